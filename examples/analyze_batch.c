@@ -0,0 +1,867 @@
+/*****************************************************************************
+ * analyze_batch.c: offline analysis of many TS recordings
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ * Analyzes the recordings of a file list on a pool of worker threads and
+ * writes one JSON object per recording: packet counters and continuity
+ * errors per PID, the last PAT and the last PMT of every program.
+ *
+ * Each worker owns a deque of tasks, takes its own tasks from the bottom
+ * and steals from the top of the others' when it has none left. A
+ * recording larger than the shard size is split into one task per worker
+ * when it is run, each task reading the whole file but only handling the
+ * PIDs of its shard, the other tasks being left to be stolen. The dvbpsi
+ * handles, and so their section buffers, and the read buffer of a worker
+ * are kept from one task to the next.
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+/* The libdvbpsi distribution defines DVBPSI_DIST */
+#ifdef DVBPSI_DIST
+#include "../src/dvbpsi.h"
+#include "../src/psi.h"
+#include "../src/descriptor.h"
+#include "../src/tables/pat.h"
+#include "../src/tables/pmt.h"
+#else
+#include <dvbpsi/dvbpsi.h>
+#include <dvbpsi/psi.h>
+#include <dvbpsi/descriptor.h>
+#include <dvbpsi/pat.h>
+#include <dvbpsi/pmt.h>
+#endif
+
+#define READ_PACKETS    1024    /* packets per read */
+#define POOL_HANDLES    64      /* idle handles kept by a worker */
+#define MAX_WORKERS     64
+#define MAX_PROGRAMS    256     /* PMTs followed per task */
+
+/*****************************************************************************
+ * Results of a recording, each PID being written by the task of its shard
+ *****************************************************************************/
+typedef struct es_info_s
+{
+  uint8_t  i_type;
+  uint16_t i_pid;
+} es_info_t;
+
+typedef struct pmt_info_s
+{
+  uint16_t  i_program;
+  uint16_t  i_pid;
+  uint8_t   i_version;
+  uint16_t  i_pcr_pid;
+  int       i_es;
+  es_info_t *p_es;
+  struct pmt_info_s *p_next;
+} pmt_info_t;
+
+typedef struct pid_info_s
+{
+  uint64_t i_packets;
+  uint64_t i_cc_errors;
+  uint64_t i_scrambled;
+  uint64_t i_transport_errors;
+} pid_info_t;
+
+typedef struct result_s
+{
+  char       *psz_file;
+  off_t       i_size;
+  bool        b_error;      /* could not be read */
+  uint64_t    i_sync_losses;
+
+  pid_info_t *p_pids;       /* 8192 PIDs */
+
+  bool        b_pat;
+  uint16_t    i_ts_id;
+  uint8_t     i_pat_version;
+  int         i_programs;
+  uint16_t   *p_programs;   /* program_number and PID pairs */
+
+  pthread_mutex_t lock;     /* PMT list, written by all the shards */
+  pmt_info_t *p_first_pmt;
+} result_t;
+
+/*****************************************************************************
+ * Tasks and workers
+ *****************************************************************************/
+typedef struct task_s
+{
+  result_t *p_result;
+  int       i_shard;        /* -1 until the task is split */
+  int       i_shards;
+} task_t;
+
+typedef struct deque_s
+{
+  pthread_mutex_t lock;
+  task_t   *p_tasks;
+  int       i_top;          /* stolen from */
+  int       i_bottom;       /* pushed to and popped from by the owner */
+  int       i_size;
+} deque_t;
+
+typedef struct batch_s batch_t;
+
+typedef struct worker_s
+{
+  batch_t   *p_batch;
+  int        i_index;
+  pthread_t  handle;
+  deque_t    deque;
+
+  /* kept from one task to the next */
+  dvbpsi_t  *pp_pool[POOL_HANDLES];
+  int        i_pool;
+  uint8_t   *p_buffer;
+  int8_t     pi_cc[8192];
+
+  /* decoders of the running task */
+  task_t     task;
+  dvbpsi_t  *p_pat;
+  int        i_pmts;
+  struct
+  {
+    uint16_t i_program;
+    uint16_t i_pid;
+    dvbpsi_t *p_handle;
+  } pmts[MAX_PROGRAMS];
+  uint8_t    pb_pmt[8192];  /* PIDs carrying a followed PMT */
+
+  uint64_t   i_steals;
+} worker_t;
+
+struct batch_s
+{
+  int        i_workers;
+  worker_t  *p_workers;
+  off_t      i_shard_size;
+
+  pthread_mutex_t lock;
+  pthread_cond_t  wait;
+  int        i_pending; /* tasks queued or running */
+};
+
+/*****************************************************************************
+ * Deques
+ *****************************************************************************/
+static bool DequeInit(deque_t *p_deque, int i_size)
+{
+  p_deque->p_tasks = malloc(i_size * sizeof(task_t));
+  if (p_deque->p_tasks == NULL)
+    return false;
+  p_deque->i_top = p_deque->i_bottom = 0;
+  p_deque->i_size = i_size;
+  pthread_mutex_init(&p_deque->lock, NULL);
+  return true;
+}
+
+static void DequeClean(deque_t *p_deque)
+{
+  pthread_mutex_destroy(&p_deque->lock);
+  free(p_deque->p_tasks);
+}
+
+static void DequePush(deque_t *p_deque, const task_t *p_task)
+{
+  pthread_mutex_lock(&p_deque->lock);
+  if (p_deque->i_top > 0 && p_deque->i_bottom == p_deque->i_size)
+  {
+    memmove(p_deque->p_tasks, p_deque->p_tasks + p_deque->i_top,
+            (p_deque->i_bottom - p_deque->i_top) * sizeof(task_t));
+    p_deque->i_bottom -= p_deque->i_top;
+    p_deque->i_top = 0;
+  }
+  /* sized for all the tasks, see main */
+  p_deque->p_tasks[p_deque->i_bottom++] = *p_task;
+  pthread_mutex_unlock(&p_deque->lock);
+}
+
+static bool DequePop(deque_t *p_deque, task_t *p_task, bool b_steal)
+{
+  bool b_ok = false;
+  pthread_mutex_lock(&p_deque->lock);
+  if (p_deque->i_top < p_deque->i_bottom)
+  {
+    if (b_steal)
+      *p_task = p_deque->p_tasks[p_deque->i_top++];
+    else
+      *p_task = p_deque->p_tasks[--p_deque->i_bottom];
+    b_ok = true;
+  }
+  pthread_mutex_unlock(&p_deque->lock);
+  return b_ok;
+}
+
+static void BatchPush(batch_t *p_batch, worker_t *p_worker, const task_t *p_task)
+{
+  pthread_mutex_lock(&p_batch->lock);
+  p_batch->i_pending++;
+  pthread_mutex_unlock(&p_batch->lock);
+
+  DequePush(&p_worker->deque, p_task);
+
+  pthread_mutex_lock(&p_batch->lock);
+  pthread_cond_broadcast(&p_batch->wait);
+  pthread_mutex_unlock(&p_batch->lock);
+}
+
+/* Gets a task of the worker or steals one, false once all are done */
+static bool BatchNext(batch_t *p_batch, worker_t *p_worker, task_t *p_task)
+{
+  if (DequePop(&p_worker->deque, p_task, false))
+    return true;
+
+  pthread_mutex_lock(&p_batch->lock);
+  for (;;)
+  {
+    for (int i = 1; i < p_batch->i_workers; i++)
+    {
+      worker_t *p_victim = &p_batch->p_workers[(p_worker->i_index + i) % p_batch->i_workers];
+      if (DequePop(&p_victim->deque, p_task, true))
+      {
+        p_worker->i_steals++;
+        pthread_mutex_unlock(&p_batch->lock);
+        return true;
+      }
+    }
+    if (DequePop(&p_worker->deque, p_task, false))
+      break;
+    if (p_batch->i_pending == 0)
+    {
+      pthread_mutex_unlock(&p_batch->lock);
+      return false;
+    }
+    pthread_cond_wait(&p_batch->wait, &p_batch->lock);
+  }
+  pthread_mutex_unlock(&p_batch->lock);
+  return true;
+}
+
+static void BatchDone(batch_t *p_batch)
+{
+  pthread_mutex_lock(&p_batch->lock);
+  if (--p_batch->i_pending == 0)
+    pthread_cond_broadcast(&p_batch->wait);
+  pthread_mutex_unlock(&p_batch->lock);
+}
+
+/*****************************************************************************
+ * Pooled handles
+ *****************************************************************************/
+static dvbpsi_t *HandleGet(worker_t *p_worker)
+{
+  if (p_worker->i_pool > 0)
+    return p_worker->pp_pool[--p_worker->i_pool];
+  return dvbpsi_new(NULL, DVBPSI_MSG_NONE);
+}
+
+static void HandlePut(worker_t *p_worker, dvbpsi_t *p_handle)
+{
+  if (p_worker->i_pool < POOL_HANDLES)
+    p_worker->pp_pool[p_worker->i_pool++] = p_handle;
+  else
+    dvbpsi_delete(p_handle);
+}
+
+/*****************************************************************************
+ * Tables
+ *****************************************************************************/
+static bool InShard(const task_t *p_task, uint16_t i_pid)
+{
+  return (i_pid % p_task->i_shards) == (unsigned)p_task->i_shard;
+}
+
+static void OnPMT(void *p_data, dvbpsi_pmt_t *p_pmt)
+{
+  result_t *p_result = (result_t *)p_data;
+  int i_es = 0;
+  for (dvbpsi_pmt_es_t *p_es = p_pmt->p_first_es; p_es; p_es = p_es->p_next)
+    i_es++;
+
+  pmt_info_t *p_info = calloc(1, sizeof(pmt_info_t));
+  if (p_info)
+    p_info->p_es = calloc(i_es ? i_es : 1, sizeof(es_info_t));
+  if (p_info == NULL || p_info->p_es == NULL)
+  {
+    free(p_info);
+    dvbpsi_pmt_delete(p_pmt);
+    return;
+  }
+  p_info->i_program = p_pmt->i_program_number;
+  p_info->i_version = p_pmt->i_version;
+  p_info->i_pcr_pid = p_pmt->i_pcr_pid;
+  for (dvbpsi_pmt_es_t *p_es = p_pmt->p_first_es; p_es; p_es = p_es->p_next)
+  {
+    p_info->p_es[p_info->i_es].i_type = p_es->i_type;
+    p_info->p_es[p_info->i_es++].i_pid = p_es->i_pid;
+  }
+  dvbpsi_pmt_delete(p_pmt);
+
+  /* the last version of a program replaces the previous one */
+  pthread_mutex_lock(&p_result->lock);
+  pmt_info_t **pp_info = &p_result->p_first_pmt;
+  while (*pp_info && (*pp_info)->i_program != p_info->i_program)
+    pp_info = &(*pp_info)->p_next;
+  if (*pp_info)
+  {
+    pmt_info_t *p_old = *pp_info;
+    p_info->p_next = p_old->p_next;
+    free(p_old->p_es);
+    free(p_old);
+  }
+  *pp_info = p_info;
+  pthread_mutex_unlock(&p_result->lock);
+}
+
+static void OnPAT(void *p_data, dvbpsi_pat_t *p_pat)
+{
+  worker_t *p_worker = (worker_t *)p_data;
+  task_t *p_task = &p_worker->task;
+  result_t *p_result = p_task->p_result;
+
+  /* every shard decodes the PAT, the one of PID 0 records it */
+  if (InShard(p_task, 0))
+  {
+    int i_programs = 0;
+    for (dvbpsi_pat_program_t *p = p_pat->p_first_program; p; p = p->p_next)
+      i_programs++;
+    uint16_t *p_programs = malloc(2 * (i_programs ? i_programs : 1) * sizeof(uint16_t));
+    if (p_programs)
+    {
+      int i = 0;
+      for (dvbpsi_pat_program_t *p = p_pat->p_first_program; p; p = p->p_next)
+      {
+        p_programs[i++] = p->i_number;
+        p_programs[i++] = p->i_pid;
+      }
+      free(p_result->p_programs);
+      p_result->p_programs = p_programs;
+      p_result->i_programs = i_programs;
+      p_result->i_ts_id = p_pat->i_ts_id;
+      p_result->i_pat_version = p_pat->i_version;
+      p_result->b_pat = true;
+    }
+  }
+
+  /* follows the PMTs of the shard, old ones included */
+  for (dvbpsi_pat_program_t *p = p_pat->p_first_program; p; p = p->p_next)
+  {
+    if (p->i_number == 0 || !InShard(p_task, p->i_pid))
+      continue;
+
+    int i;
+    for (i = 0; i < p_worker->i_pmts; i++)
+      if (p_worker->pmts[i].i_program == p->i_number
+       && p_worker->pmts[i].i_pid == p->i_pid)
+        break;
+    if (i < p_worker->i_pmts || p_worker->i_pmts == MAX_PROGRAMS)
+      continue;
+
+    dvbpsi_t *p_handle = HandleGet(p_worker);
+    if (p_handle == NULL)
+      continue;
+    if (!dvbpsi_pmt_attach(p_handle, p->i_number, OnPMT, p_result))
+    {
+      HandlePut(p_worker, p_handle);
+      continue;
+    }
+    p_worker->pmts[i].i_program = p->i_number;
+    p_worker->pmts[i].i_pid = p->i_pid;
+    p_worker->pmts[i].p_handle = p_handle;
+    p_worker->pb_pmt[p->i_pid] = 1;
+    p_worker->i_pmts++;
+  }
+  dvbpsi_pat_delete(p_pat);
+}
+
+/*****************************************************************************
+ * Packets of a shard
+ *****************************************************************************/
+static void HandlePacket(worker_t *p_worker, uint8_t *p_packet)
+{
+  task_t *p_task = &p_worker->task;
+  uint16_t i_pid = ((uint16_t)(p_packet[1] & 0x1f) << 8) | p_packet[2];
+  bool b_shard = InShard(p_task, i_pid);
+
+  if (i_pid == 0 && p_worker->p_pat)
+    dvbpsi_packet_push(p_worker->p_pat, p_packet);
+  if (!b_shard)
+    return;
+
+  pid_info_t *p_info = &p_task->p_result->p_pids[i_pid];
+  p_info->i_packets++;
+  if (p_packet[1] & 0x80)
+    p_info->i_transport_errors++;
+  if (p_packet[3] & 0xc0)
+    p_info->i_scrambled++;
+
+  /* continuity of the packets with payload, a single duplicate being
+   * allowed, the null packets excepted */
+  if ((p_packet[3] & 0x10) && i_pid != 0x1fff)
+  {
+    int8_t i_cc = p_packet[3] & 0x0f;
+    int8_t i_last = p_worker->pi_cc[i_pid];
+    if (i_last >= 0 && i_cc != ((i_last + 1) & 0x0f) && i_cc != i_last)
+      p_info->i_cc_errors++;
+    p_worker->pi_cc[i_pid] = i_cc;
+  }
+
+  if (p_worker->pb_pmt[i_pid])
+  {
+    for (int i = 0; i < p_worker->i_pmts; i++)
+      if (p_worker->pmts[i].i_pid == i_pid)
+        dvbpsi_packet_push(p_worker->pmts[i].p_handle, p_packet);
+  }
+}
+
+static void RunShard(worker_t *p_worker)
+{
+  task_t *p_task = &p_worker->task;
+  result_t *p_result = p_task->p_result;
+
+  int i_fd = open(p_result->psz_file, O_RDONLY);
+  if (i_fd < 0)
+  {
+    p_result->b_error = true;
+    return;
+  }
+
+  memset(p_worker->pi_cc, -1, sizeof(p_worker->pi_cc));
+  p_worker->p_pat = HandleGet(p_worker);
+  if (p_worker->p_pat && !dvbpsi_pat_attach(p_worker->p_pat, OnPAT, p_worker))
+  {
+    HandlePut(p_worker, p_worker->p_pat);
+    p_worker->p_pat = NULL;
+  }
+
+  /* the first shard counts the synchronization losses */
+  bool b_sync = true;
+  size_t i_left = 0;
+  for (;;)
+  {
+    ssize_t i_read = read(i_fd, p_worker->p_buffer + i_left, READ_PACKETS * 188 - i_left);
+    if (i_read < 0 && errno == EINTR)
+      continue;
+    if (i_read < 0)
+      p_result->b_error = true;
+    if (i_read <= 0)
+      break;
+
+    uint8_t *p = p_worker->p_buffer;
+    uint8_t *p_end = p + i_left + i_read;
+    while (p_end - p >= 188)
+    {
+      if (p[0] != 0x47)
+      {
+        if (b_sync && p_task->i_shard == 0)
+          p_result->i_sync_losses++;
+        b_sync = false;
+        p++;
+        continue;
+      }
+      b_sync = true;
+      HandlePacket(p_worker, p);
+      p += 188;
+    }
+    i_left = p_end - p;
+    memmove(p_worker->p_buffer, p, i_left);
+  }
+  close(i_fd);
+
+  /* the handles go back to the pool */
+  if (p_worker->p_pat)
+  {
+    dvbpsi_pat_detach(p_worker->p_pat);
+    HandlePut(p_worker, p_worker->p_pat);
+    p_worker->p_pat = NULL;
+  }
+  for (int i = 0; i < p_worker->i_pmts; i++)
+  {
+    dvbpsi_pmt_detach(p_worker->pmts[i].p_handle);
+    HandlePut(p_worker, p_worker->pmts[i].p_handle);
+    p_worker->pb_pmt[p_worker->pmts[i].i_pid] = 0;
+  }
+  p_worker->i_pmts = 0;
+}
+
+static void *Worker(void *p_data)
+{
+  worker_t *p_worker = (worker_t *)p_data;
+  batch_t *p_batch = p_worker->p_batch;
+  task_t task;
+
+  while (BatchNext(p_batch, p_worker, &task))
+  {
+    /* a large recording is split into one shard per worker, the others
+     * being left to be stolen */
+    if (task.i_shard < 0)
+    {
+      task.i_shard = 0;
+      task.i_shards = 1;
+      if (p_batch->i_workers > 1 && task.p_result->i_size > p_batch->i_shard_size)
+        task.i_shards = p_batch->i_workers;
+      for (int i = task.i_shards - 1; i > 0; i--)
+      {
+        task_t shard = task;
+        shard.i_shard = i;
+        BatchPush(p_batch, p_worker, &shard);
+      }
+    }
+
+    p_worker->task = task;
+    RunShard(p_worker);
+    BatchDone(p_batch);
+  }
+  return NULL;
+}
+
+/*****************************************************************************
+ * Report
+ *****************************************************************************/
+static void WriteString(FILE *p_out, const char *psz)
+{
+  fputc('"', p_out);
+  for (; *psz; psz++)
+  {
+    unsigned char c = *psz;
+    if (c == '"' || c == '\\')
+      fprintf(p_out, "\\%c", c);
+    else if (c < 0x20)
+      fprintf(p_out, "\\u%04x", c);
+    else
+      fputc(c, p_out);
+  }
+  fputc('"', p_out);
+}
+
+static void WriteResult(FILE *p_out, const result_t *p_result)
+{
+  uint64_t i_packets = 0, i_cc_errors = 0;
+  for (int i = 0; i < 8192; i++)
+  {
+    i_packets += p_result->p_pids[i].i_packets;
+    i_cc_errors += p_result->p_pids[i].i_cc_errors;
+  }
+
+  fprintf(p_out, "{\"file\":");
+  WriteString(p_out, p_result->psz_file);
+  if (p_result->b_error)
+  {
+    fprintf(p_out, ",\"error\":");
+    WriteString(p_out, "read failed");
+  }
+  fprintf(p_out, ",\"size\":%"PRId64",\"packets\":%"PRIu64",\"sync_losses\":%"PRIu64
+          ",\"cc_errors\":%"PRIu64, (int64_t)p_result->i_size, i_packets,
+          p_result->i_sync_losses, i_cc_errors);
+
+  fprintf(p_out, ",\"pids\":[");
+  bool b_first = true;
+  for (int i = 0; i < 8192; i++)
+  {
+    const pid_info_t *p_info = &p_result->p_pids[i];
+    if (p_info->i_packets == 0)
+      continue;
+    fprintf(p_out, "%s{\"pid\":%d,\"packets\":%"PRIu64",\"cc_errors\":%"PRIu64
+            ",\"scrambled\":%"PRIu64",\"transport_errors\":%"PRIu64"}",
+            b_first ? "" : ",", i, p_info->i_packets, p_info->i_cc_errors,
+            p_info->i_scrambled, p_info->i_transport_errors);
+    b_first = false;
+  }
+  fprintf(p_out, "]");
+
+  if (p_result->b_pat)
+  {
+    fprintf(p_out, ",\"pat\":{\"ts_id\":%d,\"version\":%d,\"programs\":[",
+            p_result->i_ts_id, p_result->i_pat_version);
+    for (int i = 0; i < p_result->i_programs; i++)
+      fprintf(p_out, "%s{\"number\":%d,\"pid\":%d}", i ? "," : "",
+              p_result->p_programs[2 * i], p_result->p_programs[2 * i + 1]);
+    fprintf(p_out, "]}");
+  }
+
+  /* PMTs by program_number, whichever shard decoded them */
+  fprintf(p_out, ",\"pmts\":[");
+  b_first = true;
+  for (int i_program = -1;;)
+  {
+    const pmt_info_t *p_next = NULL;
+    for (const pmt_info_t *p = p_result->p_first_pmt; p; p = p->p_next)
+      if (p->i_program > i_program && (!p_next || p->i_program < p_next->i_program))
+        p_next = p;
+    if (p_next == NULL)
+      break;
+    i_program = p_next->i_program;
+
+    fprintf(p_out, "%s{\"program\":%d,\"version\":%d,\"pcr_pid\":%d,\"es\":[",
+            b_first ? "" : ",", p_next->i_program, p_next->i_version, p_next->i_pcr_pid);
+    for (int i = 0; i < p_next->i_es; i++)
+      fprintf(p_out, "%s{\"type\":%d,\"pid\":%d}", i ? "," : "",
+              p_next->p_es[i].i_type, p_next->p_es[i].i_pid);
+    fprintf(p_out, "]}");
+    b_first = false;
+  }
+  fprintf(p_out, "]}\n");
+}
+
+static void FreeResult(result_t *p_result)
+{
+  pmt_info_t *p_pmt = p_result->p_first_pmt;
+  while (p_pmt)
+  {
+    pmt_info_t *p_next = p_pmt->p_next;
+    free(p_pmt->p_es);
+    free(p_pmt);
+    p_pmt = p_next;
+  }
+  pthread_mutex_destroy(&p_result->lock);
+  free(p_result->p_programs);
+  free(p_result->p_pids);
+  free(p_result->psz_file);
+}
+
+/*****************************************************************************
+ * Usage
+ *****************************************************************************/
+static void usage(char *name)
+{
+  printf("Usage: %s [-w <workers>] [-s <shard size>] [-o <report>] [-l <list>] [<file> ...]\n", name);
+  printf("\n");
+  printf(" -w : worker threads (default: one per cpu)\n");
+  printf(" -s : split recordings larger than this many MB by PID (default: 256)\n");
+  printf(" -o : JSON report, one object per line and recording (default: stdout)\n");
+  printf(" -l : file listing the recordings to analyze, one per line, - for stdin\n");
+}
+
+static bool AddFile(result_t **pp_results, int *pi_results, int *pi_max, const char *psz_file)
+{
+  if (*pi_results == *pi_max)
+  {
+    int i_max = *pi_max ? 2 * *pi_max : 64;
+    result_t *p_results = malloc(i_max * sizeof(result_t));
+    if (p_results == NULL)
+      return false;
+    if (*pp_results)
+      memcpy(p_results, *pp_results, *pi_results * sizeof(result_t));
+    free(*pp_results);
+    *pp_results = p_results;
+    *pi_max = i_max;
+  }
+
+  result_t *p_result = &(*pp_results)[*pi_results];
+  memset(p_result, 0, sizeof(result_t));
+  p_result->psz_file = strdup(psz_file);
+  p_result->p_pids = calloc(8192, sizeof(pid_info_t));
+  if (p_result->psz_file == NULL || p_result->p_pids == NULL)
+  {
+    free(p_result->psz_file);
+    free(p_result->p_pids);
+    return false;
+  }
+  pthread_mutex_init(&p_result->lock, NULL);
+
+  struct stat st;
+  if (stat(psz_file, &st) == 0)
+    p_result->i_size = st.st_size;
+  (*pi_results)++;
+  return true;
+}
+
+/*****************************************************************************
+ * main
+ *****************************************************************************/
+int main(int i_argc, char* pa_argv[])
+{
+  batch_t batch;
+  result_t *p_results = NULL;
+  int i_results = 0, i_max = 0;
+  const char *psz_list = NULL, *psz_report = NULL;
+  int i_workers = 0;
+  long i_shard_mb = 256;
+  int c;
+
+  while ((c = getopt(i_argc, pa_argv, "hl:o:s:w:")) != -1)
+  {
+    switch (c)
+    {
+      case 'l': psz_list = optarg; break;
+      case 'o': psz_report = optarg; break;
+      case 's': i_shard_mb = strtol(optarg, NULL, 10); break;
+      case 'w': i_workers = strtol(optarg, NULL, 10); break;
+      case 'h':
+      default:
+        usage(pa_argv[0]);
+        return 1;
+    }
+  }
+
+  if (psz_list)
+  {
+    FILE *p_list = strcmp(psz_list, "-") ? fopen(psz_list, "r") : stdin;
+    if (p_list == NULL)
+    {
+      fprintf(stderr, "Could not open %s\n", psz_list);
+      return 1;
+    }
+    char line[4096];
+    while (fgets(line, sizeof(line), p_list))
+    {
+      line[strcspn(line, "\r\n")] = '\0';
+      if (line[0] == '\0' || line[0] == '#')
+        continue;
+      if (!AddFile(&p_results, &i_results, &i_max, line))
+        return 1;
+    }
+    if (p_list != stdin)
+      fclose(p_list);
+  }
+  for (int i = optind; i < i_argc; i++)
+    if (!AddFile(&p_results, &i_results, &i_max, pa_argv[i]))
+      return 1;
+  if (i_results == 0)
+  {
+    usage(pa_argv[0]);
+    return 1;
+  }
+
+  FILE *p_out = psz_report ? fopen(psz_report, "w") : stdout;
+  if (p_out == NULL)
+  {
+    fprintf(stderr, "Could not create %s\n", psz_report);
+    return 1;
+  }
+
+  if (i_workers <= 0)
+    i_workers = sysconf(_SC_NPROCESSORS_ONLN);
+  if (i_workers <= 0)
+    i_workers = 1;
+  if (i_workers > MAX_WORKERS)
+    i_workers = MAX_WORKERS;
+
+  memset(&batch, 0, sizeof(batch));
+  batch.i_workers = i_workers;
+  batch.i_shard_size = (off_t)(i_shard_mb > 0 ? i_shard_mb : 1) << 20;
+  pthread_mutex_init(&batch.lock, NULL);
+  pthread_cond_init(&batch.wait, NULL);
+  batch.p_workers = calloc(i_workers, sizeof(worker_t));
+  if (batch.p_workers == NULL)
+    return 1;
+
+  /* a deque may hold all the recordings and the shards of its worker */
+  for (int i = 0; i < i_workers; i++)
+  {
+    worker_t *p_worker = &batch.p_workers[i];
+    p_worker->p_batch = &batch;
+    p_worker->i_index = i;
+    p_worker->p_buffer = malloc(READ_PACKETS * 188);
+    if (p_worker->p_buffer == NULL
+     || !DequeInit(&p_worker->deque, i_results * i_workers))
+      return 1;
+  }
+
+  /* the recordings are dealt to the workers, the largest first so that
+   * few are left for the end */
+  task_t *p_tasks = malloc(i_results * sizeof(task_t));
+  if (p_tasks == NULL)
+    return 1;
+  for (int i = 0; i < i_results; i++)
+  {
+    p_tasks[i].p_result = &p_results[i];
+    p_tasks[i].i_shard = -1;
+    p_tasks[i].i_shards = 1;
+  }
+  for (int i = 1; i < i_results; i++)
+  {
+    task_t task = p_tasks[i];
+    int j = i;
+    for (; j > 0 && p_tasks[j - 1].p_result->i_size < task.p_result->i_size; j--)
+      p_tasks[j] = p_tasks[j - 1];
+    p_tasks[j] = task;
+  }
+  /* pushed in reverse as a worker pops its last task first */
+  for (int i = i_results - 1; i >= 0; i--)
+    BatchPush(&batch, &batch.p_workers[i % i_workers], &p_tasks[i]);
+  free(p_tasks);
+
+  int i_started = 0;
+  for (; i_started < i_workers; i_started++)
+    if (pthread_create(&batch.p_workers[i_started].handle, NULL, Worker,
+                       &batch.p_workers[i_started]) != 0)
+      break;
+  if (i_started == 0)
+  {
+    fprintf(stderr, "Could not create worker threads\n");
+    return 1;
+  }
+  /* the workers started get all the tasks by stealing */
+  for (int i = 0; i < i_started; i++)
+    pthread_join(batch.p_workers[i].handle, NULL);
+
+  uint64_t i_steals = 0;
+  for (int i = 0; i < i_workers; i++)
+  {
+    worker_t *p_worker = &batch.p_workers[i];
+    i_steals += p_worker->i_steals;
+    for (int j = 0; j < p_worker->i_pool; j++)
+      dvbpsi_delete(p_worker->pp_pool[j]);
+    free(p_worker->p_buffer);
+    DequeClean(&p_worker->deque);
+  }
+  free(batch.p_workers);
+  pthread_cond_destroy(&batch.wait);
+  pthread_mutex_destroy(&batch.lock);
+
+  int i_errors = 0;
+  for (int i = 0; i < i_results; i++)
+  {
+    WriteResult(p_out, &p_results[i]);
+    if (p_results[i].b_error)
+      i_errors++;
+    FreeResult(&p_results[i]);
+  }
+  free(p_results);
+  if (p_out != stdout)
+    fclose(p_out);
+
+  fprintf(stderr, "%d recordings, %d errors, %d workers, %"PRIu64" tasks stolen\n",
+          i_results, i_errors, i_workers, i_steals);
+  return i_errors ? 1 : 0;
+}
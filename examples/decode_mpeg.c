@@ -69,6 +69,8 @@
 #include <dvbpsi/dr.h>
 #endif
 
+#include "tsfile.h"
+
 #define SYSTEM_CLOCK_DR 0x0B
 #define MAX_BITRATE_DR 0x0E
 #define STREAM_IDENTIFIER_DR 0x52
@@ -146,30 +148,6 @@ typedef struct
  *****************************************************************************/
 static void DumpPMT(void* p_data, dvbpsi_pmt_t* p_pmt);
 
-/*****************************************************************************
- * ReadPacket
- *****************************************************************************/
-static int ReadPacket( int i_fd, uint8_t* p_dst )
-{
-    int i = 187;
-    int i_rc = 1;
-
-    p_dst[0] = 0;
-
-    while((p_dst[0] != 0x47) && (i_rc > 0))
-    {
-        i_rc = read(i_fd, p_dst, 1);
-    }
-
-    while((i != 0) && (i_rc > 0))
-    {
-        i_rc = read(i_fd, p_dst + 188 - i, i);
-        if(i_rc >= 0)
-            i -= i_rc;
-    }
-    return (i_rc <= 0) ? i_rc : 188;
-}
-
 #ifdef HAVE_SYS_SOCKET_H
 static int ReadPacketFromSocket( int i_socket, uint8_t* p_dst, size_t i_size)
 {
@@ -593,6 +571,8 @@ int main(int i_argc, char* pa_argv[])
     char *filename = NULL;
 
     uint8_t *p_data = NULL;
+    uint8_t *p_packets = NULL; /* packets read, from p_data or p_file */
+    ts_file_t *p_file = NULL;
     ts_stream_t *p_stream = NULL;
     int i_len = 0;
     bool b_verbose = false;
@@ -652,10 +632,8 @@ int main(int i_argc, char* pa_argv[])
     /* initialize */
     if( filename )
     {
-        i_fd = open( filename, 0 );
-        p_data = (uint8_t *) malloc( sizeof( uint8_t ) * 188 );
-        if( !p_data )
-            goto out_of_memory;
+        p_file = ts_file_open( filename );
+        i_fd = p_file ? 0 : -1;
     }
 #ifdef HAVE_SYS_SOCKET_H
     else if( ipaddress )
@@ -684,12 +662,15 @@ int main(int i_argc, char* pa_argv[])
         goto out_of_memory;
     memset( p_stream, 0, sizeof(ts_stream_t) );
 
-    /* Read first packet */
+    /* Read first packets */
     if( filename )
-        i_len = ReadPacket( i_fd, p_data );
+        i_len = 188 * ts_file_read( p_file, &p_packets );
 #ifdef HAVE_SYS_SOCKET_H
     else
+    {
         i_len = ReadPacketFromSocket( i_fd, p_data, i_mtu );
+        p_packets = p_data;
+    }
 
     /* print the right report header */
     report_Header( i_report );
@@ -708,17 +689,21 @@ int main(int i_argc, char* pa_argv[])
 #ifdef HAVE_SYS_SOCKET_H
         vlc_bool_t b_first = VLC_FALSE;
 #endif
-        i_bytes += i_len;
+        if( !filename )
+            i_bytes += i_len;
         for( i = 0; i < i_len; i += 188 )
         {
-            uint8_t   *p_tmp = &p_data[i];
+            uint8_t   *p_tmp = &p_packets[i];
             uint16_t   i_pid = ((uint16_t)(p_tmp[1] & 0x1f) << 8) + p_tmp[2];
             int        i_cc = (p_tmp[3] & 0x0f);
             vlc_bool_t b_adaptation = (p_tmp[3] & 0x20); /* adaptation field */
             vlc_bool_t b_discontinuity_seen = VLC_FALSE;
 
+            /* the packets of a file count as read one at a time */
+            if( filename )
+                i_bytes += 188;
 #ifdef HAVE_SYS_SOCKET_H
-            if( i_report == REPORT_UDP && !b_first )
+            if( i_report == REPORT_UDP && (!b_first || filename) )
             {
 #ifdef HAVE_GETTIMEOFDAY
                 time_prev = report_UDPPacketTiming( i_cc, i_bytes, time_prev, &time_base );
@@ -726,9 +711,11 @@ int main(int i_argc, char* pa_argv[])
                 report_UDPPacketTiming( i_cc, i_bytes );
 #endif
                 b_first = VLC_TRUE;
+                if( filename )
+                    i_bytes = 0;
             }
 #endif
-            if (p_data[i] != 0x47) /* no sync skip this packet */
+            if (p_packets[i] != 0x47) /* no sync skip this packet */
             {
                 fprintf( stderr, "Missing TS sync word, skipping 188 bytes\n" );
                 break;
@@ -824,9 +811,9 @@ int main(int i_argc, char* pa_argv[])
         if( i_report == REPORT_UDP )
             i_bytes = 0; /* reset byte counter */
 #endif
-        /* Read next packet */
+        /* Read next packets */
         if( filename )
-            i_len = ReadPacket( i_fd, p_data );
+            i_len = 188 * ts_file_read( p_file, &p_packets );
 #ifdef HAVE_SYS_SOCKET_H
         else
             i_len = ReadPacketFromSocket( i_fd, p_data, i_mtu );
@@ -845,7 +832,7 @@ int main(int i_argc, char* pa_argv[])
 
     /* clean up */
     if( filename )
-        close( i_fd );
+        ts_file_close( p_file );
 #ifdef HAVE_SYS_SOCKET_H
     else
         close_connection( i_fd );
@@ -872,6 +859,7 @@ dvbpsi_out:
     }
 
 error:
+    if( p_file )    ts_file_close( p_file );
     if( p_data )    free( p_data );
     if( filename )  free( filename );
 #ifdef HAVE_SYS_SOCKET_H
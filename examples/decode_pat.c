@@ -49,32 +49,30 @@
 #include <dvbpsi/pat.h>
 #endif
 
+#include "tsfile.h"
+
+
 /*****************************************************************************
- * ReadPacket
+ * PushPID: pushes the packets of a PID of a run, each group of successive
+ * packets of the PID at once
  *****************************************************************************/
-static bool ReadPacket(int i_fd, uint8_t* p_dst)
+static void PushPID(dvbpsi_t *p_dvbpsi, uint16_t i_pid, uint8_t *p_packets, size_t i_count)
 {
-  int i = 187;
-  int i_rc = 1;
-
-  p_dst[0] = 0;
-
-  while((p_dst[0] != 0x47) && (i_rc > 0))
-  {
-    i_rc = read(i_fd, p_dst, 1);
-  }
+  size_t i = 0;
 
-  while((i != 0) && (i_rc > 0))
+  while (i < i_count)
   {
-    i_rc = read(i_fd, p_dst + 188 - i, i);
-    if(i_rc >= 0)
-      i -= i_rc;
+    size_t n = 0;
+    while ((i + n < i_count) &&
+           ((((uint16_t)(p_packets[(i + n) * 188 + 1] & 0x1f) << 8) +
+             p_packets[(i + n) * 188 + 2]) == i_pid))
+      n++;
+    if (n > 0)
+      dvbpsi_packets_push(p_dvbpsi, p_packets + i * 188, n, 188);
+    i += (n > 0) ? n : 1;
   }
-
-  return (i == 0) ? true : false;
 }
 
-
 /*****************************************************************************
  * DumpPAT
  *****************************************************************************/
@@ -114,16 +112,16 @@ static void message(dvbpsi_t *handle, const dvbpsi_msg_level_t level, const char
  *****************************************************************************/
 int main(int i_argc, char* pa_argv[])
 {
-  int i_fd;
-  uint8_t data[188];
+  ts_file_t *p_file;
+  uint8_t *p_packets;
+  size_t i_count;
   dvbpsi_t *p_dvbpsi;
-  bool b_ok;
 
   if (i_argc != 2)
       return 1;
 
-  i_fd = open(pa_argv[1], 0);
-  if (i_fd < 0)
+  p_file = ts_file_open(pa_argv[1]);
+  if (p_file == NULL)
       return 1;
 
   p_dvbpsi = dvbpsi_new(&message, DVBPSI_MSG_DEBUG);
@@ -133,15 +131,8 @@ int main(int i_argc, char* pa_argv[])
   if (!dvbpsi_pat_attach(p_dvbpsi, DumpPAT, NULL))
       goto out;
 
-  b_ok = ReadPacket(i_fd, data);
-
-  while(b_ok)
-  {
-    uint16_t i_pid = ((uint16_t)(data[1] & 0x1f) << 8) + data[2];
-    if(i_pid == 0x0)
-      dvbpsi_packet_push(p_dvbpsi, data);
-    b_ok = ReadPacket(i_fd, data);
-  }
+  while ((i_count = ts_file_read(p_file, &p_packets)) > 0)
+    PushPID(p_dvbpsi, 0x0, p_packets, i_count);
 
 out:
   if (p_dvbpsi)
@@ -149,7 +140,7 @@ out:
     dvbpsi_pat_detach(p_dvbpsi);
     dvbpsi_delete(p_dvbpsi);
   }
-  close(i_fd);
+  ts_file_close(p_file);
 
   return 0;
 }
@@ -54,36 +54,13 @@
 #include <dvbpsi/dr.h>
 #endif
 
+#include "tsfile.h"
+
 #define SYSTEM_CLOCK_DR 0x0B
 #define MAX_BITRATE_DR 0x0E
 #define STREAM_IDENTIFIER_DR 0x52
 #define SUBTITLING_DR 0x59
 
-/*****************************************************************************
- * ReadPacket
- *****************************************************************************/
-static bool ReadPacket(int i_fd, uint8_t* p_dst)
-{
-  int i = 187;
-  int i_rc = 1;
-
-  p_dst[0] = 0;
-
-  while((p_dst[0] != 0x47) && (i_rc > 0))
-  {
-    i_rc = read(i_fd, p_dst, 1);
-  }
-
-  while((i != 0) && (i_rc > 0))
-  {
-    i_rc = read(i_fd, p_dst + 188 - i, i);
-    if(i_rc >= 0)
-      i -= i_rc;
-  }
-
-  return (i == 0) ? true : false;
-}
-
 /*****************************************************************************
  * GetTypeName
  *****************************************************************************/
@@ -212,6 +189,27 @@ static void DumpDescriptors(const char* str, dvbpsi_descriptor_t* p_descriptor)
 };
 
 
+/*****************************************************************************
+ * PushPID: pushes the packets of a PID of a run, each group of successive
+ * packets of the PID at once
+ *****************************************************************************/
+static void PushPID(dvbpsi_t *p_dvbpsi, uint16_t i_pid, uint8_t *p_packets, size_t i_count)
+{
+  size_t i = 0;
+
+  while (i < i_count)
+  {
+    size_t n = 0;
+    while ((i + n < i_count) &&
+           ((((uint16_t)(p_packets[(i + n) * 188 + 1] & 0x1f) << 8) +
+             p_packets[(i + n) * 188 + 2]) == i_pid))
+      n++;
+    if (n > 0)
+      dvbpsi_packets_push(p_dvbpsi, p_packets + i * 188, n, 188);
+    i += (n > 0) ? n : 1;
+  }
+}
+
 /*****************************************************************************
  * DumpPMT
  *****************************************************************************/
@@ -257,17 +255,17 @@ static void message(dvbpsi_t *handle, const dvbpsi_msg_level_t level, const char
  *****************************************************************************/
 int main(int i_argc, char* pa_argv[])
 {
-  int i_fd;
-  uint8_t data[188];
+  ts_file_t *p_file;
+  uint8_t *p_packets;
+  size_t i_count;
   dvbpsi_t *p_dvbpsi;
-  bool b_ok;
   uint16_t i_program_number, i_pmt_pid;
 
   if (i_argc != 4)
     return 1;
 
-  i_fd = open(pa_argv[1], 0);
-  if (i_fd < 0)
+  p_file = ts_file_open(pa_argv[1]);
+  if (p_file == NULL)
       return 1;
 
   i_program_number = atoi(pa_argv[2]);
@@ -280,15 +278,8 @@ int main(int i_argc, char* pa_argv[])
   if (!dvbpsi_pmt_attach(p_dvbpsi, i_program_number, DumpPMT, NULL))
       goto out;
 
-  b_ok = ReadPacket(i_fd, data);
-
-  while(b_ok)
-  {
-    uint16_t i_pid = ((uint16_t)(data[1] & 0x1f) << 8) + data[2];
-    if(i_pid == i_pmt_pid)
-      dvbpsi_packet_push(p_dvbpsi, data);
-    b_ok = ReadPacket(i_fd, data);
-  }
+  while ((i_count = ts_file_read(p_file, &p_packets)) > 0)
+    PushPID(p_dvbpsi, i_pmt_pid, p_packets, i_count);
 
 out:
   if (p_dvbpsi)
@@ -296,7 +287,7 @@ out:
     dvbpsi_pmt_detach(p_dvbpsi);
     dvbpsi_delete(p_dvbpsi);
   }
-  close(i_fd);
+  ts_file_close(p_file);
 
   return 0;
 }
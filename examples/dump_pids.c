@@ -8,6 +8,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
 #include <unistd.h>
 
 #include <sys/types.h>
@@ -16,6 +17,8 @@
 
 #include <assert.h>
 
+#include "tsfile.h"
+
 #ifdef WIN32
 #   define O_NONBLOCK (0) /* O_NONBLOCK does not exist for Windows */
 #endif
@@ -33,29 +36,25 @@ static inline uint32_t ts_getpid(uint8_t *packet)
 
 int main(int argc, char *argv[])
 {
-    int file = open(argv[1], O_RDONLY | O_NONBLOCK);
-    if (file < 0) {
+    ts_file_t *file = ts_file_open(argv[1]);
+    if (file == NULL) {
         perror(argv[1]);
         printf("error opening %s\n", argv[1]);
         return -1;
     }
 
-    int32_t s = 188; /* COULD ALSO BE 192 */
-    uint8_t p[188] = { 0 };
+    uint8_t *p = NULL;
     int64_t n = 0;
-    size_t  len = 0;
-    for (;;) {
-
-        /* slow read */
-        len = read(file, &p[0], s);
-        if (len == 0)
-            break;
-        uint32_t pid = ts_getpid(&p[0]);
-        uint32_t cc  = ts_getcc(&p[0]);
-        n++;
-        printf("packet %"PRId64", pid %u (0x%x), cc %d\n", n, pid, pid, cc );
+    size_t  count = 0;
+    while ((count = ts_file_read(file, &p)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            uint32_t pid = ts_getpid(&p[i * 188]);
+            uint32_t cc  = ts_getcc(&p[i * 188]);
+            n++;
+            printf("packet %"PRId64", pid %u (0x%x), cc %d\n", n, pid, pid, cc );
+        }
     }
 
-    close(file);
+    ts_file_close(file);
     return 0;
 }
@@ -32,22 +32,56 @@
 #   include <stdint.h>
 #endif
 
+#include <string.h>
 #include <sys/types.h>
+#ifdef HAVE_SYS_MMAN_H
+#   include <sys/mman.h>
+#endif
 #include <assert.h>
 
 typedef int64_t mtime_t;
 
 #include "buffer.h"
 
-struct fifo_s
+#define ARENA_PAGE      4096
+#define ARENA_HUGEPAGE  (2 * 1024 * 1024)
+
+#define ALIGN(x, a) (((x) + (a) - 1) / (a) * (a))
+
+/* Atomics */
+#ifdef __ATOMIC_SEQ_CST
+#   define RING_LOAD(p, order)      __atomic_load_n(p, __ATOMIC_##order)
+#   define RING_STORE(p, v, order)  __atomic_store_n(p, v, __ATOMIC_##order)
+#else
+#   define RING_LOAD(p, order)      (__sync_synchronize(), *(volatile __typeof__(*(p)) *)(p))
+#   define RING_STORE(p, v, order)  do { __sync_synchronize(); \
+                                         *(volatile __typeof__(*(p)) *)(p) = (v); \
+                                         __sync_synchronize(); } while (0)
+#endif
+
+#define CACHE_LINE 64
+
+/* The indices only grow, the slot of index i being (i & i_mask). Each
+ * side owns a cache line: the popping thread writes i_head and
+ * b_sleeping, the pushing thread i_tail and b_waiting. The sleep flags are
+ * set under the lock before checking the indices again, so that the other
+ * side only locks when it has to wake a sleeper. */
+struct ring_s
 {
+    size_t     i_head;
+    bool       b_sleeping; /* ring_pop_wait() waits on wait */
+    uint8_t    pad_head[CACHE_LINE - sizeof(size_t) - sizeof(bool)];
+
+    size_t     i_tail;
+    bool       b_waiting;  /* ring_wait_room() waits on room */
+    uint8_t    pad_tail[CACHE_LINE - sizeof(size_t) - sizeof(bool)];
+
+    size_t     i_mask;
+    buffer_t **pp_slots;
+    bool       b_closed;
     pthread_mutex_t lock;
     pthread_cond_t  wait;
-    bool       b_force_wake;
-    ssize_t    i_count;
-    size_t     i_size; /* fifo size in bytes */
-    buffer_t  *p_first;
-    buffer_t **pp_last;
+    pthread_cond_t  room;
 };
 
 /* */
@@ -57,144 +91,289 @@ buffer_t *buffer_new(size_t i_size)
     if (buffer == NULL) return NULL;
     buffer->i_size = i_size;
     buffer->i_date = 0;
-    buffer->p_next = NULL;
+    buffer->p_source = NULL;
     buffer->p_data = (uint8_t*)((uint8_t *)buffer + sizeof(buffer_t));
+    buffer->i_datagrams = 0;
+    buffer->p_sizes = NULL;
+    buffer->p_dates = NULL;
+    buffer->b_arena = false;
+    return buffer;
+}
+
+buffer_t *buffer_new_batch(size_t i_size, unsigned i_max)
+{
+    size_t i_header = sizeof(buffer_t) + i_max * (sizeof(mtime_t) + sizeof(size_t));
+    buffer_t *buffer = (buffer_t*)malloc(i_header + i_size);
+    if (buffer == NULL) return NULL;
+    buffer->i_size = i_size;
+    buffer->i_date = 0;
+    buffer->p_source = NULL;
+    buffer->i_datagrams = 0;
+    buffer->p_dates = (mtime_t *)((uint8_t *)buffer + sizeof(buffer_t));
+    buffer->p_sizes = (size_t *)(buffer->p_dates + i_max);
+    buffer->p_data = (uint8_t *)buffer + i_header;
+    buffer->b_arena = false;
+    return buffer;
+}
+
+buffer_t *buffer_new_aligned(size_t i_size, size_t i_align)
+{
+    /* header in the first i_align bytes, freed as any buffer */
+    size_t i_header = (sizeof(buffer_t) + i_align - 1) / i_align * i_align;
+    void *p_block;
+    if (posix_memalign(&p_block, i_align, i_header + i_size) != 0)
+        return NULL;
+    buffer_t *buffer = (buffer_t*)p_block;
+    buffer->i_size = i_size;
+    buffer->i_date = 0;
+    buffer->p_source = NULL;
+    buffer->p_data = (uint8_t *)p_block + i_header;
+    buffer->i_datagrams = 0;
+    buffer->p_sizes = NULL;
+    buffer->p_dates = NULL;
+    buffer->b_arena = false;
     return buffer;
 }
 
 void buffer_free(buffer_t *buffer)
 {
+    if (buffer->b_arena)
+        return;
     free(buffer);
     buffer = NULL;
 }
 
-/* Fifo */
-fifo_t *fifo_new(void)
+/* Arena */
+struct arena_s
 {
-    fifo_t *fifo = (fifo_t *) malloc(sizeof(fifo_t));
-    if (fifo == NULL) return NULL;
-
-    fifo->i_count = 0;
-    fifo->i_size = 0;
-    fifo->b_force_wake = false;
-    fifo->p_first = NULL;
-    fifo->pp_last = &fifo->p_first;
-    pthread_mutex_init(&fifo->lock, NULL);
-    pthread_cond_init(&fifo->wait, NULL);
-    return fifo;
-}
+    uint8_t *p_base;    /* data of the buffers */
+    size_t   i_length;  /* of the mapping */
+    uint8_t *p_headers; /* buffer_t and datagram arrays of the buffers */
+    size_t   i_header;  /* bytes per header */
+    size_t   i_count;
+    bool     b_hugepages;
+};
 
-void fifo_free(fifo_t *fifo)
+arena_t *arena_new(size_t i_bytes, size_t i_size, unsigned i_max)
 {
-    if (fifo == NULL)
-        return;
+#ifdef HAVE_SYS_MMAN_H
+    size_t i_header = ALIGN(sizeof(buffer_t) + i_max * (sizeof(mtime_t) + sizeof(size_t)), 64);
+    size_t i_stride = ALIGN(i_size, ARENA_PAGE);
+    size_t i_length = ALIGN(i_bytes, ARENA_HUGEPAGE);
+    size_t i_count = i_length / i_stride;
+    if (i_count == 0)
+        return NULL;
 
-    pthread_mutex_lock(&fifo->lock);
-    buffer_t *p = fifo->p_first;
-    if (p != NULL)
+    arena_t *arena = (arena_t *) calloc(1, sizeof(arena_t));
+    if (arena == NULL)
+        return NULL;
+    arena->p_headers = (uint8_t *) calloc(i_count, i_header);
+    if (arena->p_headers == NULL)
     {
-        fifo->i_count = 0;
-        fifo->p_first = NULL;
-        fifo->pp_last = &fifo->p_first;
+        free(arena);
+        return NULL;
     }
-    pthread_mutex_unlock(&fifo->lock);
 
-    while (p != NULL)
+    void *p_base = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    p_base = mmap(NULL, i_length, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    arena->b_hugepages = (p_base != MAP_FAILED);
+#endif
+    if (p_base == MAP_FAILED)
     {
-        buffer_t *buffer;
-
-        buffer = p->p_next;
-        buffer_free(p);
-        p = buffer;
+        p_base = mmap(NULL, i_length, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p_base == MAP_FAILED)
+        {
+            free(arena->p_headers);
+            free(arena);
+            return NULL;
+        }
+#if defined(HAVE_MADVISE) && defined(MADV_HUGEPAGE)
+        madvise(p_base, i_length, MADV_HUGEPAGE);
+#endif
     }
 
-    pthread_cond_destroy(&fifo->wait);
-    pthread_mutex_destroy(&fifo->lock);
+    /* first touch, from the thread which uses the buffers */
+    memset(p_base, 0, i_length);
 
-    free(fifo);
-    fifo = NULL;
+    arena->p_base = (uint8_t *)p_base;
+    arena->i_length = i_length;
+    arena->i_header = i_header;
+    arena->i_count = i_count;
+
+    for (size_t i = 0; i < i_count; i++)
+    {
+        buffer_t *buffer = (buffer_t *)(arena->p_headers + i * i_header);
+        buffer->i_size = i_size;
+        buffer->i_date = 0;
+        buffer->p_source = NULL;
+        buffer->i_datagrams = 0;
+        buffer->p_dates = i_max ? (mtime_t *)((uint8_t *)buffer + sizeof(buffer_t)) : NULL;
+        buffer->p_sizes = i_max ? (size_t *)(buffer->p_dates + i_max) : NULL;
+        buffer->p_data = arena->p_base + i * i_stride;
+        buffer->b_arena = true;
+    }
+    return arena;
+#else
+    (void)i_bytes; (void)i_size; (void)i_max;
+    return NULL;
+#endif
 }
 
-void fifo_wake(fifo_t *fifo)
+void arena_free(arena_t *arena)
 {
-    pthread_mutex_lock(&fifo->lock);
-    if (fifo->p_first == NULL)
-        fifo->b_force_wake = true;
-    pthread_cond_broadcast(&fifo->wait);
-    pthread_mutex_unlock(&fifo->lock);
+#ifdef HAVE_SYS_MMAN_H
+    munmap(arena->p_base, arena->i_length);
+#endif
+    free(arena->p_headers);
+    free(arena);
 }
 
-ssize_t fifo_count(fifo_t *fifo)
+size_t arena_count(arena_t *arena)
 {
-    pthread_mutex_lock(&fifo->lock);
-    ssize_t count = fifo->i_count;
-    pthread_mutex_unlock(&fifo->lock);
-    return count;
+    return arena->i_count;
 }
 
-size_t fifo_size(fifo_t *fifo)
+buffer_t *arena_buffer(arena_t *arena, size_t i)
 {
-    pthread_mutex_lock(&fifo->lock);
-    size_t size = fifo->i_size;
-    pthread_mutex_unlock(&fifo->lock);
-    return size;
+    assert(i < arena->i_count);
+    return (buffer_t *)(arena->p_headers + i * arena->i_header);
 }
 
-void fifo_push(fifo_t *fifo, buffer_t *buffer)
+bool arena_hugepages(arena_t *arena)
 {
-    buffer_t *p_last;
-    size_t i_depth = 0;
+    return arena->b_hugepages;
+}
 
-    if (buffer == NULL)
-        return;
+/* Ring */
+ring_t *ring_new(size_t i_slots)
+{
+    size_t i_size = 1;
+    while (i_size < i_slots)
+        i_size <<= 1;
+
+    ring_t *ring = (ring_t *) calloc(1, sizeof(ring_t));
+    if (ring == NULL) return NULL;
 
-    pthread_mutex_lock(&fifo->lock);
-    for (p_last = buffer; ; p_last = p_last->p_next)
+    ring->pp_slots = (buffer_t **) calloc(i_size, sizeof(buffer_t *));
+    if (ring->pp_slots == NULL)
     {
-         i_depth ++;
-         if (!p_last->p_next)
-             break;
+        free(ring);
+        return NULL;
     }
+    ring->i_mask = i_size - 1;
+    pthread_mutex_init(&ring->lock, NULL);
+    pthread_cond_init(&ring->wait, NULL);
+    pthread_cond_init(&ring->room, NULL);
+    return ring;
+}
 
-    *fifo->pp_last = buffer;
-    fifo->pp_last = &p_last->p_next;
-    fifo->i_count += i_depth;
-    fifo->i_size += buffer->i_size;
+void ring_free(ring_t *ring)
+{
+    if (ring == NULL)
+        return;
+
+    buffer_t *buffer;
+    while ((buffer = ring_pop(ring)) != NULL)
+        buffer_free(buffer);
 
-    assert(fifo->p_first != NULL);
-    assert(fifo->pp_last  != NULL);
+    pthread_cond_destroy(&ring->room);
+    pthread_cond_destroy(&ring->wait);
+    pthread_mutex_destroy(&ring->lock);
 
-    pthread_cond_signal(&fifo->wait);
-    pthread_mutex_unlock(&fifo->lock);
+    free(ring->pp_slots);
+    free(ring);
+    ring = NULL;
 }
 
-buffer_t *fifo_pop(fifo_t *fifo)
+void ring_close(ring_t *ring)
 {
-    buffer_t *buffer;
+    pthread_mutex_lock(&ring->lock);
+    RING_STORE(&ring->b_closed, true, SEQ_CST);
+    pthread_cond_broadcast(&ring->wait);
+    pthread_cond_broadcast(&ring->room);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+size_t ring_count(ring_t *ring)
+{
+    return RING_LOAD(&ring->i_tail, ACQUIRE) - RING_LOAD(&ring->i_head, ACQUIRE);
+}
 
-    pthread_mutex_lock(&fifo->lock);
+size_t ring_capacity(const ring_t *ring)
+{
+    return ring->i_mask + 1;
+}
+
+bool ring_push(ring_t *ring, buffer_t *buffer)
+{
+    assert(buffer != NULL);
 
-    while ((fifo->p_first == NULL) && !fifo->b_force_wake)
-        pthread_cond_wait(&fifo->wait, &fifo->lock);
+    size_t i_tail = ring->i_tail;
+    if (i_tail - RING_LOAD(&ring->i_head, ACQUIRE) > ring->i_mask)
+        return false; /* full */
 
-    buffer = fifo->p_first;
-    fifo->b_force_wake = false;
-    if (buffer == NULL)
+    ring->pp_slots[i_tail & ring->i_mask] = buffer;
+    RING_STORE(&ring->i_tail, i_tail + 1, SEQ_CST);
+
+    if (RING_LOAD(&ring->b_sleeping, SEQ_CST))
     {
-        pthread_mutex_unlock(&fifo->lock);
-        return NULL;
+        pthread_mutex_lock(&ring->lock);
+        pthread_cond_signal(&ring->wait);
+        pthread_mutex_unlock(&ring->lock);
     }
+    return true;
+}
 
-    fifo->p_first = buffer->p_next;
-    fifo->i_count--;
-    fifo->i_size -= buffer->i_size;
+buffer_t *ring_pop(ring_t *ring)
+{
+    size_t i_head = ring->i_head;
+    if (i_head == RING_LOAD(&ring->i_tail, ACQUIRE))
+        return NULL; /* empty */
 
-    if (fifo->p_first == NULL)
+    buffer_t *buffer = ring->pp_slots[i_head & ring->i_mask];
+    RING_STORE(&ring->i_head, i_head + 1, SEQ_CST);
+
+    if (RING_LOAD(&ring->b_waiting, SEQ_CST))
     {
-        fifo->pp_last = &fifo->p_first;
+        pthread_mutex_lock(&ring->lock);
+        pthread_cond_signal(&ring->room);
+        pthread_mutex_unlock(&ring->lock);
     }
-    pthread_mutex_unlock(&fifo->lock);
-
-    buffer->p_next = NULL;
     return buffer;
 }
+
+buffer_t *ring_pop_wait(ring_t *ring)
+{
+    buffer_t *buffer = ring_pop(ring);
+    if (buffer != NULL)
+        return buffer;
+
+    pthread_mutex_lock(&ring->lock);
+    RING_STORE(&ring->b_sleeping, true, SEQ_CST);
+    while ((ring->i_head == RING_LOAD(&ring->i_tail, SEQ_CST))
+           && !RING_LOAD(&ring->b_closed, SEQ_CST))
+        pthread_cond_wait(&ring->wait, &ring->lock);
+    RING_STORE(&ring->b_sleeping, false, SEQ_CST);
+    pthread_mutex_unlock(&ring->lock);
+
+    return ring_pop(ring);
+}
+
+bool ring_wait_room(ring_t *ring)
+{
+    if (ring->i_tail - RING_LOAD(&ring->i_head, ACQUIRE) <= ring->i_mask)
+        return true;
+
+    pthread_mutex_lock(&ring->lock);
+    RING_STORE(&ring->b_waiting, true, SEQ_CST);
+    while ((ring->i_tail - RING_LOAD(&ring->i_head, SEQ_CST) > ring->i_mask)
+           && !RING_LOAD(&ring->b_closed, SEQ_CST))
+        pthread_cond_wait(&ring->room, &ring->lock);
+    RING_STORE(&ring->b_waiting, false, SEQ_CST);
+    pthread_mutex_unlock(&ring->lock);
+
+    return ring->i_tail - RING_LOAD(&ring->i_head, ACQUIRE) <= ring->i_mask;
+}
@@ -28,35 +28,73 @@ typedef struct buffer_s buffer_t;
 struct buffer_s
 {
     size_t   i_size;    /* size of buffer data */
-    mtime_t  i_date;    /* timestamp */
-    buffer_t *p_next;   /* pointer to next buffer_t */
+    mtime_t  i_date;    /* arrival, in us */
+    void     *p_source; /* source of the data, multi-input mode */
     uint8_t  *p_data;   /* actuall buffer data */
+
+    /* batched udp capture, i_datagrams being 0 otherwise */
+    unsigned i_datagrams; /* datagrams packed in p_data */
+    size_t   *p_sizes;    /* size of each datagram */
+    mtime_t  *p_dates;    /* receive timestamp of each datagram, in us */
+
+    bool     b_arena;   /* carved from an arena, which frees it */
 };
 
-typedef struct fifo_s fifo_t;
+typedef struct ring_s ring_t;
+typedef struct arena_s arena_t;
 
 /* Buffer management:
  * buffer_new()  - create new buffer of size i_size + plus header structure
+ * buffer_new_batch() - create new buffer with room for the sizes and
+ *                      timestamps of i_max datagrams
+ * buffer_new_aligned() - create new buffer with data aligned on i_align
+ *                        bytes, a power of two, for direct I/O
  * buffer_free() - free buffer
  */
 buffer_t *buffer_new(size_t i_size);
+buffer_t *buffer_new_batch(size_t i_size, unsigned i_max);
+buffer_t *buffer_new_aligned(size_t i_size, size_t i_align);
 void buffer_free(buffer_t *buffer);
 
-/* Fifo:
- * fifo_new()  - create a new fifo holding buffer_t pointers
- * fifo_free() - release fifo and all buffers contained therein
- * fifo_count()- number of buffers in fifo_t
- * fifo_size() - total size of buffers in fifo_t
- * fifo_push() - push buffer at end of fifo
- * fifo_pop()  - pop buffer from start of fifo
- * fifo_wake() - wake up fifo listeners
+/* Arena: buffers preallocated in one mapping, backed by 2 MB hugepages when
+ * the system has some reserved or transparent hugepages otherwise. The
+ * thread creating it touches all its pages, which first-touch policy then
+ * places on the NUMA node of that thread. The data of the buffers follow
+ * each other aligned on 4096 bytes, and buffer_free() leaves them alone.
+ * arena_new()    - carve i_bytes into buffers of i_size bytes, with room for
+ *                  the sizes and timestamps of i_max datagrams when not 0
+ * arena_free()   - release arena and so its buffers, none being in use
+ * arena_count()  - number of buffers of the arena
+ * arena_buffer() - buffer i of the arena
+ * arena_hugepages() - true when backed by reserved hugepages
+ */
+arena_t *arena_new(size_t i_bytes, size_t i_size, unsigned i_max);
+void arena_free(arena_t *arena);
+size_t arena_count(arena_t *arena);
+buffer_t *arena_buffer(arena_t *arena, size_t i);
+bool arena_hugepages(arena_t *arena);
+
+/* Ring: lock-free queue of buffer_t pointers between exactly one pushing
+ * and one popping thread. Only an empty ring makes ring_pop_wait() sleep,
+ * and only a full one makes ring_wait_room() sleep.
+ * ring_new()       - create a ring holding up to i_slots buffers
+ * ring_free()      - release ring and all buffers contained therein
+ * ring_count()     - number of buffers in ring_t
+ * ring_capacity()  - number of buffers ring_t holds at most
+ * ring_push()      - push buffer at end of ring, false if it is full
+ * ring_pop()       - pop buffer from start of ring, NULL if it is empty
+ * ring_pop_wait()  - pop buffer, waiting for one unless the ring is closed
+ * ring_wait_room() - wait till ring is not full, false if it is closed
+ * ring_close()     - wake up ring listeners, waits no longer block
  */
-fifo_t *fifo_new(void);
-void fifo_free(fifo_t *fifo);
-ssize_t fifo_count(fifo_t *fifo);
-size_t fifo_size(fifo_t *fifo);
-void fifo_push(fifo_t *fifo, buffer_t *buffer);
-buffer_t *fifo_pop(fifo_t *fifo);
-void fifo_wake(fifo_t *fifo);
+ring_t *ring_new(size_t i_slots);
+void ring_free(ring_t *ring);
+size_t ring_count(ring_t *ring);
+size_t ring_capacity(const ring_t *ring);
+bool ring_push(ring_t *ring, buffer_t *buffer);
+buffer_t *ring_pop(ring_t *ring);
+buffer_t *ring_pop_wait(ring_t *ring);
+bool ring_wait_room(ring_t *ring);
+void ring_close(ring_t *ring);
 
 #endif
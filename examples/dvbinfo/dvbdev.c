@@ -0,0 +1,406 @@
+/*****************************************************************************
+ * dvbdev.c: Linux DVB adapter capture
+ *****************************************************************************
+ * Copyright (C) 2011 M2X BV
+ *
+ * Authors: Jean-Paul Saman <jpsaman@videolan.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <poll.h>
+
+#if defined(HAVE_INTTYPES_H)
+#   include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#   include <stdint.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/ioctl.h>
+#include <linux/dvb/dmx.h>
+#include <assert.h>
+
+#include "dvbinfo.h"
+#include "libdvbpsi.h"
+#include "dvbdev.h"
+
+#define DVBDEV_TS_SIZE       (188 * 348)       /* bytes of TS read at once */
+#define DVBDEV_TS_BUFFER     (2 * 1024 * 1024) /* demux buffer of the TS filter */
+#define DVBDEV_SECTION_SIZE  4096              /* largest private section */
+#define DVBDEV_SECTION_BUFFER (256 * 1024)     /* demux buffer of a section filter */
+#define DVBDEV_POLL_TIMEOUT  100               /* ms */
+
+typedef struct dvbdev_filter_s
+{
+    int       fd;
+    uint16_t  i_pid;
+    uint8_t   i_table_id;
+    uint8_t   i_mask;
+} dvbdev_filter_t;
+
+typedef struct dvbdev_s
+{
+    params_t *param;
+
+    /* TS mode: one filter of all the PIDs */
+    int       fd_ts;
+    bool      pids[8192];   /* PIDs of the filter */
+    unsigned  i_pids;
+
+    /* section mode: one filter per table_id and mask of a PID */
+    dvbdev_filter_t *p_filters;
+    unsigned  i_filters;
+    unsigned  i_size;       /* filters allocated */
+
+    /* statistics */
+    uint64_t  i_bytes;
+    uint64_t  i_sections;
+    uint64_t  i_overflows;  /* reads the demux buffer overflowed before */
+    unsigned  i_failed;     /* PIDs or filters the demux refused */
+} dvbdev_t;
+
+/* Adds a PID to the TS filter, the first one setting it up */
+static void dvbdev_add_pid(dvbdev_t *dev, uint16_t i_pid)
+{
+    if (dev->pids[i_pid])
+        return;
+
+    int ret;
+    if (dev->i_pids == 0)
+    {
+        struct dmx_pes_filter_params pes;
+        memset(&pes, 0, sizeof(pes));
+        pes.pid = i_pid;
+        pes.input = DMX_IN_FRONTEND;
+        pes.output = DMX_OUT_TSDEMUX_TAP;
+        pes.pes_type = DMX_PES_OTHER;
+        pes.flags = DMX_IMMEDIATE_START;
+        ret = ioctl(dev->fd_ts, DMX_SET_PES_FILTER, &pes);
+    }
+    else
+        ret = ioctl(dev->fd_ts, DMX_ADD_PID, &i_pid);
+
+    if (ret < 0)
+    {
+        dev->i_failed++;
+        libdvbpsi_log(dev->param, DVBINFO_LOG_WARN, "dvb: cannot filter PID 0x%x (%s)\n",
+                      i_pid, strerror(errno));
+        return;
+    }
+    dev->pids[i_pid] = true;
+    dev->i_pids++;
+    libdvbpsi_log(dev->param, DVBINFO_LOG_DEBUG, "dvb: filtering PID 0x%x\n", i_pid);
+}
+
+/* Sets up a section filter of a table_id and mask of a PID */
+static void dvbdev_add_filter(dvbdev_t *dev, uint16_t i_pid, uint8_t i_table_id,
+                              uint8_t i_mask)
+{
+    for (unsigned i = 0; i < dev->i_filters; i++)
+    {
+        const dvbdev_filter_t *filter = &dev->p_filters[i];
+        if ((filter->i_pid == i_pid) && (filter->i_table_id == i_table_id) &&
+            (filter->i_mask == i_mask))
+            return;
+    }
+
+    if (dev->i_filters == dev->i_size)
+    {
+        unsigned i_size = dev->i_size ? 2 * dev->i_size : 16;
+        dvbdev_filter_t *p_filters = realloc(dev->p_filters, i_size * sizeof(dvbdev_filter_t));
+        if (p_filters == NULL)
+        {
+            dev->i_failed++;
+            return;
+        }
+        dev->p_filters = p_filters;
+        dev->i_size = i_size;
+    }
+
+    int fd = open(dev->param->input, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+        goto error;
+
+    /* the default of a few kB overflows on a burst of EIT schedule */
+    ioctl(fd, DMX_SET_BUFFER_SIZE, DVBDEV_SECTION_BUFFER);
+
+    struct dmx_sct_filter_params sct;
+    memset(&sct, 0, sizeof(sct));
+    sct.pid = i_pid;
+    sct.filter.filter[0] = i_table_id;
+    sct.filter.mask[0] = i_mask;
+    sct.timeout = 0;
+    sct.flags = DMX_IMMEDIATE_START;
+    if (ioctl(fd, DMX_SET_FILTER, &sct) < 0)
+        goto error;
+
+    dvbdev_filter_t *filter = &dev->p_filters[dev->i_filters++];
+    filter->fd = fd;
+    filter->i_pid = i_pid;
+    filter->i_table_id = i_table_id;
+    filter->i_mask = i_mask;
+    libdvbpsi_log(dev->param, DVBINFO_LOG_DEBUG,
+                  "dvb: filtering table_id 0x%02x/0x%02x on PID 0x%x\n",
+                  i_table_id, i_mask, i_pid);
+    return;
+
+error:
+    dev->i_failed++;
+    libdvbpsi_log(dev->param, DVBINFO_LOG_WARN,
+                  "dvb: cannot filter table_id 0x%02x/0x%02x on PID 0x%x (%s)\n",
+                  i_table_id, i_mask, i_pid, strerror(errno));
+    if (fd >= 0)
+        close(fd);
+}
+
+/* PID decoded by the stream, see libdvbpsi_pids() */
+static void dvbdev_pid(void *data, uint16_t i_pid, uint8_t i_table_id, uint8_t i_mask)
+{
+    dvbdev_t *dev = (dvbdev_t *)data;
+
+    if (dev->param->b_dvb_sections)
+        dvbdev_add_filter(dev, i_pid, i_table_id, i_mask);
+    else
+        dvbdev_add_pid(dev, i_pid);
+}
+
+static bool dvbdev_open(dvbdev_t *dev, params_t *param)
+{
+    memset(dev, 0, sizeof(dvbdev_t));
+    dev->param = param;
+    dev->fd_ts = -1;
+
+    if (param->b_dvb_sections)
+        return true;
+
+    dev->fd_ts = open(param->input, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (dev->fd_ts < 0)
+    {
+        libdvbpsi_log(param, DVBINFO_LOG_ERROR, "dvb: cannot open %s (%s)\n",
+                      param->input, strerror(errno));
+        return false;
+    }
+    if (ioctl(dev->fd_ts, DMX_SET_BUFFER_SIZE, DVBDEV_TS_BUFFER) < 0)
+        libdvbpsi_log(param, DVBINFO_LOG_WARN, "dvb: cannot set the demux buffer size (%s)\n",
+                      strerror(errno));
+    return true;
+}
+
+static void dvbdev_close(dvbdev_t *dev)
+{
+    if (dev->fd_ts >= 0)
+    {
+        ioctl(dev->fd_ts, DMX_STOP);
+        close(dev->fd_ts);
+    }
+    for (unsigned i = 0; i < dev->i_filters; i++)
+    {
+        ioctl(dev->p_filters[i].fd, DMX_STOP);
+        close(dev->p_filters[i].fd);
+    }
+    free(dev->p_filters);
+}
+
+/* Reads a descriptor of the demux, false on a fatal error */
+static bool dvbdev_read(dvbdev_t *dev, ts_stream_t *stream, int fd, uint16_t i_pid,
+                        uint8_t *p_buffer, size_t i_size)
+{
+    ssize_t i_len = read(fd, p_buffer, i_size);
+    if (i_len < 0)
+    {
+        /* the data lost is gone, the next read gets what came after */
+        if (errno == EOVERFLOW)
+        {
+            dev->i_overflows++;
+            return true;
+        }
+        if ((errno == EAGAIN) || (errno == EINTR))
+            return true;
+        libdvbpsi_log(dev->param, DVBINFO_LOG_ERROR, "dvb: read error: %s\n",
+                      strerror(errno));
+        return false;
+    }
+    if (i_len == 0)
+        return true;
+
+    dev->i_bytes += i_len;
+    if (!dev->param->b_dvb_sections)
+    {
+        if (dev->param->output)
+        {
+            ssize_t size = dev->param->pf_write(dev->param->fd_out, p_buffer, i_len);
+            if ((size < 0) || (size < i_len))
+            {
+                libdvbpsi_log(dev->param, DVBINFO_LOG_ERROR,
+                              "error writting to %s\n", dev->param->output);
+                return false;
+            }
+        }
+        return libdvbpsi_process(stream, p_buffer, i_len, udate());
+    }
+
+    dev->i_sections++;
+    libdvbpsi_process_section(stream, i_pid, p_buffer, i_len, udate());
+    return true;
+}
+
+/* Summary */
+static bool dvbdev_summary_file(dvbdev_t *dev, params_t *param,
+                                ts_stream_t *stream, const char *psz_temp)
+{
+    FILE *fd = fopen(psz_temp, "w+");
+    if (fd == NULL)
+    {
+        libdvbpsi_log(param, DVBINFO_LOG_ERROR,
+                      "failed opening summary file (disabling summary logging)\n");
+        return false;
+    }
+    fprintf(fd, "\n=========================================================\n");
+    if (param->b_dvb_sections)
+        fprintf(fd, "DVB: %s, section filters: %u, sections: %"PRIu64", bytes: %"PRIu64
+                ", overflows: %"PRIu64", refused: %u\n", param->input, dev->i_filters,
+                dev->i_sections, dev->i_bytes, dev->i_overflows, dev->i_failed);
+    else
+        fprintf(fd, "DVB: %s, PIDs: %u, bytes: %"PRIu64", overflows: %"PRIu64
+                ", refused: %u\n", param->input, dev->i_pids, dev->i_bytes,
+                dev->i_overflows, dev->i_failed);
+    libdvbpsi_summary(fd, stream, param->summary.mode);
+    fflush(fd);
+    fclose(fd);
+    unlink(param->summary.file);
+    if (rename(psz_temp, param->summary.file) < 0)
+    {
+        libdvbpsi_log(param, DVBINFO_LOG_ERROR,
+                      "failed renming summary file (disabling summary logging)\n");
+        return false;
+    }
+    return true;
+}
+
+int dvbinfo_dvb(params_t *param)
+{
+    int err = -1;
+    dvbdev_t dev;
+    char *psz_temp = NULL;
+    mtime_t deadline = 0;
+    struct pollfd *pfd = NULL;
+    unsigned i_pfd = 0;
+
+    size_t i_size = param->b_dvb_sections ? DVBDEV_SECTION_SIZE : DVBDEV_TS_SIZE;
+    uint8_t *p_buffer = malloc(i_size);
+    if (p_buffer == NULL)
+        return err;
+
+    if (!dvbdev_open(&dev, param))
+    {
+        free(p_buffer);
+        return err;
+    }
+
+    ts_stream_t *stream = libdvbpsi_init(param->debug, &libdvbpsi_log, (void *)param);
+    if (stream == NULL)
+        goto out;
+    libdvbpsi_trace(stream, param->trace, param->b_trace_events);
+    if (param->b_profile && !libdvbpsi_profile(stream, true))
+        libdvbpsi_log(param, DVBINFO_LOG_ERROR, "Could not profile the tables\n");
+
+    /* the PIDs decoded from the start, the others coming with the PAT */
+    libdvbpsi_pids(stream, dvbdev_pid, &dev);
+    if ((dev.i_pids == 0) && (dev.i_filters == 0))
+    {
+        libdvbpsi_log(param, DVBINFO_LOG_ERROR, "dvb: no filter could be set on %s\n",
+                      param->input);
+        goto out;
+    }
+
+    bool b_summary_file = param->b_summary && param->summary.file;
+    if (b_summary_file)
+    {
+        if (asprintf(&psz_temp, "%s.part", param->summary.file) < 0)
+            b_summary_file = false;
+        deadline = mdate() + param->summary.period;
+    }
+
+    libdvbpsi_log(param, DVBINFO_LOG_INFO, "DVB: %s filters\n",
+                  param->b_dvb_sections ? "section" : "PID");
+
+    for (;;)
+    {
+        /* the filters added while processing are polled from the next round */
+        unsigned i_count = param->b_dvb_sections ? dev.i_filters : 1;
+        if (i_count > i_pfd)
+        {
+            struct pollfd *p_new = realloc(pfd, i_count * sizeof(struct pollfd));
+            if (p_new == NULL)
+                break;
+            pfd = p_new;
+            i_pfd = i_count;
+        }
+        for (unsigned i = 0; i < i_count; i++)
+        {
+            pfd[i].fd = param->b_dvb_sections ? dev.p_filters[i].fd : dev.fd_ts;
+            pfd[i].events = POLLIN | POLLPRI;
+            pfd[i].revents = 0;
+        }
+
+        if (poll(pfd, i_count, DVBDEV_POLL_TIMEOUT) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            libdvbpsi_log(param, DVBINFO_LOG_ERROR, "poll error: %s\n", strerror(errno));
+            break;
+        }
+
+        bool b_ok = true;
+        for (unsigned i = 0; b_ok && (i < i_count); i++)
+        {
+            if ((pfd[i].revents & (POLLIN | POLLPRI | POLLERR)) == 0)
+                continue;
+            uint16_t i_pid = param->b_dvb_sections ? dev.p_filters[i].i_pid : 0x1fff;
+            b_ok = dvbdev_read(&dev, stream, pfd[i].fd, i_pid, p_buffer, i_size);
+        }
+        if (!b_ok)
+            break;
+
+        /* summary statistics */
+        if (b_summary_file && (mdate() >= deadline))
+        {
+            b_summary_file = dvbdev_summary_file(&dev, param, stream, psz_temp);
+            deadline = mdate() + param->summary.period;
+        }
+    }
+
+out:
+    if (stream)
+    {
+        libdvbpsi_pids(stream, NULL, NULL);
+        libdvbpsi_exit(stream);
+    }
+    free(pfd);
+    free(psz_temp);
+    free(p_buffer);
+    dvbdev_close(&dev);
+    return err;
+}
@@ -0,0 +1,43 @@
+/*****************************************************************************
+ * dvbdev.h: Linux DVB adapter capture
+ *****************************************************************************
+ * Copyright (C) 2011 M2X BV
+ *
+ * Authors: Jean-Paul Saman <jpsaman@videolan.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *****************************************************************************/
+
+#ifndef DVBINFO_DVBDEV_H_
+#define DVBINFO_DVBDEV_H_
+
+/* DVB adapter capture mode:
+ * dvbinfo_dvb() - monitor the mux tuned on the demux device param->input,
+ *                 /dev/dvb/adapter<n>/demux<m>, the demux filtering only
+ *                 the PSI/SI PIDs the stream decodes, see libdvbpsi_pids(),
+ *                 the PMT PIDs being added as the PAT gives them. Without
+ *                 param->b_dvb_sections one TS filter of all the PIDs is
+ *                 read from the demux device itself and processed as a byte
+ *                 stream, written to param->output if any. With it each
+ *                 table_id and mask of a PID has a section filter, whole
+ *                 sections being read and pushed with
+ *                 libdvbpsi_process_section(). The CRC_32 is left to the
+ *                 decoders so that their statistics count the errors. The
+ *                 summary file reports the filters set and the reads the
+ *                 demux buffers overflowed on.
+ */
+int dvbinfo_dvb(params_t *param);
+
+#endif
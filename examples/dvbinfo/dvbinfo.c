@@ -57,6 +57,9 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#ifdef HAVE_SYS_MMAN_H
+#   include <sys/mman.h>
+#endif
 
 #ifdef HAVE_SYS_SOCKET_H
 #   include <netdb.h>
@@ -70,10 +73,21 @@
 #include "dvbinfo.h"
 #include "libdvbpsi.h"
 #include "buffer.h"
+#include "input.h"
 
 #ifdef HAVE_SYS_SOCKET_H
 #   include "udp.h"
 #   include "tcp.h"
+#   include "multi.h"
+#endif
+#ifdef HAVE_LINUX_IF_PACKET_H
+#   include "pktring.h"
+#endif
+#ifdef HAVE_LINUX_DVB_DMX_H
+#   include "dvbdev.h"
+#endif
+#ifdef HAVE_SHM_OPEN
+#   include "stats.h"
 #endif
 
 #if __APPLE__
@@ -82,6 +96,7 @@ extern int daemon(int, int);
 #endif
 
 #define FIFO_THRESHOLD_SIZE (400 * 1024 * 1024) /* threshold in bytes */
+#define ARENA_SIZE (64 * 1024 * 1024) /* capture buffers preallocated in bytes */
 #define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
 
 #ifdef HAVE_SYS_SOCKET_H
@@ -94,14 +109,10 @@ static const char *psz_summary_mode[] = { "bandwidth", "table", "packet", "wire"
  *****************************************************************************/
 typedef struct dvbinfo_capture_s
 {
-    fifo_t  *fifo;
-    fifo_t  *empty;
-
-    pthread_mutex_t lock;
-    pthread_cond_t  fifo_full;
-    bool     b_fifo_full;
-
-    size_t   size;  /* prefered capture size */
+    ring_t  *fifo;  /* captured buffers */
+    ring_t  *empty; /* buffers to reuse */
+    input_t *input;
+    pthread_t recycler; /* processing thread, the producer of empty */
 
     params_t *params;
     bool      b_alive;
@@ -113,21 +124,52 @@ typedef struct dvbinfo_capture_s
 static void usage(void)
 {
 #ifdef HAVE_SYS_SOCKET_H
-    printf("Usage: dvbinfo [-h] [-d <debug>] [-f <filename> | -m | -c <bufsize> | [[-u|-t] -a <mcast_interface> -i <ipaddress:port>] -o <outputfile>\n");
+    printf("Usage: dvbinfo [-h] [-d <debug>] [-P] [-J <file>] [-f <filename> | -m | -c <bufsize> | [[-u|-r|-t] -a <mcast_interface> -i <ipaddress:port>] | -D <adapter>[:<demux>] [-F]] -o <outputfile>\n");
+    printf("               [-l <sources> [-w <workers>] [-C]]\n");
     printf("               [-s [bandwidth|table|packet] --summary-file <file> --summary-period <ms>]\n");
 #else
-    printf("Usage: dvbinfo [-h] [-d <debug>] [-f|\n");
+    printf("Usage: dvbinfo [-h] [-d <debug>] [-P] [-J <file>] [-f|\n");
 #endif
     printf("\n");
     printf(" -d | --debug          : debug level (default:none, error, warn, debug)\n");
+    printf(" -T | --trace          : dump one packet in n, 0 for none\n");
+    printf("                         (default: every packet at the debug level, none otherwise)\n");
+    printf(" -E | --trace-events   : dump the packets with a continuity error,\n");
+    printf("                         a discontinuity indicator or a PCR going back\n");
+    printf(" -P | --profile        : rank the tables by decoding CPU time per PID and table_id,\n");
+    printf("                         printed with the table summary and at exit\n");
+    printf(" -J | --json           : file to write each table to as a line of JSON, - for stdout\n");
     printf(" -h | --help           : help information\n");
     printf("\nInputs: \n");
     printf(" -f | --file           : filename\n");
+#ifdef HAVE_IO_URING
+    printf(" -e | --uring          : read the file ahead with io_uring, bypassing the page\n");
+    printf("                         cache when the file system allows it\n");
+#endif
 #ifdef HAVE_SYS_SOCKET_H
     printf(" -i | --ipadddress     : hostname or ipaddress\n");
     printf(" -a | --miface         : multicast interface to use\n");
     printf(" -t | --tcp            : tcp network transport\n");
     printf(" -u | --udp            : udp network transport\n");
+#ifdef HAVE_LINUX_IF_PACKET_H
+    printf(" -r | --ring           : capture udp from a packet socket ring on the multicast\n");
+    printf("                         interface or all interfaces (IPv4, needs CAP_NET_RAW)\n");
+#endif
+#ifdef HAVE_LINUX_DVB_DMX_H
+    printf(" -D | --dvb            : DVB adapter <n>[:<demux>], filtering the PSI/SI PIDs\n");
+    printf("                         found in the demux and reading them from it\n");
+    printf(" -F | --dvb-sections   : with --dvb, set a section filter per table_id of\n");
+    printf("                         each PSI/SI PID instead, reading whole sections\n");
+#endif
+    printf(" -l | --sources        : file listing sources to monitor at once, one per line:\n");
+    printf("                         <filename>, udp://[<mcast_interface>@]<ipaddress:port>\n");
+    printf("                         or tcp://<ipaddress:port>, multicast groups of the same\n");
+    printf("                         interface and port sharing a socket, a /<source> after\n");
+    printf("                         the port joining from that source only, a cpu=<n>\n");
+    printf("                         after a blank processing the source on that cpu\n");
+    printf(" -w | --workers        : worker threads for --sources (default: one per cpu)\n");
+    printf(" -C | --steer          : with --sources, process each udp source with its own\n");
+    printf("                         socket on the cpu receiving its datagrams\n");
     printf("\nOutputs: \n");
     printf(" -o | --output         : output incoming data to filename\n");
     printf("\nStatistics: \n");
@@ -139,8 +181,22 @@ static void usage(void)
 //    printf("                         wire = print arrival time per packet (wireshark like)\n");
     printf(" -j | --summary-file   : file to write summary information to (default: stdout)\n");
     printf(" -p | --summary-period : refresh summary file every n milliseconds (default: 1000ms)\n");
+#ifdef HAVE_SHM_OPEN
+    printf(" -S | --stats          : publish live counters in this POSIX shared memory object\n");
+    printf("                         (e.g. /dvbinfo), see stats.h for its layout\n");
+    printf(" -H | --stats-http     : serve the live counters as text on this tcp port\n");
+    printf(" -M | --tables-shm     : publish the decoded tables in this POSIX shared memory\n");
+    printf("                         object (e.g. /dvbinfo-tables), see shm.h for its layout\n");
+#endif
     printf("\nTuning options: \n");
     printf(" -c | --capture buffer size : number of bytes in capture buffer (default: %d bytes)\n", FIFO_THRESHOLD_SIZE);
+    printf(" -b | --buffers        : MB of capture buffers preallocated on hugepages, 0 for none\n");
+    printf("                         (default: %d MB)\n", ARENA_SIZE / (1024 * 1024));
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+    printf(" -x | --capture-cpu    : run the capture thread on this cpu\n");
+    printf(" -y | --process-cpu    : run the processing thread on this cpu, its NUMA node\n");
+    printf("                         holding the preallocated buffers\n");
+#endif
 #endif
     exit(EXIT_FAILURE);
 }
@@ -151,7 +207,7 @@ static int log_level[] = { LOG_ERR, LOG_WARNING, LOG_INFO, LOG_DEBUG };
 #endif
 static const char *psz_level[] = { "ERROR", "WARNING", "INFO", "DEBUG" };
 
-static void libdvbpsi_log(void *data, const int level, const char *format, ...)
+void libdvbpsi_log(void *data, const int level, const char *format, ...)
 {
     int err = 0;
     char *msg = NULL;
@@ -201,9 +257,12 @@ static params_t *params_init(void)
 
     param->b_verbose = false;
     param->b_monitor = false;
+    param->trace = -1;
 
     /* tuning options */
     param->threshold = FIFO_THRESHOLD_SIZE;
+    param->arena = ARENA_SIZE;
+    param->capture_cpu = param->process_cpu = -1;
 
     /* statistics */
     param->b_summary = false;
@@ -213,7 +272,6 @@ static params_t *params_init(void)
     param->summary.period = 1000; /* in ms */
 
     /* functions */
-    param->pf_read = NULL;
     param->pf_write = NULL;
     return param;
 }
@@ -223,7 +281,11 @@ static void params_free(params_t *param)
     free(param->mcast_interface);
     free(param->input);
     free(param->output);
+    free(param->sources);
     free(param->summary.file);
+    free(param->json);
+    free(param->stats);
+    free(param->tables);
     free(param);
     param = NULL;
 }
@@ -232,21 +294,15 @@ static void params_free(params_t *param)
 static void dvbinfo_close(params_t *param)
 {
 #ifdef HAVE_SYS_SOCKET_H
-    if (param->input && param->b_udp && (param->fd_in >= 0))
+    if (param->fd_in >= 0)
         udp_close(param->fd_in);
-    else if (param->input && param->b_tcp && (param->fd_in >= 0))
-        tcp_close(param->fd_in);
-    else
 #endif
-    if (param->input && (param->fd_in >= 0))
-        close(param->fd_in);
     if (param->output && (param->fd_out >= 0))
         close(param->fd_out);
 }
 
 static void dvbinfo_open(params_t *param)
 {
-#ifdef HAVE_SYS_SOCKET_H
     if (param->output)
     {
         param->fd_out = open(param->output, O_CREAT | O_RDWR | O_NONBLOCK
@@ -254,26 +310,15 @@ static void dvbinfo_open(params_t *param)
         if (param->fd_out < 0)
             goto error;
     }
-    if (param->input && param->b_udp)
+#ifdef HAVE_LINUX_IF_PACKET_H
+    /* joins the group, the packet socket ring capturing the datagrams */
+    if (param->b_ring)
     {
         param->fd_in = udp_open(param->mcast_interface, param->input, param->port);
         if (param->fd_in < 0)
             goto error;
     }
-    else if (param->input && param->b_tcp)
-    {
-        param->fd_in = tcp_open(param->input, param->port);
-        if (param->fd_in < 0)
-            goto error;
-    }
-    else
 #endif
-    if (param->input)
-    {
-        param->fd_in = open(param->input, O_RDONLY | O_NONBLOCK);
-        if (param->fd_in < 0)
-            goto error;
-    }
     return;
 
 error:
@@ -282,72 +327,224 @@ error:
     exit(EXIT_FAILURE);
 }
 
+/* Opens the input of the command line */
+static input_t *dvbinfo_input(params_t *param)
+{
+#ifdef HAVE_SYS_SOCKET_H
+    if (param->b_udp)
+        return input_udp(param->mcast_interface, param->input, param->port, 0, 0);
+    if (param->b_tcp)
+        return input_tcp(param->input, param->port, 0);
+#endif
+    if (param->b_uring)
+    {
+        input_t *input = input_file(param->input, 0, INPUT_URING);
+        if (input)
+            return input;
+        libdvbpsi_log(param, DVBINFO_LOG_WARN, "io_uring unavailable (%s), reading %s\n",
+                      strerror(errno), param->input);
+    }
+    return input_file(param->input, 0, INPUT_MAP);
+}
+
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+static void thread_pin(params_t *param, pthread_t thread, int cpu, const char *psz_thread)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int err = pthread_setaffinity_np(thread, sizeof(set), &set);
+    if (err != 0)
+        libdvbpsi_log(param, DVBINFO_LOG_WARN, "could not run the %s thread on cpu %d (%s)\n",
+                      psz_thread, cpu, strerror(err));
+}
+#endif
+
+/* Gives a buffer back for reuse, the previous size of the empty ring
+ * bounding the buffers kept. The empty ring having a single producer, only
+ * the processing thread recycles buffers. */
+static void capture_recycle(dvbinfo_capture_t *capture, buffer_t *buffer)
+{
+    assert(pthread_equal(pthread_self(), capture->recycler));
+    if (!ring_push(capture->empty, buffer))
+        buffer_free(buffer);
+}
+
 static void *dvbinfo_capture(void *data)
 {
     dvbinfo_capture_t *capture = (dvbinfo_capture_t *)data;
-    const params_t *param = capture->params;
-    bool b_eof = false;
+    input_t *input = capture->input;
+    buffer_t *spare = NULL; /* kept after a failed read or a full fifo */
 
-    while (capture->b_alive && !b_eof)
+    while (capture->b_alive)
     {
-        buffer_t *buffer;
-
-        if (fifo_count(capture->empty) == 0)
-            buffer = buffer_new(capture->size);
-        else
-            buffer = fifo_pop(capture->empty);
-
+        buffer_t *buffer = spare;
+        spare = NULL;
+        if (buffer == NULL)
+            buffer = ring_pop(capture->empty);
+        if (buffer == NULL)
+            buffer = input_buffer(input);
         if (buffer == NULL) /* out of memory */
             break;
 
-        ssize_t size = param->pf_read(param->fd_in, buffer->p_data, buffer->i_size);
-        if (size < 0) /* short read ? */
+        ssize_t size = input_read(input, &buffer);
+        if (size <= 0)
         {
-            fifo_push(capture->empty, buffer);
-            continue;
+            spare = buffer;
+            if (size == 0) /* end of input */
+                break;
+            if ((errno == EAGAIN) || (errno == EINTR) || !input->b_file)
+                continue;
+            libdvbpsi_log(capture->params, DVBINFO_LOG_ERROR,
+                          "error reading file (%s)\n", strerror(errno));
+            break;
         }
-        else if (size == 0)
+
+        /* store buffer */
+        if (!ring_push(capture->fifo, buffer))
         {
-            fifo_push(capture->empty, buffer);
-            b_eof = true;
-            continue;
+            /* wait till processing catches up, unless stopped */
+            if (input->b_file && ring_wait_room(capture->fifo)
+                && ring_push(capture->fifo, buffer))
+                continue;
+
+            libdvbpsi_log(capture->params, DVBINFO_LOG_ERROR,
+                      "error fifo full discarding buffer\n");
+            spare = buffer;
         }
+    }
+
+    if (spare)
+        buffer_free(spare);
+    capture->b_alive = false;
+    ring_close(capture->fifo);
+    return NULL;
+}
 
-        buffer->i_date = mdate();
+/* Bytes of data of a buffer */
+static size_t buffer_length(const buffer_t *buffer)
+{
+    if (buffer->i_datagrams == 0)
+        return buffer->i_size;
+
+    size_t length = 0;
+    for (unsigned i = 0; i < buffer->i_datagrams; i++)
+        length += buffer->p_sizes[i];
+    return length;
+}
 
-        /* check fifo size */
-        if (fifo_size(capture->fifo) >= param->threshold)
+/*****************************************************************************
+ * Output writer, writing the buffers while the processing thread parses
+ * them. It only reads the buffers and gives them back once written, the
+ * processing thread, done with them by then, recycling them.
+ *****************************************************************************/
+typedef struct dvbinfo_writer_s
+{
+    ring_t   *queue;    /* buffers to write */
+    ring_t   *written;  /* buffers written */
+    params_t *params;
+    bool      b_error;  /* writing failed, set by the writer */
+    pthread_t handle;
+} dvbinfo_writer_t;
+
+static void *dvbinfo_write(void *data)
+{
+    dvbinfo_writer_t *writer = (dvbinfo_writer_t *)data;
+    const params_t *param = writer->params;
+    buffer_t *buffer;
+
+    while ((buffer = ring_pop_wait(writer->queue)) != NULL)
+    {
+        if (!__atomic_load_n(&writer->b_error, __ATOMIC_RELAXED))
         {
-            pthread_mutex_lock(&capture->lock);
-            capture->b_fifo_full = true;
-            pthread_mutex_unlock(&capture->lock);
+            size_t length = buffer_length(buffer);
+            ssize_t size = param->pf_write(param->fd_out, buffer->p_data, length);
+            if (size < 0) /* error writing */
+                libdvbpsi_log(writer->params, DVBINFO_LOG_ERROR,
+                              "error (%d) writting to %s\n", errno, param->output);
+            else if ((size_t)size < length) /* short writting disk full? */
+                libdvbpsi_log(writer->params, DVBINFO_LOG_ERROR,
+                              "error writting to %s (disk full?)\n", param->output);
+            if ((size < 0) || ((size_t)size < length))
+                __atomic_store_n(&writer->b_error, true, __ATOMIC_RELAXED);
+        }
 
-            if (param->b_file)
-            {
-                /* wait till buffer becomes smaller again */
-                pthread_mutex_lock(&capture->lock);
-                while(capture->b_fifo_full)
-                    pthread_cond_wait(&capture->fifo_full, &capture->lock);
-                pthread_mutex_unlock(&capture->lock);
-            }
-            else
+        /* twice the queue size, it has room once the processing thread
+         * took the buffers back */
+        while (!ring_push(writer->written, buffer))
+        {
+            if (!ring_wait_room(writer->written))
             {
-                libdvbpsi_log(capture->params, DVBINFO_LOG_ERROR,
-                          "error fifo full discarding buffer\n");
-                fifo_push(capture->empty, buffer);
-                continue;
+                buffer_free(buffer);
+                break;
             }
         }
+    }
+    return NULL;
+}
 
-        /* store buffer */
-        fifo_push(capture->fifo, buffer);
-        buffer = NULL;
+static bool writer_start(dvbinfo_writer_t *writer, params_t *param, size_t slots)
+{
+    writer->params = param;
+    writer->b_error = false;
+    writer->queue = ring_new(slots);
+    writer->written = ring_new(2 * slots);
+    if ((writer->queue == NULL) || (writer->written == NULL) ||
+        (pthread_create(&writer->handle, NULL, dvbinfo_write, (void *)writer) != 0))
+    {
+        ring_free(writer->queue);
+        ring_free(writer->written);
+        return false;
     }
+    return true;
+}
 
-    capture->b_alive = false;
-    fifo_wake(capture->fifo);
-    return NULL;
+/* Takes the written buffers back for reuse, from the processing thread,
+ * the writer only giving them back through its written ring */
+static void writer_collect(dvbinfo_writer_t *writer, dvbinfo_capture_t *capture)
+{
+    buffer_t *buffer;
+    while ((buffer = ring_pop(writer->written)) != NULL)
+        capture_recycle(capture, buffer);
+}
+
+static void writer_stop(dvbinfo_writer_t *writer, dvbinfo_capture_t *capture)
+{
+    ring_close(writer->queue);
+    if (pthread_join(writer->handle, NULL) != 0)
+        libdvbpsi_log(writer->params, DVBINFO_LOG_ERROR, "error joining output thread\n");
+    writer_collect(writer, capture);
+    ring_free(writer->queue);
+    ring_free(writer->written);
+}
+
+#ifdef HAVE_SHM_OPEN
+/* The shared memory of --tables-shm, formatted by libdvbpsi_publish() */
+static void *tables_open(const char *psz_name, size_t i_size)
+{
+    int fd = shm_open(psz_name, O_CREAT | O_RDWR, 0644);
+    if (fd < 0)
+        return NULL;
+
+    void *p_region = NULL;
+    if (ftruncate(fd, i_size) == 0)
+    {
+        p_region = mmap(NULL, i_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p_region == MAP_FAILED)
+            p_region = NULL;
+    }
+    close(fd);
+    if (!p_region)
+        shm_unlink(psz_name);
+    return p_region;
+}
+
+static void tables_close(void *p_region, size_t i_size, const char *psz_name)
+{
+    munmap(p_region, i_size);
+    shm_unlink(psz_name);
 }
+#endif
 
 static int dvbinfo_process(dvbinfo_capture_t *capture)
 {
@@ -355,6 +552,9 @@ static int dvbinfo_process(dvbinfo_capture_t *capture)
     bool b_error = false;
     params_t *param = capture->params;
     buffer_t *buffer = NULL;
+    dvbinfo_writer_t writer;
+    bool b_writer = false;
+    FILE *json = NULL;
 
     char *psz_temp = NULL;
     mtime_t deadline = 0;
@@ -369,40 +569,123 @@ static int dvbinfo_process(dvbinfo_capture_t *capture)
         deadline = mdate() + param->summary.period;
     }
 
+#ifdef HAVE_SHM_OPEN
+    /* live statistics, read by collectors at any rate */
+    stats_t *stats = NULL;
+    stats_http_t *http = NULL;
+    mtime_t stats_deadline = 0;
+    void *tables = NULL;
+    if (param->stats)
+    {
+        stats = stats_open(param->stats);
+        if (!stats)
+        {
+            libdvbpsi_log(param, DVBINFO_LOG_ERROR, "Could not create shared memory %s (%s)\n",
+                          param->stats, strerror(errno));
+            free(psz_temp);
+            return err;
+        }
+        if (param->stats_port > 0)
+        {
+            http = stats_http_start(stats, param->stats_port);
+            if (!http)
+                libdvbpsi_log(param, DVBINFO_LOG_ERROR, "Could not serve statistics on port %d\n",
+                              param->stats_port);
+        }
+    }
+#endif
+
     ts_stream_t *stream = libdvbpsi_init(param->debug, &libdvbpsi_log, (void *)param);
     if (!stream)
         goto out;
+    libdvbpsi_trace(stream, param->trace, param->b_trace_events);
+    if (param->b_profile && !libdvbpsi_profile(stream, true))
+        libdvbpsi_log(param, DVBINFO_LOG_ERROR, "Could not profile the tables\n");
+    if (param->json)
+    {
+        json = strcmp(param->json, "-") ? fopen(param->json, "w") : stdout;
+        if (!json || !libdvbpsi_json(stream, json))
+            libdvbpsi_log(param, DVBINFO_LOG_ERROR, "Could not write the tables to %s\n",
+                          param->json);
+    }
+#ifdef HAVE_SHM_OPEN
+    if (param->tables)
+    {
+        tables = tables_open(param->tables, libdvbpsi_publish_size());
+        if (!tables || !libdvbpsi_publish(stream, tables))
+            libdvbpsi_log(param, DVBINFO_LOG_ERROR, "Could not publish the tables in %s (%s)\n",
+                          param->tables, strerror(errno));
+    }
+#endif
+
+    /* Output from its own thread, a slow disk not delaying the parsing */
+    if (param->output)
+    {
+        b_writer = writer_start(&writer, param, param->threshold / capture->input->size);
+        if (!b_writer)
+        {
+            libdvbpsi_log(param, DVBINFO_LOG_ERROR, "failed creating output thread\n");
+            libdvbpsi_exit(stream);
+            goto out;
+        }
+    }
 
     while (!b_error)
     {
         /* Wait till fifo has emptied */
-        if (!capture->b_alive && (fifo_count(capture->fifo) == 0))
+        if (!capture->b_alive && (ring_count(capture->fifo) == 0))
             break;
 
         /* Wait for data to arrive */
-        buffer = fifo_pop(capture->fifo);
+        buffer = ring_pop_wait(capture->fifo);
         if (buffer == NULL)
             continue;
 
-        if (param->output)
+        /* shed the lower priority tables while the processing lags behind
+           the capture, a file being only read as fast as it is processed */
+        if (!param->b_file)
+            libdvbpsi_shed(stream, ring_count(capture->fifo) * 100
+                                   / ring_capacity(capture->fifo));
+
+        /* written while parsed, the writer only reading it */
+        bool b_written = false;
+        if (b_writer)
         {
-            ssize_t size = param->pf_write(param->fd_out, buffer->p_data, buffer->i_size);
-            if (size < 0) /* error writing */
-            {
-                libdvbpsi_log(param, DVBINFO_LOG_ERROR,
-                              "error (%d) writting to %s\n", errno, param->output);
+            writer_collect(&writer, capture);
+            if (__atomic_load_n(&writer.b_error, __ATOMIC_RELAXED))
                 break;
-            }
-            else if ((size_t)size < buffer->i_size) /* short writting disk full? */
-            {
+            b_written = ring_push(writer.queue, buffer);
+            if (!b_written)
                 libdvbpsi_log(param, DVBINFO_LOG_ERROR,
-                              "error writting to %s (disk full?)\n", param->output);
-                break;
+                              "error output too slow, discarding output buffer\n");
+        }
+
+        if (buffer->i_datagrams == 0)
+        {
+            if (!libdvbpsi_process(stream, buffer->p_data, buffer->i_size, buffer->i_date))
+                b_error = true;
+        }
+        else
+        {
+            /* each datagram with its own receive timestamp */
+            uint8_t *p_data = buffer->p_data;
+            for (unsigned i = 0; i < buffer->i_datagrams && !b_error; i++)
+            {
+                if (!libdvbpsi_process_datagram(stream, p_data, buffer->p_sizes[i],
+                                                buffer->p_dates[i]))
+                    b_error = true;
+                p_data += buffer->p_sizes[i];
             }
         }
 
-        if (!libdvbpsi_process(stream, buffer->p_data, buffer->i_size, buffer->i_date))
-            b_error = true;
+#ifdef HAVE_SHM_OPEN
+        /* live statistics, every STATS_PERIOD ms of arrival time */
+        if (stats && (buffer->i_date / 1000 >= stats_deadline))
+        {
+            libdvbpsi_stats(stream, stats);
+            stats_deadline = buffer->i_date / 1000 + STATS_PERIOD;
+        }
+#endif
 
         /* summary statistics */
         if (param->b_summary)
@@ -434,21 +717,17 @@ static int dvbinfo_process(dvbinfo_capture_t *capture)
             }
         }
 
-        /* reuse buffer */
-        fifo_push(capture->empty, buffer);
+        /* reuse buffer, once written */
+        if (!b_written)
+            capture_recycle(capture, buffer);
         buffer = NULL;
-
-        /* check fifo size */
-        if (fifo_size(capture->fifo) < param->threshold)
-        {
-            pthread_mutex_lock(&capture->lock);
-            capture->b_fifo_full = false;
-            pthread_cond_signal(&capture->fifo_full);
-            pthread_mutex_unlock(&capture->lock);
-        }
     }
 
-    assert(fifo_count(capture->fifo) == 0);
+    assert(ring_count(capture->fifo) == 0);
+#ifdef HAVE_SHM_OPEN
+    if (stats)
+        libdvbpsi_stats(stream, stats);
+#endif
     libdvbpsi_exit(stream);
     err = 0;
 
@@ -457,6 +736,18 @@ out:
         libdvbpsi_log(param, DVBINFO_LOG_ERROR, "error while processing\n" );
 
     if (buffer) buffer_free(buffer);
+    if (b_writer)
+        writer_stop(&writer, capture);
+#ifdef HAVE_SHM_OPEN
+    if (http)
+        stats_http_stop(http);
+    if (stats)
+        stats_close(stats, param->stats);
+    if (tables)
+        tables_close(tables, libdvbpsi_publish_size(), param->tables);
+#endif
+    if (json && json != stdout)
+        fclose(json);
     free(psz_temp);
     return err;
 }
@@ -483,23 +774,36 @@ int main(int argc, char **pp_argv)
         exit(EXIT_FAILURE);
     }
     capture.params = param;
-    capture.fifo = fifo_new();
-    capture.empty = fifo_new();
-    capture.b_fifo_full = false;
-    pthread_mutex_init(&capture.lock, NULL);
-    pthread_cond_init(&capture.fifo_full, NULL);
+    capture.input = NULL;
 
     static const struct option long_options[] =
     {
         { "debug",     required_argument, NULL, 'd' },
+        { "trace",     required_argument, NULL, 'T' },
+        { "trace-events", no_argument,    NULL, 'E' },
+        { "profile",   no_argument,       NULL, 'P' },
+        { "json",      required_argument, NULL, 'J' },
         { "help",      no_argument,       NULL, 'h' },
         /* - inputs - */
         { "file",      required_argument, NULL, 'f' },
+#ifdef HAVE_IO_URING
+        { "uring",     no_argument,       NULL, 'e' },
+#endif
 #ifdef HAVE_SYS_SOCKET_H
         { "ipaddress", required_argument, NULL, 'i' },
         { "miface",    required_argument, NULL, 'a' },
         { "tcp",       no_argument,       NULL, 't' },
         { "udp",       no_argument,       NULL, 'u' },
+#ifdef HAVE_LINUX_IF_PACKET_H
+        { "ring",      no_argument,       NULL, 'r' },
+#endif
+#ifdef HAVE_LINUX_DVB_DMX_H
+        { "dvb",       required_argument, NULL, 'D' },
+        { "dvb-sections", no_argument,    NULL, 'F' },
+#endif
+        { "sources",   required_argument, NULL, 'l' },
+        { "workers",   required_argument, NULL, 'w' },
+        { "steer",     no_argument,       NULL, 'C' },
         /* - outputs - */
         { "output",    required_argument, NULL, 'o' },
         /* - daemon - */
@@ -508,15 +812,25 @@ int main(int argc, char **pp_argv)
         { "summary",        required_argument, NULL, 's' },
         { "summary-file",   required_argument, NULL, 'j' },
         { "summary-period", required_argument, NULL, 'p' },
+#ifdef HAVE_SHM_OPEN
+        { "stats",          required_argument, NULL, 'S' },
+        { "stats-http",     required_argument, NULL, 'H' },
+        { "tables-shm",     required_argument, NULL, 'M' },
+#endif
         /* - tuning options - */
         { "capturesize",    required_argument, NULL, 'c' },
+        { "buffers",        required_argument, NULL, 'b' },
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+        { "capture-cpu",    required_argument, NULL, 'x' },
+        { "process-cpu",    required_argument, NULL, 'y' },
+#endif
 #endif
         { NULL, 0, NULL, 0 }
     };
 #ifdef HAVE_SYS_SOCKET_H
-    while ((c = getopt_long(argc, pp_argv, "a:c:d:f:i:j:ho:p:ms:tu", long_options, NULL)) != -1)
+    while ((c = getopt_long(argc, pp_argv, "a:b:c:d:ef:i:j:hl:o:p:mrs:tuw:x:y:CD:FS:H:M:T:EPJ:", long_options, NULL)) != -1)
 #else
-    while ((c = getopt_long(argc, pp_argv, "d:f:h", long_options, NULL)) != -1)
+    while ((c = getopt_long(argc, pp_argv, "d:ef:hT:EPJ:", long_options, NULL)) != -1)
 #endif
     {
         switch(c)
@@ -534,6 +848,37 @@ int main(int argc, char **pp_argv)
                 }
                 break;
 
+            case 'T':
+                if (optarg)
+                {
+                    char *end;
+                    param->trace = strtol(optarg, &end, 10);
+                    if ((*end != '\0') || (param->trace < 0))
+                    {
+                        fprintf(stderr, "Option --trace has invalid content %s\n", optarg);
+                        params_free(param);
+                        usage();
+                    }
+                }
+                break;
+
+            case 'E':
+                param->b_trace_events = true;
+                break;
+
+            case 'P':
+                param->b_profile = true;
+                break;
+
+            case 'J':
+                free(param->json);
+                if (asprintf(&param->json, "%s", optarg) < 0)
+                {
+                    params_free(param);
+                    usage();
+                }
+                break;
+
             case 'f':
                 if (optarg)
                 {
@@ -544,7 +889,6 @@ int main(int argc, char **pp_argv)
                         usage();
                     }
                     /* */
-                    param->pf_read = read;
                     param->b_file = true;
                 }
                 break;
@@ -579,6 +923,41 @@ int main(int argc, char **pp_argv)
                 }
                 break;
 
+            case 'l':
+                if (optarg)
+                {
+                    param->sources = strdup(optarg);
+                    if (param->sources == NULL)
+                    {
+                        params_free(param);
+                        usage();
+                    }
+                }
+                break;
+
+            case 'w':
+                if (optarg)
+                {
+                    param->workers = strtol(optarg, NULL, 10);
+                    if (param->workers < 0)
+                    {
+                        fprintf(stderr, "Option --workers has invalid content %s\n", optarg);
+                        params_free(param);
+                        usage();
+                    }
+                }
+                break;
+
+            case 'C':
+                param->b_steer = true;
+                break;
+
+#ifdef HAVE_IO_URING
+            case 'e':
+                param->b_uring = true;
+                break;
+#endif
+
             case 'm':
                 param->b_monitor = true;
                 break;
@@ -599,14 +978,51 @@ int main(int argc, char **pp_argv)
 
             case 't':
                 param->b_tcp = true;
-                param->pf_read = tcp_read;
                 break;
 
             case 'u':
                 param->b_udp = true;
-                param->pf_read = udp_read;
                 break;
 
+#ifdef HAVE_LINUX_IF_PACKET_H
+            case 'r':
+                param->b_udp = true;
+                param->b_ring = true;
+                break;
+#endif
+
+#ifdef HAVE_LINUX_DVB_DMX_H
+            case 'D':
+                if (optarg)
+                {
+                    char *end;
+                    long adapter = strtol(optarg, &end, 10);
+                    long demux = 0;
+                    if (*end == ':')
+                        demux = strtol(end + 1, &end, 10);
+                    if ((end == optarg) || (*end != '\0') || (adapter < 0) || (demux < 0))
+                    {
+                        fprintf(stderr, "Option --dvb has invalid content %s\n", optarg);
+                        params_free(param);
+                        usage();
+                    }
+                    free(param->input);
+                    if (asprintf(&param->input, "/dev/dvb/adapter%ld/demux%ld",
+                                 adapter, demux) < 0)
+                    {
+                        fprintf(stderr, "error: out of memory\n");
+                        params_free(param);
+                        usage();
+                    }
+                    param->b_dvb = true;
+                }
+                break;
+
+            case 'F':
+                param->b_dvb_sections = true;
+                break;
+#endif
+
             /* - tuning options - */
             case 'c':
                 if (optarg)
@@ -622,6 +1038,41 @@ int main(int argc, char **pp_argv)
                 }
                 break;
 
+            case 'b':
+                if (optarg)
+                {
+                    long mb = strtol(optarg, NULL, 10);
+                    if ((mb < 0) || ((size_t)mb > SIZE_MAX / (1024 * 1024)))
+                    {
+                        fprintf(stderr, "Option --buffers has invalid content %s\n", optarg);
+                        params_free(param);
+                        usage();
+                    }
+                    param->arena = (size_t)mb * 1024 * 1024;
+                }
+                break;
+
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+            case 'x':
+            case 'y':
+                if (optarg)
+                {
+                    int cpu = strtol(optarg, NULL, 10);
+                    if ((cpu < 0) || (cpu >= CPU_SETSIZE))
+                    {
+                        fprintf(stderr, "Option --%s has invalid content %s\n",
+                                (c == 'x') ? "capture-cpu" : "process-cpu", optarg);
+                        params_free(param);
+                        usage();
+                    }
+                    if (c == 'x')
+                        param->capture_cpu = cpu;
+                    else
+                        param->process_cpu = cpu;
+                }
+                break;
+#endif
+
             /* - Statistics */
             case 's':
             {
@@ -673,6 +1124,48 @@ int main(int argc, char **pp_argv)
                     }
                 }
                 break;
+#ifdef HAVE_SHM_OPEN
+            case 'S':
+                if (optarg)
+                {
+                    free(param->stats);
+                    param->stats = strdup(optarg);
+                    if ((param->stats == NULL) || (param->stats[0] != '/'))
+                    {
+                        fprintf(stderr, "Option --stats expects a name starting with /, not %s\n", optarg);
+                        params_free(param);
+                        usage();
+                    }
+                }
+                break;
+
+            case 'M':
+                if (optarg)
+                {
+                    free(param->tables);
+                    param->tables = strdup(optarg);
+                    if ((param->tables == NULL) || (param->tables[0] != '/'))
+                    {
+                        fprintf(stderr, "Option --tables-shm expects a name starting with /, not %s\n", optarg);
+                        params_free(param);
+                        usage();
+                    }
+                }
+                break;
+
+            case 'H':
+                if (optarg)
+                {
+                    param->stats_port = strtol(optarg, NULL, 10);
+                    if ((param->stats_port <= 0) || (param->stats_port > 65535))
+                    {
+                        fprintf(stderr, "Option --stats-http has invalid content %s\n", optarg);
+                        params_free(param);
+                        usage();
+                    }
+                }
+                break;
+#endif
 #endif
             case ':':
                 fprintf(stderr, "Option %c is missing arguments\n", c);
@@ -708,6 +1201,16 @@ int main(int argc, char **pp_argv)
         libdvbpsi_log(param, DVBINFO_LOG_INFO, "dvbinfo: Copyright (C) 2011-2012 M2X BV\n");
         libdvbpsi_log(param, DVBINFO_LOG_ERROR, "License: LGPL v2.1\n");
     }
+
+    /* Multi-input mode */
+    if (param->sources)
+    {
+        int err = dvbinfo_multi(param);
+        if (param->b_monitor)
+            closelog();
+        params_free(param);
+        exit((err < 0) ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
 #endif
 
     if (param->input == NULL)
@@ -723,26 +1226,106 @@ int main(int argc, char **pp_argv)
 
 #ifdef HAVE_SYS_SOCKET_H
     if (param->b_udp || param->b_tcp)
-    {
-        capture.size = 7*188;
         libdvbpsi_log(param, DVBINFO_LOG_INFO, "Listen: host=%s port=%d\n",
                       param->input, param->port);
-    }
     else
 #endif
-    {
-        capture.size = 188;
         libdvbpsi_log(param, DVBINFO_LOG_INFO, "Examining: %s\n",
                       param->input);
+
+#ifdef HAVE_LINUX_DVB_DMX_H
+    /* DVB adapter mode, the demux filtering the PSI/SI */
+    if (param->b_dvb)
+    {
+        dvbinfo_open(param);
+        int err = dvbinfo_dvb(param);
+        dvbinfo_close(param);
+        if (param->b_monitor)
+            closelog();
+        params_free(param);
+        exit((err < 0) ? EXIT_FAILURE : EXIT_SUCCESS);
     }
+#endif
+
+#ifdef HAVE_LINUX_IF_PACKET_H
+    /* Ring capture mode, processing in place without a capture thread */
+    if (param->b_ring)
+    {
+        dvbinfo_open(param);
+        int err = dvbinfo_pktring(param);
+        dvbinfo_close(param);
+        if (param->b_monitor)
+            closelog();
+        params_free(param);
+        exit((err < 0) ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+#endif
 
-    /* Capture thread */
     dvbinfo_open(param);
+    capture.input = dvbinfo_input(param);
+    if (capture.input == NULL)
+    {
+        libdvbpsi_log(param, DVBINFO_LOG_ERROR, "Could not open %s (%s)\n",
+                      param->input, strerror(errno));
+        dvbinfo_close(param);
+#ifdef HAVE_SYS_SOCKET_H
+        if (param->b_monitor)
+            closelog();
+#endif
+        params_free(param);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Capture rings, holding up to threshold bytes */
+    capture.fifo = ring_new(param->threshold / capture.input->size);
+    capture.empty = ring_new(param->threshold / capture.input->size);
+    if (capture.fifo == NULL || capture.empty == NULL)
+    {
+        libdvbpsi_log(param, DVBINFO_LOG_ERROR, "out of memory\n");
+        ring_free(capture.fifo);
+        ring_free(capture.empty);
+        input_close(capture.input);
+        dvbinfo_close(param);
+#ifdef HAVE_SYS_SOCKET_H
+        if (param->b_monitor)
+            closelog();
+#endif
+        params_free(param);
+        exit(EXIT_FAILURE);
+    }
+
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+    if (param->process_cpu >= 0)
+        thread_pin(param, pthread_self(), param->process_cpu, "processing");
+#endif
+
+    /* Capture buffers preallocated, first touched by the processing thread */
+    arena_t *arena = NULL;
+    if ((param->arena > 0) && !capture.input->b_lend)
+    {
+        size_t bytes = (param->arena < param->threshold) ? param->arena : param->threshold;
+        arena = arena_new(bytes, capture.input->size, capture.input->batch);
+        if (arena == NULL)
+            libdvbpsi_log(param, DVBINFO_LOG_WARN, "could not preallocate capture buffers\n");
+        else
+        {
+            size_t count = 0;
+            while ((count < arena_count(arena)) &&
+                   ring_push(capture.empty, arena_buffer(arena, count)))
+                count++;
+            libdvbpsi_log(param, DVBINFO_LOG_INFO, "Preallocated %zu capture buffers%s\n",
+                          count, arena_hugepages(arena) ? " on hugepages" : "");
+        }
+    }
+
+    /* Capture thread */
     pthread_t handle;
+    capture.recycler = pthread_self();
     capture.b_alive = true;
     if (pthread_create(&handle, NULL, dvbinfo_capture, (void *)&capture) < 0)
     {
         libdvbpsi_log(param, DVBINFO_LOG_ERROR, "failed creating thread\n");
+        input_close(capture.input);
         dvbinfo_close(param);
 #ifdef HAVE_SYS_SOCKET_H
         if (param->b_monitor)
@@ -751,21 +1334,23 @@ int main(int argc, char **pp_argv)
         params_free(param);
         exit(EXIT_FAILURE);
     }
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+    if (param->capture_cpu >= 0)
+        thread_pin(param, handle, param->capture_cpu, "capture");
+#endif
     int err = dvbinfo_process(&capture);
     capture.b_alive = false;     /* stop thread */
+    ring_close(capture.fifo);
     if (pthread_join(handle, NULL) < 0)
         libdvbpsi_log(param, DVBINFO_LOG_ERROR, "error joining capture thread\n");
+    input_close(capture.input);
     dvbinfo_close(param);
 
     /* cleanup */
-    fifo_wake((&capture)->fifo);
-    fifo_wake((&capture)->empty);
-
-    fifo_free((&capture)->fifo);
-    fifo_free((&capture)->empty);
-
-    pthread_mutex_destroy(&capture.lock);
-    pthread_cond_destroy(&capture.fifo_full);
+    ring_free(capture.fifo);
+    ring_free(capture.empty);
+    if (arena)
+        arena_free(arena);
 
 #ifdef HAVE_SYS_SOCKET_H
     if (param->b_monitor)
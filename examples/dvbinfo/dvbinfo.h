@@ -44,15 +44,31 @@ typedef struct params_s
     bool b_udp;
     bool b_tcp;
     bool b_file;
+    bool b_ring;    /* udp from a packet socket ring */
+    bool b_uring;   /* file read with io_uring */
+    bool b_dvb;     /* demux device of a DVB adapter */
+    bool b_dvb_sections; /* its section filters rather than a PID filter */
+
+    /* multi-input mode */
+    char *sources;  /* file listing the sources */
+    int   workers;  /* number of worker threads, 0 for one per cpu */
+    bool  b_steer;  /* sources moved to the worker of their receiving cpu */
 
     /* tuning options */
     size_t threshold; /* capture fifo threshold */
+    size_t arena;     /* bytes of capture buffers preallocated, 0 for none */
+    int    capture_cpu; /* cpu of the capture thread, -1 for any */
+    int    process_cpu; /* cpu of the processing thread, -1 for any */
 
     /* */
     int  fd_in;
     int  fd_out;
 
     int  debug;
+    int  trace;         /* trace one packet in n, -1 for the default */
+    bool b_trace_events; /* trace the packets with an event */
+    bool b_profile;     /* decoding cost per table, see libdvbpsi_profile() */
+    char *json;         /* file of the tables as JSON, see libdvbpsi_json() */
     bool b_verbose;
     bool b_monitor; /* run in daemon mode */
 
@@ -64,10 +80,15 @@ typedef struct params_s
         char *file;     /* summary file name    */
         FILE *fd;       /* summary file descriptor */
     } summary;
+    char *stats;        /* shared memory object of the live statistics */
+    int   stats_port;   /* port of their text exporter, 0 for none */
+    char *tables;       /* shared memory object of the decoded tables */
 
-    /* read data from file of socket */
-    ssize_t (*pf_read)(int fd, void *buf, size_t count);
+    /* write data to the output file */
     ssize_t (*pf_write)(int fd, const void *buf, size_t count);
 } params_t;
 
+/* log to stderr or syslog in monitor mode, data being params_t */
+void libdvbpsi_log(void *data, const int level, const char *format, ...);
+
 #endif
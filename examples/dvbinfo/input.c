@@ -0,0 +1,465 @@
+/*****************************************************************************
+ * input.c: capture input sources
+ *****************************************************************************
+ * Copyright (C) 2011 M2X BV
+ *
+ * Authors: Jean-Paul Saman <jpsaman@videolan.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#   include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#   include <stdint.h>
+#endif
+
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#ifdef WIN32
+#   define O_NONBLOCK (0) /* O_NONBLOCK does not exist for Windows */
+#endif
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef HAVE_SYS_MMAN_H
+#   include <sys/mman.h>
+#endif
+#include <assert.h>
+
+#include "libdvbpsi.h"
+#include "buffer.h"
+#include "input.h"
+#ifdef HAVE_SYS_SOCKET_H
+#   include "udp.h"
+#   include "tcp.h"
+#endif
+#ifdef HAVE_IO_URING
+#   include "uring.h"
+#endif
+
+#define FILE_CHUNK_SIZE (1024 * 188) /* bytes per buffer of a mapped file */
+#define STREAM_READ_SIZE (64 * 188) /* bytes per read of tcp and unmapped files */
+#define URING_BLOCK (8 * FILE_CHUNK_SIZE) /* bytes per io_uring read, 4096 aligned */
+#define URING_DEPTH 8 /* io_uring reads in flight */
+
+/* */
+input_t *input_new(const input_ops_t *ops, void *p_sys)
+{
+    input_t *input = (input_t *) calloc(1, sizeof(input_t));
+    if (input == NULL)
+        return NULL;
+    input->ops = ops;
+    input->p_sys = p_sys;
+    input->fd = -1;
+    return input;
+}
+
+buffer_t *input_buffer(const input_t *input)
+{
+    if (input->b_lend)
+        return buffer_new(0);
+    if (input->align)
+        return buffer_new_aligned(input->size, input->align);
+    if (input->batch)
+        return buffer_new_batch(input->size, input->batch);
+    return buffer_new(input->size);
+}
+
+ssize_t input_read(input_t *input, buffer_t **pp_buffer)
+{
+    assert(*pp_buffer != NULL);
+    (*pp_buffer)->i_datagrams = 0;
+
+    ssize_t size = input->ops->pf_read(input, pp_buffer);
+    if (size <= 0)
+        return size;
+
+    buffer_t *buffer = *pp_buffer;
+    buffer->i_date = udate();
+    for (unsigned i = 0; i < buffer->i_datagrams; i++)
+    {
+        /* no kernel timestamp */
+        if (buffer->p_dates[i] < 0)
+            buffer->p_dates[i] = buffer->i_date;
+    }
+    if (buffer->i_datagrams > 0)
+        buffer->i_date = buffer->p_dates[0];
+    return size;
+}
+
+void input_close(input_t *input)
+{
+    if (input == NULL)
+        return;
+    input->ops->pf_close(input);
+    free(input);
+}
+
+/* File, read in the buffers */
+static ssize_t file_read(input_t *input, buffer_t **pp_buffer)
+{
+    buffer_t *buffer = *pp_buffer;
+    ssize_t size = read(input->fd, buffer->p_data, input->size);
+    if (size > 0)
+        buffer->i_size = size;
+    return size;
+}
+
+static void file_close(input_t *input)
+{
+    close(input->fd);
+}
+
+static const input_ops_t file_ops = { file_read, file_close };
+
+#ifdef HAVE_SYS_MMAN_H
+/* Mapped file, the buffers pointing into it without copy */
+typedef struct input_map_s
+{
+    uint8_t *p_map;
+    size_t   i_map;
+    size_t   i_pos; /* next byte to capture */
+} input_map_t;
+
+static ssize_t map_read(input_t *input, buffer_t **pp_buffer)
+{
+    input_map_t *map = (input_map_t *)input->p_sys;
+    buffer_t *buffer = *pp_buffer;
+
+    size_t size = map->i_map - map->i_pos;
+    if (size > input->size)
+        size = input->size;
+    buffer->p_data = map->p_map + map->i_pos;
+    buffer->i_size = size;
+    map->i_pos += size;
+    return size;
+}
+
+static void map_close(input_t *input)
+{
+    input_map_t *map = (input_map_t *)input->p_sys;
+    munmap(map->p_map, map->i_map);
+    free(map);
+}
+
+static const input_ops_t map_ops = { map_read, map_close };
+
+/* Maps a regular file, false when it cannot be */
+static bool map_open(input_t *input)
+{
+    struct stat st;
+
+    if ((fstat(input->fd, &st) < 0) || !S_ISREG(st.st_mode) ||
+        (st.st_size <= 0) || ((uint64_t)st.st_size > SIZE_MAX))
+        return false;
+
+    input_map_t *map = (input_map_t *) malloc(sizeof(input_map_t));
+    if (map == NULL)
+        return false;
+
+    /* private, the packets being writable as if read */
+    void *p_map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                       input->fd, 0);
+    if (p_map == MAP_FAILED)
+    {
+        free(map);
+        return false;
+    }
+#ifdef HAVE_MADVISE
+    madvise(p_map, st.st_size, MADV_SEQUENTIAL);
+#endif
+    close(input->fd);
+    map->p_map = (uint8_t *)p_map;
+    map->i_map = st.st_size;
+    map->i_pos = 0;
+
+    input->ops = &map_ops;
+    input->p_sys = map;
+    input->fd = -1;
+    input->b_lend = true;
+    return true;
+}
+#endif
+
+#ifdef HAVE_IO_URING
+/* File read ahead with io_uring, URING_DEPTH reads in flight, each buffer
+ * given being queued and the oldest completed one returned in file order */
+typedef struct input_uring_s
+{
+    uring_t  *uring;
+    unsigned  i_queued; /* reads in flight */
+} input_uring_t;
+
+static ssize_t uring_read(input_t *input, buffer_t **pp_buffer)
+{
+    input_uring_t *sys = (input_uring_t *)input->p_sys;
+    buffer_t *buffer = *pp_buffer;
+
+    *pp_buffer = NULL;
+    if (uring_queue(sys->uring, buffer->p_data, buffer))
+    {
+        /* more buffers till URING_DEPTH reads are in flight */
+        if (++sys->i_queued < URING_DEPTH)
+        {
+            errno = EAGAIN;
+            return -1;
+        }
+    }
+    else /* the whole file is queued */
+        buffer_free(buffer);
+
+    ssize_t size;
+    buffer = (buffer_t *)uring_next(sys->uring, &size);
+    if (buffer == NULL) /* end of file */
+        return 0;
+    sys->i_queued--;
+    if (size > 0)
+        buffer->i_size = size;
+    *pp_buffer = buffer;
+    return size;
+}
+
+static void uring_input_close(input_t *input)
+{
+    input_uring_t *sys = (input_uring_t *)input->p_sys;
+
+    /* the remaining reads are dropped */
+    ssize_t size;
+    buffer_t *buffer;
+    while ((buffer = (buffer_t *)uring_next(sys->uring, &size)) != NULL)
+        buffer_free(buffer);
+    uring_close(sys->uring);
+    free(sys);
+}
+
+static const input_ops_t uring_ops = { uring_read, uring_input_close };
+
+static input_t *uring_input_open(const char *psz_file)
+{
+    input_uring_t *sys = (input_uring_t *) calloc(1, sizeof(input_uring_t));
+    if (sys == NULL)
+        return NULL;
+    sys->uring = uring_open(psz_file, URING_DEPTH, URING_BLOCK);
+    if (sys->uring == NULL)
+    {
+        free(sys);
+        return NULL;
+    }
+
+    input_t *input = input_new(&uring_ops, sys);
+    if (input == NULL)
+    {
+        uring_close(sys->uring);
+        free(sys);
+        return NULL;
+    }
+    input->size = URING_BLOCK;
+    input->align = 4096;
+    input->b_file = true;
+    return input;
+}
+#endif
+
+input_t *input_file(const char *psz_file, size_t i_size, int i_flags)
+{
+#ifdef HAVE_IO_URING
+    if (i_flags & INPUT_URING)
+        return uring_input_open(psz_file);
+#else
+    if (i_flags & INPUT_URING)
+    {
+        errno = ENOSYS;
+        return NULL;
+    }
+#endif
+
+    int fd = open(psz_file, O_RDONLY | O_NONBLOCK);
+    if (fd < 0)
+        return NULL;
+    input_t *input = input_new(&file_ops, NULL);
+    if (input == NULL)
+    {
+        close(fd);
+        return NULL;
+    }
+    input->fd = fd;
+    input->size = i_size ? i_size : STREAM_READ_SIZE;
+    input->b_file = true;
+
+#ifdef HAVE_SYS_MMAN_H
+    if ((i_flags & INPUT_MAP) && map_open(input) && (i_size == 0))
+        input->size = FILE_CHUNK_SIZE;
+#endif
+    return input;
+}
+
+#ifdef HAVE_SYS_SOCKET_H
+/* UDP, datagram boundaries being kept for RTP */
+static ssize_t udp_input_read(input_t *input, buffer_t **pp_buffer)
+{
+    buffer_t *buffer = *pp_buffer;
+
+#ifdef HAVE_RECVMMSG
+    /* one syscall for a batch of datagrams */
+    if (input->batch > 1)
+    {
+        buffer->i_size = input->size;
+        return udp_read_batch(input->fd, buffer->p_data, buffer->i_size,
+                              input->batch, buffer->p_sizes, buffer->p_dates,
+                              &buffer->i_datagrams);
+    }
+#endif
+    ssize_t size = udp_read(input->fd, buffer->p_data, input->size);
+    if (size > 0)
+    {
+        buffer->i_size = size;
+        buffer->i_datagrams = 1;
+        buffer->p_sizes[0] = size;
+        buffer->p_dates[0] = -1;
+    }
+    return size;
+}
+
+static void udp_input_close(input_t *input)
+{
+    udp_close(input->fd);
+}
+
+static const input_ops_t udp_ops = { udp_input_read, udp_input_close };
+
+input_t *input_udp(const char *psz_iface, const char *psz_host, int port,
+                   size_t i_size, unsigned i_batch)
+{
+    int fd = udp_open(psz_iface, psz_host, port);
+    if (fd < 0)
+        return NULL;
+    input_t *input = input_new(&udp_ops, NULL);
+    if (input == NULL)
+    {
+        udp_close(fd);
+        return NULL;
+    }
+#ifdef HAVE_RECVMMSG
+    if (i_batch == 0)
+        i_batch = UDP_BATCH;
+    else if (i_batch > UDP_BATCH)
+        i_batch = UDP_BATCH;
+#else
+    if (i_batch == 0)
+        i_batch = 1;
+#endif
+    input->fd = fd;
+    input->batch = i_batch;
+    input->size = i_size ? i_size : i_batch * UDP_DATAGRAM_MAX;
+    return input;
+}
+
+/* TCP, any size, partial packets being carried over */
+static ssize_t tcp_input_read(input_t *input, buffer_t **pp_buffer)
+{
+    buffer_t *buffer = *pp_buffer;
+    ssize_t size = tcp_read(input->fd, buffer->p_data, input->size);
+    if (size > 0)
+        buffer->i_size = size;
+    return size;
+}
+
+static void tcp_input_close(input_t *input)
+{
+    tcp_close(input->fd);
+}
+
+static const input_ops_t tcp_ops = { tcp_input_read, tcp_input_close };
+
+input_t *input_tcp(const char *psz_host, int port, size_t i_size)
+{
+    int fd = tcp_open(psz_host, port);
+    if (fd < 0)
+        return NULL;
+    input_t *input = input_new(&tcp_ops, NULL);
+    if (input == NULL)
+    {
+        tcp_close(fd);
+        return NULL;
+    }
+    input->fd = fd;
+    input->size = i_size ? i_size : STREAM_READ_SIZE;
+    return input;
+}
+
+/* [<iface>@]<host>:<port> */
+static input_t *input_open_url(const char *psz_url, bool b_udp,
+                               size_t i_size, unsigned i_batch)
+{
+    char *psz_host = strdup(psz_url);
+    if (psz_host == NULL)
+        return NULL;
+
+    char *psz_iface = NULL;
+    char *psz_at = strchr(psz_host, '@');
+    char *psz_addr = psz_host;
+    if (psz_at)
+    {
+        *psz_at = '\0';
+        psz_iface = psz_host;
+        psz_addr = psz_at + 1;
+    }
+
+    input_t *input = NULL;
+    char *psz_port = strrchr(psz_addr, ':');
+    if (psz_port)
+    {
+        *psz_port++ = '\0';
+        int port = strtol(psz_port, NULL, 0);
+        if (b_udp)
+            input = input_udp(psz_iface, psz_addr, port, i_size, i_batch);
+        else
+            input = input_tcp(psz_addr, port, i_size);
+    }
+    free(psz_host);
+    return input;
+}
+#endif
+
+input_t *input_open(const char *psz_input, size_t i_size, unsigned i_batch)
+{
+#ifdef HAVE_SYS_SOCKET_H
+    if (strncmp(psz_input, "udp://", 6) == 0)
+        return input_open_url(psz_input + 6, true, i_size, i_batch);
+#endif
+
+    input_t *input = NULL;
+#ifdef HAVE_SYS_SOCKET_H
+    if (strncmp(psz_input, "tcp://", 6) == 0)
+        input = input_open_url(psz_input + 6, false, i_size, i_batch);
+    else
+#endif
+        input = input_file(psz_input, i_size, 0);
+
+    /* datagrams it never reads, for the buffers to be shared */
+    if (input)
+        input->batch = i_batch;
+    return input;
+}
@@ -0,0 +1,91 @@
+/*****************************************************************************
+ * input.h: capture input sources
+ *****************************************************************************
+ * Copyright (C) 2011 M2X BV
+ *
+ * Authors: Jean-Paul Saman <jpsaman@videolan.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *****************************************************************************/
+
+#ifndef DVBINFO_INPUT_H_
+#define DVBINFO_INPUT_H_
+
+typedef struct input_s input_t;
+
+/* Input backend, see input_new():
+ * pf_read()  - fill *pp_buffer as input_read() does, without the dates
+ * pf_close() - release p_sys and the descriptors of the input
+ */
+typedef struct input_ops_s
+{
+    ssize_t (*pf_read)(input_t *input, buffer_t **pp_buffer);
+    void    (*pf_close)(input_t *input);
+} input_ops_t;
+
+struct input_s
+{
+    const input_ops_t *ops;
+    void     *p_sys;  /* backend data */
+
+    int       fd;     /* descriptor to poll for POLLIN, -1 when always ready */
+    size_t    size;   /* bytes of data of its buffers */
+    unsigned  batch;  /* datagrams per buffer, 0 for a byte stream */
+    size_t    align;  /* alignment of the buffer data, 0 for any */
+    bool      b_lend; /* the buffers point into the input, having no data */
+    bool      b_file; /* not read faster than processed */
+};
+
+/* Input flags of input_file() */
+#define INPUT_MAP   0x1 /* lend the pages of the mapped file when regular */
+#define INPUT_URING 0x2 /* read ahead with io_uring, failing without it */
+
+/* Input sources, the capture loops knowing nothing of their backend:
+ * input_new()    - create the input of a backend, which then sets the
+ *                  other fields
+ * input_file()   - open a file, read in buffers of i_size bytes or the
+ *                  default of the backend when 0, mapped or with io_uring
+ *                  as i_flags tells
+ * input_udp()    - open a udp socket on the group or host and port, one
+ *                  recvmmsg() receiving up to i_batch datagrams, UDP_BATCH
+ *                  when 0, when the system has it, in buffers of i_size
+ *                  bytes or UDP_DATAGRAM_MAX per datagram when 0
+ * input_tcp()    - connect to the host and port, reading up to i_size bytes
+ * input_open()   - open udp://[<iface>@]<host>:<port>, tcp://<host>:<port>
+ *                  or a file, with buffers of i_size bytes and room for
+ *                  i_batch datagrams whatever the input, so that inputs
+ *                  may share their buffers
+ * input_buffer() - a new buffer for the input
+ * input_read()   - fill *pp_buffer, a buffer of the input, returning the
+ *                  bytes read, 0 at the end of the input, or -1 with errno
+ *                  EAGAIN when nothing is ready or another error. The input
+ *                  may keep the buffer, *pp_buffer being then the one read
+ *                  into or NULL. Each datagram has its kernel receive date,
+ *                  udate() otherwise, and buffer->i_date that of the first.
+ * input_close()  - close an input, the buffers it lent being invalid
+ */
+input_t *input_new(const input_ops_t *ops, void *p_sys);
+input_t *input_file(const char *psz_file, size_t i_size, int i_flags);
+#ifdef HAVE_SYS_SOCKET_H
+input_t *input_udp(const char *psz_iface, const char *psz_host, int port,
+                   size_t i_size, unsigned i_batch);
+input_t *input_tcp(const char *psz_host, int port, size_t i_size);
+#endif
+input_t *input_open(const char *psz_input, size_t i_size, unsigned i_batch);
+buffer_t *input_buffer(const input_t *input);
+ssize_t input_read(input_t *input, buffer_t **pp_buffer);
+void input_close(input_t *input);
+
+#endif
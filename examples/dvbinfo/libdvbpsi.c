@@ -41,6 +41,9 @@
 #if defined(HAVE_SYS_TIME_H)
 #   include <sys/time.h>
 #endif
+#if defined(HAVE_CLOCK_GETTIME)
+#   include <time.h>
+#endif
 
 #include <assert.h>
 
@@ -48,6 +51,8 @@
 #ifdef DVBPSI_DIST
 #   include "../../src/dvbpsi.h"
 #   include "../../src/demux.h"
+#   include "../../src/scan.h"
+#   include "../../src/mjd.h"
 #   include "../../src/psi.h"
 #   include "../../src/descriptor.h"
 #   include "../../src/tables/pat.h"
@@ -69,6 +74,8 @@
 #else
 #   include <dvbpsi/dvbpsi.h>
 #   include <dvbpsi/demux.h>
+#   include <dvbpsi/scan.h>
+#   include <dvbpsi/mjd.h>
 #   include <dvbpsi/psi.h>
 #   include <dvbpsi/descriptor.h>
 #   include <dvbpsi/pat.h>
@@ -90,6 +97,10 @@
 #endif
 
 #include "libdvbpsi.h"
+#include "series.h"
+#ifdef HAVE_SHM_OPEN
+#   include "stats.h"
+#endif
 
 /* DVB CUEI Descriptors */
 /* SIS support (SCTE 35 2004) */
@@ -103,25 +114,42 @@
 #   endif
 #endif
 
+#ifdef DVBPSI_DIST
+#   include "../../src/serialize.h"
+#   include "../../src/shm.h"
+#else
+#   include <dvbpsi/serialize.h>
+#   include <dvbpsi/shm.h>
+#endif
+
 /*****************************************************************************
  * Data structures
  *****************************************************************************/
-typedef struct ts_pid_s
-{
-    /* TS header fields */
-    int         i_pid;
-    int         i_cc;   /* countinuity counter */
+typedef struct ts_pcr_s ts_pcr_t;
 
+/* What every packet of a PID updates, kept apart in a dense array so that
+ * packets interleaving many PIDs stay in cache. The rest of the PID is in
+ * its ts_pid_t, allocated once the PID is seen or referred to. */
+typedef struct ts_pid_hot_s
+{
+    mtime_t     i_received;   /* last capture time for packet of this pid */
+    uint32_t    i_packets;    /* number of packets for this pid, modulo 2^32 */
     bool        b_seen;
+    uint8_t     i_flags;      /* byte 1 of the last packet: transport error
+                                 indicator, payload unit start indicator and
+                                 transport priority */
+    uint8_t     i_control;    /* byte 3 of the last packet: scrambling and
+                                 adaptation field control, continuity counter */
+    uint8_t     i_reserved;
+} ts_pid_hot_t;
 
-    /* flags */
-    bool        b_transport_error_indicator;
-    bool        b_payload_unit_start_indicator;
-    bool        b_transport_priority;
-    uint8_t     i_transport_scrambling_control;
+#define TS_HOT_FLAGS 0xe0
+
+typedef struct ts_pid_s
+{
+    int         i_pid;
 
     /* adaptation field: indicators and flags */
-    bool        b_adaptation_field;
     bool        b_discontinuity_indicator;
     bool        b_random_access_indicator;
     bool        b_elementary_stream_priority_indicator;
@@ -146,12 +174,15 @@ typedef struct ts_pid_s
     bool        b_seamless_splice;
 
     /* statistics */
-    uint64_t    i_packets;    /* number of packets for this pid */
+    uint32_t    i_packets_wraps; /* times ts_pid_hot_t i_packets wrapped */
+    uint64_t    i_cc_errors;  /* continuity counter discontinuities */
     mtime_t     i_first_pcr;  /* first pcr seen for this pid */
     mtime_t     i_prev_pcr;   /* previous pcr seen for this pid */
     mtime_t     i_last_pcr;   /* last pcr seen for this pid */
-    mtime_t     i_prev_received; /* capture time of previous packet for this pid */
-    mtime_t     i_received;   /* last capture time for packet of this pid */
+    ts_pcr_t    *pcr;         /* PCR analysis, allocated with the first PCR */
+    series_t    *second;      /* packets per second of arrival time */
+    series_t    *tenth;       /* packets per 100 ms of arrival time */
+    uint64_t    i_series;     /* packets counted in the series so far */
 } ts_pid_t;
 
 typedef struct
@@ -162,6 +193,7 @@ typedef struct
     int         i_ts_id;
 
     ts_pid_t    *pid;
+    mtime_t     i_prev_received; /* capture time of the packet before the last one */
 } ts_pat_t;
 
 typedef struct ts_pmt_s ts_pmt_t;
@@ -238,6 +270,91 @@ struct ts_atsc_eit_s
     ts_atsc_eit_t *p_next;
 };
 
+/* RTP (RFC 3550) encapsulation of the datagrams (RFC 2250) */
+typedef struct ts_rtp_s
+{
+    bool        b_seen;
+    uint16_t    i_seq;          /* last sequence number */
+    uint32_t    i_timestamp;    /* last RTP timestamp */
+    mtime_t     i_arrival;      /* arrival of the last datagram, in us */
+
+    uint64_t    i_datagrams;
+    uint64_t    i_lost;         /* datagrams missing from the sequence */
+    uint64_t    i_reordered;    /* late or duplicated datagrams */
+    double      f_jitter;       /* interarrival jitter, in 90 kHz units */
+} ts_rtp_t;
+
+/* running mean and variance (Welford), with the extremes */
+typedef struct ts_running_s
+{
+    uint64_t    i_count;
+    double      f_mean;
+    double      f_m2;           /* sum of the squared deviations */
+    double      f_min;
+    double      f_max;
+} ts_running_t;
+
+#define PCR_BINS 20
+
+/* PCR measurements of ETSI TR 101 290 section 5.3.2, in fixed memory */
+struct ts_pcr_s
+{
+    bool        b_valid;
+    int64_t     i_pcr;          /* last PCR, in 27 MHz units */
+    uint64_t    i_packet;       /* index of its packet in the stream */
+
+    /* transport rate since the last discontinuity */
+    int64_t     i_ticks;
+    uint64_t    i_packets;
+
+    /* PCR (unwrapped) and arrival time since the last discontinuity, in us */
+    double      f_pcr;
+    mtime_t     i_first_arrival;
+
+    /* regression of the PCR against the arrival time */
+    uint64_t    i_fit;
+    double      f_mean_x;
+    double      f_mean_y;
+    double      f_m2_x;
+    double      f_c_xy;
+    double      f_drift;        /* slope of the last regression, in ppm */
+
+    ts_running_t accuracy;      /* PCR_AC, in ns */
+    ts_running_t jitter;        /* PCR_OJ, in us */
+
+    /* 100 ns bins from -1 us and 1 ms bins from -10 ms, with the values
+     * below and above at both ends */
+    uint64_t    pi_accuracy[PCR_BINS + 2];
+    uint64_t    pi_jitter[PCR_BINS + 2];
+};
+
+/* Decoding cost of the sections of a table_id on a PID, see
+ * libdvbpsi_profile() */
+typedef struct ts_profile_entry_s ts_profile_entry_t;
+struct ts_profile_entry_s
+{
+    uint16_t    i_pid;
+    uint8_t     i_table_id;
+
+    uint64_t    i_push_ns;      /* in dvbpsi_packet_push(), handlers included */
+    uint64_t    i_handler_ns;   /* in the handle_* callbacks */
+    uint64_t    i_packets;
+    uint64_t    i_sections;     /* from dvbpsi_get_stats() */
+    uint64_t    i_bytes;
+    uint64_t    i_tables;
+
+    ts_profile_entry_t *p_next; /* of the same PID */
+};
+
+typedef struct ts_profile_s
+{
+    ts_profile_entry_t *entries[8192];
+    uint8_t     table_id[8192]; /* of the section being assembled, 0xff
+                                   until the first section start */
+    uint16_t    i_pid;          /* PID being pushed, for the handlers */
+    unsigned int i_entries;
+} ts_profile_t;
+
 struct ts_stream_t
 {
     /* Program Association Table */
@@ -268,24 +385,67 @@ struct ts_stream_t
     int         i_atsc_eit;
 
     /* pid */
-    ts_pid_t    pid[8192];
+    ts_pid_hot_t hot[8192];
+    ts_pid_t    *pid[8192];
+    uint16_t    seen[8192];     /* PIDs seen, in order of appearance */
+    uint16_t    sorted[8192];   /* the same, by increasing PID for the summaries */
+    int         i_seen;
 
     enum dvbpsi_msg_level level;
 
+    /* decoding cost per table, see libdvbpsi_profile(), NULL when off */
+    ts_profile_t *profile;
+
+    /* tables written as JSON, see libdvbpsi_json(), NULL when off */
+    FILE        *json;
+    dvbpsi_serializer_t serializer;
+
+    /* tables published in shared memory, see libdvbpsi_publish(), NULL when off */
+    dvbpsi_shm_t *shm;
+
+    /* PSI/SI PIDs decoded, see libdvbpsi_pids(), NULL when not asked */
+    ts_pid_cb   pf_pid;
+    void        *pid_data;
+
+    /* sections shed under overload, see libdvbpsi_shed() */
+    dvbpsi_shed_level_t shed_level;
+    uint64_t    i_shed_changes;
+
+    /* packet trace, see libdvbpsi_trace() */
+    unsigned int i_trace_every;     /* one packet in n, 0 for none */
+    unsigned int i_trace_countdown; /* packets until the next one, 0 for none */
+    bool        b_trace_events;     /* packets with an event as well */
+
     /* statistics */
     uint64_t    i_packets;
     uint64_t    i_null_packets;
     uint64_t    i_lost_bytes;
+    uint64_t    i_cc_errors;
+    ts_rtp_t    rtp;
+    mtime_t     i_date;     /* arrival of the last buffer, in ms */
+
+    /* packet arrivals spread over their buffer, see process_packets() */
+    mtime_t     i_arrival;    /* of the last packet, in us */
+    double      f_packet_us;  /* packet duration at the transport rate, 0 if unknown */
+    bool        b_pcr_rate;   /* that rate being the one of the PCR */
+
+    /* partial packet at the end of the last buffer */
+    uint8_t     carry[188];
+    ssize_t     i_carry;
 
     /* logging */
     ts_stream_log_cb pf_log;
     void *cb_data;
+
+    /* handles and decoders of the PMTs and subtables following the PAT */
+    dvbpsi_pool_t *pool;
 };
 
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
 
+static void handle_PAT(void* p_data, dvbpsi_pat_t* p_pat);
 static void handle_PMT(void* p_data, dvbpsi_pmt_t* p_pmt);
 static void handle_CAT(void* p_data, dvbpsi_cat_t* p_cat);
 static void handle_SDT(void* p_data, dvbpsi_sdt_t* p_sdt);
@@ -304,12 +464,41 @@ static void handle_atsc_ETT(void* p_data, dvbpsi_atsc_ett_t *p_ett);
 static void handle_atsc_STT(void* p_data, dvbpsi_atsc_stt_t *p_stt);
 static const char *AACProfileToString(dvbpsi_aac_profile_and_level_t profile);
 
+/*****************************************************************************
+ * udate: current time in microseconds
+ *****************************************************************************/
+mtime_t udate(void)
+{
+#if defined(HAVE_CLOCK_GETTIME)
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_REALTIME, &ts) == 0)
+        return (ts.tv_sec * (mtime_t)1000000) + (ts.tv_nsec / (mtime_t)1000);
+#endif
+#if defined(HAVE_SYS_TIME_H)
+    struct timeval tv;
+
+    if (gettimeofday(&tv, NULL) < 0)
+    {
+        fprintf(stderr, "gettimeofday() error: %s\n", strerror(errno));
+	/* coverity [+kill} */
+        abort();
+    }
+
+    return (tv.tv_sec * (mtime_t)1000000) + tv.tv_usec;
+#else
+    return -1;
+#endif
+}
+
 /*****************************************************************************
  * mdate: current time in milliseconds
  *****************************************************************************/
 mtime_t mdate(void)
 {
-#if defined(HAVE_SYS_TIME_H)
+#if defined(HAVE_CLOCK_GETTIME)
+    return udate() / 1000;
+#elif defined(HAVE_SYS_TIME_H)
     struct timeval tv;
 
     if (gettimeofday(&tv, NULL) < 0)
@@ -325,6 +514,212 @@ mtime_t mdate(void)
 #endif
 }
 
+/*****************************************************************************
+ * Profile: decoding cost per (PID, table_id)
+ *****************************************************************************
+ * The packets are pushed with their arrival time, so that the decoding
+ * latency of the library is recorded as well, and the sections, bytes and
+ * tables are the difference of dvbpsi_get_stats() around each push. The
+ * cost of a packet goes to the table_id of the section it continues, or of
+ * the one it starts right away.
+ *****************************************************************************/
+static uint64_t profile_ns(void)
+{
+#if defined(HAVE_CLOCK_GETTIME)
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+        return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#endif
+#if defined(HAVE_SYS_TIME_H)
+    struct timeval tv;
+    if (gettimeofday(&tv, NULL) == 0)
+        return (uint64_t)tv.tv_sec * 1000000000 + (uint64_t)tv.tv_usec * 1000;
+#endif
+    return 0;
+}
+
+static ts_profile_entry_t *profile_entry(ts_profile_t *profile, uint16_t i_pid,
+                                         uint8_t i_table_id)
+{
+    ts_profile_entry_t *entry = profile->entries[i_pid];
+    while (entry && entry->i_table_id != i_table_id)
+        entry = entry->p_next;
+    if (entry)
+        return entry;
+
+    entry = calloc(1, sizeof(ts_profile_entry_t));
+    if (!entry)
+        return NULL;
+    entry->i_pid = i_pid;
+    entry->i_table_id = i_table_id;
+    entry->p_next = profile->entries[i_pid];
+    profile->entries[i_pid] = entry;
+    profile->i_entries++;
+    return entry;
+}
+
+/* table_id of the section starting at the pointer_field of the packet, a
+ * later one when b_first is false, or -1 */
+static int profile_table_id(const uint8_t *p_packet, bool b_first)
+{
+    unsigned int i_offset = 4;
+
+    if (!(p_packet[1] & 0x40) || !(p_packet[3] & 0x10))
+        return -1;
+    if (p_packet[3] & 0x20)
+        i_offset += 1 + p_packet[4];
+    if (i_offset >= 187)
+        return -1;
+    unsigned int i_pointer = p_packet[i_offset];
+    if (b_first != (i_pointer == 0) || i_offset + 1 + i_pointer >= 188)
+        return -1;
+    return p_packet[i_offset + 1 + i_pointer];
+}
+
+static bool profile_push(ts_stream_t *stream, dvbpsi_t *handle, uint8_t *p_packet,
+                         uint16_t i_pid, mtime_t date)
+{
+    ts_profile_t *profile = stream->profile;
+    dvbpsi_stats_t before, after;
+
+    int i_table_id = profile_table_id(p_packet, true);
+    if (i_table_id >= 0)
+        profile->table_id[i_pid] = i_table_id;
+
+    dvbpsi_get_stats(handle, &before);
+    profile->i_pid = i_pid;
+    uint64_t i_start = profile_ns();
+    bool b_ok = dvbpsi_packet_push_at(handle, p_packet, date);
+    uint64_t i_ns = profile_ns() - i_start;
+    dvbpsi_get_stats(handle, &after);
+
+    ts_profile_entry_t *entry = profile_entry(profile, i_pid, profile->table_id[i_pid]);
+    if (entry)
+    {
+        entry->i_push_ns += i_ns;
+        entry->i_packets++;
+        entry->i_sections += after.i_sections - before.i_sections;
+        entry->i_bytes += after.i_bytes_copied - before.i_bytes_copied;
+        entry->i_tables += after.i_tables - before.i_tables;
+    }
+
+    i_table_id = profile_table_id(p_packet, false);
+    if (i_table_id >= 0)
+        profile->table_id[i_pid] = i_table_id;
+    return b_ok;
+}
+
+/* dvbpsi_packet_push(), timed when profiling */
+static inline bool ts_push(ts_stream_t *stream, dvbpsi_t *handle, uint8_t *p_packet,
+                           uint16_t i_pid, mtime_t date)
+{
+    if (!stream->profile)
+        return dvbpsi_packet_push(handle, p_packet);
+    return profile_push(stream, handle, p_packet, i_pid, date);
+}
+
+/* tells the caller of libdvbpsi_pids() of a PID decoded */
+static inline void ts_pid_wanted(ts_stream_t *stream, uint16_t i_pid,
+                                 uint8_t i_table_id, uint8_t i_mask)
+{
+    if (stream->pf_pid)
+        stream->pf_pid(stream->pid_data, i_pid, i_table_id, i_mask);
+}
+
+/* Writes the table serialized last as a line of JSON */
+static void json_write(ts_stream_t *stream, bool b_serialized)
+{
+    if (!b_serialized)
+        stream->pf_log(stream->cb_data, 0, "dvbinfo: Failed to serialize a table\n");
+    else if (fwrite(stream->serializer.p_buffer, 1, stream->serializer.i_length,
+                    stream->json) != stream->serializer.i_length)
+        stream->pf_log(stream->cb_data, 0, "dvbinfo: Failed to write a table\n");
+    dvbpsi_serializer_reset(&stream->serializer);
+}
+
+static uint8_t *json_grow(void *p_data, uint8_t *p_buffer, size_t i_size)
+{
+    (void)p_data;
+    return realloc(p_buffer, i_size);
+}
+
+/* Publishes the table laid out by flatten into the buffer of its slot */
+#define TS_PUBLISH(pid, table_id, extension, flatten)                          \
+    do {                                                                       \
+        size_t i_size;                                                         \
+        uint8_t *p_buffer = dvbpsi_shm_reserve(stream->shm, pid, table_id,    \
+                                               extension, &i_size);            \
+        if (!p_buffer                                                          \
+         || !dvbpsi_shm_publish(stream->shm,                                   \
+                                dvbpsi_flatten_##flatten(p_buffer, i_size, p_table))) \
+            stream->pf_log(stream->cb_data, 0,                                 \
+                           "dvbinfo: Failed to publish a table\n");           \
+    } while (0)
+#define TS_NO_PUBLISH do { } while (0)
+
+/* PID of the PMT of a program, to publish it */
+static uint16_t pmt_pid(ts_stream_t *stream, uint16_t i_number)
+{
+    for (ts_pmt_t *p = stream->pmt; p; p = p->p_next)
+        if (p->i_number == i_number && p->pid_pmt)
+            return p->pid_pmt->i_pid;
+    return 0x1fff;
+}
+
+/* The handle_* callbacks given to the decoders, timed when profiling,
+ * written as JSON first with --json and published with --tables-shm. The
+ * table_id is read before the handler deletes the table. */
+#define TS_PROFILE_HANDLER(name, type, table_id, serialize, publish)           \
+static void profile_##name(void *p_data, type *p_table)                       \
+{                                                                              \
+    ts_stream_t *stream = (ts_stream_t *)p_data;                               \
+    if (stream->json)                                                          \
+        json_write(stream, dvbpsi_serialize_##serialize(&stream->serializer,  \
+                                                        p_table));             \
+    if (stream->shm)                                                           \
+        publish;                                                               \
+    if (!stream->profile)                                                      \
+    {                                                                          \
+        handle_##name(p_data, p_table);                                        \
+        return;                                                                \
+    }                                                                          \
+    ts_profile_entry_t *entry = profile_entry(stream->profile,                 \
+                                              stream->profile->i_pid, table_id); \
+    uint64_t i_start = profile_ns();                                           \
+    handle_##name(p_data, p_table);                                            \
+    if (entry)                                                                 \
+        entry->i_handler_ns += profile_ns() - i_start;                         \
+}
+
+/* The NIT, SDT, BAT, EIT and TDT/TOT are published on their PIDs of
+ * EN 300 468 */
+TS_PROFILE_HANDLER(PAT, dvbpsi_pat_t, 0x00, pat,
+                   TS_PUBLISH(0x00, 0x00, p_table->i_ts_id, pat))
+TS_PROFILE_HANDLER(CAT, dvbpsi_cat_t, 0x01, cat,
+                   TS_PUBLISH(0x01, 0x01, 0, cat))
+TS_PROFILE_HANDLER(PMT, dvbpsi_pmt_t, 0x02, pmt,
+                   TS_PUBLISH(pmt_pid(stream, p_table->i_program_number), 0x02,
+                              p_table->i_program_number, pmt))
+TS_PROFILE_HANDLER(NIT, dvbpsi_nit_t, p_table->i_table_id, nit,
+                   TS_PUBLISH(0x10, p_table->i_table_id, p_table->i_extension, nit))
+TS_PROFILE_HANDLER(SDT, dvbpsi_sdt_t, p_table->i_table_id, sdt,
+                   TS_PUBLISH(0x11, p_table->i_table_id, p_table->i_extension, sdt))
+TS_PROFILE_HANDLER(BAT, dvbpsi_bat_t, p_table->i_table_id, bat,
+                   TS_PUBLISH(0x11, p_table->i_table_id, p_table->i_extension, bat))
+TS_PROFILE_HANDLER(EIT, dvbpsi_eit_t, p_table->i_table_id, eit,
+                   TS_PUBLISH(0x12, p_table->i_table_id, p_table->i_extension, eit))
+TS_PROFILE_HANDLER(TOT, dvbpsi_tot_t, p_table->i_table_id, tot,
+                   TS_PUBLISH(0x14, p_table->i_table_id, 0, tot))
+TS_PROFILE_HANDLER(RST, dvbpsi_rst_t, 0x71, rst, TS_NO_PUBLISH)
+#ifdef TS_USE_SCTE_SIS
+TS_PROFILE_HANDLER(SIS, dvbpsi_sis_t, p_table->i_table_id, sis, TS_NO_PUBLISH)
+#endif
+TS_PROFILE_HANDLER(atsc_VCT, dvbpsi_atsc_vct_t, p_table->i_table_id, atsc_vct, TS_NO_PUBLISH)
+TS_PROFILE_HANDLER(atsc_MGT, dvbpsi_atsc_mgt_t, p_table->i_table_id, atsc_mgt, TS_NO_PUBLISH)
+TS_PROFILE_HANDLER(atsc_EIT, dvbpsi_atsc_eit_t, p_table->i_table_id, atsc_eit, TS_NO_PUBLISH)
+TS_PROFILE_HANDLER(atsc_ETT, dvbpsi_atsc_ett_t, p_table->i_table_id, atsc_ett, TS_NO_PUBLISH)
+TS_PROFILE_HANDLER(atsc_STT, dvbpsi_atsc_stt_t, p_table->i_table_id, atsc_stt, TS_NO_PUBLISH)
+
 /*****************************************************************************
  * libdvbpsi message callback functions
  *****************************************************************************/
@@ -359,6 +754,87 @@ static void dvbpsi_message(dvbpsi_t *p_dvbpsi, const dvbpsi_msg_level_t level, c
     }
 }
 
+/*****************************************************************************
+ * PID state
+ *****************************************************************************/
+/* record of a PID, allocated the first time */
+static ts_pid_t *ts_pid(ts_stream_t *stream, uint16_t i_pid)
+{
+    if (!stream->pid[i_pid])
+    {
+        stream->pid[i_pid] = calloc(1, sizeof(ts_pid_t));
+        if (stream->pid[i_pid])
+            stream->pid[i_pid]->i_pid = i_pid;
+    }
+    return stream->pid[i_pid];
+}
+
+static uint64_t ts_packets(const ts_stream_t *stream, uint16_t i_pid)
+{
+    uint64_t i_packets = stream->hot[i_pid].i_packets;
+    if (stream->pid[i_pid])
+        i_packets += (uint64_t)stream->pid[i_pid]->i_packets_wraps << 32;
+    return i_packets;
+}
+
+/* first packet of a PID */
+static void ts_pid_seen(ts_stream_t *stream, uint16_t i_pid)
+{
+    ts_pid_t *ts = ts_pid(stream, i_pid);
+    if (!ts)
+        return;
+
+    ts->second = series_new(BITRATE_SECOND, BITRATE_SPAN / BITRATE_SECOND);
+    ts->tenth = series_new(BITRATE_TENTH, BITRATE_SPAN / BITRATE_TENTH);
+
+    /* once per PID, the summaries then only walk the PIDs seen */
+    int i = stream->i_seen;
+    while (i > 0 && stream->sorted[i - 1] > i_pid)
+    {
+        stream->sorted[i] = stream->sorted[i - 1];
+        i--;
+    }
+    stream->sorted[i] = i_pid;
+    stream->seen[stream->i_seen++] = i_pid;
+}
+
+static void ts_pids_free(ts_stream_t *stream)
+{
+    for (int i_pid = 0; i_pid < 8192; i_pid++)
+    {
+        ts_pid_t *ts = stream->pid[i_pid];
+        if (!ts)
+            continue;
+        free(ts->pcr);
+        if (ts->second)
+            series_delete(ts->second);
+        if (ts->tenth)
+            series_delete(ts->tenth);
+        free(ts);
+        stream->pid[i_pid] = NULL;
+    }
+}
+
+/* counts the packets since the last call in the bitrate series, at the
+ * arrival of the last buffer: called as the arrival time moves to another
+ * 100 ms, as no packet is counted in the series when it arrives */
+static void ts_series_flush(ts_stream_t *stream)
+{
+    for (int i = 0; i < stream->i_seen; i++)
+    {
+        ts_pid_t *ts = stream->pid[stream->seen[i]];
+        uint64_t i_packets = ts_packets(stream, stream->seen[i]);
+
+        if (i_packets == ts->i_series)
+            continue;
+        if (ts->second)
+            series_add(ts->second, stream->i_date, i_packets - ts->i_series);
+        if (ts->tenth)
+            series_add(ts->tenth, stream->i_date, i_packets - ts->i_series);
+        ts->i_series = i_packets;
+    }
+}
+
 /*****************************************************************************
  * Dump TS packet as hex
  *****************************************************************************/
@@ -374,22 +850,26 @@ static void ts_hexdump(FILE *fd, const uint8_t * const data, const uint32_t leng
     }
 }
 
-static void ts_header_dump(FILE *fd, ts_pid_t *ts)
+static void ts_header_dump(FILE *fd, const ts_stream_t *stream, const ts_pid_t *ts)
 {
+    const ts_pid_hot_t *hot = &stream->hot[ts->i_pid];
+    uint8_t i_transport_scrambling_control = (hot->i_control & 0xC0) >> 6;
+    bool b_adaptation_field = (hot->i_control & 0x20);
+
     fprintf(fd, "\n\tPID 0x%x seen %s\n",
-           ts->i_pid, ts->b_seen ? "yes" : "no");
-    fprintf(fd, "\tContinuity counter: %d\n", ts->i_cc);
+           ts->i_pid, hot->b_seen ? "yes" : "no");
+    fprintf(fd, "\tContinuity counter: %d\n", hot->i_control & 0x0f);
     fprintf(fd, "\tTransport Error indicator: %s\n",
-           ts->b_transport_error_indicator ? "yes" : "no");
+           (hot->i_flags & 0x80) ? "yes" : "no");
     fprintf(fd, "\tPayload unit start indicator: %s\n",
-           ts->b_payload_unit_start_indicator ? "yes" : "no");
+           (hot->i_flags & 0x40) ? "yes" : "no");
     fprintf(fd, "\tScrambling control: %s\n",
-           (ts->i_transport_scrambling_control != 0x0) ? "yes" : "no");
-    if (ts->i_transport_scrambling_control > 0x0)
-        fprintf(fd, "\tScrambling control word: 0x%x\n", ts->i_transport_scrambling_control);
+           (i_transport_scrambling_control != 0x0) ? "yes" : "no");
+    if (i_transport_scrambling_control > 0x0)
+        fprintf(fd, "\tScrambling control word: 0x%x\n", i_transport_scrambling_control);
     fprintf(fd, "\tAdaptation field control: %s\n",
-           ts->b_adaptation_field ? "yes" : "no");
-    if (ts->b_adaptation_field)
+           b_adaptation_field ? "yes" : "no");
+    if (b_adaptation_field)
     {
         fprintf(fd, "\tDiscontinuity indicator: %s\n",
            ts->b_discontinuity_indicator ? "yes" : "no");
@@ -465,15 +945,197 @@ static void ts_dump_packet_details(FILE *fd, ts_stream_t *stream, const uint8_t
 {
     fprintf(fd, "\n\t---------------------------------------------------------\n");
     fprintf(fd, "\tTS Packet number %"PRId64", ES number %"PRId64", pid %d (0x%x)\n",
-       stream->i_packets, stream->pid[i_pid].i_packets, i_pid, i_pid);
+       stream->i_packets, ts_packets(stream, i_pid), i_pid, i_pid);
 #if defined(HAVE_SYS_TIME_H)
-    fprintf(fd, "\tReceived time: %"PRId64" ms\n", stream->pid[i_pid].i_received);
+    fprintf(fd, "\tReceived time: %"PRId64" ms\n", stream->hot[i_pid].i_received);
 #endif
-    ts_header_dump(fd, &stream->pid[i_pid]);
+    ts_pid_t empty = { .i_pid = i_pid };
+    ts_header_dump(fd, stream, stream->pid[i_pid] ? stream->pid[i_pid] : &empty);
     ts_hexdump(fd, data, 188);
     fprintf(fd, "\n\t---------------------------------------------------------\n");
 }
 
+/*****************************************************************************
+ * PCR analysis: accuracy, overall jitter and drift (ETSI TR 101 290 5.3.2)
+ *****************************************************************************/
+#define PCR_WRAP        (((int64_t)1 << 33) * 300)  /* 27 MHz units */
+#define PCR_MAX_GAP     (27000000 / 10)     /* 100 ms, a bigger gap restarts */
+
+static void running_add(ts_running_t *run, double f_value)
+{
+    double f_delta = f_value - run->f_mean;
+
+    if (run->i_count == 0)
+        run->f_min = run->f_max = f_value;
+    else if (f_value < run->f_min)
+        run->f_min = f_value;
+    else if (f_value > run->f_max)
+        run->f_max = f_value;
+
+    run->i_count++;
+    run->f_mean += f_delta / run->i_count;
+    run->f_m2 += f_delta * (f_value - run->f_mean);
+}
+
+static double running_stddev(const ts_running_t *run)
+{
+    return (run->i_count > 1) ? sqrt(run->f_m2 / (run->i_count - 1)) : 0.0;
+}
+
+static void histogram_add(uint64_t *p_bins, double f_value, double f_low, double f_width)
+{
+    double f_bin = floor((f_value - f_low) / f_width);
+
+    if (f_bin < 0)
+        p_bins[0]++;
+    else if (f_bin >= PCR_BINS)
+        p_bins[PCR_BINS + 1]++;
+    else
+        p_bins[(int)f_bin + 1]++;
+}
+
+/* i_packet is the index of the packet carrying the PCR in the stream,
+ * i_arrival its arrival in us */
+static void pcr_account(ts_pcr_t *pcr, int64_t i_pcr, bool b_discontinuity,
+                        uint64_t i_packet, mtime_t i_arrival)
+{
+    int64_t i_delta = ((i_pcr - pcr->i_pcr) % PCR_WRAP + PCR_WRAP) % PCR_WRAP;
+    uint64_t i_packets = i_packet - pcr->i_packet;
+    bool b_rate = true;
+
+    if (!pcr->b_valid || b_discontinuity || (i_delta > PCR_MAX_GAP) || (i_packets == 0))
+    {
+        /* new time base: the rate and the regression start again */
+        pcr->i_ticks = 0;
+        pcr->i_packets = 0;
+        pcr->f_pcr = 0;
+        pcr->i_first_arrival = i_arrival;
+        pcr->i_fit = 0;
+        pcr->f_mean_x = pcr->f_mean_y = 0;
+        pcr->f_m2_x = pcr->f_c_xy = 0;
+    }
+    else
+    {
+        /* PCR_AC, against the rate interpolated from the previous PCRs */
+        if (pcr->i_packets > 0)
+        {
+            double f_expected = (double)i_packets * pcr->i_ticks / pcr->i_packets;
+            double f_accuracy = ((double)i_delta - f_expected) * 1000.0 / 27.0;
+
+            running_add(&pcr->accuracy, f_accuracy);
+            histogram_add(pcr->pi_accuracy, f_accuracy, -1000.0, 100.0);
+            b_rate = (fabs(f_accuracy) <= 500.0);
+        }
+        /* an inaccurate interval would bias the rate of all the others */
+        if (b_rate)
+        {
+            pcr->i_ticks += i_delta;
+            pcr->i_packets += i_packets;
+        }
+        pcr->f_pcr += (double)i_delta / 27.0;
+    }
+    pcr->b_valid = true;
+    pcr->i_pcr = i_pcr;
+    pcr->i_packet = i_packet;
+
+    /* offset of the PCR to the arrival time, fitted by least squares */
+    double f_x = (double)(i_arrival - pcr->i_first_arrival);
+    double f_y = pcr->f_pcr - f_x;
+    double f_dx = f_x - pcr->f_mean_x;
+
+    pcr->i_fit++;
+    pcr->f_mean_x += f_dx / pcr->i_fit;
+    pcr->f_mean_y += (f_y - pcr->f_mean_y) / pcr->i_fit;
+    pcr->f_m2_x += f_dx * (f_x - pcr->f_mean_x);
+    pcr->f_c_xy += f_dx * (f_y - pcr->f_mean_y);
+    if ((pcr->i_fit < 2) || (pcr->f_m2_x <= 0))
+        return; /* no arrival time to compare with yet */
+
+    /* PCR_OJ, the distance to the fitted line that takes the drift out */
+    double f_slope = pcr->f_c_xy / pcr->f_m2_x;
+    pcr->f_drift = f_slope * 1e6;
+    double f_jitter = f_y - (pcr->f_mean_y + f_slope * (f_x - pcr->f_mean_x));
+
+    running_add(&pcr->jitter, f_jitter);
+    histogram_add(pcr->pi_jitter, f_jitter, -10000.0, 1000.0);
+}
+
+static void summary_histogram(FILE *fd, const uint64_t *p_bins, int i_low, int i_width,
+                              const char *psz_unit)
+{
+    if (p_bins[0])
+        fprintf(fd, "\t     < %6d %s: %"PRIu64"\n", i_low, psz_unit, p_bins[0]);
+    for (int i = 1; i <= PCR_BINS; i++)
+    {
+        if (p_bins[i])
+            fprintf(fd, "\t[%6d, %6d) %s: %"PRIu64"\n", i_low + (i - 1) * i_width,
+                    i_low + i * i_width, psz_unit, p_bins[i]);
+    }
+    if (p_bins[PCR_BINS + 1])
+        fprintf(fd, "\t    >= %6d %s: %"PRIu64"\n", i_low + PCR_BINS * i_width,
+                psz_unit, p_bins[PCR_BINS + 1]);
+}
+
+static void summary_pcr(FILE *fd, ts_stream_t *stream)
+{
+    for (int i = 0; i < stream->i_seen; i++)
+    {
+        int i_pid = stream->sorted[i];
+        const ts_pcr_t *pcr = stream->pid[i_pid]->pcr;
+        if (!pcr)
+            continue;
+
+        double bitrate = 0;
+        if (pcr->i_ticks > 0)
+            bitrate = (double)pcr->i_packets * 188 * 8 * 27000.0 / pcr->i_ticks;
+        fprintf(fd, "\nPCR PID: %4d (0x%4x), interpolated bitrate %0.4f kbit/s\n",
+                i_pid, i_pid, bitrate);
+        fprintf(fd, "PCR_AC: %"PRIu64" intervals, mean %0.1f ns, stddev %0.1f ns,"
+                " min %0.1f ns, max %0.1f ns\n", pcr->accuracy.i_count,
+                pcr->accuracy.f_mean, running_stddev(&pcr->accuracy),
+                pcr->accuracy.f_min, pcr->accuracy.f_max);
+        summary_histogram(fd, pcr->pi_accuracy, -1000, 100, "ns");
+        fprintf(fd, "PCR_OJ: %"PRIu64" PCRs, mean %0.1f us, stddev %0.1f us,"
+                " min %0.1f us, max %0.1f us\n", pcr->jitter.i_count,
+                pcr->jitter.f_mean, running_stddev(&pcr->jitter),
+                pcr->jitter.f_min, pcr->jitter.f_max);
+        summary_histogram(fd, pcr->pi_jitter, -10000, 1000, "us");
+        fprintf(fd, "PCR drift: %0.3f ppm\n", pcr->f_drift);
+    }
+}
+
+/*****************************************************************************
+ * Load shedding, see libdvbpsi_shed()
+ *****************************************************************************/
+/* Calls pf_handle for each handle of the stream */
+static void ts_handles(ts_stream_t *stream, void (*pf_handle)(dvbpsi_t *, void *),
+                       void *data)
+{
+    dvbpsi_t *handles[] = { stream->pat.handle, stream->cat.handle, stream->rst.handle,
+                            stream->sdt.handle, stream->eit.handle, stream->tdt.handle,
+                            stream->atsc.handle };
+
+    for (unsigned int i = 0; i < ARRAY_SIZE(handles); i++)
+        if (handles[i])
+            pf_handle(handles[i], data);
+    for (ts_pmt_t *p = stream->pmt; p; p = p->p_next)
+        pf_handle(p->handle, data);
+    for (ts_atsc_eit_t *p = stream->atsc_eit; p; p = p->p_next)
+        pf_handle(p->handle, data);
+}
+
+static void shed_set(dvbpsi_t *handle, void *data)
+{
+    dvbpsi_set_shed_level(handle, *(const dvbpsi_shed_level_t *)data);
+}
+
+static void shed_count(dvbpsi_t *handle, void *data)
+{
+    dvbpsi_stats_t stats;
+    dvbpsi_get_stats(handle, &stats);
+    *(uint64_t *)data += stats.i_dropped_shed;
+}
+
 /*****************************************************************************
  * Summary: Bandwidth, Packet, Table
  *****************************************************************************/
@@ -485,15 +1147,18 @@ static void summary(FILE *fd, ts_stream_t *stream)
 
     fprintf(fd, "\n---------------------------------------------------------\n");
     fprintf(fd, "\nSummary: Bandwidth\n");
+    ts_series_flush(stream);
 
     /* Find PCR PID and get pcr timestamps */
-    for (int i_pid = 0; i_pid < 8192; i_pid++)
+    for (int i = 0; i < stream->i_seen; i++)
     {
-        if (stream->pid[i_pid].b_pcr)
+        int i_pid = stream->sorted[i];
+        const ts_pid_t *ts = stream->pid[i_pid];
+        if (ts->b_pcr)
         {
-            start = stream->pid[i_pid].i_first_pcr;
-            end = stream->pid[i_pid].i_last_pcr;
-            if (stream->pid[i_pid].b_discontinuity_indicator)
+            start = ts->i_first_pcr;
+            end = ts->i_last_pcr;
+            if (ts->b_discontinuity_indicator)
             {
                 fprintf(fd, "PCR discontinuity was signalled for PID: %4d (0x%4x)\n",
                        i_pid, i_pid);
@@ -501,31 +1166,44 @@ static void summary(FILE *fd, ts_stream_t *stream)
         }
     }
 
-    for (int i_pid = 0; i_pid < 8192; i_pid++)
+    for (int i = 0; i < stream->i_seen; i++)
     {
-        if (stream->pid[i_pid].b_seen)
-        {
-            fprintf(fd, "Found PID: %4d (0x%4x), DRM: %s,", i_pid, i_pid,
-                   (stream->pid[i_pid].i_transport_scrambling_control != 0x00) ? "yes" : " no" );
+        int i_pid = stream->sorted[i];
+        uint64_t i_pid_packets = ts_packets(stream, i_pid);
+        fprintf(fd, "Found PID: %4d (0x%4x), DRM: %s,", i_pid, i_pid,
+               (stream->hot[i_pid].i_control & 0xC0) ? "yes" : " no" );
 
-            double bitrate = 0;
-            if ((end - start) > 0)
-            {
-                bitrate = (double) (stream->pid[i_pid].i_packets * 188 * 8) /
-                                    ((double)(end - start)/1000.0);
-            }
-            fprintf(fd, " bitrate %0.4f kbit/s,", bitrate);
-            fprintf(fd, " seen %"PRId64" packets",
-                   stream->pid[i_pid].i_packets);
-            fprintf(fd, "\n");
-
-            i_packets += stream->pid[i_pid].i_packets;
-            if (i_first_pcr == 0)
-                i_first_pcr = start;
-            else
-                i_first_pcr = (i_first_pcr < start) ? i_first_pcr : start;
-            i_last_pcr = (i_last_pcr > end) ? i_last_pcr : end;
+        double bitrate = 0;
+        if ((end - start) > 0)
+        {
+            bitrate = (double) (i_pid_packets * 188 * 8) /
+                                ((double)(end - start)/1000.0);
+        }
+        fprintf(fd, " bitrate %0.4f kbit/s,", bitrate);
+        fprintf(fd, " seen %"PRId64" packets",
+               i_pid_packets);
+
+        /* the last whole second, and its busiest 100 ms */
+        double last[1], peak[BITRATE_SECOND / BITRATE_TENTH];
+        if (libdvbpsi_bitrate(stream, i_pid, BITRATE_SECOND,
+                              stream->i_date - BITRATE_SECOND, last, 1) == 1)
+        {
+            libdvbpsi_bitrate(stream, i_pid, BITRATE_TENTH,
+                              stream->i_date - BITRATE_SECOND, peak, ARRAY_SIZE(peak));
+            double max = 0;
+            for (unsigned int t = 0; t < ARRAY_SIZE(peak); t++)
+                max = (peak[t] > max) ? peak[t] : max;
+            fprintf(fd, ", last second %0.4f kbit/s (100 ms peak %0.4f kbit/s)",
+                    last[0] / 1000.0, max / 1000.0);
         }
+        fprintf(fd, "\n");
+
+        i_packets += i_pid_packets;
+        if (i_first_pcr == 0)
+            i_first_pcr = start;
+        else
+            i_first_pcr = (i_first_pcr < start) ? i_first_pcr : start;
+        i_last_pcr = (i_last_pcr > end) ? i_last_pcr : end;
     }
     double total_bitrate = (double)(((i_packets*188) + stream->i_lost_bytes) * 8)/((double)(i_last_pcr - i_first_pcr)/1000.0);
     fprintf(fd, "\nTotal bitrate %0.4f kbits/s\n", total_bitrate);
@@ -534,9 +1212,27 @@ static void summary(FILE *fd, ts_stream_t *stream)
             i_packets, stream->i_null_packets, stream->i_lost_bytes);
     fprintf(fd, "PCR first: %"PRId64", last: %"PRId64", duration: %"PRId64"\n",
             i_first_pcr, i_last_pcr, (mtime_t)(i_last_pcr - i_first_pcr));
+    summary_pcr(fd, stream);
+    if (stream->i_shed_changes > 0)
+    {
+        uint64_t i_shed = 0;
+        ts_handles(stream, shed_count, &i_shed);
+        fprintf(fd, "Shed level: %d, %"PRIu64" changes, %"PRIu64" sections shed\n",
+                stream->shed_level, stream->i_shed_changes, i_shed);
+    }
     fprintf(fd, "\n---------------------------------------------------------\n");
 }
 
+static void summary_rtp(FILE *fd, ts_stream_t *stream)
+{
+    if (!stream->rtp.b_seen)
+        return;
+
+    fprintf(fd, "\nRTP: %"PRIu64" datagrams, lost %"PRIu64", reordered %"PRIu64
+            ", jitter %0.3f ms\n", stream->rtp.i_datagrams, stream->rtp.i_lost,
+            stream->rtp.i_reordered, stream->rtp.f_jitter / 90.0);
+}
+
 static void summary_table(FILE *fd, ts_stream_t *stream)
 {
     fprintf(fd, "\n---------------------------------------------------------\n");
@@ -544,42 +1240,149 @@ static void summary_table(FILE *fd, ts_stream_t *stream)
 
     fprintf(fd, "\nTable: PAT\n");
     if (stream->pat.handle)
-        ts_header_dump(fd, stream->pat.pid);
+        ts_header_dump(fd, stream, stream->pat.pid);
     fprintf(fd, "\nTable: PMT\n");
     ts_pmt_t *p_pmt = stream->pmt;
     while (p_pmt)
     {
         if (p_pmt->handle)
-            ts_header_dump(fd, p_pmt->pid_pmt);
+            ts_header_dump(fd, stream, p_pmt->pid_pmt);
         p_pmt = p_pmt->p_next;
     }
     fprintf(fd, "\nTable: CAT\n");
     if (stream->cat.handle)
-        ts_header_dump(fd, stream->cat.pid );
+        ts_header_dump(fd, stream, stream->cat.pid);
     fprintf(fd, "\nTable: SDT\n");
     if (stream->sdt.handle)
-        ts_header_dump(fd, stream->sdt.pid);
+        ts_header_dump(fd, stream, stream->sdt.pid);
     fprintf(fd, "\nTable: EIT\n");
     if (stream->eit.handle)
-        ts_header_dump(fd, stream->eit.pid);
+        ts_header_dump(fd, stream, stream->eit.pid);
     fprintf(fd, "\nTable: TDT\n");
     if (stream->tdt.handle)
-        ts_header_dump(fd, stream->tdt.pid);
+        ts_header_dump(fd, stream, stream->tdt.pid);
 
     fprintf(fd, "\n---------------------------------------------------------\n");
 }
 
-static void summary_packet(FILE *fd, ts_stream_t *stream)
+/* Handle the packets of a PID are pushed to first, see process_packets() */
+static dvbpsi_t *profile_handle(ts_stream_t *stream, uint16_t i_pid)
+{
+    switch (i_pid)
+    {
+        case 0x00:   return stream->pat.handle;
+        case 0x01:   return stream->cat.handle;
+        case 0x02:
+        case 0x14:   return stream->tdt.handle;
+        case 0x11:   return stream->sdt.handle;
+        case 0x12:   return stream->eit.handle;
+        case 0x13:   return stream->rst.handle;
+        case 0x1FFB: return stream->atsc.handle;
+    }
+    for (ts_pmt_t *p = stream->pmt; p; p = p->p_next)
+        if (p->pid_pmt->i_pid == i_pid)
+            return p->handle;
+    for (ts_atsc_eit_t *p = stream->atsc_eit; p; p = p->p_next)
+        if (p->pid->i_pid == i_pid)
+            return p->handle;
+    return NULL;
+}
+
+static int profile_compare(const void *a, const void *b)
+{
+    const ts_profile_entry_t *p_a = *(ts_profile_entry_t * const *)a;
+    const ts_profile_entry_t *p_b = *(ts_profile_entry_t * const *)b;
+    if (p_a->i_push_ns != p_b->i_push_ns)
+        return p_a->i_push_ns < p_b->i_push_ns ? 1 : -1;
+    if (p_a->i_pid != p_b->i_pid)
+        return p_a->i_pid < p_b->i_pid ? -1 : 1;
+    return p_a->i_table_id - p_b->i_table_id;
+}
+
+static void summary_profile(FILE *fd, ts_stream_t *stream)
 {
+    ts_profile_t *profile = stream->profile;
+    if (!profile)
+        return;
+
     fprintf(fd, "\n---------------------------------------------------------\n");
-    fprintf(fd, "\nSummary: Packet\n");
+    fprintf(fd, "\nSummary: Top tables by CPU\n");
 
-    /* Find PCR PID and get pcr timestamps */
+    ts_profile_entry_t **entries = calloc(profile->i_entries + 1, sizeof(ts_profile_entry_t *));
+    if (!entries)
+        return;
+
+    unsigned int i_count = 0, i_pids = 0;
+    uint64_t i_total_ns = 0;
     for (int i_pid = 0; i_pid < 8192; i_pid++)
     {
-        ts_pid_t *ts = &stream->pid[i_pid];
-        ts_header_dump(fd, ts);
+        if (profile->entries[i_pid])
+            i_pids++;
+        for (ts_profile_entry_t *entry = profile->entries[i_pid]; entry; entry = entry->p_next)
+        {
+            entries[i_count++] = entry;
+            i_total_ns += entry->i_push_ns;
+        }
     }
+    qsort(entries, i_count, sizeof(ts_profile_entry_t *), profile_compare);
+
+    /* latency: median bucket of dvbpsi_get_latency_histogram(), in ms */
+    fprintf(fd, "\n rank     PID table   cpu ms      %%  handler ms  packets sections"
+                "      bytes  tables ns/section latency ms\n");
+    for (unsigned int i = 0; i < i_count; i++)
+    {
+        const ts_profile_entry_t *entry = entries[i];
+        char psz_latency[16] = "-";
+        uint64_t pi_buckets[DVBPSI_LATENCY_BUCKETS];
+        dvbpsi_t *handle = profile_handle(stream, entry->i_pid);
+
+        if (handle && entry->i_table_id != 0xff &&
+            dvbpsi_get_latency_histogram(handle, entry->i_table_id, pi_buckets))
+        {
+            uint64_t i_latencies = 0, i_seen = 0;
+            for (int b = 0; b < DVBPSI_LATENCY_BUCKETS; b++)
+                i_latencies += pi_buckets[b];
+            for (int b = 0; i_latencies > 0 && b < DVBPSI_LATENCY_BUCKETS; b++)
+            {
+                i_seen += pi_buckets[b];
+                if (2 * i_seen >= i_latencies)
+                {
+                    snprintf(psz_latency, sizeof(psz_latency), "< %"PRIu64,
+                             (uint64_t)1 << b);
+                    break;
+                }
+            }
+        }
+
+        char psz_table_id[8] = "?";
+        if (entry->i_table_id != 0xff)
+            snprintf(psz_table_id, sizeof(psz_table_id), "0x%02x", entry->i_table_id);
+
+        fprintf(fd, "%5u %4d 0x%04x %5s %9.3f %6.2f %11.3f %8"PRIu64" %8"PRIu64
+                " %10"PRIu64" %7"PRIu64" %10.0f %10s\n",
+                i + 1, entry->i_pid, entry->i_pid, psz_table_id,
+                (double)entry->i_push_ns / 1e6,
+                i_total_ns ? (double)entry->i_push_ns * 100.0 / (double)i_total_ns : 0.0,
+                (double)entry->i_handler_ns / 1e6, entry->i_packets, entry->i_sections,
+                entry->i_bytes, entry->i_tables,
+                entry->i_sections ? (double)entry->i_push_ns / (double)entry->i_sections : 0.0,
+                psz_latency);
+    }
+    fprintf(fd, "\nTotal: %0.3f ms in the decoders, %u table_ids on %u PIDs\n",
+            (double)i_total_ns / 1e6, i_count, i_pids);
+    free(entries);
+
+    fprintf(fd, "\n---------------------------------------------------------\n");
+}
+
+static void summary_packet(FILE *fd, ts_stream_t *stream)
+{
+    fprintf(fd, "\n---------------------------------------------------------\n");
+    fprintf(fd, "\nSummary: Packet\n");
+
+    /* the PIDs seen, those never seen have no header to show */
+    for (int i = 0; i < stream->i_seen; i++)
+        ts_header_dump(fd, stream, stream->pid[stream->sorted[i]]);
 
     fprintf(fd, "\n---------------------------------------------------------\n");
 }
@@ -605,11 +1408,11 @@ static void handle_subtable(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_e
 #endif
         case 0x40: // NIT network_information_section - actual_network
         case 0x41: // NIT network_information_section - other_network
-            if (!dvbpsi_nit_attach(p_dvbpsi, i_table_id, i_extension, handle_NIT, p_data))
+            if (!dvbpsi_nit_attach(p_dvbpsi, i_table_id, i_extension, profile_NIT, p_data))
                     fprintf(stderr, "dvbinfo: Failed to attach NIT subdecoder\n");
             break;
         case 0x42:
-            if (!dvbpsi_sdt_attach(p_dvbpsi, i_table_id, i_extension, handle_SDT, p_data))
+            if (!dvbpsi_sdt_attach(p_dvbpsi, i_table_id, i_extension, profile_SDT, p_data))
                     fprintf(stderr, "dvbinfo: Failed to attach SDT subdecoder\n");
             break;
 #if 0
@@ -618,7 +1421,7 @@ static void handle_subtable(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_e
         //0x47 to 0x49 reserved for future use
 #endif
         case 0x4A: // BAT bouquet_association_section
-            if (!dvbpsi_bat_attach(p_dvbpsi, i_table_id, i_extension, handle_BAT, p_data))
+            if (!dvbpsi_bat_attach(p_dvbpsi, i_table_id, i_extension, profile_BAT, p_data))
                     fprintf(stderr, "dvbinfo: Failed to attach BAT subdecoder\n");
             break;
         //0x4B to 0x4D reserved for future use
@@ -658,12 +1461,12 @@ static void handle_subtable(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_e
         case 0x6D:
         case 0x6E:
         case 0x6F:
-            if (!dvbpsi_eit_attach(p_dvbpsi, i_table_id, i_extension, handle_EIT, p_data))
+            if (!dvbpsi_eit_attach(p_dvbpsi, i_table_id, i_extension, profile_EIT, p_data))
                     fprintf(stderr, "dvbinfo: Failed to attach EIT subdecoder\n");
             break;
         case 0x70: /* TDT */
         case 0x73: /* TOT only */
-            if (!dvbpsi_tot_attach(p_dvbpsi, i_table_id, i_extension, handle_TOT, p_data))
+            if (!dvbpsi_tot_attach(p_dvbpsi, i_table_id, i_extension, profile_TOT, p_data))
                     fprintf(stderr, "dvbinfo: Failed to attach TOT subdecoder\n");
             break;
 #if 0
@@ -678,29 +1481,29 @@ static void handle_subtable(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_e
 #endif
         /* Handle ATSC PSI tables */
         case 0xC7: /* ATSC MGT */
-            if (!dvbpsi_atsc_AttachMGT(p_dvbpsi, i_table_id, i_extension, handle_atsc_MGT, p_data))
+            if (!dvbpsi_atsc_AttachMGT(p_dvbpsi, i_table_id, i_extension, profile_atsc_MGT, p_data))
                 fprintf(stderr, "dvbinfo: Failed to attach ATSC MGT subdecoder\n");
             break;
         case 0xC8:
         case 0xC9: /* ATSC VCT */
-            if (!dvbpsi_atsc_AttachVCT(p_dvbpsi, i_table_id, i_extension, handle_atsc_VCT, p_data))
+            if (!dvbpsi_atsc_AttachVCT(p_dvbpsi, i_table_id, i_extension, profile_atsc_VCT, p_data))
                     fprintf(stderr, "dvbinfo: Failed to attach ATSC VCT subdecoder\n");
             break;
         case 0xCB: /* ATSC EIT */
-            if (!dvbpsi_atsc_AttachEIT(p_dvbpsi, i_table_id, i_extension, handle_atsc_EIT, p_data))
+            if (!dvbpsi_atsc_AttachEIT(p_dvbpsi, i_table_id, i_extension, profile_atsc_EIT, p_data))
                     fprintf(stderr, "dvbinfo: Failed to attach ATSC EIT subdecoder\n");
             break;
         case 0xCC: /* ATSC ETT */
-            if (!dvbpsi_atsc_AttachETT(p_dvbpsi, i_table_id, i_extension, handle_atsc_ETT, p_data))
+            if (!dvbpsi_atsc_AttachETT(p_dvbpsi, i_table_id, i_extension, profile_atsc_ETT, p_data))
                     fprintf(stderr, "dvbinfo: Failed to attach ATSC ETT subdecoder\n");
             break;
         case 0xCD: /* ATSC STT */
-            if (!dvbpsi_atsc_AttachSTT(p_dvbpsi, i_table_id, i_extension, handle_atsc_STT, p_data))
+            if (!dvbpsi_atsc_AttachSTT(p_dvbpsi, i_table_id, i_extension, profile_atsc_STT, p_data))
                     fprintf(stderr, "dvbinfo: Failed to attach ATSC STT subdecoder\n");
             break;
 #ifdef TS_USE_SCTE_SIS
         case 0xFC:
-            if (!dvbpsi_sis_attach(p_dvbpsi, i_table_id, i_extension, handle_SIS, p_data))
+            if (!dvbpsi_sis_attach(p_dvbpsi, i_table_id, i_extension, profile_SIS, p_data))
                     fprintf(stderr, "dvbinfo: Failed to attach SIS subdecoder\n");
             break;
 #endif
@@ -723,9 +1526,9 @@ static void handle_PAT(void* p_data, dvbpsi_pat_t* p_pat)
     printf("\tTransport stream id : %d\n", p_pat->i_ts_id);
     printf("\tVersion number : %d\n", p_pat->i_version);
     printf("\tCurrent next   : %s\n", p_pat->b_current_next ? "yes" : "no");
-    if (p_stream->pat.pid->i_prev_received > 0)
+    if (p_stream->pat.i_prev_received > 0)
         printf("\tLast received  : %"PRId64" ms ago\n",
-               (mtime_t)(p_stream->pat.pid->i_received - p_stream->pat.pid->i_prev_received));
+               (mtime_t)(p_stream->hot[0x00].i_received - p_stream->pat.i_prev_received));
     printf("\t\t| program_number @ [NIT|PMT]_PID\n");
     while (p_program)
     {
@@ -741,13 +1544,20 @@ static void handle_PAT(void* p_data, dvbpsi_pat_t* p_pat)
                 free(p_pmt);
                 break;
             }
+            dvbpsi_set_shed_level(p_pmt->handle, p_stream->shed_level);
 
             p_pmt->i_number = p_program->i_number;
-            p_pmt->pid_pmt = &p_stream->pid[p_program->i_pid];
-            p_pmt->pid_pmt->i_pid = p_program->i_pid;
+            p_pmt->pid_pmt = ts_pid(p_stream, p_program->i_pid);
+            if (p_pmt->pid_pmt == NULL)
+            {
+                fprintf(stderr, "dvbinfo: Failed attach new PMT decoder\n");
+                dvbpsi_delete(p_pmt->handle);
+                free(p_pmt);
+                break;
+            }
             p_pmt->p_next = NULL;
 
-            if (!dvbpsi_pmt_attach(p_pmt->handle, p_program->i_number, handle_PMT, p_stream))
+            if (!dvbpsi_pmt_attach(p_pmt->handle, p_program->i_number, profile_PMT, p_stream))
             {
                  fprintf(stderr, "dvbinfo: Failed to attach new pmt decoder\n");
                  dvbpsi_delete(p_pmt->handle);
@@ -760,6 +1570,7 @@ static void handle_PAT(void* p_data, dvbpsi_pat_t* p_pat)
             p_stream->pmt = p_pmt;
             p_stream->i_pmt++;
             assert(p_stream->pmt);
+            ts_pid_wanted(p_stream, p_program->i_pid, 0x02, 0xff);
         }
         else
             fprintf(stderr, "dvbinfo: Failed create new PMT decoder\n");
@@ -1754,9 +2565,17 @@ static void DumpEITEventDescriptors(dvbpsi_eit_event_t *p_eit_event)
         printf("\t  | Event id: %d\n", p_event->i_event_id);
         if( p_event->b_nvod )
             printf("\t  | Start time: Unscheduled Near Video On Demand (NVOD) event\n");
+        else if (p_event->i_start_time == DVBPSI_MJD_UNDEFINED)
+            printf("\t  | Start time: undefined\n");
         else
-            printf("\t  | Start time: %"PRId64"\n", p_event->i_start_time);
-        printf("\t  | Duration: %d\n", p_event->i_duration);
+        {
+            int i_year, i_month, i_day;
+            uint32_t i_time = dvbpsi_bcd_to_seconds(p_event->i_start_time & 0xffffff);
+            dvbpsi_mjd_to_date(p_event->i_start_time >> 24, &i_year, &i_month, &i_day, NULL);
+            printf("\t  | Start time: %04d-%02d-%02d %02u:%02u:%02u UTC\n",
+                   i_year, i_month, i_day, i_time / 3600, i_time / 60 % 60, i_time % 60);
+        }
+        printf("\t  | Duration: %u s\n", dvbpsi_bcd_to_seconds(p_event->i_duration));
         printf("\t  | Running status: %d\n", p_event->i_running_status);
         printf("\t  | Free CA mode: %s\n", p_event->b_free_ca ? "yes" : "no");
         printf("\t  | Descriptor loop length: %d bytes\n", p_event->i_descriptors_length);
@@ -1867,10 +2686,17 @@ static void handle_atsc_MGT(void *p_data, dvbpsi_atsc_mgt_t *p_mgt)
                 free(p);
                 break;
             }
+            dvbpsi_set_shed_level(p->handle, p_stream->shed_level);
 
             p->i_table_pid = p_table->i_table_type_pid;
-            p->pid = &p_stream->pid[p_table->i_table_type_pid];
-            p->pid->i_pid = p_table->i_table_type_pid;
+            p->pid = ts_pid(p_stream, p_table->i_table_type_pid);
+            if (p->pid == NULL)
+            {
+                fprintf(stderr, "dvbinfo: Failed attach new ATSC EIT decoder\n");
+                dvbpsi_delete(p->handle);
+                free(p);
+                break;
+            }
             p->p_next = NULL;
 
             if (!dvbpsi_AttachDemux(p->handle, handle_subtable, p_stream))
@@ -1886,6 +2712,7 @@ static void handle_atsc_MGT(void *p_data, dvbpsi_atsc_mgt_t *p_mgt)
             p_stream->atsc_eit = p;
             p_stream->i_atsc_eit++;
             assert(p_stream->atsc_eit);
+            ts_pid_wanted(p_stream, p_table->i_table_type_pid, 0x00, 0x00);
         }
         else
             fprintf(stderr, "dvbinfo: Failed create new ATSC EIT decoder\n");
@@ -2178,8 +3005,9 @@ static void handle_PMT(void* p_data, dvbpsi_pmt_t* p_pmt)
     assert(p);
 
     p->i_pmt_version = p_pmt->i_version;
-    p->pid_pcr = &p_stream->pid[p_pmt->i_pcr_pid];
-    p_stream->pid[p_pmt->i_pcr_pid].b_pcr = true;
+    p->pid_pcr = ts_pid(p_stream, p_pmt->i_pcr_pid);
+    if (p->pid_pcr)
+        p->pid_pcr->b_pcr = true;
 
     printf("\n");
     printf("  PMT: Program Map Table\n");
@@ -2233,6 +3061,9 @@ ts_stream_t *libdvbpsi_init(int debug, ts_stream_log_cb pf_log, void *cb_data)
         stream->cb_data = cb_data;
     }
 
+    /* may fail, objects are then freed */
+    stream->pool = dvbpsi_pool_new(64);
+
     /* print PSI tables debug anyway, unless no debug is wanted at all */
     switch (debug)
     {
@@ -2242,11 +3073,15 @@ ts_stream_t *libdvbpsi_init(int debug, ts_stream_log_cb pf_log, void *cb_data)
         case 3: stream->level = DVBPSI_MSG_DEBUG; break;
     }
 
+    /* debug traces every packet unless told otherwise */
+    if (stream->level >= DVBPSI_MSG_DEBUG)
+        libdvbpsi_trace(stream, 1, false);
+
     /* PAT */
     stream->pat.handle = dvbpsi_new(&dvbpsi_message, stream->level);
     if (stream->pat.handle == NULL)
         goto error;
-    if (!dvbpsi_pat_attach(stream->pat.handle, handle_PAT, stream))
+    if (!dvbpsi_pat_attach(stream->pat.handle, profile_PAT, stream))
     {
         dvbpsi_delete(stream->pat.handle);
         stream->pat.handle = NULL;
@@ -2256,7 +3091,7 @@ ts_stream_t *libdvbpsi_init(int debug, ts_stream_log_cb pf_log, void *cb_data)
     stream->cat.handle = dvbpsi_new(&dvbpsi_message, stream->level);
     if (stream->cat.handle == NULL)
         goto error;
-    if (!dvbpsi_cat_attach(stream->cat.handle, handle_CAT, stream))
+    if (!dvbpsi_cat_attach(stream->cat.handle, profile_CAT, stream))
     {
         dvbpsi_delete(stream->cat.handle);
         stream->cat.handle = NULL;
@@ -2276,7 +3111,7 @@ ts_stream_t *libdvbpsi_init(int debug, ts_stream_log_cb pf_log, void *cb_data)
     stream->rst.handle = dvbpsi_new(&dvbpsi_message, stream->level);
     if (stream->rst.handle == NULL)
         goto error;
-    if (!dvbpsi_rst_attach(stream->rst.handle, handle_RST, stream))
+    if (!dvbpsi_rst_attach(stream->rst.handle, profile_RST, stream))
     {
         dvbpsi_delete(stream->rst.handle);
         stream->rst.handle = NULL;
@@ -2315,17 +3150,20 @@ ts_stream_t *libdvbpsi_init(int debug, ts_stream_log_cb pf_log, void *cb_data)
     }
 
     /* */
-    stream->pat.pid = &stream->pid[0x00];
-    stream->cat.pid = &stream->pid[0x01];
+    stream->pat.pid = ts_pid(stream, 0x00);
+    stream->cat.pid = ts_pid(stream, 0x01);
 #if 0
-    stream->tsdt.pid = &stream->pid[0x02];
-    stream->ipmp.pid = &stream->pid[0x03];
+    stream->tsdt.pid = ts_pid(stream, 0x02);
+    stream->ipmp.pid = ts_pid(stream, 0x03);
 #endif
-    stream->sdt.pid = &stream->pid[0x11];
-    stream->eit.pid = &stream->pid[0x12];
-    stream->rst.pid = &stream->pid[0x13];
-    stream->tdt.pid = &stream->pid[0x14];
-    stream->atsc.pid = &stream->pid[0x1FFB];
+    stream->sdt.pid = ts_pid(stream, 0x11);
+    stream->eit.pid = ts_pid(stream, 0x12);
+    stream->rst.pid = ts_pid(stream, 0x13);
+    stream->tdt.pid = ts_pid(stream, 0x14);
+    stream->atsc.pid = ts_pid(stream, 0x1FFB);
+    if (!stream->pat.pid || !stream->cat.pid || !stream->sdt.pid || !stream->eit.pid ||
+        !stream->rst.pid || !stream->tdt.pid || !stream->atsc.pid)
+        goto error;
     return stream;
 
 error:
@@ -2359,6 +3197,8 @@ error:
     if (stream->atsc.handle)
         dvbpsi_delete(stream->atsc.handle);
 
+    dvbpsi_pool_delete(stream->pool);
+    ts_pids_free(stream);
     free(stream);
 
     return NULL;
@@ -2367,6 +3207,10 @@ error:
 void libdvbpsi_exit(ts_stream_t *stream)
 {
    summary(stdout, stream);
+   summary_profile(stdout, stream);
+
+   /* leave any pool, the objects deleted now are freed */
+   dvbpsi_pool_t *previous = dvbpsi_pool_enter(NULL);
 
    if (dvbpsi_decoder_present(stream->pat.handle))
        dvbpsi_pat_detach(stream->pat.handle);
@@ -2435,33 +3279,106 @@ void libdvbpsi_exit(ts_stream_t *stream)
    if (stream->atsc.handle)
        dvbpsi_delete(stream->atsc.handle);
 
+   ts_pids_free(stream);
+   libdvbpsi_profile(stream, false);
+   free(stream->serializer.p_buffer);
+
+   dvbpsi_pool_enter(previous);
+   dvbpsi_pool_delete(stream->pool);
    free(stream);
    stream = NULL;
 }
 
-static ssize_t check_sync_word(uint8_t *buf, ssize_t length)
+/* Trace points of the packet loop, which cost a test of the countdown
+ * per packet when tracing is off and nothing with DVBINFO_NO_TRACE */
+#ifdef DVBINFO_NO_TRACE
+#   define ts_trace_sample(stream) false
+#   define ts_trace_events(stream) false
+#else
+static inline bool ts_trace_sample(ts_stream_t *stream)
 {
-    ssize_t i_lost = 0;
+    if (stream->i_trace_countdown == 0 || --stream->i_trace_countdown > 0)
+        return false;
+    stream->i_trace_countdown = stream->i_trace_every;
+    return true;
+}
+#   define ts_trace_events(stream) ((stream)->b_trace_events)
+#endif
 
-    for (i_lost = 0; i_lost < length; i_lost++)
+/* handle of the tables of a PID decoded from the start, NULL for the others */
+static dvbpsi_t *ts_fixed_handle(ts_stream_t *stream, uint16_t i_pid)
+{
+    switch (i_pid)
     {
-        if (buf[i_lost] == 0x47)
-            break;
+        case 0x00: return stream->pat.handle;   /* PAT */
+        case 0x01: return stream->cat.handle;   /* CAT */
+        case 0x02: return stream->tdt.handle;   /* Transport Stream Description Table */
+#if 0
+        case 0x03: return stream->ipmp.handle;  /* IPMP Control Information Table */
+#endif
+        case 0x11: return stream->sdt.handle;   /* SDT/BAT/NIT */
+        case 0x12: return stream->eit.handle;   /* EIT */
+        case 0x13: return stream->rst.handle;   /* RST */
+        case 0x14: return stream->tdt.handle;   /* TDT/TOT */
+        case 0x1FFB: return stream->atsc.handle; /* ATSC tables */
+        default:   return NULL;
     }
+}
 
-    if ((length - i_lost) < 188)
-        i_lost = length;
-
-    return i_lost;
+static ssize_t check_sync_word(uint8_t *buf, ssize_t length)
+{
+    return dvbpsi_sync_find(buf, length, DVBPSI_PACKET_TS);
 }
 
-bool libdvbpsi_process(ts_stream_t *stream, uint8_t *buf, ssize_t length, mtime_t date)
+/* The buffer arrived at i_arrival in us, once its last packet had. The
+ * others are spread back over the time they took at the transport rate,
+ * never before the last packet of the previous buffer. */
+static bool process_packets(ts_stream_t *stream, uint8_t *buf, ssize_t length,
+                            mtime_t i_arrival, bool b_carry)
 {
     mtime_t  i_prev_pcr = 0;  /* 33 bits */
     int      i_old_cc = -1;
 
+    ssize_t i_count = (length + 187) / 188;
+    if (i_count <= 0)
+        return true;
+
+    /* the rate of the arrivals till the PCR gives a steadier one */
+    if (!stream->b_pcr_rate && (stream->i_arrival > 0) && (i_arrival > stream->i_arrival))
+    {
+        double f_packet_us = (double)(i_arrival - stream->i_arrival) / i_count;
+        if (stream->f_packet_us > 0)
+            stream->f_packet_us += (f_packet_us - stream->f_packet_us) / 16.0;
+        else
+            stream->f_packet_us = f_packet_us;
+    }
+    mtime_t i_first = i_arrival - (mtime_t)((i_count - 1) * stream->f_packet_us);
+    if (i_first < stream->i_arrival)
+        i_first = stream->i_arrival;
+    if (i_first > i_arrival) /* clock stepped back */
+        i_first = i_arrival;
+    mtime_t i_span = i_arrival - i_first;
+    stream->i_arrival = i_arrival;
+
+    if (i_arrival / 1000 / BITRATE_TENTH != stream->i_date / BITRATE_TENTH)
+        ts_series_flush(stream);
+    stream->i_date = i_arrival / 1000;
+
     for (ssize_t i = 0; i < length; i += 188)
     {
+        mtime_t i_packet_arrival = (i_count > 1)
+                                 ? i_first + i_span * (i / 188) / (i_count - 1)
+                                 : i_arrival;
+        mtime_t date = i_packet_arrival / 1000; /* in ms */
+
+        /* partial packet in sync, completed by the next buffer */
+        if (b_carry && (length - i < 188) && (buf[i] == 0x47))
+        {
+            memcpy(stream->carry, buf + i, length - i);
+            stream->i_carry = length - i;
+            return true;
+        }
+
         /* check sync */
         ssize_t i_lost = check_sync_word(buf+i, length - i);
         if (i_lost > 0)
@@ -2482,47 +3399,30 @@ bool libdvbpsi_process(ts_stream_t *stream, uint8_t *buf, ssize_t length, mtime_
         uint16_t i_pid = ((uint16_t)(p_tmp[1] & 0x1f) << 8) + p_tmp[2];
         int      i_cc = (p_tmp[3] & 0x0f);
         bool     b_discontinuity_seen = false;
+        ts_pid_hot_t *hot = &stream->hot[i_pid];
 
         /* keep track nr of packets for this ES */
-        stream->pid[i_pid].i_packets++;
+        if ((++hot->i_packets == 0) && stream->pid[i_pid])
+            stream->pid[i_pid]->i_packets_wraps++;
         stream->i_packets++;
 
         /* received times */
-        stream->pid[i_pid].i_prev_received = stream->pid[i_pid].i_received;
-        stream->pid[i_pid].i_received = date;
-
-        if (stream->level < DVBPSI_MSG_DEBUG)
-            stream->pf_log(stream->cb_data, 3,
-                           "dvbinfo: %"PRId64" packet %"PRId64" pid %u (0x%x) cc %d\n",
-                           date, stream->i_packets, i_pid, i_pid, i_cc);
-
-        if (i_pid == 0x0) /* PAT */
-            dvbpsi_packet_push(stream->pat.handle, p_tmp);
-        else if (i_pid == 0x01) /* CAT */
-            dvbpsi_packet_push(stream->cat.handle, p_tmp);
-        else if (i_pid == 0x02) /* Transport Stream Description Table */
-            dvbpsi_packet_push(stream->tdt.handle, p_tmp);
-#if 0
-        else if (i_pid == 0x03) /* IPMP Control Information Table */
-            dvbpsi_packet_push(stream->ipmp.handle, p_tmp);
-#endif
-        else if (i_pid == 0x11) /* SDT/BAT/NIT */
-            dvbpsi_packet_push(stream->sdt.handle, p_tmp);
-        else if (i_pid == 0x12) /* EIT */
-            dvbpsi_packet_push(stream->eit.handle, p_tmp);
-        else if (i_pid == 0x13) /* RST */
-            dvbpsi_packet_push(stream->rst.handle, p_tmp);
-        else if (i_pid == 0x14) /* TDT/TOT */
-            dvbpsi_packet_push(stream->tdt.handle, p_tmp);
-        else if (i_pid == 0x1FFB) /* ATSC tables */
-            dvbpsi_packet_push(stream->atsc.handle, p_tmp);
+        if (i_pid == 0x0)
+            stream->pat.i_prev_received = hot->i_received;
+        hot->i_received = date;
+
+        bool b_event = false;   /* traced as well with b_trace_events */
+
+        dvbpsi_t *handle = ts_fixed_handle(stream, i_pid);
+        if (handle)
+            ts_push(stream, handle, p_tmp, i_pid, date);
         else
         {
             ts_pmt_t *p = stream->pmt;
             while(p)
             {
                 if (p->pid_pmt->i_pid == i_pid)
-                    dvbpsi_packet_push(p->handle, p_tmp);
+                    ts_push(stream, p->handle, p_tmp, i_pid, date);
                 p = p->p_next;
             }
 
@@ -2530,31 +3430,30 @@ bool libdvbpsi_process(ts_stream_t *stream, uint8_t *buf, ssize_t length, mtime_
             while (p_atsc_eit)
             {
                 if (p_atsc_eit->pid->i_pid == i_pid)
-                    dvbpsi_packet_push(p_atsc_eit->handle, p_tmp);
+                    ts_push(stream, p_atsc_eit->handle, p_tmp, i_pid, date);
                 p_atsc_eit = p_atsc_eit->p_next;
             }
         }
 
         /* Remember PID */
-        if (!stream->pid[i_pid].b_seen)
+        if (!hot->b_seen)
         {
-            stream->pid[i_pid].i_pid = i_pid;
-            stream->pid[i_pid].b_seen = true;
+            hot->b_seen = true;
+            ts_pid_seen(stream, i_pid);
             i_old_cc = i_cc;
-            stream->pid[i_pid].i_cc = i_cc;
         }
         else
         {
             /* Check continuity counter */
             int i_diff = 0;
 
-            i_diff = i_cc - (stream->pid[i_pid].i_cc+1)%16;
+            i_diff = i_cc - ((hot->i_control & 0x0f)+1)%16;
             b_discontinuity_seen = (i_diff != 0);
 
-            /* Update CC */
-            i_old_cc = stream->pid[i_pid].i_cc;
-            stream->pid[i_pid].i_cc = i_cc;
+            i_old_cc = hot->i_control & 0x0f;
         }
+        /* Update CC */
+        hot->i_control = (hot->i_control & 0xf0) | i_cc;
 
         if (i_pid == 0x1FFF)
         {
@@ -2564,48 +3463,51 @@ bool libdvbpsi_process(ts_stream_t *stream, uint8_t *buf, ssize_t length, mtime_
         }
 
         /* */
-        stream->pid[i_pid].b_transport_error_indicator = ((p_tmp[1] & 0x80) == 0x80);
-        stream->pid[i_pid].b_payload_unit_start_indicator = ((p_tmp[1] & 0x40) == 0x40);
-        stream->pid[i_pid].b_transport_priority = ((p_tmp[1] & 0x20) == 0x20);
-        stream->pid[i_pid].i_transport_scrambling_control = ((p_tmp[3] & 0xC0) >> 6);
-        stream->pid[i_pid].b_adaptation_field = (p_tmp[3] & 0x20);
+        hot->i_flags = p_tmp[1] & TS_HOT_FLAGS;
+        hot->i_control = p_tmp[3];
 
         /* Handle discontinuities if they occurred,
          * according to ISO/IEC 13818-1: DIS pages 20-22 */
-        if (stream->pid[i_pid].b_adaptation_field && (p_tmp[4] > 0))
+        ts_pid_t *ts = stream->pid[i_pid];
+        dvbpsi_adaptation_t af;
+        if (ts && dvbpsi_adaptation_parse(p_tmp, &af) && af.i_length > 0)
         {
-            bool b_pcr  = (p_tmp[5]&0x10) == 0x10;  /* PCR flag */
-            bool b_opcr = (p_tmp[5]&0x08) == 0x08;  /* OPCR flag */
-
-            stream->pid[i_pid].b_discontinuity_indicator = (p_tmp[5]&0x80) == 0x80;
-            stream->pid[i_pid].b_random_access_indicator = (p_tmp[5]&0x40) == 0x40;
-            stream->pid[i_pid].b_elementary_stream_priority_indicator = (p_tmp[5]&0x20) == 0x20;
-            stream->pid[i_pid].b_splicing_point = (p_tmp[5]&0x04) == 0x04;
-            stream->pid[i_pid].b_transport_private_data = (p_tmp[5]&0x02) == 0x02;
-            stream->pid[i_pid].b_adaptation_field_extension = (p_tmp[5]&0x01) == 0x01;
-
-            uint32_t i_ext = 5;
-
-            if (b_pcr) i_ext += 6;
+            ts->b_discontinuity_indicator = af.i_flags & DVBPSI_AF_DISCONTINUITY;
+            ts->b_random_access_indicator = af.i_flags & DVBPSI_AF_RANDOM_ACCESS;
+            ts->b_elementary_stream_priority_indicator = af.i_flags & DVBPSI_AF_ES_PRIORITY;
+            ts->b_opcr = af.i_flags & DVBPSI_AF_OPCR;
+            ts->b_splicing_point = af.i_flags & DVBPSI_AF_SPLICING_POINT;
+            ts->b_transport_private_data = af.i_flags & DVBPSI_AF_PRIVATE_DATA;
+            ts->b_adaptation_field_extension = af.i_flags & DVBPSI_AF_EXTENSION;
 
             /* PCR */
-            if (b_pcr && (p_tmp[4] >= 7))
+            if (af.i_flags & DVBPSI_AF_PCR)
             {
-                mtime_t i_pcr;  /* 33 bits */
-
-                i_pcr = (( (mtime_t)p_tmp[6] << 25 ) |
-                         ( (mtime_t)p_tmp[7] << 17 ) |
-                         ( (mtime_t)p_tmp[8] << 9 ) |
-                         ( (mtime_t)p_tmp[9] << 1 ) |
-                         ( (mtime_t)(p_tmp[10]&0x80) >> 7 ));
-                i_pcr = i_pcr * 100 / 9;
-                i_prev_pcr = stream->pid[i_pid].i_pcr;
-                stream->pid[i_pid].i_pcr = i_pcr;
-
-                if (stream->pid[i_pid].i_first_pcr == 0)
-                    stream->pid[i_pid].i_first_pcr = i_pcr;
-                if (i_pcr < stream->pid[i_pid].i_last_pcr)
+                /* 27 MHz with the extension, kept by the analysis */
+                if (!ts->pcr)
+                    ts->pcr = calloc(1, sizeof(ts_pcr_t));
+                if (ts->pcr)
                 {
+                    pcr_account(ts->pcr, af.i_pcr, ts->b_discontinuity_indicator,
+                                stream->i_packets, i_packet_arrival);
+                    /* the transport rate for the packets to come */
+                    if (ts->pcr->i_packets > 0)
+                    {
+                        stream->f_packet_us = (double)ts->pcr->i_ticks / 27.0 /
+                                              ts->pcr->i_packets;
+                        stream->b_pcr_rate = true;
+                    }
+                }
+
+                mtime_t i_pcr = (mtime_t)(af.i_pcr / 300) * 100 / 9;
+                i_prev_pcr = ts->i_pcr;
+                ts->i_pcr = i_pcr;
+
+                if (ts->i_first_pcr == 0)
+                    ts->i_first_pcr = i_pcr;
+                if (i_pcr < ts->i_last_pcr)
+                {
+                    b_event = true;
                     if (b_discontinuity_seen)
                         stream->pf_log(stream->cb_data, 2,
                                        "dvbinfo: Warning wrapping PCR on discontinuity\n");
@@ -2613,11 +3515,12 @@ bool libdvbpsi_process(ts_stream_t *stream, uint8_t *buf, ssize_t length, mtime_
                         stream->pf_log(stream->cb_data, 2,
                                        "dvbinfo: Warning wrapping PCR\n");
                 }
-                stream->pid[i_pid].i_prev_pcr = i_prev_pcr;
-                stream->pid[i_pid].i_last_pcr = i_pcr;
+                ts->i_prev_pcr = i_prev_pcr;
+                ts->i_last_pcr = i_pcr;
 
-                if (stream->pid[i_pid].b_discontinuity_indicator)
+                if (ts->b_discontinuity_indicator)
                 {
+                    b_event = true;
                     /* cc discontinuity is expected */
                     stream->pf_log(stream->cb_data, 2,
                                    "dvbinfo: Server signalled the continuity counter discontinuity\n");
@@ -2627,89 +3530,376 @@ bool libdvbpsi_process(ts_stream_t *stream, uint8_t *buf, ssize_t length, mtime_
                 }
             }
 
-            if (b_opcr) i_ext += 6;
-
-            if (stream->pid[i_pid].b_splicing_point)
-            {
-                i_ext++;
-                /* calculate tcimsbf */
-                stream->pid[i_pid].i_splice_countdown = ((p_tmp[i_ext] & 0x80) == 0x80) ?
-                                        -1 * (p_tmp[i_ext] & 0x7f) : (p_tmp[i_ext] & 0x7f);
-            }
-
-            if (stream->pid[i_pid].b_transport_private_data)
-            {
-                i_ext++;
-                stream->pid[i_pid].i_transport_private_data_length = p_tmp[i_ext];
-                i_ext += stream->pid[i_pid].i_transport_private_data_length;
-            }
+            if (ts->b_splicing_point)
+                ts->i_splice_countdown = af.i_splice_countdown;
+            if (ts->b_transport_private_data)
+                ts->i_transport_private_data_length = af.i_private_length;
 
-            if (stream->pid[i_pid].b_adaptation_field_extension)
+            /* adaptation_extension field */
+            if (ts->b_adaptation_field_extension)
             {
-                /* i_ext is start of adaptation_extension field */
-                i_ext++;
-                uint8_t *p_ext = &p_tmp[i_ext];
-                uint32_t i_seamless_splice = i_ext;
-
-                stream->pid[i_pid].i_adaptation_field_extension_length = p_ext[0];
-
-                if (stream->pid[i_pid].i_adaptation_field_extension_length > 0)
+                ts->i_adaptation_field_extension_length = af.i_extension_length;
+                ts->b_ltw = af.i_extension_flags & DVBPSI_AF_LTW;
+                ts->b_piecewise_rate = af.i_extension_flags & DVBPSI_AF_PIECEWISE_RATE;
+                ts->b_seamless_splice = af.i_extension_flags & DVBPSI_AF_SEAMLESS_SPLICE;
+                if (ts->b_ltw)
                 {
-                    stream->pid[i_pid].b_ltw = (p_ext[1]&0x80) == 0x80;
-                    stream->pid[i_pid].b_piecewise_rate = (p_ext[1]&0x40) == 0x40;
-                    stream->pid[i_pid].b_seamless_splice = (p_ext[1]&0x20) == 0x20;
-
-                    if (stream->pid[i_pid].b_ltw)
-                    {
-                        stream->pid[i_pid].b_ltw_valid = ((p_ext[2]&0x80) == 0x80);
-                        stream->pid[i_pid].i_ltw_offset = ((uint16_t)p_ext[2]&0x7F);
-                        i_seamless_splice += 2;
-                    }
-
-                    if (stream->pid[i_pid].b_piecewise_rate)
-                    {
-                        stream->pid[i_pid].i_piecewise_rate =
-                          (((uint32_t)p_ext[i_seamless_splice] & 0x3F) << 16) |
-                          (((uint32_t)p_ext[i_seamless_splice + 1]) << 8) |
-                           ((uint32_t)p_ext[i_seamless_splice + 2]);
-                        i_seamless_splice += 3;
-                    }
-
-                    if (stream->pid[i_pid].b_seamless_splice)
-                    {
-                        stream->pid[i_pid].i_splice_type =
-                            (p_tmp[i_seamless_splice]&0xF0);
-                    }
+                    ts->b_ltw_valid = af.b_ltw_valid;
+                    ts->i_ltw_offset = af.i_ltw_offset;
                 }
-            } /* end of adaptation_extension_field */
+                if (ts->b_piecewise_rate)
+                    ts->i_piecewise_rate = af.i_piecewise_rate;
+                if (ts->b_seamless_splice)
+                    ts->i_splice_type = af.i_splice_type;
+            }
         }
 
         if (b_discontinuity_seen)
         {
+            b_event = true;
+            stream->i_cc_errors++;
+            if (ts)
+                ts->i_cc_errors++;
             stream->pf_log(stream->cb_data, 2,
                            "dvbinfo: Continuity counter discontinuity (pid %u 0x%x found %d expected %d)\n",
-                           i_pid, i_pid, stream->pid[i_pid].i_cc, i_old_cc+1);
+                           i_pid, i_pid, i_cc, i_old_cc+1);
 
             /* Discontinuity has been handled */
             b_discontinuity_seen = false;
         }
 
 dump_packet:
-        if (stream->level >= DVBPSI_MSG_DEBUG)
-        {
+        if (ts_trace_sample(stream) || (b_event && ts_trace_events(stream)))
             ts_dump_packet_details(stdout, stream, &buf[i], i_pid);
-        }
     }
 
     return true;
 }
 
+void libdvbpsi_pids(ts_stream_t *stream, ts_pid_cb pf_pid, void *data)
+{
+    /* the tables of the handles decoding from the start */
+    static const struct
+    {
+        uint16_t i_pid;
+        uint8_t  i_table_id;
+        uint8_t  i_mask;
+    } fixed[] =
+    {
+        { 0x00,   0x00, 0xff },     /* PAT */
+        { 0x01,   0x01, 0xff },     /* CAT */
+        { 0x11,   0x42, 0xf7 },     /* SDT actual and BAT */
+        { 0x12,   0x40, 0xe0 },     /* EIT present/following, schedule actual */
+        { 0x12,   0x60, 0xf0 },     /* EIT schedule other */
+        { 0x13,   0x71, 0xff },     /* RST */
+        { 0x14,   0x70, 0xfc },     /* TDT and TOT */
+        { 0x1FFB, 0xc0, 0xf0 },     /* ATSC MGT, VCT and STT */
+    };
+
+    stream->pf_pid = pf_pid;
+    stream->pid_data = data;
+    if (pf_pid == NULL)
+        return;
+
+    for (size_t i = 0; i < ARRAY_SIZE(fixed); i++)
+        pf_pid(data, fixed[i].i_pid, fixed[i].i_table_id, fixed[i].i_mask);
+    for (ts_pmt_t *p = stream->pmt; p; p = p->p_next)
+        pf_pid(data, p->pid_pmt->i_pid, 0x02, 0xff);
+    for (ts_atsc_eit_t *p = stream->atsc_eit; p; p = p->p_next)
+        pf_pid(data, p->pid->i_pid, 0x00, 0x00);
+}
+
+void libdvbpsi_trace(ts_stream_t *stream, int i_every, bool b_events)
+{
+    if (i_every >= 0)
+    {
+        stream->i_trace_every = i_every;
+        stream->i_trace_countdown = i_every;
+    }
+    stream->b_trace_events = b_events;
+}
+
+void libdvbpsi_shed(ts_stream_t *stream, unsigned int i_backlog)
+{
+    dvbpsi_shed_level_t level = dvbpsi_shed_level_update(stream->shed_level, i_backlog);
+    if (level == stream->shed_level)
+        return;
+
+    stream->pf_log(stream->cb_data, 1,
+                   "dvbinfo: %u%% backlog, shed level %d\n", i_backlog, level);
+    stream->shed_level = level;
+    stream->i_shed_changes++;
+    ts_handles(stream, shed_set, &level);
+}
+
+bool libdvbpsi_json(ts_stream_t *stream, FILE *fd)
+{
+    if (!stream->serializer.pf_grow)
+        dvbpsi_serializer_init(&stream->serializer, DVBPSI_SERIALIZER_JSON,
+                               NULL, 0, json_grow, NULL);
+    stream->json = fd;
+    return true;
+}
+
+/* Tables of up to 32 KiB, only the pages of the slots in use being
+ * touched */
+#define PUBLISH_SLOTS       2048
+#define PUBLISH_TABLE_SIZE  (32 * 1024)
+
+size_t libdvbpsi_publish_size(void)
+{
+    return dvbpsi_shm_size(PUBLISH_SLOTS, PUBLISH_TABLE_SIZE);
+}
+
+bool libdvbpsi_publish(ts_stream_t *stream, void *p_region)
+{
+    stream->shm = NULL;
+    if (p_region)
+        stream->shm = dvbpsi_shm_init(p_region, PUBLISH_SLOTS, PUBLISH_TABLE_SIZE);
+    return stream->shm || !p_region;
+}
+
+bool libdvbpsi_profile(ts_stream_t *stream, bool b_enable)
+{
+    if (b_enable && !stream->profile)
+    {
+        stream->profile = calloc(1, sizeof(ts_profile_t));
+        if (!stream->profile)
+            return false;
+        memset(stream->profile->table_id, 0xff, sizeof(stream->profile->table_id));
+    }
+    else if (!b_enable && stream->profile)
+    {
+        for (int i_pid = 0; i_pid < 8192; i_pid++)
+        {
+            ts_profile_entry_t *entry = stream->profile->entries[i_pid];
+            while (entry)
+            {
+                ts_profile_entry_t *p_next = entry->p_next;
+                free(entry);
+                entry = p_next;
+            }
+        }
+        free(stream->profile);
+        stream->profile = NULL;
+    }
+    return true;
+}
+
+bool libdvbpsi_process(ts_stream_t *stream, uint8_t *buf, ssize_t length, mtime_t date)
+{
+    dvbpsi_pool_t *previous = dvbpsi_pool_enter(stream->pool);
+    bool b_ok = true;
+
+    /* complete the packet the last buffer ended with */
+    if (stream->i_carry > 0)
+    {
+        ssize_t i_need = 188 - stream->i_carry;
+        if (length < i_need)
+        {
+            memcpy(stream->carry + stream->i_carry, buf, length);
+            stream->i_carry += length;
+            dvbpsi_pool_enter(previous);
+            return true;
+        }
+
+        /* unless the buffer does not follow it in sync */
+        if ((length == i_need) || (buf[i_need] == 0x47))
+        {
+            memcpy(stream->carry + stream->i_carry, buf, i_need);
+            b_ok = process_packets(stream, stream->carry, 188, date, false);
+            buf += i_need;
+            length -= i_need;
+        }
+        else
+            stream->i_lost_bytes += stream->i_carry;
+        stream->i_carry = 0;
+    }
+
+    if (!process_packets(stream, buf, length, date, true))
+        b_ok = false;
+    dvbpsi_pool_enter(previous);
+    return b_ok;
+}
+
+bool libdvbpsi_process_section(ts_stream_t *stream, uint16_t i_pid, uint8_t *buf,
+                               ssize_t length, mtime_t date)
+{
+    if ((i_pid >= 8192) || (length < 3))
+        return false;
+
+    dvbpsi_pool_t *previous = dvbpsi_pool_enter(stream->pool);
+    mtime_t i_date = date / 1000; /* in ms */
+    ts_pid_hot_t *hot = &stream->hot[i_pid];
+    bool b_ok = true;
+
+    if (i_date / BITRATE_TENTH != stream->i_date / BITRATE_TENTH)
+        ts_series_flush(stream);
+    stream->i_date = i_date;
+    stream->i_arrival = date;
+
+    if (i_pid == 0x0)
+        stream->pat.i_prev_received = hot->i_received;
+    hot->i_received = i_date;
+    if (!hot->b_seen)
+    {
+        hot->b_seen = true;
+        ts_pid_seen(stream, i_pid);
+    }
+
+    /* the handles the packets of the PID would be pushed into */
+    dvbpsi_t *handle = ts_fixed_handle(stream, i_pid);
+    if (handle)
+        b_ok = dvbpsi_section_push_at(handle, buf, length, i_date);
+    else
+    {
+        for (ts_pmt_t *p = stream->pmt; p; p = p->p_next)
+            if ((p->pid_pmt->i_pid == i_pid) &&
+                !dvbpsi_section_push_at(p->handle, buf, length, i_date))
+                b_ok = false;
+        for (ts_atsc_eit_t *p = stream->atsc_eit; p; p = p->p_next)
+            if ((p->pid->i_pid == i_pid) &&
+                !dvbpsi_section_push_at(p->handle, buf, length, i_date))
+                b_ok = false;
+    }
+
+    dvbpsi_pool_enter(previous);
+    return b_ok;
+}
+
+/* Length of the RTP header of a datagram, or 0 when it does not start with
+ * one followed by a TS packet */
+static ssize_t rtp_header_length(const uint8_t *buf, ssize_t length)
+{
+    if ((length < 12) || (buf[0] == 0x47) || ((buf[0] & 0xc0) != 0x80))
+        return 0;
+
+    ssize_t i_header = 12 + 4 * (buf[0] & 0x0f); /* CSRC list */
+    if (buf[0] & 0x10) /* extension */
+    {
+        if (i_header + 4 > length)
+            return 0;
+        i_header += 4 + 4 * ((buf[i_header + 2] << 8) | buf[i_header + 3]);
+    }
+    if ((i_header >= length) || (buf[i_header] != 0x47))
+        return 0;
+    return i_header;
+}
+
+static void rtp_account(ts_rtp_t *rtp, const uint8_t *buf, mtime_t date)
+{
+    uint16_t i_seq = (buf[2] << 8) | buf[3];
+    uint32_t i_timestamp = ((uint32_t)buf[4] << 24) | (buf[5] << 16) | (buf[6] << 8) | buf[7];
+
+    rtp->i_datagrams++;
+    if (rtp->b_seen)
+    {
+        uint16_t i_gap = i_seq - (uint16_t)(rtp->i_seq + 1);
+        if (i_gap >= 0x8000) /* behind the last one */
+        {
+            rtp->i_reordered++;
+            return;
+        }
+        rtp->i_lost += i_gap;
+
+        /* RFC 3550 6.4.1, the arrival time converted to the 90 kHz clock */
+        double f_transit = (double)(date - rtp->i_arrival) * 0.09 -
+                           (double)(int32_t)(i_timestamp - rtp->i_timestamp);
+        if (f_transit < 0)
+            f_transit = -f_transit;
+        rtp->f_jitter += (f_transit - rtp->f_jitter) / 16.0;
+    }
+    rtp->b_seen = true;
+    rtp->i_seq = i_seq;
+    rtp->i_timestamp = i_timestamp;
+    rtp->i_arrival = date;
+}
+
+bool libdvbpsi_process_datagram(ts_stream_t *stream, uint8_t *buf, ssize_t length, mtime_t date)
+{
+    ssize_t i_header = rtp_header_length(buf, length);
+    if (i_header > 0)
+    {
+        rtp_account(&stream->rtp, buf, date);
+        buf += i_header;
+        length -= i_header;
+    }
+
+    /* whole packets, a datagram never continues the previous one */
+    dvbpsi_pool_t *previous = dvbpsi_pool_enter(stream->pool);
+    bool b_ok = process_packets(stream, buf, length, date, false);
+    dvbpsi_pool_enter(previous);
+    return b_ok;
+}
+
+unsigned int libdvbpsi_bitrate(ts_stream_t *stream, uint16_t i_pid, mtime_t i_resolution,
+                               mtime_t date, double *p_bitrate, unsigned int i_count)
+{
+    series_t *series = NULL;
+
+    if (i_pid < 8192)
+    {
+        ts_series_flush(stream);
+        if (!stream->pid[i_pid])
+            series = NULL;
+        else if (i_resolution == BITRATE_SECOND)
+            series = stream->pid[i_pid]->second;
+        else if (i_resolution == BITRATE_TENTH)
+            series = stream->pid[i_pid]->tenth;
+    }
+    if (!series)
+    {
+        memset(p_bitrate, 0, i_count * sizeof(double));
+        return 0;
+    }
+    if (i_count > BITRATE_SPAN / i_resolution)
+    {
+        memset(p_bitrate, 0, i_count * sizeof(double));
+        p_bitrate += i_count - BITRATE_SPAN / i_resolution;
+        i_count = BITRATE_SPAN / i_resolution;
+    }
+    return series_bitrate(series, date, p_bitrate, i_count);
+}
+
+#ifdef HAVE_SHM_OPEN
+void libdvbpsi_stats(ts_stream_t *stream, stats_t *stats)
+{
+    stats_begin(stats);
+    stats->i_date = stream->i_date;
+    stats->i_updates++;
+    stats->i_packets = stream->i_packets;
+    stats->i_null_packets = stream->i_null_packets;
+    stats->i_lost_bytes = stream->i_lost_bytes;
+    stats->i_cc_errors = stream->i_cc_errors;
+    stats->i_rtp_datagrams = stream->rtp.i_datagrams;
+    stats->i_rtp_lost = stream->rtp.i_lost;
+    stats->i_rtp_reordered = stream->rtp.i_reordered;
+
+    /* only the PIDs seen, nothing else is walked */
+    for (int i = 0; i < stream->i_seen; i++)
+    {
+        uint16_t i_pid = stream->seen[i];
+        stats_pid_t *entry = &stats->pid[i];
+
+        entry->i_pid = i_pid;
+        entry->b_scrambled = (stream->hot[i_pid].i_control & 0xC0) != 0;
+        entry->i_packets = ts_packets(stream, i_pid);
+        entry->i_cc_errors = stream->pid[i_pid]->i_cc_errors;
+        entry->i_received = stream->hot[i_pid].i_received;
+    }
+    stats->i_pids = stream->i_seen;
+    stats->i_shed_level = stream->shed_level;
+    stats_end(stats);
+}
+#endif
+
 void libdvbpsi_summary(FILE *fd, ts_stream_t *stream, const int summary_mode)
 {
     switch(summary_mode)
     {
         case SUM_TABLE:
             summary_table(fd, stream);
+            summary_profile(fd, stream);
             break;
         case SUM_PACKET:
             summary_packet(fd, stream);
@@ -2724,4 +3914,5 @@ void libdvbpsi_summary(FILE *fd, ts_stream_t *stream, const int summary_mode)
             summary(fd, stream);
             break;
     }
+    summary_rtp(fd, stream);
 }
@@ -27,7 +27,12 @@
 
 /* Date and time */
 typedef int64_t mtime_t;
+/* mdate() - wall clock time in ms
+ * udate() - wall clock time in us, the clock of the kernel receive
+ *           timestamps, read without a system call where the C library
+ *           has a vDSO clock_gettime() */
 mtime_t mdate(void);
+mtime_t udate(void);
 
 /* Summary */
 #define SUM_BANDWIDTH 0
@@ -35,14 +40,73 @@ mtime_t mdate(void);
 #define SUM_PACKET    2
 #define SUM_WIRE      3
 
+/* Bitrate time series of each PID, in ms */
+#define BITRATE_SPAN    (3600 * 1000)   /* the last hour */
+#define BITRATE_SECOND  1000
+#define BITRATE_TENTH   100
+
 /* MPEG-TS PSI decoders */
 typedef struct ts_stream_t ts_stream_t;
 typedef void (* ts_stream_log_cb)(void *data, const int level, const char *msg, ...);
 
 /* */
 ts_stream_t *libdvbpsi_init(int debug, ts_stream_log_cb pf_log, void *cb_data);
+/* trace one packet in i_every, 0 for none, -1 to keep the current rate,
+ * and with b_events the packets with a continuity error, a
+ * discontinuity_indicator or a PCR going back. Traced packets are dumped
+ * to stdout. libdvbpsi_init() sets 1 at the debug level and 0
+ * otherwise. The trace points are compiled out with DVBINFO_NO_TRACE. */
+void libdvbpsi_trace(ts_stream_t *stream, int i_every, bool b_events);
+/* with b_enable, times the decoding of the packets and the table handlers
+ * per PID and table_id, and ranks them by CPU time in the table summary
+ * and at exit. Profiling again keeps the counts, disabling frees them.
+ * Returns false out of memory. */
+bool libdvbpsi_profile(ts_stream_t *stream, bool b_enable);
+/* writes each table decoded to fd as a line of JSON, see serialize.h,
+ * before its handler prints it, NULL to stop. */
+bool libdvbpsi_json(ts_stream_t *stream, FILE *fd);
+/* publishes the PAT, CAT, PMT, NIT, SDT, BAT, EIT and TDT/TOT decoded into
+ * the shared memory of libdvbpsi_publish_size() bytes at p_region, see
+ * shm.h, before their handler prints them, NULL to stop. */
+size_t libdvbpsi_publish_size(void);
+bool libdvbpsi_publish(ts_stream_t *stream, void *p_region);
+/* sheds the sections of the lower priority tables of all the handles while
+ * i_backlog, the fill of the capture queue in percent, is high, see
+ * dvbpsi_shed_level_update(). The decoders of the sheddable tables see no
+ * section then, and catch up once the backlog is gone. */
+void libdvbpsi_shed(ts_stream_t *stream, unsigned int i_backlog);
+/* packets of a byte stream, a buffer may end and the next one start in the
+ * middle of a packet. date is the arrival of the buffer in us, that of its
+ * packets being spread back from it at the transport rate, which the PCR
+ * gives once it is known and the arrivals of the buffers before. */
 bool libdvbpsi_process(ts_stream_t *stream, uint8_t *buf, ssize_t length, mtime_t date);
+/* the same for one udp datagram, skipping and accounting an RTP header */
+bool libdvbpsi_process_datagram(ts_stream_t *stream, uint8_t *buf, ssize_t length, mtime_t date);
+/* a complete section of PID i_pid, read from a section filter, pushed into
+ * the handles its packets would be. date is its arrival in us. The
+ * sections are not profiled. */
+bool libdvbpsi_process_section(ts_stream_t *stream, uint16_t i_pid, uint8_t *buf,
+                               ssize_t length, mtime_t date);
+/* calls pf_pid with each PID the stream decodes tables from and a table_id
+ * and mask those tables match, (table_id & i_mask) == i_table_id, for a
+ * capture to filter them, see dvbdev.h: the PIDs decoded from the start and
+ * those found so far at once, then the PMT PIDs and the ATSC EIT and ETT
+ * PIDs as the PAT and the MGT give them, again for each new version. A PID
+ * may come with several table_id, NULL stops. */
+typedef void (* ts_pid_cb)(void *data, uint16_t i_pid, uint8_t i_table_id, uint8_t i_mask);
+void libdvbpsi_pids(ts_stream_t *stream, ts_pid_cb pf_pid, void *data);
 void libdvbpsi_summary(FILE *fd, ts_stream_t *stream, const int summary_mode);
+#ifdef HAVE_SHM_OPEN
+/* update the live statistics, see stats.h */
+struct stats_s;
+void libdvbpsi_stats(ts_stream_t *stream, struct stats_s *stats);
+#endif
+/* bitrates in bit/s of PID i_pid over the i_count buckets of i_resolution,
+ * BITRATE_SECOND or BITRATE_TENTH, up to date, oldest first. Returns how many
+ * of the last ones are from the first packet of the PID on, the others and
+ * all of them for an unknown resolution or PID being 0 */
+unsigned int libdvbpsi_bitrate(ts_stream_t *stream, uint16_t i_pid, mtime_t i_resolution,
+                               mtime_t date, double *p_bitrate, unsigned int i_count);
 void libdvbpsi_exit(ts_stream_t *stream);
 
 #endif
@@ -0,0 +1,843 @@
+/*****************************************************************************
+ * multi.c: multi-input monitoring
+ *****************************************************************************
+ * Copyright (C) 2011 M2X BV
+ *
+ * Authors: Jean-Paul Saman <jpsaman@videolan.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <poll.h>
+
+#if defined(HAVE_INTTYPES_H)
+#   include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#   include <stdint.h>
+#endif
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <assert.h>
+
+#include "dvbinfo.h"
+#include "libdvbpsi.h"
+#include "buffer.h"
+#include "input.h"
+#include "udp.h"
+#include "multi.h"
+
+#define MULTI_CAPTURE_SIZE  UDP_DATAGRAM_MAX /* bytes per buffer, a datagram
+                                                or a file or tcp read */
+#define MULTI_POLL_TIMEOUT  100     /* ms */
+#define MULTI_STEER_EVERY   256     /* buffers between two checks of the
+                                       receiving cpu of a source */
+
+typedef struct multi_s multi_t;
+typedef struct group_s group_t;
+
+/* Source of the list, processed by worker p_worker */
+typedef struct source_s
+{
+    char        *psz_name;
+    input_t     *input;   /* NULL when received through p_group */
+    group_t     *p_group;
+#ifdef UDP_GROUPS
+    struct sockaddr_storage group;  /* destination of its datagrams */
+    struct sockaddr_storage sender; /* source of a (S,G), AF_UNSPEC otherwise */
+#endif
+    bool         b_eof;
+    uint64_t     i_dropped; /* buffers lost as the worker was behind */
+
+    ts_stream_t *stream;
+    struct worker_s *p_worker;
+
+    /* steering to the worker of the cpu receiving the source */
+    int          i_cpu;     /* cpu=<n> of the list, -1 for none */
+    bool         b_steer;   /* moved after the receiving cpu */
+    uint64_t     i_buffers; /* buffers captured */
+    uint64_t     i_pending; /* buffers pushed, not processed yet */
+    struct worker_s *p_next; /* worker to move to once none is pending */
+    uint64_t     i_moves;
+} source_t;
+
+/* Socket of the multicast sources of the same interface, family and port,
+ * its datagrams going to their source by destination address */
+struct group_s
+{
+    char         *psz_iface;
+    int           family;
+    int           port;
+    int           fd;
+    buffer_t     *buffer;   /* batch of datagrams read */
+    source_t    **sources;
+    int           i_sources;
+    int           i_last;   /* source of the last datagram */
+    uint64_t      i_unknown; /* datagrams of no source */
+};
+
+/* Worker thread with its rings, the capture loop being the only producer
+ * of fifo and the worker the only one of empty */
+typedef struct worker_s
+{
+    multi_t   *multi;
+    pthread_t  handle;
+    ring_t    *fifo;  /* captured buffers, from any of its sources */
+    ring_t    *empty; /* buffers to reuse */
+    buffer_t  *p_spare; /* buffer left unused by the capture loop */
+    int        i_cpu;   /* cpu it is pinned to, -1 for none */
+
+    /* held while processing a buffer, for the summary */
+    pthread_mutex_t lock;
+} worker_t;
+
+struct multi_s
+{
+    params_t  *param;
+
+    source_t  *sources;
+    int        i_sources;
+
+    group_t   *groups;
+    int        i_groups;
+
+    worker_t  *workers;
+    int        i_workers;
+};
+
+/* Sources */
+static bool source_parse(source_t *source, const char *psz_line)
+{
+    memset(source, 0, sizeof(source_t));
+    source->i_cpu = -1;
+    source->psz_name = strdup(psz_line);
+    if (source->psz_name == NULL)
+        return false;
+
+    /* <source> cpu=<n> */
+    char *psz_cpu = strrchr(source->psz_name, '=');
+    size_t i_name = psz_cpu ? (size_t)(psz_cpu - source->psz_name) : 0;
+    if ((i_name > 4) && !strncmp(psz_cpu - 3, "cpu", 3) &&
+        ((psz_cpu[-4] == ' ') || (psz_cpu[-4] == '\t')))
+    {
+        char *psz_end;
+        long cpu = strtol(psz_cpu + 1, &psz_end, 10);
+        if ((psz_end == psz_cpu + 1) || (*psz_end != '\0') || (cpu < 0))
+            return false;
+        source->i_cpu = cpu;
+        i_name -= 4;
+        while ((i_name > 0) && ((source->psz_name[i_name - 1] == ' ') ||
+                                (source->psz_name[i_name - 1] == '\t')))
+            i_name--;
+        source->psz_name[i_name] = '\0';
+    }
+    return true;
+}
+
+#ifdef UDP_GROUPS
+static void group_close(group_t *group)
+{
+    udp_close(group->fd);
+    if (group->buffer)
+        buffer_free(group->buffer);
+    free(group->sources);
+    free(group->psz_iface);
+}
+
+/* Group of the multicast source udp://[<iface>@]<group>:<port>[/<sender>],
+ * joined on the socket of its interface, family and port, false when it
+ * is not one */
+static bool source_group(multi_t *multi, source_t *source)
+{
+    if (strncmp(source->psz_name, "udp://", 6) != 0)
+        return false;
+    char *psz_host = strdup(source->psz_name + 6);
+    if (psz_host == NULL)
+        return false;
+
+    char *psz_iface = NULL;
+    char *psz_addr = psz_host;
+    char *psz_at = strchr(psz_host, '@');
+    if (psz_at)
+    {
+        *psz_at = '\0';
+        psz_iface = psz_host;
+        psz_addr = psz_at + 1;
+    }
+    char *psz_sender = strchr(psz_addr, '/');
+    if (psz_sender)
+        *psz_sender++ = '\0';
+    char *psz_port = strrchr(psz_addr, ':');
+
+    bool b_ok = false;
+    memset(&source->sender, 0, sizeof(source->sender));
+    if ((psz_port == NULL) || (psz_port == psz_addr))
+        goto out;
+    *psz_port++ = '\0';
+    int port = strtol(psz_port, NULL, 0);
+    if (!udp_group_resolve(psz_addr, &source->group))
+        goto out;
+    if (psz_sender && !udp_group_resolve(psz_sender, &source->sender))
+        goto out;
+    if (psz_sender && (source->sender.ss_family != source->group.ss_family))
+        goto out;
+
+    group_t *group = NULL;
+    bool b_new = false;
+    for (int i = 0; i < multi->i_groups; i++)
+    {
+        group_t *p = &multi->groups[i];
+        if ((p->family == source->group.ss_family) && (p->port == port) &&
+            ((p->psz_iface && psz_iface) ? !strcmp(p->psz_iface, psz_iface)
+                                         : (p->psz_iface == psz_iface)))
+        {
+            group = p;
+            break;
+        }
+    }
+    if (group == NULL)
+    {
+        /* at most a group per source */
+        group = &multi->groups[multi->i_groups];
+        memset(group, 0, sizeof(group_t));
+        group->fd = udp_group_open(psz_iface, source->group.ss_family, port);
+        if (group->fd < 0)
+            goto out;
+        group->psz_iface = psz_iface ? strdup(psz_iface) : NULL;
+        group->family = source->group.ss_family;
+        group->port = port;
+        group->buffer = buffer_new_batch(UDP_BATCH * UDP_DATAGRAM_MAX, UDP_BATCH);
+        group->sources = calloc(multi->i_sources, sizeof(source_t *));
+        multi->i_groups++;
+        b_new = true;
+        if ((group->buffer == NULL) || (group->sources == NULL) ||
+            (psz_iface && (group->psz_iface == NULL)))
+            goto out;
+    }
+
+    if (!udp_group_join(group->fd, psz_iface, &source->group,
+                        psz_sender ? &source->sender : NULL))
+    {
+        /* not left bound to the port of a unicast source */
+        if (b_new)
+            group_close(&multi->groups[--multi->i_groups]);
+        goto out;
+    }
+    source->p_group = group;
+    group->sources[group->i_sources++] = source;
+    b_ok = true;
+
+out:
+    free(psz_host);
+    return b_ok;
+}
+
+/* Source of a datagram to dst from sender, NULL when none */
+static source_t *group_source(group_t *group, const struct sockaddr_storage *dst,
+                              const struct sockaddr_storage *sender)
+{
+    /* datagrams of a group mostly come in a row */
+    for (int n = 0; n < group->i_sources; n++)
+    {
+        int i = (group->i_last + n) % group->i_sources;
+        source_t *source = group->sources[i];
+        if (!udp_addr_equal(&source->group, dst))
+            continue;
+        if ((source->sender.ss_family != AF_UNSPEC) &&
+            !udp_addr_equal(&source->sender, sender))
+            continue;
+        group->i_last = i;
+        return source;
+    }
+    return NULL;
+}
+#endif
+
+/* buffers of one datagram shared by the sources of a worker */
+static bool source_open(multi_t *multi, source_t *source)
+{
+#ifdef UDP_GROUPS
+    if (source_group(multi, source))
+        return true;
+#else
+    (void) multi;
+#endif
+    source->input = input_open(source->psz_name, MULTI_CAPTURE_SIZE, 1);
+    return (source->input != NULL);
+}
+
+static void source_close(source_t *source)
+{
+    input_close(source->input);
+    source->input = NULL;
+}
+
+static bool multi_load(multi_t *multi, const char *psz_file)
+{
+    FILE *fd = fopen(psz_file, "r");
+    if (fd == NULL)
+        return false;
+
+    char line[1024];
+    int i_max = 0;
+    bool b_ok = true;
+    while (b_ok && fgets(line, sizeof(line), fd))
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        if ((line[0] == '\0') || (line[0] == '#'))
+            continue;
+
+        if (multi->i_sources == i_max)
+        {
+            i_max = i_max ? 2 * i_max : 16;
+            source_t *sources = malloc(i_max * sizeof(source_t));
+            if (sources == NULL)
+            {
+                b_ok = false;
+                break;
+            }
+            if (multi->sources)
+                memcpy(sources, multi->sources, multi->i_sources * sizeof(source_t));
+            free(multi->sources);
+            multi->sources = sources;
+        }
+        b_ok = source_parse(&multi->sources[multi->i_sources], line);
+        if (b_ok)
+            multi->i_sources++;
+        else if (multi->sources[multi->i_sources].psz_name)
+        {
+            libdvbpsi_log(multi->param, DVBINFO_LOG_ERROR, "Invalid source %s\n", line);
+            free(multi->sources[multi->i_sources].psz_name);
+        }
+    }
+    fclose(fd);
+    return b_ok && (multi->i_sources > 0);
+}
+
+/* Workers */
+static void worker_recycle(worker_t *worker, buffer_t *buffer)
+{
+    if (!ring_push(worker->empty, buffer))
+        buffer_free(buffer);
+}
+
+static void *worker_run(void *data)
+{
+    worker_t *worker = (worker_t *)data;
+    buffer_t *buffer;
+
+    /* the capture loop closes the ring once all sources have ended */
+    while ((buffer = ring_pop_wait(worker->fifo)) != NULL)
+    {
+        source_t *source = (source_t *)buffer->p_source;
+
+        pthread_mutex_lock(&worker->lock);
+        bool b_ok = true;
+        if (buffer->i_datagrams == 0)
+            b_ok = libdvbpsi_process(source->stream, buffer->p_data,
+                                     buffer->i_size, buffer->i_date);
+        else
+        {
+            uint8_t *p_data = buffer->p_data;
+            for (unsigned i = 0; i < buffer->i_datagrams && b_ok; i++)
+            {
+                b_ok = libdvbpsi_process_datagram(source->stream, p_data,
+                                                  buffer->p_sizes[i], buffer->p_dates[i]);
+                p_data += buffer->p_sizes[i];
+            }
+        }
+        if (!b_ok)
+            libdvbpsi_log(worker->multi->param, DVBINFO_LOG_ERROR,
+                          "error while processing %s\n", source->psz_name);
+        pthread_mutex_unlock(&worker->lock);
+
+        /* the source may move to another worker once this is 0 */
+        __atomic_sub_fetch(&source->i_pending, 1, __ATOMIC_RELEASE);
+        worker_recycle(worker, buffer);
+    }
+    return NULL;
+}
+
+static void worker_affinity(worker_t *worker, int i_worker)
+{
+    worker->i_cpu = -1;
+#if defined(__linux__) && defined(CPU_SET)
+    long i_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (i_cpus <= 1)
+        return;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(i_worker % i_cpus, &set);
+    if (pthread_setaffinity_np(worker->handle, sizeof(set), &set) == 0)
+        worker->i_cpu = i_worker % i_cpus;
+#else
+    (void) worker;
+    (void) i_worker;
+#endif
+}
+
+/* Worker pinned to cpu, or the same one for any cpu without its worker */
+static worker_t *worker_of_cpu(multi_t *multi, int cpu)
+{
+    for (int i = 0; i < multi->i_workers; i++)
+        if (multi->workers[i].i_cpu == cpu)
+            return &multi->workers[i];
+    return &multi->workers[cpu % multi->i_workers];
+}
+
+/* Steering, in the capture loop only: a source changes worker once all its
+ * buffers have been processed, never being processed by two at once */
+static void source_steer(multi_t *multi, source_t *source)
+{
+    if (source->p_next &&
+        (__atomic_load_n(&source->i_pending, __ATOMIC_ACQUIRE) == 0))
+    {
+        source->p_worker = source->p_next;
+        source->p_next = NULL;
+        source->i_moves++;
+    }
+
+    if (!source->b_steer || (source->i_buffers++ % MULTI_STEER_EVERY) != 0)
+        return;
+    int cpu = udp_incoming_cpu(source->input->fd);
+    if (cpu < 0)
+        return;
+    worker_t *worker = worker_of_cpu(multi, cpu);
+    source->p_next = (worker != source->p_worker) ? worker : NULL;
+}
+
+static bool capture_push(worker_t *worker, source_t *source, buffer_t *buffer)
+{
+    __atomic_add_fetch(&source->i_pending, 1, __ATOMIC_RELAXED);
+    if (ring_push(worker->fifo, buffer))
+        return true;
+    __atomic_sub_fetch(&source->i_pending, 1, __ATOMIC_RELAXED);
+    return false;
+}
+
+/* Capture, pushing to fifo and popping from empty only */
+static buffer_t *capture_get(worker_t *worker, const input_t *input)
+{
+    buffer_t *buffer = worker->p_spare;
+    worker->p_spare = NULL;
+    if (buffer == NULL)
+        buffer = ring_pop(worker->empty);
+    if (buffer == NULL)
+        buffer = input ? input_buffer(input)
+                       : buffer_new_batch(MULTI_CAPTURE_SIZE, 1);
+    return buffer;
+}
+
+static void capture_put(worker_t *worker, buffer_t *buffer)
+{
+    if (worker->p_spare == NULL)
+        worker->p_spare = buffer;
+    else
+        buffer_free(buffer);
+}
+
+static void multi_capture(multi_t *multi, source_t *source)
+{
+    source_steer(multi, source);
+    worker_t *worker = source->p_worker;
+    bool b_file = source->input->b_file;
+
+    /* files are not read faster than they are processed, their worker
+     * holding up the capture loop while its ring is full */
+    if (b_file && !ring_wait_room(worker->fifo))
+        return;
+
+    buffer_t *buffer = capture_get(worker, source->input);
+    if (buffer == NULL) /* out of memory */
+        return;
+
+    ssize_t size = input_read(source->input, &buffer);
+    if ((size <= 0) && ((size == 0) || b_file || (errno != EAGAIN && errno != EINTR)))
+    {
+        libdvbpsi_log(multi->param, DVBINFO_LOG_INFO, "End of %s\n", source->psz_name);
+        source->b_eof = true;
+        if (buffer)
+            capture_put(worker, buffer);
+        return;
+    }
+    if (size < 0)
+    {
+        if (buffer)
+            capture_put(worker, buffer);
+        return;
+    }
+
+    buffer->p_source = source;
+    if (!capture_push(worker, source, buffer))
+    {
+        source->i_dropped++;
+        capture_put(worker, buffer);
+    }
+}
+
+#ifdef UDP_GROUPS
+/* Reads a batch of the group, each datagram being copied to a buffer of the
+ * worker of its source */
+static void multi_capture_group(multi_t *multi, group_t *group)
+{
+    buffer_t *batch = group->buffer;
+    struct sockaddr_storage dests[UDP_BATCH], senders[UDP_BATCH];
+
+    ssize_t size = udp_group_read(group->fd, batch->p_data, UDP_BATCH * UDP_DATAGRAM_MAX,
+                                  UDP_BATCH, batch->p_sizes, batch->p_dates,
+                                  dests, senders, &batch->i_datagrams);
+    if (size < 0)
+    {
+        if ((errno == EAGAIN) || (errno == EINTR))
+            return;
+        for (int i = 0; i < group->i_sources; i++)
+        {
+            libdvbpsi_log(multi->param, DVBINFO_LOG_INFO, "End of %s\n",
+                          group->sources[i]->psz_name);
+            group->sources[i]->b_eof = true;
+        }
+        return;
+    }
+
+    mtime_t i_date = udate();
+    uint8_t *p_data = batch->p_data;
+    for (unsigned i = 0; i < batch->i_datagrams; i++)
+    {
+        size_t i_size = batch->p_sizes[i];
+        source_t *source = group_source(group, &dests[i], &senders[i]);
+        if (source == NULL)
+        {
+            group->i_unknown++;
+            p_data += i_size;
+            continue;
+        }
+
+        worker_t *worker = source->p_worker;
+        buffer_t *buffer = capture_get(worker, NULL);
+        if (buffer == NULL) /* out of memory */
+            return;
+        memcpy(buffer->p_data, p_data, i_size);
+        p_data += i_size;
+        buffer->i_size = i_size;
+        buffer->i_datagrams = 1;
+        buffer->p_sizes[0] = i_size;
+        /* no kernel timestamp */
+        buffer->p_dates[0] = (batch->p_dates[i] < 0) ? i_date : batch->p_dates[i];
+        buffer->i_date = buffer->p_dates[0];
+        buffer->p_source = source;
+        if (!capture_push(worker, source, buffer))
+        {
+            source->i_dropped++;
+            capture_put(worker, buffer);
+        }
+    }
+}
+#endif
+
+/* Summary */
+static void multi_summary(multi_t *multi, FILE *fd)
+{
+    const params_t *param = multi->param;
+
+    for (int i = 0; i < multi->i_sources; i++)
+    {
+        source_t *source = &multi->sources[i];
+        fprintf(fd, "\n=========================================================\n");
+        fprintf(fd, "Source: %s%s, dropped buffers: %"PRIu64"\n", source->psz_name,
+                source->b_eof ? " (ended)" : "", source->i_dropped);
+        if (source->p_worker->i_cpu >= 0)
+            fprintf(fd, "Processed on cpu %d, moved %"PRIu64" times\n",
+                    source->p_worker->i_cpu, source->i_moves);
+
+        pthread_mutex_lock(&source->p_worker->lock);
+        libdvbpsi_summary(fd, source->stream, param->summary.mode);
+        pthread_mutex_unlock(&source->p_worker->lock);
+    }
+#ifdef UDP_GROUPS
+    for (int i = 0; i < multi->i_groups; i++)
+    {
+        group_t *group = &multi->groups[i];
+        if (group->i_unknown > 0)
+            fprintf(fd, "\nGroup socket %s%sport %d: %"PRIu64" datagrams of no source\n",
+                    group->psz_iface ? group->psz_iface : "", group->psz_iface ? " " : "",
+                    group->port, group->i_unknown);
+    }
+#endif
+}
+
+static bool multi_summary_file(multi_t *multi, const char *psz_temp)
+{
+    params_t *param = multi->param;
+
+    FILE *fd = fopen(psz_temp, "w+");
+    if (fd == NULL)
+    {
+        libdvbpsi_log(param, DVBINFO_LOG_ERROR,
+                      "failed opening summary file (disabling summary logging)\n");
+        return false;
+    }
+    multi_summary(multi, fd);
+    fflush(fd);
+    fclose(fd);
+    unlink(param->summary.file);
+    if (rename(psz_temp, param->summary.file) < 0)
+    {
+        libdvbpsi_log(param, DVBINFO_LOG_ERROR,
+                      "failed renming summary file (disabling summary logging)\n");
+        return false;
+    }
+    return true;
+}
+
+/* Capture loop */
+static void multi_loop(multi_t *multi)
+{
+    params_t *param = multi->param;
+    char *psz_temp = NULL;
+    mtime_t deadline = 0;
+
+    bool b_summary_file = param->b_summary && param->summary.file;
+    if (b_summary_file)
+    {
+        if (asprintf(&psz_temp, "%s.part", param->summary.file) < 0)
+            b_summary_file = false;
+        deadline = mdate() + param->summary.period;
+    }
+
+    /* the sources of a group being polled through it */
+    struct pollfd *fds = calloc(multi->i_sources, sizeof(struct pollfd));
+    source_t **map = calloc(multi->i_sources, sizeof(source_t *));
+    group_t **groups = calloc(multi->i_sources, sizeof(group_t *));
+    if ((fds == NULL) || (map == NULL) || (groups == NULL))
+        goto out;
+
+    for (;;)
+    {
+        int i_fds = 0;
+        bool b_ready = false; /* an input without descriptor */
+        for (int i = 0; i < multi->i_groups; i++)
+        {
+            group_t *group = &multi->groups[i];
+            bool b_alive = false;
+            for (int j = 0; (j < group->i_sources) && !b_alive; j++)
+                b_alive = !group->sources[j]->b_eof;
+            if (!b_alive)
+                continue;
+            fds[i_fds].fd = group->fd;
+            fds[i_fds].events = POLLIN;
+            fds[i_fds].revents = 0;
+            map[i_fds] = NULL;
+            groups[i_fds++] = group;
+        }
+        for (int i = 0; i < multi->i_sources; i++)
+        {
+            source_t *source = &multi->sources[i];
+            if (source->b_eof || source->p_group)
+                continue;
+            fds[i_fds].fd = source->input->fd;
+            fds[i_fds].events = POLLIN;
+            fds[i_fds].revents = 0;
+            if (fds[i_fds].fd < 0)
+                b_ready = true;
+            groups[i_fds] = NULL;
+            map[i_fds++] = source;
+        }
+        if (i_fds == 0)
+            break;
+
+        int n = poll(fds, i_fds, b_ready ? 0 : MULTI_POLL_TIMEOUT);
+        if ((n < 0) && (errno != EINTR))
+        {
+            libdvbpsi_log(param, DVBINFO_LOG_ERROR, "poll error: %s\n", strerror(errno));
+            break;
+        }
+        for (int i = 0; ((n > 0) || b_ready) && (i < i_fds); i++)
+        {
+            if (!(fds[i].fd < 0) && !(fds[i].revents & (POLLIN | POLLERR | POLLHUP)))
+                continue;
+#ifdef UDP_GROUPS
+            if (groups[i])
+            {
+                multi_capture_group(multi, groups[i]);
+                continue;
+            }
+#endif
+            multi_capture(multi, map[i]);
+        }
+
+        /* summary statistics */
+        if (b_summary_file && (mdate() >= deadline))
+        {
+            b_summary_file = multi_summary_file(multi, psz_temp);
+            deadline = mdate() + param->summary.period;
+        }
+    }
+
+out:
+    free(groups);
+    free(map);
+    free(fds);
+    free(psz_temp);
+}
+
+int dvbinfo_multi(params_t *param)
+{
+    int err = -1;
+    multi_t multi;
+
+    memset(&multi, 0, sizeof(multi));
+    multi.param = param;
+    if (!multi_load(&multi, param->sources))
+    {
+        libdvbpsi_log(param, DVBINFO_LOG_ERROR, "No source read from %s\n", param->sources);
+        goto out;
+    }
+
+    multi.i_workers = param->workers;
+    if (multi.i_workers <= 0)
+        multi.i_workers = sysconf(_SC_NPROCESSORS_ONLN);
+    if (multi.i_workers <= 0)
+        multi.i_workers = 1;
+    /* steered sources may need the worker of any cpu */
+    bool b_steer = param->b_steer;
+    for (int i = 0; i < multi.i_sources; i++)
+        b_steer |= (multi.sources[i].i_cpu >= 0);
+    if ((multi.i_workers > multi.i_sources) && !(b_steer && (param->workers <= 0)))
+        multi.i_workers = multi.i_sources;
+
+    multi.workers = calloc(multi.i_workers, sizeof(worker_t));
+    if (multi.workers == NULL)
+        goto out;
+#ifdef UDP_GROUPS
+    multi.groups = calloc(multi.i_sources, sizeof(group_t));
+    if (multi.groups == NULL)
+        goto out;
+#endif
+
+    /* rings of threshold bytes in all */
+    size_t i_slots = param->threshold / MULTI_CAPTURE_SIZE / multi.i_workers;
+    for (int i = 0; i < multi.i_workers; i++)
+    {
+        worker_t *worker = &multi.workers[i];
+        worker->multi = &multi;
+        worker->fifo = ring_new(i_slots);
+        worker->empty = ring_new(i_slots);
+        pthread_mutex_init(&worker->lock, NULL);
+        if ((worker->fifo == NULL) || (worker->empty == NULL))
+            goto out;
+    }
+
+    /* threads pinned to their cpu first, for the sources given a cpu */
+    int i_started = 0;
+    for (; i_started < multi.i_workers; i_started++)
+    {
+        worker_t *worker = &multi.workers[i_started];
+        if (pthread_create(&worker->handle, NULL, worker_run, worker) != 0)
+        {
+            libdvbpsi_log(param, DVBINFO_LOG_ERROR, "failed creating thread\n");
+            break;
+        }
+        worker_affinity(worker, i_started);
+    }
+    if (i_started < multi.i_workers)
+        goto stop;
+
+    /* each source stays on one worker, unless steered */
+    for (int i = 0; i < multi.i_sources; i++)
+    {
+        source_t *source = &multi.sources[i];
+        source->p_worker = (source->i_cpu >= 0) ? worker_of_cpu(&multi, source->i_cpu)
+                                                : &multi.workers[i % multi.i_workers];
+        source->stream = libdvbpsi_init(param->debug, &libdvbpsi_log, (void *)param);
+        if (source->stream == NULL)
+            goto stop;
+        libdvbpsi_trace(source->stream, param->trace, param->b_trace_events);
+        if (param->b_profile && !libdvbpsi_profile(source->stream, true))
+            goto stop;
+        if (!source_open(&multi, source))
+        {
+            libdvbpsi_log(param, DVBINFO_LOG_ERROR, "Could not open %s\n", source->psz_name);
+            source->b_eof = true;
+        }
+        else
+            libdvbpsi_log(param, DVBINFO_LOG_INFO, "Examining: %s\n", source->psz_name);
+        /* the receiving cpu of a socket of its own */
+        source->b_steer = param->b_steer && (source->i_cpu < 0) && !source->b_eof &&
+                          source->input && !source->input->b_file &&
+                          !strncmp(source->psz_name, "udp://", 6);
+    }
+
+    multi_loop(&multi);
+    err = 0;
+
+stop:
+    /* stop workers once they have emptied their fifo */
+    for (int i = 0; i < multi.i_workers; i++)
+        ring_close(multi.workers[i].fifo);
+    for (int i = 0; i < i_started; i++)
+    {
+        if (pthread_join(multi.workers[i].handle, NULL) != 0)
+            libdvbpsi_log(param, DVBINFO_LOG_ERROR, "error joining worker thread\n");
+    }
+
+    /* final summary */
+    if ((err == 0) && param->b_summary && param->summary.file)
+    {
+        char *psz_temp = NULL;
+        if (asprintf(&psz_temp, "%s.part", param->summary.file) >= 0)
+            multi_summary_file(&multi, psz_temp);
+        free(psz_temp);
+    }
+
+out:
+    for (int i = 0; i < multi.i_sources; i++)
+    {
+        source_t *source = &multi.sources[i];
+        source_close(source);
+        if (source->stream)
+            libdvbpsi_exit(source->stream);
+        free(source->psz_name);
+    }
+    free(multi.sources);
+#ifdef UDP_GROUPS
+    for (int i = 0; i < multi.i_groups; i++)
+        group_close(&multi.groups[i]);
+#endif
+    free(multi.groups);
+
+    for (int i = 0; multi.workers && (i < multi.i_workers); i++)
+    {
+        worker_t *worker = &multi.workers[i];
+        ring_free(worker->fifo);
+        ring_free(worker->empty);
+        if (worker->p_spare)
+            buffer_free(worker->p_spare);
+        pthread_mutex_destroy(&worker->lock);
+    }
+    free(multi.workers);
+    return err;
+}
@@ -0,0 +1,45 @@
+/*****************************************************************************
+ * multi.h: multi-input monitoring
+ *****************************************************************************
+ * Copyright (C) 2011 M2X BV
+ *
+ * Authors: Jean-Paul Saman <jpsaman@videolan.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *****************************************************************************/
+
+#ifndef DVBINFO_MULTI_H_
+#define DVBINFO_MULTI_H_
+
+/* Multi-input mode:
+ * dvbinfo_multi() - monitor every source listed in param->sources, one
+ *                   per line, until they have all ended: one capture loop
+ *                   polls them and a pool of param->workers threads
+ *                   processes them, each source always on the same worker.
+ *                   A source is a file name, udp://[<iface>@]<host>:<port>
+ *                   or tcp://<host>:<port>; empty lines and lines starting
+ *                   with # are skipped. The summary of all sources is
+ *                   written to one summary file. Multicast groups of the
+ *                   same interface, family and port are received on one
+ *                   socket, by destination address, a /<sender> after the
+ *                   port making it a source specific join. A cpu=<n> after
+ *                   a blank puts the source on the worker of cpu n. With
+ *                   param->b_steer, a udp source with its own socket moves
+ *                   to the worker of the cpu receiving its datagrams, so
+ *                   that the packets and the decoders stay in its caches.
+ */
+int dvbinfo_multi(params_t *param);
+
+#endif
@@ -0,0 +1,360 @@
+/*****************************************************************************
+ * pktring.c: PACKET_MMAP ring capture
+ *****************************************************************************
+ * Copyright (C) 2011 M2X BV
+ *
+ * Authors: Jean-Paul Saman <jpsaman@videolan.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <poll.h>
+
+#if defined(HAVE_INTTYPES_H)
+#   include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#   include <stdint.h>
+#endif
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <net/ethernet.h>
+#include <linux/if_packet.h>
+#include <linux/filter.h>
+#include <assert.h>
+
+#include "dvbinfo.h"
+#include "libdvbpsi.h"
+#include "pktring.h"
+
+#define PKTRING_BLOCK_SIZE  (1 << 20) /* bytes per ring block */
+#define PKTRING_FRAME_SIZE  2048      /* nominal frame size */
+#define PKTRING_MAX_BLOCKS  64
+#define PKTRING_BLOCK_TOV   10        /* ms before the kernel retires a
+                                         partly filled block */
+#define PKTRING_POLL_TIMEOUT 100      /* ms */
+
+typedef struct pktring_s
+{
+    int       fd;
+    uint8_t  *p_map;
+    size_t    i_map;
+    unsigned  i_blocks;
+    unsigned  i_block;  /* next block to read */
+
+    /* statistics */
+    uint64_t  i_packets;
+    uint64_t  i_drops;  /* packets the ring had no room for */
+    uint64_t  i_datagrams;
+} pktring_t;
+
+/* Socket filter keeping the unfragmented IPv4 udp datagrams to address and
+ * port, the packet socket giving the network header at offset 0 */
+static bool pktring_filter(int fd, uint32_t i_addr, uint16_t i_port)
+{
+    struct sock_filter code[] =
+    {
+        BPF_STMT(BPF_LD  | BPF_B   | BPF_ABS, 9),             /* protocol */
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 8),
+        BPF_STMT(BPF_LD  | BPF_W   | BPF_ABS, 16),            /* destination */
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, i_addr, 0, 6),
+        BPF_STMT(BPF_LD  | BPF_H   | BPF_ABS, 6),             /* fragment */
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x1fff, 4, 0),
+        BPF_STMT(BPF_LDX | BPF_B   | BPF_MSH, 0),             /* header length */
+        BPF_STMT(BPF_LD  | BPF_H   | BPF_IND, 2),             /* udp destination port */
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, i_port, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, 0xffff),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+    struct sock_fprog prog = { .len = sizeof(code) / sizeof(code[0]), .filter = code };
+
+    return setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) == 0;
+}
+
+static bool pktring_open(pktring_t *ring, params_t *param)
+{
+    struct addrinfo hints, *addr;
+
+    memset(ring, 0, sizeof(pktring_t));
+    ring->fd = -1;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    if (getaddrinfo(param->input, NULL, &hints, &addr) != 0)
+    {
+        libdvbpsi_log(param, DVBINFO_LOG_ERROR, "ring: no IPv4 address for %s\n",
+                      param->input);
+        return false;
+    }
+    uint32_t i_addr = ntohl(((struct sockaddr_in *)addr->ai_addr)->sin_addr.s_addr);
+    freeaddrinfo(addr);
+
+    /* cooked packets, starting at the network header */
+    ring->fd = socket(AF_PACKET, SOCK_DGRAM | SOCK_CLOEXEC, htons(ETH_P_IP));
+    if (ring->fd < 0)
+    {
+        libdvbpsi_log(param, DVBINFO_LOG_ERROR, "ring: packet socket error: %s\n",
+                      strerror(errno));
+        return false;
+    }
+
+    if (!pktring_filter(ring->fd, i_addr, param->port))
+        goto error;
+
+    int version = TPACKET_V3;
+    if (setsockopt(ring->fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0)
+        goto error;
+
+    ring->i_blocks = param->threshold / PKTRING_BLOCK_SIZE;
+    if (ring->i_blocks > PKTRING_MAX_BLOCKS)
+        ring->i_blocks = PKTRING_MAX_BLOCKS;
+    if (ring->i_blocks < 2)
+        ring->i_blocks = 2;
+
+    struct tpacket_req3 req;
+    memset(&req, 0, sizeof(req));
+    req.tp_block_size = PKTRING_BLOCK_SIZE;
+    req.tp_block_nr = ring->i_blocks;
+    req.tp_frame_size = PKTRING_FRAME_SIZE;
+    req.tp_frame_nr = (PKTRING_BLOCK_SIZE / PKTRING_FRAME_SIZE) * ring->i_blocks;
+    req.tp_retire_blk_tov = PKTRING_BLOCK_TOV;
+    if (setsockopt(ring->fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0)
+        goto error;
+
+    ring->i_map = (size_t)PKTRING_BLOCK_SIZE * ring->i_blocks;
+    ring->p_map = mmap(NULL, ring->i_map, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_LOCKED, ring->fd, 0);
+    if (ring->p_map == MAP_FAILED)
+    {
+        /* without locking, for a low RLIMIT_MEMLOCK */
+        ring->p_map = mmap(NULL, ring->i_map, PROT_READ | PROT_WRITE,
+                           MAP_SHARED, ring->fd, 0);
+    }
+    if (ring->p_map == MAP_FAILED)
+    {
+        ring->p_map = NULL;
+        goto error;
+    }
+
+    struct sockaddr_ll sll;
+    memset(&sll, 0, sizeof(sll));
+    sll.sll_family = AF_PACKET;
+    sll.sll_protocol = htons(ETH_P_IP);
+    if (param->mcast_interface)
+    {
+        sll.sll_ifindex = if_nametoindex(param->mcast_interface);
+        if (sll.sll_ifindex == 0)
+            goto error;
+    }
+    if (bind(ring->fd, (struct sockaddr *)&sll, sizeof(sll)) < 0)
+        goto error;
+
+    return true;
+
+error:
+    libdvbpsi_log(param, DVBINFO_LOG_ERROR, "ring: setup error: %s\n", strerror(errno));
+    if (ring->p_map)
+        munmap(ring->p_map, ring->i_map);
+    close(ring->fd);
+    ring->fd = -1;
+    return false;
+}
+
+static void pktring_close(pktring_t *ring)
+{
+    munmap(ring->p_map, ring->i_map);
+    close(ring->fd);
+}
+
+/* Adds the kernel counters, which reading resets */
+static void pktring_stats(pktring_t *ring)
+{
+    struct tpacket_stats_v3 stats;
+    socklen_t len = sizeof(stats);
+
+    if (getsockopt(ring->fd, SOL_PACKET, PACKET_STATISTICS, &stats, &len) == 0)
+    {
+        ring->i_packets += stats.tp_packets;
+        ring->i_drops += stats.tp_drops;
+    }
+}
+
+/* Processes the datagrams of a block, in place */
+static bool pktring_block(pktring_t *ring, params_t *param, ts_stream_t *stream,
+                          struct tpacket_block_desc *block)
+{
+    struct tpacket3_hdr *hdr = (struct tpacket3_hdr *)
+            ((uint8_t *)block + block->hdr.bh1.offset_to_first_pkt);
+
+    for (uint32_t i = 0; i < block->hdr.bh1.num_pkts; i++)
+    {
+        const struct sockaddr_ll *sll = (const struct sockaddr_ll *)
+                ((uint8_t *)hdr + TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+        uint8_t *p_ip = (uint8_t *)hdr + hdr->tp_net;
+        size_t i_len = hdr->tp_snaplen - (hdr->tp_net - hdr->tp_mac);
+
+        /* loopback shows sent packets as well */
+        if ((sll->sll_pkttype != PACKET_OUTGOING) && (i_len >= 20))
+        {
+            size_t i_ihl = (p_ip[0] & 0x0f) * 4;
+            if (i_len >= i_ihl + 8)
+            {
+                uint8_t *p_udp = p_ip + i_ihl;
+                size_t i_payload = ((p_udp[4] << 8) | p_udp[5]);
+                if (i_payload > i_len - i_ihl)
+                    i_payload = i_len - i_ihl;
+                i_payload = (i_payload >= 8) ? i_payload - 8 : 0;
+
+                mtime_t i_date = (hdr->tp_sec * (mtime_t)1000000) +
+                                 (hdr->tp_nsec / (mtime_t)1000);
+                ring->i_datagrams++;
+
+                if (param->output && (i_payload > 0))
+                {
+                    ssize_t size = param->pf_write(param->fd_out, p_udp + 8, i_payload);
+                    if ((size < 0) || ((size_t)size < i_payload))
+                    {
+                        libdvbpsi_log(param, DVBINFO_LOG_ERROR,
+                                      "error writting to %s\n", param->output);
+                        return false;
+                    }
+                }
+                if ((i_payload > 0) &&
+                    !libdvbpsi_process_datagram(stream, p_udp + 8, i_payload, i_date))
+                    return false;
+            }
+        }
+        hdr = (struct tpacket3_hdr *)((uint8_t *)hdr + hdr->tp_next_offset);
+    }
+    return true;
+}
+
+/* Summary */
+static bool pktring_summary_file(pktring_t *ring, params_t *param,
+                                 ts_stream_t *stream, const char *psz_temp)
+{
+    FILE *fd = fopen(psz_temp, "w+");
+    if (fd == NULL)
+    {
+        libdvbpsi_log(param, DVBINFO_LOG_ERROR,
+                      "failed opening summary file (disabling summary logging)\n");
+        return false;
+    }
+    pktring_stats(ring);
+    fprintf(fd, "\n=========================================================\n");
+    fprintf(fd, "Ring: %s:%d, packets: %"PRIu64", datagrams: %"PRIu64", drops: %"PRIu64"\n",
+            param->input, param->port, ring->i_packets, ring->i_datagrams, ring->i_drops);
+    libdvbpsi_summary(fd, stream, param->summary.mode);
+    fflush(fd);
+    fclose(fd);
+    unlink(param->summary.file);
+    if (rename(psz_temp, param->summary.file) < 0)
+    {
+        libdvbpsi_log(param, DVBINFO_LOG_ERROR,
+                      "failed renming summary file (disabling summary logging)\n");
+        return false;
+    }
+    return true;
+}
+
+int dvbinfo_pktring(params_t *param)
+{
+    int err = -1;
+    pktring_t ring;
+    char *psz_temp = NULL;
+    mtime_t deadline = 0;
+
+    if (!pktring_open(&ring, param))
+        return err;
+
+    /* the group is joined through param->fd_in, which keeps as little as
+     * possible of the copies it gets */
+    if (param->fd_in >= 0)
+        setsockopt(param->fd_in, SOL_SOCKET, SO_RCVBUF, &(int){ 0 }, sizeof(int));
+
+    ts_stream_t *stream = libdvbpsi_init(param->debug, &libdvbpsi_log, (void *)param);
+    if (stream == NULL)
+        goto out;
+    libdvbpsi_trace(stream, param->trace, param->b_trace_events);
+    if (param->b_profile && !libdvbpsi_profile(stream, true))
+        libdvbpsi_log(param, DVBINFO_LOG_ERROR, "Could not profile the tables\n");
+
+    bool b_summary_file = param->b_summary && param->summary.file;
+    if (b_summary_file)
+    {
+        if (asprintf(&psz_temp, "%s.part", param->summary.file) < 0)
+            b_summary_file = false;
+        deadline = mdate() + param->summary.period;
+    }
+
+    libdvbpsi_log(param, DVBINFO_LOG_INFO, "Ring: %u blocks of %d bytes\n",
+                  ring.i_blocks, PKTRING_BLOCK_SIZE);
+
+    for (;;)
+    {
+        struct tpacket_block_desc *block = (struct tpacket_block_desc *)
+                (ring.p_map + (size_t)ring.i_block * PKTRING_BLOCK_SIZE);
+
+        if ((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE)
+             & TP_STATUS_USER) == 0)
+        {
+            struct pollfd pfd = { .fd = ring.fd, .events = POLLIN | POLLERR, .revents = 0 };
+            if ((poll(&pfd, 1, PKTRING_POLL_TIMEOUT) < 0) && (errno != EINTR))
+            {
+                libdvbpsi_log(param, DVBINFO_LOG_ERROR, "poll error: %s\n", strerror(errno));
+                break;
+            }
+        }
+        else
+        {
+            bool b_ok = pktring_block(&ring, param, stream, block);
+
+            /* give the block back to the kernel */
+            __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL,
+                             __ATOMIC_RELEASE);
+            ring.i_block = (ring.i_block + 1) % ring.i_blocks;
+            if (!b_ok)
+                break;
+        }
+
+        /* summary statistics */
+        if (b_summary_file && (mdate() >= deadline))
+        {
+            b_summary_file = pktring_summary_file(&ring, param, stream, psz_temp);
+            deadline = mdate() + param->summary.period;
+        }
+    }
+
+out:
+    if (stream)
+        libdvbpsi_exit(stream);
+    free(psz_temp);
+    pktring_close(&ring);
+    return err;
+}
@@ -0,0 +1,39 @@
+/*****************************************************************************
+ * pktring.h: PACKET_MMAP ring capture
+ *****************************************************************************
+ * Copyright (C) 2011 M2X BV
+ *
+ * Authors: Jean-Paul Saman <jpsaman@videolan.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *****************************************************************************/
+
+#ifndef DVBINFO_PKTRING_H_
+#define DVBINFO_PKTRING_H_
+
+/* Ring capture mode:
+ * dvbinfo_pktring() - monitor the udp stream param->input:param->port from
+ *                     a TPACKET_V3 ring of a packet socket on
+ *                     param->mcast_interface, or on all interfaces. A
+ *                     BPF filter keeps the IPv4 datagrams of the stream
+ *                     and the TS payloads are processed in place in the
+ *                     ring frames. param->fd_in is expected to be the
+ *                     udp_open() socket joining the multicast group; it
+ *                     is never read. The summary file reports the packets
+ *                     the kernel dropped as the ring was full.
+ */
+int dvbinfo_pktring(params_t *param);
+
+#endif
@@ -0,0 +1,123 @@
+/*****************************************************************************
+ * series.c: bitrate time series
+ *****************************************************************************
+ * Copyright (C) 2011 M2X BV
+ *
+ * Authors: Jean-Paul Saman <jpsaman@videolan.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#if defined(HAVE_INTTYPES_H)
+#   include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#   include <stdint.h>
+#endif
+
+#include <string.h>
+#include <assert.h>
+
+typedef int64_t mtime_t;
+
+#include "series.h"
+
+struct series_s
+{
+    mtime_t      i_resolution;  /* bucket length, in ms */
+    unsigned int i_buckets;
+
+    bool         b_started;
+    int64_t      i_first;       /* bucket of the first packet */
+    int64_t      i_last;        /* bucket of the last packet */
+
+    uint32_t     p_count[];     /* packets, bucket i at p_count[i % i_buckets] */
+};
+
+series_t *series_new(mtime_t i_resolution, unsigned int i_buckets)
+{
+    assert(i_resolution > 0);
+    assert(i_buckets > 0);
+
+    series_t *series = calloc(1, sizeof(series_t) + i_buckets * sizeof(uint32_t));
+    if (!series)
+        return NULL;
+    series->i_resolution = i_resolution;
+    series->i_buckets = i_buckets;
+    return series;
+}
+
+void series_delete(series_t *series)
+{
+    free(series);
+}
+
+void series_add(series_t *series, mtime_t date, uint32_t i_packets)
+{
+    int64_t i_bucket = date / series->i_resolution;
+
+    if (!series->b_started)
+    {
+        series->b_started = true;
+        series->i_first = series->i_last = i_bucket;
+    }
+    else if (i_bucket > series->i_last)
+    {
+        /* clear the buckets nothing arrived in, then the new one */
+        int64_t i_gap = i_bucket - series->i_last;
+        if (i_gap >= series->i_buckets)
+            memset(series->p_count, 0, series->i_buckets * sizeof(uint32_t));
+        else
+        {
+            for (int64_t i = series->i_last + 1; i <= i_bucket; i++)
+                series->p_count[i % series->i_buckets] = 0;
+        }
+        series->i_last = i_bucket;
+    }
+    else if (i_bucket <= series->i_last - series->i_buckets)
+        return; /* reused already */
+
+    if (i_bucket < series->i_first)
+        series->i_first = i_bucket;
+    series->p_count[i_bucket % series->i_buckets] += i_packets;
+}
+
+unsigned int series_bitrate(const series_t *series, mtime_t date,
+                            double *p_bitrate, unsigned int i_count)
+{
+    assert(i_count <= series->i_buckets);
+
+    int64_t i_bucket = date / series->i_resolution;
+    double f_scale = 188.0 * 8 * 1000 / series->i_resolution;
+    unsigned int i_valid = 0;
+
+    for (unsigned int i = 0; i < i_count; i++)
+    {
+        int64_t i_at = i_bucket - (i_count - 1) + i;
+
+        p_bitrate[i] = 0;
+        if (!series->b_started || (i_at < series->i_first))
+            continue;
+        i_valid++;
+        /* buckets after the last packet have not been cleared yet */
+        if ((i_at <= series->i_last) && (i_at > series->i_last - series->i_buckets))
+            p_bitrate[i] = series->p_count[i_at % series->i_buckets] * f_scale;
+    }
+    return i_valid;
+}
@@ -0,0 +1,50 @@
+/*****************************************************************************
+ * series.h: bitrate time series
+ *****************************************************************************
+ * Copyright (C) 2011 M2X BV
+ *
+ * Authors: Jean-Paul Saman <jpsaman@videolan.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *****************************************************************************/
+
+#ifndef DVBINFO_SERIES_H_
+#define DVBINFO_SERIES_H_
+
+typedef struct series_s series_t;
+
+/* Time series: packets counted in i_buckets buckets of i_resolution ms of
+ * arrival time, the oldest bucket being reused for the next one. Buckets are
+ * only cleared when the arrival time moves into them, so that counting costs
+ * the same with packets in every bucket or seconds between two packets.
+ *
+ * series_new()     - create a series covering i_buckets * i_resolution ms
+ * series_delete()  - delete series
+ * series_add()     - count i_packets arrived at date. Packets arriving later
+ *                    than the series covers are dropped.
+ * series_bitrate() - fill p_bitrate with the bitrates in bit/s of the i_count
+ *                    buckets up to the one of date, oldest first, and return
+ *                    how many of the last ones are from the first packet on,
+ *                    the others being 0. date is usually the arrival of the
+ *                    last packet, or a bucket earlier for complete buckets
+ *                    only, and i_count at most i_buckets.
+ */
+series_t *series_new(mtime_t i_resolution, unsigned int i_buckets);
+void series_delete(series_t *series);
+void series_add(series_t *series, mtime_t date, uint32_t i_packets);
+unsigned int series_bitrate(const series_t *series, mtime_t date,
+                            double *p_bitrate, unsigned int i_count);
+
+#endif
@@ -0,0 +1,214 @@
+/*****************************************************************************
+ * stats.c: live statistics in shared memory
+ *****************************************************************************
+ * Copyright (C) 2011 M2X BV
+ *
+ * Authors: Jean-Paul Saman <jpsaman@videolan.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+#if defined(HAVE_INTTYPES_H)
+#   include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#   include <stdint.h>
+#endif
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#ifdef HAVE_SYS_SOCKET_H
+#   include <sys/socket.h>
+#   include <netinet/in.h>
+#   include <poll.h>
+#endif
+
+#include <assert.h>
+
+#include "stats.h"
+
+#define STATS_HTTP_TRIES 100 /* snapshots attempted per request */
+
+stats_t *stats_open(const char *psz_name)
+{
+    int fd = shm_open(psz_name, O_CREAT | O_RDWR, 0644);
+    if (fd < 0)
+        return NULL;
+
+    stats_t *stats = NULL;
+    if (ftruncate(fd, sizeof(stats_t)) == 0)
+    {
+        stats = mmap(NULL, sizeof(stats_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (stats == MAP_FAILED)
+            stats = NULL;
+    }
+    close(fd);
+    if (!stats)
+    {
+        shm_unlink(psz_name);
+        return NULL;
+    }
+
+    /* a collector still mapping a previous segment sees it change */
+    stats_begin(stats);
+    memset((uint8_t *)stats + offsetof(stats_t, i_date), 0,
+           sizeof(stats_t) - offsetof(stats_t, i_date));
+    stats->i_magic = STATS_MAGIC;
+    stats->i_version = STATS_VERSION;
+    stats->i_size = sizeof(stats_t);
+    stats_end(stats);
+    return stats;
+}
+
+void stats_close(stats_t *stats, const char *psz_name)
+{
+    munmap(stats, sizeof(stats_t));
+    shm_unlink(psz_name);
+}
+
+/*****************************************************************************
+ * Text exporter
+ *****************************************************************************/
+#ifdef HAVE_SYS_SOCKET_H
+struct stats_http_s
+{
+    const stats_t *stats;
+    stats_t   *copy;    /* snapshot of the last request */
+    int        fd;      /* listening socket */
+    bool       b_alive;
+    pthread_t  handle;
+};
+
+static void stats_http_write(FILE *out, const stats_t *s)
+{
+    fprintf(out, "HTTP/1.0 200 OK\r\n"
+                 "Content-Type: text/plain; version=0.0.4\r\n"
+                 "Connection: close\r\n\r\n");
+    fprintf(out, "dvbinfo_date_ms %"PRId64"\n", s->i_date);
+    fprintf(out, "dvbinfo_packets_total %"PRIu64"\n", s->i_packets);
+    fprintf(out, "dvbinfo_null_packets_total %"PRIu64"\n", s->i_null_packets);
+    fprintf(out, "dvbinfo_lost_bytes_total %"PRIu64"\n", s->i_lost_bytes);
+    fprintf(out, "dvbinfo_cc_errors_total %"PRIu64"\n", s->i_cc_errors);
+    fprintf(out, "dvbinfo_rtp_datagrams_total %"PRIu64"\n", s->i_rtp_datagrams);
+    fprintf(out, "dvbinfo_rtp_lost_total %"PRIu64"\n", s->i_rtp_lost);
+    fprintf(out, "dvbinfo_rtp_reordered_total %"PRIu64"\n", s->i_rtp_reordered);
+    fprintf(out, "dvbinfo_shed_level %u\n", s->i_shed_level);
+    for (uint32_t i = 0; i < s->i_pids; i++)
+        fprintf(out, "dvbinfo_pid_packets_total{pid=\"%u\"} %"PRIu64"\n",
+                s->pid[i].i_pid, s->pid[i].i_packets);
+    for (uint32_t i = 0; i < s->i_pids; i++)
+        fprintf(out, "dvbinfo_pid_cc_errors_total{pid=\"%u\"} %"PRIu64"\n",
+                s->pid[i].i_pid, s->pid[i].i_cc_errors);
+    for (uint32_t i = 0; i < s->i_pids; i++)
+        fprintf(out, "dvbinfo_pid_scrambled{pid=\"%u\"} %u\n",
+                s->pid[i].i_pid, s->pid[i].b_scrambled);
+}
+
+static void *stats_http_run(void *data)
+{
+    stats_http_t *http = (stats_http_t *)data;
+    struct pollfd pfd = { .fd = http->fd, .events = POLLIN };
+
+    while (__atomic_load_n(&http->b_alive, __ATOMIC_RELAXED))
+    {
+        /* wake up now and then to notice being stopped */
+        if (poll(&pfd, 1, 200) <= 0)
+            continue;
+        int fd = accept(http->fd, NULL, NULL);
+        if (fd < 0)
+            continue;
+
+        /* the request itself does not matter */
+        struct timeval tv = { .tv_sec = 1, .tv_usec = 0 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        char request[1024];
+        if (recv(fd, request, sizeof(request), 0) < 0)
+        {
+            close(fd);
+            continue;
+        }
+
+        FILE *out = fdopen(fd, "w");
+        if (!out)
+        {
+            close(fd);
+            continue;
+        }
+        if (stats_read(http->stats, http->copy, STATS_HTTP_TRIES))
+            stats_http_write(out, http->copy);
+        else
+            fprintf(out, "HTTP/1.0 503 Service Unavailable\r\n\r\n");
+        fclose(out);
+    }
+    return NULL;
+}
+
+stats_http_t *stats_http_start(const stats_t *stats, int i_port)
+{
+    stats_http_t *http = calloc(1, sizeof(stats_http_t));
+    if (!http)
+        return NULL;
+    http->stats = stats;
+    http->copy = malloc(sizeof(stats_t));
+    http->fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (!http->copy || (http->fd < 0))
+        goto error;
+
+    int i_reuse = 1;
+    setsockopt(http->fd, SOL_SOCKET, SO_REUSEADDR, &i_reuse, sizeof(i_reuse));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(i_port);
+    if ((bind(http->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) ||
+        (listen(http->fd, 8) < 0))
+        goto error;
+
+    http->b_alive = true;
+    if (pthread_create(&http->handle, NULL, stats_http_run, http) != 0)
+        goto error;
+    return http;
+
+error:
+    if (http->fd >= 0)
+        close(http->fd);
+    free(http->copy);
+    free(http);
+    return NULL;
+}
+
+void stats_http_stop(stats_http_t *http)
+{
+    __atomic_store_n(&http->b_alive, false, __ATOMIC_RELAXED);
+    pthread_join(http->handle, NULL);
+    close(http->fd);
+    free(http->copy);
+    free(http);
+}
+#endif
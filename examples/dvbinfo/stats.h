@@ -0,0 +1,135 @@
+/*****************************************************************************
+ * stats.h: live statistics in shared memory
+ *****************************************************************************
+ * Copyright (C) 2011 M2X BV
+ *
+ * Authors: Jean-Paul Saman <jpsaman@videolan.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *****************************************************************************/
+
+#ifndef DVBINFO_STATS_H_
+#define DVBINFO_STATS_H_
+
+/* Live statistics of dvbinfo --stats <name>, in the POSIX shared memory
+ * object <name> (see shm_open(3)). This header is all a collector needs:
+ * it maps the object read-only, checks i_magic and i_version and takes
+ * snapshots with stats_read(), at any rate, dvbinfo never waiting for it.
+ *
+ * The processing thread updates the segment every STATS_PERIOD ms of
+ * arrival time, i_seq being odd during the update (a seqlock). Counters
+ * are totals since dvbinfo started. The layout only grows at the end
+ * within one version; i_size is the size of the segment. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define STATS_MAGIC     0x53425644  /* "DVBS" in little endian */
+#define STATS_VERSION   1
+#define STATS_PERIOD    100         /* ms */
+
+typedef struct stats_pid_s
+{
+    uint16_t    i_pid;
+    uint8_t     b_scrambled;    /* last packet scrambled */
+    uint8_t     i_reserved[5];
+    uint64_t    i_packets;
+    uint64_t    i_cc_errors;    /* continuity counter discontinuities */
+    int64_t     i_received;     /* arrival of the last packet, in ms */
+} stats_pid_t;
+
+typedef struct stats_s
+{
+    uint32_t    i_magic;        /* STATS_MAGIC */
+    uint32_t    i_version;      /* STATS_VERSION */
+    uint32_t    i_size;         /* bytes of the segment */
+    uint32_t    i_seq;          /* odd while being updated */
+
+    int64_t     i_date;         /* arrival of the last packet, in ms */
+    uint64_t    i_updates;
+    uint64_t    i_packets;
+    uint64_t    i_null_packets;
+    uint64_t    i_lost_bytes;
+    uint64_t    i_cc_errors;
+    uint64_t    i_rtp_datagrams;
+    uint64_t    i_rtp_lost;
+    uint64_t    i_rtp_reordered;
+
+    uint32_t    i_pids;         /* entries of pid[] in use, by order of appearance */
+    uint32_t    i_shed_level;   /* dvbpsi_shed_level_t of libdvbpsi_shed() */
+    stats_pid_t pid[8192];
+} stats_t;
+
+/* Writer side:
+ * stats_begin() - start an update
+ * stats_end()   - publish it
+ */
+static inline void stats_begin(stats_t *stats)
+{
+    __atomic_store_n(&stats->i_seq, stats->i_seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void stats_end(stats_t *stats)
+{
+    __atomic_store_n(&stats->i_seq, stats->i_seq + 1, __ATOMIC_RELEASE);
+}
+
+/* Reader side:
+ * stats_read() - copy the header and the i_pids entries in use of a segment
+ *                into p_copy, which has room for a whole stats_t. Returns
+ *                false if the writer kept updating during i_tries attempts.
+ */
+static inline bool stats_read(const stats_t *stats, stats_t *p_copy, int i_tries)
+{
+    while (i_tries-- > 0)
+    {
+        uint32_t i_seq = __atomic_load_n(&stats->i_seq, __ATOMIC_ACQUIRE);
+        if (i_seq & 1)
+            continue;
+
+        memcpy(p_copy, stats, offsetof(stats_t, pid));
+        uint32_t i_pids = p_copy->i_pids;
+        if (i_pids > 8192)
+            i_pids = 8192;
+        memcpy(p_copy->pid, stats->pid, i_pids * sizeof(stats_pid_t));
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&stats->i_seq, __ATOMIC_RELAXED) == i_seq)
+        {
+            p_copy->i_pids = i_pids;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* dvbinfo:
+ * stats_open()  - create and map the shared memory object psz_name
+ * stats_close() - unmap and remove it
+ * stats_http_start() - serve the statistics as text at http://<host>:i_port/
+ *                      from a thread, in the Prometheus exposition format
+ * stats_http_stop()  - stop serving
+ */
+stats_t *stats_open(const char *psz_name);
+void stats_close(stats_t *stats, const char *psz_name);
+
+typedef struct stats_http_s stats_http_t;
+stats_http_t *stats_http_start(const stats_t *stats, int i_port);
+void stats_http_stop(stats_http_t *http);
+
+#endif
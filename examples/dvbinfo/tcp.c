@@ -166,14 +166,17 @@ ssize_t tcp_read(int fd, void *buf, size_t count)
 {
     ssize_t err;
 again:
-    err = recv(fd, buf, count, MSG_WAITALL);
+    /* any size, the packets cut at the end of a read being carried over
+     * to the next one */
+    err = recv(fd, buf, count, 0);
     if (err < 0)
     {
         switch(errno)
         {
             case EINTR:
-            case EAGAIN:
                 goto again;
+            case EAGAIN: /* non-blocking, nothing received */
+                return -1;
             case ECONNREFUSED:
                 fprintf(stderr, "remote host refused connection\n");
                 break;
@@ -29,6 +29,12 @@
 #include <string.h>
 #include <unistd.h>
 
+#if defined(HAVE_INTTYPES_H)
+#   include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#   include <stdint.h>
+#endif
+
 #include <sys/time.h>
 #include <sys/types.h>
 
@@ -104,9 +110,7 @@ static bool mcast_connect(int s, const char *interface, const struct sockaddr_st
     struct group_req greq;
     memset(&greq, 0, sizeof(greq));
 
-    if (ifindex == 0)
-        return false;
-
+    /* any interface when 0, the kernel taking the route to the group */
     greq.gr_interface = ifindex;
     assert(len <= sizeof(greq.gr_group));
     memcpy(&greq.gr_group, addr, len);
@@ -275,6 +279,12 @@ int udp_open(const char *interface, const char *ipaddress, int port)
         if (setsockopt (s_ctl, SOL_SOCKET, SO_REUSEADDR, &(int){ 1 }, sizeof (int)) < 0)
             perror("udp setsockopt error");
 
+#if defined(HAVE_RECVMMSG) && defined(SO_TIMESTAMPNS)
+        /* Kernel receive timestamps for udp_read_batch() */
+        if (setsockopt (s_ctl, SOL_SOCKET, SO_TIMESTAMPNS, &(int){ 1 }, sizeof (int)) < 0)
+            perror("udp setsockopt error");
+#endif
+
         result = bind(s_ctl, ptr->ai_addr, ptr->ai_addrlen);
         if (result < 0)
         {
@@ -284,9 +294,9 @@ int udp_open(const char *interface, const char *ipaddress, int port)
             continue;
         }
 
-        const struct sockaddr_storage *saddr = (const struct sockaddr_storage *)&ptr->ai_addr;
+        const struct sockaddr_storage *saddr = (const struct sockaddr_storage *)ptr->ai_addr;
         if (is_multicast(saddr, ptr->ai_addrlen) &&
-            mcast_connect(s_ctl, NULL, saddr, ptr->ai_addrlen))
+            !mcast_connect(s_ctl, interface, saddr, ptr->ai_addrlen))
         {
             close(s_ctl);
             s_ctl = -1;
@@ -313,8 +323,9 @@ again:
         switch(errno)
         {
             case EINTR:
-            case EAGAIN:
                 goto again;
+            case EAGAIN: /* non-blocking, nothing received */
+                return -1;
             case ECONNREFUSED:
                 fprintf(stderr, "remote host refused connection\n");
                 break;
@@ -328,4 +339,300 @@ again:
     }
     return err;
 }
+
+int udp_incoming_cpu(int fd)
+{
+#ifdef SO_INCOMING_CPU
+    int cpu = -1;
+    socklen_t len = sizeof(cpu);
+    if (getsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) < 0)
+        return -1;
+    return cpu;
+#else
+    (void) fd;
+    return -1;
+#endif
+}
+
+#ifdef HAVE_RECVMMSG
+/* Receives up to i_max datagrams, with the destination and sender address
+ * of each when p_dests and p_froms are not NULL */
+static ssize_t udp_recv_batch(int fd, void *buf, size_t count, unsigned i_max,
+                              size_t *pi_sizes, int64_t *pi_dates,
+                              struct sockaddr_storage *p_dests,
+                              struct sockaddr_storage *p_froms, unsigned *pi_count)
+{
+    struct mmsghdr msgs[UDP_BATCH];
+    struct iovec iov[UDP_BATCH];
+    union {
+        struct cmsghdr align;
+        uint8_t buf[CMSG_SPACE(sizeof(struct timespec))
+#ifdef IP_PKTINFO
+                    + CMSG_SPACE(sizeof(struct in_pktinfo))
+#endif
+#ifdef IPV6_RECVPKTINFO
+                    + CMSG_SPACE(sizeof(struct in6_pktinfo))
+#endif
+                   ];
+    } control[UDP_BATCH];
+    uint8_t *p_data = (uint8_t *)buf;
+    size_t i_datagram;
+    int n;
+
+    if (i_max > UDP_BATCH)
+        i_max = UDP_BATCH;
+    assert(i_max > 0);
+    i_datagram = count / i_max;
+
+    memset(msgs, 0, i_max * sizeof(struct mmsghdr));
+    for (unsigned i = 0; i < i_max; i++)
+    {
+        iov[i].iov_base = p_data + i * i_datagram;
+        iov[i].iov_len = i_datagram;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_control = control[i].buf;
+        msgs[i].msg_hdr.msg_controllen = sizeof(control[i].buf);
+        if (p_froms)
+        {
+            msgs[i].msg_hdr.msg_name = &p_froms[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+        }
+    }
+
+again:
+    /* block for the first datagram only, then take what is queued */
+    n = recvmmsg(fd, msgs, i_max, MSG_WAITFORONE, NULL);
+    if (n < 0)
+    {
+        switch(errno)
+        {
+            case EINTR:
+                goto again;
+            case EAGAIN: /* non-blocking, nothing received */
+                return -1;
+            default:
+                fprintf(stderr, "recvmmsg error: %s\n", strerror(errno));
+                return -1;
+        }
+    }
+
+    /* pack the datagrams, a short one leaving a hole before the next */
+    size_t i_length = 0;
+    for (int i = 0; i < n; i++)
+    {
+        size_t i_size = msgs[i].msg_len;
+        int64_t i_date = -1;
+
+        if (i_length != i * i_datagram)
+            memmove(p_data + i_length, p_data + i * i_datagram, i_size);
+        i_length += i_size;
+
+        if (p_dests)
+            memset(&p_dests[i], 0, sizeof(struct sockaddr_storage));
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsg != NULL;
+             cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg))
+        {
+#ifdef SO_TIMESTAMPNS
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS)
+            {
+                struct timespec ts;
+                memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+                i_date = (ts.tv_sec * (int64_t)1000000) + (ts.tv_nsec / (int64_t)1000);
+                continue;
+            }
+#endif
+            if (p_dests == NULL)
+                continue;
+#ifdef IP_PKTINFO
+            if (cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_PKTINFO)
+            {
+                struct in_pktinfo info;
+                struct sockaddr_in *dst = (struct sockaddr_in *)&p_dests[i];
+                memcpy(&info, CMSG_DATA(cmsg), sizeof(info));
+                dst->sin_family = AF_INET;
+                dst->sin_addr = info.ipi_addr;
+            }
+#endif
+#ifdef IPV6_RECVPKTINFO
+            if (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_PKTINFO)
+            {
+                struct in6_pktinfo info;
+                struct sockaddr_in6 *dst = (struct sockaddr_in6 *)&p_dests[i];
+                memcpy(&info, CMSG_DATA(cmsg), sizeof(info));
+                dst->sin6_family = AF_INET6;
+                dst->sin6_addr = info.ipi6_addr;
+            }
+#endif
+        }
+        pi_sizes[i] = i_size;
+        pi_dates[i] = i_date;
+    }
+    *pi_count = n;
+    return i_length;
+}
+
+ssize_t udp_read_batch(int fd, void *buf, size_t count, unsigned i_max,
+                       size_t *pi_sizes, int64_t *pi_dates, unsigned *pi_count)
+{
+    return udp_recv_batch(fd, buf, count, i_max, pi_sizes, pi_dates,
+                          NULL, NULL, pi_count);
+}
+
+#if defined(IP_PKTINFO) && defined(IPV6_RECVPKTINFO)
+int udp_group_open(const char *interface, int family, int port)
+{
+    if ((port > 65535) || (port < 0))
+    {
+        fprintf(stderr, "udp error: invalid port %d specified\n", port);
+        return -1;
+    }
+
+    int sflags = 0;
+#ifdef SOCK_CLOEXEC
+    sflags = SOCK_CLOEXEC;
+#endif
+    int s = socket(family, SOCK_DGRAM | sflags, IPPROTO_UDP);
+    if (s < 0)
+    {
+        perror("udp socket error");
+        return -1;
+    }
+#ifndef SOCK_CLOEXEC
+    if (!set_fdsocketclosexec(s))
+    {
+        close(s);
+        return -1;
+    }
+#endif
+
+    /* all the groups sharing it, 8MB being 1/2s of 128Mb/s */
+    if (setsockopt(s, SOL_SOCKET, SO_RCVBUF, &(int){ 0x800000 }, sizeof(int)) < 0)
+        perror("udp setsockopt error");
+    if (setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &(int){ 1 }, sizeof(int)) < 0)
+        perror("udp setsockopt error");
+#ifdef SO_TIMESTAMPNS
+    if (setsockopt(s, SOL_SOCKET, SO_TIMESTAMPNS, &(int){ 1 }, sizeof(int)) < 0)
+        perror("udp setsockopt error");
+#endif
+#ifdef SO_BINDTODEVICE
+    /* other interfaces joining the same groups are not ours */
+    if (interface &&
+        setsockopt(s, SOL_SOCKET, SO_BINDTODEVICE, interface, strlen(interface) + 1) < 0)
+        perror("udp setsockopt error");
+#endif
+
+    /* the destination address of each datagram, telling its group */
+    struct sockaddr_storage any;
+    socklen_t len;
+    memset(&any, 0, sizeof(any));
+    int result;
+    if (family == AF_INET6)
+    {
+        struct sockaddr_in6 *ip6 = (struct sockaddr_in6 *)&any;
+        ip6->sin6_family = AF_INET6;
+        ip6->sin6_addr = in6addr_any;
+        ip6->sin6_port = htons(port);
+        len = sizeof(*ip6);
+        result = setsockopt(s, SOL_IPV6, IPV6_RECVPKTINFO, &(int){ 1 }, sizeof(int));
+    }
+    else
+    {
+        struct sockaddr_in *ip = (struct sockaddr_in *)&any;
+        ip->sin_family = AF_INET;
+        ip->sin_addr.s_addr = htonl(INADDR_ANY);
+        ip->sin_port = htons(port);
+        len = sizeof(*ip);
+        result = setsockopt(s, SOL_IP, IP_PKTINFO, &(int){ 1 }, sizeof(int));
+    }
+    if (result < 0)
+    {
+        perror("udp setsockopt error");
+        close(s);
+        return -1;
+    }
+
+    if (bind(s, (struct sockaddr *)&any, len) < 0)
+    {
+        perror("udp bind error");
+        close(s);
+        return -1;
+    }
+    return s;
+}
+
+bool udp_group_resolve(const char *ipaddress, struct sockaddr_storage *saddr)
+{
+    struct addrinfo hints, *addr;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = is_ipv6(ipaddress) ? AF_INET6: AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_protocol = IPPROTO_UDP;
+
+    int result = getaddrinfo(ipaddress, NULL, &hints, &addr);
+    if (result != 0)
+    {
+        fprintf(stderr, "udp address error: %s\n", gai_strerror(result));
+        return false;
+    }
+    bool b_ok = (addr->ai_addrlen <= sizeof(*saddr));
+    if (b_ok)
+    {
+        memset(saddr, 0, sizeof(*saddr));
+        memcpy(saddr, addr->ai_addr, addr->ai_addrlen);
+    }
+    freeaddrinfo(addr);
+    return b_ok;
+}
+
+bool udp_group_join(int fd, const char *interface,
+                    const struct sockaddr_storage *group,
+                    const struct sockaddr_storage *source)
+{
+    const struct sockaddr *addr = (const struct sockaddr *)group;
+    socklen_t len = (addr->sa_family == AF_INET6) ? sizeof(struct sockaddr_in6)
+                                                  : sizeof(struct sockaddr_in);
+    if (!is_multicast(group, len))
+        return false;
+    if ((source == NULL) || (source->ss_family == AF_UNSPEC))
+        return mcast_connect(fd, interface, group, len);
+
+#if defined(MCAST_JOIN_SOURCE_GROUP)
+    /* Source Specific Multicast Join */
+    struct group_source_req gsreq;
+    memset(&gsreq, 0, sizeof(gsreq));
+    gsreq.gsr_interface = interface ? if_nametoindex(interface) : 0;
+    memcpy(&gsreq.gsr_group, group, len);
+    memcpy(&gsreq.gsr_source, source, len);
+    int level = (addr->sa_family == AF_INET6) ? SOL_IPV6 : SOL_IP;
+    return (setsockopt(fd, level, MCAST_JOIN_SOURCE_GROUP, &gsreq, sizeof(gsreq)) == 0);
+#else
+    return false;
+#endif
+}
+
+ssize_t udp_group_read(int fd, void *buf, size_t count, unsigned i_max,
+                       size_t *pi_sizes, int64_t *pi_dates,
+                       struct sockaddr_storage *p_dests,
+                       struct sockaddr_storage *p_froms, unsigned *pi_count)
+{
+    return udp_recv_batch(fd, buf, count, i_max, pi_sizes, pi_dates,
+                          p_dests, p_froms, pi_count);
+}
+
+bool udp_addr_equal(const struct sockaddr_storage *a, const struct sockaddr_storage *b)
+{
+    if (a->ss_family != b->ss_family)
+        return false;
+    if (a->ss_family == AF_INET6)
+        return IN6_ARE_ADDR_EQUAL(&((const struct sockaddr_in6 *)a)->sin6_addr,
+                                  &((const struct sockaddr_in6 *)b)->sin6_addr);
+    if (a->ss_family == AF_INET)
+        return ((const struct sockaddr_in *)a)->sin_addr.s_addr ==
+               ((const struct sockaddr_in *)b)->sin_addr.s_addr;
+    return false;
+}
+#endif
+#endif
 #endif
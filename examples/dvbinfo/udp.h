@@ -26,7 +26,53 @@
 
 int udp_open(const char *interface, const char *ipaddress, int port);
 int udp_close(int fd);
+/* Room for one datagram: 7 TS packets and an RTP header, or more */
+#define UDP_DATAGRAM_MAX 2048
+
 ssize_t udp_read(int fd, void *buf, size_t count);
 
+/* Cpu which processed the last datagram received on fd in the kernel, the
+ * one of its receive queue with RSS, -1 when unknown */
+int udp_incoming_cpu(int fd);
+
+#ifdef HAVE_RECVMMSG
+/* Batched reception: up to UDP_BATCH datagrams of at most count / i_max
+ * bytes per call, packed one after the other in buf. The size of each
+ * datagram and its kernel receive timestamp in us go to pi_sizes and
+ * pi_dates, the number of datagrams to *pi_count. Returns the number of
+ * bytes packed, or -1 on error, errno being EAGAIN when the socket is
+ * non-blocking and nothing was received. */
+#define UDP_BATCH 64
+ssize_t udp_read_batch(int fd, void *buf, size_t count, unsigned i_max,
+                       size_t *pi_sizes, int64_t *pi_dates, unsigned *pi_count);
+
+#if defined(IP_PKTINFO) && defined(IPV6_RECVPKTINFO)
+/* Many groups on one socket, each datagram telling its group by the
+ * destination address of its packet info:
+ * udp_group_open()    - socket of family bound to any address on port,
+ *                       receiving on interface only when not NULL
+ * udp_group_resolve() - address of ipaddress, false when it has none
+ * udp_group_join()    - join group, from source only when not NULL or
+ *                       AF_UNSPEC, false when not a multicast group
+ * udp_group_read()    - udp_read_batch() which also stores the destination
+ *                       and sender address of each datagram to p_dests and
+ *                       p_froms, the ports of the destinations being 0
+ * udp_addr_equal()    - true when a and b have the same address, whatever
+ *                       their port
+ */
+#define UDP_GROUPS 1
+int udp_group_open(const char *interface, int family, int port);
+bool udp_group_resolve(const char *ipaddress, struct sockaddr_storage *saddr);
+bool udp_group_join(int fd, const char *interface,
+                    const struct sockaddr_storage *group,
+                    const struct sockaddr_storage *source);
+ssize_t udp_group_read(int fd, void *buf, size_t count, unsigned i_max,
+                       size_t *pi_sizes, int64_t *pi_dates,
+                       struct sockaddr_storage *p_dests,
+                       struct sockaddr_storage *p_froms, unsigned *pi_count);
+bool udp_addr_equal(const struct sockaddr_storage *a, const struct sockaddr_storage *b);
+#endif
+#endif
+
 #endif
 
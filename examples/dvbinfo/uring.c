@@ -0,0 +1,260 @@
+/*****************************************************************************
+ * uring.c: io_uring file reader
+ *****************************************************************************
+ * Copyright (C) 2011 M2X BV
+ *
+ * Authors: Jean-Paul Saman <jpsaman@videolan.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#   include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#   include <stdint.h>
+#endif
+
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#include <assert.h>
+
+#include "uring.h"
+
+#define URING_ALIGN 4096 /* O_DIRECT offset, size and memory alignment */
+
+typedef struct uring_slot_s
+{
+    void         *p_tag;
+    struct iovec  iov;
+    bool          b_done;
+    ssize_t       i_result;
+} uring_slot_t;
+
+struct uring_s
+{
+    int           fd_ring;
+    int           fd_file;
+    off_t         i_file_size;
+    off_t         i_offset;      /* of the next block to queue */
+    size_t        i_block;
+
+    /* reads, queued in file order from i_head */
+    uring_slot_t *slots;
+    unsigned      i_depth;
+    unsigned      i_head;
+    unsigned      i_queued;
+    unsigned      i_pending;     /* queued but not submitted yet */
+
+    /* rings shared with the kernel */
+    void         *p_sq;
+    size_t        i_sq;
+    void         *p_cq;
+    size_t        i_cq;
+    struct io_uring_sqe *sqes;
+    size_t        i_sqes;
+    unsigned     *p_sq_head, *p_sq_tail, *p_sq_mask, *p_sq_array;
+    unsigned     *p_cq_head, *p_cq_tail, *p_cq_mask;
+    struct io_uring_cqe *cqes;
+};
+
+static int uring_setup(unsigned i_entries, struct io_uring_params *p)
+{
+    return (int) syscall(__NR_io_uring_setup, i_entries, p);
+}
+
+static int uring_enter(int fd, unsigned i_submit, unsigned i_complete, unsigned i_flags)
+{
+    return (int) syscall(__NR_io_uring_enter, fd, i_submit, i_complete, i_flags, NULL, 0);
+}
+
+uring_t *uring_open(const char *psz_file, unsigned i_depth, size_t i_block)
+{
+    struct io_uring_params params;
+    struct stat st;
+
+    assert((i_block % URING_ALIGN) == 0);
+
+    uring_t *uring = (uring_t *) calloc(1, sizeof(uring_t));
+    if (uring == NULL)
+        return NULL;
+    uring->fd_ring = -1;
+    uring->i_block = i_block;
+    uring->i_depth = i_depth;
+
+    /* without O_DIRECT on file systems refusing it */
+    uring->fd_file = open(psz_file, O_RDONLY | O_DIRECT | O_CLOEXEC);
+    if (uring->fd_file < 0)
+        uring->fd_file = open(psz_file, O_RDONLY | O_CLOEXEC);
+    if ((uring->fd_file < 0) || (fstat(uring->fd_file, &st) < 0))
+        goto error;
+    uring->i_file_size = st.st_size;
+
+    uring->slots = (uring_slot_t *) calloc(i_depth, sizeof(uring_slot_t));
+    if (uring->slots == NULL)
+        goto error;
+
+    memset(&params, 0, sizeof(params));
+    uring->fd_ring = uring_setup(i_depth, &params);
+    if (uring->fd_ring < 0)
+        goto error;
+
+    uring->i_sq = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    uring->i_cq = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    uring->i_sqes = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    uring->p_sq = mmap(NULL, uring->i_sq, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, uring->fd_ring, IORING_OFF_SQ_RING);
+    uring->p_cq = mmap(NULL, uring->i_cq, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, uring->fd_ring, IORING_OFF_CQ_RING);
+    uring->sqes = mmap(NULL, uring->i_sqes, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, uring->fd_ring, IORING_OFF_SQES);
+    if ((uring->p_sq == MAP_FAILED) || (uring->p_cq == MAP_FAILED) ||
+        (uring->sqes == MAP_FAILED))
+        goto error;
+
+    uint8_t *p_sq = (uint8_t *)uring->p_sq;
+    uring->p_sq_head  = (unsigned *)(p_sq + params.sq_off.head);
+    uring->p_sq_tail  = (unsigned *)(p_sq + params.sq_off.tail);
+    uring->p_sq_mask  = (unsigned *)(p_sq + params.sq_off.ring_mask);
+    uring->p_sq_array = (unsigned *)(p_sq + params.sq_off.array);
+
+    uint8_t *p_cq = (uint8_t *)uring->p_cq;
+    uring->p_cq_head = (unsigned *)(p_cq + params.cq_off.head);
+    uring->p_cq_tail = (unsigned *)(p_cq + params.cq_off.tail);
+    uring->p_cq_mask = (unsigned *)(p_cq + params.cq_off.ring_mask);
+    uring->cqes = (struct io_uring_cqe *)(p_cq + params.cq_off.cqes);
+    return uring;
+
+error:
+    uring_close(uring);
+    return NULL;
+}
+
+bool uring_queue(uring_t *uring, void *p_data, void *p_tag)
+{
+    if ((uring->i_queued == uring->i_depth) || (uring->i_offset >= uring->i_file_size))
+        return false;
+
+    unsigned i_slot = (uring->i_head + uring->i_queued) % uring->i_depth;
+    uring_slot_t *slot = &uring->slots[i_slot];
+    slot->p_tag = p_tag;
+    slot->iov.iov_base = p_data;
+    slot->iov.iov_len = uring->i_block;
+    slot->b_done = false;
+    slot->i_result = 0;
+
+    /* the submission queue is as deep as the reads in flight */
+    unsigned i_tail = *uring->p_sq_tail;
+    unsigned i_index = i_tail & *uring->p_sq_mask;
+    struct io_uring_sqe *sqe = &uring->sqes[i_index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = uring->fd_file;
+    sqe->off = uring->i_offset;
+    sqe->addr = (uint64_t)(uintptr_t)&slot->iov;
+    sqe->len = 1;
+    sqe->user_data = i_slot;
+    uring->p_sq_array[i_index] = i_index;
+    __atomic_store_n(uring->p_sq_tail, i_tail + 1, __ATOMIC_RELEASE);
+
+    uring->i_offset += uring->i_block;
+    uring->i_queued++;
+    uring->i_pending++;
+    return true;
+}
+
+/* Marks the slots of the completed reads */
+static void uring_reap(uring_t *uring)
+{
+    unsigned i_head = *uring->p_cq_head;
+    unsigned i_tail = __atomic_load_n(uring->p_cq_tail, __ATOMIC_ACQUIRE);
+
+    for (; i_head != i_tail; i_head++)
+    {
+        struct io_uring_cqe *cqe = &uring->cqes[i_head & *uring->p_cq_mask];
+        uring_slot_t *slot = &uring->slots[cqe->user_data];
+        slot->i_result = cqe->res;
+        slot->b_done = true;
+    }
+    __atomic_store_n(uring->p_cq_head, i_head, __ATOMIC_RELEASE);
+}
+
+void *uring_next(uring_t *uring, ssize_t *pi_size)
+{
+    if (uring->i_queued == 0)
+        return NULL;
+
+    uring_slot_t *slot = &uring->slots[uring->i_head];
+    for (;;)
+    {
+        uring_reap(uring);
+        if (slot->b_done && (uring->i_pending == 0))
+            break;
+
+        int i_rc = uring_enter(uring->fd_ring, uring->i_pending,
+                               slot->b_done ? 0 : 1, IORING_ENTER_GETEVENTS);
+        if (i_rc < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            *pi_size = -1;
+            return NULL;
+        }
+        uring->i_pending -= i_rc;
+    }
+
+    uring->i_head = (uring->i_head + 1) % uring->i_depth;
+    uring->i_queued--;
+
+    *pi_size = slot->i_result;
+    if (slot->i_result < 0)
+        errno = -slot->i_result;
+    return slot->p_tag;
+}
+
+void uring_close(uring_t *uring)
+{
+    /* the buffers of the reads in flight belong to the kernel */
+    ssize_t i_size;
+    while ((uring->i_queued > 0) && (uring_next(uring, &i_size) != NULL))
+        ;
+
+    if (uring->sqes && (uring->sqes != MAP_FAILED))
+        munmap(uring->sqes, uring->i_sqes);
+    if (uring->p_cq && (uring->p_cq != MAP_FAILED))
+        munmap(uring->p_cq, uring->i_cq);
+    if (uring->p_sq && (uring->p_sq != MAP_FAILED))
+        munmap(uring->p_sq, uring->i_sq);
+    if (uring->fd_ring >= 0)
+        close(uring->fd_ring);
+    if (uring->fd_file >= 0)
+        close(uring->fd_file);
+    free(uring->slots);
+    free(uring);
+}
@@ -0,0 +1,45 @@
+/*****************************************************************************
+ * uring.h: io_uring file reader
+ *****************************************************************************
+ * Copyright (C) 2011 M2X BV
+ *
+ * Authors: Jean-Paul Saman <jpsaman@videolan.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *****************************************************************************/
+
+#ifndef DVBINFO_URING_H_
+#define DVBINFO_URING_H_
+
+/* io_uring file reader:
+ * uring_open()  - open a file for reads of i_block bytes, a multiple of the
+ *                 4096 bytes O_DIRECT alignment, up to i_depth in flight.
+ *                 The page cache is bypassed when the file system allows it.
+ * uring_queue() - queue the read of the next block of the file into p_data,
+ *                 aligned on 4096 bytes, p_tag identifying it. Returns false
+ *                 when the whole file is already queued or i_depth reads are.
+ * uring_next()  - submit the queued reads and wait for the oldest one,
+ *                 returning its tag and its size in *pi_size, 0 at the end
+ *                 of the file or -1 on error; NULL when none is queued.
+ * uring_close() - close the file, the reads in flight being waited for.
+ */
+typedef struct uring_s uring_t;
+
+uring_t *uring_open(const char *psz_file, unsigned i_depth, size_t i_block);
+bool uring_queue(uring_t *uring, void *p_data, void *p_tag);
+void *uring_next(uring_t *uring, ssize_t *pi_size);
+void uring_close(uring_t *uring);
+
+#endif
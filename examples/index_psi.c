@@ -0,0 +1,416 @@
+/*****************************************************************************
+ * index_psi.c: PSI/SI scan and PID index of a TS recording
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ * Scans a recording in two passes for its PSI/SI. The first pass pushes a
+ * sample of the start of the file through the SI discovery engine, which
+ * attaches decoders to the PIDs listed by the PAT and the MGT as the tables
+ * appear. The second pass walks the whole file with the packet header
+ * scanner, prints the tables decoded after the sample and only writes the
+ * runs of packets of the PIDs having decoders to an index:
+ *
+ *   <pid> <offset> <packets>
+ *
+ * one line per run of successive packets of a PID, in file order. Given
+ * back with -x, the index replaces both passes: only the indexed packets
+ * are read and decoded.
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+/* The libdvbpsi distribution defines DVBPSI_DIST */
+#ifdef DVBPSI_DIST
+#include "../src/dvbpsi.h"
+#include "../src/psi.h"
+#include "../src/descriptor.h"
+#include "../src/router.h"
+#include "../src/scan.h"
+#include "../src/discovery.h"
+#include "../src/tables/pat.h"
+#include "../src/tables/cat.h"
+#include "../src/tables/pmt.h"
+#include "../src/tables/nit.h"
+#include "../src/tables/sdt.h"
+#include "../src/tables/bat.h"
+#include "../src/tables/eit.h"
+#include "../src/tables/tot.h"
+#include "../src/tables/rst.h"
+#include "../src/tables/atsc_mgt.h"
+#include "../src/tables/atsc_vct.h"
+#include "../src/tables/atsc_eit.h"
+#include "../src/tables/atsc_ett.h"
+#include "../src/tables/atsc_stt.h"
+#else
+#include <dvbpsi/dvbpsi.h>
+#include <dvbpsi/psi.h>
+#include <dvbpsi/descriptor.h>
+#include <dvbpsi/router.h>
+#include <dvbpsi/scan.h>
+#include <dvbpsi/discovery.h>
+#include <dvbpsi/pat.h>
+#include <dvbpsi/cat.h>
+#include <dvbpsi/pmt.h>
+#include <dvbpsi/nit.h>
+#include <dvbpsi/sdt.h>
+#include <dvbpsi/bat.h>
+#include <dvbpsi/eit.h>
+#include <dvbpsi/tot.h>
+#include <dvbpsi/rst.h>
+#include <dvbpsi/atsc_mgt.h>
+#include <dvbpsi/atsc_vct.h>
+#include <dvbpsi/atsc_eit.h>
+#include <dvbpsi/atsc_ett.h>
+#include <dvbpsi/atsc_stt.h>
+#endif
+
+#include "tsfile.h"
+
+/*****************************************************************************
+ * Scan state
+ *****************************************************************************/
+typedef struct run_s
+{
+  uint16_t i_pid;
+  uint64_t i_offset;    /* of the first packet */
+  uint8_t *p_packets;   /* valid until the next ts_file_read() */
+  size_t   i_count;     /* 0 for no run */
+} run_t;
+
+typedef struct scan_s
+{
+  dvbpsi_router_t    *p_router;
+  dvbpsi_discovery_t *p_discovery;
+  uint64_t i_offset;    /* of the packets being decoded */
+  uint64_t i_tables;
+
+  FILE    *p_index;
+  uint64_t i_packets;   /* walked over */
+  uint64_t i_indexed;
+} scan_t;
+
+/*****************************************************************************
+ * Tables
+ *****************************************************************************/
+static const char *TableName(uint8_t i_table_id)
+{
+  if (i_table_id >= 0x4e && i_table_id <= 0x6f)
+    return "EIT";
+  switch (i_table_id)
+  {
+    case 0x00: return "PAT";
+    case 0x01: return "CAT";
+    case 0x02: return "PMT";
+    case 0x40: case 0x41: return "NIT";
+    case 0x42: case 0x46: return "SDT";
+    case 0x4a: return "BAT";
+    case 0x70: return "TDT";
+    case 0x73: return "TOT";
+    case 0x71: return "RST";
+    case 0xc7: return "MGT";
+    case 0xc8: case 0xc9: return "VCT";
+    case 0xcb: return "ATSC EIT";
+    case 0xcc: return "ETT";
+    case 0xcd: return "STT";
+    default:   return "?";
+  }
+}
+
+static void OnTable(void *p_data, uint16_t i_pid, uint8_t i_table_id, void *p_table)
+{
+  scan_t *p_scan = (scan_t *)p_data;
+
+  printf("%" PRIu64 " pid 0x%04x table_id 0x%02x %s\n",
+         p_scan->i_offset, i_pid, i_table_id, TableName(i_table_id));
+  p_scan->i_tables++;
+
+  if (i_table_id >= 0x4e && i_table_id <= 0x6f)
+  {
+    dvbpsi_eit_delete((dvbpsi_eit_t *)p_table);
+    return;
+  }
+  switch (i_table_id)
+  {
+    case 0x00: dvbpsi_pat_delete((dvbpsi_pat_t *)p_table); break;
+    case 0x01: dvbpsi_cat_delete((dvbpsi_cat_t *)p_table); break;
+    case 0x02: dvbpsi_pmt_delete((dvbpsi_pmt_t *)p_table); break;
+    case 0x40: case 0x41: dvbpsi_nit_delete((dvbpsi_nit_t *)p_table); break;
+    case 0x42: case 0x46: dvbpsi_sdt_delete((dvbpsi_sdt_t *)p_table); break;
+    case 0x4a: dvbpsi_bat_delete((dvbpsi_bat_t *)p_table); break;
+    case 0x70: case 0x73: dvbpsi_tot_delete((dvbpsi_tot_t *)p_table); break;
+    case 0x71: dvbpsi_rst_delete((dvbpsi_rst_t *)p_table); break;
+    case 0xc7: dvbpsi_atsc_DeleteMGT((dvbpsi_atsc_mgt_t *)p_table); break;
+    case 0xc8: case 0xc9: dvbpsi_atsc_DeleteVCT((dvbpsi_atsc_vct_t *)p_table); break;
+    case 0xcb: dvbpsi_atsc_DeleteEIT((dvbpsi_atsc_eit_t *)p_table); break;
+    case 0xcc: dvbpsi_atsc_DeleteETT((dvbpsi_atsc_ett_t *)p_table); break;
+    case 0xcd: dvbpsi_atsc_DeleteSTT((dvbpsi_atsc_stt_t *)p_table); break;
+  }
+}
+
+/*****************************************************************************
+ * Passes
+ *****************************************************************************/
+static void Decode(scan_t *p_scan, uint64_t i_offset, uint8_t *p_packets, size_t i_count)
+{
+  p_scan->i_offset = i_offset;
+  dvbpsi_router_push(p_scan->p_router, p_packets, i_count, 188);
+}
+
+/* First pass, decoding up to i_sample bytes. Returns the bytes decoded. */
+static uint64_t Sample(scan_t *p_scan, ts_file_t *p_file, uint64_t i_sample)
+{
+  uint8_t *p_packets;
+  size_t i_count;
+  uint64_t i_end = 0;
+
+  while (i_end < i_sample && (i_count = ts_file_read(p_file, &p_packets)) > 0)
+  {
+    i_end = ts_file_tell(p_file);
+    uint64_t i_offset = i_end - i_count * 188;
+    if (i_end > i_sample)
+    {
+      /* the rest of the run is left to the second pass */
+      i_count = (i_sample - i_offset + 187) / 188;
+      i_end = i_offset + i_count * 188;
+    }
+    Decode(p_scan, i_offset, p_packets, i_count);
+  }
+  return i_end;
+}
+
+/* Writes a run to the index, and decodes it unless the first pass did */
+static void RunFlush(scan_t *p_scan, run_t *p_run, uint64_t i_decoded)
+{
+  if (p_run->i_count == 0)
+    return;
+
+  if (p_scan->p_index)
+    fprintf(p_scan->p_index, "0x%04x %" PRIu64 " %zu\n",
+            p_run->i_pid, p_run->i_offset, p_run->i_count);
+  p_scan->i_indexed += p_run->i_count;
+  if (p_run->i_offset >= i_decoded)
+    Decode(p_scan, p_run->i_offset, p_run->p_packets, p_run->i_count);
+  p_run->i_count = 0;
+}
+
+/* Second pass over the whole file, the first i_decoded bytes being only
+ * indexed. The PIDs are read from the headers scanned by blocks, the
+ * packets of PIDs without decoders being walked over. */
+static void Index(scan_t *p_scan, ts_file_t *p_file, uint64_t i_decoded)
+{
+  dvbpsi_ts_headers_t headers;
+  uint8_t *p_packets;
+  size_t i_count;
+
+  while ((i_count = ts_file_read(p_file, &p_packets)) > 0)
+  {
+    uint64_t i_offset = ts_file_tell(p_file) - i_count * 188;
+    run_t run = { 0, 0, NULL, 0 };
+
+    for (size_t i = 0; i < i_count; i += headers.i_count)
+    {
+      dvbpsi_packets_scan(p_packets + i * 188, (i_count - i) * 188,
+                          DVBPSI_PACKET_TS, &headers);
+      if (headers.i_count == 0)
+        break;
+
+      for (unsigned j = 0; j < headers.i_count; j++)
+      {
+        uint16_t i_pid = headers.pi_pid[j];
+        if (dvbpsi_router_get(p_scan->p_router, i_pid) == NULL)
+        {
+          RunFlush(p_scan, &run, i_decoded);
+          continue;
+        }
+        if (run.i_count > 0 && run.i_pid == i_pid)
+        {
+          run.i_count++;
+          continue;
+        }
+        RunFlush(p_scan, &run, i_decoded);
+        run.i_pid = i_pid;
+        run.i_offset = i_offset + (i + j) * 188;
+        run.p_packets = p_packets + (i + j) * 188;
+        run.i_count = 1;
+      }
+    }
+    RunFlush(p_scan, &run, i_decoded);
+    p_scan->i_packets += i_count;
+  }
+}
+
+/* Decodes the packets of an index */
+static bool Reuse(scan_t *p_scan, ts_file_t *p_file, FILE *p_index)
+{
+  char line[256];
+  unsigned i_pid;
+  uint64_t i_offset;
+  size_t i_left;
+
+  while (fgets(line, sizeof(line), p_index))
+  {
+    if (line[0] == '#' || line[0] == '\n')
+      continue;
+    if (sscanf(line, "%x %" SCNu64 " %zu", &i_pid, &i_offset, &i_left) != 3
+     || !ts_file_seek(p_file, i_offset))
+      return false;
+
+    while (i_left > 0)
+    {
+      uint8_t *p_packets;
+      size_t i_count = ts_file_read(p_file, &p_packets);
+      if (i_count == 0)
+        return false;
+      if (i_count > i_left)
+        i_count = i_left;
+      Decode(p_scan, ts_file_tell(p_file) - i_count * 188, p_packets, i_count);
+      i_left -= i_count;
+      p_scan->i_indexed += i_count;
+    }
+  }
+  return true;
+}
+
+/*****************************************************************************
+ * Usage
+ *****************************************************************************/
+static void usage(char *name)
+{
+  printf("Usage: %s [-s <sample size>] [-o <index>] [-x <index>] <file>\n", name);
+  printf("\n");
+  printf(" -s : MB of the start of the file sampled for the PSI/SI PIDs (default: 16)\n");
+  printf(" -o : write the index of the PSI/SI packets to this file\n");
+  printf(" -x : decode only the packets of this index, written by -o\n");
+}
+
+/*****************************************************************************
+ * main
+ *****************************************************************************/
+int main(int i_argc, char* pa_argv[])
+{
+  const char *psz_index = NULL, *psz_reuse = NULL;
+  long i_sample_mb = 16;
+  int c;
+
+  while ((c = getopt(i_argc, pa_argv, "ho:s:x:")) != -1)
+  {
+    switch (c)
+    {
+      case 'o': psz_index = optarg; break;
+      case 's': i_sample_mb = strtol(optarg, NULL, 10); break;
+      case 'x': psz_reuse = optarg; break;
+      case 'h':
+      default:
+        usage(pa_argv[0]);
+        return 1;
+    }
+  }
+  if (optind != i_argc - 1)
+  {
+    usage(pa_argv[0]);
+    return 1;
+  }
+
+  ts_file_t *p_file = ts_file_open(pa_argv[optind]);
+  if (p_file == NULL)
+  {
+    fprintf(stderr, "Could not open %s\n", pa_argv[optind]);
+    return 1;
+  }
+
+  scan_t scan;
+  memset(&scan, 0, sizeof(scan));
+  scan.p_router = dvbpsi_router_new();
+  if (scan.p_router)
+    scan.p_discovery = dvbpsi_discovery_new(scan.p_router, 0, NULL, DVBPSI_MSG_NONE,
+                                            OnTable, &scan);
+  if (scan.p_discovery == NULL)
+  {
+    fprintf(stderr, "Could not create the SI discovery engine\n");
+    if (scan.p_router)
+      dvbpsi_router_delete(scan.p_router);
+    ts_file_close(p_file);
+    return 1;
+  }
+
+  int i_ret = 0;
+  if (psz_reuse)
+  {
+    FILE *p_reuse = fopen(psz_reuse, "r");
+    if (p_reuse == NULL || !Reuse(&scan, p_file, p_reuse))
+    {
+      fprintf(stderr, "Could not use the index %s\n", psz_reuse);
+      i_ret = 1;
+    }
+    if (p_reuse)
+      fclose(p_reuse);
+    printf("%" PRIu64 " tables, %" PRIu64 " packets decoded\n",
+           scan.i_tables, scan.i_indexed);
+  }
+  else
+  {
+    if (psz_index && (scan.p_index = fopen(psz_index, "w")) == NULL)
+    {
+      fprintf(stderr, "Could not create %s\n", psz_index);
+      i_ret = 1;
+    }
+    else
+    {
+      uint64_t i_sample = (uint64_t)(i_sample_mb > 0 ? i_sample_mb : 1) << 20;
+      uint64_t i_decoded = Sample(&scan, p_file, i_sample);
+      if (!ts_file_seek(p_file, 0))
+      {
+        fprintf(stderr, "Could not seek %s\n", pa_argv[optind]);
+        i_ret = 1;
+      }
+      else
+      {
+        if (scan.p_index)
+          fprintf(scan.p_index, "# %s\n", pa_argv[optind]);
+        Index(&scan, p_file, i_decoded);
+        printf("%" PRIu64 " tables, %" PRIu64 " of %" PRIu64 " packets indexed\n",
+               scan.i_tables, scan.i_indexed, scan.i_packets);
+      }
+      if (scan.p_index && fclose(scan.p_index) != 0)
+      {
+        fprintf(stderr, "Could not write %s\n", psz_index);
+        i_ret = 1;
+      }
+    }
+  }
+
+  dvbpsi_discovery_delete(scan.p_discovery);
+  dvbpsi_router_delete(scan.p_router);
+  ts_file_close(p_file);
+  return i_ret;
+}
@@ -0,0 +1,469 @@
+/*****************************************************************************
+ * index_tables.c: table version index of a TS recording
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ * Writes, with -o, a sidecar file recording every new version of the PAT,
+ * PMTs and actual SDT of a recording, as given by the table callbacks of
+ * the SI discovery engine, with the sections of the version, so that the
+ * tables current at any offset of the recording are restored, with -r,
+ * without reading it from the start.
+ *
+ * The sidecar starts with the 4 bytes "TSVX" and a format version byte,
+ * followed by one record per section, all fields big-endian:
+ *
+ *   8 bytes  offset of the packet completing the table in the recording
+ *   8 bytes  last PCR of the stream before it, in 27 MHz units, or all
+ *            bits set without any
+ *   2 bytes  PID
+ *   1 byte   table_id
+ *   2 bytes  table_id_extension
+ *   1 byte   version_number
+ *   4 bytes  CRC_32 of the section
+ *   2 bytes  size of the section
+ *   section
+ *
+ * The sections are those encoded again from the decoded table, which the
+ * corresponding decoder turns back into the same table.
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+/* The libdvbpsi distribution defines DVBPSI_DIST */
+#ifdef DVBPSI_DIST
+#include "../src/dvbpsi.h"
+#include "../src/psi.h"
+#include "../src/descriptor.h"
+#include "../src/demux.h"
+#include "../src/router.h"
+#include "../src/discovery.h"
+#include "../src/tables/pat.h"
+#include "../src/tables/pmt.h"
+#include "../src/tables/sdt.h"
+#else
+#include <dvbpsi/dvbpsi.h>
+#include <dvbpsi/psi.h>
+#include <dvbpsi/descriptor.h>
+#include <dvbpsi/demux.h>
+#include <dvbpsi/router.h>
+#include <dvbpsi/discovery.h>
+#include <dvbpsi/pat.h>
+#include <dvbpsi/pmt.h>
+#include <dvbpsi/sdt.h>
+#endif
+
+#include "tsfile.h"
+
+#define SIDECAR_MAGIC   "TSVX"
+#define SIDECAR_VERSION 1
+#define RECORD_HEADER   28      /* bytes before the section of a record */
+#define NO_PCR          UINT64_MAX
+
+/*****************************************************************************
+ * Indexing
+ *****************************************************************************/
+typedef struct indexer_s
+{
+  dvbpsi_t *p_encoder;  /* encodes the sections of the tables */
+  FILE     *p_out;
+  bool      b_error;
+  uint64_t  i_offset;   /* of the packet being decoded */
+  uint64_t  i_pcr;      /* last PCR */
+  uint64_t  i_records;
+} indexer_t;
+
+static void Put(uint8_t *p, uint64_t i_value, int i_bytes)
+{
+  for (int i = i_bytes - 1; i >= 0; i--, i_value >>= 8)
+    p[i] = i_value & 0xff;
+}
+
+static uint64_t Get(const uint8_t *p, int i_bytes)
+{
+  uint64_t i_value = 0;
+  for (int i = 0; i < i_bytes; i++)
+    i_value = (i_value << 8) | p[i];
+  return i_value;
+}
+
+static void WriteSections(indexer_t *p_indexer, uint16_t i_pid,
+                          dvbpsi_psi_section_t *p_sections)
+{
+  if (p_sections == NULL)
+  {
+    p_indexer->b_error = true;
+    return;
+  }
+  for (dvbpsi_psi_section_t *p = p_sections; p; p = p->p_next)
+  {
+    uint8_t header[RECORD_HEADER];
+    size_t i_size = p->i_length + 3;
+    Put(header, p_indexer->i_offset, 8);
+    Put(header + 8, p_indexer->i_pcr, 8);
+    Put(header + 16, i_pid, 2);
+    header[18] = p->i_table_id;
+    Put(header + 19, p->i_extension, 2);
+    header[21] = p->i_version;
+    memcpy(header + 22, p->p_data + i_size - 4, 4);
+    Put(header + 26, i_size, 2);
+    if (fwrite(header, RECORD_HEADER, 1, p_indexer->p_out) != 1
+     || fwrite(p->p_data, i_size, 1, p_indexer->p_out) != 1)
+      p_indexer->b_error = true;
+    p_indexer->i_records++;
+  }
+  dvbpsi_DeletePSISections(p_sections);
+}
+
+static void OnTable(void *p_data, uint16_t i_pid, uint8_t i_table_id, void *p_table)
+{
+  indexer_t *p_indexer = (indexer_t *)p_data;
+  dvbpsi_t *p_encoder = p_indexer->p_encoder;
+
+  switch (i_table_id)
+  {
+    case 0x00:
+      WriteSections(p_indexer, i_pid,
+                    dvbpsi_pat_sections_generate(p_encoder, (dvbpsi_pat_t *)p_table, 253));
+      dvbpsi_pat_delete((dvbpsi_pat_t *)p_table);
+      break;
+    case 0x02:
+      WriteSections(p_indexer, i_pid,
+                    dvbpsi_pmt_sections_generate(p_encoder, (dvbpsi_pmt_t *)p_table));
+      dvbpsi_pmt_delete((dvbpsi_pmt_t *)p_table);
+      break;
+    case 0x42:
+      WriteSections(p_indexer, i_pid,
+                    dvbpsi_sdt_sections_generate(p_encoder, (dvbpsi_sdt_t *)p_table));
+      dvbpsi_sdt_delete((dvbpsi_sdt_t *)p_table);
+      break;
+  }
+}
+
+/* Keeps the PCR of a packet, carried by its adaptation field */
+static void ReadPCR(indexer_t *p_indexer, const uint8_t *p_packet)
+{
+  if ((p_packet[3] & 0x20) && p_packet[4] >= 7 && (p_packet[5] & 0x10))
+  {
+    uint64_t i_base = ((uint64_t)p_packet[6] << 25) | ((uint64_t)p_packet[7] << 17)
+                    | ((uint64_t)p_packet[8] << 9) | ((uint64_t)p_packet[9] << 1)
+                    | (p_packet[10] >> 7);
+    uint64_t i_ext = ((uint64_t)(p_packet[10] & 0x01) << 8) | p_packet[11];
+    p_indexer->i_pcr = i_base * 300 + i_ext;
+  }
+}
+
+static bool Index(const char *psz_file, const char *psz_sidecar)
+{
+  ts_file_t *p_file = ts_file_open(psz_file);
+  if (p_file == NULL)
+  {
+    fprintf(stderr, "Could not open %s\n", psz_file);
+    return false;
+  }
+
+  indexer_t indexer;
+  memset(&indexer, 0, sizeof(indexer));
+  indexer.i_pcr = NO_PCR;
+  indexer.p_out = fopen(psz_sidecar, "wb");
+  indexer.p_encoder = dvbpsi_new(NULL, DVBPSI_MSG_NONE);
+  dvbpsi_router_t *p_router = dvbpsi_router_new();
+  dvbpsi_discovery_t *p_discovery = NULL;
+  if (p_router)
+    p_discovery = dvbpsi_discovery_new(p_router, 0, NULL, DVBPSI_MSG_NONE,
+                                       OnTable, &indexer);
+  if (indexer.p_out == NULL || indexer.p_encoder == NULL || p_discovery == NULL)
+  {
+    fprintf(stderr, "Could not create %s\n", psz_sidecar);
+    indexer.b_error = true;
+    goto out;
+  }
+
+  /* the PAT, PMTs and actual SDT */
+  uint8_t tables[32];
+  memset(tables, 0, sizeof(tables));
+  tables[0x00 >> 3] |= 1 << (0x00 & 7);
+  tables[0x02 >> 3] |= 1 << (0x02 & 7);
+  tables[0x42 >> 3] |= 1 << (0x42 & 7);
+  dvbpsi_discovery_set_tables(p_discovery, tables);
+
+  uint8_t magic[5] = { 'T', 'S', 'V', 'X', SIDECAR_VERSION };
+  if (fwrite(magic, sizeof(magic), 1, indexer.p_out) != 1)
+    indexer.b_error = true;
+
+  /* one packet at a time, for the offset of each table */
+  uint8_t *p_packets;
+  size_t i_count;
+  while (!indexer.b_error && (i_count = ts_file_read(p_file, &p_packets)) > 0)
+  {
+    uint64_t i_offset = ts_file_tell(p_file) - i_count * 188;
+    for (size_t i = 0; i < i_count; i++)
+    {
+      uint8_t *p_packet = p_packets + i * 188;
+      ReadPCR(&indexer, p_packet);
+      indexer.i_offset = i_offset + i * 188;
+      dvbpsi_router_push(p_router, p_packet, 1, 188);
+    }
+  }
+  printf("%" PRIu64 " sections indexed\n", indexer.i_records);
+
+out:
+  if (p_discovery)
+    dvbpsi_discovery_delete(p_discovery);
+  if (p_router)
+    dvbpsi_router_delete(p_router);
+  if (indexer.p_encoder)
+    dvbpsi_delete(indexer.p_encoder);
+  if (indexer.p_out && fclose(indexer.p_out) != 0)
+    indexer.b_error = true;
+  ts_file_close(p_file);
+  if (indexer.b_error)
+    fprintf(stderr, "Could not write %s\n", psz_sidecar);
+  return !indexer.b_error;
+}
+
+/*****************************************************************************
+ * Restoring
+ *****************************************************************************/
+typedef struct current_s
+{
+  uint8_t  i_table_id;
+  uint16_t i_extension;
+  size_t   i_first;     /* offset in the sidecar of the first record */
+  size_t   i_end;       /* after the last record */
+} current_t;
+
+static void PrintPAT(void *p_data, dvbpsi_pat_t *p_pat)
+{
+  (void)p_data;
+  printf("  PAT ts_id %d version %d\n", p_pat->i_ts_id, p_pat->i_version);
+  for (dvbpsi_pat_program_t *p = p_pat->p_first_program; p; p = p->p_next)
+    printf("    program %d pid 0x%04x\n", p->i_number, p->i_pid);
+  dvbpsi_pat_delete(p_pat);
+}
+
+static void PrintPMT(void *p_data, dvbpsi_pmt_t *p_pmt)
+{
+  (void)p_data;
+  printf("  PMT program %d version %d pcr_pid 0x%04x\n",
+         p_pmt->i_program_number, p_pmt->i_version, p_pmt->i_pcr_pid);
+  for (dvbpsi_pmt_es_t *p = p_pmt->p_first_es; p; p = p->p_next)
+    printf("    stream type 0x%02x pid 0x%04x\n", p->i_type, p->i_pid);
+  dvbpsi_pmt_delete(p_pmt);
+}
+
+static void PrintSDT(void *p_data, dvbpsi_sdt_t *p_sdt)
+{
+  (void)p_data;
+  printf("  SDT ts_id %d version %d\n", p_sdt->i_extension, p_sdt->i_version);
+  for (dvbpsi_sdt_service_t *p = p_sdt->p_first_service; p; p = p->p_next)
+    printf("    service %d\n", p->i_service_id);
+  dvbpsi_sdt_delete(p_sdt);
+}
+
+static void NewSubtable(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_extension,
+                        void *p_data)
+{
+  if (i_table_id == 0x42)
+    dvbpsi_sdt_attach(p_dvbpsi, i_table_id, i_extension, PrintSDT, p_data);
+}
+
+/* Decodes the sections of a table version with a new decoder */
+static bool RestoreTable(uint8_t *p_sidecar, const current_t *p_current)
+{
+  dvbpsi_t *p_dvbpsi = dvbpsi_new(NULL, DVBPSI_MSG_NONE);
+  if (p_dvbpsi == NULL)
+    return false;
+
+  bool b_attached;
+  if (p_current->i_table_id == 0x00)
+    b_attached = dvbpsi_pat_attach(p_dvbpsi, PrintPAT, NULL);
+  else if (p_current->i_table_id == 0x02)
+    b_attached = dvbpsi_pmt_attach(p_dvbpsi, p_current->i_extension, PrintPMT, NULL);
+  else
+    b_attached = dvbpsi_AttachDemux(p_dvbpsi, NewSubtable, NULL);
+
+  uint8_t *p = p_sidecar + p_current->i_first;
+  printf("offset %" PRIu64 " pid 0x%04x table_id 0x%02x extension %d",
+         Get(p, 8), (unsigned)Get(p + 16, 2), p[18], (unsigned)Get(p + 19, 2));
+  if (Get(p + 8, 8) != NO_PCR)
+    printf(" pcr %" PRIu64, Get(p + 8, 8));
+  printf("\n");
+
+  bool b_ok = b_attached;
+  while (b_ok && p < p_sidecar + p_current->i_end)
+  {
+    size_t i_size = Get(p + 26, 2);
+    b_ok = dvbpsi_section_push(p_dvbpsi, p + RECORD_HEADER, i_size);
+    p += RECORD_HEADER + i_size;
+  }
+
+  if (b_attached)
+  {
+    if (p_current->i_table_id == 0x00)
+      dvbpsi_pat_detach(p_dvbpsi);
+    else if (p_current->i_table_id == 0x02)
+      dvbpsi_pmt_detach(p_dvbpsi);
+    else
+      dvbpsi_DetachDemux(p_dvbpsi);
+  }
+  dvbpsi_delete(p_dvbpsi);
+  return b_ok;
+}
+
+static bool Restore(const char *psz_sidecar, uint64_t i_target)
+{
+  FILE *p_in = fopen(psz_sidecar, "rb");
+  if (p_in == NULL)
+  {
+    fprintf(stderr, "Could not open %s\n", psz_sidecar);
+    return false;
+  }
+
+  uint8_t *p_sidecar = NULL;
+  size_t i_size = 0, i_max = 0;
+  for (;;)
+  {
+    if (i_size == i_max)
+    {
+      i_max = i_max ? 2 * i_max : 65536;
+      uint8_t *p_new = realloc(p_sidecar, i_max);
+      if (p_new == NULL)
+        break;
+      p_sidecar = p_new;
+    }
+    size_t i_read = fread(p_sidecar + i_size, 1, i_max - i_size, p_in);
+    if (i_read == 0)
+      break;
+    i_size += i_read;
+  }
+  fclose(p_in);
+
+  if (i_size < 5 || memcmp(p_sidecar, SIDECAR_MAGIC, 4) || p_sidecar[4] != SIDECAR_VERSION)
+  {
+    fprintf(stderr, "%s is not a table version index\n", psz_sidecar);
+    free(p_sidecar);
+    return false;
+  }
+
+  /* the versions current at the target, the sections of a version
+   * following each other */
+  current_t *p_current = NULL;
+  int i_current = 0, i_current_max = 0;
+  size_t i_pos = 5;
+  while (i_pos + RECORD_HEADER <= i_size)
+  {
+    const uint8_t *p = p_sidecar + i_pos;
+    size_t i_end = i_pos + RECORD_HEADER + Get(p + 26, 2);
+    if (i_end > i_size || Get(p, 8) > i_target)
+      break;
+
+    uint8_t i_table_id = p[18];
+    uint16_t i_extension = Get(p + 19, 2);
+    int i;
+    for (i = 0; i < i_current; i++)
+      if (p_current[i].i_table_id == i_table_id && p_current[i].i_extension == i_extension)
+        break;
+    if (i == i_current)
+    {
+      if (i_current == i_current_max)
+      {
+        i_current_max = i_current_max ? 2 * i_current_max : 16;
+        current_t *p_new = realloc(p_current, i_current_max * sizeof(current_t));
+        if (p_new == NULL)
+          break;
+        p_current = p_new;
+      }
+      p_current[i_current].i_table_id = i_table_id;
+      p_current[i_current].i_extension = i_extension;
+      p_current[i_current].i_first = i_pos;
+      i_current++;
+    }
+    else if (p_current[i].i_end != i_pos)
+      p_current[i].i_first = i_pos;  /* a new version */
+    p_current[i].i_end = i_end;
+    i_pos = i_end;
+  }
+
+  bool b_ok = true;
+  for (int i = 0; i < i_current; i++)
+    if (!RestoreTable(p_sidecar, &p_current[i]))
+      b_ok = false;
+
+  free(p_current);
+  free(p_sidecar);
+  return b_ok;
+}
+
+/*****************************************************************************
+ * Usage
+ *****************************************************************************/
+static void usage(char *name)
+{
+  printf("Usage: %s -o <sidecar> <file>\n", name);
+  printf("       %s -r <offset> <sidecar>\n", name);
+  printf("\n");
+  printf(" -o : index the PAT, PMT and SDT versions of a recording to a sidecar file\n");
+  printf(" -r : print the tables current at a byte offset of the recording of a sidecar\n");
+}
+
+/*****************************************************************************
+ * main
+ *****************************************************************************/
+int main(int i_argc, char* pa_argv[])
+{
+  const char *psz_sidecar = NULL;
+  const char *psz_target = NULL;
+  int c;
+
+  while ((c = getopt(i_argc, pa_argv, "ho:r:")) != -1)
+  {
+    switch (c)
+    {
+      case 'o': psz_sidecar = optarg; break;
+      case 'r': psz_target = optarg; break;
+      case 'h':
+      default:
+        usage(pa_argv[0]);
+        return 1;
+    }
+  }
+  if (optind != i_argc - 1 || (psz_sidecar == NULL) == (psz_target == NULL))
+  {
+    usage(pa_argv[0]);
+    return 1;
+  }
+
+  if (psz_sidecar)
+    return Index(pa_argv[optind], psz_sidecar) ? 0 : 1;
+  return Restore(pa_argv[optind], strtoull(psz_target, NULL, 10)) ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+/*****************************************************************************
+ * tsfile.c: Routines for reading TS packets from a file.
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef HAVE_SYS_MMAN_H
+#   include <sys/mman.h>
+#endif
+
+#if defined(HAVE_INTTYPES_H)
+#   include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#   include <stdint.h>
+#endif
+
+#include "tsfile.h"
+
+#define TS_FILE_BLOCK (TS_FILE_RUN * 188) /* bytes per read() */
+
+struct ts_file_s
+{
+    int      i_fd;
+    uint8_t *p_map;     /* whole file when mapped */
+    size_t   i_map;
+
+    uint8_t *p_buffer;  /* block reads otherwise */
+    size_t   i_pos;     /* next byte of p_data[] */
+    size_t   i_len;     /* bytes available in p_data[] */
+    uint8_t *p_data;
+    uint64_t i_base;    /* offset in the file of p_data[0] */
+};
+
+ts_file_t *ts_file_open( const char *psz_name )
+{
+    ts_file_t *p_file = (ts_file_t *) calloc( 1, sizeof(ts_file_t) );
+    if( !p_file )
+        return NULL;
+
+    if( strcmp( psz_name, "-" ) == 0 )
+        p_file->i_fd = 0;
+    else
+        p_file->i_fd = open( psz_name, O_RDONLY );
+    if( p_file->i_fd < 0 )
+    {
+        free( p_file );
+        return NULL;
+    }
+
+#ifdef HAVE_SYS_MMAN_H
+    struct stat st;
+    if( (fstat( p_file->i_fd, &st ) == 0) && S_ISREG( st.st_mode ) &&
+        (st.st_size > 0) && ((uint64_t)st.st_size <= (size_t)-1) )
+    {
+        /* private mapping, the decoders get writable packets */
+        void *p_map = mmap( NULL, st.st_size, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE, p_file->i_fd, 0 );
+        if( p_map != MAP_FAILED )
+        {
+#ifdef HAVE_MADVISE
+            madvise( p_map, st.st_size, MADV_SEQUENTIAL );
+#endif
+            p_file->p_map = p_file->p_data = p_map;
+            p_file->i_map = p_file->i_len = st.st_size;
+            return p_file;
+        }
+    }
+#endif
+
+    p_file->p_buffer = p_file->p_data = (uint8_t *) malloc( TS_FILE_BLOCK );
+    if( !p_file->p_buffer )
+    {
+        ts_file_close( p_file );
+        return NULL;
+    }
+    return p_file;
+}
+
+void ts_file_close( ts_file_t *p_file )
+{
+#ifdef HAVE_SYS_MMAN_H
+    if( p_file->p_map )
+        munmap( p_file->p_map, p_file->i_map );
+#endif
+    free( p_file->p_buffer );
+    if( p_file->i_fd > 0 )
+        close( p_file->i_fd );
+    free( p_file );
+}
+
+/* Keeps the bytes left and reads more after them, false at the end */
+static bool ts_file_fill( ts_file_t *p_file )
+{
+    if( p_file->p_map )
+        return false;
+
+    size_t i_left = p_file->i_len - p_file->i_pos;
+    memmove( p_file->p_buffer, p_file->p_buffer + p_file->i_pos, i_left );
+    p_file->i_base += p_file->i_pos;
+    p_file->i_pos = 0;
+    p_file->i_len = i_left;
+
+    ssize_t i_rc = read( p_file->i_fd, p_file->p_buffer + i_left,
+                         TS_FILE_BLOCK - i_left );
+    if( i_rc <= 0 )
+        return false;
+    p_file->i_len += i_rc;
+    return true;
+}
+
+size_t ts_file_read( ts_file_t *p_file, uint8_t **pp_packets )
+{
+    for( ;; )
+    {
+        /* skip to a sync byte */
+        while( (p_file->i_pos < p_file->i_len) &&
+               (p_file->p_data[p_file->i_pos] != 0x47) )
+            p_file->i_pos++;
+
+        if( p_file->i_len - p_file->i_pos >= 188 )
+            break;
+        if( !ts_file_fill( p_file ) )
+            return 0;
+    }
+
+    uint8_t *p_packets = p_file->p_data + p_file->i_pos;
+    size_t i_max = (p_file->i_len - p_file->i_pos) / 188;
+    size_t i_count = 1;
+
+    if( i_max > TS_FILE_RUN )
+        i_max = TS_FILE_RUN;
+    while( (i_count < i_max) && (p_packets[i_count * 188] == 0x47) )
+        i_count++;
+
+    p_file->i_pos += i_count * 188;
+    *pp_packets = p_packets;
+    return i_count;
+}
+
+uint64_t ts_file_tell( ts_file_t *p_file )
+{
+    return p_file->i_base + p_file->i_pos;
+}
+
+bool ts_file_seek( ts_file_t *p_file, uint64_t i_offset )
+{
+    if( p_file->p_map )
+    {
+        if( i_offset > p_file->i_map )
+            return false;
+        p_file->i_pos = i_offset;
+        return true;
+    }
+
+    if( lseek( p_file->i_fd, (off_t)i_offset, SEEK_SET ) < 0 )
+        return false;
+    p_file->i_base = i_offset;
+    p_file->i_pos = p_file->i_len = 0;
+    return true;
+}
@@ -0,0 +1,53 @@
+/*****************************************************************************
+ * tsfile.h: Routines for reading TS packets from a file.
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#if !defined(_TSFILE_H_)
+#define _TSFILE_H_ 1
+
+/* Most packets returned by one ts_file_read() */
+#define TS_FILE_RUN 8192
+
+typedef struct ts_file_s ts_file_t;
+
+/* Opens a file, memory-mapped when possible and read by large blocks
+ * otherwise, "-" being the standard input. */
+ts_file_t *ts_file_open( const char *psz_name );
+void ts_file_close( ts_file_t *p_file );
+
+/* Gets the next run of TS packets, skipping the bytes before a sync byte
+ * like a read of one byte at a time would: *pp_packets points to up to
+ * TS_FILE_RUN packets of 188 bytes each starting with a sync byte, valid
+ * until the next call. Returns the number of packets, 0 at the end of the
+ * file. */
+size_t ts_file_read( ts_file_t *p_file, uint8_t **pp_packets );
+
+/* Offset in the file of the byte after the packets last returned */
+uint64_t ts_file_tell( ts_file_t *p_file );
+
+/* Moves to an offset of the file, the next run starting at the first sync
+ * byte from there. Returns false if the file cannot seek, or the offset is
+ * beyond the end of a mapped file. */
+bool ts_file_seek( ts_file_t *p_file, uint64_t i_offset );
+
+#endif
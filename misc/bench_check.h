@@ -0,0 +1,137 @@
+/*****************************************************************************
+ * bench_check.h
+ * Copyright (c)2001-2012 VideoLAN
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *****************************************************************************
+ * Check mode of the benchmarks, run by make check through bench_check.sh.
+ * Instead of timings, which vary from one run to the other, a benchmark
+ * started with --check prints metrics that only change with the code, one
+ * "key value" line each: the instructions retired in user space, counted
+ * with perf_event_open() when the kernel and the CPU allow it, and the
+ * allocations.
+ *****************************************************************************/
+
+#ifdef HAVE_PERF_EVENT_OPEN
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+static bool b_bench_check;
+
+/*****************************************************************************
+ * bench_check_arg
+ *****************************************************************************
+ * Removes --check from the arguments, returns whether it was given.
+ *****************************************************************************/
+static bool bench_check_arg(int *pi_argc, char *argv[])
+{
+  int i, j;
+
+  for(i = j = 1; i < *pi_argc; i++)
+  {
+    if(!strcmp(argv[i], "--check"))
+      b_bench_check = true;
+    else
+      argv[j++] = argv[i];
+  }
+  *pi_argc = j;
+  return b_bench_check;
+}
+
+/*****************************************************************************
+ * bench_counter_open, bench_counter_start, bench_counter_stop
+ *****************************************************************************
+ * Instructions of the calling thread in user space between start and stop.
+ * bench_counter_open() returns -1 without a counter, stop then returns 0.
+ *****************************************************************************/
+static int bench_counter_open(void)
+{
+#ifdef HAVE_PERF_EVENT_OPEN
+  struct perf_event_attr attr;
+
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+  return -1;
+#endif
+}
+
+static void bench_counter_start(int i_fd)
+{
+#ifdef HAVE_PERF_EVENT_OPEN
+  if(i_fd >= 0)
+  {
+    ioctl(i_fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(i_fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+#else
+  (void)i_fd;
+#endif
+}
+
+static uint64_t bench_counter_stop(int i_fd)
+{
+  uint64_t i_count = 0;
+#ifdef HAVE_PERF_EVENT_OPEN
+  if(i_fd >= 0)
+  {
+    ioctl(i_fd, PERF_EVENT_IOC_DISABLE, 0);
+    if(read(i_fd, &i_count, sizeof(i_count)) != sizeof(i_count))
+      i_count = 0;
+  }
+#else
+  (void)i_fd;
+#endif
+  return i_count;
+}
+
+/*****************************************************************************
+ * bench_check_print
+ *****************************************************************************
+ * Prints the metric prefix.name.metric, the name turned into an identifier.
+ *****************************************************************************/
+static void bench_check_print(const char *psz_prefix, const char *psz_name,
+                              const char *psz_metric, double value)
+{
+  bool b_sep = false, b_first = true;
+
+  printf("%s.", psz_prefix);
+  for(; *psz_name; psz_name++)
+  {
+    if((*psz_name >= 'a' && *psz_name <= 'z') ||
+       (*psz_name >= 'A' && *psz_name <= 'Z') ||
+       (*psz_name >= '0' && *psz_name <= '9'))
+    {
+      if(b_sep && !b_first)
+        putchar('_');
+      putchar(*psz_name);
+      b_sep = b_first = false;
+    }
+    else
+      b_sep = true;
+  }
+  printf(".%s %.3f\n", psz_metric, value);
+}
@@ -0,0 +1,87 @@
+#!/bin/sh
+# bench_check.sh: performance regression check, run by make check
+#
+# Usage: bench_check.sh [--update] baseline
+#
+# Runs bench_psi, bench_crc and bench_dr of the current directory with
+# --check (see bench_check.h) and compares each metric with the baseline,
+# made of "key value tolerance" lines, the tolerance being a percentage. A
+# metric above its baseline value by more than the tolerance fails the
+# check, a metric without a baseline value is only reported. With --update
+# the baseline gets the current values, the tolerances of the metrics it
+# already has are kept, the others get 2% for instructions, 0 otherwise.
+
+update=no
+if test "$1" = "--update"; then
+  update=yes
+  shift
+fi
+baseline="$1"
+if test -z "$baseline"; then
+  echo "usage: $0 [--update] baseline" >&2
+  exit 2
+fi
+
+current="${TMPDIR:-/tmp}/bench_check.$$"
+trap 'rm -f "$current" "$current.new"' 0
+: > "$current"
+
+for bench in bench_psi bench_crc bench_dr; do
+  if ! ./$bench --check >> "$current"; then
+    echo "$bench --check FAILED" >&2
+    exit 1
+  fi
+done
+
+if ! grep -q instructions "$current"; then
+  echo "no instruction counter, only the allocations are checked"
+fi
+
+if test "$update" = "yes"; then
+  test -f "$baseline" || : > "$baseline"
+  awk 'NR == FNR {
+         if ($1 ~ /^#/) { print; next }
+         if (NF >= 3) { value[$1] = $2; tol[$1] = $3; order[n++] = $1 }
+         next
+       }
+       {
+         t = ($1 in tol) ? tol[$1] : ($1 ~ /instructions/ ? 2 : 0)
+         line[$1] = $1 " " $2 " " t
+         if (!($1 in tol)) order[n++] = $1
+       }
+       END {
+         for (i = 0; i < n; i++) {
+           k = order[i]
+           print (k in line) ? line[k] : k " " value[k] " " tol[k]
+         }
+       }' "$baseline" "$current" > "$current.new" || exit 1
+  cp "$current.new" "$baseline" || exit 1
+  echo "$baseline updated"
+  exit 0
+fi
+
+if test ! -f "$baseline"; then
+  echo "$baseline: no such baseline" >&2
+  exit 1
+fi
+
+awk 'NR == FNR {
+       if ($1 !~ /^#/ && NF >= 3) { base[$1] = $2; tol[$1] = $3 }
+       next
+     }
+     {
+       if (!($1 in base)) {
+         printf "%-56s %12s  no baseline\n", $1, $2
+         next
+       }
+       limit = base[$1] * (1 + tol[$1] / 100) + 0.0005
+       if ($2 > limit) {
+         printf "%-56s %12s  REGRESSION, baseline %s +%s%%\n", $1, $2, base[$1], tol[$1]
+         failed++
+       }
+       checked++
+     }
+     END {
+       printf "%d metrics checked, %d regressions\n", checked, failed
+       exit failed ? 1 : 0
+     }' "$baseline" "$current"
@@ -0,0 +1,171 @@
+/*****************************************************************************
+ * bench_crc.c: CRC_32 kernels microbenchmark
+ *----------------------------------------------------------------------------
+ * Copyright (c)2001-2012 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ * Checks every CRC_32 kernel the running CPU supports against the byte per
+ * byte reference, then times them on 1 KB and 4 KB sections.
+ *
+ * Usage: bench_crc [--check]. With --check, the instructions per byte are
+ * printed for bench_check.sh instead of the timings, see bench_check.h.
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+
+/* the CRC_32 engine is internal, this tool only builds in the distribution */
+#include "../src/crc32_private.h"
+
+#include "bench_check.h"
+
+#define BENCH_BYTES (256 * 1024 * 1024)
+#define CHECK_BYTES (4 * 1024 * 1024)
+
+/*****************************************************************************
+ * now_us
+ *****************************************************************************/
+static double now_us(void)
+{
+#ifdef HAVE_SYS_TIME_H
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double)tv.tv_sec * 1e6 + (double)tv.tv_usec;
+#else
+  return 0.;
+#endif
+}
+
+/*****************************************************************************
+ * check
+ *****************************************************************************
+ * Compares a kernel with the reference on every length up to 4200 bytes and
+ * checks the residue of a section carrying its own CRC_32 is 0.
+ *****************************************************************************/
+static bool check(dvbpsi_crc32_kernel_t pf_kernel, const uint8_t *p_data)
+{
+  dvbpsi_crc32_kernel_t pf_ref = dvbpsi_crc32_kernel(DVBPSI_CRC32_BYTE);
+  uint8_t p_section[1024 + 4];
+  size_t i;
+
+  for(i = 0; i <= 4200; i++)
+  {
+    if(pf_kernel(0xffffffff, p_data, i) != pf_ref(0xffffffff, p_data, i))
+      return false;
+    if(pf_kernel(0x12345678, p_data + 1, i) != pf_ref(0x12345678, p_data + 1, i))
+      return false;
+  }
+
+  for(i = 0; i < 1024; i++)
+    p_section[i] = p_data[i];
+  uint32_t i_crc = pf_kernel(0xffffffff, p_section, 1024);
+  p_section[1024] = i_crc >> 24;
+  p_section[1025] = i_crc >> 16;
+  p_section[1026] = i_crc >> 8;
+  p_section[1027] = i_crc;
+
+  return pf_kernel(0xffffffff, p_section, 1028) == 0;
+}
+
+/*****************************************************************************
+ * main
+ *****************************************************************************/
+int main(int argc, char *argv[])
+{
+  static const size_t pi_sizes[] = { 1024, 4096 };
+  uint8_t *p_data = malloc(8192);
+  int i_ret = 0;
+  int i_counter = bench_check_arg(&argc, argv) ? bench_counter_open() : -1;
+  size_t i;
+
+  if(p_data == NULL)
+    return 1;
+
+  srand(0x47);
+  for(i = 0; i < 8192; i++)
+    p_data[i] = rand();
+
+  for(int impl = 0; impl < DVBPSI_CRC32_IMPL_MAX; impl++)
+  {
+    dvbpsi_crc32_kernel_t pf_kernel = dvbpsi_crc32_kernel(impl);
+    if(pf_kernel == NULL)
+    {
+      if(!b_bench_check)
+        printf("%-8s not supported\n", dvbpsi_crc32_name(impl));
+      continue;
+    }
+
+    if(!check(pf_kernel, p_data))
+    {
+      printf("%-8s FAILED\n", dvbpsi_crc32_name(impl));
+      i_ret = 1;
+      continue;
+    }
+
+    for(size_t s = 0; b_bench_check && s < sizeof(pi_sizes) / sizeof(pi_sizes[0]); s++)
+    {
+      size_t i_loops = CHECK_BYTES / pi_sizes[s];
+      volatile uint32_t i_sum = 0;
+      char psz_name[32];
+
+      if(i_counter < 0)
+        break;
+      bench_counter_start(i_counter);
+      for(i = 0; i < i_loops; i++)
+        i_sum += pf_kernel(0xffffffff, p_data + (i & 63), pi_sizes[s]);
+      snprintf(psz_name, sizeof(psz_name), "%s %zu", dvbpsi_crc32_name(impl),
+               pi_sizes[s]);
+      bench_check_print("crc", psz_name, "instructions_per_byte",
+                        (double)bench_counter_stop(i_counter) / CHECK_BYTES);
+    }
+
+    for(size_t s = 0; !b_bench_check && s < sizeof(pi_sizes) / sizeof(pi_sizes[0]); s++)
+    {
+      size_t i_loops = BENCH_BYTES / pi_sizes[s];
+      uint32_t i_sum = 0;
+      double start = now_us();
+
+      for(i = 0; i < i_loops; i++)
+        i_sum += pf_kernel(0xffffffff, p_data + (i & 63), pi_sizes[s]);
+
+      double elapsed = now_us() - start;
+      printf("%-8s %4zu bytes: %8.1f MB/s (%08x)\n",
+             dvbpsi_crc32_name(impl), pi_sizes[s],
+             elapsed > 0. ? (double)BENCH_BYTES / elapsed : 0., i_sum);
+    }
+  }
+
+  free(p_data);
+  return i_ret;
+}
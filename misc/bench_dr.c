@@ -0,0 +1,307 @@
+
+/* This file is generated by applying the bench_dr.xsl stylesheet to the
+ * dr.xml description file. DO NOT EDIT !!! */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+
+/* the libdvbpsi distribution defines DVBPSI_DIST */
+#ifdef DVBPSI_DIST
+#include "../src/dvbpsi.h"
+#include "../src/descriptor.h"
+#include "../src/descriptors/dr.h"
+#else
+#include <dvbpsi/dvbpsi.h>
+#include <dvbpsi/descriptor.h>
+#include <dvbpsi/dr.h>
+#endif
+
+#include "bench_dr.h"
+
+  
+/* video stream (b_mpeg2 = false) */
+static int bench_vstream_1(void)
+{
+  BENCH_VARS(vstream);
+  
+  BENCH_set_boolean(b_multiple_frame_rate, 0);
+  BENCH_set_integer(i_frame_rate_code, 3);
+  s_decoded.b_mpeg2 = 0;
+  BENCH_set_boolean(b_constrained_parameter, 0);
+  BENCH_set_boolean(b_still_picture, 0);
+
+  BENCH_ENCODE(VStream);
+  BENCH_DECODE(VStream);
+  BENCH_END(video stream (b_mpeg2 = false));
+
+  return i_err;
+}
+
+/* video stream (b_mpeg2 = true) */
+static int bench_vstream_2(void)
+{
+  BENCH_VARS(vstream);
+  
+  BENCH_set_boolean(b_multiple_frame_rate, 0);
+  BENCH_set_integer(i_frame_rate_code, 3);
+  s_decoded.b_mpeg2 = 12;
+  BENCH_set_boolean(b_constrained_parameter, 0);
+  BENCH_set_boolean(b_still_picture, 0);
+  BENCH_set_integer(i_profile_level_indication, 0x48);
+  BENCH_set_integer(i_chroma_format, 1);
+  BENCH_set_boolean(b_frame_rate_extension, 0);
+
+  BENCH_ENCODE(VStream);
+  BENCH_DECODE(VStream);
+  BENCH_END(video stream (b_mpeg2 = true));
+
+  return i_err;
+}
+
+/* audio stream */
+static int bench_astream_(void)
+{
+  BENCH_VARS(astream);
+  
+  BENCH_set_boolean(b_free_format, 0);
+  BENCH_set_integer(i_id, 1);
+  BENCH_set_integer(i_layer, 2);
+  BENCH_set_boolean(b_variable_rate_audio_indicator, 0);
+
+  BENCH_ENCODE(AStream);
+  BENCH_DECODE(AStream);
+  BENCH_END(audio stream);
+
+  return i_err;
+}
+
+/* hierarchy */
+static int bench_hierarchy_(void)
+{
+  BENCH_VARS(hierarchy);
+  
+  BENCH_set_integer(i_h_type, 3);
+  BENCH_set_integer(i_h_layer_index, 1);
+  BENCH_set_integer(i_h_embedded_layer, 0);
+  BENCH_set_integer(i_h_priority, 1);
+
+  BENCH_ENCODE(Hierarchy);
+  BENCH_DECODE(Hierarchy);
+  BENCH_END(hierarchy);
+
+  return i_err;
+}
+
+/* registration */
+static int bench_registration_(void)
+{
+  BENCH_VARS(registration);
+  
+  s_decoded.i_additional_length = 0;
+  BENCH_set_integer(i_format_identifier, 0x41432d33);
+
+  BENCH_ENCODE(Registration);
+  BENCH_DECODE(Registration);
+  BENCH_END(registration);
+
+  return i_err;
+}
+
+/* data stream alignment */
+static int bench_ds_alignment_(void)
+{
+  BENCH_VARS(ds_alignment);
+  
+  BENCH_set_integer(i_alignment_type, 1);
+
+  BENCH_ENCODE(DSAlignment);
+  BENCH_DECODE(DSAlignment);
+  BENCH_END(data stream alignment);
+
+  return i_err;
+}
+
+/* target background grid */
+static int bench_target_bg_grid_(void)
+{
+  BENCH_VARS(target_bg_grid);
+  
+  BENCH_set_integer(i_horizontal_size, 720);
+  BENCH_set_integer(i_vertical_size, 576);
+  BENCH_set_integer(i_pel_aspect_ratio, 2);
+
+  BENCH_ENCODE(TargetBgGrid);
+  BENCH_DECODE(TargetBgGrid);
+  BENCH_END(target background grid);
+
+  return i_err;
+}
+
+/* video window */
+static int bench_vwindow_(void)
+{
+  BENCH_VARS(vwindow);
+  
+  BENCH_set_integer(i_horizontal_offset, 64);
+  BENCH_set_integer(i_vertical_offset, 32);
+  BENCH_set_integer(i_window_priority, 1);
+
+  BENCH_ENCODE(VWindow);
+  BENCH_DECODE(VWindow);
+  BENCH_END(video window);
+
+  return i_err;
+}
+
+/* conditional access */
+static int bench_ca_(void)
+{
+  BENCH_VARS(ca);
+  
+  s_decoded.i_private_length = 0;
+  BENCH_set_integer(i_ca_system_id, 0x0b00);
+  BENCH_set_integer(i_ca_pid, 0x1ff0);
+
+  BENCH_ENCODE(CA);
+  BENCH_DECODE(CA);
+  BENCH_END(conditional access);
+
+  return i_err;
+}
+
+/* system clock */
+static int bench_system_clock_(void)
+{
+  BENCH_VARS(system_clock);
+  
+  BENCH_set_boolean(b_external_clock_ref, 0);
+  BENCH_set_integer(i_clock_accuracy_integer, 30);
+  BENCH_set_integer(i_clock_accuracy_exponent, 0);
+
+  BENCH_ENCODE(SystemClock);
+  BENCH_DECODE(SystemClock);
+  BENCH_END(system clock);
+
+  return i_err;
+}
+
+/* multiplex buffer utilization */
+static int bench_mx_buff_utilization_(void)
+{
+  BENCH_VARS(mx_buff_utilization);
+  
+  BENCH_set_boolean(b_mdv_valid, 1);
+  BENCH_set_integer(i_mx_delay_variation, 5400);
+  BENCH_set_integer(i_mx_strategy, 1);
+
+  BENCH_ENCODE(MxBuffUtilization);
+  BENCH_DECODE(MxBuffUtilization);
+  BENCH_END(multiplex buffer utilization);
+
+  return i_err;
+}
+
+/* copyright */
+static int bench_copyright_(void)
+{
+  BENCH_VARS(copyright);
+  
+  s_decoded.i_additional_length = 0;
+  BENCH_set_integer(i_copyright_identifier, 0x4d504547);
+
+  BENCH_ENCODE(Copyright);
+  BENCH_DECODE(Copyright);
+  BENCH_END(copyright);
+
+  return i_err;
+}
+
+/* maximum bitrate */
+static int bench_max_bitrate_(void)
+{
+  BENCH_VARS(max_bitrate);
+  
+  BENCH_set_integer(i_max_bitrate, 30000);
+
+  BENCH_ENCODE(MaxBitrate);
+  BENCH_DECODE(MaxBitrate);
+  BENCH_END(maximum bitrate);
+
+  return i_err;
+}
+
+/* private data indicator */
+static int bench_private_data_(void)
+{
+  BENCH_VARS(private_data);
+  
+  BENCH_set_integer(i_private_data, 0x28);
+
+  BENCH_ENCODE(PrivateData);
+  BENCH_DECODE(PrivateData);
+  BENCH_END(private data indicator);
+
+  return i_err;
+}
+
+/* service */
+static int bench_service_(void)
+{
+  BENCH_VARS(service);
+  
+  s_decoded.i_service_provider_name_length = 8;
+  memcpy(s_decoded.i_service_provider_name, "VideoLAN", 8);
+  s_decoded.i_service_name_length = 13;
+  memcpy(s_decoded.i_service_name, "bench service", 13);
+  BENCH_set_integer(i_service_type, 1);
+
+  BENCH_ENCODE(Service);
+  BENCH_DECODE(Service);
+  BENCH_END(service);
+
+  return i_err;
+}
+
+
+/* main function */
+int main(int argc, char *argv[])
+{
+  int i_err = 0;
+  BENCH_INIT(argc, argv);
+  
+  i_err |= bench_vstream_1();
+  i_err |= bench_vstream_2();
+  i_err |= bench_astream_();
+  i_err |= bench_hierarchy_();
+  i_err |= bench_registration_();
+  i_err |= bench_ds_alignment_();
+  i_err |= bench_target_bg_grid_();
+  i_err |= bench_vwindow_();
+  i_err |= bench_ca_();
+  i_err |= bench_system_clock_();
+  i_err |= bench_mx_buff_utilization_();
+  i_err |= bench_copyright_();
+  i_err |= bench_max_bitrate_();
+  i_err |= bench_private_data_();
+  i_err |= bench_service_();
+
+  if(i_err)
+    fprintf(stderr, "At least one benchmark has FAILED !!!\n");
+
+  return i_err;
+}
+
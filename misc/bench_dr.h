@@ -0,0 +1,159 @@
+/*****************************************************************************
+ * bench_dr.h
+ * Copyright (c)2001-2012 VideoLAN
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ *****************************************************************************
+ * Timing of the descriptor generators and decoders described in dr.xml, see
+ * bench_dr.xsl. Each descriptor is encoded then decoded i_bench_loops times
+ * with the bench values of its fields, or their default values. Allocations
+ * are counted with a dvbpsi_set_allocator() allocator. Only included by the
+ * generated bench_dr.c.
+ *
+ * Usage: bench_dr [--check] [loops], 1048576 by default. With --check, the
+ * instructions and the allocations per operation are printed for
+ * bench_check.sh instead of the timings, over 4096 loops by default, see
+ * bench_check.h.
+ *****************************************************************************/
+
+#include "bench_check.h"
+
+#define BENCH_LOOPS (1 << 20)
+#define BENCH_CHECK_LOOPS 4096
+
+static uint64_t i_bench_loops = BENCH_LOOPS;
+static int i_bench_counter = -1;
+static uint64_t i_bench_allocations;
+
+static void *bench_malloc(size_t i_size, void *p_data)
+{
+  (void)p_data;
+  i_bench_allocations++;
+  return malloc(i_size);
+}
+
+static void *bench_calloc(size_t i_count, size_t i_size, void *p_data)
+{
+  (void)p_data;
+  i_bench_allocations++;
+  return calloc(i_count, i_size);
+}
+
+static void bench_free(void *p_ptr, void *p_data)
+{
+  (void)p_data;
+  free(p_ptr);
+}
+
+static double bench_now_us(void)
+{
+#ifdef HAVE_SYS_TIME_H
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double)tv.tv_sec * 1e6 + (double)tv.tv_usec;
+#else
+  return 0.;
+#endif
+}
+
+#define BENCH_INIT(argc, argv)                                          \
+  {                                                                     \
+    static const dvbpsi_allocator_t allocator =                         \
+      { bench_malloc, bench_calloc, bench_free, NULL };                 \
+    if(bench_check_arg(&argc, argv))                                    \
+    {                                                                   \
+      i_bench_loops = BENCH_CHECK_LOOPS;                                \
+      i_bench_counter = bench_counter_open();                           \
+    }                                                                   \
+    if(argc > 1 && atoi(argv[1]) > 0)                                   \
+      i_bench_loops = atoi(argv[1]);                                    \
+    dvbpsi_set_allocator(&allocator);                                   \
+  }
+
+#define BENCH_VARS(sname)                                               \
+  int i_err = 0;                                                        \
+  uint64_t i_loop, i_allocs;                                            \
+  double start, encode_ns, encode_allocs, decode_ns, decode_allocs;     \
+  uint64_t encode_instructions, decode_instructions;                    \
+  dvbpsi_##sname##_dr_t s_decoded;                                      \
+  dvbpsi_descriptor_t * p_descriptor;                                   \
+  memset(&s_decoded, 0, sizeof(s_decoded));
+
+/* generation of the descriptor, and its deletion */
+#define BENCH_ENCODE(fname)                                             \
+  i_allocs = i_bench_allocations;                                       \
+  start = bench_now_us();                                               \
+  bench_counter_start(i_bench_counter);                                 \
+  for(i_loop = 0; !i_err && i_loop < i_bench_loops; i_loop++)          \
+  {                                                                     \
+    p_descriptor = dvbpsi_Gen##fname##Dr(&s_decoded, 0);                \
+    if(p_descriptor == NULL)                                            \
+      i_err = 1;                                                        \
+    dvbpsi_DeleteDescriptors(p_descriptor);                             \
+  }                                                                     \
+  encode_instructions = bench_counter_stop(i_bench_counter);            \
+  encode_ns = (bench_now_us() - start) * 1e3 / i_bench_loops;           \
+  encode_allocs = (double)(i_bench_allocations - i_allocs) / i_bench_loops;
+
+/* decoding of one generated descriptor, and the deletion of the result */
+#define BENCH_DECODE(fname)                                             \
+  p_descriptor = i_err ? NULL : dvbpsi_Gen##fname##Dr(&s_decoded, 0);   \
+  i_allocs = i_bench_allocations;                                       \
+  start = bench_now_us();                                               \
+  bench_counter_start(i_bench_counter);                                 \
+  for(i_loop = 0; p_descriptor && !i_err && i_loop < i_bench_loops; i_loop++) \
+  {                                                                     \
+    if(dvbpsi_Decode##fname##Dr(p_descriptor) == NULL)                  \
+      i_err = 1;                                                        \
+    bench_free(p_descriptor->p_decoded, NULL);                          \
+    p_descriptor->p_decoded = NULL;                                     \
+  }                                                                     \
+  decode_instructions = bench_counter_stop(i_bench_counter);            \
+  decode_ns = (bench_now_us() - start) * 1e3 / i_bench_loops;           \
+  decode_allocs = (double)(i_bench_allocations - i_allocs) / i_bench_loops; \
+  if(p_descriptor == NULL)                                              \
+    i_err = 1;                                                          \
+  dvbpsi_DeleteDescriptors(p_descriptor);
+
+#define BENCH_END(name)                                                 \
+  if(i_err)                                                             \
+    fprintf(stderr, "\"%s\" descriptor benchmark FAILED !!!\n", #name); \
+  else if(b_bench_check)                                                \
+  {                                                                     \
+    if(i_bench_counter >= 0)                                            \
+    {                                                                   \
+      bench_check_print("dr", #name, "encode_instructions",             \
+                        (double)encode_instructions / i_bench_loops);   \
+      bench_check_print("dr", #name, "decode_instructions",             \
+                        (double)decode_instructions / i_bench_loops);   \
+    }                                                                   \
+    bench_check_print("dr", #name, "encode_allocs", encode_allocs);     \
+    bench_check_print("dr", #name, "decode_allocs", decode_allocs);     \
+  }                                                                     \
+  else                                                                  \
+    fprintf(stdout, "%-36s encode %8.1f ns/op %5.2f allocs/op"          \
+            "   decode %8.1f ns/op %5.2f allocs/op\n", "\"" #name "\"",   \
+            encode_ns, encode_allocs, decode_ns, decode_allocs);
+
+
+/* integer */
+#define BENCH_set_integer(name, value)                                  \
+  s_decoded.name = value;
+
+/* boolean */
+#define BENCH_set_boolean(name, value)                                  \
+  s_decoded.name = value;
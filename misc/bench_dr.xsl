@@ -0,0 +1,118 @@
+<?xml version="1.0" encoding="iso-8859-1" ?>
+<xsl:stylesheet xmlns:xsl="http://www.w3.org/1999/XSL/Transform" version="1.0">
+
+<xsl:output method="text" omit-xml-declaration="yes" indent="no" encoding="iso-8859-1" />
+
+<!--             -->
+<!-- entry point -->
+<!--             -->
+
+<xsl:template match="/dr">
+/* This file is generated by applying the bench_dr.xsl stylesheet to the
+ * dr.xml description file. DO NOT EDIT !!! */
+
+#include "config.h"
+
+#include &lt;stdio.h&gt;
+#include &lt;stdlib.h&gt;
+#include &lt;stdbool.h&gt;
+#include &lt;string.h&gt;
+
+#if defined(HAVE_INTTYPES_H)
+#include &lt;inttypes.h&gt;
+#elif defined(HAVE_STDINT_H)
+#include &lt;stdint.h&gt;
+#endif
+
+#ifdef HAVE_SYS_TIME_H
+#include &lt;sys/time.h&gt;
+#endif
+
+/* the libdvbpsi distribution defines DVBPSI_DIST */
+#ifdef DVBPSI_DIST
+#include "../src/dvbpsi.h"
+#include "../src/descriptor.h"
+#include "../src/descriptors/dr.h"
+#else
+#include &lt;dvbpsi/dvbpsi.h&gt;
+#include &lt;dvbpsi/descriptor.h&gt;
+#include &lt;dvbpsi/dr.h&gt;
+#endif
+
+#include "bench_dr.h"
+
+  <xsl:apply-templates mode="code" />
+
+/* main function */
+int main(int argc, char *argv[])
+{
+  int i_err = 0;
+  BENCH_INIT(argc, argv);
+  <xsl:apply-templates mode="main" />
+
+  if(i_err)
+    fprintf(stderr, "At least one benchmark has FAILED !!!\n");
+
+  return i_err;
+}
+
+</xsl:template>
+
+<xsl:template match="text()" priority="-1"/>
+
+<!--                -->
+<!-- code templates -->
+<!--                -->
+
+<xsl:template match="descriptor" mode="code">
+/* <xsl:value-of select="@name" /> */
+static int bench_<xsl:value-of select="@sname" />_<xsl:value-of select="@msuffix" />(void)
+{
+  BENCH_VARS(<xsl:value-of select="@sname" />);
+  <xsl:apply-templates mode="set" />
+
+  BENCH_ENCODE(<xsl:value-of select="@fname" />);
+  BENCH_DECODE(<xsl:value-of select="@fname" />);
+  BENCH_END(<xsl:value-of select="@name" />);
+
+  return i_err;
+}
+</xsl:template>
+
+<xsl:template match="text()" mode="code" priority="-1"/>
+
+<!--               -->
+<!-- set templates -->
+<!--               -->
+
+<xsl:template match="integer" mode="set">
+  BENCH_set_integer(<xsl:value-of select="@name" />, <xsl:choose>
+    <xsl:when test="@bench"><xsl:value-of select="@bench" /></xsl:when>
+    <xsl:otherwise><xsl:value-of select="@default" /></xsl:otherwise>
+  </xsl:choose>);</xsl:template>
+
+<xsl:template match="boolean" mode="set">
+  BENCH_set_boolean(<xsl:value-of select="@name" />, <xsl:choose>
+    <xsl:when test="@bench"><xsl:value-of select="@bench" /></xsl:when>
+    <xsl:otherwise><xsl:value-of select="@default" /></xsl:otherwise>
+  </xsl:choose>);</xsl:template>
+
+<xsl:template match="insert" mode="set">
+  <xsl:choose>
+    <xsl:when test="bench"><xsl:value-of select="bench" /></xsl:when>
+    <xsl:otherwise><xsl:value-of select="begin" /></xsl:otherwise>
+  </xsl:choose>
+</xsl:template>
+
+<xsl:template match="text()" mode="set" priority="-1"/>
+
+<!--                -->
+<!-- main templates -->
+<!--                -->
+
+<xsl:template match="descriptor" mode="main">
+  i_err |= bench_<xsl:value-of select="@sname" />_<xsl:value-of select="@msuffix" />();</xsl:template>
+
+<xsl:template match="text()" mode="main" priority="-1"/>
+
+</xsl:stylesheet>
@@ -0,0 +1,1662 @@
+/*****************************************************************************
+ * bench_psi.c: PSI/SI decoding throughput benchmark
+ *----------------------------------------------------------------------------
+ * Copyright (c)2001-2012 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ * Synthesizes reproducible transport streams with the table generators and
+ * the packetizer of the library, then times their decoding through
+ * dvbpsi_packet_push(), the PAT and PMT decoders and the demux of the SDT,
+ * NIT, BAT and EIT decoders. The profiles are:
+ *
+ *  minimal   PAT, one PMT, SDT and NIT, repeated
+ *  pmt-churn 64 programs whose PMTs all change version every cycle
+ *  eit-storm EIT schedule of 32 services, new versions every cycle
+ *  bat       operator BAT of 400 transport streams over many sections
+ *  cc-storm  the minimal mux with a wrong continuity_counter every 7 packets
+ *  crc       the minimal mux with one PSI packet in 3 corrupted
+ *
+ * and the hostile ones, a corpus of the malformed streams that push the
+ * decoders down their slow paths:
+ *
+ *  bad-length    a section start in every packet, section_length 1021 or
+ *                beyond the limit, never completed
+ *  dr-flood      BAT and NIT of 64 full sections of empty descriptors
+ *  dr-overrun    PAT, PMT, SDT, EIT, NIT and BAT sections with a valid CRC_32
+ *                whose loop and descriptor lengths run past the section
+ *  section-order SDT of 256 sections and a sparse EIT schedule, sent last
+ *                section first, the EIT never complete
+ *
+ * Usage: bench_psi [--check] [--worst] [profile ...], all the profiles by
+ * default. The peak RSS is the one of the process so far, run a single
+ * profile to measure it. With --worst, each packet is measured alone, and
+ * the costliest packet and section are reported with the cost per input
+ * byte, as for the hostile profiles with --check. With --check, the
+ * instructions per packet and the allocations per section are printed for
+ * bench_check.sh instead, see bench_check.h.
+ *
+ * bench_psi --memory reports instead the memory held for each decoded table
+ * type per 1000 programs, services, TS loop entries or events, by category,
+ * and the peak during the assembly of the table. It needs a library
+ * configured with --enable-mem-stats.
+ *
+ * bench_psi --latency [threads [streams]] decodes copies of a mux on 4
+ * threads of 8 streams by default, and reports per table type the
+ * percentiles of the time from the dvbpsi_packet_push() completing a table
+ * to its callback, with the longest dvbpsi_packet_push().
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+#ifdef HAVE_CLOCK_GETTIME
+#include <time.h>
+#endif
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+/* the libdvbpsi distribution defines DVBPSI_DIST */
+#ifdef DVBPSI_DIST
+#include "../src/dvbpsi.h"
+#include "../src/psi.h"
+#include "../src/descriptor.h"
+#include "../src/demux.h"
+#include "../src/packetizer.h"
+#include "../src/tables/pat.h"
+#include "../src/tables/pmt.h"
+#include "../src/tables/sdt.h"
+#include "../src/tables/nit.h"
+#include "../src/tables/bat.h"
+#include "../src/tables/eit.h"
+#include "../src/descriptors/dr.h"
+#else
+#include <dvbpsi/dvbpsi.h>
+#include <dvbpsi/psi.h>
+#include <dvbpsi/descriptor.h>
+#include <dvbpsi/demux.h>
+#include <dvbpsi/packetizer.h>
+#include <dvbpsi/pat.h>
+#include <dvbpsi/pmt.h>
+#include <dvbpsi/sdt.h>
+#include <dvbpsi/nit.h>
+#include <dvbpsi/bat.h>
+#include <dvbpsi/eit.h>
+#include <dvbpsi/dr.h>
+#endif
+
+#include "bench_check.h"
+
+#define BENCH_RING      4096
+#define BENCH_PROGRAMS  64
+#define BENCH_PMT_PID   0x100
+#define BENCH_DECODERS  (BENCH_PROGRAMS + 4)
+
+/*****************************************************************************
+ * Counting allocator
+ *****************************************************************************/
+static uint64_t i_allocations;
+static uint64_t i_allocated_bytes;
+
+static void *count_malloc(size_t i_size, void *p_data)
+{
+  (void)p_data;
+  i_allocations++;
+  i_allocated_bytes += i_size;
+  return malloc(i_size);
+}
+
+static void *count_calloc(size_t i_count, size_t i_size, void *p_data)
+{
+  (void)p_data;
+  i_allocations++;
+  i_allocated_bytes += i_count * i_size;
+  return calloc(i_count, i_size);
+}
+
+static void count_free(void *p_ptr, void *p_data)
+{
+  (void)p_data;
+  free(p_ptr);
+}
+
+/*****************************************************************************
+ * now_us, now_ns, peak_rss_kb
+ *****************************************************************************/
+static double now_us(void)
+{
+#ifdef HAVE_SYS_TIME_H
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double)tv.tv_sec * 1e6 + (double)tv.tv_usec;
+#else
+  return 0.;
+#endif
+}
+
+static double now_ns(void)
+{
+#ifdef HAVE_CLOCK_GETTIME
+  struct timespec ts;
+  if(clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+#endif
+  return now_us() * 1e3;
+}
+
+static long peak_rss_kb(void)
+{
+#ifdef HAVE_SYS_RESOURCE_H
+  struct rusage usage;
+  if(getrusage(RUSAGE_SELF, &usage) == 0)
+    return usage.ru_maxrss;
+#endif
+  return -1;
+}
+
+/*****************************************************************************
+ * stream_t: synthesized transport stream
+ *****************************************************************************/
+typedef struct
+{
+  uint8_t *             p_data;
+  size_t                i_packets;
+  size_t                i_max;
+  dvbpsi_packetizer_t * p_packetizer;
+  uint8_t               p_ring[BENCH_RING * 188];
+  uint8_t               p_cc[8192];     /* of the packets of stream_packet() */
+} stream_t;
+
+static bool stream_reserve(stream_t *p_stream, size_t i_count)
+{
+  if(p_stream->i_packets + i_count > p_stream->i_max)
+  {
+    size_t i_max = 2 * p_stream->i_max + i_count;
+    uint8_t *p_data = realloc(p_stream->p_data, i_max * 188);
+    if(p_data == NULL)
+      return false;
+    p_stream->p_data = p_data;
+    p_stream->i_max = i_max;
+  }
+  return true;
+}
+
+static bool stream_drain(stream_t *p_stream)
+{
+  uint8_t *p_packets;
+  size_t i_count;
+
+  while((i_count = dvbpsi_packetizer_peek(p_stream->p_packetizer, &p_packets)) > 0)
+  {
+    if(!stream_reserve(p_stream, i_count))
+      return false;
+    memcpy(p_stream->p_data + p_stream->i_packets * 188, p_packets, i_count * 188);
+    p_stream->i_packets += i_count;
+    dvbpsi_packetizer_consume(p_stream->p_packetizer, i_count);
+  }
+  return true;
+}
+
+/* Packetizes and frees a list of sections */
+static bool stream_push(stream_t *p_stream, uint16_t i_pid,
+                        dvbpsi_psi_section_t *p_sections)
+{
+  bool b_ok = p_sections != NULL;
+
+  for(dvbpsi_psi_section_t *p = p_sections; b_ok && p; p = p->p_next)
+  {
+    dvbpsi_psi_section_t *p_next = p->p_next;
+
+    /* one section at a time, so that the ring never overflows */
+    p->p_next = NULL;
+    b_ok = dvbpsi_packetizer_push(p_stream->p_packetizer, i_pid, p)
+        && stream_drain(p_stream);
+    p->p_next = p_next;
+  }
+
+  dvbpsi_DeletePSISections(p_sections);
+  return b_ok;
+}
+
+static bool stream_flush(stream_t *p_stream)
+{
+  return dvbpsi_packetizer_flush(p_stream->p_packetizer) && stream_drain(p_stream);
+}
+
+/* Appends a packet of the 184 bytes of payload, for the streams the
+ * packetizer cannot make */
+static bool stream_packet(stream_t *p_stream, uint16_t i_pid, bool b_unit_start,
+                          const uint8_t *p_payload)
+{
+  if(!stream_reserve(p_stream, 1))
+    return false;
+
+  uint8_t *p_packet = p_stream->p_data + p_stream->i_packets++ * 188;
+  p_packet[0] = 0x47;
+  p_packet[1] = (b_unit_start ? 0x40 : 0x00) | (i_pid >> 8);
+  p_packet[2] = i_pid;
+  p_packet[3] = 0x10 | (p_stream->p_cc[i_pid]++ & 0x0f);
+  memcpy(p_packet + 4, p_payload, 184);
+  return true;
+}
+
+/*****************************************************************************
+ * Table builders
+ *****************************************************************************/
+static dvbpsi_psi_section_t *build_pat(dvbpsi_t *p_dvbpsi, unsigned int i_programs,
+                                       uint8_t i_version)
+{
+  dvbpsi_pat_t pat;
+  dvbpsi_pat_init(&pat, 1, i_version, true);
+  for(unsigned int i = 0; i < i_programs; i++)
+    dvbpsi_pat_program_add(&pat, i + 1, BENCH_PMT_PID + i);
+  dvbpsi_psi_section_t *p_sections = dvbpsi_pat_sections_generate(p_dvbpsi, &pat, 253);
+  dvbpsi_pat_empty(&pat);
+  return p_sections;
+}
+
+/* Video then audio ES of a language, alternately */
+static dvbpsi_psi_section_t *build_pmt(dvbpsi_t *p_dvbpsi, unsigned int i_program,
+                                       unsigned int i_es, uint8_t i_version)
+{
+  static uint8_t p_language[] = { 'e', 'n', 'g', 0 };
+  uint16_t i_pid = 0x1000 + 4 * i_program;
+  dvbpsi_pmt_t pmt;
+
+  dvbpsi_pmt_init(&pmt, i_program + 1, i_version, true, i_pid);
+  for(unsigned int e = 0; e < i_es; e++)
+  {
+    dvbpsi_pmt_es_t *p_es = dvbpsi_pmt_es_add(&pmt, e % 2 ? 0x04 : 0x1b, i_pid + e);
+    if(p_es && e % 2)
+      dvbpsi_pmt_es_descriptor_add(p_es, 0x0a, 4, p_language);
+  }
+  dvbpsi_psi_section_t *p_sections = dvbpsi_pmt_sections_generate(p_dvbpsi, &pmt);
+  dvbpsi_pmt_empty(&pmt);
+  return p_sections;
+}
+
+static dvbpsi_psi_section_t *build_sdt(dvbpsi_t *p_dvbpsi, unsigned int i_services,
+                                       uint8_t i_version)
+{
+  uint8_t p_service[32] = { 0x01, 5, 'b', 'e', 'n', 'c', 'h', 8 };
+  dvbpsi_sdt_t sdt;
+
+  memcpy(p_service + 8, "service#", 8);
+  dvbpsi_sdt_init(&sdt, 0x42, 1, i_version, true, 1);
+  for(unsigned int i = 0; i < i_services; i++)
+  {
+    dvbpsi_sdt_service_t *p_srv = dvbpsi_sdt_service_add(&sdt, i + 1, true, true, 4, false);
+    if(p_srv)
+      dvbpsi_sdt_service_descriptor_add(p_srv, 0x48, 16, p_service);
+  }
+  dvbpsi_psi_section_t *p_sections = dvbpsi_sdt_sections_generate(p_dvbpsi, &sdt);
+  dvbpsi_sdt_empty(&sdt);
+  return p_sections;
+}
+
+static dvbpsi_psi_section_t *build_nit(dvbpsi_t *p_dvbpsi, unsigned int i_ts,
+                                       uint8_t i_version)
+{
+  static uint8_t p_name[] = { 'b', 'e', 'n', 'c', 'h' };
+  /* cable delivery system: 346 MHz, QAM 256, 6.9 Mbaud */
+  static uint8_t p_delivery[11] = { 0x03, 0x46, 0x00, 0x00, 0xff, 0xf0, 0x05,
+                                    0x06, 0x90, 0x00, 0x03 };
+  dvbpsi_nit_t nit;
+
+  dvbpsi_nit_init(&nit, 0x40, 1, 1, i_version, true);
+  dvbpsi_nit_descriptor_add(&nit, 0x40, sizeof(p_name), p_name);
+  for(unsigned int i = 0; i < i_ts; i++)
+  {
+    dvbpsi_nit_ts_t *p_ts = dvbpsi_nit_ts_add(&nit, i + 1, 1);
+    if(p_ts)
+      dvbpsi_nit_ts_descriptor_add(p_ts, 0x44, sizeof(p_delivery), p_delivery);
+  }
+  dvbpsi_psi_section_t *p_sections = dvbpsi_nit_sections_generate(p_dvbpsi, &nit, 0x40);
+  dvbpsi_nit_empty(&nit);
+  return p_sections;
+}
+
+static dvbpsi_psi_section_t *build_bat(dvbpsi_t *p_dvbpsi, unsigned int i_ts,
+                                       uint8_t i_version)
+{
+  uint8_t p_services[3 * 40];
+  dvbpsi_bat_t bat;
+
+  dvbpsi_bat_init(&bat, 0x4a, 0x1234, i_version, true);
+  for(unsigned int i = 0; i < i_ts; i++)
+  {
+    dvbpsi_bat_ts_t *p_ts = dvbpsi_bat_ts_add(&bat, i + 1, 1);
+    if(p_ts == NULL)
+      continue;
+    /* service_list_descriptor */
+    for(unsigned int s = 0; s < 40; s++)
+    {
+      p_services[3 * s] = (i * 40 + s) >> 8;
+      p_services[3 * s + 1] = i * 40 + s;
+      p_services[3 * s + 2] = 0x01;
+    }
+    dvbpsi_bat_ts_descriptor_add(p_ts, 0x41, sizeof(p_services), p_services);
+  }
+  dvbpsi_psi_section_t *p_sections = dvbpsi_bat_sections_generate(p_dvbpsi, &bat);
+  dvbpsi_bat_empty(&bat);
+  return p_sections;
+}
+
+static dvbpsi_psi_section_t *build_eit(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                                       unsigned int i_service, unsigned int i_events,
+                                       uint8_t i_version)
+{
+  uint8_t p_event[40] = { 'e', 'n', 'g', 12 };
+  dvbpsi_eit_t eit;
+
+  memcpy(p_event + 4, "bench event ", 12);
+  p_event[16] = 20;
+  memset(p_event + 17, 'x', 20);
+  p_event[37] = 0;
+
+  dvbpsi_eit_init(&eit, i_table_id, i_service + 1, i_version, true, 1, 1, 0, 0x57);
+  for(unsigned int e = 0; e < i_events; e++)
+  {
+    /* half hours of a day, the next day every 48 events */
+    uint64_t i_start = ((uint64_t)(0xe0b5 + e / 48) << 24) | ((e % 48 / 2) << 16)
+                     | ((e % 2) * 0x30 << 8);
+    dvbpsi_eit_event_t *p_ev = dvbpsi_eit_event_add(&eit, e + 1, i_start, 0x003000,
+                                                    1, false, 0);
+    if(p_ev)
+      dvbpsi_eit_event_descriptor_add(p_ev, 0x4d, 38, p_event);
+  }
+  dvbpsi_psi_section_t *p_sections = dvbpsi_eit_sections_generate(p_dvbpsi, &eit, i_table_id);
+  dvbpsi_eit_empty(&eit);
+  return p_sections;
+}
+
+/* Long syntax section of any payload, with its CRC_32 */
+static dvbpsi_psi_section_t *build_raw(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                                       uint16_t i_extension, uint8_t i_version,
+                                       uint8_t i_number, uint8_t i_last_number,
+                                       const uint8_t *p_payload, size_t i_size)
+{
+  dvbpsi_psi_section_t *p_section = dvbpsi_NewPSISection(8 + i_size + 4);
+  if(p_section == NULL)
+    return NULL;
+
+  p_section->i_table_id = i_table_id;
+  p_section->b_syntax_indicator = true;
+  p_section->b_private_indicator = i_table_id >= 0x40;
+  p_section->i_length = 5 + i_size + 4;
+  p_section->i_extension = i_extension;
+  p_section->i_version = i_version;
+  p_section->b_current_next = true;
+  p_section->i_number = i_number;
+  p_section->i_last_number = i_last_number;
+  p_section->p_payload_start = p_section->p_data + 8;
+  memcpy(p_section->p_payload_start, p_payload, i_size);
+  p_section->p_payload_end = p_section->p_payload_start + i_size;
+  dvbpsi_BuildPSISection(p_dvbpsi, p_section);
+  return p_section;
+}
+
+/* Network or bouquet descriptors then 2 transport streams, all empty
+ * descriptors, filling a section of 1024 bytes */
+static dvbpsi_psi_section_t *build_dr_flood(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                                            uint8_t i_number, uint8_t i_version)
+{
+  uint8_t p_payload[1012];
+  size_t i = 0;
+
+  memset(p_payload, 0, sizeof(p_payload));
+  p_payload[i++] = 0xf0 | (400 >> 8);
+  p_payload[i++] = 400 & 0xff;
+  for(unsigned int d = 0; d < 200; d++, i += 2)
+    p_payload[i] = 0x5f;
+  p_payload[i++] = 0xf0 | (604 >> 8);
+  p_payload[i++] = 604 & 0xff;
+  for(unsigned int t = 0; t < 2; t++)
+  {
+    p_payload[i++] = 0;
+    p_payload[i++] = 2 * i_number + t;
+    p_payload[i++] = 0;
+    p_payload[i++] = 1;
+    p_payload[i++] = 0xf0 | (296 >> 8);
+    p_payload[i++] = 296 & 0xff;
+    for(unsigned int d = 0; d < 148; d++, i += 2)
+      p_payload[i] = 0x5f;
+  }
+  return build_raw(p_dvbpsi, i_table_id, i_table_id == 0x4a ? 0x1234 : 1,
+                   i_version, i_number, 63, p_payload, i);
+}
+
+/* Sections of each table whose lengths run past their end */
+static bool push_dr_overrun(stream_t *p_stream, dvbpsi_t *p_dvbpsi, uint8_t i_version)
+{
+  /* PAT: a truncated program */
+  static const uint8_t p_pat[] = { 0x00, 0x01, 0xe1, 0x00, 0x00, 0x02, 0xe1 };
+  /* PMT: program_info_length 4095, a descriptor of 255 bytes */
+  static const uint8_t p_pmt[] = { 0xe1, 0x00, 0xff, 0xff, 0x0a, 0xff, 'e', 'n', 'g' };
+  /* PMT: an ES with es_info_length 4095 */
+  static const uint8_t p_pmt_es[] = { 0xe1, 0x00, 0xf0, 0x00,
+                                      0x1b, 0xe1, 0x00, 0xff, 0xff, 0x0a, 0xff };
+  /* SDT: a service with descriptors_loop_length 4095 */
+  static const uint8_t p_sdt[] = { 0x00, 0x01, 0xff, 0x00, 0x01, 0xfc, 0x8f, 0xff,
+                                   0x48, 0xc8, 0x01 };
+  /* EIT: an event with descriptors_loop_length 4095 */
+  static const uint8_t p_eit[] = { 0x00, 0x01, 0x00, 0x01, 0x00, 0x4e,
+                                   0x00, 0x01, 0xe0, 0xb5, 0x00, 0x00, 0x00,
+                                   0x00, 0x30, 0x00, 0x8f, 0xff, 0x4d, 0xff };
+  /* NIT and BAT: first loop of 4095 bytes */
+  static const uint8_t p_nit[] = { 0xff, 0xff, 0x40, 0xff, 'n', 'e', 't' };
+
+  return stream_push(p_stream, 0x00,
+                     build_raw(p_dvbpsi, 0x00, 1, i_version, 0, 0, p_pat, sizeof(p_pat)))
+      && stream_push(p_stream, BENCH_PMT_PID,
+                     build_raw(p_dvbpsi, 0x02, 1, i_version, 0, 0, p_pmt, sizeof(p_pmt)))
+      && stream_push(p_stream, BENCH_PMT_PID,
+                     build_raw(p_dvbpsi, 0x02, 1, (i_version + 1) % 32, 0, 0,
+                               p_pmt_es, sizeof(p_pmt_es)))
+      && stream_push(p_stream, 0x11,
+                     build_raw(p_dvbpsi, 0x42, 1, i_version, 0, 0, p_sdt, sizeof(p_sdt)))
+      && stream_push(p_stream, 0x12,
+                     build_raw(p_dvbpsi, 0x4e, 1, i_version, 0, 0, p_eit, sizeof(p_eit)))
+      && stream_push(p_stream, 0x10,
+                     build_raw(p_dvbpsi, 0x40, 1, i_version, 0, 0, p_nit, sizeof(p_nit)))
+      && stream_push(p_stream, 0x11,
+                     build_raw(p_dvbpsi, 0x4a, 0x1234, i_version, 0, 0, p_nit, sizeof(p_nit)));
+}
+
+/* SDT of 256 sections, and EIT schedule of one section per segment without
+ * its first one, last section first */
+static bool push_section_order(stream_t *p_stream, dvbpsi_t *p_dvbpsi, uint8_t i_version)
+{
+  uint8_t p_sdt[] = { 0x00, 0x01, 0xff, 0x00, 0x00, 0xfc, 0x80, 0x00 };
+  uint8_t p_eit[] = { 0x00, 0x01, 0x00, 0x01, 0x00, 0x50 };
+  bool b_ok = true;
+
+  for(int n = 255; b_ok && n >= 0; n--)
+  {
+    p_sdt[3] = n >> 8;
+    p_sdt[4] = n;
+    b_ok = stream_push(p_stream, 0x11,
+                       build_raw(p_dvbpsi, 0x42, 1, i_version, n, 255, p_sdt, sizeof(p_sdt)));
+  }
+  for(int n = 248; b_ok && n > 0; n -= 8)
+  {
+    p_eit[4] = n;   /* segment_last_section_number */
+    b_ok = stream_push(p_stream, 0x12,
+                       build_raw(p_dvbpsi, 0x50, 1, i_version, n, 248, p_eit, sizeof(p_eit)));
+  }
+  return b_ok;
+}
+
+/* A section start in every packet, never completed */
+static bool push_bad_length(stream_t *p_stream, unsigned int i_cycle)
+{
+  static const uint16_t pi_pids[] = { 0x00, BENCH_PMT_PID, 0x10, 0x11, 0x12 };
+  static const uint8_t pi_table_ids[] = { 0x00, 0x02, 0x40, 0x42, 0x4e };
+  uint8_t p_payload[184];
+  bool b_ok = true;
+
+  for(unsigned int i = 0; b_ok && i < sizeof(pi_pids) / sizeof(pi_pids[0]); i++)
+  {
+    uint16_t i_length = i_cycle % 3 == 2 ? 0xfff : 1021;
+
+    memset(p_payload, 0xff, sizeof(p_payload));
+    /* pointer_field at the end of the payload every 4 cycles */
+    p_payload[0] = i_cycle % 4 == 3 ? 176 : 0;
+    uint8_t *p_section = p_payload + 1 + p_payload[0];
+    p_section[0] = pi_table_ids[i];
+    p_section[1] = 0xb0 | (i_length >> 8);
+    p_section[2] = i_length & 0xff;
+    p_section[3] = 0x00;
+    p_section[4] = 0x01;
+    p_section[5] = 0xc1 | ((i_cycle % 32) << 1);
+    p_section[6] = 0x00;
+    b_ok = stream_packet(p_stream, pi_pids[i], true, p_payload);
+  }
+  return b_ok;
+}
+
+/*****************************************************************************
+ * Profiles
+ *****************************************************************************/
+typedef enum
+{
+  PROFILE_MINIMAL = 0,
+  PROFILE_PMT_CHURN,
+  PROFILE_EIT_STORM,
+  PROFILE_BAT,
+  PROFILE_CC_STORM,
+  PROFILE_CRC,
+  PROFILE_BAD_LENGTH,
+  PROFILE_DR_FLOOD,
+  PROFILE_DR_OVERRUN,
+  PROFILE_SECTION_ORDER,
+  PROFILE_MAX
+} profile_t;
+
+#define PROFILE_HOSTILE PROFILE_BAD_LENGTH
+
+static const char *const ppsz_profiles[PROFILE_MAX] =
+{
+  "minimal", "pmt-churn", "eit-storm", "bat", "cc-storm", "crc",
+  "bad-length", "dr-flood", "dr-overrun", "section-order",
+};
+
+static bool synthesize(stream_t *p_stream, profile_t i_profile)
+{
+  dvbpsi_t *p_dvbpsi = dvbpsi_new(NULL, DVBPSI_MSG_NONE);
+  bool b_ok = p_dvbpsi != NULL;
+
+  switch(i_profile)
+  {
+  case PROFILE_MINIMAL:
+  case PROFILE_CC_STORM:
+  case PROFILE_CRC:
+    for(unsigned int c = 0; b_ok && c < 20000; c++)
+      b_ok = stream_push(p_stream, 0x00, build_pat(p_dvbpsi, 1, 0))
+          && stream_push(p_stream, BENCH_PMT_PID, build_pmt(p_dvbpsi, 0, 2, 0))
+          && (c % 4 || stream_push(p_stream, 0x11, build_sdt(p_dvbpsi, 1, 0)))
+          && (c % 16 || stream_push(p_stream, 0x10, build_nit(p_dvbpsi, 8, 0)))
+          && stream_flush(p_stream);
+    break;
+  case PROFILE_PMT_CHURN:
+    for(unsigned int c = 0; b_ok && c < 1000; c++)
+    {
+      b_ok = stream_push(p_stream, 0x00, build_pat(p_dvbpsi, BENCH_PROGRAMS, 0));
+      for(unsigned int p = 0; b_ok && p < BENCH_PROGRAMS; p++)
+        b_ok = stream_push(p_stream, BENCH_PMT_PID + p, build_pmt(p_dvbpsi, p, 2, c % 32));
+      b_ok = b_ok && stream_flush(p_stream);
+    }
+    break;
+  case PROFILE_EIT_STORM:
+    for(unsigned int c = 0; b_ok && c < 40; c++)
+    {
+      for(unsigned int s = 0; b_ok && s < 32; s++)
+        for(uint8_t t = 0x50; b_ok && t <= 0x57; t++)
+          b_ok = stream_push(p_stream, 0x12, build_eit(p_dvbpsi, t, s, 48, c % 32));
+      b_ok = b_ok && stream_flush(p_stream);
+    }
+    break;
+  case PROFILE_BAT:
+    for(unsigned int c = 0; b_ok && c < 200; c++)
+      b_ok = stream_push(p_stream, 0x11, build_bat(p_dvbpsi, 400, (c / 10) % 32))
+          && stream_flush(p_stream);
+    break;
+  case PROFILE_BAD_LENGTH:
+    for(unsigned int c = 0; b_ok && c < 20000; c++)
+      b_ok = push_bad_length(p_stream, c);
+    break;
+  case PROFILE_DR_FLOOD:
+    for(unsigned int c = 0; b_ok && c < 16; c++)
+    {
+      for(unsigned int n = 0; b_ok && n < 64; n++)
+        b_ok = stream_push(p_stream, 0x11, build_dr_flood(p_dvbpsi, 0x4a, n, c % 32))
+            && stream_push(p_stream, 0x10, build_dr_flood(p_dvbpsi, 0x40, n, c % 32));
+      b_ok = b_ok && stream_flush(p_stream);
+    }
+    break;
+  case PROFILE_DR_OVERRUN:
+    for(unsigned int c = 0; b_ok && c < 2000; c++)
+      b_ok = push_dr_overrun(p_stream, p_dvbpsi, c % 32) && stream_flush(p_stream);
+    break;
+  case PROFILE_SECTION_ORDER:
+    for(unsigned int c = 0; b_ok && c < 64; c++)
+      b_ok = push_section_order(p_stream, p_dvbpsi, c % 32) && stream_flush(p_stream);
+    break;
+  default:
+    b_ok = false;
+  }
+
+  if(p_dvbpsi)
+    dvbpsi_delete(p_dvbpsi);
+  if(!b_ok)
+    return false;
+
+  /* Damage the mux once it is built */
+  for(size_t i = 0; i < p_stream->i_packets; i++)
+  {
+    uint8_t *p_packet = p_stream->p_data + i * 188;
+    if(i_profile == PROFILE_CC_STORM && i % 7 == 3)
+      p_packet[3] = (p_packet[3] & 0xf0) | ((p_packet[3] + 1) & 0x0f);
+    else if(i_profile == PROFILE_CRC && i % 3 == 1)
+      p_packet[13] ^= 0x5a;
+  }
+  return true;
+}
+
+/*****************************************************************************
+ * Decoders
+ *****************************************************************************/
+typedef enum
+{
+  TABLE_PAT = 0,
+  TABLE_PMT,
+  TABLE_SDT,
+  TABLE_NIT,
+  TABLE_BAT,
+  TABLE_EIT,
+  TABLE_MAX
+} table_t;
+
+static const char *const ppsz_tables[TABLE_MAX] =
+{
+  "pat", "pmt", "sdt", "nit", "bat", "eit",
+};
+
+typedef struct latency_s latency_t;
+static void latency_record(latency_t *p_latency, table_t i_table);
+
+typedef struct
+{
+  dvbpsi_t *  p_pat;
+  dvbpsi_t *  pp_pmt[BENCH_PROGRAMS];
+  dvbpsi_t *  p_sdt;    /* SDT and BAT */
+  dvbpsi_t *  p_nit;
+  dvbpsi_t *  p_eit;
+  uint64_t    i_tables;
+  latency_t * p_latency;    /* of the callbacks, NULL but for --latency */
+} decoders_t;
+
+static void decoders_table(decoders_t *p_dec, table_t i_table)
+{
+  p_dec->i_tables++;
+  if(p_dec->p_latency)
+    latency_record(p_dec->p_latency, i_table);
+}
+
+static void pat_cb(void *p_data, dvbpsi_pat_t *p_pat)
+{
+  decoders_table((decoders_t *)p_data, TABLE_PAT);
+  dvbpsi_pat_delete(p_pat);
+}
+
+static void pmt_cb(void *p_data, dvbpsi_pmt_t *p_pmt)
+{
+  decoders_table((decoders_t *)p_data, TABLE_PMT);
+  dvbpsi_pmt_delete(p_pmt);
+}
+
+static void sdt_cb(void *p_data, dvbpsi_sdt_t *p_sdt)
+{
+  decoders_table((decoders_t *)p_data, TABLE_SDT);
+  dvbpsi_sdt_delete(p_sdt);
+}
+
+static void nit_cb(void *p_data, dvbpsi_nit_t *p_nit)
+{
+  decoders_table((decoders_t *)p_data, TABLE_NIT);
+  dvbpsi_nit_delete(p_nit);
+}
+
+static void bat_cb(void *p_data, dvbpsi_bat_t *p_bat)
+{
+  decoders_table((decoders_t *)p_data, TABLE_BAT);
+  dvbpsi_bat_delete(p_bat);
+}
+
+static void eit_cb(void *p_data, dvbpsi_eit_t *p_eit)
+{
+  decoders_table((decoders_t *)p_data, TABLE_EIT);
+  dvbpsi_eit_delete(p_eit);
+}
+
+static void new_subtable(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_extension,
+                         void *p_data)
+{
+  if(i_table_id == 0x42 || i_table_id == 0x46)
+    dvbpsi_sdt_attach(p_dvbpsi, i_table_id, i_extension, sdt_cb, p_data);
+  else if(i_table_id == 0x4a)
+    dvbpsi_bat_attach(p_dvbpsi, i_table_id, i_extension, bat_cb, p_data);
+  else if(i_table_id == 0x40 || i_table_id == 0x41)
+    dvbpsi_nit_attach(p_dvbpsi, i_table_id, i_extension, nit_cb, p_data);
+  else if(i_table_id >= 0x4e && i_table_id <= 0x6f)
+    dvbpsi_eit_attach(p_dvbpsi, i_table_id, i_extension, eit_cb, p_data);
+}
+
+static bool decoders_open(decoders_t *p_dec)
+{
+  memset(p_dec, 0, sizeof(decoders_t));
+
+  p_dec->p_pat = dvbpsi_new(NULL, DVBPSI_MSG_NONE);
+  if(p_dec->p_pat == NULL || !dvbpsi_pat_attach(p_dec->p_pat, pat_cb, p_dec))
+    return false;
+
+  for(unsigned int i = 0; i < BENCH_PROGRAMS; i++)
+  {
+    p_dec->pp_pmt[i] = dvbpsi_new(NULL, DVBPSI_MSG_NONE);
+    if(p_dec->pp_pmt[i] == NULL
+       || !dvbpsi_pmt_attach(p_dec->pp_pmt[i], i + 1, pmt_cb, p_dec))
+      return false;
+  }
+
+  p_dec->p_sdt = dvbpsi_new(NULL, DVBPSI_MSG_NONE);
+  p_dec->p_nit = dvbpsi_new(NULL, DVBPSI_MSG_NONE);
+  p_dec->p_eit = dvbpsi_new(NULL, DVBPSI_MSG_NONE);
+  return p_dec->p_sdt && dvbpsi_AttachDemux(p_dec->p_sdt, new_subtable, p_dec)
+      && p_dec->p_nit && dvbpsi_AttachDemux(p_dec->p_nit, new_subtable, p_dec)
+      && p_dec->p_eit && dvbpsi_AttachDemux(p_dec->p_eit, new_subtable, p_dec);
+}
+
+static void decoders_close(decoders_t *p_dec)
+{
+  dvbpsi_t *pp_all[BENCH_PROGRAMS + 4] = { p_dec->p_pat, p_dec->p_sdt, p_dec->p_nit,
+                                           p_dec->p_eit };
+  memcpy(pp_all + 4, p_dec->pp_pmt, sizeof(p_dec->pp_pmt));
+
+  for(size_t i = 0; i < sizeof(pp_all) / sizeof(pp_all[0]); i++)
+  {
+    if(pp_all[i] == NULL)
+      continue;
+    if(dvbpsi_decoder_present(pp_all[i]))
+    {
+      if(pp_all[i] == p_dec->p_pat)
+        dvbpsi_pat_detach(pp_all[i]);
+      else if(i >= 4)
+        dvbpsi_pmt_detach(pp_all[i]);
+      else
+        dvbpsi_DetachDemux(pp_all[i]);
+    }
+    dvbpsi_delete(pp_all[i]);
+  }
+}
+
+static uint64_t decoders_sections(decoders_t *p_dec, uint64_t *pi_bad)
+{
+  dvbpsi_t *pp_all[BENCH_PROGRAMS + 4] = { p_dec->p_pat, p_dec->p_sdt, p_dec->p_nit,
+                                           p_dec->p_eit };
+  uint64_t i_sections = 0;
+
+  *pi_bad = 0;
+  memcpy(pp_all + 4, p_dec->pp_pmt, sizeof(p_dec->pp_pmt));
+  for(size_t i = 0; i < sizeof(pp_all) / sizeof(pp_all[0]); i++)
+  {
+    dvbpsi_stats_t stats;
+    dvbpsi_get_stats(pp_all[i], &stats);
+    i_sections += stats.i_sections;
+    *pi_bad += stats.i_dropped_crc;
+  }
+  return i_sections;
+}
+
+/* Index of the decoder of the pid in pp_all of decoders_sections(), or -1 */
+static int decoders_index(decoders_t *p_dec, uint16_t i_pid, dvbpsi_t **pp_dvbpsi)
+{
+  int i_index = -1;
+
+  if(i_pid == 0x00)
+    i_index = 0, *pp_dvbpsi = p_dec->p_pat;
+  else if(i_pid == 0x11)
+    i_index = 1, *pp_dvbpsi = p_dec->p_sdt;
+  else if(i_pid == 0x10)
+    i_index = 2, *pp_dvbpsi = p_dec->p_nit;
+  else if(i_pid == 0x12)
+    i_index = 3, *pp_dvbpsi = p_dec->p_eit;
+  else if(i_pid >= BENCH_PMT_PID && i_pid < BENCH_PMT_PID + BENCH_PROGRAMS)
+    i_index = 4 + i_pid - BENCH_PMT_PID, *pp_dvbpsi = p_dec->pp_pmt[i_pid - BENCH_PMT_PID];
+  return i_index;
+}
+
+/*****************************************************************************
+ * Worst case
+ *****************************************************************************
+ * Each packet is measured alone. The cost of a section is the one of the
+ * packets of its decoder since the previous section, those which only carry
+ * garbage included: the packets of a section which never completes only
+ * show in the cost per byte, the cost of the whole stream over its size.
+ *****************************************************************************/
+typedef struct
+{
+  double      ns;
+  uint64_t    i_instructions;
+  uint64_t    i_allocs;
+} cost_t;
+
+typedef struct
+{
+  cost_t      packet;                     /* costliest packet */
+  cost_t      section;                    /* costliest section */
+  cost_t      total;
+  cost_t      p_pending[BENCH_DECODERS];  /* since the last section */
+  uint64_t    pi_sections[BENCH_DECODERS];
+} worst_t;
+
+static void cost_max(cost_t *p_max, const cost_t *p_cost)
+{
+  if(p_cost->ns > p_max->ns)
+    p_max->ns = p_cost->ns;
+  if(p_cost->i_instructions > p_max->i_instructions)
+    p_max->i_instructions = p_cost->i_instructions;
+  if(p_cost->i_allocs > p_max->i_allocs)
+    p_max->i_allocs = p_cost->i_allocs;
+}
+
+static void cost_add(cost_t *p_sum, const cost_t *p_cost)
+{
+  p_sum->ns += p_cost->ns;
+  p_sum->i_instructions += p_cost->i_instructions;
+  p_sum->i_allocs += p_cost->i_allocs;
+}
+
+static void worst_push(worst_t *p_worst, decoders_t *p_dec, uint8_t *p_packet,
+                       int i_counter)
+{
+  uint16_t i_pid = ((uint16_t)(p_packet[1] & 0x1f) << 8) | p_packet[2];
+  dvbpsi_t *p_dvbpsi;
+  int i_index = decoders_index(p_dec, i_pid, &p_dvbpsi);
+  dvbpsi_stats_t stats;
+  cost_t cost;
+
+  if(i_index < 0)
+    return;
+
+  uint64_t i_first = i_allocations;
+  double start = now_ns();
+  bench_counter_start(i_counter);
+  dvbpsi_packet_push(p_dvbpsi, p_packet);
+  cost.i_instructions = bench_counter_stop(i_counter);
+  cost.ns = now_ns() - start;
+  cost.i_allocs = i_allocations - i_first;
+
+  cost_max(&p_worst->packet, &cost);
+  cost_add(&p_worst->total, &cost);
+  cost_add(&p_worst->p_pending[i_index], &cost);
+
+  dvbpsi_get_stats(p_dvbpsi, &stats);
+  if(stats.i_sections != p_worst->pi_sections[i_index])
+  {
+    p_worst->pi_sections[i_index] = stats.i_sections;
+    cost_max(&p_worst->section, &p_worst->p_pending[i_index]);
+    memset(&p_worst->p_pending[i_index], 0, sizeof(cost_t));
+  }
+}
+
+/*****************************************************************************
+ * run
+ *****************************************************************************/
+static bool run(profile_t i_profile, int i_counter, bool b_worst)
+{
+  stream_t *p_stream = calloc(1, sizeof(stream_t));
+  decoders_t dec;
+  bool b_ok = false;
+
+  if(p_stream == NULL)
+    return false;
+  p_stream->p_packetizer = dvbpsi_packetizer_new(p_stream->p_ring, BENCH_RING);
+  if(p_stream->p_packetizer == NULL || !synthesize(p_stream, i_profile))
+  {
+    fprintf(stderr, "%s: cannot synthesize the stream\n", ppsz_profiles[i_profile]);
+    goto out;
+  }
+
+  if(!decoders_open(&dec))
+  {
+    fprintf(stderr, "%s: cannot create the decoders\n", ppsz_profiles[i_profile]);
+    decoders_close(&dec);
+    goto out;
+  }
+
+  /* The hostile profiles are about their worst case */
+  if(b_bench_check && i_profile >= PROFILE_HOSTILE)
+    b_worst = true;
+
+  worst_t worst;
+  uint64_t i_first = i_allocations;
+  uint64_t i_first_bytes = i_allocated_bytes;
+  double start = now_us();
+
+  memset(&worst, 0, sizeof(worst));
+  if(!b_worst)
+    bench_counter_start(i_counter);
+
+  for(size_t i = 0; i < p_stream->i_packets; i++)
+  {
+    uint8_t *p_packet = p_stream->p_data + i * 188;
+    uint16_t i_pid = ((uint16_t)(p_packet[1] & 0x1f) << 8) | p_packet[2];
+    dvbpsi_t *p_dvbpsi;
+
+    if(b_worst)
+      worst_push(&worst, &dec, p_packet, i_counter);
+    else if(decoders_index(&dec, i_pid, &p_dvbpsi) >= 0)
+      dvbpsi_packet_push(p_dvbpsi, p_packet);
+  }
+
+  uint64_t i_instructions = b_worst ? worst.total.i_instructions
+                                    : bench_counter_stop(i_counter);
+  double elapsed = now_us() - start;
+  double bytes = (double)p_stream->i_packets * 188.;
+  uint64_t i_allocs = i_allocations - i_first;
+  uint64_t i_bytes = i_allocated_bytes - i_first_bytes;
+  uint64_t i_bad;
+  uint64_t i_sections = decoders_sections(&dec, &i_bad);
+
+  if(b_bench_check)
+  {
+    const char *psz_name = ppsz_profiles[i_profile];
+    double sections = i_sections ? (double)i_sections : 1.;
+
+    if(i_counter >= 0)
+      bench_check_print("psi", psz_name, "instructions_per_packet",
+                        (double)i_instructions / (double)p_stream->i_packets);
+    bench_check_print("psi", psz_name, "allocs_per_section",
+                      (double)i_allocs / sections);
+    bench_check_print("psi", psz_name, "bytes_per_section",
+                      (double)i_bytes / sections);
+    if(b_worst)
+    {
+      if(i_counter >= 0)
+      {
+        bench_check_print("psi", psz_name, "max_instructions_per_packet",
+                          (double)worst.packet.i_instructions);
+        bench_check_print("psi", psz_name, "max_instructions_per_section",
+                          (double)worst.section.i_instructions);
+        bench_check_print("psi", psz_name, "instructions_per_byte",
+                          (double)i_instructions / bytes);
+      }
+      bench_check_print("psi", psz_name, "max_allocs_per_packet",
+                        (double)worst.packet.i_allocs);
+      bench_check_print("psi", psz_name, "max_allocs_per_section",
+                        (double)worst.section.i_allocs);
+    }
+    decoders_close(&dec);
+    b_ok = true;
+    goto out;
+  }
+
+  printf("%-9s %8zu packets %8"PRIu64" sections (%6"PRIu64" bad CRC) %7"PRIu64" tables: "
+         "%7.2f Mpackets/s %8.0f ksections/s %7.0f ns/section "
+         "%6.2f allocs/section %7ld KB peak RSS\n",
+         ppsz_profiles[i_profile], p_stream->i_packets, i_sections, i_bad, dec.i_tables,
+         elapsed > 0. ? (double)p_stream->i_packets / elapsed : 0.,
+         elapsed > 0. ? (double)i_sections * 1e3 / elapsed : 0.,
+         i_sections ? elapsed * 1e3 / (double)i_sections : 0.,
+         i_sections ? (double)i_allocs / (double)i_sections : 0.,
+         peak_rss_kb());
+  if(b_worst)
+    printf("%-9s worst: %8.0f ns/packet %9.0f ns/section %6.2f ns/byte "
+           "%3"PRIu64" allocs/packet %5"PRIu64" allocs/section\n",
+           ppsz_profiles[i_profile], worst.packet.ns, worst.section.ns,
+           worst.total.ns / bytes, worst.packet.i_allocs, worst.section.i_allocs);
+  decoders_close(&dec);
+  b_ok = true;
+
+out:
+  if(p_stream->p_packetizer)
+    dvbpsi_packetizer_delete(p_stream->p_packetizer);
+  free(p_stream->p_data);
+  free(p_stream);
+  return b_ok;
+}
+
+/*****************************************************************************
+ * Memory
+ *****************************************************************************
+ * Each table type is built with BENCH_ENTITIES programs, services, TS loop
+ * entries or events, the PMT with the BENCH_PMT_ES ES of one section,
+ * decoded from its packets by a handle of its own and kept, then its
+ * descriptors decoded. What the library holds then, from dvbpsi_mem_stats(),
+ * is reported per 1000 entities by category, with the peak of the memory
+ * and of the sections during the assembly, sampled after each packet.
+ *****************************************************************************/
+#define BENCH_ENTITIES  1000
+#define BENCH_PMT_ES    90
+
+static const struct
+{
+  const char *  psz_entities;
+  uint16_t      i_pid;
+} p_memory_tables[TABLE_MAX] =
+{
+  { "programs", 0x00 },
+  { "ES",       BENCH_PMT_PID },
+  { "services", 0x11 },
+  { "TS",       0x10 },
+  { "TS",       0x11 },
+  { "events",   0x12 },
+};
+
+typedef struct
+{
+  dvbpsi_pat_t *  p_pat;
+  dvbpsi_pmt_t *  p_pmt;
+  dvbpsi_sdt_t *  p_sdt;
+  dvbpsi_nit_t *  p_nit;
+  dvbpsi_bat_t *  p_bat;
+  dvbpsi_eit_t *  p_eit;
+} kept_t;
+
+static void keep_pat_cb(void *p_data, dvbpsi_pat_t *p_pat)
+{
+  kept_t *p_kept = (kept_t *)p_data;
+  if(p_kept->p_pat)
+    dvbpsi_pat_delete(p_kept->p_pat);
+  p_kept->p_pat = p_pat;
+}
+
+static void keep_pmt_cb(void *p_data, dvbpsi_pmt_t *p_pmt)
+{
+  kept_t *p_kept = (kept_t *)p_data;
+  if(p_kept->p_pmt)
+    dvbpsi_pmt_delete(p_kept->p_pmt);
+  p_kept->p_pmt = p_pmt;
+}
+
+static void keep_sdt_cb(void *p_data, dvbpsi_sdt_t *p_sdt)
+{
+  kept_t *p_kept = (kept_t *)p_data;
+  if(p_kept->p_sdt)
+    dvbpsi_sdt_delete(p_kept->p_sdt);
+  p_kept->p_sdt = p_sdt;
+}
+
+static void keep_nit_cb(void *p_data, dvbpsi_nit_t *p_nit)
+{
+  kept_t *p_kept = (kept_t *)p_data;
+  if(p_kept->p_nit)
+    dvbpsi_nit_delete(p_kept->p_nit);
+  p_kept->p_nit = p_nit;
+}
+
+static void keep_bat_cb(void *p_data, dvbpsi_bat_t *p_bat)
+{
+  kept_t *p_kept = (kept_t *)p_data;
+  if(p_kept->p_bat)
+    dvbpsi_bat_delete(p_kept->p_bat);
+  p_kept->p_bat = p_bat;
+}
+
+static void keep_eit_cb(void *p_data, dvbpsi_eit_t *p_eit)
+{
+  kept_t *p_kept = (kept_t *)p_data;
+  if(p_kept->p_eit)
+    dvbpsi_eit_delete(p_kept->p_eit);
+  p_kept->p_eit = p_eit;
+}
+
+static void keep_subtable(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_extension,
+                          void *p_data)
+{
+  if(i_table_id == 0x42)
+    dvbpsi_sdt_attach(p_dvbpsi, i_table_id, i_extension, keep_sdt_cb, p_data);
+  else if(i_table_id == 0x4a)
+    dvbpsi_bat_attach(p_dvbpsi, i_table_id, i_extension, keep_bat_cb, p_data);
+  else if(i_table_id == 0x40)
+    dvbpsi_nit_attach(p_dvbpsi, i_table_id, i_extension, keep_nit_cb, p_data);
+  else if(i_table_id >= 0x4e && i_table_id <= 0x6f)
+    dvbpsi_eit_attach(p_dvbpsi, i_table_id, i_extension, keep_eit_cb, p_data);
+}
+
+static void decode_list(dvbpsi_descriptor_t *p_descriptors)
+{
+  if(p_descriptors)
+    dvbpsi_decode_descriptors(p_descriptors, DVBPSI_DESCRIPTOR_CONTEXT_DVB, NULL);
+}
+
+/* Decodes the descriptors of the kept table, returns its number of
+ * entities, 0 if there is none */
+static unsigned int kept_decode(kept_t *p_kept, table_t i_table)
+{
+  unsigned int i_entities = 0;
+
+  switch(i_table)
+  {
+  case TABLE_PAT:
+    if(p_kept->p_pat)
+      for(dvbpsi_pat_program_t *p = p_kept->p_pat->p_first_program; p; p = p->p_next)
+        i_entities++;
+    break;
+  case TABLE_PMT:
+    if(p_kept->p_pmt == NULL)
+      break;
+    decode_list(p_kept->p_pmt->p_first_descriptor);
+    for(dvbpsi_pmt_es_t *p = p_kept->p_pmt->p_first_es; p; p = p->p_next, i_entities++)
+      decode_list(p->p_first_descriptor);
+    break;
+  case TABLE_SDT:
+    if(p_kept->p_sdt == NULL)
+      break;
+    for(dvbpsi_sdt_service_t *p = p_kept->p_sdt->p_first_service; p;
+        p = p->p_next, i_entities++)
+      decode_list(p->p_first_descriptor);
+    break;
+  case TABLE_NIT:
+    if(p_kept->p_nit == NULL)
+      break;
+    decode_list(p_kept->p_nit->p_first_descriptor);
+    for(dvbpsi_nit_ts_t *p = p_kept->p_nit->p_first_ts; p; p = p->p_next, i_entities++)
+      decode_list(p->p_first_descriptor);
+    break;
+  case TABLE_BAT:
+    if(p_kept->p_bat == NULL)
+      break;
+    decode_list(p_kept->p_bat->p_first_descriptor);
+    for(dvbpsi_bat_ts_t *p = p_kept->p_bat->p_first_ts; p; p = p->p_next, i_entities++)
+      decode_list(p->p_first_descriptor);
+    break;
+  case TABLE_EIT:
+    if(p_kept->p_eit == NULL)
+      break;
+    for(dvbpsi_eit_event_t *p = p_kept->p_eit->p_first_event; p;
+        p = p->p_next, i_entities++)
+      decode_list(p->p_first_descriptor);
+    break;
+  default:
+    break;
+  }
+  return i_entities;
+}
+
+static void kept_delete(kept_t *p_kept)
+{
+  if(p_kept->p_pat)
+    dvbpsi_pat_delete(p_kept->p_pat);
+  if(p_kept->p_pmt)
+    dvbpsi_pmt_delete(p_kept->p_pmt);
+  if(p_kept->p_sdt)
+    dvbpsi_sdt_delete(p_kept->p_sdt);
+  if(p_kept->p_nit)
+    dvbpsi_nit_delete(p_kept->p_nit);
+  if(p_kept->p_bat)
+    dvbpsi_bat_delete(p_kept->p_bat);
+  if(p_kept->p_eit)
+    dvbpsi_eit_delete(p_kept->p_eit);
+}
+
+static int64_t mem_delta(const dvbpsi_mem_stats_t *p_after,
+                         const dvbpsi_mem_stats_t *p_before, int i_category)
+{
+  return (int64_t)p_after->i_bytes[i_category] - (int64_t)p_before->i_bytes[i_category];
+}
+
+static int64_t mem_total(const dvbpsi_mem_stats_t *p_after,
+                         const dvbpsi_mem_stats_t *p_before)
+{
+  int64_t i_total = 0;
+  for(int c = 0; c < DVBPSI_MEM_CATEGORY_MAX; c++)
+    i_total += mem_delta(p_after, p_before, c);
+  return i_total;
+}
+
+static bool memory_run(table_t i_table)
+{
+  const char *psz_name = ppsz_tables[i_table];
+  unsigned int i_entities = i_table == TABLE_PMT ? BENCH_PMT_ES : BENCH_ENTITIES;
+  stream_t *p_stream = calloc(1, sizeof(stream_t));
+  dvbpsi_t *p_dvbpsi = dvbpsi_new(NULL, DVBPSI_MSG_NONE);
+  dvbpsi_psi_section_t *p_sections = NULL;
+  dvbpsi_mem_stats_t before, stats;
+  int64_t i_peak = 0, i_peak_sections = 0;
+  kept_t kept;
+  bool b_ok = false;
+
+  memset(&kept, 0, sizeof(kept));
+  if(p_stream == NULL || p_dvbpsi == NULL)
+    goto out;
+  p_stream->p_packetizer = dvbpsi_packetizer_new(p_stream->p_ring, BENCH_RING);
+  if(p_stream->p_packetizer == NULL)
+    goto out;
+
+  switch(i_table)
+  {
+  case TABLE_PAT:
+    p_sections = build_pat(p_dvbpsi, i_entities, 0);
+    break;
+  case TABLE_PMT:
+    p_sections = build_pmt(p_dvbpsi, 0, i_entities, 0);
+    break;
+  case TABLE_SDT:
+    p_sections = build_sdt(p_dvbpsi, i_entities, 0);
+    break;
+  case TABLE_NIT:
+    p_sections = build_nit(p_dvbpsi, i_entities, 0);
+    break;
+  case TABLE_BAT:
+    p_sections = build_bat(p_dvbpsi, i_entities, 0);
+    break;
+  case TABLE_EIT:
+    p_sections = build_eit(p_dvbpsi, 0x50, 0, i_entities, 0);
+    break;
+  default:
+    break;
+  }
+  if(!stream_push(p_stream, p_memory_tables[i_table].i_pid, p_sections)
+     || !stream_flush(p_stream))
+  {
+    fprintf(stderr, "%s: cannot synthesize the table\n", psz_name);
+    goto out;
+  }
+
+  if(i_table == TABLE_PAT)
+    b_ok = dvbpsi_pat_attach(p_dvbpsi, keep_pat_cb, &kept);
+  else if(i_table == TABLE_PMT)
+    b_ok = dvbpsi_pmt_attach(p_dvbpsi, 1, keep_pmt_cb, &kept);
+  else
+    b_ok = dvbpsi_AttachDemux(p_dvbpsi, keep_subtable, &kept);
+  if(!b_ok)
+  {
+    fprintf(stderr, "%s: cannot create the decoder\n", psz_name);
+    goto out;
+  }
+
+  dvbpsi_mem_stats(&before);
+  for(size_t i = 0; i < p_stream->i_packets; i++)
+  {
+    dvbpsi_packet_push(p_dvbpsi, p_stream->p_data + i * 188);
+
+    dvbpsi_mem_stats(&stats);
+    int64_t i_sections = mem_delta(&stats, &before, DVBPSI_MEM_SECTION)
+                       + mem_delta(&stats, &before, DVBPSI_MEM_SECTION_LIST);
+    int64_t i_total = mem_total(&stats, &before);
+    if(i_sections > i_peak_sections)
+      i_peak_sections = i_sections;
+    if(i_total > i_peak)
+      i_peak = i_total;
+  }
+
+  i_entities = kept_decode(&kept, i_table);
+  b_ok = i_entities > 0;
+  if(!b_ok)
+  {
+    fprintf(stderr, "%s: the table was not decoded\n", psz_name);
+    goto out;
+  }
+  dvbpsi_mem_stats(&stats);
+
+  printf("%-3s %4u %-8s %5zu packets, bytes per 1000:", psz_name, i_entities,
+         p_memory_tables[i_table].psz_entities, p_stream->i_packets);
+  for(int c = 0; c < DVBPSI_MEM_CATEGORY_MAX; c++)
+    printf(" %s %.0f", dvbpsi_mem_category_name(c),
+           (double)mem_delta(&stats, &before, c) * 1000. / i_entities);
+  printf(" total %.0f, assembly peak %"PRId64" B (sections %"PRId64" B)\n",
+         (double)mem_total(&stats, &before) * 1000. / i_entities,
+         i_peak, i_peak_sections);
+
+out:
+  kept_delete(&kept);
+  if(p_dvbpsi)
+  {
+    if(dvbpsi_decoder_present(p_dvbpsi))
+    {
+      if(i_table == TABLE_PAT)
+        dvbpsi_pat_detach(p_dvbpsi);
+      else if(i_table == TABLE_PMT)
+        dvbpsi_pmt_detach(p_dvbpsi);
+      else
+        dvbpsi_DetachDemux(p_dvbpsi);
+    }
+    dvbpsi_delete(p_dvbpsi);
+  }
+  if(p_stream)
+  {
+    if(p_stream->p_packetizer)
+      dvbpsi_packetizer_delete(p_stream->p_packetizer);
+    free(p_stream->p_data);
+    free(p_stream);
+  }
+  return b_ok;
+}
+
+static bool memory(void)
+{
+  dvbpsi_mem_stats_t stats;
+  bool b_ok = true;
+
+  if(!dvbpsi_mem_stats(&stats))
+  {
+    fprintf(stderr, "--memory needs a libdvbpsi configured with --enable-mem-stats\n");
+    return false;
+  }
+  for(int i = 0; i < TABLE_MAX; i++)
+    if(!memory_run(i))
+      b_ok = false;
+  return b_ok;
+}
+
+/*****************************************************************************
+ * Latency
+ *****************************************************************************
+ * Worker threads each decode several copies of a mux of PAT, PMTs, SDT, NIT,
+ * BAT and EIT schedule whose tables all change version every cycle, each
+ * copy started at its own offset and the copies interleaved packet by
+ * packet. The latency of a table is the time from the start of the
+ * dvbpsi_packet_push() of the packet completing it to its callback, the
+ * decoding of the table included, which the histograms of
+ * dvbpsi_get_latency_histogram() measure in stream time and so leave out.
+ *****************************************************************************/
+#define BENCH_THREADS   4
+#define BENCH_STREAMS   8
+#define BENCH_CYCLES    32
+
+struct latency_s
+{
+  double      start;                      /* of the packet being pushed */
+  uint32_t *  pp_samples[TABLE_MAX];      /* ns */
+  size_t      pi_samples[TABLE_MAX];
+  size_t      pi_max[TABLE_MAX];
+  double      max_push;
+  bool        b_error;
+};
+
+static void latency_record(latency_t *p_latency, table_t i_table)
+{
+  double ns = now_ns() - p_latency->start;
+
+  if(p_latency->pi_samples[i_table] == p_latency->pi_max[i_table])
+  {
+    size_t i_max = 2 * p_latency->pi_max[i_table] + 256;
+    uint32_t *p_samples = realloc(p_latency->pp_samples[i_table],
+                                  i_max * sizeof(uint32_t));
+    if(p_samples == NULL)
+    {
+      p_latency->b_error = true;
+      return;
+    }
+    p_latency->pp_samples[i_table] = p_samples;
+    p_latency->pi_max[i_table] = i_max;
+  }
+  p_latency->pp_samples[i_table][p_latency->pi_samples[i_table]++] =
+      ns < 4e9 ? (uint32_t)ns : UINT32_MAX;
+}
+
+static bool synthesize_mux(stream_t *p_stream)
+{
+  dvbpsi_t *p_dvbpsi = dvbpsi_new(NULL, DVBPSI_MSG_NONE);
+  bool b_ok = p_dvbpsi != NULL;
+
+  for(unsigned int c = 0; b_ok && c < BENCH_CYCLES; c++)
+  {
+    b_ok = stream_push(p_stream, 0x00, build_pat(p_dvbpsi, BENCH_PROGRAMS, c));
+    for(unsigned int p = 0; b_ok && p < BENCH_PROGRAMS; p++)
+      b_ok = stream_push(p_stream, BENCH_PMT_PID + p, build_pmt(p_dvbpsi, p, 2, c));
+    b_ok = b_ok && stream_push(p_stream, 0x11, build_sdt(p_dvbpsi, BENCH_PROGRAMS, c))
+                && stream_push(p_stream, 0x10, build_nit(p_dvbpsi, BENCH_PROGRAMS, c))
+                && stream_push(p_stream, 0x11, build_bat(p_dvbpsi, 400, c));
+    for(unsigned int e = 0; b_ok && e < 16; e++)
+      b_ok = stream_push(p_stream, 0x12, build_eit(p_dvbpsi, 0x50 + e % 2, e / 2, 48, c));
+    b_ok = b_ok && stream_flush(p_stream);
+  }
+
+  if(p_dvbpsi)
+    dvbpsi_delete(p_dvbpsi);
+  return b_ok;
+}
+
+#ifdef HAVE_PTHREAD_H
+typedef struct
+{
+  pthread_t           thread;
+  const stream_t *    p_stream;
+  unsigned int        i_worker;
+  unsigned int        i_workers;
+  unsigned int        i_streams;
+  latency_t           latency;
+  bool                b_ok;
+} latency_worker_t;
+
+static void *latency_work(void *p_data)
+{
+  latency_worker_t *p_worker = (latency_worker_t *)p_data;
+  const stream_t *p_stream = p_worker->p_stream;
+  decoders_t *p_decs = calloc(p_worker->i_streams, sizeof(decoders_t));
+  size_t *pi_offsets = calloc(p_worker->i_streams, sizeof(size_t));
+  unsigned int i_open = 0;
+
+  if(p_decs == NULL || pi_offsets == NULL)
+    goto out;
+  for(; i_open < p_worker->i_streams; i_open++)
+  {
+    decoders_t *p_dec = &p_decs[i_open];
+    if(!decoders_open(p_dec))
+    {
+      decoders_close(p_dec);
+      goto out;
+    }
+    p_dec->p_latency = &p_worker->latency;
+    pi_offsets[i_open] = (p_worker->i_worker + (size_t)i_open * p_worker->i_workers)
+                       * p_stream->i_packets
+                       / ((size_t)p_worker->i_workers * p_worker->i_streams);
+  }
+
+  for(size_t i = 0; i < p_stream->i_packets; i++)
+    for(unsigned int s = 0; s < p_worker->i_streams; s++)
+    {
+      uint8_t *p_packet = p_stream->p_data
+                        + (i + pi_offsets[s]) % p_stream->i_packets * 188;
+      uint16_t i_pid = ((uint16_t)(p_packet[1] & 0x1f) << 8) | p_packet[2];
+      dvbpsi_t *p_dvbpsi;
+
+      if(decoders_index(&p_decs[s], i_pid, &p_dvbpsi) < 0)
+        continue;
+      p_worker->latency.start = now_ns();
+      dvbpsi_packet_push(p_dvbpsi, p_packet);
+      double ns = now_ns() - p_worker->latency.start;
+      if(ns > p_worker->latency.max_push)
+        p_worker->latency.max_push = ns;
+    }
+  p_worker->b_ok = !p_worker->latency.b_error;
+
+out:
+  for(unsigned int s = 0; s < i_open; s++)
+    decoders_close(&p_decs[s]);
+  free(p_decs);
+  free(pi_offsets);
+  return NULL;
+}
+
+static int compare_samples(const void *p_a, const void *p_b)
+{
+  uint32_t a = *(const uint32_t *)p_a, b = *(const uint32_t *)p_b;
+  return a < b ? -1 : a > b;
+}
+
+/* Nearest rank percentile of sorted samples */
+static uint32_t percentile(const uint32_t *p_samples, size_t i_count, double q)
+{
+  size_t i_rank = (size_t)(q * (double)i_count + .999999);
+  return p_samples[i_rank > 0 ? i_rank - 1 : 0];
+}
+
+static bool latency(unsigned int i_workers, unsigned int i_streams)
+{
+  stream_t *p_stream = calloc(1, sizeof(stream_t));
+  latency_worker_t *p_workers = calloc(i_workers, sizeof(latency_worker_t));
+  unsigned int i_started = 0;
+  bool b_ok = false;
+
+  if(p_stream == NULL || p_workers == NULL)
+    goto out;
+  p_stream->p_packetizer = dvbpsi_packetizer_new(p_stream->p_ring, BENCH_RING);
+  if(p_stream->p_packetizer == NULL || !synthesize_mux(p_stream))
+  {
+    fprintf(stderr, "latency: cannot synthesize the stream\n");
+    goto out;
+  }
+
+  double start = now_us();
+  for(; i_started < i_workers; i_started++)
+  {
+    latency_worker_t *p_worker = &p_workers[i_started];
+    p_worker->p_stream = p_stream;
+    p_worker->i_worker = i_started;
+    p_worker->i_workers = i_workers;
+    p_worker->i_streams = i_streams;
+    if(pthread_create(&p_worker->thread, NULL, latency_work, p_worker) != 0)
+    {
+      fprintf(stderr, "latency: cannot create thread %u\n", i_started);
+      break;
+    }
+  }
+
+  b_ok = i_started == i_workers;
+  double max_push = 0.;
+  for(unsigned int w = 0; w < i_started; w++)
+  {
+    pthread_join(p_workers[w].thread, NULL);
+    if(!p_workers[w].b_ok)
+    {
+      fprintf(stderr, "latency: worker %u failed\n", w);
+      b_ok = false;
+    }
+    if(p_workers[w].latency.max_push > max_push)
+      max_push = p_workers[w].latency.max_push;
+  }
+  double elapsed = now_us() - start;
+  if(!b_ok)
+    goto out;
+
+  double packets = (double)p_stream->i_packets * i_workers * i_streams;
+  printf("latency %u threads x %u streams of %zu packets: %7.2f Mpackets/s, "
+         "%9.0f ns max push\n", i_workers, i_streams, p_stream->i_packets,
+         elapsed > 0. ? packets / elapsed : 0., max_push);
+
+  for(int t = 0; t < TABLE_MAX; t++)
+  {
+    size_t i_count = 0;
+    for(unsigned int w = 0; w < i_workers; w++)
+      i_count += p_workers[w].latency.pi_samples[t];
+    if(i_count == 0)
+      continue;
+
+    uint32_t *p_samples = malloc(i_count * sizeof(uint32_t));
+    if(p_samples == NULL)
+    {
+      b_ok = false;
+      break;
+    }
+    size_t i = 0;
+    for(unsigned int w = 0; w < i_workers; w++)
+    {
+      memcpy(p_samples + i, p_workers[w].latency.pp_samples[t],
+             p_workers[w].latency.pi_samples[t] * sizeof(uint32_t));
+      i += p_workers[w].latency.pi_samples[t];
+    }
+    qsort(p_samples, i_count, sizeof(uint32_t), compare_samples);
+
+    printf("%-3s %8zu tables: %8"PRIu32" ns p50 %8"PRIu32" ns p99 "
+           "%8"PRIu32" ns p99.9 %9"PRIu32" ns max\n", ppsz_tables[t], i_count,
+           percentile(p_samples, i_count, .5), percentile(p_samples, i_count, .99),
+           percentile(p_samples, i_count, .999), p_samples[i_count - 1]);
+    free(p_samples);
+  }
+
+out:
+  if(p_workers)
+  {
+    for(unsigned int w = 0; w < i_workers; w++)
+      for(int t = 0; t < TABLE_MAX; t++)
+        free(p_workers[w].latency.pp_samples[t]);
+    free(p_workers);
+  }
+  if(p_stream)
+  {
+    if(p_stream->p_packetizer)
+      dvbpsi_packetizer_delete(p_stream->p_packetizer);
+    free(p_stream->p_data);
+    free(p_stream);
+  }
+  return b_ok;
+}
+#else
+static bool latency(unsigned int i_workers, unsigned int i_streams)
+{
+  (void)i_workers;
+  (void)i_streams;
+  (void)synthesize_mux;
+  fprintf(stderr, "--latency needs threads\n");
+  return false;
+}
+#endif
+
+/*****************************************************************************
+ * main
+ *****************************************************************************/
+int main(int argc, char *argv[])
+{
+  static const dvbpsi_allocator_t allocator =
+  {
+    count_malloc, count_calloc, count_free, NULL
+  };
+  int i_ret = 0;
+
+  /* Several threads, without the counting allocator */
+  if(argc > 1 && !strcmp(argv[1], "--latency"))
+  {
+    int i_workers = argc > 2 ? atoi(argv[2]) : BENCH_THREADS;
+    int i_streams = argc > 3 ? atoi(argv[3]) : BENCH_STREAMS;
+    if(i_workers <= 0 || i_streams <= 0)
+    {
+      fprintf(stderr, "usage: bench_psi --latency [threads [streams]]\n");
+      return 1;
+    }
+    return latency(i_workers, i_streams) ? 0 : 1;
+  }
+
+  int i_counter = bench_check_arg(&argc, argv) ? bench_counter_open() : -1;
+  bool b_worst = argc > 1 && !strcmp(argv[1], "--worst");
+
+  if(b_worst)
+  {
+    argv++;
+    argc--;
+  }
+
+  dvbpsi_set_allocator(&allocator);
+
+  if(argc > 1 && !strcmp(argv[1], "--memory"))
+    return memory() ? 0 : 1;
+
+  if(argc < 2)
+  {
+    for(int i = 0; i < PROFILE_MAX; i++)
+      if(!run(i, i_counter, b_worst))
+        i_ret = 1;
+    return i_ret;
+  }
+
+  for(int a = 1; a < argc; a++)
+  {
+    int i;
+    for(i = 0; i < PROFILE_MAX; i++)
+      if(!strcmp(argv[a], ppsz_profiles[i]))
+        break;
+    if(i == PROFILE_MAX)
+    {
+      fprintf(stderr, "unknown profile %s\n", argv[a]);
+      i_ret = 1;
+    }
+    else if(!run(i, i_counter, b_worst))
+      i_ret = 1;
+  }
+  return i_ret;
+}
@@ -0,0 +1,134 @@
+<?xml version="1.0" encoding="iso-8859-1" ?>
+<xsl:stylesheet xmlns:xsl="http://www.w3.org/1999/XSL/Transform" version="1.0">
+
+<xsl:output method="text" omit-xml-declaration="yes" indent="no" encoding="iso-8859-1" />
+
+<xsl:variable name="lower" select="'abcdefghijklmnopqrstuvwxyz'" />
+<xsl:variable name="upper" select="'ABCDEFGHIJKLMNOPQRSTUVWXYZ'" />
+
+<!--             -->
+<!-- entry point -->
+<!--             -->
+
+<xsl:template match="/dr">/* This file is generated by applying the dr_codec.xsl stylesheet to the
+ * dr.xml description file. DO NOT EDIT !!! */
+
+/*****************************************************************************
+ * dr_codec.h: fixed-size fields of the descriptors
+ *****************************************************************************
+ * Each descriptor of dr.xml with a tag and a length has:
+ *  - DVBPSI_&lt;SNAME&gt;_DR_LENGTH, the size in bytes of the block of its
+ *    fixed-size fields at the start of the descriptor data,
+ *  - dvbpsi_unpack_&lt;sname&gt;_dr(), which reads these fields,
+ *  - dvbpsi_pack_&lt;sname&gt;_dr(), which writes them, reserved bits set to 1.
+ * The block is handled as one big endian 64 bit word, without any test:
+ * the caller checks once that the data holds DVBPSI_&lt;SNAME&gt;_DR_LENGTH
+ * bytes. Only the functions of the dr_*.h headers included before are
+ * defined.
+ *****************************************************************************/
+
+#ifndef _DVBPSI_DR_CODEC_H_
+#define _DVBPSI_DR_CODEC_H_
+<xsl:apply-templates select="descriptor[@tag and @length]" mode="code" />
+#else
+#error "Multiple inclusions of dr_codec.h"
+#endif
+</xsl:template>
+
+<!--                -->
+<!-- code templates -->
+<!--                -->
+
+<xsl:template match="descriptor" mode="code">
+  <xsl:variable name="bits"
+    select="sum(integer/@bitcount | reserved/@bitcount) + count(boolean)" />
+  <xsl:if test="$bits != @length * 8 or @length &gt; 8">
+    <xsl:message terminate="yes">
+      <xsl:value-of select="@name" />: <xsl:value-of select="$bits" /> bits in <xsl:value-of select="@length" /> bytes
+    </xsl:message>
+  </xsl:if>
+  <xsl:variable name="sname" select="@sname" />
+  <xsl:variable name="SNAME" select="translate(@sname, $lower, $upper)" />
+  <xsl:variable name="TAG" select="translate(substring(@tag, 3), $lower, $upper)" />
+#ifdef _DVBPSI_DR_<xsl:value-of select="$TAG" />_H_
+/* <xsl:value-of select="@name" />, tag <xsl:value-of select="@tag" /> */
+#define DVBPSI_<xsl:value-of select="$SNAME" />_DR_LENGTH <xsl:value-of select="@length" />
+
+static inline void dvbpsi_unpack_<xsl:value-of select="$sname" />_dr(dvbpsi_<xsl:value-of select="$sname" />_dr_t *p_decoded, const uint8_t *p_data)
+{
+    const uint64_t i_bits =<xsl:call-template name="load">
+      <xsl:with-param name="i" select="0" />
+      <xsl:with-param name="n" select="@length" />
+    </xsl:call-template>;
+<xsl:apply-templates mode="unpack" />}
+
+static inline void dvbpsi_pack_<xsl:value-of select="$sname" />_dr(uint8_t *p_data, const dvbpsi_<xsl:value-of select="$sname" />_dr_t *p_decoded)
+{
+    uint64_t i_bits = 0;
+<xsl:apply-templates mode="pack" /><xsl:call-template name="store">
+      <xsl:with-param name="i" select="0" />
+      <xsl:with-param name="n" select="@length" />
+    </xsl:call-template>}
+#endif
+</xsl:template>
+
+<!-- bit offset of a field from the start of the block -->
+<xsl:template name="offset">
+  <xsl:value-of select="sum(preceding-sibling::integer/@bitcount | preceding-sibling::reserved/@bitcount) + count(preceding-sibling::boolean)" />
+</xsl:template>
+
+<xsl:template name="load">
+  <xsl:param name="i" />
+  <xsl:param name="n" />
+  <xsl:if test="$i &gt; 0"><xsl:text> |&#10;                           </xsl:text></xsl:if>
+  <xsl:text> ((uint64_t)p_data[</xsl:text><xsl:value-of select="$i" />] &lt;&lt; <xsl:value-of select="56 - 8 * $i" /><xsl:text>)</xsl:text>
+  <xsl:if test="$i + 1 &lt; $n">
+    <xsl:call-template name="load">
+      <xsl:with-param name="i" select="$i + 1" />
+      <xsl:with-param name="n" select="$n" />
+    </xsl:call-template>
+  </xsl:if>
+</xsl:template>
+
+<xsl:template name="store">
+  <xsl:param name="i" />
+  <xsl:param name="n" />
+  <xsl:text>    p_data[</xsl:text><xsl:value-of select="$i" />] = i_bits &gt;&gt; <xsl:value-of select="56 - 8 * $i" /><xsl:text>;&#10;</xsl:text>
+  <xsl:if test="$i + 1 &lt; $n">
+    <xsl:call-template name="store">
+      <xsl:with-param name="i" select="$i + 1" />
+      <xsl:with-param name="n" select="$n" />
+    </xsl:call-template>
+  </xsl:if>
+</xsl:template>
+
+<xsl:template match="text()" mode="code" priority="-1"/>
+
+<!--                  -->
+<!-- unpack templates -->
+<!--                  -->
+
+<xsl:template match="integer" mode="unpack">    p_decoded-&gt;<xsl:value-of select="@name" /> = i_bits &lt;&lt; <xsl:call-template name="offset" /> &gt;&gt; <xsl:value-of select="64 - @bitcount" />;
+</xsl:template>
+
+<xsl:template match="boolean" mode="unpack">    p_decoded-&gt;<xsl:value-of select="@name" /> = i_bits &lt;&lt; <xsl:call-template name="offset" /> &gt;&gt; 63;
+</xsl:template>
+
+<xsl:template match="text()" mode="unpack" priority="-1"/>
+
+<!--                -->
+<!-- pack templates -->
+<!--                -->
+
+<xsl:template match="integer" mode="pack">    i_bits |= (uint64_t)p_decoded-&gt;<xsl:value-of select="@name" /> &lt;&lt; <xsl:value-of select="64 - @bitcount" /> &gt;&gt; <xsl:call-template name="offset" />;
+</xsl:template>
+
+<xsl:template match="boolean" mode="pack">    i_bits |= (uint64_t)p_decoded-&gt;<xsl:value-of select="@name" /> &lt;&lt; 63 &gt;&gt; <xsl:call-template name="offset" />;
+</xsl:template>
+
+<xsl:template match="reserved" mode="pack">    i_bits |= ~(uint64_t)0 &lt;&lt; <xsl:value-of select="64 - @bitcount" /> &gt;&gt; <xsl:call-template name="offset" />;
+</xsl:template>
+
+<xsl:template match="text()" mode="pack" priority="-1"/>
+
+</xsl:stylesheet>
@@ -35,37 +35,75 @@
 #endif
 
 
+/*****************************************************************************
+ * xpow_mod
+ *****************************************************************************
+ * Computes x^n modulo the CRC_32 polynomial, n >= 32.
+ *****************************************************************************/
+static uint32_t xpow_mod(uint32_t n)
+{
+  uint32_t r = 0x04c11db7;     /* x^32 mod P */
+
+  for(; n > 32; n--)
+    r = (r << 1) ^ ((r & 0x80000000) ? 0x04c11db7 : 0);
+
+  return r;
+}
+
 /*****************************************************************************
  * main
+ *****************************************************************************
+ * Prints the 8 slicing tables used by src/crc32.c. table[0] is the classic
+ * byte per byte table, table[n] is table[n - 1] advanced by one more zero
+ * byte. The carry-less multiplication folding constants follow.
  *****************************************************************************/
 int main(void)
 {
-  uint32_t table[256];
-  uint32_t i, j, k;
+  uint32_t table[8][256];
+  uint32_t i, j, k, n;
 
   for(i = 0; i < 256; i++)
   {
     k = 0;
     for (j = (i << 24) | 0x800000; j != 0x80000000; j <<= 1)
       k = (k << 1) ^ (((k ^ j) & 0x80000000) ? 0x04c11db7 : 0);
-    table[i] = k;
+    table[0][i] = k;
   }
 
-  printf("static uint32_t table[256] =\n{\n");
-  for(i = 0; i < 64; i++)
+  for(n = 1; n < 8; n++)
+    for(i = 0; i < 256; i++)
+      table[n][i] = (table[n - 1][i] << 8)
+                    ^ table[0][table[n - 1][i] >> 24];
+
+  printf("static const uint32_t table[8][256] =\n{\n");
+  for(n = 0; n < 8; n++)
   {
-    printf("  0x%08x, 0x%08x, 0x%08x, 0x%08x",
-           table[i << 2 | 0],
-           table[i << 2 | 1],
-           table[i << 2 | 2],
-           table[i << 2 | 3]);
-    if(i < 63)
-      printf(",\n");
+    printf("  {\n");
+    for(i = 0; i < 64; i++)
+    {
+      printf("    0x%08x, 0x%08x, 0x%08x, 0x%08x",
+             table[n][i << 2 | 0],
+             table[n][i << 2 | 1],
+             table[n][i << 2 | 2],
+             table[n][i << 2 | 3]);
+      if(i < 63)
+        printf(",\n");
+      else
+        printf("\n");
+    }
+    if(n < 7)
+      printf("  },\n");
     else
-      printf("\n");
+      printf("  }\n");
   }
-  printf("};\n");
+  printf("};\n\n");
+
+  printf("/* x^192, x^128 mod P: fold by 128 bits */\n");
+  printf("#define CRC32_K_128_HI 0x%08x\n", xpow_mod(192));
+  printf("#define CRC32_K_128_LO 0x%08x\n", xpow_mod(128));
+  printf("/* x^576, x^512 mod P: fold by 512 bits */\n");
+  printf("#define CRC32_K_512_HI 0x%08x\n", xpow_mod(576));
+  printf("#define CRC32_K_512_LO 0x%08x\n", xpow_mod(512));
 
   return 0;
 }
-
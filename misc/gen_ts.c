@@ -0,0 +1,751 @@
+/*****************************************************************************
+ * gen_ts.c: paced TS sender, a load source for the benchmarks
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ * Sends a TS file or a section log, see seclog.h, in real time to many UDP
+ * destinations at once, 7 packets per datagram. The input is loaded in
+ * memory and the send time of each packet computed once:
+ *
+ *  - for a TS file, from the PCR of the first PID carrying one, the packets
+ *    between two PCR being spread evenly, or from the bitrate of -b when
+ *    the file has less than two PCR;
+ *  - for a section log, from the bitrate of -b, or from the arrival times
+ *    of the log with -u, the number of time units of the log per second.
+ *    The sections are packetized by the packetizer of the library.
+ *
+ * Usage: gen_ts [-b bitrate] [-u units] [-l loops] [-d seconds] [-n count]
+ *               [-t ttl] input address:port ...
+ *
+ *  -b  bitrate in bits per second without PCR, 10000000 by default
+ *  -u  time units per second of the section log, to follow its times
+ *  -l  number of times the input is sent, 0 for ever, 1 by default
+ *  -d  stop after this number of seconds
+ *  -n  number of streams per address, sent to successive ports
+ *  -t  TTL, or hop limit, of multicast datagrams, 1 by default
+ *
+ * Every destination is an independent stream of the input. When looping,
+ * the continuity_counter of each PID and the PCR are restamped so that the
+ * streams stay continuous, the PTS and DTS are left as they are. All the
+ * streams are served by a single thread and socket: the datagrams due are
+ * gathered across the streams and sent by batches with sendmmsg() where it
+ * is available, which keeps hundreds of streams within a core. A datagram
+ * may leave up to GEN_TS_SLACK ns before its time, to batch more.
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <getopt.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+#ifdef HAVE_CLOCK_GETTIME
+#include <time.h>
+#endif
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netdb.h>
+
+/* the libdvbpsi distribution defines DVBPSI_DIST */
+#ifdef DVBPSI_DIST
+#include "../src/dvbpsi.h"
+#include "../src/psi.h"
+#include "../src/packetizer.h"
+#include "../src/seclog.h"
+#else
+#include <dvbpsi/dvbpsi.h>
+#include <dvbpsi/psi.h>
+#include <dvbpsi/packetizer.h>
+#include <dvbpsi/seclog.h>
+#endif
+
+#define GEN_TS_PACKETS  7               /* per datagram */
+#define GEN_TS_BATCH    64              /* datagrams per system call */
+#define GEN_TS_SLACK    250000          /* ns */
+#define GEN_TS_RING     32              /* packets of the packetizer */
+
+#define PCR_MODULO      (((int64_t)1 << 33) * 300)
+
+/*****************************************************************************
+ * input_t: the packets of the input and their send times
+ *****************************************************************************/
+typedef struct
+{
+  uint8_t *     p_packets;
+  int64_t *     pi_time;        /* ns from the start of a loop */
+  size_t        i_packets;
+  size_t        i_max;
+  int64_t       i_duration;     /* of a loop, ns */
+  int64_t       i_duration_pcr; /* of a loop, 27 MHz */
+  /* continuity_counter of the first and last packets with a payload */
+  uint8_t       pi_first_cc[8192];
+  uint8_t       pi_last_cc[8192];
+  bool          pb_payload[8192];
+  uint16_t *    pi_pids;        /* PIDs with a payload, but the null one */
+  size_t        i_pids;
+} input_t;
+
+static bool input_append(input_t *p_input, const uint8_t *p_packet)
+{
+  if(p_input->i_packets == p_input->i_max)
+  {
+    size_t i_max = 2 * p_input->i_max + 1024;
+    uint8_t *p_packets = realloc(p_input->p_packets, i_max * 188);
+    if(p_packets == NULL)
+      return false;
+    p_input->p_packets = p_packets;
+    int64_t *pi_time = realloc(p_input->pi_time, i_max * sizeof(int64_t));
+    if(pi_time == NULL)
+      return false;
+    p_input->pi_time = pi_time;
+    p_input->i_max = i_max;
+  }
+  memcpy(p_input->p_packets + 188 * p_input->i_packets, p_packet, 188);
+  p_input->pi_time[p_input->i_packets++] = 0;
+  return true;
+}
+
+static bool packet_pcr(const uint8_t *p_packet, int64_t *pi_pcr)
+{
+  if(!(p_packet[3] & 0x20) || p_packet[4] < 7 || !(p_packet[5] & 0x10))
+    return false;
+  int64_t i_base = ((int64_t)p_packet[6] << 25) | (p_packet[7] << 17)
+                 | (p_packet[8] << 9) | (p_packet[9] << 1) | (p_packet[10] >> 7);
+  *pi_pcr = i_base * 300 + (((p_packet[10] & 0x01) << 8) | p_packet[11]);
+  return true;
+}
+
+static void packet_set_pcr(uint8_t *p_packet, int64_t i_pcr)
+{
+  int64_t i_base = i_pcr / 300;
+  int i_ext = i_pcr % 300;
+
+  p_packet[6] = i_base >> 25;
+  p_packet[7] = i_base >> 17;
+  p_packet[8] = i_base >> 9;
+  p_packet[9] = i_base >> 1;
+  p_packet[10] = ((i_base & 0x01) << 7) | 0x7e | (i_ext >> 8);
+  p_packet[11] = i_ext;
+}
+
+/* Sets the send times from a bitrate */
+static void input_time_bitrate(input_t *p_input, uint64_t i_bitrate)
+{
+  double f_packet = 188. * 8. * 1e9 / (double)i_bitrate;
+
+  for(size_t i = 0; i < p_input->i_packets; i++)
+    p_input->pi_time[i] = (int64_t)(f_packet * (double)i);
+  p_input->i_duration = (int64_t)(f_packet * (double)p_input->i_packets);
+}
+
+/* Sets the send times from the PCR, false if there are less than two */
+static bool input_time_pcr(input_t *p_input)
+{
+  int i_pcr_pid = -1;
+  size_t i_last = 0;            /* packet of the last PCR */
+  int64_t i_last_pcr = 0;
+  int64_t i_time = 0;           /* of the last PCR, 27 MHz */
+  double f_rate = 0.;           /* 27 MHz per packet */
+  size_t i_count = 0;
+  int64_t *pi_time = p_input->pi_time;
+
+  for(size_t i = 0; i < p_input->i_packets; i++)
+  {
+    const uint8_t *p_packet = p_input->p_packets + 188 * i;
+    int i_pid = ((p_packet[1] & 0x1f) << 8) | p_packet[2];
+    int64_t i_pcr;
+
+    if(i_pcr_pid != -1 && i_pid != i_pcr_pid)
+      continue;
+    if(!packet_pcr(p_packet, &i_pcr))
+      continue;
+    if(i_pcr_pid == -1)
+    {
+      i_pcr_pid = i_pid;
+      i_last = i;
+      i_last_pcr = i_pcr;
+      i_count = 1;
+      continue;
+    }
+
+    int64_t i_delta = (i_pcr - i_last_pcr + PCR_MODULO) % PCR_MODULO;
+    /* a PCR discontinuity keeps the rate of the previous interval */
+    if(i_delta == 0 || i_delta > 27000000)
+      i_delta = (int64_t)(f_rate * (double)(i - i_last));
+    else
+      f_rate = (double)i_delta / (double)(i - i_last);
+    if(i_count == 1 && f_rate > 0.)
+    {
+      /* the packets before the first PCR at the rate of the first interval */
+      for(size_t j = 0; j <= i_last; j++)
+        pi_time[j] = (int64_t)(f_rate * (double)j);
+      i_time = pi_time[i_last];
+    }
+    for(size_t j = i_last + 1; j <= i; j++)
+      pi_time[j] = i_time + i_delta * (int64_t)(j - i_last) / (int64_t)(i - i_last);
+    i_time = pi_time[i];
+    i_last = i;
+    i_last_pcr = i_pcr;
+    i_count++;
+  }
+  if(i_count < 2 || f_rate <= 0.)
+    return false;
+
+  /* the packets after the last PCR at the rate of the last interval */
+  for(size_t j = i_last + 1; j < p_input->i_packets; j++)
+    pi_time[j] = i_time + (int64_t)(f_rate * (double)(j - i_last));
+  p_input->i_duration_pcr = pi_time[p_input->i_packets - 1] + (int64_t)f_rate;
+  for(size_t i = 0; i < p_input->i_packets; i++)
+    pi_time[i] = pi_time[i] * 1000 / 27;
+  p_input->i_duration = p_input->i_duration_pcr * 1000 / 27;
+  return true;
+}
+
+/* Reads the payloads of the packets, for the restamping */
+static bool input_index(input_t *p_input)
+{
+  p_input->pi_pids = malloc(8192 * sizeof(uint16_t));
+  if(p_input->pi_pids == NULL)
+    return false;
+  for(size_t i = 0; i < p_input->i_packets; i++)
+  {
+    const uint8_t *p_packet = p_input->p_packets + 188 * i;
+    uint16_t i_pid = ((p_packet[1] & 0x1f) << 8) | p_packet[2];
+
+    if(!(p_packet[3] & 0x10) || i_pid == 0x1fff)
+      continue;
+    if(!p_input->pb_payload[i_pid])
+    {
+      p_input->pb_payload[i_pid] = true;
+      p_input->pi_first_cc[i_pid] = p_packet[3] & 0x0f;
+      p_input->pi_pids[p_input->i_pids++] = i_pid;
+    }
+    p_input->pi_last_cc[i_pid] = p_packet[3] & 0x0f;
+  }
+  return true;
+}
+
+static bool load_ts(input_t *p_input, const uint8_t *p_data, size_t i_size)
+{
+  size_t i = 0;
+
+  while(i + 188 <= i_size)
+  {
+    if(p_data[i] != 0x47)
+    {
+      i++;
+      continue;
+    }
+    if(!input_append(p_input, p_data + i))
+      return false;
+    i += 188;
+  }
+  return true;
+}
+
+static bool load_seclog(input_t *p_input, uint8_t *p_data, size_t i_size,
+                        uint64_t i_units, uint64_t i_bitrate)
+{
+  uint8_t p_ring[GEN_TS_RING * 188];
+  dvbpsi_packetizer_t *p_packetizer = dvbpsi_packetizer_new(p_ring, GEN_TS_RING);
+  dvbpsi_seclog_reader_t reader;
+  dvbpsi_seclog_record_t record;
+  int64_t i_first = DVBPSI_TIME_NONE;
+  int64_t i_time = 0;
+  bool b_ok = p_packetizer != NULL;
+
+  if(b_ok)
+    dvbpsi_seclog_reader_init(&reader, p_data, i_size);
+  while(b_ok && dvbpsi_seclog_read(&reader, &record))
+  {
+    dvbpsi_psi_section_t section;
+    uint8_t *p_packets;
+    size_t i_count;
+    size_t i_start = p_input->i_packets;
+
+    memset(&section, 0, sizeof(section));
+    section.p_data = record.p_section;
+    section.p_payload_end = record.p_section + record.i_size;
+
+    /* one section at a time, sent at its arrival time */
+    b_ok = dvbpsi_packetizer_push(p_packetizer, record.i_pid, &section)
+        && dvbpsi_packetizer_flush(p_packetizer);
+    while(b_ok && (i_count = dvbpsi_packetizer_peek(p_packetizer, &p_packets)) > 0)
+    {
+      for(size_t i = 0; b_ok && i < i_count; i++)
+        b_ok = input_append(p_input, p_packets + 188 * i);
+      dvbpsi_packetizer_consume(p_packetizer, i_count);
+    }
+
+    if(i_units == 0 || record.i_time == DVBPSI_TIME_NONE)
+      continue;
+    if(i_first == DVBPSI_TIME_NONE)
+      i_first = record.i_time;
+    /* times going backwards are kept at the last one */
+    int64_t i_section = (int64_t)((double)(record.i_time - i_first) * 1e9
+                                  / (double)i_units);
+    if(i_section > i_time)
+      i_time = i_section;
+    for(size_t i = i_start; i < p_input->i_packets; i++)
+      p_input->pi_time[i] = i_time;
+  }
+  dvbpsi_packetizer_delete(p_packetizer);
+  if(!b_ok)
+    return false;
+
+  if(i_first == DVBPSI_TIME_NONE)
+    input_time_bitrate(p_input, i_bitrate);
+  else
+  {
+    /* one more packet interval of the bitrate after the last section */
+    p_input->i_duration = i_time + (int64_t)(188. * 8. * 1e9 / (double)i_bitrate);
+    p_input->i_duration_pcr = p_input->i_duration * 27 / 1000;
+  }
+  return true;
+}
+
+static bool load(input_t *p_input, const char *psz_path, uint64_t i_units,
+                 uint64_t i_bitrate)
+{
+  FILE *p_file = fopen(psz_path, "rb");
+  uint8_t *p_data = NULL;
+  size_t i_size = 0;
+  size_t i_max = 0;
+  size_t i_read;
+  bool b_ok;
+
+  if(p_file == NULL)
+  {
+    fprintf(stderr, "cannot open %s: %s\n", psz_path, strerror(errno));
+    return false;
+  }
+  do
+  {
+    if(i_size == i_max)
+    {
+      i_max = 2 * i_max + 1048576;
+      uint8_t *p_new = realloc(p_data, i_max);
+      if(p_new == NULL)
+      {
+        free(p_data);
+        fclose(p_file);
+        return false;
+      }
+      p_data = p_new;
+    }
+    i_read = fread(p_data + i_size, 1, i_max - i_size, p_file);
+    i_size += i_read;
+  } while(i_read > 0);
+  fclose(p_file);
+
+  dvbpsi_seclog_reader_t reader;
+  if(dvbpsi_seclog_reader_init(&reader, p_data, i_size))
+    b_ok = load_seclog(p_input, p_data, i_size, i_units, i_bitrate);
+  else
+  {
+    b_ok = load_ts(p_input, p_data, i_size);
+    if(b_ok && p_input->i_packets > 0 && !input_time_pcr(p_input))
+      input_time_bitrate(p_input, i_bitrate);
+  }
+  free(p_data);
+
+  if(b_ok && p_input->i_packets == 0)
+  {
+    fprintf(stderr, "%s: no packet to send\n", psz_path);
+    return false;
+  }
+  if(b_ok && p_input->i_duration_pcr == 0)
+    p_input->i_duration_pcr = p_input->i_duration * 27 / 1000;
+  return b_ok && input_index(p_input);
+}
+
+/*****************************************************************************
+ * stream_t: an independent stream of the input to a destination
+ *****************************************************************************/
+typedef struct
+{
+  struct sockaddr_storage addr;
+  socklen_t     i_addr_len;
+  int           i_socket;
+  size_t        i_next;         /* its next packet in the input */
+  uint64_t      i_loop;
+  int64_t       i_base;         /* start of the loop, ns */
+  int64_t       i_pcr_offset;   /* of the loop, 27 MHz */
+  uint8_t       pi_cc_offset[8192];
+  bool          b_done;
+} stream_t;
+
+static int64_t now(void)
+{
+#ifdef HAVE_CLOCK_GETTIME
+  struct timespec ts;
+  if(clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (int64_t)tv.tv_sec * 1000000000 + (int64_t)tv.tv_usec * 1000;
+}
+
+static void wait_until(int64_t i_time)
+{
+  int64_t i_delay = i_time - now();
+
+  if(i_delay <= 0)
+    return;
+#ifdef HAVE_CLOCK_GETTIME
+  struct timespec ts = { i_delay / 1000000000, i_delay % 1000000000 };
+  nanosleep(&ts, NULL);
+#else
+  usleep(i_delay / 1000);
+#endif
+}
+
+/* Copies the next datagram of a stream, restamped, and returns its size */
+static size_t stream_next(stream_t *p_stream, const input_t *p_input,
+                          uint8_t *p_datagram, uint64_t i_loops)
+{
+  size_t i_size = 0;
+
+  while(i_size < GEN_TS_PACKETS * 188 && !p_stream->b_done)
+  {
+    uint8_t *p_packet = p_datagram + i_size;
+
+    memcpy(p_packet, p_input->p_packets + 188 * p_stream->i_next, 188);
+    i_size += 188;
+    if(p_stream->i_loop > 0)
+    {
+      uint16_t i_pid = ((p_packet[1] & 0x1f) << 8) | p_packet[2];
+      int64_t i_pcr;
+
+      if(p_packet[3] & 0x10)
+        p_packet[3] = (p_packet[3] & 0xf0)
+                    | ((p_packet[3] + p_stream->pi_cc_offset[i_pid]) & 0x0f);
+      if(packet_pcr(p_packet, &i_pcr))
+        packet_set_pcr(p_packet, (i_pcr + p_stream->i_pcr_offset) % PCR_MODULO);
+    }
+
+    if(++p_stream->i_next < p_input->i_packets)
+      continue;
+
+    /* the next loop follows the last packets of this one */
+    p_stream->i_next = 0;
+    p_stream->i_loop++;
+    p_stream->i_base += p_input->i_duration;
+    p_stream->i_pcr_offset = (p_stream->i_pcr_offset + p_input->i_duration_pcr)
+                           % PCR_MODULO;
+    for(size_t i = 0; i < p_input->i_pids; i++)
+    {
+      uint16_t i_pid = p_input->pi_pids[i];
+      p_stream->pi_cc_offset[i_pid] += p_input->pi_last_cc[i_pid] + 1
+                                     - p_input->pi_first_cc[i_pid];
+    }
+    if(i_loops != 0 && p_stream->i_loop == i_loops)
+      p_stream->b_done = true;
+  }
+  return i_size;
+}
+
+/*****************************************************************************
+ * sender_t: the datagrams of a batch
+ *****************************************************************************/
+typedef struct
+{
+  int           i_count;
+  int           i_socket;
+#ifdef HAVE_SENDMMSG
+  struct mmsghdr p_msgs[GEN_TS_BATCH];
+#endif
+  struct iovec  p_iov[GEN_TS_BATCH];
+  stream_t *    pp_streams[GEN_TS_BATCH];
+  uint8_t       pp_datagrams[GEN_TS_BATCH][GEN_TS_PACKETS * 188];
+  uint64_t      i_sent;
+  uint64_t      i_bytes;
+  uint64_t      i_errors;
+} sender_t;
+
+static void sender_flush(sender_t *p_sender)
+{
+  int i_done = 0;
+
+  while(i_done < p_sender->i_count)
+  {
+#ifdef HAVE_SENDMMSG
+    for(int i = i_done; i < p_sender->i_count; i++)
+    {
+      struct msghdr *p_hdr = &p_sender->p_msgs[i].msg_hdr;
+      memset(p_hdr, 0, sizeof(*p_hdr));
+      p_hdr->msg_name = &p_sender->pp_streams[i]->addr;
+      p_hdr->msg_namelen = p_sender->pp_streams[i]->i_addr_len;
+      p_hdr->msg_iov = &p_sender->p_iov[i];
+      p_hdr->msg_iovlen = 1;
+    }
+    int i_ret = sendmmsg(p_sender->i_socket, p_sender->p_msgs + i_done,
+                         p_sender->i_count - i_done, 0);
+#else
+    stream_t *p_stream = p_sender->pp_streams[i_done];
+    int i_ret = sendto(p_sender->i_socket, p_sender->p_iov[i_done].iov_base,
+                       p_sender->p_iov[i_done].iov_len, 0,
+                       (struct sockaddr *)&p_stream->addr, p_stream->i_addr_len) < 0
+              ? -1 : 1;
+#endif
+    if(i_ret < 0)
+    {
+      if(errno == EINTR || errno == EAGAIN)
+        continue;
+      /* the datagram is dropped, the stream goes on */
+      p_sender->i_errors++;
+      i_ret = 1;
+    }
+    else
+    {
+      p_sender->i_sent += i_ret;
+      for(int i = i_done; i < i_done + i_ret; i++)
+        p_sender->i_bytes += p_sender->p_iov[i].iov_len;
+    }
+    i_done += i_ret;
+  }
+  p_sender->i_count = 0;
+}
+
+/*****************************************************************************
+ * destinations
+ *****************************************************************************/
+static bool parse_destination(const char *psz_dest, stream_t *p_stream,
+                              int i_port_offset)
+{
+  char psz_host[256];
+  const char *psz_port = strrchr(psz_dest, ':');
+  struct addrinfo hints, *p_res;
+  char psz_service[16];
+
+  if(psz_port == NULL || (size_t)(psz_port - psz_dest) >= sizeof(psz_host))
+    return false;
+  memcpy(psz_host, psz_dest, psz_port - psz_dest);
+  psz_host[psz_port - psz_dest] = '\0';
+  /* [address]:port for IPv6 */
+  char *psz_name = psz_host;
+  if(psz_host[0] == '[' && psz_host[strlen(psz_host) - 1] == ']')
+  {
+    psz_host[strlen(psz_host) - 1] = '\0';
+    psz_name++;
+  }
+  snprintf(psz_service, sizeof(psz_service), "%d", atoi(psz_port + 1) + i_port_offset);
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_DGRAM;
+  if(getaddrinfo(psz_name, psz_service, &hints, &p_res) != 0)
+    return false;
+  memcpy(&p_stream->addr, p_res->ai_addr, p_res->ai_addrlen);
+  p_stream->i_addr_len = p_res->ai_addrlen;
+  freeaddrinfo(p_res);
+  return true;
+}
+
+static int open_socket(int i_family, int i_ttl)
+{
+  int i_socket = socket(i_family, SOCK_DGRAM, 0);
+  int i_buffer = 4 * 1024 * 1024;
+
+  if(i_socket < 0)
+    return -1;
+  setsockopt(i_socket, SOL_SOCKET, SO_SNDBUF, &i_buffer, sizeof(i_buffer));
+  if(i_family == AF_INET)
+  {
+    unsigned char i_char_ttl = i_ttl;
+    setsockopt(i_socket, IPPROTO_IP, IP_MULTICAST_TTL, &i_char_ttl, sizeof(i_char_ttl));
+  }
+#ifdef IPV6_MULTICAST_HOPS
+  else if(i_family == AF_INET6)
+    setsockopt(i_socket, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, &i_ttl, sizeof(i_ttl));
+#endif
+  return i_socket;
+}
+
+static volatile sig_atomic_t b_stop = 0;
+
+static void on_signal(int i_signal)
+{
+  (void)i_signal;
+  b_stop = 1;
+}
+
+static void usage(void)
+{
+  fprintf(stderr, "usage: gen_ts [-b bitrate] [-u units] [-l loops] [-d seconds]"
+                  " [-n count] [-t ttl] input address:port ...\n");
+}
+
+/*****************************************************************************
+ * main
+ *****************************************************************************/
+int main(int argc, char *argv[])
+{
+  uint64_t i_bitrate = 10000000;
+  uint64_t i_units = 0;
+  uint64_t i_loops = 1;
+  double f_seconds = 0.;
+  int i_count = 1;
+  int i_ttl = 1;
+  int c;
+
+  while((c = getopt(argc, argv, "b:u:l:d:n:t:")) != -1)
+  {
+    switch(c)
+    {
+      case 'b': i_bitrate = strtoull(optarg, NULL, 0); break;
+      case 'u': i_units = strtoull(optarg, NULL, 0); break;
+      case 'l': i_loops = strtoull(optarg, NULL, 0); break;
+      case 'd': f_seconds = atof(optarg); break;
+      case 'n': i_count = atoi(optarg); break;
+      case 't': i_ttl = atoi(optarg); break;
+      default: usage(); return 1;
+    }
+  }
+  if(argc - optind < 2 || i_bitrate == 0 || i_count < 1)
+  {
+    usage();
+    return 1;
+  }
+
+  input_t *p_input = calloc(1, sizeof(input_t));
+  if(p_input == NULL || !load(p_input, argv[optind], i_units, i_bitrate))
+    return 1;
+
+  size_t i_streams = (size_t)(argc - optind - 1) * i_count;
+  stream_t *p_streams = calloc(i_streams, sizeof(stream_t));
+  sender_t *p_senders = calloc(2, sizeof(sender_t)); /* IPv4 and IPv6 */
+  if(p_streams == NULL || p_senders == NULL)
+    return 1;
+  p_senders[0].i_socket = p_senders[1].i_socket = -1;
+  for(size_t i = 0; i < i_streams; i++)
+  {
+    const char *psz_dest = argv[optind + 1 + i / i_count];
+    stream_t *p_stream = &p_streams[i];
+
+    if(!parse_destination(psz_dest, p_stream, i % i_count))
+    {
+      fprintf(stderr, "bad destination %s\n", psz_dest);
+      return 1;
+    }
+    sender_t *p_sender = &p_senders[p_stream->addr.ss_family == AF_INET6];
+    if(p_sender->i_socket < 0
+     && (p_sender->i_socket = open_socket(p_stream->addr.ss_family, i_ttl)) < 0)
+    {
+      fprintf(stderr, "cannot open a socket: %s\n", strerror(errno));
+      return 1;
+    }
+    p_stream->i_socket = p_sender->i_socket;
+  }
+  for(int i = 0; i < 2; i++)
+    for(int j = 0; j < GEN_TS_BATCH; j++)
+    {
+      p_senders[i].p_iov[j].iov_base = p_senders[i].pp_datagrams[j];
+#ifdef HAVE_SENDMMSG
+      p_senders[i].p_msgs[j].msg_hdr.msg_iov = &p_senders[i].p_iov[j];
+#endif
+    }
+
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+
+  int64_t i_start = now() + 10000000;
+  int64_t i_end = f_seconds > 0. ? i_start + (int64_t)(f_seconds * 1e9) : INT64_MAX;
+  int64_t i_late = 0;
+  size_t i_active = i_streams;
+
+  for(size_t i = 0; i < i_streams; i++)
+    p_streams[i].i_base = i_start;
+
+  while(i_active > 0 && !b_stop)
+  {
+    int64_t i_now = now();
+    int64_t i_next = INT64_MAX;
+
+    if(i_now >= i_end)
+      break;
+    for(size_t i = 0; i < i_streams; i++)
+    {
+      stream_t *p_stream = &p_streams[i];
+      sender_t *p_sender = &p_senders[p_stream->addr.ss_family == AF_INET6];
+      int64_t i_due = 0;
+
+      while(!p_stream->b_done
+         && (i_due = p_stream->i_base + p_input->pi_time[p_stream->i_next])
+            <= i_now + GEN_TS_SLACK)
+      {
+        if(i_now - i_due > i_late)
+          i_late = i_now - i_due;
+        int j = p_sender->i_count++;
+        p_sender->pp_streams[j] = p_stream;
+        p_sender->p_iov[j].iov_len = stream_next(p_stream, p_input,
+                                                 p_sender->pp_datagrams[j], i_loops);
+        if(p_stream->b_done)
+          i_active--;
+        if(p_sender->i_count == GEN_TS_BATCH)
+          sender_flush(p_sender);
+      }
+      if(!p_stream->b_done && i_due < i_next)
+        i_next = i_due;
+    }
+    sender_flush(&p_senders[0]);
+    sender_flush(&p_senders[1]);
+    if(i_next != INT64_MAX)
+      wait_until(i_next < i_end ? i_next : i_end);
+  }
+
+  uint64_t i_sent = p_senders[0].i_sent + p_senders[1].i_sent;
+  uint64_t i_bytes = p_senders[0].i_bytes + p_senders[1].i_bytes;
+  double f_elapsed = (double)(now() - i_start) / 1e9;
+  fprintf(stderr, "%zu streams, %"PRIu64" datagrams sent, %"PRIu64" errors,"
+          " %.1f Mbit/s, %.3f ms late at most\n",
+          i_streams, i_sent, p_senders[0].i_errors + p_senders[1].i_errors,
+          f_elapsed > 0. ? (double)i_bytes * 8. / f_elapsed / 1e6 : 0.,
+          (double)i_late / 1e6);
+
+  for(int i = 0; i < 2; i++)
+    if(p_senders[i].i_socket >= 0)
+      close(p_senders[i].i_socket);
+  free(p_senders);
+  free(p_streams);
+  free(p_input->pi_pids);
+  free(p_input->pi_time);
+  free(p_input->p_packets);
+  free(p_input);
+  return 0;
+}
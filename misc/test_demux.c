@@ -0,0 +1,206 @@
+/*****************************************************************************
+ * test_demux.c: test of the limits of the subtable decoders of a demux
+ *----------------------------------------------------------------------------
+ * Copyright (c)2001-2012 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ * Feeds a demux bounded by dvbpsi_demux_set_limits() with SDT sections:
+ * - an actual SDT a fan-out is subscribed to, given a new version at long
+ *   intervals, which must neither expire nor be evicted, its subscriber
+ *   getting every version;
+ * - other SDTs of the new subtable callback, only ever given their first
+ *   section of two, which hold sections, expire and are evicted;
+ * - another SDT of the new subtable callback, complete and given the same
+ *   version all along, which holds no section and must not be evicted.
+ * The exit status is 1 on failure.
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+/* the libdvbpsi distribution defines DVBPSI_DIST */
+#ifdef DVBPSI_DIST
+#include "../src/dvbpsi.h"
+#include "../src/psi.h"
+#include "../src/descriptor.h"
+#include "../src/demux.h"
+#include "../src/snapshot.h"
+#include "../src/fanout.h"
+#include "../src/tables/sdt.h"
+#else
+#include <dvbpsi/dvbpsi.h>
+#include <dvbpsi/psi.h>
+#include <dvbpsi/descriptor.h>
+#include <dvbpsi/demux.h>
+#include <dvbpsi/snapshot.h>
+#include <dvbpsi/fanout.h>
+#include <dvbpsi/sdt.h>
+#endif
+
+#define TEST_ROUNDS     2048
+#define TEST_INTERVAL   10000   /* between two rounds */
+#define TEST_TTL        15000   /* a subtable fed each round never expires */
+#define TEST_FANOUT     8       /* rounds between two fan-out versions */
+#define TEST_PARTIALS   4       /* other SDTs left incomplete, one a round */
+#define TEST_COMPLETE   100     /* transport_stream_id of the complete one */
+
+static unsigned int i_errors;
+static unsigned int i_tables;
+static unsigned int i_complete_attached;
+
+static void message(dvbpsi_t *p_dvbpsi, const dvbpsi_msg_level_t level, const char *psz_msg)
+{
+  (void)p_dvbpsi;
+  if(level == DVBPSI_MSG_ERROR)
+  {
+    fprintf(stderr, "%s\n", psz_msg);
+    i_errors++;
+  }
+}
+
+static void fanout_cb(void *p_data, dvbpsi_snapshot_t *p_snapshot)
+{
+  (void)p_data;
+  i_tables++;
+  dvbpsi_table_unref(p_snapshot);
+}
+
+static void sdt_cb(void *p_data, dvbpsi_sdt_t *p_sdt)
+{
+  (void)p_data;
+  dvbpsi_sdt_delete(p_sdt);
+}
+
+static void new_subtable(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_extension,
+                         void *p_data)
+{
+  (void)p_data;
+  if(i_table_id != 0x46)
+    return;
+  if(i_extension == TEST_COMPLETE)
+    i_complete_attached++;
+  dvbpsi_sdt_attach(p_dvbpsi, i_table_id, i_extension, sdt_cb, NULL);
+}
+
+static uint32_t crc32(const uint8_t *p_data, size_t i_size)
+{
+  uint32_t i_crc = 0xffffffff;
+  for(size_t i = 0; i < i_size; i++)
+  {
+    i_crc ^= (uint32_t)p_data[i] << 24;
+    for(int j = 0; j < 8; j++)
+      i_crc = (i_crc & 0x80000000) ? (i_crc << 1) ^ 0x04c11db7 : i_crc << 1;
+  }
+  return i_crc;
+}
+
+/* An SDT section without any service */
+static void push_sdt(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_ts_id,
+                     uint8_t i_version, uint8_t i_number, uint8_t i_last,
+                     int64_t i_time)
+{
+  uint8_t p_section[15];
+  p_section[0] = i_table_id;
+  p_section[1] = 0xf0;
+  p_section[2] = sizeof(p_section) - 3;
+  p_section[3] = i_ts_id >> 8;
+  p_section[4] = i_ts_id;
+  p_section[5] = 0xc1 | (i_version << 1);
+  p_section[6] = i_number;
+  p_section[7] = i_last;
+  p_section[8] = 0x00;
+  p_section[9] = 0x01;
+  p_section[10] = 0xff;
+  uint32_t i_crc = crc32(p_section, 11);
+  p_section[11] = i_crc >> 24;
+  p_section[12] = i_crc >> 16;
+  p_section[13] = i_crc >> 8;
+  p_section[14] = i_crc;
+  dvbpsi_section_push_at(p_dvbpsi, p_section, sizeof(p_section), i_time);
+}
+
+int main(void)
+{
+  dvbpsi_t *p_dvbpsi = dvbpsi_new(message, DVBPSI_MSG_ERROR);
+  if(p_dvbpsi == NULL || !dvbpsi_AttachDemux(p_dvbpsi, new_subtable, NULL))
+    return 1;
+  dvbpsi_demux_set_limits(p_dvbpsi, 1, TEST_TTL);
+
+  dvbpsi_fanout_t *p_fanout = dvbpsi_fanout_new(p_dvbpsi);
+  if(p_fanout == NULL ||
+     !dvbpsi_fanout_subscribe(p_fanout, 0x42, 1, DVBPSI_FANOUT_CURRENT, fanout_cb, NULL))
+    return 1;
+
+  unsigned int i_versions = 0;
+  for(unsigned int i = 0; i < TEST_ROUNDS; i++)
+  {
+    int64_t i_time = (int64_t)i * TEST_INTERVAL;
+    if(i % TEST_FANOUT == 0)
+    {
+      push_sdt(p_dvbpsi, 0x42, 1, i_versions % 32, 0, 0, i_time);
+      i_versions++;
+    }
+    push_sdt(p_dvbpsi, 0x46, 2 + i % TEST_PARTIALS, 0, 0, 1, i_time);
+    push_sdt(p_dvbpsi, 0x46, TEST_COMPLETE, 0, 0, 0, i_time);
+  }
+
+  dvbpsi_stats_t stats;
+  dvbpsi_get_stats(p_dvbpsi, &stats);
+
+  int i_ret = 0;
+  if(i_tables != i_versions)
+  {
+    fprintf(stderr, "fan-out subscriber got %u tables of %u\n", i_tables, i_versions);
+    i_ret = 1;
+  }
+  if(i_complete_attached != 1)
+  {
+    fprintf(stderr, "subtable holding no section attached %u times\n",
+            i_complete_attached);
+    i_ret = 1;
+  }
+  if(stats.i_subdecs_expired == 0 || stats.i_subdecs_evicted == 0)
+  {
+    fprintf(stderr, "%"PRIu64" subtables expired, %"PRIu64" evicted\n",
+            stats.i_subdecs_expired, stats.i_subdecs_evicted);
+    i_ret = 1;
+  }
+
+  dvbpsi_fanout_delete(p_fanout);
+  dvbpsi_DetachDemux(p_dvbpsi);
+  dvbpsi_delete(p_dvbpsi);
+
+  if(i_errors)
+  {
+    fprintf(stderr, "%u errors\n", i_errors);
+    i_ret = 1;
+  }
+  return i_ret;
+}
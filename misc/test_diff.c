@@ -0,0 +1,828 @@
+/*****************************************************************************
+ * test_diff.c: differential test of the decoding options
+ *----------------------------------------------------------------------------
+ * Copyright (c)2001-2012 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ * Decodes the same streams with the reference handles, without any
+ * DVBPSI_FLAG_* option, and with each set of the options replacing a
+ * decoding path, and compares what both emit byte by byte: every table,
+ * serialized to CBOR, and every event, in their order. The PAT, the PMTs of
+ * its programs, the CAT, NIT, SDT, BAT, EIT and TOT are decoded. The
+ * CRC_32 kernels are compared with the byte per byte one on every packet
+ * as well.
+ *
+ * The streams are muxes of the generators damaged at random, packets
+ * dropped, duplicated, swapped, bytes and continuity counters changed, and
+ * the captured streams given on the command line.
+ *
+ * Usage: test_diff [-n streams] [-s seed] [file.ts ...], 16 random streams
+ * by default. The exit status is 1 on the first difference.
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+/* the libdvbpsi distribution defines DVBPSI_DIST */
+#ifdef DVBPSI_DIST
+#include "../src/dvbpsi.h"
+#include "../src/psi.h"
+#include "../src/descriptor.h"
+#include "../src/demux.h"
+#include "../src/packetizer.h"
+#include "../src/tables/pat.h"
+#include "../src/tables/pmt.h"
+#include "../src/tables/cat.h"
+#include "../src/tables/sdt.h"
+#include "../src/tables/nit.h"
+#include "../src/tables/bat.h"
+#include "../src/tables/eit.h"
+#include "../src/tables/tot.h"
+#include "../src/tables/rst.h"
+#include "../src/tables/sis.h"
+#include "../src/tables/atsc_vct.h"
+#include "../src/tables/atsc_mgt.h"
+#include "../src/tables/atsc_stt.h"
+#include "../src/tables/atsc_eit.h"
+#include "../src/tables/atsc_ett.h"
+#include "../src/serialize.h"
+#include "../src/crc32_private.h"
+#else
+#include <dvbpsi/dvbpsi.h>
+#include <dvbpsi/psi.h>
+#include <dvbpsi/descriptor.h>
+#include <dvbpsi/demux.h>
+#include <dvbpsi/packetizer.h>
+#include <dvbpsi/pat.h>
+#include <dvbpsi/pmt.h>
+#include <dvbpsi/cat.h>
+#include <dvbpsi/sdt.h>
+#include <dvbpsi/nit.h>
+#include <dvbpsi/bat.h>
+#include <dvbpsi/eit.h>
+#include <dvbpsi/tot.h>
+#include <dvbpsi/rst.h>
+#include <dvbpsi/sis.h>
+#include <dvbpsi/atsc_vct.h>
+#include <dvbpsi/atsc_mgt.h>
+#include <dvbpsi/atsc_stt.h>
+#include <dvbpsi/atsc_eit.h>
+#include <dvbpsi/atsc_ett.h>
+#include <dvbpsi/serialize.h>
+#endif
+
+#define DIFF_RING       1024
+#define DIFF_PROGRAMS   16
+
+/* Options compared with the reference, one handle set each. Those which
+ * change what is emitted on purpose, DVBPSI_FLAG_DROP_ERRORED and
+ * DVBPSI_FLAG_KEEP_SECTIONS, are left out. DVBPSI_FLAG_CRC_CACHE does not
+ * signal again the table decoded before a discontinuity, so it is only
+ * compared on the undamaged streams. */
+typedef struct
+{
+  uint32_t    i_flags;
+  bool        b_damaged;    /* compared on the damaged streams as well */
+} options_t;
+
+static const options_t p_options[] =
+{
+  { DVBPSI_FLAG_ZERO_COPY, true },
+  { DVBPSI_FLAG_CRC_CACHE, false },
+  { DVBPSI_FLAG_ZERO_COPY | DVBPSI_FLAG_CRC_CACHE, false },
+  { DVBPSI_FLAG_TABLE_ARENA, true },
+  { DVBPSI_FLAG_TABLE_ARRAYS, true },
+  { DVBPSI_FLAG_LAZY_DECODE, true },
+  { DVBPSI_FLAG_DESCRIPTOR_CACHE, true },
+  { DVBPSI_FLAG_INTERN_DESCRIPTORS, true },
+  { DVBPSI_FLAG_TABLE_INDEX, true },
+  { DVBPSI_FLAG_COMPACT, true },
+  { DVBPSI_FLAG_REPETITION | DVBPSI_FLAG_LAST_SECTIONS, true },
+  { DVBPSI_FLAG_ZERO_COPY | DVBPSI_FLAG_TABLE_ARRAYS | DVBPSI_FLAG_DESCRIPTOR_CACHE
+    | DVBPSI_FLAG_INTERN_DESCRIPTORS | DVBPSI_FLAG_COMPACT, true },
+  { DVBPSI_FLAG_ZERO_COPY | DVBPSI_FLAG_CRC_CACHE | DVBPSI_FLAG_TABLE_ARRAYS
+    | DVBPSI_FLAG_DESCRIPTOR_CACHE | DVBPSI_FLAG_INTERN_DESCRIPTORS | DVBPSI_FLAG_COMPACT, false },
+  { DVBPSI_FLAG_ZERO_COPY | DVBPSI_FLAG_TABLE_ARENA | DVBPSI_FLAG_LAZY_DECODE
+    | DVBPSI_FLAG_TABLE_INDEX, true },
+};
+
+#define DIFF_OPTIONS (sizeof(p_options) / sizeof(p_options[0]))
+
+/*****************************************************************************
+ * log_t: what a handle set emitted
+ *****************************************************************************/
+typedef struct
+{
+  uint8_t *   p_data;
+  size_t      i_length;
+  size_t      i_size;
+  size_t      i_records;
+  bool        b_error;
+} log_t;
+
+static bool log_reserve(log_t *p_log, size_t i_size)
+{
+  if(p_log->i_length + i_size > p_log->i_size)
+  {
+    size_t i_new = 2 * p_log->i_size + i_size + 4096;
+    uint8_t *p_data = realloc(p_log->p_data, i_new);
+    if(p_data == NULL)
+    {
+      p_log->b_error = true;
+      return false;
+    }
+    p_log->p_data = p_data;
+    p_log->i_size = i_new;
+  }
+  return true;
+}
+
+/* Record: kind, PID and length of the payload, 7 bytes, then the payload */
+static void log_append(log_t *p_log, uint8_t i_kind, uint16_t i_pid,
+                       const uint8_t *p_payload, size_t i_size)
+{
+  if(!log_reserve(p_log, 7 + i_size))
+    return;
+
+  uint8_t *p = p_log->p_data + p_log->i_length;
+  p[0] = i_kind;
+  p[1] = i_pid >> 8;
+  p[2] = i_pid;
+  p[3] = i_size >> 24;
+  p[4] = i_size >> 16;
+  p[5] = i_size >> 8;
+  p[6] = i_size;
+  memcpy(p + 7, p_payload, i_size);
+  p_log->i_length += 7 + i_size;
+  p_log->i_records++;
+}
+
+/*****************************************************************************
+ * chain_t: the handles of the PIDs of a stream, with one set of options
+ *****************************************************************************/
+typedef struct chain_s chain_t;
+
+/* The PID of a PMT, given to its callback */
+typedef struct
+{
+  chain_t *   p_chain;
+  uint16_t    i_pid;
+} tap_t;
+
+struct chain_s
+{
+  uint32_t              i_flags;
+  dvbpsi_t *            pp_handles[8192];
+  unsigned int          i_pmts;
+  tap_t                 p_taps[DIFF_PROGRAMS];
+  log_t                 log;
+  dvbpsi_serializer_t   serializer;
+};
+
+static uint8_t *serializer_grow(void *p_cb_data, uint8_t *p_buffer, size_t i_size)
+{
+  (void)p_cb_data;
+  return realloc(p_buffer, i_size);
+}
+
+static void chain_table(chain_t *p_chain, uint16_t i_pid, bool b_ok)
+{
+  dvbpsi_serializer_t *p_serializer = &p_chain->serializer;
+
+  if(!b_ok)
+    p_chain->log.b_error = true;
+  else
+    log_append(&p_chain->log, 'T', i_pid, p_serializer->p_buffer,
+               p_serializer->i_length);
+  dvbpsi_serializer_reset(p_serializer);
+}
+
+static void chain_event(dvbpsi_t *p_dvbpsi, const dvbpsi_event_t *p_event,
+                        void *p_cb_data)
+{
+  chain_t *p_chain = (chain_t *)p_cb_data;
+  uint8_t p_record[21];
+  (void)p_dvbpsi;
+
+  p_record[0] = p_event->i_type;
+  p_record[1] = p_event->i_pid >> 8;
+  p_record[2] = p_event->i_pid;
+  p_record[3] = p_event->i_table_id;
+  p_record[4] = p_event->i_extension >> 8;
+  p_record[5] = p_event->i_extension;
+  p_record[6] = p_event->i_version;
+  p_record[7] = p_event->i_last_version;
+  for(int i = 0; i < 4; i++)
+  {
+    p_record[8 + i] = p_event->i_expected >> (24 - 8 * i);
+    p_record[12 + i] = p_event->i_received >> (24 - 8 * i);
+  }
+  /* the count on the handle, which may be one of many PMT handles */
+  for(int i = 0; i < 5; i++)
+    p_record[16 + i] = p_event->i_count >> (32 - 8 * i);
+  log_append(&p_chain->log, 'E', p_event->i_pid, p_record, sizeof(p_record));
+}
+
+static void pmt_cb(void *p_data, dvbpsi_pmt_t *p_pmt)
+{
+  tap_t *p_tap = (tap_t *)p_data;
+  chain_t *p_chain = p_tap->p_chain;
+  dvbpsi_pmt_decode(p_pmt);
+  chain_table(p_chain, p_tap->i_pid,
+              dvbpsi_serialize_pmt(&p_chain->serializer, p_pmt));
+  dvbpsi_pmt_delete(p_pmt);
+}
+
+static dvbpsi_t *chain_handle(chain_t *p_chain, uint16_t i_pid)
+{
+  dvbpsi_t *p_dvbpsi = dvbpsi_new(NULL, DVBPSI_MSG_NONE);
+  if(p_dvbpsi == NULL)
+  {
+    p_chain->log.b_error = true;
+    return NULL;
+  }
+  dvbpsi_set_flags(p_dvbpsi, p_chain->i_flags);
+  dvbpsi_set_event_cb(p_dvbpsi, chain_event, p_chain);
+  p_chain->pp_handles[i_pid] = p_dvbpsi;
+  return p_dvbpsi;
+}
+
+static void pat_cb(void *p_data, dvbpsi_pat_t *p_pat)
+{
+  chain_t *p_chain = (chain_t *)p_data;
+
+  chain_table(p_chain, 0x00, dvbpsi_serialize_pat(&p_chain->serializer, p_pat));
+
+  /* The PMTs of the first programs, on PIDs of no other table */
+  for(dvbpsi_pat_program_t *p = p_pat->p_first_program; p; p = p->p_next)
+  {
+    if(p->i_number == 0 || p->i_pid < 0x20 || p->i_pid == 0x1fff
+       || p_chain->pp_handles[p->i_pid] != NULL || p_chain->i_pmts >= DIFF_PROGRAMS)
+      continue;
+    tap_t *p_tap = &p_chain->p_taps[p_chain->i_pmts];
+    dvbpsi_t *p_dvbpsi = chain_handle(p_chain, p->i_pid);
+    p_tap->p_chain = p_chain;
+    p_tap->i_pid = p->i_pid;
+    if(p_dvbpsi && !dvbpsi_pmt_attach(p_dvbpsi, p->i_number, pmt_cb, p_tap))
+      p_chain->log.b_error = true;
+    p_chain->i_pmts++;
+  }
+  dvbpsi_pat_delete(p_pat);
+}
+
+static void cat_cb(void *p_data, dvbpsi_cat_t *p_cat)
+{
+  chain_t *p_chain = (chain_t *)p_data;
+  chain_table(p_chain, 0x01, dvbpsi_serialize_cat(&p_chain->serializer, p_cat));
+  dvbpsi_cat_delete(p_cat);
+}
+
+static void nit_cb(void *p_data, dvbpsi_nit_t *p_nit)
+{
+  chain_t *p_chain = (chain_t *)p_data;
+  dvbpsi_nit_decode(p_nit);
+  chain_table(p_chain, 0x10, dvbpsi_serialize_nit(&p_chain->serializer, p_nit));
+  dvbpsi_nit_delete(p_nit);
+}
+
+static void sdt_cb(void *p_data, dvbpsi_sdt_t *p_sdt)
+{
+  chain_t *p_chain = (chain_t *)p_data;
+  dvbpsi_sdt_decode(p_sdt);
+  chain_table(p_chain, 0x11, dvbpsi_serialize_sdt(&p_chain->serializer, p_sdt));
+  dvbpsi_sdt_delete(p_sdt);
+}
+
+static void bat_cb(void *p_data, dvbpsi_bat_t *p_bat)
+{
+  chain_t *p_chain = (chain_t *)p_data;
+  dvbpsi_bat_decode(p_bat);
+  chain_table(p_chain, 0x11, dvbpsi_serialize_bat(&p_chain->serializer, p_bat));
+  dvbpsi_bat_delete(p_bat);
+}
+
+static void eit_cb(void *p_data, dvbpsi_eit_t *p_eit)
+{
+  chain_t *p_chain = (chain_t *)p_data;
+  dvbpsi_eit_decode(p_eit);
+  chain_table(p_chain, 0x12, dvbpsi_serialize_eit(&p_chain->serializer, p_eit));
+  dvbpsi_eit_delete(p_eit);
+}
+
+static void tot_cb(void *p_data, dvbpsi_tot_t *p_tot)
+{
+  chain_t *p_chain = (chain_t *)p_data;
+  chain_table(p_chain, 0x14, dvbpsi_serialize_tot(&p_chain->serializer, p_tot));
+  dvbpsi_tot_delete(p_tot);
+}
+
+static void new_subtable(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_extension,
+                         void *p_data)
+{
+  if(i_table_id == 0x42 || i_table_id == 0x46)
+    dvbpsi_sdt_attach(p_dvbpsi, i_table_id, i_extension, sdt_cb, p_data);
+  else if(i_table_id == 0x4a)
+    dvbpsi_bat_attach(p_dvbpsi, i_table_id, i_extension, bat_cb, p_data);
+  else if(i_table_id == 0x40 || i_table_id == 0x41)
+    dvbpsi_nit_attach(p_dvbpsi, i_table_id, i_extension, nit_cb, p_data);
+  else if(i_table_id >= 0x4e && i_table_id <= 0x6f)
+    dvbpsi_eit_attach(p_dvbpsi, i_table_id, i_extension, eit_cb, p_data);
+  else if(i_table_id == 0x70 || i_table_id == 0x73)
+    dvbpsi_tot_attach(p_dvbpsi, i_table_id, i_extension, tot_cb, p_data);
+}
+
+static chain_t *chain_new(uint32_t i_flags)
+{
+  static const uint16_t pi_demux_pids[] = { 0x10, 0x11, 0x12, 0x14 };
+  chain_t *p_chain = calloc(1, sizeof(chain_t));
+  dvbpsi_t *p_dvbpsi;
+
+  if(p_chain == NULL)
+    return NULL;
+  p_chain->i_flags = i_flags;
+  dvbpsi_serializer_init(&p_chain->serializer, DVBPSI_SERIALIZER_CBOR, NULL, 0,
+                         serializer_grow, NULL);
+
+  if((p_dvbpsi = chain_handle(p_chain, 0x00)) == NULL
+     || !dvbpsi_pat_attach(p_dvbpsi, pat_cb, p_chain)
+     || (p_dvbpsi = chain_handle(p_chain, 0x01)) == NULL
+     || !dvbpsi_cat_attach(p_dvbpsi, cat_cb, p_chain))
+    p_chain->log.b_error = true;
+  for(size_t i = 0; i < sizeof(pi_demux_pids) / sizeof(pi_demux_pids[0]); i++)
+    if((p_dvbpsi = chain_handle(p_chain, pi_demux_pids[i])) == NULL
+       || !dvbpsi_AttachDemux(p_dvbpsi, new_subtable, p_chain))
+      p_chain->log.b_error = true;
+  return p_chain;
+}
+
+static void chain_delete(chain_t *p_chain)
+{
+  for(unsigned int i = 0; i < 8192; i++)
+  {
+    dvbpsi_t *p_dvbpsi = p_chain->pp_handles[i];
+    if(p_dvbpsi == NULL)
+      continue;
+    if(dvbpsi_decoder_present(p_dvbpsi))
+    {
+      if(i == 0x00)
+        dvbpsi_pat_detach(p_dvbpsi);
+      else if(i == 0x01)
+        dvbpsi_cat_detach(p_dvbpsi);
+      else if(i >= 0x20)
+        dvbpsi_pmt_detach(p_dvbpsi);
+      else
+        dvbpsi_DetachDemux(p_dvbpsi);
+    }
+    dvbpsi_delete(p_dvbpsi);
+  }
+  free(p_chain->serializer.p_buffer);
+  free(p_chain->log.p_data);
+  free(p_chain);
+}
+
+static void chain_push(chain_t *p_chain, uint8_t *p_packets, size_t i_count)
+{
+  for(size_t i = 0; i < i_count; i++)
+  {
+    uint8_t *p_packet = p_packets + 188 * i;
+    uint16_t i_pid = ((uint16_t)(p_packet[1] & 0x1f) << 8) | p_packet[2];
+    if(p_chain->pp_handles[i_pid])
+      dvbpsi_packet_push(p_chain->pp_handles[i_pid], p_packet);
+  }
+}
+
+/*****************************************************************************
+ * Random streams
+ *****************************************************************************/
+typedef struct
+{
+  uint8_t *             p_data;
+  size_t                i_packets;
+  size_t                i_max;
+  dvbpsi_packetizer_t * p_packetizer;
+  uint8_t               p_ring[DIFF_RING * 188];
+} stream_t;
+
+static uint32_t i_random;
+
+static uint32_t random_next(void)
+{
+  /* xorshift32 */
+  i_random ^= i_random << 13;
+  i_random ^= i_random >> 17;
+  i_random ^= i_random << 5;
+  return i_random;
+}
+
+static bool stream_push(stream_t *p_stream, uint16_t i_pid,
+                        dvbpsi_psi_section_t *p_sections)
+{
+  bool b_ok = p_sections != NULL;
+
+  for(dvbpsi_psi_section_t *p = p_sections; b_ok && p; p = p->p_next)
+  {
+    dvbpsi_psi_section_t *p_next = p->p_next;
+    uint8_t *p_packets;
+    size_t i_count;
+
+    p->p_next = NULL;
+    b_ok = dvbpsi_packetizer_push(p_stream->p_packetizer, i_pid, p)
+        && dvbpsi_packetizer_flush(p_stream->p_packetizer);
+    p->p_next = p_next;
+
+    while(b_ok && (i_count = dvbpsi_packetizer_peek(p_stream->p_packetizer,
+                                                    &p_packets)) > 0)
+    {
+      if(p_stream->i_packets + i_count > p_stream->i_max)
+      {
+        size_t i_max = 2 * p_stream->i_max + i_count;
+        uint8_t *p_data = realloc(p_stream->p_data, i_max * 188);
+        if(p_data == NULL)
+        {
+          b_ok = false;
+          break;
+        }
+        p_stream->p_data = p_data;
+        p_stream->i_max = i_max;
+      }
+      memcpy(p_stream->p_data + p_stream->i_packets * 188, p_packets, i_count * 188);
+      p_stream->i_packets += i_count;
+      dvbpsi_packetizer_consume(p_stream->p_packetizer, i_count);
+    }
+  }
+
+  dvbpsi_DeletePSISections(p_sections);
+  return b_ok;
+}
+
+/* One version of each table of the mux, their sizes at random */
+static bool stream_cycle(stream_t *p_stream, dvbpsi_t *p_dvbpsi, uint8_t i_version)
+{
+  static uint8_t p_language[] = { 'e', 'n', 'g', 0 };
+  static uint8_t p_service[] = { 0x01, 3, 'd', 'i', 'f', 4, 't', 'e', 's', 't' };
+  static uint8_t p_delivery[] = { 0x03, 0x46, 0x00, 0x00, 0xff, 0xf0, 0x05,
+                                  0x06, 0x90, 0x00, 0x03 };
+  uint8_t p_event[] = { 'e', 'n', 'g', 4, 'n', 'e', 'w', 's', 0 };
+  unsigned int i_programs = 1 + random_next() % DIFF_PROGRAMS;
+  bool b_ok;
+
+  dvbpsi_pat_t pat;
+  dvbpsi_pat_init(&pat, 1, i_version, true);
+  for(unsigned int p = 0; p < i_programs; p++)
+    dvbpsi_pat_program_add(&pat, p + 1, 0x100 + p);
+  b_ok = stream_push(p_stream, 0x00, dvbpsi_pat_sections_generate(p_dvbpsi, &pat, 253));
+  dvbpsi_pat_empty(&pat);
+
+  for(unsigned int p = 0; b_ok && p < i_programs; p++)
+  {
+    dvbpsi_pmt_t pmt;
+    dvbpsi_pmt_init(&pmt, p + 1, i_version, true, 0x200 + 8 * p);
+    for(unsigned int e = 0, i_es = 1 + random_next() % 6; e < i_es; e++)
+    {
+      dvbpsi_pmt_es_t *p_es = dvbpsi_pmt_es_add(&pmt, e ? 0x04 : 0x1b, 0x200 + 8 * p + e);
+      p_language[3] = e;
+      if(p_es && e)
+        dvbpsi_pmt_es_descriptor_add(p_es, 0x0a, 4, p_language);
+    }
+    b_ok = stream_push(p_stream, 0x100 + p, dvbpsi_pmt_sections_generate(p_dvbpsi, &pmt));
+    dvbpsi_pmt_empty(&pmt);
+  }
+
+  dvbpsi_sdt_t sdt;
+  dvbpsi_sdt_init(&sdt, 0x42, 1, i_version, true, 1);
+  for(unsigned int p = 0; p < i_programs; p++)
+  {
+    dvbpsi_sdt_service_t *p_srv = dvbpsi_sdt_service_add(&sdt, p + 1, false, true, 4, false);
+    if(p_srv)
+      dvbpsi_sdt_service_descriptor_add(p_srv, 0x48, sizeof(p_service), p_service);
+  }
+  b_ok = b_ok && stream_push(p_stream, 0x11, dvbpsi_sdt_sections_generate(p_dvbpsi, &sdt));
+  dvbpsi_sdt_empty(&sdt);
+
+  dvbpsi_nit_t nit;
+  dvbpsi_nit_init(&nit, 0x40, 1, 1, i_version, true);
+  for(unsigned int t = 0, i_ts = 1 + random_next() % 80; t < i_ts; t++)
+  {
+    dvbpsi_nit_ts_t *p_ts = dvbpsi_nit_ts_add(&nit, t + 1, 1);
+    if(p_ts)
+      dvbpsi_nit_ts_descriptor_add(p_ts, 0x44, sizeof(p_delivery), p_delivery);
+  }
+  b_ok = b_ok && stream_push(p_stream, 0x10, dvbpsi_nit_sections_generate(p_dvbpsi, &nit, 0x40));
+  dvbpsi_nit_empty(&nit);
+
+  dvbpsi_bat_t bat;
+  dvbpsi_bat_init(&bat, 0x4a, 0x1234, i_version, true);
+  for(unsigned int t = 0, i_ts = 1 + random_next() % 80; t < i_ts; t++)
+  {
+    dvbpsi_bat_ts_t *p_ts = dvbpsi_bat_ts_add(&bat, t + 1, 1);
+    if(p_ts)
+      dvbpsi_bat_ts_descriptor_add(p_ts, 0x41, 3, (uint8_t *)"\x00\x01\x01");
+  }
+  b_ok = b_ok && stream_push(p_stream, 0x11, dvbpsi_bat_sections_generate(p_dvbpsi, &bat));
+  dvbpsi_bat_empty(&bat);
+
+  for(unsigned int s = 0; b_ok && s < 2; s++)
+  {
+    dvbpsi_eit_t eit;
+    dvbpsi_eit_init(&eit, 0x4e, s + 1, i_version, true, 1, 1, 0, 0x4e);
+    for(unsigned int e = 0; e < 2; e++)
+    {
+      dvbpsi_eit_event_t *p_ev = dvbpsi_eit_event_add(&eit, e + 1,
+                                    ((uint64_t)0xe0b5 << 24) | ((uint64_t)e << 16),
+                                    0x010000, 4, false, 0);
+      if(p_ev)
+        dvbpsi_eit_event_descriptor_add(p_ev, 0x4d, sizeof(p_event), p_event);
+    }
+    b_ok = stream_push(p_stream, 0x12, dvbpsi_eit_sections_generate(p_dvbpsi, &eit, 0x4e));
+    dvbpsi_eit_empty(&eit);
+  }
+  return b_ok;
+}
+
+/* Damages about one packet in 16 */
+static void stream_damage(stream_t *p_stream)
+{
+  for(size_t i = 0; i + 1 < p_stream->i_packets; i++)
+  {
+    uint8_t *p_packet = p_stream->p_data + i * 188;
+    uint32_t i_draw = random_next();
+    uint8_t p_swap[188];
+
+    if(i_draw % 16)
+      continue;
+    switch((i_draw >> 4) % 6)
+    {
+    case 0:     /* a byte of the payload */
+      p_packet[4 + (i_draw >> 8) % 184] ^= 1 << ((i_draw >> 16) % 8);
+      break;
+    case 1:     /* continuity_counter */
+      p_packet[3] = (p_packet[3] & 0xf0) | ((i_draw >> 8) & 0x0f);
+      break;
+    case 2:     /* duplicated */
+      memcpy(p_packet + 188, p_packet, 188);
+      break;
+    case 3:     /* swapped with the next one */
+      memcpy(p_swap, p_packet, 188);
+      memcpy(p_packet, p_packet + 188, 188);
+      memcpy(p_packet + 188, p_swap, 188);
+      break;
+    case 4:     /* lost, its PID changed for a null packet */
+      p_packet[1] = (p_packet[1] & 0xe0) | 0x1f;
+      p_packet[2] = 0xff;
+      break;
+    default:    /* a section start in garbage */
+      p_packet[1] |= 0x40;
+      for(int b = 4; b < 188; b++)
+        p_packet[b] = random_next();
+      p_packet[4] %= 4;
+      break;
+    }
+  }
+}
+
+static bool stream_random(stream_t *p_stream, uint32_t i_seed)
+{
+  dvbpsi_t *p_dvbpsi = dvbpsi_new(NULL, DVBPSI_MSG_NONE);
+  bool b_ok = p_dvbpsi != NULL;
+
+  i_random = i_seed ? i_seed : 1;
+  for(unsigned int c = 0; b_ok && c < 48; c++)
+    /* versions going back and forth, some cycles repeated */
+    b_ok = stream_cycle(p_stream, p_dvbpsi, (c / (1 + i_seed % 3)) % 32);
+  if(p_dvbpsi)
+    dvbpsi_delete(p_dvbpsi);
+  return b_ok;
+}
+
+static bool stream_file(stream_t *p_stream, const char *psz_file)
+{
+  FILE *p_file = fopen(psz_file, "rb");
+  uint8_t p_packet[188];
+
+  if(p_file == NULL)
+    return false;
+  while(fread(p_packet, 188, 1, p_file) == 1)
+  {
+    if(p_packet[0] != 0x47)
+    {
+      fprintf(stderr, "%s: packet %zu is not a TS packet\n", psz_file, p_stream->i_packets);
+      fclose(p_file);
+      return false;
+    }
+    if(p_stream->i_packets == p_stream->i_max)
+    {
+      size_t i_max = 2 * p_stream->i_max + 1024;
+      uint8_t *p_data = realloc(p_stream->p_data, i_max * 188);
+      if(p_data == NULL)
+      {
+        fclose(p_file);
+        return false;
+      }
+      p_stream->p_data = p_data;
+      p_stream->i_max = i_max;
+    }
+    memcpy(p_stream->p_data + p_stream->i_packets++ * 188, p_packet, 188);
+  }
+  fclose(p_file);
+  return true;
+}
+
+/*****************************************************************************
+ * compare
+ *****************************************************************************/
+/* CRC_32 of every packet with each kernel, against the byte per byte one */
+static bool compare_crc(const stream_t *p_stream, const char *psz_name)
+{
+#ifdef DVBPSI_DIST
+  dvbpsi_crc32_kernel_t pf_reference = dvbpsi_crc32_kernel(DVBPSI_CRC32_BYTE);
+
+  for(int k = DVBPSI_CRC32_BYTE + 1; k < DVBPSI_CRC32_IMPL_MAX; k++)
+  {
+    dvbpsi_crc32_kernel_t pf_kernel = dvbpsi_crc32_kernel(k);
+    if(pf_kernel == NULL)
+      continue;
+    for(size_t i = 0; i < p_stream->i_packets; i++)
+    {
+      const uint8_t *p_packet = p_stream->p_data + i * 188;
+      size_t i_length = 1 + i % 187;
+      if(pf_kernel(0xffffffff, p_packet, i_length)
+         != pf_reference(0xffffffff, p_packet, i_length))
+      {
+        fprintf(stderr, "%s: %s CRC_32 differs on packet %zu\n", psz_name,
+                dvbpsi_crc32_name(k), i);
+        return false;
+      }
+    }
+  }
+#else
+  (void)p_stream;
+  (void)psz_name;
+#endif
+  return true;
+}
+
+/* Index of the record of a log at a byte offset */
+static size_t log_record(const log_t *p_log, size_t i_offset)
+{
+  size_t i_record = 0;
+  for(size_t i = 0; i + 7 <= p_log->i_length; i_record++)
+  {
+    size_t i_size = ((size_t)p_log->p_data[i + 3] << 24) | ((size_t)p_log->p_data[i + 4] << 16)
+                  | ((size_t)p_log->p_data[i + 5] << 8) | p_log->p_data[i + 6];
+    if(i_offset < i + 7 + i_size)
+      break;
+    i += 7 + i_size;
+  }
+  return i_record;
+}
+
+static bool compare(stream_t *p_stream, const char *psz_name, bool b_damaged)
+{
+  size_t i_compared = 0;
+  chain_t *p_reference = chain_new(0);
+  bool b_ok = p_reference != NULL && compare_crc(p_stream, psz_name);
+
+  if(p_reference)
+    chain_push(p_reference, p_stream->p_data, p_stream->i_packets);
+  if(b_ok && p_reference->log.b_error)
+  {
+    fprintf(stderr, "%s: the reference handles failed\n", psz_name);
+    b_ok = false;
+  }
+
+  for(size_t f = 0; b_ok && f < DIFF_OPTIONS; f++)
+  {
+    if(b_damaged && !p_options[f].b_damaged)
+      continue;
+    chain_t *p_chain = chain_new(p_options[f].i_flags);
+    if(p_chain == NULL)
+    {
+      b_ok = false;
+      break;
+    }
+    chain_push(p_chain, p_stream->p_data, p_stream->i_packets);
+
+    const log_t *p_ref = &p_reference->log, *p_log = &p_chain->log;
+    size_t i_common = p_ref->i_length < p_log->i_length ? p_ref->i_length : p_log->i_length;
+    size_t i = 0;
+    while(i < i_common && p_ref->p_data[i] == p_log->p_data[i])
+      i++;
+    if(p_log->b_error)
+    {
+      fprintf(stderr, "%s: the handles of options 0x%"PRIx32" failed\n",
+              psz_name, p_options[f].i_flags);
+      b_ok = false;
+    }
+    else if(i < i_common || p_ref->i_length != p_log->i_length)
+    {
+      size_t i_record = log_record(p_ref, i);
+      fprintf(stderr, "%s: options 0x%"PRIx32" differ from the reference at byte %zu, "
+              "record %zu of %zu\n", psz_name, p_options[f].i_flags, i, i_record,
+              p_ref->i_records);
+      b_ok = false;
+    }
+    chain_delete(p_chain);
+    i_compared++;
+  }
+
+  if(b_ok)
+    printf("%-24s %8zu packets %6zu tables and events, %2zu option sets identical\n",
+           psz_name, p_stream->i_packets, p_reference->log.i_records, i_compared);
+  if(p_reference)
+    chain_delete(p_reference);
+  return b_ok;
+}
+
+/*****************************************************************************
+ * main
+ *****************************************************************************/
+int main(int i_argc, char *pa_argv[])
+{
+  unsigned int i_streams = 16;
+  uint32_t i_seed = 1;
+  int i_ret = 0;
+  int a = 1;
+
+  for(; a + 1 < i_argc && pa_argv[a][0] == '-'; a += 2)
+  {
+    if(!strcmp(pa_argv[a], "-n"))
+      i_streams = atoi(pa_argv[a + 1]);
+    else if(!strcmp(pa_argv[a], "-s"))
+      i_seed = strtoul(pa_argv[a + 1], NULL, 0);
+    else
+      break;
+  }
+  if(a < i_argc && pa_argv[a][0] == '-')
+  {
+    fprintf(stderr, "usage: %s [-n streams] [-s seed] [file.ts ...]\n", pa_argv[0]);
+    return 1;
+  }
+
+  for(unsigned int s = 0; s < i_streams + (unsigned int)(i_argc - a) && i_ret == 0; s++)
+  {
+    stream_t *p_stream = calloc(1, sizeof(stream_t));
+    char psz_name[32];
+    const char *psz_stream = psz_name;
+    bool b_ok;
+
+    if(p_stream == NULL)
+      return 1;
+    if(s < i_streams)
+    {
+      p_stream->p_packetizer = dvbpsi_packetizer_new(p_stream->p_ring, DIFF_RING);
+      snprintf(psz_name, sizeof(psz_name), "random %"PRIu32, i_seed + s);
+      b_ok = p_stream->p_packetizer && stream_random(p_stream, i_seed + s);
+      if(b_ok && !compare(p_stream, psz_name, false))
+        i_ret = 1;
+      snprintf(psz_name, sizeof(psz_name), "random %"PRIu32" damaged", i_seed + s);
+      stream_damage(p_stream);
+    }
+    else
+    {
+      psz_stream = pa_argv[a + s - i_streams];
+      b_ok = stream_file(p_stream, psz_stream);
+    }
+
+    /* captured streams may have errors */
+    if(!b_ok)
+    {
+      fprintf(stderr, "%s: cannot make the stream\n", psz_stream);
+      i_ret = 1;
+    }
+    else if(i_ret == 0 && !compare(p_stream, psz_stream, true))
+      i_ret = 1;
+
+    if(p_stream->p_packetizer)
+      dvbpsi_packetizer_delete(p_stream->p_packetizer);
+    free(p_stream->p_data);
+    free(p_stream);
+  }
+  return i_ret;
+}
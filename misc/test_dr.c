@@ -219,6 +219,7 @@ static int main_astream_(void)
   BOZO_init_boolean(b_free_format, 0);
   BOZO_init_integer(i_id, 0);
   BOZO_init_integer(i_layer, 0);
+  BOZO_init_boolean(b_variable_rate_audio_indicator, 0);
   BOZO_begin_boolean(b_free_format)
     BOZO_DOJOB(AStream);
     BOZO_check_boolean(b_free_format)
@@ -229,6 +230,7 @@ static int main_astream_(void)
   BOZO_init_boolean(b_free_format, 0);
   BOZO_init_integer(i_id, 0);
   BOZO_init_integer(i_layer, 0);
+  BOZO_init_boolean(b_variable_rate_audio_indicator, 0);
   BOZO_begin_integer(i_id, 1)
     BOZO_DOJOB(AStream);
     BOZO_check_integer(i_id, 1)
@@ -239,12 +241,24 @@ static int main_astream_(void)
   BOZO_init_boolean(b_free_format, 0);
   BOZO_init_integer(i_id, 0);
   BOZO_init_integer(i_layer, 0);
+  BOZO_init_boolean(b_variable_rate_audio_indicator, 0);
   BOZO_begin_integer(i_layer, 2)
     BOZO_DOJOB(AStream);
     BOZO_check_integer(i_layer, 2)
     BOZO_CLEAN();
   BOZO_end_integer(i_layer, 2)
 
+  /* check b_variable_rate_audio_indicator */
+  BOZO_init_boolean(b_free_format, 0);
+  BOZO_init_integer(i_id, 0);
+  BOZO_init_integer(i_layer, 0);
+  BOZO_init_boolean(b_variable_rate_audio_indicator, 0);
+  BOZO_begin_boolean(b_variable_rate_audio_indicator)
+    BOZO_DOJOB(AStream);
+    BOZO_check_boolean(b_variable_rate_audio_indicator)
+    BOZO_CLEAN();
+  BOZO_end_boolean(b_variable_rate_audio_indicator)
+
 
   BOZO_END(audio stream);
 
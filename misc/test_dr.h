@@ -95,15 +95,15 @@
 #define BOZO_begin_boolean(name)                                        \
   if(!i_err)                                                            \
   {                                                                     \
+    int i_bool = 0;                                                     \
     fprintf(stdout, "  \"%s\" boolean check\n", #name);                 \
     i_loop_count = 0;                                                   \
-    s_decoded.name = 0;                                                 \
     do                                                                  \
-    {
+    {                                                                   \
+      s_decoded.name = i_bool;
 
 #define BOZO_end_boolean(name)                                          \
-      s_decoded.name += 12;                                             \
-    } while(!i_err && (s_decoded.name <= 12));                          \
+    } while(!i_err && (++i_bool < 2));                                  \
     fprintf(stdout, "\r  iteration count: %22"PRI64d, i_loop_count);       \
     if(i_err)                                                           \
       fprintf(stdout, "    FAILED !!!\n");                              \
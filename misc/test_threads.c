@@ -0,0 +1,355 @@
+/*****************************************************************************
+ * test_threads.c: concurrent decoding of independent handles
+ *----------------------------------------------------------------------------
+ * Copyright (c)2001-2012 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *
+ *----------------------------------------------------------------------------
+ *
+ * Runs one worker per thread, each with its own handles and options,
+ * generating PAT, PMT and SDT versions and decoding them back from TS
+ * packets. Distinct handles share no mutable state, so the workers run
+ * without any lock; build with -fsanitize=thread to check it.
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+/* the libdvbpsi distribution defines DVBPSI_DIST */
+#ifdef DVBPSI_DIST
+#include "../src/dvbpsi.h"
+#include "../src/psi.h"
+#include "../src/descriptor.h"
+#include "../src/demux.h"
+#include "../src/tables/pat.h"
+#include "../src/tables/pmt.h"
+#include "../src/tables/sdt.h"
+#else
+#include <dvbpsi/dvbpsi.h>
+#include <dvbpsi/psi.h>
+#include <dvbpsi/descriptor.h>
+#include <dvbpsi/demux.h>
+#include <dvbpsi/pat.h>
+#include <dvbpsi/pmt.h>
+#include <dvbpsi/sdt.h>
+#endif
+
+#define PMT_PID     0x100
+#define SDT_PID     0x11
+
+/* Options of the decoding handles, one set per worker in turn */
+static const uint32_t pi_flags[] =
+{
+  0,
+  DVBPSI_FLAG_ZERO_COPY | DVBPSI_FLAG_CRC_CACHE,
+  DVBPSI_FLAG_TABLE_ARENA,
+  DVBPSI_FLAG_LAZY_DECODE,
+  DVBPSI_FLAG_DESCRIPTOR_CACHE | DVBPSI_FLAG_INTERN_DESCRIPTORS,
+  DVBPSI_FLAG_SKIP_UNCHANGED | DVBPSI_FLAG_TABLE_ARENA | DVBPSI_FLAG_INTERN_DESCRIPTORS,
+  DVBPSI_FLAG_TABLE_ARRAYS | DVBPSI_FLAG_DESCRIPTOR_CACHE,
+  DVBPSI_FLAG_TABLE_ARRAYS | DVBPSI_FLAG_LAZY_DECODE | DVBPSI_FLAG_ZERO_COPY,
+};
+
+typedef struct worker_s
+{
+  pthread_t     thread;
+  unsigned int  i_id;
+  unsigned int  i_iterations;
+  uint32_t      i_flags;
+
+  /* version expected by the callbacks */
+  uint8_t       i_version;
+  unsigned int  i_programs;
+  unsigned int  i_es;
+
+  unsigned int  i_pat, i_pmt, i_sdt, i_messages, i_errors;
+
+  uint8_t       pi_cc[0x2000];
+  uint8_t       p_packets[188 * 64];
+} worker_t;
+
+/*****************************************************************************
+ * message
+ *****************************************************************************
+ * Counts the messages of a handle, which formats them.
+ *****************************************************************************/
+static void message(dvbpsi_t *p_dvbpsi, const dvbpsi_msg_level_t level, const char* msg)
+{
+  worker_t *p_worker = (worker_t *)p_dvbpsi->p_sys;
+  (void)level;
+  if(msg[0] != '\0')
+    p_worker->i_messages++;
+}
+
+/*****************************************************************************
+ * push
+ *****************************************************************************
+ * Packetizes sections and pushes them into a handle.
+ *****************************************************************************/
+static void push(worker_t *p_worker, dvbpsi_t *p_dvbpsi, uint16_t i_pid,
+                 dvbpsi_psi_section_t *p_sections)
+{
+  dvbpsi_psi_section_t *p_section;
+  unsigned int i_packets = 0;
+  unsigned int i;
+
+  for(p_section = p_sections; p_section; p_section = p_section->p_next)
+  {
+    uint8_t *p_byte = p_section->p_data;
+    uint8_t *p_end = p_section->p_payload_end + (p_section->b_syntax_indicator ? 4 : 0);
+    bool b_first = true;
+
+    while(p_byte < p_end && i_packets < 64)
+    {
+      uint8_t *p_packet = p_worker->p_packets + 188 * i_packets++;
+      uint8_t *p_pos = p_packet + 4;
+
+      p_packet[0] = 0x47;
+      p_packet[1] = (b_first ? 0x40 : 0x00) | (i_pid >> 8);
+      p_packet[2] = i_pid & 0xff;
+      p_packet[3] = 0x10 | p_worker->pi_cc[i_pid];
+      p_worker->pi_cc[i_pid] = (p_worker->pi_cc[i_pid] + 1) & 0x0f;
+      if(b_first)
+        *p_pos++ = 0x00; /* pointer_field */
+      while(p_pos < p_packet + 188 && p_byte < p_end)
+        *p_pos++ = *p_byte++;
+      memset(p_pos, 0xff, p_packet + 188 - p_pos);
+      b_first = false;
+    }
+  }
+  dvbpsi_DeletePSISections(p_sections);
+
+  for(i = 0; i < i_packets; i++)
+    dvbpsi_packet_push(p_dvbpsi, p_worker->p_packets + 188 * i);
+}
+
+/*****************************************************************************
+ * Table callbacks
+ *****************************************************************************/
+static void pat_cb(void *p_data, dvbpsi_pat_t *p_pat)
+{
+  worker_t *p_worker = (worker_t *)p_data;
+  dvbpsi_pat_program_t *p_program;
+  unsigned int i_programs = 0;
+
+  for(p_program = p_pat->p_first_program; p_program; p_program = p_program->p_next)
+    i_programs++;
+  if(p_pat->i_version != p_worker->i_version || i_programs != p_worker->i_programs)
+    p_worker->i_errors++;
+  p_worker->i_pat++;
+  dvbpsi_pat_delete(p_pat);
+}
+
+static void pmt_cb(void *p_data, dvbpsi_pmt_t *p_pmt)
+{
+  worker_t *p_worker = (worker_t *)p_data;
+  dvbpsi_pmt_es_t *p_es;
+  unsigned int i_es = 0;
+
+  dvbpsi_pmt_decode(p_pmt);
+  for(p_es = p_pmt->p_first_es; p_es; p_es = p_es->p_next)
+  {
+    if(p_es->p_first_descriptor == NULL || p_es->p_first_descriptor->i_tag != 0x0a)
+      p_worker->i_errors++;
+    i_es++;
+  }
+  if(p_pmt->i_version != p_worker->i_version || i_es != p_worker->i_es)
+    p_worker->i_errors++;
+  p_worker->i_pmt++;
+  dvbpsi_pmt_delete(p_pmt);
+}
+
+static void sdt_cb(void *p_data, dvbpsi_sdt_t *p_sdt)
+{
+  worker_t *p_worker = (worker_t *)p_data;
+  dvbpsi_sdt_service_t *p_service;
+  unsigned int i_services = 0;
+
+  dvbpsi_sdt_decode(p_sdt);
+  for(p_service = p_sdt->p_first_service; p_service; p_service = p_service->p_next)
+  {
+    if(p_service->p_first_descriptor == NULL
+    || p_service->p_first_descriptor->i_tag != 0x48)
+      p_worker->i_errors++;
+    i_services++;
+  }
+  if(p_sdt->i_version != p_worker->i_version || i_services != p_worker->i_programs - 1)
+    p_worker->i_errors++;
+  p_worker->i_sdt++;
+  dvbpsi_sdt_delete(p_sdt);
+}
+
+static void new_subtable(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_extension,
+                         void *p_data)
+{
+  if(i_table_id == 0x42)
+    dvbpsi_sdt_attach(p_dvbpsi, i_table_id, i_extension, sdt_cb, p_data);
+}
+
+/*****************************************************************************
+ * work
+ *****************************************************************************
+ * Generates and decodes a new version of each table per iteration.
+ *****************************************************************************/
+static void *work(void *p_data)
+{
+  worker_t *p_worker = (worker_t *)p_data;
+  dvbpsi_t *p_gen = dvbpsi_new(NULL, DVBPSI_MSG_NONE);
+  dvbpsi_t *p_pat_dec = dvbpsi_new(message, DVBPSI_MSG_DEBUG);
+  dvbpsi_t *p_pmt_dec = dvbpsi_new(message, DVBPSI_MSG_DEBUG);
+  dvbpsi_t *p_sdt_dec = dvbpsi_new(message, DVBPSI_MSG_DEBUG);
+  uint8_t p_language[4] = { 'e', 'n', 'g', 0 };
+  uint8_t p_service[16] = { 0x01, 3, 'o', 'n', 'e', 4, 'l', 'i', 'v', 'e' };
+  unsigned int i, j;
+
+  if(p_gen == NULL || p_pat_dec == NULL || p_pmt_dec == NULL || p_sdt_dec == NULL)
+  {
+    p_worker->i_errors++;
+    goto end;
+  }
+  p_pat_dec->p_sys = p_pmt_dec->p_sys = p_sdt_dec->p_sys = p_worker;
+  dvbpsi_set_flags(p_gen, DVBPSI_FLAG_ENCODER_CACHE);
+  dvbpsi_set_flags(p_pat_dec, p_worker->i_flags);
+  dvbpsi_set_flags(p_pmt_dec, p_worker->i_flags);
+  dvbpsi_set_flags(p_sdt_dec, p_worker->i_flags);
+  if(!dvbpsi_pat_attach(p_pat_dec, pat_cb, p_worker)
+  || !dvbpsi_pmt_attach(p_pmt_dec, 1, pmt_cb, p_worker)
+  || !dvbpsi_AttachDemux(p_sdt_dec, new_subtable, p_worker))
+  {
+    p_worker->i_errors++;
+    goto end;
+  }
+
+  for(i = 0; i < p_worker->i_iterations; i++)
+  {
+    dvbpsi_pat_t pat;
+    dvbpsi_pmt_t pmt;
+    dvbpsi_sdt_t sdt;
+
+    p_worker->i_version = i % 32;
+    p_worker->i_programs = 2 + (i + p_worker->i_id) % 60;
+    p_worker->i_es = 1 + i % 8;
+
+    dvbpsi_pat_init(&pat, 1, p_worker->i_version, true);
+    for(j = 0; j < p_worker->i_programs; j++)
+      dvbpsi_pat_program_add(&pat, j, j ? PMT_PID : 0x10);
+    push(p_worker, p_pat_dec, 0, dvbpsi_pat_sections_generate(p_gen, &pat, 16));
+    dvbpsi_pat_empty(&pat);
+
+    dvbpsi_pmt_init(&pmt, 1, p_worker->i_version, true, 0x101);
+    for(j = 0; j < p_worker->i_es; j++)
+    {
+      dvbpsi_pmt_es_t *p_es = dvbpsi_pmt_es_add(&pmt, j ? 0x04 : 0x02, 0x101 + j);
+      p_language[3] = j;
+      if(p_es)
+        dvbpsi_pmt_es_descriptor_add(p_es, 0x0a, 4, p_language);
+    }
+    push(p_worker, p_pmt_dec, PMT_PID, dvbpsi_pmt_sections_generate(p_gen, &pmt));
+    dvbpsi_pmt_empty(&pmt);
+
+    /* Identical service descriptors, shared when interned */
+    dvbpsi_sdt_init(&sdt, 0x42, 1, p_worker->i_version, true, 1);
+    for(j = 1; j < p_worker->i_programs; j++)
+    {
+      dvbpsi_sdt_service_t *p_sdt_service = dvbpsi_sdt_service_add(&sdt, j, false, true,
+                                                                   4, false);
+      if(p_sdt_service)
+        dvbpsi_sdt_service_descriptor_add(p_sdt_service, 0x48, 10, p_service);
+    }
+    push(p_worker, p_sdt_dec, SDT_PID, dvbpsi_sdt_sections_generate(p_gen, &sdt));
+    dvbpsi_sdt_empty(&sdt);
+  }
+
+  dvbpsi_pat_detach(p_pat_dec);
+  dvbpsi_pmt_detach(p_pmt_dec);
+  dvbpsi_DetachDemux(p_sdt_dec);
+end:
+  if(p_gen)
+    dvbpsi_delete(p_gen);
+  if(p_pat_dec)
+    dvbpsi_delete(p_pat_dec);
+  if(p_pmt_dec)
+    dvbpsi_delete(p_pmt_dec);
+  if(p_sdt_dec)
+    dvbpsi_delete(p_sdt_dec);
+  return NULL;
+}
+
+/*****************************************************************************
+ * main
+ *****************************************************************************/
+int main(int i_argc, char* pa_argv[])
+{
+  unsigned int i_threads = i_argc > 1 ? (unsigned int)atoi(pa_argv[1]) : 16;
+  unsigned int i_iterations = i_argc > 2 ? (unsigned int)atoi(pa_argv[2]) : 2000;
+  worker_t *p_workers;
+  unsigned int i;
+  int i_ret = 0;
+
+  if(i_threads == 0 || i_iterations == 0)
+  {
+    fprintf(stderr, "usage: %s [threads [iterations]]\n", pa_argv[0]);
+    return 1;
+  }
+
+  p_workers = calloc(i_threads, sizeof(worker_t));
+  if(p_workers == NULL)
+    return 1;
+
+  for(i = 0; i < i_threads; i++)
+  {
+    p_workers[i].i_id = i;
+    p_workers[i].i_iterations = i_iterations;
+    p_workers[i].i_flags = pi_flags[i % (sizeof(pi_flags) / sizeof(pi_flags[0]))];
+    if(pthread_create(&p_workers[i].thread, NULL, work, &p_workers[i]) != 0)
+    {
+      fprintf(stderr, "cannot create thread %u\n", i);
+      i_threads = i;
+      i_ret = 1;
+      break;
+    }
+  }
+
+  for(i = 0; i < i_threads; i++)
+  {
+    worker_t *p_worker = &p_workers[i];
+    pthread_join(p_worker->thread, NULL);
+    printf("worker %2u, flags 0x%03x: %u PAT, %u PMT, %u SDT, %u messages, %u errors\n",
+           i, p_worker->i_flags, p_worker->i_pat, p_worker->i_pmt, p_worker->i_sdt,
+           p_worker->i_messages, p_worker->i_errors);
+    if(p_worker->i_errors || p_worker->i_pat != i_iterations
+    || p_worker->i_pmt != i_iterations || p_worker->i_sdt != i_iterations)
+      i_ret = 1;
+  }
+
+  free(p_workers);
+  printf(i_ret ? "FAILED\n" : "OK\n");
+  return i_ret;
+}
@@ -0,0 +1,116 @@
+#!/bin/sh
+# amalgamate.sh: single translation unit of the library, see --enable-amalgamation
+#
+# Usage: amalgamate.sh srcdir file.c...
+#
+# Writes the given sources of srcdir to the standard output, one after the
+# other, with the local headers they include inlined at their first
+# inclusion only, as the headers of the library refuse a second one. The
+# #line directives keep the file names and lines of the diagnostics and of
+# the assertions. The macros a source defines are undefined after it, and
+# DVBPSI_MEM_CATEGORY gets the default of dvbpsi_private.h again for each
+# source, see dvbpsi_private.h. descriptors/dr.c, which includes every
+# descriptor header, comes before the first descriptors/dr_*.c so that the
+# single inclusion of dr_codec.h gets all the descriptor codecs.
+
+if test $# -lt 2; then
+  echo "usage: $0 srcdir file.c..." >&2
+  exit 2
+fi
+srcdir="$1"
+shift
+
+echo "/* Generated by amalgamate.sh from the sources of libdvbpsi, do not edit */"
+awk -v srcdir="$srcdir" '
+function normalize(path,    n, i, j, part, out)
+{
+  n = split(path, part, "/")
+  j = 0
+  for (i = 1; i <= n; i++)
+  {
+    if (part[i] == "." || part[i] == "")
+      continue
+    if (part[i] == ".." && j > 0 && out[j] != "..")
+      j--
+    else
+      out[++j] = part[i]
+  }
+  path = ""
+  for (i = 1; i <= j; i++)
+    path = path (i > 1 ? "/" : "") out[i]
+  return path
+}
+
+function dirname(path)
+{
+  if (path !~ /\//)
+    return ""
+  sub(/\/[^\/]*$/, "", path)
+  return path "/"
+}
+
+function inline(file, top,    line, lineno, name, path, macro, defined, n, i)
+{
+  printf "#line 1 \"%s\"\n", file
+  lineno = 0
+  n = 0
+  while ((getline line < (srcdir "/" file)) > 0)
+  {
+    lineno++
+    if (line ~ /^#[ \t]*include[ \t]*"/)
+    {
+      name = line
+      sub(/^#[ \t]*include[ \t]*"/, "", name)
+      sub(/".*$/, "", name)
+      path = normalize(dirname(file) name)
+      if ((getline < (srcdir "/" path)) < 0)
+      {
+        # outside of srcdir, like config.h: kept once
+        if (!(name in seen))
+          print line
+        seen[name] = 1
+        continue
+      }
+      close(srcdir "/" path)
+      if (path in seen)
+      {
+        if (path == "dvbpsi_private.h")
+          print "#ifndef DVBPSI_MEM_CATEGORY\n" \
+                "#   define DVBPSI_MEM_CATEGORY DVBPSI_MEM_OTHER\n" \
+                "#endif"
+        else
+          print ""
+        continue
+      }
+      seen[path] = 1
+      inline(path, 0)
+      printf "#line %d \"%s\"\n", lineno + 1, file
+      continue
+    }
+    if (top && line ~ /^#[ \t]*define[ \t]+[A-Za-z_]/)
+    {
+      macro = line
+      sub(/^#[ \t]*define[ \t]+/, "", macro)
+      sub(/[^A-Za-z0-9_].*$/, "", macro)
+      if (!(macro in defined))
+        defined[macro] = ++n
+    }
+    print line
+  }
+  close(srcdir "/" file)
+  for (macro in defined)
+    printf "#undef %s\n", macro
+}
+
+BEGIN {
+  for (i = 1; i < ARGC; i++)
+  {
+    print "#undef DVBPSI_MEM_CATEGORY"
+    inline(normalize(ARGV[i]), 1)
+  }
+  exit 0
+}' $(for f in "$@"; do echo "$f"; done | awk '
+  $0 == "descriptors/dr.c" { print; next }
+  /^descriptors\/dr_/ { dr[n++] = $0; next }
+  { print }
+  END { for (i = 0; i < n; i++) print dr[i] }')
@@ -0,0 +1,391 @@
+/*****************************************************************************
+ * bulk.c: bulk section generation
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "descriptor.h"
+#include "tables/pat.h"
+#include "tables/pmt.h"
+#include "tables/cat.h"
+#include "tables/nit.h"
+#include "tables/sdt.h"
+#include "tables/bat.h"
+#include "tables/eit.h"
+#include "tables/tot.h"
+#include "tables/rst.h"
+#include "tables/sis.h"
+#include "bulk.h"
+
+/*****************************************************************************
+ * dvbpsi_bulk_work_t
+ *****************************************************************************
+ * State of a bulk generation shared by its workers.
+ *****************************************************************************/
+typedef struct dvbpsi_bulk_work_s
+{
+    dvbpsi_bulk_job_t  *p_jobs;
+    size_t              i_jobs;
+    size_t              i_next;             /* next job to take */
+    unsigned int        i_workers;
+    dvbpsi_t          **pp_handles;         /* one per worker */
+} dvbpsi_bulk_work_t;
+
+#ifdef __ATOMIC_RELAXED
+#   define BULK_NEXT_JOB(p_work, i_worker, i_taken) \
+        __atomic_fetch_add(&(p_work)->i_next, 1, __ATOMIC_RELAXED)
+#else
+/* Without atomics each worker takes every i_workers-th job */
+#   define BULK_NEXT_JOB(p_work, i_worker, i_taken) \
+        ((i_taken) * (p_work)->i_workers + (i_worker))
+#endif
+
+/*****************************************************************************
+ * dvbpsi_bulk_job
+ *****************************************************************************
+ * Runs the generator of a job.
+ *****************************************************************************/
+static dvbpsi_psi_section_t *dvbpsi_bulk_job(dvbpsi_t *p_dvbpsi,
+                                             const dvbpsi_bulk_job_t *p_job)
+{
+    switch (p_job->i_type)
+    {
+        case DVBPSI_BULK_PAT:
+            return dvbpsi_pat_sections_generate(p_dvbpsi, p_job->p_table, p_job->i_param);
+        case DVBPSI_BULK_PMT:
+            return dvbpsi_pmt_sections_generate(p_dvbpsi, p_job->p_table);
+        case DVBPSI_BULK_CAT:
+            return dvbpsi_cat_sections_generate(p_dvbpsi, p_job->p_table);
+        case DVBPSI_BULK_NIT:
+            return dvbpsi_nit_sections_generate(p_dvbpsi, p_job->p_table, p_job->i_param);
+        case DVBPSI_BULK_SDT:
+            return dvbpsi_sdt_sections_generate(p_dvbpsi, p_job->p_table);
+        case DVBPSI_BULK_BAT:
+            return dvbpsi_bat_sections_generate(p_dvbpsi, p_job->p_table);
+        case DVBPSI_BULK_EIT:
+            return dvbpsi_eit_sections_generate(p_dvbpsi, p_job->p_table, p_job->i_param);
+        case DVBPSI_BULK_TOT:
+            return dvbpsi_tot_sections_generate(p_dvbpsi, p_job->p_table);
+        case DVBPSI_BULK_RST:
+            return dvbpsi_rst_sections_generate(p_dvbpsi, p_job->p_table);
+        case DVBPSI_BULK_SIS:
+            return dvbpsi_sis_sections_generate(p_dvbpsi, p_job->p_table);
+        default:
+            dvbpsi_error(p_dvbpsi, "bulk", "unknown table type %d", p_job->i_type);
+            return NULL;
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_bulk_work
+ *****************************************************************************
+ * A worker, generating jobs until there is none left.
+ *****************************************************************************/
+static void dvbpsi_bulk_work(void *p_data, unsigned int i_worker)
+{
+    dvbpsi_bulk_work_t *p_work = (dvbpsi_bulk_work_t *)p_data;
+    assert(i_worker < p_work->i_workers);
+
+    dvbpsi_t *p_dvbpsi = p_work->pp_handles[i_worker];
+    for (size_t i_taken = 0; ; i_taken++)
+    {
+        size_t i_job = BULK_NEXT_JOB(p_work, i_worker, i_taken);
+        if (i_job >= p_work->i_jobs)
+            break;
+
+        dvbpsi_bulk_job_t *p_job = &p_work->p_jobs[i_job];
+        p_job->p_sections = dvbpsi_bulk_job(p_dvbpsi, p_job);
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_bulk_generate
+ *****************************************************************************/
+bool dvbpsi_bulk_generate(dvbpsi_t *p_dvbpsi, dvbpsi_bulk_job_t *p_jobs,
+                          size_t i_jobs, unsigned int i_workers,
+                          dvbpsi_bulk_executor pf_executor,
+                          void *p_executor_data)
+{
+    assert(p_dvbpsi);
+    assert(p_jobs || i_jobs == 0);
+    assert(i_workers > 0);
+
+    for (size_t i = 0; i < i_jobs; i++)
+        p_jobs[i].p_sections = NULL;
+
+    if (pf_executor == NULL)
+    {
+        for (size_t i = 0; i < i_jobs; i++)
+            p_jobs[i].p_sections = dvbpsi_bulk_job(p_dvbpsi, &p_jobs[i]);
+    }
+    else
+    {
+        dvbpsi_bulk_work_t work = { p_jobs, i_jobs, 0, i_workers, NULL };
+        work.pp_handles = dvbpsi_calloc(i_workers, sizeof(dvbpsi_t *));
+        if (work.pp_handles == NULL)
+            return false;
+
+        bool b_ok = true;
+        for (unsigned int i = 0; i < i_workers && b_ok; i++)
+        {
+            work.pp_handles[i] = dvbpsi_new(p_dvbpsi->pf_message, p_dvbpsi->i_msg_level);
+            b_ok = work.pp_handles[i] != NULL;
+        }
+
+        if (b_ok)
+            pf_executor(p_executor_data, i_workers, dvbpsi_bulk_work, &work);
+
+        for (unsigned int i = 0; i < i_workers; i++)
+            dvbpsi_delete(work.pp_handles[i]);
+        dvbpsi_free(work.pp_handles);
+        if (!b_ok)
+            return false;
+    }
+
+    for (size_t i = 0; i < i_jobs; i++)
+    {
+        if (p_jobs[i].p_sections == NULL)
+            return false;
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_bulk_decode_t
+ *****************************************************************************
+ * State of a parallel decoding shared by its workers, each section being
+ * decoded into a partial table of its own.
+ *****************************************************************************/
+typedef struct dvbpsi_bulk_decode_s
+{
+    dvbpsi_bulk_table_t     i_type;
+    dvbpsi_psi_section_t  **pp_sections;    /* one per job, unlinked */
+    size_t                  i_jobs;
+    size_t                  i_next;         /* next job to take */
+    unsigned int            i_workers;
+    dvbpsi_arena_t        **pp_arenas;      /* one per worker, NULL for the heap */
+    uint8_t                *p_partials;     /* one table per job */
+    size_t                  i_partial_size;
+} dvbpsi_bulk_decode_t;
+
+static size_t dvbpsi_bulk_table_size(dvbpsi_bulk_table_t i_type)
+{
+    switch (i_type)
+    {
+        case DVBPSI_BULK_NIT: return sizeof(dvbpsi_nit_t);
+        case DVBPSI_BULK_SDT: return sizeof(dvbpsi_sdt_t);
+        case DVBPSI_BULK_BAT: return sizeof(dvbpsi_bat_t);
+        case DVBPSI_BULK_EIT: return sizeof(dvbpsi_eit_t);
+        default:              return 0;
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_bulk_table_decode
+ *****************************************************************************
+ * Decodes the raw sections of a table in the arena p_arena, the sections
+ * given when p_sections is not NULL.
+ *****************************************************************************/
+static void dvbpsi_bulk_table_decode(dvbpsi_bulk_table_t i_type, void *p_table,
+                                     dvbpsi_arena_t *p_arena,
+                                     dvbpsi_psi_section_t *p_sections)
+{
+#define BULK_DECODE(type, table)                                             \
+    do {                                                                     \
+        type *p = (type *)p_table;                                           \
+        if (p_sections)                                                      \
+        {                                                                    \
+            p->p_arena = p_arena;                                            \
+            p->p_sections = p_sections;                                      \
+        }                                                                    \
+        dvbpsi_##table##_decode(p);                                          \
+    } while(0)
+
+    switch (i_type)
+    {
+        case DVBPSI_BULK_NIT: BULK_DECODE(dvbpsi_nit_t, nit); break;
+        case DVBPSI_BULK_SDT: BULK_DECODE(dvbpsi_sdt_t, sdt); break;
+        case DVBPSI_BULK_BAT: BULK_DECODE(dvbpsi_bat_t, bat); break;
+        case DVBPSI_BULK_EIT: BULK_DECODE(dvbpsi_eit_t, eit); break;
+        default: break;
+    }
+#undef BULK_DECODE
+}
+
+/*****************************************************************************
+ * dvbpsi_bulk_table_splice
+ *****************************************************************************
+ * Appends the lists of the partial table p_part to those of p_table.
+ *****************************************************************************/
+static void dvbpsi_bulk_table_splice(dvbpsi_bulk_table_t i_type, void *p_table,
+                                     void *p_part)
+{
+#define BULK_SPLICE(type, first, last)                                       \
+    dvbpsi_list_splice(((type *)p_table)->first, ((type *)p_table)->last,    \
+                       ((type *)p_part)->first, ((type *)p_part)->last)
+
+    switch (i_type)
+    {
+        case DVBPSI_BULK_NIT:
+            BULK_SPLICE(dvbpsi_nit_t, p_first_descriptor, p_last_descriptor);
+            BULK_SPLICE(dvbpsi_nit_t, p_first_ts, p_last_ts);
+            break;
+        case DVBPSI_BULK_SDT:
+            BULK_SPLICE(dvbpsi_sdt_t, p_first_service, p_last_service);
+            break;
+        case DVBPSI_BULK_BAT:
+            BULK_SPLICE(dvbpsi_bat_t, p_first_descriptor, p_last_descriptor);
+            BULK_SPLICE(dvbpsi_bat_t, p_first_ts, p_last_ts);
+            break;
+        case DVBPSI_BULK_EIT:
+            BULK_SPLICE(dvbpsi_eit_t, p_first_event, p_last_event);
+            break;
+        default:
+            break;
+    }
+#undef BULK_SPLICE
+}
+
+/*****************************************************************************
+ * dvbpsi_bulk_decode_work
+ *****************************************************************************
+ * A worker, decoding sections until there is none left.
+ *****************************************************************************/
+static void dvbpsi_bulk_decode_work(void *p_data, unsigned int i_worker)
+{
+    dvbpsi_bulk_decode_t *p_work = (dvbpsi_bulk_decode_t *)p_data;
+    assert(i_worker < p_work->i_workers);
+
+    for (size_t i_taken = 0; ; i_taken++)
+    {
+        size_t i_job = BULK_NEXT_JOB(p_work, i_worker, i_taken);
+        if (i_job >= p_work->i_jobs)
+            break;
+
+        dvbpsi_bulk_table_decode(p_work->i_type,
+                                 p_work->p_partials + i_job * p_work->i_partial_size,
+                                 p_work->pp_arenas[i_worker],
+                                 p_work->pp_sections[i_job]);
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_bulk_decode
+ *****************************************************************************/
+bool dvbpsi_bulk_decode(dvbpsi_bulk_table_t i_type, void *p_table,
+                        unsigned int i_workers, dvbpsi_bulk_executor pf_executor,
+                        void *p_executor_data)
+{
+    assert(p_table);
+    assert(i_workers > 0);
+
+    size_t i_size = dvbpsi_bulk_table_size(i_type);
+    if (i_size == 0)
+        return false;
+
+    /* The raw sections and the arena are the same members of all the types */
+    dvbpsi_psi_section_t **pp_table_sections = NULL;
+    dvbpsi_arena_t *p_table_arena = NULL;
+    switch (i_type)
+    {
+#define BULK_MEMBERS(type)                                                   \
+        pp_table_sections = &((type *)p_table)->p_sections;                  \
+        p_table_arena = ((type *)p_table)->p_arena;                          \
+        break
+        case DVBPSI_BULK_NIT: BULK_MEMBERS(dvbpsi_nit_t);
+        case DVBPSI_BULK_SDT: BULK_MEMBERS(dvbpsi_sdt_t);
+        case DVBPSI_BULK_BAT: BULK_MEMBERS(dvbpsi_bat_t);
+        case DVBPSI_BULK_EIT: BULK_MEMBERS(dvbpsi_eit_t);
+#undef BULK_MEMBERS
+        default: return false;
+    }
+
+    size_t i_jobs = 0;
+    for (dvbpsi_psi_section_t *p = *pp_table_sections; p; p = p->p_next)
+        i_jobs++;
+
+    dvbpsi_bulk_decode_t work = { i_type, NULL, i_jobs, 0, i_workers, NULL, NULL, i_size };
+    if (pf_executor && i_jobs > 1)
+    {
+        work.pp_sections = dvbpsi_calloc(i_jobs, sizeof(dvbpsi_psi_section_t *));
+        work.pp_arenas = dvbpsi_calloc(i_workers, sizeof(dvbpsi_arena_t *));
+        work.p_partials = dvbpsi_calloc(i_jobs, i_size);
+    }
+
+    bool b_parallel = work.pp_sections && work.pp_arenas && work.p_partials;
+    for (unsigned int i = 0; b_parallel && p_table_arena && i < i_workers; i++)
+    {
+        work.pp_arenas[i] = dvbpsi_arena_new();
+        b_parallel = work.pp_arenas[i] != NULL;
+    }
+
+    if (!b_parallel)
+    {
+        /* Too small a table or out of memory */
+        for (unsigned int i = 0; work.pp_arenas && i < i_workers; i++)
+            dvbpsi_arena_delete(work.pp_arenas[i]);
+        dvbpsi_free(work.pp_arenas);
+        dvbpsi_free(work.pp_sections);
+        dvbpsi_free(work.p_partials);
+        dvbpsi_bulk_table_decode(i_type, p_table, NULL, NULL);
+        return true;
+    }
+
+    /* Each section on its own, freed by the decoding of its partial table */
+    dvbpsi_psi_section_t *p_section = *pp_table_sections;
+    for (size_t i = 0; i < i_jobs; i++)
+    {
+        work.pp_sections[i] = p_section;
+        p_section = p_section->p_next;
+        work.pp_sections[i]->p_next = NULL;
+    }
+    *pp_table_sections = NULL;
+
+    pf_executor(p_executor_data, i_workers, dvbpsi_bulk_decode_work, &work);
+
+    for (size_t i = 0; i < i_jobs; i++)
+        dvbpsi_bulk_table_splice(i_type, p_table, work.p_partials + i * i_size);
+    for (unsigned int i = 0; p_table_arena && i < i_workers; i++)
+        dvbpsi_arena_merge(p_table_arena, work.pp_arenas[i]);
+
+    dvbpsi_free(work.pp_arenas);
+    dvbpsi_free(work.pp_sections);
+    dvbpsi_free(work.p_partials);
+    return true;
+}
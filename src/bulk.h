@@ -0,0 +1,184 @@
+/*****************************************************************************
+ * bulk.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <bulk.h>
+ * \brief Bulk section generation and parallel table decoding.
+ *
+ * Generates the sections of many tables at once, or decodes the sections of
+ * a large table, spreading them over workers run by an executor of the
+ * application, for instance a thread pool, the library itself creating no
+ * thread.
+ */
+
+#ifndef _DVBPSI_BULK_H_
+#define _DVBPSI_BULK_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_bulk_table_t
+ *****************************************************************************/
+/*!
+ * \enum dvbpsi_bulk_table
+ * \brief Type of the table of a bulk generation job
+ */
+enum dvbpsi_bulk_table
+{
+    DVBPSI_BULK_PAT,    /*!< dvbpsi_pat_t, i_param is i_max_pps */
+    DVBPSI_BULK_PMT,    /*!< dvbpsi_pmt_t */
+    DVBPSI_BULK_CAT,    /*!< dvbpsi_cat_t */
+    DVBPSI_BULK_NIT,    /*!< dvbpsi_nit_t, i_param is the table_id */
+    DVBPSI_BULK_SDT,    /*!< dvbpsi_sdt_t */
+    DVBPSI_BULK_BAT,    /*!< dvbpsi_bat_t */
+    DVBPSI_BULK_EIT,    /*!< dvbpsi_eit_t, i_param is the table_id */
+    DVBPSI_BULK_TOT,    /*!< dvbpsi_tot_t */
+    DVBPSI_BULK_RST,    /*!< dvbpsi_rst_t */
+    DVBPSI_BULK_SIS,    /*!< dvbpsi_sis_t */
+};
+
+/*!
+ * \typedef enum dvbpsi_bulk_table dvbpsi_bulk_table_t
+ * \brief dvbpsi_bulk_table_t type definition.
+ */
+typedef enum dvbpsi_bulk_table dvbpsi_bulk_table_t;
+
+/*****************************************************************************
+ * dvbpsi_bulk_job_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_bulk_job_s
+ * \brief Table to generate and its sections.
+ */
+/*!
+ * \typedef struct dvbpsi_bulk_job_s dvbpsi_bulk_job_t
+ * \brief dvbpsi_bulk_job_t type definition.
+ */
+typedef struct dvbpsi_bulk_job_s
+{
+    dvbpsi_bulk_table_t     i_type;         /*!< type of p_table */
+    void                   *p_table;        /*!< table, not modified */
+    int                     i_param;        /*!< argument of the generator,
+                                                 see dvbpsi_bulk_table */
+
+    dvbpsi_psi_section_t   *p_sections;     /*!< filled with the sections,
+                                                 NULL on error */
+} dvbpsi_bulk_job_t;
+
+/*****************************************************************************
+ * dvbpsi_bulk_worker
+ *****************************************************************************/
+/*!
+ * \typedef void (* dvbpsi_bulk_worker)(void *p_work, unsigned int i_worker)
+ * \brief Worker of a bulk generation, which generates jobs until there is
+ * none left.
+ */
+typedef void (* dvbpsi_bulk_worker)(void *p_work, unsigned int i_worker);
+
+/*****************************************************************************
+ * dvbpsi_bulk_executor
+ *****************************************************************************/
+/*!
+ * \typedef void (* dvbpsi_bulk_executor)(void *p_executor_data,
+ *                                        unsigned int i_workers,
+ *                                        dvbpsi_bulk_worker pf_worker,
+ *                                        void *p_work)
+ * \brief Executor of the application.
+ *
+ * It must call pf_worker(p_work, i) once for each i from 0 to
+ * i_workers - 1, in parallel or not, and only return once all these calls
+ * have returned.
+ */
+typedef void (* dvbpsi_bulk_executor)(void *p_executor_data,
+                                      unsigned int i_workers,
+                                      dvbpsi_bulk_worker pf_worker,
+                                      void *p_work);
+
+/*****************************************************************************
+ * dvbpsi_bulk_generate
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_bulk_generate(dvbpsi_t *p_dvbpsi, dvbpsi_bulk_job_t *p_jobs,
+ *                               size_t i_jobs, unsigned int i_workers,
+ *                               dvbpsi_bulk_executor pf_executor,
+ *                               void *p_executor_data)
+ * \brief Generates the sections of a set of tables
+ * \param p_dvbpsi handle whose message callback and level the workers use
+ * \param p_jobs jobs, whose p_sections are filled
+ * \param i_jobs number of jobs
+ * \param i_workers number of workers, at least 1
+ * \param pf_executor executor running the workers, or NULL to generate all
+ *        the jobs in the calling thread with p_dvbpsi
+ * \param p_executor_data private data given to pf_executor
+ * \return false if a job failed, true otherwise.
+ *
+ * Each worker generates with a handle of its own, created for the call
+ * without any flag: distinct jobs must not share a table, and the message
+ * callback and the allocator must be thread safe when the workers run in
+ * parallel. The sections of the jobs are as if generated in a row by the
+ * dvbpsi_xxx_sections_generate() functions.
+ */
+bool dvbpsi_bulk_generate(dvbpsi_t *p_dvbpsi, dvbpsi_bulk_job_t *p_jobs,
+                          size_t i_jobs, unsigned int i_workers,
+                          dvbpsi_bulk_executor pf_executor,
+                          void *p_executor_data);
+
+/*****************************************************************************
+ * dvbpsi_bulk_decode
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_bulk_decode(dvbpsi_bulk_table_t i_type, void *p_table,
+ *                             unsigned int i_workers,
+ *                             dvbpsi_bulk_executor pf_executor,
+ *                             void *p_executor_data)
+ * \brief Decodes the raw sections of a table received with
+ *        DVBPSI_FLAG_LAZY_DECODE, one section per job
+ * \param i_type DVBPSI_BULK_NIT, DVBPSI_BULK_SDT, DVBPSI_BULK_BAT or
+ *        DVBPSI_BULK_EIT
+ * \param p_table table, whose p_sections are decoded and released
+ * \param i_workers number of workers, at least 1
+ * \param pf_executor executor running the workers, or NULL to decode the
+ *        table in the calling thread
+ * \param p_executor_data private data given to pf_executor
+ * \return false for another type of table, true otherwise.
+ *
+ * The loops of each section are decoded into partial lists, which are then
+ * linked in section order: the table ends up as after dvbpsi_nit_decode(),
+ * dvbpsi_sdt_decode(), dvbpsi_bat_decode() or dvbpsi_eit_decode(). With
+ * DVBPSI_FLAG_TABLE_ARENA each worker allocates in an arena of its own,
+ * given to the table at the end, otherwise the allocator must be thread
+ * safe when the workers run in parallel. Out of memory, the section
+ * decoding stops as in these functions.
+ */
+bool dvbpsi_bulk_decode(dvbpsi_bulk_table_t i_type, void *p_table,
+                        unsigned int i_workers, dvbpsi_bulk_executor pf_executor,
+                        void *p_executor_data);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of bulk.h"
+#endif
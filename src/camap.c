@@ -0,0 +1,452 @@
+/*****************************************************************************
+ * camap.c: conditional access PID map
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "descriptor.h"
+#include "tables/pat.h"
+#include "tables/pmt.h"
+#include "tables/cat.h"
+#include "camap.h"
+
+/*****************************************************************************
+ * dvbpsi_camap_program_t
+ *****************************************************************************
+ * Program, or the CAT for program_number 0, with the hash of the CA
+ * descriptors it was last updated with.
+ *****************************************************************************/
+typedef struct dvbpsi_camap_program_s
+{
+    uint16_t                i_number;
+    uint64_t                i_hash;
+} dvbpsi_camap_program_t;
+
+struct dvbpsi_camap_s
+{
+    dvbpsi_camap_callback   pf_callback;
+    void *                  p_cb_data;
+
+    /* Entries of all the programs, ordered */
+    dvbpsi_camap_entry_t *  p_entries;
+    size_t                  i_entries;
+
+    /* Programs, by program_number */
+    dvbpsi_camap_program_t *p_programs;
+    size_t                  i_programs;
+    size_t                  i_programs_size;
+
+    /* Entries of the table being read, kept across updates */
+    dvbpsi_camap_entry_t *  p_scratch;
+    size_t                  i_scratch;
+    size_t                  i_scratch_size;
+    bool                    b_error;
+};
+
+/* FNV-1a */
+static uint64_t dvbpsi_camap_hash(uint64_t i_hash, const uint8_t *p_data, size_t i_length)
+{
+    for (size_t i = 0; i < i_length; i++)
+        i_hash = (i_hash ^ p_data[i]) * UINT64_C(0x100000001b3);
+    return i_hash;
+}
+
+#define DVBPSI_CAMAP_HASH_INIT UINT64_C(0xcbf29ce484222325)
+
+/***** dvbpsi_camap_compare ***** Order of the entries *****/
+static int dvbpsi_camap_compare(const dvbpsi_camap_entry_t *p_a,
+                                const dvbpsi_camap_entry_t *p_b)
+{
+    uint64_t i_a = ((uint64_t)p_a->i_program_number << 48)
+                 | ((uint64_t)p_a->i_es_pid << 32)
+                 | ((uint32_t)p_a->i_ca_system_id << 16) | p_a->i_ca_pid;
+    uint64_t i_b = ((uint64_t)p_b->i_program_number << 48)
+                 | ((uint64_t)p_b->i_es_pid << 32)
+                 | ((uint32_t)p_b->i_ca_system_id << 16) | p_b->i_ca_pid;
+    return (i_a > i_b) - (i_a < i_b);
+}
+
+static int dvbpsi_camap_sort(const void *p_a, const void *p_b)
+{
+    return dvbpsi_camap_compare((const dvbpsi_camap_entry_t *)p_a,
+                                (const dvbpsi_camap_entry_t *)p_b);
+}
+
+/*****************************************************************************
+ * dvbpsi_camap_read
+ *****************************************************************************
+ * Hashes a CA descriptor of a table, with the PID of its loop, and adds it
+ * to the scratch entries.
+ *****************************************************************************/
+static uint64_t dvbpsi_camap_read(dvbpsi_camap_t *p_camap, uint64_t i_hash,
+                                  uint16_t i_program_number, uint16_t i_es_pid,
+                                  const dvbpsi_descriptor_t *p_descriptor)
+{
+    if (p_descriptor->i_tag != 0x09 || p_descriptor->i_length < 4)
+        return i_hash;
+
+    uint8_t p_key[2] = { i_es_pid >> 8, i_es_pid & 0xff };
+    i_hash = dvbpsi_camap_hash(i_hash, p_key, 2);
+    i_hash = dvbpsi_camap_hash(i_hash, &p_descriptor->i_length, 1);
+    i_hash = dvbpsi_camap_hash(i_hash, p_descriptor->p_data, p_descriptor->i_length);
+
+    if (p_camap->i_scratch == p_camap->i_scratch_size)
+    {
+        size_t i_size = p_camap->i_scratch_size ? 2 * p_camap->i_scratch_size : 16;
+        dvbpsi_camap_entry_t *p_scratch = dvbpsi_malloc(i_size * sizeof(dvbpsi_camap_entry_t));
+        if (p_scratch == NULL)
+        {
+            p_camap->b_error = true;
+            return i_hash;
+        }
+        if (p_camap->i_scratch)
+            memcpy(p_scratch, p_camap->p_scratch,
+                   p_camap->i_scratch * sizeof(dvbpsi_camap_entry_t));
+        dvbpsi_free(p_camap->p_scratch);
+        p_camap->p_scratch = p_scratch;
+        p_camap->i_scratch_size = i_size;
+    }
+
+    dvbpsi_camap_entry_t *p_entry = &p_camap->p_scratch[p_camap->i_scratch++];
+    p_entry->i_program_number = i_program_number;
+    p_entry->i_es_pid = i_es_pid;
+    p_entry->i_ca_system_id = ((uint16_t)p_descriptor->p_data[0] << 8)
+                            | p_descriptor->p_data[1];
+    p_entry->i_ca_pid = ((uint16_t)(p_descriptor->p_data[2] & 0x1f) << 8)
+                      | p_descriptor->p_data[3];
+    return i_hash;
+}
+
+/***** dvbpsi_camap_range ***** First entry of a program or after it *****/
+static size_t dvbpsi_camap_range(const dvbpsi_camap_t *p_camap, uint32_t i_program_number)
+{
+    size_t i_low = 0, i_high = p_camap->i_entries;
+    while (i_low < i_high)
+    {
+        size_t i_mid = (i_low + i_high) / 2;
+        if (p_camap->p_entries[i_mid].i_program_number < i_program_number)
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
+}
+
+/***** dvbpsi_camap_program ***** Index of a program, or where to insert it *****/
+static size_t dvbpsi_camap_program(const dvbpsi_camap_t *p_camap, uint16_t i_program_number)
+{
+    size_t i_low = 0, i_high = p_camap->i_programs;
+    while (i_low < i_high)
+    {
+        size_t i_mid = (i_low + i_high) / 2;
+        if (p_camap->p_programs[i_mid].i_number < i_program_number)
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
+}
+
+/*****************************************************************************
+ * dvbpsi_camap_replace
+ *****************************************************************************
+ * Replaces the entries of a program with the scratch entries, and calls the
+ * callback with the differences.
+ *****************************************************************************/
+static bool dvbpsi_camap_replace(dvbpsi_camap_t *p_camap, uint16_t i_program_number)
+{
+    dvbpsi_camap_entry_t *p_new = p_camap->p_scratch;
+    size_t i_new = p_camap->i_scratch;
+
+    /* Duplicates are a single entry */
+    if (i_new > 1)
+    {
+        qsort(p_new, i_new, sizeof(dvbpsi_camap_entry_t), dvbpsi_camap_sort);
+        size_t j = 1;
+        for (size_t i = 1; i < i_new; i++)
+            if (dvbpsi_camap_compare(&p_new[i], &p_new[j - 1]) != 0)
+                p_new[j++] = p_new[i];
+        i_new = j;
+    }
+
+    size_t i_first = dvbpsi_camap_range(p_camap, i_program_number);
+    size_t i_last = dvbpsi_camap_range(p_camap, (uint32_t)i_program_number + 1);
+    size_t i_old = i_last - i_first;
+    size_t i_entries = p_camap->i_entries - i_old + i_new;
+
+    dvbpsi_camap_entry_t *p_entries = NULL;
+    if (i_entries)
+    {
+        p_entries = dvbpsi_malloc(i_entries * sizeof(dvbpsi_camap_entry_t));
+        if (p_entries == NULL)
+            return false;
+        if (i_first)
+            memcpy(p_entries, p_camap->p_entries, i_first * sizeof(dvbpsi_camap_entry_t));
+        if (i_new)
+            memcpy(p_entries + i_first, p_new, i_new * sizeof(dvbpsi_camap_entry_t));
+        if (i_last < p_camap->i_entries)
+            memcpy(p_entries + i_first + i_new, p_camap->p_entries + i_last,
+                   (p_camap->i_entries - i_last) * sizeof(dvbpsi_camap_entry_t));
+    }
+
+    /* The callback sees the map updated */
+    dvbpsi_camap_entry_t *p_previous = p_camap->p_entries;
+    const dvbpsi_camap_entry_t *p_old = p_previous + i_first;
+    p_camap->p_entries = p_entries;
+    p_camap->i_entries = i_entries;
+
+    size_t i = 0, j = 0;
+    while (i < i_old || j < i_new)
+    {
+        int i_order = i == i_old ? 1 : j == i_new ? -1
+                    : dvbpsi_camap_compare(&p_old[i], &p_new[j]);
+        if (i_order < 0)
+            p_camap->pf_callback(p_camap->p_cb_data, false, &p_old[i]);
+        i += i_order <= 0;
+        j += i_order >= 0;
+    }
+    for (i = 0, j = 0; i < i_old || j < i_new; )
+    {
+        int i_order = i == i_old ? 1 : j == i_new ? -1
+                    : dvbpsi_camap_compare(&p_old[i], &p_new[j]);
+        if (i_order > 0)
+            p_camap->pf_callback(p_camap->p_cb_data, true, &p_new[j]);
+        i += i_order <= 0;
+        j += i_order >= 0;
+    }
+
+    dvbpsi_free(p_previous);
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_camap_update
+ *****************************************************************************
+ * Updates a program with the scratch entries unless its hash is unchanged.
+ *****************************************************************************/
+static bool dvbpsi_camap_update(dvbpsi_camap_t *p_camap, uint16_t i_program_number,
+                                uint64_t i_hash)
+{
+    if (p_camap->b_error)
+        return false;
+
+    size_t i = dvbpsi_camap_program(p_camap, i_program_number);
+    bool b_known = i < p_camap->i_programs && p_camap->p_programs[i].i_number == i_program_number;
+    if (b_known && p_camap->p_programs[i].i_hash == i_hash)
+        return true;
+
+    if (!b_known && p_camap->i_programs == p_camap->i_programs_size)
+    {
+        size_t i_size = p_camap->i_programs_size ? 2 * p_camap->i_programs_size : 8;
+        dvbpsi_camap_program_t *p_programs = dvbpsi_malloc(i_size * sizeof(dvbpsi_camap_program_t));
+        if (p_programs == NULL)
+            return false;
+        if (p_camap->i_programs)
+            memcpy(p_programs, p_camap->p_programs,
+                   p_camap->i_programs * sizeof(dvbpsi_camap_program_t));
+        dvbpsi_free(p_camap->p_programs);
+        p_camap->p_programs = p_programs;
+        p_camap->i_programs_size = i_size;
+    }
+
+    if (!dvbpsi_camap_replace(p_camap, i_program_number))
+        return false;
+
+    if (!b_known)
+    {
+        memmove(&p_camap->p_programs[i + 1], &p_camap->p_programs[i],
+                (p_camap->i_programs - i) * sizeof(dvbpsi_camap_program_t));
+        p_camap->p_programs[i].i_number = i_program_number;
+        p_camap->i_programs++;
+    }
+    p_camap->p_programs[i].i_hash = i_hash;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_camap_new
+ *****************************************************************************/
+dvbpsi_camap_t *dvbpsi_camap_new(dvbpsi_camap_callback pf_callback, void *p_cb_data)
+{
+    assert(pf_callback);
+
+    dvbpsi_camap_t *p_camap = dvbpsi_calloc(1, sizeof(dvbpsi_camap_t));
+    if (p_camap == NULL)
+        return NULL;
+
+    p_camap->pf_callback = pf_callback;
+    p_camap->p_cb_data = p_cb_data;
+    return p_camap;
+}
+
+/*****************************************************************************
+ * dvbpsi_camap_delete
+ *****************************************************************************/
+void dvbpsi_camap_delete(dvbpsi_camap_t *p_camap)
+{
+    if (p_camap == NULL)
+        return;
+
+    dvbpsi_free(p_camap->p_entries);
+    dvbpsi_free(p_camap->p_programs);
+    dvbpsi_free(p_camap->p_scratch);
+    dvbpsi_free(p_camap);
+}
+
+/*****************************************************************************
+ * dvbpsi_camap_cat
+ *****************************************************************************/
+bool dvbpsi_camap_cat(dvbpsi_camap_t *p_camap, const dvbpsi_cat_t *p_cat)
+{
+    assert(p_camap);
+    assert(p_cat);
+
+    if (!p_cat->b_current_next)
+        return true;
+
+    p_camap->i_scratch = 0;
+    p_camap->b_error = false;
+    uint64_t i_hash = DVBPSI_CAMAP_HASH_INIT;
+    for (const dvbpsi_descriptor_t *p = p_cat->p_first_descriptor; p; p = p->p_next)
+        i_hash = dvbpsi_camap_read(p_camap, i_hash, 0, DVBPSI_CAMAP_PROGRAM, p);
+
+    return dvbpsi_camap_update(p_camap, 0, i_hash);
+}
+
+/*****************************************************************************
+ * dvbpsi_camap_pmt
+ *****************************************************************************/
+bool dvbpsi_camap_pmt(dvbpsi_camap_t *p_camap, const dvbpsi_pmt_t *p_pmt)
+{
+    assert(p_camap);
+    assert(p_pmt);
+
+    if (!p_pmt->b_current_next || p_pmt->i_program_number == 0)
+        return true;
+
+    uint16_t i_number = p_pmt->i_program_number;
+    p_camap->i_scratch = 0;
+    p_camap->b_error = false;
+    uint64_t i_hash = DVBPSI_CAMAP_HASH_INIT;
+
+    /* DVBPSI_FLAG_LAZY_DECODE, read from the raw sections */
+    if (p_pmt->p_sections)
+    {
+        dvbpsi_descriptor_iter_t descriptors;
+        dvbpsi_entry_iter_t es;
+        dvbpsi_descriptor_t view;
+        uint8_t *p_header;
+
+        for (dvbpsi_psi_section_t *p_section = p_pmt->p_sections; p_section;
+             p_section = p_section->p_next)
+        {
+            if (!dvbpsi_pmt_section_iter(p_section, &descriptors, &es))
+                continue;
+            while (dvbpsi_descriptor_iter_next(&descriptors, &view))
+                i_hash = dvbpsi_camap_read(p_camap, i_hash, i_number,
+                                           DVBPSI_CAMAP_PROGRAM, &view);
+            while ((p_header = dvbpsi_entry_iter_next(&es, &descriptors)) != NULL)
+            {
+                uint16_t i_pid = ((uint16_t)(p_header[1] & 0x1f) << 8) | p_header[2];
+                while (dvbpsi_descriptor_iter_next(&descriptors, &view))
+                    i_hash = dvbpsi_camap_read(p_camap, i_hash, i_number, i_pid, &view);
+            }
+        }
+        return dvbpsi_camap_update(p_camap, i_number, i_hash);
+    }
+
+    /* The tag bitmaps skip the loops without a CA descriptor */
+    if (dvbpsi_has_descriptor(p_pmt->p_tags, 0x09))
+        for (const dvbpsi_descriptor_t *p = p_pmt->p_first_descriptor; p; p = p->p_next)
+            i_hash = dvbpsi_camap_read(p_camap, i_hash, i_number, DVBPSI_CAMAP_PROGRAM, p);
+    for (const dvbpsi_pmt_es_t *p_es = p_pmt->p_first_es; p_es; p_es = p_es->p_next)
+    {
+        if (!dvbpsi_has_descriptor(p_es->p_tags, 0x09))
+            continue;
+        for (const dvbpsi_descriptor_t *p = p_es->p_first_descriptor; p; p = p->p_next)
+            i_hash = dvbpsi_camap_read(p_camap, i_hash, i_number, p_es->i_pid, p);
+    }
+    return dvbpsi_camap_update(p_camap, i_number, i_hash);
+}
+
+/*****************************************************************************
+ * dvbpsi_camap_pat
+ *****************************************************************************/
+void dvbpsi_camap_pat(dvbpsi_camap_t *p_camap, const dvbpsi_pat_t *p_pat)
+{
+    assert(p_camap);
+    assert(p_pat);
+
+    if (!p_pat->b_current_next)
+        return;
+
+    size_t j = 0;
+    for (size_t i = 0; i < p_camap->i_programs; i++)
+    {
+        dvbpsi_camap_program_t *p_program = &p_camap->p_programs[i];
+        bool b_listed = p_program->i_number == 0;
+        for (const dvbpsi_pat_program_t *p = p_pat->p_first_program; p && !b_listed;
+             p = p->p_next)
+            b_listed = p->i_number == p_program->i_number;
+
+        /* A program whose entries cannot be removed is kept */
+        if (!b_listed)
+        {
+            p_camap->i_scratch = 0;
+            if (dvbpsi_camap_replace(p_camap, p_program->i_number))
+                continue;
+        }
+        p_camap->p_programs[j++] = *p_program;
+    }
+    p_camap->i_programs = j;
+}
+
+/*****************************************************************************
+ * dvbpsi_camap_get
+ *****************************************************************************/
+size_t dvbpsi_camap_get(const dvbpsi_camap_t *p_camap, uint16_t i_program_number,
+                        const dvbpsi_camap_entry_t **pp_entries)
+{
+    assert(p_camap);
+    assert(pp_entries);
+
+    size_t i_first = dvbpsi_camap_range(p_camap, i_program_number);
+    size_t i_last = dvbpsi_camap_range(p_camap, (uint32_t)i_program_number + 1);
+    *pp_entries = p_camap->p_entries + i_first;
+    return i_last - i_first;
+}
@@ -0,0 +1,180 @@
+/*****************************************************************************
+ * camap.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <camap.h>
+ * \brief Conditional access PID map.
+ *
+ * Keeps the EMM PIDs given by the CA descriptors of the CAT and the ECM
+ * PIDs given by the CA descriptors of the PMTs, per program and ES, and
+ * reports only the PIDs added and removed by each new table. A table
+ * whose CA descriptors are the same bytes as before is recognized by a
+ * hash of them, without building the map of the table again, and a PMT
+ * received with DVBPSI_FLAG_LAZY_DECODE is read from its raw sections,
+ * without being decoded.
+ */
+
+#ifndef _DVBPSI_CAMAP_H_
+#define _DVBPSI_CAMAP_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_camap_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_camap_s dvbpsi_camap_t
+ * \brief dvbpsi_camap_t type definition, an opaque CA PID map.
+ */
+typedef struct dvbpsi_camap_s dvbpsi_camap_t;
+
+/*!
+ * \def DVBPSI_CAMAP_PROGRAM
+ * \brief i_es_pid of the entries of the CAT and of the program_info loop
+ * of a PMT.
+ */
+#define DVBPSI_CAMAP_PROGRAM 0x1fff
+
+/*****************************************************************************
+ * dvbpsi_camap_entry_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_camap_entry_s
+ * \brief CA descriptor of a CA PID map.
+ */
+/*!
+ * \typedef struct dvbpsi_camap_entry_s dvbpsi_camap_entry_t
+ * \brief dvbpsi_camap_entry_t type definition.
+ */
+typedef struct dvbpsi_camap_entry_s
+{
+    uint16_t    i_program_number;   /*!< program_number of the PMT, 0 for
+                                         an EMM PID of the CAT */
+    uint16_t    i_es_pid;           /*!< elementary_PID of the ES, or
+                                         DVBPSI_CAMAP_PROGRAM */
+    uint16_t    i_ca_system_id;     /*!< CA_system_ID */
+    uint16_t    i_ca_pid;           /*!< CA_PID, EMM or ECM PID */
+} dvbpsi_camap_entry_t;
+
+/*****************************************************************************
+ * dvbpsi_camap_callback
+ *****************************************************************************/
+/*!
+ * \typedef void (* dvbpsi_camap_callback)(void *p_cb_data, bool b_added,
+ *                                         const dvbpsi_camap_entry_t *p_entry)
+ * \brief Callback type definition, called for each entry added to or
+ * removed from a map, p_entry being only valid during the call.
+ */
+typedef void (* dvbpsi_camap_callback)(void *p_cb_data, bool b_added,
+                                       const dvbpsi_camap_entry_t *p_entry);
+
+/*****************************************************************************
+ * dvbpsi_camap_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_camap_t *dvbpsi_camap_new(dvbpsi_camap_callback pf_callback,
+ *                                      void *p_cb_data)
+ * \brief Creates an empty CA PID map
+ * \param pf_callback function called with the changes of the map
+ * \param p_cb_data private data given in argument to the callback
+ * \return pointer to the map, or NULL on error
+ */
+dvbpsi_camap_t *dvbpsi_camap_new(dvbpsi_camap_callback pf_callback, void *p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_camap_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_camap_delete(dvbpsi_camap_t *p_camap)
+ * \brief Deletes a map, without calling its callback
+ * \param p_camap pointer to the map
+ * \return nothing
+ */
+void dvbpsi_camap_delete(dvbpsi_camap_t *p_camap);
+
+/*****************************************************************************
+ * dvbpsi_camap_cat/pmt/pat
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_camap_cat(dvbpsi_camap_t *p_camap, const dvbpsi_cat_t *p_cat)
+ * \brief Updates the EMM PIDs of a map with a CAT
+ * \param p_camap pointer to the map
+ * \param p_cat CAT, as given to the callback of dvbpsi_cat_attach(), which
+ *        stays owned by the caller
+ * \return false on error, in which case the map keeps the previous EMM
+ *         PIDs, true otherwise.
+ *
+ * Like the other update functions, it ignores a table that is not current,
+ * and calls the callback before returning, first for the removed entries
+ * then for the added ones, the map being already updated. The cost of a
+ * table with unchanged CA descriptors is a walk over its descriptors.
+ */
+bool dvbpsi_camap_cat(dvbpsi_camap_t *p_camap, const dvbpsi_cat_t *p_cat);
+
+/*!
+ * \fn bool dvbpsi_camap_pmt(dvbpsi_camap_t *p_camap, const dvbpsi_pmt_t *p_pmt)
+ * \brief Updates the ECM PIDs of a program with its PMT
+ * \param p_camap pointer to the map
+ * \param p_pmt PMT, as given to the callback of dvbpsi_pmt_attach(), which
+ *        stays owned by the caller and is not decoded if it was not yet
+ * \return false on error, in which case the program keeps the previous ECM
+ *         PIDs, true otherwise.
+ */
+bool dvbpsi_camap_pmt(dvbpsi_camap_t *p_camap, const dvbpsi_pmt_t *p_pmt);
+
+/*!
+ * \fn void dvbpsi_camap_pat(dvbpsi_camap_t *p_camap, const dvbpsi_pat_t *p_pat)
+ * \brief Removes the ECM PIDs of the programs left out of a PAT
+ * \param p_camap pointer to the map
+ * \param p_pat PAT, as given to the callback of dvbpsi_pat_attach(), which
+ *        stays owned by the caller
+ * \return nothing.
+ */
+void dvbpsi_camap_pat(dvbpsi_camap_t *p_camap, const dvbpsi_pat_t *p_pat);
+
+/*****************************************************************************
+ * dvbpsi_camap_get
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_camap_get(const dvbpsi_camap_t *p_camap,
+ *                             uint16_t i_program_number,
+ *                             const dvbpsi_camap_entry_t **pp_entries)
+ * \brief Gets the entries of a program
+ * \param p_camap pointer to the map
+ * \param i_program_number program_number, 0 for the EMM PIDs of the CAT
+ * \param pp_entries filled with the entries, ordered by i_es_pid,
+ *        i_ca_system_id and i_ca_pid, and valid until the next update of
+ *        the map
+ * \return the number of entries.
+ */
+size_t dvbpsi_camap_get(const dvbpsi_camap_t *p_camap, uint16_t i_program_number,
+                        const dvbpsi_camap_entry_t **pp_entries);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of camap.h"
+#endif
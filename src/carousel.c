@@ -0,0 +1,859 @@
+/*****************************************************************************
+ * carousel.c: PSI/SI carousel
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "packetizer.h"
+#include "carousel.h"
+
+#define DVBPSI_CAROUSEL_PIDS 8192
+
+/*****************************************************************************
+ * dvbpsi_carousel_packets_t
+ *****************************************************************************
+ * TS packets of a version of a table, with a flag on the last packet of
+ * each section.
+ *****************************************************************************/
+typedef struct dvbpsi_carousel_packets_s
+{
+    size_t   i_packets;
+    uint8_t *pb_section_end;                /* one flag per packet */
+    uint8_t  p_packets[];
+} dvbpsi_carousel_packets_t;
+
+/*****************************************************************************
+ * dvbpsi_carousel_table_s
+ *****************************************************************************/
+struct dvbpsi_carousel_table_s
+{
+    uint16_t i_pid;
+    uint64_t i_interval;                    /* between repetition starts */
+    uint64_t i_packet_gap;                  /* from the maximum bitrate */
+
+    dvbpsi_carousel_packets_t *p_packets;   /* version being sent */
+    dvbpsi_carousel_packets_t *p_pending;   /* next version or NULL */
+    size_t   i_position;                    /* next packet to send */
+    uint64_t i_start;                       /* of the current repetition */
+
+    uint64_t i_due;                         /* next packet not before */
+    unsigned int i_heap;                    /* position in the heap */
+};
+
+/*****************************************************************************
+ * dvbpsi_carousel_s
+ *****************************************************************************/
+struct dvbpsi_carousel_s
+{
+    dvbpsi_carousel_table_t **pp_heap;      /* min-heap on i_due */
+    unsigned int i_tables;
+    unsigned int i_max_tables;
+
+    uint8_t pi_continuity_counters[DVBPSI_CAROUSEL_PIDS];
+    /* Table in the middle of a section on each PID, the packets of two
+     * sections of a PID cannot be interleaved */
+    dvbpsi_carousel_table_t *pp_senders[DVBPSI_CAROUSEL_PIDS];
+};
+
+/*****************************************************************************
+ * dvbpsi_carousel_new
+ *****************************************************************************/
+dvbpsi_carousel_t *dvbpsi_carousel_new(unsigned int i_max_tables)
+{
+    dvbpsi_carousel_t *p_carousel = dvbpsi_calloc(1, sizeof(dvbpsi_carousel_t));
+    if (p_carousel == NULL)
+        return NULL;
+
+    p_carousel->pp_heap = dvbpsi_calloc(i_max_tables ? i_max_tables : 1,
+                                        sizeof(dvbpsi_carousel_table_t *));
+    if (p_carousel->pp_heap == NULL)
+    {
+        dvbpsi_free(p_carousel);
+        return NULL;
+    }
+
+    p_carousel->i_max_tables = i_max_tables;
+    return p_carousel;
+}
+
+/*****************************************************************************
+ * dvbpsi_carousel_table_delete
+ *****************************************************************************/
+static void dvbpsi_carousel_table_delete(dvbpsi_carousel_table_t *p_table)
+{
+    dvbpsi_free(p_table->p_packets);
+    dvbpsi_free(p_table->p_pending);
+    dvbpsi_free(p_table);
+}
+
+/*****************************************************************************
+ * dvbpsi_carousel_delete
+ *****************************************************************************/
+void dvbpsi_carousel_delete(dvbpsi_carousel_t *p_carousel)
+{
+    if (p_carousel == NULL)
+        return;
+
+    for (unsigned int i = 0; i < p_carousel->i_tables; i++)
+        dvbpsi_carousel_table_delete(p_carousel->pp_heap[i]);
+    dvbpsi_free(p_carousel->pp_heap);
+    dvbpsi_free(p_carousel);
+}
+
+/*****************************************************************************
+ * dvbpsi_carousel_packetize
+ *****************************************************************************
+ * Builds the TS packets of a list of sections, each section starting in a
+ * packet of its own.
+ *****************************************************************************/
+static dvbpsi_carousel_packets_t *dvbpsi_carousel_packetize(uint16_t i_pid,
+                                        const dvbpsi_psi_section_t *p_section)
+{
+    /* Bound of dvbpsi_packetizer_push(), which counts the packet each
+     * section is flushed in */
+    size_t i_max = 0;
+    for (const dvbpsi_psi_section_t *p = p_section; p; p = p->p_next)
+    {
+        size_t i_size = p->p_payload_end + (p->b_syntax_indicator ? 4 : 0) - p->p_data;
+        i_max += (i_size + 1) / 184 + 1;
+    }
+    if (i_max == 0)
+        return NULL;
+
+    dvbpsi_carousel_packets_t *p_packets = dvbpsi_malloc(sizeof(dvbpsi_carousel_packets_t)
+                                                         + i_max * (188 + 1));
+    if (p_packets == NULL)
+        return NULL;
+    p_packets->pb_section_end = p_packets->p_packets + 188 * i_max;
+    memset(p_packets->pb_section_end, 0, i_max);
+
+    dvbpsi_packetizer_t *p_packetizer = dvbpsi_packetizer_new(p_packets->p_packets, i_max);
+    if (p_packetizer == NULL)
+    {
+        dvbpsi_free(p_packets);
+        return NULL;
+    }
+
+    size_t i_packets = 0;
+    for (; p_section; p_section = p_section->p_next)
+    {
+        dvbpsi_psi_section_t section = *p_section;
+        section.p_next = NULL;
+
+        if (!dvbpsi_packetizer_push(p_packetizer, i_pid, &section)
+         || !dvbpsi_packetizer_flush(p_packetizer))
+        {
+            dvbpsi_packetizer_delete(p_packetizer);
+            dvbpsi_free(p_packets);
+            return NULL;
+        }
+
+        uint8_t *p_first;
+        i_packets = dvbpsi_packetizer_peek(p_packetizer, &p_first);
+        assert(p_first == p_packets->p_packets);
+        p_packets->pb_section_end[i_packets - 1] = 1;
+    }
+    dvbpsi_packetizer_delete(p_packetizer);
+
+    p_packets->i_packets = i_packets;
+    return p_packets;
+}
+
+/*****************************************************************************
+ * Min-heap of the tables on their due time
+ *****************************************************************************
+ * dvbpsi_carousel_sift_up() and dvbpsi_carousel_sift_down() move the table
+ * at position i of the heap to its place.
+ *****************************************************************************/
+static void dvbpsi_carousel_place(dvbpsi_carousel_t *p_carousel, unsigned int i,
+                                  dvbpsi_carousel_table_t *p_table)
+{
+    p_carousel->pp_heap[i] = p_table;
+    p_table->i_heap = i;
+}
+
+static void dvbpsi_carousel_sift_up(dvbpsi_carousel_t *p_carousel, unsigned int i)
+{
+    dvbpsi_carousel_table_t *p_table = p_carousel->pp_heap[i];
+    while (i > 0)
+    {
+        unsigned int i_parent = (i - 1) / 2;
+        if (p_carousel->pp_heap[i_parent]->i_due <= p_table->i_due)
+            break;
+        dvbpsi_carousel_place(p_carousel, i, p_carousel->pp_heap[i_parent]);
+        i = i_parent;
+    }
+    dvbpsi_carousel_place(p_carousel, i, p_table);
+}
+
+static void dvbpsi_carousel_sift_down(dvbpsi_carousel_t *p_carousel, unsigned int i)
+{
+    dvbpsi_carousel_table_t *p_table = p_carousel->pp_heap[i];
+    for (;;)
+    {
+        unsigned int i_child = 2 * i + 1;
+        if (i_child >= p_carousel->i_tables)
+            break;
+        if (i_child + 1 < p_carousel->i_tables
+         && p_carousel->pp_heap[i_child + 1]->i_due < p_carousel->pp_heap[i_child]->i_due)
+            i_child++;
+        if (p_table->i_due <= p_carousel->pp_heap[i_child]->i_due)
+            break;
+        dvbpsi_carousel_place(p_carousel, i, p_carousel->pp_heap[i_child]);
+        i = i_child;
+    }
+    dvbpsi_carousel_place(p_carousel, i, p_table);
+}
+
+/*****************************************************************************
+ * dvbpsi_carousel_add
+ *****************************************************************************/
+dvbpsi_carousel_table_t *dvbpsi_carousel_add(dvbpsi_carousel_t *p_carousel,
+                                             uint16_t i_pid,
+                                             const dvbpsi_psi_section_t *p_section,
+                                             uint64_t i_interval,
+                                             uint32_t i_max_bitrate)
+{
+    assert(p_carousel);
+
+    if (i_pid >= DVBPSI_CAROUSEL_PIDS
+     || p_carousel->i_tables >= p_carousel->i_max_tables)
+        return NULL;
+
+    dvbpsi_carousel_table_t *p_table = dvbpsi_calloc(1, sizeof(dvbpsi_carousel_table_t));
+    if (p_table == NULL)
+        return NULL;
+
+    p_table->p_packets = dvbpsi_carousel_packetize(i_pid, p_section);
+    if (p_table->p_packets == NULL)
+    {
+        dvbpsi_free(p_table);
+        return NULL;
+    }
+
+    p_table->i_pid = i_pid;
+    p_table->i_interval = i_interval;
+    if (i_max_bitrate)
+        p_table->i_packet_gap = (188 * 8 * UINT64_C(1000000) + i_max_bitrate - 1)
+                                                             / i_max_bitrate;
+
+    /* Due at once */
+    dvbpsi_carousel_place(p_carousel, p_carousel->i_tables++, p_table);
+    dvbpsi_carousel_sift_up(p_carousel, p_table->i_heap);
+    return p_table;
+}
+
+/*****************************************************************************
+ * dvbpsi_carousel_update
+ *****************************************************************************/
+bool dvbpsi_carousel_update(dvbpsi_carousel_t *p_carousel,
+                            dvbpsi_carousel_table_t *p_table,
+                            const dvbpsi_psi_section_t *p_section)
+{
+    assert(p_carousel);
+    assert(p_table);
+    assert(p_carousel->pp_heap[p_table->i_heap] == p_table);
+
+    dvbpsi_carousel_packets_t *p_packets = dvbpsi_carousel_packetize(p_table->i_pid,
+                                                                     p_section);
+    if (p_packets == NULL)
+        return false;
+
+    if (p_table->i_position == 0)
+    {
+        /* Between two repetitions */
+        dvbpsi_free(p_table->p_packets);
+        p_table->p_packets = p_packets;
+    }
+    else
+    {
+        dvbpsi_free(p_table->p_pending);
+        p_table->p_pending = p_packets;
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_carousel_remove
+ *****************************************************************************/
+void dvbpsi_carousel_remove(dvbpsi_carousel_t *p_carousel,
+                            dvbpsi_carousel_table_t *p_table)
+{
+    assert(p_carousel);
+    assert(p_table);
+
+    unsigned int i = p_table->i_heap;
+    assert(p_carousel->pp_heap[i] == p_table);
+
+    /* The last table of the heap takes the place of the removed one */
+    p_carousel->i_tables--;
+    if (i < p_carousel->i_tables)
+    {
+        dvbpsi_carousel_place(p_carousel, i, p_carousel->pp_heap[p_carousel->i_tables]);
+        dvbpsi_carousel_sift_up(p_carousel, i);
+        dvbpsi_carousel_sift_down(p_carousel, p_carousel->pp_heap[i]->i_heap);
+    }
+    /* A section cut short is dropped by the receivers at the next one */
+    if (p_carousel->pp_senders[p_table->i_pid] == p_table)
+        p_carousel->pp_senders[p_table->i_pid] = NULL;
+    dvbpsi_carousel_table_delete(p_table);
+}
+
+/*****************************************************************************
+ * dvbpsi_carousel_serve
+ *****************************************************************************
+ * Sends the next due packet, copied to p_packet when not NULL, and returns
+ * its table, its position in the table being written to pi_position, or
+ * returns NULL when none is due.
+ *****************************************************************************/
+static dvbpsi_carousel_table_t *dvbpsi_carousel_serve(dvbpsi_carousel_t *p_carousel,
+                                                      uint64_t i_now, uint8_t *p_packet,
+                                                      size_t *pi_position)
+{
+    dvbpsi_carousel_table_t *p_table;
+    for (;;)
+    {
+        if (p_carousel->i_tables == 0 || p_carousel->pp_heap[0]->i_due > i_now)
+            return NULL;
+
+        p_table = p_carousel->pp_heap[0];
+        dvbpsi_carousel_table_t *p_sender = p_carousel->pp_senders[p_table->i_pid];
+        if (p_sender == NULL || p_sender == p_table)
+            break;
+
+        /* Wait for the end of the section of the PID, this happens at most
+         * once for each table sharing the PID */
+        p_table->i_due = p_sender->i_due + 1;
+        dvbpsi_carousel_sift_down(p_carousel, 0);
+    }
+
+    dvbpsi_carousel_packets_t *p_packets = p_table->p_packets;
+    if (p_table->i_position == 0)
+        p_table->i_start = i_now;
+
+    uint8_t *pi_counter = &p_carousel->pi_continuity_counters[p_table->i_pid];
+    if (p_packet)
+    {
+        memcpy(p_packet, p_packets->p_packets + 188 * p_table->i_position, 188);
+        p_packet[3] = (p_packet[3] & 0xf0) | *pi_counter;
+    }
+    *pi_counter = (*pi_counter + 1) & 0x0f;
+    *pi_position = p_table->i_position;
+
+    bool b_section_end = p_packets->pb_section_end[p_table->i_position];
+    p_carousel->pp_senders[p_table->i_pid] = b_section_end ? NULL : p_table;
+    uint64_t i_gap = p_table->i_packet_gap;
+    if (b_section_end && i_gap < DVBPSI_CAROUSEL_SECTION_GAP)
+        i_gap = DVBPSI_CAROUSEL_SECTION_GAP;
+    p_table->i_due = i_now + i_gap;
+
+    if (++p_table->i_position == p_packets->i_packets)
+    {
+        /* End of the repetition, switch to the new version if any */
+        p_table->i_position = 0;
+        if (p_table->p_pending)
+        {
+            dvbpsi_free(p_table->p_packets);
+            p_table->p_packets = p_table->p_pending;
+            p_table->p_pending = NULL;
+        }
+        if (p_table->i_due < p_table->i_start + p_table->i_interval)
+            p_table->i_due = p_table->i_start + p_table->i_interval;
+    }
+
+    dvbpsi_carousel_sift_down(p_carousel, 0);
+    return p_table;
+}
+
+/*****************************************************************************
+ * dvbpsi_carousel_next
+ *****************************************************************************/
+bool dvbpsi_carousel_next(dvbpsi_carousel_t *p_carousel, uint64_t i_now,
+                          uint8_t *p_packet)
+{
+    assert(p_carousel);
+    assert(p_packet);
+
+    size_t i_position;
+    return dvbpsi_carousel_serve(p_carousel, i_now, p_packet, &i_position) != NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_carousel_slot_t
+ *****************************************************************************
+ * Packet of a rendered loop: a packet of a table, or a stuffing packet of
+ * a PID when p_table is NULL, a null packet on PID 0x1fff.
+ *****************************************************************************/
+typedef struct dvbpsi_carousel_slot_s
+{
+    dvbpsi_carousel_table_t *p_table;
+    uint32_t i_position;                    /* packet of the table */
+    uint16_t i_pid;
+    uint8_t  i_counter;                     /* continuity_counter */
+} dvbpsi_carousel_slot_t;
+
+/*****************************************************************************
+ * dvbpsi_carousel_layout_t
+ *****************************************************************************
+ * Packets of a table when the loop was rendered, which a new version must
+ * keep to be written in its place.
+ *****************************************************************************/
+typedef struct dvbpsi_carousel_layout_s
+{
+    dvbpsi_carousel_table_t *p_table;
+    size_t   i_packets;
+    uint8_t *pb_section_end;
+} dvbpsi_carousel_layout_t;
+
+/*****************************************************************************
+ * dvbpsi_carousel_render_s
+ *****************************************************************************/
+struct dvbpsi_carousel_render_s
+{
+    dvbpsi_carousel_slot_t *p_slots;
+    size_t   i_slots;
+    size_t   i_max_slots;
+
+    dvbpsi_carousel_layout_t *p_layouts;
+    unsigned int i_layouts;
+};
+
+/* Version a table will be sent with from its next repetition */
+static dvbpsi_carousel_packets_t *dvbpsi_carousel_latest(const dvbpsi_carousel_table_t *p_table)
+{
+    return p_table->p_pending ? p_table->p_pending : p_table->p_packets;
+}
+
+static bool dvbpsi_carousel_slot_add(dvbpsi_carousel_render_t *p_render,
+                                     dvbpsi_carousel_table_t *p_table, size_t i_position,
+                                     uint16_t i_pid, uint8_t i_counter)
+{
+    if (p_render->i_slots == p_render->i_max_slots)
+    {
+        size_t i_max = 2 * p_render->i_max_slots + 1024;
+        dvbpsi_carousel_slot_t *p_slots = dvbpsi_malloc(i_max * sizeof(dvbpsi_carousel_slot_t));
+        if (p_slots == NULL)
+            return false;
+        if (p_render->i_slots)
+            memcpy(p_slots, p_render->p_slots, p_render->i_slots * sizeof(dvbpsi_carousel_slot_t));
+        dvbpsi_free(p_render->p_slots);
+        p_render->p_slots = p_slots;
+        p_render->i_max_slots = i_max;
+    }
+
+    dvbpsi_carousel_slot_t *p_slot = &p_render->p_slots[p_render->i_slots++];
+    p_slot->p_table = p_table;
+    p_slot->i_position = i_position;
+    p_slot->i_pid = i_pid;
+    p_slot->i_counter = i_counter;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_carousel_schedule
+ *****************************************************************************
+ * Plays one loop of the carousel from its start into the slots of the
+ * render, the carousel being in its start state.
+ *****************************************************************************/
+static bool dvbpsi_carousel_schedule(dvbpsi_carousel_t *p_carousel,
+                                     dvbpsi_carousel_render_t *p_render,
+                                     uint64_t i_duration, uint32_t i_bitrate)
+{
+    const uint64_t i_packet_time = 188 * 8 * UINT64_C(1000000);
+    uint8_t *pi_counters = p_carousel->pi_continuity_counters;
+
+    /* A packet every 1504 / i_bitrate s */
+    for (uint64_t k = 0; k * i_packet_time / i_bitrate < i_duration; k++)
+    {
+        size_t i_position;
+        dvbpsi_carousel_table_t *p_table = dvbpsi_carousel_serve(p_carousel,
+                                               k * i_packet_time / i_bitrate,
+                                               NULL, &i_position);
+        bool b_ok = p_table
+            ? dvbpsi_carousel_slot_add(p_render, p_table, i_position, p_table->i_pid,
+                                       (pi_counters[p_table->i_pid] - 1) & 0x0f)
+            : dvbpsi_carousel_slot_add(p_render, NULL, 0, 0x1fff, 0);
+        if (!b_ok)
+            return false;
+    }
+
+    /* The sections in progress are completed within the loop, the next
+     * one starting its repetition at the start of the file */
+    for (unsigned int i = 0; i < p_carousel->i_tables; i++)
+    {
+        dvbpsi_carousel_table_t *p_table = p_carousel->pp_heap[i];
+        if (p_carousel->pp_senders[p_table->i_pid] != p_table)
+            continue;
+        const dvbpsi_carousel_packets_t *p_packets = p_table->p_packets;
+        size_t i_position = p_table->i_position;
+        do
+        {
+            uint8_t *pi_counter = &pi_counters[p_table->i_pid];
+            if (!dvbpsi_carousel_slot_add(p_render, p_table, i_position,
+                                          p_table->i_pid, *pi_counter))
+                return false;
+            *pi_counter = (*pi_counter + 1) & 0x0f;
+        } while (!p_packets->pb_section_end[i_position++]);
+    }
+
+    /* Stuffing packets up to a multiple of 16 packets on each PID, so that
+     * the continuity_counter goes on from the end of the file to its start */
+    for (unsigned int i = 0; i < p_carousel->i_tables; i++)
+    {
+        uint16_t i_pid = p_carousel->pp_heap[i]->i_pid;
+        while (pi_counters[i_pid] != 0)
+        {
+            if (!dvbpsi_carousel_slot_add(p_render, NULL, 0, i_pid, pi_counters[i_pid]))
+                return false;
+            pi_counters[i_pid] = (pi_counters[i_pid] + 1) & 0x0f;
+        }
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_carousel_render_new
+ *****************************************************************************/
+dvbpsi_carousel_render_t *dvbpsi_carousel_render_new(dvbpsi_carousel_t *p_carousel,
+                                                     uint64_t i_duration,
+                                                     uint32_t i_bitrate)
+{
+    assert(p_carousel);
+
+    if (i_bitrate == 0 || p_carousel->i_tables == 0)
+        return NULL;
+
+    unsigned int i_tables = p_carousel->i_tables;
+    dvbpsi_carousel_render_t *p_render = dvbpsi_calloc(1, sizeof(dvbpsi_carousel_render_t));
+    dvbpsi_carousel_table_t *p_saved = dvbpsi_malloc(i_tables * sizeof(dvbpsi_carousel_table_t));
+    dvbpsi_carousel_table_t **pp_heap = dvbpsi_malloc(i_tables * sizeof(dvbpsi_carousel_table_t *));
+    dvbpsi_carousel_table_t **pp_senders = dvbpsi_malloc(sizeof(p_carousel->pp_senders));
+    uint8_t *pi_counters = dvbpsi_malloc(sizeof(p_carousel->pi_continuity_counters));
+    bool b_ok = p_render && p_saved && pp_heap && pp_senders && pi_counters;
+    if (b_ok)
+    {
+        p_render->p_layouts = dvbpsi_calloc(i_tables, sizeof(dvbpsi_carousel_layout_t));
+        b_ok = (p_render->p_layouts != NULL);
+    }
+
+    /* The layout of the latest version of each table */
+    for (unsigned int i = 0; b_ok && i < i_tables; i++)
+    {
+        dvbpsi_carousel_table_t *p_table = p_carousel->pp_heap[i];
+        const dvbpsi_carousel_packets_t *p_packets = dvbpsi_carousel_latest(p_table);
+        dvbpsi_carousel_layout_t *p_layout = &p_render->p_layouts[i];
+
+        p_layout->p_table = p_table;
+        p_layout->i_packets = p_packets->i_packets;
+        p_layout->pb_section_end = dvbpsi_malloc(p_packets->i_packets);
+        if (p_layout->pb_section_end == NULL)
+            b_ok = false;
+        else
+        {
+            memcpy(p_layout->pb_section_end, p_packets->pb_section_end, p_packets->i_packets);
+            p_render->i_layouts++;
+        }
+    }
+
+    if (b_ok)
+    {
+        /* Saves the carousel, then plays it from the start with the latest
+         * version of each table */
+        memcpy(pp_heap, p_carousel->pp_heap, i_tables * sizeof(dvbpsi_carousel_table_t *));
+        memcpy(pp_senders, p_carousel->pp_senders, sizeof(p_carousel->pp_senders));
+        memcpy(pi_counters, p_carousel->pi_continuity_counters,
+               sizeof(p_carousel->pi_continuity_counters));
+        for (unsigned int i = 0; i < i_tables; i++)
+        {
+            dvbpsi_carousel_table_t *p_table = pp_heap[i];
+            p_saved[i] = *p_table;
+            p_table->p_packets = dvbpsi_carousel_latest(p_table);
+            p_table->p_pending = NULL;
+            p_table->i_position = 0;
+            p_table->i_start = 0;
+            p_table->i_due = 0;
+        }
+        memset(p_carousel->pp_senders, 0, sizeof(p_carousel->pp_senders));
+        memset(p_carousel->pi_continuity_counters, 0,
+               sizeof(p_carousel->pi_continuity_counters));
+
+        b_ok = dvbpsi_carousel_schedule(p_carousel, p_render, i_duration, i_bitrate);
+
+        /* No version is switched to as the pending one was played */
+        for (unsigned int i = 0; i < i_tables; i++)
+            *pp_heap[i] = p_saved[i];
+        memcpy(p_carousel->pp_heap, pp_heap, i_tables * sizeof(dvbpsi_carousel_table_t *));
+        memcpy(p_carousel->pp_senders, pp_senders, sizeof(p_carousel->pp_senders));
+        memcpy(p_carousel->pi_continuity_counters, pi_counters,
+               sizeof(p_carousel->pi_continuity_counters));
+    }
+
+    dvbpsi_free(pi_counters);
+    dvbpsi_free(pp_senders);
+    dvbpsi_free(pp_heap);
+    dvbpsi_free(p_saved);
+    if (!b_ok)
+    {
+        dvbpsi_carousel_render_delete(p_render);
+        return NULL;
+    }
+    return p_render;
+}
+
+/*****************************************************************************
+ * dvbpsi_carousel_render_delete
+ *****************************************************************************/
+void dvbpsi_carousel_render_delete(dvbpsi_carousel_render_t *p_render)
+{
+    if (p_render == NULL)
+        return;
+
+    for (unsigned int i = 0; i < p_render->i_layouts; i++)
+        dvbpsi_free(p_render->p_layouts[i].pb_section_end);
+    dvbpsi_free(p_render->p_layouts);
+    dvbpsi_free(p_render->p_slots);
+    dvbpsi_free(p_render);
+}
+
+/*****************************************************************************
+ * dvbpsi_carousel_render_packets
+ *****************************************************************************/
+size_t dvbpsi_carousel_render_packets(const dvbpsi_carousel_render_t *p_render)
+{
+    assert(p_render);
+    return p_render->i_slots;
+}
+
+/*****************************************************************************
+ * dvbpsi_carousel_render_fits
+ *****************************************************************************
+ * True when the latest version of the table has the packets it was
+ * rendered with.
+ *****************************************************************************/
+static bool dvbpsi_carousel_render_fits(const dvbpsi_carousel_layout_t *p_layout)
+{
+    const dvbpsi_carousel_packets_t *p_packets = dvbpsi_carousel_latest(p_layout->p_table);
+    return p_packets->i_packets == p_layout->i_packets
+        && !memcmp(p_packets->pb_section_end, p_layout->pb_section_end, p_layout->i_packets);
+}
+
+/*****************************************************************************
+ * dvbpsi_carousel_render_slots
+ *****************************************************************************
+ * Writes the packets of the slots of a table, or of all the slots when
+ * p_table is NULL.
+ *****************************************************************************/
+static void dvbpsi_carousel_render_slots(const dvbpsi_carousel_render_t *p_render,
+                                         const dvbpsi_carousel_table_t *p_table,
+                                         uint8_t *p_buffer)
+{
+    for (size_t i = 0; i < p_render->i_slots; i++)
+    {
+        const dvbpsi_carousel_slot_t *p_slot = &p_render->p_slots[i];
+        uint8_t *p_packet = p_buffer + 188 * i;
+
+        if (p_table && p_slot->p_table != p_table)
+            continue;
+        if (p_slot->p_table)
+        {
+            const dvbpsi_carousel_packets_t *p_packets = dvbpsi_carousel_latest(p_slot->p_table);
+            memcpy(p_packet, p_packets->p_packets + 188 * p_slot->i_position, 188);
+            p_packet[3] = (p_packet[3] & 0xf0) | p_slot->i_counter;
+        }
+        else
+        {
+            /* Stuffing only, after the end of the last section of the PID */
+            p_packet[0] = 0x47;
+            p_packet[1] = p_slot->i_pid >> 8;
+            p_packet[2] = p_slot->i_pid;
+            p_packet[3] = 0x10 | p_slot->i_counter;
+            memset(p_packet + 4, 0xff, 184);
+        }
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_carousel_render_write
+ *****************************************************************************/
+bool dvbpsi_carousel_render_write(const dvbpsi_carousel_render_t *p_render,
+                                  uint8_t *p_buffer)
+{
+    assert(p_render);
+    assert(p_buffer);
+
+    for (unsigned int i = 0; i < p_render->i_layouts; i++)
+        if (!dvbpsi_carousel_render_fits(&p_render->p_layouts[i]))
+            return false;
+
+    dvbpsi_carousel_render_slots(p_render, NULL, p_buffer);
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_carousel_render_update
+ *****************************************************************************/
+bool dvbpsi_carousel_render_update(const dvbpsi_carousel_render_t *p_render,
+                                   const dvbpsi_carousel_table_t *p_table,
+                                   uint8_t *p_buffer)
+{
+    assert(p_render);
+    assert(p_table);
+    assert(p_buffer);
+
+    for (unsigned int i = 0; i < p_render->i_layouts; i++)
+    {
+        const dvbpsi_carousel_layout_t *p_layout = &p_render->p_layouts[i];
+        if (p_layout->p_table != p_table)
+            continue;
+        if (!dvbpsi_carousel_render_fits(p_layout))
+            return false;
+        dvbpsi_carousel_render_slots(p_render, p_table, p_buffer);
+        return true;
+    }
+    return false;
+}
+
+/*****************************************************************************
+ * dvbpsi_carousel_limit
+ *****************************************************************************
+ * Maximum interval of a table in microseconds, 0 if none.
+ *****************************************************************************/
+static uint64_t dvbpsi_carousel_limit(uint8_t i_table_id)
+{
+    switch (i_table_id)
+    {
+        case 0x00: /* PAT */
+        case 0x02: /* PMT */
+            return 500000;
+        case 0x42: /* SDT actual */
+        case 0x4e: /* EIT present/following actual */
+            return 2000000;
+        case 0x40: /* NIT actual */
+        case 0x41: /* NIT other */
+        case 0x46: /* SDT other */
+        case 0x4a: /* BAT */
+        case 0x4f: /* EIT present/following other */
+            return 10000000;
+        case 0x70: /* TDT */
+        case 0x73: /* TOT */
+            return 30000000;
+        default:
+            break;
+    }
+
+    /* EIT schedule, 4 days a table_id */
+    if (i_table_id >= 0x50 && i_table_id <= 0x6f)
+        return ((i_table_id & 0x0f) < 2) ? 10000000 : 30000000;
+    return 0;
+}
+
+/*****************************************************************************
+ * dvbpsi_carousel_plan
+ *****************************************************************************/
+unsigned int dvbpsi_carousel_plan(dvbpsi_carousel_plan_t *p_plan, size_t i_tables,
+                                  const dvbpsi_carousel_budget_t *p_budgets,
+                                  size_t i_budgets)
+{
+    assert(p_plan || i_tables == 0);
+    assert(p_budgets || i_budgets == 0);
+
+    /* Packets and shortest interval of each table on its own */
+    for (size_t i = 0; i < i_tables; i++)
+    {
+        dvbpsi_carousel_plan_t *p_table = &p_plan[i];
+        size_t i_sections = 0;
+
+        p_table->i_packets = 0;
+        for (const dvbpsi_psi_section_t *p = p_table->p_sections; p; p = p->p_next)
+        {
+            /* each section starts in a packet of its own, with its
+             * pointer_field */
+            size_t i_size = p->p_payload_end + (p->b_syntax_indicator ? 4 : 0) - p->p_data;
+            p_table->i_packets += (i_size + 1 + 183) / 184;
+            i_sections++;
+        }
+
+        p_table->i_limit = p_table->p_sections
+                         ? dvbpsi_carousel_limit(p_table->p_sections->i_table_id) : 0;
+        p_table->i_achieved = p_table->i_interval ? p_table->i_interval
+                            : p_table->i_limit ? p_table->i_limit : 10000000;
+        if (p_table->i_achieved < i_sections * DVBPSI_CAROUSEL_SECTION_GAP)
+            p_table->i_achieved = i_sections * DVBPSI_CAROUSEL_SECTION_GAP;
+        p_table->i_max_bitrate = 0;
+    }
+
+    /* Fit the tables of each PID in its bitrate */
+    for (size_t b = 0; b < i_budgets; b++)
+    {
+        uint16_t i_pid = p_budgets[b].i_pid;
+        double f_bitrate = p_budgets[b].i_bitrate;
+
+        double f_needed = 0;
+        for (size_t i = 0; i < i_tables; i++)
+        {
+            if (p_plan[i].i_pid == i_pid)
+                f_needed += p_plan[i].i_packets * 188 * 8 * 1e6 / p_plan[i].i_achieved;
+        }
+        if (f_needed == 0)
+            continue;
+
+        double f_stretch = (f_needed > f_bitrate) ? f_needed / f_bitrate : 1.0;
+        for (size_t i = 0; i < i_tables; i++)
+        {
+            dvbpsi_carousel_plan_t *p_table = &p_plan[i];
+            if (p_table->i_pid != i_pid || p_table->i_packets == 0)
+                continue;
+
+            /* The sections of a PID are sent one at a time: at the bitrate
+             * of the PID each, its tables never exceed it together */
+            p_table->i_achieved = (uint64_t)(p_table->i_achieved * f_stretch + 0.5);
+            p_table->i_max_bitrate = p_budgets[b].i_bitrate;
+        }
+    }
+
+    unsigned int i_violations = 0;
+    for (size_t i = 0; i < i_tables; i++)
+    {
+        p_plan[i].b_violation = p_plan[i].i_limit
+                             && p_plan[i].i_achieved > p_plan[i].i_limit;
+        if (p_plan[i].b_violation)
+            i_violations++;
+    }
+    return i_violations;
+}
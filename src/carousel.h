@@ -0,0 +1,363 @@
+/*****************************************************************************
+ * carousel.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <carousel.h>
+ * \brief PSI/SI carousel.
+ *
+ * Repeats tables at their own interval and hands out their TS packets one
+ * at a time, whenever the multiplexer has a free packet slot.
+ */
+
+#ifndef _DVBPSI_CAROUSEL_H_
+#define _DVBPSI_CAROUSEL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_carousel_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_carousel_s dvbpsi_carousel_t
+ * \brief dvbpsi_carousel_t type definition, an opaque table carousel.
+ */
+typedef struct dvbpsi_carousel_s dvbpsi_carousel_t;
+
+/*!
+ * \typedef struct dvbpsi_carousel_table_s dvbpsi_carousel_table_t
+ * \brief dvbpsi_carousel_table_t type definition, an opaque table of a
+ * carousel.
+ */
+typedef struct dvbpsi_carousel_table_s dvbpsi_carousel_table_t;
+
+/*!
+ * \def DVBPSI_CAROUSEL_SECTION_GAP
+ * \brief Minimum time in microseconds between two sections of a table,
+ * ETSI TR 101 211 section 4.4.
+ */
+#define DVBPSI_CAROUSEL_SECTION_GAP 25000
+
+/*****************************************************************************
+ * dvbpsi_carousel_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_carousel_t *dvbpsi_carousel_new(unsigned int i_max_tables)
+ * \brief Creates a carousel without any table
+ * \param i_max_tables maximum number of tables of the carousel
+ * \return pointer to the carousel, or NULL on error
+ */
+dvbpsi_carousel_t *dvbpsi_carousel_new(unsigned int i_max_tables);
+
+/*****************************************************************************
+ * dvbpsi_carousel_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_carousel_delete(dvbpsi_carousel_t *p_carousel)
+ * \brief Deletes a carousel and all its tables
+ * \param p_carousel pointer to the carousel
+ * \return nothing
+ */
+void dvbpsi_carousel_delete(dvbpsi_carousel_t *p_carousel);
+
+/*****************************************************************************
+ * dvbpsi_carousel_add
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_carousel_table_t *dvbpsi_carousel_add(dvbpsi_carousel_t *p_carousel,
+ *                                                 uint16_t i_pid,
+ *                                                 const dvbpsi_psi_section_t *p_section,
+ *                                                 uint64_t i_interval,
+ *                                                 uint32_t i_max_bitrate)
+ * \brief Adds a table to a carousel
+ * \param p_carousel pointer to the carousel
+ * \param i_pid PID of the table, 0 to 0x1fff
+ * \param p_section sections of the table, as built by the
+ *        dvbpsi_xxx_sections_generate() functions, copied by the carousel
+ * \param i_interval target time in microseconds between the starts of two
+ *        repetitions of the table
+ * \param i_max_bitrate maximum bitrate of the table in bits per second,
+ *        0 for no limit
+ * \return the table, or NULL if the carousel is full, the PID invalid or
+ *         on error.
+ *
+ * The table is due at once. Its sections are sent one after the other,
+ * at least DVBPSI_CAROUSEL_SECTION_GAP apart, and a repetition starts
+ * after i_interval or DVBPSI_CAROUSEL_SECTION_GAP after the end of the
+ * previous one, whichever comes last.
+ */
+dvbpsi_carousel_table_t *dvbpsi_carousel_add(dvbpsi_carousel_t *p_carousel,
+                                             uint16_t i_pid,
+                                             const dvbpsi_psi_section_t *p_section,
+                                             uint64_t i_interval,
+                                             uint32_t i_max_bitrate);
+
+/*****************************************************************************
+ * dvbpsi_carousel_update
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_carousel_update(dvbpsi_carousel_t *p_carousel,
+ *                                 dvbpsi_carousel_table_t *p_table,
+ *                                 const dvbpsi_psi_section_t *p_section)
+ * \brief Replaces the sections of a table, typically on a version change
+ * \param p_carousel pointer to the carousel
+ * \param p_table table of the carousel
+ * \param p_section new sections of the table, copied by the carousel
+ * \return false on error, in which case the table keeps its sections,
+ *         true otherwise.
+ *
+ * A repetition of the table in progress is completed with the previous
+ * sections, so that the packets of two versions are never mixed. The new
+ * sections are sent from the next repetition on.
+ */
+bool dvbpsi_carousel_update(dvbpsi_carousel_t *p_carousel,
+                            dvbpsi_carousel_table_t *p_table,
+                            const dvbpsi_psi_section_t *p_section);
+
+/*****************************************************************************
+ * dvbpsi_carousel_remove
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_carousel_remove(dvbpsi_carousel_t *p_carousel,
+ *                                 dvbpsi_carousel_table_t *p_table)
+ * \brief Removes a table from a carousel, even in the middle of a repetition
+ * \param p_carousel pointer to the carousel
+ * \param p_table table of the carousel, deleted
+ * \return nothing
+ */
+void dvbpsi_carousel_remove(dvbpsi_carousel_t *p_carousel,
+                            dvbpsi_carousel_table_t *p_table);
+
+/*****************************************************************************
+ * dvbpsi_carousel_next
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_carousel_next(dvbpsi_carousel_t *p_carousel,
+ *                               uint64_t i_now, uint8_t *p_packet)
+ * \brief Gets the next due TS packet of a carousel
+ * \param p_carousel pointer to the carousel
+ * \param i_now current time in microseconds, which must not go backwards
+ * \param p_packet filled with the 188 bytes of the packet
+ * \return true if a packet was due and written, false otherwise.
+ *
+ * The table that has been due for the longest time is served first. The
+ * continuity counters are kept per PID, for all the tables sharing it.
+ * A call costs one packet copy and O(log n) with n tables, the packets
+ * being built when the tables are added or updated.
+ */
+bool dvbpsi_carousel_next(dvbpsi_carousel_t *p_carousel, uint64_t i_now,
+                          uint8_t *p_packet);
+
+/*****************************************************************************
+ * dvbpsi_carousel_render_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_carousel_render_s dvbpsi_carousel_render_t
+ * \brief dvbpsi_carousel_render_t type definition, an opaque loop of a
+ * carousel rendered for playout.
+ */
+typedef struct dvbpsi_carousel_render_s dvbpsi_carousel_render_t;
+
+/*****************************************************************************
+ * dvbpsi_carousel_render_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_carousel_render_t *dvbpsi_carousel_render_new(dvbpsi_carousel_t *p_carousel,
+ *                                                         uint64_t i_duration,
+ *                                                         uint32_t i_bitrate)
+ * \brief Renders the tables of a carousel into a loop of TS packets to be
+ * played out repeatedly
+ * \param p_carousel pointer to the carousel
+ * \param i_duration duration of the loop in microseconds
+ * \param i_bitrate bitrate of the loop in bits per second
+ * \return a pointer to the render, or NULL if the carousel has no tables,
+ *         i_bitrate is 0 or on error.
+ *
+ * The carousel is played from its start with the latest version of each
+ * table, a packet slot every 1504 / i_bitrate s, the free slots being
+ * filled with null packets. The sections in progress at the end of
+ * i_duration are completed, then stuffing packets are added on each PID up
+ * to a multiple of 16 packets, so that the continuity counters and the
+ * intervals go on across the end of the loop. The carousel itself is left
+ * as it was. The render must be deleted before its tables are removed.
+ */
+dvbpsi_carousel_render_t *dvbpsi_carousel_render_new(dvbpsi_carousel_t *p_carousel,
+                                                     uint64_t i_duration,
+                                                     uint32_t i_bitrate);
+
+/*****************************************************************************
+ * dvbpsi_carousel_render_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_carousel_render_delete(dvbpsi_carousel_render_t *p_render)
+ * \brief Deletes a render
+ * \param p_render pointer to the render
+ * \return nothing.
+ */
+void dvbpsi_carousel_render_delete(dvbpsi_carousel_render_t *p_render);
+
+/*****************************************************************************
+ * dvbpsi_carousel_render_packets
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_carousel_render_packets(const dvbpsi_carousel_render_t *p_render)
+ * \brief Gets the number of TS packets of a render
+ * \param p_render pointer to the render
+ * \return the number of packets, the buffer of the loop holding 188 bytes
+ *         for each.
+ */
+size_t dvbpsi_carousel_render_packets(const dvbpsi_carousel_render_t *p_render);
+
+/*****************************************************************************
+ * dvbpsi_carousel_render_write
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_carousel_render_write(const dvbpsi_carousel_render_t *p_render,
+ *                                       uint8_t *p_buffer)
+ * \brief Writes the packets of a render
+ * \param p_render pointer to the render
+ * \param p_buffer filled with the packets, such as a mapped file
+ * \return true on success, false if a table no longer has the number of
+ *         packets and sections it was rendered with.
+ */
+bool dvbpsi_carousel_render_write(const dvbpsi_carousel_render_t *p_render,
+                                  uint8_t *p_buffer);
+
+/*****************************************************************************
+ * dvbpsi_carousel_render_update
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_carousel_render_update(const dvbpsi_carousel_render_t *p_render,
+ *                                        const dvbpsi_carousel_table_t *p_table,
+ *                                        uint8_t *p_buffer)
+ * \brief Rewrites the packets of a table in a written render
+ * \param p_render pointer to the render
+ * \param p_table table updated with dvbpsi_carousel_update()
+ * \param p_buffer packets written by dvbpsi_carousel_render_write()
+ * \return true on success, false if the table is not in the render or no
+ *         longer has the number of packets and sections it was rendered
+ *         with, a new render being needed.
+ *
+ * Only the packets of the table are written, in place: a new version of
+ * the same size, such as a new version_number, leaves the rest of a
+ * mapped file untouched.
+ */
+bool dvbpsi_carousel_render_update(const dvbpsi_carousel_render_t *p_render,
+                                   const dvbpsi_carousel_table_t *p_table,
+                                   uint8_t *p_buffer);
+
+/*****************************************************************************
+ * dvbpsi_carousel_plan_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_carousel_plan_s
+ * \brief Table to plan, see dvbpsi_carousel_plan().
+ */
+/*!
+ * \typedef struct dvbpsi_carousel_plan_s dvbpsi_carousel_plan_t
+ * \brief dvbpsi_carousel_plan_t type definition.
+ */
+typedef struct dvbpsi_carousel_plan_s
+{
+    uint16_t                    i_pid;          /*!< PID of the table */
+    const dvbpsi_psi_section_t *p_sections;     /*!< sections of the table */
+    uint64_t                    i_interval;     /*!< wanted interval in
+                                                     microseconds, 0 for the
+                                                     limit of the table */
+
+    size_t                      i_packets;      /*!< filled with the number of
+                                                     packets of a repetition */
+    uint64_t                    i_limit;        /*!< filled with the maximum
+                                                     interval of the table,
+                                                     0 if none */
+    uint64_t                    i_achieved;     /*!< filled with the interval
+                                                     for dvbpsi_carousel_add() */
+    uint32_t                    i_max_bitrate;  /*!< filled with the bitrate
+                                                     for dvbpsi_carousel_add(),
+                                                     0 for no limit */
+    bool                        b_violation;    /*!< filled with true when
+                                                     i_achieved exceeds
+                                                     i_limit */
+} dvbpsi_carousel_plan_t;
+
+/*****************************************************************************
+ * dvbpsi_carousel_budget_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_carousel_budget_s
+ * \brief Bitrate available on a PID, see dvbpsi_carousel_plan().
+ */
+/*!
+ * \typedef struct dvbpsi_carousel_budget_s dvbpsi_carousel_budget_t
+ * \brief dvbpsi_carousel_budget_t type definition.
+ */
+typedef struct dvbpsi_carousel_budget_s
+{
+    uint16_t i_pid;                             /*!< PID */
+    uint32_t i_bitrate;                         /*!< bits per second on the
+                                                     PID, TS headers included */
+} dvbpsi_carousel_budget_t;
+
+/*****************************************************************************
+ * dvbpsi_carousel_plan
+ *****************************************************************************/
+/*!
+ * \fn unsigned int dvbpsi_carousel_plan(dvbpsi_carousel_plan_t *p_plan,
+ *                                       size_t i_tables,
+ *                                       const dvbpsi_carousel_budget_t *p_budgets,
+ *                                       size_t i_budgets)
+ * \brief Plans the intervals and bitrates of tables to be added to a
+ * carousel within the bitrate of their PIDs
+ * \param p_plan tables to plan
+ * \param i_tables number of tables
+ * \param p_budgets bitrates of the PIDs, a PID without any being unlimited
+ * \param i_budgets number of bitrates
+ * \return the number of tables whose achievable interval exceeds their
+ *         limit.
+ *
+ * The limits are the maximum intervals of ETSI TR 101 211 section 4.4 and
+ * ETSI TR 101 290 for the table_id of the first section: 0.5 s for the PAT
+ * and the PMT, 2 s for the actual SDT and EIT present/following, 10 s for
+ * the NIT, BAT, other SDT and EIT present/following and the first 8 days
+ * of EIT schedule, 30 s for the later days and the TDT and TOT. A table
+ * without any limit and wanted interval is planned every 10 s.
+ *
+ * A repetition cannot be shorter than DVBPSI_CAROUSEL_SECTION_GAP per
+ * section. When the tables of a PID need more than its bitrate, all their
+ * intervals are stretched in the same proportion. Each table of a PID is
+ * limited to the bitrate of the PID: as the carousel sends the sections
+ * of a PID one at a time, the PID never exceeds it, and a large EIT
+ * schedule segment is spread at that bitrate instead of being sent in a
+ * burst.
+ */
+unsigned int dvbpsi_carousel_plan(dvbpsi_carousel_plan_t *p_plan, size_t i_tables,
+                                  const dvbpsi_carousel_budget_t *p_budgets,
+                                  size_t i_budgets);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of carousel.h"
+#endif
@@ -0,0 +1,195 @@
+/*****************************************************************************
+ * changelog.c: change sequence log of the tables of handles
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "changelog.h"
+
+/*****************************************************************************
+ * Atomics
+ *****************************************************************************
+ * The sequence of an entry is cleared before its other words are written
+ * and set after them, a reader checking it is the same on both sides.
+ *****************************************************************************/
+#ifdef __ATOMIC_SEQ_CST
+#   define CHANGELOG_LOAD(p, order)     __atomic_load_n(p, __ATOMIC_##order)
+#   define CHANGELOG_STORE(p, v, order) __atomic_store_n(p, v, __ATOMIC_##order)
+#   define CHANGELOG_FENCE(order)       __atomic_thread_fence(__ATOMIC_##order)
+#else
+#   define CHANGELOG_LOAD(p, order)     (__sync_synchronize(), *(volatile __typeof__(*(p)) *)(p))
+#   define CHANGELOG_STORE(p, v, order) do { __sync_synchronize(); \
+                                              *(volatile __typeof__(*(p)) *)(p) = (v); \
+                                              __sync_synchronize(); } while (0)
+#   define CHANGELOG_FENCE(order)       __sync_synchronize()
+#endif
+
+/*****************************************************************************
+ * dvbpsi_changelog_entry_t
+ *****************************************************************************
+ * A change in two words: PID, table_id, table_id_extension and versions
+ * packed in i_key, and the time.
+ *****************************************************************************/
+typedef struct dvbpsi_changelog_entry_s
+{
+    uint64_t   i_sequence;      /* 0 while being written */
+    uint64_t   i_key;
+    int64_t    i_time;
+} dvbpsi_changelog_entry_t;
+
+/*****************************************************************************
+ * dvbpsi_changelog_s
+ *****************************************************************************/
+struct dvbpsi_changelog_s
+{
+    uint64_t                    i_sequence;     /* last change */
+    uint64_t                    i_size;         /* power of 2 */
+    dvbpsi_changelog_entry_t   *p_entries;
+};
+
+/*****************************************************************************
+ * dvbpsi_changelog_new
+ *****************************************************************************/
+dvbpsi_changelog_t *dvbpsi_changelog_new(unsigned int i_size)
+{
+    uint64_t i_entries = 1;
+    while (i_entries < i_size)
+        i_entries <<= 1;
+
+    dvbpsi_changelog_t *p_log = dvbpsi_calloc(1, sizeof(dvbpsi_changelog_t));
+    if (p_log == NULL)
+        return NULL;
+
+    p_log->p_entries = dvbpsi_calloc(i_entries, sizeof(dvbpsi_changelog_entry_t));
+    if (p_log->p_entries == NULL)
+    {
+        dvbpsi_free(p_log);
+        return NULL;
+    }
+    p_log->i_size = i_entries;
+    return p_log;
+}
+
+/*****************************************************************************
+ * dvbpsi_changelog_delete
+ *****************************************************************************/
+void dvbpsi_changelog_delete(dvbpsi_changelog_t *p_log)
+{
+    if (p_log == NULL)
+        return;
+
+    dvbpsi_free(p_log->p_entries);
+    dvbpsi_free(p_log);
+}
+
+/*****************************************************************************
+ * dvbpsi_changelog_append
+ *****************************************************************************/
+uint64_t dvbpsi_changelog_append(dvbpsi_changelog_t *p_log,
+                                 const dvbpsi_change_t *p_change)
+{
+    assert(p_log);
+    assert(p_change);
+
+    uint64_t i_sequence = p_log->i_sequence + 1;
+    dvbpsi_changelog_entry_t *p_entry = &p_log->p_entries[i_sequence & (p_log->i_size - 1)];
+    uint64_t i_key = ((uint64_t)p_change->i_pid << 40)
+                   | ((uint64_t)p_change->i_table_id << 32)
+                   | ((uint64_t)p_change->i_extension << 16)
+                   | ((uint64_t)p_change->i_old_version << 8)
+                   | p_change->i_new_version;
+
+    CHANGELOG_STORE(&p_entry->i_sequence, 0, RELAXED);
+    CHANGELOG_FENCE(RELEASE);
+    CHANGELOG_STORE(&p_entry->i_key, i_key, RELAXED);
+    CHANGELOG_STORE(&p_entry->i_time, p_change->i_time, RELAXED);
+    CHANGELOG_STORE(&p_entry->i_sequence, i_sequence, RELEASE);
+
+    CHANGELOG_STORE(&p_log->i_sequence, i_sequence, RELEASE);
+    return i_sequence;
+}
+
+/*****************************************************************************
+ * dvbpsi_changelog_sequence
+ *****************************************************************************/
+uint64_t dvbpsi_changelog_sequence(const dvbpsi_changelog_t *p_log)
+{
+    assert(p_log);
+    return CHANGELOG_LOAD(&p_log->i_sequence, ACQUIRE);
+}
+
+/*****************************************************************************
+ * dvbpsi_changelog_read
+ *****************************************************************************/
+size_t dvbpsi_changelog_read(const dvbpsi_changelog_t *p_log, uint64_t i_since,
+                             dvbpsi_change_t *p_changes, size_t i_max)
+{
+    assert(p_log);
+    assert(p_changes || i_max == 0);
+
+    uint64_t i_last = CHANGELOG_LOAD(&p_log->i_sequence, ACQUIRE);
+    uint64_t i_first = i_since + 1;
+    if (i_last >= p_log->i_size && i_first <= i_last - p_log->i_size)
+        i_first = i_last - p_log->i_size + 1;
+
+    size_t i_count = 0;
+    for (uint64_t i_sequence = i_first; i_sequence <= i_last && i_count < i_max; i_sequence++)
+    {
+        const dvbpsi_changelog_entry_t *p_entry
+                = &p_log->p_entries[i_sequence & (p_log->i_size - 1)];
+
+        /* Overwritten by a later change, or being written */
+        if (CHANGELOG_LOAD(&p_entry->i_sequence, ACQUIRE) != i_sequence)
+            continue;
+        uint64_t i_key = CHANGELOG_LOAD(&p_entry->i_key, RELAXED);
+        int64_t i_time = CHANGELOG_LOAD(&p_entry->i_time, RELAXED);
+        CHANGELOG_FENCE(ACQUIRE);
+        if (CHANGELOG_LOAD(&p_entry->i_sequence, RELAXED) != i_sequence)
+            continue;
+
+        dvbpsi_change_t *p_change = &p_changes[i_count++];
+        p_change->i_sequence = i_sequence;
+        p_change->i_pid = (i_key >> 40) & 0xffff;
+        p_change->i_table_id = (i_key >> 32) & 0xff;
+        p_change->i_extension = (i_key >> 16) & 0xffff;
+        p_change->i_old_version = (i_key >> 8) & 0xff;
+        p_change->i_new_version = i_key & 0xff;
+        p_change->i_time = i_time;
+    }
+    return i_count;
+}
@@ -0,0 +1,161 @@
+/*****************************************************************************
+ * changelog.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <changelog.h>
+ * \brief Change sequence log of the tables of handles.
+ *
+ * A change log numbers the new versions accepted by the decoders of the
+ * handles it is set on, see dvbpsi_set_changelog(), from 1 upwards, and
+ * keeps the last of them in a ring. Readers ask for the changes following
+ * a sequence number they saw, in time proportional to the number of
+ * changes, from any thread and without locks: each entry of the ring is a
+ * sequence lock written by the single thread pushing data into the
+ * handles.
+ */
+
+#ifndef _DVBPSI_CHANGELOG_H_
+#define _DVBPSI_CHANGELOG_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_changelog_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_changelog_s dvbpsi_changelog_t
+ * \brief dvbpsi_changelog_t type definition, an opaque change log.
+ */
+typedef struct dvbpsi_changelog_s dvbpsi_changelog_t;
+
+/*!
+ * \def DVBPSI_CHANGELOG_NO_VERSION
+ * \brief Old version of the first table of a subtable, or of one decoded
+ * again after a reset of its decoder
+ */
+#define DVBPSI_CHANGELOG_NO_VERSION 0xff
+
+/*****************************************************************************
+ * dvbpsi_change_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_change_s
+ * \brief Entry of a change log
+ */
+/*!
+ * \typedef struct dvbpsi_change_s dvbpsi_change_t
+ * \brief dvbpsi_change_t type definition.
+ */
+typedef struct dvbpsi_change_s
+{
+    uint64_t i_sequence;        /*!< sequence number, from 1 */
+    uint16_t i_pid;             /*!< PID, DVBPSI_EVENT_NO_PID for sections
+                                     given to dvbpsi_section_push() */
+    uint8_t  i_table_id;        /*!< table_id */
+    uint16_t i_extension;       /*!< table_id_extension */
+    uint8_t  i_old_version;     /*!< previous version_number, or
+                                     DVBPSI_CHANGELOG_NO_VERSION */
+    uint8_t  i_new_version;     /*!< new version_number */
+    int64_t  i_time;            /*!< arrival time of the section completing
+                                     the table, or DVBPSI_TIME_NONE */
+} dvbpsi_change_t;
+
+/*****************************************************************************
+ * dvbpsi_changelog_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_changelog_t *dvbpsi_changelog_new(unsigned int i_size)
+ * \brief Creates a change log
+ * \param i_size number of changes kept, rounded up to a power of 2
+ * \return pointer to the log, or NULL on error
+ */
+dvbpsi_changelog_t *dvbpsi_changelog_new(unsigned int i_size);
+
+/*****************************************************************************
+ * dvbpsi_changelog_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_changelog_delete(dvbpsi_changelog_t *p_log)
+ * \brief Deletes a change log, once set on no handle and read by no thread
+ * \param p_log pointer to the log
+ * \return nothing
+ */
+void dvbpsi_changelog_delete(dvbpsi_changelog_t *p_log);
+
+/*****************************************************************************
+ * dvbpsi_changelog_append
+ *****************************************************************************/
+/*!
+ * \fn uint64_t dvbpsi_changelog_append(dvbpsi_changelog_t *p_log,
+ *                                      const dvbpsi_change_t *p_change)
+ * \brief Appends a change, as done by the handles the log is set on
+ * \param p_log pointer to the log
+ * \param p_change change, whose i_sequence is ignored
+ * \return sequence number of the change
+ *
+ * Only one thread may append to a log.
+ */
+uint64_t dvbpsi_changelog_append(dvbpsi_changelog_t *p_log,
+                                 const dvbpsi_change_t *p_change);
+
+/*****************************************************************************
+ * dvbpsi_changelog_sequence
+ *****************************************************************************/
+/*!
+ * \fn uint64_t dvbpsi_changelog_sequence(const dvbpsi_changelog_t *p_log)
+ * \brief Gives the sequence number of the last change
+ * \param p_log pointer to the log
+ * \return the sequence number, 0 before the first change
+ */
+uint64_t dvbpsi_changelog_sequence(const dvbpsi_changelog_t *p_log);
+
+/*****************************************************************************
+ * dvbpsi_changelog_read
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_changelog_read(const dvbpsi_changelog_t *p_log,
+ *                                  uint64_t i_since, dvbpsi_change_t *p_changes,
+ *                                  size_t i_max)
+ * \brief Gives the changes following a sequence number, oldest first
+ * \param p_log pointer to the log
+ * \param i_since sequence number of the last change already seen, 0 for
+ *        all the changes of the log
+ * \param p_changes filled with the changes
+ * \param i_max maximum number of changes given
+ * \return number of changes given
+ *
+ * When the first change given is not i_since + 1, the changes in between
+ * were overwritten in the ring, or while being read: the reader needs to
+ * look at the whole tables again.
+ */
+size_t dvbpsi_changelog_read(const dvbpsi_changelog_t *p_log, uint64_t i_since,
+                             dvbpsi_change_t *p_changes, size_t i_max);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of changelog.h"
+#endif
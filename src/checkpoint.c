@@ -0,0 +1,491 @@
+/*****************************************************************************
+ * checkpoint.c: checkpoints of the decoders of handles
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "demux.h"
+#include "router.h"
+#include "checkpoint.h"
+
+#define CHECKPOINT_BUCKETS      1024
+#define CHECKPOINT_HEADER       12
+#define CHECKPOINT_DECODER      8
+#define CHECKPOINT_SECTION_MAX  4096
+
+#define CHECKPOINT_FLAG_FULL    0x01
+
+/*****************************************************************************
+ * dvbpsi_checkpoint_entry_t
+ *****************************************************************************
+ * What was written of a decoder, by PID, table_id and table_id_extension.
+ *****************************************************************************/
+typedef struct dvbpsi_checkpoint_entry_s
+{
+    struct dvbpsi_checkpoint_entry_s *p_next;
+    uint64_t i_key;
+    uint32_t i_hash;            /* of its sections */
+    uint32_t i_generation;      /* of the last checkpoint holding it */
+} dvbpsi_checkpoint_entry_t;
+
+/*****************************************************************************
+ * dvbpsi_checkpoint_s
+ *****************************************************************************/
+struct dvbpsi_checkpoint_s
+{
+    dvbpsi_checkpoint_entry_t *p_buckets[CHECKPOINT_BUCKETS];
+
+    uint8_t *  p_data;              /* checkpoint being written */
+    size_t     i_length;            /* its length */
+    size_t     i_max;               /* bytes allocated */
+    uint32_t   i_decoders;          /* its decoders */
+    bool       b_full;              /* it holds all the decoders */
+    bool       b_failed;            /* a memory error happened */
+    bool       b_written;           /* a checkpoint was completed */
+
+    uint32_t   i_generation;        /* sequence number of the checkpoint */
+};
+
+/*****************************************************************************
+ * checkpoint_put16, checkpoint_get16...
+ *****************************************************************************/
+static void checkpoint_put16(uint8_t *p, uint16_t i)
+{
+    p[0] = i;
+    p[1] = i >> 8;
+}
+
+static void checkpoint_put32(uint8_t *p, uint32_t i)
+{
+    checkpoint_put16(p, i);
+    checkpoint_put16(p + 2, i >> 16);
+}
+
+static uint16_t checkpoint_get16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t checkpoint_get32(const uint8_t *p)
+{
+    return checkpoint_get16(p) | (uint32_t)checkpoint_get16(p + 2) << 16;
+}
+
+/*****************************************************************************
+ * checkpoint_bucket
+ *****************************************************************************/
+static dvbpsi_checkpoint_entry_t **checkpoint_bucket(dvbpsi_checkpoint_t *p_checkpoint,
+                                                     uint64_t i_key)
+{
+    uint32_t i_fold = (uint32_t)(i_key ^ i_key >> 32);
+    return &p_checkpoint->p_buckets[(i_fold * 2654435761u) >> 22];
+}
+
+/*****************************************************************************
+ * checkpoint_clear
+ *****************************************************************************
+ * Forgets the decoders the current checkpoint does not hold, or all of them.
+ *****************************************************************************/
+static void checkpoint_clear(dvbpsi_checkpoint_t *p_checkpoint, bool b_all)
+{
+    for (int i = 0; i < CHECKPOINT_BUCKETS; i++)
+    {
+        dvbpsi_checkpoint_entry_t **pp_entry = &p_checkpoint->p_buckets[i];
+        while (*pp_entry)
+        {
+            dvbpsi_checkpoint_entry_t *p_entry = *pp_entry;
+            if (b_all || p_entry->i_generation != p_checkpoint->i_generation)
+            {
+                *pp_entry = p_entry->p_next;
+                dvbpsi_free(p_entry);
+            }
+            else
+                pp_entry = &p_entry->p_next;
+        }
+    }
+}
+
+/*****************************************************************************
+ * checkpoint_hash
+ *****************************************************************************
+ * FNV-1a hash of a list of sections: the header and CRC_32 of those that
+ * have one, all the bytes of the others.
+ *****************************************************************************/
+static uint32_t checkpoint_hash(uint32_t i_hash, dvbpsi_psi_section_t *p_section,
+                                uint16_t *pi_count)
+{
+    *pi_count = 0;
+    for (; p_section; p_section = p_section->p_next)
+    {
+        size_t i_size = p_section->i_length + 3;
+        const uint8_t *p_data = p_section->p_data;
+        bool b_crc = dvbpsi_has_CRC32(p_section) && (i_size >= 12);
+
+        for (size_t i = 0; i < (b_crc ? 8 : i_size); i++)
+            i_hash = (i_hash ^ p_data[i]) * 16777619u;
+        if (b_crc)
+            for (size_t i = i_size - 4; i < i_size; i++)
+                i_hash = (i_hash ^ p_data[i]) * 16777619u;
+        (*pi_count)++;
+    }
+    return (i_hash ^ *pi_count) * 16777619u;
+}
+
+/*****************************************************************************
+ * checkpoint_reserve
+ *****************************************************************************/
+static bool checkpoint_reserve(dvbpsi_checkpoint_t *p_checkpoint, size_t i_size)
+{
+    if (p_checkpoint->i_length + i_size <= p_checkpoint->i_max)
+        return true;
+
+    size_t i_max = p_checkpoint->i_max ? p_checkpoint->i_max : 4096;
+    while (i_max < p_checkpoint->i_length + i_size)
+        i_max *= 2;
+    uint8_t *p_data = dvbpsi_malloc(i_max);
+    if (p_data == NULL)
+        return false;
+    if (p_checkpoint->i_length > 0)
+        memcpy(p_data, p_checkpoint->p_data, p_checkpoint->i_length);
+    dvbpsi_free(p_checkpoint->p_data);
+    p_checkpoint->p_data = p_data;
+    p_checkpoint->i_max = i_max;
+    return true;
+}
+
+/*****************************************************************************
+ * checkpoint_write_sections
+ *****************************************************************************/
+static void checkpoint_write_sections(dvbpsi_checkpoint_t *p_checkpoint,
+                                      const dvbpsi_psi_section_t *p_section)
+{
+    for (; p_section; p_section = p_section->p_next)
+    {
+        size_t i_size = p_section->i_length + 3;
+        memcpy(p_checkpoint->p_data + p_checkpoint->i_length, p_section->p_data, i_size);
+        p_checkpoint->i_length += i_size;
+    }
+}
+
+/*****************************************************************************
+ * checkpoint_decoder
+ *****************************************************************************
+ * Writes a decoder if it holds sections that were not written yet.
+ *****************************************************************************/
+static bool checkpoint_decoder(dvbpsi_checkpoint_t *p_checkpoint,
+                               const dvbpsi_decoder_t *p_decoder, uint16_t i_pid)
+{
+    dvbpsi_psi_section_t *p_last = p_decoder->p_last_sections;
+    dvbpsi_psi_section_t *p_gathering = p_decoder->p_sections;
+    if (p_last == NULL && p_gathering == NULL)
+        return true;
+
+    const dvbpsi_psi_section_t *p_first = p_last ? p_last : p_gathering;
+    uint64_t i_key = (uint64_t)i_pid << 24 | (uint64_t)p_first->i_table_id << 16
+                   | p_first->i_extension;
+
+    uint16_t i_last, i_gathering;
+    uint32_t i_hash = checkpoint_hash(2166136261u, p_last, &i_last);
+    i_hash = checkpoint_hash(i_hash, p_gathering, &i_gathering);
+
+    dvbpsi_checkpoint_entry_t **pp_entry = checkpoint_bucket(p_checkpoint, i_key);
+    while (*pp_entry && (*pp_entry)->i_key != i_key)
+        pp_entry = &(*pp_entry)->p_next;
+    dvbpsi_checkpoint_entry_t *p_entry = *pp_entry;
+
+    if (p_entry && p_entry->i_generation == p_checkpoint->i_generation)
+        return true; /* already held, its handle being given twice */
+    if (p_entry && !p_checkpoint->b_full && p_entry->i_hash == i_hash)
+    {
+        p_entry->i_generation = p_checkpoint->i_generation;
+        return true;
+    }
+
+    size_t i_size = CHECKPOINT_DECODER;
+    for (const dvbpsi_psi_section_t *p = p_last; p; p = p->p_next)
+        i_size += p->i_length + 3;
+    for (const dvbpsi_psi_section_t *p = p_gathering; p; p = p->p_next)
+        i_size += p->i_length + 3;
+    if (!checkpoint_reserve(p_checkpoint, i_size))
+        return false;
+
+    if (p_entry == NULL)
+    {
+        p_entry = dvbpsi_malloc(sizeof(dvbpsi_checkpoint_entry_t));
+        if (p_entry == NULL)
+            return false;
+        p_entry->p_next = NULL;
+        p_entry->i_key = i_key;
+        *pp_entry = p_entry;
+    }
+    p_entry->i_hash = i_hash;
+    p_entry->i_generation = p_checkpoint->i_generation;
+
+    uint8_t *p = p_checkpoint->p_data + p_checkpoint->i_length;
+    checkpoint_put16(p, i_pid);
+    checkpoint_put16(p + 2, i_last);
+    checkpoint_put16(p + 4, i_gathering);
+    checkpoint_put16(p + 6, 0);
+    p_checkpoint->i_length += CHECKPOINT_DECODER;
+    checkpoint_write_sections(p_checkpoint, p_last);
+    checkpoint_write_sections(p_checkpoint, p_gathering);
+    p_checkpoint->i_decoders++;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_checkpoint_new
+ *****************************************************************************/
+dvbpsi_checkpoint_t *dvbpsi_checkpoint_new(void)
+{
+    return dvbpsi_calloc(1, sizeof(dvbpsi_checkpoint_t));
+}
+
+/*****************************************************************************
+ * dvbpsi_checkpoint_delete
+ *****************************************************************************/
+void dvbpsi_checkpoint_delete(dvbpsi_checkpoint_t *p_checkpoint)
+{
+    if (p_checkpoint == NULL)
+        return;
+
+    checkpoint_clear(p_checkpoint, true);
+    dvbpsi_free(p_checkpoint->p_data);
+    dvbpsi_free(p_checkpoint);
+}
+
+/*****************************************************************************
+ * dvbpsi_checkpoint_begin
+ *****************************************************************************/
+void dvbpsi_checkpoint_begin(dvbpsi_checkpoint_t *p_checkpoint, bool b_full)
+{
+    assert(p_checkpoint);
+
+    p_checkpoint->i_generation++;
+    p_checkpoint->b_full = b_full || !p_checkpoint->b_written;
+    p_checkpoint->i_decoders = 0;
+    p_checkpoint->i_length = 0;
+    p_checkpoint->b_failed = !checkpoint_reserve(p_checkpoint, CHECKPOINT_HEADER);
+    if (!p_checkpoint->b_failed)
+        p_checkpoint->i_length = CHECKPOINT_HEADER;
+}
+
+/*****************************************************************************
+ * dvbpsi_checkpoint_handle
+ *****************************************************************************/
+bool dvbpsi_checkpoint_handle(dvbpsi_checkpoint_t *p_checkpoint, dvbpsi_t *p_dvbpsi,
+                              uint16_t i_pid)
+{
+    assert(p_checkpoint && p_dvbpsi);
+
+    if (p_checkpoint->b_failed)
+        return false;
+
+    dvbpsi_decoder_t *p_decoder = p_dvbpsi->p_decoder;
+    if (p_decoder == NULL)
+        return true;
+
+    bool b_ok = true;
+    if (p_decoder->pf_gather == dvbpsi_Demux)
+    {
+        dvbpsi_demux_t *p_demux = (dvbpsi_demux_t *)p_decoder;
+        for (dvbpsi_demux_subdec_t *p_subdec = p_demux->p_first_subdec;
+             b_ok && p_subdec; p_subdec = p_subdec->p_next)
+            if (p_subdec->p_decoder)
+                b_ok = checkpoint_decoder(p_checkpoint, p_subdec->p_decoder, i_pid);
+    }
+    else
+        b_ok = checkpoint_decoder(p_checkpoint, p_decoder, i_pid);
+
+    if (!b_ok)
+        p_checkpoint->b_failed = true;
+    return b_ok;
+}
+
+/*****************************************************************************
+ * dvbpsi_checkpoint_router
+ *****************************************************************************/
+bool dvbpsi_checkpoint_router(dvbpsi_checkpoint_t *p_checkpoint,
+                              dvbpsi_router_t *p_router)
+{
+    assert(p_checkpoint && p_router);
+
+    /* handles written, those attached to several PIDs only once */
+    dvbpsi_t **pp_handles = NULL;
+    size_t i_handles = 0, i_max = 0;
+    bool b_ok = true;
+
+    for (uint16_t i_pid = 0; b_ok && i_pid < DVBPSI_ROUTER_PIDS; i_pid++)
+    {
+        dvbpsi_t *p_dvbpsi = dvbpsi_router_get(p_router, i_pid);
+        if (p_dvbpsi == NULL)
+            continue;
+
+        size_t i = 0;
+        while (i < i_handles && pp_handles[i] != p_dvbpsi)
+            i++;
+        if (i < i_handles)
+            continue;
+
+        if (i_handles == i_max)
+        {
+            size_t i_new = i_max ? 2 * i_max : 32;
+            dvbpsi_t **pp_new = dvbpsi_malloc(i_new * sizeof(dvbpsi_t *));
+            if (pp_new == NULL)
+            {
+                p_checkpoint->b_failed = true;
+                b_ok = false;
+                break;
+            }
+            if (i_handles > 0)
+                memcpy(pp_new, pp_handles, i_handles * sizeof(dvbpsi_t *));
+            dvbpsi_free(pp_handles);
+            pp_handles = pp_new;
+            i_max = i_new;
+        }
+        pp_handles[i_handles++] = p_dvbpsi;
+
+        b_ok = dvbpsi_checkpoint_handle(p_checkpoint, p_dvbpsi, i_pid);
+    }
+
+    dvbpsi_free(pp_handles);
+    return b_ok;
+}
+
+/*****************************************************************************
+ * dvbpsi_checkpoint_end
+ *****************************************************************************/
+const uint8_t *dvbpsi_checkpoint_end(dvbpsi_checkpoint_t *p_checkpoint, size_t *pi_size)
+{
+    assert(p_checkpoint && pi_size);
+
+    *pi_size = 0;
+    if (p_checkpoint->b_failed)
+    {
+        /* what this one holds may never arrive */
+        p_checkpoint->b_written = false;
+        return NULL;
+    }
+
+    if (p_checkpoint->b_full)
+        checkpoint_clear(p_checkpoint, false);
+    p_checkpoint->b_written = true;
+
+    uint8_t *p = p_checkpoint->p_data;
+    p[0] = 'D';
+    p[1] = 'C';
+    p[2] = 1;
+    p[3] = p_checkpoint->b_full ? CHECKPOINT_FLAG_FULL : 0;
+    checkpoint_put32(p + 4, p_checkpoint->i_generation);
+    checkpoint_put32(p + 8, p_checkpoint->i_decoders);
+
+    *pi_size = p_checkpoint->i_length;
+    return p_checkpoint->p_data;
+}
+
+/*****************************************************************************
+ * checkpoint_push
+ *****************************************************************************
+ * Pushes i_count sections from *pp_data, false if they overrun p_end.
+ *****************************************************************************/
+static bool checkpoint_push(dvbpsi_t *p_dvbpsi, const uint8_t **pp_data,
+                            const uint8_t *p_end, uint16_t i_count)
+{
+    uint8_t p_section[CHECKPOINT_SECTION_MAX];
+    const uint8_t *p = *pp_data;
+
+    for (uint16_t i = 0; i < i_count; i++)
+    {
+        if (p_end - p < 3)
+            return false;
+        size_t i_size = 3 + (((p[1] & 0x0f) << 8) | p[2]);
+        if ((size_t)(p_end - p) < i_size || i_size > CHECKPOINT_SECTION_MAX)
+            return false;
+
+        if (p_dvbpsi && dvbpsi_decoder_present(p_dvbpsi))
+        {
+            memcpy(p_section, p, i_size);
+            dvbpsi_section_push(p_dvbpsi, p_section, i_size);
+        }
+        p += i_size;
+    }
+
+    *pp_data = p;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_checkpoint_restore
+ *****************************************************************************/
+bool dvbpsi_checkpoint_restore(const uint8_t *p_data, size_t i_size,
+                               dvbpsi_checkpoint_handle_cb pf_handle, void *p_cb_data,
+                               uint32_t *pi_sequence, bool *pb_full)
+{
+    assert(p_data && pf_handle);
+
+    if (i_size < CHECKPOINT_HEADER || p_data[0] != 'D' || p_data[1] != 'C'
+     || p_data[2] != 1)
+        return false;
+
+    if (pi_sequence)
+        *pi_sequence = checkpoint_get32(p_data + 4);
+    if (pb_full)
+        *pb_full = p_data[3] & CHECKPOINT_FLAG_FULL;
+
+    uint32_t i_decoders = checkpoint_get32(p_data + 8);
+    const uint8_t *p = p_data + CHECKPOINT_HEADER;
+    const uint8_t *p_end = p_data + i_size;
+
+    for (uint32_t i = 0; i < i_decoders; i++)
+    {
+        if (p_end - p < CHECKPOINT_DECODER)
+            return false;
+        uint16_t i_pid = checkpoint_get16(p);
+        uint16_t i_last = checkpoint_get16(p + 2);
+        uint16_t i_gathering = checkpoint_get16(p + 4);
+        p += CHECKPOINT_DECODER;
+
+        /* the complete table first, the next one gathered over it */
+        dvbpsi_t *p_dvbpsi = pf_handle(p_cb_data, i_pid);
+        if (!checkpoint_push(p_dvbpsi, &p, p_end, i_last)
+         || !checkpoint_push(p_dvbpsi, &p, p_end, i_gathering))
+            return false;
+    }
+    return p == p_end;
+}
@@ -0,0 +1,207 @@
+/*****************************************************************************
+ * checkpoint.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <checkpoint.h>
+ * \brief Checkpoints of the decoders of handles, restored in another process.
+ *
+ * A checkpoint holds the state of each decoder of the handles given, the
+ * single decoder of a handle or each subtable decoder of a demux, as the
+ * sections it holds: those of its last complete current table, kept with
+ * DVBPSI_FLAG_LAST_SECTIONS, then those of the table it is gathering. A
+ * restore pushes them in that order with dvbpsi_section_push() into the
+ * decoders of fresh handles, which decode the current tables again and go
+ * on gathering where the checkpoint left off: the version_number, CRC_32
+ * and section_number of the tables come with their sections. Without
+ * DVBPSI_FLAG_LAST_SECTIONS only the tables being gathered are kept.
+ *
+ * A writer remembers what it wrote of each decoder, so that a checkpoint
+ * that is not full only holds the decoders whose sections changed since.
+ * Each decoder written holds all its sections: a standby restoring each
+ * checkpoint of an active probe stays warm, and one that lost a checkpoint
+ * only misses the decoders it held until they change again or the next
+ * full checkpoint.
+ *
+ * All numbers are little endian:
+ * - checkpoint: "DC", version (8 bits, 1), flags (8 bits, 1 for a full
+ *   checkpoint), sequence number (32 bits), number of decoders (32 bits),
+ *   decoders;
+ * - decoder: PID (16 bits), number of sections of the complete table,
+ *   number of sections being gathered (16 bits each), 0 (16 bits), the
+ *   sections, each one sized by its section_length.
+ */
+
+#ifndef _DVBPSI_CHECKPOINT_H_
+#define _DVBPSI_CHECKPOINT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_checkpoint_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_checkpoint_s dvbpsi_checkpoint_t
+ * \brief dvbpsi_checkpoint_t type definition, an opaque checkpoint writer.
+ */
+typedef struct dvbpsi_checkpoint_s dvbpsi_checkpoint_t;
+
+/*****************************************************************************
+ * dvbpsi_checkpoint_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_checkpoint_t *dvbpsi_checkpoint_new(void)
+ * \brief Creates a checkpoint writer, which wrote nothing yet
+ * \return pointer to the writer, or NULL on error
+ */
+dvbpsi_checkpoint_t *dvbpsi_checkpoint_new(void);
+
+/*****************************************************************************
+ * dvbpsi_checkpoint_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_checkpoint_delete(dvbpsi_checkpoint_t *p_checkpoint)
+ * \brief Deletes a checkpoint writer and the last checkpoint
+ * \param p_checkpoint pointer to the writer, or NULL
+ * \return nothing
+ */
+void dvbpsi_checkpoint_delete(dvbpsi_checkpoint_t *p_checkpoint);
+
+/*****************************************************************************
+ * dvbpsi_checkpoint_begin
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_checkpoint_begin(dvbpsi_checkpoint_t *p_checkpoint, bool b_full)
+ * \brief Starts a checkpoint, holding no decoder yet
+ * \param p_checkpoint pointer to the writer
+ * \param b_full write all the decoders, not only those that changed since
+ *        the last checkpoint. The first checkpoint of a writer is always
+ *        full.
+ * \return nothing
+ *
+ * The handles are then given with dvbpsi_checkpoint_handle() or
+ * dvbpsi_checkpoint_router(), all before dvbpsi_checkpoint_end(), and not
+ * pushed into in the meantime.
+ */
+void dvbpsi_checkpoint_begin(dvbpsi_checkpoint_t *p_checkpoint, bool b_full);
+
+/*****************************************************************************
+ * dvbpsi_checkpoint_handle
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_checkpoint_handle(dvbpsi_checkpoint_t *p_checkpoint,
+ *                                   dvbpsi_t *p_dvbpsi, uint16_t i_pid)
+ * \brief Writes the decoders of a handle into the checkpoint
+ * \param p_checkpoint pointer to the writer, between dvbpsi_checkpoint_begin()
+ *        and dvbpsi_checkpoint_end()
+ * \param p_dvbpsi handle
+ * \param i_pid PID the handle decodes, given back to restore it
+ * \return false on a memory error, true otherwise.
+ *
+ * Decoders holding no section are not written.
+ */
+bool dvbpsi_checkpoint_handle(dvbpsi_checkpoint_t *p_checkpoint, dvbpsi_t *p_dvbpsi,
+                              uint16_t i_pid);
+
+/*****************************************************************************
+ * dvbpsi_checkpoint_router
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_checkpoint_router(dvbpsi_checkpoint_t *p_checkpoint,
+ *                                   dvbpsi_router_t *p_router)
+ * \brief Writes the decoders of the handles of a router into the checkpoint
+ * \param p_checkpoint pointer to the writer, between dvbpsi_checkpoint_begin()
+ *        and dvbpsi_checkpoint_end()
+ * \param p_router router
+ * \return false on a memory error, true otherwise.
+ *
+ * Each handle is written once, with the lowest PID it is attached to.
+ */
+bool dvbpsi_checkpoint_router(dvbpsi_checkpoint_t *p_checkpoint,
+                              dvbpsi_router_t *p_router);
+
+/*****************************************************************************
+ * dvbpsi_checkpoint_end
+ *****************************************************************************/
+/*!
+ * \fn const uint8_t *dvbpsi_checkpoint_end(dvbpsi_checkpoint_t *p_checkpoint,
+ *                                          size_t *pi_size)
+ * \brief Completes a checkpoint
+ * \param p_checkpoint pointer to the writer
+ * \param pi_size filled with the size of the checkpoint
+ * \return the checkpoint, valid until the next dvbpsi_checkpoint_begin(), or
+ *         NULL if a memory error happened since dvbpsi_checkpoint_begin(),
+ *         the next checkpoint being then full.
+ *
+ * A full checkpoint forgets the decoders it did not hold, which are then
+ * written again if they come back.
+ */
+const uint8_t *dvbpsi_checkpoint_end(dvbpsi_checkpoint_t *p_checkpoint,
+                                     size_t *pi_size);
+
+/*****************************************************************************
+ * dvbpsi_checkpoint_handle_cb
+ *****************************************************************************/
+/*!
+ * \typedef dvbpsi_t *(* dvbpsi_checkpoint_handle_cb)(void *p_cb_data,
+ *                                                    uint16_t i_pid)
+ * \brief Callback type definition, giving the handle restoring the decoders
+ * of a PID, or NULL to skip them.
+ */
+typedef dvbpsi_t *(* dvbpsi_checkpoint_handle_cb)(void *p_cb_data, uint16_t i_pid);
+
+/*****************************************************************************
+ * dvbpsi_checkpoint_restore
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_checkpoint_restore(const uint8_t *p_data, size_t i_size,
+ *                                    dvbpsi_checkpoint_handle_cb pf_handle,
+ *                                    void *p_cb_data, uint32_t *pi_sequence,
+ *                                    bool *pb_full)
+ * \brief Pushes the sections of a checkpoint to the handles of their PID
+ * \param p_data checkpoint
+ * \param i_size size of the checkpoint
+ * \param pf_handle function giving the handle of a PID
+ * \param p_cb_data private data given in argument to pf_handle
+ * \param pi_sequence filled with the sequence number of the checkpoint, one
+ *        more than that of the previous checkpoint of its writer, or NULL
+ * \param pb_full filled with whether the checkpoint is full, or NULL
+ * \return false if the checkpoint is malformed, the decoders before the
+ *         error being restored, true otherwise.
+ *
+ * The handles have their decoders attached as those of the checkpoint
+ * were, and the tables come to their callbacks as they are completed, from
+ * inside the call. The sections rejected by the decoders, such as those of
+ * a table they already have, do not fail the restore.
+ */
+bool dvbpsi_checkpoint_restore(const uint8_t *p_data, size_t i_size,
+                               dvbpsi_checkpoint_handle_cb pf_handle, void *p_cb_data,
+                               uint32_t *pi_sequence, bool *pb_full);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of checkpoint.h"
+#endif
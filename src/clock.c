@@ -0,0 +1,232 @@
+/*****************************************************************************
+ * clock.c: broadcast time of a transport stream
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "descriptor.h"
+#include "mjd.h"
+#include "tables/tot.h"
+#include "clock.h"
+
+/* System time clock in 27 MHz units, wrapping with the 33 bits PCR base */
+#define DVBPSI_CLOCK_WRAP   ((INT64_C(1) << 33) * 300)
+/* One second of the system time clock */
+#define DVBPSI_CLOCK_SECOND INT64_C(27000000)
+/* PCR away from the extrapolated clock taken as a discontinuity, 1 s */
+#define DVBPSI_CLOCK_JUMP   DVBPSI_CLOCK_SECOND
+
+/*****************************************************************************
+ * dvbpsi_clock_s
+ *****************************************************************************/
+struct dvbpsi_clock_s
+{
+    /* System time clock, from the last PCR */
+    bool        b_clock;
+    int64_t     i_pcr;              /* last PCR */
+    int64_t     i_stc;              /* last PCR on the extended clock */
+    uint64_t    i_packet;           /* packet of the last PCR */
+    int64_t     i_rate_stc;         /* clock between the last two PCRs */
+    uint64_t    i_rate_packets;     /* packets between them, 0 if unknown */
+
+    /* Bounds of UTC - system time clock, in 27 MHz units */
+    bool        b_anchor;
+    int64_t     i_low;
+    int64_t     i_high;
+};
+
+/*****************************************************************************
+ * dvbpsi_clock_new
+ *****************************************************************************/
+dvbpsi_clock_t *dvbpsi_clock_new(void)
+{
+    return dvbpsi_calloc(1, sizeof(dvbpsi_clock_t));
+}
+
+/*****************************************************************************
+ * dvbpsi_clock_delete
+ *****************************************************************************/
+void dvbpsi_clock_delete(dvbpsi_clock_t *p_clock)
+{
+    dvbpsi_free(p_clock);
+}
+
+/*****************************************************************************
+ * Clock
+ *****************************************************************************
+ * dvbpsi_clock_wrap() is the difference of two PCRs or PTS * 300 closest to
+ * 0, dvbpsi_clock_stc() the extended clock at a packet.
+ *****************************************************************************/
+static inline int64_t dvbpsi_clock_wrap(int64_t i_delta)
+{
+    i_delta %= DVBPSI_CLOCK_WRAP;
+    if (i_delta < 0)
+        i_delta += DVBPSI_CLOCK_WRAP;
+    if (i_delta >= DVBPSI_CLOCK_WRAP / 2)
+        i_delta -= DVBPSI_CLOCK_WRAP;
+    return i_delta;
+}
+
+static inline int64_t dvbpsi_clock_stc(const dvbpsi_clock_t *p_clock, uint64_t i_packet)
+{
+    if (p_clock->i_rate_packets == 0)
+        return p_clock->i_stc;
+    int64_t i_packets = (int64_t)(i_packet - p_clock->i_packet);
+    return p_clock->i_stc
+         + i_packets * p_clock->i_rate_stc / (int64_t)p_clock->i_rate_packets;
+}
+
+/*****************************************************************************
+ * dvbpsi_clock_pcr
+ *****************************************************************************/
+void dvbpsi_clock_pcr(dvbpsi_clock_t *p_clock, uint64_t i_pcr, bool b_discontinuity,
+                      uint64_t i_packet)
+{
+    assert(p_clock);
+
+    int64_t i_new = (int64_t)(i_pcr % DVBPSI_CLOCK_WRAP);
+    if (!p_clock->b_clock)
+    {
+        p_clock->b_clock = true;
+        p_clock->i_stc = 0;
+    }
+    else if (b_discontinuity || i_packet <= p_clock->i_packet)
+    {
+        /* New time base or packet count, the extended clock going on at the
+         * packet or from the last PCR */
+        if (i_packet > p_clock->i_packet)
+            p_clock->i_stc = dvbpsi_clock_stc(p_clock, i_packet);
+    }
+    else
+    {
+        int64_t i_expected = dvbpsi_clock_stc(p_clock, i_packet);
+        int64_t i_stc = p_clock->i_stc + dvbpsi_clock_wrap(i_new - p_clock->i_pcr);
+        int64_t i_error = i_stc - i_expected;
+        if (i_error > DVBPSI_CLOCK_JUMP || i_error < -DVBPSI_CLOCK_JUMP)
+            i_stc = i_expected;
+        else
+        {
+            p_clock->i_rate_stc = i_stc - p_clock->i_stc;
+            p_clock->i_rate_packets = i_packet - p_clock->i_packet;
+        }
+        p_clock->i_stc = i_stc;
+    }
+    p_clock->i_pcr = i_new;
+    p_clock->i_packet = i_packet;
+}
+
+/*****************************************************************************
+ * dvbpsi_clock_tdt
+ *****************************************************************************/
+bool dvbpsi_clock_tdt(dvbpsi_clock_t *p_clock, const dvbpsi_tot_t *p_tot,
+                      uint64_t i_packet)
+{
+    assert(p_clock);
+    assert(p_tot);
+
+    int64_t i_utc = dvbpsi_mjd_to_utc(p_tot->i_utc_time);
+    if (!p_clock->b_clock || i_utc == INT64_MIN)
+        return false;
+
+    /* The section was sent within the second of its UTC_time */
+    int64_t i_low = i_utc * DVBPSI_CLOCK_SECOND - dvbpsi_clock_stc(p_clock, i_packet);
+    int64_t i_high = i_low + DVBPSI_CLOCK_SECOND;
+    if (!p_clock->b_anchor || i_low >= p_clock->i_high || i_high <= p_clock->i_low)
+    {
+        p_clock->b_anchor = true;
+        p_clock->i_low = i_low;
+        p_clock->i_high = i_high;
+    }
+    else
+    {
+        if (i_low > p_clock->i_low)
+            p_clock->i_low = i_low;
+        if (i_high < p_clock->i_high)
+            p_clock->i_high = i_high;
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_clock_utc_at
+ *****************************************************************************
+ * Broadcast time in microseconds of a point of the extended clock.
+ *****************************************************************************/
+static int64_t dvbpsi_clock_utc_at(const dvbpsi_clock_t *p_clock, int64_t i_stc)
+{
+    if (!p_clock->b_clock || !p_clock->b_anchor)
+        return DVBPSI_TIME_NONE;
+
+    int64_t i_offset = p_clock->i_low + (p_clock->i_high - p_clock->i_low) / 2;
+    return (i_stc + i_offset) / 27;
+}
+
+/*****************************************************************************
+ * dvbpsi_clock_utc
+ *****************************************************************************/
+int64_t dvbpsi_clock_utc(const dvbpsi_clock_t *p_clock, uint64_t i_packet)
+{
+    assert(p_clock);
+    return dvbpsi_clock_utc_at(p_clock, dvbpsi_clock_stc(p_clock, i_packet));
+}
+
+/*****************************************************************************
+ * dvbpsi_clock_utc_pts
+ *****************************************************************************/
+int64_t dvbpsi_clock_utc_pts(const dvbpsi_clock_t *p_clock, uint64_t i_pts)
+{
+    assert(p_clock);
+
+    int64_t i_stc = p_clock->i_stc
+                  + dvbpsi_clock_wrap((int64_t)(i_pts % (UINT64_C(1) << 33)) * 300
+                                      - p_clock->i_pcr);
+    return dvbpsi_clock_utc_at(p_clock, i_stc);
+}
+
+/*****************************************************************************
+ * dvbpsi_clock_accuracy
+ *****************************************************************************/
+int64_t dvbpsi_clock_accuracy(const dvbpsi_clock_t *p_clock)
+{
+    assert(p_clock);
+
+    if (!p_clock->b_anchor)
+        return DVBPSI_TIME_NONE;
+    return (p_clock->i_high - p_clock->i_low) / 2 / 27;
+}
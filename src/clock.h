@@ -0,0 +1,165 @@
+/*****************************************************************************
+ * clock.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <clock.h>
+ * \brief Broadcast time of a transport stream.
+ *
+ * A clock follows the system time clock of a reference program through its
+ * PCRs, as given by dvbpsi_pcrs_scan() or dvbpsi_adaptation_parse(), and
+ * anchors to it the UTC_time of the TDTs and TOTs of the stream. The
+ * broadcast time of any packet, or of any PTS of the program, is then the
+ * system time clock at that point, interpolated between the PCRs from the
+ * packet count, plus the offset of the anchors.
+ *
+ * A UTC_time has a one second granularity: it is taken to be the time of
+ * its section truncated to the second, so that each anchor bounds the
+ * offset within a second. The bounds of the successive anchors are
+ * intersected, and as the sections come at various points of their second,
+ * the offset gets to within a few milliseconds after some tens of TDTs. An
+ * anchor out of the bounds, after a change of the UTC time or a drift of
+ * the system time clock, restarts them from that anchor.
+ *
+ * Packets are identified by their index in the stream, counted by the
+ * caller from any origin. A PCR discontinuity keeps the clock going from
+ * the time extrapolated at the packet of the new time base, and so keeps
+ * the anchors.
+ */
+
+#ifndef _DVBPSI_CLOCK_H_
+#define _DVBPSI_CLOCK_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_clock_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_clock_s dvbpsi_clock_t
+ * \brief dvbpsi_clock_t type definition, an opaque broadcast time clock.
+ */
+typedef struct dvbpsi_clock_s dvbpsi_clock_t;
+
+/*****************************************************************************
+ * dvbpsi_clock_new/dvbpsi_clock_delete
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_clock_t *dvbpsi_clock_new(void)
+ * \brief Creates a clock without any PCR nor anchor yet
+ * \return the new clock, NULL on error.
+ */
+dvbpsi_clock_t *dvbpsi_clock_new(void);
+
+/*!
+ * \fn void dvbpsi_clock_delete(dvbpsi_clock_t *p_clock)
+ * \brief Deletes a clock
+ * \param p_clock clock, or NULL
+ * \return nothing.
+ */
+void dvbpsi_clock_delete(dvbpsi_clock_t *p_clock);
+
+/*****************************************************************************
+ * dvbpsi_clock_pcr
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_clock_pcr(dvbpsi_clock_t *p_clock, uint64_t i_pcr,
+ *                           bool b_discontinuity, uint64_t i_packet)
+ * \brief Follows the system time clock of the reference program with a PCR
+ * \param p_clock clock
+ * \param i_pcr PCR in 27 MHz units, as given by dvbpsi_pcrs_scan()
+ * \param b_discontinuity discontinuity_indicator of the packet
+ * \param i_packet index of the packet in the stream
+ * \return nothing.
+ *
+ * The packets between two PCRs are put on the system time clock at the
+ * rate of the last two PCRs. A PCR more than a second away from the clock
+ * extrapolated at its packet is taken as a discontinuity, as is a packet
+ * index going backwards.
+ */
+void dvbpsi_clock_pcr(dvbpsi_clock_t *p_clock, uint64_t i_pcr, bool b_discontinuity,
+                      uint64_t i_packet);
+
+/*****************************************************************************
+ * dvbpsi_clock_tdt
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_clock_tdt(dvbpsi_clock_t *p_clock, const dvbpsi_tot_t *p_tot,
+ *                           uint64_t i_packet)
+ * \brief Anchors the UTC_time of a TDT or a TOT to the system time clock
+ * \param p_clock clock
+ * \param p_tot TDT or TOT, as given to the callback of dvbpsi_tot_attach()
+ * \param i_packet index of the last packet of its section, the one pushed
+ *        when the callback is called
+ * \return false if the clock has no PCR yet or the UTC_time is undefined,
+ *         true otherwise.
+ */
+bool dvbpsi_clock_tdt(dvbpsi_clock_t *p_clock, const dvbpsi_tot_t *p_tot,
+                      uint64_t i_packet);
+
+/*****************************************************************************
+ * dvbpsi_clock_utc/dvbpsi_clock_utc_pts
+ *****************************************************************************/
+/*!
+ * \fn int64_t dvbpsi_clock_utc(const dvbpsi_clock_t *p_clock, uint64_t i_packet)
+ * \brief Gets the broadcast time of a packet
+ * \param p_clock clock
+ * \param i_packet index of the packet in the stream
+ * \return the time in microseconds since 1970-01-01 UTC, DVBPSI_TIME_NONE
+ *         without PCR or anchor. The cost is a few multiplications.
+ */
+int64_t dvbpsi_clock_utc(const dvbpsi_clock_t *p_clock, uint64_t i_packet);
+
+/*!
+ * \fn int64_t dvbpsi_clock_utc_pts(const dvbpsi_clock_t *p_clock, uint64_t i_pts)
+ * \brief Gets the broadcast time of a PTS of the reference program
+ * \param p_clock clock
+ * \param i_pts PTS, or pts_time, in 90 kHz units
+ * \return the time in microseconds since 1970-01-01 UTC, DVBPSI_TIME_NONE
+ *         without PCR or anchor.
+ *
+ * The PTS is taken on the time base of the last PCR, within 13 hours of
+ * it.
+ */
+int64_t dvbpsi_clock_utc_pts(const dvbpsi_clock_t *p_clock, uint64_t i_pts);
+
+/*****************************************************************************
+ * dvbpsi_clock_accuracy
+ *****************************************************************************/
+/*!
+ * \fn int64_t dvbpsi_clock_accuracy(const dvbpsi_clock_t *p_clock)
+ * \brief Gets the accuracy of the broadcast time of a clock
+ * \param p_clock clock
+ * \return the largest error in microseconds of the times given by the
+ *         clock, half the width of the bounds of its anchors, or
+ *         DVBPSI_TIME_NONE without anchor.
+ */
+int64_t dvbpsi_clock_accuracy(const dvbpsi_clock_t *p_clock);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of clock.h"
+#endif
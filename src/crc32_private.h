@@ -0,0 +1,89 @@
+/*****************************************************************************
+ * crc32_private.h: CRC_32 engine
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2012 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#ifndef _DVBPSI_CRC32_PRIVATE_H_
+#define _DVBPSI_CRC32_PRIVATE_H_
+
+/*****************************************************************************
+ * dvbpsi_crc32_kernel_t
+ *****************************************************************************
+ * Every kernel computes the MPEG-2 CRC_32 (polynomial 0x04c11db7, MSB first,
+ * no final xor) of i_length bytes at p_data, continuing from register i_crc.
+ * Start with 0xffffffff; running over a section including its CRC_32 field
+ * yields 0 when the section is valid.
+ *****************************************************************************/
+typedef uint32_t (*dvbpsi_crc32_kernel_t)(uint32_t i_crc, const uint8_t *p_data,
+                                          size_t i_length);
+
+/*****************************************************************************
+ * dvbpsi_crc32_impl
+ *****************************************************************************/
+enum dvbpsi_crc32_impl
+{
+    DVBPSI_CRC32_BYTE = 0,  /*!< byte per byte, one 256-entry table */
+    DVBPSI_CRC32_SLICE8,    /*!< slicing-by-8, portable */
+    DVBPSI_CRC32_PCLMUL,    /*!< x86 carry-less multiply folding */
+    DVBPSI_CRC32_IMPL_MAX
+};
+
+/*****************************************************************************
+ * dvbpsi_crc32_init
+ *****************************************************************************
+ * Selects the fastest kernel supported by the running CPU. Called from
+ * dvbpsi_new(), safe to call any number of times from any thread.
+ *****************************************************************************/
+void dvbpsi_crc32_init(void);
+
+/*****************************************************************************
+ * dvbpsi_crc32
+ *****************************************************************************
+ * Runs the selected kernel (selecting it first if needed).
+ *****************************************************************************/
+uint32_t dvbpsi_crc32(uint32_t i_crc, const uint8_t *p_data, size_t i_length);
+
+/*****************************************************************************
+ * dvbpsi_crc32_patch
+ *****************************************************************************
+ * CRC_32 of i_length bytes whose CRC_32 was i_crc before the i_count bytes
+ * at i_offset were xored with p_xor, in O(i_count + log i_length).
+ *****************************************************************************/
+uint32_t dvbpsi_crc32_patch(uint32_t i_crc, size_t i_length, size_t i_offset,
+                            const uint8_t *p_xor, size_t i_count);
+
+/*****************************************************************************
+ * dvbpsi_crc32_kernel
+ *****************************************************************************
+ * Returns the given kernel, or NULL when this build or CPU cannot run it.
+ * Used by misc/bench_crc to compare kernels against each other.
+ *****************************************************************************/
+dvbpsi_crc32_kernel_t dvbpsi_crc32_kernel(enum dvbpsi_crc32_impl impl);
+
+/*****************************************************************************
+ * dvbpsi_crc32_name
+ *****************************************************************************/
+const char *dvbpsi_crc32_name(enum dvbpsi_crc32_impl impl);
+
+#else
+#error "Multiple inclusions of crc32_private.h"
+#endif
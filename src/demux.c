@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 
 #if defined(HAVE_INTTYPES_H)
 #include <inttypes.h>
@@ -40,10 +41,61 @@
 #include <assert.h>
 
 #include "dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODER
 #include "dvbpsi_private.h"
 #include "psi.h"
 #include "demux.h"
 
+/* Initial number of index buckets, doubled as subtable decoders are added */
+#define DVBPSI_DEMUX_INDEX_BITS 6
+
+/*****************************************************************************
+ * dvbpsi_demux_bucket
+ *****************************************************************************
+ * Index bucket of a subtable id.
+ *****************************************************************************/
+static inline unsigned int dvbpsi_demux_bucket(const dvbpsi_demux_t *p_demux,
+                                               uint32_t i_id)
+{
+    return (uint32_t)(i_id * UINT32_C(2654435761)) >> (32 - p_demux->i_index_bits);
+}
+
+/*****************************************************************************
+ * dvbpsi_demux_index_grow
+ *****************************************************************************
+ * Doubles the index once there are more subtable decoders than buckets. The
+ * index keeps working with longer chains if this fails.
+ *****************************************************************************/
+static void dvbpsi_demux_index_grow(dvbpsi_demux_t *p_demux)
+{
+    unsigned int i_old_size = 1u << p_demux->i_index_bits;
+    if (p_demux->i_subdecs <= i_old_size || p_demux->i_index_bits >= 24)
+        return;
+
+    dvbpsi_demux_subdec_t **pp_index = dvbpsi_calloc(2 * i_old_size,
+                                              sizeof(dvbpsi_demux_subdec_t *));
+    if (pp_index == NULL)
+        return;
+
+    dvbpsi_demux_subdec_t **pp_old = p_demux->pp_subdec_index;
+    p_demux->pp_subdec_index = pp_index;
+    p_demux->i_index_bits++;
+
+    for (unsigned int i = 0; i < i_old_size; i++)
+    {
+        dvbpsi_demux_subdec_t *p_subdec = pp_old[i];
+        while (p_subdec)
+        {
+            dvbpsi_demux_subdec_t *p_next = p_subdec->p_hash_next;
+            unsigned int i_bucket = dvbpsi_demux_bucket(p_demux, p_subdec->i_id);
+            p_subdec->p_hash_next = pp_index[i_bucket];
+            pp_index[i_bucket] = p_subdec;
+            p_subdec = p_next;
+        }
+    }
+    dvbpsi_free(pp_old);
+}
+
 /*****************************************************************************
  * dvbpsi_AttachDemux
  *****************************************************************************
@@ -64,13 +116,137 @@ bool dvbpsi_AttachDemux(dvbpsi_t *            p_dvbpsi,
 
     /* Subtables demux configuration */
     p_demux->p_first_subdec = NULL;
+    p_demux->i_index_bits = DVBPSI_DEMUX_INDEX_BITS;
+    p_demux->i_subdecs = 0;
+    p_demux->pp_subdec_index = dvbpsi_calloc(1u << DVBPSI_DEMUX_INDEX_BITS,
+                                      sizeof(dvbpsi_demux_subdec_t *));
+    if (p_demux->pp_subdec_index == NULL)
+    {
+        dvbpsi_decoder_delete(DVBPSI_DECODER(p_demux));
+        return false;
+    }
     p_demux->pf_new_callback = pf_new_cb;
     p_demux->p_new_cb_data = p_new_cb_data;
+    p_demux->i_budget = 0;
+    p_demux->i_ttl = 0;
+    p_demux->i_sequence = 0;
 
     p_dvbpsi->p_decoder = DVBPSI_DECODER(p_demux);
     return true;
 }
 
+/*****************************************************************************
+ * dvbpsi_demux_set_limits
+ *****************************************************************************/
+void dvbpsi_demux_set_limits(dvbpsi_t *p_dvbpsi, size_t i_budget, int64_t i_ttl)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    dvbpsi_demux_t *p_demux = (dvbpsi_demux_t *)p_dvbpsi->p_decoder;
+    p_demux->i_budget = i_budget;
+    p_demux->i_ttl = (i_ttl > 0) ? i_ttl : 0;
+}
+
+/*****************************************************************************
+ * dvbpsi_demux_sections_bytes, dvbpsi_demux_subdec_bytes
+ *****************************************************************************
+ * Bytes of a list of sections, and of those a subtable decoder holds.
+ *****************************************************************************/
+static size_t dvbpsi_demux_sections_bytes(const dvbpsi_psi_section_t *p_section)
+{
+    size_t i_bytes = 0;
+    for (; p_section; p_section = p_section->p_next)
+        i_bytes += sizeof(dvbpsi_psi_section_t) + p_section->i_max_size;
+    return i_bytes;
+}
+
+static size_t dvbpsi_demux_subdec_bytes(const dvbpsi_demux_subdec_t *p_subdec)
+{
+    const dvbpsi_decoder_t *p_decoder = p_subdec->p_decoder;
+    if (p_decoder == NULL)
+        return 0;
+    return dvbpsi_demux_sections_bytes(p_decoder->p_sections) +
+           dvbpsi_demux_sections_bytes(p_decoder->p_last_sections);
+}
+
+/*****************************************************************************
+ * dvbpsi_demux_evict
+ *****************************************************************************
+ * Detaches a subtable decoder as its own detach function does.
+ *****************************************************************************/
+static void dvbpsi_demux_evict(dvbpsi_t *p_dvbpsi, dvbpsi_demux_subdec_t *p_subdec)
+{
+    uint8_t i_table_id = (p_subdec->i_id >> 16) & 0xFF;
+    uint16_t i_extension = p_subdec->i_id & 0xFFFF;
+
+    dvbpsi_debug(p_dvbpsi, "demux", "detaching subtable decoder %02x/%04x",
+                 i_table_id, i_extension);
+    p_subdec->pf_detach(p_dvbpsi, i_table_id, i_extension);
+}
+
+/*****************************************************************************
+ * dvbpsi_demux_sweep
+ *****************************************************************************
+ * Detaches the idle subtable decoders, then the least recently completed
+ * ones holding sections while over budget, EIT schedule ones first. Only the
+ * ones of the new subtable callback, which attaches them anew, are detached.
+ *****************************************************************************/
+static void dvbpsi_demux_sweep(dvbpsi_t *p_dvbpsi, dvbpsi_demux_t *p_demux)
+{
+    int64_t i_now = p_dvbpsi->i_time;
+    size_t i_bytes = 0;
+
+    dvbpsi_demux_subdec_t *p_subdec = p_demux->p_first_subdec;
+    while (p_subdec)
+    {
+        dvbpsi_demux_subdec_t *p_next = p_subdec->p_next;
+        if (p_subdec->b_evictable &&
+            (p_demux->i_ttl > 0) && (i_now != DVBPSI_TIME_NONE) &&
+            (p_subdec->i_fed != DVBPSI_TIME_NONE) &&
+            (i_now - p_subdec->i_fed > p_demux->i_ttl))
+        {
+            dvbpsi_demux_evict(p_dvbpsi, p_subdec);
+            p_dvbpsi->stats.i_subdecs_expired++;
+        }
+        else
+            i_bytes += dvbpsi_demux_subdec_bytes(p_subdec);
+        p_subdec = p_next;
+    }
+
+    while ((p_demux->i_budget > 0) && (i_bytes > p_demux->i_budget))
+    {
+        dvbpsi_demux_subdec_t *p_victim = NULL;
+        bool b_victim_schedule = false;
+        size_t i_victim = 0;
+        for (p_subdec = p_demux->p_first_subdec; p_subdec; p_subdec = p_subdec->p_next)
+        {
+            if (!p_subdec->b_evictable)
+                continue;
+            uint8_t i_table_id = (p_subdec->i_id >> 16) & 0xFF;
+            bool b_schedule = (i_table_id >= 0x50) && (i_table_id <= 0x6f);
+            if (p_victim && (b_victim_schedule && !b_schedule))
+                continue;
+            if (p_victim && (b_schedule == b_victim_schedule) &&
+                (p_subdec->i_completed >= p_victim->i_completed))
+                continue;
+            /* detaching one holding nothing would not free anything */
+            size_t i_subdec = dvbpsi_demux_subdec_bytes(p_subdec);
+            if (i_subdec == 0)
+                continue;
+            p_victim = p_subdec;
+            b_victim_schedule = b_schedule;
+            i_victim = i_subdec;
+        }
+        if (p_victim == NULL)
+            break;
+
+        dvbpsi_demux_evict(p_dvbpsi, p_victim);
+        p_dvbpsi->stats.i_subdecs_evicted++;
+        i_bytes = (i_bytes > i_victim) ? i_bytes - i_victim : 0;
+    }
+}
+
 /*****************************************************************************
  * dvbpsi_demuxGetSubDec
  *****************************************************************************
@@ -81,14 +257,15 @@ dvbpsi_demux_subdec_t * dvbpsi_demuxGetSubDec(dvbpsi_demux_t * p_demux,
                                               uint16_t i_extension)
 {
     uint32_t i_id = (uint32_t)i_table_id << 16 |(uint32_t)i_extension;
-    dvbpsi_demux_subdec_t * p_subdec = p_demux->p_first_subdec;
+    dvbpsi_demux_subdec_t * p_subdec
+            = p_demux->pp_subdec_index[dvbpsi_demux_bucket(p_demux, i_id)];
 
     while (p_subdec)
     {
         if (p_subdec->i_id == i_id)
             break;
 
-        p_subdec = p_subdec->p_next;
+        p_subdec = p_subdec->p_hash_next;
     }
 
     return p_subdec;
@@ -111,18 +288,34 @@ void dvbpsi_Demux(dvbpsi_t *p_dvbpsi, dvbpsi_psi_section_t *p_section)
     {
         /* Tell the application we found a new subtable, so that it may attach a
          * subtable decoder */
+        dvbpsi_probe_callback_entry("demux_new", p_section->i_table_id, p_section->i_extension);
         p_demux->pf_new_callback(p_dvbpsi, p_section->i_table_id, p_section->i_extension,
                                  p_demux->p_new_cb_data);
+        dvbpsi_probe_callback_exit("demux_new", p_section->i_table_id, p_section->i_extension);
 
-        /* Check if a new subtable decoder is available */
+        /* Check if a new subtable decoder is available, the callback
+         * attaching it anew once detached by the limits */
         p_subdec = dvbpsi_demuxGetSubDec(p_demux, p_section->i_table_id,
                                          p_section->i_extension);
+        if (p_subdec)
+            p_subdec->b_evictable = true;
     }
 
+    p_demux->i_sequence++;
     if (p_subdec)
+    {
+        uint64_t i_tables = p_dvbpsi->stats.i_tables;
+        p_subdec->i_fed = p_dvbpsi->i_time;
         p_subdec->pf_gather(p_dvbpsi, p_subdec->p_decoder, p_section);
+        if (p_dvbpsi->stats.i_tables != i_tables)
+            p_subdec->i_completed = p_demux->i_sequence;
+    }
     else
         dvbpsi_DeletePSISections(p_section);
+
+    if (((p_demux->i_budget > 0) || (p_demux->i_ttl > 0)) &&
+        (p_demux->i_sequence % DVBPSI_DEMUX_SWEEP == 0))
+        dvbpsi_demux_sweep(p_dvbpsi, p_demux);
 }
 
 /*****************************************************************************
@@ -146,9 +339,10 @@ void dvbpsi_DetachDemux(dvbpsi_t *p_dvbpsi)
         if (p_subdec_temp->pf_detach)
             p_subdec_temp->pf_detach(p_dvbpsi, (p_subdec_temp->i_id >> 16) & 0xFFFF,
                                      p_subdec_temp->i_id & 0xFFFF);
-        else free(p_subdec_temp);
+        else dvbpsi_free(p_subdec_temp);
     }
 
+    dvbpsi_free(p_demux->pp_subdec_index);
     dvbpsi_decoder_delete(p_dvbpsi->p_decoder);
     p_dvbpsi->p_decoder = NULL;
 }
@@ -167,7 +361,15 @@ dvbpsi_demux_subdec_t *dvbpsi_NewDemuxSubDecoder(const uint8_t i_table_id,
     assert(pf_gather);
     assert(pf_detach);
 
-    dvbpsi_demux_subdec_t *p_subdec = calloc(1, sizeof(dvbpsi_demux_subdec_t));
+    dvbpsi_demux_subdec_t *p_subdec = dvbpsi_pool_take(DVBPSI_POOL_BLOCK,
+                                                       sizeof(dvbpsi_demux_subdec_t));
+    if (p_subdec)
+    {
+        dvbpsi_mem_tag(p_subdec, DVBPSI_MEM_CATEGORY);
+        memset(p_subdec, 0, sizeof(dvbpsi_demux_subdec_t));
+    }
+    else
+        p_subdec = dvbpsi_calloc(1, sizeof(dvbpsi_demux_subdec_t));
     if (p_subdec == NULL)
         return NULL;
 
@@ -178,6 +380,7 @@ dvbpsi_demux_subdec_t *dvbpsi_NewDemuxSubDecoder(const uint8_t i_table_id,
     p_subdec->p_decoder = p_decoder;
     p_subdec->pf_gather = pf_gather;
     p_subdec->pf_detach = pf_detach;
+    p_subdec->i_fed = DVBPSI_TIME_NONE;
 
     return p_subdec;
 }
@@ -193,7 +396,8 @@ void dvbpsi_DeleteDemuxSubDecoder(dvbpsi_demux_subdec_t *p_subdec)
         return;
     /* FIXME: find a saner way to release private decoder resources */
     dvbpsi_decoder_delete(p_subdec->p_decoder);
-    free(p_subdec);
+    if (!dvbpsi_pool_give(DVBPSI_POOL_BLOCK, p_subdec, sizeof(dvbpsi_demux_subdec_t)))
+        dvbpsi_free(p_subdec);
     p_subdec = NULL;
 }
 
@@ -208,8 +412,21 @@ void dvbpsi_AttachDemuxSubDecoder(dvbpsi_demux_t *p_demux, dvbpsi_demux_subdec_t
     if (!p_demux || !p_subdec)
         abort();
 
+    p_subdec->p_prev = NULL;
     p_subdec->p_next = p_demux->p_first_subdec;
+    if (p_subdec->p_next)
+        p_subdec->p_next->p_prev = p_subdec;
     p_demux->p_first_subdec = p_subdec;
+
+    unsigned int i_bucket = dvbpsi_demux_bucket(p_demux, p_subdec->i_id);
+    p_subdec->p_hash_next = p_demux->pp_subdec_index[i_bucket];
+    p_demux->pp_subdec_index[i_bucket] = p_subdec;
+
+    /* ranked as if it had just completed, not evicted while it gathers */
+    p_subdec->i_completed = p_demux->i_sequence;
+
+    p_demux->i_subdecs++;
+    dvbpsi_demux_index_grow(p_demux);
 }
 
 /*****************************************************************************
@@ -225,10 +442,19 @@ void dvbpsi_DetachDemuxSubDecoder(dvbpsi_demux_t *p_demux, dvbpsi_demux_subdec_t
 
     assert(p_demux->p_first_subdec);
 
+    if (p_subdec->p_prev)
+        p_subdec->p_prev->p_next = p_subdec->p_next;
+    else
+        p_demux->p_first_subdec = p_subdec->p_next;
+    if (p_subdec->p_next)
+        p_subdec->p_next->p_prev = p_subdec->p_prev;
+
     dvbpsi_demux_subdec_t** pp_prev_subdec;
-    pp_prev_subdec = &p_demux->p_first_subdec;
+    pp_prev_subdec = &p_demux->pp_subdec_index[dvbpsi_demux_bucket(p_demux, p_subdec->i_id)];
     while(*pp_prev_subdec != p_subdec)
-        pp_prev_subdec = &(*pp_prev_subdec)->p_next;
+        pp_prev_subdec = &(*pp_prev_subdec)->p_hash_next;
 
-    *pp_prev_subdec = p_subdec->p_next;
+    *pp_prev_subdec = p_subdec->p_hash_next;
+    p_subdec->p_next = p_subdec->p_prev = p_subdec->p_hash_next = NULL;
+    p_demux->i_subdecs--;
 }
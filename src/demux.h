@@ -90,6 +90,10 @@ typedef void (*dvbpsi_demux_detach_cb_t) (dvbpsi_t *p_dvbpsi,    /*!< pointer to
 typedef struct dvbpsi_demux_subdec_s
 {
   uint32_t                      i_id;      /*!< subtable id */
+  bool                          b_evictable; /*!< private, attached by the new
+                                                subtable callback, so that
+                                                dvbpsi_demux_set_limits() may
+                                                detach it */
 
   dvbpsi_demux_gather_cb_t      pf_gather; /*!< gather subdec callback */
   dvbpsi_decoder_t             *p_decoder; /*!< private decoder for this subdec */
@@ -97,6 +101,15 @@ typedef struct dvbpsi_demux_subdec_s
   dvbpsi_demux_detach_cb_t      pf_detach; /*!< detach subdec callback */
 
   struct dvbpsi_demux_subdec_s *p_next;    /*!< next subdec */
+
+  struct dvbpsi_demux_subdec_s *p_prev;    /*!< private, previous subdec */
+  struct dvbpsi_demux_subdec_s *p_hash_next; /*!< private, next subdec in
+                                                the same index bucket */
+
+  int64_t                       i_fed;      /*!< private, arrival time of its
+                                                last section */
+  uint64_t                      i_completed; /*!< private, demux sequence of
+                                                its last complete table */
 } dvbpsi_demux_subdec_t;
 
 
@@ -122,10 +135,26 @@ struct dvbpsi_demux_s
 
     dvbpsi_demux_subdec_t *   p_first_subdec;     /*!< First subtable decoder */
 
+    /* Subtable decoders index */
+    dvbpsi_demux_subdec_t **  pp_subdec_index;    /*!< private, hash buckets
+                                                     of the subtable decoders */
+    unsigned int              i_index_bits;       /*!< private, log2 of the
+                                                     number of buckets */
+    unsigned int              i_subdecs;          /*!< private, number of
+                                                     subtable decoders */
+
     /* New subtable callback */
     dvbpsi_demux_new_cb_t     pf_new_callback;    /*!< New subtable callback */
     void *                    p_new_cb_data;      /*!< Data provided to the
                                                      previous callback */
+
+    /* Limits, see dvbpsi_demux_set_limits() */
+    size_t                    i_budget;           /*!< private, bytes of
+                                                     sections, 0 for none */
+    int64_t                   i_ttl;              /*!< private, idle time of
+                                                     a subdec, 0 for none */
+    uint64_t                  i_sequence;         /*!< private, sections
+                                                     demultiplexed */
 };
 
 /*****************************************************************************
@@ -154,6 +183,43 @@ bool dvbpsi_AttachDemux(dvbpsi_t *            p_dvbpsi,
  */
 void dvbpsi_DetachDemux(dvbpsi_t *p_dvbpsi);
 
+/*****************************************************************************
+ * dvbpsi_demux_set_limits
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_demux_set_limits(dvbpsi_t *p_dvbpsi, size_t i_budget,
+ *                                  int64_t i_ttl)
+ * \brief Bounds the memory of the subtable decoders of a demux
+ * \param p_dvbpsi handle of the demux
+ * \param i_budget bytes of sections the subtable decoders may hold, 0 for
+ *        no limit, the default
+ * \param i_ttl time after which a subtable decoder given no section is
+ *        detached, in the unit of dvbpsi_packet_push_at(), 0 for never, the
+ *        default
+ * \return nothing
+ *
+ * The subtable decoders are checked every DVBPSI_DEMUX_SWEEP sections. Only
+ * the ones the new subtable callback attached for the section it was called
+ * for are detached, those attached otherwise, such as by a dvbpsi_fanout_t or
+ * a dvbpsi_observer_demux_attach(), having an owner which would not attach
+ * them anew. Those fed nothing for i_ttl are detached, which needs the
+ * sections to come with an arrival time. The bytes are those of the sections
+ * each subtable decoder gathers towards its next table, and of
+ * DVBPSI_FLAG_LAST_SECTIONS. While they go over i_budget the subtable decoder
+ * holding some of them whose last table completed least recently is
+ * detached, the EIT schedule ones, table_id 0x50 to 0x6f, first. Detached
+ * subtable decoders are counted in dvbpsi_stats_t::i_subdecs_expired and
+ * dvbpsi_stats_t::i_subdecs_evicted, and the new subtable callback is called
+ * again on their next section, so that one is attached anew.
+ */
+void dvbpsi_demux_set_limits(dvbpsi_t *p_dvbpsi, size_t i_budget, int64_t i_ttl);
+
+/*!
+ * \def DVBPSI_DEMUX_SWEEP
+ * \brief Sections between two checks of dvbpsi_demux_set_limits()
+ */
+#define DVBPSI_DEMUX_SWEEP 256
+
 /*****************************************************************************
  * dvbpsi_demuxGetSubDec
  *****************************************************************************/
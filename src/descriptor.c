@@ -28,6 +28,7 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <string.h>
 
 #if defined(HAVE_INTTYPES_H)
@@ -39,6 +40,9 @@
 #include <assert.h>
 
 #include "dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DESCRIPTOR
+#include "dvbpsi_private.h"
+#include "psi.h"
 #include "descriptor.h"
 
 /*****************************************************************************
@@ -77,6 +81,134 @@ bool dvbpsi_CanDecodeAsDescriptor(dvbpsi_descriptor_t *p_descriptor, const uint8
     return true;
 }
 
+/*****************************************************************************
+ * Descriptor interning
+ *****************************************************************************
+ * While an intern table is entered, dvbpsi_NewDescriptor() points the
+ * content of descriptors to a shared, reference counted block looked up by
+ * tag, length and content. The table only indexes the blocks, they are
+ * freed with their last descriptor.
+ *****************************************************************************/
+#define DVBPSI_INTERN_BUCKETS 256
+
+typedef struct dvbpsi_descriptor_shared_s
+{
+    struct dvbpsi_descriptor_shared_s *p_next;  /* in the intern table */
+    uint32_t                           i_hash;
+    unsigned int                       i_refcount;
+    uint8_t                            i_tag;
+    uint8_t                            i_length;
+    uint8_t                            p_data[];
+} dvbpsi_descriptor_shared_t;
+
+struct dvbpsi_intern_s
+{
+    dvbpsi_descriptor_shared_t *p_buckets[DVBPSI_INTERN_BUCKETS];
+};
+
+#if defined(HAVE_THREAD_LOCAL)
+static __thread dvbpsi_intern_t *dvbpsi_intern_current = NULL;
+#else
+/* Without thread local storage no intern table is ever entered */
+static dvbpsi_intern_t * const dvbpsi_intern_current = NULL;
+#endif
+
+/*****************************************************************************
+ * dvbpsi_intern_new
+ *****************************************************************************/
+dvbpsi_intern_t *dvbpsi_intern_new(const dvbpsi_t *p_dvbpsi)
+{
+#if defined(HAVE_THREAD_LOCAL)
+    if (!(p_dvbpsi->i_flags & DVBPSI_FLAG_INTERN_DESCRIPTORS))
+        return NULL;
+
+    /* The index does not belong to the table being built */
+    dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(NULL);
+    dvbpsi_intern_t *p_intern = dvbpsi_calloc(1, sizeof(dvbpsi_intern_t));
+    dvbpsi_arena_leave(p_previous);
+    return p_intern;
+#else
+    (void)p_dvbpsi;
+    return NULL;
+#endif
+}
+
+/*****************************************************************************
+ * dvbpsi_intern_delete
+ *****************************************************************************/
+void dvbpsi_intern_delete(dvbpsi_intern_t *p_intern)
+{
+    dvbpsi_free(p_intern);
+}
+
+/*****************************************************************************
+ * dvbpsi_intern_enter
+ *****************************************************************************/
+dvbpsi_intern_t *dvbpsi_intern_enter(dvbpsi_intern_t *p_intern)
+{
+#if defined(HAVE_THREAD_LOCAL)
+    dvbpsi_intern_t *p_previous = dvbpsi_intern_current;
+    dvbpsi_intern_current = p_intern;
+    return p_previous;
+#else
+    assert(p_intern == NULL);
+    return NULL;
+#endif
+}
+
+/*****************************************************************************
+ * dvbpsi_intern_get
+ *****************************************************************************
+ * Shared block holding the given content, with one more reference.
+ *****************************************************************************/
+static uint8_t *dvbpsi_intern_get(dvbpsi_intern_t *p_intern, uint8_t i_tag,
+                                  uint8_t i_length, const uint8_t *p_data)
+{
+    uint32_t i_hash = 2166136261u;
+    i_hash = (i_hash ^ i_tag) * 16777619u;
+    i_hash = (i_hash ^ i_length) * 16777619u;
+    for (int i = 0; i < i_length; i++)
+        i_hash = (i_hash ^ p_data[i]) * 16777619u;
+
+    dvbpsi_descriptor_shared_t **pp_bucket = &p_intern->p_buckets[i_hash % DVBPSI_INTERN_BUCKETS];
+    dvbpsi_descriptor_shared_t *p_shared = *pp_bucket;
+    while (p_shared && (p_shared->i_hash != i_hash || p_shared->i_tag != i_tag
+                        || p_shared->i_length != i_length
+                        || memcmp(p_shared->p_data, p_data, i_length)))
+        p_shared = p_shared->p_next;
+
+    if (p_shared == NULL)
+    {
+        p_shared = dvbpsi_malloc(sizeof(dvbpsi_descriptor_shared_t) + i_length);
+        if (p_shared == NULL)
+            return NULL;
+        p_shared->i_hash = i_hash;
+        p_shared->i_refcount = 0;
+        p_shared->i_tag = i_tag;
+        p_shared->i_length = i_length;
+        memcpy(p_shared->p_data, p_data, i_length);
+        p_shared->p_next = *pp_bucket;
+        *pp_bucket = p_shared;
+    }
+
+    p_shared->i_refcount++;
+    return p_shared->p_data;
+}
+
+/*****************************************************************************
+ * dvbpsi_intern_release
+ *****************************************************************************
+ * Drops a reference to the shared block of p_data.
+ *****************************************************************************/
+static void dvbpsi_intern_release(uint8_t *p_data)
+{
+    dvbpsi_descriptor_shared_t *p_shared = (dvbpsi_descriptor_shared_t *)
+                (p_data - offsetof(dvbpsi_descriptor_shared_t, p_data));
+    assert(p_shared->i_refcount > 0);
+    if (--p_shared->i_refcount == 0)
+        dvbpsi_free(p_shared);
+}
+
 /*****************************************************************************
  * dvbpsi_NewDescriptor
  *****************************************************************************
@@ -85,28 +217,126 @@ bool dvbpsi_CanDecodeAsDescriptor(dvbpsi_descriptor_t *p_descriptor, const uint8
 dvbpsi_descriptor_t* dvbpsi_NewDescriptor(uint8_t i_tag, uint8_t i_length,
                                           uint8_t* p_data)
 {
-    dvbpsi_descriptor_t* p_descriptor
-                = (dvbpsi_descriptor_t*)malloc(sizeof(dvbpsi_descriptor_t));
-
-    if (p_descriptor == NULL)
-        return NULL;
+    dvbpsi_descriptor_t* p_descriptor;
 
-    p_descriptor->p_data = (uint8_t*)malloc(i_length * sizeof(uint8_t));
-    if (p_descriptor->p_data)
+    if (p_data && dvbpsi_intern_current)
+    {
+        /* Share the content with identical descriptors */
+        p_descriptor = (dvbpsi_descriptor_t*)dvbpsi_malloc(sizeof(dvbpsi_descriptor_t));
+        if (p_descriptor == NULL)
+            return NULL;
+        p_descriptor->p_data = dvbpsi_intern_get(dvbpsi_intern_current,
+                                                 i_tag, i_length, p_data);
+        if (p_descriptor->p_data == NULL)
+        {
+            dvbpsi_free(p_descriptor);
+            return NULL;
+        }
+    }
+    else
     {
-        p_descriptor->i_tag = i_tag;
-        p_descriptor->i_length = i_length;
+        p_descriptor = (dvbpsi_descriptor_t*)dvbpsi_malloc(sizeof(dvbpsi_descriptor_t)
+                                                           + i_length * sizeof(uint8_t));
+        if (p_descriptor == NULL)
+            return NULL;
+
+        p_descriptor->p_data = p_descriptor->p_payload;
         if (p_data)
             memcpy(p_descriptor->p_data, p_data, i_length);
-        p_descriptor->p_decoded = NULL;
-        p_descriptor->p_next = NULL;
     }
-    else
+
+    p_descriptor->i_tag = i_tag;
+    p_descriptor->i_length = i_length;
+    p_descriptor->p_decoded = NULL;
+    p_descriptor->p_next = NULL;
+
+    return p_descriptor;
+}
+
+/*****************************************************************************
+ * Table arrays
+ *****************************************************************************
+ * A descriptor laid out in a span takes the room of one allocated by
+ * dvbpsi_NewDescriptor(), rounded up to keep the next one aligned.
+ *****************************************************************************/
+#define DVBPSI_ARRAYS_ROUND(x) (((x) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+#define DVBPSI_ARRAYS_DR_SIZE(i_length) \
+    DVBPSI_ARRAYS_ROUND(sizeof(dvbpsi_descriptor_t) + (i_length))
+
+/*****************************************************************************
+ * dvbpsi_arrays_span
+ *****************************************************************************/
+size_t dvbpsi_arrays_span(const uint8_t *p_byte, const uint8_t *p_end)
+{
+    size_t i_span = 0;
+    while (p_byte + 2 <= p_end)
     {
-        free(p_descriptor);
-        p_descriptor = NULL;
+        uint8_t i_length = p_byte[1];
+        if (i_length + 2 <= p_end - p_byte)
+            i_span += DVBPSI_ARRAYS_DR_SIZE(i_length);
+        p_byte += 2 + i_length;
     }
+    return i_span;
+}
+
+/*****************************************************************************
+ * dvbpsi_arrays_new
+ *****************************************************************************/
+bool dvbpsi_arrays_new(dvbpsi_arrays_t *p_arrays, dvbpsi_arena_t *p_arena,
+                       size_t i_entries, size_t i_entry_size, size_t i_span)
+{
+    memset(p_arrays, 0, sizeof(dvbpsi_arrays_t));
+    p_arrays->i_entry_size = DVBPSI_ARRAYS_ROUND(i_entry_size);
+    if (p_arena == NULL || (i_entries == 0 && i_span == 0))
+        return false;
+
+    if (i_entries > (SIZE_MAX - i_span) / p_arrays->i_entry_size)
+        return false;
+    size_t i_entries_size = i_entries * p_arrays->i_entry_size;
+    uint8_t *p_block = dvbpsi_arena_alloc(p_arena, i_entries_size + i_span);
+    if (p_block == NULL)
+        return false;
+
+    p_arrays->p_entry = p_block;
+    p_arrays->p_entries_end = p_block + i_entries_size;
+    p_arrays->p_span = p_arrays->p_entries_end;
+    p_arrays->p_span_end = p_arrays->p_span + i_span;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_arrays_entry
+ *****************************************************************************/
+void *dvbpsi_arrays_entry(dvbpsi_arrays_t *p_arrays)
+{
+    if (p_arrays->p_entry == p_arrays->p_entries_end)
+        return NULL;
+
+    void *p_entry = p_arrays->p_entry;
+    p_arrays->p_entry += p_arrays->i_entry_size;
+    return p_entry;
+}
+
+/*****************************************************************************
+ * dvbpsi_arrays_descriptor
+ *****************************************************************************/
+dvbpsi_descriptor_t *dvbpsi_arrays_descriptor(dvbpsi_arrays_t *p_arrays,
+                                              uint8_t i_tag, uint8_t i_length,
+                                              uint8_t *p_data)
+{
+    size_t i_size = DVBPSI_ARRAYS_DR_SIZE(i_length);
+    if ((size_t)(p_arrays->p_span_end - p_arrays->p_span) < i_size)
+        return dvbpsi_NewDescriptor(i_tag, i_length, p_data);
 
+    dvbpsi_descriptor_t *p_descriptor = (dvbpsi_descriptor_t *)p_arrays->p_span;
+    p_arrays->p_span += i_size;
+
+    p_descriptor->i_tag = i_tag;
+    p_descriptor->i_length = i_length;
+    p_descriptor->p_data = p_descriptor->p_payload;
+    memcpy(p_descriptor->p_data, p_data, i_length);
+    p_descriptor->p_decoded = NULL;
+    p_descriptor->p_next = NULL;
     return p_descriptor;
 }
 
@@ -132,6 +362,23 @@ dvbpsi_descriptor_t *dvbpsi_AddDescriptor(dvbpsi_descriptor_t *p_list,
     return p_list;
 }
 
+/*****************************************************************************
+ * dvbpsi_find_descriptor
+ *****************************************************************************
+ * First descriptor of 'p_list' with tag 'i_tag', if 'p_tags' has it.
+ *****************************************************************************/
+dvbpsi_descriptor_t *dvbpsi_find_descriptor(dvbpsi_descriptor_t *p_list,
+                                            const uint8_t *p_tags,
+                                            uint8_t i_tag)
+{
+    if (p_tags && !dvbpsi_has_descriptor(p_tags, i_tag))
+        return NULL;
+
+    while (p_list && p_list->i_tag != i_tag)
+        p_list = p_list->p_next;
+    return p_list;
+}
+
 /*****************************************************************************
  * dvbpsi_DeleteDescriptors
  *****************************************************************************
@@ -143,13 +390,13 @@ void dvbpsi_DeleteDescriptors(dvbpsi_descriptor_t* p_descriptor)
     {
         dvbpsi_descriptor_t* p_next = p_descriptor->p_next;
 
-        if (p_descriptor->p_data != NULL)
-            free(p_descriptor->p_data);
-
         if (p_descriptor->p_decoded != NULL)
-            free(p_descriptor->p_decoded);
+            dvbpsi_free(p_descriptor->p_decoded);
+
+        if (p_descriptor->p_data != p_descriptor->p_payload)
+            dvbpsi_intern_release(p_descriptor->p_data);
 
-        free(p_descriptor);
+        dvbpsi_free(p_descriptor);
         p_descriptor = p_next;
     }
 }
@@ -164,8 +411,312 @@ void *dvbpsi_DuplicateDecodedDescriptor(void *p_decoded, ssize_t i_size)
     if (!p_decoded)
         return NULL;
 
-    void *p_duplicate = calloc(1, i_size);
+    void *p_duplicate = dvbpsi_calloc_as(1, i_size, DVBPSI_MEM_DECODED_DR);
     if (p_duplicate)
         memcpy(p_duplicate, p_decoded, i_size);
     return p_duplicate;
 }
+
+/*****************************************************************************
+ * dvbpsi_descriptor_index
+ *****************************************************************************/
+size_t dvbpsi_descriptor_index(const uint8_t *p_data, size_t i_length,
+                               dvbpsi_descriptor_index_t *p_index, size_t i_max)
+{
+    assert(i_length <= UINT16_MAX);
+
+    size_t i_count = 0;
+    size_t i_offset = 0;
+    while (i_offset + 2 <= i_length)
+    {
+        size_t i_next = i_offset + 2 + p_data[i_offset + 1];
+        if (i_next > i_length)
+            break;
+        if (i_count < i_max)
+        {
+            p_index[i_count].i_offset = i_offset;
+            p_index[i_count].i_tag = p_data[i_offset];
+            p_index[i_count].i_length = p_data[i_offset + 1];
+        }
+        i_count++;
+        i_offset = i_next;
+    }
+    return i_count;
+}
+
+/*****************************************************************************
+ * dvbpsi_arrays_descriptors
+ *****************************************************************************/
+#define DVBPSI_ARRAYS_INDEX 128
+
+void dvbpsi_arrays_descriptors(dvbpsi_arrays_t *p_arrays,
+                               uint8_t *p_byte, const uint8_t *p_end,
+                               dvbpsi_descriptor_t **pp_first,
+                               dvbpsi_descriptor_t **pp_last, uint8_t *p_tags)
+{
+    /* A loop of many short descriptors takes several passes */
+    dvbpsi_descriptor_index_t p_index[DVBPSI_ARRAYS_INDEX];
+    while (p_end - p_byte >= 2)
+    {
+        size_t i_count = dvbpsi_descriptor_index(p_byte, p_end - p_byte, p_index,
+                                                 DVBPSI_ARRAYS_INDEX);
+        if (i_count == 0)
+            return;
+        if (i_count > DVBPSI_ARRAYS_INDEX)
+            i_count = DVBPSI_ARRAYS_INDEX;
+
+        for (size_t i = 0; i < i_count; i++)
+        {
+            const dvbpsi_descriptor_index_t *p_entry = &p_index[i];
+            dvbpsi_descriptor_t *p_descriptor =
+                    dvbpsi_arrays_descriptor(p_arrays, p_entry->i_tag, p_entry->i_length,
+                                             p_byte + p_entry->i_offset + 2);
+            if (p_descriptor)
+            {
+                dvbpsi_list_append(*pp_first, *pp_last, p_descriptor);
+                dvbpsi_tags_add(p_tags, p_entry->i_tag);
+            }
+        }
+
+        const dvbpsi_descriptor_index_t *p_last = &p_index[i_count - 1];
+        p_byte += p_last->i_offset + 2 + p_last->i_length;
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_descriptor_iter_init
+ *****************************************************************************/
+void dvbpsi_descriptor_iter_init(dvbpsi_descriptor_iter_t *p_iter,
+                                 uint8_t *p_data, size_t i_length)
+{
+    assert(p_iter);
+    p_iter->p_pos = p_data;
+    p_iter->p_end = p_data + i_length;
+    p_iter->p_view = NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_descriptor_iter_clear
+ *****************************************************************************/
+void dvbpsi_descriptor_iter_clear(dvbpsi_descriptor_iter_t *p_iter)
+{
+    assert(p_iter);
+    if (p_iter->p_view)
+    {
+        dvbpsi_free(p_iter->p_view->p_decoded);
+        p_iter->p_view->p_decoded = NULL;
+        p_iter->p_view = NULL;
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_descriptor_iter_next
+ *****************************************************************************/
+bool dvbpsi_descriptor_iter_next(dvbpsi_descriptor_iter_t *p_iter,
+                                 dvbpsi_descriptor_t *p_view)
+{
+    assert(p_iter);
+    assert(p_view);
+
+    dvbpsi_descriptor_iter_clear(p_iter);
+
+    if (p_iter->p_end - p_iter->p_pos < 2
+     || p_iter->p_pos[1] + 2 > p_iter->p_end - p_iter->p_pos)
+    {
+        p_iter->p_pos = p_iter->p_end;
+        return false;
+    }
+
+    p_view->i_tag = p_iter->p_pos[0];
+    p_view->i_length = p_iter->p_pos[1];
+    p_view->p_data = p_iter->p_pos + 2;
+    p_view->p_next = NULL;
+    p_view->p_decoded = NULL;
+
+    p_iter->p_pos += 2 + p_view->i_length;
+    p_iter->p_view = p_view;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_entry_iter_init
+ *****************************************************************************/
+void dvbpsi_entry_iter_init(dvbpsi_entry_iter_t *p_iter,
+                            uint8_t *p_data, size_t i_length,
+                            uint8_t i_header, uint8_t i_length_offset)
+{
+    assert(p_iter);
+    assert(i_length_offset + 2 <= i_header);
+
+    p_iter->p_pos = p_data;
+    p_iter->p_end = p_data + i_length;
+    p_iter->i_header = i_header;
+    p_iter->i_length_offset = i_length_offset;
+}
+
+/*****************************************************************************
+ * dvbpsi_entry_iter_next
+ *****************************************************************************/
+uint8_t *dvbpsi_entry_iter_next(dvbpsi_entry_iter_t *p_iter,
+                                dvbpsi_descriptor_iter_t *p_descriptors)
+{
+    assert(p_iter);
+
+    if (p_iter->p_end - p_iter->p_pos < p_iter->i_header)
+    {
+        p_iter->p_pos = p_iter->p_end;
+        return NULL;
+    }
+
+    uint8_t *p_header = p_iter->p_pos;
+    size_t i_loop = ((size_t)(p_header[p_iter->i_length_offset] & 0x0f) << 8)
+                  | p_header[p_iter->i_length_offset + 1];
+    uint8_t *p_loop = p_header + p_iter->i_header;
+    if (i_loop > (size_t)(p_iter->p_end - p_loop))
+        i_loop = p_iter->p_end - p_loop;
+
+    if (p_descriptors)
+        dvbpsi_descriptor_iter_init(p_descriptors, p_loop, i_loop);
+
+    p_iter->p_pos = p_loop + i_loop;
+    return p_header;
+}
+
+/*****************************************************************************
+ * dvbpsi_delta_hash
+ *****************************************************************************
+ * FNV-1a, as the descriptor cache.
+ *****************************************************************************/
+static uint64_t dvbpsi_delta_hash(uint64_t i_hash, const uint8_t *p_data, size_t i_length)
+{
+    for (size_t i = 0; i < i_length; i++)
+        i_hash = (i_hash ^ p_data[i]) * UINT64_C(0x100000001b3);
+    return i_hash;
+}
+
+#define DVBPSI_DELTA_HASH_INIT UINT64_C(0xcbf29ce484222325)
+
+static int dvbpsi_delta_entry_cmp(const void *p_a, const void *p_b)
+{
+    uint32_t i_a = ((const dvbpsi_delta_entry_t *)p_a)->i_key;
+    uint32_t i_b = ((const dvbpsi_delta_entry_t *)p_b)->i_key;
+    return (i_a > i_b) - (i_a < i_b);
+}
+
+/*****************************************************************************
+ * dvbpsi_delta_reset
+ *****************************************************************************/
+void dvbpsi_delta_reset(dvbpsi_delta_summary_t *p_summary)
+{
+    dvbpsi_free(p_summary->p_entries);
+    p_summary->p_entries = NULL;
+    p_summary->i_entries = 0;
+    p_summary->b_valid = false;
+}
+
+/*****************************************************************************
+ * dvbpsi_delta_compute
+ *****************************************************************************
+ * Summarizes the sections of a complete table, compares the summary with
+ * the previous one and keeps it.
+ *****************************************************************************/
+dvbpsi_delta_change_t *dvbpsi_delta_compute(dvbpsi_delta_summary_t *p_summary,
+                                            dvbpsi_psi_section_t *p_sections,
+                                            dvbpsi_delta_iter_cb pf_iter,
+                                            dvbpsi_delta_key_cb pf_key,
+                                            bool *pb_first, bool *pb_descriptors,
+                                            unsigned int *pi_changes)
+{
+    dvbpsi_psi_section_t *p_section;
+    dvbpsi_descriptor_iter_t descriptors;
+    dvbpsi_entry_iter_t entries;
+    uint8_t *p_header;
+
+    unsigned int i_entries = 0;
+    for (p_section = p_sections; p_section; p_section = p_section->p_next)
+    {
+        if (!pf_iter(p_section, NULL, &entries))
+            continue;
+        while (dvbpsi_entry_iter_next(&entries, NULL))
+            i_entries++;
+    }
+
+    /* The summary belongs to the decoder, not to the table being built */
+    dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(NULL);
+    dvbpsi_delta_entry_t *p_entries = dvbpsi_malloc_as((i_entries ? i_entries : 1)
+                                                       * sizeof(dvbpsi_delta_entry_t),
+                                                       DVBPSI_MEM_DECODER);
+    dvbpsi_delta_change_t *p_changes = dvbpsi_malloc_as((i_entries + p_summary->i_entries + 1)
+                                                        * sizeof(dvbpsi_delta_change_t),
+                                                        DVBPSI_MEM_DECODER);
+    dvbpsi_arena_leave(p_previous);
+    if (p_entries == NULL || p_changes == NULL)
+    {
+        dvbpsi_free(p_entries);
+        dvbpsi_free(p_changes);
+        dvbpsi_delta_reset(p_summary);
+        return NULL;
+    }
+
+    /* Summary of the new version */
+    uint64_t i_hash = DVBPSI_DELTA_HASH_INIT;
+    i_entries = 0;
+    for (p_section = p_sections; p_section; p_section = p_section->p_next)
+    {
+        if (!pf_iter(p_section, &descriptors, &entries))
+            continue;
+        i_hash = dvbpsi_delta_hash(i_hash, descriptors.p_pos,
+                                   descriptors.p_end - descriptors.p_pos);
+        while ((p_header = dvbpsi_entry_iter_next(&entries, &descriptors)) != NULL)
+        {
+            p_entries[i_entries].i_key = pf_key(p_header);
+            p_entries[i_entries].i_hash = dvbpsi_delta_hash(DVBPSI_DELTA_HASH_INIT, p_header,
+                                                            descriptors.p_end - p_header);
+            i_entries++;
+        }
+    }
+    qsort(p_entries, i_entries, sizeof(dvbpsi_delta_entry_t), dvbpsi_delta_entry_cmp);
+
+    /* Removed, then added and modified entries, an entry repeated under the
+       same key being matched with the next one of the other version */
+    const dvbpsi_delta_entry_t *p_old = p_summary->p_entries;
+    unsigned int i_old = p_summary->i_entries;
+    unsigned int i_changes = 0;
+    unsigned int i, j;
+    for (i = 0, j = 0; i < i_old; i++)
+    {
+        while (j < i_entries && p_entries[j].i_key < p_old[i].i_key)
+            j++;
+        if (j < i_entries && p_entries[j].i_key == p_old[i].i_key)
+            j++;
+        else
+            p_changes[i_changes++] = (dvbpsi_delta_change_t){ p_old[i].i_key,
+                                                              DVBPSI_ENTRY_REMOVED };
+    }
+    for (i = 0, j = 0; j < i_entries; j++)
+    {
+        while (i < i_old && p_old[i].i_key < p_entries[j].i_key)
+            i++;
+        if (i < i_old && p_old[i].i_key == p_entries[j].i_key)
+        {
+            if (p_old[i].i_hash != p_entries[j].i_hash)
+                p_changes[i_changes++] = (dvbpsi_delta_change_t){ p_entries[j].i_key,
+                                                                  DVBPSI_ENTRY_MODIFIED };
+            i++;
+        }
+        else
+            p_changes[i_changes++] = (dvbpsi_delta_change_t){ p_entries[j].i_key,
+                                                              DVBPSI_ENTRY_ADDED };
+    }
+
+    *pb_first = !p_summary->b_valid;
+    *pb_descriptors = p_summary->b_valid && p_summary->i_hash != i_hash;
+    *pi_changes = i_changes;
+
+    dvbpsi_free(p_summary->p_entries);
+    p_summary->p_entries = p_entries;
+    p_summary->i_entries = i_entries;
+    p_summary->i_hash = i_hash;
+    p_summary->b_valid = true;
+    return p_changes;
+}
@@ -30,6 +30,13 @@
  *
  * NOTE: Descriptor generators and decoder functions return a pointer on success
  * and NULL on error. They do not use a dvbpsi_t handle as first argument.
+ *
+ * Descriptor encoders, dvbpsi_Encode*Dr(p_buffer, i_size, p_decoded), write
+ * the tag, length and data of a descriptor at p_buffer, such as into the
+ * descriptor loop of a section being built, and return the number of bytes
+ * written, or 0 when they do not fit in the i_size bytes available or in the
+ * 255 bytes of a descriptor. The generators are built on them, and both
+ * correct the out of range fields of p_decoded the same way.
  */
 
 #ifndef _DVBPSI_DESCRIPTOR_H_
@@ -84,13 +91,20 @@ typedef struct dvbpsi_descriptor_s
   uint8_t                       i_tag;          /*!< descriptor_tag */
   uint8_t                       i_length;       /*!< descriptor_length */
 
-  uint8_t *                     p_data;         /*!< content */
+  uint8_t *                     p_data;         /*!< content, points to
+                                                     p_payload or to content
+                                                     shared with identical
+                                                     descriptors, see
+                                                     DVBPSI_FLAG_INTERN_DESCRIPTORS */
 
   struct dvbpsi_descriptor_s *  p_next;         /*!< next element of
                                                      the list */
 
   void *                        p_decoded;      /*!< decoded descriptor */
 
+  uint8_t                       p_payload[];    /*!< private, storage of the
+                                                     content allocated with
+                                                     the descriptor */
 } dvbpsi_descriptor_t;
 
 /*****************************************************************************
@@ -105,6 +119,9 @@ typedef struct dvbpsi_descriptor_s
  * \param i_length descriptor's length
  * \param p_data descriptor's data
  * \return a pointer to the descriptor.
+ *
+ * The descriptor and its content are a single allocation. When p_data is
+ * NULL the content is left uninitialized.
  */
 dvbpsi_descriptor_t* dvbpsi_NewDescriptor(uint8_t i_tag, uint8_t i_length,
                                           uint8_t* p_data);
@@ -136,6 +153,53 @@ void dvbpsi_DeleteDescriptors(dvbpsi_descriptor_t* p_descriptor);
 dvbpsi_descriptor_t *dvbpsi_AddDescriptor(dvbpsi_descriptor_t *p_list,
                                           dvbpsi_descriptor_t *p_descriptor);
 
+/*****************************************************************************
+ * dvbpsi_has_descriptor
+ *****************************************************************************/
+/*!
+ * \def DVBPSI_TAGS_SIZE
+ * \brief Size in bytes of a bitmap of the 256 descriptor tags.
+ */
+#define DVBPSI_TAGS_SIZE 32
+
+/*!
+ * \fn static inline bool dvbpsi_has_descriptor(const uint8_t *p_tags,
+                                             uint8_t i_tag)
+ * \brief Checks a tag in a bitmap of the descriptor tags present in a list.
+ *
+ * The table decoders keep such a bitmap, named p_tags, next to each
+ * descriptor list they fill, bit (tag & 7) of byte (tag >> 3) being set for
+ * each tag in the list. Only the descriptors added with the
+ * dvbpsi_xxx_descriptor_add() functions of the tables are recorded.
+ * \param p_tags bitmap of DVBPSI_TAGS_SIZE bytes
+ * \param i_tag descriptor tag to look for
+ * \return true if a descriptor with this tag is present, false if not.
+ */
+static inline bool dvbpsi_has_descriptor(const uint8_t *p_tags, uint8_t i_tag)
+{
+    return (p_tags[i_tag >> 3] & (1 << (i_tag & 7))) != 0;
+}
+
+/*****************************************************************************
+ * dvbpsi_find_descriptor
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_descriptor_t *dvbpsi_find_descriptor(dvbpsi_descriptor_t *p_list,
+                                                const uint8_t *p_tags,
+                                                uint8_t i_tag)
+ * \brief Finds the first descriptor with the given tag in a list.
+ *
+ * When the bitmap of the list does not have the tag the list is not walked.
+ * \param p_list the first descriptor in the descriptor list
+ * \param p_tags bitmap of the tags present in the list, see
+ *        dvbpsi_has_descriptor(), or NULL to walk the list in any case
+ * \param i_tag descriptor tag to look for
+ * \return the first descriptor with tag i_tag, NULL if there is none.
+ */
+dvbpsi_descriptor_t *dvbpsi_find_descriptor(dvbpsi_descriptor_t *p_list,
+                                            const uint8_t *p_tags,
+                                            uint8_t i_tag);
+
 /*****************************************************************************
  * dvbpsi_CanDecodeAsDescriptor
  *****************************************************************************/
@@ -171,6 +235,188 @@ bool dvbpsi_IsDescriptorDecoded(dvbpsi_descriptor_t *p_descriptor);
  */
 void *dvbpsi_DuplicateDecodedDescriptor(void *p_decoded, ssize_t i_size);
 
+/*****************************************************************************
+ * dvbpsi_descriptor_iter_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_descriptor_iter_s
+ * \brief Iterator over a descriptor loop of raw section bytes.
+ *
+ * Each step fills a caller provided dvbpsi_descriptor_t view whose p_data
+ * points into the section, nothing is allocated. The views can be given to
+ * the dvbpsi_Decode*Dr functions: what they attach to a view is freed by the
+ * next step, by the end of the loop or by dvbpsi_descriptor_iter_clear().
+ */
+/*!
+ * \typedef struct dvbpsi_descriptor_iter_s dvbpsi_descriptor_iter_t
+ * \brief dvbpsi_descriptor_iter_t type definition.
+ */
+typedef struct dvbpsi_descriptor_iter_s
+{
+    uint8_t             *p_pos;     /*!< next descriptor */
+    uint8_t             *p_end;     /*!< end of the loop */
+    dvbpsi_descriptor_t *p_view;    /*!< private, last view filled */
+} dvbpsi_descriptor_iter_t;
+
+/*****************************************************************************
+ * dvbpsi_entry_iter_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_entry_iter_s
+ * \brief Iterator over the entries of a section, such as the ESs of a PMT.
+ *
+ * An entry is a fixed size header holding the 12 bits length of the
+ * descriptor loop that follows it. The per table *_section_iter() functions
+ * set up these iterators.
+ */
+/*!
+ * \typedef struct dvbpsi_entry_iter_s dvbpsi_entry_iter_t
+ * \brief dvbpsi_entry_iter_t type definition.
+ */
+typedef struct dvbpsi_entry_iter_s
+{
+    uint8_t *p_pos;                 /*!< next entry */
+    uint8_t *p_end;                 /*!< end of the entries */
+    uint8_t  i_header;              /*!< size of an entry header */
+    uint8_t  i_length_offset;       /*!< offset of the descriptor loop length
+                                         in the header */
+} dvbpsi_entry_iter_t;
+
+/*****************************************************************************
+ * dvbpsi_descriptor_index_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_descriptor_index_s
+ * \brief Position of a descriptor of a loop, see dvbpsi_descriptor_index().
+ */
+/*!
+ * \typedef struct dvbpsi_descriptor_index_s dvbpsi_descriptor_index_t
+ * \brief dvbpsi_descriptor_index_t type definition.
+ */
+typedef struct dvbpsi_descriptor_index_s
+{
+    uint16_t i_offset;              /*!< offset of the descriptor_tag in the
+                                         loop */
+    uint8_t  i_tag;                 /*!< descriptor_tag */
+    uint8_t  i_length;              /*!< descriptor_length */
+} dvbpsi_descriptor_index_t;
+
+/*****************************************************************************
+ * dvbpsi_entry_change
+ *****************************************************************************/
+/*!
+ * \enum dvbpsi_entry_change
+ * \brief Change of an entry between two versions of a table, as reported
+ * by the SDT, NIT and BAT delta callbacks.
+ */
+enum dvbpsi_entry_change
+{
+    DVBPSI_ENTRY_ADDED,         /*!< key not in the previous version */
+    DVBPSI_ENTRY_REMOVED,       /*!< key not in the new version */
+    DVBPSI_ENTRY_MODIFIED,      /*!< bytes of the entry changed */
+};
+
+/*****************************************************************************
+ * dvbpsi_descriptor_iter_init
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_descriptor_iter_init(dvbpsi_descriptor_iter_t *p_iter,
+ *                                      uint8_t *p_data, size_t i_length)
+ * \brief Starts iterating over a descriptor loop.
+ * \param p_iter iterator
+ * \param p_data first byte of the loop
+ * \param i_length size of the loop in bytes
+ * \return nothing.
+ */
+void dvbpsi_descriptor_iter_init(dvbpsi_descriptor_iter_t *p_iter,
+                                 uint8_t *p_data, size_t i_length);
+
+/*****************************************************************************
+ * dvbpsi_descriptor_iter_next
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_descriptor_iter_next(dvbpsi_descriptor_iter_t *p_iter,
+ *                                      dvbpsi_descriptor_t *p_view)
+ * \brief Steps to the next descriptor of the loop.
+ * \param p_iter iterator
+ * \param p_view filled with the descriptor, valid until the next step
+ * \return false at the end of the loop or on a truncated descriptor.
+ *
+ * The same view should be given at each step of a loop.
+ */
+bool dvbpsi_descriptor_iter_next(dvbpsi_descriptor_iter_t *p_iter,
+                                 dvbpsi_descriptor_t *p_view);
+
+/*****************************************************************************
+ * dvbpsi_descriptor_iter_clear
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_descriptor_iter_clear(dvbpsi_descriptor_iter_t *p_iter)
+ * \brief Frees the decoded descriptor attached to the last view.
+ * \param p_iter iterator
+ * \return nothing.
+ *
+ * Only needed when leaving a loop before dvbpsi_descriptor_iter_next()
+ * returned false.
+ */
+void dvbpsi_descriptor_iter_clear(dvbpsi_descriptor_iter_t *p_iter);
+
+/*****************************************************************************
+ * dvbpsi_descriptor_index
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_descriptor_index(const uint8_t *p_data, size_t i_length,
+ *                                   dvbpsi_descriptor_index_t *p_index,
+ *                                   size_t i_max)
+ * \brief Checks the tag and length chain of a descriptor loop in one pass.
+ * \param p_data first byte of the loop
+ * \param i_length size of the loop in bytes, at most 65535
+ * \param p_index filled with the position of each descriptor
+ * \param i_max number of entries of p_index
+ * \return the number of complete descriptors of the loop, up to the first
+ *         truncated one, of which the first i_max are in p_index.
+ *
+ * Each entry of the index holds a whole descriptor: its content can be
+ * read without further bounds checks, in particular by decoders of
+ * descriptors of a fixed size once i_length has been compared to it.
+ */
+size_t dvbpsi_descriptor_index(const uint8_t *p_data, size_t i_length,
+                               dvbpsi_descriptor_index_t *p_index, size_t i_max);
+
+/*****************************************************************************
+ * dvbpsi_entry_iter_init
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_entry_iter_init(dvbpsi_entry_iter_t *p_iter,
+ *                                 uint8_t *p_data, size_t i_length,
+ *                                 uint8_t i_header, uint8_t i_length_offset)
+ * \brief Starts iterating over the entries of a section.
+ * \param p_iter iterator
+ * \param p_data first byte of the first entry
+ * \param i_length size of all the entries in bytes
+ * \param i_header size of an entry header
+ * \param i_length_offset offset of the descriptor loop length in the header
+ * \return nothing.
+ */
+void dvbpsi_entry_iter_init(dvbpsi_entry_iter_t *p_iter,
+                            uint8_t *p_data, size_t i_length,
+                            uint8_t i_header, uint8_t i_length_offset);
+
+/*****************************************************************************
+ * dvbpsi_entry_iter_next
+ *****************************************************************************/
+/*!
+ * \fn uint8_t *dvbpsi_entry_iter_next(dvbpsi_entry_iter_t *p_iter,
+ *                                     dvbpsi_descriptor_iter_t *p_descriptors)
+ * \brief Steps to the next entry.
+ * \param p_iter iterator
+ * \param p_descriptors set up to iterate over the descriptors of the entry,
+ *        may be NULL
+ * \return the header of the entry, NULL at the end of the entries.
+ */
+uint8_t *dvbpsi_entry_iter_next(dvbpsi_entry_iter_t *p_iter,
+                                dvbpsi_descriptor_iter_t *p_descriptors);
+
 #ifdef __cplusplus
 };
 #endif
@@ -0,0 +1,685 @@
+/*****************************************************************************
+ * dr.c: descriptor decoders dispatch
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
+#include "../dvbpsi_private.h"
+#include "../descriptor.h"
+
+#include "dr.h"
+
+/*****************************************************************************
+ * DVBPSI_DR_DECODER
+ *****************************************************************************
+ * Defines a dvbpsi_descriptor_decoder_cb calling a typed decoder. A
+ * descriptor left out by configure, see --enable-descriptors, has a NULL
+ * decoder instead, its tag is then not decoded.
+ *****************************************************************************/
+#define DVBPSI_DR_DECODER(decoder)                                            \
+static void *dvbpsi_dr_##decoder(dvbpsi_descriptor_t *p_descriptor)           \
+{                                                                             \
+    return dvbpsi_##decoder(p_descriptor);                                    \
+}
+
+#ifndef DVBPSI_WITHOUT_DR_02
+DVBPSI_DR_DECODER(DecodeVStreamDr)
+#else
+#   define dvbpsi_dr_DecodeVStreamDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_03
+DVBPSI_DR_DECODER(DecodeAStreamDr)
+#else
+#   define dvbpsi_dr_DecodeAStreamDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_04
+DVBPSI_DR_DECODER(DecodeHierarchyDr)
+#else
+#   define dvbpsi_dr_DecodeHierarchyDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_05
+DVBPSI_DR_DECODER(DecodeRegistrationDr)
+#else
+#   define dvbpsi_dr_DecodeRegistrationDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_06
+DVBPSI_DR_DECODER(DecodeDSAlignmentDr)
+#else
+#   define dvbpsi_dr_DecodeDSAlignmentDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_07
+DVBPSI_DR_DECODER(DecodeTargetBgGridDr)
+#else
+#   define dvbpsi_dr_DecodeTargetBgGridDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_08
+DVBPSI_DR_DECODER(DecodeVWindowDr)
+#else
+#   define dvbpsi_dr_DecodeVWindowDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_09
+DVBPSI_DR_DECODER(DecodeCADr)
+#else
+#   define dvbpsi_dr_DecodeCADr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_0a
+DVBPSI_DR_DECODER(DecodeISO639Dr)
+#else
+#   define dvbpsi_dr_DecodeISO639Dr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_0b
+DVBPSI_DR_DECODER(DecodeSystemClockDr)
+#else
+#   define dvbpsi_dr_DecodeSystemClockDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_0c
+DVBPSI_DR_DECODER(DecodeMxBuffUtilizationDr)
+#else
+#   define dvbpsi_dr_DecodeMxBuffUtilizationDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_0d
+DVBPSI_DR_DECODER(DecodeCopyrightDr)
+#else
+#   define dvbpsi_dr_DecodeCopyrightDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_0e
+DVBPSI_DR_DECODER(DecodeMaxBitrateDr)
+#else
+#   define dvbpsi_dr_DecodeMaxBitrateDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_0f
+DVBPSI_DR_DECODER(DecodePrivateDataDr)
+#else
+#   define dvbpsi_dr_DecodePrivateDataDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_10
+DVBPSI_DR_DECODER(DecodeSmoothingBufferDr)
+#else
+#   define dvbpsi_dr_DecodeSmoothingBufferDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_11
+DVBPSI_DR_DECODER(DecodeSTDDr)
+#else
+#   define dvbpsi_dr_DecodeSTDDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_12
+DVBPSI_DR_DECODER(DecodeIBPDr)
+#else
+#   define dvbpsi_dr_DecodeIBPDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_13
+DVBPSI_DR_DECODER(DecodeCarouselIdDr)
+#else
+#   define dvbpsi_dr_DecodeCarouselIdDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_14
+DVBPSI_DR_DECODER(DecodeAssociationTagDr)
+#else
+#   define dvbpsi_dr_DecodeAssociationTagDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_1b
+DVBPSI_DR_DECODER(DecodeMPEG4VideoDr)
+#else
+#   define dvbpsi_dr_DecodeMPEG4VideoDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_1c
+DVBPSI_DR_DECODER(DecodeMPEG4AudioDr)
+#else
+#   define dvbpsi_dr_DecodeMPEG4AudioDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_40
+DVBPSI_DR_DECODER(DecodeNetworkNameDr)
+#else
+#   define dvbpsi_dr_DecodeNetworkNameDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_41
+DVBPSI_DR_DECODER(DecodeServiceListDrCounted)
+#else
+#   define dvbpsi_dr_DecodeServiceListDrCounted NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_42
+DVBPSI_DR_DECODER(DecodeStuffingDr)
+#else
+#   define dvbpsi_dr_DecodeStuffingDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_43
+DVBPSI_DR_DECODER(DecodeSatDelivSysDr)
+#else
+#   define dvbpsi_dr_DecodeSatDelivSysDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_44
+DVBPSI_DR_DECODER(DecodeCableDelivSysDr)
+#else
+#   define dvbpsi_dr_DecodeCableDelivSysDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_45
+DVBPSI_DR_DECODER(DecodeVBIDataDr)
+#else
+#   define dvbpsi_dr_DecodeVBIDataDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_47
+DVBPSI_DR_DECODER(DecodeBouquetNameDr)
+#else
+#   define dvbpsi_dr_DecodeBouquetNameDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_48
+DVBPSI_DR_DECODER(DecodeServiceDr)
+#else
+#   define dvbpsi_dr_DecodeServiceDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_49
+DVBPSI_DR_DECODER(DecodeCountryAvailability)
+#else
+#   define dvbpsi_dr_DecodeCountryAvailability NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_4a
+DVBPSI_DR_DECODER(DecodeLinkageDrCounted)
+#else
+#   define dvbpsi_dr_DecodeLinkageDrCounted NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_4b
+DVBPSI_DR_DECODER(DecodeNVODReferenceDr)
+#else
+#   define dvbpsi_dr_DecodeNVODReferenceDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_4c
+DVBPSI_DR_DECODER(DecodeTimeShiftedServiceDr)
+#else
+#   define dvbpsi_dr_DecodeTimeShiftedServiceDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_4d
+DVBPSI_DR_DECODER(DecodeShortEventDr)
+#else
+#   define dvbpsi_dr_DecodeShortEventDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_4e
+DVBPSI_DR_DECODER(DecodeExtendedEventDr)
+#else
+#   define dvbpsi_dr_DecodeExtendedEventDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_4f
+DVBPSI_DR_DECODER(DecodeTimeShiftedEventDr)
+#else
+#   define dvbpsi_dr_DecodeTimeShiftedEventDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_50
+DVBPSI_DR_DECODER(DecodeComponentDr)
+#else
+#   define dvbpsi_dr_DecodeComponentDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_52
+DVBPSI_DR_DECODER(DecodeStreamIdentifierDr)
+#else
+#   define dvbpsi_dr_DecodeStreamIdentifierDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_53
+DVBPSI_DR_DECODER(DecodeCAIdentifierDr)
+#else
+#   define dvbpsi_dr_DecodeCAIdentifierDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_54
+DVBPSI_DR_DECODER(DecodeContentDr)
+#else
+#   define dvbpsi_dr_DecodeContentDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_55
+DVBPSI_DR_DECODER(DecodeParentalRatingDr)
+#else
+#   define dvbpsi_dr_DecodeParentalRatingDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_56
+DVBPSI_DR_DECODER(DecodeTeletextDr)
+#else
+#   define dvbpsi_dr_DecodeTeletextDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_58
+DVBPSI_DR_DECODER(DecodeLocalTimeOffsetDr)
+#else
+#   define dvbpsi_dr_DecodeLocalTimeOffsetDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_59
+DVBPSI_DR_DECODER(DecodeSubtitlingDr)
+#else
+#   define dvbpsi_dr_DecodeSubtitlingDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_5a
+DVBPSI_DR_DECODER(DecodeTerrDelivSysDr)
+#else
+#   define dvbpsi_dr_DecodeTerrDelivSysDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_62
+DVBPSI_DR_DECODER(DecodeFrequencyListDr)
+#else
+#   define dvbpsi_dr_DecodeFrequencyListDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_66
+DVBPSI_DR_DECODER(DecodeDataBroadcastIdDr)
+#else
+#   define dvbpsi_dr_DecodeDataBroadcastIdDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_69
+DVBPSI_DR_DECODER(DecodePDCDr)
+#else
+#   define dvbpsi_dr_DecodePDCDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_73
+DVBPSI_DR_DECODER(DecodeDefaultAuthorityDr)
+#else
+#   define dvbpsi_dr_DecodeDefaultAuthorityDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_76
+DVBPSI_DR_DECODER(DecodeContentIdDr)
+#else
+#   define dvbpsi_dr_DecodeContentIdDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_7c
+DVBPSI_DR_DECODER(DecodeAACDr)
+#else
+#   define dvbpsi_dr_DecodeAACDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_81
+DVBPSI_DR_DECODER(DecodeAc3AudioDr)
+#else
+#   define dvbpsi_dr_DecodeAc3AudioDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_83
+DVBPSI_DR_DECODER(DecodeLCNDrCounted)
+#else
+#   define dvbpsi_dr_DecodeLCNDrCounted NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_86
+DVBPSI_DR_DECODER(DecodeCaptionServiceDr)
+#else
+#   define dvbpsi_dr_DecodeCaptionServiceDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_8a
+DVBPSI_DR_DECODER(DecodeCUEIDr)
+#else
+#   define dvbpsi_dr_DecodeCUEIDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_a0
+DVBPSI_DR_DECODER(ExtendedChannelNameDr)
+#else
+#   define dvbpsi_dr_ExtendedChannelNameDr NULL
+#endif
+#ifndef DVBPSI_WITHOUT_DR_a1
+DVBPSI_DR_DECODER(DecodeServiceLocationDr)
+#else
+#   define dvbpsi_dr_DecodeServiceLocationDr NULL
+#endif
+
+/*****************************************************************************
+ * Sizes of the counted decoded forms
+ *****************************************************************************/
+static size_t dvbpsi_dr_size_41(const void *p_decoded)
+{
+    const dvbpsi_service_list_counted_t *p = p_decoded;
+    return DVBPSI_SERVICE_LIST_COUNTED_SIZE(p->i_service_count);
+}
+
+static size_t dvbpsi_dr_size_4a(const void *p_decoded)
+{
+    const dvbpsi_linkage_counted_t *p = p_decoded;
+    return DVBPSI_LINKAGE_COUNTED_SIZE(p->i_private_data_length);
+}
+
+static size_t dvbpsi_dr_size_83(const void *p_decoded)
+{
+    const dvbpsi_lcn_counted_t *p = p_decoded;
+    return DVBPSI_LCN_COUNTED_SIZE(p->i_number_of_entries);
+}
+
+/*****************************************************************************
+ * dvbpsi_dr_entry_t
+ *****************************************************************************
+ * Decoder of a tag with the size of its decoded form, 0 when the decoded
+ * form holds pointers and cannot be duplicated by a plain copy. A form
+ * sized to its content also has the function giving its whole size.
+ *****************************************************************************/
+typedef struct dvbpsi_dr_entry_s
+{
+    dvbpsi_descriptor_decoder_cb pf_decode;
+    size_t                       i_size;
+    size_t                    (* pf_size)(const void *p_decoded);
+} dvbpsi_dr_entry_t;
+
+#define DVBPSI_DR(decoder, type) { dvbpsi_dr_##decoder, sizeof(type), NULL }
+#define DVBPSI_DR_POINTERS(decoder) { dvbpsi_dr_##decoder, 0, NULL }
+#define DVBPSI_DR_COUNTED(decoder, type, tag) \
+    { dvbpsi_dr_##decoder, sizeof(type), dvbpsi_dr_size_##tag }
+
+/*****************************************************************************
+ * dvbpsi_dr_size
+ *****************************************************************************/
+static inline size_t dvbpsi_dr_size(const dvbpsi_dr_entry_t *p_dr, const void *p_decoded)
+{
+    return p_dr->pf_size ? p_dr->pf_size(p_decoded) : p_dr->i_size;
+}
+
+/*****************************************************************************
+ * DVBPSI_DR_MPEG
+ *****************************************************************************
+ * ISO/IEC 13818-1 descriptors, common to every context.
+ *****************************************************************************/
+#define DVBPSI_DR_MPEG                                                        \
+    [0x02] = DVBPSI_DR(DecodeVStreamDr, dvbpsi_vstream_dr_t),                  \
+    [0x03] = DVBPSI_DR(DecodeAStreamDr, dvbpsi_astream_dr_t),                  \
+    [0x04] = DVBPSI_DR(DecodeHierarchyDr, dvbpsi_hierarchy_dr_t),              \
+    [0x05] = DVBPSI_DR(DecodeRegistrationDr, dvbpsi_registration_dr_t),        \
+    [0x06] = DVBPSI_DR(DecodeDSAlignmentDr, dvbpsi_ds_alignment_dr_t),         \
+    [0x07] = DVBPSI_DR(DecodeTargetBgGridDr, dvbpsi_target_bg_grid_dr_t),      \
+    [0x08] = DVBPSI_DR(DecodeVWindowDr, dvbpsi_vwindow_dr_t),                  \
+    [0x09] = DVBPSI_DR(DecodeCADr, dvbpsi_ca_dr_t),                            \
+    [0x0a] = DVBPSI_DR(DecodeISO639Dr, dvbpsi_iso639_dr_t),                    \
+    [0x0b] = DVBPSI_DR(DecodeSystemClockDr, dvbpsi_system_clock_dr_t),         \
+    [0x0c] = DVBPSI_DR(DecodeMxBuffUtilizationDr, dvbpsi_mx_buff_utilization_dr_t), \
+    [0x0d] = DVBPSI_DR(DecodeCopyrightDr, dvbpsi_copyright_dr_t),              \
+    [0x0e] = DVBPSI_DR(DecodeMaxBitrateDr, dvbpsi_max_bitrate_dr_t),           \
+    [0x0f] = DVBPSI_DR(DecodePrivateDataDr, dvbpsi_private_data_dr_t),         \
+    [0x10] = DVBPSI_DR(DecodeSmoothingBufferDr, dvbpsi_smoothing_buffer_dr_t), \
+    [0x11] = DVBPSI_DR(DecodeSTDDr, dvbpsi_std_dr_t),                          \
+    [0x12] = DVBPSI_DR(DecodeIBPDr, dvbpsi_ibp_dr_t),                          \
+    [0x13] = DVBPSI_DR_POINTERS(DecodeCarouselIdDr),                           \
+    [0x14] = DVBPSI_DR_POINTERS(DecodeAssociationTagDr),                       \
+    [0x1b] = DVBPSI_DR(DecodeMPEG4VideoDr, dvbpsi_mpeg4_video_dr_t),           \
+    [0x1c] = DVBPSI_DR(DecodeMPEG4AudioDr, dvbpsi_mpeg4_audio_dr_t),           \
+    [0x8a] = DVBPSI_DR(DecodeCUEIDr, dvbpsi_cuei_dr_t)
+
+/*****************************************************************************
+ * dvbpsi_dr_decoders
+ *****************************************************************************
+ * Decoder of each tag, by dvbpsi_descriptor_context.
+ *****************************************************************************/
+static const dvbpsi_dr_entry_t dvbpsi_dr_decoders[DVBPSI_DESCRIPTOR_CONTEXT_MAX][256] =
+{
+    [DVBPSI_DESCRIPTOR_CONTEXT_DVB] =
+    {
+        DVBPSI_DR_MPEG,
+        /* ETSI EN 300 468 */
+        [0x40] = DVBPSI_DR(DecodeNetworkNameDr, dvbpsi_network_name_dr_t),
+        [0x41] = DVBPSI_DR_COUNTED(DecodeServiceListDrCounted, dvbpsi_service_list_counted_t, 41),
+        [0x42] = DVBPSI_DR(DecodeStuffingDr, dvbpsi_stuffing_dr_t),
+        [0x43] = DVBPSI_DR(DecodeSatDelivSysDr, dvbpsi_sat_deliv_sys_dr_t),
+        [0x44] = DVBPSI_DR(DecodeCableDelivSysDr, dvbpsi_cable_deliv_sys_dr_t),
+        [0x45] = DVBPSI_DR(DecodeVBIDataDr, dvbpsi_vbi_dr_t),
+        [0x46] = DVBPSI_DR(DecodeTeletextDr, dvbpsi_teletext_dr_t),
+        [0x47] = DVBPSI_DR(DecodeBouquetNameDr, dvbpsi_bouquet_name_dr_t),
+        [0x48] = DVBPSI_DR(DecodeServiceDr, dvbpsi_service_dr_t),
+        [0x49] = DVBPSI_DR(DecodeCountryAvailability, dvbpsi_country_availability_dr_t),
+        [0x4a] = DVBPSI_DR_COUNTED(DecodeLinkageDrCounted, dvbpsi_linkage_counted_t, 4a),
+        [0x4b] = DVBPSI_DR(DecodeNVODReferenceDr, dvbpsi_nvod_ref_dr_t),
+        [0x4c] = DVBPSI_DR(DecodeTimeShiftedServiceDr, dvbpsi_tshifted_service_dr_t),
+        [0x4d] = DVBPSI_DR(DecodeShortEventDr, dvbpsi_short_event_dr_t),
+        [0x4e] = DVBPSI_DR_POINTERS(DecodeExtendedEventDr),
+        [0x4f] = DVBPSI_DR(DecodeTimeShiftedEventDr, dvbpsi_tshifted_ev_dr_t),
+        [0x50] = DVBPSI_DR_POINTERS(DecodeComponentDr),
+        [0x52] = DVBPSI_DR(DecodeStreamIdentifierDr, dvbpsi_stream_identifier_dr_t),
+        [0x53] = DVBPSI_DR(DecodeCAIdentifierDr, dvbpsi_ca_identifier_dr_t),
+        [0x54] = DVBPSI_DR(DecodeContentDr, dvbpsi_content_dr_t),
+        [0x55] = DVBPSI_DR(DecodeParentalRatingDr, dvbpsi_parental_rating_dr_t),
+        [0x56] = DVBPSI_DR(DecodeTeletextDr, dvbpsi_teletext_dr_t),
+        [0x58] = DVBPSI_DR(DecodeLocalTimeOffsetDr, dvbpsi_local_time_offset_dr_t),
+        [0x59] = DVBPSI_DR(DecodeSubtitlingDr, dvbpsi_subtitling_dr_t),
+        [0x5a] = DVBPSI_DR(DecodeTerrDelivSysDr, dvbpsi_terr_deliv_sys_dr_t),
+        [0x62] = DVBPSI_DR(DecodeFrequencyListDr, dvbpsi_frequency_list_dr_t),
+        [0x66] = DVBPSI_DR_POINTERS(DecodeDataBroadcastIdDr),
+        [0x69] = DVBPSI_DR(DecodePDCDr, dvbpsi_PDC_dr_t),
+        [0x73] = DVBPSI_DR(DecodeDefaultAuthorityDr, dvbpsi_default_authority_dr_t),
+        [0x76] = DVBPSI_DR(DecodeContentIdDr, dvbpsi_content_id_dr_t),
+        [0x7c] = DVBPSI_DR_POINTERS(DecodeAACDr),
+        /* EACEM/E-Book logical_channel_descriptor */
+        [0x83] = DVBPSI_DR_COUNTED(DecodeLCNDrCounted, dvbpsi_lcn_counted_t, 83),
+    },
+    [DVBPSI_DESCRIPTOR_CONTEXT_ATSC] =
+    {
+        DVBPSI_DR_MPEG,
+        /* ATSC A/52 and A/65 */
+        [0x81] = DVBPSI_DR(DecodeAc3AudioDr, dvbpsi_ac3_audio_dr_t),
+        [0x86] = DVBPSI_DR(DecodeCaptionServiceDr, dvbpsi_caption_service_dr_t),
+        [0xa0] = DVBPSI_DR(ExtendedChannelNameDr, dvbpsi_extended_channel_name_dr_t),
+        [0xa1] = DVBPSI_DR(DecodeServiceLocationDr, dvbpsi_service_location_dr_t),
+    },
+};
+
+/*****************************************************************************
+ * dvbpsi_descriptor_decoder
+ *****************************************************************************/
+dvbpsi_descriptor_decoder_cb dvbpsi_descriptor_decoder(enum dvbpsi_descriptor_context i_context,
+                                                       uint8_t i_tag)
+{
+    if ((unsigned)i_context >= DVBPSI_DESCRIPTOR_CONTEXT_MAX)
+        return NULL;
+    return dvbpsi_dr_decoders[i_context][i_tag].pf_decode;
+}
+
+/*****************************************************************************
+ * dvbpsi_decode_descriptors
+ *****************************************************************************/
+int dvbpsi_decode_descriptors(dvbpsi_descriptor_t *p_descriptors,
+                              enum dvbpsi_descriptor_context i_context,
+                              const uint8_t *p_tags)
+{
+    if ((unsigned)i_context >= DVBPSI_DESCRIPTOR_CONTEXT_MAX)
+        return 0;
+
+    const dvbpsi_dr_entry_t *p_decoders = dvbpsi_dr_decoders[i_context];
+    int i_decoded = 0;
+
+    for (dvbpsi_descriptor_t *p = p_descriptors; p != NULL; p = p->p_next)
+    {
+        const uint8_t i_tag = p->i_tag;
+        if (p_tags && !dvbpsi_has_descriptor(p_tags, i_tag))
+            continue;
+        if (p->p_decoded == NULL && p_decoders[i_tag].pf_decode)
+            p_decoders[i_tag].pf_decode(p);
+        if (p->p_decoded)
+            i_decoded++;
+    }
+
+    return i_decoded;
+}
+
+/*****************************************************************************
+ * Descriptor cache
+ *****************************************************************************
+ * Each entry holds the bytes of a descriptor followed by a copy of its
+ * decoded form. Entries not used by the last table are dropped.
+ *****************************************************************************/
+#define DVBPSI_DR_CACHE_BUCKETS 256
+
+typedef struct dvbpsi_dr_cache_entry_s
+{
+    struct dvbpsi_dr_cache_entry_s *p_next;
+    uint32_t                        i_hash;
+    unsigned int                    i_generation;
+    void                           *p_decoded;
+    size_t                          i_size;         /* of p_decoded */
+    uint8_t                         i_tag;
+    uint8_t                         i_length;
+    uint8_t                         p_data[];
+} dvbpsi_dr_cache_entry_t;
+
+struct dvbpsi_dr_cache_s
+{
+    unsigned int             i_generation;
+    dvbpsi_dr_cache_entry_t *p_buckets[DVBPSI_DR_CACHE_BUCKETS];
+};
+
+/*****************************************************************************
+ * dvbpsi_dr_cache_hash
+ *****************************************************************************
+ * FNV-1a of the tag, length and content of a descriptor.
+ *****************************************************************************/
+static uint32_t dvbpsi_dr_cache_hash(const dvbpsi_descriptor_t *p_descriptor)
+{
+    uint32_t i_hash = 2166136261u;
+    i_hash = (i_hash ^ p_descriptor->i_tag) * 16777619u;
+    i_hash = (i_hash ^ p_descriptor->i_length) * 16777619u;
+    for (int i = 0; i < p_descriptor->i_length; i++)
+        i_hash = (i_hash ^ p_descriptor->p_data[i]) * 16777619u;
+    return i_hash;
+}
+
+/*****************************************************************************
+ * dvbpsi_dr_cache_add
+ *****************************************************************************
+ * Caches a copy of the decoded form of p_descriptor, on the heap even if a
+ * table arena is current.
+ *****************************************************************************/
+static void dvbpsi_dr_cache_add(dvbpsi_dr_cache_t *p_cache, uint32_t i_hash,
+                                const dvbpsi_descriptor_t *p_descriptor,
+                                size_t i_size)
+{
+    size_t i_offset = (sizeof(dvbpsi_dr_cache_entry_t) + p_descriptor->i_length + 15)
+                        & ~(size_t)15;
+
+    dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(NULL);
+    dvbpsi_dr_cache_entry_t *p_entry = dvbpsi_malloc(i_offset + i_size);
+    dvbpsi_arena_leave(p_previous);
+    if (p_entry == NULL)
+        return;
+
+    p_entry->i_hash = i_hash;
+    p_entry->i_generation = p_cache->i_generation;
+    p_entry->i_tag = p_descriptor->i_tag;
+    p_entry->i_length = p_descriptor->i_length;
+    memcpy(p_entry->p_data, p_descriptor->p_data, p_descriptor->i_length);
+    p_entry->p_decoded = (uint8_t *)p_entry + i_offset;
+    p_entry->i_size = i_size;
+    memcpy(p_entry->p_decoded, p_descriptor->p_decoded, i_size);
+
+    dvbpsi_dr_cache_entry_t **pp_bucket = &p_cache->p_buckets[i_hash % DVBPSI_DR_CACHE_BUCKETS];
+    p_entry->p_next = *pp_bucket;
+    *pp_bucket = p_entry;
+}
+
+/*****************************************************************************
+ * dvbpsi_dr_cache_decode
+ *****************************************************************************/
+void dvbpsi_dr_cache_decode(dvbpsi_t *p_dvbpsi, dvbpsi_decoder_t *p_decoder,
+                            dvbpsi_descriptor_t *p_descriptors)
+{
+    const dvbpsi_dr_entry_t *p_decoders = dvbpsi_dr_decoders[DVBPSI_DESCRIPTOR_CONTEXT_DVB];
+
+    if (p_decoder->p_dr_cache == NULL)
+    {
+        dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(NULL);
+        p_decoder->p_dr_cache = dvbpsi_calloc_as(1, sizeof(dvbpsi_dr_cache_t), DVBPSI_MEM_DECODER);
+        dvbpsi_arena_leave(p_previous);
+    }
+    dvbpsi_dr_cache_t *p_cache = p_decoder->p_dr_cache;
+
+    for (dvbpsi_descriptor_t *p = p_descriptors; p != NULL; p = p->p_next)
+    {
+        const dvbpsi_dr_entry_t *p_dr = &p_decoders[p->i_tag];
+        if (p->p_decoded || p_dr->pf_decode == NULL)
+            continue;
+
+        if (p_cache == NULL || p_dr->i_size == 0)
+        {
+            p_dr->pf_decode(p);
+            continue;
+        }
+
+        uint32_t i_hash = dvbpsi_dr_cache_hash(p);
+        dvbpsi_dr_cache_entry_t *p_entry = p_cache->p_buckets[i_hash % DVBPSI_DR_CACHE_BUCKETS];
+        while (p_entry && (p_entry->i_hash != i_hash || p_entry->i_tag != p->i_tag
+                           || p_entry->i_length != p->i_length
+                           || memcmp(p_entry->p_data, p->p_data, p->i_length)))
+            p_entry = p_entry->p_next;
+
+        if (p_entry)
+        {
+            p->p_decoded = dvbpsi_DuplicateDecodedDescriptor(p_entry->p_decoded,
+                                                             p_entry->i_size);
+            if (p->p_decoded)
+            {
+                p_entry->i_generation = p_cache->i_generation;
+                p_dvbpsi->stats.i_descriptors_reused++;
+            }
+        }
+        else if (p_dr->pf_decode(p) && p->p_decoded)
+            dvbpsi_dr_cache_add(p_cache, i_hash, p, dvbpsi_dr_size(p_dr, p->p_decoded));
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_dr_cache_trim
+ *****************************************************************************/
+void dvbpsi_dr_cache_trim(dvbpsi_decoder_t *p_decoder)
+{
+    dvbpsi_dr_cache_t *p_cache = p_decoder->p_dr_cache;
+    if (p_cache == NULL)
+        return;
+
+    for (int i = 0; i < DVBPSI_DR_CACHE_BUCKETS; i++)
+    {
+        dvbpsi_dr_cache_entry_t **pp_entry = &p_cache->p_buckets[i];
+        while (*pp_entry)
+        {
+            dvbpsi_dr_cache_entry_t *p_entry = *pp_entry;
+            if (p_entry->i_generation != p_cache->i_generation)
+            {
+                *pp_entry = p_entry->p_next;
+                dvbpsi_free(p_entry);
+            }
+            else
+                pp_entry = &p_entry->p_next;
+        }
+    }
+    p_cache->i_generation++;
+}
+
+/*****************************************************************************
+ * dvbpsi_dr_cache_delete
+ *****************************************************************************/
+void dvbpsi_dr_cache_delete(dvbpsi_dr_cache_t *p_cache)
+{
+    if (p_cache == NULL)
+        return;
+
+    for (int i = 0; i < DVBPSI_DR_CACHE_BUCKETS; i++)
+    {
+        dvbpsi_dr_cache_entry_t *p_entry = p_cache->p_buckets[i];
+        while (p_entry)
+        {
+            dvbpsi_dr_cache_entry_t *p_next = p_entry->p_next;
+            dvbpsi_free(p_entry);
+            p_entry = p_next;
+        }
+    }
+    dvbpsi_free(p_cache);
+}
@@ -89,6 +89,74 @@
 #include "dr_a0.h"
 #include "dr_a1.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_descriptor_context
+ *****************************************************************************/
+/*!
+ * \enum dvbpsi_descriptor_context
+ * \brief Standard giving the meaning of the descriptor tags
+ *
+ * The ISO/IEC 13818-1 tags are decoded in every context. The user private
+ * tags from 0x80 mean different things in DVB and ATSC streams.
+ */
+enum dvbpsi_descriptor_context
+{
+    DVBPSI_DESCRIPTOR_CONTEXT_DVB = 0,  /*!< ETSI EN 300 468 descriptors */
+    DVBPSI_DESCRIPTOR_CONTEXT_ATSC,     /*!< ATSC A/52 and A/65 descriptors */
+    DVBPSI_DESCRIPTOR_CONTEXT_MAX       /*!< number of contexts */
+};
+
+/*!
+ * \typedef void *(* dvbpsi_descriptor_decoder_cb)(dvbpsi_descriptor_t *p_descriptor)
+ * \brief Descriptor decoder, returns dvbpsi_descriptor_t::p_decoded or NULL
+ */
+typedef void *(* dvbpsi_descriptor_decoder_cb)(dvbpsi_descriptor_t *p_descriptor);
+
+/*****************************************************************************
+ * dvbpsi_descriptor_decoder
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_descriptor_decoder_cb dvbpsi_descriptor_decoder(
+                    enum dvbpsi_descriptor_context i_context, uint8_t i_tag)
+ * \brief Looks up the decoder of a descriptor tag
+ * \param i_context standard of the stream
+ * \param i_tag descriptor tag
+ * \return the dvbpsi_Decode*Dr() function for the tag, or NULL when
+ * libdvbpsi has none in this context.
+ */
+dvbpsi_descriptor_decoder_cb dvbpsi_descriptor_decoder(enum dvbpsi_descriptor_context i_context,
+                                                       uint8_t i_tag);
+
+/*****************************************************************************
+ * dvbpsi_decode_descriptors
+ *****************************************************************************/
+/*!
+ * \fn int dvbpsi_decode_descriptors(dvbpsi_descriptor_t *p_descriptors,
+                    enum dvbpsi_descriptor_context i_context,
+                    const uint8_t *p_tags)
+ * \brief Decodes a list of descriptors in one pass
+ * \param p_descriptors first descriptor of the list
+ * \param i_context standard of the stream
+ * \param p_tags bitmap of the 256 tags to decode, bit (tag & 7) of byte
+ * (tag >> 3), or NULL to decode every tag
+ * \return the number of descriptors of the list with a decoded form.
+ *
+ * The decoded form of each descriptor is left in dvbpsi_descriptor_t::p_decoded
+ * as if the matching dvbpsi_Decode*Dr() function had been called. Descriptors
+ * already decoded are not decoded again.
+ */
+int dvbpsi_decode_descriptors(dvbpsi_descriptor_t *p_descriptors,
+                              enum dvbpsi_descriptor_context i_context,
+                              const uint8_t *p_tags);
+
+#ifdef __cplusplus
+};
+#endif
+
 #else
 #error "Multiple inclusions of dr.h"
 #endif
@@ -35,6 +35,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -56,7 +57,7 @@ dvbpsi_vstream_dr_t * dvbpsi_DecodeVStreamDr(dvbpsi_descriptor_t * p_descriptor)
      return p_descriptor->p_decoded;
 
   /* Allocate memory */
-  p_decoded = (dvbpsi_vstream_dr_t*)malloc(sizeof(dvbpsi_vstream_dr_t));
+  p_decoded = (dvbpsi_vstream_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_vstream_dr_t));
   if(!p_decoded) return NULL;
 
   /* Decode data and check the length */
@@ -64,7 +65,7 @@ dvbpsi_vstream_dr_t * dvbpsi_DecodeVStreamDr(dvbpsi_descriptor_t * p_descriptor)
   if(    (!p_decoded->b_mpeg2 && (p_descriptor->i_length != 1))
       || (p_decoded->b_mpeg2 && (p_descriptor->i_length != 3)))
   {
-    free(p_decoded);
+    dvbpsi_free(p_decoded);
     return NULL;
   }
 
@@ -88,36 +89,56 @@ dvbpsi_vstream_dr_t * dvbpsi_DecodeVStreamDr(dvbpsi_descriptor_t * p_descriptor)
 
 
 /*****************************************************************************
- * dvbpsi_GenVStreamDr
+ * dvbpsi_EncodeVStreamDr
  *****************************************************************************/
-dvbpsi_descriptor_t * dvbpsi_GenVStreamDr(dvbpsi_vstream_dr_t * p_decoded,
-                                          bool b_duplicate)
+size_t dvbpsi_EncodeVStreamDr(uint8_t *p_buffer, size_t i_size,
+                              dvbpsi_vstream_dr_t *p_decoded)
 {
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor =
-            dvbpsi_NewDescriptor(0x02, p_decoded->b_mpeg2 ? 3 : 1, NULL);
-    if (!p_descriptor)
-        return NULL;
+    size_t i_length = p_decoded->b_mpeg2 ? 3 : 1;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x02;
+    p_buffer[1] = i_length;
 
     /* Encode data */
-    p_descriptor->p_data[0] = (p_decoded->b_mpeg2) ? 0 : 0x04;
+    p_data[0] = (p_decoded->b_mpeg2) ? 0 : 0x04;
     if (p_decoded->b_multiple_frame_rate)
-        p_descriptor->p_data[0] |= 0x80;
-    p_descriptor->p_data[0] |= (p_decoded->i_frame_rate_code & 0x0f) << 3;
+        p_data[0] |= 0x80;
+    p_data[0] |= (p_decoded->i_frame_rate_code & 0x0f) << 3;
     if (p_decoded->b_constrained_parameter)
-        p_descriptor->p_data[0] |= 0x02;
+        p_data[0] |= 0x02;
     if (p_decoded->b_still_picture)
-        p_descriptor->p_data[0] |= 0x01;
+        p_data[0] |= 0x01;
 
     if (p_decoded->b_mpeg2)
     {
-        p_descriptor->p_data[1] = p_decoded->i_profile_level_indication;
-        p_descriptor->p_data[2] = 0x1f;
-        p_descriptor->p_data[2] |= (p_decoded->i_chroma_format & 0x03) << 6;
+        p_data[1] = p_decoded->i_profile_level_indication;
+        p_data[2] = 0x1f;
+        p_data[2] |= (p_decoded->i_chroma_format & 0x03) << 6;
         if (p_decoded->b_frame_rate_extension)
-            p_descriptor->p_data[2] |= 0x20;
+            p_data[2] |= 0x20;
     }
 
+    return 2 + i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_GenVStreamDr
+ *****************************************************************************/
+dvbpsi_descriptor_t * dvbpsi_GenVStreamDr(dvbpsi_vstream_dr_t * p_decoded,
+                                          bool b_duplicate)
+{
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeVStreamDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
+
     if (b_duplicate)
     {
         /* Duplicate decoded data */
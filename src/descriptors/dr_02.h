@@ -99,6 +99,17 @@ dvbpsi_vstream_dr_t* dvbpsi_DecodeVStreamDr(dvbpsi_descriptor_t * p_descriptor);
 dvbpsi_descriptor_t * dvbpsi_GenVStreamDr(dvbpsi_vstream_dr_t * p_decoded,
                                           bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeVStreamDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeVStreamDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_vstream_dr_t *p_decoded)
+ * \brief "video stream" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeVStreamDr(uint8_t *p_buffer, size_t i_size,
+                              dvbpsi_vstream_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
@@ -35,10 +35,12 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
 #include "dr_03.h"
+#include "dr_codec.h"
 
 
 /*****************************************************************************
@@ -57,20 +59,17 @@ dvbpsi_astream_dr_t * dvbpsi_DecodeAStreamDr(dvbpsi_descriptor_t * p_descriptor)
      return p_descriptor->p_decoded;
 
   /* Allocate memory */
-  p_decoded = (dvbpsi_astream_dr_t*)malloc(sizeof(dvbpsi_astream_dr_t));
+  p_decoded = (dvbpsi_astream_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_astream_dr_t));
   if(!p_decoded) return NULL;
 
   /* Decode data and check the length */
-  if(p_descriptor->i_length != 1)
+  if(p_descriptor->i_length != DVBPSI_ASTREAM_DR_LENGTH)
   {
-    free(p_decoded);
+    dvbpsi_free(p_decoded);
     return NULL;
   }
 
-  p_decoded->b_free_format = (p_descriptor->p_data[0] & 0x80) ? true : false;
-  p_decoded->i_id = (p_descriptor->p_data[0] & 0x40) >> 6;
-  p_decoded->i_layer = (p_descriptor->p_data[0] & 0x30) >> 4;
-  p_decoded->b_variable_rate_audio_indicator = ((p_descriptor->p_data[0] & 0x08) >> 3) ? true : false;
+  dvbpsi_unpack_astream_dr(p_decoded, p_descriptor->p_data);
 
   p_descriptor->p_decoded = (void*)p_decoded;
 
@@ -78,25 +77,40 @@ dvbpsi_astream_dr_t * dvbpsi_DecodeAStreamDr(dvbpsi_descriptor_t * p_descriptor)
 }
 
 
+/*****************************************************************************
+ * dvbpsi_EncodeAStreamDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeAStreamDr(uint8_t *p_buffer, size_t i_size,
+                              dvbpsi_astream_dr_t *p_decoded)
+{
+    size_t i_length = DVBPSI_ASTREAM_DR_LENGTH;
+    if (i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x03;
+    p_buffer[1] = i_length;
+
+    /* Encode data */
+    dvbpsi_pack_astream_dr(p_data, p_decoded);
+
+    return 2 + i_length;
+}
+
 /*****************************************************************************
  * dvbpsi_GenAStreamDr
  *****************************************************************************/
 dvbpsi_descriptor_t *dvbpsi_GenAStreamDr(dvbpsi_astream_dr_t * p_decoded,
                                          bool b_duplicate)
 {
-    /* Create the descriptor */
-    dvbpsi_descriptor_t *p_descriptor = dvbpsi_NewDescriptor(0x03, 1, NULL);
-    if (!p_descriptor)
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeAStreamDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
         return NULL;
 
-    /* Encode data */
-    *p_descriptor->p_data = 0x0f;
-    if (p_decoded->b_free_format)
-        *p_descriptor->p_data |= 0x80;
-    *p_descriptor->p_data |= (p_decoded->i_id & 0x01) << 6;
-    *p_descriptor->p_data |= (p_decoded->i_layer & 0x03) << 4;
-    if (p_decoded->b_variable_rate_audio_indicator)
-        *p_descriptor->p_data |= 0x08;
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
 
     if (b_duplicate)
     {
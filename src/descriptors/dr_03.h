@@ -93,6 +93,17 @@ dvbpsi_astream_dr_t* dvbpsi_DecodeAStreamDr(dvbpsi_descriptor_t * p_descriptor);
 dvbpsi_descriptor_t * dvbpsi_GenAStreamDr(dvbpsi_astream_dr_t * p_decoded,
                                           bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeAStreamDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeAStreamDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_astream_dr_t *p_decoded)
+ * \brief "audio stream" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeAStreamDr(uint8_t *p_buffer, size_t i_size,
+                              dvbpsi_astream_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
@@ -35,10 +35,12 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
 #include "dr_04.h"
+#include "dr_codec.h"
 
 
 /*****************************************************************************
@@ -58,20 +60,17 @@ dvbpsi_hierarchy_dr_t * dvbpsi_DecodeHierarchyDr(
      return p_descriptor->p_decoded;
 
   /* Allocate memory */
-  p_decoded = (dvbpsi_hierarchy_dr_t*)malloc(sizeof(dvbpsi_hierarchy_dr_t));
+  p_decoded = (dvbpsi_hierarchy_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_hierarchy_dr_t));
   if(!p_decoded) return NULL;
 
   /* Decode data and check the length */
-  if(p_descriptor->i_length != 4)
+  if(p_descriptor->i_length != DVBPSI_HIERARCHY_DR_LENGTH)
   {
-    free(p_decoded);
+    dvbpsi_free(p_decoded);
     return NULL;
   }
 
-  p_decoded->i_h_type = p_descriptor->p_data[0] & 0x0f;
-  p_decoded->i_h_layer_index = p_descriptor->p_data[1] & 0x3f;
-  p_decoded->i_h_embedded_layer = p_descriptor->p_data[2] & 0x3f;
-  p_decoded->i_h_priority = p_descriptor->p_data[3] & 0x3f;
+  dvbpsi_unpack_hierarchy_dr(p_decoded, p_descriptor->p_data);
 
   p_descriptor->p_decoded = (void*)p_decoded;
 
@@ -79,22 +78,40 @@ dvbpsi_hierarchy_dr_t * dvbpsi_DecodeHierarchyDr(
 }
 
 
+/*****************************************************************************
+ * dvbpsi_EncodeHierarchyDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeHierarchyDr(uint8_t *p_buffer, size_t i_size,
+                                dvbpsi_hierarchy_dr_t *p_decoded)
+{
+    size_t i_length = DVBPSI_HIERARCHY_DR_LENGTH;
+    if (i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x04;
+    p_buffer[1] = i_length;
+
+    /* Encode data */
+    dvbpsi_pack_hierarchy_dr(p_data, p_decoded);
+
+    return 2 + i_length;
+}
+
 /*****************************************************************************
  * dvbpsi_GenHierarchyDr
  *****************************************************************************/
 dvbpsi_descriptor_t * dvbpsi_GenHierarchyDr(dvbpsi_hierarchy_dr_t * p_decoded,
                                             bool b_duplicate)
 {
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor = dvbpsi_NewDescriptor(0x04, 4, NULL);
-    if (!p_descriptor)
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeHierarchyDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
         return NULL;
 
-    /* Encode data */
-    p_descriptor->p_data[0] = 0xf0 | p_decoded->i_h_type;
-    p_descriptor->p_data[1] = 0xc0 | p_decoded->i_h_layer_index;
-    p_descriptor->p_data[2] = 0xc0 | p_decoded->i_h_embedded_layer;
-    p_descriptor->p_data[3] = 0xc0 | p_decoded->i_h_priority;
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
 
     if (b_duplicate)
     {
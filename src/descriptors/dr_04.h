@@ -94,6 +94,17 @@ dvbpsi_hierarchy_dr_t* dvbpsi_DecodeHierarchyDr(
 dvbpsi_descriptor_t * dvbpsi_GenHierarchyDr(dvbpsi_hierarchy_dr_t * p_decoded,
                                             bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeHierarchyDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeHierarchyDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_hierarchy_dr_t *p_decoded)
+ * \brief "hierarchy" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeHierarchyDr(uint8_t *p_buffer, size_t i_size,
+                                dvbpsi_hierarchy_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
@@ -95,6 +95,17 @@ dvbpsi_descriptor_t * dvbpsi_GenRegistrationDr(
                                         dvbpsi_registration_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeRegistrationDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeRegistrationDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_registration_dr_t *p_decoded)
+ * \brief "registration" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeRegistrationDr(uint8_t *p_buffer, size_t i_size,
+                                   dvbpsi_registration_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
@@ -35,10 +35,12 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
 #include "dr_06.h"
+#include "dr_codec.h"
 
 
 /*****************************************************************************
@@ -57,14 +59,14 @@ dvbpsi_ds_alignment_dr_t * dvbpsi_DecodeDSAlignmentDr(
     if (dvbpsi_IsDescriptorDecoded(p_descriptor))
         return p_descriptor->p_decoded;
 
-    if (p_descriptor->i_length != 1)
+    if (p_descriptor->i_length != DVBPSI_DS_ALIGNMENT_DR_LENGTH)
         return NULL;
 
     /* Allocate memory */
-    p_decoded = (dvbpsi_ds_alignment_dr_t*) malloc(sizeof(dvbpsi_ds_alignment_dr_t));
+    p_decoded = (dvbpsi_ds_alignment_dr_t*) dvbpsi_malloc(sizeof(dvbpsi_ds_alignment_dr_t));
     if(!p_decoded) return NULL;
 
-    p_decoded->i_alignment_type = p_descriptor->p_data[0];
+    dvbpsi_unpack_ds_alignment_dr(p_decoded, p_descriptor->p_data);
 
     p_descriptor->p_decoded = (void*)p_decoded;
 
@@ -72,6 +74,26 @@ dvbpsi_ds_alignment_dr_t * dvbpsi_DecodeDSAlignmentDr(
 }
 
 
+/*****************************************************************************
+ * dvbpsi_EncodeDSAlignmentDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeDSAlignmentDr(uint8_t *p_buffer, size_t i_size,
+                                  dvbpsi_ds_alignment_dr_t *p_decoded)
+{
+    size_t i_length = DVBPSI_DS_ALIGNMENT_DR_LENGTH;
+    if (i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x06;
+    p_buffer[1] = i_length;
+
+    /* Encode data */
+    dvbpsi_pack_ds_alignment_dr(p_data, p_decoded);
+
+    return 2 + i_length;
+}
+
 /*****************************************************************************
  * dvbpsi_GenDSAlignmentDr
  *****************************************************************************/
@@ -79,13 +101,14 @@ dvbpsi_descriptor_t * dvbpsi_GenDSAlignmentDr(
                                         dvbpsi_ds_alignment_dr_t * p_decoded,
                                         bool b_duplicate)
 {
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor = dvbpsi_NewDescriptor(0x06, 1, NULL);
-    if (!p_descriptor)
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeDSAlignmentDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
         return NULL;
 
-    /* Encode data */
-    p_descriptor->p_data[0] = p_decoded->i_alignment_type;
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
 
     if (b_duplicate)
     {
@@ -93,6 +93,17 @@ dvbpsi_descriptor_t * dvbpsi_GenDSAlignmentDr(
                                         dvbpsi_ds_alignment_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeDSAlignmentDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeDSAlignmentDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_ds_alignment_dr_t *p_decoded)
+ * \brief "data stream alignment" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeDSAlignmentDr(uint8_t *p_buffer, size_t i_size,
+                                  dvbpsi_ds_alignment_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
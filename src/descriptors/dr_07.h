@@ -95,6 +95,17 @@ dvbpsi_descriptor_t * dvbpsi_GenTargetBgGridDr(
                                         dvbpsi_target_bg_grid_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeTargetBgGridDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeTargetBgGridDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_target_bg_grid_dr_t *p_decoded)
+ * \brief "target background grid" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeTargetBgGridDr(uint8_t *p_buffer, size_t i_size,
+                                   dvbpsi_target_bg_grid_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
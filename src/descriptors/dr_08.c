@@ -35,10 +35,12 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
 #include "dr_08.h"
+#include "dr_codec.h"
 
 
 /*****************************************************************************
@@ -56,21 +58,15 @@ dvbpsi_vwindow_dr_t * dvbpsi_DecodeVWindowDr(dvbpsi_descriptor_t * p_descriptor)
     if (dvbpsi_IsDescriptorDecoded(p_descriptor))
         return p_descriptor->p_decoded;
 
-    if (p_descriptor->i_length != 4)
+    if (p_descriptor->i_length != DVBPSI_VWINDOW_DR_LENGTH)
         return NULL;
 
     /* Allocate memory */
-    p_decoded = (dvbpsi_vwindow_dr_t*)malloc(sizeof(dvbpsi_vwindow_dr_t));
+    p_decoded = (dvbpsi_vwindow_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_vwindow_dr_t));
     if (!p_decoded)
         return NULL;
 
-    p_decoded->i_horizontal_offset =   ((uint16_t)(p_descriptor->p_data[0]) << 6)
-            | ((p_descriptor->p_data[1] & 0xfc) >> 2);
-    p_decoded->i_vertical_offset =
-            ((uint16_t)(p_descriptor->p_data[1] & 0x03) << 12)
-            | ((uint16_t)(p_descriptor->p_data[2]) << 4)
-            | ((p_descriptor->p_data[3] & 0xf0) >> 4);
-    p_decoded->i_window_priority = p_descriptor->p_data[3] & 0x0f;
+    dvbpsi_unpack_vwindow_dr(p_decoded, p_descriptor->p_data);
 
     p_descriptor->p_decoded = (void*)p_decoded;
 
@@ -78,26 +74,41 @@ dvbpsi_vwindow_dr_t * dvbpsi_DecodeVWindowDr(dvbpsi_descriptor_t * p_descriptor)
 }
 
 
+/*****************************************************************************
+ * dvbpsi_EncodeVWindowDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeVWindowDr(uint8_t *p_buffer, size_t i_size,
+                              dvbpsi_vwindow_dr_t *p_decoded)
+{
+    size_t i_length = DVBPSI_VWINDOW_DR_LENGTH;
+    if (i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x08;
+    p_buffer[1] = i_length;
+
+    /* Encode data */
+    dvbpsi_pack_vwindow_dr(p_data, p_decoded);
+
+    return 2 + i_length;
+}
+
 /*****************************************************************************
  * dvbpsi_GenVWindowDr
  *****************************************************************************/
 dvbpsi_descriptor_t * dvbpsi_GenVWindowDr(dvbpsi_vwindow_dr_t * p_decoded,
                                           bool b_duplicate)
 {
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor = dvbpsi_NewDescriptor(0x08, 4, NULL);
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeVWindowDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
 
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
     if (!p_descriptor)
         return NULL;
 
-    /* Encode data */
-    p_descriptor->p_data[0] = p_decoded->i_horizontal_offset >> 6;
-    p_descriptor->p_data[1] =   (((uint8_t)p_decoded->i_horizontal_offset) << 2)
-            | (p_decoded->i_vertical_offset >> 12);
-    p_descriptor->p_data[2] = p_decoded->i_vertical_offset >> 4;
-    p_descriptor->p_data[3] =   (((uint8_t)p_decoded->i_vertical_offset) << 4)
-            | (p_decoded->i_window_priority & 0x0f);
-
     if (b_duplicate)
     {
         /* Duplicate decoded data */
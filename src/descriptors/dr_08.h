@@ -92,6 +92,17 @@ dvbpsi_vwindow_dr_t* dvbpsi_DecodeVWindowDr(dvbpsi_descriptor_t * p_descriptor);
 dvbpsi_descriptor_t * dvbpsi_GenVWindowDr(dvbpsi_vwindow_dr_t * p_decoded,
                                           bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeVWindowDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeVWindowDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_vwindow_dr_t *p_decoded)
+ * \brief "video window" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeVWindowDr(uint8_t *p_buffer, size_t i_size,
+                              dvbpsi_vwindow_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
@@ -35,10 +35,12 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
 #include "dr_09.h"
+#include "dr_codec.h"
 
 
 /*****************************************************************************
@@ -56,19 +58,16 @@ dvbpsi_ca_dr_t * dvbpsi_DecodeCADr(dvbpsi_descriptor_t * p_descriptor)
     if (dvbpsi_IsDescriptorDecoded(p_descriptor))
         return p_descriptor->p_decoded;
 
-    if (p_descriptor->i_length < 4)
+    if (p_descriptor->i_length < DVBPSI_CA_DR_LENGTH)
         return NULL;
 
     /* Allocate memory */
-    p_decoded = (dvbpsi_ca_dr_t*)malloc(sizeof(dvbpsi_ca_dr_t));
+    p_decoded = (dvbpsi_ca_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_ca_dr_t));
     if (!p_decoded)
         return NULL;
 
-    p_decoded->i_ca_system_id =   ((uint16_t)(p_descriptor->p_data[0]) << 8)
-            | p_descriptor->p_data[1];
-    p_decoded->i_ca_pid =   ((uint16_t)(p_descriptor->p_data[2] & 0x1f) << 8)
-            | p_descriptor->p_data[3];
-    p_decoded->i_private_length = p_descriptor->i_length - 4;
+    dvbpsi_unpack_ca_dr(p_decoded, p_descriptor->p_data);
+    p_decoded->i_private_length = p_descriptor->i_length - DVBPSI_CA_DR_LENGTH;
     if (p_decoded->i_private_length > 251)
         p_decoded->i_private_length = 251;
 
@@ -83,30 +82,47 @@ dvbpsi_ca_dr_t * dvbpsi_DecodeCADr(dvbpsi_descriptor_t * p_descriptor)
 }
 
 /*****************************************************************************
- * dvbpsi_GenCADr
+ * dvbpsi_EncodeCADr
  *****************************************************************************/
-dvbpsi_descriptor_t * dvbpsi_GenCADr(dvbpsi_ca_dr_t * p_decoded,
-                                     bool b_duplicate)
+size_t dvbpsi_EncodeCADr(uint8_t *p_buffer, size_t i_size,
+                         dvbpsi_ca_dr_t *p_decoded)
 {
     if (p_decoded->i_private_length > 251)
         p_decoded->i_private_length = 251;
 
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor =
-            dvbpsi_NewDescriptor(0x09, p_decoded->i_private_length + 4, NULL);
-    if (!p_descriptor)
-        return NULL;
+    size_t i_length = p_decoded->i_private_length + 4;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x09;
+    p_buffer[1] = i_length;
 
     /* Encode data */
-    p_descriptor->p_data[0] = p_decoded->i_ca_system_id >> 8;
-    p_descriptor->p_data[1] = p_decoded->i_ca_system_id;
-    p_descriptor->p_data[2] = 0xe0 | ((p_decoded->i_ca_pid >> 8) & 0x1f);
-    p_descriptor->p_data[3] = p_decoded->i_ca_pid;
+    dvbpsi_pack_ca_dr(p_data, p_decoded);
     if (p_decoded->i_private_length)
-        memcpy(p_descriptor->p_data + 4,
+        memcpy(p_data + 4,
                p_decoded->i_private_data,
                p_decoded->i_private_length);
 
+    return 2 + i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_GenCADr
+ *****************************************************************************/
+dvbpsi_descriptor_t * dvbpsi_GenCADr(dvbpsi_ca_dr_t * p_decoded,
+                                     bool b_duplicate)
+{
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeCADr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
+
     if (b_duplicate)
     {
         /* Duplicate decoded data */
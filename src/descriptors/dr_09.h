@@ -95,6 +95,17 @@ dvbpsi_ca_dr_t* dvbpsi_DecodeCADr(dvbpsi_descriptor_t * p_descriptor);
 dvbpsi_descriptor_t * dvbpsi_GenCADr(dvbpsi_ca_dr_t * p_decoded,
                                      bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeCADr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeCADr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_ca_dr_t *p_decoded)
+ * \brief "conditional access" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeCADr(uint8_t *p_buffer, size_t i_size,
+                         dvbpsi_ca_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
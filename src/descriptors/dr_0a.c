@@ -35,6 +35,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -61,7 +62,7 @@ dvbpsi_iso639_dr_t * dvbpsi_DecodeISO639Dr(dvbpsi_descriptor_t * p_descriptor)
         return NULL;
 
     /* Allocate memory */
-    p_decoded = (dvbpsi_iso639_dr_t*)malloc(sizeof(dvbpsi_iso639_dr_t));
+    p_decoded = (dvbpsi_iso639_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_iso639_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -85,32 +86,52 @@ dvbpsi_iso639_dr_t * dvbpsi_DecodeISO639Dr(dvbpsi_descriptor_t * p_descriptor)
 
 
 /*****************************************************************************
- * dvbpsi_GenISO639Dr
+ * dvbpsi_EncodeISO639Dr
  *****************************************************************************/
-dvbpsi_descriptor_t * dvbpsi_GenISO639Dr(dvbpsi_iso639_dr_t * p_decoded,
-                                         bool b_duplicate)
+size_t dvbpsi_EncodeISO639Dr(uint8_t *p_buffer, size_t i_size,
+                             dvbpsi_iso639_dr_t *p_decoded)
 {
-    if (p_decoded->i_code_count > 64)
-        p_decoded->i_code_count = 64;
+    /* 63 codes of 4 bytes fill the 255 bytes of a descriptor */
+    if (p_decoded->i_code_count > 63)
+        p_decoded->i_code_count = 63;
 
-    /* Create the descriptor */
-    uint8_t i_size = (p_decoded->i_code_count * 4) > UINT8_MAX ? 255 : p_decoded->i_code_count * 4;
-    dvbpsi_descriptor_t * p_descriptor =
-            dvbpsi_NewDescriptor(0x0a, i_size, NULL);
-    if (!p_descriptor)
-        return NULL;
+    size_t i_length = p_decoded->i_code_count * 4;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x0a;
+    p_buffer[1] = i_length;
 
     /* Encode data */
     int i = 0;
     while( i < p_decoded->i_code_count )
     {
-        p_descriptor->p_data[i*4] = p_decoded->code[i].iso_639_code[0];
-        p_descriptor->p_data[i*4+1] = p_decoded->code[i].iso_639_code[1];
-        p_descriptor->p_data[i*4+2] = p_decoded->code[i].iso_639_code[2];
-        p_descriptor->p_data[i*4+3] = p_decoded->code[i].i_audio_type;
+        p_data[i*4] = p_decoded->code[i].iso_639_code[0];
+        p_data[i*4+1] = p_decoded->code[i].iso_639_code[1];
+        p_data[i*4+2] = p_decoded->code[i].iso_639_code[2];
+        p_data[i*4+3] = p_decoded->code[i].i_audio_type;
         i++;
     }
 
+    return 2 + i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_GenISO639Dr
+ *****************************************************************************/
+dvbpsi_descriptor_t * dvbpsi_GenISO639Dr(dvbpsi_iso639_dr_t * p_decoded,
+                                         bool b_duplicate)
+{
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeISO639Dr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
+
     if (b_duplicate)
     {
         /* Duplicate decoded data */
@@ -97,6 +97,17 @@ dvbpsi_iso639_dr_t* dvbpsi_DecodeISO639Dr(dvbpsi_descriptor_t * p_descriptor);
 dvbpsi_descriptor_t * dvbpsi_GenISO639Dr(dvbpsi_iso639_dr_t * p_decoded,
                                          bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeISO639Dr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeISO639Dr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_iso639_dr_t *p_decoded)
+ * \brief "ISO 639 language" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeISO639Dr(uint8_t *p_buffer, size_t i_size,
+                             dvbpsi_iso639_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
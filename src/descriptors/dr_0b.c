@@ -35,10 +35,12 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
 #include "dr_0b.h"
+#include "dr_codec.h"
 
 
 /*****************************************************************************
@@ -58,43 +60,57 @@ dvbpsi_system_clock_dr_t * dvbpsi_DecodeSystemClockDr(
         return p_descriptor->p_decoded;
 
     /* Check the length */
-    if (p_descriptor->i_length != 2)
+    if (p_descriptor->i_length != DVBPSI_SYSTEM_CLOCK_DR_LENGTH)
         return NULL;
 
     /* Allocate memory */
     p_decoded =
-            (dvbpsi_system_clock_dr_t*)malloc(sizeof(dvbpsi_system_clock_dr_t));
+            (dvbpsi_system_clock_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_system_clock_dr_t));
     if (!p_decoded)
         return NULL;
 
-    p_decoded->b_external_clock_ref = (p_descriptor->p_data[0] & 0x80) ? true : false;
-    p_decoded->i_clock_accuracy_integer = p_descriptor->p_data[0] & 0x3f;
-    p_decoded->i_clock_accuracy_exponent = (p_descriptor->p_data[1] & 0xe0) >> 5;
+    dvbpsi_unpack_system_clock_dr(p_decoded, p_descriptor->p_data);
 
     p_descriptor->p_decoded = (void*)p_decoded;
 
     return p_decoded;
 }
 
+/*****************************************************************************
+ * dvbpsi_EncodeSystemClockDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeSystemClockDr(uint8_t *p_buffer, size_t i_size,
+                                  dvbpsi_system_clock_dr_t *p_decoded)
+{
+    size_t i_length = DVBPSI_SYSTEM_CLOCK_DR_LENGTH;
+    if (i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x0b;
+    p_buffer[1] = i_length;
+
+    /* Encode data */
+    dvbpsi_pack_system_clock_dr(p_data, p_decoded);
+
+    return 2 + i_length;
+}
+
 /*****************************************************************************
  * dvbpsi_GenSystemClockDr
  *****************************************************************************/
 dvbpsi_descriptor_t * dvbpsi_GenSystemClockDr(dvbpsi_system_clock_dr_t * p_decoded,
                                               bool b_duplicate)
 {
-    /* Create the descriptor */
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeSystemClockDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
     dvbpsi_descriptor_t * p_descriptor =
-            dvbpsi_NewDescriptor(0x0b, 2, NULL);
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
     if (!p_descriptor)
         return NULL;
 
-    /* Encode data */
-    p_descriptor->p_data[0] =
-            0x40 | (p_decoded->i_clock_accuracy_integer & 0x3f);
-    if (p_decoded->b_external_clock_ref)
-        p_descriptor->p_data[0] |= 0x80;
-    p_descriptor->p_data[1] = 0x1f | p_decoded->i_clock_accuracy_exponent << 5;
-
     if (b_duplicate)
     {
         /* Duplicate decoded data */
@@ -96,6 +96,17 @@ dvbpsi_descriptor_t * dvbpsi_GenSystemClockDr(
                                         dvbpsi_system_clock_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeSystemClockDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeSystemClockDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_system_clock_dr_t *p_decoded)
+ * \brief "system clock" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeSystemClockDr(uint8_t *p_buffer, size_t i_size,
+                                  dvbpsi_system_clock_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
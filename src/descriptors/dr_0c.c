@@ -35,10 +35,12 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
 #include "dr_0c.h"
+#include "dr_codec.h"
 
 
 /*****************************************************************************
@@ -57,20 +59,16 @@ dvbpsi_mx_buff_utilization_dr_t * dvbpsi_DecodeMxBuffUtilizationDr(
     if (dvbpsi_IsDescriptorDecoded(p_descriptor))
         return p_descriptor->p_decoded;
 
-    if (p_descriptor->i_length != 3)
+    if (p_descriptor->i_length != DVBPSI_MX_BUFF_UTILIZATION_DR_LENGTH)
         return NULL;
 
     /* Allocate memory */
     p_decoded = (dvbpsi_mx_buff_utilization_dr_t*)
-            malloc(sizeof(dvbpsi_mx_buff_utilization_dr_t));
+            dvbpsi_malloc(sizeof(dvbpsi_mx_buff_utilization_dr_t));
     if (!p_decoded)
         return NULL;
 
-    p_decoded->b_mdv_valid = (p_descriptor->p_data[0] & 0x80) ? true : false;
-    p_decoded->i_mx_delay_variation =
-            ((uint16_t)(p_descriptor->p_data[0] & 0x7f) << 8)
-            | p_descriptor->p_data[1];
-    p_decoded->i_mx_strategy = (p_descriptor->p_data[2] & 0xe0) >> 5;
+    dvbpsi_unpack_mx_buff_utilization_dr(p_decoded, p_descriptor->p_data);
 
     p_descriptor->p_decoded = (void*)p_decoded;
 
@@ -78,6 +76,26 @@ dvbpsi_mx_buff_utilization_dr_t * dvbpsi_DecodeMxBuffUtilizationDr(
 }
 
 
+/*****************************************************************************
+ * dvbpsi_EncodeMxBuffUtilizationDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeMxBuffUtilizationDr(uint8_t *p_buffer, size_t i_size,
+                                        dvbpsi_mx_buff_utilization_dr_t *p_decoded)
+{
+    size_t i_length = DVBPSI_MX_BUFF_UTILIZATION_DR_LENGTH;
+    if (i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x0c;
+    p_buffer[1] = i_length;
+
+    /* Encode data */
+    dvbpsi_pack_mx_buff_utilization_dr(p_data, p_decoded);
+
+    return 2 + i_length;
+}
+
 /*****************************************************************************
  * dvbpsi_GenMxBuffUtilizationDr
  *****************************************************************************/
@@ -85,17 +103,14 @@ dvbpsi_descriptor_t * dvbpsi_GenMxBuffUtilizationDr(
                                 dvbpsi_mx_buff_utilization_dr_t * p_decoded,
                                 bool b_duplicate)
 {
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor = dvbpsi_NewDescriptor(0x0c, 3, NULL);
-    if (!p_descriptor)
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeMxBuffUtilizationDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
         return NULL;
 
-    /* Encode data */
-    p_descriptor->p_data[0] = (p_decoded->i_mx_delay_variation >> 8) & 0x7f;
-    if(p_decoded->b_mdv_valid)
-        p_descriptor->p_data[0] |= 0x80;
-    p_descriptor->p_data[1] = p_decoded->i_mx_delay_variation;
-    p_descriptor->p_data[2] = 0x1f | p_decoded->i_mx_strategy << 5;
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
 
     if (b_duplicate)
     {
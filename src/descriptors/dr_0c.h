@@ -95,6 +95,17 @@ dvbpsi_descriptor_t * dvbpsi_GenMxBuffUtilizationDr(
                                 dvbpsi_mx_buff_utilization_dr_t * p_decoded,
                                 bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeMxBuffUtilizationDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeMxBuffUtilizationDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_mx_buff_utilization_dr_t *p_decoded)
+ * \brief "multiplex buffer utilization" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeMxBuffUtilizationDr(uint8_t *p_buffer, size_t i_size,
+                                        dvbpsi_mx_buff_utilization_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
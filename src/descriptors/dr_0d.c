@@ -35,10 +35,12 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
 #include "dr_0d.h"
+#include "dr_codec.h"
 
 
 /*****************************************************************************
@@ -57,21 +59,18 @@ dvbpsi_copyright_dr_t * dvbpsi_DecodeCopyrightDr(
     if (dvbpsi_IsDescriptorDecoded(p_descriptor))
         return p_descriptor->p_decoded;
 
-    if (p_descriptor->i_length < 4)
+    if (p_descriptor->i_length < DVBPSI_COPYRIGHT_DR_LENGTH)
         return NULL;
 
     /* Allocate memory */
     p_decoded = (dvbpsi_copyright_dr_t*)
-            malloc(sizeof(dvbpsi_copyright_dr_t));
+            dvbpsi_malloc(sizeof(dvbpsi_copyright_dr_t));
     if (!p_decoded)
         return NULL;
 
-    p_decoded->i_copyright_identifier =
-            ((uint32_t)(p_descriptor->p_data[0]) << 24)
-            | ((uint32_t)(p_descriptor->p_data[1]) << 16)
-            | ((uint32_t)(p_descriptor->p_data[2]) << 8)
-            | (uint32_t)(p_descriptor->p_data[3]);
-    p_decoded->i_additional_length = p_descriptor->i_length - 4;
+    dvbpsi_unpack_copyright_dr(p_decoded, p_descriptor->p_data);
+    p_decoded->i_additional_length =
+            p_descriptor->i_length - DVBPSI_COPYRIGHT_DR_LENGTH;
     if (p_decoded->i_additional_length > 251)
         p_decoded->i_additional_length = 251;
 
@@ -87,30 +86,47 @@ dvbpsi_copyright_dr_t * dvbpsi_DecodeCopyrightDr(
 
 
 /*****************************************************************************
- * dvbpsi_GenCopyrightDr
+ * dvbpsi_EncodeCopyrightDr
  *****************************************************************************/
-dvbpsi_descriptor_t * dvbpsi_GenCopyrightDr(dvbpsi_copyright_dr_t * p_decoded,
-                                            bool b_duplicate)
+size_t dvbpsi_EncodeCopyrightDr(uint8_t *p_buffer, size_t i_size,
+                                dvbpsi_copyright_dr_t *p_decoded)
 {
     if (p_decoded->i_additional_length > 251)
         p_decoded->i_additional_length = 251;
 
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor =
-            dvbpsi_NewDescriptor(0x0d, p_decoded->i_additional_length + 4, NULL);
-    if (!p_descriptor)
-        return NULL;
+    size_t i_length = p_decoded->i_additional_length + 4;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x0d;
+    p_buffer[1] = i_length;
 
     /* Encode data */
-    p_descriptor->p_data[0] = p_decoded->i_copyright_identifier >> 24;
-    p_descriptor->p_data[1] = p_decoded->i_copyright_identifier >> 16;
-    p_descriptor->p_data[2] = p_decoded->i_copyright_identifier >> 8;
-    p_descriptor->p_data[3] = p_decoded->i_copyright_identifier;
+    dvbpsi_pack_copyright_dr(p_data, p_decoded);
     if(p_decoded->i_additional_length)
-        memcpy(p_descriptor->p_data + 4,
+        memcpy(p_data + 4,
                p_decoded->i_additional_info,
                p_decoded->i_additional_length);
 
+    return 2 + i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_GenCopyrightDr
+ *****************************************************************************/
+dvbpsi_descriptor_t * dvbpsi_GenCopyrightDr(dvbpsi_copyright_dr_t * p_decoded,
+                                            bool b_duplicate)
+{
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeCopyrightDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
+
     if (b_duplicate)
     {
         /* Duplicate decoded data */
@@ -95,6 +95,17 @@ dvbpsi_descriptor_t * dvbpsi_GenCopyrightDr(
                                         dvbpsi_copyright_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeCopyrightDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeCopyrightDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_copyright_dr_t *p_decoded)
+ * \brief "copyright" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeCopyrightDr(uint8_t *p_buffer, size_t i_size,
+                                dvbpsi_copyright_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
@@ -35,10 +35,12 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
 #include "dr_0e.h"
+#include "dr_codec.h"
 
 
 /*****************************************************************************
@@ -57,39 +59,55 @@ dvbpsi_max_bitrate_dr_t * dvbpsi_DecodeMaxBitrateDr(
     if (dvbpsi_IsDescriptorDecoded(p_descriptor))
         return p_descriptor->p_decoded;
 
-    if (p_descriptor->i_length != 3)
+    if (p_descriptor->i_length != DVBPSI_MAX_BITRATE_DR_LENGTH)
         return NULL;
 
     /* Allocate memory */
-    p_decoded = (dvbpsi_max_bitrate_dr_t*)malloc(sizeof(dvbpsi_max_bitrate_dr_t));
+    p_decoded = (dvbpsi_max_bitrate_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_max_bitrate_dr_t));
     if (!p_decoded)
         return NULL;
 
-    p_decoded->i_max_bitrate =
-            ((uint32_t)(p_descriptor->p_data[0] & 0x3f) << 16)
-            | ((uint32_t)(p_descriptor->p_data[1]) << 8)
-            | p_descriptor->p_data[2];
+    dvbpsi_unpack_max_bitrate_dr(p_decoded, p_descriptor->p_data);
 
     p_descriptor->p_decoded = (void*)p_decoded;
 
     return p_decoded;
 }
 
+/*****************************************************************************
+ * dvbpsi_EncodeMaxBitrateDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeMaxBitrateDr(uint8_t *p_buffer, size_t i_size,
+                                 dvbpsi_max_bitrate_dr_t *p_decoded)
+{
+    size_t i_length = DVBPSI_MAX_BITRATE_DR_LENGTH;
+    if (i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x0e;
+    p_buffer[1] = i_length;
+
+    /* Encode data */
+    dvbpsi_pack_max_bitrate_dr(p_data, p_decoded);
+
+    return 2 + i_length;
+}
+
 /*****************************************************************************
  * dvbpsi_GenMaxBitrateDr
  *****************************************************************************/
 dvbpsi_descriptor_t * dvbpsi_GenMaxBitrateDr(dvbpsi_max_bitrate_dr_t * p_decoded,
                                              bool b_duplicate)
 {
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor = dvbpsi_NewDescriptor(0x0e, 3, NULL);
-    if (!p_descriptor)
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeMaxBitrateDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
         return NULL;
 
-    /* Encode data */
-    p_descriptor->p_data[0] = 0xc0 | ((p_decoded->i_max_bitrate >> 16) & 0x3f);
-    p_descriptor->p_data[1] = p_decoded->i_max_bitrate >> 8;
-    p_descriptor->p_data[2] = p_decoded->i_max_bitrate;
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
 
     if (b_duplicate)
     {
@@ -92,6 +92,17 @@ dvbpsi_descriptor_t * dvbpsi_GenMaxBitrateDr(
                                         dvbpsi_max_bitrate_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeMaxBitrateDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeMaxBitrateDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_max_bitrate_dr_t *p_decoded)
+ * \brief "maximum bitrate" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeMaxBitrateDr(uint8_t *p_buffer, size_t i_size,
+                                 dvbpsi_max_bitrate_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
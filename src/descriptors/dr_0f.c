@@ -35,10 +35,12 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
 #include "dr_0f.h"
+#include "dr_codec.h"
 
 
 /*****************************************************************************
@@ -57,18 +59,15 @@ dvbpsi_private_data_dr_t * dvbpsi_DecodePrivateDataDr(
     if (dvbpsi_IsDescriptorDecoded(p_descriptor))
         return p_descriptor->p_decoded;
 
-    if (p_descriptor->i_length != 4)
+    if (p_descriptor->i_length != DVBPSI_PRIVATE_DATA_DR_LENGTH)
         return NULL;
 
     /* Allocate memory */
-    p_decoded = (dvbpsi_private_data_dr_t*)malloc(sizeof(dvbpsi_private_data_dr_t));
+    p_decoded = (dvbpsi_private_data_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_private_data_dr_t));
     if (!p_decoded)
         return NULL;
 
-    p_decoded->i_private_data =   ((uint32_t)(p_descriptor->p_data[0]) << 24)
-            | ((uint32_t)(p_descriptor->p_data[1]) << 16)
-            | ((uint32_t)(p_descriptor->p_data[2]) << 8)
-            | p_descriptor->p_data[3];
+    dvbpsi_unpack_private_data_dr(p_decoded, p_descriptor->p_data);
 
     p_descriptor->p_decoded = (void*)p_decoded;
 
@@ -76,6 +75,26 @@ dvbpsi_private_data_dr_t * dvbpsi_DecodePrivateDataDr(
 }
 
 
+/*****************************************************************************
+ * dvbpsi_EncodePrivateDataDr
+ *****************************************************************************/
+size_t dvbpsi_EncodePrivateDataDr(uint8_t *p_buffer, size_t i_size,
+                                  dvbpsi_private_data_dr_t *p_decoded)
+{
+    size_t i_length = DVBPSI_PRIVATE_DATA_DR_LENGTH;
+    if (i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x0f;
+    p_buffer[1] = i_length;
+
+    /* Encode data */
+    dvbpsi_pack_private_data_dr(p_data, p_decoded);
+
+    return 2 + i_length;
+}
+
 /*****************************************************************************
  * dvbpsi_GenPrivateDataDr
  *****************************************************************************/
@@ -83,16 +102,14 @@ dvbpsi_descriptor_t * dvbpsi_GenPrivateDataDr(
                                         dvbpsi_private_data_dr_t * p_decoded,
                                         bool b_duplicate)
 {
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor = dvbpsi_NewDescriptor(0x0f, 4, NULL);
-    if (!p_descriptor)
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodePrivateDataDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
         return NULL;
 
-    /* Encode data */
-    p_descriptor->p_data[0] = p_decoded->i_private_data >> 24;
-    p_descriptor->p_data[1] = p_decoded->i_private_data >> 16;
-    p_descriptor->p_data[2] = p_decoded->i_private_data >> 8;
-    p_descriptor->p_data[3] = p_decoded->i_private_data;
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
 
     if (b_duplicate)
     {
@@ -93,6 +93,17 @@ dvbpsi_descriptor_t * dvbpsi_GenPrivateDataDr(
                                         dvbpsi_private_data_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodePrivateDataDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodePrivateDataDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_private_data_dr_t *p_decoded)
+ * \brief "private data indicator" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodePrivateDataDr(uint8_t *p_buffer, size_t i_size,
+                                  dvbpsi_private_data_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
@@ -28,6 +28,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -50,7 +51,7 @@ dvbpsi_smoothing_buffer_dr_t* dvbpsi_DecodeSmoothingBufferDr(
     if (p_descriptor->i_length != 6)
         return NULL;
     
-    p_decoded = (dvbpsi_smoothing_buffer_dr_t*)malloc(sizeof(*p_decoded));
+    p_decoded = (dvbpsi_smoothing_buffer_dr_t*)dvbpsi_malloc(sizeof(*p_decoded));
     if (!p_decoded)
         return NULL;
     
@@ -69,21 +70,43 @@ dvbpsi_smoothing_buffer_dr_t* dvbpsi_DecodeSmoothingBufferDr(
     return p_decoded;
 }
 
+/*****************************************************************************
+ * dvbpsi_EncodeSmoothingBufferDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeSmoothingBufferDr(uint8_t *p_buffer, size_t i_size,
+                                      dvbpsi_smoothing_buffer_dr_t *p_decoded)
+{
+    size_t i_length = 6;
+    if (i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x10;
+    p_buffer[1] = i_length;
+
+    /* encode the data, making sure the reserved fields are set to all ones. */
+    p_data[0] = (p_decoded->i_sb_leak_rate >> 16) | 0xc0;
+    p_data[1] = p_decoded->i_sb_leak_rate >> 8;
+    p_data[2] = p_decoded->i_sb_leak_rate;
+    
+    p_data[3] = (p_decoded->i_sb_size >> 16) | 0xc0;
+    p_data[4] = p_decoded->i_sb_size >> 8;
+    p_data[5] = p_decoded->i_sb_size;
+
+    return 2 + i_length;
+}
+
 dvbpsi_descriptor_t * dvbpsi_GenSmoothingBufferDr(
                                       dvbpsi_smoothing_buffer_dr_t * p_decoded)
 {
-    dvbpsi_descriptor_t * p_descriptor = dvbpsi_NewDescriptor(0x10, 6, NULL);
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeSmoothingBufferDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
     if (!p_descriptor)
         return NULL;
-    
-    /* encode the data, making sure the reserved fields are set to all ones. */
-    p_descriptor->p_data[0] = (p_decoded->i_sb_leak_rate >> 16) | 0xc0;
-    p_descriptor->p_data[1] = p_decoded->i_sb_leak_rate >> 8;
-    p_descriptor->p_data[2] = p_decoded->i_sb_leak_rate;
-    
-    p_descriptor->p_data[3] = (p_decoded->i_sb_size >> 16) | 0xc0;
-    p_descriptor->p_data[4] = p_decoded->i_sb_size >> 8;
-    p_descriptor->p_data[5] = p_decoded->i_sb_size;
-    
+
     return p_descriptor;
 }
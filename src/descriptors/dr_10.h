@@ -72,6 +72,17 @@ dvbpsi_smoothing_buffer_dr_t* dvbpsi_DecodeSmoothingBufferDr(
 dvbpsi_descriptor_t * dvbpsi_GenSmoothingBufferDr(
                                       dvbpsi_smoothing_buffer_dr_t * p_decoded);
 
+/*****************************************************************************
+ * dvbpsi_EncodeSmoothingBufferDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeSmoothingBufferDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_smoothing_buffer_dr_t *p_decoded)
+ * \brief smoothing buffer descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeSmoothingBufferDr(uint8_t *p_buffer, size_t i_size,
+                                      dvbpsi_smoothing_buffer_dr_t *p_decoded);
+
 #ifdef __cplusplus
 }
 #endif
@@ -28,6 +28,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -49,7 +50,7 @@ dvbpsi_std_dr_t* dvbpsi_DecodeSTDDr(dvbpsi_descriptor_t * p_descriptor)
     if (p_descriptor->i_length != 1)
         return NULL;
 
-    p_decoded = (dvbpsi_std_dr_t*)malloc(sizeof(*p_decoded));
+    p_decoded = (dvbpsi_std_dr_t*)dvbpsi_malloc(sizeof(*p_decoded));
     if (!p_decoded)
         return NULL;
 
@@ -60,14 +61,36 @@ dvbpsi_std_dr_t* dvbpsi_DecodeSTDDr(dvbpsi_descriptor_t * p_descriptor)
     return p_decoded;
 }
 
+/*****************************************************************************
+ * dvbpsi_EncodeSTDDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeSTDDr(uint8_t *p_buffer, size_t i_size,
+                          dvbpsi_std_dr_t *p_decoded)
+{
+    size_t i_length = 1;
+    if (i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x11;
+    p_buffer[1] = i_length;
+
+    /* encode the data, making sure the reserved fields are set to all ones. */
+    p_data[0] = (0xfe | p_decoded->b_leak_valid_flag);
+
+    return 2 + i_length;
+}
+
 dvbpsi_descriptor_t * dvbpsi_GenSTDDr(dvbpsi_std_dr_t * p_decoded)
 {
-    dvbpsi_descriptor_t * p_descriptor = dvbpsi_NewDescriptor(0x11, 1, NULL);
-    if (!p_descriptor)
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeSTDDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
         return NULL;
 
-    /* encode the data, making sure the reserved fields are set to all ones. */
-    p_descriptor->p_data[0] = (0xfe | p_decoded->b_leak_valid_flag);
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
 
     return p_descriptor;
 }
@@ -66,6 +66,17 @@ dvbpsi_std_dr_t* dvbpsi_DecodeSTDDr(dvbpsi_descriptor_t * p_descriptor);
  */
 dvbpsi_descriptor_t * dvbpsi_GenSTDDr(dvbpsi_std_dr_t * p_decoded);
 
+/*****************************************************************************
+ * dvbpsi_EncodeSTDDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeSTDDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_std_dr_t *p_decoded)
+ * \brief STD descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeSTDDr(uint8_t *p_buffer, size_t i_size,
+                          dvbpsi_std_dr_t *p_decoded);
+
 #ifdef __cplusplus
 }
 #endif
@@ -28,6 +28,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -49,7 +50,7 @@ dvbpsi_ibp_dr_t* dvbpsi_DecodeIBPDr(dvbpsi_descriptor_t * p_descriptor)
     if (p_descriptor->i_length != 2)
         return NULL;
     
-    p_decoded = (dvbpsi_ibp_dr_t*)malloc(sizeof(*p_decoded));
+    p_decoded = (dvbpsi_ibp_dr_t*)dvbpsi_malloc(sizeof(*p_decoded));
     if (!p_decoded)
         return NULL;
     
@@ -62,7 +63,7 @@ dvbpsi_ibp_dr_t* dvbpsi_DecodeIBPDr(dvbpsi_descriptor_t * p_descriptor)
     /* a value of 0 is forbidden for max_gop_length. */
     if(p_decoded->i_max_gop_length == 0)
     {
-        free(p_decoded);
+        dvbpsi_free(p_decoded);
         return NULL;
     }
     
@@ -71,18 +72,40 @@ dvbpsi_ibp_dr_t* dvbpsi_DecodeIBPDr(dvbpsi_descriptor_t * p_descriptor)
     return p_decoded;
 }
 
+/*****************************************************************************
+ * dvbpsi_EncodeIBPDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeIBPDr(uint8_t *p_buffer, size_t i_size,
+                          dvbpsi_ibp_dr_t *p_decoded)
+{
+    size_t i_length = 2;
+    if (i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x12;
+    p_buffer[1] = i_length;
+
+    /* encode the data. */
+    p_data[0]  = p_decoded->b_closed_gop_flag << 7;
+    p_data[0] |= p_decoded->b_identical_gop_flag << 6;
+    p_data[0] |= p_decoded->i_max_gop_length >> 8;
+    
+    p_data[1] = p_decoded->i_max_gop_length;
+
+    return 2 + i_length;
+}
+
 dvbpsi_descriptor_t * dvbpsi_GenIBPDr(dvbpsi_ibp_dr_t * p_decoded)
 {
-    dvbpsi_descriptor_t * p_descriptor = dvbpsi_NewDescriptor(0x12, 2, NULL);
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeIBPDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
     if (!p_descriptor)
         return NULL;
-    
-    /* encode the data. */
-    p_descriptor->p_data[0]  = p_decoded->b_closed_gop_flag << 7;
-    p_descriptor->p_data[0] |= p_decoded->b_identical_gop_flag << 6;
-    p_descriptor->p_data[0] |= p_decoded->i_max_gop_length >> 8;
-    
-    p_descriptor->p_data[1] = p_decoded->i_max_gop_length;
-    
+
     return p_descriptor;
 }
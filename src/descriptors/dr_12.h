@@ -68,6 +68,17 @@ dvbpsi_ibp_dr_t* dvbpsi_DecodeIBPDr(dvbpsi_descriptor_t * p_descriptor);
  */
 dvbpsi_descriptor_t * dvbpsi_GenIBPDr(dvbpsi_ibp_dr_t * p_decoded);
 
+/*****************************************************************************
+ * dvbpsi_EncodeIBPDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeIBPDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_ibp_dr_t *p_decoded)
+ * \brief IBP descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeIBPDr(uint8_t *p_buffer, size_t i_size,
+                          dvbpsi_ibp_dr_t *p_decoded);
+
 #ifdef __cplusplus
 }
 #endif
@@ -34,6 +34,7 @@ Decode Carousel Id Descriptor.
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -45,7 +46,7 @@ static dvbpsi_carousel_id_dr_t *NewCarouselDr(const size_t i_private)
     if (i_private <= 0)
         return NULL;
     p_carousel = (dvbpsi_carousel_id_dr_t *)
-                    calloc(1, sizeof(dvbpsi_carousel_id_dr_t) + i_private);
+                    dvbpsi_calloc(1, sizeof(dvbpsi_carousel_id_dr_t) + i_private);
     if (p_carousel)
     {
         p_carousel->p_private_data = ((uint8_t *)p_carousel + sizeof(dvbpsi_carousel_id_dr_t));
@@ -34,6 +34,7 @@ Decode Assocation Tag Descriptor.
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -47,7 +48,7 @@ static dvbpsi_association_tag_dr_t *NewAssociationTagDr(const size_t i_selector,
         return NULL;
 
     size_t i_size = sizeof(dvbpsi_association_tag_dr_t) + i_selector + i_private;
-    p_tag = (dvbpsi_association_tag_dr_t*) calloc(1, i_size);
+    p_tag = (dvbpsi_association_tag_dr_t*) dvbpsi_calloc(1, i_size);
     if (p_tag)
     {
         p_tag->p_selector = ((uint8_t*)p_tag + sizeof(dvbpsi_association_tag_dr_t));
@@ -28,6 +28,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -50,7 +51,7 @@ dvbpsi_mpeg4_video_dr_t* dvbpsi_DecodeMPEG4VideoDr(
     if (p_descriptor->i_length != 1)
         return NULL;
 
-    p_decoded = (dvbpsi_mpeg4_video_dr_t*)malloc(sizeof(*p_decoded));
+    p_decoded = (dvbpsi_mpeg4_video_dr_t*)dvbpsi_malloc(sizeof(*p_decoded));
     if (!p_decoded)
         return NULL;
 
@@ -61,15 +62,37 @@ dvbpsi_mpeg4_video_dr_t* dvbpsi_DecodeMPEG4VideoDr(
     return p_decoded;
 }
 
+/*****************************************************************************
+ * dvbpsi_EncodeMPEG4VideoDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeMPEG4VideoDr(uint8_t *p_buffer, size_t i_size,
+                                 dvbpsi_mpeg4_video_dr_t *p_decoded)
+{
+    size_t i_length = 1;
+    if (i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x1b;
+    p_buffer[1] = i_length;
+
+    /* encode the data. */
+    p_data[0] = p_decoded->i_mpeg4_visual_profile_and_level;
+
+    return 2 + i_length;
+}
+
 dvbpsi_descriptor_t * dvbpsi_GenMPEG4VideoDr(
                                       dvbpsi_mpeg4_video_dr_t * p_decoded)
 {
-    dvbpsi_descriptor_t * p_descriptor = dvbpsi_NewDescriptor(0x1b, 1, NULL);
-    if (!p_descriptor)
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeMPEG4VideoDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
         return NULL;
 
-    /* encode the data. */
-    p_descriptor->p_data[0] = p_decoded->i_mpeg4_visual_profile_and_level;
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
 
     return p_descriptor;
 }
@@ -136,6 +136,17 @@ dvbpsi_mpeg4_video_dr_t* dvbpsi_DecodeMPEG4VideoDr(
 dvbpsi_descriptor_t * dvbpsi_GenMPEG4VideoDr(
                                       dvbpsi_mpeg4_video_dr_t * p_decoded);
 
+/*****************************************************************************
+ * dvbpsi_EncodeMPEG4VideoDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeMPEG4VideoDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_mpeg4_video_dr_t *p_decoded)
+ * \brief MPEG-4 video descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeMPEG4VideoDr(uint8_t *p_buffer, size_t i_size,
+                                 dvbpsi_mpeg4_video_dr_t *p_decoded);
+
 #ifdef __cplusplus
 }
 #endif
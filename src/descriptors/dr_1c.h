@@ -71,6 +71,17 @@ dvbpsi_mpeg4_audio_dr_t* dvbpsi_DecodeMPEG4AudioDr(
 dvbpsi_descriptor_t * dvbpsi_GenMPEG4AudioDr(
                                       dvbpsi_mpeg4_audio_dr_t * p_decoded);
 
+/*****************************************************************************
+ * dvbpsi_EncodeMPEG4AudioDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeMPEG4AudioDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_mpeg4_audio_dr_t *p_decoded)
+ * \brief MPEG-4 audio descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeMPEG4AudioDr(uint8_t *p_buffer, size_t i_size,
+                                 dvbpsi_mpeg4_audio_dr_t *p_decoded);
+
 #ifdef __cplusplus
 }
 #endif
@@ -34,6 +34,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -56,7 +57,7 @@ dvbpsi_network_name_dr_t* dvbpsi_DecodeNetworkNameDr(
        return p_descriptor->p_decoded;
 
     /* Allocate memory */
-    p_decoded = (dvbpsi_network_name_dr_t*)calloc(1, sizeof(dvbpsi_network_name_dr_t));
+    p_decoded = (dvbpsi_network_name_dr_t*)dvbpsi_calloc(1, sizeof(dvbpsi_network_name_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -74,6 +75,29 @@ dvbpsi_network_name_dr_t* dvbpsi_DecodeNetworkNameDr(
 }
 
 
+/*****************************************************************************
+ * dvbpsi_EncodeNetworkNameDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeNetworkNameDr(uint8_t *p_buffer, size_t i_size,
+                                  dvbpsi_network_name_dr_t *p_decoded)
+{
+    size_t i_length = p_decoded->i_name_length;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x40;
+    p_buffer[1] = i_length;
+
+    /* Encode data */
+    if (p_decoded->i_name_length)
+        memcpy(p_data,
+               p_decoded->i_name_byte,
+               p_decoded->i_name_length);
+
+    return 2 + i_length;
+}
+
 /*****************************************************************************
  * dvbpsi_GenNetworkNameDr
  *****************************************************************************/
@@ -81,18 +105,15 @@ dvbpsi_descriptor_t * dvbpsi_GenNetworkNameDr(
                                         dvbpsi_network_name_dr_t * p_decoded,
                                         bool b_duplicate)
 {
-    /* Create the descriptor */
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeNetworkNameDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
     dvbpsi_descriptor_t * p_descriptor =
-            dvbpsi_NewDescriptor(0x40, p_decoded->i_name_length, NULL);
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
     if (!p_descriptor)
         return NULL;
 
-    /* Encode data */
-    if (p_decoded->i_name_length)
-        memcpy(p_descriptor->p_data,
-               p_decoded->i_name_byte,
-               p_decoded->i_name_length);
-
     if (b_duplicate)
     {
         /* Duplicate decoded data */
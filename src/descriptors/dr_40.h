@@ -95,6 +95,17 @@ dvbpsi_descriptor_t * dvbpsi_GenNetworkNameDr(
                                         dvbpsi_network_name_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeNetworkNameDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeNetworkNameDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_network_name_dr_t *p_decoded)
+ * \brief "network name" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeNetworkNameDr(uint8_t *p_buffer, size_t i_size,
+                                  dvbpsi_network_name_dr_t *p_decoded);
+
 #ifdef __cplusplus
 };
 #endif
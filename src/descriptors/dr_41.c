@@ -34,19 +34,21 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
 #include "dr_41.h"
 
 /*****************************************************************************
- * dvbpsi_DecodeServiceListDr
+ * dvbpsi_ServiceListDrDecode
+ *****************************************************************************
+ * Decodes into i_size bytes, the whole dvbpsi_service_list_dr_t or only
+ * the services of the descriptor.
  *****************************************************************************/
-dvbpsi_service_list_dr_t* dvbpsi_DecodeServiceListDr(
-                                        dvbpsi_descriptor_t * p_descriptor)
+static void *dvbpsi_ServiceListDrDecode(dvbpsi_descriptor_t * p_descriptor,
+                                        bool b_counted)
 {
-    dvbpsi_service_list_dr_t * p_decoded;
-
     /* Check the tag */
     if (p_descriptor->i_tag != 0x41)
         return NULL;
@@ -58,12 +60,13 @@ dvbpsi_service_list_dr_t* dvbpsi_DecodeServiceListDr(
     /* Check the length */
     unsigned int service_count = p_descriptor->i_length / 3;
     if ((p_descriptor->i_length < 1) ||
-        (p_descriptor->i_length % 3 != 0) ||
-        (service_count>63))
+        (p_descriptor->i_length % 3 != 0))
       return NULL;
 
     /* Allocate memory */
-    p_decoded = (dvbpsi_service_list_dr_t*)calloc(1, sizeof(dvbpsi_service_list_dr_t));
+    size_t i_size = b_counted ? DVBPSI_SERVICE_LIST_COUNTED_SIZE(service_count)
+                              : sizeof(dvbpsi_service_list_dr_t);
+    dvbpsi_service_list_counted_t * p_decoded = dvbpsi_calloc(1, i_size);
     if (!p_decoded)
         return NULL;
 
@@ -82,6 +85,53 @@ dvbpsi_service_list_dr_t* dvbpsi_DecodeServiceListDr(
     return p_decoded;
 }
 
+/*****************************************************************************
+ * dvbpsi_DecodeServiceListDr
+ *****************************************************************************/
+dvbpsi_service_list_dr_t* dvbpsi_DecodeServiceListDr(
+                                        dvbpsi_descriptor_t * p_descriptor)
+{
+    return dvbpsi_ServiceListDrDecode(p_descriptor, false);
+}
+
+/*****************************************************************************
+ * dvbpsi_DecodeServiceListDrCounted
+ *****************************************************************************/
+dvbpsi_service_list_counted_t* dvbpsi_DecodeServiceListDrCounted(
+                                        dvbpsi_descriptor_t * p_descriptor)
+{
+    return dvbpsi_ServiceListDrDecode(p_descriptor, true);
+}
+
+
+/*****************************************************************************
+ * dvbpsi_EncodeServiceListDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeServiceListDr(uint8_t *p_buffer, size_t i_size,
+                                  dvbpsi_service_list_dr_t *p_decoded)
+{
+    /* Check the length */
+    if (p_decoded->i_service_count > DVBPSI_SERVICE_LIST_DR_MAX)
+        return 0;
+
+    size_t i_length = p_decoded->i_service_count*3;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x41;
+    p_buffer[1] = i_length;
+
+    /* Encode data */
+    for (uint8_t i = 0; i < p_decoded->i_service_count; i++)
+    {
+        p_data[i*3] = p_decoded->i_service[i].i_service_id >> 8;
+        p_data[i*3+1] = p_decoded->i_service[i].i_service_id;
+        p_data[i*3+2] = p_decoded->i_service[i].i_service_type;
+    }
+
+    return 2 + i_length;
+}
 
 /*****************************************************************************
  * dvbpsi_GenServiceListDr
@@ -90,30 +140,21 @@ dvbpsi_descriptor_t * dvbpsi_GenServiceListDr(
 		                        dvbpsi_service_list_dr_t * p_decoded,
                                         bool b_duplicate)
 {
-    /* Check the length */
-    if (p_decoded->i_service_count > 63)
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeServiceListDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
         return NULL;
 
-    /* Create the descriptor */
     dvbpsi_descriptor_t * p_descriptor =
-            dvbpsi_NewDescriptor(0x83, p_decoded->i_service_count*3, NULL);
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
     if (!p_descriptor)
         return NULL;
 
-    /* Encode data */
-    for (uint8_t i = 0; i < p_decoded->i_service_count; i++)
-    {
-        p_descriptor->p_data[i*3] = p_decoded->i_service[i].i_service_id >> 8;
-        p_descriptor->p_data[i*3+1] = p_decoded->i_service[i].i_service_id;
-        p_descriptor->p_data[i*3+2] = p_decoded->i_service[i].i_service_type;
-    }
-
     if (b_duplicate)
     {
-        /* Duplicate decoded data */
+        /* Duplicate decoded data, which may be a counted form */
         p_descriptor->p_decoded =
                dvbpsi_DuplicateDecodedDescriptor(p_decoded,
-                       sizeof(dvbpsi_service_list_dr_t));
+                       DVBPSI_SERVICE_LIST_COUNTED_SIZE(p_decoded->i_service_count));
     }
 
     return p_descriptor;
@@ -38,8 +38,32 @@
 extern "C" {
 #endif
 
+/*!
+ * \def DVBPSI_SERVICE_LIST_DR_MAX
+ * \brief Maximum number of services of a "service list" descriptor, 3 bytes
+ * each.
+ */
+#define DVBPSI_SERVICE_LIST_DR_MAX 85
+
 /*****************************************************************************
- * dvbpsi_network_name_dr_t
+ * dvbpsi_service_list_entry_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_service_list_entry_s
+ * \brief Service of a "service list" descriptor.
+ */
+/*!
+ * \typedef struct dvbpsi_service_list_entry_s dvbpsi_service_list_entry_t
+ * \brief dvbpsi_service_list_entry_t type definition.
+ */
+typedef struct dvbpsi_service_list_entry_s
+{
+  uint16_t     i_service_id;                /*!< service id */
+  uint8_t      i_service_type;              /*!< service type */
+} dvbpsi_service_list_entry_t;
+
+/*****************************************************************************
+ * dvbpsi_service_list_dr_t
  *****************************************************************************/
 /*!
  * \struct dvbpsi_service_list_dr_s
@@ -47,6 +71,12 @@ extern "C" {
  *
  * This structure is used to store a decoded "service list"
  * descriptor. (ETSI EN 300 468 section 6.2.35).
+ *
+ * The descriptors decoded by dvbpsi_decode_descriptors() or through
+ * DVBPSI_FLAG_DESCRIPTOR_CACHE hold the counted form,
+ * dvbpsi_service_list_counted_t, of which this structure is the prefix:
+ * only its first i_service_count services are then there, and it must not
+ * be copied as a whole.
  */
 /*!
  * \typedef struct dvbpsi_service_list_dr_s dvbpsi_service_list_dr_t
@@ -56,13 +86,36 @@ typedef struct dvbpsi_service_list_dr_s
 {
   uint8_t       i_service_count;            /*!< length of the i_service_list
   	                                             array */
-  struct {
-      uint16_t     i_service_id;            /*!< service id */
-      uint8_t      i_service_type;          /*!< service type */
-  } i_service[64];                          /*!< array of services */
+  dvbpsi_service_list_entry_t i_service[DVBPSI_SERVICE_LIST_DR_MAX];
+                                            /*!< array of services */
 
 } dvbpsi_service_list_dr_t;
 
+/*****************************************************************************
+ * dvbpsi_service_list_counted_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_service_list_counted_s
+ * \brief "service list" descriptor structure sized to its services.
+ */
+/*!
+ * \typedef struct dvbpsi_service_list_counted_s dvbpsi_service_list_counted_t
+ * \brief dvbpsi_service_list_counted_t type definition.
+ */
+typedef struct dvbpsi_service_list_counted_s
+{
+  uint8_t       i_service_count;            /*!< length of the i_service
+                                                 array */
+  dvbpsi_service_list_entry_t i_service[];  /*!< array of services */
+} dvbpsi_service_list_counted_t;
+
+/*!
+ * \def DVBPSI_SERVICE_LIST_COUNTED_SIZE(count)
+ * \brief Size of a dvbpsi_service_list_counted_t of count services.
+ */
+#define DVBPSI_SERVICE_LIST_COUNTED_SIZE(count)                                \
+    (sizeof(dvbpsi_service_list_counted_t) + (count) * sizeof(dvbpsi_service_list_entry_t))
+
 /*****************************************************************************
  * dvbpsi_DecodeServiceListDr
  *****************************************************************************/
@@ -77,6 +130,25 @@ typedef struct dvbpsi_service_list_dr_s
 dvbpsi_service_list_dr_t* dvbpsi_DecodeServiceListDr(
                                         dvbpsi_descriptor_t * p_descriptor);
 
+/*****************************************************************************
+ * dvbpsi_DecodeServiceListDrCounted
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_service_list_counted_t * dvbpsi_DecodeServiceListDrCounted(
+                                        dvbpsi_descriptor_t * p_descriptor)
+ * \brief "service list" descriptor decoder, sized to the services.
+ * \param p_descriptor pointer to the descriptor structure
+ * \return a pointer to the decoded data, stored in
+ * dvbpsi_descriptor_t::p_decoded as dvbpsi_DecodeServiceListDr() does.
+ *
+ * The decoded form only holds the services of the descriptor instead of
+ * the DVBPSI_SERVICE_LIST_DR_MAX of dvbpsi_service_list_dr_t. It is allocated like the descriptor, from the
+ * arena of its table with DVBPSI_FLAG_TABLE_ARENA. A descriptor already
+ * decoded by dvbpsi_DecodeServiceListDr() is returned as is.
+ */
+dvbpsi_service_list_counted_t* dvbpsi_DecodeServiceListDrCounted(
+                                        dvbpsi_descriptor_t * p_descriptor);
+
 
 /*****************************************************************************
  * dvbpsi_GenServiceListDr
@@ -95,6 +167,17 @@ dvbpsi_descriptor_t * dvbpsi_GenServiceListDr(
 		                        dvbpsi_service_list_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeServiceListDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeServiceListDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_service_list_dr_t *p_decoded)
+ * \brief "service list" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeServiceListDr(uint8_t *p_buffer, size_t i_size,
+                                  dvbpsi_service_list_dr_t *p_decoded);
+
 #ifdef __cplusplus
 };
 #endif
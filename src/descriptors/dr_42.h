@@ -96,6 +96,17 @@ dvbpsi_descriptor_t * dvbpsi_GenStuffingDr(
                                         dvbpsi_stuffing_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeStuffingDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeStuffingDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_stuffing_dr_t *p_decoded)
+ * \brief "stuffing" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeStuffingDr(uint8_t *p_buffer, size_t i_size,
+                               dvbpsi_stuffing_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
@@ -101,6 +101,17 @@ dvbpsi_descriptor_t * dvbpsi_GenSatDelivSysDr(
                                         dvbpsi_sat_deliv_sys_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeSatDelivSysDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeSatDelivSysDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_sat_deliv_sys_dr_t *p_decoded)
+ * \brief satellite delivery system descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeSatDelivSysDr(uint8_t *p_buffer, size_t i_size,
+                                  dvbpsi_sat_deliv_sys_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
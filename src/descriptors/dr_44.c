@@ -35,6 +35,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -59,7 +60,7 @@ dvbpsi_cable_deliv_sys_dr_t * dvbpsi_DecodeCableDelivSysDr(
 
   /* Allocate memory */
   p_decoded =
-        (dvbpsi_cable_deliv_sys_dr_t*)malloc(sizeof(dvbpsi_cable_deliv_sys_dr_t));
+        (dvbpsi_cable_deliv_sys_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_cable_deliv_sys_dr_t));
   if (!p_decoded)
     return NULL;
 
@@ -81,6 +82,36 @@ dvbpsi_cable_deliv_sys_dr_t * dvbpsi_DecodeCableDelivSysDr(
   return p_decoded;
 }
 
+/*****************************************************************************
+ * dvbpsi_EncodeCableDelivSysDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeCableDelivSysDr(uint8_t *p_buffer, size_t i_size,
+                                    dvbpsi_cable_deliv_sys_dr_t *p_decoded)
+{
+    size_t i_length = 11;
+    if (i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x44;
+    p_buffer[1] = i_length;
+
+    /* Encode data */
+    p_data[0]  =     (p_decoded->i_frequency >> 24)       & 0xff;
+    p_data[1]  =     (p_decoded->i_frequency >> 16)       & 0xff;
+    p_data[2]  =     (p_decoded->i_frequency >>  8)       & 0xff;
+    p_data[3]  =      p_decoded->i_frequency              & 0xff;
+    p_data[5]  =     (p_decoded->i_fec_outer              & 0x0f);
+    p_data[6]  =     (p_decoded->i_modulation);
+    p_data[7]  =     (p_decoded->i_symbol_rate >> 20)     & 0xff;
+    p_data[8]  =     (p_decoded->i_symbol_rate >> 12)     & 0xff;
+    p_data[9]  =     (p_decoded->i_symbol_rate >>  4)     & 0xff;
+    p_data[10] =    ((p_decoded->i_symbol_rate <<  4)     & 0xf0)
+                    |(p_decoded->i_fec_inner              & 0x0f);
+
+    return 2 + i_length;
+}
+
 /*****************************************************************************
  * dvbpsi_GenCableDelivSysDr
  *****************************************************************************/
@@ -88,25 +119,15 @@ dvbpsi_descriptor_t * dvbpsi_GenCableDelivSysDr(
                                         dvbpsi_cable_deliv_sys_dr_t * p_decoded,
                                         bool b_duplicate)
 {
-    /* Create the descriptor */
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeCableDelivSysDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
     dvbpsi_descriptor_t * p_descriptor =
-            dvbpsi_NewDescriptor(0x44, 11, NULL);
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
     if (!p_descriptor)
         return NULL;
 
-    /* Encode data */
-    p_descriptor->p_data[0]  =     (p_decoded->i_frequency >> 24)       & 0xff;
-    p_descriptor->p_data[1]  =     (p_decoded->i_frequency >> 16)       & 0xff;
-    p_descriptor->p_data[2]  =     (p_decoded->i_frequency >>  8)       & 0xff;
-    p_descriptor->p_data[3]  =      p_decoded->i_frequency              & 0xff;
-    p_descriptor->p_data[5]  =     (p_decoded->i_fec_outer              & 0x0f);
-    p_descriptor->p_data[6]  =     (p_decoded->i_modulation);
-    p_descriptor->p_data[7]  =     (p_decoded->i_symbol_rate >> 20)     & 0xff;
-    p_descriptor->p_data[8]  =     (p_decoded->i_symbol_rate >> 12)     & 0xff;
-    p_descriptor->p_data[9]  =     (p_decoded->i_symbol_rate >>  4)     & 0xff;
-    p_descriptor->p_data[10] =    ((p_decoded->i_symbol_rate <<  4)     & 0xf0)
-                                  |(p_decoded->i_fec_inner              & 0x0f);
-
     if(b_duplicate)
     {
         /* Duplicate decoded data */
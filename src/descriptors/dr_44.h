@@ -98,6 +98,17 @@ dvbpsi_descriptor_t * dvbpsi_GenCableDelivSysDr(
                                         dvbpsi_cable_deliv_sys_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeCableDelivSysDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeCableDelivSysDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_cable_deliv_sys_dr_t *p_decoded)
+ * \brief cable delivery system descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeCableDelivSysDr(uint8_t *p_buffer, size_t i_size,
+                                    dvbpsi_cable_deliv_sys_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
@@ -35,6 +35,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -67,7 +68,7 @@ dvbpsi_vbi_dr_t * dvbpsi_DecodeVBIDataDr(
         i_services_number = DVBPSI_VBI_DR_MAX;
 
     /* Allocate memory */
-    p_decoded = (dvbpsi_vbi_dr_t*)malloc(sizeof(dvbpsi_vbi_dr_t));
+    p_decoded = (dvbpsi_vbi_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_vbi_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -101,42 +102,61 @@ dvbpsi_vbi_dr_t * dvbpsi_DecodeVBIDataDr(
 }
 
 /*****************************************************************************
- * dvbpsi_GenVBIDataDr
+ * dvbpsi_EncodeVBIDataDr
  *****************************************************************************/
-dvbpsi_descriptor_t * dvbpsi_GenVBIDataDr(dvbpsi_vbi_dr_t * p_decoded,
-                                          bool b_duplicate)
+size_t dvbpsi_EncodeVBIDataDr(uint8_t *p_buffer, size_t i_size,
+                              dvbpsi_vbi_dr_t *p_decoded)
 {
-    if (p_decoded->i_services_number > DVBPSI_VBI_DR_MAX)
-        p_decoded->i_services_number = DVBPSI_VBI_DR_MAX;
+    /* 51 services of 5 bytes fill the 255 bytes of a descriptor */
+    if (p_decoded->i_services_number > 51)
+        p_decoded->i_services_number = 51;
 
-    /* Create the descriptor */
-    uint8_t i_size = (p_decoded->i_services_number * 5) > UINT8_MAX ?
-                        255 : (p_decoded->i_services_number * 5); /* FIXME: */
-    dvbpsi_descriptor_t * p_descriptor =
-            dvbpsi_NewDescriptor(0x45, i_size, NULL);
-    if (!p_descriptor)
-        return NULL;
+    size_t i_length = p_decoded->i_services_number * 5;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x45;
+    p_buffer[1] = i_length;
 
     /* Encode data */
     for (uint8_t i = 0; i < p_decoded->i_services_number; i++)
     {
-        p_descriptor->p_data[5 * i + 3] =
+        p_data[5 * i + 3] =
                 ( (uint8_t) p_decoded->p_services[i].i_data_service_id );
 
-        p_descriptor->p_data[5 * i + 4] = p_decoded->p_services[i].i_lines;
+        p_data[5 * i + 4] = p_decoded->p_services[i].i_lines;
         for (uint8_t n=0; n < p_decoded->p_services[i].i_lines; n++ )
         {
             if( (p_decoded->p_services[i].i_data_service_id >= 0x01) &&
                     (p_decoded->p_services[i].i_data_service_id <= 0x07) )
             {
-                p_descriptor->p_data[5 * i + 4 + n] = (uint8_t)
+                p_data[5 * i + 4 + n] = (uint8_t)
                         ( (((uint8_t) p_decoded->p_services[i].p_lines[n].i_parity)&0x20)<<5) |
                         ( ((uint8_t) p_decoded->p_services[i].p_lines[n].i_line_offset)&0x1f);
             }
-            else p_descriptor->p_data[5 * i + 3 + n] = 0xFF; /* Stuffing byte */
+            else p_data[5 * i + 3 + n] = 0xFF; /* Stuffing byte */
         }
     }
 
+    return 2 + i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_GenVBIDataDr
+ *****************************************************************************/
+dvbpsi_descriptor_t * dvbpsi_GenVBIDataDr(dvbpsi_vbi_dr_t * p_decoded,
+                                          bool b_duplicate)
+{
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeVBIDataDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
+
     if (b_duplicate)
     {
         /* Duplicate decoded data */
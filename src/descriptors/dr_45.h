@@ -151,6 +151,17 @@ dvbpsi_descriptor_t * dvbpsi_GenVBIDataDr(
                                         dvbpsi_vbi_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeVBIDataDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeVBIDataDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_vbi_dr_t *p_decoded)
+ * \brief "VBI data" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeVBIDataDr(uint8_t *p_buffer, size_t i_size,
+                              dvbpsi_vbi_dr_t *p_decoded);
+
 #ifdef __cplusplus
 };
 #endif
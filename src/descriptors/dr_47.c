@@ -36,6 +36,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -59,7 +60,7 @@ dvbpsi_bouquet_name_dr_t * dvbpsi_DecodeBouquetNameDr(
         return p_descriptor->p_decoded;
 
     /* Allocate memory */
-    p_decoded = (dvbpsi_bouquet_name_dr_t*)malloc(sizeof(dvbpsi_bouquet_name_dr_t));
+    p_decoded = (dvbpsi_bouquet_name_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_bouquet_name_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -77,24 +78,44 @@ dvbpsi_bouquet_name_dr_t * dvbpsi_DecodeBouquetNameDr(
 }
 
 
+/*****************************************************************************
+ * dvbpsi_EncodeBouquetNameDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeBouquetNameDr(uint8_t *p_buffer, size_t i_size,
+                                  dvbpsi_bouquet_name_dr_t *p_decoded)
+{
+    size_t i_length = p_decoded->i_name_length;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x47;
+    p_buffer[1] = i_length;
+
+    /* Encode data */
+    if(p_decoded->i_name_length)
+        memcpy(p_data,
+               p_decoded->i_char,
+               p_decoded->i_name_length);
+
+    return 2 + i_length;
+}
+
 /*****************************************************************************
  * dvbpsi_GenBouquetNameDr
  *****************************************************************************/
 dvbpsi_descriptor_t * dvbpsi_GenBouquetNameDr(dvbpsi_bouquet_name_dr_t *p_decoded,
                                         bool b_duplicate)
 {
-    /* Create the descriptor */
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeBouquetNameDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
     dvbpsi_descriptor_t * p_descriptor =
-            dvbpsi_NewDescriptor(0x47, p_decoded->i_name_length, NULL);
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
     if (!p_descriptor)
         return NULL;
 
-    /* Encode data */
-    if(p_decoded->i_name_length)
-        memcpy(p_descriptor->p_data,
-               p_decoded->i_char,
-               p_decoded->i_name_length);
-
     if (b_duplicate)
     {
         /* Duplicate decoded data */
@@ -95,6 +95,17 @@ dvbpsi_descriptor_t * dvbpsi_GenBouquetNameDr(
                                         dvbpsi_bouquet_name_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeBouquetNameDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeBouquetNameDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_bouquet_name_dr_t *p_decoded)
+ * \brief "bouquet name" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeBouquetNameDr(uint8_t *p_buffer, size_t i_size,
+                                  dvbpsi_bouquet_name_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
@@ -36,6 +36,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -61,7 +62,7 @@ dvbpsi_service_dr_t * dvbpsi_DecodeServiceDr(
 
     /* Allocate memory */
     dvbpsi_service_dr_t * p_decoded;
-    p_decoded = (dvbpsi_service_dr_t*)calloc(1, sizeof(dvbpsi_service_dr_t));
+    p_decoded = (dvbpsi_service_dr_t*)dvbpsi_calloc(1, sizeof(dvbpsi_service_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -106,41 +107,100 @@ dvbpsi_service_dr_t * dvbpsi_DecodeServiceDr(
 }
 
 /*****************************************************************************
- * dvbpsi_GenServiceDr
+ * dvbpsi_DecodeServiceDrCompact
  *****************************************************************************/
-dvbpsi_descriptor_t * dvbpsi_GenServiceDr(dvbpsi_service_dr_t * p_decoded,
-                                          bool b_duplicate)
+bool dvbpsi_DecodeServiceDrCompact(dvbpsi_descriptor_t * p_descriptor,
+                                   dvbpsi_service_compact_t * p_compact)
+{
+    /* Check the tag */
+    if (!dvbpsi_CanDecodeAsDescriptor(p_descriptor, 0x48))
+        return false;
+
+    if (p_descriptor->i_length < 3)
+        return false;
+
+    uint8_t *p_data = p_descriptor->p_data;
+    int i_provider_length = p_data[1];
+
+    p_compact->i_service_type = p_data[0];
+    p_compact->i_service_provider_name_length = 0;
+    p_compact->p_service_provider_name = p_data + 2;
+    p_compact->i_service_name_length = 0;
+    p_compact->p_service_name = p_data + 2;
+
+    if (i_provider_length + 2 > p_descriptor->i_length)
+        return true;
+
+    p_compact->i_service_provider_name_length = i_provider_length;
+    p_compact->p_service_name = p_data + 3 + i_provider_length;
+
+    if (i_provider_length + 3 > p_descriptor->i_length)
+        return true;
+
+    int i_name_length = p_data[2 + i_provider_length];
+    if (i_provider_length + 3 + i_name_length > p_descriptor->i_length)
+        return true;
+
+    p_compact->i_service_name_length = i_name_length;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_EncodeServiceDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeServiceDr(uint8_t *p_buffer, size_t i_size,
+                              dvbpsi_service_dr_t *p_decoded)
 {
+    /* The descriptor data cannot exceed 255 bytes: the two names share the
+     * 252 bytes left by the 3 bytes of service_type and lengths */
     if (p_decoded->i_service_provider_name_length > 252)
         p_decoded->i_service_provider_name_length = 252;
-    if (p_decoded->i_service_name_length > 252)
-        p_decoded->i_service_name_length = 252;
+    if (p_decoded->i_service_name_length >
+                            252 - p_decoded->i_service_provider_name_length)
+        p_decoded->i_service_name_length =
+                            252 - p_decoded->i_service_provider_name_length;
 
-    /* FIXME: is this correct? A descriptor cannot be more then 255 bytes due to
-     * the function prototype definition */
-    uint8_t i_size = 0;
-    int i_length = 3 + p_decoded->i_service_name_length + p_decoded->i_service_provider_name_length;
-    i_size = (i_length >= UINT8_MAX) ? 255 : i_length;
+    size_t i_length = 3 + p_decoded->i_service_provider_name_length
+                                         + p_decoded->i_service_name_length;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
 
-    /* Create the descriptor */
-    dvbpsi_descriptor_t *p_descriptor = dvbpsi_NewDescriptor(0x48, i_size, NULL);
-    if (!p_descriptor)
-        return NULL;
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x48;
+    p_buffer[1] = i_length;
 
     /* Encode data */
-    p_descriptor->p_data[0] = p_decoded->i_service_type;
-    p_descriptor->p_data[1] = p_decoded->i_service_provider_name_length;
+    p_data[0] = p_decoded->i_service_type;
+    p_data[1] = p_decoded->i_service_provider_name_length;
     if (p_decoded->i_service_provider_name_length)
-        memcpy(p_descriptor->p_data + 2,
+        memcpy(p_data + 2,
                p_decoded->i_service_provider_name,
                p_decoded->i_service_provider_name_length);
-    p_descriptor->p_data[2+p_decoded->i_service_provider_name_length] =
+    p_data[2+p_decoded->i_service_provider_name_length] =
             p_decoded->i_service_name_length;
     if (p_decoded->i_service_name_length)
-        memcpy(p_descriptor->p_data + 3 + p_decoded->i_service_provider_name_length,
+        memcpy(p_data + 3 + p_decoded->i_service_provider_name_length,
                p_decoded->i_service_name,
                p_decoded->i_service_name_length);
 
+    return 2 + i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_GenServiceDr
+ *****************************************************************************/
+dvbpsi_descriptor_t * dvbpsi_GenServiceDr(dvbpsi_service_dr_t * p_decoded,
+                                          bool b_duplicate)
+{
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeServiceDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
+
     if (b_duplicate)
     {
         /* Duplicate decoded data */
@@ -83,6 +83,53 @@ dvbpsi_service_dr_t* dvbpsi_DecodeServiceDr(
                                         dvbpsi_descriptor_t * p_descriptor);
 
 
+/*****************************************************************************
+ * dvbpsi_service_compact_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_service_compact_s
+ * \brief compact "service" descriptor structure.
+ *
+ * This structure is filled by dvbpsi_DecodeServiceDrCompact(). The names
+ * point into the p_data of the descriptor and are valid as long as it is.
+ */
+/*!
+ * \typedef struct dvbpsi_service_compact_s dvbpsi_service_compact_t
+ * \brief dvbpsi_service_compact_t type definition.
+ */
+typedef struct dvbpsi_service_compact_s
+{
+  uint8_t        i_service_type;                 /*!< service_type*/
+  uint8_t        i_service_provider_name_length; /*!< length of
+                                                   p_service_provider_name */
+  const uint8_t *p_service_provider_name;        /*!< name of the service
+                                                   provider */
+  uint8_t        i_service_name_length;          /*!< length of
+                                                   p_service_name */
+  const uint8_t *p_service_name;                 /*!< name of the service */
+
+} dvbpsi_service_compact_t;
+
+
+/*****************************************************************************
+ * dvbpsi_DecodeServiceDrCompact
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_DecodeServiceDrCompact(dvbpsi_descriptor_t * p_descriptor,
+                                dvbpsi_service_compact_t * p_compact)
+ * \brief "service" descriptor decoder without copy.
+ * \param p_descriptor pointer to the descriptor structure
+ * \param p_compact structure filled with the decoded data
+ * \return true on success, false if the descriptor is not a "service"
+ * descriptor.
+ *
+ * Like dvbpsi_DecodeServiceDr(), a truncated name is left empty. Nothing is
+ * allocated and dvbpsi_descriptor_t::p_decoded is left alone.
+ */
+bool dvbpsi_DecodeServiceDrCompact(dvbpsi_descriptor_t * p_descriptor,
+                                   dvbpsi_service_compact_t * p_compact);
+
+
 /*****************************************************************************
  * dvbpsi_GenServiceDataDr
  *****************************************************************************/
@@ -100,6 +147,17 @@ dvbpsi_descriptor_t * dvbpsi_GenServiceDr(
                                         dvbpsi_service_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeServiceDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeServiceDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_service_dr_t *p_decoded)
+ * \brief "service" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeServiceDr(uint8_t *p_buffer, size_t i_size,
+                              dvbpsi_service_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
@@ -34,6 +34,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -63,7 +64,7 @@ dvbpsi_country_availability_dr_t* dvbpsi_DecodeCountryAvailability(
         return NULL;
 
     /* Allocate memory */
-    p_decoded = (dvbpsi_country_availability_dr_t*)calloc(1, sizeof(dvbpsi_country_availability_dr_t));
+    p_decoded = (dvbpsi_country_availability_dr_t*)dvbpsi_calloc(1, sizeof(dvbpsi_country_availability_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -85,32 +86,52 @@ dvbpsi_country_availability_dr_t* dvbpsi_DecodeCountryAvailability(
 
 
 /*****************************************************************************
- * dvbpsi_GenCountryAvailabilityDr
+ * dvbpsi_EncodeCountryAvailabilityDr
  *****************************************************************************/
-dvbpsi_descriptor_t * dvbpsi_GenCountryAvailabilityDr(
-		                        dvbpsi_country_availability_dr_t * p_decoded,
-                                        bool b_duplicate)
+size_t dvbpsi_EncodeCountryAvailabilityDr(uint8_t *p_buffer, size_t i_size,
+                                          dvbpsi_country_availability_dr_t *p_decoded)
 {
     /* Check the length */    
     if (p_decoded->i_code_count > 83) 
-        return NULL;
+        return 0;
 
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor =
-            dvbpsi_NewDescriptor(0x83, 1+p_decoded->i_code_count*3, NULL);
-    if (!p_descriptor)
-        return NULL;
+    size_t i_length = 1+p_decoded->i_code_count*3;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x49;
+    p_buffer[1] = i_length;
 
     /* Encode data */
-    p_descriptor->p_data[0] = (p_decoded->b_country_availability_flag) ? 0x80: 0x00;
+    p_data[0] = (p_decoded->b_country_availability_flag) ? 0x80: 0x00;
 
     for (uint8_t i = 0; i < p_decoded->i_code_count; i++)
     {
-        p_descriptor->p_data[1+i*3] = p_decoded->code[i].iso_639_code[0];
-        p_descriptor->p_data[2+i*3] = p_decoded->code[i].iso_639_code[1];
-        p_descriptor->p_data[3+i*3] = p_decoded->code[i].iso_639_code[2];
+        p_data[1+i*3] = p_decoded->code[i].iso_639_code[0];
+        p_data[2+i*3] = p_decoded->code[i].iso_639_code[1];
+        p_data[3+i*3] = p_decoded->code[i].iso_639_code[2];
     }
 
+    return 2 + i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_GenCountryAvailabilityDr
+ *****************************************************************************/
+dvbpsi_descriptor_t * dvbpsi_GenCountryAvailabilityDr(
+		                        dvbpsi_country_availability_dr_t * p_decoded,
+                                        bool b_duplicate)
+{
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeCountryAvailabilityDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
+
     if (b_duplicate)
     {
         /* Duplicate decoded data */
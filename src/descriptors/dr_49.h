@@ -100,6 +100,17 @@ dvbpsi_descriptor_t * dvbpsi_GenCountryAvailabilityDr(
 		                        dvbpsi_country_availability_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeCountryAvailabilityDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeCountryAvailabilityDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_country_availability_dr_t *p_decoded)
+ * \brief "country availability" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeCountryAvailabilityDr(uint8_t *p_buffer, size_t i_size,
+                                          dvbpsi_country_availability_dr_t *p_decoded);
+
 #ifdef __cplusplus
 };
 #endif
@@ -34,15 +34,20 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
 #include "dr_4a.h"
 
 /*****************************************************************************
- * dvbpsi_DecodeLinkageDr
+ * dvbpsi_LinkageDrDecode
+ *****************************************************************************
+ * Decodes into the whole dvbpsi_linkage_dr_t or only the private data of
+ * the descriptor.
  *****************************************************************************/
-dvbpsi_linkage_dr_t* dvbpsi_DecodeLinkageDr(dvbpsi_descriptor_t * p_descriptor)
+static void *dvbpsi_LinkageDrDecode(dvbpsi_descriptor_t * p_descriptor,
+                                    bool b_counted)
 {
     /* Check the tag */
     if (p_descriptor->i_tag != 0x4A)
@@ -53,33 +58,36 @@ dvbpsi_linkage_dr_t* dvbpsi_DecodeLinkageDr(dvbpsi_descriptor_t * p_descriptor)
         return p_descriptor->p_decoded;
 
     /* Check the length */
-    int handover_type = 0, origin_type = 0;
+    if (p_descriptor->i_length < 7)
+        return NULL;
+
+    int i = 7, handover_type = 0, origin_type = 0;
     if (p_descriptor->p_data[6] == 0x08)
     {
-        handover_type = p_descriptor->p_data[7] & 0xF0 >> 4;
-        origin_type = p_descriptor->p_data[7] & 0x01;
-        if ((( handover_type > 0 ) && ( handover_type < 4 )
-                && ( origin_type == 0 ) && ( p_descriptor->i_length > 243 )) ||
-            (( handover_type > 0 ) && ( handover_type < 4 )
-                && ( origin_type == 1 ) && ( p_descriptor->i_length > 245 )))
+        if (p_descriptor->i_length < 8)
             return NULL;
+        handover_type = (p_descriptor->p_data[7] & 0xF0) >> 4;
+        origin_type = p_descriptor->p_data[7] & 0x01;
+        i = 8;
+        if (handover_type > 0 && handover_type < 4)
+            i += 2;
+        if (origin_type == 0)
+            i += 2;
     }
-    if (p_descriptor->p_data[6] == 0x0D &&
-        p_descriptor->i_length > 245)
-        return NULL;
-    if (p_descriptor->p_data[6] != 0x08 &&
-        p_descriptor->p_data[6] != 0x0D &&
-        p_descriptor->i_length > 248)
+    else if (p_descriptor->p_data[6] == 0x0D)
+        i = 10;
+    if (p_descriptor->i_length < i)
         return NULL;
 
     /* Allocate memory */
-    dvbpsi_linkage_dr_t * p_decoded;
-    p_decoded = (dvbpsi_linkage_dr_t*)calloc(1, sizeof(dvbpsi_linkage_dr_t));
+    unsigned int i_private_length = p_descriptor->i_length - i;
+    dvbpsi_linkage_counted_t * p_decoded;
+    p_decoded = dvbpsi_calloc(1, b_counted ? DVBPSI_LINKAGE_COUNTED_SIZE(i_private_length)
+                                           : sizeof(dvbpsi_linkage_dr_t));
     if (!p_decoded)
         return NULL;
 
     /* Decode data */
-    int i = 7;
     p_decoded->i_transport_stream_id = p_descriptor->p_data[0] << 8
                                        | p_descriptor->p_data[1];
     p_decoded->i_original_network_id = p_descriptor->p_data[2] << 8
@@ -90,29 +98,18 @@ dvbpsi_linkage_dr_t* dvbpsi_DecodeLinkageDr(dvbpsi_descriptor_t * p_descriptor)
 
     if (p_descriptor->p_data[6] == 0x08)
     {
+        int j = 8;
         p_decoded->i_handover_type = handover_type;
         p_decoded->i_origin_type = origin_type;
         if (handover_type > 0 && handover_type < 4)
         {
-            p_decoded->i_network_id = p_descriptor->p_data[8] << 8
-                                      | p_descriptor->p_data[9];
-            i = 10;
+            p_decoded->i_network_id = p_descriptor->p_data[j] << 8
+                                      | p_descriptor->p_data[j + 1];
+            j += 2;
         }
         if (origin_type == 0)
-        {
-            if (handover_type > 0 && handover_type < 4)
-            {
-                p_decoded->i_initial_service_id = p_descriptor->p_data[10] << 8
-                                                  | p_descriptor->p_data[11];
-                i = 12;
-            }
-            else
-            {
-                p_decoded->i_initial_service_id = p_descriptor->p_data[8] << 8
-                                                  | p_descriptor->p_data[9];
-                i = 10;
-            }
-        }
+            p_decoded->i_initial_service_id = p_descriptor->p_data[j] << 8
+                                              | p_descriptor->p_data[j + 1];
     }
     if (p_descriptor->p_data[6] == 0x0D)
     {
@@ -120,12 +117,10 @@ dvbpsi_linkage_dr_t* dvbpsi_DecodeLinkageDr(dvbpsi_descriptor_t * p_descriptor)
                                       | p_descriptor->p_data[8];
        p_decoded->b_target_listed = (p_descriptor->p_data[9] & 0x80) ? true : false;
        p_decoded->b_event_simulcast = (p_descriptor->p_data[9] & 0x40) ? true : false;
-       i = 10;
     }
-    p_decoded->i_private_data_length = p_descriptor->i_length - i;
-    if (p_decoded->i_private_data_length > 248)
-        p_decoded->i_private_data_length = 248;
-    memcpy(p_decoded->i_private_data, &p_descriptor->p_data[i], p_decoded->i_private_data_length);
+    /* At most 248 bytes, which dvbpsi_linkage_dr_t holds */
+    p_decoded->i_private_data_length = i_private_length;
+    memcpy(p_decoded->i_private_data, &p_descriptor->p_data[i], i_private_length);
 
     p_descriptor->p_decoded = (void*)p_decoded;
 
@@ -133,10 +128,27 @@ dvbpsi_linkage_dr_t* dvbpsi_DecodeLinkageDr(dvbpsi_descriptor_t * p_descriptor)
 }
 
 /*****************************************************************************
- * dvbpsi_GenCountryAvailabilityDr
+ * dvbpsi_DecodeLinkageDr
  *****************************************************************************/
-dvbpsi_descriptor_t * dvbpsi_GenLinkageDr(dvbpsi_linkage_dr_t * p_decoded,
-                                          bool b_duplicate)
+dvbpsi_linkage_dr_t* dvbpsi_DecodeLinkageDr(dvbpsi_descriptor_t * p_descriptor)
+{
+    return dvbpsi_LinkageDrDecode(p_descriptor, false);
+}
+
+/*****************************************************************************
+ * dvbpsi_DecodeLinkageDrCounted
+ *****************************************************************************/
+dvbpsi_linkage_counted_t* dvbpsi_DecodeLinkageDrCounted(
+                                        dvbpsi_descriptor_t * p_descriptor)
+{
+    return dvbpsi_LinkageDrDecode(p_descriptor, true);
+}
+
+/*****************************************************************************
+ * dvbpsi_EncodeLinkageDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeLinkageDr(uint8_t *p_buffer, size_t i_size,
+                              dvbpsi_linkage_dr_t *p_decoded)
 {
     /* Check the length */
     int last_pos;
@@ -156,32 +168,34 @@ dvbpsi_descriptor_t * dvbpsi_GenLinkageDr(dvbpsi_linkage_dr_t * p_decoded,
     if (p_decoded->i_linkage_type == 0x0D)
         length+=3;
     if (length+p_decoded->i_private_data_length > 255)
-        return NULL;
+        return 0;
 
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor =
-            dvbpsi_NewDescriptor(0x4a, p_decoded->i_private_data_length+length, NULL);
-    if (!p_descriptor)
-        return NULL;
+    size_t i_length = p_decoded->i_private_data_length+length;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x4a;
+    p_buffer[1] = i_length;
 
     /* Encode data */
-    p_descriptor->p_data[0] = p_decoded->i_transport_stream_id >> 8;
-    p_descriptor->p_data[1] = p_decoded->i_transport_stream_id;
-    p_descriptor->p_data[2] = p_decoded->i_original_network_id >> 8;
-    p_descriptor->p_data[3] = p_decoded->i_original_network_id;
-    p_descriptor->p_data[4] = p_decoded->i_service_id >> 8;
-    p_descriptor->p_data[5] = p_decoded->i_service_id;
-    p_descriptor->p_data[6] = p_decoded->i_linkage_type;
+    p_data[0] = p_decoded->i_transport_stream_id >> 8;
+    p_data[1] = p_decoded->i_transport_stream_id;
+    p_data[2] = p_decoded->i_original_network_id >> 8;
+    p_data[3] = p_decoded->i_original_network_id;
+    p_data[4] = p_decoded->i_service_id >> 8;
+    p_data[5] = p_decoded->i_service_id;
+    p_data[6] = p_decoded->i_linkage_type;
     last_pos = 6;
     if (p_decoded->i_linkage_type == 0x08)
     {
-    	p_descriptor->p_data[7] = ( (p_decoded->i_handover_type & 0x0F) << 4 )
+    	p_data[7] = ( (p_decoded->i_handover_type & 0x0F) << 4 )
     			| 0x0E | ( p_decoded->i_origin_type & 0x01 );
         if ((p_decoded->i_handover_type > 0) &&
             (p_decoded->i_handover_type < 3 ))
         {
-    		p_descriptor->p_data[8] = p_decoded->i_network_id >> 8;
-    		p_descriptor->p_data[9] = p_decoded->i_network_id;
+    		p_data[8] = p_decoded->i_network_id >> 8;
+    		p_data[9] = p_decoded->i_network_id;
     		last_pos = 9;
     	}
         if (p_decoded->i_origin_type == 0)
@@ -189,14 +203,14 @@ dvbpsi_descriptor_t * dvbpsi_GenLinkageDr(dvbpsi_linkage_dr_t * p_decoded,
                 if ((p_decoded->i_handover_type > 0) &&
                     (p_decoded->i_handover_type < 3 ))
                 {
-        		p_descriptor->p_data[10] = p_decoded->i_initial_service_id >> 8;
-        		p_descriptor->p_data[11] = p_decoded->i_initial_service_id;
+        		p_data[10] = p_decoded->i_initial_service_id >> 8;
+        		p_data[11] = p_decoded->i_initial_service_id;
         		last_pos = 11;
     		}
                 else
                 {
-        		p_descriptor->p_data[8] = p_decoded->i_initial_service_id >> 8;
-        		p_descriptor->p_data[9] = p_decoded->i_initial_service_id;
+        		p_data[8] = p_decoded->i_initial_service_id >> 8;
+        		p_data[9] = p_decoded->i_initial_service_id;
         		last_pos = 9;
     		}
     	}
@@ -204,21 +218,39 @@ dvbpsi_descriptor_t * dvbpsi_GenLinkageDr(dvbpsi_linkage_dr_t * p_decoded,
 
     if (p_decoded->i_linkage_type == 0x0D)
     {
-    	p_descriptor->p_data[7] = p_decoded->i_target_event_id >> 8;
-        p_descriptor->p_data[8] = p_decoded->i_target_event_id;
-        p_descriptor->p_data[9] = ((p_decoded->b_target_listed) ? 0x80 : 0x00 )
+    	p_data[7] = p_decoded->i_target_event_id >> 8;
+        p_data[8] = p_decoded->i_target_event_id;
+        p_data[9] = ((p_decoded->b_target_listed) ? 0x80 : 0x00 )
                         | ((p_decoded->b_event_simulcast) ? 0x40 : 0x00) | 0x3F;
         last_pos = 9;
     }
 
-    memcpy(&p_descriptor->p_data[last_pos+1], p_decoded->i_private_data, p_decoded->i_private_data_length);
+    memcpy(&p_data[last_pos+1], p_decoded->i_private_data, p_decoded->i_private_data_length);
+
+    return 2 + i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_GenCountryAvailabilityDr
+ *****************************************************************************/
+dvbpsi_descriptor_t * dvbpsi_GenLinkageDr(dvbpsi_linkage_dr_t * p_decoded,
+                                          bool b_duplicate)
+{
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeLinkageDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
 
     if (b_duplicate)
     {
-        /* Duplicate decoded data */
+        /* Duplicate decoded data, which may be a counted form */
         p_descriptor->p_decoded =
                dvbpsi_DuplicateDecodedDescriptor(p_decoded,
-                      sizeof(dvbpsi_linkage_dr_t));
+                      DVBPSI_LINKAGE_COUNTED_SIZE(p_decoded->i_private_data_length));
     }
 
     return p_descriptor;
@@ -84,6 +84,48 @@ typedef struct dvbpsi_linkage_dr_s
 
 } dvbpsi_linkage_dr_t;
 
+/*****************************************************************************
+ * dvbpsi_linkage_counted_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_linkage_counted_s
+ * \brief "linkage" descriptor structure sized to its private data.
+ *
+ * The descriptors decoded by dvbpsi_decode_descriptors() hold this form,
+ * of which dvbpsi_linkage_dr_t is the prefix: only its first
+ * i_private_data_length bytes of private data are then there, and it must
+ * not be copied as a whole.
+ */
+/*!
+ * \typedef struct dvbpsi_linkage_counted_s dvbpsi_linkage_counted_t
+ * \brief dvbpsi_linkage_counted_t type definition.
+ */
+typedef struct dvbpsi_linkage_counted_s
+{
+  uint16_t       i_transport_stream_id;         /*!< transport stream id */
+  uint16_t       i_original_network_id;         /*!< original network id */
+  uint16_t       i_service_id;                  /*!< service id */
+  uint8_t        i_linkage_type;                /*!< linkage type */
+  uint8_t        i_handover_type;               /*!< hand-over type */
+  uint8_t        i_origin_type;                 /*!< origin type */
+  uint16_t       i_network_id;                  /*!< network id */
+  uint16_t       i_initial_service_id;          /*!< initial service id */
+  uint16_t       i_target_event_id;             /*!< target event id */
+  bool           b_target_listed;               /*!< target listed */
+  bool           b_event_simulcast;             /*!< event simulcast */
+  uint8_t        i_private_data_length;         /*!< length of the
+                                                     i_private_data array */
+  uint8_t        i_private_data[];              /*!< private data */
+} dvbpsi_linkage_counted_t;
+
+/*!
+ * \def DVBPSI_LINKAGE_COUNTED_SIZE(length)
+ * \brief Size of a dvbpsi_linkage_counted_t of length bytes of private
+ * data.
+ */
+#define DVBPSI_LINKAGE_COUNTED_SIZE(length)                                    \
+    (sizeof(dvbpsi_linkage_counted_t) + (length))
+
 /*****************************************************************************
  * dvbpsi_DecodeLinkageDr
  *****************************************************************************/
@@ -97,6 +139,24 @@ typedef struct dvbpsi_linkage_dr_s
  */
 dvbpsi_linkage_dr_t* dvbpsi_DecodeLinkageDr(dvbpsi_descriptor_t * p_descriptor);
 
+/*****************************************************************************
+ * dvbpsi_DecodeLinkageDrCounted
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_linkage_counted_t * dvbpsi_DecodeLinkageDrCounted(
+                                        dvbpsi_descriptor_t * p_descriptor)
+ * \brief "linkage" descriptor decoder, sized to the private data.
+ * \param p_descriptor pointer to the descriptor structure
+ * \return a pointer to the decoded data, stored in
+ * dvbpsi_descriptor_t::p_decoded as dvbpsi_DecodeLinkageDr() does.
+ *
+ * The decoded form is allocated like the descriptor, from the arena of its
+ * table with DVBPSI_FLAG_TABLE_ARENA. A descriptor already decoded by
+ * dvbpsi_DecodeLinkageDr() is returned as is.
+ */
+dvbpsi_linkage_counted_t* dvbpsi_DecodeLinkageDrCounted(
+                                        dvbpsi_descriptor_t * p_descriptor);
+
 /*****************************************************************************
  * dvbpsi_GenLinkageDr
  *****************************************************************************/
@@ -112,6 +172,17 @@ dvbpsi_linkage_dr_t* dvbpsi_DecodeLinkageDr(dvbpsi_descriptor_t * p_descriptor);
 dvbpsi_descriptor_t *dvbpsi_GenLinkageDr(dvbpsi_linkage_dr_t * p_decoded,
                                          bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeLinkageDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeLinkageDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_linkage_dr_t *p_decoded)
+ * \brief "linkage" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeLinkageDr(uint8_t *p_buffer, size_t i_size,
+                              dvbpsi_linkage_dr_t *p_decoded);
+
 #ifdef __cplusplus
 };
 #endif
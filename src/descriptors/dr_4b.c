@@ -34,6 +34,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -60,7 +61,7 @@ dvbpsi_nvod_ref_dr_t* dvbpsi_DecodeNVODReferenceDr(dvbpsi_descriptor_t * p_descr
 
     /* Allocate memory */
     dvbpsi_nvod_ref_dr_t * p_decoded;
-    p_decoded = (dvbpsi_nvod_ref_dr_t*)calloc(1, sizeof(dvbpsi_nvod_ref_dr_t));
+    p_decoded = (dvbpsi_nvod_ref_dr_t*)dvbpsi_calloc(1, sizeof(dvbpsi_nvod_ref_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -86,16 +87,18 @@ dvbpsi_nvod_ref_dr_t* dvbpsi_DecodeNVODReferenceDr(dvbpsi_descriptor_t * p_descr
 }
 
 /*****************************************************************************
- * dvbpsi_GenNVODReferenceDr
+ * dvbpsi_EncodeNVODReferenceDr
  *****************************************************************************/
-dvbpsi_descriptor_t * dvbpsi_GenNVODReferenceDr(dvbpsi_nvod_ref_dr_t * p_decoded,
-                                          bool b_duplicate)
+size_t dvbpsi_EncodeNVODReferenceDr(uint8_t *p_buffer, size_t i_size,
+                                    dvbpsi_nvod_ref_dr_t *p_decoded)
 {
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor =
-            dvbpsi_NewDescriptor(0x4b, p_decoded->i_references * 6, NULL);
-    if (!p_descriptor)
-        return NULL;
+    size_t i_length = p_decoded->i_references * 6;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x4b;
+    p_buffer[1] = i_length;
 
     if (p_decoded->i_references > 43)
 	p_decoded->i_references = 43;
@@ -104,14 +107,32 @@ dvbpsi_descriptor_t * dvbpsi_GenNVODReferenceDr(dvbpsi_nvod_ref_dr_t * p_decoded
     int pos = 0;
     for (int i = 0; i < p_decoded->i_references; i++ )
     {
-    	p_descriptor->p_data[pos++] = p_decoded->p_nvod_refs[i].i_transport_stream_id >> 8;
-        p_descriptor->p_data[pos++] = p_decoded->p_nvod_refs[i].i_transport_stream_id;
-        p_descriptor->p_data[pos++] = p_decoded->p_nvod_refs[i].i_original_network_id >> 8;
-        p_descriptor->p_data[pos++] = p_decoded->p_nvod_refs[i].i_original_network_id;
-        p_descriptor->p_data[pos++] = p_decoded->p_nvod_refs[i].i_service_id >> 8;
-        p_descriptor->p_data[pos++] = p_decoded->p_nvod_refs[i].i_service_id;
+    	p_data[pos++] = p_decoded->p_nvod_refs[i].i_transport_stream_id >> 8;
+        p_data[pos++] = p_decoded->p_nvod_refs[i].i_transport_stream_id;
+        p_data[pos++] = p_decoded->p_nvod_refs[i].i_original_network_id >> 8;
+        p_data[pos++] = p_decoded->p_nvod_refs[i].i_original_network_id;
+        p_data[pos++] = p_decoded->p_nvod_refs[i].i_service_id >> 8;
+        p_data[pos++] = p_decoded->p_nvod_refs[i].i_service_id;
     }
 
+    return 2 + i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_GenNVODReferenceDr
+ *****************************************************************************/
+dvbpsi_descriptor_t * dvbpsi_GenNVODReferenceDr(dvbpsi_nvod_ref_dr_t * p_decoded,
+                                          bool b_duplicate)
+{
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeNVODReferenceDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
+
     if (b_duplicate)
     {
         /* Duplicate decoded data */
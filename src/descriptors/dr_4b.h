@@ -110,6 +110,17 @@ dvbpsi_nvod_ref_dr_t* dvbpsi_DecodeNVODReferenceDr(dvbpsi_descriptor_t * p_descr
 dvbpsi_descriptor_t *dvbpsi_GenNVODReferenceDr(dvbpsi_nvod_ref_dr_t * p_decoded,
                                          bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeNVODReferenceDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeNVODReferenceDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_nvod_ref_dr_t *p_decoded)
+ * \brief "NVOD reference" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeNVODReferenceDr(uint8_t *p_buffer, size_t i_size,
+                                    dvbpsi_nvod_ref_dr_t *p_decoded);
+
 #ifdef __cplusplus
 };
 #endif
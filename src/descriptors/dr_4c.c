@@ -34,6 +34,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -57,7 +58,7 @@ dvbpsi_tshifted_service_dr_t* dvbpsi_DecodeTimeShiftedServiceDr(dvbpsi_descripto
 
     /* Allocate memory */
     dvbpsi_tshifted_service_dr_t *p_decoded;
-    p_decoded = (dvbpsi_tshifted_service_dr_t*)calloc(1, sizeof(dvbpsi_tshifted_service_dr_t));
+    p_decoded = (dvbpsi_tshifted_service_dr_t*)dvbpsi_calloc(1, sizeof(dvbpsi_tshifted_service_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -70,20 +71,41 @@ dvbpsi_tshifted_service_dr_t* dvbpsi_DecodeTimeShiftedServiceDr(dvbpsi_descripto
     return p_decoded;
 }
 
+/*****************************************************************************
+ * dvbpsi_EncodeTimeShiftedServiceDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeTimeShiftedServiceDr(uint8_t *p_buffer, size_t i_size,
+                                         dvbpsi_tshifted_service_dr_t *p_decoded)
+{
+    size_t i_length = 2;
+    if (i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x4c;
+    p_buffer[1] = i_length;
+
+    /* Encode data */
+    p_data[0] = p_decoded->i_ref_service_id >> 8;
+    p_data[1] = p_decoded->i_ref_service_id;
+
+    return 2 + i_length;
+}
+
 /*****************************************************************************
  * dvbpsi_GenTimeShiftedServiceDr
  *****************************************************************************/
 dvbpsi_descriptor_t *dvbpsi_GenTimeShiftedServiceDr(dvbpsi_tshifted_service_dr_t *p_decoded,
                                                     bool b_duplicate)
 {
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor = dvbpsi_NewDescriptor(0x4c, 2, NULL);
-    if (!p_descriptor)
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeTimeShiftedServiceDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
         return NULL;
 
-    /* Encode data */
-    p_descriptor->p_data[0] = p_decoded->i_ref_service_id >> 8;
-    p_descriptor->p_data[1] = p_decoded->i_ref_service_id;
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
 
     if (b_duplicate)
     {
@@ -89,6 +89,17 @@ dvbpsi_tshifted_service_dr_t* dvbpsi_DecodeTimeShiftedServiceDr(dvbpsi_descripto
 dvbpsi_descriptor_t *dvbpsi_GenTimeShiftedServiceDr(dvbpsi_tshifted_service_dr_t *p_decoded,
                                                     bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeTimeShiftedServiceDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeTimeShiftedServiceDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_tshifted_service_dr_t *p_decoded)
+ * \brief "time shifted service" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeTimeShiftedServiceDr(uint8_t *p_buffer, size_t i_size,
+                                         dvbpsi_tshifted_service_dr_t *p_decoded);
+
 #ifdef __cplusplus
 };
 #endif
@@ -35,6 +35,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -70,7 +71,7 @@ dvbpsi_short_event_dr_t * dvbpsi_DecodeShortEventDr(dvbpsi_descriptor_t * p_desc
     return p_descriptor->p_decoded;
 
   /* Allocate memory */
-  p_decoded = malloc(sizeof(dvbpsi_short_event_dr_t));
+  p_decoded = dvbpsi_malloc(sizeof(dvbpsi_short_event_dr_t));
   if (!p_decoded)
       return NULL;
 
@@ -89,27 +90,79 @@ dvbpsi_short_event_dr_t * dvbpsi_DecodeShortEventDr(dvbpsi_descriptor_t * p_desc
 }
 
 /*****************************************************************************
- * dvbpsi_GenShortEventDr
+ * dvbpsi_DecodeShortEventDrCompact
  *****************************************************************************/
-dvbpsi_descriptor_t * dvbpsi_GenShortEventDr(dvbpsi_short_event_dr_t * p_decoded,
-                                             bool b_duplicate)
+bool dvbpsi_DecodeShortEventDrCompact(dvbpsi_descriptor_t * p_descriptor,
+                                      dvbpsi_short_event_compact_t * p_compact)
+{
+  int i_len1;
+  int i_len2;
+
+  /* Check the tag */
+  if (!dvbpsi_CanDecodeAsDescriptor(p_descriptor, 0x4d) ||
+      p_descriptor->i_length < 5 )
+    return false;
+
+  /* Check length */
+  i_len1 = p_descriptor->p_data[3];
+  if (p_descriptor->i_length < 5 + i_len1)
+    return false;
+  i_len2 = p_descriptor->p_data[4+i_len1];
+  if (p_descriptor->i_length < 5 + i_len1 + i_len2)
+    return false;
+
+  memcpy( p_compact->i_iso_639_code, &p_descriptor->p_data[0], 3 );
+  p_compact->i_event_name_length = i_len1;
+  p_compact->p_event_name = &p_descriptor->p_data[3+1];
+  p_compact->i_text_length = i_len2;
+  p_compact->p_text = &p_descriptor->p_data[4+i_len1+1];
+
+  return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_EncodeShortEventDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeShortEventDr(uint8_t *p_buffer, size_t i_size,
+                                 dvbpsi_short_event_dr_t *p_decoded)
 {
     uint8_t i_len1 = p_decoded->i_event_name_length;
     uint8_t i_len2 = p_decoded->i_text_length;
 
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor = dvbpsi_NewDescriptor(0x4d, 5 + i_len1 + i_len2, NULL );
-    if (!p_descriptor)
-        return NULL;
+    size_t i_length = 5 + i_len1 + i_len2;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x4d;
+    p_buffer[1] = i_length;
 
     /* Encode data */
-    memcpy( &p_descriptor->p_data[0], p_decoded->i_iso_639_code, 3 );
-    p_descriptor->p_data[3] = i_len1;
+    memcpy( &p_data[0], p_decoded->i_iso_639_code, 3 );
+    p_data[3] = i_len1;
     if (i_len1)
-        memcpy( &p_descriptor->p_data[4], p_decoded->i_event_name, i_len1 );
-    p_descriptor->p_data[3+1+i_len1] = i_len2;
+        memcpy( &p_data[4], p_decoded->i_event_name, i_len1 );
+    p_data[3+1+i_len1] = i_len2;
     if (i_len2)
-        memcpy( &p_descriptor->p_data[3+1+i_len1+1], p_decoded->i_text, i_len2 );
+        memcpy( &p_data[3+1+i_len1+1], p_decoded->i_text, i_len2 );
+
+    return 2 + i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_GenShortEventDr
+ *****************************************************************************/
+dvbpsi_descriptor_t * dvbpsi_GenShortEventDr(dvbpsi_short_event_dr_t * p_decoded,
+                                             bool b_duplicate)
+{
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeShortEventDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
 
     if (b_duplicate)
     {
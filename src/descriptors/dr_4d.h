@@ -78,6 +78,50 @@ typedef struct dvbpsi_short_event_dr_s
 dvbpsi_short_event_dr_t* dvbpsi_DecodeShortEventDr(dvbpsi_descriptor_t * p_descriptor);
 
 
+/*****************************************************************************
+ * dvbpsi_short_event_compact_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_short_event_compact_s
+ * \brief compact "short event" descriptor structure.
+ *
+ * This structure is filled by dvbpsi_DecodeShortEventDrCompact(). The name
+ * and text point into the p_data of the descriptor and are valid as long as
+ * it is.
+ */
+/*!
+ * \typedef struct dvbpsi_short_event_compact_s dvbpsi_short_event_compact_t
+ * \brief dvbpsi_short_event_compact_t type definition.
+ */
+typedef struct dvbpsi_short_event_compact_s
+{
+  uint8_t        i_iso_639_code[3];    /*!< ISO 639 language code */
+  uint8_t        i_event_name_length;  /*!< length of event name */
+  const uint8_t *p_event_name;         /*!< "short event" name */
+  uint8_t        i_text_length;        /*!< text length */
+  const uint8_t *p_text;               /*!< "short event" text */
+
+} dvbpsi_short_event_compact_t;
+
+
+/*****************************************************************************
+ * dvbpsi_DecodeShortEventDrCompact
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_DecodeShortEventDrCompact(dvbpsi_descriptor_t * p_descriptor,
+                                dvbpsi_short_event_compact_t * p_compact)
+ * \brief "short event" descriptor decoder without copy.
+ * \param p_descriptor pointer to the descriptor structure
+ * \param p_compact structure filled with the decoded data
+ * \return true on success, false if the descriptor is not a valid
+ * "short event" descriptor.
+ *
+ * Nothing is allocated and dvbpsi_descriptor_t::p_decoded is left alone.
+ */
+bool dvbpsi_DecodeShortEventDrCompact(dvbpsi_descriptor_t * p_descriptor,
+                                      dvbpsi_short_event_compact_t * p_compact);
+
+
 /*****************************************************************************
  * dvbpsi_GenShortEventDr
  *****************************************************************************/
@@ -93,6 +137,17 @@ dvbpsi_short_event_dr_t* dvbpsi_DecodeShortEventDr(dvbpsi_descriptor_t * p_descr
 dvbpsi_descriptor_t * dvbpsi_GenShortEventDr(dvbpsi_short_event_dr_t * p_decoded,
                                              bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeShortEventDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeShortEventDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_short_event_dr_t *p_decoded)
+ * \brief "short event" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeShortEventDr(uint8_t *p_buffer, size_t i_size,
+                                 dvbpsi_short_event_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
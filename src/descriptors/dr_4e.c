@@ -35,6 +35,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -60,7 +61,7 @@ dvbpsi_extended_event_dr_t * dvbpsi_DecodeExtendedEventDr(dvbpsi_descriptor_t *
         return p_descriptor->p_decoded;
 
     /* Allocate memory */
-    p_decoded = malloc(sizeof(dvbpsi_extended_event_dr_t));
+    p_decoded = dvbpsi_malloc(sizeof(dvbpsi_extended_event_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -101,28 +102,89 @@ dvbpsi_extended_event_dr_t * dvbpsi_DecodeExtendedEventDr(dvbpsi_descriptor_t *
     return p_decoded;
 }
 
+/*****************************************************************************
+ * dvbpsi_DecodeExtendedEventDrCompact
+ *****************************************************************************/
+bool dvbpsi_DecodeExtendedEventDrCompact(dvbpsi_descriptor_t * p_descriptor,
+                                         dvbpsi_extended_event_compact_t * p_compact)
+{
+    int i_len;
+
+    /* Check the tag */
+    if (!dvbpsi_CanDecodeAsDescriptor(p_descriptor, 0x4e) ||
+            p_descriptor->i_length < 6 )
+        return false;
+
+    /* Check length */
+    i_len = p_descriptor->p_data[4];
+    if (p_descriptor->i_length < 6 + i_len ||
+        p_descriptor->i_length < 6 + i_len + p_descriptor->p_data[5+i_len])
+        return false;
+
+    /* Decode */
+    p_compact->i_descriptor_number = (p_descriptor->p_data[0] >> 4)&0xf;
+    p_compact->i_last_descriptor_number = p_descriptor->p_data[0]&0x0f;
+    memcpy( &p_compact->i_iso_639_code[0], &p_descriptor->p_data[1], 3 );
+    p_compact->i_items_length = i_len;
+    p_compact->p_items = &p_descriptor->p_data[5];
+    p_compact->i_text_length = p_descriptor->p_data[5+i_len];
+    p_compact->p_text = &p_descriptor->p_data[5+i_len+1];
+
+    return true;
+}
 
 /*****************************************************************************
- * dvbpsi_GenExtendedEventDr
+ * dvbpsi_NextExtendedEventItem
  *****************************************************************************/
-dvbpsi_descriptor_t * dvbpsi_GenExtendedEventDr(dvbpsi_extended_event_dr_t * p_decoded,
-                                                bool b_duplicate)
+bool dvbpsi_NextExtendedEventItem(const dvbpsi_extended_event_compact_t * p_compact,
+                                  int * pi_offset,
+                                  const uint8_t ** pp_description,
+                                  uint8_t * pi_description_length,
+                                  const uint8_t ** pp_item,
+                                  uint8_t * pi_item_length)
+{
+    const uint8_t *p = p_compact->p_items + *pi_offset;
+    const uint8_t *p_end = p_compact->p_items + p_compact->i_items_length;
+
+    /* item_description_length, description, item_length, item */
+    if (p + 1 > p_end || p + 1 + p[0] + 1 > p_end)
+        return false;
+    const uint8_t *p_next = p + 1 + p[0];
+    if (p_next + 1 + p_next[0] > p_end)
+        return false;
+
+    *pi_description_length = p[0];
+    *pp_description = p + 1;
+    *pi_item_length = p_next[0];
+    *pp_item = p_next + 1;
+    *pi_offset = p_next + 1 + p_next[0] - p_compact->p_items;
+
+    return true;
+}
+
+
+/*****************************************************************************
+ * dvbpsi_EncodeExtendedEventDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeExtendedEventDr(uint8_t *p_buffer, size_t i_size,
+                                    dvbpsi_extended_event_dr_t *p_decoded)
 {
     int i_len;
     int i_len2;
-    dvbpsi_descriptor_t * p_descriptor;
-
     i_len2 = 0;
     for (int i = 0; i < p_decoded->i_entry_count; i++)
         i_len2 += 2 + p_decoded->i_item_description_length[i] + p_decoded->i_item_length[i];
     i_len = 1 + 3 + 1 + i_len2 + 1 + p_decoded->i_text_length;
 
-    /* Create the descriptor */
-    p_descriptor = dvbpsi_NewDescriptor(0x4e, i_len, NULL );
-    if (!p_descriptor)
-        return NULL;
+    size_t i_length = i_len;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
 
-    uint8_t *p = &p_descriptor->p_data[0];
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x4e;
+    p_buffer[1] = i_length;
+
+    uint8_t *p = &p_data[0];
 
     /* Encode data */
     p[0] = (p_decoded->i_descriptor_number << 4 ) |
@@ -146,6 +208,24 @@ dvbpsi_descriptor_t * dvbpsi_GenExtendedEventDr(dvbpsi_extended_event_dr_t * p_d
     p[0] = p_decoded->i_text_length;
     memcpy( &p[1], p_decoded->i_text, p[0] );
 
+    return 2 + i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_GenExtendedEventDr
+ *****************************************************************************/
+dvbpsi_descriptor_t * dvbpsi_GenExtendedEventDr(dvbpsi_extended_event_dr_t * p_decoded,
+                                                bool b_duplicate)
+{
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeExtendedEventDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
+
     if (b_duplicate)
     {
         /* Duplicate decoded data */
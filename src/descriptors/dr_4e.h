@@ -87,6 +87,79 @@ typedef struct dvbpsi_extended_event_dr_s
 dvbpsi_extended_event_dr_t* dvbpsi_DecodeExtendedEventDr(dvbpsi_descriptor_t * p_descriptor);
 
 
+/*****************************************************************************
+ * dvbpsi_extended_event_compact_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_extended_event_compact_s
+ * \brief compact "extended event" descriptor structure.
+ *
+ * This structure is filled by dvbpsi_DecodeExtendedEventDrCompact(). The
+ * items and text point into the p_data of the descriptor and are valid as
+ * long as it is. The items are read with dvbpsi_NextExtendedEventItem().
+ */
+/*!
+ * \typedef struct dvbpsi_extended_event_compact_s dvbpsi_extended_event_compact_t
+ * \brief dvbpsi_extended_event_compact_t type definition.
+ */
+typedef struct dvbpsi_extended_event_compact_s
+{
+  uint8_t        i_descriptor_number;       /*!< descriptor number */
+  uint8_t        i_last_descriptor_number;  /*!< last descriptor number */
+
+  uint8_t        i_iso_639_code[3];         /*!< 3 letter ISO 639 language code */
+
+  uint8_t        i_items_length;            /*!< length_of_items */
+  const uint8_t *p_items;                   /*!< raw item loop */
+
+  uint8_t        i_text_length;             /*!< text length */
+  const uint8_t *p_text;                    /*!< text */
+} dvbpsi_extended_event_compact_t;
+
+
+/*****************************************************************************
+ * dvbpsi_DecodeExtendedEventDrCompact
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_DecodeExtendedEventDrCompact(dvbpsi_descriptor_t * p_descriptor,
+                                dvbpsi_extended_event_compact_t * p_compact)
+ * \brief "extended event" descriptor decoder without copy.
+ * \param p_descriptor pointer to the descriptor structure
+ * \param p_compact structure filled with the decoded data
+ * \return true on success, false if the descriptor is not a valid
+ * "extended event" descriptor.
+ *
+ * Nothing is allocated and dvbpsi_descriptor_t::p_decoded is left alone.
+ */
+bool dvbpsi_DecodeExtendedEventDrCompact(dvbpsi_descriptor_t * p_descriptor,
+                                         dvbpsi_extended_event_compact_t * p_compact);
+
+/*****************************************************************************
+ * dvbpsi_NextExtendedEventItem
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_NextExtendedEventItem(
+                        const dvbpsi_extended_event_compact_t * p_compact,
+                        int * pi_offset,
+                        const uint8_t ** pp_description, uint8_t * pi_description_length,
+                        const uint8_t ** pp_item, uint8_t * pi_item_length)
+ * \brief Reads the next item of a compact "extended event" descriptor.
+ * \param p_compact structure filled by dvbpsi_DecodeExtendedEventDrCompact()
+ * \param pi_offset position in the item loop, set it to 0 for the first item
+ * \param pp_description set to the item description
+ * \param pi_description_length set to the length of the item description
+ * \param pp_item set to the item
+ * \param pi_item_length set to the length of the item
+ * \return true if an item was read, false at the end of the loop.
+ */
+bool dvbpsi_NextExtendedEventItem(const dvbpsi_extended_event_compact_t * p_compact,
+                                  int * pi_offset,
+                                  const uint8_t ** pp_description,
+                                  uint8_t * pi_description_length,
+                                  const uint8_t ** pp_item,
+                                  uint8_t * pi_item_length);
+
+
 /*****************************************************************************
  * dvbpsi_GenExtendedEventDr
  *****************************************************************************/
@@ -102,6 +175,17 @@ dvbpsi_extended_event_dr_t* dvbpsi_DecodeExtendedEventDr(dvbpsi_descriptor_t * p
 dvbpsi_descriptor_t * dvbpsi_GenExtendedEventDr(dvbpsi_extended_event_dr_t * p_decoded,
                                                 bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeExtendedEventDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeExtendedEventDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_extended_event_dr_t *p_decoded)
+ * \brief "extended event" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeExtendedEventDr(uint8_t *p_buffer, size_t i_size,
+                                    dvbpsi_extended_event_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
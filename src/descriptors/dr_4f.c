@@ -34,6 +34,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -57,7 +58,7 @@ dvbpsi_tshifted_ev_dr_t* dvbpsi_DecodeTimeShiftedEventDr(dvbpsi_descriptor_t * p
 
     /* Allocate memory */
     dvbpsi_tshifted_ev_dr_t * p_decoded;
-    p_decoded = (dvbpsi_tshifted_ev_dr_t*)calloc(1, sizeof(dvbpsi_tshifted_ev_dr_t));
+    p_decoded = (dvbpsi_tshifted_ev_dr_t*)dvbpsi_calloc(1, sizeof(dvbpsi_tshifted_ev_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -72,23 +73,43 @@ dvbpsi_tshifted_ev_dr_t* dvbpsi_DecodeTimeShiftedEventDr(dvbpsi_descriptor_t * p
     return p_decoded;
 }
 
+/*****************************************************************************
+ * dvbpsi_EncodeTimeShiftedEventDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeTimeShiftedEventDr(uint8_t *p_buffer, size_t i_size,
+                                       dvbpsi_tshifted_ev_dr_t *p_decoded)
+{
+    size_t i_length = 4;
+    if (i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x4f;
+    p_buffer[1] = i_length;
+
+    /* Encode data */
+	p_data[0] = p_decoded->i_ref_service_id >> 8;
+    p_data[1] = p_decoded->i_ref_service_id;
+	p_data[2] = p_decoded->i_ref_event_id >> 8;
+    p_data[3] = p_decoded->i_ref_event_id;
+
+    return 2 + i_length;
+}
+
 /*****************************************************************************
  * dvbpsi_GenTimeShiftedEventDr
  *****************************************************************************/
 dvbpsi_descriptor_t *dvbpsi_GenTimeShiftedEventDr(dvbpsi_tshifted_ev_dr_t * p_decoded,
                                                   bool b_duplicate) {
-    /* Create the descriptor */
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeTimeShiftedEventDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
     dvbpsi_descriptor_t * p_descriptor =
-            dvbpsi_NewDescriptor(0x4f, 4, NULL);
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
     if (!p_descriptor)
         return NULL;
 
-    /* Encode data */
-	p_descriptor->p_data[0] = p_decoded->i_ref_service_id >> 8;
-    p_descriptor->p_data[1] = p_decoded->i_ref_service_id;
-	p_descriptor->p_data[2] = p_decoded->i_ref_event_id >> 8;
-    p_descriptor->p_data[3] = p_decoded->i_ref_event_id;
-
     if (b_duplicate)
     {
         /* Duplicate decoded data */
@@ -90,6 +90,17 @@ dvbpsi_tshifted_ev_dr_t* dvbpsi_DecodeTimeShiftedEventDr(dvbpsi_descriptor_t * p
 dvbpsi_descriptor_t *dvbpsi_GenTimeShiftedEventDr(dvbpsi_tshifted_ev_dr_t * p_decoded,
                                                   bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeTimeShiftedEventDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeTimeShiftedEventDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_tshifted_ev_dr_t *p_decoded)
+ * \brief "time shifted event" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeTimeShiftedEventDr(uint8_t *p_buffer, size_t i_size,
+                                       dvbpsi_tshifted_ev_dr_t *p_decoded);
+
 #ifdef __cplusplus
 };
 #endif
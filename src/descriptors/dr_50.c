@@ -34,6 +34,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -58,7 +59,7 @@ dvbpsi_component_dr_t* dvbpsi_DecodeComponentDr(dvbpsi_descriptor_t * p_descript
 
     /* Allocate memory */
     dvbpsi_component_dr_t * p_decoded;
-    p_decoded = (dvbpsi_component_dr_t*)calloc(1, sizeof(dvbpsi_component_dr_t));
+    p_decoded = (dvbpsi_component_dr_t*)dvbpsi_calloc(1, sizeof(dvbpsi_component_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -70,10 +71,10 @@ dvbpsi_component_dr_t* dvbpsi_DecodeComponentDr(dvbpsi_descriptor_t * p_descript
     if (p_descriptor->i_length > 6)
     {
     	p_decoded->i_text_length = p_descriptor->i_length - 6;
-        p_decoded->i_text = calloc(1, p_decoded->i_text_length);
+        p_decoded->i_text = dvbpsi_calloc(1, p_decoded->i_text_length);
         if (!p_decoded->i_text)
         {
-        	free(p_decoded);
+        	dvbpsi_free(p_decoded);
             return NULL;
         }
     	memcpy( p_decoded->i_text, &p_descriptor->p_data[6], p_decoded->i_text_length );
@@ -89,26 +90,46 @@ dvbpsi_component_dr_t* dvbpsi_DecodeComponentDr(dvbpsi_descriptor_t * p_descript
     return p_decoded;
 }
 
+/*****************************************************************************
+ * dvbpsi_EncodeComponentDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeComponentDr(uint8_t *p_buffer, size_t i_size,
+                                dvbpsi_component_dr_t *p_decoded)
+{
+    size_t i_length = 6+p_decoded->i_text_length;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x50;
+    p_buffer[1] = i_length;
+
+    /* Encode data */
+	p_data[0] = p_decoded->i_stream_content+0xF0;
+    p_data[1] = p_decoded->i_component_type;
+    p_data[2] = p_decoded->i_component_tag;
+    memcpy( &p_data[3], p_decoded->i_iso_639_code, 3 );
+    if (p_decoded->i_text_length)
+      memcpy(&p_data[6],p_decoded->i_text,p_decoded->i_text_length);
+
+    return 2 + i_length;
+}
+
 /*****************************************************************************
  * dvbpsi_GenComponentDr
  *****************************************************************************/
 dvbpsi_descriptor_t *dvbpsi_GenComponentDr(dvbpsi_component_dr_t * p_decoded,
                                                   bool b_duplicate)
 {
-    /* Create the descriptor */
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeComponentDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
     dvbpsi_descriptor_t * p_descriptor =
-            dvbpsi_NewDescriptor(0x50, 6+p_decoded->i_text_length, NULL);
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
     if (!p_descriptor)
         return NULL;
 
-    /* Encode data */
-	p_descriptor->p_data[0] = p_decoded->i_stream_content+0xF0;
-    p_descriptor->p_data[1] = p_decoded->i_component_type;
-    p_descriptor->p_data[2] = p_decoded->i_component_tag;
-    memcpy( &p_descriptor->p_data[3], p_decoded->i_iso_639_code, 3 );
-    if (p_decoded->i_text_length)
-      memcpy(&p_descriptor->p_data[6],p_decoded->i_text,p_decoded->i_text_length);
-
     if (b_duplicate)
     {
         /* Duplicate decoded data */
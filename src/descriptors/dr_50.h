@@ -95,6 +95,17 @@ dvbpsi_component_dr_t* dvbpsi_DecodeComponentDr(dvbpsi_descriptor_t * p_descript
 dvbpsi_descriptor_t *dvbpsi_GenComponentDr(dvbpsi_component_dr_t * p_decoded,
                                                   bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeComponentDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeComponentDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_component_dr_t *p_decoded)
+ * \brief "Component" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeComponentDr(uint8_t *p_buffer, size_t i_size,
+                                dvbpsi_component_dr_t *p_decoded);
+
 #ifdef __cplusplus
 };
 #endif
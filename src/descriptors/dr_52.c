@@ -34,6 +34,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -60,7 +61,7 @@ dvbpsi_stream_identifier_dr_t * dvbpsi_DecodeStreamIdentifierDr(
         return NULL;
 
     /* Allocate memory */
-    p_decoded = (dvbpsi_stream_identifier_dr_t*)malloc(sizeof(dvbpsi_stream_identifier_dr_t));
+    p_decoded = (dvbpsi_stream_identifier_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_stream_identifier_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -72,6 +73,26 @@ dvbpsi_stream_identifier_dr_t * dvbpsi_DecodeStreamIdentifierDr(
 }
 
 
+/*****************************************************************************
+ * dvbpsi_EncodeStreamIdentifierDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeStreamIdentifierDr(uint8_t *p_buffer, size_t i_size,
+                                       dvbpsi_stream_identifier_dr_t *p_decoded)
+{
+    size_t i_length = 1;
+    if (i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x52;
+    p_buffer[1] = i_length;
+
+    /* Encode data */
+    p_data[0] = p_decoded->i_component_tag;
+
+    return 2 + i_length;
+}
+
 /*****************************************************************************
  * dvbpsi_GenStreamIdentifierDr
  *****************************************************************************/
@@ -79,13 +100,14 @@ dvbpsi_descriptor_t * dvbpsi_GenStreamIdentifierDr(
                                         dvbpsi_stream_identifier_dr_t * p_decoded,
                                         bool b_duplicate)
 {
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor = dvbpsi_NewDescriptor(0x52, 1, NULL);
-    if (!p_descriptor)
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeStreamIdentifierDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
         return NULL;
 
-    /* Encode data */
-    p_descriptor->p_data[0] = p_decoded->i_component_tag;
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
 
     if (b_duplicate)
     {
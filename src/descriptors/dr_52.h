@@ -91,6 +91,17 @@ dvbpsi_descriptor_t * dvbpsi_GenStreamIdentifierDr(
                                         dvbpsi_stream_identifier_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeStreamIdentifierDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeStreamIdentifierDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_stream_identifier_dr_t *p_decoded)
+ * \brief "stream identifier" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeStreamIdentifierDr(uint8_t *p_buffer, size_t i_size,
+                                       dvbpsi_stream_identifier_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
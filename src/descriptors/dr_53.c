@@ -34,6 +34,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -58,7 +59,7 @@ dvbpsi_ca_identifier_dr_t * dvbpsi_DecodeCAIdentifierDr(dvbpsi_descriptor_t *p_d
         return NULL;
 
     /* Allocate memory */
-    p_decoded = (dvbpsi_ca_identifier_dr_t*)calloc(1, sizeof(dvbpsi_ca_identifier_dr_t));
+    p_decoded = (dvbpsi_ca_identifier_dr_t*)dvbpsi_calloc(1, sizeof(dvbpsi_ca_identifier_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -80,26 +81,47 @@ dvbpsi_ca_identifier_dr_t * dvbpsi_DecodeCAIdentifierDr(dvbpsi_descriptor_t *p_d
 
 
 /*****************************************************************************
- * dvbpsi_GenCAIdentifierDr
+ * dvbpsi_EncodeCAIdentifierDr
  *****************************************************************************/
-dvbpsi_descriptor_t * dvbpsi_GenCAIdentifierDr(dvbpsi_ca_identifier_dr_t *p_decoded,
-                                               bool b_duplicate)
+size_t dvbpsi_EncodeCAIdentifierDr(uint8_t *p_buffer, size_t i_size,
+                                   dvbpsi_ca_identifier_dr_t *p_decoded)
 {
     if (p_decoded->i_number > DVBPSI_CA_SYSTEM_ID_DR_MAX)
         p_decoded->i_number = DVBPSI_CA_SYSTEM_ID_DR_MAX;
 
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor = dvbpsi_NewDescriptor(0x53, p_decoded->i_number * 2, NULL);
-    if (!p_descriptor)
-        return NULL;
+    size_t i_length = p_decoded->i_number * 2;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x53;
+    p_buffer[1] = i_length;
 
     /* Encode data */
     for (int i = 0; i < p_decoded->i_number; i++ )
     {
-        p_descriptor->p_data[2 * i] = p_decoded->p_system[i].i_ca_system_id >> 8;
-        p_descriptor->p_data[2 * i + 1] = p_decoded->p_system[i].i_ca_system_id;
+        p_data[2 * i] = p_decoded->p_system[i].i_ca_system_id >> 8;
+        p_data[2 * i + 1] = p_decoded->p_system[i].i_ca_system_id;
     }
 
+    return 2 + i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_GenCAIdentifierDr
+ *****************************************************************************/
+dvbpsi_descriptor_t * dvbpsi_GenCAIdentifierDr(dvbpsi_ca_identifier_dr_t *p_decoded,
+                                               bool b_duplicate)
+{
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeCAIdentifierDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
+
     if (b_duplicate)
     {
         /* Duplicate decoded data */
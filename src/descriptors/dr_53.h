@@ -116,6 +116,17 @@ dvbpsi_ca_identifier_dr_t* dvbpsi_DecodeCAIdentifierDr(dvbpsi_descriptor_t *p_de
 dvbpsi_descriptor_t *dvbpsi_GenCAIdentifierDr(dvbpsi_ca_identifier_dr_t *p_decoded,
                                               bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeCAIdentifierDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeCAIdentifierDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_ca_identifier_dr_t *p_decoded)
+ * \brief "CA identifier" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeCAIdentifierDr(uint8_t *p_buffer, size_t i_size,
+                                   dvbpsi_ca_identifier_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
@@ -33,6 +33,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -59,7 +60,7 @@ dvbpsi_content_dr_t * dvbpsi_DecodeContentDr(
 
     /* Allocate memory */
     dvbpsi_content_dr_t * p_decoded;
-    p_decoded = (dvbpsi_content_dr_t*)malloc(sizeof(dvbpsi_content_dr_t));
+    p_decoded = (dvbpsi_content_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_content_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -81,29 +82,48 @@ dvbpsi_content_dr_t * dvbpsi_DecodeContentDr(
 
 
 /*****************************************************************************
- * dvbpsi_GenContentDr
+ * dvbpsi_EncodeContentDr
  *****************************************************************************/
-dvbpsi_descriptor_t * dvbpsi_GenContentDr(
-                                        dvbpsi_content_dr_t * p_decoded,
-                                        bool b_duplicate)
+size_t dvbpsi_EncodeContentDr(uint8_t *p_buffer, size_t i_size,
+                              dvbpsi_content_dr_t *p_decoded)
 {
     if (p_decoded->i_contents_number > DVBPSI_CONTENT_DR_MAX)
         p_decoded->i_contents_number = DVBPSI_CONTENT_DR_MAX;
 
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor =
-            dvbpsi_NewDescriptor(0x54, p_decoded->i_contents_number * 2 , NULL);
+    size_t i_length = p_decoded->i_contents_number * 2;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
 
-    if (!p_descriptor)
-        return NULL;
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x54;
+    p_buffer[1] = i_length;
 
     /* Encode data */
     for (int i = 0; i < p_decoded->i_contents_number; i++ )
     {
-        p_descriptor->p_data[8 * i] = p_decoded->p_content[i].i_type;
-        p_descriptor->p_data[8 * i + 1] = p_decoded->p_content[i].i_user_byte;
+        p_data[8 * i] = p_decoded->p_content[i].i_type;
+        p_data[8 * i + 1] = p_decoded->p_content[i].i_user_byte;
     }
 
+    return 2 + i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_GenContentDr
+ *****************************************************************************/
+dvbpsi_descriptor_t * dvbpsi_GenContentDr(
+                                        dvbpsi_content_dr_t * p_decoded,
+                                        bool b_duplicate)
+{
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeContentDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
+
     if (b_duplicate)
     {
         /* Duplicate decoded data */
@@ -252,6 +252,17 @@ dvbpsi_descriptor_t * dvbpsi_GenContentDr(
                                         dvbpsi_content_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeContentDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeContentDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_content_dr_t *p_decoded)
+ * \brief "content" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeContentDr(uint8_t *p_buffer, size_t i_size,
+                              dvbpsi_content_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
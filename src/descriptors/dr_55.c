@@ -35,6 +35,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -61,7 +62,7 @@ dvbpsi_parental_rating_dr_t * dvbpsi_DecodeParentalRatingDr(
 
     /* Allocate memory */
     dvbpsi_parental_rating_dr_t * p_decoded;
-    p_decoded = (dvbpsi_parental_rating_dr_t*)malloc(sizeof(dvbpsi_parental_rating_dr_t));
+    p_decoded = (dvbpsi_parental_rating_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_parental_rating_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -87,13 +88,12 @@ dvbpsi_parental_rating_dr_t * dvbpsi_DecodeParentalRatingDr(
 
 
 /*****************************************************************************
- * dvbpsi_GenParentalRatingDr
+ * dvbpsi_EncodeParentalRatingDr
  *****************************************************************************/
-dvbpsi_descriptor_t * dvbpsi_GenParentalRatingDr(
-                                        dvbpsi_parental_rating_dr_t * p_decoded,
-                                        bool b_duplicate)
+size_t dvbpsi_EncodeParentalRatingDr(uint8_t *p_buffer, size_t i_size,
+                                     dvbpsi_parental_rating_dr_t *p_decoded)
 {
-    uint8_t i_length;
+    size_t i_length;
     if (p_decoded->i_ratings_number >= DVBPSI_PARENTAL_RATING_DR_MAX)
     {
         i_length = (DVBPSI_PARENTAL_RATING_DR_MAX - 1) * 4;
@@ -102,27 +102,46 @@ dvbpsi_descriptor_t * dvbpsi_GenParentalRatingDr(
     else
         i_length = p_decoded->i_ratings_number * 4;
 
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor =
-            dvbpsi_NewDescriptor(0x55, i_length, NULL);
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
 
-    if (!p_descriptor)
-        return NULL;
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x55;
+    p_buffer[1] = i_length;
 
     /* Encode data */
     for (int i = 0; i < p_decoded->i_ratings_number; i++ )
     {
-        p_descriptor->p_data[8 * i] =
+        p_data[8 * i] =
                 p_decoded->p_parental_rating[i].i_country_code >> 16;
-        p_descriptor->p_data[8 * i + 1] =
+        p_data[8 * i + 1] =
                 (p_decoded->p_parental_rating[i].i_country_code >> 8) & 0xff;
-        p_descriptor->p_data[8 * i + 2] =
+        p_data[8 * i + 2] =
                 p_decoded->p_parental_rating[i].i_country_code & 0xff;
 
-        p_descriptor->p_data[8 * i + 3] =
+        p_data[8 * i + 3] =
                 p_decoded->p_parental_rating[i].i_rating;
     }
 
+    return 2 + i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_GenParentalRatingDr
+ *****************************************************************************/
+dvbpsi_descriptor_t * dvbpsi_GenParentalRatingDr(
+                                        dvbpsi_parental_rating_dr_t * p_decoded,
+                                        bool b_duplicate)
+{
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeParentalRatingDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
+
     if (b_duplicate)
     {
         /* Duplicate decoded data */
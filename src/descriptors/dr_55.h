@@ -120,6 +120,17 @@ dvbpsi_descriptor_t * dvbpsi_GenParentalRatingDr(
                                         dvbpsi_parental_rating_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeParentalRatingDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeParentalRatingDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_parental_rating_dr_t *p_decoded)
+ * \brief "parental_rating" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeParentalRatingDr(uint8_t *p_buffer, size_t i_size,
+                                     dvbpsi_parental_rating_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
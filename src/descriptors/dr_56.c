@@ -35,6 +35,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -64,7 +65,7 @@ dvbpsi_teletext_dr_t * dvbpsi_DecodeTeletextDr(
 
     /* Allocate memory */
     dvbpsi_teletext_dr_t * p_decoded;
-    p_decoded = (dvbpsi_teletext_dr_t*)malloc(sizeof(dvbpsi_teletext_dr_t));
+    p_decoded = (dvbpsi_teletext_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_teletext_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -95,35 +96,55 @@ dvbpsi_teletext_dr_t * dvbpsi_DecodeTeletextDr(
 
 
 /*****************************************************************************
- * dvbpsi_GenTeletextDr
+ * dvbpsi_EncodeTeletextDr
  *****************************************************************************/
-dvbpsi_descriptor_t * dvbpsi_GenTeletextDr(dvbpsi_teletext_dr_t * p_decoded,
-                                           bool b_duplicate)
+size_t dvbpsi_EncodeTeletextDr(uint8_t *p_buffer, size_t i_size,
+                               dvbpsi_teletext_dr_t *p_decoded)
 {
     if (p_decoded->i_pages_number > DVBPSI_TELETEXT_DR_MAX)
         p_decoded->i_pages_number = DVBPSI_TELETEXT_DR_MAX;
 
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor =
-            dvbpsi_NewDescriptor(0x56, p_decoded->i_pages_number * 5 , NULL);
-    if (!p_descriptor)
-        return NULL;
+    size_t i_length = p_decoded->i_pages_number * 5;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x56;
+    p_buffer[1] = i_length;
 
     /* Encode data */
     for (int i = 0; i < p_decoded->i_pages_number; i++ )
     {
-        memcpy( p_descriptor->p_data + 8 * i,
+        memcpy( p_data + 8 * i,
                 p_decoded->p_pages[i].i_iso6392_language_code,
                 3);
 
-        p_descriptor->p_data[8 * i + 3] =
+        p_data[8 * i + 3] =
                 (uint8_t) ( ( (uint8_t) p_decoded->p_pages[i].i_teletext_type << 3 ) |
                             ( (uint8_t) p_decoded->p_pages[i].i_teletext_magazine_number & 0x07 ) );
 
-        p_descriptor->p_data[8 * i + 4] =
+        p_data[8 * i + 4] =
                 p_decoded->p_pages[i].i_teletext_page_number;
     }
 
+    return 2 + i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_GenTeletextDr
+ *****************************************************************************/
+dvbpsi_descriptor_t * dvbpsi_GenTeletextDr(dvbpsi_teletext_dr_t * p_decoded,
+                                           bool b_duplicate)
+{
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeTeletextDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
+
     if (b_duplicate)
     {
         /* Duplicate decoded data */
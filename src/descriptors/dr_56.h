@@ -122,6 +122,17 @@ dvbpsi_descriptor_t * dvbpsi_GenTeletextDr(
                                         dvbpsi_teletext_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeTeletextDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeTeletextDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_teletext_dr_t *p_decoded)
+ * \brief "teletext" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeTeletextDr(uint8_t *p_buffer, size_t i_size,
+                               dvbpsi_teletext_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
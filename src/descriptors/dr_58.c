@@ -35,6 +35,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -60,7 +61,7 @@ dvbpsi_local_time_offset_dr_t * dvbpsi_DecodeLocalTimeOffsetDr(
         return p_descriptor->p_decoded;
 
     /* Allocate memory */
-    p_decoded = (dvbpsi_local_time_offset_dr_t*)malloc(sizeof(dvbpsi_local_time_offset_dr_t));
+    p_decoded = (dvbpsi_local_time_offset_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_local_time_offset_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -100,27 +101,26 @@ dvbpsi_local_time_offset_dr_t * dvbpsi_DecodeLocalTimeOffsetDr(
 }
 
 /*****************************************************************************
- * dvbpsi_GenLocalTimeOffsetDr
+ * dvbpsi_EncodeLocalTimeOffsetDr
  *****************************************************************************/
-dvbpsi_descriptor_t * dvbpsi_GenLocalTimeOffsetDr(
-                                        dvbpsi_local_time_offset_dr_t * p_decoded,
-                                        bool b_duplicate)
+size_t dvbpsi_EncodeLocalTimeOffsetDr(uint8_t *p_buffer, size_t i_size,
+                                      dvbpsi_local_time_offset_dr_t *p_decoded)
 {
     if (p_decoded->i_local_time_offsets_number > DVBPSI_LOCAL_TIME_OFFSET_DR_MAX)
         p_decoded->i_local_time_offsets_number = DVBPSI_LOCAL_TIME_OFFSET_DR_MAX;
 
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor =
-            dvbpsi_NewDescriptor(0x58, p_decoded->i_local_time_offsets_number * 13, NULL);
-    if (!p_descriptor)
-        return NULL;
+    size_t i_length = p_decoded->i_local_time_offsets_number * 13;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x58;
+    p_buffer[1] = i_length;
 
     /* Encode data */
     dvbpsi_local_time_offset_t * p_current;
-    uint8_t * p_data;
 
     p_current = p_decoded->p_local_time_offset;
-    p_data = p_descriptor->p_data;
 
     for (uint8_t i_num = 0; i_num < p_decoded->i_local_time_offsets_number; i_num++)
     {
@@ -142,6 +142,25 @@ dvbpsi_descriptor_t * dvbpsi_GenLocalTimeOffsetDr(
         p_current++;
     }
 
+    return 2 + i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_GenLocalTimeOffsetDr
+ *****************************************************************************/
+dvbpsi_descriptor_t * dvbpsi_GenLocalTimeOffsetDr(
+                                        dvbpsi_local_time_offset_dr_t * p_decoded,
+                                        bool b_duplicate)
+{
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeLocalTimeOffsetDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
+
     if (b_duplicate)
     {
         /* Duplicate decoded data */
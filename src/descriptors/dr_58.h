@@ -126,6 +126,17 @@ dvbpsi_descriptor_t * dvbpsi_GenLocalTimeOffsetDr(
                                         dvbpsi_local_time_offset_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeLocalTimeOffsetDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeLocalTimeOffsetDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_local_time_offset_dr_t *p_decoded)
+ * \brief "local time offset" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeLocalTimeOffsetDr(uint8_t *p_buffer, size_t i_size,
+                                      dvbpsi_local_time_offset_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
@@ -36,6 +36,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -67,7 +68,7 @@ dvbpsi_subtitling_dr_t * dvbpsi_DecodeSubtitlingDr(
         return NULL;
 
     /* Allocate memory */
-    p_decoded = (dvbpsi_subtitling_dr_t*)malloc(sizeof(dvbpsi_subtitling_dr_t));
+    p_decoded = (dvbpsi_subtitling_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_subtitling_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -100,42 +101,62 @@ dvbpsi_subtitling_dr_t * dvbpsi_DecodeSubtitlingDr(
 
 
 /*****************************************************************************
- * dvbpsi_GenSubtitlingDr
+ * dvbpsi_EncodeSubtitlingDr
  *****************************************************************************/
-dvbpsi_descriptor_t * dvbpsi_GenSubtitlingDr(
-                                        dvbpsi_subtitling_dr_t * p_decoded,
-                                        bool b_duplicate)
+size_t dvbpsi_EncodeSubtitlingDr(uint8_t *p_buffer, size_t i_size,
+                                 dvbpsi_subtitling_dr_t *p_decoded)
 {
     if (p_decoded->i_subtitles_number > DVBPSI_SUBTITLING_DR_MAX)
         p_decoded->i_subtitles_number = DVBPSI_SUBTITLING_DR_MAX;
 
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor =
-            dvbpsi_NewDescriptor(0x59, p_decoded->i_subtitles_number * 8 , NULL);
-    if (!p_descriptor)
-        return NULL;
+    size_t i_length = p_decoded->i_subtitles_number * 8;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x59;
+    p_buffer[1] = i_length;
 
     /* Encode data */
     for (int i = 0; i < p_decoded->i_subtitles_number; i++ )
     {
-        memcpy( p_descriptor->p_data + 8 * i,
+        memcpy( p_data + 8 * i,
                 p_decoded->p_subtitle[i].i_iso6392_language_code,
                 3);
 
-        p_descriptor->p_data[8 * i + 3] =
+        p_data[8 * i + 3] =
                 p_decoded->p_subtitle[i].i_subtitling_type;
 
-        p_descriptor->p_data[8 * i + 4] =
+        p_data[8 * i + 4] =
                 p_decoded->p_subtitle[i].i_composition_page_id >> 8;
-        p_descriptor->p_data[8 * i + 5] =
+        p_data[8 * i + 5] =
                 p_decoded->p_subtitle[i].i_composition_page_id % 0xFF;
 
-        p_descriptor->p_data[8 * i + 6] =
+        p_data[8 * i + 6] =
                 p_decoded->p_subtitle[i].i_ancillary_page_id >> 8;
-        p_descriptor->p_data[8 * i + 7] =
+        p_data[8 * i + 7] =
                 p_decoded->p_subtitle[i].i_ancillary_page_id % 0xFF;
     }
 
+    return 2 + i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_GenSubtitlingDr
+ *****************************************************************************/
+dvbpsi_descriptor_t * dvbpsi_GenSubtitlingDr(
+                                        dvbpsi_subtitling_dr_t * p_decoded,
+                                        bool b_duplicate)
+{
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeSubtitlingDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
+
     if (b_duplicate)
     {
         /* Duplicate decoded data */
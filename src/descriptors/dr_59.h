@@ -122,6 +122,17 @@ dvbpsi_descriptor_t * dvbpsi_GenSubtitlingDr(
                                         dvbpsi_subtitling_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeSubtitlingDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeSubtitlingDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_subtitling_dr_t *p_decoded)
+ * \brief "subtitling" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeSubtitlingDr(uint8_t *p_buffer, size_t i_size,
+                                 dvbpsi_subtitling_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
@@ -35,6 +35,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -57,7 +58,7 @@ dvbpsi_terr_deliv_sys_dr_t * dvbpsi_DecodeTerrDelivSysDr(
 
     /* Allocate memory */
     dvbpsi_terr_deliv_sys_dr_t * p_decoded;
-    p_decoded = (dvbpsi_terr_deliv_sys_dr_t*)malloc(sizeof(dvbpsi_terr_deliv_sys_dr_t));
+    p_decoded = (dvbpsi_terr_deliv_sys_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_terr_deliv_sys_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -83,6 +84,45 @@ dvbpsi_terr_deliv_sys_dr_t * dvbpsi_DecodeTerrDelivSysDr(
     return p_decoded;
 }
 
+/*****************************************************************************
+ * dvbpsi_EncodeTerrDelivSysDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeTerrDelivSysDr(uint8_t *p_buffer, size_t i_size,
+                                   dvbpsi_terr_deliv_sys_dr_t *p_decoded)
+{
+    size_t i_length = 11;
+    if (i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x5a;
+    p_buffer[1] = i_length;
+
+    /* Encode data */
+    p_data[0]  =   (p_decoded->i_centre_frequency >> 24) & 0xff;
+    p_data[1]  =   (p_decoded->i_centre_frequency >> 16) & 0xff;
+    p_data[2]  =   (p_decoded->i_centre_frequency >>  8) & 0xff;
+    p_data[3]  =    p_decoded->i_centre_frequency        & 0xff;
+    p_data[4]  =   (p_decoded->i_bandwidth               & 0x07) << 5
+                 | (p_decoded->i_priority                & 0x01) << 4
+                 | (p_decoded->i_time_slice_indicator    & 0x01) << 3
+                 | (p_decoded->i_mpe_fec_indicator       & 0x01) << 2
+                 | 0x03;
+    p_data[5]  =   (p_decoded->i_constellation           & 0x03) << 6
+                 | (p_decoded->i_hierarchy_information   & 0x07) << 3
+                 | (p_decoded->i_code_rate_hp_stream     & 0x07);
+    p_data[6]  =   (p_decoded->i_code_rate_lp_stream     & 0x07) << 5
+                 | (p_decoded->i_guard_interval          & 0x03) << 3
+                 | (p_decoded->i_transmission_mode       & 0x03) << 1
+                 | (p_decoded->i_other_frequency_flag    & 0x01);
+    p_data[7]  =   0xff;
+    p_data[8]  =   0xff;
+    p_data[9]  =   0xff;
+    p_data[10] =   0xff;
+
+    return 2 + i_length;
+}
+
 /*****************************************************************************
  * dvbpsi_GenTerrDelivSysDr
  *****************************************************************************/
@@ -90,32 +130,14 @@ dvbpsi_descriptor_t * dvbpsi_GenTerrDelivSysDr(
                                         dvbpsi_terr_deliv_sys_dr_t * p_decoded,
                                         bool b_duplicate)
 {
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor = dvbpsi_NewDescriptor(0x5a, 11, NULL);
-    if (!p_descriptor)
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeTerrDelivSysDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
         return NULL;
 
-    /* Encode data */
-    p_descriptor->p_data[0]  =   (p_decoded->i_centre_frequency >> 24) & 0xff;
-    p_descriptor->p_data[1]  =   (p_decoded->i_centre_frequency >> 16) & 0xff;
-    p_descriptor->p_data[2]  =   (p_decoded->i_centre_frequency >>  8) & 0xff;
-    p_descriptor->p_data[3]  =    p_decoded->i_centre_frequency        & 0xff;
-    p_descriptor->p_data[4]  =   (p_decoded->i_bandwidth               & 0x07) << 5
-                               | (p_decoded->i_priority                & 0x01) << 4
-                               | (p_decoded->i_time_slice_indicator    & 0x01) << 3
-                               | (p_decoded->i_mpe_fec_indicator       & 0x01) << 2
-                               | 0x03;
-    p_descriptor->p_data[5]  =   (p_decoded->i_constellation           & 0x03) << 6
-                               | (p_decoded->i_hierarchy_information   & 0x07) << 3
-                               | (p_decoded->i_code_rate_hp_stream     & 0x07);
-    p_descriptor->p_data[6]  =   (p_decoded->i_code_rate_lp_stream     & 0x07) << 5
-                               | (p_decoded->i_guard_interval          & 0x03) << 3
-                               | (p_decoded->i_transmission_mode       & 0x03) << 1
-                               | (p_decoded->i_other_frequency_flag    & 0x01);
-    p_descriptor->p_data[7]  =   0xff;
-    p_descriptor->p_data[8]  =   0xff;
-    p_descriptor->p_data[9]  =   0xff;
-    p_descriptor->p_data[10] =   0xff;
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
 
     if (b_duplicate)
     {
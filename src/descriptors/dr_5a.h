@@ -104,6 +104,17 @@ dvbpsi_descriptor_t * dvbpsi_GenTerrDelivSysDr(
                                         dvbpsi_terr_deliv_sys_dr_t * p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeTerrDelivSysDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeTerrDelivSysDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_terr_deliv_sys_dr_t *p_decoded)
+ * \brief terrestrial delivery system descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeTerrDelivSysDr(uint8_t *p_buffer, size_t i_size,
+                                   dvbpsi_terr_deliv_sys_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
@@ -34,6 +34,7 @@ Decode Frequency List Descriptor.
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -58,7 +59,7 @@ dvbpsi_frequency_list_dr_t *dvbpsi_DecodeFrequencyListDr(dvbpsi_descriptor_t *p_
     if ((p_descriptor->i_length - 1) % 4)
         return NULL;
 
-    p_decoded = (dvbpsi_frequency_list_dr_t*)malloc(sizeof(dvbpsi_frequency_list_dr_t));
+    p_decoded = (dvbpsi_frequency_list_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_frequency_list_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -34,6 +34,7 @@ Decode Data Broadcast Id Descriptor.
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -47,7 +48,7 @@ static dvbpsi_data_broadcast_id_dr_t *NewDataBroadcastDr(const size_t i_private)
         return NULL;
 
     p_bcast = (dvbpsi_data_broadcast_id_dr_t *)
-                calloc(1, sizeof(dvbpsi_data_broadcast_id_dr_t) + i_private);
+                dvbpsi_calloc(1, sizeof(dvbpsi_data_broadcast_id_dr_t) + i_private);
     if (p_bcast)
     {
         p_bcast->p_id_selector = ((uint8_t *)p_bcast + sizeof(dvbpsi_data_broadcast_id_dr_t));
@@ -35,6 +35,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -61,7 +62,7 @@ dvbpsi_PDC_dr_t * dvbpsi_DecodePDCDr(dvbpsi_descriptor_t * p_descriptor)
         return NULL;
 
     /* Allocate memory */
-    p_decoded = (dvbpsi_PDC_dr_t*)malloc(sizeof(dvbpsi_PDC_dr_t));
+    p_decoded = (dvbpsi_PDC_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_PDC_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -78,24 +79,45 @@ dvbpsi_PDC_dr_t * dvbpsi_DecodePDCDr(dvbpsi_descriptor_t * p_descriptor)
 }
 
 
+/*****************************************************************************
+ * dvbpsi_EncodePDCDr
+ *****************************************************************************/
+size_t dvbpsi_EncodePDCDr(uint8_t *p_buffer, size_t i_size,
+                          dvbpsi_PDC_dr_t *p_decoded)
+{
+    size_t i_length = 3;
+    if (i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x69;
+    p_buffer[1] = i_length;
+
+    /* Encode data */
+    p_data[0] = 0xf0 | (p_decoded->i_PDC[0] >> 1);
+    p_data[1] = (p_decoded->i_PDC[0] << 7) |
+                (p_decoded->i_PDC[1] << 3) |
+                (p_decoded->i_PDC[2] >> 2);
+    p_data[2] = (p_decoded->i_PDC[2] << 6 ) |
+                 p_decoded->i_PDC[3];
+
+    return 2 + i_length;
+}
+
 /*****************************************************************************
  * dvbpsi_GenPDCDr
  *****************************************************************************/
 dvbpsi_descriptor_t * dvbpsi_GenPDCDr(dvbpsi_PDC_dr_t * p_decoded,
                                       bool b_duplicate)
 {
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor = dvbpsi_NewDescriptor(0x69, 3, NULL);
-    if (!p_descriptor)
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodePDCDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
         return NULL;
 
-    /* Encode data */
-    p_descriptor->p_data[0] = 0xf0 | (p_decoded->i_PDC[0] >> 1);
-    p_descriptor->p_data[1] = (p_decoded->i_PDC[0] << 7) |
-                              (p_decoded->i_PDC[1] << 3) |
-                              (p_decoded->i_PDC[2] >> 2);
-    p_descriptor->p_data[2] = (p_decoded->i_PDC[2] << 6 ) |
-                               p_decoded->i_PDC[3];
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
 
     if (b_duplicate)
     {
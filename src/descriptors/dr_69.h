@@ -89,6 +89,17 @@ dvbpsi_PDC_dr_t* dvbpsi_DecodePDCDr(dvbpsi_descriptor_t * p_descriptor);
 dvbpsi_descriptor_t * dvbpsi_GenPDCDr(dvbpsi_PDC_dr_t * p_decoded,
                                       bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodePDCDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodePDCDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_PDC_dr_t *p_decoded)
+ * \brief PDC descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodePDCDr(uint8_t *p_buffer, size_t i_size,
+                          dvbpsi_PDC_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
@@ -34,6 +34,7 @@ Decode Default Authority Descriptor.
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -54,7 +55,7 @@ dvbpsi_default_authority_dr_t *dvbpsi_DecodeDefaultAuthorityDr(dvbpsi_descriptor
     if (p_descriptor->p_decoded)
         return p_descriptor->p_decoded;
 
-    p_decoded = (dvbpsi_default_authority_dr_t*)malloc(sizeof(dvbpsi_default_authority_dr_t));
+    p_decoded = (dvbpsi_default_authority_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_default_authority_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -34,6 +34,7 @@ Decode Content Identifier Descriptor.
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -59,7 +60,7 @@ dvbpsi_content_id_dr_t *dvbpsi_DecodeContentIdDr(dvbpsi_descriptor_t *p_descript
     if (p_descriptor->i_length > ARRAY_SIZE(p_decoded->p_entries))
         p_descriptor->i_length = ARRAY_SIZE(p_decoded->p_entries);
 
-    p_decoded = (dvbpsi_content_id_dr_t*)malloc(sizeof(dvbpsi_content_id_dr_t));
+    p_decoded = (dvbpsi_content_id_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_content_id_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -99,7 +100,7 @@ dvbpsi_content_id_dr_t *dvbpsi_DecodeContentIdDr(dvbpsi_descriptor_t *p_descript
         else
         {
             /* Unknown location */
-            free(p_decoded);
+            dvbpsi_free(p_decoded);
             return NULL;
         }
     }
@@ -35,6 +35,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -46,7 +47,7 @@ struct dvbpsi_aac_profile_and_level_table_s
     uint8_t hex;
     dvbpsi_aac_profile_and_level_t profile_and_level;
 };
-static struct dvbpsi_aac_profile_and_level_table_s aac_profile_and_level_table[] =
+static const struct dvbpsi_aac_profile_and_level_table_s aac_profile_and_level_table[] =
 {
     { 0x00, DVBPSI_AAC_PROFILE_RESERVED },
     /* 0x00-0x0E Reserved */
@@ -150,7 +151,7 @@ struct dvbpsi_aac_type_table_s
     uint8_t hex;
     dvbpsi_aac_type_t type;
 };
-static struct dvbpsi_aac_type_table_s aac_type_table[] =
+static const struct dvbpsi_aac_type_table_s aac_type_table[] =
 {
     { 0x00, DVBPSI_AAC_RESERVED0 },
     { 0x01, DVBPSI_HE_AAC_MONO   },
@@ -234,32 +235,34 @@ dvbpsi_aac_dr_t *dvbpsi_DecodeAACDr(dvbpsi_descriptor_t *p_descriptor)
     if (p_descriptor->i_length == 0x01)
         return NULL;
 
-    /* Allocate memory */
+    /* AAC Audio descriptor
+     * ETSI EN 300 468 V1.13.1 (2012-04) Annex H
+     */
+    bool b_type = false;
+    uint8_t i_info_length = 0;
+    if (p_descriptor->i_length > 1)
+    {
+        b_type = ((p_descriptor->p_data[1]>>7) == 0x01);
+        if (b_type && p_descriptor->i_length < 3)
+            return NULL;
+        i_info_length = p_descriptor->i_length - (b_type ? 3 : 2);
+    }
+
+    /* Allocate memory, additional info bytes follow the structure */
     dvbpsi_aac_dr_t *p_decoded;
-    p_decoded = (dvbpsi_aac_dr_t*)calloc(1, sizeof(dvbpsi_aac_dr_t));
+    p_decoded = (dvbpsi_aac_dr_t*)dvbpsi_calloc(1, sizeof(dvbpsi_aac_dr_t) + i_info_length);
     if (!p_decoded)
         return NULL;
 
-    /* AAC Audio descriptor
-     * ETSI EN 300 468 V1.13.1 (2012-04) Annex H
-     */
     p_decoded->i_profile_and_level = dvbpsi_aac_profile_and_level_lookup(p_descriptor->p_data[0]);
-    if (p_descriptor->i_length > 1)
-        p_decoded->b_type = ((p_descriptor->p_data[1]>>7) == 0x01);
+    p_decoded->b_type = b_type;
     if (p_decoded->b_type)
         p_decoded->i_type = dvbpsi_aac_type_lookup(p_descriptor->p_data[2]);
 
     /* Keep additional info bytes field */
     if (p_descriptor->i_length > 1)
     {
-        uint8_t i_info_length = p_descriptor->i_length - (p_decoded->b_type ? 3 : 2);
-        dvbpsi_aac_dr_t *p_tmp = realloc(p_decoded, sizeof(dvbpsi_aac_dr_t) + i_info_length);
-        if (!p_tmp)
-        {
-            free(p_decoded);
-            return NULL;
-        }
-        p_decoded->p_additional_info = ((uint8_t*)p_tmp + sizeof(dvbpsi_aac_dr_t));
+        p_decoded->p_additional_info = ((uint8_t*)p_decoded + sizeof(dvbpsi_aac_dr_t));
         p_decoded->i_additional_info_length = i_info_length;
 
         uint8_t i_data = p_decoded->b_type ? 3 : 2;
@@ -273,35 +276,55 @@ dvbpsi_aac_dr_t *dvbpsi_DecodeAACDr(dvbpsi_descriptor_t *p_descriptor)
 }
 
 /*****************************************************************************
- * dvbpsi_GenAACDr
+ * dvbpsi_EncodeAACDr
  *****************************************************************************/
-dvbpsi_descriptor_t *dvbpsi_GenAACDr(dvbpsi_aac_dr_t *p_decoded, bool b_duplicate)
+size_t dvbpsi_EncodeAACDr(uint8_t *p_buffer, size_t i_size,
+                          dvbpsi_aac_dr_t *p_decoded)
 {
-    /* Create the descriptor */
-    uint8_t i_length = p_decoded->b_type ? 3 + p_decoded->i_additional_info_length : 1;
-    dvbpsi_descriptor_t *p_descriptor = dvbpsi_NewDescriptor(0x7c, i_length, NULL);
-    if (!p_descriptor)
-        return NULL;
+    size_t i_length = p_decoded->b_type ? 3 + p_decoded->i_additional_info_length : 1;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x7c;
+    p_buffer[1] = i_length;
 
     /* Encode data */
-    p_descriptor->p_data[0] = dvbpsi_aac_profile_and_level_to_hex(p_decoded->i_profile_and_level);
+    p_data[0] = dvbpsi_aac_profile_and_level_to_hex(p_decoded->i_profile_and_level);
 
-    if (p_descriptor->i_length > 1)
+    if (i_length > 1)
     {
-        p_descriptor->p_data[1]  = 0x00;
-        p_descriptor->p_data[1] |= ((p_decoded->b_type ? 1: 0) << 7);
+        p_data[1]  = 0x00;
+        p_data[1] |= ((p_decoded->b_type ? 1: 0) << 7);
     }
 
     if (p_decoded->b_type)
-        p_descriptor->p_data[2] = dvbpsi_aac_type_to_hex(p_decoded->i_type);
+        p_data[2] = dvbpsi_aac_type_to_hex(p_decoded->i_type);
 
     /* Store additional info bytes field */
-    if (p_descriptor->i_length > 1)
+    if (i_length > 1)
     {
-        uint8_t *p = &p_descriptor->p_data[p_decoded->b_type ? 3 : 2];
+        uint8_t *p = &p_data[p_decoded->b_type ? 3 : 2];
         memcpy(p, p_decoded->p_additional_info, p_decoded->i_additional_info_length);
     }
 
+    return 2 + i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_GenAACDr
+ *****************************************************************************/
+dvbpsi_descriptor_t *dvbpsi_GenAACDr(dvbpsi_aac_dr_t *p_decoded, bool b_duplicate)
+{
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeAACDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
+
     if (b_duplicate)
     {
         /* Duplicate decoded data */
@@ -136,6 +136,17 @@ dvbpsi_aac_dr_t* dvbpsi_DecodeAACDr(dvbpsi_descriptor_t *p_descriptor);
  */
 dvbpsi_descriptor_t *dvbpsi_GenAACDr(dvbpsi_aac_dr_t *p_decoded, bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeAACDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeAACDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_aac_dr_t *p_decoded)
+ * \brief "AAC" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeAACDr(uint8_t *p_buffer, size_t i_size,
+                          dvbpsi_aac_dr_t *p_decoded);
+
 #ifdef __cplusplus
 };
 #endif
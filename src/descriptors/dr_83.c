@@ -34,17 +34,21 @@ Decode Logical Channel Number Descriptor.
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
 #include "dr_83.h"
 
 /*****************************************************************************
- * dvbpsi_DecodeLCNDr
+ * dvbpsi_LCNDrDecode
+ *****************************************************************************
+ * Decodes into the whole dvbpsi_lcn_dr_t or only the entries of the
+ * descriptor.
  *****************************************************************************/
-dvbpsi_lcn_dr_t *dvbpsi_DecodeLCNDr(dvbpsi_descriptor_t *p_descriptor)
+static void *dvbpsi_LCNDrDecode(dvbpsi_descriptor_t *p_descriptor, bool b_counted)
 {
-    dvbpsi_lcn_dr_t *p_decoded;
+    dvbpsi_lcn_counted_t *p_decoded;
     int i;
 
     /* Check the tag */
@@ -59,13 +63,14 @@ dvbpsi_lcn_dr_t *dvbpsi_DecodeLCNDr(dvbpsi_descriptor_t *p_descriptor)
     if (p_descriptor->i_length % 4)
         return NULL;
 
-    p_decoded = (dvbpsi_lcn_dr_t*)malloc(sizeof(dvbpsi_lcn_dr_t));
+    /* At most 63 entries, which dvbpsi_lcn_dr_t holds */
+    unsigned int i_entries = p_descriptor->i_length / 4;
+    p_decoded = dvbpsi_malloc(b_counted ? DVBPSI_LCN_COUNTED_SIZE(i_entries)
+                                        : sizeof(dvbpsi_lcn_dr_t));
     if (!p_decoded)
         return NULL;
 
-    p_decoded->i_number_of_entries = p_descriptor->i_length / 4;
-    if (p_decoded->i_number_of_entries > ARRAY_SIZE(p_decoded->p_entries))
-        p_decoded->i_number_of_entries = ARRAY_SIZE(p_decoded->p_entries);
+    p_decoded->i_number_of_entries = i_entries;
 
     for (i = 0; i < p_decoded->i_number_of_entries; i ++)
     {
@@ -85,32 +90,72 @@ dvbpsi_lcn_dr_t *dvbpsi_DecodeLCNDr(dvbpsi_descriptor_t *p_descriptor)
 }
 
 /*****************************************************************************
- * dvbpsi_GenLCNDr
+ * dvbpsi_DecodeLCNDr
  *****************************************************************************/
-dvbpsi_descriptor_t* dvbpsi_GenLCNDr(dvbpsi_lcn_dr_t* p_decoded,
-                                       bool b_duplicate)
+dvbpsi_lcn_dr_t *dvbpsi_DecodeLCNDr(dvbpsi_descriptor_t *p_descriptor)
+{
+    return dvbpsi_LCNDrDecode(p_descriptor, false);
+}
+
+/*****************************************************************************
+ * dvbpsi_DecodeLCNDrCounted
+ *****************************************************************************/
+dvbpsi_lcn_counted_t *dvbpsi_DecodeLCNDrCounted(dvbpsi_descriptor_t *p_descriptor)
+{
+    return dvbpsi_LCNDrDecode(p_descriptor, true);
+}
+
+/*****************************************************************************
+ * dvbpsi_EncodeLCNDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeLCNDr(uint8_t *p_buffer, size_t i_size,
+                          dvbpsi_lcn_dr_t *p_decoded)
 {
     if (p_decoded->i_number_of_entries > 63)
-        p_decoded->i_number_of_entries = 63;
+        return 0;
 
-    dvbpsi_descriptor_t* p_descriptor = dvbpsi_NewDescriptor(0x83, p_decoded->i_number_of_entries * 4, 0);
-    if (NULL == p_descriptor)
-        return NULL;
+    size_t i_length = p_decoded->i_number_of_entries * 4;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x83;
+    p_buffer[1] = i_length;
 
     for (int i = 0; i < p_decoded->i_number_of_entries; i++ )
     {
-        p_descriptor->p_data[4 * i] = p_decoded->p_entries[i].i_service_id >> 8;
-        p_descriptor->p_data[4 * i + 1] = p_decoded->p_entries[i].i_service_id;
-        p_descriptor->p_data[4 * i + 2] = (p_decoded->p_entries[i].b_visible_service_flag << 7);
-        p_descriptor->p_data[4 * i + 2] |= (p_decoded->p_entries[i].i_logical_channel_number >> 8);
-        p_descriptor->p_data[4 * i + 3] = p_decoded->p_entries[i].i_logical_channel_number;
+        p_data[4 * i] = p_decoded->p_entries[i].i_service_id >> 8;
+        p_data[4 * i + 1] = p_decoded->p_entries[i].i_service_id;
+        p_data[4 * i + 2] = (p_decoded->p_entries[i].b_visible_service_flag << 7);
+        p_data[4 * i + 2] |= (p_decoded->p_entries[i].i_logical_channel_number >> 8);
+        p_data[4 * i + 3] = p_decoded->p_entries[i].i_logical_channel_number;
     }
 
+    return 2 + i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_GenLCNDr
+ *****************************************************************************/
+dvbpsi_descriptor_t* dvbpsi_GenLCNDr(dvbpsi_lcn_dr_t* p_decoded,
+                                       bool b_duplicate)
+{
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeLCNDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
+
     if (b_duplicate)
     {
-        dvbpsi_lcn_dr_t * p_dup = (dvbpsi_lcn_dr_t*) malloc(sizeof (dvbpsi_lcn_dr_t));
+        /* p_decoded may be a counted form */
+        size_t i_size = DVBPSI_LCN_COUNTED_SIZE(p_decoded->i_number_of_entries);
+        dvbpsi_lcn_dr_t * p_dup = (dvbpsi_lcn_dr_t*) dvbpsi_malloc(i_size);
         if (NULL != p_dup)
-            memcpy(p_dup, p_decoded, sizeof(dvbpsi_lcn_dr_t));
+            memcpy(p_dup, p_decoded, i_size);
         p_descriptor->p_decoded = (void*)p_dup;
     }
 
@@ -73,6 +73,35 @@ typedef struct dvbpsi_lcn_dr_s
     dvbpsi_lcn_entry_t p_entries[64];/*!< Array of LCN entries. */
 } dvbpsi_lcn_dr_t;
 
+/*****************************************************************************
+ * dvbpsi_lcn_counted_s
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_lcn_counted_s
+ * \brief Logical Channel Number Descriptor sized to its entries
+ *
+ * The descriptors decoded by dvbpsi_decode_descriptors() hold this form,
+ * of which dvbpsi_lcn_dr_t is the prefix: only its first
+ * i_number_of_entries entries are then there, and it must not be copied as
+ * a whole.
+ */
+/*!
+ * \typedef struct dvbpsi_lcn_counted_s dvbpsi_lcn_counted_t
+ * \brief dvbpsi_lcn_counted_t type definition.
+ */
+typedef struct dvbpsi_lcn_counted_s
+{
+    uint8_t i_number_of_entries;     /*!< Number of LCN entries present. */
+    dvbpsi_lcn_entry_t p_entries[];  /*!< Array of LCN entries. */
+} dvbpsi_lcn_counted_t;
+
+/*!
+ * \def DVBPSI_LCN_COUNTED_SIZE(count)
+ * \brief Size of a dvbpsi_lcn_counted_t of count entries.
+ */
+#define DVBPSI_LCN_COUNTED_SIZE(count)                                         \
+    (sizeof(dvbpsi_lcn_counted_t) + (count) * sizeof(dvbpsi_lcn_entry_t))
+
 /*****************************************************************************
  * dvbpsi_DecodeLCNDr
  *****************************************************************************/
@@ -85,6 +114,25 @@ typedef struct dvbpsi_lcn_dr_s
  */
 dvbpsi_lcn_dr_t *dvbpsi_DecodeLCNDr(dvbpsi_descriptor_t *p_descriptor);
 
+/*****************************************************************************
+ * dvbpsi_DecodeLCNDrCounted
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_lcn_counted_t *dvbpsi_DecodeLCNDrCounted(
+                                        dvbpsi_descriptor_t *p_descriptor)
+ * \brief Decode a Logical Channel Number descriptor (tag 0x83), sized to
+ * its entries
+ * \param p_descriptor Raw descriptor to decode.
+ * \return NULL if the descriptor could not be decoded or a pointer to a
+ *         dvbpsi_lcn_counted_t structure, stored in
+ *         dvbpsi_descriptor_t::p_decoded as dvbpsi_DecodeLCNDr() does.
+ *
+ * The decoded form is allocated like the descriptor, from the arena of its
+ * table with DVBPSI_FLAG_TABLE_ARENA. A descriptor already decoded by
+ * dvbpsi_DecodeLCNDr() is returned as is.
+ */
+dvbpsi_lcn_counted_t *dvbpsi_DecodeLCNDrCounted(dvbpsi_descriptor_t *p_descriptor);
+
 /*****************************************************************************
  * dvbpsi_GenLCNDr
  *****************************************************************************/
@@ -100,6 +148,19 @@ dvbpsi_lcn_dr_t *dvbpsi_DecodeLCNDr(dvbpsi_descriptor_t *p_descriptor);
  */
 dvbpsi_descriptor_t* dvbpsi_GenLCNDr(dvbpsi_lcn_dr_t* p_decoded, bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeLCNDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeLCNDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_lcn_dr_t *p_decoded)
+ * \brief "logical_channel" descriptor encoder, see descriptor.h.
+ *
+ * More than 63 entries do not fit in a descriptor.
+ */
+size_t dvbpsi_EncodeLCNDr(uint8_t *p_buffer, size_t i_size,
+                          dvbpsi_lcn_dr_t *p_decoded);
+
 #ifdef __cplusplus
 };
 #endif
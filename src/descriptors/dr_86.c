@@ -34,6 +34,7 @@ Decode Caption Service Descriptor.
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -59,7 +60,7 @@ dvbpsi_caption_service_dr_t *dvbpsi_DecodeCaptionServiceDr(dvbpsi_descriptor_t *
     if ((p_descriptor->i_length - 1) % 6)
         return NULL;
 
-    p_decoded = (dvbpsi_caption_service_dr_t*)malloc(sizeof(dvbpsi_caption_service_dr_t));
+    p_decoded = (dvbpsi_caption_service_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_caption_service_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -35,6 +35,7 @@
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -58,7 +59,7 @@ dvbpsi_cuei_dr_t * dvbpsi_DecodeCUEIDr(dvbpsi_descriptor_t * p_descriptor)
 
     /* Allocate memory */
     dvbpsi_cuei_dr_t *p_decoded;
-    p_decoded = (dvbpsi_cuei_dr_t*)malloc(sizeof(dvbpsi_cuei_dr_t));
+    p_decoded = (dvbpsi_cuei_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_cuei_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -79,18 +80,39 @@ dvbpsi_cuei_dr_t * dvbpsi_DecodeCUEIDr(dvbpsi_descriptor_t * p_descriptor)
     return p_decoded;
 }
 
+/*****************************************************************************
+ * dvbpsi_EncodeCUEIDr
+ *****************************************************************************/
+size_t dvbpsi_EncodeCUEIDr(uint8_t *p_buffer, size_t i_size,
+                           dvbpsi_cuei_dr_t *p_decoded)
+{
+    size_t i_length = 0x01;
+    if (i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0x8a;
+    p_buffer[1] = i_length;
+
+    /* Encode data */
+    p_data[0] = p_decoded->i_cue_stream_type;
+
+    return 2 + i_length;
+}
+
 /*****************************************************************************
  * dvbpsi_GenCUEIDr
  *****************************************************************************/
 dvbpsi_descriptor_t * dvbpsi_GenCUEIDr(dvbpsi_cuei_dr_t * p_decoded, bool b_duplicate)
 {
-    /* Create the descriptor */
-    dvbpsi_descriptor_t * p_descriptor = dvbpsi_NewDescriptor(0x8a, 0x01, NULL);
-    if (!p_descriptor)
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeCUEIDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
         return NULL;
 
-    /* Encode data */
-    p_descriptor->p_data[0] = p_decoded->i_cue_stream_type;
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
 
     if (b_duplicate)
     {
@@ -86,6 +86,17 @@ dvbpsi_cuei_dr_t* dvbpsi_DecodeCUEIDr(dvbpsi_descriptor_t * p_descriptor);
  */
 dvbpsi_descriptor_t * dvbpsi_GenCUEIDr(dvbpsi_cuei_dr_t * p_decoded, bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeCUEIDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeCUEIDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_cuei_dr_t *p_decoded)
+ * \brief "CUEI" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeCUEIDr(uint8_t *p_buffer, size_t i_size,
+                           dvbpsi_cuei_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 };
@@ -34,6 +34,7 @@ Decode Extended Channel Name Descriptor.
 #endif
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODED_DR
 #include "../dvbpsi_private.h"
 #include "../descriptor.h"
 
@@ -58,7 +59,7 @@ dvbpsi_extended_channel_name_dr_t *dvbpsi_ExtendedChannelNameDr(dvbpsi_descripto
     if (!p_descriptor->i_length)
         return NULL;
 
-    p_decoded = (dvbpsi_extended_channel_name_dr_t*)malloc(sizeof(dvbpsi_extended_channel_name_dr_t));
+    p_decoded = (dvbpsi_extended_channel_name_dr_t*)dvbpsi_malloc(sizeof(dvbpsi_extended_channel_name_dr_t));
     if (!p_decoded)
         return NULL;
 
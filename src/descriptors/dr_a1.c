@@ -64,7 +64,7 @@ dvbpsi_DecodeServiceLocationDr (dvbpsi_descriptor_t * p_descriptor)
 
     /* Allocate memory */
     p_decoded = (dvbpsi_service_location_dr_t *)
-            malloc (sizeof (dvbpsi_service_location_dr_t));
+            dvbpsi_malloc (sizeof (dvbpsi_service_location_dr_t));
     if (!p_decoded)
         return NULL;
 
@@ -93,21 +93,22 @@ dvbpsi_DecodeServiceLocationDr (dvbpsi_descriptor_t * p_descriptor)
 
 
 /*****************************************************************************
- * dvbpsi_GenServiceLocationDr
+ * dvbpsi_EncodeServiceLocationDr
  *****************************************************************************/
-dvbpsi_descriptor_t* dvbpsi_GenServiceLocationDr(
-                                        dvbpsi_service_location_dr_t* p_decoded,
-                                        bool b_duplicate)
+size_t dvbpsi_EncodeServiceLocationDr(uint8_t *p_buffer, size_t i_size,
+                                      dvbpsi_service_location_dr_t *p_decoded)
 {
     if (p_decoded->i_number_elements > 42)
         p_decoded->i_number_elements = 42;
 
-    uint8_t i_desc_length = 3 + p_decoded->i_number_elements * 6;
-    dvbpsi_descriptor_t* p_descriptor = dvbpsi_NewDescriptor(0xa1, i_desc_length, NULL);
-    if (!p_descriptor)
-        return NULL;
+    size_t i_length = 3 + p_decoded->i_number_elements * 6;
+    if (i_length > 255 || i_size < 2 + i_length)
+        return 0;
+
+    uint8_t *p_data = p_buffer + 2;
+    p_buffer[0] = 0xa1;
+    p_buffer[1] = i_length;
 
-    uint8_t* p_data = p_descriptor->p_data;
     p_data[0] = p_decoded->i_pcr_pid >> 8;
     p_data[1] = p_decoded->i_pcr_pid;
     p_data[2] = p_decoded->i_number_elements;
@@ -127,6 +128,25 @@ dvbpsi_descriptor_t* dvbpsi_GenServiceLocationDr(
         p_data += 6;
     }
 
+    return 2 + i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_GenServiceLocationDr
+ *****************************************************************************/
+dvbpsi_descriptor_t* dvbpsi_GenServiceLocationDr(
+                                        dvbpsi_service_location_dr_t* p_decoded,
+                                        bool b_duplicate)
+{
+    uint8_t p_buffer[2 + 255];
+    if (dvbpsi_EncodeServiceLocationDr(p_buffer, sizeof(p_buffer), p_decoded) == 0)
+        return NULL;
+
+    dvbpsi_descriptor_t * p_descriptor =
+            dvbpsi_NewDescriptor(p_buffer[0], p_buffer[1], p_buffer + 2);
+    if (!p_descriptor)
+        return NULL;
+
     if (b_duplicate)
     {
         p_descriptor->p_decoded = dvbpsi_DuplicateDecodedDescriptor(p_decoded,
@@ -110,6 +110,17 @@ dvbpsi_descriptor_t* dvbpsi_GenServiceLocationDr(
                                         dvbpsi_service_location_dr_t* p_decoded,
                                         bool b_duplicate);
 
+/*****************************************************************************
+ * dvbpsi_EncodeServiceLocationDr
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_EncodeServiceLocationDr(uint8_t *p_buffer, size_t i_size,
+ *                  dvbpsi_service_location_dr_t *p_decoded)
+ * \brief "service location" descriptor encoder, see descriptor.h.
+ */
+size_t dvbpsi_EncodeServiceLocationDr(uint8_t *p_buffer, size_t i_size,
+                                      dvbpsi_service_location_dr_t *p_decoded);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,331 @@
+/* This file is generated by applying the dr_codec.xsl stylesheet to the
+ * dr.xml description file. DO NOT EDIT !!! */
+
+/*****************************************************************************
+ * dr_codec.h: fixed-size fields of the descriptors
+ *****************************************************************************
+ * Each descriptor of dr.xml with a tag and a length has:
+ *  - DVBPSI_<SNAME>_DR_LENGTH, the size in bytes of the block of its
+ *    fixed-size fields at the start of the descriptor data,
+ *  - dvbpsi_unpack_<sname>_dr(), which reads these fields,
+ *  - dvbpsi_pack_<sname>_dr(), which writes them, reserved bits set to 1.
+ * The block is handled as one big endian 64 bit word, without any test:
+ * the caller checks once that the data holds DVBPSI_<SNAME>_DR_LENGTH
+ * bytes. Only the functions of the dr_*.h headers included before are
+ * defined.
+ *****************************************************************************/
+
+#ifndef _DVBPSI_DR_CODEC_H_
+#define _DVBPSI_DR_CODEC_H_
+
+#ifdef _DVBPSI_DR_03_H_
+/* audio stream, tag 0x03 */
+#define DVBPSI_ASTREAM_DR_LENGTH 1
+
+static inline void dvbpsi_unpack_astream_dr(dvbpsi_astream_dr_t *p_decoded, const uint8_t *p_data)
+{
+    const uint64_t i_bits = ((uint64_t)p_data[0] << 56);
+    p_decoded->b_free_format = i_bits << 0 >> 63;
+    p_decoded->i_id = i_bits << 1 >> 63;
+    p_decoded->i_layer = i_bits << 2 >> 62;
+    p_decoded->b_variable_rate_audio_indicator = i_bits << 4 >> 63;
+}
+
+static inline void dvbpsi_pack_astream_dr(uint8_t *p_data, const dvbpsi_astream_dr_t *p_decoded)
+{
+    uint64_t i_bits = 0;
+    i_bits |= (uint64_t)p_decoded->b_free_format << 63 >> 0;
+    i_bits |= (uint64_t)p_decoded->i_id << 63 >> 1;
+    i_bits |= (uint64_t)p_decoded->i_layer << 62 >> 2;
+    i_bits |= (uint64_t)p_decoded->b_variable_rate_audio_indicator << 63 >> 4;
+    i_bits |= ~(uint64_t)0 << 61 >> 5;
+    p_data[0] = i_bits >> 56;
+}
+#endif
+
+#ifdef _DVBPSI_DR_04_H_
+/* hierarchy, tag 0x04 */
+#define DVBPSI_HIERARCHY_DR_LENGTH 4
+
+static inline void dvbpsi_unpack_hierarchy_dr(dvbpsi_hierarchy_dr_t *p_decoded, const uint8_t *p_data)
+{
+    const uint64_t i_bits = ((uint64_t)p_data[0] << 56) |
+                            ((uint64_t)p_data[1] << 48) |
+                            ((uint64_t)p_data[2] << 40) |
+                            ((uint64_t)p_data[3] << 32);
+    p_decoded->i_h_type = i_bits << 4 >> 60;
+    p_decoded->i_h_layer_index = i_bits << 10 >> 58;
+    p_decoded->i_h_embedded_layer = i_bits << 18 >> 58;
+    p_decoded->i_h_priority = i_bits << 26 >> 58;
+}
+
+static inline void dvbpsi_pack_hierarchy_dr(uint8_t *p_data, const dvbpsi_hierarchy_dr_t *p_decoded)
+{
+    uint64_t i_bits = 0;
+    i_bits |= ~(uint64_t)0 << 60 >> 0;
+    i_bits |= (uint64_t)p_decoded->i_h_type << 60 >> 4;
+    i_bits |= ~(uint64_t)0 << 62 >> 8;
+    i_bits |= (uint64_t)p_decoded->i_h_layer_index << 58 >> 10;
+    i_bits |= ~(uint64_t)0 << 62 >> 16;
+    i_bits |= (uint64_t)p_decoded->i_h_embedded_layer << 58 >> 18;
+    i_bits |= ~(uint64_t)0 << 62 >> 24;
+    i_bits |= (uint64_t)p_decoded->i_h_priority << 58 >> 26;
+    p_data[0] = i_bits >> 56;
+    p_data[1] = i_bits >> 48;
+    p_data[2] = i_bits >> 40;
+    p_data[3] = i_bits >> 32;
+}
+#endif
+
+#ifdef _DVBPSI_DR_05_H_
+/* registration, tag 0x05 */
+#define DVBPSI_REGISTRATION_DR_LENGTH 4
+
+static inline void dvbpsi_unpack_registration_dr(dvbpsi_registration_dr_t *p_decoded, const uint8_t *p_data)
+{
+    const uint64_t i_bits = ((uint64_t)p_data[0] << 56) |
+                            ((uint64_t)p_data[1] << 48) |
+                            ((uint64_t)p_data[2] << 40) |
+                            ((uint64_t)p_data[3] << 32);
+    p_decoded->i_format_identifier = i_bits << 0 >> 32;
+}
+
+static inline void dvbpsi_pack_registration_dr(uint8_t *p_data, const dvbpsi_registration_dr_t *p_decoded)
+{
+    uint64_t i_bits = 0;
+    i_bits |= (uint64_t)p_decoded->i_format_identifier << 32 >> 0;
+    p_data[0] = i_bits >> 56;
+    p_data[1] = i_bits >> 48;
+    p_data[2] = i_bits >> 40;
+    p_data[3] = i_bits >> 32;
+}
+#endif
+
+#ifdef _DVBPSI_DR_06_H_
+/* data stream alignment, tag 0x06 */
+#define DVBPSI_DS_ALIGNMENT_DR_LENGTH 1
+
+static inline void dvbpsi_unpack_ds_alignment_dr(dvbpsi_ds_alignment_dr_t *p_decoded, const uint8_t *p_data)
+{
+    const uint64_t i_bits = ((uint64_t)p_data[0] << 56);
+    p_decoded->i_alignment_type = i_bits << 0 >> 56;
+}
+
+static inline void dvbpsi_pack_ds_alignment_dr(uint8_t *p_data, const dvbpsi_ds_alignment_dr_t *p_decoded)
+{
+    uint64_t i_bits = 0;
+    i_bits |= (uint64_t)p_decoded->i_alignment_type << 56 >> 0;
+    p_data[0] = i_bits >> 56;
+}
+#endif
+
+#ifdef _DVBPSI_DR_07_H_
+/* target background grid, tag 0x07 */
+#define DVBPSI_TARGET_BG_GRID_DR_LENGTH 4
+
+static inline void dvbpsi_unpack_target_bg_grid_dr(dvbpsi_target_bg_grid_dr_t *p_decoded, const uint8_t *p_data)
+{
+    const uint64_t i_bits = ((uint64_t)p_data[0] << 56) |
+                            ((uint64_t)p_data[1] << 48) |
+                            ((uint64_t)p_data[2] << 40) |
+                            ((uint64_t)p_data[3] << 32);
+    p_decoded->i_horizontal_size = i_bits << 0 >> 50;
+    p_decoded->i_vertical_size = i_bits << 14 >> 50;
+    p_decoded->i_pel_aspect_ratio = i_bits << 28 >> 60;
+}
+
+static inline void dvbpsi_pack_target_bg_grid_dr(uint8_t *p_data, const dvbpsi_target_bg_grid_dr_t *p_decoded)
+{
+    uint64_t i_bits = 0;
+    i_bits |= (uint64_t)p_decoded->i_horizontal_size << 50 >> 0;
+    i_bits |= (uint64_t)p_decoded->i_vertical_size << 50 >> 14;
+    i_bits |= (uint64_t)p_decoded->i_pel_aspect_ratio << 60 >> 28;
+    p_data[0] = i_bits >> 56;
+    p_data[1] = i_bits >> 48;
+    p_data[2] = i_bits >> 40;
+    p_data[3] = i_bits >> 32;
+}
+#endif
+
+#ifdef _DVBPSI_DR_08_H_
+/* video window, tag 0x08 */
+#define DVBPSI_VWINDOW_DR_LENGTH 4
+
+static inline void dvbpsi_unpack_vwindow_dr(dvbpsi_vwindow_dr_t *p_decoded, const uint8_t *p_data)
+{
+    const uint64_t i_bits = ((uint64_t)p_data[0] << 56) |
+                            ((uint64_t)p_data[1] << 48) |
+                            ((uint64_t)p_data[2] << 40) |
+                            ((uint64_t)p_data[3] << 32);
+    p_decoded->i_horizontal_offset = i_bits << 0 >> 50;
+    p_decoded->i_vertical_offset = i_bits << 14 >> 50;
+    p_decoded->i_window_priority = i_bits << 28 >> 60;
+}
+
+static inline void dvbpsi_pack_vwindow_dr(uint8_t *p_data, const dvbpsi_vwindow_dr_t *p_decoded)
+{
+    uint64_t i_bits = 0;
+    i_bits |= (uint64_t)p_decoded->i_horizontal_offset << 50 >> 0;
+    i_bits |= (uint64_t)p_decoded->i_vertical_offset << 50 >> 14;
+    i_bits |= (uint64_t)p_decoded->i_window_priority << 60 >> 28;
+    p_data[0] = i_bits >> 56;
+    p_data[1] = i_bits >> 48;
+    p_data[2] = i_bits >> 40;
+    p_data[3] = i_bits >> 32;
+}
+#endif
+
+#ifdef _DVBPSI_DR_09_H_
+/* conditional access, tag 0x09 */
+#define DVBPSI_CA_DR_LENGTH 4
+
+static inline void dvbpsi_unpack_ca_dr(dvbpsi_ca_dr_t *p_decoded, const uint8_t *p_data)
+{
+    const uint64_t i_bits = ((uint64_t)p_data[0] << 56) |
+                            ((uint64_t)p_data[1] << 48) |
+                            ((uint64_t)p_data[2] << 40) |
+                            ((uint64_t)p_data[3] << 32);
+    p_decoded->i_ca_system_id = i_bits << 0 >> 48;
+    p_decoded->i_ca_pid = i_bits << 19 >> 51;
+}
+
+static inline void dvbpsi_pack_ca_dr(uint8_t *p_data, const dvbpsi_ca_dr_t *p_decoded)
+{
+    uint64_t i_bits = 0;
+    i_bits |= (uint64_t)p_decoded->i_ca_system_id << 48 >> 0;
+    i_bits |= ~(uint64_t)0 << 61 >> 16;
+    i_bits |= (uint64_t)p_decoded->i_ca_pid << 51 >> 19;
+    p_data[0] = i_bits >> 56;
+    p_data[1] = i_bits >> 48;
+    p_data[2] = i_bits >> 40;
+    p_data[3] = i_bits >> 32;
+}
+#endif
+
+#ifdef _DVBPSI_DR_0B_H_
+/* system clock, tag 0x0b */
+#define DVBPSI_SYSTEM_CLOCK_DR_LENGTH 2
+
+static inline void dvbpsi_unpack_system_clock_dr(dvbpsi_system_clock_dr_t *p_decoded, const uint8_t *p_data)
+{
+    const uint64_t i_bits = ((uint64_t)p_data[0] << 56) |
+                            ((uint64_t)p_data[1] << 48);
+    p_decoded->b_external_clock_ref = i_bits << 0 >> 63;
+    p_decoded->i_clock_accuracy_integer = i_bits << 2 >> 58;
+    p_decoded->i_clock_accuracy_exponent = i_bits << 8 >> 61;
+}
+
+static inline void dvbpsi_pack_system_clock_dr(uint8_t *p_data, const dvbpsi_system_clock_dr_t *p_decoded)
+{
+    uint64_t i_bits = 0;
+    i_bits |= (uint64_t)p_decoded->b_external_clock_ref << 63 >> 0;
+    i_bits |= ~(uint64_t)0 << 63 >> 1;
+    i_bits |= (uint64_t)p_decoded->i_clock_accuracy_integer << 58 >> 2;
+    i_bits |= (uint64_t)p_decoded->i_clock_accuracy_exponent << 61 >> 8;
+    i_bits |= ~(uint64_t)0 << 59 >> 11;
+    p_data[0] = i_bits >> 56;
+    p_data[1] = i_bits >> 48;
+}
+#endif
+
+#ifdef _DVBPSI_DR_0C_H_
+/* multiplex buffer utilization, tag 0x0c */
+#define DVBPSI_MX_BUFF_UTILIZATION_DR_LENGTH 3
+
+static inline void dvbpsi_unpack_mx_buff_utilization_dr(dvbpsi_mx_buff_utilization_dr_t *p_decoded, const uint8_t *p_data)
+{
+    const uint64_t i_bits = ((uint64_t)p_data[0] << 56) |
+                            ((uint64_t)p_data[1] << 48) |
+                            ((uint64_t)p_data[2] << 40);
+    p_decoded->b_mdv_valid = i_bits << 0 >> 63;
+    p_decoded->i_mx_delay_variation = i_bits << 1 >> 49;
+    p_decoded->i_mx_strategy = i_bits << 16 >> 61;
+}
+
+static inline void dvbpsi_pack_mx_buff_utilization_dr(uint8_t *p_data, const dvbpsi_mx_buff_utilization_dr_t *p_decoded)
+{
+    uint64_t i_bits = 0;
+    i_bits |= (uint64_t)p_decoded->b_mdv_valid << 63 >> 0;
+    i_bits |= (uint64_t)p_decoded->i_mx_delay_variation << 49 >> 1;
+    i_bits |= (uint64_t)p_decoded->i_mx_strategy << 61 >> 16;
+    i_bits |= ~(uint64_t)0 << 59 >> 19;
+    p_data[0] = i_bits >> 56;
+    p_data[1] = i_bits >> 48;
+    p_data[2] = i_bits >> 40;
+}
+#endif
+
+#ifdef _DVBPSI_DR_0D_H_
+/* copyright, tag 0x0d */
+#define DVBPSI_COPYRIGHT_DR_LENGTH 4
+
+static inline void dvbpsi_unpack_copyright_dr(dvbpsi_copyright_dr_t *p_decoded, const uint8_t *p_data)
+{
+    const uint64_t i_bits = ((uint64_t)p_data[0] << 56) |
+                            ((uint64_t)p_data[1] << 48) |
+                            ((uint64_t)p_data[2] << 40) |
+                            ((uint64_t)p_data[3] << 32);
+    p_decoded->i_copyright_identifier = i_bits << 0 >> 32;
+}
+
+static inline void dvbpsi_pack_copyright_dr(uint8_t *p_data, const dvbpsi_copyright_dr_t *p_decoded)
+{
+    uint64_t i_bits = 0;
+    i_bits |= (uint64_t)p_decoded->i_copyright_identifier << 32 >> 0;
+    p_data[0] = i_bits >> 56;
+    p_data[1] = i_bits >> 48;
+    p_data[2] = i_bits >> 40;
+    p_data[3] = i_bits >> 32;
+}
+#endif
+
+#ifdef _DVBPSI_DR_0E_H_
+/* maximum bitrate, tag 0x0e */
+#define DVBPSI_MAX_BITRATE_DR_LENGTH 3
+
+static inline void dvbpsi_unpack_max_bitrate_dr(dvbpsi_max_bitrate_dr_t *p_decoded, const uint8_t *p_data)
+{
+    const uint64_t i_bits = ((uint64_t)p_data[0] << 56) |
+                            ((uint64_t)p_data[1] << 48) |
+                            ((uint64_t)p_data[2] << 40);
+    p_decoded->i_max_bitrate = i_bits << 2 >> 42;
+}
+
+static inline void dvbpsi_pack_max_bitrate_dr(uint8_t *p_data, const dvbpsi_max_bitrate_dr_t *p_decoded)
+{
+    uint64_t i_bits = 0;
+    i_bits |= ~(uint64_t)0 << 62 >> 0;
+    i_bits |= (uint64_t)p_decoded->i_max_bitrate << 42 >> 2;
+    p_data[0] = i_bits >> 56;
+    p_data[1] = i_bits >> 48;
+    p_data[2] = i_bits >> 40;
+}
+#endif
+
+#ifdef _DVBPSI_DR_0F_H_
+/* private data indicator, tag 0x0f */
+#define DVBPSI_PRIVATE_DATA_DR_LENGTH 4
+
+static inline void dvbpsi_unpack_private_data_dr(dvbpsi_private_data_dr_t *p_decoded, const uint8_t *p_data)
+{
+    const uint64_t i_bits = ((uint64_t)p_data[0] << 56) |
+                            ((uint64_t)p_data[1] << 48) |
+                            ((uint64_t)p_data[2] << 40) |
+                            ((uint64_t)p_data[3] << 32);
+    p_decoded->i_private_data = i_bits << 0 >> 32;
+}
+
+static inline void dvbpsi_pack_private_data_dr(uint8_t *p_data, const dvbpsi_private_data_dr_t *p_decoded)
+{
+    uint64_t i_bits = 0;
+    i_bits |= (uint64_t)p_decoded->i_private_data << 32 >> 0;
+    p_data[0] = i_bits >> 56;
+    p_data[1] = i_bits >> 48;
+    p_data[2] = i_bits >> 40;
+    p_data[3] = i_bits >> 32;
+}
+#endif
+
+#else
+#error "Multiple inclusions of dr_codec.h"
+#endif
@@ -0,0 +1,769 @@
+/*****************************************************************************
+ * discovery.c: SI discovery engine
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+
+
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "descriptor.h"
+#include "demux.h"
+#include "router.h"
+#include "tables/pat.h"
+#include "tables/cat.h"
+#include "tables/pmt.h"
+#include "tables/nit.h"
+#include "tables/sdt.h"
+#include "tables/bat.h"
+#include "tables/eit.h"
+#include "tables/tot.h"
+#include "tables/rst.h"
+#include "tables/atsc_mgt.h"
+#include "tables/atsc_vct.h"
+#include "tables/atsc_stt.h"
+#include "tables/atsc_eit.h"
+#include "tables/atsc_ett.h"
+#include "discovery.h"
+
+/* Decoders of a PID, the first three being alone on their handle */
+#define DVBPSI_DISCOVERY_PAT    0x01
+#define DVBPSI_DISCOVERY_CAT    0x02
+#define DVBPSI_DISCOVERY_RST    0x04
+#define DVBPSI_DISCOVERY_SI     0x08    /* DVB SI, attached as it appears */
+#define DVBPSI_DISCOVERY_PSIP   0x10    /* ATSC PSIP, attached as it appears */
+#define DVBPSI_DISCOVERY_PMT    0x20    /* PMTs of the programs of the PAT */
+#define DVBPSI_DISCOVERY_DIRECT (DVBPSI_DISCOVERY_PAT | DVBPSI_DISCOVERY_CAT \
+                                 | DVBPSI_DISCOVERY_RST)
+
+/* PID of the ATSC PSIP base tables */
+#define DVBPSI_DISCOVERY_PSIP_PID 0x1ffb
+
+/*****************************************************************************
+ * dvbpsi_discovery_pid_t
+ *****************************************************************************
+ * PID of the engine and its handle.
+ *****************************************************************************/
+typedef struct dvbpsi_discovery_pid_s
+{
+    dvbpsi_discovery_t *            p_discovery;
+    dvbpsi_t *                      p_handle;
+    uint16_t                        i_pid;
+    uint8_t                         i_role;     /* DVBPSI_DISCOVERY_* */
+
+    struct dvbpsi_discovery_pid_s * p_next;
+} dvbpsi_discovery_pid_t;
+
+/*****************************************************************************
+ * dvbpsi_discovery_program_t
+ *****************************************************************************
+ * Program of the last PAT.
+ *****************************************************************************/
+typedef struct dvbpsi_discovery_program_s
+{
+    uint16_t                i_number;
+    uint16_t                i_pid;
+} dvbpsi_discovery_program_t;
+
+/*****************************************************************************
+ * dvbpsi_discovery_psip_t
+ *****************************************************************************
+ * EIT or ETT PID of the last MGT.
+ *****************************************************************************/
+typedef struct dvbpsi_discovery_psip_s
+{
+    uint16_t                i_pid;
+    uint8_t                 i_slot;         /* k of EIT-k and ETT-k, 0xff
+                                               for the channel ETT */
+} dvbpsi_discovery_psip_t;
+
+struct dvbpsi_discovery_s
+{
+    dvbpsi_router_t *               p_router;
+    uint32_t                        i_flags;
+    dvbpsi_message_cb               pf_message;
+    enum dvbpsi_msg_level           i_msg_level;
+
+    dvbpsi_discovery_callback       pf_callback;
+    void *                          p_cb_data;
+
+    dvbpsi_discovery_pid_t *        p_first_pid;
+    uint8_t                         pi_excluded[DVBPSI_ROUTER_PIDS / 8];
+
+    /* Last PAT */
+    dvbpsi_discovery_program_t *    p_programs;
+    size_t                          i_programs;
+    uint16_t                        i_network_pid;  /* 0 if none */
+
+    /* EIT and ETT PIDs of the last MGT */
+    dvbpsi_discovery_psip_t *       p_psip_pids;
+    size_t                          i_psip_pids;
+    unsigned int                    i_atsc_slots;   /* 0 for all */
+
+    /* Bit (table_id & 7) of byte (table_id >> 3) set for each table_id to
+       acquire */
+    uint8_t                         pi_tables[32];
+};
+
+static void dvbpsi_discovery_sync(dvbpsi_discovery_t *p_discovery);
+
+/*****************************************************************************
+ * dvbpsi_discovery_signal
+ *****************************************************************************
+ * Gives a new table to the application.
+ *****************************************************************************/
+static void dvbpsi_discovery_signal(void *p_data, uint8_t i_table_id, void *p_table)
+{
+    dvbpsi_discovery_pid_t *p_entry = (dvbpsi_discovery_pid_t *)p_data;
+    dvbpsi_discovery_t *p_discovery = p_entry->p_discovery;
+
+    p_discovery->pf_callback(p_discovery->p_cb_data, p_entry->i_pid, i_table_id, p_table);
+}
+
+/*****************************************************************************
+ * Callbacks of the decoders
+ *****************************************************************************/
+static void dvbpsi_discovery_pat(void *p_data, dvbpsi_pat_t *p_pat)
+{
+    dvbpsi_discovery_pid_t *p_entry = (dvbpsi_discovery_pid_t *)p_data;
+    dvbpsi_discovery_t *p_discovery = p_entry->p_discovery;
+
+    if (p_pat->b_current_next)
+    {
+        size_t i_programs = 0;
+        for (dvbpsi_pat_program_t *p = p_pat->p_first_program; p; p = p->p_next)
+            i_programs++;
+
+        dvbpsi_discovery_program_t *p_programs = NULL;
+        if (i_programs)
+            p_programs = dvbpsi_malloc(i_programs * sizeof(dvbpsi_discovery_program_t));
+
+        /* Without memory, the decoders of the previous PAT are kept */
+        if (p_programs || i_programs == 0)
+        {
+            size_t i = 0;
+            p_discovery->i_network_pid = 0;
+            for (dvbpsi_pat_program_t *p = p_pat->p_first_program; p; p = p->p_next)
+            {
+                if (p->i_number == 0)
+                    p_discovery->i_network_pid = p->i_pid;
+                else
+                {
+                    p_programs[i].i_number = p->i_number;
+                    p_programs[i].i_pid = p->i_pid;
+                    i++;
+                }
+            }
+            dvbpsi_free(p_discovery->p_programs);
+            p_discovery->p_programs = p_programs;
+            p_discovery->i_programs = i;
+            dvbpsi_discovery_sync(p_discovery);
+        }
+    }
+
+    dvbpsi_discovery_signal(p_data, 0x00, p_pat);
+}
+
+static void dvbpsi_discovery_cat(void *p_data, dvbpsi_cat_t *p_cat)
+{
+    dvbpsi_discovery_signal(p_data, 0x01, p_cat);
+}
+
+static void dvbpsi_discovery_pmt(void *p_data, dvbpsi_pmt_t *p_pmt)
+{
+    dvbpsi_discovery_signal(p_data, 0x02, p_pmt);
+}
+
+static void dvbpsi_discovery_nit(void *p_data, dvbpsi_nit_t *p_nit)
+{
+    dvbpsi_discovery_signal(p_data, p_nit->i_table_id, p_nit);
+}
+
+static void dvbpsi_discovery_sdt(void *p_data, dvbpsi_sdt_t *p_sdt)
+{
+    dvbpsi_discovery_signal(p_data, p_sdt->i_table_id, p_sdt);
+}
+
+static void dvbpsi_discovery_bat(void *p_data, dvbpsi_bat_t *p_bat)
+{
+    dvbpsi_discovery_signal(p_data, p_bat->i_table_id, p_bat);
+}
+
+static void dvbpsi_discovery_eit(void *p_data, dvbpsi_eit_t *p_eit)
+{
+    dvbpsi_discovery_signal(p_data, p_eit->i_table_id, p_eit);
+}
+
+static void dvbpsi_discovery_tot(void *p_data, dvbpsi_tot_t *p_tot)
+{
+    dvbpsi_discovery_signal(p_data, p_tot->i_table_id, p_tot);
+}
+
+static void dvbpsi_discovery_rst(void *p_data, dvbpsi_rst_t *p_rst)
+{
+    dvbpsi_discovery_signal(p_data, 0x71, p_rst);
+}
+
+static void dvbpsi_discovery_mgt(void *p_data, dvbpsi_atsc_mgt_t *p_mgt)
+{
+    dvbpsi_discovery_pid_t *p_entry = (dvbpsi_discovery_pid_t *)p_data;
+    dvbpsi_discovery_t *p_discovery = p_entry->p_discovery;
+
+    if (p_mgt->b_current_next)
+    {
+        size_t i_pids = 0;
+        for (dvbpsi_atsc_mgt_table_t *p = p_mgt->p_first_table; p; p = p->p_next)
+            i_pids++;
+
+        dvbpsi_discovery_psip_t *p_pids = NULL;
+        if (i_pids)
+            p_pids = dvbpsi_malloc(i_pids * sizeof(dvbpsi_discovery_psip_t));
+
+        /* Without memory, the decoders of the previous MGT are kept */
+        if (p_pids || i_pids == 0)
+        {
+            /* EIT-0 to EIT-127, channel ETT and ETT-0 to ETT-127 */
+            size_t i = 0;
+            for (dvbpsi_atsc_mgt_table_t *p = p_mgt->p_first_table; p; p = p->p_next)
+            {
+                if (   (p->i_table_type >= 0x0100 && p->i_table_type <= 0x017f)
+                    || (p->i_table_type >= 0x0200 && p->i_table_type <= 0x027f)
+                    || p->i_table_type == 0x0004)
+                {
+                    p_pids[i].i_pid = p->i_table_type_pid & 0x1fff;
+                    p_pids[i].i_slot = p->i_table_type == 0x0004 ? 0xff
+                                     : p->i_table_type & 0x7f;
+                    i++;
+                }
+            }
+            dvbpsi_free(p_discovery->p_psip_pids);
+            p_discovery->p_psip_pids = p_pids;
+            p_discovery->i_psip_pids = i;
+            dvbpsi_discovery_sync(p_discovery);
+        }
+    }
+
+    dvbpsi_discovery_signal(p_data, p_mgt->i_table_id, p_mgt);
+}
+
+static void dvbpsi_discovery_vct(void *p_data, dvbpsi_atsc_vct_t *p_vct)
+{
+    dvbpsi_discovery_signal(p_data, p_vct->i_table_id, p_vct);
+}
+
+static void dvbpsi_discovery_stt(void *p_data, dvbpsi_atsc_stt_t *p_stt)
+{
+    dvbpsi_discovery_signal(p_data, p_stt->i_table_id, p_stt);
+}
+
+static void dvbpsi_discovery_atsc_eit(void *p_data, dvbpsi_atsc_eit_t *p_eit)
+{
+    dvbpsi_discovery_signal(p_data, p_eit->i_table_id, p_eit);
+}
+
+static void dvbpsi_discovery_ett(void *p_data, dvbpsi_atsc_ett_t *p_ett)
+{
+    dvbpsi_discovery_signal(p_data, p_ett->i_table_id, p_ett);
+}
+
+/*****************************************************************************
+ * dvbpsi_discovery_wants
+ *****************************************************************************
+ * Whether a table_id, or one of a range, is acquired.
+ *****************************************************************************/
+static bool dvbpsi_discovery_wants(const dvbpsi_discovery_t *p_discovery,
+                                   uint8_t i_first, uint8_t i_last)
+{
+    for (unsigned int i = i_first; i <= i_last; i++)
+        if (p_discovery->pi_tables[i >> 3] & (1 << (i & 7)))
+            return true;
+    return false;
+}
+
+/* The MGT is decoded for the EIT and ETT PIDs it lists */
+#define dvbpsi_discovery_wants_mgt(p_discovery) \
+    (dvbpsi_discovery_wants(p_discovery, 0xc7, 0xc7) \
+     || dvbpsi_discovery_wants(p_discovery, 0xcb, 0xcc))
+
+/*****************************************************************************
+ * dvbpsi_discovery_subtable
+ *****************************************************************************
+ * Attaches the decoder of a new subtable of a demux PID.
+ *****************************************************************************/
+static void dvbpsi_discovery_subtable(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                                      uint16_t i_extension, void *p_data)
+{
+    dvbpsi_discovery_pid_t *p_entry = (dvbpsi_discovery_pid_t *)p_data;
+    const dvbpsi_discovery_t *p_discovery = p_entry->p_discovery;
+
+    if (i_table_id == 0xc7 ? !dvbpsi_discovery_wants_mgt(p_discovery)
+                           : !dvbpsi_discovery_wants(p_discovery, i_table_id, i_table_id))
+        return;
+
+    if (p_entry->i_role & DVBPSI_DISCOVERY_SI)
+    {
+        if (i_table_id == 0x40 || i_table_id == 0x41)
+            dvbpsi_nit_attach(p_dvbpsi, i_table_id, i_extension, dvbpsi_discovery_nit, p_data);
+        else if (i_table_id == 0x42 || i_table_id == 0x46)
+            dvbpsi_sdt_attach(p_dvbpsi, i_table_id, i_extension, dvbpsi_discovery_sdt, p_data);
+        else if (i_table_id == 0x4a)
+            dvbpsi_bat_attach(p_dvbpsi, i_table_id, i_extension, dvbpsi_discovery_bat, p_data);
+        else if (i_table_id >= 0x4e && i_table_id <= 0x6f)
+            dvbpsi_eit_attach(p_dvbpsi, i_table_id, i_extension, dvbpsi_discovery_eit, p_data);
+        else if (i_table_id == 0x70 || i_table_id == 0x73)
+            dvbpsi_tot_attach(p_dvbpsi, i_table_id, i_extension, dvbpsi_discovery_tot, p_data);
+    }
+
+    if (p_entry->i_role & DVBPSI_DISCOVERY_PSIP)
+    {
+        if (i_table_id == 0xc7)
+            dvbpsi_atsc_AttachMGT(p_dvbpsi, i_table_id, i_extension, dvbpsi_discovery_mgt, p_data);
+        else if (i_table_id == 0xc8 || i_table_id == 0xc9)
+            dvbpsi_atsc_AttachVCT(p_dvbpsi, i_table_id, i_extension, dvbpsi_discovery_vct, p_data);
+        else if (i_table_id == 0xcb)
+            dvbpsi_atsc_AttachEIT(p_dvbpsi, i_table_id, i_extension, dvbpsi_discovery_atsc_eit, p_data);
+        else if (i_table_id == 0xcc)
+            dvbpsi_atsc_AttachETT(p_dvbpsi, i_table_id, i_extension, dvbpsi_discovery_ett, p_data);
+        else if (i_table_id == 0xcd)
+            dvbpsi_atsc_AttachSTT(p_dvbpsi, i_table_id, i_extension, dvbpsi_discovery_stt, p_data);
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_discovery_si_tables
+ *****************************************************************************
+ * Range of the table_ids of the DVB SI of a PID.
+ *****************************************************************************/
+static void dvbpsi_discovery_si_tables(uint16_t i_pid, uint8_t *pi_range)
+{
+    switch (i_pid)
+    {
+    case 0x11: pi_range[0] = 0x42; pi_range[1] = 0x4a; break;     /* SDT, BAT */
+    case 0x12: pi_range[0] = 0x4e; pi_range[1] = 0x6f; break;     /* EIT */
+    case 0x14: pi_range[0] = 0x70; pi_range[1] = 0x73; break;     /* TDT, TOT */
+    default:   pi_range[0] = 0x40; pi_range[1] = 0x41; break;     /* NIT */
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_discovery_role
+ *****************************************************************************
+ * Decoders a PID should have, 0 for none.
+ *****************************************************************************/
+static uint8_t dvbpsi_discovery_role(const dvbpsi_discovery_t *p_discovery, uint16_t i_pid)
+{
+    if (p_discovery->pi_excluded[i_pid / 8] & (1 << (i_pid % 8)))
+        return 0;
+
+    /* The PAT is decoded for the PMTs it lists */
+    switch (i_pid)
+    {
+    case 0x00:
+        return dvbpsi_discovery_wants(p_discovery, 0x00, 0x02)
+             ? DVBPSI_DISCOVERY_PAT : 0;
+    case 0x01:
+        return dvbpsi_discovery_wants(p_discovery, 0x01, 0x01)
+             ? DVBPSI_DISCOVERY_CAT : 0;
+    case 0x13:
+        return dvbpsi_discovery_wants(p_discovery, 0x71, 0x71)
+             ? DVBPSI_DISCOVERY_RST : 0;
+    }
+
+    uint8_t i_role = 0;
+    if (   (i_pid >= 0x10 && i_pid <= 0x14)
+        || i_pid == p_discovery->i_network_pid)
+    {
+        uint8_t pi_range[2];
+        dvbpsi_discovery_si_tables(i_pid, pi_range);
+        if (dvbpsi_discovery_wants(p_discovery, pi_range[0], pi_range[1]))
+            i_role |= DVBPSI_DISCOVERY_SI;
+    }
+    if (i_pid == DVBPSI_DISCOVERY_PSIP_PID
+     && dvbpsi_discovery_wants(p_discovery, 0xc7, 0xcd))
+        i_role |= DVBPSI_DISCOVERY_PSIP;
+    if (dvbpsi_discovery_wants(p_discovery, 0xcb, 0xcc))
+    {
+        for (size_t i = 0; i < p_discovery->i_psip_pids; i++)
+            if (p_discovery->p_psip_pids[i].i_pid == i_pid
+             && (p_discovery->i_atsc_slots == 0
+              || p_discovery->p_psip_pids[i].i_slot == 0xff
+              || p_discovery->p_psip_pids[i].i_slot < p_discovery->i_atsc_slots))
+                i_role |= DVBPSI_DISCOVERY_PSIP;
+    }
+    if (dvbpsi_discovery_wants(p_discovery, 0x02, 0x02))
+    {
+        for (size_t i = 0; i < p_discovery->i_programs; i++)
+            if (p_discovery->p_programs[i].i_pid == i_pid)
+                i_role |= DVBPSI_DISCOVERY_PMT;
+    }
+    return i_role;
+}
+
+/*****************************************************************************
+ * dvbpsi_discovery_filter
+ *****************************************************************************
+ * Sets the section filter of a demux PID to the table_ids acquired on it,
+ * as one table_id and mask, or removes it when all its tables are.
+ *****************************************************************************/
+static void dvbpsi_discovery_filter(const dvbpsi_discovery_t *p_discovery,
+                                    dvbpsi_discovery_pid_t *p_entry)
+{
+    /* Tables of the PID, in ranges of table_ids */
+    uint8_t pi_ranges[3][2];
+    unsigned int i_ranges = 0;
+    if (p_entry->i_role & DVBPSI_DISCOVERY_SI)
+        dvbpsi_discovery_si_tables(p_entry->i_pid, pi_ranges[i_ranges++]);
+    if (p_entry->i_role & DVBPSI_DISCOVERY_PSIP)
+    {
+        pi_ranges[i_ranges][0] = 0xc7;
+        pi_ranges[i_ranges++][1] = 0xcd;
+    }
+    if (p_entry->i_role & DVBPSI_DISCOVERY_PMT)
+    {
+        pi_ranges[i_ranges][0] = 0x02;
+        pi_ranges[i_ranges++][1] = 0x02;
+    }
+
+    uint8_t i_and = 0xff, i_or = 0x00;
+    bool b_all = true;
+    for (unsigned int r = 0; r < i_ranges; r++)
+    {
+        for (unsigned int i = pi_ranges[r][0]; i <= pi_ranges[r][1]; i++)
+        {
+            bool b_wanted = i == 0xc7 ? dvbpsi_discovery_wants_mgt(p_discovery)
+                                      : dvbpsi_discovery_wants(p_discovery, i, i);
+            if (!b_wanted)
+            {
+                b_all = false;
+                continue;
+            }
+            i_and &= i;
+            i_or |= i;
+        }
+    }
+
+    if (b_all)
+        dvbpsi_set_section_filter(p_entry->p_handle, NULL);
+    else
+    {
+        /* The bits all the table_ids share */
+        dvbpsi_section_filter_t filter = { 0, 0, 0, 0 };
+        filter.i_table_id_mask = ~(i_and ^ i_or);
+        filter.i_table_id = i_and & filter.i_table_id_mask;
+        dvbpsi_set_section_filter(p_entry->p_handle, &filter);
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_discovery_pid_delete
+ *****************************************************************************
+ * Detaches a PID from the router and deletes its handle.
+ *****************************************************************************/
+static void dvbpsi_discovery_pid_delete(dvbpsi_discovery_t *p_discovery,
+                                        dvbpsi_discovery_pid_t *p_entry)
+{
+    dvbpsi_discovery_pid_t **pp_entry = &p_discovery->p_first_pid;
+    while (*pp_entry != p_entry)
+        pp_entry = &(*pp_entry)->p_next;
+    *pp_entry = p_entry->p_next;
+
+    dvbpsi_router_detach(p_discovery->p_router, p_entry->i_pid);
+    if (p_entry->p_handle->p_decoder)
+    {
+        if (p_entry->i_role & DVBPSI_DISCOVERY_PAT)
+            dvbpsi_pat_detach(p_entry->p_handle);
+        else if (p_entry->i_role & DVBPSI_DISCOVERY_CAT)
+            dvbpsi_cat_detach(p_entry->p_handle);
+        else if (p_entry->i_role & DVBPSI_DISCOVERY_RST)
+            dvbpsi_rst_detach(p_entry->p_handle);
+        else
+            dvbpsi_DetachDemux(p_entry->p_handle);
+    }
+    dvbpsi_delete(p_entry->p_handle);
+    dvbpsi_free(p_entry);
+}
+
+/*****************************************************************************
+ * dvbpsi_discovery_pid_new
+ *****************************************************************************
+ * Attaches the decoders of a role to a PID, NULL if the router already has
+ * the PID or on error.
+ *****************************************************************************/
+static dvbpsi_discovery_pid_t *dvbpsi_discovery_pid_new(dvbpsi_discovery_t *p_discovery,
+                                                        uint16_t i_pid, uint8_t i_role)
+{
+    if (dvbpsi_router_get(p_discovery->p_router, i_pid))
+        return NULL;
+
+    dvbpsi_discovery_pid_t *p_entry = dvbpsi_calloc(1, sizeof(dvbpsi_discovery_pid_t));
+    if (p_entry == NULL)
+        return NULL;
+    p_entry->p_discovery = p_discovery;
+    p_entry->i_pid = i_pid;
+    p_entry->i_role = i_role;
+
+    p_entry->p_handle = dvbpsi_new(p_discovery->pf_message, p_discovery->i_msg_level);
+    if (p_entry->p_handle == NULL)
+    {
+        dvbpsi_free(p_entry);
+        return NULL;
+    }
+    dvbpsi_set_flags(p_entry->p_handle, p_discovery->i_flags);
+    dvbpsi_set_packet_format(p_entry->p_handle,
+                             dvbpsi_router_get_packet_format(p_discovery->p_router));
+
+    bool b_attached;
+    if (i_role & DVBPSI_DISCOVERY_PAT)
+        b_attached = dvbpsi_pat_attach(p_entry->p_handle, dvbpsi_discovery_pat, p_entry);
+    else if (i_role & DVBPSI_DISCOVERY_CAT)
+        b_attached = dvbpsi_cat_attach(p_entry->p_handle, dvbpsi_discovery_cat, p_entry);
+    else if (i_role & DVBPSI_DISCOVERY_RST)
+        b_attached = dvbpsi_rst_attach(p_entry->p_handle, dvbpsi_discovery_rst, p_entry);
+    else
+        b_attached = dvbpsi_AttachDemux(p_entry->p_handle, dvbpsi_discovery_subtable, p_entry);
+
+    if (!b_attached || !dvbpsi_router_attach(p_discovery->p_router, i_pid, p_entry->p_handle))
+    {
+        p_entry->p_next = p_discovery->p_first_pid;
+        p_discovery->p_first_pid = p_entry;
+        dvbpsi_discovery_pid_delete(p_discovery, p_entry);
+        return NULL;
+    }
+
+    p_entry->p_next = p_discovery->p_first_pid;
+    p_discovery->p_first_pid = p_entry;
+    return p_entry;
+}
+
+/*****************************************************************************
+ * dvbpsi_discovery_pid_sync
+ *****************************************************************************
+ * Gives a PID the decoders it should have.
+ *****************************************************************************/
+static void dvbpsi_discovery_pid_sync(dvbpsi_discovery_t *p_discovery, uint16_t i_pid)
+{
+    uint8_t i_role = dvbpsi_discovery_role(p_discovery, i_pid);
+
+    dvbpsi_discovery_pid_t *p_entry = p_discovery->p_first_pid;
+    while (p_entry && p_entry->i_pid != i_pid)
+        p_entry = p_entry->p_next;
+
+    /* Another kind of handle */
+    if (p_entry && (i_role & DVBPSI_DISCOVERY_DIRECT) != (p_entry->i_role & DVBPSI_DISCOVERY_DIRECT))
+    {
+        dvbpsi_discovery_pid_delete(p_discovery, p_entry);
+        p_entry = NULL;
+    }
+    if (i_role == 0)
+    {
+        if (p_entry)
+            dvbpsi_discovery_pid_delete(p_discovery, p_entry);
+        return;
+    }
+
+    if (p_entry == NULL)
+        p_entry = dvbpsi_discovery_pid_new(p_discovery, i_pid, i_role);
+    if (p_entry == NULL)
+        return;
+    p_entry->i_role = i_role;
+    if (i_role & DVBPSI_DISCOVERY_DIRECT)
+        return;
+    dvbpsi_discovery_filter(p_discovery, p_entry);
+
+    /* PMTs of the programs not on this PID anymore */
+    dvbpsi_demux_t *p_demux = (dvbpsi_demux_t *)p_entry->p_handle->p_decoder;
+    dvbpsi_demux_subdec_t *p_subdec = p_demux->p_first_subdec;
+    while (p_subdec)
+    {
+        dvbpsi_demux_subdec_t *p_next = p_subdec->p_next;
+        if ((p_subdec->i_id >> 16) == 0x02)
+        {
+            uint16_t i_number = p_subdec->i_id & 0xffff;
+            size_t i = 0;
+            while (i < p_discovery->i_programs
+                   && (   p_discovery->p_programs[i].i_number != i_number
+                       || p_discovery->p_programs[i].i_pid != i_pid))
+                i++;
+            if (i == p_discovery->i_programs)
+                dvbpsi_pmt_demux_detach(p_entry->p_handle, i_number);
+        }
+        p_subdec = p_next;
+    }
+
+    /* PMTs of the programs of this PID */
+    for (size_t i = 0; i < p_discovery->i_programs; i++)
+    {
+        const dvbpsi_discovery_program_t *p_program = &p_discovery->p_programs[i];
+        if (   p_program->i_pid == i_pid
+            && dvbpsi_demuxGetSubDec(p_demux, 0x02, p_program->i_number) == NULL)
+            dvbpsi_pmt_demux_attach(p_entry->p_handle, p_program->i_number,
+                                    dvbpsi_discovery_pmt, p_entry);
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_discovery_sync
+ *****************************************************************************
+ * Gives all the PIDs the decoders they should have.
+ *****************************************************************************/
+static void dvbpsi_discovery_sync(dvbpsi_discovery_t *p_discovery)
+{
+    /* PIDs to detach, the deletions keeping the list valid from p_next */
+    dvbpsi_discovery_pid_t *p_entry = p_discovery->p_first_pid;
+    while (p_entry)
+    {
+        dvbpsi_discovery_pid_t *p_next = p_entry->p_next;
+        if (dvbpsi_discovery_role(p_discovery, p_entry->i_pid) == 0)
+            dvbpsi_discovery_pid_delete(p_discovery, p_entry);
+        p_entry = p_next;
+    }
+
+    static const uint16_t pi_base_pids[] = {
+        0x00, 0x01, 0x10, 0x11, 0x12, 0x13, 0x14, DVBPSI_DISCOVERY_PSIP_PID
+    };
+    for (size_t i = 0; i < sizeof(pi_base_pids) / sizeof(pi_base_pids[0]); i++)
+        dvbpsi_discovery_pid_sync(p_discovery, pi_base_pids[i]);
+    if (p_discovery->i_network_pid)
+        dvbpsi_discovery_pid_sync(p_discovery, p_discovery->i_network_pid);
+    for (size_t i = 0; i < p_discovery->i_psip_pids; i++)
+        dvbpsi_discovery_pid_sync(p_discovery, p_discovery->p_psip_pids[i].i_pid);
+    for (size_t i = 0; i < p_discovery->i_programs; i++)
+        dvbpsi_discovery_pid_sync(p_discovery, p_discovery->p_programs[i].i_pid);
+}
+
+/*****************************************************************************
+ * dvbpsi_discovery_new
+ *****************************************************************************/
+dvbpsi_discovery_t *dvbpsi_discovery_new(dvbpsi_router_t *p_router, uint32_t i_flags,
+                                         dvbpsi_message_cb pf_message,
+                                         enum dvbpsi_msg_level i_msg_level,
+                                         dvbpsi_discovery_callback pf_callback,
+                                         void *p_cb_data)
+{
+    assert(p_router);
+    assert(pf_callback);
+
+    dvbpsi_discovery_t *p_discovery = dvbpsi_calloc(1, sizeof(dvbpsi_discovery_t));
+    if (p_discovery == NULL)
+        return NULL;
+
+    p_discovery->p_router = p_router;
+    p_discovery->i_flags = i_flags;
+    p_discovery->pf_message = pf_message;
+    p_discovery->i_msg_level = i_msg_level;
+    p_discovery->pf_callback = pf_callback;
+    p_discovery->p_cb_data = p_cb_data;
+    memset(p_discovery->pi_tables, 0xff, sizeof(p_discovery->pi_tables));
+
+    dvbpsi_discovery_sync(p_discovery);
+    return p_discovery;
+}
+
+/*****************************************************************************
+ * dvbpsi_discovery_delete
+ *****************************************************************************/
+void dvbpsi_discovery_delete(dvbpsi_discovery_t *p_discovery)
+{
+    if (p_discovery == NULL)
+        return;
+
+    while (p_discovery->p_first_pid)
+        dvbpsi_discovery_pid_delete(p_discovery, p_discovery->p_first_pid);
+    dvbpsi_free(p_discovery->p_programs);
+    dvbpsi_free(p_discovery->p_psip_pids);
+    dvbpsi_free(p_discovery);
+}
+
+/*****************************************************************************
+ * dvbpsi_discovery_exclude
+ *****************************************************************************/
+bool dvbpsi_discovery_exclude(dvbpsi_discovery_t *p_discovery, uint16_t i_pid,
+                              bool b_excluded)
+{
+    assert(p_discovery);
+
+    if (i_pid >= DVBPSI_ROUTER_PIDS)
+        return false;
+
+    if (b_excluded)
+        p_discovery->pi_excluded[i_pid / 8] |= 1 << (i_pid % 8);
+    else
+        p_discovery->pi_excluded[i_pid / 8] &= ~(1 << (i_pid % 8));
+    dvbpsi_discovery_pid_sync(p_discovery, i_pid);
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_discovery_set_atsc_slots
+ *****************************************************************************/
+void dvbpsi_discovery_set_atsc_slots(dvbpsi_discovery_t *p_discovery,
+                                     unsigned int i_slots)
+{
+    assert(p_discovery);
+
+    p_discovery->i_atsc_slots = i_slots;
+    dvbpsi_discovery_sync(p_discovery);
+}
+
+/*****************************************************************************
+ * dvbpsi_discovery_set_tables
+ *****************************************************************************/
+void dvbpsi_discovery_set_tables(dvbpsi_discovery_t *p_discovery,
+                                 const uint8_t *p_tables)
+{
+    assert(p_discovery);
+
+    if (p_tables)
+        memcpy(p_discovery->pi_tables, p_tables, sizeof(p_discovery->pi_tables));
+    else
+        memset(p_discovery->pi_tables, 0xff, sizeof(p_discovery->pi_tables));
+    dvbpsi_discovery_sync(p_discovery);
+}
+
+/*****************************************************************************
+ * dvbpsi_discovery_get
+ *****************************************************************************/
+dvbpsi_t *dvbpsi_discovery_get(dvbpsi_discovery_t *p_discovery, uint16_t i_pid)
+{
+    assert(p_discovery);
+
+    for (dvbpsi_discovery_pid_t *p_entry = p_discovery->p_first_pid; p_entry;
+         p_entry = p_entry->p_next)
+        if (p_entry->i_pid == i_pid)
+            return p_entry->p_handle;
+    return NULL;
+}
@@ -0,0 +1,201 @@
+/*****************************************************************************
+ * discovery.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <discovery.h>
+ * \brief SI discovery.
+ *
+ * Attaches the decoders of the PSI, DVB SI and ATSC PSIP tables of a
+ * transport stream to a PID router as they appear: the PAT, CAT, and the
+ * DVB SI of the PIDs 0x10 to 0x14 and the PSIP of the PID 0x1ffb, then the
+ * PMTs and network PID of the PAT and the EIT and ETT PIDs of the MGT. The
+ * decoders of the PIDs the PAT or the MGT stop listing are detached, and
+ * all the tables are given to one callback. The ATSC event information
+ * may be limited to its first 3 hours slots, to bound the decoders of a
+ * stream carrying a 16 days guide, and the tables to a set of table_ids,
+ * the sections of the others being filtered out.
+ */
+
+#ifndef _DVBPSI_DISCOVERY_H_
+#define _DVBPSI_DISCOVERY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_discovery_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_discovery_s dvbpsi_discovery_t
+ * \brief dvbpsi_discovery_t type definition, an opaque SI discovery engine.
+ */
+typedef struct dvbpsi_discovery_s dvbpsi_discovery_t;
+
+/*****************************************************************************
+ * dvbpsi_discovery_callback
+ *****************************************************************************/
+/*!
+ * \typedef void (* dvbpsi_discovery_callback)(void *p_cb_data, uint16_t i_pid,
+ *                                             uint8_t i_table_id,
+ *                                             void *p_table)
+ * \brief Callback type definition, called with each new table.
+ *
+ * p_table is, according to i_table_id: a dvbpsi_pat_t for 0x00, a
+ * dvbpsi_cat_t for 0x01, a dvbpsi_pmt_t for 0x02, a dvbpsi_nit_t for 0x40
+ * and 0x41, a dvbpsi_sdt_t for 0x42 and 0x46, a dvbpsi_bat_t for 0x4a, a
+ * dvbpsi_eit_t for 0x4e to 0x6f, a dvbpsi_tot_t for 0x70 and 0x73, a
+ * dvbpsi_rst_t for 0x71, a dvbpsi_atsc_mgt_t for 0xc7, a dvbpsi_atsc_vct_t
+ * for 0xc8 and 0xc9, a dvbpsi_atsc_eit_t for 0xcb, a dvbpsi_atsc_ett_t for
+ * 0xcc and a dvbpsi_atsc_stt_t for 0xcd. As with the callbacks of each
+ * table, the table belongs to the application, which deletes it with the
+ * delete function of its type.
+ */
+typedef void (* dvbpsi_discovery_callback)(void *p_cb_data, uint16_t i_pid,
+                                           uint8_t i_table_id, void *p_table);
+
+/*****************************************************************************
+ * dvbpsi_discovery_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_discovery_t *dvbpsi_discovery_new(dvbpsi_router_t *p_router,
+ *                                              uint32_t i_flags,
+ *                                              dvbpsi_message_cb pf_message,
+ *                                              enum dvbpsi_msg_level i_msg_level,
+ *                                              dvbpsi_discovery_callback pf_callback,
+ *                                              void *p_cb_data)
+ * \brief Creates an SI discovery engine attaching its decoders to a router
+ * \param p_router PID router the transport stream is pushed into, which
+ *        must stay valid until the engine is deleted
+ * \param i_flags DVBPSI_FLAG_* options of the handles of the engine
+ * \param pf_message message callback of the handles of the engine
+ * \param i_msg_level message level of the handles of the engine
+ * \param pf_callback function called with each new table
+ * \param p_cb_data private data given in argument to the callback
+ * \return pointer to the engine, or NULL on error
+ *
+ * The PIDs already attached to the router are left to their handle.
+ */
+dvbpsi_discovery_t *dvbpsi_discovery_new(dvbpsi_router_t *p_router, uint32_t i_flags,
+                                         dvbpsi_message_cb pf_message,
+                                         enum dvbpsi_msg_level i_msg_level,
+                                         dvbpsi_discovery_callback pf_callback,
+                                         void *p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_discovery_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_discovery_delete(dvbpsi_discovery_t *p_discovery)
+ * \brief Detaches the PIDs of an engine from its router and deletes it
+ * \param p_discovery pointer to the engine
+ * \return nothing
+ */
+void dvbpsi_discovery_delete(dvbpsi_discovery_t *p_discovery);
+
+/*****************************************************************************
+ * dvbpsi_discovery_exclude
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_discovery_exclude(dvbpsi_discovery_t *p_discovery,
+ *                                   uint16_t i_pid, bool b_excluded)
+ * \brief Keeps an engine from attaching decoders to a PID, or lets it again
+ * \param p_discovery pointer to the engine
+ * \param i_pid PID, 0 to 0x1fff
+ * \param b_excluded true to filter the PID out, false to let it in
+ * \return false if the PID is invalid, true otherwise.
+ *
+ * The decoders already attached to a PID filtered out are detached at
+ * once, and a PID let in again gets its decoders back if the last PAT or
+ * MGT lists it. It must not be called from the callback of the engine.
+ */
+bool dvbpsi_discovery_exclude(dvbpsi_discovery_t *p_discovery, uint16_t i_pid,
+                              bool b_excluded);
+
+/*****************************************************************************
+ * dvbpsi_discovery_set_atsc_slots
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_discovery_set_atsc_slots(dvbpsi_discovery_t *p_discovery,
+ *                                          unsigned int i_slots)
+ * \brief Limits the ATSC event information an engine acquires
+ * \param p_discovery pointer to the engine
+ * \param i_slots number of 3 hours slots, EIT-0 to EIT-(i_slots - 1) and
+ *        ETT-0 to ETT-(i_slots - 1), whose PIDs get decoders, 0 for the
+ *        128 slots the MGT may list
+ * \return nothing
+ *
+ * The channel ETT is always acquired. The decoders of the PIDs of the
+ * slots beyond the limit are detached at once, and those of the slots
+ * within it attached if the last MGT lists them. It must not be called
+ * from the callback of the engine.
+ */
+void dvbpsi_discovery_set_atsc_slots(dvbpsi_discovery_t *p_discovery,
+                                     unsigned int i_slots);
+
+/*****************************************************************************
+ * dvbpsi_discovery_set_tables
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_discovery_set_tables(dvbpsi_discovery_t *p_discovery,
+ *                                      const uint8_t *p_tables)
+ * \brief Limits the tables an engine acquires
+ * \param p_discovery pointer to the engine
+ * \param p_tables bitmap of 32 bytes, bit (table_id & 7) of byte
+ *        (table_id >> 3) being set for each table_id to acquire, copied,
+ *        or NULL for all the tables
+ * \return nothing
+ *
+ * The PIDs without any table to acquire are detached, and the section
+ * filter of the others, see dvbpsi_set_section_filter(), is set to the
+ * table_ids they carry that are acquired, so that the sections of the
+ * other tables are walked over before assembly. The PAT is still decoded
+ * and signaled when the PMTs are acquired, and the MGT when the ATSC EITs
+ * or ETTs are. It must not be called from the callback of the engine.
+ */
+void dvbpsi_discovery_set_tables(dvbpsi_discovery_t *p_discovery,
+                                 const uint8_t *p_tables);
+
+/*****************************************************************************
+ * dvbpsi_discovery_get
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_t *dvbpsi_discovery_get(dvbpsi_discovery_t *p_discovery,
+ *                                    uint16_t i_pid)
+ * \brief Gets the handle of an engine attached to a PID
+ * \param p_discovery pointer to the engine
+ * \param i_pid PID, 0 to 0x1fff
+ * \return the handle, valid until the decoders of the PID are detached, or
+ *         NULL if the engine has none on this PID.
+ *
+ * The handle may be used to set further options, such as the segment
+ * callback of the EIT decoders, from the callback of the engine.
+ */
+dvbpsi_t *dvbpsi_discovery_get(dvbpsi_discovery_t *p_discovery, uint16_t i_pid);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of discovery.h"
+#endif
@@ -0,0 +1,421 @@
+/*****************************************************************************
+ * dispatch.c: asynchronous table dispatch queue
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "descriptor.h"
+#include "tables/pat.h"
+#include "tables/cat.h"
+#include "tables/pmt.h"
+#include "tables/sdt.h"
+#include "tables/eit.h"
+#include "tables/nit.h"
+#include "tables/bat.h"
+#include "tables/tot.h"
+#include "dispatch.h"
+
+/*****************************************************************************
+ * dvbpsi_dispatch_item_t
+ *****************************************************************************
+ * Queued table with the callback it goes to.
+ *****************************************************************************/
+typedef struct dvbpsi_dispatch_item_s
+{
+    dvbpsi_dispatch_callback    pf_callback;
+    void *                      p_cb_data;
+    uint8_t                     i_table_id;
+    uint16_t                    i_extension;
+    void *                      p_table;
+    void                     (* pf_delete)(void *);
+} dvbpsi_dispatch_item_t;
+
+struct dvbpsi_dispatch_s
+{
+    uint32_t                i_flags;
+    void                 (* pf_notify)(void *);
+    void *                  p_notify_data;
+
+    pthread_mutex_t         lock;
+    pthread_cond_t          ready;      /* a table was queued, or closed */
+    pthread_cond_t          room;       /* a table was taken, or closed */
+    bool                    b_closed;
+    size_t                  i_waiting;  /* posts waiting for room */
+
+    dvbpsi_dispatch_item_t *p_items;    /* ring of i_size items */
+    size_t                  i_size;
+    size_t                  i_head;     /* oldest item */
+    size_t                  i_count;
+
+    dvbpsi_dispatch_stats_t stats;
+};
+
+/*****************************************************************************
+ * dvbpsi_dispatch_new
+ *****************************************************************************/
+dvbpsi_dispatch_t *dvbpsi_dispatch_new(size_t i_size, uint32_t i_flags,
+                                       void (*pf_notify)(void *), void *p_notify_data)
+{
+    if (i_size == 0)
+        return NULL;
+
+    dvbpsi_dispatch_t *p_dispatch = dvbpsi_calloc(1, sizeof(dvbpsi_dispatch_t));
+    if (p_dispatch == NULL)
+        return NULL;
+
+    p_dispatch->p_items = dvbpsi_calloc(i_size, sizeof(dvbpsi_dispatch_item_t));
+    if (p_dispatch->p_items == NULL)
+    {
+        dvbpsi_free(p_dispatch);
+        return NULL;
+    }
+    p_dispatch->i_size = i_size;
+    p_dispatch->i_flags = i_flags;
+    p_dispatch->pf_notify = pf_notify;
+    p_dispatch->p_notify_data = p_notify_data;
+
+    pthread_mutex_init(&p_dispatch->lock, NULL);
+    pthread_cond_init(&p_dispatch->ready, NULL);
+    pthread_cond_init(&p_dispatch->room, NULL);
+    return p_dispatch;
+}
+
+/*****************************************************************************
+ * dvbpsi_dispatch_delete
+ *****************************************************************************/
+void dvbpsi_dispatch_delete(dvbpsi_dispatch_t *p_dispatch)
+{
+    if (p_dispatch == NULL)
+        return;
+
+    for (size_t i = 0; i < p_dispatch->i_count; i++)
+    {
+        dvbpsi_dispatch_item_t *p_item =
+            &p_dispatch->p_items[(p_dispatch->i_head + i) % p_dispatch->i_size];
+        p_item->pf_delete(p_item->p_table);
+    }
+
+    pthread_mutex_destroy(&p_dispatch->lock);
+    pthread_cond_destroy(&p_dispatch->ready);
+    pthread_cond_destroy(&p_dispatch->room);
+    dvbpsi_free(p_dispatch->p_items);
+    dvbpsi_free(p_dispatch);
+}
+
+/*****************************************************************************
+ * dvbpsi_dispatch_find
+ *****************************************************************************
+ * Finds the queued item of a subtable, among the i_count ones.
+ *****************************************************************************/
+static dvbpsi_dispatch_item_t *dvbpsi_dispatch_find(dvbpsi_dispatch_t *p_dispatch,
+                                                    const dvbpsi_dispatch_item_t *p_new)
+{
+    for (size_t i = 0; i < p_dispatch->i_count; i++)
+    {
+        dvbpsi_dispatch_item_t *p_item =
+            &p_dispatch->p_items[(p_dispatch->i_head + i) % p_dispatch->i_size];
+        if (p_item->i_table_id == p_new->i_table_id
+         && p_item->i_extension == p_new->i_extension
+         && p_item->pf_callback == p_new->pf_callback
+         && p_item->p_cb_data == p_new->p_cb_data)
+            return p_item;
+    }
+    return NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_dispatch_post
+ *****************************************************************************/
+bool dvbpsi_dispatch_post(dvbpsi_dispatch_t *p_dispatch,
+                          dvbpsi_dispatch_callback pf_callback, void *p_cb_data,
+                          uint8_t i_table_id, uint16_t i_extension, void *p_table,
+                          void (*pf_delete)(void *))
+{
+    assert(p_dispatch);
+    assert(pf_callback && pf_delete);
+
+    dvbpsi_dispatch_item_t item = { pf_callback, p_cb_data, i_table_id,
+                                    i_extension, p_table, pf_delete };
+    void *p_old = NULL;         /* table deleted once unlocked */
+    void (*pf_old)(void *) = NULL;
+    bool b_notify = false;
+    bool b_queued = false;
+
+    pthread_mutex_lock(&p_dispatch->lock);
+    p_dispatch->stats.i_posted++;
+
+    bool b_blocked = false;
+    while (!p_dispatch->b_closed)
+    {
+        dvbpsi_dispatch_item_t *p_item = NULL;
+        if (p_dispatch->i_flags & DVBPSI_DISPATCH_COALESCE)
+            p_item = dvbpsi_dispatch_find(p_dispatch, &item);
+        if (p_item != NULL)
+        {
+            /* Superseded: the new version takes the place of the old one */
+            p_old = p_item->p_table;
+            pf_old = p_item->pf_delete;
+            *p_item = item;
+            p_dispatch->stats.i_coalesced++;
+            b_queued = true;
+            break;
+        }
+        if (p_dispatch->i_count < p_dispatch->i_size)
+        {
+            p_dispatch->p_items[(p_dispatch->i_head + p_dispatch->i_count)
+                                % p_dispatch->i_size] = item;
+            b_notify = (p_dispatch->i_count++ == 0);
+            if (p_dispatch->i_count > p_dispatch->stats.i_max_depth)
+                p_dispatch->stats.i_max_depth = p_dispatch->i_count;
+            pthread_cond_signal(&p_dispatch->ready);
+            b_queued = true;
+            break;
+        }
+        if (!(p_dispatch->i_flags & DVBPSI_DISPATCH_BLOCK))
+            break;
+
+        if (!b_blocked)
+        {
+            p_dispatch->stats.i_blocked++;
+            b_blocked = true;
+        }
+        p_dispatch->i_waiting++;
+        pthread_cond_wait(&p_dispatch->room, &p_dispatch->lock);
+        p_dispatch->i_waiting--;
+    }
+    if (!b_queued)
+    {
+        p_dispatch->stats.i_dropped++;
+        p_old = p_table;
+        pf_old = pf_delete;
+    }
+    pthread_mutex_unlock(&p_dispatch->lock);
+
+    if (p_old != NULL)
+        pf_old(p_old);
+    if (b_notify && p_dispatch->pf_notify)
+        p_dispatch->pf_notify(p_dispatch->p_notify_data);
+    return b_queued;
+}
+
+/*****************************************************************************
+ * dvbpsi_dispatch_run
+ *****************************************************************************/
+size_t dvbpsi_dispatch_run(dvbpsi_dispatch_t *p_dispatch, size_t i_max)
+{
+    assert(p_dispatch);
+
+    size_t i_done = 0;
+    while (i_done < i_max)
+    {
+        pthread_mutex_lock(&p_dispatch->lock);
+        if (p_dispatch->i_count == 0)
+        {
+            pthread_mutex_unlock(&p_dispatch->lock);
+            break;
+        }
+        dvbpsi_dispatch_item_t item = p_dispatch->p_items[p_dispatch->i_head];
+        p_dispatch->i_head = (p_dispatch->i_head + 1) % p_dispatch->i_size;
+        p_dispatch->i_count--;
+        p_dispatch->stats.i_delivered++;
+        if (p_dispatch->i_waiting > 0)
+            pthread_cond_signal(&p_dispatch->room);
+        pthread_mutex_unlock(&p_dispatch->lock);
+
+        item.pf_callback(item.p_cb_data, item.i_table_id, item.i_extension,
+                         item.p_table);
+        i_done++;
+    }
+    return i_done;
+}
+
+/*****************************************************************************
+ * dvbpsi_dispatch_wait
+ *****************************************************************************/
+bool dvbpsi_dispatch_wait(dvbpsi_dispatch_t *p_dispatch, int64_t i_timeout)
+{
+    assert(p_dispatch);
+
+    struct timespec deadline;
+    if (i_timeout >= 0)
+    {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        int64_t i_nsec = deadline.tv_nsec + (i_timeout % 1000000) * 1000;
+        deadline.tv_sec += i_timeout / 1000000 + i_nsec / 1000000000;
+        deadline.tv_nsec = i_nsec % 1000000000;
+    }
+
+    pthread_mutex_lock(&p_dispatch->lock);
+    while (p_dispatch->i_count == 0 && !p_dispatch->b_closed)
+    {
+        if (i_timeout < 0)
+            pthread_cond_wait(&p_dispatch->ready, &p_dispatch->lock);
+        else if (pthread_cond_timedwait(&p_dispatch->ready, &p_dispatch->lock,
+                                        &deadline) != 0)
+            break;
+    }
+    bool b_ready = (p_dispatch->i_count > 0);
+    pthread_mutex_unlock(&p_dispatch->lock);
+    return b_ready;
+}
+
+/*****************************************************************************
+ * dvbpsi_dispatch_close
+ *****************************************************************************/
+void dvbpsi_dispatch_close(dvbpsi_dispatch_t *p_dispatch)
+{
+    assert(p_dispatch);
+
+    pthread_mutex_lock(&p_dispatch->lock);
+    p_dispatch->b_closed = true;
+    pthread_cond_broadcast(&p_dispatch->ready);
+    pthread_cond_broadcast(&p_dispatch->room);
+    pthread_mutex_unlock(&p_dispatch->lock);
+}
+
+/*****************************************************************************
+ * dvbpsi_dispatch_get_stats
+ *****************************************************************************/
+void dvbpsi_dispatch_get_stats(dvbpsi_dispatch_t *p_dispatch,
+                               dvbpsi_dispatch_stats_t *p_stats)
+{
+    assert(p_dispatch && p_stats);
+
+    pthread_mutex_lock(&p_dispatch->lock);
+    *p_stats = p_dispatch->stats;
+    p_stats->i_depth = p_dispatch->i_count;
+    pthread_mutex_unlock(&p_dispatch->lock);
+}
+
+/*****************************************************************************
+ * Table callbacks
+ *****************************************************************************/
+static void dvbpsi_dispatch_delete_pat(void *p_table)
+{
+    dvbpsi_pat_delete(p_table);
+}
+
+static void dvbpsi_dispatch_delete_cat(void *p_table)
+{
+    dvbpsi_cat_delete(p_table);
+}
+
+static void dvbpsi_dispatch_delete_pmt(void *p_table)
+{
+    dvbpsi_pmt_delete(p_table);
+}
+
+static void dvbpsi_dispatch_delete_sdt(void *p_table)
+{
+    dvbpsi_sdt_delete(p_table);
+}
+
+static void dvbpsi_dispatch_delete_eit(void *p_table)
+{
+    dvbpsi_eit_delete(p_table);
+}
+
+static void dvbpsi_dispatch_delete_nit(void *p_table)
+{
+    dvbpsi_nit_delete(p_table);
+}
+
+static void dvbpsi_dispatch_delete_bat(void *p_table)
+{
+    dvbpsi_bat_delete(p_table);
+}
+
+static void dvbpsi_dispatch_delete_tot(void *p_table)
+{
+    dvbpsi_tot_delete(p_table);
+}
+
+#define DVBPSI_DISPATCH_PORT(p_port, i_table_id, i_extension, p_table, pf_delete) \
+    do { \
+        dvbpsi_dispatch_port_t *p_dest = (dvbpsi_dispatch_port_t *)(p_port); \
+        dvbpsi_dispatch_post(p_dest->p_dispatch, p_dest->pf_callback, \
+                             p_dest->p_cb_data, i_table_id, i_extension, \
+                             p_table, pf_delete); \
+    } while (0)
+
+void dvbpsi_dispatch_pat(void *p_port, dvbpsi_pat_t *p_pat)
+{
+    DVBPSI_DISPATCH_PORT(p_port, 0x00, p_pat->i_ts_id, p_pat, dvbpsi_dispatch_delete_pat);
+}
+
+void dvbpsi_dispatch_cat(void *p_port, dvbpsi_cat_t *p_cat)
+{
+    DVBPSI_DISPATCH_PORT(p_port, 0x01, 0, p_cat, dvbpsi_dispatch_delete_cat);
+}
+
+void dvbpsi_dispatch_pmt(void *p_port, dvbpsi_pmt_t *p_pmt)
+{
+    DVBPSI_DISPATCH_PORT(p_port, 0x02, p_pmt->i_program_number, p_pmt,
+                         dvbpsi_dispatch_delete_pmt);
+}
+
+void dvbpsi_dispatch_sdt(void *p_port, dvbpsi_sdt_t *p_sdt)
+{
+    DVBPSI_DISPATCH_PORT(p_port, p_sdt->i_table_id, p_sdt->i_extension, p_sdt,
+                         dvbpsi_dispatch_delete_sdt);
+}
+
+void dvbpsi_dispatch_eit(void *p_port, dvbpsi_eit_t *p_eit)
+{
+    DVBPSI_DISPATCH_PORT(p_port, p_eit->i_table_id, p_eit->i_extension, p_eit,
+                         dvbpsi_dispatch_delete_eit);
+}
+
+void dvbpsi_dispatch_nit(void *p_port, dvbpsi_nit_t *p_nit)
+{
+    DVBPSI_DISPATCH_PORT(p_port, p_nit->i_table_id, p_nit->i_extension, p_nit,
+                         dvbpsi_dispatch_delete_nit);
+}
+
+void dvbpsi_dispatch_bat(void *p_port, dvbpsi_bat_t *p_bat)
+{
+    DVBPSI_DISPATCH_PORT(p_port, p_bat->i_table_id, p_bat->i_extension, p_bat,
+                         dvbpsi_dispatch_delete_bat);
+}
+
+void dvbpsi_dispatch_tot(void *p_port, dvbpsi_tot_t *p_tot)
+{
+    DVBPSI_DISPATCH_PORT(p_port, p_tot->i_table_id, p_tot->i_extension, p_tot,
+                         dvbpsi_dispatch_delete_tot);
+}
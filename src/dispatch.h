@@ -0,0 +1,279 @@
+/*****************************************************************************
+ * dispatch.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <dispatch.h>
+ * \brief Asynchronous delivery of decoded tables.
+ *
+ * Moves the work of the table callbacks out of dvbpsi_packet_push(): the
+ * decoders are given callbacks that only queue their tables, and another
+ * thread, or an event loop, delivers them to the application callbacks.
+ * The queue is bounded. When it is full, a new table is dropped, or waits
+ * for room if the queue was created with DVBPSI_DISPATCH_BLOCK. With
+ * DVBPSI_DISPATCH_COALESCE, a table replaces the queued version of the same
+ * subtable, so that a slow consumer only gets the latest versions.
+ *
+ * Only built when POSIX threads are available.
+ */
+
+#ifndef _DVBPSI_DISPATCH_H_
+#define _DVBPSI_DISPATCH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_dispatch_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_dispatch_s dvbpsi_dispatch_t
+ * \brief dvbpsi_dispatch_t type definition, an opaque dispatch queue.
+ */
+typedef struct dvbpsi_dispatch_s dvbpsi_dispatch_t;
+
+/*!
+ * \def DVBPSI_DISPATCH_COALESCE
+ * \brief A table replaces the queued table of the same subtable, callback
+ * and callback data.
+ */
+#define DVBPSI_DISPATCH_COALESCE 0x01
+/*!
+ * \def DVBPSI_DISPATCH_BLOCK
+ * \brief Posting to a full queue waits for room instead of dropping the
+ * table.
+ */
+#define DVBPSI_DISPATCH_BLOCK    0x02
+
+/*****************************************************************************
+ * dvbpsi_dispatch_callback
+ *****************************************************************************/
+/*!
+ * \typedef void (* dvbpsi_dispatch_callback)(void *p_cb_data,
+ *                                            uint8_t i_table_id,
+ *                                            uint16_t i_extension,
+ *                                            void *p_table)
+ * \brief Callback type definition, called by dvbpsi_dispatch_run() with a
+ * table it then owns, as the callback of its decoder would.
+ * p_table is the dvbpsi_pat_t, dvbpsi_pmt_t, ... of i_table_id.
+ */
+typedef void (* dvbpsi_dispatch_callback)(void *p_cb_data, uint8_t i_table_id,
+                                          uint16_t i_extension, void *p_table);
+
+/*****************************************************************************
+ * dvbpsi_dispatch_stats_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_dispatch_stats_s
+ * \brief Counters of a dispatch queue.
+ */
+/*!
+ * \typedef struct dvbpsi_dispatch_stats_s dvbpsi_dispatch_stats_t
+ * \brief dvbpsi_dispatch_stats_t type definition.
+ */
+typedef struct dvbpsi_dispatch_stats_s
+{
+    uint64_t    i_posted;       /*!< tables posted */
+    uint64_t    i_delivered;    /*!< tables given to their callback */
+    uint64_t    i_coalesced;    /*!< queued tables replaced by a newer one */
+    uint64_t    i_dropped;      /*!< tables deleted as the queue was full */
+    uint64_t    i_blocked;      /*!< posts that waited for room */
+    size_t      i_depth;        /*!< tables queued */
+    size_t      i_max_depth;    /*!< highest number of tables queued */
+} dvbpsi_dispatch_stats_t;
+
+/*****************************************************************************
+ * dvbpsi_dispatch_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_dispatch_t *dvbpsi_dispatch_new(size_t i_size, uint32_t i_flags,
+ *                                            void (*pf_notify)(void *),
+ *                                            void *p_notify_data)
+ * \brief Creates an empty dispatch queue
+ * \param i_size maximum number of tables queued
+ * \param i_flags or'ed DVBPSI_DISPATCH_* options
+ * \param pf_notify function called by the posting thread when a table is
+ *        queued while the queue was empty, for instance to wake an event
+ *        loop, or NULL
+ * \param p_notify_data private data given in argument to pf_notify
+ * \return pointer to the queue, or NULL on error
+ */
+dvbpsi_dispatch_t *dvbpsi_dispatch_new(size_t i_size, uint32_t i_flags,
+                                       void (*pf_notify)(void *), void *p_notify_data);
+
+/*****************************************************************************
+ * dvbpsi_dispatch_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_dispatch_delete(dvbpsi_dispatch_t *p_dispatch)
+ * \brief Deletes a queue and the tables still queued
+ * \param p_dispatch pointer to the queue, no longer used by any thread
+ * \return nothing
+ */
+void dvbpsi_dispatch_delete(dvbpsi_dispatch_t *p_dispatch);
+
+/*****************************************************************************
+ * dvbpsi_dispatch_post
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_dispatch_post(dvbpsi_dispatch_t *p_dispatch,
+ *                               dvbpsi_dispatch_callback pf_callback,
+ *                               void *p_cb_data, uint8_t i_table_id,
+ *                               uint16_t i_extension, void *p_table,
+ *                               void (*pf_delete)(void *))
+ * \brief Queues a table for its callback
+ * \param p_dispatch pointer to the queue
+ * \param pf_callback function the table is given to
+ * \param p_cb_data private data given in argument to the callback
+ * \param i_table_id table_id of the table
+ * \param i_extension table_id_extension of the table
+ * \param p_table table, owned by the queue from now on
+ * \param pf_delete function deleting the table, such as dvbpsi_pmt_delete()
+ * \return false if the table was deleted as the queue was full or closed,
+ *         true otherwise.
+ *
+ * It may be called from several threads at once. With
+ * DVBPSI_DISPATCH_COALESCE the cost is linear in the number of tables
+ * queued.
+ */
+bool dvbpsi_dispatch_post(dvbpsi_dispatch_t *p_dispatch,
+                          dvbpsi_dispatch_callback pf_callback, void *p_cb_data,
+                          uint8_t i_table_id, uint16_t i_extension, void *p_table,
+                          void (*pf_delete)(void *));
+
+/*****************************************************************************
+ * dvbpsi_dispatch_port_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_dispatch_port_s
+ * \brief Callback of the application for the tables of a decoder, given as
+ * callback data to a decoder with one of the dvbpsi_dispatch_pat(),
+ * dvbpsi_dispatch_pmt(), ... callbacks, which post the tables.
+ */
+/*!
+ * \typedef struct dvbpsi_dispatch_port_s dvbpsi_dispatch_port_t
+ * \brief dvbpsi_dispatch_port_t type definition.
+ */
+typedef struct dvbpsi_dispatch_port_s
+{
+    dvbpsi_dispatch_t *         p_dispatch;     /*!< queue */
+    dvbpsi_dispatch_callback    pf_callback;    /*!< application callback */
+    void *                      p_cb_data;      /*!< its private data */
+} dvbpsi_dispatch_port_t;
+
+/*****************************************************************************
+ * dvbpsi_dispatch_pat/cat/pmt/sdt/eit/nit/bat/tot
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_dispatch_pat(void *p_port, dvbpsi_pat_t *p_pat)
+ * \brief PAT callback posting to the queue of a dvbpsi_dispatch_port_t
+ * \param p_port pointer to the port
+ * \param p_pat new PAT
+ * \return nothing.
+ *
+ * dvbpsi_dispatch_cat(), dvbpsi_dispatch_pmt(), dvbpsi_dispatch_sdt(),
+ * dvbpsi_dispatch_eit(), dvbpsi_dispatch_nit(), dvbpsi_dispatch_bat() and
+ * dvbpsi_dispatch_tot() are the same for the other tables, the subtable
+ * being given by table_id and extension: program_number for a PMT, 0 for
+ * a CAT and transport_stream_id for a PAT.
+ */
+void dvbpsi_dispatch_pat(void *p_port, dvbpsi_pat_t *p_pat);
+/*! \brief CAT callback, see dvbpsi_dispatch_pat() */
+void dvbpsi_dispatch_cat(void *p_port, dvbpsi_cat_t *p_cat);
+/*! \brief PMT callback, see dvbpsi_dispatch_pat() */
+void dvbpsi_dispatch_pmt(void *p_port, dvbpsi_pmt_t *p_pmt);
+/*! \brief SDT callback, see dvbpsi_dispatch_pat() */
+void dvbpsi_dispatch_sdt(void *p_port, dvbpsi_sdt_t *p_sdt);
+/*! \brief EIT callback, see dvbpsi_dispatch_pat() */
+void dvbpsi_dispatch_eit(void *p_port, dvbpsi_eit_t *p_eit);
+/*! \brief NIT callback, see dvbpsi_dispatch_pat() */
+void dvbpsi_dispatch_nit(void *p_port, dvbpsi_nit_t *p_nit);
+/*! \brief BAT callback, see dvbpsi_dispatch_pat() */
+void dvbpsi_dispatch_bat(void *p_port, dvbpsi_bat_t *p_bat);
+/*! \brief TDT/TOT callback, see dvbpsi_dispatch_pat() */
+void dvbpsi_dispatch_tot(void *p_port, dvbpsi_tot_t *p_tot);
+
+/*****************************************************************************
+ * dvbpsi_dispatch_run
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_dispatch_run(dvbpsi_dispatch_t *p_dispatch, size_t i_max)
+ * \brief Delivers queued tables to their callbacks, without waiting
+ * \param p_dispatch pointer to the queue
+ * \param i_max maximum number of tables to deliver
+ * \return the number of tables delivered.
+ *
+ * The tables are delivered in the order they were posted, a coalesced table
+ * taking the place of the one it replaced. The callbacks are called
+ * without any lock held and may post tables. It is meant to be called by
+ * one thread at a time.
+ */
+size_t dvbpsi_dispatch_run(dvbpsi_dispatch_t *p_dispatch, size_t i_max);
+
+/*****************************************************************************
+ * dvbpsi_dispatch_wait
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_dispatch_wait(dvbpsi_dispatch_t *p_dispatch,
+ *                               int64_t i_timeout)
+ * \brief Waits for a table to be queued
+ * \param p_dispatch pointer to the queue
+ * \param i_timeout maximum time to wait in microseconds, negative for no
+ *        limit
+ * \return true if a table is queued, false on timeout or once the queue is
+ *         closed and empty.
+ */
+bool dvbpsi_dispatch_wait(dvbpsi_dispatch_t *p_dispatch, int64_t i_timeout);
+
+/*****************************************************************************
+ * dvbpsi_dispatch_close
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_dispatch_close(dvbpsi_dispatch_t *p_dispatch)
+ * \brief Stops a queue: tables are not queued anymore, and
+ * dvbpsi_dispatch_wait() returns false once the queue is empty
+ * \param p_dispatch pointer to the queue
+ * \return nothing
+ */
+void dvbpsi_dispatch_close(dvbpsi_dispatch_t *p_dispatch);
+
+/*****************************************************************************
+ * dvbpsi_dispatch_get_stats
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_dispatch_get_stats(dvbpsi_dispatch_t *p_dispatch,
+ *                                    dvbpsi_dispatch_stats_t *p_stats)
+ * \brief Gets the counters of a queue, for instance to watch its backlog
+ * \param p_dispatch pointer to the queue
+ * \param p_stats filled with the counters
+ * \return nothing
+ */
+void dvbpsi_dispatch_get_stats(dvbpsi_dispatch_t *p_dispatch,
+                               dvbpsi_dispatch_stats_t *p_stats);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of dispatch.h"
+#endif
@@ -0,0 +1,597 @@
+/*****************************************************************************
+ * dsmcc.c: reassembly of the modules of DSM-CC carousels
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "crc32_private.h"
+#include "dsmcc.h"
+
+/* Buckets of the modules, a power of 2 */
+#define DVBPSI_DSMCC_BUCKETS        256
+/* dsmccMessageHeader and dsmccDownloadDataHeader, adaptation excluded */
+#define DVBPSI_DSMCC_HEADER         12
+/* messageId of the download messages */
+#define DVBPSI_DSMCC_DII            0x1002
+#define DVBPSI_DSMCC_DDB            0x1003
+#define DVBPSI_DSMCC_DSI            0x1006
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_entry_t
+ *****************************************************************************
+ * Module of a DII, in its bucket.
+ *****************************************************************************/
+typedef struct dvbpsi_dsmcc_entry_s
+{
+    struct dvbpsi_dsmcc_entry_s *p_next;
+    dvbpsi_dsmcc_module_t   module;         /* p_info pointing to p_info_bytes */
+    uint8_t                 p_info_bytes[255];
+    uint32_t *              p_bitmap;       /* blocks received, with p_data */
+    bool                    b_complete;
+} dvbpsi_dsmcc_entry_t;
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_download_t
+ *****************************************************************************
+ * Last DII transaction of a downloadId.
+ *****************************************************************************/
+typedef struct dvbpsi_dsmcc_download_s
+{
+    struct dvbpsi_dsmcc_download_s *p_next;
+    uint32_t                i_download_id;
+    uint32_t                i_transaction_id;
+} dvbpsi_dsmcc_download_t;
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_s
+ *****************************************************************************/
+struct dvbpsi_dsmcc_s
+{
+    dvbpsi_dsmcc_module_callback pf_callback;
+    void *                  p_cb_data;
+    dvbpsi_dsmcc_dsi_callback pf_dsi_callback;
+    void *                  p_dsi_cb_data;
+
+    bool                    b_buffers;
+    dvbpsi_dsmcc_buffers_t  buffers;
+    size_t                  i_max_memory;
+
+    dvbpsi_dsmcc_entry_t *  pp_buckets[DVBPSI_DSMCC_BUCKETS];
+    dvbpsi_dsmcc_download_t *p_downloads;
+
+    bool                    b_dsi;
+    uint32_t                i_dsi_transaction_id;
+
+    dvbpsi_dsmcc_stats_t    stats;
+};
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_new
+ *****************************************************************************/
+dvbpsi_dsmcc_t *dvbpsi_dsmcc_new(size_t i_max_memory,
+                                 dvbpsi_dsmcc_module_callback pf_callback,
+                                 void *p_cb_data)
+{
+    assert(pf_callback);
+
+    dvbpsi_dsmcc_t *p_dsmcc = dvbpsi_calloc(1, sizeof(dvbpsi_dsmcc_t));
+    if (p_dsmcc == NULL)
+        return NULL;
+
+    p_dsmcc->i_max_memory = i_max_memory;
+    p_dsmcc->pf_callback = pf_callback;
+    p_dsmcc->p_cb_data = p_cb_data;
+    return p_dsmcc;
+}
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_release
+ *****************************************************************************
+ * Gives back the buffer of a module.
+ *****************************************************************************/
+static void dvbpsi_dsmcc_release(dvbpsi_dsmcc_t *p_dsmcc,
+                                 dvbpsi_dsmcc_entry_t *p_entry, bool b_complete)
+{
+    if (p_entry->module.p_data == NULL)
+        return;
+
+    if (p_dsmcc->b_buffers)
+        p_dsmcc->buffers.pf_delete(&p_entry->module, p_entry->module.p_data,
+                                   b_complete, p_dsmcc->buffers.p_data);
+    else
+        dvbpsi_free(p_entry->module.p_data);
+    dvbpsi_free(p_entry->p_bitmap);
+    p_dsmcc->stats.i_memory -= p_entry->module.i_size;
+    p_entry->module.p_data = NULL;
+    p_entry->p_bitmap = NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_delete
+ *****************************************************************************/
+void dvbpsi_dsmcc_delete(dvbpsi_dsmcc_t *p_dsmcc)
+{
+    if (p_dsmcc == NULL)
+        return;
+
+    for (unsigned int i = 0; i < DVBPSI_DSMCC_BUCKETS; i++)
+    {
+        dvbpsi_dsmcc_entry_t *p_entry = p_dsmcc->pp_buckets[i];
+        while (p_entry)
+        {
+            dvbpsi_dsmcc_entry_t *p_next = p_entry->p_next;
+            dvbpsi_dsmcc_release(p_dsmcc, p_entry, false);
+            dvbpsi_free(p_entry);
+            p_entry = p_next;
+        }
+    }
+    dvbpsi_dsmcc_download_t *p_download = p_dsmcc->p_downloads;
+    while (p_download)
+    {
+        dvbpsi_dsmcc_download_t *p_next = p_download->p_next;
+        dvbpsi_free(p_download);
+        p_download = p_next;
+    }
+    dvbpsi_free(p_dsmcc);
+}
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_set_dsi_callback
+ *****************************************************************************/
+void dvbpsi_dsmcc_set_dsi_callback(dvbpsi_dsmcc_t *p_dsmcc,
+                                   dvbpsi_dsmcc_dsi_callback pf_callback,
+                                   void *p_cb_data)
+{
+    assert(p_dsmcc);
+
+    p_dsmcc->pf_dsi_callback = pf_callback;
+    p_dsmcc->p_dsi_cb_data = p_cb_data;
+}
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_set_buffers
+ *****************************************************************************/
+void dvbpsi_dsmcc_set_buffers(dvbpsi_dsmcc_t *p_dsmcc,
+                              const dvbpsi_dsmcc_buffers_t *p_buffers)
+{
+    assert(p_dsmcc);
+    assert(p_buffers == NULL || (p_buffers->pf_new && p_buffers->pf_delete));
+
+    p_dsmcc->b_buffers = p_buffers != NULL;
+    if (p_buffers)
+        p_dsmcc->buffers = *p_buffers;
+}
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_bucket
+ *****************************************************************************
+ * Bucket of a module.
+ *****************************************************************************/
+static dvbpsi_dsmcc_entry_t **dvbpsi_dsmcc_bucket(dvbpsi_dsmcc_t *p_dsmcc,
+                                                  uint32_t i_download_id,
+                                                  uint16_t i_module_id)
+{
+    uint32_t i_hash = (i_download_id ^ (i_download_id >> 16)) * 0x9e3779b1u;
+    i_hash ^= i_module_id * 0x85ebca6bu;
+    return &p_dsmcc->pp_buckets[(i_hash >> 16) & (DVBPSI_DSMCC_BUCKETS - 1)];
+}
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_find
+ *****************************************************************************/
+static dvbpsi_dsmcc_entry_t *dvbpsi_dsmcc_find(dvbpsi_dsmcc_t *p_dsmcc,
+                                               uint32_t i_download_id,
+                                               uint16_t i_module_id)
+{
+    dvbpsi_dsmcc_entry_t *p_entry = *dvbpsi_dsmcc_bucket(p_dsmcc, i_download_id,
+                                                         i_module_id);
+    while (p_entry && (p_entry->module.i_download_id != i_download_id
+                    || p_entry->module.i_module_id != i_module_id))
+        p_entry = p_entry->p_next;
+    return p_entry;
+}
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_complete
+ *****************************************************************************
+ * Calls a complete module back, and gives its buffer back.
+ *****************************************************************************/
+static void dvbpsi_dsmcc_complete(dvbpsi_dsmcc_t *p_dsmcc,
+                                  dvbpsi_dsmcc_entry_t *p_entry)
+{
+    p_entry->b_complete = true;
+    p_dsmcc->stats.i_completed++;
+    p_dsmcc->pf_callback(p_dsmcc->p_cb_data, &p_entry->module);
+    dvbpsi_dsmcc_release(p_dsmcc, p_entry, true);
+}
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_message
+ *****************************************************************************
+ * Reads the header of a download message. Returns the start of its payload,
+ * after the adaptation bytes, and sets its end, or NULL if invalid.
+ *****************************************************************************/
+static const uint8_t *dvbpsi_dsmcc_message(const uint8_t *p_byte,
+                                           const uint8_t *p_end,
+                                           uint16_t *pi_message_id, uint32_t *pi_id,
+                                           const uint8_t **pp_message_end)
+{
+    if (p_end - p_byte < DVBPSI_DSMCC_HEADER
+     || p_byte[0] != 0x11 || p_byte[1] != 0x03)
+        return NULL;
+
+    *pi_message_id = ((uint16_t)p_byte[2] << 8) | p_byte[3];
+    *pi_id = ((uint32_t)p_byte[4] << 24) | ((uint32_t)p_byte[5] << 16)
+           | ((uint32_t)p_byte[6] << 8) | p_byte[7];
+    uint8_t i_adaptation = p_byte[9];
+    uint16_t i_length = ((uint16_t)p_byte[10] << 8) | p_byte[11];
+    if (i_adaptation > i_length
+     || i_length > p_end - p_byte - DVBPSI_DSMCC_HEADER)
+        return NULL;
+
+    *pp_message_end = p_byte + DVBPSI_DSMCC_HEADER + i_length;
+    return p_byte + DVBPSI_DSMCC_HEADER + i_adaptation;
+}
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_dsi
+ *****************************************************************************
+ * Handles a DownloadServerInitiate message.
+ *****************************************************************************/
+static bool dvbpsi_dsmcc_dsi(dvbpsi_dsmcc_t *p_dsmcc, uint32_t i_transaction_id,
+                             const uint8_t *p_byte, const uint8_t *p_end)
+{
+    if (p_end - p_byte < 20 + 2)
+        return false;
+    uint16_t i_compatibility = ((uint16_t)p_byte[20] << 8) | p_byte[21];
+    const uint8_t *p_private = p_byte + 20 + 2 + i_compatibility;
+    if (p_end - p_private < 2)
+        return false;
+    uint16_t i_private = ((uint16_t)p_private[0] << 8) | p_private[1];
+    if (i_private > p_end - p_private - 2)
+        return false;
+
+    if (p_dsmcc->b_dsi && p_dsmcc->i_dsi_transaction_id == i_transaction_id)
+        return true;
+    p_dsmcc->b_dsi = true;
+    p_dsmcc->i_dsi_transaction_id = i_transaction_id;
+
+    if (p_dsmcc->pf_dsi_callback)
+    {
+        dvbpsi_dsmcc_dsi_t dsi;
+        dsi.i_transaction_id = i_transaction_id;
+        memcpy(dsi.i_server_id, p_byte, 20);
+        dsi.i_private_length = i_private;
+        dsi.p_private = p_private + 2;
+        p_dsmcc->pf_dsi_callback(p_dsmcc->p_dsi_cb_data, &dsi);
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_dii
+ *****************************************************************************
+ * Handles a DownloadInfoIndication message: a new transaction updates the
+ * modules of its downloadId.
+ *****************************************************************************/
+static bool dvbpsi_dsmcc_dii(dvbpsi_dsmcc_t *p_dsmcc, uint32_t i_transaction_id,
+                             const uint8_t *p_byte, const uint8_t *p_end)
+{
+    /* downloadId, blockSize, windowSize, ackPeriod, tCDownloadWindow,
+     * tCDownloadScenario and compatibilityDescriptorLength */
+    if (p_end - p_byte < 4 + 2 + 1 + 1 + 4 + 4 + 2)
+        return false;
+    uint32_t i_download_id = ((uint32_t)p_byte[0] << 24) | ((uint32_t)p_byte[1] << 16)
+                           | ((uint32_t)p_byte[2] << 8) | p_byte[3];
+    uint16_t i_block_size = ((uint16_t)p_byte[4] << 8) | p_byte[5];
+    uint16_t i_compatibility = ((uint16_t)p_byte[16] << 8) | p_byte[17];
+    const uint8_t *p_module = p_byte + 18 + i_compatibility;
+    if (i_block_size == 0 || p_end - p_module < 2)
+        return false;
+    uint16_t i_modules = ((uint16_t)p_module[0] << 8) | p_module[1];
+    p_module += 2;
+
+    dvbpsi_dsmcc_download_t *p_download = p_dsmcc->p_downloads;
+    while (p_download && p_download->i_download_id != i_download_id)
+        p_download = p_download->p_next;
+    if (p_download && p_download->i_transaction_id == i_transaction_id)
+        return true;
+    if (p_download == NULL)
+    {
+        p_download = dvbpsi_calloc(1, sizeof(dvbpsi_dsmcc_download_t));
+        if (p_download == NULL)
+            return false;
+        p_download->i_download_id = i_download_id;
+        p_download->p_next = p_dsmcc->p_downloads;
+        p_dsmcc->p_downloads = p_download;
+    }
+    p_download->i_transaction_id = i_transaction_id;
+    p_dsmcc->stats.i_dii++;
+
+    bool b_valid = true;
+    for (uint16_t i = 0; i < i_modules; i++)
+    {
+        /* moduleId, moduleSize, moduleVersion and moduleInfoLength */
+        if (p_end - p_module < 2 + 4 + 1 + 1
+         || p_module[7] > p_end - p_module - 8)
+        {
+            b_valid = false;
+            break;
+        }
+        uint16_t i_module_id = ((uint16_t)p_module[0] << 8) | p_module[1];
+        uint32_t i_size = ((uint32_t)p_module[2] << 24) | ((uint32_t)p_module[3] << 16)
+                        | ((uint32_t)p_module[4] << 8) | p_module[5];
+        uint8_t i_version = p_module[6];
+        uint8_t i_info_length = p_module[7];
+        const uint8_t *p_info = p_module + 8;
+        p_module += 8 + i_info_length;
+
+        /* blockNumber is 16 bits */
+        uint32_t i_blocks = i_size / i_block_size + (i_size % i_block_size != 0);
+        if (i_blocks > 65536)
+        {
+            b_valid = false;
+            continue;
+        }
+
+        dvbpsi_dsmcc_entry_t *p_entry = dvbpsi_dsmcc_find(p_dsmcc, i_download_id,
+                                                          i_module_id);
+        if (p_entry && (p_entry->module.i_version != i_version
+                     || p_entry->module.i_size != i_size
+                     || p_entry->module.i_block_size != i_block_size))
+        {
+            if (!p_entry->b_complete && p_entry->module.i_received)
+                p_dsmcc->stats.i_restarted++;
+            dvbpsi_dsmcc_release(p_dsmcc, p_entry, false);
+            p_entry->b_complete = false;
+            p_entry->module.i_received = 0;
+        }
+        else if (p_entry == NULL)
+        {
+            p_entry = dvbpsi_calloc(1, sizeof(dvbpsi_dsmcc_entry_t));
+            if (p_entry == NULL)
+            {
+                b_valid = false;
+                break;
+            }
+            dvbpsi_dsmcc_entry_t **pp_bucket = dvbpsi_dsmcc_bucket(p_dsmcc, i_download_id,
+                                                                   i_module_id);
+            p_entry->p_next = *pp_bucket;
+            *pp_bucket = p_entry;
+            p_entry->module.i_download_id = i_download_id;
+            p_entry->module.i_module_id = i_module_id;
+            p_entry->module.p_info = p_entry->p_info_bytes;
+            p_dsmcc->stats.i_modules++;
+        }
+
+        p_entry->module.i_transaction_id = i_transaction_id;
+        p_entry->module.i_version = i_version;
+        p_entry->module.i_size = i_size;
+        p_entry->module.i_block_size = i_block_size;
+        p_entry->module.i_blocks = i_blocks;
+        p_entry->module.i_info_length = i_info_length;
+        memcpy(p_entry->p_info_bytes, p_info, i_info_length);
+
+        if (i_blocks == 0 && !p_entry->b_complete)
+            dvbpsi_dsmcc_complete(p_dsmcc, p_entry);
+    }
+
+    /* Modules no longer listed */
+    for (unsigned int i = 0; i < DVBPSI_DSMCC_BUCKETS; i++)
+    {
+        dvbpsi_dsmcc_entry_t **pp_entry = &p_dsmcc->pp_buckets[i];
+        while (*pp_entry)
+        {
+            dvbpsi_dsmcc_entry_t *p_entry = *pp_entry;
+            if (p_entry->module.i_download_id != i_download_id
+             || p_entry->module.i_transaction_id == i_transaction_id)
+            {
+                pp_entry = &p_entry->p_next;
+                continue;
+            }
+            if (!p_entry->b_complete && p_entry->module.i_received)
+                p_dsmcc->stats.i_restarted++;
+            *pp_entry = p_entry->p_next;
+            dvbpsi_dsmcc_release(p_dsmcc, p_entry, false);
+            dvbpsi_free(p_entry);
+            p_dsmcc->stats.i_modules--;
+        }
+    }
+    return b_valid;
+}
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_ddb
+ *****************************************************************************
+ * Handles a DownloadDataBlock message, placing its block in its module.
+ *****************************************************************************/
+static bool dvbpsi_dsmcc_ddb(dvbpsi_dsmcc_t *p_dsmcc, uint32_t i_download_id,
+                             const uint8_t *p_byte, const uint8_t *p_end)
+{
+    /* moduleId, moduleVersion, reserved and blockNumber */
+    if (p_end - p_byte < 2 + 1 + 1 + 2)
+        return false;
+    uint16_t i_module_id = ((uint16_t)p_byte[0] << 8) | p_byte[1];
+    uint8_t i_version = p_byte[2];
+    uint16_t i_block = ((uint16_t)p_byte[4] << 8) | p_byte[5];
+    p_byte += 6;
+
+    dvbpsi_dsmcc_entry_t *p_entry = dvbpsi_dsmcc_find(p_dsmcc, i_download_id,
+                                                      i_module_id);
+    if (p_entry == NULL || p_entry->module.i_version != i_version)
+    {
+        p_dsmcc->stats.i_orphans++;
+        return true;
+    }
+    if (p_entry->b_complete)
+    {
+        p_dsmcc->stats.i_duplicates++;
+        return true;
+    }
+
+    dvbpsi_dsmcc_module_t *p_module = &p_entry->module;
+    if (i_block >= p_module->i_blocks)
+        return false;
+    uint32_t i_offset = (uint32_t)i_block * p_module->i_block_size;
+    uint32_t i_length = p_module->i_size - i_offset;
+    if (i_length > p_module->i_block_size)
+        i_length = p_module->i_block_size;
+    if (i_length > (size_t)(p_end - p_byte))
+        return false;
+
+    if (p_entry->p_bitmap
+     && (p_entry->p_bitmap[i_block >> 5] & (UINT32_C(1) << (i_block & 31))))
+    {
+        p_dsmcc->stats.i_duplicates++;
+        return true;
+    }
+
+    if (p_module->p_data == NULL)
+    {
+        if (p_dsmcc->i_max_memory
+         && p_module->i_size > p_dsmcc->i_max_memory - p_dsmcc->stats.i_memory)
+        {
+            p_dsmcc->stats.i_overflows++;
+            return true;
+        }
+        p_entry->p_bitmap = dvbpsi_calloc((p_module->i_blocks + 31) / 32,
+                                          sizeof(uint32_t));
+        if (p_entry->p_bitmap == NULL)
+            return false;
+        if (p_dsmcc->b_buffers)
+            p_module->p_data = p_dsmcc->buffers.pf_new(p_module,
+                                                       p_dsmcc->buffers.p_data);
+        else
+            p_module->p_data = dvbpsi_malloc(p_module->i_size);
+        if (p_module->p_data == NULL)
+        {
+            dvbpsi_free(p_entry->p_bitmap);
+            p_entry->p_bitmap = NULL;
+            p_dsmcc->stats.i_overflows++;
+            return true;
+        }
+        p_dsmcc->stats.i_memory += p_module->i_size;
+    }
+
+    memcpy(p_module->p_data + i_offset, p_byte, i_length);
+    p_entry->p_bitmap[i_block >> 5] |= UINT32_C(1) << (i_block & 31);
+    p_module->i_received++;
+    p_dsmcc->stats.i_blocks++;
+
+    if (p_module->i_received == p_module->i_blocks)
+        dvbpsi_dsmcc_complete(p_dsmcc, p_entry);
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_handle
+ *****************************************************************************
+ * Handles a DSM-CC section, whose CRC_32 is checked if b_crc.
+ *****************************************************************************/
+static bool dvbpsi_dsmcc_handle(dvbpsi_dsmcc_t *p_dsmcc, const uint8_t *p_section,
+                                size_t i_size, bool b_crc)
+{
+    assert(p_dsmcc);
+
+    if (p_section == NULL || i_size < 3
+     || (p_section[0] != 0x3b && p_section[0] != 0x3c))
+        return false;
+    size_t i_section = 3 + ((((size_t)p_section[1] & 0x0f) << 8) | p_section[2]);
+    p_dsmcc->stats.i_sections++;
+    /* Section header, message header and CRC_32 or checksum */
+    if (i_section > i_size || i_section < 8 + DVBPSI_DSMCC_HEADER + 4
+     || (b_crc && (p_section[1] & 0x80)
+         && dvbpsi_crc32(0xffffffff, p_section, i_section) != 0))
+    {
+        p_dsmcc->stats.i_invalid++;
+        return false;
+    }
+
+    uint16_t i_message_id;
+    uint32_t i_id;
+    const uint8_t *p_end;
+    const uint8_t *p_byte = dvbpsi_dsmcc_message(p_section + 8,
+                                                 p_section + i_section - 4,
+                                                 &i_message_id, &i_id, &p_end);
+    bool b_valid = false;
+    if (p_byte == NULL)
+        b_valid = false;
+    else if (p_section[0] == 0x3c && i_message_id == DVBPSI_DSMCC_DDB)
+        b_valid = dvbpsi_dsmcc_ddb(p_dsmcc, i_id, p_byte, p_end);
+    else if (p_section[0] == 0x3b && i_message_id == DVBPSI_DSMCC_DII)
+        b_valid = dvbpsi_dsmcc_dii(p_dsmcc, i_id, p_byte, p_end);
+    else if (p_section[0] == 0x3b && i_message_id == DVBPSI_DSMCC_DSI)
+        b_valid = dvbpsi_dsmcc_dsi(p_dsmcc, i_id, p_byte, p_end);
+
+    if (!b_valid)
+        p_dsmcc->stats.i_invalid++;
+    return b_valid;
+}
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_section
+ *****************************************************************************/
+bool dvbpsi_dsmcc_section(dvbpsi_dsmcc_t *p_dsmcc,
+                          const uint8_t *p_section, size_t i_size)
+{
+    return dvbpsi_dsmcc_handle(p_dsmcc, p_section, i_size, true);
+}
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_tap
+ *****************************************************************************/
+void dvbpsi_dsmcc_tap(void *p_cb_data, uint16_t i_pid, int64_t i_time,
+                      const uint8_t *p_section, size_t i_size)
+{
+    (void)i_pid;
+    (void)i_time;
+
+    if (i_size && (p_section[0] == 0x3b || p_section[0] == 0x3c))
+        dvbpsi_dsmcc_handle((dvbpsi_dsmcc_t *)p_cb_data, p_section, i_size, false);
+}
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_get_stats
+ *****************************************************************************/
+void dvbpsi_dsmcc_get_stats(const dvbpsi_dsmcc_t *p_dsmcc,
+                            dvbpsi_dsmcc_stats_t *p_stats)
+{
+    assert(p_dsmcc);
+    assert(p_stats);
+
+    *p_stats = p_dsmcc->stats;
+}
@@ -0,0 +1,316 @@
+/*****************************************************************************
+ * dsmcc.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <dsmcc.h>
+ * \brief Reassembly of the modules of DSM-CC data and object carousels.
+ *
+ * The download messages of ISO/IEC 13818-6 are carried by DSM-CC sections,
+ * table_id 0x3B for the DownloadServerInitiate (DSI) and
+ * DownloadInfoIndication (DII) messages, and 0x3C for the DownloadDataBlock
+ * (DDB) ones, on the PIDs tagged by the association_tag of a data carousel
+ * or carousel identifier descriptor, ETSI EN 301 192 and TR 101 202.
+ *
+ * The modules listed in a DII are rebuilt from their DDBs: each block is
+ * copied once at its place in the module buffer, in any order, a bitmap
+ * telling the blocks received, and the module is called back once all of
+ * them are. The repetitions of a DII and of the blocks already received
+ * only cost a lookup. A new DII transaction restarts the modules whose
+ * version or size changed and drops those no longer listed. The module
+ * buffers may be given by the application, e.g. mapped files for large
+ * software updates.
+ *
+ * The sections are given to dvbpsi_dsmcc_section(), or seen on a handle
+ * through dvbpsi_dsmcc_tap() set as its section tap. The payloads of the
+ * object carousels, BIOP messages, are left to the application.
+ */
+
+#ifndef _DVBPSI_DSMCC_H_
+#define _DVBPSI_DSMCC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_dsmcc_s dvbpsi_dsmcc_t
+ * \brief dvbpsi_dsmcc_t type definition, an opaque module reassembler.
+ */
+typedef struct dvbpsi_dsmcc_s dvbpsi_dsmcc_t;
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_module_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_dsmcc_module_s
+ * \brief Module of a DII, given to the callbacks.
+ */
+/*!
+ * \typedef struct dvbpsi_dsmcc_module_s dvbpsi_dsmcc_module_t
+ * \brief dvbpsi_dsmcc_module_t type definition.
+ */
+typedef struct dvbpsi_dsmcc_module_s
+{
+    uint32_t        i_download_id;      /*!< downloadId */
+    uint32_t        i_transaction_id;   /*!< transactionId of the DII */
+    uint16_t        i_module_id;        /*!< moduleId */
+    uint8_t         i_version;          /*!< moduleVersion */
+    uint32_t        i_size;             /*!< moduleSize */
+    uint16_t        i_block_size;       /*!< blockSize of the DII */
+    uint32_t        i_blocks;           /*!< number of blocks */
+    uint32_t        i_received;         /*!< blocks received */
+    uint8_t         i_info_length;      /*!< moduleInfoLength */
+    const uint8_t * p_info;             /*!< moduleInfo, e.g. the BIOP
+                                             ModuleInfo of an object
+                                             carousel */
+    uint8_t *       p_data;             /*!< module buffer of i_size bytes,
+                                             NULL before the first block */
+} dvbpsi_dsmcc_module_t;
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_dsi_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_dsmcc_dsi_s
+ * \brief DownloadServerInitiate message.
+ */
+/*!
+ * \typedef struct dvbpsi_dsmcc_dsi_s dvbpsi_dsmcc_dsi_t
+ * \brief dvbpsi_dsmcc_dsi_t type definition.
+ */
+typedef struct dvbpsi_dsmcc_dsi_s
+{
+    uint32_t        i_transaction_id;   /*!< transactionId */
+    uint8_t         i_server_id[20];    /*!< serverId */
+    uint16_t        i_private_length;   /*!< privateDataLength */
+    const uint8_t * p_private;          /*!< privateData: GroupInfoIndication
+                                             of a data carousel,
+                                             ServiceGatewayInfo of an object
+                                             carousel */
+} dvbpsi_dsmcc_dsi_t;
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_stats_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_dsmcc_stats_s
+ * \brief Counters of a reassembler.
+ */
+/*!
+ * \typedef struct dvbpsi_dsmcc_stats_s dvbpsi_dsmcc_stats_t
+ * \brief dvbpsi_dsmcc_stats_t type definition.
+ */
+typedef struct dvbpsi_dsmcc_stats_s
+{
+    uint64_t    i_sections;     /*!< DSM-CC sections given */
+    uint64_t    i_invalid;      /*!< sections or messages not understood */
+    uint64_t    i_dii;          /*!< DII transactions handled */
+    uint64_t    i_blocks;       /*!< blocks placed in their module */
+    uint64_t    i_duplicates;   /*!< blocks already received */
+    uint64_t    i_orphans;      /*!< blocks of no module or of another
+                                     version */
+    uint64_t    i_completed;    /*!< modules called back */
+    uint64_t    i_restarted;    /*!< modules dropped before completion, by a
+                                     new DII */
+    uint64_t    i_overflows;    /*!< blocks dropped as the memory limit or
+                                     the buffer function refused their
+                                     module */
+    size_t      i_modules;      /*!< modules known */
+    size_t      i_memory;       /*!< bytes of the buffers of the modules
+                                     being received */
+} dvbpsi_dsmcc_stats_t;
+
+/*!
+ * \typedef void (* dvbpsi_dsmcc_module_callback)(void *p_cb_data,
+                  const dvbpsi_dsmcc_module_t *p_module)
+ * \brief Callback type definition of a complete module, whose buffer is
+ * only valid during the call.
+ */
+typedef void (* dvbpsi_dsmcc_module_callback)(void *p_cb_data,
+                                              const dvbpsi_dsmcc_module_t *p_module);
+
+/*!
+ * \typedef void (* dvbpsi_dsmcc_dsi_callback)(void *p_cb_data,
+                  const dvbpsi_dsmcc_dsi_t *p_dsi)
+ * \brief Callback type definition of a new DSI, only valid during the call.
+ */
+typedef void (* dvbpsi_dsmcc_dsi_callback)(void *p_cb_data,
+                                           const dvbpsi_dsmcc_dsi_t *p_dsi);
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_buffers_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_dsmcc_buffers_s
+ * \brief Functions giving the module buffers, see dvbpsi_dsmcc_set_buffers()
+ */
+/*!
+ * \typedef struct dvbpsi_dsmcc_buffers_s dvbpsi_dsmcc_buffers_t
+ * \brief dvbpsi_dsmcc_buffers_t type definition.
+ */
+typedef struct dvbpsi_dsmcc_buffers_s
+{
+    uint8_t *(*pf_new)(const dvbpsi_dsmcc_module_t *p_module,
+                       void *p_data);               /*!< buffer of
+                                                         p_module->i_size
+                                                         bytes, NULL to skip
+                                                         the module for now */
+    void     (*pf_delete)(const dvbpsi_dsmcc_module_t *p_module,
+                          uint8_t *p_buffer, bool b_complete,
+                          void *p_data);            /*!< buffer given back,
+                                                         after the module
+                                                         callback when
+                                                         b_complete */
+    void     *p_data;                               /*!< private data given
+                                                         to the functions */
+} dvbpsi_dsmcc_buffers_t;
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_dsmcc_t *dvbpsi_dsmcc_new(size_t i_max_memory,
+ *                                      dvbpsi_dsmcc_module_callback pf_callback,
+ *                                      void *p_cb_data)
+ * \brief Creates a reassembler without any module
+ * \param i_max_memory maximum number of bytes of the buffers of the modules
+ *        being received, 0 for no limit
+ * \param pf_callback function called with each complete module
+ * \param p_cb_data data given to pf_callback
+ * \return the new reassembler, NULL on error.
+ */
+dvbpsi_dsmcc_t *dvbpsi_dsmcc_new(size_t i_max_memory,
+                                 dvbpsi_dsmcc_module_callback pf_callback,
+                                 void *p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_dsmcc_delete(dvbpsi_dsmcc_t *p_dsmcc)
+ * \brief Deletes a reassembler, giving back the buffers of the modules
+ * being received
+ * \param p_dsmcc reassembler, or NULL
+ * \return nothing.
+ */
+void dvbpsi_dsmcc_delete(dvbpsi_dsmcc_t *p_dsmcc);
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_set_dsi_callback
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_dsmcc_set_dsi_callback(dvbpsi_dsmcc_t *p_dsmcc,
+ *                                        dvbpsi_dsmcc_dsi_callback pf_callback,
+ *                                        void *p_cb_data)
+ * \brief Sets the function called with each new DSI transaction
+ * \param p_dsmcc reassembler
+ * \param pf_callback function, NULL to disable it
+ * \param p_cb_data data given to pf_callback
+ * \return nothing.
+ */
+void dvbpsi_dsmcc_set_dsi_callback(dvbpsi_dsmcc_t *p_dsmcc,
+                                   dvbpsi_dsmcc_dsi_callback pf_callback,
+                                   void *p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_set_buffers
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_dsmcc_set_buffers(dvbpsi_dsmcc_t *p_dsmcc,
+ *                                   const dvbpsi_dsmcc_buffers_t *p_buffers)
+ * \brief Sets the functions giving the module buffers
+ * \param p_dsmcc reassembler
+ * \param p_buffers functions, NULL for buffers allocated by the library
+ * \return nothing.
+ *
+ * A buffer is asked for when the first block of a module arrives, and
+ * given back once the module is called back, restarted, dropped or the
+ * reassembler deleted. Set the functions before the first section.
+ */
+void dvbpsi_dsmcc_set_buffers(dvbpsi_dsmcc_t *p_dsmcc,
+                              const dvbpsi_dsmcc_buffers_t *p_buffers);
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_section
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_dsmcc_section(dvbpsi_dsmcc_t *p_dsmcc,
+ *                               const uint8_t *p_section, size_t i_size)
+ * \brief Handles a DSM-CC section
+ * \param p_dsmcc reassembler
+ * \param p_section bytes of the section
+ * \param i_size number of bytes, at least the length of the section
+ * \return false if the section is not a valid DSI, DII or DDB one, true
+ *         otherwise.
+ *
+ * The CRC_32 of the sections with the section_syntax_indicator is checked.
+ * The module callbacks are made from inside the call.
+ */
+bool dvbpsi_dsmcc_section(dvbpsi_dsmcc_t *p_dsmcc,
+                          const uint8_t *p_section, size_t i_size);
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_tap
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_dsmcc_tap(void *p_cb_data, uint16_t i_pid, int64_t i_time,
+ *                           const uint8_t *p_section, size_t i_size)
+ * \brief Section tap handing the DSM-CC sections of a handle to a
+ * reassembler
+ * \param p_cb_data reassembler
+ * \param i_pid PID of the section
+ * \param i_time arrival time of the section
+ * \param p_section bytes of the section
+ * \param i_size number of bytes
+ * \return nothing.
+ *
+ * To be set with dvbpsi_set_section_tap() on the handle of the carousel
+ * PID, the sections of other tables being ignored. Their CRC_32 having been
+ * checked by the handle, it is not checked again.
+ */
+void dvbpsi_dsmcc_tap(void *p_cb_data, uint16_t i_pid, int64_t i_time,
+                      const uint8_t *p_section, size_t i_size);
+
+/*****************************************************************************
+ * dvbpsi_dsmcc_get_stats
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_dsmcc_get_stats(const dvbpsi_dsmcc_t *p_dsmcc,
+ *                                 dvbpsi_dsmcc_stats_t *p_stats)
+ * \brief Gets the counters of a reassembler
+ * \param p_dsmcc reassembler
+ * \param p_stats receives the counters
+ * \return nothing.
+ */
+void dvbpsi_dsmcc_get_stats(const dvbpsi_dsmcc_t *p_dsmcc,
+                            dvbpsi_dsmcc_stats_t *p_stats);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of dsmcc.h"
+#endif
@@ -42,21 +42,747 @@
 #include <assert.h>
 
 #include "dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODER
 #include "dvbpsi_private.h"
 #include "psi.h"
+#include "crc32_private.h"
+#include "demux.h"
+#include "changelog.h"
+
+/*****************************************************************************
+ * Memory allocation
+ *****************************************************************************/
+static void *dvbpsi_libc_malloc(size_t i_size, void *p_data)
+{
+    (void)p_data;
+    return malloc(i_size);
+}
+
+static void *dvbpsi_libc_calloc(size_t i_count, size_t i_size, void *p_data)
+{
+    (void)p_data;
+    return calloc(i_count, i_size);
+}
+
+static void dvbpsi_libc_free(void *p_ptr, void *p_data)
+{
+    (void)p_data;
+    free(p_ptr);
+}
+
+static dvbpsi_allocator_t dvbpsi_allocator =
+{
+    .pf_malloc = dvbpsi_libc_malloc,
+    .pf_calloc = dvbpsi_libc_calloc,
+    .pf_free   = dvbpsi_libc_free,
+    .p_data    = NULL,
+};
+
+/*****************************************************************************
+ * Memory records
+ *****************************************************************************
+ * With DVBPSI_MEM_STATS every block allocated through dvbpsi_malloc_as() and
+ * dvbpsi_calloc_as() is recorded, by address, in an open addressing hash
+ * table, with its size and category. Blocks are not tagged in place so the
+ * allocator still sees the pointers it returned, and the table comes from
+ * calloc() so that its allocations are not counted by the allocator, nor
+ * tied to it. A deleted record is kept as a tombstone until the table is
+ * rebuilt. The lock is a spinning flag, the records being only touched for
+ * a few instructions at a time.
+ *****************************************************************************/
+#ifdef DVBPSI_MEM_STATS
+#define DVBPSI_MEM_DELETED      ((const void *)1)
+#define DVBPSI_MEM_RECORDS_MIN  1024
+
+typedef struct dvbpsi_mem_record_s
+{
+    const void            *p_ptr;       /* NULL if free, or DVBPSI_MEM_DELETED */
+    size_t                 i_size;
+    dvbpsi_mem_category_t  i_category;
+} dvbpsi_mem_record_t;
+
+static struct
+{
+    dvbpsi_mem_record_t *p_records;
+    size_t               i_records;     /* a power of 2 */
+    size_t               i_used;        /* live records and tombstones */
+    size_t               i_live;
+    dvbpsi_mem_stats_t   stats;
+#ifdef __ATOMIC_RELAXED
+    bool                 b_lock;
+#endif
+} dvbpsi_mem;
+
+static inline void dvbpsi_mem_lock(void)
+{
+#ifdef __ATOMIC_RELAXED
+    while (__atomic_test_and_set(&dvbpsi_mem.b_lock, __ATOMIC_ACQUIRE))
+        ;
+#endif
+}
+
+static inline void dvbpsi_mem_unlock(void)
+{
+#ifdef __ATOMIC_RELAXED
+    __atomic_clear(&dvbpsi_mem.b_lock, __ATOMIC_RELEASE);
+#endif
+}
+
+static inline size_t dvbpsi_mem_hash(const void *p_ptr, size_t i_records)
+{
+    uint64_t i_hash = (uint64_t)(uintptr_t)p_ptr * UINT64_C(0x9e3779b97f4a7c15);
+    return (size_t)(i_hash >> 32) & (i_records - 1);
+}
+
+/* Record of p_ptr, or NULL */
+static dvbpsi_mem_record_t *dvbpsi_mem_find(const void *p_ptr)
+{
+    if (dvbpsi_mem.p_records == NULL)
+        return NULL;
+
+    size_t i_mask = dvbpsi_mem.i_records - 1;
+    for (size_t i = dvbpsi_mem_hash(p_ptr, dvbpsi_mem.i_records);
+         dvbpsi_mem.p_records[i].p_ptr != NULL; i = (i + 1) & i_mask)
+    {
+        if (dvbpsi_mem.p_records[i].p_ptr == p_ptr)
+            return &dvbpsi_mem.p_records[i];
+    }
+    return NULL;
+}
+
+/* Rebuilds the table, without tombstones, large enough for one more record */
+static bool dvbpsi_mem_rehash(void)
+{
+    size_t i_records = DVBPSI_MEM_RECORDS_MIN;
+    while (i_records < 2 * (dvbpsi_mem.i_live + 1))
+        i_records *= 2;
+
+    dvbpsi_mem_record_t *p_records = calloc(i_records, sizeof(dvbpsi_mem_record_t));
+    if (p_records == NULL)
+        return false;
+
+    for (size_t i = 0; i < dvbpsi_mem.i_records; i++)
+    {
+        const dvbpsi_mem_record_t *p_record = &dvbpsi_mem.p_records[i];
+        if (p_record->p_ptr == NULL || p_record->p_ptr == DVBPSI_MEM_DELETED)
+            continue;
+
+        size_t j = dvbpsi_mem_hash(p_record->p_ptr, i_records);
+        while (p_records[j].p_ptr != NULL)
+            j = (j + 1) & (i_records - 1);
+        p_records[j] = *p_record;
+    }
+
+    free(dvbpsi_mem.p_records);
+    dvbpsi_mem.p_records = p_records;
+    dvbpsi_mem.i_records = i_records;
+    dvbpsi_mem.i_used = dvbpsi_mem.i_live;
+    return true;
+}
+
+/* Records a new block, which stays unaccounted for if memory is short */
+static void dvbpsi_mem_record(const void *p_ptr, size_t i_size,
+                              dvbpsi_mem_category_t i_category)
+{
+    assert(i_category < DVBPSI_MEM_CATEGORY_MAX);
+    dvbpsi_mem_lock();
+    if (4 * (dvbpsi_mem.i_used + 1) > 3 * dvbpsi_mem.i_records
+     && !dvbpsi_mem_rehash())
+    {
+        dvbpsi_mem_unlock();
+        return;
+    }
+
+    size_t i = dvbpsi_mem_hash(p_ptr, dvbpsi_mem.i_records);
+    while (dvbpsi_mem.p_records[i].p_ptr != NULL
+        && dvbpsi_mem.p_records[i].p_ptr != DVBPSI_MEM_DELETED)
+        i = (i + 1) & (dvbpsi_mem.i_records - 1);
+
+    if (dvbpsi_mem.p_records[i].p_ptr == NULL)
+        dvbpsi_mem.i_used++;
+    dvbpsi_mem.p_records[i].p_ptr = p_ptr;
+    dvbpsi_mem.p_records[i].i_size = i_size;
+    dvbpsi_mem.p_records[i].i_category = i_category;
+    dvbpsi_mem.i_live++;
+    dvbpsi_mem.stats.i_bytes[i_category] += i_size;
+    dvbpsi_mem.stats.i_count[i_category]++;
+    dvbpsi_mem_unlock();
+}
+
+/* Forgets a block about to be freed */
+static void dvbpsi_mem_forget(const void *p_ptr)
+{
+    dvbpsi_mem_lock();
+    dvbpsi_mem_record_t *p_record = dvbpsi_mem_find(p_ptr);
+    if (p_record)
+    {
+        dvbpsi_mem.stats.i_bytes[p_record->i_category] -= p_record->i_size;
+        dvbpsi_mem.stats.i_count[p_record->i_category]--;
+        p_record->p_ptr = DVBPSI_MEM_DELETED;
+        dvbpsi_mem.i_live--;
+    }
+    dvbpsi_mem_unlock();
+}
+
+/*****************************************************************************
+ * dvbpsi_mem_tag
+ *****************************************************************************/
+void dvbpsi_mem_tag(const void *p_ptr, dvbpsi_mem_category_t i_category)
+{
+    assert(i_category < DVBPSI_MEM_CATEGORY_MAX);
+    dvbpsi_mem_lock();
+    dvbpsi_mem_record_t *p_record = p_ptr ? dvbpsi_mem_find(p_ptr) : NULL;
+    if (p_record && p_record->i_category != i_category)
+    {
+        dvbpsi_mem.stats.i_bytes[p_record->i_category] -= p_record->i_size;
+        dvbpsi_mem.stats.i_count[p_record->i_category]--;
+        dvbpsi_mem.stats.i_bytes[i_category] += p_record->i_size;
+        dvbpsi_mem.stats.i_count[i_category]++;
+        p_record->i_category = i_category;
+    }
+    dvbpsi_mem_unlock();
+}
+#endif
+
+/*****************************************************************************
+ * dvbpsi_mem_stats
+ *****************************************************************************/
+bool dvbpsi_mem_stats(dvbpsi_mem_stats_t *p_stats)
+{
+    assert(p_stats);
+#ifdef DVBPSI_MEM_STATS
+    dvbpsi_mem_lock();
+    *p_stats = dvbpsi_mem.stats;
+    dvbpsi_mem_unlock();
+    return true;
+#else
+    memset(p_stats, 0, sizeof(dvbpsi_mem_stats_t));
+    return false;
+#endif
+}
+
+/*****************************************************************************
+ * dvbpsi_mem_category_name
+ *****************************************************************************/
+const char *dvbpsi_mem_category_name(dvbpsi_mem_category_t i_category)
+{
+    static const char * const ppsz_names[DVBPSI_MEM_CATEGORY_MAX] =
+    {
+        [DVBPSI_MEM_SECTION]      = "section",
+        [DVBPSI_MEM_SECTION_LIST] = "section_list",
+        [DVBPSI_MEM_TABLE]        = "table",
+        [DVBPSI_MEM_DESCRIPTOR]   = "descriptor",
+        [DVBPSI_MEM_DECODED_DR]   = "decoded_dr",
+        [DVBPSI_MEM_DECODER]      = "decoder",
+        [DVBPSI_MEM_POOL]         = "pool",
+        [DVBPSI_MEM_OTHER]        = "other",
+    };
+
+    if ((unsigned int)i_category >= DVBPSI_MEM_CATEGORY_MAX)
+        return "unknown";
+    return ppsz_names[i_category];
+}
+
+/*****************************************************************************
+ * Table arenas
+ *****************************************************************************
+ * An arena is a list of chunks, bump allocated and freed all at once. The
+ * arena structure itself lives in its first chunk. The arena entered with
+ * dvbpsi_arena_enter() serves dvbpsi_malloc() and dvbpsi_calloc() of the
+ * running thread, and dvbpsi_free() ignores the memory it owns.
+ *****************************************************************************/
+#define DVBPSI_ARENA_ALIGN      16
+#define DVBPSI_ARENA_ROUND(x)   (((x) + DVBPSI_ARENA_ALIGN - 1) & ~(size_t)(DVBPSI_ARENA_ALIGN - 1))
+#define DVBPSI_ARENA_CHUNK      4096
+#define DVBPSI_ARENA_CHUNK_MAX  65536
+
+typedef struct dvbpsi_arena_chunk_s
+{
+    struct dvbpsi_arena_chunk_s *p_next;
+    uint8_t                     *p_start;   /* first usable byte */
+    uint8_t                     *p_end;     /* end of the chunk */
+    uint8_t                     *p_free;    /* first unallocated byte */
+} dvbpsi_arena_chunk_t;
+
+struct dvbpsi_arena_s
+{
+    dvbpsi_arena_chunk_t *p_chunks;         /* newest first */
+    size_t                i_chunk_size;     /* size of the next chunk */
+};
+
+#define DVBPSI_ARENA_CHUNK_HEADER DVBPSI_ARENA_ROUND(sizeof(dvbpsi_arena_chunk_t))
+
+#if defined(HAVE_THREAD_LOCAL)
+static __thread dvbpsi_arena_t *dvbpsi_arena_current = NULL;
+#else
+/* Without thread local storage no arena is ever entered */
+static dvbpsi_arena_t * const dvbpsi_arena_current = NULL;
+#endif
+
+static dvbpsi_arena_chunk_t *dvbpsi_arena_chunk_new(size_t i_size)
+{
+    dvbpsi_arena_chunk_t *p_chunk = dvbpsi_allocator.pf_malloc(i_size, dvbpsi_allocator.p_data);
+    if (p_chunk == NULL)
+        return NULL;
+#ifdef DVBPSI_MEM_STATS
+    dvbpsi_mem_record(p_chunk, i_size, DVBPSI_MEM_TABLE);
+#endif
+
+    p_chunk->p_next = NULL;
+    p_chunk->p_start = (uint8_t *)p_chunk + DVBPSI_ARENA_CHUNK_HEADER;
+    p_chunk->p_end = (uint8_t *)p_chunk + i_size;
+    p_chunk->p_free = p_chunk->p_start;
+    return p_chunk;
+}
+
+/*****************************************************************************
+ * dvbpsi_arena_new
+ *****************************************************************************/
+dvbpsi_arena_t *dvbpsi_arena_new(void)
+{
+#if defined(HAVE_THREAD_LOCAL)
+    dvbpsi_arena_chunk_t *p_chunk = dvbpsi_arena_chunk_new(DVBPSI_ARENA_CHUNK);
+    if (p_chunk == NULL)
+        return NULL;
+
+    dvbpsi_arena_t *p_arena = (dvbpsi_arena_t *)p_chunk->p_start;
+    p_chunk->p_start += DVBPSI_ARENA_ROUND(sizeof(dvbpsi_arena_t));
+    p_chunk->p_free = p_chunk->p_start;
+
+    p_arena->p_chunks = p_chunk;
+    p_arena->i_chunk_size = 2 * DVBPSI_ARENA_CHUNK;
+    return p_arena;
+#else
+    return NULL;
+#endif
+}
+
+/*****************************************************************************
+ * dvbpsi_arena_delete
+ *****************************************************************************/
+void dvbpsi_arena_delete(dvbpsi_arena_t *p_arena)
+{
+    if (p_arena == NULL)
+        return;
+
+    /* The first chunk, holding the arena, is the last of the list */
+    dvbpsi_arena_chunk_t *p_chunk = p_arena->p_chunks;
+    while (p_chunk)
+    {
+        dvbpsi_arena_chunk_t *p_next = p_chunk->p_next;
+#ifdef DVBPSI_MEM_STATS
+        dvbpsi_mem_forget(p_chunk);
+#endif
+        dvbpsi_allocator.pf_free(p_chunk, dvbpsi_allocator.p_data);
+        p_chunk = p_next;
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_arena_alloc
+ *****************************************************************************/
+void *dvbpsi_arena_alloc(dvbpsi_arena_t *p_arena, size_t i_size)
+{
+    assert(p_arena);
+
+    if (i_size > SIZE_MAX - DVBPSI_ARENA_CHUNK_HEADER - DVBPSI_ARENA_ALIGN)
+        return NULL;
+    i_size = DVBPSI_ARENA_ROUND(i_size ? i_size : 1);
+
+    dvbpsi_arena_chunk_t *p_chunk = p_arena->p_chunks;
+    if ((size_t)(p_chunk->p_end - p_chunk->p_free) < i_size)
+    {
+        size_t i_chunk_size = p_arena->i_chunk_size;
+        if (i_chunk_size < DVBPSI_ARENA_CHUNK_MAX)
+            p_arena->i_chunk_size *= 2;
+        if (i_chunk_size < DVBPSI_ARENA_CHUNK_HEADER + i_size)
+            i_chunk_size = DVBPSI_ARENA_CHUNK_HEADER + i_size;
+
+        p_chunk = dvbpsi_arena_chunk_new(i_chunk_size);
+        if (p_chunk == NULL)
+            return NULL;
+        p_chunk->p_next = p_arena->p_chunks;
+        p_arena->p_chunks = p_chunk;
+    }
+
+    void *p_ptr = p_chunk->p_free;
+    p_chunk->p_free += i_size;
+    return p_ptr;
+}
+
+/*****************************************************************************
+ * dvbpsi_arena_owns
+ *****************************************************************************/
+bool dvbpsi_arena_owns(const dvbpsi_arena_t *p_arena, const void *p_ptr)
+{
+    const uint8_t *p = (const uint8_t *)p_ptr;
+    for (const dvbpsi_arena_chunk_t *p_chunk = p_arena->p_chunks;
+         p_chunk; p_chunk = p_chunk->p_next)
+    {
+        if (p >= (const uint8_t *)p_chunk && p < p_chunk->p_end)
+            return true;
+    }
+    return false;
+}
+
+/*****************************************************************************
+ * dvbpsi_arena_merge
+ *****************************************************************************
+ * The chunks go after the newest chunk of p_arena, which keeps serving the
+ * allocations. The structure of p_other stays in its first chunk, unused.
+ *****************************************************************************/
+void dvbpsi_arena_merge(dvbpsi_arena_t *p_arena, dvbpsi_arena_t *p_other)
+{
+    assert(p_arena && p_other && p_arena != p_other);
+
+    dvbpsi_arena_chunk_t *p_first = p_other->p_chunks;
+    dvbpsi_arena_chunk_t *p_last = p_first;
+    while (p_last->p_next)
+        p_last = p_last->p_next;
+
+    p_last->p_next = p_arena->p_chunks->p_next;
+    p_arena->p_chunks->p_next = p_first;
+}
+
+/*****************************************************************************
+ * dvbpsi_arena_enter
+ *****************************************************************************/
+dvbpsi_arena_t *dvbpsi_arena_enter(dvbpsi_arena_t *p_arena)
+{
+#if defined(HAVE_THREAD_LOCAL)
+    dvbpsi_arena_t *p_previous = dvbpsi_arena_current;
+    dvbpsi_arena_current = p_arena;
+    return p_previous;
+#else
+    assert(p_arena == NULL);
+    return NULL;
+#endif
+}
+
+/*****************************************************************************
+ * dvbpsi_arena_table_new
+ *****************************************************************************/
+dvbpsi_arena_t *dvbpsi_arena_table_new(const dvbpsi_t *p_dvbpsi)
+{
+    if (!(p_dvbpsi->i_flags & (DVBPSI_FLAG_TABLE_ARENA | DVBPSI_FLAG_TABLE_ARRAYS)))
+        return NULL;
+
+    return dvbpsi_arena_new();
+}
+
+/*****************************************************************************
+ * Handle and decoder pools
+ *****************************************************************************
+ * The pool entered with dvbpsi_pool_enter() keeps the handles, decoders and
+ * demux subtable decoders deleted by the running thread, by kind and size,
+ * for dvbpsi_new(), dvbpsi_decoder_new() and dvbpsi_NewDemuxSubDecoder() to
+ * reuse. An idle object is linked through its first bytes. A handle keeps
+ * its section pool and a decoder its section index.
+ *****************************************************************************/
+#define DVBPSI_POOL_CLASSES     16
+
+typedef struct dvbpsi_pool_block_s
+{
+    struct dvbpsi_pool_block_s *p_next;
+} dvbpsi_pool_block_t;
+
+typedef struct dvbpsi_pool_class_s
+{
+    dvbpsi_pool_kind_t   i_kind;
+    size_t               i_size;
+    dvbpsi_pool_block_t *p_first;
+} dvbpsi_pool_class_t;
+
+struct dvbpsi_pool_s
+{
+    unsigned int         i_max;
+    unsigned int         i_classes;
+    dvbpsi_pool_class_t  classes[DVBPSI_POOL_CLASSES];
+    dvbpsi_pool_stats_t  stats;
+};
+
+#if defined(HAVE_THREAD_LOCAL)
+static __thread dvbpsi_pool_t *dvbpsi_pool_current = NULL;
+#else
+/* Without thread local storage no pool is ever entered */
+static dvbpsi_pool_t * const dvbpsi_pool_current = NULL;
+#endif
+
+/*****************************************************************************
+ * dvbpsi_pool_new
+ *****************************************************************************/
+dvbpsi_pool_t *dvbpsi_pool_new(unsigned int i_max)
+{
+#if defined(HAVE_THREAD_LOCAL)
+    dvbpsi_pool_t *p_pool = dvbpsi_calloc(1, sizeof(dvbpsi_pool_t));
+    if (p_pool == NULL)
+        return NULL;
+
+    p_pool->i_max = i_max;
+    return p_pool;
+#else
+    (void)i_max;
+    return NULL;
+#endif
+}
+
+/*****************************************************************************
+ * dvbpsi_pool_delete
+ *****************************************************************************/
+void dvbpsi_pool_delete(dvbpsi_pool_t *p_pool)
+{
+    if (p_pool == NULL)
+        return;
+
+    assert(dvbpsi_pool_current != p_pool);
+    for (unsigned int i = 0; i < p_pool->i_classes; i++)
+    {
+        dvbpsi_pool_class_t *p_class = &p_pool->classes[i];
+        while (p_class->p_first)
+        {
+            dvbpsi_pool_block_t *p_block = p_class->p_first;
+            p_class->p_first = p_block->p_next;
+
+            if (p_class->i_kind == DVBPSI_POOL_HANDLE)
+                dvbpsi_section_pool_delete(((dvbpsi_t *)p_block)->p_pool);
+            else if (p_class->i_kind == DVBPSI_POOL_DECODER)
+                dvbpsi_free(((dvbpsi_decoder_t *)p_block)->p_section_index);
+            dvbpsi_free(p_block);
+        }
+    }
+    dvbpsi_free(p_pool);
+}
+
+/*****************************************************************************
+ * dvbpsi_pool_enter
+ *****************************************************************************/
+dvbpsi_pool_t *dvbpsi_pool_enter(dvbpsi_pool_t *p_pool)
+{
+#if defined(HAVE_THREAD_LOCAL)
+    dvbpsi_pool_t *p_previous = dvbpsi_pool_current;
+    dvbpsi_pool_current = p_pool;
+    return p_previous;
+#else
+    assert(p_pool == NULL);
+    return NULL;
+#endif
+}
+
+/*****************************************************************************
+ * dvbpsi_pool_get_stats
+ *****************************************************************************/
+void dvbpsi_pool_get_stats(const dvbpsi_pool_t *p_pool, dvbpsi_pool_stats_t *p_stats)
+{
+    assert(p_pool);
+    assert(p_stats);
+    *p_stats = p_pool->stats;
+}
+
+/*****************************************************************************
+ * dvbpsi_pool_take
+ *****************************************************************************/
+void *dvbpsi_pool_take(dvbpsi_pool_kind_t i_kind, size_t i_size)
+{
+    dvbpsi_pool_t *p_pool = dvbpsi_pool_current;
+    if (p_pool == NULL)
+        return NULL;
+
+    for (unsigned int i = 0; i < p_pool->i_classes; i++)
+    {
+        dvbpsi_pool_class_t *p_class = &p_pool->classes[i];
+        if (p_class->i_kind != i_kind || p_class->i_size != i_size)
+            continue;
+
+        dvbpsi_pool_block_t *p_block = p_class->p_first;
+        if (p_block == NULL)
+            break;
+        p_class->p_first = p_block->p_next;
+        p_pool->stats.i_idle--;
+        p_pool->stats.i_reused++;
+        return p_block;
+    }
+    p_pool->stats.i_allocated++;
+    return NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_pool_give
+ *****************************************************************************/
+bool dvbpsi_pool_give(dvbpsi_pool_kind_t i_kind, void *p_ptr, size_t i_size)
+{
+    dvbpsi_pool_t *p_pool = dvbpsi_pool_current;
+    if (p_pool == NULL || p_pool->stats.i_idle >= p_pool->i_max)
+        return false;
+
+    /* Memory of the table arena of the thread is not the pool's to keep */
+    if (dvbpsi_arena_current && dvbpsi_arena_owns(dvbpsi_arena_current, p_ptr))
+        return false;
+
+    unsigned int i = 0;
+    for (; i < p_pool->i_classes; i++)
+        if (p_pool->classes[i].i_kind == i_kind && p_pool->classes[i].i_size == i_size)
+            break;
+    if (i == p_pool->i_classes)
+    {
+        if (i == DVBPSI_POOL_CLASSES)
+            return false;
+        p_pool->classes[i].i_kind = i_kind;
+        p_pool->classes[i].i_size = i_size;
+        p_pool->classes[i].p_first = NULL;
+        p_pool->i_classes++;
+    }
+
+    dvbpsi_pool_block_t *p_block = (dvbpsi_pool_block_t *)p_ptr;
+    p_block->p_next = p_pool->classes[i].p_first;
+    p_pool->classes[i].p_first = p_block;
+    p_pool->stats.i_idle++;
+    dvbpsi_mem_tag(p_block, DVBPSI_MEM_POOL);
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_set_allocator
+ *****************************************************************************/
+bool dvbpsi_set_allocator(const dvbpsi_allocator_t *p_allocator)
+{
+    if (p_allocator == NULL)
+    {
+        dvbpsi_allocator.pf_malloc = dvbpsi_libc_malloc;
+        dvbpsi_allocator.pf_calloc = dvbpsi_libc_calloc;
+        dvbpsi_allocator.pf_free   = dvbpsi_libc_free;
+        dvbpsi_allocator.p_data    = NULL;
+        return true;
+    }
+
+    if (p_allocator->pf_malloc == NULL || p_allocator->pf_free == NULL)
+        return false;
+
+    dvbpsi_allocator = *p_allocator;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_malloc
+ *****************************************************************************
+ * The name is in parentheses, here and for dvbpsi_calloc(), so as not to be
+ * replaced by the macro of an instrumented library.
+ *****************************************************************************/
+void *(dvbpsi_malloc)(size_t i_size)
+{
+    if (dvbpsi_arena_current)
+        return dvbpsi_arena_alloc(dvbpsi_arena_current, i_size);
+
+    return dvbpsi_allocator.pf_malloc(i_size, dvbpsi_allocator.p_data);
+}
+
+/*****************************************************************************
+ * dvbpsi_calloc
+ *****************************************************************************/
+void *(dvbpsi_calloc)(size_t i_count, size_t i_size)
+{
+    if (dvbpsi_arena_current)
+    {
+        if (i_size && i_count > SIZE_MAX / i_size)
+            return NULL;
+
+        void *p_ptr = dvbpsi_arena_alloc(dvbpsi_arena_current, i_count * i_size);
+        if (p_ptr)
+            memset(p_ptr, 0, i_count * i_size);
+        return p_ptr;
+    }
+
+    if (dvbpsi_allocator.pf_calloc)
+        return dvbpsi_allocator.pf_calloc(i_count, i_size, dvbpsi_allocator.p_data);
+
+    if (i_size && i_count > SIZE_MAX / i_size)
+        return NULL;
+
+    void *p_ptr = dvbpsi_allocator.pf_malloc(i_count * i_size, dvbpsi_allocator.p_data);
+    if (p_ptr)
+        memset(p_ptr, 0, i_count * i_size);
+    return p_ptr;
+}
+
+/*****************************************************************************
+ * dvbpsi_free
+ *****************************************************************************/
+void dvbpsi_free(void *p_ptr)
+{
+    if (p_ptr == NULL)
+        return;
+
+    /* Released with the whole arena */
+    if (dvbpsi_arena_current && dvbpsi_arena_owns(dvbpsi_arena_current, p_ptr))
+        return;
+
+#ifdef DVBPSI_MEM_STATS
+    dvbpsi_mem_forget(p_ptr);
+#endif
+    dvbpsi_allocator.pf_free(p_ptr, dvbpsi_allocator.p_data);
+}
+
+#ifdef DVBPSI_MEM_STATS
+/*****************************************************************************
+ * dvbpsi_malloc_as
+ *****************************************************************************
+ * Memory of the table arena is counted by chunk.
+ *****************************************************************************/
+void *dvbpsi_malloc_as(size_t i_size, dvbpsi_mem_category_t i_category)
+{
+    void *p_ptr = (dvbpsi_malloc)(i_size);
+    if (p_ptr && !dvbpsi_arena_current)
+        dvbpsi_mem_record(p_ptr, i_size, i_category);
+    return p_ptr;
+}
+
+/*****************************************************************************
+ * dvbpsi_calloc_as
+ *****************************************************************************/
+void *dvbpsi_calloc_as(size_t i_count, size_t i_size, dvbpsi_mem_category_t i_category)
+{
+    void *p_ptr = (dvbpsi_calloc)(i_count, i_size);
+    if (p_ptr && !dvbpsi_arena_current)
+        dvbpsi_mem_record(p_ptr, i_count * i_size, i_category);
+    return p_ptr;
+}
+#endif
 
 /*****************************************************************************
  * dvbpsi_new
  *****************************************************************************/
 dvbpsi_t *dvbpsi_new(dvbpsi_message_cb callback, enum dvbpsi_msg_level level)
 {
-    dvbpsi_t *p_dvbpsi = calloc(1, sizeof(dvbpsi_t));
-    if (p_dvbpsi == NULL)
-        return NULL;
+    /* A pooled handle is reset, keeping its section pool */
+    dvbpsi_t *p_dvbpsi = dvbpsi_pool_take(DVBPSI_POOL_HANDLE, sizeof(dvbpsi_t));
+    if (p_dvbpsi)
+    {
+        dvbpsi_mem_tag(p_dvbpsi, DVBPSI_MEM_CATEGORY);
+        struct dvbpsi_section_pool_s *p_pool = p_dvbpsi->p_pool;
+        memset(p_dvbpsi, 0, sizeof(dvbpsi_t));
+        p_dvbpsi->p_pool = p_pool;
+    }
+    else
+    {
+        p_dvbpsi = dvbpsi_calloc(1, sizeof(dvbpsi_t));
+        if (p_dvbpsi == NULL)
+            return NULL;
+
+        p_dvbpsi->p_pool = dvbpsi_section_pool_new();
+        if (p_dvbpsi->p_pool == NULL)
+        {
+            dvbpsi_free(p_dvbpsi);
+            return NULL;
+        }
+    }
 
     p_dvbpsi->p_decoder  = NULL;
     p_dvbpsi->pf_message = callback;
     p_dvbpsi->i_msg_level = level;
+    p_dvbpsi->i_time = DVBPSI_TIME_NONE;
+    p_dvbpsi->i_packet_format = DVBPSI_PACKET_TS;
+    p_dvbpsi->i_ats_time = DVBPSI_TIME_NONE;
+
+    dvbpsi_crc32_init();
     return p_dvbpsi;
 }
 
@@ -67,25 +793,345 @@ void dvbpsi_delete(dvbpsi_t *p_dvbpsi)
 {
     if (p_dvbpsi) {
         assert(p_dvbpsi->p_decoder == NULL);
+        assert(p_dvbpsi->p_pull == NULL);
         p_dvbpsi->pf_message = NULL;
+        dvbpsi_encoder_cache_delete(p_dvbpsi->p_encoder_cache);
+        p_dvbpsi->p_encoder_cache = NULL;
+        dvbpsi_free(p_dvbpsi->p_latency);
+        p_dvbpsi->p_latency = NULL;
+        if (dvbpsi_pool_give(DVBPSI_POOL_HANDLE, p_dvbpsi, sizeof(dvbpsi_t)))
+            return;
+        dvbpsi_section_pool_delete(p_dvbpsi->p_pool);
+        p_dvbpsi->p_pool = NULL;
+    }
+    dvbpsi_free(p_dvbpsi);
+}
+
+/*****************************************************************************
+ * dvbpsi_set_flags
+ *****************************************************************************/
+void dvbpsi_set_flags(dvbpsi_t *p_dvbpsi, uint32_t i_flags)
+{
+    assert(p_dvbpsi);
+    p_dvbpsi->i_flags = i_flags;
+    dvbpsi_section_pool_set_compact(p_dvbpsi->p_pool, i_flags & DVBPSI_FLAG_COMPACT);
+    dvbpsi_section_pool_set_keep_last(p_dvbpsi->p_pool, i_flags & DVBPSI_FLAG_LAST_SECTIONS);
+}
+
+/*****************************************************************************
+ * dvbpsi_get_flags
+ *****************************************************************************/
+uint32_t dvbpsi_get_flags(dvbpsi_t *p_dvbpsi)
+{
+    assert(p_dvbpsi);
+    return p_dvbpsi->i_flags;
+}
+
+/*****************************************************************************
+ * dvbpsi_set_verify_interval
+ *****************************************************************************/
+void dvbpsi_set_verify_interval(dvbpsi_t *p_dvbpsi, unsigned int i_interval)
+{
+    assert(p_dvbpsi);
+    p_dvbpsi->i_verify_interval = i_interval;
+}
+
+/*****************************************************************************
+ * dvbpsi_get_crc_cache_stats
+ *****************************************************************************/
+void dvbpsi_get_crc_cache_stats(dvbpsi_t *p_dvbpsi, uint64_t *pi_hits,
+                                uint64_t *pi_misses)
+{
+    assert(p_dvbpsi);
+    if (pi_hits)
+        *pi_hits = p_dvbpsi->i_crc_cache_hits;
+    if (pi_misses)
+        *pi_misses = p_dvbpsi->i_crc_cache_misses;
+}
+
+/*****************************************************************************
+ * dvbpsi_set_section_filter
+ *****************************************************************************/
+void dvbpsi_set_section_filter(dvbpsi_t *p_dvbpsi,
+                               const dvbpsi_section_filter_t *p_filter)
+{
+    assert(p_dvbpsi);
+    p_dvbpsi->b_section_filter = (p_filter != NULL);
+    if (p_filter)
+        p_dvbpsi->section_filter = *p_filter;
+}
+
+/*****************************************************************************
+ * dvbpsi_set_eit_window
+ *****************************************************************************/
+void dvbpsi_set_eit_window(dvbpsi_t *p_dvbpsi, const dvbpsi_eit_window_t *p_window)
+{
+    assert(p_dvbpsi);
+    p_dvbpsi->b_eit_window = (p_window != NULL);
+    if (p_window)
+        p_dvbpsi->eit_window = *p_window;
+}
+
+/*****************************************************************************
+ * dvbpsi_eit_window_init
+ *****************************************************************************/
+void dvbpsi_eit_window_init(dvbpsi_eit_window_t *p_window, int64_t i_utc,
+                            unsigned int i_hours)
+{
+    assert(p_window);
+
+    /* Seconds since 00:00 UTC */
+    int64_t i_day = i_utc % 86400;
+    if (i_day < 0)
+        i_day += 86400;
+
+    p_window->i_first_segment = i_day / 10800;
+    int64_t i_last = (i_day + (int64_t)i_hours * 3600) / 10800;
+    p_window->i_last_segment = i_last > 511 ? 511 : i_last;
+}
+
+/*****************************************************************************
+ * dvbpsi_table_priority
+ *****************************************************************************/
+dvbpsi_priority_t dvbpsi_table_priority(uint8_t i_table_id)
+{
+    switch (i_table_id)
+    {
+        case 0x00: /* PAT */
+        case 0x01: /* CAT */
+        case 0x02: /* PMT */
+        case 0x70: /* TDT */
+        case 0x73: /* TOT */
+        case 0xcd: /* ATSC STT */
+            return DVBPSI_PRIORITY_CRITICAL;
+        case 0x40: /* NIT */
+        case 0x41:
+        case 0x42: /* SDT */
+        case 0x46:
+        case 0x4e: /* EIT present/following */
+        case 0x4f:
+        case 0xc7: /* ATSC MGT */
+        case 0xc8: /* ATSC VCT */
+        case 0xc9:
+            return DVBPSI_PRIORITY_NORMAL;
+        default:
+            return DVBPSI_PRIORITY_SHEDDABLE;
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_set_shed_level, dvbpsi_get_shed_level
+ *****************************************************************************/
+void dvbpsi_set_shed_level(dvbpsi_t *p_dvbpsi, dvbpsi_shed_level_t i_level)
+{
+    assert(p_dvbpsi);
+    assert(i_level <= DVBPSI_SHED_NORMAL);
+    p_dvbpsi->i_shed_level = i_level;
+}
+
+dvbpsi_shed_level_t dvbpsi_get_shed_level(const dvbpsi_t *p_dvbpsi)
+{
+    assert(p_dvbpsi);
+    return p_dvbpsi->i_shed_level;
+}
+
+/*****************************************************************************
+ * dvbpsi_shed_level_update
+ *****************************************************************************
+ * Thresholds of 50 and 75% going up, 25 and 50% going down.
+ *****************************************************************************/
+dvbpsi_shed_level_t dvbpsi_shed_level_update(dvbpsi_shed_level_t i_level,
+                                             unsigned int i_backlog)
+{
+    if (i_backlog >= 75)
+        return DVBPSI_SHED_NORMAL;
+    if (i_backlog >= 50)
+        return i_level == DVBPSI_SHED_NORMAL ? DVBPSI_SHED_NORMAL
+                                             : DVBPSI_SHED_SHEDDABLE;
+    if (i_backlog >= 25)
+        return i_level == DVBPSI_SHED_NONE ? DVBPSI_SHED_NONE
+                                           : DVBPSI_SHED_SHEDDABLE;
+    return DVBPSI_SHED_NONE;
+}
+
+/*****************************************************************************
+ * dvbpsi_set_packet_format
+ *****************************************************************************/
+void dvbpsi_set_packet_format(dvbpsi_t *p_dvbpsi, dvbpsi_packet_format_t i_format)
+{
+    assert(p_dvbpsi);
+    assert(i_format <= DVBPSI_PACKET_RS);
+    p_dvbpsi->i_packet_format = i_format;
+    p_dvbpsi->i_ats_time = DVBPSI_TIME_NONE;
+}
+
+/*****************************************************************************
+ * dvbpsi_get_packet_size
+ *****************************************************************************/
+size_t dvbpsi_get_packet_size(dvbpsi_packet_format_t i_format)
+{
+    switch (i_format)
+    {
+        case DVBPSI_PACKET_M2TS: return 192;
+        case DVBPSI_PACKET_RS:   return 204;
+        default:                 return 188;
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_m2ts_time
+ *****************************************************************************
+ * Arrival time stamp of an M2TS packet, unwrapped to 64 bits.
+ *****************************************************************************/
+static int64_t dvbpsi_m2ts_time(dvbpsi_t *p_dvbpsi, const uint8_t *p_unit)
+{
+    uint32_t i_ats = ((uint32_t)(p_unit[0] & 0x3f) << 24) | ((uint32_t)p_unit[1] << 16)
+                   | ((uint32_t)p_unit[2] << 8) | p_unit[3];
+
+    if (p_dvbpsi->i_ats_time == DVBPSI_TIME_NONE)
+        p_dvbpsi->i_ats_time = i_ats;
+    else
+        p_dvbpsi->i_ats_time += (i_ats - p_dvbpsi->i_ats_last) & 0x3fffffff;
+    p_dvbpsi->i_ats_last = i_ats;
+
+    return p_dvbpsi->i_ats_time;
+}
+
+/*****************************************************************************
+ * dvbpsi_get_stats
+ *****************************************************************************/
+void dvbpsi_get_stats(dvbpsi_t *p_dvbpsi, dvbpsi_stats_t *p_stats)
+{
+    assert(p_dvbpsi);
+    assert(p_stats);
+
+    uint64_t i_allocations, i_copied;
+    dvbpsi_section_pool_counters(p_dvbpsi->p_pool, &i_allocations, &i_copied);
+
+    *p_stats = p_dvbpsi->stats;
+    p_stats->i_allocations += i_allocations;
+    p_stats->i_bytes_copied += i_copied;
+}
+
+/*****************************************************************************
+ * dvbpsi_get_latency_histogram
+ *****************************************************************************/
+bool dvbpsi_get_latency_histogram(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                                  uint64_t pi_buckets[DVBPSI_LATENCY_BUCKETS])
+{
+    assert(p_dvbpsi);
+
+    if (p_dvbpsi->p_latency == NULL)
+        return false;
+
+    memcpy(pi_buckets, p_dvbpsi->p_latency->pi_buckets[i_table_id],
+           DVBPSI_LATENCY_BUCKETS * sizeof(uint64_t));
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_latency_record
+ *****************************************************************************
+ * Adds the decoding latency of a table to the table_id histogram.
+ *****************************************************************************/
+static void dvbpsi_latency_record(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                                  int64_t i_arrival)
+{
+    if (p_dvbpsi->p_latency == NULL)
+    {
+        p_dvbpsi->p_latency = dvbpsi_calloc(1, sizeof(dvbpsi_latency_t));
+        if (p_dvbpsi->p_latency == NULL)
+            return;
     }
-    free(p_dvbpsi);
+
+    uint64_t i_latency = (p_dvbpsi->i_time > i_arrival)
+                       ? (uint64_t)(p_dvbpsi->i_time - i_arrival) : 0;
+    p_dvbpsi->p_latency->pi_buckets[i_table_id][dvbpsi_latency_bucket(i_latency)]++;
+}
+
+/*****************************************************************************
+ * dvbpsi_set_event_cb
+ *****************************************************************************/
+void dvbpsi_set_event_cb(dvbpsi_t *p_dvbpsi, dvbpsi_event_cb pf_event,
+                         void *p_cb_data)
+{
+    assert(p_dvbpsi);
+    p_dvbpsi->pf_event = pf_event;
+    p_dvbpsi->p_event_data = p_cb_data;
+}
+
+/*****************************************************************************
+ * dvbpsi_set_section_tap
+ *****************************************************************************/
+void dvbpsi_set_section_tap(dvbpsi_t *p_dvbpsi, dvbpsi_section_tap_cb pf_tap,
+                            void *p_cb_data)
+{
+    assert(p_dvbpsi);
+    p_dvbpsi->pf_section_tap = pf_tap;
+    p_dvbpsi->p_section_tap_data = p_cb_data;
+}
+
+/*****************************************************************************
+ * dvbpsi_set_changelog
+ *****************************************************************************/
+void dvbpsi_set_changelog(dvbpsi_t *p_dvbpsi, dvbpsi_changelog_t *p_log)
+{
+    assert(p_dvbpsi);
+    p_dvbpsi->p_changelog = p_log;
+}
+
+/*****************************************************************************
+ * dvbpsi_get_event_count
+ *****************************************************************************/
+uint64_t dvbpsi_get_event_count(dvbpsi_t *p_dvbpsi, dvbpsi_event_type_t i_type)
+{
+    assert(p_dvbpsi);
+    assert(i_type < DVBPSI_EVENT_MAX);
+    return p_dvbpsi->i_events[i_type];
 }
 
 /*****************************************************************************
  * dvbpsi_decoder_new
  *****************************************************************************/
 #define DVBPSI_INVALID_CC (0xFF)
+
+/* Numbers every decoder allocated, so that one reusing the address of a
+ * deleted decoder, as the pool makes likely, is still told apart */
+static unsigned int dvbpsi_decoder_generation = 0;
+
+#ifdef __ATOMIC_RELAXED
+#   define DECODER_GENERATION_NEXT() \
+        __atomic_add_fetch(&dvbpsi_decoder_generation, 1, __ATOMIC_RELAXED)
+#else
+#   define DECODER_GENERATION_NEXT() (++dvbpsi_decoder_generation)
+#endif
+
 void *dvbpsi_decoder_new(dvbpsi_callback_gather_t pf_gather,
     const int i_section_max_size, const bool b_discontinuity, const size_t psi_size)
 {
     assert(psi_size >= sizeof(dvbpsi_decoder_t));
 
-    dvbpsi_decoder_t *p_decoder = (dvbpsi_decoder_t *) calloc(1, psi_size);
-    if (p_decoder == NULL)
-        return NULL;
+    /* A pooled decoder is reset, keeping its section index */
+    dvbpsi_decoder_t *p_decoder = dvbpsi_pool_take(DVBPSI_POOL_DECODER, psi_size);
+    if (p_decoder)
+    {
+        dvbpsi_mem_tag(p_decoder, DVBPSI_MEM_CATEGORY);
+        struct dvbpsi_section_index_s *p_index = p_decoder->p_section_index;
+        memset(p_decoder, 0, psi_size);
+        p_decoder->p_section_index = p_index;
+        if (p_index)
+            memset(p_index->pi_received, 0, sizeof(p_index->pi_received));
+    }
+    else
+    {
+        p_decoder = (dvbpsi_decoder_t *) dvbpsi_calloc(1, psi_size);
+        if (p_decoder == NULL)
+            return NULL;
+    }
 
     memcpy(&p_decoder->i_magic[0], "psi", 3);
+    p_decoder->i_psi_size = psi_size;
+    p_decoder->i_generation = DECODER_GENERATION_NEXT();
     p_decoder->pf_gather = pf_gather;
     p_decoder->p_current_section = NULL;
     p_decoder->i_section_max_size = i_section_max_size;
@@ -98,48 +1144,289 @@ void *dvbpsi_decoder_new(dvbpsi_callback_gather_t pf_gather,
     p_decoder->p_sections = NULL;
     p_decoder->b_complete_header = false;
 
-    return p_decoder;
+    return p_decoder;
+}
+
+/*****************************************************************************
+ * dvbpsi_decoder_reset
+ *****************************************************************************/
+void dvbpsi_decoder_reset(dvbpsi_decoder_t* p_decoder, const bool b_force)
+{
+    assert(p_decoder);
+
+    /* Force redecoding */
+    if (b_force)
+    {
+        p_decoder->b_current_valid = false;
+        p_decoder->b_known = false;
+    }
+
+    /* Clear the section array, a compact decoder also drops its index
+     * until it gets several sections again */
+    bool b_compact = p_decoder->p_sections
+                  && dvbpsi_section_pool_is_compact(p_decoder->p_sections->p_pool);
+    dvbpsi_DeletePSISections(p_decoder->p_sections);
+    p_decoder->p_sections = NULL;
+    if (b_compact)
+    {
+        dvbpsi_free(p_decoder->p_section_index);
+        p_decoder->p_section_index = NULL;
+    }
+    else if (p_decoder->p_section_index)
+        memset(p_decoder->p_section_index->pi_received, 0,
+               sizeof(p_decoder->p_section_index->pi_received));
+}
+
+/*****************************************************************************
+ * dvbpsi_decoder_psi_sections_completed
+ *****************************************************************************/
+bool dvbpsi_decoder_psi_sections_completed(dvbpsi_decoder_t* p_decoder)
+{
+    assert(p_decoder);
+
+    bool b_complete = false;
+    dvbpsi_section_index_t *p_index = p_decoder->p_section_index;
+
+    if (p_index && p_decoder->p_sections)
+    {
+        /* Sections 0 up to i_last_section_number have been received */
+        unsigned int i_last = p_decoder->i_last_section_number;
+        unsigned int i_word = 0;
+
+        b_complete = true;
+        for (; i_word < i_last / 64; i_word++)
+            if (p_index->pi_received[i_word] != UINT64_MAX)
+                b_complete = false;
+
+        uint64_t i_mask = (i_last % 64 == 63) ? UINT64_MAX
+                                              : (UINT64_C(1) << (i_last % 64 + 1)) - 1;
+        if ((p_index->pi_received[i_word] & i_mask) != i_mask)
+            b_complete = false;
+    }
+    else
+    {
+        dvbpsi_psi_section_t *p = p_decoder->p_sections;
+        unsigned int prev_nr = 0;
+        while (p)
+        {
+            assert(prev_nr < 256);
+            if (prev_nr != p->i_number)
+                break;
+            if (p_decoder->i_last_section_number == p->i_number)
+                b_complete = true;
+            p = p->p_next;
+            prev_nr++;
+        }
+    }
+
+    if (b_complete)
+        dvbpsi_decoder_psi_sections_known(p_decoder);
+
+    return b_complete;
+}
+
+/*****************************************************************************
+ * dvbpsi_last_sections_same
+ *****************************************************************************
+ * Whether two lists of sections have the same bytes, which is down to their
+ * CRC_32 once the header is known to match.
+ *****************************************************************************/
+static bool dvbpsi_last_sections_same(const dvbpsi_psi_section_t *p_a,
+                                      const dvbpsi_psi_section_t *p_b)
+{
+    for (; p_a && p_b; p_a = p_a->p_next, p_b = p_b->p_next)
+    {
+        if (p_a->i_table_id != p_b->i_table_id || p_a->i_extension != p_b->i_extension
+         || p_a->i_version != p_b->i_version || p_a->i_number != p_b->i_number
+         || p_a->i_length != p_b->i_length
+         || memcmp(p_a->p_data + p_a->i_length - 1, p_b->p_data + p_b->i_length - 1, 4))
+            return false;
+    }
+    return p_a == NULL && p_b == NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_last_sections_keep
+ *****************************************************************************
+ * DVBPSI_FLAG_LAST_SECTIONS copy of the sections of the table just
+ * completed. A repetition of the same table keeps the previous copy.
+ *****************************************************************************/
+static void dvbpsi_last_sections_keep(dvbpsi_decoder_t *p_decoder)
+{
+    if (dvbpsi_last_sections_same(p_decoder->p_sections, p_decoder->p_last_sections))
+        return;
+
+    dvbpsi_psi_section_t *p_first = NULL, **pp_last = &p_first;
+    for (dvbpsi_psi_section_t *p = p_decoder->p_sections; p; p = p->p_next)
+    {
+        dvbpsi_psi_section_t *p_copy = dvbpsi_section_pool_copy(p);
+        if (p_copy == NULL)
+        {
+            /* an incomplete table is of no use to a joining client */
+            dvbpsi_DeletePSISections(p_first);
+            return;
+        }
+        *pp_last = p_copy;
+        pp_last = &p_copy->p_next;
+    }
+
+    dvbpsi_DeletePSISections(p_decoder->p_last_sections);
+    p_decoder->p_last_sections = p_first;
+}
+
+/*****************************************************************************
+ * dvbpsi_decoder_psi_sections_known
+ *****************************************************************************/
+void dvbpsi_decoder_psi_sections_known(dvbpsi_decoder_t* p_decoder)
+{
+    assert(p_decoder);
+
+    dvbpsi_psi_section_t *p_section = p_decoder->p_sections;
+    if (p_section == NULL || !p_section->b_syntax_indicator)
+    {
+        p_decoder->b_known = false;
+        return;
+    }
+
+    p_decoder->b_known = true;
+    p_decoder->i_known_table_id = p_section->i_table_id;
+    p_decoder->i_known_extension = p_section->i_extension;
+    p_decoder->i_known_version = p_section->i_version;
+    p_decoder->b_known_current_next = p_section->b_current_next;
+    p_decoder->i_known_skipped = 0;
+
+    /* DVBPSI_FLAG_LAST_SECTIONS */
+    if (p_section->b_current_next && dvbpsi_section_pool_keeps_last(p_section->p_pool))
+        dvbpsi_last_sections_keep(p_decoder);
+
+    /* DVBPSI_FLAG_CRC_CACHE */
+    dvbpsi_crc_cache_t *p_cache = p_decoder->p_crc_cache;
+    if (p_cache == NULL)
+        return;
+
+    memset(p_cache->pi_valid, 0, sizeof(p_cache->pi_valid));
+    for (; p_section; p_section = p_section->p_next)
+    {
+        if (!dvbpsi_has_CRC32(p_section))
+            continue;
+
+        const uint8_t *p_crc = p_section->p_payload_end;
+        p_cache->pi_crc[p_section->i_number] = ((uint32_t)p_crc[0] << 24)
+                                             | ((uint32_t)p_crc[1] << 16)
+                                             | ((uint32_t)p_crc[2] << 8) | p_crc[3];
+        p_cache->pi_valid[p_section->i_number >> 3] |= 1 << (p_section->i_number & 7);
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_section_index_set
+ *****************************************************************************/
+static inline void dvbpsi_section_index_set(dvbpsi_section_index_t *p_index,
+                                            dvbpsi_psi_section_t *p_section)
+{
+    p_index->ap_sections[p_section->i_number] = p_section;
+    p_index->pi_received[p_section->i_number / 64]
+                                |= UINT64_C(1) << (p_section->i_number % 64);
+}
+
+/*****************************************************************************
+ * dvbpsi_section_index_new
+ *****************************************************************************
+ * Indexes the sections of an existing (ordered) list.
+ *****************************************************************************/
+static dvbpsi_section_index_t *dvbpsi_section_index_new(dvbpsi_psi_section_t *p_sections)
+{
+    dvbpsi_section_index_t *p_index = dvbpsi_calloc(1, sizeof(dvbpsi_section_index_t));
+    if (p_index == NULL)
+        return NULL;
+
+    for (; p_sections; p_sections = p_sections->p_next)
+        dvbpsi_section_index_set(p_index, p_sections);
+
+    return p_index;
 }
 
 /*****************************************************************************
- * dvbpsi_decoder_reset
+ * dvbpsi_section_index_prev
+ *****************************************************************************
+ * Received section with the highest section_number below i_number, or NULL.
  *****************************************************************************/
-void dvbpsi_decoder_reset(dvbpsi_decoder_t* p_decoder, const bool b_force)
+static dvbpsi_psi_section_t *dvbpsi_section_index_prev(dvbpsi_section_index_t *p_index,
+                                                       unsigned int i_number)
 {
-    assert(p_decoder);
+    int i_word = i_number / 64;
+    uint64_t i_bits = p_index->pi_received[i_word]
+                    & ((UINT64_C(1) << (i_number % 64)) - 1);
 
-    /* Force redecoding */
-    if (b_force)
-        p_decoder->b_current_valid = false;
+    while (i_bits == 0)
+    {
+        if (--i_word < 0)
+            return NULL;
+        i_bits = p_index->pi_received[i_word];
+    }
 
-    /* Clear the section array */
-    dvbpsi_DeletePSISections(p_decoder->p_sections);
-    p_decoder->p_sections = NULL;
+#if defined(__GNUC__)
+    int i_bit = 63 - __builtin_clzll(i_bits);
+#else
+    int i_bit = 63;
+    while (!(i_bits & (UINT64_C(1) << i_bit)))
+        i_bit--;
+#endif
+    return p_index->ap_sections[i_word * 64 + i_bit];
 }
 
 /*****************************************************************************
- * dvbpsi_decoder_psi_sections_completed
+ * dvbpsi_section_index_add
+ *****************************************************************************
+ * Inserts or replaces a section in the indexed p_sections list.
  *****************************************************************************/
-bool dvbpsi_decoder_psi_sections_completed(dvbpsi_decoder_t* p_decoder)
+static bool dvbpsi_section_index_add(dvbpsi_decoder_t *p_decoder,
+                                     dvbpsi_psi_section_t *p_section)
 {
-    assert(p_decoder);
-
-    bool b_complete = false;
+    dvbpsi_section_index_t *p_index = p_decoder->p_section_index;
+    uint8_t i_number = p_section->i_number;
+    bool b_overwrite = p_index->pi_received[i_number / 64]
+                                & (UINT64_C(1) << (i_number % 64));
+    dvbpsi_psi_section_t *p_prev = dvbpsi_section_index_prev(p_index, i_number);
+    dvbpsi_psi_section_t **pp_link = p_prev ? &p_prev->p_next : &p_decoder->p_sections;
 
-    dvbpsi_psi_section_t *p = p_decoder->p_sections;
-    unsigned int prev_nr = 0;
-    while (p)
+    if (b_overwrite)
     {
-        assert(prev_nr < 256);
-        if (prev_nr != p->i_number)
-            break;
-        if (p_decoder->i_last_section_number == p->i_number)
-            b_complete = true;
-        p = p->p_next;
-        prev_nr++;
+        /* Replace */
+        dvbpsi_psi_section_t *p_old = p_index->ap_sections[i_number];
+        assert(*pp_link == p_old);
+        p_section->p_next = p_old->p_next;
+        p_old->p_next = NULL;
+        dvbpsi_DeletePSISections(p_old);
+    }
+    else
+    {
+        /* Insert after p_prev */
+        p_section->p_next = *pp_link;
     }
 
-    return b_complete;
+    *pp_link = p_section;
+    dvbpsi_section_index_set(p_index, p_section);
+    return b_overwrite;
+}
+
+/*****************************************************************************
+ * dvbpsi_decoder_psi_section_single
+ *****************************************************************************/
+bool dvbpsi_decoder_psi_section_single(dvbpsi_decoder_t *p_decoder, dvbpsi_psi_section_t *p_section)
+{
+    assert(p_decoder);
+    assert(p_section);
+
+    if (p_decoder->p_sections || p_section->i_number != 0 || p_section->i_last_number != 0)
+        return false;
+
+    /* No list to build nor index to fill in */
+    p_section->p_next = NULL;
+    p_decoder->i_last_section_number = 0;
+    p_decoder->p_sections = p_section;
+    dvbpsi_decoder_psi_sections_known(p_decoder);
+    return true;
 }
 
 /*****************************************************************************
@@ -151,14 +1438,37 @@ bool dvbpsi_decoder_psi_section_add(dvbpsi_decoder_t *p_decoder, dvbpsi_psi_sect
     assert(p_section);
     assert(p_section->p_next == NULL);
 
+    /* The section has to outlive the TS packet */
+    if (p_section->b_borrowed)
+    {
+        p_section = dvbpsi_section_pool_copy(p_section);
+        if (!p_section)
+            return false;
+    }
+
+#ifdef DVBPSI_MEM_STATS
+    /* The section now waits for the rest of its table */
+    dvbpsi_mem_tag(p_section, DVBPSI_MEM_SECTION_LIST);
+    if (p_section->p_data != (uint8_t *)(p_section + 1))
+        dvbpsi_mem_tag(p_section->p_data, DVBPSI_MEM_SECTION_LIST);
+#endif
+
     /* Empty list */
     if (!p_decoder->p_sections)
     {
         p_decoder->p_sections = p_section;
         p_section->p_next = NULL;
+        if (p_decoder->p_section_index)
+            dvbpsi_section_index_set(p_decoder->p_section_index, p_section);
         return false;
     }
 
+    /* Index the list once it holds more than one section */
+    if (!p_decoder->p_section_index)
+        p_decoder->p_section_index = dvbpsi_section_index_new(p_decoder->p_sections);
+    if (p_decoder->p_section_index)
+        return dvbpsi_section_index_add(p_decoder, p_section);
+
     /* Insert in right place */
     dvbpsi_psi_section_t *p = p_decoder->p_sections;
     dvbpsi_psi_section_t *p_prev = NULL;
@@ -215,45 +1525,743 @@ bool dvbpsi_decoder_psi_section_add(dvbpsi_decoder_t *p_decoder, dvbpsi_psi_sect
         p_section->p_next = NULL;
     }
 
-out:
-    return b_overwrite;
+out:
+    return b_overwrite;
+}
+
+/*****************************************************************************
+ * dvbpsi_decoder_delete
+ *****************************************************************************/
+void dvbpsi_decoder_delete(dvbpsi_decoder_t *p_decoder)
+{
+    assert(p_decoder);
+
+    if (p_decoder->p_sections)
+    {
+        dvbpsi_DeletePSISections(p_decoder->p_sections);
+        p_decoder->p_sections = NULL;
+    }
+
+    dvbpsi_DeletePSISections(p_decoder->p_current_section);
+    p_decoder->p_current_section = NULL;
+    dvbpsi_free(p_decoder->p_crc_cache);
+    p_decoder->p_crc_cache = NULL;
+    dvbpsi_dr_cache_delete(p_decoder->p_dr_cache);
+    p_decoder->p_dr_cache = NULL;
+    dvbpsi_free(p_decoder->p_repetitions);
+    p_decoder->p_repetitions = NULL;
+    dvbpsi_DeletePSISections(p_decoder->p_last_sections);
+    p_decoder->p_last_sections = NULL;
+    if (p_decoder->i_psi_size
+     && dvbpsi_pool_give(DVBPSI_POOL_DECODER, p_decoder, p_decoder->i_psi_size))
+        return;
+    dvbpsi_free(p_decoder->p_section_index);
+    dvbpsi_free(p_decoder);
+}
+
+/*****************************************************************************
+ * dvbpsi_decoder_present
+ *****************************************************************************/
+bool dvbpsi_decoder_present(dvbpsi_t *p_dvbpsi)
+{
+    if (p_dvbpsi && p_dvbpsi->p_decoder)
+        return true;
+    else
+        return false;
+}
+
+/*****************************************************************************
+ * dvbpsi_section_owner
+ *****************************************************************************
+ * Decoder a section is meant for: the demux hands sections over to its
+ * subtable decoders. NULL if there is none yet.
+ *****************************************************************************/
+static inline dvbpsi_decoder_t *dvbpsi_section_owner(dvbpsi_decoder_t *p_decoder,
+                                                     uint8_t i_table_id,
+                                                     uint16_t i_extension)
+{
+    if (p_decoder->pf_gather == dvbpsi_Demux)
+    {
+        dvbpsi_demux_subdec_t *p_subdec
+                = dvbpsi_demuxGetSubDec((dvbpsi_demux_t *)p_decoder,
+                                        i_table_id, i_extension);
+        return p_subdec ? p_subdec->p_decoder : NULL;
+    }
+
+    return p_decoder;
+}
+
+/*****************************************************************************
+ * dvbpsi_get_repetition
+ *****************************************************************************/
+bool dvbpsi_get_repetition(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                           uint16_t i_extension, uint8_t i_number,
+                           dvbpsi_repetition_t *p_repetition)
+{
+    assert(p_dvbpsi);
+    assert(p_repetition);
+
+    if (p_dvbpsi->p_decoder == NULL)
+        return false;
+
+    dvbpsi_decoder_t *p_owner = dvbpsi_section_owner(p_dvbpsi->p_decoder,
+                                                     i_table_id, i_extension);
+    if (p_owner == NULL || p_owner->p_repetitions == NULL
+        || p_owner->p_repetitions->repetition[i_number].i_last == DVBPSI_TIME_NONE)
+        return false;
+
+    *p_repetition = p_owner->p_repetitions->repetition[i_number];
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_get_last_sections
+ *****************************************************************************/
+const dvbpsi_psi_section_t *dvbpsi_get_last_sections(dvbpsi_t *p_dvbpsi,
+                                                     uint8_t i_table_id,
+                                                     uint16_t i_extension)
+{
+    assert(p_dvbpsi);
+
+    if (p_dvbpsi->p_decoder == NULL)
+        return NULL;
+
+    dvbpsi_decoder_t *p_owner = dvbpsi_section_owner(p_dvbpsi->p_decoder,
+                                                     i_table_id, i_extension);
+    if (p_owner == NULL || p_owner->p_last_sections == NULL
+     || p_owner->p_last_sections->i_table_id != i_table_id)
+        return NULL;
+
+    return p_owner->p_last_sections;
+}
+
+/*****************************************************************************
+ * dvbpsi_repetition_record
+ *****************************************************************************
+ * Adds a copy of section i_number arrived at i_arrival to the
+ * DVBPSI_FLAG_REPETITION intervals of its subtable decoder.
+ *****************************************************************************/
+static void dvbpsi_repetition_record(dvbpsi_decoder_t *p_owner, uint8_t i_number,
+                                     int64_t i_arrival)
+{
+    if (i_arrival == DVBPSI_TIME_NONE)
+        return;
+
+    if (p_owner->p_repetitions == NULL)
+    {
+        p_owner->p_repetitions = dvbpsi_malloc(sizeof(dvbpsi_repetitions_t));
+        if (p_owner->p_repetitions == NULL)
+            return;
+        for (unsigned int i = 0; i < 256; i++)
+            p_owner->p_repetitions->repetition[i] = (dvbpsi_repetition_t) {
+                .i_last = DVBPSI_TIME_NONE,
+            };
+    }
+
+    dvbpsi_repetition_t *p_repetition = &p_owner->p_repetitions->repetition[i_number];
+    if (p_repetition->i_last != DVBPSI_TIME_NONE && i_arrival >= p_repetition->i_last)
+    {
+        uint64_t i_interval = i_arrival - p_repetition->i_last;
+        if (p_repetition->i_count == 0 || i_interval < p_repetition->i_min)
+            p_repetition->i_min = i_interval;
+        if (i_interval > p_repetition->i_max)
+            p_repetition->i_max = i_interval;
+        p_repetition->i_total += i_interval;
+        p_repetition->i_count++;
+    }
+    p_repetition->i_last = i_arrival;
+}
+
+/*****************************************************************************
+ * dvbpsi_section_repeated
+ *****************************************************************************
+ * DVBPSI_FLAG_REPETITION measure of a valid section starting at p_data,
+ * whose 8 header bytes are available.
+ *****************************************************************************/
+static void dvbpsi_section_repeated(dvbpsi_decoder_t *p_decoder,
+                                    const uint8_t *p_data, int64_t i_arrival)
+{
+    bool b_syntax = p_data[1] & 0x80;
+    uint16_t i_extension = b_syntax ? ((uint16_t)p_data[3] << 8) | p_data[4] : 0;
+    dvbpsi_decoder_t *p_owner = dvbpsi_section_owner(p_decoder, p_data[0],
+                                                     i_extension);
+    if (p_owner)
+        dvbpsi_repetition_record(p_owner, b_syntax ? p_data[6] : 0, i_arrival);
+}
+
+/*****************************************************************************
+ * dvbpsi_fingerprint_init
+ *****************************************************************************/
+void dvbpsi_fingerprint_init(dvbpsi_fingerprint_t *p_fingerprint)
+{
+    assert(p_fingerprint);
+    memset(p_fingerprint, 0, sizeof(dvbpsi_fingerprint_t));
+}
+
+/*****************************************************************************
+ * dvbpsi_set_fingerprint
+ *****************************************************************************/
+void dvbpsi_set_fingerprint(dvbpsi_t *p_dvbpsi, dvbpsi_fingerprint_t *p_fingerprint)
+{
+    assert(p_dvbpsi);
+    p_dvbpsi->p_fingerprint = p_fingerprint;
+}
+
+/*****************************************************************************
+ * dvbpsi_fingerprint_hash
+ *****************************************************************************
+ * Hash of a section and its CRC_32, the finalizer of splitmix64.
+ *****************************************************************************/
+static inline uint64_t dvbpsi_fingerprint_hash(uint32_t i_key, uint32_t i_crc)
+{
+    uint64_t i_hash = ((uint64_t)i_key << 32) | i_crc;
+    i_hash = (i_hash ^ (i_hash >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    i_hash = (i_hash ^ (i_hash >> 27)) * UINT64_C(0x94d049bb133111eb);
+    return i_hash ^ (i_hash >> 31);
+}
+
+/*****************************************************************************
+ * dvbpsi_fingerprint_find
+ *****************************************************************************
+ * Slot of a section in the open addressing table of a fingerprint: the one
+ * holding it, or the empty one where it would go. -1 if neither exists.
+ *****************************************************************************/
+static int dvbpsi_fingerprint_find(const dvbpsi_fingerprint_t *p_fingerprint,
+                                   uint32_t i_key)
+{
+    unsigned int i_slot = ((i_key * UINT32_C(0x9e3779b1)) >> 16) % DVBPSI_FINGERPRINT_SIZE;
+    for (unsigned int i = 0; i < DVBPSI_FINGERPRINT_SIZE; i++)
+    {
+        uint32_t i_stored = p_fingerprint->pi_key[i_slot];
+        if (i_stored == i_key || i_stored == 0)
+            return i_slot;
+        i_slot = (i_slot + 1) % DVBPSI_FINGERPRINT_SIZE;
+    }
+    return -1;
+}
+
+/*****************************************************************************
+ * dvbpsi_fingerprint_record
+ *****************************************************************************
+ * Updates a fingerprint with a section of i_length bytes after the
+ * section_length field, ending with a valid CRC_32.
+ *****************************************************************************/
+static void dvbpsi_fingerprint_record(dvbpsi_fingerprint_t *p_fingerprint,
+                                      const uint8_t *p_data, unsigned int i_length)
+{
+    /* 0 marks an empty slot, 0xff is not a valid table_id */
+    if (p_data[0] == 0xff || i_length < 4)
+        return;
+
+    uint32_t i_key = (uint32_t)p_data[0] << 24;
+    if ((p_data[1] & 0x80) && i_length >= 9)
+        i_key |= ((uint32_t)p_data[3] << 16) | ((uint32_t)p_data[4] << 8) | p_data[6];
+    i_key++;
+
+    const uint8_t *p_crc = p_data + 3 + i_length - 4;
+    uint32_t i_crc = ((uint32_t)p_crc[0] << 24) | ((uint32_t)p_crc[1] << 16)
+                   | ((uint32_t)p_crc[2] << 8) | p_crc[3];
+
+    int i_slot = dvbpsi_fingerprint_find(p_fingerprint, i_key);
+    if (i_slot < 0)
+    {
+        p_fingerprint->i_overflow++;
+        return;
+    }
+
+    if (p_fingerprint->pi_key[i_slot] == 0)
+    {
+        p_fingerprint->pi_key[i_slot] = i_key;
+        p_fingerprint->i_sections++;
+    }
+    else if (p_fingerprint->pi_crc[i_slot] == i_crc)
+        return;
+    else
+        p_fingerprint->i_hash -= dvbpsi_fingerprint_hash(i_key, p_fingerprint->pi_crc[i_slot]);
+
+    p_fingerprint->pi_crc[i_slot] = i_crc;
+    p_fingerprint->i_hash += dvbpsi_fingerprint_hash(i_key, i_crc);
+    p_fingerprint->i_changes++;
+}
+
+/*****************************************************************************
+ * dvbpsi_fingerprint_equal
+ *****************************************************************************/
+bool dvbpsi_fingerprint_equal(const dvbpsi_fingerprint_t *p_a,
+                              const dvbpsi_fingerprint_t *p_b)
+{
+    assert(p_a);
+    assert(p_b);
+    return p_a->i_sections == p_b->i_sections && p_a->i_hash == p_b->i_hash;
+}
+
+/*****************************************************************************
+ * dvbpsi_fingerprint_compare
+ *****************************************************************************/
+unsigned int dvbpsi_fingerprint_compare(const dvbpsi_fingerprint_t *p_a,
+                                        const dvbpsi_fingerprint_t *p_b)
+{
+    assert(p_a);
+    assert(p_b);
+
+    unsigned int i_common = 0;
+    for (unsigned int i = 0; i < DVBPSI_FINGERPRINT_SIZE; i++)
+    {
+        uint32_t i_key = p_a->pi_key[i];
+        if (i_key == 0)
+            continue;
+
+        int i_slot = dvbpsi_fingerprint_find(p_b, i_key);
+        if (i_slot >= 0 && p_b->pi_key[i_slot] == i_key
+            && p_b->pi_crc[i_slot] == p_a->pi_crc[i])
+            i_common++;
+    }
+    return i_common;
+}
+
+/*****************************************************************************
+ * dvbpsi_section_cached
+ *****************************************************************************
+ * DVBPSI_FLAG_CRC_CACHE lookup of an assembled section.
+ *****************************************************************************/
+static bool dvbpsi_section_cached(dvbpsi_t *p_dvbpsi, dvbpsi_decoder_t *p_decoder,
+                                  dvbpsi_psi_section_t *p_section)
+{
+    const uint8_t *p_data = p_section->p_data;
+
+    /* section_number and CRC_32 */
+    if (!(p_data[1] & 0x80) || p_section->i_length < 9)
+        return false;
+
+    dvbpsi_decoder_t *p_owner = dvbpsi_section_owner(p_decoder, p_data[0],
+                                                     ((uint16_t)p_data[3] << 8) | p_data[4]);
+    if (p_owner == NULL)
+        return false;
+
+    if (p_owner->p_crc_cache == NULL)
+    {
+        /* Filled in when the next table gets complete */
+        p_owner->p_crc_cache = dvbpsi_calloc(1, sizeof(dvbpsi_crc_cache_t));
+        p_dvbpsi->i_crc_cache_misses++;
+        return false;
+    }
+
+    dvbpsi_crc_cache_t *p_cache = p_owner->p_crc_cache;
+    const uint8_t *p_crc = p_data + 3 + p_section->i_length - 4;
+    uint32_t i_crc = ((uint32_t)p_crc[0] << 24) | ((uint32_t)p_crc[1] << 16)
+                   | ((uint32_t)p_crc[2] << 8) | p_crc[3];
+    uint8_t i_number = p_data[6];
+
+    if ((p_cache->pi_valid[i_number >> 3] & (1 << (i_number & 7)))
+        && p_cache->pi_crc[i_number] == i_crc)
+    {
+        p_dvbpsi->i_crc_cache_hits++;
+        return true;
+    }
+
+    p_dvbpsi->i_crc_cache_misses++;
+    return false;
+}
+
+/*****************************************************************************
+ * dvbpsi_section_known
+ *****************************************************************************
+ * Tells if the section starting at p_pos (8 header bytes available) belongs
+ * to the table version already decoded by the decoder it is meant for, in
+ * which case that decoder would drop it.
+ *****************************************************************************/
+static bool dvbpsi_section_known(dvbpsi_t *p_dvbpsi, dvbpsi_decoder_t *p_decoder,
+                                 const uint8_t *p_pos)
+{
+    uint8_t i_table_id = p_pos[0];
+    uint16_t i_extension = ((uint16_t)p_pos[3] << 8) | p_pos[4];
+
+    /* No version to compare with */
+    if (!(p_pos[1] & 0x80))
+        return false;
+
+    dvbpsi_decoder_t *p_owner = dvbpsi_section_owner(p_decoder, i_table_id,
+                                                     i_extension);
+    if (p_owner == NULL)
+        return false;
+
+    if (   !p_owner->b_known || !p_owner->b_current_valid
+        || p_owner->p_sections != NULL
+        || p_decoder->b_discontinuity || p_owner->b_discontinuity
+        || p_owner->i_known_table_id != i_table_id
+        || p_owner->i_known_extension != i_extension
+        || p_owner->i_known_version != ((p_pos[5] & 0x3e) >> 1)
+        || p_owner->b_known_current_next != (p_pos[5] & 0x1))
+        return false;
+
+    /* Fully check one of them from time to time */
+    if (p_dvbpsi->i_verify_interval
+        && ++p_owner->i_known_skipped >= p_dvbpsi->i_verify_interval)
+    {
+        p_owner->i_known_skipped = 0;
+        return false;
+    }
+
+    /* The skipped copy still counts as a repetition */
+    if (p_dvbpsi->i_flags & DVBPSI_FLAG_REPETITION)
+        dvbpsi_repetition_record(p_owner, p_pos[6], p_dvbpsi->i_time);
+
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_section_filtered
+ *****************************************************************************
+ * True when the i_size bytes of section header at p_pos are enough to tell
+ * that the section does not match the handle's section filter, or is an
+ * EIT schedule section out of its window. Called when either is set.
+ *****************************************************************************/
+static inline bool dvbpsi_section_filtered(const dvbpsi_t *p_dvbpsi,
+                                           const uint8_t *p_pos, size_t i_size)
+{
+    const dvbpsi_section_filter_t *p_filter = &p_dvbpsi->section_filter;
+
+    if (p_dvbpsi->b_eit_window && p_pos[0] >= 0x50 && p_pos[0] <= 0x6f && i_size >= 7)
+    {
+        unsigned int i_segment = (p_pos[0] & 0x0f) * 32u + p_pos[6] / 8u;
+        if (i_segment < p_dvbpsi->eit_window.i_first_segment
+         || i_segment > p_dvbpsi->eit_window.i_last_segment)
+            return true;
+    }
+
+    if (!p_dvbpsi->b_section_filter)
+        return false;
+
+    if ((p_pos[0] ^ p_filter->i_table_id) & p_filter->i_table_id_mask)
+        return true;
+
+    if (p_filter->i_extension_mask == 0 || i_size < 5 || !(p_pos[1] & 0x80))
+        return false;
+
+    uint16_t i_extension = ((uint16_t)p_pos[3] << 8) | p_pos[4];
+    return ((i_extension ^ p_filter->i_extension) & p_filter->i_extension_mask) != 0;
+}
+
+/*****************************************************************************
+ * dvbpsi_section_shed
+ *****************************************************************************
+ * True when the section of table_id i_table_id is dropped by the handle's
+ * shed level.
+ *****************************************************************************/
+static inline bool dvbpsi_section_shed(const dvbpsi_t *p_dvbpsi, uint8_t i_table_id)
+{
+    return p_dvbpsi->i_shed_level != DVBPSI_SHED_NONE
+        && (int)dvbpsi_table_priority(i_table_id)
+           > DVBPSI_PRIORITY_SHEDDABLE - (int)p_dvbpsi->i_shed_level;
+}
+
+/*****************************************************************************
+ * dvbpsi_section_start
+ *****************************************************************************
+ * Takes a section for the one starting at p_pos. When the 3 header bytes are
+ * in the packet the section is sized from its section_length, otherwise it
+ * only holds the header and is grown by dvbpsi_section_grow().
+ * With DVBPSI_FLAG_ZERO_COPY a section ending in the packet is borrowed: its
+ * p_data points to p_pos and nothing gets copied. A skipped section is
+ * borrowed as well, its p_data is only valid for the header.
+ *****************************************************************************/
+static inline dvbpsi_psi_section_t *dvbpsi_section_start(dvbpsi_t *p_dvbpsi,
+                                                         dvbpsi_decoder_t *p_decoder,
+                                                         uint16_t i_pid,
+                                                         uint8_t *p_pos,
+                                                         const uint8_t *p_end)
+{
+    dvbpsi_psi_section_t *p_section;
+    int i_size = 3;
+
+    p_decoder->b_skip_section = false;
+    dvbpsi_probe2(section__start, i_pid, p_end > p_pos ? p_pos[0] : 0xff);
+
+    if (p_end - p_pos >= 3)
+    {
+        i_size += ((uint16_t)(p_pos[1] & 0xf)) << 8 | p_pos[2];
+        /* Too long, rejected once the header is complete */
+        if (i_size > p_decoder->i_section_max_size)
+            i_size = 3;
+        else if ((p_dvbpsi->b_section_filter || p_dvbpsi->b_eit_window)
+                 && dvbpsi_section_filtered(p_dvbpsi, p_pos, p_end - p_pos))
+        {
+            /* Walk over the section without storing it */
+            p_dvbpsi->stats.i_dropped_filtered++;
+            dvbpsi_probe3(section__dropped, i_pid, p_pos[0], "filtered");
+            p_decoder->b_skip_section = true;
+            return dvbpsi_section_pool_borrow(p_dvbpsi->p_pool, p_pos, i_size);
+        }
+        else if (dvbpsi_section_shed(p_dvbpsi, p_pos[0]))
+        {
+            /* Walk over the section without storing it */
+            p_dvbpsi->stats.i_dropped_shed++;
+            dvbpsi_probe3(section__dropped, i_pid, p_pos[0], "shed");
+            p_decoder->b_skip_section = true;
+            return dvbpsi_section_pool_borrow(p_dvbpsi->p_pool, p_pos, i_size);
+        }
+        else if ((p_dvbpsi->i_flags & DVBPSI_FLAG_SKIP_UNCHANGED)
+                 && p_end - p_pos >= 8 && p_dvbpsi->p_pool
+                 && dvbpsi_section_known(p_dvbpsi, p_decoder, p_pos))
+        {
+            /* Walk over the section without storing it */
+            p_dvbpsi->stats.i_dropped_unchanged++;
+            dvbpsi_probe3(section__dropped, i_pid, p_pos[0], "unchanged");
+            p_decoder->b_skip_section = true;
+            return dvbpsi_section_pool_borrow(p_dvbpsi->p_pool, p_pos, i_size);
+        }
+        else if ((p_dvbpsi->i_flags & DVBPSI_FLAG_ZERO_COPY)
+                 && i_size <= p_end - p_pos && p_dvbpsi->p_pool)
+        {
+            p_section = dvbpsi_section_pool_borrow(p_dvbpsi->p_pool, p_pos, i_size);
+            p_section->i_arrival = p_dvbpsi->i_time;
+            return p_section;
+        }
+    }
+
+    p_section = dvbpsi_section_pool_get(p_dvbpsi->p_pool, i_size);
+    if (p_section)
+        p_section->i_arrival = p_dvbpsi->i_time;
+    return p_section;
 }
 
 /*****************************************************************************
- * dvbpsi_decoder_delete
+ * dvbpsi_section_grow
+ *****************************************************************************
+ * Moves the header of p_section to a section able to hold the whole section
+ * once its length is known.
  *****************************************************************************/
-void dvbpsi_decoder_delete(dvbpsi_decoder_t *p_decoder)
+static dvbpsi_psi_section_t *dvbpsi_section_grow(dvbpsi_t *p_dvbpsi,
+                                                 dvbpsi_psi_section_t *p_section)
 {
-    assert(p_decoder);
-
-    if (p_decoder->p_sections)
+    dvbpsi_psi_section_t *p_grown
+        = dvbpsi_section_pool_get(p_dvbpsi->p_pool, p_section->i_length + 3);
+    if (p_grown)
     {
-        dvbpsi_DeletePSISections(p_decoder->p_sections);
-        p_decoder->p_sections = NULL;
+        memcpy(p_grown->p_data, p_section->p_data, 3);
+        p_dvbpsi->stats.i_bytes_copied += 3;
+        p_grown->i_arrival = p_section->i_arrival;
+        p_grown->p_payload_end = p_grown->p_data + 3;
+        p_grown->i_length = p_section->i_length;
     }
 
-    dvbpsi_DeletePSISections(p_decoder->p_current_section);
-    free(p_decoder);
+    dvbpsi_DeletePSISections(p_section);
+    return p_grown;
 }
 
 /*****************************************************************************
- * dvbpsi_decoder_present
+ * dvbpsi_section_complete
+ *****************************************************************************
+ * Checks a fully assembled section and hands it to the decoder.
  *****************************************************************************/
-bool dvbpsi_decoder_present(dvbpsi_t *p_dvbpsi)
+static void dvbpsi_section_complete(dvbpsi_t *p_dvbpsi, dvbpsi_decoder_t *p_decoder,
+                                    dvbpsi_psi_section_t *p_section, uint16_t i_pid)
 {
-    if (p_dvbpsi && p_dvbpsi->p_decoder)
-        return true;
+    bool b_valid_crc32 = false;
+    bool has_crc32;
+
+    p_dvbpsi->stats.i_sections++;
+
+    /* Header straddled two packets, it could not be filtered earlier */
+    if ((p_dvbpsi->b_section_filter || p_dvbpsi->b_eit_window)
+        && dvbpsi_section_filtered(p_dvbpsi, p_section->p_data,
+                                   p_section->p_payload_end - p_section->p_data))
+    {
+        p_dvbpsi->stats.i_dropped_filtered++;
+        dvbpsi_probe3(section__dropped, i_pid, p_section->p_data[0], "filtered");
+        dvbpsi_DeletePSISections(p_section);
+        return;
+    }
+    if (dvbpsi_section_shed(p_dvbpsi, p_section->p_data[0]))
+    {
+        p_dvbpsi->stats.i_dropped_shed++;
+        dvbpsi_probe3(section__dropped, i_pid, p_section->p_data[0], "shed");
+        dvbpsi_DeletePSISections(p_section);
+        return;
+    }
+
+    /* Same bytes as in the last decoded table */
+    if ((p_dvbpsi->i_flags & DVBPSI_FLAG_CRC_CACHE)
+        && dvbpsi_section_cached(p_dvbpsi, p_decoder, p_section))
+    {
+        if (p_dvbpsi->pf_section_tap)
+            p_dvbpsi->pf_section_tap(p_dvbpsi->p_section_tap_data, i_pid,
+                                     p_section->i_arrival, p_section->p_data,
+                                     p_section->i_length + 3);
+        if (p_dvbpsi->i_flags & DVBPSI_FLAG_REPETITION)
+            dvbpsi_section_repeated(p_decoder, p_section->p_data, p_section->i_arrival);
+        if (p_dvbpsi->p_fingerprint)
+            dvbpsi_fingerprint_record(p_dvbpsi->p_fingerprint, p_section->p_data,
+                                      p_section->i_length);
+        p_dvbpsi->stats.i_dropped_unchanged++;
+        dvbpsi_probe3(section__dropped, i_pid, p_section->p_data[0], "unchanged");
+        dvbpsi_DeletePSISections(p_section);
+        return;
+    }
+
+    p_section->i_table_id = p_section->p_data[0];
+    p_section->b_syntax_indicator = p_section->p_data[1] & 0x80;
+    p_section->b_private_indicator = p_section->p_data[1] & 0x40;
+
+    /* Update the end of the payload if CRC_32 is present */
+    has_crc32 = dvbpsi_has_CRC32(p_section);
+    if (p_section->b_syntax_indicator || has_crc32)
+        p_section->p_payload_end -= 4;
+
+    /* Check CRC32 if present */
+    if (has_crc32)
+        b_valid_crc32 = dvbpsi_ValidPSISection(p_section);
+
+    if (!has_crc32 || b_valid_crc32)
+    {
+        if (b_valid_crc32 && p_dvbpsi->p_fingerprint)
+            dvbpsi_fingerprint_record(p_dvbpsi->p_fingerprint, p_section->p_data,
+                                      p_section->i_length);
+
+        /* PSI section is valid */
+        if (p_section->b_syntax_indicator)
+        {
+            p_section->i_extension =  (p_section->p_data[3] << 8)
+                                     | p_section->p_data[4];
+            p_section->i_version = (p_section->p_data[5] & 0x3e) >> 1;
+            p_section->b_current_next = p_section->p_data[5] & 0x1;
+            p_section->i_number = p_section->p_data[6];
+            p_section->i_last_number = p_section->p_data[7];
+            p_section->p_payload_start = p_section->p_data + 8;
+        }
+        else
+        {
+            p_section->i_extension = 0;
+            p_section->i_version = 0;
+            p_section->b_current_next = true;
+            p_section->i_number = 0;
+            p_section->i_last_number = 0;
+            p_section->p_payload_start = p_section->p_data + 3;
+        }
+        dvbpsi_probe4(section__complete, i_pid, p_section->i_table_id,
+                      p_section->i_extension, p_section->i_length + 3);
+        if (p_dvbpsi->pf_section_tap)
+            p_dvbpsi->pf_section_tap(p_dvbpsi->p_section_tap_data, i_pid,
+                                     p_section->i_arrival, p_section->p_data,
+                                     p_section->i_length + 3);
+        if (p_decoder->pf_gather)
+        {
+            /* Table version seen by the decoder before this section */
+            dvbpsi_decoder_t *p_owner = dvbpsi_section_owner(p_decoder,
+                                            p_section->i_table_id,
+                                            p_section->i_extension);
+            bool b_known = p_owner && p_owner->b_known;
+            uint8_t i_last_version = b_known ? p_owner->i_known_version : 0;
+            uint8_t i_table_id = p_section->i_table_id;
+            uint16_t i_extension = p_section->i_extension;
+            int64_t i_arrival = p_section->i_arrival;
+            uint8_t i_number = p_section->i_number;
+            uint64_t i_tables = p_dvbpsi->stats.i_tables;
+
+            p_decoder->pf_gather(p_dvbpsi, p_section);
+
+            /* This section completed a table */
+            if (p_dvbpsi->stats.i_tables != i_tables)
+            {
+                dvbpsi_probe3(table__complete, i_pid, i_table_id, i_extension);
+                if (i_arrival != DVBPSI_TIME_NONE && p_dvbpsi->i_time != DVBPSI_TIME_NONE)
+                    dvbpsi_latency_record(p_dvbpsi, i_table_id, i_arrival);
+            }
+
+            /* After the gather, which creates the decoder of a new subtable */
+            if ((p_dvbpsi->i_flags & DVBPSI_FLAG_REPETITION)
+                && p_dvbpsi->p_decoder == p_decoder)
+            {
+                dvbpsi_decoder_t *p_repeated = dvbpsi_section_owner(p_decoder,
+                                                   i_table_id, i_extension);
+                if (p_repeated)
+                    dvbpsi_repetition_record(p_repeated, i_number, i_arrival);
+            }
+
+            /* The callbacks may have detached the decoder */
+            if (b_known && p_dvbpsi->p_decoder == p_decoder
+                && dvbpsi_section_owner(p_decoder, i_table_id, i_extension) == p_owner
+                && p_owner->b_known
+                && p_owner->i_known_version != i_last_version)
+            {
+                dvbpsi_event_t event = {
+                    .i_type = DVBPSI_EVENT_VERSION_CHANGE,
+                    .i_pid = i_pid,
+                    .i_table_id = i_table_id,
+                    .i_extension = i_extension,
+                    .i_version = p_owner->i_known_version,
+                    .i_last_version = i_last_version,
+                };
+                dvbpsi_event(p_dvbpsi, &event);
+            }
+
+            /* A first or new version accepted */
+            if (p_dvbpsi->p_changelog && p_dvbpsi->stats.i_tables != i_tables
+                && p_dvbpsi->p_decoder == p_decoder)
+            {
+                dvbpsi_decoder_t *p_accepted = dvbpsi_section_owner(p_decoder,
+                                                   i_table_id, i_extension);
+                if (p_accepted && p_accepted->b_known
+                    && p_accepted->i_known_table_id == i_table_id
+                    && p_accepted->i_known_extension == i_extension
+                    && (!b_known || p_accepted != p_owner
+                        || p_accepted->i_known_version != i_last_version))
+                {
+                    dvbpsi_change_t change = {
+                        .i_pid = i_pid,
+                        .i_table_id = i_table_id,
+                        .i_extension = i_extension,
+                        .i_old_version = (b_known && p_accepted == p_owner)
+                                       ? i_last_version : DVBPSI_CHANGELOG_NO_VERSION,
+                        .i_new_version = p_accepted->i_known_version,
+                        .i_time = i_arrival,
+                    };
+                    dvbpsi_changelog_append(p_dvbpsi->p_changelog, &change);
+                }
+            }
+        }
+    }
     else
-        return false;
+    {
+        if (has_crc32 && !b_valid_crc32)
+        {
+            dvbpsi_event_t event = {
+                .i_type = DVBPSI_EVENT_CRC_ERROR,
+                .i_pid = i_pid,
+                .i_table_id = p_section->i_table_id,
+            };
+            /* A damaged section may end before its extension and version */
+            if (p_section->b_syntax_indicator && p_section->i_length >= 3)
+            {
+                event.i_extension = (p_section->p_data[3] << 8) | p_section->p_data[4];
+                event.i_version = (p_section->p_data[5] & 0x3e) >> 1;
+            }
+            dvbpsi_event(p_dvbpsi, &event);
+            p_dvbpsi->stats.i_dropped_crc++;
+            dvbpsi_probe3(crc__fail, i_pid, p_section->i_table_id, p_section->i_length + 3);
+            dvbpsi_error(p_dvbpsi, "misc PSI", "Bad CRC_32 table 0x%x !!!",
+                                   p_section->p_data[0]);
+        }
+        else
+            dvbpsi_error(p_dvbpsi, "misc PSI", "table 0x%x", p_section->p_data[0]);
+
+        /* PSI section isn't valid => trash it */
+        dvbpsi_DeletePSISections(p_section);
+    }
 }
 
 /*****************************************************************************
- * dvbpsi_packet_push
+ * dvbpsi_packet_decode
  *****************************************************************************
- * Injection of a TS packet into a PSI decoder.
+ * Feeds one TS packet to the decoder. The caller has already checked that
+ * a decoder is attached and that the packet starts with a sync byte, which
+ * allows the batch entry point to do those checks only once.
  *****************************************************************************/
-bool dvbpsi_packet_push(dvbpsi_t *p_dvbpsi, uint8_t* p_data)
+static inline bool dvbpsi_packet_decode(dvbpsi_t *p_dvbpsi,
+                                        dvbpsi_decoder_t *p_decoder,
+                                        uint8_t* p_data)
 {
+    uint16_t i_pid = ((uint16_t)(p_data[1] & 0x1f) << 8) | p_data[2];
     uint8_t i_expected_counter;           /* Expected continuity counter */
     dvbpsi_psi_section_t* p_section;      /* Current section */
     uint8_t* p_payload_pos;               /* Where in the TS packet */
@@ -263,13 +2271,29 @@ bool dvbpsi_packet_push(dvbpsi_t *p_dvbpsi, uint8_t* p_data)
     int i_available;                      /* Byte count available in the
                                              packet */
 
-    dvbpsi_decoder_t *p_decoder = p_dvbpsi->p_decoder;
-    assert(p_decoder);
+    p_dvbpsi->stats.i_packets++;
 
-    /* TS start code */
-    if (p_data[0] != 0x47)
+    /* Errored or scrambled packets */
+    if ((p_dvbpsi->i_flags & DVBPSI_FLAG_DROP_ERRORED)
+     && ((p_data[1] & 0x80) || (p_data[3] & 0xc0)))
     {
-        dvbpsi_error(p_dvbpsi, "PSI decoder", "not a TS packet");
+        p_dvbpsi->stats.i_dropped_errored++;
+        if (p_data[1] & 0x80)
+        {
+            dvbpsi_debug(p_dvbpsi, "PSI decoder",
+                         "transport_error_indicator set for PID %d", i_pid);
+            p_decoder->i_continuity_counter = DVBPSI_INVALID_CC;
+            if (p_decoder->p_current_section)
+            {
+                dvbpsi_probe3(section__dropped, i_pid,
+                              p_decoder->p_current_section->p_data[0], "errored");
+                dvbpsi_DeletePSISections(p_decoder->p_current_section);
+                p_decoder->p_current_section = NULL;
+            }
+        }
+        else
+            dvbpsi_debug(p_dvbpsi, "PSI decoder",
+                         "scrambled packet for PID %d", i_pid);
         return false;
     }
 
@@ -285,20 +2309,49 @@ bool dvbpsi_packet_push(dvbpsi_t *p_dvbpsi, uint8_t* p_data)
         if (i_expected_counter == ((p_decoder->i_continuity_counter + 1) & 0xf)
             && !p_decoder->b_discontinuity)
         {
+            dvbpsi_event_t event = {
+                .i_type = DVBPSI_EVENT_DUPLICATE,
+                .i_pid = i_pid,
+                .i_expected = i_expected_counter,
+                .i_received = p_decoder->i_continuity_counter,
+            };
+            dvbpsi_event(p_dvbpsi, &event);
             dvbpsi_error(p_dvbpsi, "PSI decoder",
                      "TS duplicate (received %d, expected %d) for PID %d",
-                     p_decoder->i_continuity_counter, i_expected_counter,
-                     ((uint16_t)(p_data[1] & 0x1f) << 8) | p_data[2]);
+                     p_decoder->i_continuity_counter, i_expected_counter, i_pid);
             return false;
         }
 
-        if (i_expected_counter != p_decoder->i_continuity_counter)
+        /* A discontinuity signalled by the discontinuity_indicator of the
+         * adaptation_field is no error */
+        bool b_signalled = (p_dvbpsi->i_flags & DVBPSI_FLAG_KEEP_SECTIONS)
+                        && (p_data[3] & 0x20) && p_data[4] > 0 && (p_data[5] & 0x80);
+
+        if (i_expected_counter != p_decoder->i_continuity_counter && b_signalled)
+        {
+            if (p_decoder->p_current_section)
+            {
+                dvbpsi_DeletePSISections(p_decoder->p_current_section);
+                p_decoder->p_current_section = NULL;
+            }
+        }
+        else if (i_expected_counter != p_decoder->i_continuity_counter)
         {
+            dvbpsi_event_t event = {
+                .i_type = DVBPSI_EVENT_CC_ERROR,
+                .i_pid = i_pid,
+                .i_expected = i_expected_counter,
+                .i_received = p_decoder->i_continuity_counter,
+            };
+            dvbpsi_event(p_dvbpsi, &event);
+            dvbpsi_probe3(cc__discontinuity, i_pid, i_expected_counter,
+                          p_decoder->i_continuity_counter);
             dvbpsi_error(p_dvbpsi, "PSI decoder",
                      "TS discontinuity (received %d, expected %d) for PID %d",
-                     p_decoder->i_continuity_counter, i_expected_counter,
-                     ((uint16_t)(p_data[1] & 0x1f) << 8) | p_data[2]);
-            p_decoder->b_discontinuity = true;
+                     p_decoder->i_continuity_counter, i_expected_counter, i_pid);
+            /* the sections already gathered passed their CRC_32 */
+            if (!(p_dvbpsi->i_flags & DVBPSI_FLAG_KEEP_SECTIONS))
+                p_decoder->b_discontinuity = true;
             if (p_decoder->p_current_section)
             {
                 dvbpsi_DeletePSISections(p_decoder->p_current_section);
@@ -335,7 +2388,8 @@ bool dvbpsi_packet_push(dvbpsi_t *p_dvbpsi, uint8_t* p_data)
             /* Allocation of the structure */
             p_decoder->p_current_section
                         = p_section
-                        = dvbpsi_NewPSISection(p_decoder->i_section_max_size);
+                        = dvbpsi_section_start(p_dvbpsi, p_decoder, i_pid,
+                                               p_new_pos, p_data + 188);
             if (!p_section)
                 return false;
             /* Update the position in the packet */
@@ -362,7 +2416,11 @@ bool dvbpsi_packet_push(dvbpsi_t *p_dvbpsi, uint8_t* p_data)
         {
             /* There are enough bytes in this packet to complete the
                header/section */
-            memcpy(p_section->p_payload_end, p_payload_pos, p_decoder->i_need);
+            if (!p_section->b_borrowed)
+            {
+                memcpy(p_section->p_payload_end, p_payload_pos, p_decoder->i_need);
+                p_dvbpsi->stats.i_bytes_copied += p_decoder->i_need;
+            }
             p_payload_pos += p_decoder->i_need;
             p_section->p_payload_end += p_decoder->i_need;
             i_available -= p_decoder->i_need;
@@ -378,6 +2436,16 @@ bool dvbpsi_packet_push(dvbpsi_t *p_dvbpsi, uint8_t* p_data)
                 /* Check that the section isn't too long */
                 if (p_decoder->i_need > p_decoder->i_section_max_size - 3)
                 {
+                    dvbpsi_event_t event = {
+                        .i_type = DVBPSI_EVENT_SECTION_TOO_LONG,
+                        .i_pid = i_pid,
+                        .i_table_id = p_section->p_data[0],
+                        .i_expected = p_decoder->i_section_max_size - 3,
+                        .i_received = p_decoder->i_need,
+                    };
+                    dvbpsi_event(p_dvbpsi, &event);
+                    p_dvbpsi->stats.i_dropped_too_long++;
+                    dvbpsi_probe3(section__dropped, i_pid, p_section->p_data[0], "too long");
                     dvbpsi_error(p_dvbpsi, "PSI decoder", "PSI section too long");
                     dvbpsi_DeletePSISections(p_section);
                     p_decoder->p_current_section = NULL;
@@ -387,7 +2455,8 @@ bool dvbpsi_packet_push(dvbpsi_t *p_dvbpsi, uint8_t* p_data)
                     {
                         p_decoder->p_current_section
                                     = p_section
-                                    = dvbpsi_NewPSISection(p_decoder->i_section_max_size);
+                                    = dvbpsi_section_start(p_dvbpsi, p_decoder, i_pid,
+                                                           p_new_pos, p_data + 188);
                         if (!p_section)
                             return false;
                         p_payload_pos = p_new_pos;
@@ -401,63 +2470,26 @@ bool dvbpsi_packet_push(dvbpsi_t *p_dvbpsi, uint8_t* p_data)
                         i_available = 0;
                     }
                 }
+                else if (p_decoder->i_need + 3 > p_section->i_max_size)
+                {
+                    /* The header straddled two packets */
+                    p_decoder->p_current_section
+                                = p_section
+                                = dvbpsi_section_grow(p_dvbpsi, p_section);
+                    if (!p_section)
+                        return false;
+                }
             }
             else
             {
-                bool b_valid_crc32 = false;
-                bool has_crc32;
-
-                /* PSI section is complete */
-                p_section->i_table_id = p_section->p_data[0];
-                p_section->b_syntax_indicator = p_section->p_data[1] & 0x80;
-                p_section->b_private_indicator = p_section->p_data[1] & 0x40;
-
-                /* Update the end of the payload if CRC_32 is present */
-                has_crc32 = dvbpsi_has_CRC32(p_section);
-                if (p_section->b_syntax_indicator || has_crc32)
-                    p_section->p_payload_end -= 4;
-
-                /* Check CRC32 if present */
-                if (has_crc32)
-                    b_valid_crc32 = dvbpsi_ValidPSISection(p_section);
-
-                if (!has_crc32 || b_valid_crc32)
-                {
-                    /* PSI section is valid */
-                    if (p_section->b_syntax_indicator)
-                    {
-                        p_section->i_extension =  (p_section->p_data[3] << 8)
-                                                 | p_section->p_data[4];
-                        p_section->i_version = (p_section->p_data[5] & 0x3e) >> 1;
-                        p_section->b_current_next = p_section->p_data[5] & 0x1;
-                        p_section->i_number = p_section->p_data[6];
-                        p_section->i_last_number = p_section->p_data[7];
-                        p_section->p_payload_start = p_section->p_data + 8;
-                    }
-                    else
-                    {
-                        p_section->i_extension = 0;
-                        p_section->i_version = 0;
-                        p_section->b_current_next = true;
-                        p_section->i_number = 0;
-                        p_section->i_last_number = 0;
-                        p_section->p_payload_start = p_section->p_data + 3;
-                    }
-                    if (p_decoder->pf_gather)
-                        p_decoder->pf_gather(p_dvbpsi, p_section);
-                    p_decoder->p_current_section = NULL;
-                }
-                else
+                /* PSI section is complete, handed over before the callbacks,
+                 * which may detach the decoder */
+                p_decoder->p_current_section = NULL;
+                if (!p_decoder->b_skip_section)
                 {
-                    if (has_crc32 && !dvbpsi_ValidPSISection(p_section))
-                        dvbpsi_error(p_dvbpsi, "misc PSI", "Bad CRC_32 table 0x%x !!!",
-                                               p_section->p_data[0]);
-                    else
-                        dvbpsi_error(p_dvbpsi, "misc PSI", "table 0x%x", p_section->p_data[0]);
-
-                    /* PSI section isn't valid => trash it */
-                    dvbpsi_DeletePSISections(p_section);
-                    p_decoder->p_current_section = NULL;
+                    dvbpsi_section_complete(p_dvbpsi, p_decoder, p_section, i_pid);
+                    if (p_dvbpsi->p_decoder != p_decoder)
+                        return true;
                 }
 
                 /* A TS packet may contain any number of sections, only the first
@@ -472,7 +2504,8 @@ bool dvbpsi_packet_push(dvbpsi_t *p_dvbpsi, uint8_t* p_data)
                 {
                     p_decoder->p_current_section
                               = p_section
-                              = dvbpsi_NewPSISection(p_decoder->i_section_max_size);
+                              = dvbpsi_section_start(p_dvbpsi, p_decoder, i_pid,
+                                                     p_new_pos, p_data + 188);
                     if (!p_section)
                         return false;
                     p_payload_pos = p_new_pos;
@@ -491,7 +2524,11 @@ bool dvbpsi_packet_push(dvbpsi_t *p_dvbpsi, uint8_t* p_data)
         {
             /* There aren't enough bytes in this packet to complete the
                header/section */
-            memcpy(p_section->p_payload_end, p_payload_pos, i_available);
+            if (!p_section->b_borrowed)
+            {
+                memcpy(p_section->p_payload_end, p_payload_pos, i_available);
+                p_dvbpsi->stats.i_bytes_copied += i_available;
+            }
             p_section->p_payload_end += i_available;
             p_decoder->i_need -= i_available;
             i_available = 0;
@@ -499,8 +2536,216 @@ bool dvbpsi_packet_push(dvbpsi_t *p_dvbpsi, uint8_t* p_data)
     }
     return true;
 }
+
+/*****************************************************************************
+ * dvbpsi_packet_push
+ *****************************************************************************
+ * Injection of a TS packet into a PSI decoder.
+ *****************************************************************************/
+bool dvbpsi_packet_push(dvbpsi_t *p_dvbpsi, uint8_t* p_data)
+{
+    dvbpsi_decoder_t *p_decoder = p_dvbpsi->p_decoder;
+    assert(p_decoder);
+
+    if (p_dvbpsi->i_packet_format == DVBPSI_PACKET_M2TS)
+        return dvbpsi_packets_push(p_dvbpsi, p_data, 1, 0);
+
+    /* TS start code */
+    if (p_data[0] != 0x47)
+    {
+        dvbpsi_error(p_dvbpsi, "PSI decoder", "not a TS packet");
+        return false;
+    }
+
+    return dvbpsi_packet_decode(p_dvbpsi, p_decoder, p_data);
+}
+
+/*****************************************************************************
+ * dvbpsi_packet_push_at
+ *****************************************************************************/
+bool dvbpsi_packet_push_at(dvbpsi_t *p_dvbpsi, uint8_t* p_data, int64_t i_time)
+{
+    p_dvbpsi->i_time = i_time;
+    bool b_ret = dvbpsi_packet_push(p_dvbpsi, p_data);
+    p_dvbpsi->i_time = DVBPSI_TIME_NONE;
+    return b_ret;
+}
+
+/*****************************************************************************
+ * dvbpsi_packets_push
+ *****************************************************************************
+ * Injection of a run of TS packets into a PSI decoder.
+ *****************************************************************************/
+bool dvbpsi_packets_push(dvbpsi_t *p_dvbpsi, uint8_t *p_data,
+                         size_t i_count, size_t i_stride)
+{
+    assert(p_dvbpsi->p_decoder);
+
+    if (i_stride == 0)
+        i_stride = dvbpsi_get_packet_size(p_dvbpsi->i_packet_format);
+    assert(i_stride >= 188);
+
+    bool b_valid = true;
+    uint8_t *p_end = p_data + i_count * i_stride;
+
+    if (p_dvbpsi->i_packet_format == DVBPSI_PACKET_M2TS)
+    {
+        /* The arrival time stamps time the packets unless the caller does */
+        bool b_ats = (p_dvbpsi->i_time == DVBPSI_TIME_NONE);
+        for (; p_data < p_end; p_data += i_stride)
+        {
+            int64_t i_ats = dvbpsi_m2ts_time(p_dvbpsi, p_data);
+            if (p_data[4] != 0x47)
+            {
+                dvbpsi_error(p_dvbpsi, "PSI decoder", "not a TS packet");
+                b_valid = false;
+                continue;
+            }
+
+            /* A section callback may detach or replace the decoder */
+            dvbpsi_decoder_t *p_decoder = p_dvbpsi->p_decoder;
+            if (p_decoder == NULL)
+                break;
+            if (b_ats)
+                p_dvbpsi->i_time = i_ats;
+            dvbpsi_packet_decode(p_dvbpsi, p_decoder, p_data + 4);
+        }
+        if (b_ats)
+            p_dvbpsi->i_time = DVBPSI_TIME_NONE;
+
+        return b_valid;
+    }
+
+    for (; p_data < p_end; p_data += i_stride)
+    {
+        /* TS start code */
+        if (p_data[0] != 0x47)
+        {
+            dvbpsi_error(p_dvbpsi, "PSI decoder", "not a TS packet");
+            b_valid = false;
+            continue;
+        }
+
+        /* A section callback may detach or replace the decoder */
+        dvbpsi_decoder_t *p_decoder = p_dvbpsi->p_decoder;
+        if (p_decoder == NULL)
+            break;
+        dvbpsi_packet_decode(p_dvbpsi, p_decoder, p_data);
+    }
+
+    return b_valid;
+}
 #undef DVBPSI_INVALID_CC
 
+/*****************************************************************************
+ * dvbpsi_packets_push_at
+ *****************************************************************************/
+bool dvbpsi_packets_push_at(dvbpsi_t *p_dvbpsi, uint8_t *p_data,
+                            size_t i_count, size_t i_stride, int64_t i_time)
+{
+    p_dvbpsi->i_time = i_time;
+    bool b_ret = dvbpsi_packets_push(p_dvbpsi, p_data, i_count, i_stride);
+    p_dvbpsi->i_time = DVBPSI_TIME_NONE;
+    return b_ret;
+}
+
+/*****************************************************************************
+ * dvbpsi_section_push
+ *****************************************************************************
+ * Injection of a complete PSI section into a PSI decoder.
+ *****************************************************************************/
+bool dvbpsi_section_push(dvbpsi_t *p_dvbpsi, uint8_t *p_data, size_t i_size)
+{
+    dvbpsi_decoder_t *p_decoder = p_dvbpsi->p_decoder;
+    assert(p_decoder);
+
+    if (i_size < 3)
+    {
+        dvbpsi_error(p_dvbpsi, "PSI decoder", "PSI section too short");
+        return false;
+    }
+
+    uint16_t i_length = ((uint16_t)(p_data[1] & 0xf)) << 8 | p_data[2];
+    if ((size_t)i_length + 3 > i_size)
+    {
+        dvbpsi_error(p_dvbpsi, "PSI decoder",
+                     "truncated PSI section (%d bytes for section_length %d)",
+                     (int)i_size, i_length);
+        return false;
+    }
+
+    if (i_length > p_decoder->i_section_max_size - 3)
+    {
+        dvbpsi_event_t event = {
+            .i_type = DVBPSI_EVENT_SECTION_TOO_LONG,
+            .i_pid = DVBPSI_EVENT_NO_PID,
+            .i_table_id = p_data[0],
+            .i_expected = p_decoder->i_section_max_size - 3,
+            .i_received = i_length,
+        };
+        dvbpsi_event(p_dvbpsi, &event);
+        p_dvbpsi->stats.i_dropped_too_long++;
+        dvbpsi_probe3(section__dropped, DVBPSI_EVENT_NO_PID, p_data[0], "too long");
+        dvbpsi_error(p_dvbpsi, "PSI decoder", "PSI section too long");
+        return false;
+    }
+
+    /* Same early checks as for the first TS packet of a section */
+    if ((p_dvbpsi->b_section_filter || p_dvbpsi->b_eit_window)
+        && dvbpsi_section_filtered(p_dvbpsi, p_data, i_length + 3))
+    {
+        p_dvbpsi->stats.i_dropped_filtered++;
+        dvbpsi_probe3(section__dropped, DVBPSI_EVENT_NO_PID, p_data[0], "filtered");
+        return true;
+    }
+    if (dvbpsi_section_shed(p_dvbpsi, p_data[0]))
+    {
+        p_dvbpsi->stats.i_dropped_shed++;
+        dvbpsi_probe3(section__dropped, DVBPSI_EVENT_NO_PID, p_data[0], "shed");
+        return true;
+    }
+    if ((p_dvbpsi->i_flags & DVBPSI_FLAG_SKIP_UNCHANGED) && i_length >= 5
+        && dvbpsi_section_known(p_dvbpsi, p_decoder, p_data))
+    {
+        p_dvbpsi->stats.i_dropped_unchanged++;
+        dvbpsi_probe3(section__dropped, DVBPSI_EVENT_NO_PID, p_data[0], "unchanged");
+        return true;
+    }
+
+    /* The borrowed section may be a skipped one spanning TS packets */
+    dvbpsi_psi_section_t *p_section;
+    if ((p_dvbpsi->i_flags & DVBPSI_FLAG_ZERO_COPY)
+        && !(p_decoder->p_current_section && p_decoder->p_current_section->b_borrowed))
+        p_section = dvbpsi_section_pool_borrow(p_dvbpsi->p_pool, p_data, i_length + 3);
+    else
+    {
+        p_section = dvbpsi_section_pool_get(p_dvbpsi->p_pool, i_length + 3);
+        if (p_section == NULL)
+            return false;
+        memcpy(p_section->p_data, p_data, i_length + 3);
+        p_dvbpsi->stats.i_bytes_copied += i_length + 3;
+    }
+
+    p_section->i_length = i_length;
+    p_section->p_payload_end = p_section->p_data + i_length + 3;
+    p_section->i_arrival = p_dvbpsi->i_time;
+
+    dvbpsi_section_complete(p_dvbpsi, p_decoder, p_section, DVBPSI_EVENT_NO_PID);
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_section_push_at
+ *****************************************************************************/
+bool dvbpsi_section_push_at(dvbpsi_t *p_dvbpsi, uint8_t *p_data, size_t i_size,
+                            int64_t i_time)
+{
+    p_dvbpsi->i_time = i_time;
+    bool b_ret = dvbpsi_section_push(p_dvbpsi, p_data, i_size);
+    p_dvbpsi->i_time = DVBPSI_TIME_NONE;
+    return b_ret;
+}
+
 /*****************************************************************************
  * Message error level:
  * -1 is disabled,
@@ -508,121 +2753,112 @@ bool dvbpsi_packet_push(dvbpsi_t *p_dvbpsi, uint8_t* p_data)
  *  1 is warning and errors
  *  2 is debug, warning and errors
  *****************************************************************************/
-#if !defined(HAVE_ASPRINTF)
-#   define DVBPSI_MSG_SIZE 1024
-#endif
+/* Messages are formatted on the stack, only longer ones hit the heap */
+#define DVBPSI_MSG_SIZE 1024
 
 #define DVBPSI_MSG_FORMAT "libdvbpsi (%s): "
 
 #ifdef HAVE_VARIADIC_MACROS
 void dvbpsi_message(dvbpsi_t *dvbpsi, const dvbpsi_msg_level_t level, const char *fmt, ...)
 {
-    if ((dvbpsi->i_msg_level > DVBPSI_MSG_NONE) &&
-        (level <= dvbpsi->i_msg_level))
+    if (!dvbpsi_message_enabled(dvbpsi, level))
+        return;
+
+    char buf[DVBPSI_MSG_SIZE];
+    va_list ap;
+    va_start(ap, fmt);
+    int err = vsnprintf(buf, DVBPSI_MSG_SIZE, fmt, ap);
+    va_end(ap);
+    if (err <= 0)
+        return;
+
+    char *msg = buf;
+#if defined(HAVE_ASPRINTF)
+    if (err >= DVBPSI_MSG_SIZE)
     {
-        va_list ap;
         va_start(ap, fmt);
-        char *msg = NULL;
-#if defined(HAVE_ASPRINTF)
-        int err = vasprintf(&msg, fmt, ap);
-#else
-        msg = malloc(DVBPSI_MSG_SIZE);
-        if (msg == NULL) {
-            va_end(ap);
+        err = vasprintf(&msg, fmt, ap);
+        va_end(ap);
+        if (err < 0)
             return;
-        }
-        int err = vsnprintf(msg, DVBPSI_MSG_SIZE, DVBPSI_MSG_FORMAT fmt, ap);
+    }
 #endif
-        va_end(ap);
-        if (err > 0) {
-            if (dvbpsi->pf_message)
-                dvbpsi->pf_message(dvbpsi, level, msg);
-        }
+    dvbpsi->pf_message(dvbpsi, level, msg);
+    if (msg != buf)
         free(msg);
-    }
 }
 #else
 
-/* Common code for printing messages */
-#   if defined(HAVE_ASPRINTF)
-#       define DVBPSI_MSG_COMMON(level)                         \
-    do {                                                        \
-        va_list ap;                                             \
-        va_start(ap, fmt);                                      \
-        char *tmp = NULL;                                       \
-        int err = vasprintf(&tmp, fmt, ap);                     \
-        if (err < 0) {                                          \
-            va_end(ap);                                         \
-            return;                                             \
-        }                                                       \
-        char *msg = NULL;                                       \
-        if (asprintf(&msg, DVBPSI_MSG_FORMAT "%s", src, tmp) < 0) { \
-            va_end(ap);                                         \
-            free(tmp);                                          \
-            return;                                             \
-        }                                                       \
-        free(tmp);                                              \
-        va_end(ap);                                             \
-        if (err > 0) {                                          \
-            if (dvbpsi->pf_message)                             \
-                dvbpsi->pf_message(dvbpsi, level, msg);         \
-        }                                                       \
-        free(msg);                                              \
-    } while(0);
-#   else
-#       define DVBPSI_MSG_COMMON(level)                         \
-    do {                                                        \
-        va_list ap;                                             \
-        va_start(ap, fmt);                                      \
-        char *tmp = malloc(DVBPSI_MSG_SIZE);                    \
-        char *msg = malloc(DVBPSI_MSG_SIZE);                    \
-        if ((tmp == NULL) || (msg == NULL)) {                   \
-            va_end(ap);                                         \
-            if (tmp) free(tmp);                                 \
-            if (msg) free(msg);                                 \
-            return;                                             \
-        }                                                       \
-        if (vsnprintf(tmp, DVBPSI_MSG_SIZE, fmt, ap) < 0) {     \
-            va_end(ap);                                         \
-            if (tmp) free(tmp);                                 \
-            if (msg) free(msg);                                 \
-            return;                                             \
-        }                                                       \
-        va_end(ap);                                             \
-        int err = snprintf(msg, DVBPSI_MSG_SIZE, DVBPSI_MSG_FORMAT "%s", src, tmp); \
-        if (err > 0) {                                          \
-            if (dvbpsi->pf_message)                             \
-                dvbpsi->pf_message(dvbpsi, level, msg);         \
-        }                                                       \
-        free(tmp);                                              \
-        free(msg);                                              \
-    } while(0);
-#   endif
+/*****************************************************************************
+ * dvbpsi_vmessage
+ *****************************************************************************
+ * Common code for printing messages.
+ *****************************************************************************/
+static void dvbpsi_vmessage(dvbpsi_t *dvbpsi, const dvbpsi_msg_level_t level,
+                            const char *src, const char *fmt, va_list ap)
+{
+    char buf[DVBPSI_MSG_SIZE];
+    int i_prefix = snprintf(buf, DVBPSI_MSG_SIZE, DVBPSI_MSG_FORMAT, src);
+    if ((i_prefix < 0) || (i_prefix >= DVBPSI_MSG_SIZE))
+        return;
+
+    va_list aq;
+    va_copy(aq, ap);
+    int err = vsnprintf(buf + i_prefix, DVBPSI_MSG_SIZE - i_prefix, fmt, aq);
+    va_end(aq);
+    if (err <= 0)
+        return;
+
+    char *msg = buf;
+#if defined(HAVE_ASPRINTF)
+    if (i_prefix + err >= DVBPSI_MSG_SIZE)
+    {
+        char *tmp = NULL;
+        if (vasprintf(&tmp, fmt, ap) < 0)
+            return;
+        err = asprintf(&msg, DVBPSI_MSG_FORMAT "%s", src, tmp);
+        free(tmp);
+        if (err < 0)
+            return;
+    }
+#endif
+    dvbpsi->pf_message(dvbpsi, level, msg);
+    if (msg != buf)
+        free(msg);
+}
 
 void dvbpsi_error(dvbpsi_t *dvbpsi, const char *src, const char *fmt, ...)
 {
-    if ((dvbpsi->i_msg_level > DVBPSI_MSG_NONE) &&
-        (DVBPSI_MSG_ERROR <= dvbpsi->i_msg_level))
+    if (dvbpsi_message_enabled(dvbpsi, DVBPSI_MSG_ERROR))
     {
-        DVBPSI_MSG_COMMON(DVBPSI_MSG_ERROR)
+        va_list ap;
+        va_start(ap, fmt);
+        dvbpsi_vmessage(dvbpsi, DVBPSI_MSG_ERROR, src, fmt, ap);
+        va_end(ap);
     }
 }
 
 void dvbpsi_warning(dvbpsi_t *dvbpsi, const char *src, const char *fmt, ...)
 {
-    if ((dvbpsi->i_msg_level > DVBPSI_MSG_NONE) &&
-        (DVBPSI_MSG_WARN <= dvbpsi->i_msg_level))
+    if (dvbpsi_message_enabled(dvbpsi, DVBPSI_MSG_WARN))
     {
-        DVBPSI_MSG_COMMON(DVBPSI_MSG_WARN)
+        va_list ap;
+        va_start(ap, fmt);
+        dvbpsi_vmessage(dvbpsi, DVBPSI_MSG_WARN, src, fmt, ap);
+        va_end(ap);
     }
 }
 
+#if !defined(DVBPSI_NO_DEBUG_MESSAGES)
 void dvbpsi_debug(dvbpsi_t *dvbpsi, const char *src, const char *fmt, ...)
 {
-    if ((dvbpsi->i_msg_level > DVBPSI_MSG_NONE) &&
-        (DVBPSI_MSG_DEBUG <= dvbpsi->i_msg_level))
+    if (dvbpsi_message_enabled(dvbpsi, DVBPSI_MSG_DEBUG))
     {
-        DVBPSI_MSG_COMMON(DVBPSI_MSG_DEBUG)
+        va_list ap;
+        va_start(ap, fmt);
+        dvbpsi_vmessage(dvbpsi, DVBPSI_MSG_DEBUG, src, fmt, ap);
+        va_end(ap);
     }
 }
 #endif
+#endif
@@ -30,6 +30,21 @@
  *
  * Application interface for all DVB/PSI decoders. The generic decoder
  * structure is public so that external decoders are allowed.
+ *
+ * A handle with its decoders, like every object built on handles such as
+ * a router, a discovery engine or an EPG store, is not thread safe, but
+ * distinct objects share no mutable state: they can be used concurrently
+ * from different threads without any lock, and an object can move from
+ * one thread to another between calls. The only global state is the
+ * allocator of dvbpsi_set_allocator(), set before any other call, the
+ * CRC_32 kernel, selected once with atomic accesses, and the memory records
+ * of an instrumented library, behind a lock. The table arena and
+ * the descriptor intern table entered during a decode are thread local.
+ * The tables given to the callbacks belong to the application and may be
+ * deleted on any thread, except with DVBPSI_FLAG_INTERN_DESCRIPTORS: the
+ * shared descriptor contents of such a handle are not reference counted
+ * atomically, so its tables must be deleted on the thread using it, or
+ * while it does not decode. misc/test_threads checks these guarantees.
  */
 
 #ifndef _DVBPSI_DVBPSI_H_
@@ -95,6 +110,320 @@ typedef void (* dvbpsi_message_cb)(dvbpsi_t *handle,
                                    const dvbpsi_msg_level_t level,
                                    const char* msg);
 
+/*****************************************************************************
+ * dvbpsi_event_t
+ *****************************************************************************/
+/*!
+ * \enum dvbpsi_event_type
+ * \brief Types of the events given to a dvbpsi_event_cb
+ */
+enum dvbpsi_event_type
+{
+    DVBPSI_EVENT_CC_ERROR = 0,       /*!< TS discontinuity, i_expected and
+                                          i_received are the continuity
+                                          counters */
+    DVBPSI_EVENT_DUPLICATE,          /*!< Duplicate TS packet, i_received is
+                                          its continuity counter */
+    DVBPSI_EVENT_CRC_ERROR,          /*!< Section with a bad CRC_32 */
+    DVBPSI_EVENT_SECTION_TOO_LONG,   /*!< Section longer than the decoder
+                                          accepts, i_received is the
+                                          section_length, i_expected the
+                                          maximum */
+    DVBPSI_EVENT_VERSION_CHANGE,     /*!< A new version of a table was
+                                          decoded, i_last_version is the
+                                          previous one */
+
+    DVBPSI_EVENT_MAX                 /*!< Number of event types */
+};
+/*!
+ * \typedef enum dvbpsi_event_type dvbpsi_event_type_t
+ * \brief dvbpsi_event_type_t type definition.
+ */
+typedef enum dvbpsi_event_type dvbpsi_event_type_t;
+
+/*!
+ * \def DVBPSI_EVENT_NO_PID
+ * \brief i_pid of events not tied to a TS packet
+ */
+#define DVBPSI_EVENT_NO_PID 0xffff
+
+/*!
+ * \struct dvbpsi_event_s
+ * \brief Event structure
+ *
+ * Filled on the stack by libdvbpsi, without any formatting or allocation,
+ * and only valid during the dvbpsi_event_cb call. Fields that do not apply
+ * to an event type are 0.
+ */
+/*!
+ * \typedef struct dvbpsi_event_s dvbpsi_event_t
+ * \brief dvbpsi_event_t type definition.
+ */
+typedef struct dvbpsi_event_s
+{
+    dvbpsi_event_type_t i_type;         /*!< event type */
+    uint16_t            i_pid;          /*!< PID or DVBPSI_EVENT_NO_PID */
+    uint8_t             i_table_id;     /*!< table_id */
+    uint16_t            i_extension;    /*!< table_id_extension */
+    uint8_t             i_version;      /*!< version_number */
+    uint8_t             i_last_version; /*!< previous version_number */
+    uint32_t            i_expected;     /*!< expected value */
+    uint32_t            i_received;     /*!< received value */
+    uint64_t            i_count;        /*!< events of this type seen so far
+                                             on the handle, this one included */
+} dvbpsi_event_t;
+
+/*****************************************************************************
+ * dvbpsi_event_cb
+ *****************************************************************************/
+/*!
+ * \typedef void (* dvbpsi_event_cb)(dvbpsi_t *handle,
+ *                                   const dvbpsi_event_t *p_event,
+ *                                   void *p_cb_data)
+ * \brief Event callback type definition.
+ */
+typedef void (* dvbpsi_event_cb)(dvbpsi_t *handle,
+                                 const dvbpsi_event_t *p_event,
+                                 void *p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_section_tap_cb
+ *****************************************************************************/
+/*!
+ * \typedef void (* dvbpsi_section_tap_cb)(void *p_cb_data, uint16_t i_pid,
+ *                                        int64_t i_time,
+ *                                        const uint8_t *p_section,
+ *                                        size_t i_size)
+ * \brief Section tap callback type definition, see dvbpsi_set_section_tap().
+ * i_pid is DVBPSI_EVENT_NO_PID for a section given to dvbpsi_section_push(),
+ * i_time the arrival time of the section, DVBPSI_TIME_NONE if unknown.
+ */
+typedef void (* dvbpsi_section_tap_cb)(void *p_cb_data, uint16_t i_pid,
+                                       int64_t i_time, const uint8_t *p_section,
+                                       size_t i_size);
+
+/*****************************************************************************
+ * dvbpsi_section_filter_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_section_filter_s
+ * \brief Section filter, see dvbpsi_set_section_filter()
+ *
+ * A section matches when the bits of its table_id selected by
+ * i_table_id_mask equal those of i_table_id, and the bits of its
+ * table_id_extension selected by i_extension_mask equal those of
+ * i_extension. The extension is only compared for sections with the
+ * section_syntax_indicator set.
+ */
+/*!
+ * \typedef struct dvbpsi_section_filter_s dvbpsi_section_filter_t
+ * \brief dvbpsi_section_filter_t type definition.
+ */
+typedef struct dvbpsi_section_filter_s
+{
+    uint8_t  i_table_id;        /*!< table_id value */
+    uint8_t  i_table_id_mask;   /*!< table_id bits to compare */
+    uint16_t i_extension;       /*!< table_id_extension value */
+    uint16_t i_extension_mask;  /*!< table_id_extension bits to compare */
+} dvbpsi_section_filter_t;
+
+/*****************************************************************************
+ * dvbpsi_eit_window_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_eit_window_s
+ * \brief EIT schedule acquisition window, see dvbpsi_set_eit_window()
+ *
+ * The EIT schedule tables, table_id 0x50 to 0x5f for the actual transport
+ * stream and 0x60 to 0x6f for the others, hold 512 segments of 3 hours
+ * from 00:00 UTC of the current day: segment (table_id & 0x0f) * 32 +
+ * section_number / 8. The window keeps the segments from i_first_segment
+ * to i_last_segment included.
+ */
+/*!
+ * \typedef struct dvbpsi_eit_window_s dvbpsi_eit_window_t
+ * \brief dvbpsi_eit_window_t type definition.
+ */
+typedef struct dvbpsi_eit_window_s
+{
+    uint16_t i_first_segment;   /*!< first segment kept, 0 to 511 */
+    uint16_t i_last_segment;    /*!< last segment kept, 0 to 511 */
+} dvbpsi_eit_window_t;
+
+/*****************************************************************************
+ * dvbpsi_stats_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_stats_s
+ * \brief Performance counters of a dvbpsi_t handle, see dvbpsi_get_stats()
+ */
+/*!
+ * \typedef struct dvbpsi_stats_s dvbpsi_stats_t
+ * \brief dvbpsi_stats_t type definition.
+ */
+typedef struct dvbpsi_stats_s
+{
+    uint64_t i_packets;           /*!< TS packets given to the decoder */
+    uint64_t i_bytes_copied;      /*!< section bytes copied out of the TS
+                                       packets or pushed sections */
+    uint64_t i_sections;          /*!< sections assembled or pushed with
+                                       dvbpsi_section_push() */
+    uint64_t i_dropped_too_long;  /*!< sections longer than the decoder
+                                       accepts */
+    uint64_t i_dropped_crc;       /*!< sections with a bad CRC_32 */
+    uint64_t i_dropped_filtered;  /*!< sections not matching the section
+                                       filter */
+    uint64_t i_dropped_unchanged; /*!< sections skipped by
+                                       DVBPSI_FLAG_SKIP_UNCHANGED or
+                                       DVBPSI_FLAG_CRC_CACHE */
+    uint64_t i_dropped_duplicate; /*!< sections of an already decoded table
+                                       version dropped by the decoders */
+    uint64_t i_tables;            /*!< tables completed by the decoders */
+    uint64_t i_allocations;       /*!< section buffers allocated */
+    uint64_t i_dropped_errored;   /*!< TS packets ignored by
+                                       DVBPSI_FLAG_DROP_ERRORED */
+    uint64_t i_descriptors_reused; /*!< descriptors duplicated by
+                                       DVBPSI_FLAG_DESCRIPTOR_CACHE */
+    uint64_t i_crc_patched;       /*!< generated sections whose CRC_32 was
+                                       derived from their previous encoding by
+                                       DVBPSI_FLAG_ENCODER_CACHE */
+    uint64_t i_dropped_shed;      /*!< sections dropped by the shed level,
+                                       see dvbpsi_set_shed_level() */
+    uint64_t i_subdecs_expired;   /*!< subtable decoders detached as idle,
+                                       see dvbpsi_demux_set_limits() */
+    uint64_t i_subdecs_evicted;   /*!< subtable decoders detached over the
+                                       memory budget, see
+                                       dvbpsi_demux_set_limits() */
+} dvbpsi_stats_t;
+
+/*****************************************************************************
+ * dvbpsi_repetition_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_repetition_s
+ * \brief Repetition of a section, see dvbpsi_get_repetition()
+ *
+ * The times are in the unit of the timestamps given to
+ * dvbpsi_packet_push_at(), the average interval is i_total / i_count.
+ */
+/*!
+ * \typedef struct dvbpsi_repetition_s dvbpsi_repetition_t
+ * \brief dvbpsi_repetition_t type definition.
+ */
+typedef struct dvbpsi_repetition_s
+{
+    int64_t  i_last;              /*!< arrival time of the last copy */
+    uint64_t i_count;             /*!< intervals measured */
+    uint64_t i_min;               /*!< shortest interval */
+    uint64_t i_max;               /*!< longest interval */
+    uint64_t i_total;             /*!< sum of the intervals */
+} dvbpsi_repetition_t;
+
+/*****************************************************************************
+ * dvbpsi_fingerprint_t
+ *****************************************************************************/
+/*!
+ * \def DVBPSI_FINGERPRINT_SIZE
+ * \brief Maximum number of sections described by a dvbpsi_fingerprint_t
+ */
+#define DVBPSI_FINGERPRINT_SIZE 256
+
+/*!
+ * \struct dvbpsi_fingerprint_s
+ * \brief Identity of the PSI and SI of a stream, see dvbpsi_set_fingerprint()
+ *
+ * The last CRC_32 of each section, identified by its table_id,
+ * table_id_extension and section_number, the CRC_32 covering the
+ * version_number. i_hash combines them regardless of the order in which the
+ * sections arrived, so that two streams carrying the same sections have
+ * the same hash. Once DVBPSI_FINGERPRINT_SIZE sections are known, new ones
+ * are only counted in i_overflow.
+ */
+/*!
+ * \typedef struct dvbpsi_fingerprint_s dvbpsi_fingerprint_t
+ * \brief dvbpsi_fingerprint_t type definition.
+ */
+typedef struct dvbpsi_fingerprint_s
+{
+    uint64_t     i_hash;          /*!< sum of the hashes of the sections */
+    unsigned int i_sections;      /*!< sections described */
+    uint64_t     i_changes;       /*!< new sections and CRC_32 changes */
+    uint64_t     i_overflow;      /*!< sections left out for lack of room */
+
+    uint32_t     pi_key[DVBPSI_FINGERPRINT_SIZE]; /*!< private, hash table of
+                                                       the sections */
+    uint32_t     pi_crc[DVBPSI_FINGERPRINT_SIZE]; /*!< private, CRC_32 of the
+                                                       sections */
+} dvbpsi_fingerprint_t;
+
+/*!
+ * \enum dvbpsi_packet_format
+ * \brief Framing of the TS packets given to a dvbpsi_t handle
+ */
+enum dvbpsi_packet_format
+{
+    DVBPSI_PACKET_TS   = 0, /*!< 188 bytes TS packets */
+    DVBPSI_PACKET_M2TS = 1, /*!< 192 bytes M2TS/BDAV packets, a 4 bytes
+                                 TP_extra_header holding a 30 bits arrival
+                                 time stamp followed by the TS packet */
+    DVBPSI_PACKET_RS   = 2, /*!< 204 bytes packets, the TS packet followed by
+                                 16 Reed-Solomon parity bytes */
+};
+/*!
+ * \typedef enum dvbpsi_packet_format dvbpsi_packet_format_t
+ * \brief dvbpsi_packet_format_t type definition.
+ */
+typedef enum dvbpsi_packet_format dvbpsi_packet_format_t;
+
+/*!
+ * \enum dvbpsi_priority
+ * \brief Priority of a table under overload, see dvbpsi_table_priority()
+ */
+enum dvbpsi_priority
+{
+    DVBPSI_PRIORITY_CRITICAL  = 0, /*!< PAT, CAT, PMT, TDT, TOT and ATSC STT */
+    DVBPSI_PRIORITY_NORMAL    = 1, /*!< NIT, SDT, EIT present/following and
+                                        ATSC MGT and VCT */
+    DVBPSI_PRIORITY_SHEDDABLE = 2, /*!< EIT schedule, BAT and all the others */
+};
+/*!
+ * \typedef enum dvbpsi_priority dvbpsi_priority_t
+ * \brief dvbpsi_priority_t type definition.
+ */
+typedef enum dvbpsi_priority dvbpsi_priority_t;
+
+/*!
+ * \enum dvbpsi_shed_level
+ * \brief Sections dropped by a handle under overload, see
+ * dvbpsi_set_shed_level()
+ */
+enum dvbpsi_shed_level
+{
+    DVBPSI_SHED_NONE      = 0, /*!< all sections are processed */
+    DVBPSI_SHED_SHEDDABLE = 1, /*!< DVBPSI_PRIORITY_SHEDDABLE sections are
+                                    dropped */
+    DVBPSI_SHED_NORMAL    = 2, /*!< DVBPSI_PRIORITY_NORMAL sections are
+                                    dropped as well */
+};
+/*!
+ * \typedef enum dvbpsi_shed_level dvbpsi_shed_level_t
+ * \brief dvbpsi_shed_level_t type definition.
+ */
+typedef enum dvbpsi_shed_level dvbpsi_shed_level_t;
+
+/*!
+ * \def DVBPSI_TIME_NONE
+ * \brief Arrival time of data pushed without a timestamp
+ */
+#define DVBPSI_TIME_NONE INT64_MIN
+
+/*!
+ * \def DVBPSI_LATENCY_BUCKETS
+ * \brief Number of buckets of a latency histogram, see
+ * dvbpsi_get_latency_histogram()
+ */
+#define DVBPSI_LATENCY_BUCKETS 32
+
 /*****************************************************************************
  * dvbpsi_decoder_t
  *****************************************************************************/
@@ -152,6 +481,132 @@ struct dvbpsi_s
                                                           from caller. Do not use
                                                           from inside libdvbpsi. It
                                                           will crash any application. */
+
+    /* Decoding options */
+    uint32_t                      i_flags;              /*!< DVBPSI_FLAG_* options,
+                                                          see dvbpsi_set_flags() */
+    unsigned int                  i_verify_interval;    /*!< see
+                                                          dvbpsi_set_verify_interval() */
+    uint64_t                      i_crc_cache_hits;     /*!< see
+                                                          dvbpsi_get_crc_cache_stats() */
+    uint64_t                      i_crc_cache_misses;   /*!< see
+                                                          dvbpsi_get_crc_cache_stats() */
+
+    struct dvbpsi_section_pool_s *p_pool;               /*!< private section
+                                                          buffers pool */
+    struct dvbpsi_section_buffer_s *p_section_buffer;   /*!< private, see
+                                                          dvbpsi_section_buffer_t */
+    struct dvbpsi_encoder_cache_s *p_encoder_cache;     /*!< private, see
+                                                          DVBPSI_FLAG_ENCODER_CACHE */
+
+    /* Performance counters */
+    dvbpsi_stats_t                stats;                /*!< see
+                                                          dvbpsi_get_stats() */
+
+    /* Packet framing */
+    dvbpsi_packet_format_t        i_packet_format;      /*!< see
+                                                          dvbpsi_set_packet_format() */
+    uint32_t                      i_ats_last;           /*!< private, last M2TS
+                                                          arrival time stamp */
+    int64_t                       i_ats_time;           /*!< private, unwrapped
+                                                          arrival time stamps */
+
+    /* Arrival time of the data being pushed */
+    int64_t                       i_time;               /*!< see
+                                                          dvbpsi_packet_push_at() */
+    struct dvbpsi_latency_s      *p_latency;            /*!< private, latency
+                                                          histograms */
+
+    /* Section filter */
+    bool                          b_section_filter;     /*!< see
+                                                          dvbpsi_set_section_filter() */
+    dvbpsi_section_filter_t       section_filter;       /*!< see
+                                                          dvbpsi_set_section_filter() */
+    bool                          b_eit_window;         /*!< see
+                                                          dvbpsi_set_eit_window() */
+    dvbpsi_eit_window_t           eit_window;           /*!< see
+                                                          dvbpsi_set_eit_window() */
+    dvbpsi_shed_level_t           i_shed_level;         /*!< see
+                                                          dvbpsi_set_shed_level() */
+
+    /* Stream identity */
+    dvbpsi_fingerprint_t         *p_fingerprint;        /*!< see
+                                                          dvbpsi_set_fingerprint() */
+
+    /* Events callback */
+    dvbpsi_event_cb               pf_event;             /*!< see
+                                                          dvbpsi_set_event_cb() */
+    void                         *p_event_data;         /*!< private data given
+                                                          to pf_event */
+    uint64_t                      i_events[DVBPSI_EVENT_MAX]; /*!< event
+                                                          counters */
+
+    dvbpsi_section_tap_cb         pf_section_tap;       /*!< see
+                                                          dvbpsi_set_section_tap() */
+    void                         *p_section_tap_data;   /*!< private data given
+                                                          to pf_section_tap */
+    struct dvbpsi_changelog_s    *p_changelog;          /*!< see
+                                                          dvbpsi_set_changelog() */
+    struct dvbpsi_pull_s         *p_pull;               /*!< private, see
+                                                          dvbpsi_pull_attach() */
+};
+
+/*!
+ * \enum dvbpsi_flag
+ * \brief Decoding options of a dvbpsi_t handle
+ */
+enum dvbpsi_flag
+{
+    DVBPSI_FLAG_ZERO_COPY = 0x01, /*!< Sections that start and end in the same
+                                       TS packet are validated and given to the
+                                       decoder in place, see dvbpsi_set_flags() */
+    DVBPSI_FLAG_SKIP_UNCHANGED = 0x02, /*!< Sections of an already decoded table
+                                       version are skipped before assembly,
+                                       see dvbpsi_set_flags() */
+    DVBPSI_FLAG_CRC_CACHE = 0x04, /*!< Sections identical to those of the last
+                                       decoded table are dropped after assembly,
+                                       see dvbpsi_set_flags() */
+    DVBPSI_FLAG_DROP_ERRORED = 0x08, /*!< TS packets with the
+                                       transport_error_indicator set or a
+                                       scrambled payload are ignored,
+                                       see dvbpsi_set_flags() */
+    DVBPSI_FLAG_TABLE_ARENA = 0x10, /*!< Decoded PMT, SDT, EIT, NIT and BAT
+                                       tables are allocated in one block
+                                       list each, see dvbpsi_set_flags() */
+    DVBPSI_FLAG_LAZY_DECODE = 0x20, /*!< PMT, SDT, EIT, NIT and BAT tables are
+                                       signaled with their raw sections and
+                                       decoded on request, see
+                                       dvbpsi_set_flags() */
+    DVBPSI_FLAG_DESCRIPTOR_CACHE = 0x40, /*!< SDT and NIT descriptors are
+                                       decoded with the table, reusing those
+                                       of the previous version,
+                                       see dvbpsi_set_flags() */
+    DVBPSI_FLAG_INTERN_DESCRIPTORS = 0x80, /*!< Identical descriptors of an
+                                       SDT, NIT or BAT share their content,
+                                       see dvbpsi_set_flags() */
+    DVBPSI_FLAG_ENCODER_CACHE = 0x100, /*!< Generated sections identical to
+                                       their previous encoding get their
+                                       CRC_32 patched, see dvbpsi_set_flags() */
+    DVBPSI_FLAG_TABLE_INDEX = 0x200, /*!< Decoded NIT and BAT tables come
+                                       with a hash index of their transport
+                                       streams and services, and ATSC VCTs
+                                       of their channels,
+                                       see dvbpsi_set_flags() */
+    DVBPSI_FLAG_COMPACT = 0x400, /*!< Idle decoders keep no section buffer
+                                       or index, see dvbpsi_set_flags() */
+    DVBPSI_FLAG_REPETITION = 0x800, /*!< Repetition intervals of the sections
+                                       are measured, see
+                                       dvbpsi_get_repetition() */
+    DVBPSI_FLAG_KEEP_SECTIONS = 0x1000, /*!< A discontinuity only drops the
+                                       section being assembled, see
+                                       dvbpsi_set_flags() */
+    DVBPSI_FLAG_LAST_SECTIONS = 0x2000, /*!< The sections of the last complete
+                                       table are kept, see
+                                       dvbpsi_get_last_sections() */
+    DVBPSI_FLAG_TABLE_ARRAYS = 0x4000, /*!< Decoded PAT, PMT and SDT tables
+                                       store their entries in an array and
+                                       their descriptors one after the other,
+                                       see dvbpsi_set_flags() */
 };
 
 /*****************************************************************************
@@ -167,6 +622,13 @@ struct dvbpsi_s
  *
  * Creates a handle to use with PSI decoder and encoder API functions. The
  * handle must be freed with dvbpsi_delete().
+ *
+ * A handle and what is attached to it are used by one thread at a time.
+ * The library has no other mutable state shared between handles besides
+ * the allocator: the dvbpsi_xxx_sections_generate() functions may run
+ * concurrently with distinct handles, on tables that are not modified
+ * meanwhile, provided that the message callback and the allocator are
+ * thread safe. See dvbpsi_bulk_generate().
  */
 dvbpsi_t *dvbpsi_new(dvbpsi_message_cb callback, enum dvbpsi_msg_level level);
 
@@ -184,6 +646,751 @@ dvbpsi_t *dvbpsi_new(dvbpsi_message_cb callback, enum dvbpsi_msg_level level);
  */
 void dvbpsi_delete(dvbpsi_t *p_dvbpsi);
 
+/*****************************************************************************
+ * dvbpsi_allocator_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_allocator_s
+ * \brief Memory allocator used by libdvbpsi, see dvbpsi_set_allocator()
+ */
+/*!
+ * \typedef struct dvbpsi_allocator_s dvbpsi_allocator_t
+ * \brief dvbpsi_allocator_t type definition.
+ */
+typedef struct dvbpsi_allocator_s
+{
+    void *(*pf_malloc)(size_t i_size, void *p_data);     /*!< malloc() */
+    void *(*pf_calloc)(size_t i_count, size_t i_size,
+                       void *p_data);                     /*!< calloc(), may be
+                                                              NULL */
+    void  (*pf_free)(void *p_ptr, void *p_data);          /*!< free() */
+    void  *p_data;                                        /*!< private data
+                                                              given to the
+                                                              functions */
+} dvbpsi_allocator_t;
+
+/*****************************************************************************
+ * dvbpsi_set_allocator
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_set_allocator(const dvbpsi_allocator_t *p_allocator)
+ * \brief Sets the memory allocator of the library
+ * \param p_allocator allocator functions, NULL for malloc(), calloc() and free()
+ * \return true if the allocator was set, false if pf_malloc or pf_free is NULL
+ *
+ * Every handle, decoder, section, descriptor, table and decoded descriptor
+ * of the library is allocated and freed with these functions. When pf_calloc
+ * is NULL, pf_malloc is used and the memory cleared. The allocator is global:
+ * set it before any libdvbpsi call and only change it once everything it
+ * allocated has been freed. Tables and descriptors given to libdvbpsi to be
+ * freed, for instance by dvbpsi_pat_delete(), must be allocated with it too.
+ */
+bool dvbpsi_set_allocator(const dvbpsi_allocator_t *p_allocator);
+
+/*****************************************************************************
+ * dvbpsi_pool_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_pool_s dvbpsi_pool_t
+ * \brief dvbpsi_pool_t type definition, an opaque pool of handles and
+ * decoders.
+ */
+typedef struct dvbpsi_pool_s dvbpsi_pool_t;
+
+/*****************************************************************************
+ * dvbpsi_pool_stats_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_pool_stats_s
+ * \brief Counters of a pool, see dvbpsi_pool_get_stats()
+ */
+/*!
+ * \typedef struct dvbpsi_pool_stats_s dvbpsi_pool_stats_t
+ * \brief dvbpsi_pool_stats_t type definition.
+ */
+typedef struct dvbpsi_pool_stats_s
+{
+    uint64_t     i_reused;    /*!< objects taken from the pool */
+    uint64_t     i_allocated; /*!< objects allocated as the pool had none */
+    unsigned int i_idle;      /*!< objects kept by the pool */
+} dvbpsi_pool_stats_t;
+
+/*****************************************************************************
+ * dvbpsi_pool_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_pool_t *dvbpsi_pool_new(unsigned int i_max)
+ * \brief Creates a pool recycling the handles and decoders of a thread
+ * \param i_max maximum number of idle objects kept, the others being freed
+ * \return pointer to the pool, or NULL on error or without compiler support
+ *         for thread local storage
+ *
+ * While a thread has entered the pool with dvbpsi_pool_enter(),
+ * dvbpsi_delete() and dvbpsi_decoder_delete(), and so the detach functions
+ * of all the tables and the demux, give their objects to the pool instead
+ * of freeing them, and dvbpsi_new() and dvbpsi_decoder_new(), and so the
+ * attach functions, take them back. Objects are kept by kind and size,
+ * every table type having its own decoders. A reused object starts afresh,
+ * as a new one, with dvbpsi_decoder_reset() semantics for a decoder, but it
+ * keeps its allocations: the section buffers of a handle and the section
+ * index of a decoder. This takes attach and detach out of the allocator
+ * when PMT decoders follow the PAT changes of a dynamic multiplex or as EIT
+ * subtable decoders come and go on a demux.
+ */
+dvbpsi_pool_t *dvbpsi_pool_new(unsigned int i_max);
+
+/*****************************************************************************
+ * dvbpsi_pool_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_pool_delete(dvbpsi_pool_t *p_pool)
+ * \brief Frees a pool and the objects it keeps
+ * \param p_pool pointer to the pool, which no thread may have entered
+ * \return nothing
+ */
+void dvbpsi_pool_delete(dvbpsi_pool_t *p_pool);
+
+/*****************************************************************************
+ * dvbpsi_pool_enter
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_pool_t *dvbpsi_pool_enter(dvbpsi_pool_t *p_pool)
+ * \brief Makes a pool the one of the running thread
+ * \param p_pool pointer to the pool, NULL to leave the pool entered
+ * \return the pool previously entered, or NULL
+ *
+ * A pool is not thread safe and may only be entered by one thread at a
+ * time. The handles and decoders it gives back may have been created with
+ * no pool entered or with another pool, and may be deleted on another
+ * thread later on.
+ */
+dvbpsi_pool_t *dvbpsi_pool_enter(dvbpsi_pool_t *p_pool);
+
+/*****************************************************************************
+ * dvbpsi_pool_get_stats
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_pool_get_stats(const dvbpsi_pool_t *p_pool,
+ *                                 dvbpsi_pool_stats_t *p_stats)
+ * \brief Gets the counters of a pool
+ * \param p_pool pointer to the pool
+ * \param p_stats receives the counters
+ * \return nothing
+ */
+void dvbpsi_pool_get_stats(const dvbpsi_pool_t *p_pool, dvbpsi_pool_stats_t *p_stats);
+
+/*****************************************************************************
+ * dvbpsi_mem_category_t
+ *****************************************************************************/
+/*!
+ * \enum dvbpsi_mem_category_e
+ * \brief Owners of the memory of the library, see dvbpsi_mem_stats()
+ */
+/*!
+ * \typedef enum dvbpsi_mem_category_e dvbpsi_mem_category_t
+ * \brief dvbpsi_mem_category_t type definition.
+ */
+typedef enum dvbpsi_mem_category_e
+{
+    DVBPSI_MEM_SECTION = 0,     /*!< sections being assembled or built */
+    DVBPSI_MEM_SECTION_LIST,    /*!< sections kept by a decoder until its
+                                     table is complete, or by a table of
+                                     DVBPSI_FLAG_LAZY_DECODE */
+    DVBPSI_MEM_TABLE,           /*!< decoded tables, their entries and
+                                     table arenas */
+    DVBPSI_MEM_DESCRIPTOR,      /*!< descriptors */
+    DVBPSI_MEM_DECODED_DR,      /*!< decoded descriptor structures */
+    DVBPSI_MEM_DECODER,         /*!< handles, decoders and their caches */
+    DVBPSI_MEM_POOL,            /*!< idle objects kept by the pools */
+    DVBPSI_MEM_OTHER,           /*!< everything else: demux, services... */
+    DVBPSI_MEM_CATEGORY_MAX     /*!< number of categories */
+} dvbpsi_mem_category_t;
+
+/*****************************************************************************
+ * dvbpsi_mem_stats_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_mem_stats_s
+ * \brief Live memory of the library by category, see dvbpsi_mem_stats()
+ */
+/*!
+ * \typedef struct dvbpsi_mem_stats_s dvbpsi_mem_stats_t
+ * \brief dvbpsi_mem_stats_t type definition.
+ */
+typedef struct dvbpsi_mem_stats_s
+{
+    uint64_t i_bytes[DVBPSI_MEM_CATEGORY_MAX];  /*!< bytes allocated */
+    uint64_t i_count[DVBPSI_MEM_CATEGORY_MAX];  /*!< allocated blocks */
+} dvbpsi_mem_stats_t;
+
+/*****************************************************************************
+ * dvbpsi_mem_stats
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_mem_stats(dvbpsi_mem_stats_t *p_stats)
+ * \brief Gets the memory the library holds, by owner
+ * \param p_stats receives the live blocks and bytes of each category
+ * \return true, or false when the library was not configured with
+ *         --enable-mem-stats, p_stats being then cleared
+ *
+ * An instrumented library records every block it allocates, with its size
+ * and the category of the code that allocated it. A block changes category
+ * as its owner changes: a section kept by a decoder moves to
+ * DVBPSI_MEM_SECTION_LIST, an object given to a pool to DVBPSI_MEM_POOL. The
+ * counts are global, for all the handles of all the threads, and sampled
+ * under a lock, so comparing two calls shows what grew in between, like an
+ * EIT decoder whose tables never complete. Memory of a table arena is
+ * counted by chunk. The recording costs a lookup per allocation and per
+ * free, the normal library only has this function.
+ */
+bool dvbpsi_mem_stats(dvbpsi_mem_stats_t *p_stats);
+
+/*****************************************************************************
+ * dvbpsi_mem_category_name
+ *****************************************************************************/
+/*!
+ * \fn const char *dvbpsi_mem_category_name(dvbpsi_mem_category_t i_category)
+ * \brief Gets the name of a memory category
+ * \param i_category category
+ * \return a short name, like "section_list", or "unknown"
+ */
+const char *dvbpsi_mem_category_name(dvbpsi_mem_category_t i_category);
+
+/*****************************************************************************
+ * dvbpsi_set_flags
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_set_flags(dvbpsi_t *p_dvbpsi, uint32_t i_flags)
+ * \brief Sets the decoding options of a dvbpsi_t handle
+ * \param p_dvbpsi pointer to dvbpsi_t handle
+ * \param i_flags or'ed enum dvbpsi_flag values, 0 by default
+ * \return nothing
+ *
+ * With DVBPSI_FLAG_ZERO_COPY a section contained in one TS packet is not
+ * copied: the decoder gets a borrowed section pointing into the packet given
+ * to dvbpsi_packet_push(), valid until that call returns.
+ * dvbpsi_decoder_psi_section_add() copies such a section before keeping it
+ * and dvbpsi_DeletePSISections() ignores it, so decoders built on these
+ * functions need no change.
+ *
+ * With DVBPSI_FLAG_SKIP_UNCHANGED the header of each new section is looked
+ * at in the first TS packet. A section of the table version the decoder has
+ * already decoded, while no new version is being assembled, is skipped: it
+ * is neither copied nor CRC checked, the decoder would drop it anyway.
+ * See dvbpsi_set_verify_interval() to still fully check some of them.
+ *
+ * With DVBPSI_FLAG_CRC_CACHE each decoder remembers the CRC_32 of every
+ * section of its last decoded table. An assembled section carrying the same
+ * CRC_32 as the cached one for its section_number is dropped before its CRC
+ * is even computed. This also holds after a discontinuity, where decoders
+ * would otherwise decode and signal the same table again.
+ *
+ * With DVBPSI_FLAG_DROP_ERRORED a TS packet with the transport_error_indicator
+ * set drops the section being assembled at once, instead of when its CRC_32
+ * fails, and the continuity counter is resynchronised on the next packet.
+ * PSI is never scrambled: a packet with a non zero transport_scrambling_control
+ * is ignored.
+ *
+ * With DVBPSI_FLAG_TABLE_ARENA the PMT, SDT, EIT, NIT and BAT decoders
+ * allocate each table, its entries and descriptors from a private arena.
+ * dvbpsi_*_delete() releases it in one go and only frees separately what was
+ * allocated after the table was signaled, like decoded descriptors. The
+ * option needs compiler support for thread local storage and is ignored
+ * otherwise.
+ *
+ * With DVBPSI_FLAG_LAZY_DECODE the PMT, SDT, EIT, NIT and BAT decoders skip
+ * the decoding of complete tables. The callback receives the table with its
+ * header fields set, empty lists and the sections in p_sections, which the
+ * table owns. The loops can be walked without allocation through
+ * dvbpsi_*_section_iter(), dvbpsi_*_decode() fills the lists on request.
+ * dvbpsi_nit_decode_step() and dvbpsi_bat_decode_step() fill them a few
+ * sections at a time, to decode a large table outside dvbpsi_packet_push()
+ * without stalling the packets.
+ *
+ * With DVBPSI_FLAG_DESCRIPTOR_CACHE the SDT and NIT decoders decode every
+ * descriptor they know, see dvbpsi_decode_descriptors(), before signaling
+ * the table. The decoded form of a descriptor whose bytes did not change
+ * since the previous table of the decoder is duplicated instead of decoded
+ * again. The option is ignored with DVBPSI_FLAG_LAZY_DECODE.
+ *
+ * With DVBPSI_FLAG_INTERN_DESCRIPTORS the SDT, NIT and BAT decoders store the
+ * content of identical descriptors of a table once. Each descriptor keeps
+ * its own dvbpsi_descriptor_t, whose p_data points to the shared content,
+ * which must then be treated as read only. The content is freed with the
+ * last descriptor using it. The option needs compiler support for thread
+ * local storage and is ignored otherwise, and with DVBPSI_FLAG_LAZY_DECODE.
+ *
+ * With DVBPSI_FLAG_ENCODER_CACHE dvbpsi_BuildPSISection(), which the table
+ * generators call on each section, keeps the last encoding of each section
+ * generated with the handle, by table_id, table_id_extension and
+ * section_number. A section whose content is the same as its previous
+ * encoding, the version_number aside, gets its CRC_32 derived from the
+ * previous one instead of computed and checked over the whole section. The
+ * memory grows with the number of different sections generated, until the
+ * handle is deleted.
+ *
+ * With DVBPSI_FLAG_TABLE_INDEX the NIT and BAT decoders build the index of
+ * dvbpsi_nit_index() and dvbpsi_bat_index() on each table they decode, for
+ * O(1) lookups of its transport streams and services, and the ATSC VCT
+ * decoder builds the index of dvbpsi_atsc_vct_index() for lookups of its
+ * channels by number, source_id and program. The option is ignored with
+ * DVBPSI_FLAG_LAZY_DECODE, the index being built on request.
+ *
+ * With DVBPSI_FLAG_COMPACT, meant for processes following thousands of PIDs,
+ * the handle keeps no free section buffer of its own: the buffer of a
+ * section is taken when the section starts and given back when it
+ * completes, to the pool of dvbpsi_pool_enter(), which all the handles of
+ * the thread share, or to the allocator without one. A decoder also frees
+ * its section index when its sections are cleared, so that an idle decoder
+ * is down to its table version, continuity counter and, with
+ * DVBPSI_FLAG_CRC_CACHE, the CRC_32 of its sections.
+ *
+ * With DVBPSI_FLAG_REPETITION each subtable decoder keeps the arrival time
+ * of the last copy of each of its sections and the intervals between two
+ * copies, see dvbpsi_get_repetition(). Sections skipped by
+ * DVBPSI_FLAG_SKIP_UNCHANGED or DVBPSI_FLAG_CRC_CACHE are measured as well.
+ *
+ * With DVBPSI_FLAG_KEEP_SECTIONS a continuity counter error only drops the
+ * section being assembled. The sections the decoder has gathered passed
+ * their CRC_32 and stand on their own, they are kept, so that a large
+ * subtable like an EIT schedule still completes on a noisy input. A new
+ * version still replaces them as usual. A discontinuity signalled by the
+ * discontinuity_indicator of the adaptation_field is not reported as an
+ * error.
+ *
+ * With DVBPSI_FLAG_LAST_SECTIONS each subtable decoder keeps a copy of the
+ * sections of the last complete current table, see
+ * dvbpsi_get_last_sections().
+ *
+ * With DVBPSI_FLAG_TABLE_ARRAYS the PAT, PMT and SDT decoders allocate each
+ * table in an arena, as with DVBPSI_FLAG_TABLE_ARENA, and size its entries
+ * from the loop lengths of its sections when they decode it. The programs,
+ * ESs or services are then stored in one array, i_program_count,
+ * i_es_count or i_service_count entries long from p_first_program,
+ * p_first_es or p_first_service, and the descriptors of the table one
+ * after the other in a single block. The p_next links still hold, as for
+ * the lists. The counts are 0 for tables decoded otherwise and do not
+ * cover the entries added later. Identical descriptors do not share their
+ * content. The option needs compiler support for thread local storage and
+ * is ignored otherwise.
+ */
+void dvbpsi_set_flags(dvbpsi_t *p_dvbpsi, uint32_t i_flags);
+
+/*****************************************************************************
+ * dvbpsi_set_section_filter
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_set_section_filter(dvbpsi_t *p_dvbpsi,
+ *                                    const dvbpsi_section_filter_t *p_filter)
+ * \brief Sets the filter sections must match to be given to the decoder
+ * \param p_dvbpsi pointer to dvbpsi_t handle
+ * \param p_filter filter, copied, NULL to accept all sections again
+ * \return nothing
+ *
+ * Like a Linux DVB section filter, it is applied to the header of each new
+ * section in the first TS packet: a section that does not match is walked
+ * over without being copied, allocated or CRC checked. When the header
+ * straddles two TS packets the section is dropped once assembled, before
+ * its CRC_32 is checked. Typical use is a demux on PID 0x12 keeping only the
+ * EIT present/following tables, table_id 0x4e with mask 0xfe.
+ */
+void dvbpsi_set_section_filter(dvbpsi_t *p_dvbpsi,
+                               const dvbpsi_section_filter_t *p_filter);
+
+/*****************************************************************************
+ * dvbpsi_set_eit_window/dvbpsi_eit_window_init
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_set_eit_window(dvbpsi_t *p_dvbpsi,
+ *                                const dvbpsi_eit_window_t *p_window)
+ * \brief Sets the segments of the EIT schedule tables given to the decoder
+ * \param p_dvbpsi pointer to dvbpsi_t handle
+ * \param p_window window, copied, NULL to accept all segments again
+ * \return nothing
+ *
+ * Applied to the headers like the section filter, see
+ * dvbpsi_set_section_filter(), and counted in i_dropped_filtered: an EIT
+ * schedule section out of the window is walked over without being copied,
+ * allocated or CRC checked. The other sections are not affected. A
+ * schedule table then never completes, its segments in the window being
+ * given by dvbpsi_eit_set_segment_callback(). The segments are relative to
+ * the day: the window is set again after 00:00 UTC.
+ */
+void dvbpsi_set_eit_window(dvbpsi_t *p_dvbpsi, const dvbpsi_eit_window_t *p_window);
+
+/*!
+ * \fn void dvbpsi_eit_window_init(dvbpsi_eit_window_t *p_window,
+ *                                 int64_t i_utc, unsigned int i_hours)
+ * \brief Fills a window with the segments of the next hours
+ * \param p_window window
+ * \param i_utc current time, in seconds since 1970-01-01 UTC, from a TDT
+ *        with dvbpsi_mjd_to_utc() for instance
+ * \param i_hours hours of schedule kept from i_utc, 0 for the current
+ *        segment only
+ * \return nothing
+ *
+ * The window starts with the segment of i_utc and ends with the one of
+ * i_hours later, or the last one.
+ */
+void dvbpsi_eit_window_init(dvbpsi_eit_window_t *p_window, int64_t i_utc,
+                            unsigned int i_hours);
+
+/*****************************************************************************
+ * dvbpsi_table_priority
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_priority_t dvbpsi_table_priority(uint8_t i_table_id)
+ * \brief Gives the priority of the sections of a table under overload
+ * \param i_table_id table_id of the sections
+ * \return the priority, DVBPSI_PRIORITY_SHEDDABLE for an unknown table_id
+ */
+dvbpsi_priority_t dvbpsi_table_priority(uint8_t i_table_id);
+
+/*****************************************************************************
+ * dvbpsi_set_shed_level
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_set_shed_level(dvbpsi_t *p_dvbpsi,
+ *                                dvbpsi_shed_level_t i_level)
+ * \brief Sets the sections a handle drops to catch up under overload
+ * \param p_dvbpsi pointer to dvbpsi_t handle
+ * \param i_level shed level, DVBPSI_SHED_NONE by default
+ * \return nothing
+ *
+ * The sections whose table priority, see dvbpsi_table_priority(), is shed
+ * are dropped on their header like those of the section filter, see
+ * dvbpsi_set_section_filter(), and counted in
+ * dvbpsi_stats_t::i_dropped_shed. The decoders of the tables kept go on
+ * unaffected, those of the tables shed simply see no section until the
+ * level is lowered again.
+ */
+void dvbpsi_set_shed_level(dvbpsi_t *p_dvbpsi, dvbpsi_shed_level_t i_level);
+
+/*****************************************************************************
+ * dvbpsi_get_shed_level
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_shed_level_t dvbpsi_get_shed_level(const dvbpsi_t *p_dvbpsi)
+ * \brief Gets the shed level of a handle, see dvbpsi_set_shed_level()
+ * \param p_dvbpsi pointer to dvbpsi_t handle
+ * \return the shed level
+ */
+dvbpsi_shed_level_t dvbpsi_get_shed_level(const dvbpsi_t *p_dvbpsi);
+
+/*****************************************************************************
+ * dvbpsi_shed_level_update
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_shed_level_t dvbpsi_shed_level_update(dvbpsi_shed_level_t i_level,
+ *                                                  unsigned int i_backlog)
+ * \brief Gives the shed level following a measure of the load
+ * \param i_level current shed level
+ * \param i_backlog load, in percent: the fill of the capture queue, or the
+ *        part of its CPU budget the application uses
+ * \return the new shed level
+ *
+ * The sheddable tables are dropped from 50% on, the normal ones as well
+ * from 75% on. Each level is kept until the load is 25% below its
+ * threshold, so that the level does not flip with every measure. One
+ * level is usually computed for all the handles of a stream, and given
+ * to each with dvbpsi_set_shed_level() when it changes.
+ */
+dvbpsi_shed_level_t dvbpsi_shed_level_update(dvbpsi_shed_level_t i_level,
+                                             unsigned int i_backlog);
+
+/*****************************************************************************
+ * dvbpsi_set_packet_format
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_set_packet_format(dvbpsi_t *p_dvbpsi,
+ *                                   dvbpsi_packet_format_t i_format)
+ * \brief Sets the framing of the packets pushed into a dvbpsi_t handle
+ * \param p_dvbpsi pointer to dvbpsi_t handle
+ * \param i_format packet framing, DVBPSI_PACKET_TS by default
+ * \return nothing
+ *
+ * dvbpsi_packet_push() and dvbpsi_packets_push() then take pointers to the
+ * 192 or 204 bytes packets as they are read, with no repacking: the TS
+ * packet is found at its offset and the default stride is the framed
+ * packet size. For DVBPSI_PACKET_M2TS packets pushed without a timestamp
+ * the arrival time stamp, extended to 64 bits, is used as arrival time, in
+ * 27 MHz ticks, see dvbpsi_get_latency_histogram().
+ */
+void dvbpsi_set_packet_format(dvbpsi_t *p_dvbpsi, dvbpsi_packet_format_t i_format);
+
+/*****************************************************************************
+ * dvbpsi_get_packet_size
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_get_packet_size(dvbpsi_packet_format_t i_format)
+ * \brief Size in bytes of the packets of a framing
+ * \param i_format packet framing
+ * \return 188, 192 or 204
+ */
+size_t dvbpsi_get_packet_size(dvbpsi_packet_format_t i_format);
+
+/*****************************************************************************
+ * dvbpsi_get_stats
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_get_stats(dvbpsi_t *p_dvbpsi, dvbpsi_stats_t *p_stats)
+ * \brief Gets the performance counters of a dvbpsi_t handle
+ * \param p_dvbpsi pointer to dvbpsi_t handle
+ * \param p_stats receives the counters, accumulated since dvbpsi_new()
+ * \return nothing
+ *
+ * The counters are plain increments on the decoding path, they cost next to
+ * nothing and need no message level. CC errors and other events are counted
+ * separately, see dvbpsi_get_event_count().
+ */
+void dvbpsi_get_stats(dvbpsi_t *p_dvbpsi, dvbpsi_stats_t *p_stats);
+
+/*****************************************************************************
+ * dvbpsi_get_latency_histogram
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_get_latency_histogram(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+ *                                       uint64_t pi_buckets[DVBPSI_LATENCY_BUCKETS])
+ * \brief Gets the decoding latency histogram of a table_id
+ * \param p_dvbpsi pointer to dvbpsi_t handle
+ * \param i_table_id table_id
+ * \param pi_buckets receives the number of tables per latency bucket
+ * \return false if no latency was recorded on the handle yet
+ *
+ * The latency of a table is the time from the first TS packet of the
+ * section completing it to the table callback, in the unit of the
+ * timestamps given to dvbpsi_packet_push_at(). It is only recorded when
+ * both packets were pushed with a timestamp. Bucket 0 counts latencies of 0,
+ * bucket i latencies from 2^(i-1) to 2^i - 1, the last bucket also counts
+ * all longer ones.
+ */
+bool dvbpsi_get_latency_histogram(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                                  uint64_t pi_buckets[DVBPSI_LATENCY_BUCKETS]);
+
+/*****************************************************************************
+ * dvbpsi_get_repetition
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_get_repetition(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+ *                                uint16_t i_extension, uint8_t i_number,
+ *                                dvbpsi_repetition_t *p_repetition)
+ * \brief Gets the repetition of a section, see DVBPSI_FLAG_REPETITION
+ * \param p_dvbpsi pointer to dvbpsi_t handle
+ * \param i_table_id table_id
+ * \param i_extension table_id_extension, ignored by decoders of a single
+ *        subtable
+ * \param i_number section_number, 0 for sections without one
+ * \param p_repetition receives the intervals
+ * \return false if the section was never received with a timestamp
+ *
+ * The arrival time of a copy is that of its first TS packet, given to
+ * dvbpsi_packet_push_at() or dvbpsi_packets_push_at(), or the arrival time
+ * stamp of an M2TS packet. Only valid copies are counted: a section is measured once its CRC_32 is checked, or
+ * when it is skipped before assembly. The intervals are those of all the
+ * versions of the subtable, which is what the maximum repetition intervals
+ * of ETSI TR 101 211 apply to.
+ */
+bool dvbpsi_get_repetition(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                           uint16_t i_extension, uint8_t i_number,
+                           dvbpsi_repetition_t *p_repetition);
+
+/*****************************************************************************
+ * dvbpsi_get_last_sections
+ *****************************************************************************/
+/*!
+ * \fn const struct dvbpsi_psi_section_s *dvbpsi_get_last_sections(
+ *                                  dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+ *                                  uint16_t i_extension)
+ * \brief Gets the sections of the last complete table, see
+ *        DVBPSI_FLAG_LAST_SECTIONS
+ * \param p_dvbpsi pointer to dvbpsi_t handle
+ * \param i_table_id table_id
+ * \param i_extension table_id_extension, ignored by decoders of a single
+ *        subtable
+ * \return the sections, in section_number order, or NULL if no current
+ *         table with section syntax was completed since the flag was set
+ *
+ * The sections are those received, whose CRC_32 was checked: they can be
+ * given as they are to dvbpsi_packetizer_push() to serve a client joining
+ * the stream without decoding and generating the table again. They survive
+ * discontinuities and resets of the decoder, a new version of the table
+ * replaces them. They are valid until the next TS packet is pushed to the
+ * handle or the decoder is detached.
+ */
+const struct dvbpsi_psi_section_s *dvbpsi_get_last_sections(dvbpsi_t *p_dvbpsi,
+                                                            uint8_t i_table_id,
+                                                            uint16_t i_extension);
+
+/*****************************************************************************
+ * dvbpsi_fingerprint_init/dvbpsi_set_fingerprint
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_fingerprint_init(dvbpsi_fingerprint_t *p_fingerprint)
+ * \brief Empties a fingerprint
+ * \param p_fingerprint pointer to the fingerprint
+ * \return nothing
+ */
+void dvbpsi_fingerprint_init(dvbpsi_fingerprint_t *p_fingerprint);
+
+/*!
+ * \fn void dvbpsi_set_fingerprint(dvbpsi_t *p_dvbpsi,
+ *                                 dvbpsi_fingerprint_t *p_fingerprint)
+ * \brief Adds the sections of a dvbpsi_t handle to a fingerprint
+ * \param p_dvbpsi pointer to dvbpsi_t handle
+ * \param p_fingerprint initialized fingerprint, NULL to stop
+ * \return nothing
+ *
+ * Every section whose CRC_32 is checked, or matched by
+ * DVBPSI_FLAG_CRC_CACHE, updates the fingerprint. Sections skipped by
+ * DVBPSI_FLAG_SKIP_UNCHANGED are not seen. The handles of the PIDs of a
+ * stream may share one fingerprint, if they are used by the same thread.
+ * The fingerprint must outlive its use by the handle.
+ */
+void dvbpsi_set_fingerprint(dvbpsi_t *p_dvbpsi, dvbpsi_fingerprint_t *p_fingerprint);
+
+/*****************************************************************************
+ * dvbpsi_fingerprint_equal/dvbpsi_fingerprint_compare
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_fingerprint_equal(const dvbpsi_fingerprint_t *p_a,
+ *                                   const dvbpsi_fingerprint_t *p_b)
+ * \brief Tells in constant time whether two streams carry the same sections
+ * \param p_a first fingerprint
+ * \param p_b second fingerprint
+ * \return true if both have as many sections and the same hash.
+ */
+bool dvbpsi_fingerprint_equal(const dvbpsi_fingerprint_t *p_a,
+                              const dvbpsi_fingerprint_t *p_b);
+
+/*!
+ * \fn unsigned int dvbpsi_fingerprint_compare(const dvbpsi_fingerprint_t *p_a,
+ *                                             const dvbpsi_fingerprint_t *p_b)
+ * \brief Counts the sections two streams have in common
+ * \param p_a first fingerprint
+ * \param p_b second fingerprint
+ * \return the number of sections of p_a found in p_b with the same CRC_32.
+ *
+ * Unlike dvbpsi_fingerprint_equal(), it tells how close two streams are
+ * while one of them is still receiving, or after a change reached only one
+ * of them.
+ */
+unsigned int dvbpsi_fingerprint_compare(const dvbpsi_fingerprint_t *p_a,
+                                        const dvbpsi_fingerprint_t *p_b);
+
+/*****************************************************************************
+ * dvbpsi_set_event_cb
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_set_event_cb(dvbpsi_t *p_dvbpsi, dvbpsi_event_cb pf_event,
+ *                              void *p_cb_data)
+ * \brief Sets a typed event callback on a dvbpsi_t handle
+ * \param p_dvbpsi pointer to dvbpsi_t handle
+ * \param pf_event event callback, NULL to disable it
+ * \param p_cb_data private data given to pf_event
+ * \return nothing
+ *
+ * Events are signaled in addition to, and independently of, the messages.
+ * They are counted by type whether a callback is set or not, see
+ * dvbpsi_get_event_count().
+ */
+void dvbpsi_set_event_cb(dvbpsi_t *p_dvbpsi, dvbpsi_event_cb pf_event,
+                         void *p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_set_section_tap
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_set_section_tap(dvbpsi_t *p_dvbpsi,
+ *                                 dvbpsi_section_tap_cb pf_tap,
+ *                                 void *p_cb_data)
+ * \brief Sets a callback seeing the valid sections before their decoder
+ * \param p_dvbpsi pointer to dvbpsi_t handle
+ * \param pf_tap tap callback, NULL to disable it
+ * \param p_cb_data private data given to pf_tap
+ * \return nothing
+ *
+ * The callback gets each section that passed the section filter and its
+ * CRC_32 check, including the copies dropped by DVBPSI_FLAG_CRC_CACHE, just
+ * before it is handed to the decoder. The copies skipped before assembly by
+ * DVBPSI_FLAG_SKIP_UNCHANGED are not seen. It is the recording hook of the
+ * section logs, see seclog.h.
+ */
+void dvbpsi_set_section_tap(dvbpsi_t *p_dvbpsi, dvbpsi_section_tap_cb pf_tap,
+                            void *p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_set_changelog
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_set_changelog(dvbpsi_t *p_dvbpsi,
+ *                               struct dvbpsi_changelog_s *p_log)
+ * \brief Sets the change log the new versions accepted by the decoders of a
+ *        handle are appended to, see changelog.h
+ * \param p_dvbpsi pointer to dvbpsi_t handle
+ * \param p_log change log, NULL to stop logging
+ * \return nothing
+ *
+ * A change is appended each time a decoder completes a table of another
+ * version_number than the last one of its subtable, or its first one, with
+ * the PID of the TS packets. The handles of a router, or any handles given
+ * data by the same thread, can share one log and its sequence numbers.
+ */
+void dvbpsi_set_changelog(dvbpsi_t *p_dvbpsi, struct dvbpsi_changelog_s *p_log);
+
+/*****************************************************************************
+ * dvbpsi_get_event_count
+ *****************************************************************************/
+/*!
+ * \fn uint64_t dvbpsi_get_event_count(dvbpsi_t *p_dvbpsi,
+ *                                     dvbpsi_event_type_t i_type)
+ * \brief Gets the number of events of a type seen on a dvbpsi_t handle
+ * \param p_dvbpsi pointer to dvbpsi_t handle
+ * \param i_type event type
+ * \return the number of events
+ */
+uint64_t dvbpsi_get_event_count(dvbpsi_t *p_dvbpsi, dvbpsi_event_type_t i_type);
+
+/*****************************************************************************
+ * dvbpsi_get_crc_cache_stats
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_get_crc_cache_stats(dvbpsi_t *p_dvbpsi, uint64_t *pi_hits,
+ *                                     uint64_t *pi_misses)
+ * \brief Gets the DVBPSI_FLAG_CRC_CACHE counters of a dvbpsi_t handle
+ * \param p_dvbpsi pointer to dvbpsi_t handle
+ * \param pi_hits if not NULL, receives the number of dropped sections
+ * \param pi_misses if not NULL, receives the number of sections that went on
+ *        to be checked and decoded
+ * \return nothing
+ */
+void dvbpsi_get_crc_cache_stats(dvbpsi_t *p_dvbpsi, uint64_t *pi_hits,
+                                uint64_t *pi_misses);
+
+/*****************************************************************************
+ * dvbpsi_set_verify_interval
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_set_verify_interval(dvbpsi_t *p_dvbpsi, unsigned int i_interval)
+ * \brief Sets how often a skipped section is fully checked
+ * \param p_dvbpsi pointer to dvbpsi_t handle
+ * \param i_interval with DVBPSI_FLAG_SKIP_UNCHANGED, every i_interval-th
+ *        section of a known table is assembled and CRC checked as usual so
+ *        that corruption is still reported. 0 (default) never checks.
+ * \return nothing
+ */
+void dvbpsi_set_verify_interval(dvbpsi_t *p_dvbpsi, unsigned int i_interval);
+
+/*****************************************************************************
+ * dvbpsi_get_flags
+ *****************************************************************************/
+/*!
+ * \fn uint32_t dvbpsi_get_flags(dvbpsi_t *p_dvbpsi)
+ * \brief Gets the decoding options of a dvbpsi_t handle
+ * \param p_dvbpsi pointer to dvbpsi_t handle
+ * \return or'ed enum dvbpsi_flag values
+ */
+uint32_t dvbpsi_get_flags(dvbpsi_t *p_dvbpsi);
+
 /*****************************************************************************
  * dvbpsi_packet_push
  *****************************************************************************/
@@ -194,10 +1401,117 @@ void dvbpsi_delete(dvbpsi_t *p_dvbpsi);
  * \param p_data pointer to a 188 bytes playload of a TS packet
  * \return true when packet has been handled, false on error.
  *
- * Injection of a TS packet into a PSI decoder.
+ * Injection of a TS packet into a PSI decoder. For a handle set to another
+ * packet format p_data points to the 192 or 204 bytes framed packet, see
+ * dvbpsi_set_packet_format().
  */
 bool dvbpsi_packet_push(dvbpsi_t *p_dvbpsi, uint8_t* p_data);
 
+/*****************************************************************************
+ * dvbpsi_packet_push_at
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_packet_push_at(dvbpsi_t *p_dvbpsi, uint8_t* p_data,
+ *                                int64_t i_time)
+ * \brief dvbpsi_packet_push() with the arrival time of the packet.
+ * \param p_dvbpsi handle to dvbpsi with attached decoder
+ * \param p_data pointer to a 188 bytes playload of a TS packet
+ * \param i_time arrival time, in any monotonic unit of the caller
+ * \return true when packet has been handled, false on error.
+ *
+ * Sections remember the arrival time of their first packet and the
+ * decoding latency of the tables is recorded, see
+ * dvbpsi_get_latency_histogram().
+ */
+bool dvbpsi_packet_push_at(dvbpsi_t *p_dvbpsi, uint8_t* p_data, int64_t i_time);
+
+/*****************************************************************************
+ * dvbpsi_packets_push
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_packets_push(dvbpsi_t *p_dvbpsi, uint8_t *p_data,
+ *                              size_t i_count, size_t i_stride)
+ * \brief Injection of a run of TS packets into a PSI decoder.
+ * \param p_dvbpsi handle to dvbpsi with attached decoder
+ * \param p_data pointer to the first of 'i_count' TS packets
+ * \param i_count number of TS packets in the buffer
+ * \param i_stride distance in bytes between the start of two successive
+ *        packets, 0 means the packet size of the handle format, see
+ *        dvbpsi_set_packet_format()
+ * \return false when at least one packet was not a TS packet, true otherwise.
+ *
+ * Equivalent to calling dvbpsi_packet_push() for each packet, the format and
+ * stride being only looked at once for the whole run. All packets must
+ * belong to the PID of the attached decoder. Packets that do not start with
+ * a sync byte are skipped and the remaining packets are still processed. A
+ * callback may detach the decoder or attach another one: the packets after
+ * the one delivering its section go to the decoder then attached, the run
+ * stopping if there is none.
+ */
+bool dvbpsi_packets_push(dvbpsi_t *p_dvbpsi, uint8_t *p_data,
+                         size_t i_count, size_t i_stride);
+
+/*****************************************************************************
+ * dvbpsi_packets_push_at
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_packets_push_at(dvbpsi_t *p_dvbpsi, uint8_t *p_data,
+ *                                 size_t i_count, size_t i_stride,
+ *                                 int64_t i_time)
+ * \brief dvbpsi_packets_push() with the arrival time of the packets.
+ * \param p_dvbpsi handle to dvbpsi with attached decoder
+ * \param p_data pointer to the first of 'i_count' TS packets
+ * \param i_count number of TS packets in the buffer
+ * \param i_stride distance in bytes between the start of two successive
+ *        packets, 0 means the packet size of the handle format
+ * \param i_time arrival time of the buffer, see dvbpsi_packet_push_at()
+ * \return false when at least one packet was not a TS packet, true otherwise.
+ */
+bool dvbpsi_packets_push_at(dvbpsi_t *p_dvbpsi, uint8_t *p_data,
+                            size_t i_count, size_t i_stride, int64_t i_time);
+
+/*****************************************************************************
+ * dvbpsi_section_push
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_section_push(dvbpsi_t *p_dvbpsi, uint8_t *p_data,
+ *                              size_t i_size)
+ * \brief Injection of a complete PSI section into a PSI decoder.
+ * \param p_dvbpsi handle to dvbpsi with attached decoder
+ * \param p_data pointer to the section, starting with its table_id
+ * \param i_size number of bytes available at p_data, at least the 3 header
+ *        bytes plus section_length
+ * \return false if the section is truncated or too long, true otherwise.
+ *
+ * For sections delivered already assembled, by a hardware section filter
+ * or over IP for instance. The section goes through the same checks (section
+ * filter, DVBPSI_FLAG_* options, CRC_32) and decoder dispatch as a section
+ * reassembled by dvbpsi_packet_push(), without any TS packet handling. Its
+ * events carry DVBPSI_EVENT_NO_PID. p_data only needs to stay valid during
+ * the call, with DVBPSI_FLAG_ZERO_COPY the section is decoded in place
+ * instead of being copied.
+ */
+bool dvbpsi_section_push(dvbpsi_t *p_dvbpsi, uint8_t *p_data, size_t i_size);
+
+/*****************************************************************************
+ * dvbpsi_section_push_at
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_section_push_at(dvbpsi_t *p_dvbpsi, uint8_t *p_data,
+ *                                 size_t i_size, int64_t i_time)
+ * \brief dvbpsi_section_push() with the arrival time of the section.
+ * \param p_dvbpsi handle to dvbpsi with attached decoder
+ * \param p_data pointer to the section, starting with its table_id
+ * \param i_size number of bytes available at p_data
+ * \param i_time arrival time, in any monotonic unit of the caller
+ * \return false if the section is truncated or too long, true otherwise.
+ *
+ * As dvbpsi_packet_push_at(), the decoding latency of the tables is
+ * recorded, see dvbpsi_get_latency_histogram().
+ */
+bool dvbpsi_section_push_at(dvbpsi_t *p_dvbpsi, uint8_t *p_data, size_t i_size,
+                            int64_t i_time);
+
 /*****************************************************************************
  * dvbpsi_psi_section_t
  *****************************************************************************/
@@ -208,6 +1522,12 @@ bool dvbpsi_packet_push(dvbpsi_t *p_dvbpsi, uint8_t* p_data);
  */
 typedef struct dvbpsi_psi_section_s dvbpsi_psi_section_t;
 
+/*!
+ * \typedef struct dvbpsi_section_buffer_s dvbpsi_section_buffer_t
+ * \brief dvbpsi_section_buffer_t type definition, see psi.h.
+ */
+typedef struct dvbpsi_section_buffer_s dvbpsi_section_buffer_t;
+
 /*****************************************************************************
  * dvbpsi_callback_gather_t
  *****************************************************************************/
@@ -245,6 +1565,26 @@ typedef void (* dvbpsi_callback_gather_t)(dvbpsi_t *p_dvbpsi,  /*!< pointer to d
     dvbpsi_callback_gather_t  pf_gather;/*!< PSI decoder's callback */            \
     int      i_section_max_size;   /*!< Max size of a section for this decoder */ \
     int      i_need;               /*!< Bytes needed */                           \
+    bool     b_skip_section;       /*!< Current section is being skipped */       \
+    bool     b_known;              /*!< The next members describe the last */    \
+                                   /*!< completed table */                        \
+    uint8_t  i_known_table_id;     /*!< table_id of the known table */            \
+    uint16_t i_known_extension;    /*!< table_id_extension of the known table */  \
+    uint8_t  i_known_version;      /*!< version_number of the known table */      \
+    bool     b_known_current_next; /*!< current_next of the known table */        \
+    unsigned int i_known_skipped;  /*!< Sections skipped since the last check */  \
+    unsigned int i_generation;     /*!< private, see dvbpsi_decoder_new() */      \
+    struct dvbpsi_crc_cache_s *p_crc_cache; /*!< private, CRC_32 of the */        \
+                                   /*!< known sections */                         \
+    struct dvbpsi_section_index_s *p_section_index; /*!< private, p_sections */   \
+                                   /*!< by section_number */                      \
+    struct dvbpsi_dr_cache_s *p_dr_cache; /*!< private, decoded descriptors */    \
+                                   /*!< of the known table */                     \
+    struct dvbpsi_repetitions_s *p_repetitions; /*!< private, see */              \
+                                   /*!< DVBPSI_FLAG_REPETITION */                 \
+    dvbpsi_psi_section_t *p_last_sections; /*!< private, see */                   \
+                                   /*!< DVBPSI_FLAG_LAST_SECTIONS */              \
+    size_t   i_psi_size;           /*!< private, size of the decoder */           \
 /**@}*/
 
 /*****************************************************************************
@@ -321,9 +1661,27 @@ void dvbpsi_decoder_reset(dvbpsi_decoder_t* p_decoder, const bool b_force);
  * \brief Have all sections for this decoder been received?
  * \param p_decoder pointer to dvbpsi_decoder_t with decoder
  * \return true when all PSI sections have been received, false otherwise
+ *
+ * A complete table becomes the known table of the decoder, see
+ * dvbpsi_decoder_psi_sections_known().
  */
 bool dvbpsi_decoder_psi_sections_completed(dvbpsi_decoder_t* p_decoder);
 
+/*****************************************************************************
+ * dvbpsi_decoder_psi_sections_known
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_decoder_psi_sections_known(dvbpsi_decoder_t* p_decoder);
+ * \brief Records the table in dvbpsi_decoder_t::p_sections as decoded
+ * \param p_decoder pointer to dvbpsi_decoder_t with decoder
+ * \return nothing
+ *
+ * Decoders not using dvbpsi_decoder_psi_sections_completed() call it once
+ * their table is complete. Together with dvbpsi_decoder_t::b_current_valid
+ * it lets DVBPSI_FLAG_SKIP_UNCHANGED skip the sections of this version.
+ */
+void dvbpsi_decoder_psi_sections_known(dvbpsi_decoder_t* p_decoder);
+
 /*****************************************************************************
  * dvbpsi_decoder_psi_section_add
  *****************************************************************************/
@@ -333,9 +1691,30 @@ bool dvbpsi_decoder_psi_sections_completed(dvbpsi_decoder_t* p_decoder);
  * \param p_decoder pointer to dvbpsi_decoder_t with decoder
  * \param p_section PSI section to add to dvbpsi_decoder_t::p_sections list
  * \return true if it overwrites a earlier section, false otherwise
+ *
+ * A borrowed section (see DVBPSI_FLAG_ZERO_COPY) is copied first.
  */
 bool dvbpsi_decoder_psi_section_add(dvbpsi_decoder_t *p_decoder, dvbpsi_psi_section_t *p_section);
 
+/*****************************************************************************
+ * dvbpsi_decoder_psi_section_single
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_decoder_psi_section_single(dvbpsi_decoder_t *p_decoder, dvbpsi_psi_section_t *p_section);
+ * \brief Completes at once a table carried by a single section
+ * \param p_decoder pointer to dvbpsi_decoder_t with decoder
+ * \param p_section PSI section received
+ * \return true if p_section is section 0 of 0 and no other section is
+ * being gathered, false otherwise and nothing is done.
+ *
+ * The section then is the whole dvbpsi_decoder_t::p_sections list and the
+ * table is known as after dvbpsi_decoder_psi_sections_completed(). The
+ * section is neither copied nor indexed: a borrowed section (see
+ * DVBPSI_FLAG_ZERO_COPY) is decoded in place, a decoder keeping the
+ * sections of its table copies it first.
+ */
+bool dvbpsi_decoder_psi_section_single(dvbpsi_decoder_t *p_decoder, dvbpsi_psi_section_t *p_section);
+
 /*****************************************************************************
  * dvbpsi_decoder_present
  *****************************************************************************/
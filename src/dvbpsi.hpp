@@ -0,0 +1,515 @@
+/*****************************************************************************
+ * dvbpsi.hpp
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <dvbpsi.hpp>
+ * \brief C++11 wrapper, header only.
+ *
+ * Move-only owners of the handle, of the decoders and of the decoded
+ * tables, and views over the lists of the C structures, without any copy.
+ * The handler of a table is given as a template parameter: the callback
+ * given to the C decoder is a trampoline instantiated for its type, which
+ * calls it directly, so that the compiler can inline it there, without
+ * any allocation. The C headers of the tables come first, only the tables
+ * whose header is included are wrapped.
+ *
+ * \code
+ * dvbpsi::handle h(NULL, DVBPSI_MSG_ERROR);
+ * auto on_pat = [](dvbpsi::table<dvbpsi_pat_t> pat) {
+ *     for (const dvbpsi_pat_program_t &program : dvbpsi::programs(*pat))
+ *         printf("%u %u\n", program.i_number, program.i_pid);
+ * };
+ * dvbpsi::decoder<dvbpsi_pat_t> pat = dvbpsi::attach<dvbpsi_pat_t>(h, on_pat);
+ * \endcode
+ *
+ * The handler must outlive its decoder, and a decoder its handle. The
+ * subtable decoders of a demux are detached with the demux: those attached
+ * from the callback of dvbpsi::attach_demux() are usually released.
+ */
+
+#ifndef _DVBPSI_HPP_
+#define _DVBPSI_HPP_
+
+#if !defined(_DVBPSI_DVBPSI_H_) || !defined(_DVBPSI_PSI_H_) || !defined(_DVBPSI_DESCRIPTOR_H_)
+#error "Include dvbpsi.h, psi.h and descriptor.h before dvbpsi.hpp"
+#endif
+
+#include <cstddef>
+#include <type_traits>
+
+namespace dvbpsi
+{
+
+/*****************************************************************************
+ * dvbpsi::handle
+ *****************************************************************************/
+/*!
+ * \class handle
+ * \brief Owner of a dvbpsi_t, see dvbpsi_new() and dvbpsi_delete().
+ *
+ * Its decoder is detached before, by the owner of the decoder.
+ */
+class handle
+{
+public:
+    explicit handle(dvbpsi_message_cb pf_message = NULL,
+                    enum dvbpsi_msg_level i_level = DVBPSI_MSG_NONE)
+        : p_dvbpsi(dvbpsi_new(pf_message, i_level)) {}
+    ~handle() { dvbpsi_delete(p_dvbpsi); }
+
+    handle(handle &&other) noexcept : p_dvbpsi(other.p_dvbpsi)
+    {
+        other.p_dvbpsi = NULL;
+    }
+    handle &operator=(handle &&other) noexcept
+    {
+        if (this != &other)
+        {
+            dvbpsi_delete(p_dvbpsi);
+            p_dvbpsi = other.p_dvbpsi;
+            other.p_dvbpsi = NULL;
+        }
+        return *this;
+    }
+    handle(const handle &) = delete;
+    handle &operator=(const handle &) = delete;
+
+    /*! false if dvbpsi_new() failed */
+    explicit operator bool() const { return p_dvbpsi != NULL; }
+    dvbpsi_t *get() const { return p_dvbpsi; }
+
+    /*! see dvbpsi_packet_push() */
+    bool push(uint8_t *p_packet) { return dvbpsi_packet_push(p_dvbpsi, p_packet); }
+    /*! see dvbpsi_packet_push_at() */
+    bool push(uint8_t *p_packet, int64_t i_time)
+    {
+        return dvbpsi_packet_push_at(p_dvbpsi, p_packet, i_time);
+    }
+    /*! see dvbpsi_decoder_present() */
+    bool has_decoder() const { return dvbpsi_decoder_present(p_dvbpsi); }
+
+private:
+    dvbpsi_t *p_dvbpsi;
+};
+
+/*****************************************************************************
+ * dvbpsi::table_traits
+ *****************************************************************************/
+/*!
+ * \struct table_traits
+ * \brief C functions of a table: destroy() deletes a decoded table,
+ * attach() and detach() its decoder.
+ *
+ * The decoder of a table is identified by its table_id and extension,
+ * ignored by the PAT, the CAT and the RST, the extension being the
+ * program_number of a PMT.
+ */
+template <typename T> struct table_traits;
+
+#define DVBPSI_HPP_TABLE(name)                                                \
+template <> struct table_traits<dvbpsi_##name##_t>                            \
+{                                                                             \
+    static void destroy(dvbpsi_##name##_t *p_table)                           \
+    {                                                                         \
+        dvbpsi_##name##_delete(p_table);                                      \
+    }                                                                         \
+    static bool attach(dvbpsi_t *p_dvbpsi, uint8_t, uint16_t,                 \
+                       dvbpsi_##name##_callback pf_callback, void *p_data)    \
+    {                                                                         \
+        return dvbpsi_##name##_attach(p_dvbpsi, pf_callback, p_data);         \
+    }                                                                         \
+    static void detach(dvbpsi_t *p_dvbpsi, uint8_t, uint16_t)                 \
+    {                                                                         \
+        dvbpsi_##name##_detach(p_dvbpsi);                                     \
+    }                                                                         \
+};
+
+#define DVBPSI_HPP_SUBTABLE(name)                                             \
+template <> struct table_traits<dvbpsi_##name##_t>                            \
+{                                                                             \
+    static void destroy(dvbpsi_##name##_t *p_table)                           \
+    {                                                                         \
+        dvbpsi_##name##_delete(p_table);                                      \
+    }                                                                         \
+    static bool attach(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,                \
+                       uint16_t i_extension,                                  \
+                       dvbpsi_##name##_callback pf_callback, void *p_data)    \
+    {                                                                         \
+        return dvbpsi_##name##_attach(p_dvbpsi, i_table_id, i_extension,      \
+                                      pf_callback, p_data);                   \
+    }                                                                         \
+    static void detach(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,                \
+                       uint16_t i_extension)                                  \
+    {                                                                         \
+        dvbpsi_##name##_detach(p_dvbpsi, i_table_id, i_extension);            \
+    }                                                                         \
+};
+
+#ifdef _DVBPSI_PAT_H_
+DVBPSI_HPP_TABLE(pat)
+#endif
+#ifdef _DVBPSI_CAT_H_
+DVBPSI_HPP_TABLE(cat)
+#endif
+#ifdef _DVBPSI_RST_H_
+DVBPSI_HPP_TABLE(rst)
+#endif
+#ifdef _DVBPSI_PMT_H_
+template <> struct table_traits<dvbpsi_pmt_t>
+{
+    static void destroy(dvbpsi_pmt_t *p_table) { dvbpsi_pmt_delete(p_table); }
+    static bool attach(dvbpsi_t *p_dvbpsi, uint8_t, uint16_t i_program_number,
+                       dvbpsi_pmt_callback pf_callback, void *p_data)
+    {
+        return dvbpsi_pmt_attach(p_dvbpsi, i_program_number, pf_callback, p_data);
+    }
+    static void detach(dvbpsi_t *p_dvbpsi, uint8_t, uint16_t)
+    {
+        dvbpsi_pmt_detach(p_dvbpsi);
+    }
+};
+#endif
+#ifdef _DVBPSI_SDT_H_
+DVBPSI_HPP_SUBTABLE(sdt)
+#endif
+#ifdef _DVBPSI_EIT_H_
+DVBPSI_HPP_SUBTABLE(eit)
+#endif
+#ifdef _DVBPSI_NIT_H_
+DVBPSI_HPP_SUBTABLE(nit)
+#endif
+#ifdef _DVBPSI_BAT_H_
+DVBPSI_HPP_SUBTABLE(bat)
+#endif
+#ifdef _DVBPSI_TOT_H_
+DVBPSI_HPP_SUBTABLE(tot)
+#endif
+#ifdef _DVBPSI_SIS_H_
+DVBPSI_HPP_SUBTABLE(sis)
+#endif
+
+#undef DVBPSI_HPP_TABLE
+#undef DVBPSI_HPP_SUBTABLE
+
+/*****************************************************************************
+ * dvbpsi::table
+ *****************************************************************************/
+/*!
+ * \class table
+ * \brief Owner of a decoded table, deleted with table_traits::destroy().
+ */
+template <typename T>
+class table
+{
+public:
+    explicit table(T *p = NULL) noexcept : p_table(p) {}
+    ~table() { if (p_table) table_traits<T>::destroy(p_table); }
+
+    table(table &&other) noexcept : p_table(other.release()) {}
+    table &operator=(table &&other) noexcept
+    {
+        if (this != &other)
+            reset(other.release());
+        return *this;
+    }
+    table(const table &) = delete;
+    table &operator=(const table &) = delete;
+
+    explicit operator bool() const { return p_table != NULL; }
+    T *get() const { return p_table; }
+    T &operator*() const { return *p_table; }
+    T *operator->() const { return p_table; }
+
+    /*! gives the table to the caller, who deletes it */
+    T *release() noexcept
+    {
+        T *p = p_table;
+        p_table = NULL;
+        return p;
+    }
+    void reset(T *p = NULL)
+    {
+        if (p_table)
+            table_traits<T>::destroy(p_table);
+        p_table = p;
+    }
+
+private:
+    T *p_table;
+};
+
+/*****************************************************************************
+ * dvbpsi::decoder
+ *****************************************************************************/
+/*!
+ * \class decoder
+ * \brief Decoder of a table attached by dvbpsi::attach(), detached with it.
+ */
+template <typename T>
+class decoder
+{
+public:
+    decoder() noexcept : p_dvbpsi(NULL), i_table_id(0), i_extension(0) {}
+    decoder(dvbpsi_t *p, uint8_t i_id, uint16_t i_ext) noexcept
+        : p_dvbpsi(p), i_table_id(i_id), i_extension(i_ext) {}
+    ~decoder() { detach(); }
+
+    decoder(decoder &&other) noexcept
+        : p_dvbpsi(other.p_dvbpsi), i_table_id(other.i_table_id),
+          i_extension(other.i_extension)
+    {
+        other.p_dvbpsi = NULL;
+    }
+    decoder &operator=(decoder &&other) noexcept
+    {
+        if (this != &other)
+        {
+            detach();
+            p_dvbpsi = other.p_dvbpsi;
+            i_table_id = other.i_table_id;
+            i_extension = other.i_extension;
+            other.p_dvbpsi = NULL;
+        }
+        return *this;
+    }
+    decoder(const decoder &) = delete;
+    decoder &operator=(const decoder &) = delete;
+
+    /*! false if the attachment failed */
+    explicit operator bool() const { return p_dvbpsi != NULL; }
+
+    void detach()
+    {
+        if (p_dvbpsi)
+            table_traits<T>::detach(p_dvbpsi, i_table_id, i_extension);
+        p_dvbpsi = NULL;
+    }
+    /*! forgets the decoder without detaching it, detached otherwise */
+    void release() noexcept { p_dvbpsi = NULL; }
+
+private:
+    dvbpsi_t *p_dvbpsi;
+    uint8_t   i_table_id;
+    uint16_t  i_extension;
+};
+
+/*****************************************************************************
+ * dvbpsi::attach
+ *****************************************************************************/
+/*!
+ * \fn template <typename T, typename Handler> decoder<T> attach(dvbpsi_t *p_dvbpsi, Handler &handler, uint8_t i_table_id = 0, uint16_t i_extension = 0)
+ * \brief Attaches the decoder of the tables T, given to handler as a
+ * table<T>: handler(table<T>(p_new_table)).
+ * \param p_dvbpsi handle, to a demux for the subtables
+ * \param handler called back, kept by reference
+ * \param i_table_id table_id of a subtable
+ * \param i_extension extension of a subtable, program_number of a PMT
+ * \return the decoder, false if the decoder could not be attached
+ */
+template <typename T, typename Handler>
+struct trampoline
+{
+    static void call(void *p_data, T *p_table)
+    {
+        (*static_cast<Handler *>(p_data))(table<T>(p_table));
+    }
+};
+
+template <typename T, typename Handler>
+decoder<T> attach(dvbpsi_t *p_dvbpsi, Handler &handler,
+                  uint8_t i_table_id = 0, uint16_t i_extension = 0)
+{
+    if (!table_traits<T>::attach(p_dvbpsi, i_table_id, i_extension,
+                                 &trampoline<T, Handler>::call, &handler))
+        return decoder<T>();
+    return decoder<T>(p_dvbpsi, i_table_id, i_extension);
+}
+
+template <typename T, typename Handler>
+decoder<T> attach(handle &h, Handler &handler,
+                  uint8_t i_table_id = 0, uint16_t i_extension = 0)
+{
+    return attach<T>(h.get(), handler, i_table_id, i_extension);
+}
+
+#ifdef _DVBPSI_DEMUX_H_
+/*****************************************************************************
+ * dvbpsi::demux
+ *****************************************************************************/
+/*!
+ * \class demux
+ * \brief Demux attached by dvbpsi::attach_demux(), detached with it, the
+ * subtable decoders being detached with it too.
+ */
+class demux
+{
+public:
+    explicit demux(dvbpsi_t *p = NULL) noexcept : p_dvbpsi(p) {}
+    ~demux() { detach(); }
+
+    demux(demux &&other) noexcept : p_dvbpsi(other.p_dvbpsi)
+    {
+        other.p_dvbpsi = NULL;
+    }
+    demux &operator=(demux &&other) noexcept
+    {
+        if (this != &other)
+        {
+            detach();
+            p_dvbpsi = other.p_dvbpsi;
+            other.p_dvbpsi = NULL;
+        }
+        return *this;
+    }
+    demux(const demux &) = delete;
+    demux &operator=(const demux &) = delete;
+
+    explicit operator bool() const { return p_dvbpsi != NULL; }
+
+    void detach()
+    {
+        if (p_dvbpsi)
+            dvbpsi_DetachDemux(p_dvbpsi);
+        p_dvbpsi = NULL;
+    }
+
+private:
+    dvbpsi_t *p_dvbpsi;
+};
+
+/*!
+ * \fn template <typename Handler> demux attach_demux(dvbpsi_t *p_dvbpsi, Handler &handler)
+ * \brief Attaches a demux, see dvbpsi_AttachDemux(), handler being called
+ * back with each new subtable: handler(p_dvbpsi, i_table_id, i_extension).
+ */
+template <typename Handler>
+struct demux_trampoline
+{
+    static void call(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                     uint16_t i_extension, void *p_data)
+    {
+        (*static_cast<Handler *>(p_data))(p_dvbpsi, i_table_id, i_extension);
+    }
+};
+
+template <typename Handler>
+demux attach_demux(dvbpsi_t *p_dvbpsi, Handler &handler)
+{
+    if (!dvbpsi_AttachDemux(p_dvbpsi, &demux_trampoline<Handler>::call, &handler))
+        return demux();
+    return demux(p_dvbpsi);
+}
+
+template <typename Handler>
+demux attach_demux(handle &h, Handler &handler)
+{
+    return attach_demux(h.get(), handler);
+}
+#endif
+
+/*****************************************************************************
+ * dvbpsi::list
+ *****************************************************************************/
+/*!
+ * \class list
+ * \brief View of a list of the C structures linked by p_next, const when
+ * viewed from a const structure.
+ */
+template <typename T>
+class list
+{
+public:
+    class iterator
+    {
+    public:
+        explicit iterator(T *p = NULL) : p_item(p) {}
+        T &operator*() const { return *p_item; }
+        T *operator->() const { return p_item; }
+        iterator &operator++() { p_item = p_item->p_next; return *this; }
+        iterator operator++(int) { iterator it(*this); ++*this; return it; }
+        bool operator==(const iterator &other) const { return p_item == other.p_item; }
+        bool operator!=(const iterator &other) const { return p_item != other.p_item; }
+    private:
+        T *p_item;
+    };
+
+    explicit list(T *p_first) : p_first_item(p_first) {}
+    iterator begin() const { return iterator(p_first_item); }
+    iterator end() const { return iterator(); }
+    bool empty() const { return p_first_item == NULL; }
+    T *front() const { return p_first_item; }
+
+private:
+    T *p_first_item;
+};
+
+/*! list of Item viewed from a Parent, possibly const */
+template <typename Parent, typename Item>
+struct list_of
+{
+    typedef list<typename std::conditional<std::is_const<Parent>::value,
+                                           const Item, Item>::type> type;
+};
+
+/*!
+ * \fn template <typename T> descriptors(T &parent)
+ * \brief Descriptors of a table or of an item of a table.
+ */
+template <typename T>
+typename list_of<T, dvbpsi_descriptor_t>::type descriptors(T &parent)
+{
+    return typename list_of<T, dvbpsi_descriptor_t>::type(parent.p_first_descriptor);
+}
+
+#define DVBPSI_HPP_LIST(view, parent, item, first)                            \
+inline list<item> view(parent &p) { return list<item>(p.first); }             \
+inline list<const item> view(const parent &p)                                 \
+{                                                                             \
+    return list<const item>(p.first);                                         \
+}
+
+#ifdef _DVBPSI_PAT_H_
+DVBPSI_HPP_LIST(programs, dvbpsi_pat_t, dvbpsi_pat_program_t, p_first_program)
+#endif
+#ifdef _DVBPSI_PMT_H_
+DVBPSI_HPP_LIST(es, dvbpsi_pmt_t, dvbpsi_pmt_es_t, p_first_es)
+#endif
+#ifdef _DVBPSI_SDT_H_
+DVBPSI_HPP_LIST(services, dvbpsi_sdt_t, dvbpsi_sdt_service_t, p_first_service)
+#endif
+#ifdef _DVBPSI_EIT_H_
+DVBPSI_HPP_LIST(events, dvbpsi_eit_t, dvbpsi_eit_event_t, p_first_event)
+#endif
+#ifdef _DVBPSI_NIT_H_
+DVBPSI_HPP_LIST(transport_streams, dvbpsi_nit_t, dvbpsi_nit_ts_t, p_first_ts)
+#endif
+#ifdef _DVBPSI_BAT_H_
+DVBPSI_HPP_LIST(transport_streams, dvbpsi_bat_t, dvbpsi_bat_ts_t, p_first_ts)
+#endif
+
+#undef DVBPSI_HPP_LIST
+
+} /* namespace dvbpsi */
+
+#else
+#error "Multiple inclusions of dvbpsi.hpp"
+#endif
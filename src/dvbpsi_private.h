@@ -32,6 +32,141 @@
 
 #define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
 
+/*****************************************************************************
+ * dvbpsi_list_append
+ *****************************************************************************
+ * Appends p_item to the list running from p_first to p_last, all lvalues of
+ * the same type with a p_next member. The tail lets the *_add() functions
+ * append in constant time; it is only trusted while it is still the end of
+ * a non empty list, so a list head reset or extended by hand is walked.
+ *****************************************************************************/
+#define dvbpsi_list_append(p_first, p_last, p_item)                          \
+    do {                                                                     \
+        if ((p_first) == NULL)                                               \
+            (p_first) = (p_item);                                            \
+        else                                                                 \
+        {                                                                    \
+            if ((p_last) == NULL || (p_last)->p_next != NULL)                \
+            {                                                                \
+                (p_last) = (p_first);                                        \
+                while ((p_last)->p_next != NULL)                             \
+                    (p_last) = (p_last)->p_next;                             \
+            }                                                                \
+            (p_last)->p_next = (p_item);                                     \
+        }                                                                    \
+        (p_last) = (p_item);                                                 \
+    } while(0)
+
+/*****************************************************************************
+ * dvbpsi_list_splice
+ *****************************************************************************
+ * Appends the list running from p_other_first to p_other_last to the list
+ * running from p_first to p_last, tails being trusted as by
+ * dvbpsi_list_append(). The other list is left to the first one.
+ *****************************************************************************/
+#define dvbpsi_list_splice(p_first, p_last, p_other_first, p_other_last)     \
+    do {                                                                     \
+        if ((p_other_first) == NULL)                                         \
+            break;                                                           \
+        if ((p_other_last) == NULL || (p_other_last)->p_next != NULL)        \
+        {                                                                    \
+            (p_other_last) = (p_other_first);                                \
+            while ((p_other_last)->p_next != NULL)                           \
+                (p_other_last) = (p_other_last)->p_next;                     \
+        }                                                                    \
+        dvbpsi_list_append(p_first, p_last, p_other_first);                  \
+        (p_last) = (p_other_last);                                           \
+    } while(0)
+
+/*****************************************************************************
+ * dvbpsi_tags_add
+ *****************************************************************************
+ * Records i_tag in a bitmap of descriptor tags, see dvbpsi_has_descriptor().
+ *****************************************************************************/
+#define dvbpsi_tags_add(p_tags, i_tag) \
+    ((p_tags)[(i_tag) >> 3] |= (uint8_t)(1 << ((i_tag) & 7)))
+
+/*****************************************************************************
+ * Memory allocation
+ *
+ * Every allocation of the library goes through these, see
+ * dvbpsi_set_allocator().
+ *****************************************************************************/
+void *dvbpsi_malloc(size_t i_size);
+void *dvbpsi_calloc(size_t i_count, size_t i_size);
+void dvbpsi_free(void *p_ptr);
+
+/*****************************************************************************
+ * Memory categories
+ *
+ * Configured with --enable-mem-stats, the library records the category of
+ * each block for dvbpsi_mem_stats(). dvbpsi_malloc() and dvbpsi_calloc()
+ * tag the block with the DVBPSI_MEM_CATEGORY of the file, defined before
+ * including this header, DVBPSI_MEM_OTHER by default. dvbpsi_malloc_as()
+ * and dvbpsi_calloc_as() tag it explicitly, dvbpsi_mem_tag() moves a block
+ * to another category, blocks it does not know, in an arena or in a
+ * structure, are ignored. All of them are plain allocations otherwise.
+ *****************************************************************************/
+#ifdef DVBPSI_MEM_STATS
+#ifndef DVBPSI_MEM_CATEGORY
+#   define DVBPSI_MEM_CATEGORY DVBPSI_MEM_OTHER
+#endif
+
+void *dvbpsi_malloc_as(size_t i_size, dvbpsi_mem_category_t i_category);
+void *dvbpsi_calloc_as(size_t i_count, size_t i_size, dvbpsi_mem_category_t i_category);
+void dvbpsi_mem_tag(const void *p_ptr, dvbpsi_mem_category_t i_category);
+
+#define dvbpsi_malloc(i_size) dvbpsi_malloc_as(i_size, DVBPSI_MEM_CATEGORY)
+#define dvbpsi_calloc(i_count, i_size) \
+    dvbpsi_calloc_as(i_count, i_size, DVBPSI_MEM_CATEGORY)
+#else
+#define dvbpsi_malloc_as(i_size, i_category) dvbpsi_malloc(i_size)
+#define dvbpsi_calloc_as(i_count, i_size, i_category) dvbpsi_calloc(i_count, i_size)
+#define dvbpsi_mem_tag(p_ptr, i_category) ((void)0)
+#endif
+
+/*****************************************************************************
+ * Table arenas
+ *
+ * With DVBPSI_FLAG_TABLE_ARENA a decoder allocates each table it builds, with
+ * all its entries and descriptors, in one arena. Between dvbpsi_arena_enter()
+ * and dvbpsi_arena_leave() the thread allocates in the arena and
+ * dvbpsi_free() ignores the memory of the arena, which is freed at once by
+ * dvbpsi_arena_delete(). Entering a NULL arena restores heap allocation.
+ * Without thread local storage dvbpsi_arena_new() always fails.
+ *****************************************************************************/
+typedef struct dvbpsi_arena_s dvbpsi_arena_t;
+
+dvbpsi_arena_t *dvbpsi_arena_new(void);
+void dvbpsi_arena_delete(dvbpsi_arena_t *p_arena);
+void *dvbpsi_arena_alloc(dvbpsi_arena_t *p_arena, size_t i_size);
+bool dvbpsi_arena_owns(const dvbpsi_arena_t *p_arena, const void *p_ptr);
+/* Gives the chunks of p_other to p_arena, p_other being gone */
+void dvbpsi_arena_merge(dvbpsi_arena_t *p_arena, dvbpsi_arena_t *p_other);
+dvbpsi_arena_t *dvbpsi_arena_enter(dvbpsi_arena_t *p_arena);
+#define dvbpsi_arena_leave(p_previous) ((void)dvbpsi_arena_enter(p_previous))
+
+/* New arena for a table decoded by p_dvbpsi, NULL if it uses the heap */
+dvbpsi_arena_t *dvbpsi_arena_table_new(const dvbpsi_t *p_dvbpsi);
+
+/*****************************************************************************
+ * Handle and decoder pools
+ *
+ * dvbpsi_pool_take() gets an idle object of a kind and size from the pool
+ * entered by the thread, NULL if there is none, for the caller to reset.
+ * dvbpsi_pool_give() keeps an object deleted by the caller, false if no
+ * pool is entered or it is full, the caller then freeing it.
+ *****************************************************************************/
+typedef enum dvbpsi_pool_kind_e
+{
+    DVBPSI_POOL_HANDLE,     /* dvbpsi_t, with its p_pool */
+    DVBPSI_POOL_DECODER,    /* dvbpsi_decoder_t, with its p_section_index */
+    DVBPSI_POOL_BLOCK,      /* plain memory */
+} dvbpsi_pool_kind_t;
+
+void *dvbpsi_pool_take(dvbpsi_pool_kind_t i_kind, size_t i_size);
+bool dvbpsi_pool_give(dvbpsi_pool_kind_t i_kind, void *p_ptr, size_t i_size);
+
 /*****************************************************************************
  * Error management
  *
@@ -39,21 +174,353 @@
  * "libdvbpsi [error | warning | debug] (<component>): <msg>"
  *****************************************************************************/
 
+/*****************************************************************************
+ * dvbpsi_message_enabled
+ *****************************************************************************
+ * True when a message of the given level reaches the message callback. The
+ * macros below test this before any argument is evaluated or formatted.
+ *****************************************************************************/
+static inline bool dvbpsi_message_enabled(const dvbpsi_t *dvbpsi, const int level)
+{
+    return dvbpsi->pf_message && (dvbpsi->i_msg_level > DVBPSI_MSG_NONE) &&
+           (level <= dvbpsi->i_msg_level);
+}
+
 #ifdef HAVE_VARIADIC_MACROS
 void dvbpsi_message(dvbpsi_t *dvbpsi, const int level, const char *fmt, ...);
 
-#  define dvbpsi_error(hnd, src, str, x...)                             \
-        dvbpsi_message(hnd, DVBPSI_MSG_ERROR, "libdvbpsi error (%s): " str, src, ##x)
+#  define dvbpsi_error(hnd, src, str, x...)                                  \
+    do {                                                                     \
+        if (dvbpsi_message_enabled(hnd, DVBPSI_MSG_ERROR))                   \
+            dvbpsi_message(hnd, DVBPSI_MSG_ERROR, "libdvbpsi error (%s): " str, src, ##x); \
+    } while(0)
 #  define dvbpsi_warning(hnd, src, str, x...)                                \
-        dvbpsi_message(hnd, DVBPSI_MSG_WARN, "libdvbpsi warning (%s): " str, src, ##x)
+    do {                                                                     \
+        if (dvbpsi_message_enabled(hnd, DVBPSI_MSG_WARN))                    \
+            dvbpsi_message(hnd, DVBPSI_MSG_WARN, "libdvbpsi warning (%s): " str, src, ##x); \
+    } while(0)
+#  if defined(DVBPSI_NO_DEBUG_MESSAGES)
+/* Still type checked, but never emitted */
+#  define dvbpsi_debug(hnd, src, str, x...)                                  \
+    do {                                                                     \
+        if (0)                                                               \
+            dvbpsi_message(hnd, DVBPSI_MSG_DEBUG, "libdvbpsi debug (%s): " str, src, ##x); \
+    } while(0)
+#  else
 #  define dvbpsi_debug(hnd, src, str, x...)                                  \
-        dvbpsi_message(hnd, DVBPSI_MSG_DEBUG, "libdvbpsi debug (%s): " str, src, ##x)
+    do {                                                                     \
+        if (dvbpsi_message_enabled(hnd, DVBPSI_MSG_DEBUG))                   \
+            dvbpsi_message(hnd, DVBPSI_MSG_DEBUG, "libdvbpsi debug (%s): " str, src, ##x); \
+    } while(0)
+#  endif
 #else
 void dvbpsi_error(dvbpsi_t *dvbpsi, const char *src, const char *fmt, ...);
 void dvbpsi_warning(dvbpsi_t *dvbpsi, const char *src, const char *fmt, ...);
+#  if defined(DVBPSI_NO_DEBUG_MESSAGES)
+static inline void dvbpsi_debug(dvbpsi_t *dvbpsi, const char *src, const char *fmt, ...)
+{
+    (void)dvbpsi; (void)src; (void)fmt;
+}
+#  else
 void dvbpsi_debug(dvbpsi_t *dvbpsi, const char *src, const char *fmt, ...);
+#  endif
 #endif
 
+/*****************************************************************************
+ * dvbpsi_event
+ *****************************************************************************
+ * Counts an event and gives it to the event callback if there is one.
+ *****************************************************************************/
+static inline void dvbpsi_event(dvbpsi_t *dvbpsi, dvbpsi_event_t *p_event)
+{
+    p_event->i_count = ++dvbpsi->i_events[p_event->i_type];
+    if (dvbpsi->pf_event)
+        dvbpsi->pf_event(dvbpsi, p_event, dvbpsi->p_event_data);
+}
+
+/*****************************************************************************
+ * Latency histograms
+ *****************************************************************************/
+typedef struct dvbpsi_latency_s
+{
+    uint64_t pi_buckets[256][DVBPSI_LATENCY_BUCKETS];   /* by table_id */
+} dvbpsi_latency_t;
+
+/* Bucket of a latency: 0 for 0, i for 2^(i-1) to 2^i - 1, the last bucket
+ * for all longer ones */
+static inline unsigned int dvbpsi_latency_bucket(uint64_t i_latency)
+{
+    unsigned int i_bucket = 0;
+    while (i_latency && i_bucket < DVBPSI_LATENCY_BUCKETS - 1)
+    {
+        i_latency >>= 1;
+        i_bucket++;
+    }
+    return i_bucket;
+}
+
+/*****************************************************************************
+ * Section pool
+ *
+ * Sections assembled by dvbpsi_packet_push() come from a per handle pool of
+ * recycled buffers, sorted in power of two size classes of 64 up to 4096
+ * bytes. Their p_data area is not zeroed. dvbpsi_DeletePSISections() gives them back to
+ * the pool, which keeps up to DVBPSI_SECTION_POOL_DEPTH free sections per
+ * class. A pool deleted while sections are still out is freed when the last
+ * of them comes back.
+ *****************************************************************************/
+#define DVBPSI_SECTION_POOL_CLASSES 7
+#define DVBPSI_SECTION_POOL_DEPTH   32
+
+typedef struct dvbpsi_section_pool_s dvbpsi_section_pool_t;
+
+dvbpsi_section_pool_t *dvbpsi_section_pool_new(void);
+void dvbpsi_section_pool_delete(dvbpsi_section_pool_t *p_pool);
+
+/* Falls back to dvbpsi_NewPSISection() without a pool or for sizes above
+ * the largest class. */
+dvbpsi_psi_section_t *dvbpsi_section_pool_get(dvbpsi_section_pool_t *p_pool,
+                                              int i_max_size);
+
+/* DVBPSI_FLAG_ZERO_COPY section over the i_size bytes at p_pos */
+dvbpsi_psi_section_t *dvbpsi_section_pool_borrow(dvbpsi_section_pool_t *p_pool,
+                                                 uint8_t *p_pos, int i_size);
+
+/* Section buffers allocated and bytes copied by the pool */
+void dvbpsi_section_pool_counters(const dvbpsi_section_pool_t *p_pool,
+                                  uint64_t *pi_allocations, uint64_t *pi_copied);
+
+/* Copy of a borrowed section, taken from the pool of the handle */
+dvbpsi_psi_section_t *dvbpsi_section_pool_copy(dvbpsi_psi_section_t *p_section);
+
+/* With DVBPSI_FLAG_COMPACT the pool keeps no free section of its own: they
+ * go to the handle and decoder pool entered by the thread, shared by all
+ * its handles, or are freed. */
+void dvbpsi_section_pool_set_compact(dvbpsi_section_pool_t *p_pool, bool b_compact);
+bool dvbpsi_section_pool_is_compact(const dvbpsi_section_pool_t *p_pool);
+
+/* With DVBPSI_FLAG_LAST_SECTIONS the decoders whose sections come from the
+ * pool keep a copy of their last complete table. */
+void dvbpsi_section_pool_set_keep_last(dvbpsi_section_pool_t *p_pool, bool b_keep_last);
+bool dvbpsi_section_pool_keeps_last(const dvbpsi_section_pool_t *p_pool);
+
+/*****************************************************************************
+ * Section buffer
+ *
+ * The table generators take their sections with dvbpsi_section_buffer_get(),
+ * which uses the dvbpsi_section_buffer_t set on the handle between
+ * dvbpsi_section_buffer_begin() and dvbpsi_section_buffer_end(), and
+ * dvbpsi_NewPSISection() otherwise. When the buffer is full the sections are
+ * allocated anyway, and dvbpsi_section_buffer_end() deletes them.
+ *****************************************************************************/
+dvbpsi_psi_section_t *dvbpsi_section_buffer_get(dvbpsi_t *p_dvbpsi, int i_max_size);
+void dvbpsi_section_buffer_begin(dvbpsi_t *p_dvbpsi, dvbpsi_section_buffer_t *p_buffer);
+
+/* Number of sections of p_section, all in the buffer, or -1 */
+int dvbpsi_section_buffer_end(dvbpsi_t *p_dvbpsi, dvbpsi_psi_section_t *p_section);
+
+/*****************************************************************************
+ * Encoder cache
+ *
+ * Last encoding of the sections built by dvbpsi_BuildPSISection() with
+ * DVBPSI_FLAG_ENCODER_CACHE, allocated on first use.
+ *****************************************************************************/
+typedef struct dvbpsi_encoder_cache_s dvbpsi_encoder_cache_t;
+
+void dvbpsi_encoder_cache_delete(dvbpsi_encoder_cache_t *p_cache);
+
+/*****************************************************************************
+ * CRC_32 cache
+ *
+ * With DVBPSI_FLAG_CRC_CACHE, the CRC_32 field of each section of the last
+ * table completed by a decoder, indexed by section_number.
+ *****************************************************************************/
+typedef struct dvbpsi_crc_cache_s
+{
+    uint32_t pi_crc[256];
+    uint8_t  pi_valid[256 / 8];
+} dvbpsi_crc_cache_t;
+
+/*****************************************************************************
+ * Section index
+ *
+ * Once a decoder holds more than one section, p_sections is also indexed by
+ * section_number with a received bitmap, so that inserting, replacing and
+ * checking for completion do not walk the list. The list is kept in order
+ * for the *_sections_decode functions.
+ *****************************************************************************/
+typedef struct dvbpsi_section_index_s
+{
+    dvbpsi_psi_section_t *ap_sections[256];
+    uint64_t              pi_received[256 / 64];
+} dvbpsi_section_index_t;
+
+/*****************************************************************************
+ * Section repetition
+ *
+ * With DVBPSI_FLAG_REPETITION, the repetition of each section of a subtable
+ * decoder by section_number, allocated with its first timed section.
+ *****************************************************************************/
+typedef struct dvbpsi_repetitions_s
+{
+    dvbpsi_repetition_t repetition[256];
+} dvbpsi_repetitions_t;
+
+/*****************************************************************************
+ * Descriptor cache
+ *
+ * With DVBPSI_FLAG_DESCRIPTOR_CACHE, the decoded form of the descriptors of
+ * the last table completed by a decoder, keyed by tag, length and content.
+ * dvbpsi_dr_cache_decode() decodes a descriptor list, duplicating the cached
+ * form of unchanged descriptors, dvbpsi_dr_cache_trim() then forgets the
+ * descriptors the table did not use.
+ *****************************************************************************/
+typedef struct dvbpsi_dr_cache_s dvbpsi_dr_cache_t;
+struct dvbpsi_descriptor_s;
+
+void dvbpsi_dr_cache_decode(dvbpsi_t *p_dvbpsi, dvbpsi_decoder_t *p_decoder,
+                            struct dvbpsi_descriptor_s *p_descriptors);
+void dvbpsi_dr_cache_trim(dvbpsi_decoder_t *p_decoder);
+void dvbpsi_dr_cache_delete(dvbpsi_dr_cache_t *p_cache);
+
+/*****************************************************************************
+ * Descriptor interning
+ *
+ * With DVBPSI_FLAG_INTERN_DESCRIPTORS a decoder enters an intern table while
+ * it builds a table. The descriptors created by the thread in between share
+ * their content with the identical descriptors of the table. Without thread
+ * local storage dvbpsi_intern_new() always returns NULL.
+ *****************************************************************************/
+typedef struct dvbpsi_intern_s dvbpsi_intern_t;
+
+/* New intern table if p_dvbpsi interns descriptors, NULL otherwise */
+dvbpsi_intern_t *dvbpsi_intern_new(const dvbpsi_t *p_dvbpsi);
+void dvbpsi_intern_delete(dvbpsi_intern_t *p_intern);
+dvbpsi_intern_t *dvbpsi_intern_enter(dvbpsi_intern_t *p_intern);
+#define dvbpsi_intern_leave(p_previous) ((void)dvbpsi_intern_enter(p_previous))
+
+/*****************************************************************************
+ * Table arrays
+ *
+ * With DVBPSI_FLAG_TABLE_ARRAYS a decoder sizes, from the loop lengths of
+ * the sections of a complete table, one block of the arena of the table
+ * holding its entries as an array, followed by all its descriptors laid
+ * out one after the other. dvbpsi_arrays_span() is the room taken in the
+ * block by the descriptors of a loop, counted as the decoders add them.
+ * dvbpsi_arrays_entry() returns the next entry of the array, NULL once the
+ * array is full or without a block, the decoder then allocating the entry.
+ * dvbpsi_arrays_descriptor() lays out the next descriptor, or allocates it
+ * with dvbpsi_NewDescriptor() in these cases. dvbpsi_arrays_descriptors()
+ * appends those of a whole loop to a list and its bitmap of tags, after one
+ * pass of dvbpsi_descriptor_index() over the loop.
+ *****************************************************************************/
+typedef struct dvbpsi_arrays_s
+{
+    uint8_t *p_entry;                   /* next entry of the array */
+    uint8_t *p_entries_end;
+    size_t   i_entry_size;
+    uint8_t *p_span;                    /* next descriptor */
+    uint8_t *p_span_end;
+} dvbpsi_arrays_t;
+
+size_t dvbpsi_arrays_span(const uint8_t *p_byte, const uint8_t *p_end);
+/* Without an arena or a block the arrays stay empty and false is returned */
+bool dvbpsi_arrays_new(dvbpsi_arrays_t *p_arrays, dvbpsi_arena_t *p_arena,
+                       size_t i_entries, size_t i_entry_size, size_t i_span);
+void *dvbpsi_arrays_entry(dvbpsi_arrays_t *p_arrays);
+struct dvbpsi_descriptor_s *dvbpsi_arrays_descriptor(dvbpsi_arrays_t *p_arrays,
+                                                     uint8_t i_tag, uint8_t i_length,
+                                                     uint8_t *p_data);
+void dvbpsi_arrays_descriptors(dvbpsi_arrays_t *p_arrays,
+                               uint8_t *p_byte, const uint8_t *p_end,
+                               struct dvbpsi_descriptor_s **pp_first,
+                               struct dvbpsi_descriptor_s **pp_last, uint8_t *p_tags);
+
+/*****************************************************************************
+ * Table deltas
+ *
+ * The summary a SDT, NIT or BAT decoder keeps of the version it last
+ * signalled for its delta callback: a 64 bits FNV-1a hash of the
+ * descriptor loops of the table itself and, sorted by key, the key of each
+ * entry with the hash of its bytes, header included. dvbpsi_delta_compute()
+ * walks the raw sections of a complete table with pf_iter, which must
+ * accept a NULL descriptor iterator, and pf_key, replaces the summary with
+ * the one of the new version and returns the changes, removed entries
+ * first and then the others by key, to be freed with dvbpsi_free(). The
+ * entries are matched by a merge of the two sorted summaries and compared
+ * on their hashes only. Out of memory returns NULL and drops the summary,
+ * the next version then being reported as a first one.
+ *****************************************************************************/
+struct dvbpsi_descriptor_iter_s;
+struct dvbpsi_entry_iter_s;
+typedef bool (* dvbpsi_delta_iter_cb)(dvbpsi_psi_section_t *p_section,
+                                      struct dvbpsi_descriptor_iter_s *p_descriptors,
+                                      struct dvbpsi_entry_iter_s *p_entries);
+typedef uint32_t (* dvbpsi_delta_key_cb)(const uint8_t *p_header);
+
+typedef struct dvbpsi_delta_entry_s
+{
+    uint32_t i_key;
+    uint64_t i_hash;
+} dvbpsi_delta_entry_t;
+
+typedef struct dvbpsi_delta_summary_s
+{
+    bool                  b_valid;          /* a version was summarized */
+    uint64_t              i_hash;           /* of the table descriptor loops */
+    dvbpsi_delta_entry_t *p_entries;
+    unsigned int          i_entries;
+} dvbpsi_delta_summary_t;
+
+typedef struct dvbpsi_delta_change_s
+{
+    uint32_t i_key;
+    uint8_t  i_change;                      /* enum dvbpsi_entry_change */
+} dvbpsi_delta_change_t;
+
+dvbpsi_delta_change_t *dvbpsi_delta_compute(dvbpsi_delta_summary_t *p_summary,
+                                            dvbpsi_psi_section_t *p_sections,
+                                            dvbpsi_delta_iter_cb pf_iter,
+                                            dvbpsi_delta_key_cb pf_key,
+                                            bool *pb_first, bool *pb_descriptors,
+                                            unsigned int *pi_changes);
+void dvbpsi_delta_reset(dvbpsi_delta_summary_t *p_summary);
+
+/*****************************************************************************
+ * Static tracepoints
+ *
+ * USDT probes of the libdvbpsi provider, compiled in when configure finds
+ * <sys/sdt.h>: each one is a nop until bpftrace, perf or SystemTap attaches.
+ * The packet path fires section__start, section__complete, crc__fail,
+ * cc__discontinuity, section__dropped and table__complete with the PID of
+ * the packet first, DVBPSI_EVENT_NO_PID for dvbpsi_section_push(), then the
+ * table_id. The gather functions fire section__dropped with
+ * DVBPSI_EVENT_NO_PID, and callback__entry and callback__exit around the
+ * callbacks, with the name of the callback, the table_id and the extension:
+ * they nest in the section__complete of their section on the same thread.
+ *****************************************************************************/
+#ifdef HAVE_SYS_SDT_H
+#   include <sys/sdt.h>
+#   define dvbpsi_probe2(name, a1, a2) DTRACE_PROBE2(libdvbpsi, name, a1, a2)
+#   define dvbpsi_probe3(name, a1, a2, a3) DTRACE_PROBE3(libdvbpsi, name, a1, a2, a3)
+#   define dvbpsi_probe4(name, a1, a2, a3, a4) \
+        DTRACE_PROBE4(libdvbpsi, name, a1, a2, a3, a4)
+#else
+#   define dvbpsi_probe2(name, a1, a2) ((void)0)
+#   define dvbpsi_probe3(name, a1, a2, a3) ((void)0)
+#   define dvbpsi_probe4(name, a1, a2, a3, a4) ((void)0)
+#endif
+
+/* Drop of a section by a gather function, reason being a string literal */
+#define dvbpsi_probe_dropped(p_section, reason) \
+    dvbpsi_probe3(section__dropped, DVBPSI_EVENT_NO_PID, (p_section)->i_table_id, reason)
+
+/* Around a callback of a gather function, psz_name being a string literal */
+#define dvbpsi_probe_callback_entry(psz_name, i_table_id, i_extension) \
+    dvbpsi_probe3(callback__entry, psz_name, i_table_id, i_extension)
+#define dvbpsi_probe_callback_exit(psz_name, i_table_id, i_extension) \
+    dvbpsi_probe3(callback__exit, psz_name, i_table_id, i_extension)
+
 #else
 #error "Multiple inclusions of dvbpsi_private.h"
 #endif
@@ -0,0 +1,1279 @@
+/*****************************************************************************
+ * epg.c: in-memory EPG store
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "descriptor.h"
+#include "crc32_private.h"
+#include "tables/eit.h"
+#include "tables/rst.h"
+#include "descriptors/dr_4d.h"
+#include "mjd.h"
+#include "text.h"
+#include "epg.h"
+
+/* Largest number of present/following events of a service looked at to
+   hide their schedule copies */
+#define DVBPSI_EPG_PF_MAX 8
+
+/* Largest number of words of the event names of an event, or of a search,
+   that are indexed */
+#define DVBPSI_EPG_WORDS_MAX 32
+
+/* EIT table_ids, 0x4e to 0x6f */
+#define DVBPSI_EPG_TABLES (0x70 - 0x4e)
+
+/* Snapshot format */
+#define DVBPSI_EPG_MAGIC   "DEPG"
+#define DVBPSI_EPG_FORMAT  1
+
+/*****************************************************************************
+ * dvbpsi_epg_table_t
+ *****************************************************************************
+ * Version of an EIT of a service the events come from.
+ *****************************************************************************/
+typedef struct dvbpsi_epg_table_s
+{
+    uint8_t                 i_version;      /* 0xff if none */
+    bool                    b_complete;     /* given as a whole table */
+    uint32_t                i_segments;     /* segments of the version given
+                                               one by one */
+} dvbpsi_epg_table_t;
+
+/*****************************************************************************
+ * dvbpsi_epg_word_t
+ *****************************************************************************
+ * Word of the event names of an event of a service.
+ *****************************************************************************/
+typedef struct dvbpsi_epg_word_s
+{
+    uint32_t                i_hash;
+    uint32_t                i_event;        /* index in the events */
+} dvbpsi_epg_word_t;
+
+/*****************************************************************************
+ * dvbpsi_epg_service_t
+ *****************************************************************************
+ * Events of a service, by start time then table_id.
+ *****************************************************************************/
+typedef struct dvbpsi_epg_service_s
+{
+    uint64_t                i_key;          /* original_network_id,
+                                               transport_stream_id and
+                                               service_id */
+    dvbpsi_epg_event_t *    p_events;
+    size_t                  i_events;
+    uint32_t                i_max_duration; /* bounds the events looked at
+                                               before a time */
+    uint16_t                pi_pf_ids[DVBPSI_EPG_PF_MAX];
+    unsigned int            i_pf;
+
+    /* Indexes of the events by content_nibble_level_1, from
+       pi_genre_offsets[n] to pi_genre_offsets[n + 1], by start time */
+    uint32_t *              pi_genres;
+    size_t                  i_genres_size;
+    uint32_t                pi_genre_offsets[17];
+
+    dvbpsi_epg_word_t *     p_words;        /* by hash then event */
+    size_t                  i_words;
+    size_t                  i_words_size;
+
+    /* Indexes of the events plus one by event_id, open addressing over a
+       power of two slots, 0 if none */
+    uint32_t *              pi_ids;
+    size_t                  i_ids_size;
+
+    dvbpsi_epg_table_t      tables[DVBPSI_EPG_TABLES];
+} dvbpsi_epg_service_t;
+
+/*****************************************************************************
+ * dvbpsi_epg_s
+ *****************************************************************************/
+struct dvbpsi_epg_s
+{
+    dvbpsi_epg_service_t ** pp_services;    /* by key */
+    size_t                  i_services;
+    size_t                  i_size;
+};
+
+/*****************************************************************************
+ * dvbpsi_epg_time
+ *****************************************************************************/
+int64_t dvbpsi_epg_time(uint64_t i_start_time)
+{
+    return dvbpsi_mjd_to_utc(i_start_time);
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_new
+ *****************************************************************************/
+dvbpsi_epg_t *dvbpsi_epg_new(void)
+{
+    return (dvbpsi_epg_t *)dvbpsi_calloc(1, sizeof(dvbpsi_epg_t));
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_event_clean
+ *****************************************************************************/
+static void dvbpsi_epg_event_clean(dvbpsi_epg_event_t *p_event)
+{
+    dvbpsi_DeleteDescriptors(p_event->p_first_descriptor);
+    dvbpsi_free(p_event->pi_words);
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_events_delete
+ *****************************************************************************/
+static void dvbpsi_epg_events_delete(dvbpsi_epg_event_t *p_events, size_t i_events)
+{
+    for (size_t i = 0; i < i_events; i++)
+        dvbpsi_epg_event_clean(&p_events[i]);
+    dvbpsi_free(p_events);
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_delete
+ *****************************************************************************/
+void dvbpsi_epg_delete(dvbpsi_epg_t *p_epg)
+{
+    if (p_epg == NULL)
+        return;
+
+    for (size_t i = 0; i < p_epg->i_services; i++)
+    {
+        dvbpsi_epg_service_t *p_service = p_epg->pp_services[i];
+        dvbpsi_epg_events_delete(p_service->p_events, p_service->i_events);
+        dvbpsi_free(p_service->pi_genres);
+        dvbpsi_free(p_service->p_words);
+        dvbpsi_free(p_service->pi_ids);
+        dvbpsi_free(p_service);
+    }
+    dvbpsi_free(p_epg->pp_services);
+    dvbpsi_free(p_epg);
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_key
+ *****************************************************************************/
+static inline uint64_t dvbpsi_epg_key(uint16_t i_network_id, uint16_t i_ts_id,
+                                      uint16_t i_service_id)
+{
+    return ((uint64_t)i_network_id << 32) | ((uint32_t)i_ts_id << 16) | i_service_id;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_service_find
+ *****************************************************************************
+ * Index of the service of a key, or of where it would be inserted.
+ *****************************************************************************/
+static size_t dvbpsi_epg_service_find(const dvbpsi_epg_t *p_epg, uint64_t i_key)
+{
+    size_t i_low = 0, i_high = p_epg->i_services;
+    while (i_low < i_high)
+    {
+        size_t i_mid = i_low + (i_high - i_low) / 2;
+        if (p_epg->pp_services[i_mid]->i_key < i_key)
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_service_get
+ *****************************************************************************
+ * Finds the service of a key, NULL if there is none.
+ *****************************************************************************/
+static dvbpsi_epg_service_t *dvbpsi_epg_service_get(const dvbpsi_epg_t *p_epg,
+                                                    uint64_t i_key)
+{
+    size_t i = dvbpsi_epg_service_find(p_epg, i_key);
+    if (i < p_epg->i_services && p_epg->pp_services[i]->i_key == i_key)
+        return p_epg->pp_services[i];
+    return NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_service_add
+ *****************************************************************************
+ * Finds the service of a key, creating it if needed.
+ *****************************************************************************/
+static dvbpsi_epg_service_t *dvbpsi_epg_service_add(dvbpsi_epg_t *p_epg, uint64_t i_key)
+{
+    size_t i = dvbpsi_epg_service_find(p_epg, i_key);
+    if (i < p_epg->i_services && p_epg->pp_services[i]->i_key == i_key)
+        return p_epg->pp_services[i];
+
+    if (p_epg->i_services == p_epg->i_size)
+    {
+        size_t i_size = p_epg->i_size ? 2 * p_epg->i_size : 16;
+        dvbpsi_epg_service_t **pp_services = dvbpsi_malloc(i_size * sizeof(*pp_services));
+        if (pp_services == NULL)
+            return NULL;
+        if (p_epg->i_services)
+            memcpy(pp_services, p_epg->pp_services,
+                   p_epg->i_services * sizeof(*pp_services));
+        dvbpsi_free(p_epg->pp_services);
+        p_epg->pp_services = pp_services;
+        p_epg->i_size = i_size;
+    }
+
+    dvbpsi_epg_service_t *p_service = dvbpsi_calloc(1, sizeof(dvbpsi_epg_service_t));
+    if (p_service == NULL)
+        return NULL;
+    p_service->i_key = i_key;
+    for (unsigned int j = 0; j < DVBPSI_EPG_TABLES; j++)
+        p_service->tables[j].i_version = 0xff;
+
+    memmove(p_epg->pp_services + i + 1, p_epg->pp_services + i,
+            (p_epg->i_services - i) * sizeof(*p_epg->pp_services));
+    p_epg->pp_services[i] = p_service;
+    p_epg->i_services++;
+    return p_service;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_words
+ *****************************************************************************
+ * Adds the hashes of the words of an UTF-8 text not yet in an array, up to
+ * DVBPSI_EPG_WORDS_MAX, and returns the new number of words.
+ *****************************************************************************/
+static unsigned int dvbpsi_epg_words(const char *psz_text, uint32_t *pi_words,
+                                     unsigned int i_words)
+{
+    const uint8_t *p = (const uint8_t *)psz_text;
+    while (*p && i_words < DVBPSI_EPG_WORDS_MAX)
+    {
+        /* FNV-1a of the word, ASCII letters in lower case */
+        uint32_t i_hash = UINT32_C(2166136261);
+        size_t i_length = 0;
+        for (; *p >= 0x80 || (*p >= '0' && *p <= '9') || (*p >= 'a' && *p <= 'z')
+               || (*p >= 'A' && *p <= 'Z'); p++, i_length++)
+        {
+            uint8_t i_char = (*p >= 'A' && *p <= 'Z') ? *p + 'a' - 'A' : *p;
+            i_hash = (i_hash ^ i_char) * UINT32_C(16777619);
+        }
+        if (i_length == 0)
+        {
+            p++;
+            continue;
+        }
+
+        unsigned int i = 0;
+        while (i < i_words && pi_words[i] != i_hash)
+            i++;
+        if (i == i_words)
+            pi_words[i_words++] = i_hash;
+    }
+    return i_words;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_event_terms
+ *****************************************************************************
+ * Reads the genres and the words of the event names of a new event.
+ *****************************************************************************/
+static bool dvbpsi_epg_event_terms(dvbpsi_epg_event_t *p_event)
+{
+    uint32_t pi_words[DVBPSI_EPG_WORDS_MAX];
+    unsigned int i_words = 0;
+
+    p_event->i_genres = 0;
+    for (dvbpsi_descriptor_t *p = p_event->p_first_descriptor; p; p = p->p_next)
+    {
+        if (p->i_tag == 0x54)
+        {
+            for (unsigned int i = 0; i + 1 < p->i_length; i += 2)
+                p_event->i_genres |= 1 << (p->p_data[i] >> 4);
+        }
+        else if (p->i_tag == 0x4d)
+        {
+            /* A character of a DVB text takes up to 3 bytes in UTF-8 */
+            dvbpsi_short_event_compact_t short_event;
+            char psz_name[3 * 255 + 1];
+            if (   dvbpsi_DecodeShortEventDrCompact(p, &short_event)
+                && dvbpsi_text_to_utf8(short_event.p_event_name,
+                                       short_event.i_event_name_length, 0,
+                                       psz_name, sizeof(psz_name)) >= 0)
+                i_words = dvbpsi_epg_words(psz_name, pi_words, i_words);
+        }
+    }
+
+    p_event->i_words = 0;
+    p_event->pi_words = NULL;
+    if (i_words == 0)
+        return true;
+    p_event->pi_words = dvbpsi_malloc(i_words * sizeof(uint32_t));
+    if (p_event->pi_words == NULL)
+        return false;
+    memcpy(p_event->pi_words, pi_words, i_words * sizeof(uint32_t));
+    p_event->i_words = i_words;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_word_compare
+ *****************************************************************************/
+static int dvbpsi_epg_word_compare(const void *p_a, const void *p_b)
+{
+    const dvbpsi_epg_word_t *p_word_a = p_a, *p_word_b = p_b;
+    if (p_word_a->i_hash != p_word_b->i_hash)
+        return p_word_a->i_hash < p_word_b->i_hash ? -1 : 1;
+    if (p_word_a->i_event != p_word_b->i_event)
+        return p_word_a->i_event < p_word_b->i_event ? -1 : 1;
+    return 0;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_id_hash
+ *****************************************************************************/
+static inline size_t dvbpsi_epg_id_hash(uint16_t i_event_id, size_t i_size)
+{
+    return ((uint32_t)i_event_id * UINT32_C(2654435761)) & (i_size - 1);
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_service_ids
+ *****************************************************************************
+ * Refreshes the index of the events by event_id, half full at most. On
+ * error, the events are looked at one by one.
+ *****************************************************************************/
+static void dvbpsi_epg_service_ids(dvbpsi_epg_service_t *p_service)
+{
+    size_t i_size = 16;
+    while (i_size < 2 * p_service->i_events)
+        i_size *= 2;
+
+    /* Grown only, as the other indexes */
+    if (i_size > p_service->i_ids_size)
+    {
+        dvbpsi_free(p_service->pi_ids);
+        p_service->i_ids_size = 0;
+        p_service->pi_ids = dvbpsi_malloc(i_size * sizeof(uint32_t));
+        if (p_service->pi_ids == NULL)
+            return;
+        p_service->i_ids_size = i_size;
+    }
+
+    i_size = p_service->i_ids_size;
+    memset(p_service->pi_ids, 0, i_size * sizeof(uint32_t));
+    for (size_t i = 0; i < p_service->i_events; i++)
+    {
+        size_t j = dvbpsi_epg_id_hash(p_service->p_events[i].i_event_id, i_size);
+        while (p_service->pi_ids[j])
+            j = (j + 1) & (i_size - 1);
+        p_service->pi_ids[j] = i + 1;
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_service_index
+ *****************************************************************************
+ * Refreshes what the queries use besides the events, from what was read of
+ * each event when it was added. On error, the service is left out of the
+ * searches until its next update.
+ *****************************************************************************/
+static void dvbpsi_epg_service_index(dvbpsi_epg_service_t *p_service)
+{
+    uint32_t pi_count[16] = { 0 };
+    size_t i_genres = 0, i_words = 0;
+
+    p_service->i_max_duration = 0;
+    p_service->i_pf = 0;
+    for (size_t i = 0; i < p_service->i_events; i++)
+    {
+        const dvbpsi_epg_event_t *p_event = &p_service->p_events[i];
+        if (p_event->i_duration > p_service->i_max_duration)
+            p_service->i_max_duration = p_event->i_duration;
+        if (p_event->i_table_id < 0x50 && p_service->i_pf < DVBPSI_EPG_PF_MAX)
+            p_service->pi_pf_ids[p_service->i_pf++] = p_event->i_event_id;
+        for (unsigned int n = 0; n < 16; n++)
+            if (p_event->i_genres & (1 << n))
+            {
+                pi_count[n]++;
+                i_genres++;
+            }
+        i_words += p_event->i_words;
+    }
+
+    dvbpsi_epg_service_ids(p_service);
+
+    memset(p_service->pi_genre_offsets, 0, sizeof(p_service->pi_genre_offsets));
+    p_service->i_words = 0;
+
+    /* Grown only, the indexes being refreshed on every update */
+    if (i_genres > p_service->i_genres_size)
+    {
+        dvbpsi_free(p_service->pi_genres);
+        p_service->i_genres_size = 0;
+        p_service->pi_genres = dvbpsi_malloc(2 * i_genres * sizeof(uint32_t));
+        if (p_service->pi_genres == NULL)
+            return;
+        p_service->i_genres_size = 2 * i_genres;
+    }
+    if (i_words > p_service->i_words_size)
+    {
+        dvbpsi_free(p_service->p_words);
+        p_service->i_words_size = 0;
+        p_service->p_words = dvbpsi_malloc(2 * i_words * sizeof(dvbpsi_epg_word_t));
+        if (p_service->p_words == NULL)
+            return;
+        p_service->i_words_size = 2 * i_words;
+    }
+
+    /* The events being by start time, so is each genre */
+    uint32_t pi_next[16];
+    for (unsigned int n = 0; n < 16; n++)
+    {
+        p_service->pi_genre_offsets[n + 1] = p_service->pi_genre_offsets[n] + pi_count[n];
+        pi_next[n] = p_service->pi_genre_offsets[n];
+    }
+    for (size_t i = 0; i < p_service->i_events; i++)
+    {
+        const dvbpsi_epg_event_t *p_event = &p_service->p_events[i];
+        for (unsigned int n = 0; n < 16; n++)
+            if (p_event->i_genres & (1 << n))
+                p_service->pi_genres[pi_next[n]++] = i;
+        for (unsigned int j = 0; j < p_event->i_words; j++)
+        {
+            dvbpsi_epg_word_t *p_word = &p_service->p_words[p_service->i_words++];
+            p_word->i_hash = p_event->pi_words[j];
+            p_word->i_event = i;
+        }
+    }
+    if (p_service->i_words > 1)
+        qsort(p_service->p_words, p_service->i_words, sizeof(dvbpsi_epg_word_t),
+              dvbpsi_epg_word_compare);
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_hidden
+ *****************************************************************************
+ * True for the schedule copy of a present/following event.
+ *****************************************************************************/
+static bool dvbpsi_epg_hidden(const dvbpsi_epg_service_t *p_service,
+                              const dvbpsi_epg_event_t *p_event)
+{
+    if (p_event->i_table_id < 0x50)
+        return false;
+
+    for (unsigned int i = 0; i < p_service->i_pf; i++)
+        if (p_service->pi_pf_ids[i] == p_event->i_event_id)
+            return true;
+    return false;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_event_compare
+ *****************************************************************************/
+static int dvbpsi_epg_event_compare(const void *p_a, const void *p_b)
+{
+    const dvbpsi_epg_event_t *p_event_a = p_a, *p_event_b = p_b;
+    if (p_event_a->i_start != p_event_b->i_start)
+        return p_event_a->i_start < p_event_b->i_start ? -1 : 1;
+    return (int)p_event_a->i_table_id - (int)p_event_b->i_table_id;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_descriptors_copy
+ *****************************************************************************/
+static bool dvbpsi_epg_descriptors_copy(dvbpsi_descriptor_t *p_descriptor,
+                                        dvbpsi_descriptor_t **pp_copy)
+{
+    dvbpsi_descriptor_t **pp_last = pp_copy;
+
+    *pp_copy = NULL;
+    for (; p_descriptor; p_descriptor = p_descriptor->p_next)
+    {
+        *pp_last = dvbpsi_NewDescriptor(p_descriptor->i_tag, p_descriptor->i_length,
+                                        p_descriptor->p_data);
+        if (*pp_last == NULL)
+        {
+            dvbpsi_DeleteDescriptors(*pp_copy);
+            *pp_copy = NULL;
+            return false;
+        }
+        pp_last = &(*pp_last)->p_next;
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_update
+ *****************************************************************************/
+bool dvbpsi_epg_update(dvbpsi_epg_t *p_epg, dvbpsi_eit_t *p_eit, bool b_segment)
+{
+    assert(p_epg);
+    assert(p_eit);
+
+    /* DVBPSI_FLAG_LAZY_DECODE */
+    if (p_eit->p_sections)
+        dvbpsi_eit_decode(p_eit);
+
+    dvbpsi_epg_service_t *p_service = dvbpsi_epg_service_add(p_epg,
+                    dvbpsi_epg_key(p_eit->i_network_id, p_eit->i_ts_id, p_eit->i_extension));
+    if (p_service == NULL)
+        return false;
+
+    /* Copy the new events */
+    uint8_t i_segment = b_segment ? p_eit->i_segment_last_section_number / 8 : 0xff;
+    size_t i_new = 0;
+    for (dvbpsi_eit_event_t *p = p_eit->p_first_event; p; p = p->p_next)
+        i_new++;
+
+    dvbpsi_epg_event_t *p_new = NULL;
+    if (i_new)
+    {
+        p_new = dvbpsi_calloc(i_new, sizeof(dvbpsi_epg_event_t));
+        if (p_new == NULL)
+            return false;
+    }
+
+    size_t i_count = 0;
+    for (dvbpsi_eit_event_t *p = p_eit->p_first_event; p; p = p->p_next)
+    {
+        int64_t i_start = dvbpsi_epg_time(p->i_start_time);
+        if (i_start == INT64_MIN)
+            continue;
+
+        dvbpsi_epg_event_t *p_event = &p_new[i_count];
+        p_event->i_start = i_start;
+        p_event->i_duration = dvbpsi_bcd_to_seconds(p->i_duration);
+        p_event->i_event_id = p->i_event_id;
+        p_event->i_running_status = p->i_running_status;
+        p_event->b_free_ca = p->b_free_ca;
+        p_event->i_table_id = p_eit->i_table_id;
+        p_event->i_segment = i_segment;
+        if (!dvbpsi_epg_descriptors_copy(p->p_first_descriptor,
+                                         &p_event->p_first_descriptor))
+        {
+            dvbpsi_epg_events_delete(p_new, i_count);
+            return false;
+        }
+        i_count++;
+        if (!dvbpsi_epg_event_terms(p_event))
+        {
+            dvbpsi_epg_events_delete(p_new, i_count);
+            return false;
+        }
+    }
+    if (i_count > 1)
+        qsort(p_new, i_count, sizeof(dvbpsi_epg_event_t), dvbpsi_epg_event_compare);
+
+    /* Merge them with the events kept */
+    size_t i_size = p_service->i_events + i_count;
+    dvbpsi_epg_event_t *p_events = NULL;
+    if (i_size)
+    {
+        p_events = dvbpsi_malloc(i_size * sizeof(dvbpsi_epg_event_t));
+        if (p_events == NULL)
+        {
+            dvbpsi_epg_events_delete(p_new, i_count);
+            return false;
+        }
+    }
+
+    size_t i_events = 0, j = 0;
+    for (size_t i = 0; i < p_service->i_events; i++)
+    {
+        dvbpsi_epg_event_t *p_old = &p_service->p_events[i];
+        if (   p_old->i_table_id == p_eit->i_table_id
+            && (!b_segment || p_old->i_segment == i_segment || p_old->i_segment == 0xff))
+        {
+            /* Replaced */
+            dvbpsi_epg_event_clean(p_old);
+            continue;
+        }
+
+        while (j < i_count && dvbpsi_epg_event_compare(&p_new[j], p_old) < 0)
+            p_events[i_events++] = p_new[j++];
+        p_events[i_events++] = *p_old;
+    }
+    while (j < i_count)
+        p_events[i_events++] = p_new[j++];
+
+    dvbpsi_free(p_new);
+    dvbpsi_free(p_service->p_events);
+    p_service->p_events = p_events;
+    p_service->i_events = i_events;
+    dvbpsi_epg_service_index(p_service);
+
+    /* Version the events come from */
+    if (p_eit->i_table_id >= 0x4e && p_eit->i_table_id < 0x4e + DVBPSI_EPG_TABLES)
+    {
+        dvbpsi_epg_table_t *p_table = &p_service->tables[p_eit->i_table_id - 0x4e];
+        if (!b_segment || p_table->i_version != p_eit->i_version)
+        {
+            p_table->i_version = p_eit->i_version;
+            p_table->b_complete = !b_segment;
+            p_table->i_segments = 0;
+        }
+        if (b_segment)
+            p_table->i_segments |= UINT32_C(1) << i_segment;
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_version
+ *****************************************************************************/
+bool dvbpsi_epg_version(dvbpsi_epg_t *p_epg, uint16_t i_network_id,
+                        uint16_t i_ts_id, uint16_t i_service_id, uint8_t i_table_id,
+                        uint8_t *pi_version, uint32_t *pi_segments)
+{
+    assert(p_epg);
+
+    const dvbpsi_epg_service_t *p_service = dvbpsi_epg_service_get(p_epg,
+                                dvbpsi_epg_key(i_network_id, i_ts_id, i_service_id));
+    if (   p_service == NULL
+        || i_table_id < 0x4e || i_table_id >= 0x4e + DVBPSI_EPG_TABLES
+        || p_service->tables[i_table_id - 0x4e].i_version == 0xff)
+        return false;
+
+    const dvbpsi_epg_table_t *p_table = &p_service->tables[i_table_id - 0x4e];
+    *pi_version = p_table->i_version;
+    *pi_segments = p_table->b_complete ? UINT32_MAX : p_table->i_segments;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_writer_t
+ *****************************************************************************
+ * Snapshot being written, or only measured without a buffer.
+ *****************************************************************************/
+typedef struct dvbpsi_epg_writer_s
+{
+    uint8_t *               p_buffer;
+    size_t                  i_pos;
+} dvbpsi_epg_writer_t;
+
+static void dvbpsi_epg_put(dvbpsi_epg_writer_t *p_writer, uint64_t i_value,
+                           unsigned int i_bytes)
+{
+    if (p_writer->p_buffer)
+        for (unsigned int i = 0; i < i_bytes; i++)
+            p_writer->p_buffer[p_writer->i_pos + i] = i_value >> (8 * (i_bytes - 1 - i));
+    p_writer->i_pos += i_bytes;
+}
+
+static void dvbpsi_epg_put_bytes(dvbpsi_epg_writer_t *p_writer, const uint8_t *p_data,
+                                 size_t i_length)
+{
+    if (p_writer->p_buffer && i_length)
+        memcpy(p_writer->p_buffer + p_writer->i_pos, p_data, i_length);
+    p_writer->i_pos += i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_write
+ *****************************************************************************
+ * Writes or measures the snapshot of a store, without its CRC_32.
+ *****************************************************************************/
+static void dvbpsi_epg_write(const dvbpsi_epg_t *p_epg, dvbpsi_epg_writer_t *p_writer)
+{
+    dvbpsi_epg_put_bytes(p_writer, (const uint8_t *)DVBPSI_EPG_MAGIC, 4);
+    dvbpsi_epg_put(p_writer, DVBPSI_EPG_FORMAT, 1);
+    dvbpsi_epg_put(p_writer, 0, 3);
+    dvbpsi_epg_put(p_writer, p_epg->i_services, 4);
+
+    for (size_t i = 0; i < p_epg->i_services; i++)
+    {
+        const dvbpsi_epg_service_t *p_service = p_epg->pp_services[i];
+        unsigned int i_tables = 0;
+        for (unsigned int j = 0; j < DVBPSI_EPG_TABLES; j++)
+            if (p_service->tables[j].i_version != 0xff)
+                i_tables++;
+
+        dvbpsi_epg_put(p_writer, p_service->i_key, 6);
+        dvbpsi_epg_put(p_writer, i_tables, 1);
+        dvbpsi_epg_put(p_writer, p_service->i_events, 4);
+
+        for (unsigned int j = 0; j < DVBPSI_EPG_TABLES; j++)
+        {
+            const dvbpsi_epg_table_t *p_table = &p_service->tables[j];
+            if (p_table->i_version == 0xff)
+                continue;
+            dvbpsi_epg_put(p_writer, 0x4e + j, 1);
+            dvbpsi_epg_put(p_writer, p_table->i_version, 1);
+            dvbpsi_epg_put(p_writer, p_table->b_complete, 1);
+            dvbpsi_epg_put(p_writer, p_table->i_segments, 4);
+        }
+
+        for (size_t j = 0; j < p_service->i_events; j++)
+        {
+            const dvbpsi_epg_event_t *p_event = &p_service->p_events[j];
+            unsigned int i_descriptors = 0;
+            for (dvbpsi_descriptor_t *p = p_event->p_first_descriptor; p; p = p->p_next)
+                i_descriptors++;
+
+            dvbpsi_epg_put(p_writer, (uint64_t)p_event->i_start, 8);
+            dvbpsi_epg_put(p_writer, p_event->i_duration, 4);
+            dvbpsi_epg_put(p_writer, p_event->i_event_id, 2);
+            dvbpsi_epg_put(p_writer, p_event->i_running_status, 1);
+            dvbpsi_epg_put(p_writer, p_event->b_free_ca, 1);
+            dvbpsi_epg_put(p_writer, p_event->i_table_id, 1);
+            dvbpsi_epg_put(p_writer, p_event->i_segment, 1);
+            dvbpsi_epg_put(p_writer, i_descriptors, 2);
+            for (dvbpsi_descriptor_t *p = p_event->p_first_descriptor; p; p = p->p_next)
+            {
+                dvbpsi_epg_put(p_writer, p->i_tag, 1);
+                dvbpsi_epg_put(p_writer, p->i_length, 1);
+                dvbpsi_epg_put_bytes(p_writer, p->p_data, p->i_length);
+            }
+        }
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_save
+ *****************************************************************************/
+size_t dvbpsi_epg_save(dvbpsi_epg_t *p_epg, uint8_t *p_buffer, size_t i_size)
+{
+    assert(p_epg);
+
+    dvbpsi_epg_writer_t writer = { .p_buffer = NULL, .i_pos = 0 };
+    dvbpsi_epg_write(p_epg, &writer);
+    size_t i_length = writer.i_pos + 4;
+    if (p_buffer == NULL || i_size < i_length)
+        return i_length;
+
+    writer.p_buffer = p_buffer;
+    writer.i_pos = 0;
+    dvbpsi_epg_write(p_epg, &writer);
+    dvbpsi_epg_put(&writer, dvbpsi_crc32(0xffffffff, p_buffer, writer.i_pos), 4);
+    return i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_reader_t
+ *****************************************************************************
+ * Snapshot being read, every read checked against its end.
+ *****************************************************************************/
+typedef struct dvbpsi_epg_reader_s
+{
+    const uint8_t *         p_buffer;
+    size_t                  i_size;
+    size_t                  i_pos;
+    bool                    b_error;
+} dvbpsi_epg_reader_t;
+
+static uint64_t dvbpsi_epg_get(dvbpsi_epg_reader_t *p_reader, unsigned int i_bytes)
+{
+    uint64_t i_value = 0;
+    if (p_reader->b_error || p_reader->i_size - p_reader->i_pos < i_bytes)
+    {
+        p_reader->b_error = true;
+        return 0;
+    }
+    for (unsigned int i = 0; i < i_bytes; i++)
+        i_value = (i_value << 8) | p_reader->p_buffer[p_reader->i_pos++];
+    return i_value;
+}
+
+static const uint8_t *dvbpsi_epg_get_bytes(dvbpsi_epg_reader_t *p_reader, size_t i_length)
+{
+    if (p_reader->b_error || p_reader->i_size - p_reader->i_pos < i_length)
+    {
+        p_reader->b_error = true;
+        return NULL;
+    }
+    p_reader->i_pos += i_length;
+    return p_reader->p_buffer + p_reader->i_pos - i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_read_service
+ *****************************************************************************
+ * Reads a service of a snapshot into a store.
+ *****************************************************************************/
+static bool dvbpsi_epg_read_service(dvbpsi_epg_t *p_epg, dvbpsi_epg_reader_t *p_reader)
+{
+    uint64_t i_key = dvbpsi_epg_get(p_reader, 6);
+    unsigned int i_tables = dvbpsi_epg_get(p_reader, 1);
+    size_t i_events = dvbpsi_epg_get(p_reader, 4);
+
+    /* An event takes at least 20 bytes */
+    if (p_reader->b_error || i_events > (p_reader->i_size - p_reader->i_pos) / 20
+        || dvbpsi_epg_service_get(p_epg, i_key))
+        return false;
+
+    dvbpsi_epg_service_t *p_service = dvbpsi_epg_service_add(p_epg, i_key);
+    if (p_service == NULL)
+        return false;
+
+    for (unsigned int i = 0; i < i_tables; i++)
+    {
+        uint8_t i_table_id = dvbpsi_epg_get(p_reader, 1);
+        uint8_t i_version = dvbpsi_epg_get(p_reader, 1);
+        bool b_complete = dvbpsi_epg_get(p_reader, 1) != 0;
+        uint32_t i_segments = dvbpsi_epg_get(p_reader, 4);
+        if (i_table_id < 0x4e || i_table_id >= 0x4e + DVBPSI_EPG_TABLES || i_version > 31)
+            return false;
+        dvbpsi_epg_table_t *p_table = &p_service->tables[i_table_id - 0x4e];
+        p_table->i_version = i_version;
+        p_table->b_complete = b_complete;
+        p_table->i_segments = i_segments;
+    }
+
+    if (i_events)
+    {
+        p_service->p_events = dvbpsi_calloc(i_events, sizeof(dvbpsi_epg_event_t));
+        if (p_service->p_events == NULL)
+            return false;
+    }
+
+    for (size_t i = 0; i < i_events; i++)
+    {
+        dvbpsi_epg_event_t *p_event = &p_service->p_events[i];
+        p_event->i_start = (int64_t)dvbpsi_epg_get(p_reader, 8);
+        p_event->i_duration = dvbpsi_epg_get(p_reader, 4);
+        p_event->i_event_id = dvbpsi_epg_get(p_reader, 2);
+        p_event->i_running_status = dvbpsi_epg_get(p_reader, 1);
+        p_event->b_free_ca = dvbpsi_epg_get(p_reader, 1) != 0;
+        p_event->i_table_id = dvbpsi_epg_get(p_reader, 1);
+        p_event->i_segment = dvbpsi_epg_get(p_reader, 1);
+        unsigned int i_descriptors = dvbpsi_epg_get(p_reader, 2);
+        /* The service owns the event from now on */
+        p_service->i_events = i + 1;
+
+        dvbpsi_descriptor_t **pp_last = &p_event->p_first_descriptor;
+        for (unsigned int j = 0; j < i_descriptors; j++)
+        {
+            uint8_t i_tag = dvbpsi_epg_get(p_reader, 1);
+            uint8_t i_length = dvbpsi_epg_get(p_reader, 1);
+            const uint8_t *p_data = dvbpsi_epg_get_bytes(p_reader, i_length);
+            if (p_data == NULL)
+                return false;
+            *pp_last = dvbpsi_NewDescriptor(i_tag, i_length, NULL);
+            if (*pp_last == NULL)
+                return false;
+            memcpy((*pp_last)->p_data, p_data, i_length);
+            pp_last = &(*pp_last)->p_next;
+        }
+        if (p_reader->b_error || !dvbpsi_epg_event_terms(p_event))
+            return false;
+    }
+
+    if (p_service->i_events > 1)
+        qsort(p_service->p_events, p_service->i_events, sizeof(dvbpsi_epg_event_t),
+              dvbpsi_epg_event_compare);
+    dvbpsi_epg_service_index(p_service);
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_load
+ *****************************************************************************/
+dvbpsi_epg_t *dvbpsi_epg_load(const uint8_t *p_buffer, size_t i_size)
+{
+    assert(p_buffer);
+
+    /* Header and CRC_32 */
+    if (   i_size < 16
+        || memcmp(p_buffer, DVBPSI_EPG_MAGIC, 4) != 0
+        || p_buffer[4] != DVBPSI_EPG_FORMAT)
+        return NULL;
+
+    const uint8_t *p_crc = p_buffer + i_size - 4;
+    uint32_t i_crc = ((uint32_t)p_crc[0] << 24) | ((uint32_t)p_crc[1] << 16)
+                   | ((uint32_t)p_crc[2] << 8) | p_crc[3];
+    if (dvbpsi_crc32(0xffffffff, p_buffer, i_size - 4) != i_crc)
+        return NULL;
+
+    dvbpsi_epg_t *p_epg = dvbpsi_epg_new();
+    if (p_epg == NULL)
+        return NULL;
+
+    dvbpsi_epg_reader_t reader = {
+        .p_buffer = p_buffer, .i_size = i_size - 4, .i_pos = 8, .b_error = false
+    };
+    size_t i_services = dvbpsi_epg_get(&reader, 4);
+    for (size_t i = 0; i < i_services; i++)
+    {
+        if (!dvbpsi_epg_read_service(p_epg, &reader))
+        {
+            dvbpsi_epg_delete(p_epg);
+            return NULL;
+        }
+    }
+
+    if (reader.b_error || reader.i_pos != reader.i_size)
+    {
+        dvbpsi_epg_delete(p_epg);
+        return NULL;
+    }
+    return p_epg;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_expire
+ *****************************************************************************/
+void dvbpsi_epg_expire(dvbpsi_epg_t *p_epg, int64_t i_time)
+{
+    assert(p_epg);
+
+    for (size_t i = 0; i < p_epg->i_services; i++)
+    {
+        dvbpsi_epg_service_t *p_service = p_epg->pp_services[i];
+        size_t i_events = 0;
+
+        for (size_t j = 0; j < p_service->i_events; j++)
+        {
+            dvbpsi_epg_event_t *p_event = &p_service->p_events[j];
+            if (p_event->i_start + p_event->i_duration <= i_time)
+                dvbpsi_epg_event_clean(p_event);
+            else
+                p_service->p_events[i_events++] = *p_event;
+        }
+
+        if (i_events != p_service->i_events)
+        {
+            p_service->i_events = i_events;
+            dvbpsi_epg_service_index(p_service);
+        }
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_status
+ *****************************************************************************
+ * Sets the running_status of the events of an event_id of a service,
+ * returning the number of events changed.
+ *****************************************************************************/
+static size_t dvbpsi_epg_status(dvbpsi_epg_service_t *p_service, uint16_t i_event_id,
+                                uint8_t i_running_status)
+{
+    size_t i_changed = 0;
+
+    if (p_service->pi_ids == NULL)
+    {
+        for (size_t i = 0; i < p_service->i_events; i++)
+        {
+            dvbpsi_epg_event_t *p_event = &p_service->p_events[i];
+            if (   p_event->i_event_id == i_event_id
+                && p_event->i_running_status != i_running_status)
+            {
+                p_event->i_running_status = i_running_status;
+                i_changed++;
+            }
+        }
+        return i_changed;
+    }
+
+    size_t i_size = p_service->i_ids_size;
+    for (size_t j = dvbpsi_epg_id_hash(i_event_id, i_size); p_service->pi_ids[j];
+         j = (j + 1) & (i_size - 1))
+    {
+        dvbpsi_epg_event_t *p_event = &p_service->p_events[p_service->pi_ids[j] - 1];
+        if (   p_event->i_event_id == i_event_id
+            && p_event->i_running_status != i_running_status)
+        {
+            p_event->i_running_status = i_running_status;
+            i_changed++;
+        }
+    }
+    return i_changed;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_rst
+ *****************************************************************************/
+size_t dvbpsi_epg_rst(dvbpsi_epg_t *p_epg, dvbpsi_rst_t *p_rst)
+{
+    assert(p_epg);
+    assert(p_rst);
+
+    size_t i_changed = 0;
+    for (dvbpsi_rst_event_t *p = p_rst->p_first_event; p; p = p->p_next)
+    {
+        dvbpsi_epg_service_t *p_service = dvbpsi_epg_service_get(p_epg,
+                    dvbpsi_epg_key(p->i_orig_network_id, p->i_ts_id, p->i_service_id));
+        if (p_service)
+            i_changed += dvbpsi_epg_status(p_service, p->i_event_id, p->i_running_status);
+    }
+    return i_changed;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_after
+ *****************************************************************************
+ * Index of the first event of a service starting after a time.
+ *****************************************************************************/
+static size_t dvbpsi_epg_after(const dvbpsi_epg_service_t *p_service, int64_t i_time)
+{
+    size_t i_low = 0, i_high = p_service->i_events;
+    while (i_low < i_high)
+    {
+        size_t i_mid = i_low + (i_high - i_low) / 2;
+        if (p_service->p_events[i_mid].i_start <= i_time)
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_at
+ *****************************************************************************/
+const dvbpsi_epg_event_t *dvbpsi_epg_at(dvbpsi_epg_t *p_epg, uint16_t i_network_id,
+                                        uint16_t i_ts_id, uint16_t i_service_id,
+                                        int64_t i_time)
+{
+    assert(p_epg);
+
+    const dvbpsi_epg_service_t *p_service = dvbpsi_epg_service_get(p_epg,
+                                dvbpsi_epg_key(i_network_id, i_ts_id, i_service_id));
+    if (p_service == NULL)
+        return NULL;
+
+    /* Only the events starting less than the longest duration before
+       i_time may still be on */
+    const dvbpsi_epg_event_t *p_found = NULL;
+    for (size_t i = dvbpsi_epg_after(p_service, i_time); i > 0; i--)
+    {
+        const dvbpsi_epg_event_t *p_event = &p_service->p_events[i - 1];
+        if (p_event->i_start + p_service->i_max_duration <= i_time)
+            break;
+        if (   p_event->i_start + p_event->i_duration <= i_time
+            || dvbpsi_epg_hidden(p_service, p_event))
+            continue;
+
+        if (p_event->i_table_id < 0x50)
+            return p_event;
+        if (p_found == NULL)
+            p_found = p_event;
+    }
+    return p_found;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_next
+ *****************************************************************************/
+size_t dvbpsi_epg_next(dvbpsi_epg_t *p_epg, uint16_t i_network_id,
+                       uint16_t i_ts_id, uint16_t i_service_id, int64_t i_time,
+                       const dvbpsi_epg_event_t **pp_events, size_t i_max)
+{
+    assert(p_epg);
+
+    const dvbpsi_epg_service_t *p_service = dvbpsi_epg_service_get(p_epg,
+                                dvbpsi_epg_key(i_network_id, i_ts_id, i_service_id));
+    if (p_service == NULL)
+        return 0;
+
+    size_t i_count = 0;
+    for (size_t i = dvbpsi_epg_after(p_service, i_time);
+         i < p_service->i_events && i_count < i_max; i++)
+    {
+        if (!dvbpsi_epg_hidden(p_service, &p_service->p_events[i]))
+            pp_events[i_count++] = &p_service->p_events[i];
+    }
+    return i_count;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_match
+ *****************************************************************************
+ * Counts an event found by a search, keeping it if there is room.
+ *****************************************************************************/
+static void dvbpsi_epg_match(const dvbpsi_epg_service_t *p_service,
+                             const dvbpsi_epg_event_t *p_event,
+                             dvbpsi_epg_match_t *p_matches, size_t i_max,
+                             size_t *pi_count)
+{
+    if (*pi_count < i_max)
+    {
+        dvbpsi_epg_match_t *p_match = &p_matches[*pi_count];
+        p_match->i_network_id = p_service->i_key >> 32;
+        p_match->i_ts_id = p_service->i_key >> 16;
+        p_match->i_service_id = p_service->i_key;
+        p_match->p_event = p_event;
+    }
+    (*pi_count)++;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_first
+ *****************************************************************************
+ * Index of the first event of a service that may still be on at a time,
+ * only the events starting less than the longest duration before it.
+ *****************************************************************************/
+static size_t dvbpsi_epg_first(const dvbpsi_epg_service_t *p_service, int64_t i_time)
+{
+    if (i_time < INT64_MIN + p_service->i_max_duration)
+        return 0;
+    return dvbpsi_epg_after(p_service, i_time - p_service->i_max_duration);
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_genre
+ *****************************************************************************/
+size_t dvbpsi_epg_genre(dvbpsi_epg_t *p_epg, uint8_t i_nibble,
+                        int64_t i_from, int64_t i_to,
+                        dvbpsi_epg_match_t *p_matches, size_t i_max)
+{
+    assert(p_epg);
+
+    if (i_nibble > 0xf)
+        return 0;
+
+    size_t i_count = 0;
+    for (size_t i = 0; i < p_epg->i_services; i++)
+    {
+        const dvbpsi_epg_service_t *p_service = p_epg->pp_services[i];
+        uint32_t i_low = p_service->pi_genre_offsets[i_nibble];
+        uint32_t i_high = p_service->pi_genre_offsets[i_nibble + 1];
+        if (i_low == i_high)
+            continue;
+
+        size_t i_first = dvbpsi_epg_first(p_service, i_from);
+        while (i_low < i_high)
+        {
+            uint32_t i_mid = i_low + (i_high - i_low) / 2;
+            if (p_service->pi_genres[i_mid] < i_first)
+                i_low = i_mid + 1;
+            else
+                i_high = i_mid;
+        }
+
+        for (uint32_t j = i_low; j < p_service->pi_genre_offsets[i_nibble + 1]; j++)
+        {
+            const dvbpsi_epg_event_t *p_event = &p_service->p_events[p_service->pi_genres[j]];
+            if (p_event->i_start >= i_to)
+                break;
+            if (   p_event->i_start + p_event->i_duration > i_from
+                && !dvbpsi_epg_hidden(p_service, p_event))
+                dvbpsi_epg_match(p_service, p_event, p_matches, i_max, &i_count);
+        }
+    }
+    return i_count;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_word_find
+ *****************************************************************************
+ * Index of the first word of a service not before a hash and event.
+ *****************************************************************************/
+static size_t dvbpsi_epg_word_find(const dvbpsi_epg_service_t *p_service,
+                                   uint32_t i_hash, uint64_t i_event)
+{
+    size_t i_low = 0, i_high = p_service->i_words;
+    while (i_low < i_high)
+    {
+        size_t i_mid = i_low + (i_high - i_low) / 2;
+        const dvbpsi_epg_word_t *p_word = &p_service->p_words[i_mid];
+        if (   p_word->i_hash < i_hash
+            || (p_word->i_hash == i_hash && p_word->i_event < i_event))
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
+}
+
+/*****************************************************************************
+ * dvbpsi_epg_search
+ *****************************************************************************/
+size_t dvbpsi_epg_search(dvbpsi_epg_t *p_epg, const char *psz_words,
+                         int64_t i_from, int64_t i_to,
+                         dvbpsi_epg_match_t *p_matches, size_t i_max)
+{
+    assert(p_epg);
+    assert(psz_words);
+
+    uint32_t pi_words[DVBPSI_EPG_WORDS_MAX];
+    unsigned int i_words = dvbpsi_epg_words(psz_words, pi_words, 0);
+    if (i_words == 0)
+        return 0;
+
+    size_t i_count = 0;
+    for (size_t i = 0; i < p_epg->i_services; i++)
+    {
+        const dvbpsi_epg_service_t *p_service = p_epg->pp_services[i];
+        if (p_service->i_words == 0)
+            continue;
+
+        /* Walks the events of the rarest word from the first event that
+           may still be on at i_from */
+        size_t i_first = dvbpsi_epg_first(p_service, i_from);
+        size_t i_low = 0, i_high = 0;
+        unsigned int i_rarest = 0;
+        for (unsigned int j = 0; j < i_words; j++)
+        {
+            size_t i_word_low = dvbpsi_epg_word_find(p_service, pi_words[j], i_first);
+            size_t i_word_high = dvbpsi_epg_word_find(p_service, pi_words[j], UINT64_MAX);
+            if (j == 0 || i_word_high - i_word_low < i_high - i_low)
+            {
+                i_low = i_word_low;
+                i_high = i_word_high;
+                i_rarest = j;
+            }
+            if (i_low == i_high)
+                break;
+        }
+
+        for (size_t j = i_low; j < i_high; j++)
+        {
+            uint32_t i_event = p_service->p_words[j].i_event;
+            const dvbpsi_epg_event_t *p_event = &p_service->p_events[i_event];
+            if (p_event->i_start >= i_to)
+                break;
+            if (   p_event->i_start + p_event->i_duration <= i_from
+                || dvbpsi_epg_hidden(p_service, p_event))
+                continue;
+
+            unsigned int k = 0;
+            for (; k < i_words; k++)
+            {
+                if (k == i_rarest)
+                    continue;
+                size_t i_word = dvbpsi_epg_word_find(p_service, pi_words[k], i_event);
+                if (   i_word == p_service->i_words
+                    || p_service->p_words[i_word].i_hash != pi_words[k]
+                    || p_service->p_words[i_word].i_event != i_event)
+                    break;
+            }
+            if (k == i_words)
+                dvbpsi_epg_match(p_service, p_event, p_matches, i_max, &i_count);
+        }
+    }
+    return i_count;
+}
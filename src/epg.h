@@ -0,0 +1,375 @@
+/*****************************************************************************
+ * epg.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <epg.h>
+ * \brief In-memory EPG store.
+ *
+ * Keeps the events of the EITs given by the EIT decoders per service,
+ * ordered by start time, and answers what is on a service at a time and
+ * what comes next. The present/following and schedule tables of a service
+ * are merged, each table or segment replacing the events it previously
+ * carried.
+ *
+ * A store can be saved to a snapshot and loaded back on the next start,
+ * for instance from a memory-mapped file, the EIT decoders then resuming
+ * from the versions it records with dvbpsi_eit_restore().
+ *
+ * The store also indexes its events by content_nibble_level_1 of their
+ * content descriptors and by the words of the event names of their short
+ * event descriptors, both indexes being refreshed with the events of a
+ * service so that looking for all the sport events of the next hours or
+ * for a title across all the services needs no decoding.
+ */
+
+#ifndef _DVBPSI_EPG_H_
+#define _DVBPSI_EPG_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_epg_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_epg_s dvbpsi_epg_t
+ * \brief dvbpsi_epg_t type definition, an opaque EPG store.
+ */
+typedef struct dvbpsi_epg_s dvbpsi_epg_t;
+
+/*****************************************************************************
+ * dvbpsi_epg_event_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_epg_event_s
+ * \brief Event of an EPG store.
+ */
+/*!
+ * \typedef struct dvbpsi_epg_event_s dvbpsi_epg_event_t
+ * \brief dvbpsi_epg_event_t type definition.
+ */
+typedef struct dvbpsi_epg_event_s
+{
+    int64_t               i_start;            /*!< start time in seconds
+                                                   since 1970-01-01 UTC */
+    uint32_t              i_duration;         /*!< duration in seconds */
+    uint16_t              i_event_id;         /*!< event_id */
+    uint8_t               i_running_status;   /*!< running_status */
+    bool                  b_free_ca;          /*!< free_CA_mode */
+    uint8_t               i_table_id;         /*!< table_id of the EIT */
+    uint8_t               i_segment;          /*!< private, segment of the
+                                                   EIT, 0xff for a whole
+                                                   table */
+    uint16_t              i_genres;           /*!< bit n set for each
+                                                   content_nibble_level_1 n
+                                                   of its content
+                                                   descriptors */
+    uint8_t               i_words;            /*!< private, number of words
+                                                   of its event names */
+    uint32_t *            pi_words;           /*!< private, hashes of the
+                                                   words of its event names */
+    dvbpsi_descriptor_t * p_first_descriptor; /*!< copies of the descriptors */
+} dvbpsi_epg_event_t;
+
+/*****************************************************************************
+ * dvbpsi_epg_match_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_epg_match_s
+ * \brief Event found by a search of an EPG store, with its service.
+ */
+/*!
+ * \typedef struct dvbpsi_epg_match_s dvbpsi_epg_match_t
+ * \brief dvbpsi_epg_match_t type definition.
+ */
+typedef struct dvbpsi_epg_match_s
+{
+    uint16_t                    i_network_id;   /*!< original_network_id */
+    uint16_t                    i_ts_id;        /*!< transport_stream_id */
+    uint16_t                    i_service_id;   /*!< service_id */
+    const dvbpsi_epg_event_t *  p_event;        /*!< the event, valid until
+                                                     the next update or expiry
+                                                     of the store */
+} dvbpsi_epg_match_t;
+
+/*****************************************************************************
+ * dvbpsi_epg_time
+ *****************************************************************************/
+/*!
+ * \fn int64_t dvbpsi_epg_time(uint64_t i_start_time)
+ * \brief Converts a start_time, 16 bits of MJD and 24 bits of BCD time, to
+ * seconds since 1970-01-01 UTC
+ * \param i_start_time start_time as in dvbpsi_eit_event_t
+ * \return the time, or INT64_MIN for an undefined start_time (all bits
+ *         set).
+ */
+int64_t dvbpsi_epg_time(uint64_t i_start_time);
+
+/*****************************************************************************
+ * dvbpsi_epg_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_epg_t *dvbpsi_epg_new(void)
+ * \brief Creates an empty EPG store
+ * \return pointer to the store, or NULL on error
+ */
+dvbpsi_epg_t *dvbpsi_epg_new(void);
+
+/*****************************************************************************
+ * dvbpsi_epg_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_epg_delete(dvbpsi_epg_t *p_epg)
+ * \brief Deletes an EPG store and all its events
+ * \param p_epg pointer to the store
+ * \return nothing
+ */
+void dvbpsi_epg_delete(dvbpsi_epg_t *p_epg);
+
+/*****************************************************************************
+ * dvbpsi_epg_update
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_epg_update(dvbpsi_epg_t *p_epg, dvbpsi_eit_t *p_eit,
+ *                            bool b_segment)
+ * \brief Replaces the events of a service carried by a table or a segment
+ * \param p_epg pointer to the store
+ * \param p_eit EIT of the service, present/following or schedule, decoded
+ *        if it was not yet, its events being copied
+ * \param b_segment true for an EIT given to the callback of
+ *        dvbpsi_eit_set_segment_callback(), which only replaces the events
+ *        of its segment, false for a whole table, which replaces all the
+ *        events of its table_id
+ * \return false on error, in which case the service keeps its previous
+ *         events, true otherwise.
+ *
+ * The events of a table_id are expected to be given either as whole tables
+ * or by segment: the first segment of a table_id also removes the events a
+ * whole table gave for it. Events with an undefined start_time are
+ * ignored. The cost is linear in the number of events of the service,
+ * with no decoding of the events already stored: only the content and
+ * short event descriptors of the new events are read for the indexes.
+ */
+bool dvbpsi_epg_update(dvbpsi_epg_t *p_epg, dvbpsi_eit_t *p_eit, bool b_segment);
+
+/*****************************************************************************
+ * dvbpsi_epg_expire
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_epg_expire(dvbpsi_epg_t *p_epg, int64_t i_time)
+ * \brief Removes the events ended at a time from all the services
+ * \param p_epg pointer to the store
+ * \param i_time time in seconds since 1970-01-01 UTC
+ * \return nothing
+ */
+void dvbpsi_epg_expire(dvbpsi_epg_t *p_epg, int64_t i_time);
+
+/*****************************************************************************
+ * dvbpsi_epg_rst
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_epg_rst(dvbpsi_epg_t *p_epg, dvbpsi_rst_t *p_rst)
+ * \brief Applies the running status of a RST to the events of a store
+ * \param p_epg pointer to the store
+ * \param p_rst RST, unchanged
+ * \return the number of events whose running_status changed.
+ *
+ * The events are found by event_id through an index of each service
+ * refreshed with its events, the schedule copy of a present/following
+ * event changing with it. The RST entries of events not in the store are
+ * ignored.
+ */
+size_t dvbpsi_epg_rst(dvbpsi_epg_t *p_epg, dvbpsi_rst_t *p_rst);
+
+/*****************************************************************************
+ * dvbpsi_epg_at
+ *****************************************************************************/
+/*!
+ * \fn const dvbpsi_epg_event_t *dvbpsi_epg_at(dvbpsi_epg_t *p_epg,
+ *                                            uint16_t i_network_id,
+ *                                            uint16_t i_ts_id,
+ *                                            uint16_t i_service_id,
+ *                                            int64_t i_time)
+ * \brief Finds the event of a service on at a time
+ * \param p_epg pointer to the store
+ * \param i_network_id original_network_id of the service
+ * \param i_ts_id transport_stream_id of the service
+ * \param i_service_id service_id
+ * \param i_time time in seconds since 1970-01-01 UTC
+ * \return the event, valid until the next update or expiry of the store,
+ *         or NULL if there is none.
+ *
+ * An event of a present/following table wins over a schedule one, and the
+ * schedule copy of a present/following event is hidden. The cost is
+ * O(log n) with n events of the service.
+ */
+const dvbpsi_epg_event_t *dvbpsi_epg_at(dvbpsi_epg_t *p_epg, uint16_t i_network_id,
+                                        uint16_t i_ts_id, uint16_t i_service_id,
+                                        int64_t i_time);
+
+/*****************************************************************************
+ * dvbpsi_epg_next
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_epg_next(dvbpsi_epg_t *p_epg, uint16_t i_network_id,
+ *                            uint16_t i_ts_id, uint16_t i_service_id,
+ *                            int64_t i_time,
+ *                            const dvbpsi_epg_event_t **pp_events,
+ *                            size_t i_max)
+ * \brief Gets the next events of a service, starting after a time
+ * \param p_epg pointer to the store
+ * \param i_network_id original_network_id of the service
+ * \param i_ts_id transport_stream_id of the service
+ * \param i_service_id service_id
+ * \param i_time time in seconds since 1970-01-01 UTC
+ * \param pp_events filled with up to i_max events by start time, valid
+ *        until the next update or expiry of the store
+ * \param i_max maximum number of events
+ * \return the number of events.
+ *
+ * The cost is O(log n + i_max) with n events of the service.
+ */
+size_t dvbpsi_epg_next(dvbpsi_epg_t *p_epg, uint16_t i_network_id,
+                       uint16_t i_ts_id, uint16_t i_service_id, int64_t i_time,
+                       const dvbpsi_epg_event_t **pp_events, size_t i_max);
+
+/*****************************************************************************
+ * dvbpsi_epg_genre
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_epg_genre(dvbpsi_epg_t *p_epg, uint8_t i_nibble,
+ *                             int64_t i_from, int64_t i_to,
+ *                             dvbpsi_epg_match_t *p_matches, size_t i_max)
+ * \brief Finds the events of a genre on between two times, on all the
+ * services
+ * \param p_epg pointer to the store
+ * \param i_nibble content_nibble_level_1, DVBPSI_CONTENT_CAT_* of dr_54.h
+ * \param i_from start of the period in seconds since 1970-01-01 UTC
+ * \param i_to end of the period, excluded
+ * \param p_matches filled with up to i_max events, by service then start
+ *        time
+ * \param i_max maximum number of events
+ * \return the number of events found, which may be larger than i_max.
+ *
+ * The events overlapping the period are found, the schedule copies of
+ * present/following events being hidden as by dvbpsi_epg_next(). The cost
+ * is O(s log n + m) with s services, n events per service and m events
+ * found.
+ */
+size_t dvbpsi_epg_genre(dvbpsi_epg_t *p_epg, uint8_t i_nibble,
+                        int64_t i_from, int64_t i_to,
+                        dvbpsi_epg_match_t *p_matches, size_t i_max);
+
+/*****************************************************************************
+ * dvbpsi_epg_search
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_epg_search(dvbpsi_epg_t *p_epg, const char *psz_words,
+ *                              int64_t i_from, int64_t i_to,
+ *                              dvbpsi_epg_match_t *p_matches, size_t i_max)
+ * \brief Finds the events whose name has all the given words, on between
+ * two times, on all the services
+ * \param p_epg pointer to the store
+ * \param psz_words words in UTF-8, separated by spaces or punctuation
+ * \param i_from start of the period in seconds since 1970-01-01 UTC
+ * \param i_to end of the period, excluded
+ * \param p_matches filled with up to i_max events, by service then start
+ *        time
+ * \param i_max maximum number of events
+ * \return the number of events found, which may be larger than i_max.
+ *
+ * The event names of the short event descriptors are converted to UTF-8
+ * and cut into words at the ASCII spaces and punctuation, ASCII letters
+ * being matched regardless of their case while the other characters are
+ * matched as they are. Words are compared by a 32 bits hash, so that a rare event may
+ * match a word it does not have. The cost is O(s log w + m) with s
+ * services, w words per service and m events having the rarest word.
+ */
+size_t dvbpsi_epg_search(dvbpsi_epg_t *p_epg, const char *psz_words,
+                         int64_t i_from, int64_t i_to,
+                         dvbpsi_epg_match_t *p_matches, size_t i_max);
+
+/*****************************************************************************
+ * dvbpsi_epg_version
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_epg_version(dvbpsi_epg_t *p_epg, uint16_t i_network_id,
+ *                             uint16_t i_ts_id, uint16_t i_service_id,
+ *                             uint8_t i_table_id, uint8_t *pi_version,
+ *                             uint32_t *pi_segments)
+ * \brief Gets the version of an EIT the events of a service come from
+ * \param p_epg pointer to the store
+ * \param i_network_id original_network_id of the service
+ * \param i_ts_id transport_stream_id of the service
+ * \param i_service_id service_id
+ * \param i_table_id table_id of the EIT, 0x4e to 0x6f
+ * \param pi_version filled with the version_number
+ * \param pi_segments filled with UINT32_MAX for a whole table, or the bit
+ *        mask of the segments of the version given by segment
+ * \return false if no EIT of this table_id was given for the service, true
+ *         otherwise.
+ */
+bool dvbpsi_epg_version(dvbpsi_epg_t *p_epg, uint16_t i_network_id,
+                        uint16_t i_ts_id, uint16_t i_service_id, uint8_t i_table_id,
+                        uint8_t *pi_version, uint32_t *pi_segments);
+
+/*****************************************************************************
+ * dvbpsi_epg_save
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_epg_save(dvbpsi_epg_t *p_epg, uint8_t *p_buffer,
+ *                            size_t i_size)
+ * \brief Writes a snapshot of an EPG store
+ * \param p_epg pointer to the store
+ * \param p_buffer buffer for the snapshot, or NULL to get its size
+ * \param i_size size of the buffer
+ * \return the size of the snapshot. Nothing is written if it is larger than
+ *         i_size.
+ *
+ * The snapshot holds the events, their descriptors and the versions of the
+ * EITs of every service, in a versioned format protected by a CRC_32 and
+ * independent of the host byte order.
+ */
+size_t dvbpsi_epg_save(dvbpsi_epg_t *p_epg, uint8_t *p_buffer, size_t i_size);
+
+/*****************************************************************************
+ * dvbpsi_epg_load
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_epg_t *dvbpsi_epg_load(const uint8_t *p_buffer, size_t i_size)
+ * \brief Creates an EPG store from a snapshot of dvbpsi_epg_save()
+ * \param p_buffer snapshot, for instance a memory-mapped file, which is not
+ *        needed anymore once the function returns
+ * \param i_size size of the snapshot
+ * \return pointer to the store, or NULL if the snapshot is truncated,
+ *         corrupted, of another format or on error
+ */
+dvbpsi_epg_t *dvbpsi_epg_load(const uint8_t *p_buffer, size_t i_size);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of epg.h"
+#endif
@@ -0,0 +1,730 @@
+/*****************************************************************************
+ * epgsched.c: now/next transitions of the services of an EPG store
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "descriptor.h"
+#include "tables/eit.h"
+#include "tables/rst.h"
+#include "tables/tot.h"
+#include "epg.h"
+#include "epgsched.h"
+
+/* Events followed per service: the one on and the following one */
+#define DVBPSI_EPGSCHED_EVENTS 2
+
+/* Timer wheel: 4 levels of 64 slots of 1, 64, 4096 and 262144 seconds,
+   about 194 days, the later timers waiting in the last slots */
+#define DVBPSI_EPGSCHED_BITS   6
+#define DVBPSI_EPGSCHED_SLOTS  (1 << DVBPSI_EPGSCHED_BITS)
+#define DVBPSI_EPGSCHED_LEVELS 4
+#define DVBPSI_EPGSCHED_RANGE  (INT64_C(1) << (DVBPSI_EPGSCHED_BITS * DVBPSI_EPGSCHED_LEVELS))
+
+/* Slot of the timers already due */
+#define DVBPSI_EPGSCHED_DUE    0xffff
+
+/* running_status */
+#define DVBPSI_EPGSCHED_NOT_RUNNING 1
+#define DVBPSI_EPGSCHED_RUNNING     4
+
+typedef struct dvbpsi_epgsched_service_s dvbpsi_epgsched_service_t;
+
+/*****************************************************************************
+ * dvbpsi_epgsched_timer_t
+ *****************************************************************************
+ * Start or end of an event, in the list of a slot of the wheel or of the
+ * due timers, the ends and the starts being in separate lists.
+ *****************************************************************************/
+typedef struct dvbpsi_epgsched_timer_s
+{
+    struct dvbpsi_epgsched_timer_s *  p_next;
+    struct dvbpsi_epgsched_timer_s ** pp_prev;  /* NULL if not queued */
+    int64_t                     i_time;
+    uint16_t                    i_slot;         /* level * SLOTS + slot */
+    uint8_t                     i_kind;
+    uint8_t                     i_entry;        /* in the events */
+    dvbpsi_epgsched_service_t * p_service;
+} dvbpsi_epgsched_timer_t;
+
+/*****************************************************************************
+ * dvbpsi_epgsched_entry_t
+ *****************************************************************************
+ * Event followed on a service.
+ *****************************************************************************/
+typedef struct dvbpsi_epgsched_entry_s
+{
+    dvbpsi_epgsched_timer_t     start;
+    dvbpsi_epgsched_timer_t     end;
+    uint16_t                    i_event_id;
+    uint8_t                     i_running_status;   /* last applied */
+    bool                        b_used;
+    bool                        b_started;
+    bool                        b_done;         /* ended, or missed */
+} dvbpsi_epgsched_entry_t;
+
+/*****************************************************************************
+ * dvbpsi_epgsched_service_t
+ *****************************************************************************/
+struct dvbpsi_epgsched_service_s
+{
+    uint64_t                    i_key;          /* original_network_id,
+                                                   transport_stream_id and
+                                                   service_id */
+    dvbpsi_epgsched_entry_t     events[DVBPSI_EPGSCHED_EVENTS];
+};
+
+/*****************************************************************************
+ * dvbpsi_epgsched_s
+ *****************************************************************************/
+struct dvbpsi_epgsched_s
+{
+    dvbpsi_epg_t *              p_epg;
+    dvbpsi_epgsched_callback    pf_callback;
+    void *                      p_cb_data;
+
+    int64_t                     i_next;         /* next second to fire, the
+                                                   scheduler time plus one */
+    size_t                      i_timers;       /* in the wheel */
+    dvbpsi_epgsched_timer_t *   pp_slots[DVBPSI_EPGSCHED_LEVELS][DVBPSI_EPGSCHED_SLOTS][2];
+    uint64_t                    pi_occupied[DVBPSI_EPGSCHED_LEVELS];
+    dvbpsi_epgsched_timer_t *   p_due[2];
+
+    dvbpsi_epgsched_service_t **pp_services;    /* by key */
+    size_t                      i_services;
+    size_t                      i_size;
+};
+
+/*****************************************************************************
+ * dvbpsi_epgsched_new
+ *****************************************************************************/
+dvbpsi_epgsched_t *dvbpsi_epgsched_new(dvbpsi_epg_t *p_epg, int64_t i_time,
+                                       dvbpsi_epgsched_callback pf_callback,
+                                       void *p_cb_data)
+{
+    assert(p_epg);
+    assert(pf_callback);
+
+    dvbpsi_epgsched_t *p_sched = dvbpsi_calloc(1, sizeof(dvbpsi_epgsched_t));
+    if (p_sched == NULL)
+        return NULL;
+    p_sched->p_epg = p_epg;
+    p_sched->pf_callback = pf_callback;
+    p_sched->p_cb_data = p_cb_data;
+    p_sched->i_next = i_time + 1;
+    return p_sched;
+}
+
+/*****************************************************************************
+ * dvbpsi_epgsched_delete
+ *****************************************************************************/
+void dvbpsi_epgsched_delete(dvbpsi_epgsched_t *p_sched)
+{
+    if (p_sched == NULL)
+        return;
+
+    for (size_t i = 0; i < p_sched->i_services; i++)
+        dvbpsi_free(p_sched->pp_services[i]);
+    dvbpsi_free(p_sched->pp_services);
+    dvbpsi_free(p_sched);
+}
+
+/*****************************************************************************
+ * dvbpsi_epgsched_timer_add
+ *****************************************************************************
+ * Queues a timer in the slot of its time, or with the due timers.
+ *****************************************************************************/
+static void dvbpsi_epgsched_timer_add(dvbpsi_epgsched_t *p_sched,
+                                      dvbpsi_epgsched_timer_t *p_timer)
+{
+    assert(p_timer->pp_prev == NULL);
+
+    dvbpsi_epgsched_timer_t **pp_head;
+    int64_t i_delta = p_timer->i_time - p_sched->i_next;
+    if (i_delta < 0)
+    {
+        p_timer->i_slot = DVBPSI_EPGSCHED_DUE;
+        pp_head = &p_sched->p_due[p_timer->i_kind];
+    }
+    else
+    {
+        int64_t i_time = p_timer->i_time;
+        if (i_delta >= DVBPSI_EPGSCHED_RANGE)
+            i_time = p_sched->i_next + DVBPSI_EPGSCHED_RANGE - 1;
+
+        unsigned int i_level = 0;
+        while (   i_level + 1 < DVBPSI_EPGSCHED_LEVELS
+               && i_delta >= INT64_C(1) << (DVBPSI_EPGSCHED_BITS * (i_level + 1)))
+            i_level++;
+        unsigned int i_slot = (i_time >> (DVBPSI_EPGSCHED_BITS * i_level))
+                            & (DVBPSI_EPGSCHED_SLOTS - 1);
+
+        p_timer->i_slot = i_level * DVBPSI_EPGSCHED_SLOTS + i_slot;
+        pp_head = &p_sched->pp_slots[i_level][i_slot][p_timer->i_kind];
+        p_sched->pi_occupied[i_level] |= UINT64_C(1) << i_slot;
+        p_sched->i_timers++;
+    }
+
+    p_timer->p_next = *pp_head;
+    if (p_timer->p_next)
+        p_timer->p_next->pp_prev = &p_timer->p_next;
+    p_timer->pp_prev = pp_head;
+    *pp_head = p_timer;
+}
+
+/*****************************************************************************
+ * dvbpsi_epgsched_timer_cancel
+ *****************************************************************************/
+static void dvbpsi_epgsched_timer_cancel(dvbpsi_epgsched_t *p_sched,
+                                         dvbpsi_epgsched_timer_t *p_timer)
+{
+    if (p_timer->pp_prev == NULL)
+        return;
+
+    *p_timer->pp_prev = p_timer->p_next;
+    if (p_timer->p_next)
+        p_timer->p_next->pp_prev = p_timer->pp_prev;
+    p_timer->pp_prev = NULL;
+    p_timer->p_next = NULL;
+
+    if (p_timer->i_slot != DVBPSI_EPGSCHED_DUE)
+    {
+        unsigned int i_level = p_timer->i_slot / DVBPSI_EPGSCHED_SLOTS;
+        unsigned int i_slot = p_timer->i_slot % DVBPSI_EPGSCHED_SLOTS;
+        dvbpsi_epgsched_timer_t **pp_slot = p_sched->pp_slots[i_level][i_slot];
+        if (pp_slot[0] == NULL && pp_slot[1] == NULL)
+            p_sched->pi_occupied[i_level] &= ~(UINT64_C(1) << i_slot);
+        p_sched->i_timers--;
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_epgsched_timer_set
+ *****************************************************************************
+ * Moves a timer to a time, if it is not already there.
+ *****************************************************************************/
+static void dvbpsi_epgsched_timer_set(dvbpsi_epgsched_t *p_sched,
+                                      dvbpsi_epgsched_timer_t *p_timer, int64_t i_time)
+{
+    if (p_timer->pp_prev && p_timer->i_time == i_time)
+        return;
+    dvbpsi_epgsched_timer_cancel(p_sched, p_timer);
+    p_timer->i_time = i_time;
+    dvbpsi_epgsched_timer_add(p_sched, p_timer);
+}
+
+/*****************************************************************************
+ * dvbpsi_epgsched_requeue
+ *****************************************************************************
+ * Queues again the timers of a list, which is emptied first so that none
+ * is taken twice.
+ *****************************************************************************/
+static void dvbpsi_epgsched_requeue(dvbpsi_epgsched_t *p_sched,
+                                    dvbpsi_epgsched_timer_t **pp_head)
+{
+    dvbpsi_epgsched_timer_t *p_list = NULL;
+    while (*pp_head)
+    {
+        dvbpsi_epgsched_timer_t *p_timer = *pp_head;
+        dvbpsi_epgsched_timer_cancel(p_sched, p_timer);
+        p_timer->p_next = p_list;
+        p_list = p_timer;
+    }
+    while (p_list)
+    {
+        dvbpsi_epgsched_timer_t *p_timer = p_list;
+        p_list = p_timer->p_next;
+        p_timer->p_next = NULL;
+        dvbpsi_epgsched_timer_add(p_sched, p_timer);
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_epgsched_cascade
+ *****************************************************************************
+ * Spreads the timers of the slot of a level reached by the time over the
+ * lower levels, returning the index of the slot.
+ *****************************************************************************/
+static unsigned int dvbpsi_epgsched_cascade(dvbpsi_epgsched_t *p_sched,
+                                            unsigned int i_level)
+{
+    unsigned int i_slot = (p_sched->i_next >> (DVBPSI_EPGSCHED_BITS * i_level))
+                        & (DVBPSI_EPGSCHED_SLOTS - 1);
+    dvbpsi_epgsched_timer_t **pp_slot = p_sched->pp_slots[i_level][i_slot];
+    dvbpsi_epgsched_requeue(p_sched, &pp_slot[DVBPSI_EPGSCHED_END]);
+    dvbpsi_epgsched_requeue(p_sched, &pp_slot[DVBPSI_EPGSCHED_START]);
+    return i_slot;
+}
+
+/*****************************************************************************
+ * dvbpsi_epgsched_service_find
+ *****************************************************************************
+ * Index of the service of a key, or of where it would be inserted.
+ *****************************************************************************/
+static size_t dvbpsi_epgsched_service_find(const dvbpsi_epgsched_t *p_sched,
+                                           uint64_t i_key)
+{
+    size_t i_low = 0, i_high = p_sched->i_services;
+    while (i_low < i_high)
+    {
+        size_t i_mid = i_low + (i_high - i_low) / 2;
+        if (p_sched->pp_services[i_mid]->i_key < i_key)
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
+}
+
+/*****************************************************************************
+ * dvbpsi_epgsched_service_add
+ *****************************************************************************
+ * Finds the service of a key, creating it if needed.
+ *****************************************************************************/
+static dvbpsi_epgsched_service_t *dvbpsi_epgsched_service_add(dvbpsi_epgsched_t *p_sched,
+                                                              uint64_t i_key)
+{
+    size_t i = dvbpsi_epgsched_service_find(p_sched, i_key);
+    if (i < p_sched->i_services && p_sched->pp_services[i]->i_key == i_key)
+        return p_sched->pp_services[i];
+
+    if (p_sched->i_services == p_sched->i_size)
+    {
+        size_t i_size = p_sched->i_size ? 2 * p_sched->i_size : 16;
+        dvbpsi_epgsched_service_t **pp_services = dvbpsi_malloc(i_size * sizeof(*pp_services));
+        if (pp_services == NULL)
+            return NULL;
+        if (p_sched->i_services)
+            memcpy(pp_services, p_sched->pp_services,
+                   p_sched->i_services * sizeof(*pp_services));
+        dvbpsi_free(p_sched->pp_services);
+        p_sched->pp_services = pp_services;
+        p_sched->i_size = i_size;
+    }
+
+    dvbpsi_epgsched_service_t *p_service = dvbpsi_calloc(1, sizeof(dvbpsi_epgsched_service_t));
+    if (p_service == NULL)
+        return NULL;
+    p_service->i_key = i_key;
+    for (unsigned int j = 0; j < DVBPSI_EPGSCHED_EVENTS; j++)
+    {
+        dvbpsi_epgsched_entry_t *p_entry = &p_service->events[j];
+        p_entry->start.i_kind = DVBPSI_EPGSCHED_START;
+        p_entry->end.i_kind = DVBPSI_EPGSCHED_END;
+        p_entry->start.i_entry = p_entry->end.i_entry = j;
+        p_entry->start.p_service = p_entry->end.p_service = p_service;
+    }
+
+    memmove(p_sched->pp_services + i + 1, p_sched->pp_services + i,
+            (p_sched->i_services - i) * sizeof(*p_sched->pp_services));
+    p_sched->pp_services[i] = p_service;
+    p_sched->i_services++;
+    return p_service;
+}
+
+/*****************************************************************************
+ * dvbpsi_epgsched_service_get
+ *****************************************************************************/
+static dvbpsi_epgsched_service_t *dvbpsi_epgsched_service_get(const dvbpsi_epgsched_t *p_sched,
+                                                              uint64_t i_key)
+{
+    size_t i = dvbpsi_epgsched_service_find(p_sched, i_key);
+    if (i < p_sched->i_services && p_sched->pp_services[i]->i_key == i_key)
+        return p_sched->pp_services[i];
+    return NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_epgsched_key
+ *****************************************************************************/
+static inline uint64_t dvbpsi_epgsched_key(uint16_t i_network_id, uint16_t i_ts_id,
+                                           uint16_t i_service_id)
+{
+    return ((uint64_t)i_network_id << 32) | ((uint32_t)i_ts_id << 16) | i_service_id;
+}
+
+/*****************************************************************************
+ * dvbpsi_epgsched_call
+ *****************************************************************************/
+static void dvbpsi_epgsched_call(dvbpsi_epgsched_t *p_sched,
+                                 const dvbpsi_epgsched_service_t *p_service,
+                                 const dvbpsi_epgsched_entry_t *p_entry,
+                                 dvbpsi_epgsched_kind_t i_kind, bool b_signalled)
+{
+    dvbpsi_epgsched_transition_t transition = {
+        .i_network_id = p_service->i_key >> 32,
+        .i_ts_id = (p_service->i_key >> 16) & 0xffff,
+        .i_service_id = p_service->i_key & 0xffff,
+        .i_event_id = p_entry->i_event_id,
+        .i_kind = i_kind,
+        .b_signalled = b_signalled,
+        .i_time = p_sched->i_next - 1,
+    };
+    p_sched->pf_callback(p_sched->p_cb_data, &transition);
+}
+
+/*****************************************************************************
+ * dvbpsi_epgsched_end
+ *****************************************************************************
+ * Ends an event, calling back only if it started.
+ *****************************************************************************/
+static void dvbpsi_epgsched_end(dvbpsi_epgsched_t *p_sched,
+                                dvbpsi_epgsched_service_t *p_service,
+                                dvbpsi_epgsched_entry_t *p_entry, bool b_signalled)
+{
+    if (p_entry->b_done)
+        return;
+    dvbpsi_epgsched_timer_cancel(p_sched, &p_entry->start);
+    dvbpsi_epgsched_timer_cancel(p_sched, &p_entry->end);
+    p_entry->b_done = true;
+    if (p_entry->b_started)
+        dvbpsi_epgsched_call(p_sched, p_service, p_entry, DVBPSI_EPGSCHED_END,
+                             b_signalled);
+}
+
+/*****************************************************************************
+ * dvbpsi_epgsched_start
+ *****************************************************************************
+ * Starts an event, ending first the other events of its service on.
+ *****************************************************************************/
+static void dvbpsi_epgsched_start(dvbpsi_epgsched_t *p_sched,
+                                  dvbpsi_epgsched_service_t *p_service,
+                                  dvbpsi_epgsched_entry_t *p_entry, bool b_signalled)
+{
+    if (p_entry->b_started || p_entry->b_done)
+        return;
+
+    for (unsigned int i = 0; i < DVBPSI_EPGSCHED_EVENTS; i++)
+    {
+        dvbpsi_epgsched_entry_t *p_other = &p_service->events[i];
+        if (p_other != p_entry && p_other->b_used && p_other->b_started)
+            dvbpsi_epgsched_end(p_sched, p_service, p_other, true);
+    }
+
+    dvbpsi_epgsched_timer_cancel(p_sched, &p_entry->start);
+    p_entry->b_started = true;
+    dvbpsi_epgsched_call(p_sched, p_service, p_entry, DVBPSI_EPGSCHED_START,
+                         b_signalled);
+}
+
+/*****************************************************************************
+ * dvbpsi_epgsched_status
+ *****************************************************************************
+ * Applies a running_status to an event, if it changed.
+ *****************************************************************************/
+static void dvbpsi_epgsched_status(dvbpsi_epgsched_t *p_sched,
+                                   dvbpsi_epgsched_service_t *p_service,
+                                   dvbpsi_epgsched_entry_t *p_entry,
+                                   uint8_t i_running_status)
+{
+    if (p_entry->i_running_status == i_running_status)
+        return;
+    p_entry->i_running_status = i_running_status;
+
+    if (i_running_status == DVBPSI_EPGSCHED_RUNNING)
+        dvbpsi_epgsched_start(p_sched, p_service, p_entry, true);
+    else if (i_running_status == DVBPSI_EPGSCHED_NOT_RUNNING && p_entry->b_started)
+        dvbpsi_epgsched_end(p_sched, p_service, p_entry, true);
+}
+
+/*****************************************************************************
+ * dvbpsi_epgsched_refresh
+ *****************************************************************************
+ * Follows the event of a service on at the scheduler time and the
+ * following ones, keeping the timers of the events already followed.
+ *****************************************************************************/
+static void dvbpsi_epgsched_refresh(dvbpsi_epgsched_t *p_sched,
+                                    dvbpsi_epgsched_service_t *p_service)
+{
+    int64_t i_now = p_sched->i_next - 1;
+    uint16_t i_network_id = p_service->i_key >> 32;
+    uint16_t i_ts_id = (p_service->i_key >> 16) & 0xffff;
+    uint16_t i_service_id = p_service->i_key & 0xffff;
+
+    const dvbpsi_epg_event_t *pp_events[DVBPSI_EPGSCHED_EVENTS];
+    size_t i_events = 0;
+    pp_events[0] = dvbpsi_epg_at(p_sched->p_epg, i_network_id, i_ts_id, i_service_id,
+                                 i_now);
+    if (pp_events[0])
+        i_events++;
+    i_events += dvbpsi_epg_next(p_sched->p_epg, i_network_id, i_ts_id, i_service_id,
+                                i_now, pp_events + i_events,
+                                DVBPSI_EPGSCHED_EVENTS - i_events);
+
+    /* The events no longer followed end */
+    dvbpsi_epgsched_entry_t *pp_entries[DVBPSI_EPGSCHED_EVENTS] = { NULL };
+    for (unsigned int i = 0; i < DVBPSI_EPGSCHED_EVENTS; i++)
+    {
+        dvbpsi_epgsched_entry_t *p_entry = &p_service->events[i];
+        if (!p_entry->b_used)
+            continue;
+
+        size_t j = 0;
+        while (j < i_events && pp_events[j]->i_event_id != p_entry->i_event_id)
+            j++;
+        if (j < i_events && pp_entries[j] == NULL)
+        {
+            pp_entries[j] = p_entry;
+            continue;
+        }
+        dvbpsi_epgsched_end(p_sched, p_service, p_entry, true);
+        p_entry->b_used = false;
+    }
+
+    /* The others are moved to their times, or followed */
+    for (size_t j = 0; j < i_events; j++)
+    {
+        const dvbpsi_epg_event_t *p_event = pp_events[j];
+        dvbpsi_epgsched_entry_t *p_entry = pp_entries[j];
+        if (p_entry == NULL)
+        {
+            for (unsigned int i = 0; p_entry == NULL; i++)
+                if (!p_service->events[i].b_used)
+                    p_entry = &p_service->events[i];
+            p_entry->b_used = true;
+            p_entry->b_started = p_entry->b_done = false;
+            p_entry->i_event_id = p_event->i_event_id;
+            p_entry->i_running_status = 0;
+            pp_entries[j] = p_entry;
+        }
+
+        if (p_entry->b_done)
+            continue;
+        if (!p_entry->b_started)
+            dvbpsi_epgsched_timer_set(p_sched, &p_entry->start, p_event->i_start);
+        dvbpsi_epgsched_timer_set(p_sched, &p_entry->end,
+                                  p_event->i_start + p_event->i_duration);
+    }
+
+    for (size_t j = 0; j < i_events; j++)
+        dvbpsi_epgsched_status(p_sched, p_service, pp_entries[j],
+                               pp_events[j]->i_running_status);
+}
+
+/*****************************************************************************
+ * dvbpsi_epgsched_fire
+ *****************************************************************************
+ * Calls back the timers of a slot or of the due timers, the ends first,
+ * following the next events of a service once one ended.
+ *****************************************************************************/
+static void dvbpsi_epgsched_fire(dvbpsi_epgsched_t *p_sched,
+                                 dvbpsi_epgsched_timer_t **pp_lists)
+{
+    for (;;)
+    {
+        dvbpsi_epgsched_timer_t *p_timer = pp_lists[DVBPSI_EPGSCHED_END];
+        if (p_timer == NULL)
+            p_timer = pp_lists[DVBPSI_EPGSCHED_START];
+        if (p_timer == NULL)
+            break;
+
+        dvbpsi_epgsched_service_t *p_service = p_timer->p_service;
+        dvbpsi_epgsched_entry_t *p_entry = &p_service->events[p_timer->i_entry];
+        dvbpsi_epgsched_timer_cancel(p_sched, p_timer);
+        if (p_timer->i_kind == DVBPSI_EPGSCHED_START)
+            dvbpsi_epgsched_start(p_sched, p_service, p_entry, false);
+        else
+        {
+            dvbpsi_epgsched_end(p_sched, p_service, p_entry, false);
+            dvbpsi_epgsched_refresh(p_sched, p_service);
+        }
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_epgsched_update
+ *****************************************************************************/
+bool dvbpsi_epgsched_update(dvbpsi_epgsched_t *p_sched, uint16_t i_network_id,
+                            uint16_t i_ts_id, uint16_t i_service_id)
+{
+    assert(p_sched);
+
+    dvbpsi_epgsched_service_t *p_service = dvbpsi_epgsched_service_add(p_sched,
+                    dvbpsi_epgsched_key(i_network_id, i_ts_id, i_service_id));
+    if (p_service == NULL)
+        return false;
+
+    dvbpsi_epgsched_refresh(p_sched, p_service);
+    dvbpsi_epgsched_fire(p_sched, p_sched->p_due);
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_epgsched_rst
+ *****************************************************************************/
+void dvbpsi_epgsched_rst(dvbpsi_epgsched_t *p_sched, dvbpsi_rst_t *p_rst)
+{
+    assert(p_sched);
+    assert(p_rst);
+
+    /* Into the store first, for the next refreshes not to undo it */
+    if (dvbpsi_epg_rst(p_sched->p_epg, p_rst) == 0)
+        return;
+
+    for (dvbpsi_rst_event_t *p = p_rst->p_first_event; p; p = p->p_next)
+    {
+        dvbpsi_epgsched_service_t *p_service = dvbpsi_epgsched_service_get(p_sched,
+                    dvbpsi_epgsched_key(p->i_orig_network_id, p->i_ts_id, p->i_service_id));
+        if (p_service == NULL)
+            continue;
+
+        for (unsigned int i = 0; i < DVBPSI_EPGSCHED_EVENTS; i++)
+        {
+            dvbpsi_epgsched_entry_t *p_entry = &p_service->events[i];
+            if (p_entry->b_used && p_entry->i_event_id == p->i_event_id)
+                dvbpsi_epgsched_status(p_sched, p_service, p_entry, p->i_running_status);
+        }
+    }
+    dvbpsi_epgsched_fire(p_sched, p_sched->p_due);
+}
+
+/*****************************************************************************
+ * dvbpsi_epgsched_advance
+ *****************************************************************************/
+void dvbpsi_epgsched_advance(dvbpsi_epgsched_t *p_sched, int64_t i_time)
+{
+    assert(p_sched);
+
+    if (i_time < p_sched->i_next - 1)
+    {
+        /* Back in time: every timer is later, only its slot changes */
+        dvbpsi_epgsched_timer_t *p_list = NULL;
+        for (unsigned int i_level = 0; i_level < DVBPSI_EPGSCHED_LEVELS; i_level++)
+            for (unsigned int i_slot = 0; i_slot < DVBPSI_EPGSCHED_SLOTS; i_slot++)
+                for (unsigned int i_kind = 0; i_kind < 2; i_kind++)
+                {
+                    dvbpsi_epgsched_timer_t **pp_head = &p_sched->pp_slots[i_level][i_slot][i_kind];
+                    while (*pp_head)
+                    {
+                        dvbpsi_epgsched_timer_t *p_timer = *pp_head;
+                        dvbpsi_epgsched_timer_cancel(p_sched, p_timer);
+                        p_timer->p_next = p_list;
+                        p_list = p_timer;
+                    }
+                }
+
+        p_sched->i_next = i_time + 1;
+        while (p_list)
+        {
+            dvbpsi_epgsched_timer_t *p_timer = p_list;
+            p_list = p_timer->p_next;
+            p_timer->p_next = NULL;
+            dvbpsi_epgsched_timer_add(p_sched, p_timer);
+        }
+        return;
+    }
+
+    while (p_sched->i_next <= i_time)
+    {
+        if (p_sched->i_timers == 0)
+        {
+            p_sched->i_next = i_time + 1;
+            break;
+        }
+
+        /* Skip the empty slots of the first level up to the end of its
+           round, the first second of a round being always taken for the
+           slots of the upper levels to be spread */
+        unsigned int i_slot = p_sched->i_next & (DVBPSI_EPGSCHED_SLOTS - 1);
+        if (i_slot != 0)
+        {
+            uint64_t i_occupied = p_sched->pi_occupied[0] >> i_slot;
+            int64_t i_second;
+            if (i_occupied == 0)
+                i_second = (p_sched->i_next | (DVBPSI_EPGSCHED_SLOTS - 1)) + 1;
+            else
+            {
+                while (!(i_occupied & 1))
+                {
+                    i_occupied >>= 1;
+                    i_slot++;
+                }
+                i_second = (p_sched->i_next & ~(int64_t)(DVBPSI_EPGSCHED_SLOTS - 1))
+                         + i_slot;
+            }
+            if (i_second > i_time)
+            {
+                p_sched->i_next = i_time + 1;
+                break;
+            }
+            p_sched->i_next = i_second;
+            i_slot = i_second & (DVBPSI_EPGSCHED_SLOTS - 1);
+        }
+
+        for (unsigned int i_level = 1;
+             i_slot == 0 && i_level < DVBPSI_EPGSCHED_LEVELS; i_level++)
+            i_slot = dvbpsi_epgsched_cascade(p_sched, i_level);
+
+        /* The second is the scheduler time while it is fired, the timers
+           added for it being due */
+        dvbpsi_epgsched_timer_t **pp_slot
+                = p_sched->pp_slots[0][p_sched->i_next & (DVBPSI_EPGSCHED_SLOTS - 1)];
+        p_sched->i_next++;
+        while (   pp_slot[0] || pp_slot[1]
+               || p_sched->p_due[0] || p_sched->p_due[1])
+        {
+            dvbpsi_epgsched_fire(p_sched, pp_slot);
+            dvbpsi_epgsched_fire(p_sched, p_sched->p_due);
+        }
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_epgsched_tot
+ *****************************************************************************/
+void dvbpsi_epgsched_tot(dvbpsi_epgsched_t *p_sched, dvbpsi_tot_t *p_tot)
+{
+    assert(p_sched);
+    assert(p_tot);
+
+    int64_t i_time = dvbpsi_epg_time(p_tot->i_utc_time);
+    if (i_time != INT64_MIN)
+        dvbpsi_epgsched_advance(p_sched, i_time);
+}
+
+/*****************************************************************************
+ * dvbpsi_epgsched_clock
+ *****************************************************************************/
+void dvbpsi_epgsched_clock(dvbpsi_epgsched_t *p_sched)
+{
+    assert(p_sched);
+
+    dvbpsi_epgsched_advance(p_sched, (int64_t)time(NULL));
+}
@@ -0,0 +1,230 @@
+/*****************************************************************************
+ * epgsched.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <epgsched.h>
+ * \brief Now/next transitions of the services of an EPG store.
+ *
+ * A scheduler follows the services of an EPG store, see epg.h, and calls
+ * back when an event of one of them starts or ends. For each service it
+ * keeps the event on and the following one, their start and end times
+ * being timers of a hierarchical wheel of one second ticks, added and
+ * cancelled in constant time, so that rescheduling a service on each of
+ * its EIT present/following tables costs the same for thousands of
+ * services as for one.
+ *
+ * The scheduler is driven by the time given to dvbpsi_epgsched_advance(),
+ * read from the TDT/TOT with dvbpsi_epgsched_tot() or from the system
+ * clock with dvbpsi_epgsched_clock(). The running status of the events,
+ * from the EIT present/following or from a RST, overrides their times: an
+ * event starts as soon as it is signalled running, and a started event
+ * ends as soon as it is signalled not running, or when another event of
+ * its service starts.
+ *
+ * The callbacks are made from inside the calls of the scheduler, which
+ * must not be called back from them; the store is only changed by
+ * dvbpsi_epgsched_rst() and may be queried from them.
+ */
+
+#ifndef _DVBPSI_EPGSCHED_H_
+#define _DVBPSI_EPGSCHED_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_epgsched_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_epgsched_s dvbpsi_epgsched_t
+ * \brief dvbpsi_epgsched_t type definition, an opaque scheduler.
+ */
+typedef struct dvbpsi_epgsched_s dvbpsi_epgsched_t;
+
+/*****************************************************************************
+ * dvbpsi_epgsched_transition_t
+ *****************************************************************************/
+/*!
+ * \enum dvbpsi_epgsched_kind
+ * \brief Kinds of transitions of an event
+ */
+enum dvbpsi_epgsched_kind
+{
+    DVBPSI_EPGSCHED_START = 0,  /*!< the event starts */
+    DVBPSI_EPGSCHED_END,        /*!< the event ends */
+};
+/*!
+ * \typedef enum dvbpsi_epgsched_kind dvbpsi_epgsched_kind_t
+ * \brief dvbpsi_epgsched_kind_t type definition.
+ */
+typedef enum dvbpsi_epgsched_kind dvbpsi_epgsched_kind_t;
+
+/*!
+ * \struct dvbpsi_epgsched_transition_s
+ * \brief Transition of an event given to the callback of a scheduler.
+ */
+/*!
+ * \typedef struct dvbpsi_epgsched_transition_s dvbpsi_epgsched_transition_t
+ * \brief dvbpsi_epgsched_transition_t type definition.
+ */
+typedef struct dvbpsi_epgsched_transition_s
+{
+    uint16_t                i_network_id;   /*!< original_network_id */
+    uint16_t                i_ts_id;        /*!< transport_stream_id */
+    uint16_t                i_service_id;   /*!< service_id */
+    uint16_t                i_event_id;     /*!< event_id */
+    uint8_t                 i_kind;         /*!< dvbpsi_epgsched_kind_t */
+    bool                    b_signalled;    /*!< made by the running status
+                                                 or the start of another
+                                                 event, not by the time of
+                                                 the event */
+    int64_t                 i_time;         /*!< scheduler time, in seconds
+                                                 since 1970-01-01 UTC */
+} dvbpsi_epgsched_transition_t;
+
+/*!
+ * \typedef void (* dvbpsi_epgsched_callback)(void *p_cb_data,
+                  const dvbpsi_epgsched_transition_t *p_transition)
+ * \brief Callback type definition.
+ */
+typedef void (* dvbpsi_epgsched_callback)(void *p_cb_data,
+                                          const dvbpsi_epgsched_transition_t *p_transition);
+
+/*****************************************************************************
+ * dvbpsi_epgsched_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_epgsched_t *dvbpsi_epgsched_new(dvbpsi_epg_t *p_epg,
+ *                            int64_t i_time, dvbpsi_epgsched_callback pf_callback,
+ *                            void *p_cb_data)
+ * \brief Creates a scheduler following no service yet
+ * \param p_epg store the events are read from, which must outlive the
+ *        scheduler
+ * \param i_time scheduler time, in seconds since 1970-01-01 UTC
+ * \param pf_callback function called on each transition
+ * \param p_cb_data data given to pf_callback
+ * \return the new scheduler, NULL on error.
+ */
+dvbpsi_epgsched_t *dvbpsi_epgsched_new(dvbpsi_epg_t *p_epg, int64_t i_time,
+                                       dvbpsi_epgsched_callback pf_callback,
+                                       void *p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_epgsched_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_epgsched_delete(dvbpsi_epgsched_t *p_sched)
+ * \brief Deletes a scheduler, calling back nothing
+ * \param p_sched scheduler, or NULL
+ * \return nothing.
+ */
+void dvbpsi_epgsched_delete(dvbpsi_epgsched_t *p_sched);
+
+/*****************************************************************************
+ * dvbpsi_epgsched_update
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_epgsched_update(dvbpsi_epgsched_t *p_sched,
+ *                                 uint16_t i_network_id, uint16_t i_ts_id,
+ *                                 uint16_t i_service_id)
+ * \brief Reschedules a service from the events of the store
+ * \param p_sched scheduler
+ * \param i_network_id original_network_id of the service
+ * \param i_ts_id transport_stream_id of the service
+ * \param i_service_id service_id of the service
+ * \return false on error, true otherwise.
+ *
+ * To be called after each dvbpsi_epg_update() of the service, typically
+ * for its EIT present/following, the service being followed from its
+ * first update on. Only the timers of the events whose times changed are
+ * moved; the events no longer on or following end, the event on starts
+ * if it did not yet, and the running status of the events in the store is
+ * applied as by dvbpsi_epgsched_rst().
+ */
+bool dvbpsi_epgsched_update(dvbpsi_epgsched_t *p_sched, uint16_t i_network_id,
+                            uint16_t i_ts_id, uint16_t i_service_id);
+
+/*****************************************************************************
+ * dvbpsi_epgsched_rst
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_epgsched_rst(dvbpsi_epgsched_t *p_sched, dvbpsi_rst_t *p_rst)
+ * \brief Applies the running status of a RST to the store and the events
+ * followed
+ * \param p_sched scheduler
+ * \param p_rst RST, unchanged
+ * \return nothing.
+ *
+ * The running status is set on the events of the store with
+ * dvbpsi_epg_rst(). An event on or following a service being followed
+ * then starts when it is signalled running, and ends when it started and
+ * is signalled not running.
+ */
+void dvbpsi_epgsched_rst(dvbpsi_epgsched_t *p_sched, dvbpsi_rst_t *p_rst);
+
+/*****************************************************************************
+ * dvbpsi_epgsched_advance
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_epgsched_advance(dvbpsi_epgsched_t *p_sched, int64_t i_time)
+ * \brief Moves the time of a scheduler, calling back the transitions due
+ * \param p_sched scheduler
+ * \param i_time new scheduler time, in seconds since 1970-01-01 UTC
+ * \return nothing.
+ *
+ * The transitions are called back in the order of their times, an end
+ * before a start of the same second. A time going backwards only moves
+ * the timers, an event that started not starting again.
+ */
+void dvbpsi_epgsched_advance(dvbpsi_epgsched_t *p_sched, int64_t i_time);
+
+/*****************************************************************************
+ * dvbpsi_epgsched_tot
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_epgsched_tot(dvbpsi_epgsched_t *p_sched, dvbpsi_tot_t *p_tot)
+ * \brief Moves the time of a scheduler to the UTC_time of a TDT or TOT
+ * \param p_sched scheduler
+ * \param p_tot TDT or TOT, unchanged
+ * \return nothing.
+ */
+void dvbpsi_epgsched_tot(dvbpsi_epgsched_t *p_sched, dvbpsi_tot_t *p_tot);
+
+/*****************************************************************************
+ * dvbpsi_epgsched_clock
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_epgsched_clock(dvbpsi_epgsched_t *p_sched)
+ * \brief Moves the time of a scheduler to the system clock
+ * \param p_sched scheduler
+ * \return nothing.
+ */
+void dvbpsi_epgsched_clock(dvbpsi_epgsched_t *p_sched);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of epgsched.h"
+#endif
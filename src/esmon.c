@@ -0,0 +1,322 @@
+/*****************************************************************************
+ * esmon.c: elementary stream presence and scrambling monitor
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "descriptor.h"
+#include "tables/pat.h"
+#include "tables/pmt.h"
+#include "tables/sdt.h"
+#include "tables/nit.h"
+#include "tables/bat.h"
+#include "scan.h"
+#include "sidb.h"
+#include "esmon.h"
+
+#define DVBPSI_ESMON_PIDS       8192
+
+/* pi_state bits */
+#define DVBPSI_ESMON_MONITORED  0x01
+#define DVBPSI_ESMON_LATE       0x02    /* DVBPSI_ESMON_MISSING reported */
+#define DVBPSI_ESMON_STALE      0x04    /* left out of the PMT being read */
+#define DVBPSI_ESMON_FREE_CA    0x08    /* free_CA_mode of the service */
+
+/*****************************************************************************
+ * dvbpsi_esmon_s
+ *****************************************************************************
+ * The state of each PID is kept in one array per field and the monitored
+ * PIDs in a list, pi_slot giving the position of a PID in it.
+ *****************************************************************************/
+struct dvbpsi_esmon_s
+{
+    dvbpsi_sidb_t *         p_sidb;
+    int64_t                 i_timeout;
+    dvbpsi_esmon_callback   pf_callback;
+    void *                  p_cb_data;
+
+    uint8_t                 pi_state[DVBPSI_ESMON_PIDS];
+    uint8_t                 pi_scrambling[DVBPSI_ESMON_PIDS];
+    uint8_t                 pi_stream_type[DVBPSI_ESMON_PIDS];
+    uint16_t                pi_ts_id[DVBPSI_ESMON_PIDS];
+    uint16_t                pi_service_id[DVBPSI_ESMON_PIDS];
+    int64_t                 pi_last[DVBPSI_ESMON_PIDS];  /* DVBPSI_TIME_NONE
+                                                            until armed */
+    int64_t                 pi_max_gap[DVBPSI_ESMON_PIDS];
+    uint64_t                pi_packets[DVBPSI_ESMON_PIDS];
+
+    uint16_t                pi_monitored[DVBPSI_ESMON_PIDS];
+    uint16_t                pi_slot[DVBPSI_ESMON_PIDS];
+    unsigned int            i_monitored;
+};
+
+/*****************************************************************************
+ * dvbpsi_esmon_new
+ *****************************************************************************/
+dvbpsi_esmon_t *dvbpsi_esmon_new(dvbpsi_sidb_t *p_sidb, int64_t i_timeout,
+                                 dvbpsi_esmon_callback pf_callback,
+                                 void *p_cb_data)
+{
+    assert(p_sidb);
+
+    dvbpsi_esmon_t *p_mon = dvbpsi_calloc(1, sizeof(dvbpsi_esmon_t));
+    if (p_mon == NULL)
+        return NULL;
+
+    p_mon->p_sidb = p_sidb;
+    p_mon->i_timeout = i_timeout;
+    p_mon->pf_callback = pf_callback;
+    p_mon->p_cb_data = p_cb_data;
+    return p_mon;
+}
+
+/*****************************************************************************
+ * dvbpsi_esmon_delete
+ *****************************************************************************/
+void dvbpsi_esmon_delete(dvbpsi_esmon_t *p_mon)
+{
+    dvbpsi_free(p_mon);
+}
+
+/*****************************************************************************
+ * dvbpsi_esmon_notify
+ *****************************************************************************/
+static void dvbpsi_esmon_notify(dvbpsi_esmon_t *p_mon, dvbpsi_esmon_event_type_t i_type,
+                                uint16_t i_pid, int64_t i_time, int64_t i_gap)
+{
+    if (p_mon->pf_callback == NULL)
+        return;
+
+    dvbpsi_esmon_event_t event;
+    event.i_type = i_type;
+    event.i_ts_id = p_mon->pi_ts_id[i_pid];
+    event.i_service_id = p_mon->pi_service_id[i_pid];
+    event.i_pid = i_pid;
+    event.i_stream_type = p_mon->pi_stream_type[i_pid];
+    event.i_scrambling = p_mon->pi_scrambling[i_pid];
+    event.b_free_ca = (p_mon->pi_state[i_pid] & DVBPSI_ESMON_FREE_CA) != 0;
+    event.i_time = i_time;
+    event.i_gap = i_gap;
+    p_mon->pf_callback(p_mon->p_cb_data, &event);
+}
+
+/*****************************************************************************
+ * dvbpsi_esmon_add, dvbpsi_esmon_remove
+ *****************************************************************************/
+static void dvbpsi_esmon_add(dvbpsi_esmon_t *p_mon, uint16_t i_pid,
+                             uint16_t i_ts_id, uint16_t i_service_id)
+{
+    p_mon->pi_state[i_pid] = DVBPSI_ESMON_MONITORED;
+    p_mon->pi_scrambling[i_pid] = 0;
+    p_mon->pi_ts_id[i_pid] = i_ts_id;
+    p_mon->pi_service_id[i_pid] = i_service_id;
+    p_mon->pi_last[i_pid] = DVBPSI_TIME_NONE;
+    p_mon->pi_max_gap[i_pid] = 0;
+    p_mon->pi_packets[i_pid] = 0;
+
+    p_mon->pi_slot[i_pid] = p_mon->i_monitored;
+    p_mon->pi_monitored[p_mon->i_monitored++] = i_pid;
+}
+
+static void dvbpsi_esmon_remove(dvbpsi_esmon_t *p_mon, uint16_t i_pid)
+{
+    uint16_t i_slot = p_mon->pi_slot[i_pid];
+    uint16_t i_moved = p_mon->pi_monitored[--p_mon->i_monitored];
+
+    p_mon->pi_monitored[i_slot] = i_moved;
+    p_mon->pi_slot[i_moved] = i_slot;
+    p_mon->pi_state[i_pid] = 0;
+}
+
+/*****************************************************************************
+ * dvbpsi_esmon_service
+ *****************************************************************************/
+bool dvbpsi_esmon_service(dvbpsi_esmon_t *p_mon, uint16_t i_ts_id,
+                          uint16_t i_service_id)
+{
+    assert(p_mon);
+
+    const dvbpsi_sidb_service_t *p_service =
+            dvbpsi_sidb_find(p_mon->p_sidb, i_ts_id, i_service_id);
+    const dvbpsi_pmt_t *p_pmt = p_service ? p_service->p_pmt : NULL;
+    uint8_t i_free_ca = (p_service && p_service->p_sdt && p_service->p_sdt->b_free_ca)
+                        ? DVBPSI_ESMON_FREE_CA : 0;
+
+    for (unsigned int i = 0; i < p_mon->i_monitored; i++)
+    {
+        uint16_t i_pid = p_mon->pi_monitored[i];
+        if (p_mon->pi_ts_id[i_pid] == i_ts_id
+         && p_mon->pi_service_id[i_pid] == i_service_id)
+            p_mon->pi_state[i_pid] |= DVBPSI_ESMON_STALE;
+    }
+
+    for (const dvbpsi_pmt_es_t *p_es = p_pmt ? p_pmt->p_first_es : NULL;
+         p_es != NULL; p_es = p_es->p_next)
+    {
+        uint16_t i_pid = p_es->i_pid & 0x1fff;
+        if (!(p_mon->pi_state[i_pid] & DVBPSI_ESMON_MONITORED))
+            dvbpsi_esmon_add(p_mon, i_pid, i_ts_id, i_service_id);
+        else if (p_mon->pi_ts_id[i_pid] != i_ts_id
+              || p_mon->pi_service_id[i_pid] != i_service_id)
+            continue; /* monitored for another service */
+
+        p_mon->pi_state[i_pid] &= ~(DVBPSI_ESMON_STALE | DVBPSI_ESMON_FREE_CA);
+        p_mon->pi_state[i_pid] |= i_free_ca;
+        p_mon->pi_stream_type[i_pid] = p_es->i_type;
+    }
+
+    for (unsigned int i = 0; i < p_mon->i_monitored; )
+    {
+        uint16_t i_pid = p_mon->pi_monitored[i];
+        if (p_mon->pi_state[i_pid] & DVBPSI_ESMON_STALE)
+            dvbpsi_esmon_remove(p_mon, i_pid); /* slot i now holds another PID */
+        else
+            i++;
+    }
+
+    return p_pmt != NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_esmon_account
+ *****************************************************************************/
+static inline void dvbpsi_esmon_account(dvbpsi_esmon_t *p_mon, uint16_t i_pid,
+                                        uint8_t i_scrambling, int64_t i_time)
+{
+    uint8_t i_state = p_mon->pi_state[i_pid];
+    if (!(i_state & DVBPSI_ESMON_MONITORED))
+        return;
+
+    int64_t i_last = p_mon->pi_last[i_pid];
+    int64_t i_gap = (i_last != DVBPSI_TIME_NONE) ? i_time - i_last : 0;
+    if (p_mon->pi_packets[i_pid] > 0 && i_gap > p_mon->pi_max_gap[i_pid])
+        p_mon->pi_max_gap[i_pid] = i_gap;
+    p_mon->pi_last[i_pid] = i_time;
+
+    if (i_state & DVBPSI_ESMON_LATE)
+    {
+        p_mon->pi_state[i_pid] = i_state & ~DVBPSI_ESMON_LATE;
+        dvbpsi_esmon_notify(p_mon, DVBPSI_ESMON_BACK, i_pid, i_time, i_gap);
+    }
+
+    /* Only report the changes between clear and scrambled, not those of
+     * the key */
+    bool b_was = (p_mon->pi_scrambling[i_pid] != 0);
+    p_mon->pi_scrambling[i_pid] = i_scrambling;
+    if (p_mon->pi_packets[i_pid]++ == 0)
+        b_was = false;
+    if ((i_scrambling != 0) != b_was)
+        dvbpsi_esmon_notify(p_mon, b_was ? DVBPSI_ESMON_CLEAR : DVBPSI_ESMON_SCRAMBLED,
+                            i_pid, i_time, 0);
+}
+
+/*****************************************************************************
+ * dvbpsi_esmon_packet
+ *****************************************************************************/
+void dvbpsi_esmon_packet(dvbpsi_esmon_t *p_mon, const uint8_t *p_packet,
+                         int64_t i_time)
+{
+    assert(p_mon);
+    if (p_packet[0] != 0x47)
+        return;
+
+    uint16_t i_pid = ((uint16_t)(p_packet[1] & 0x1f) << 8) | p_packet[2];
+    dvbpsi_esmon_account(p_mon, i_pid, p_packet[3] >> 6, i_time);
+}
+
+/*****************************************************************************
+ * dvbpsi_esmon_headers
+ *****************************************************************************/
+void dvbpsi_esmon_headers(dvbpsi_esmon_t *p_mon, const dvbpsi_ts_headers_t *p_headers,
+                          int64_t i_time)
+{
+    assert(p_mon);
+    for (unsigned int i = 0; i < p_headers->i_count; i++)
+        dvbpsi_esmon_account(p_mon, p_headers->pi_pid[i],
+                             DVBPSI_TS_SCRAMBLING(p_headers->pi_flags[i]), i_time);
+}
+
+/*****************************************************************************
+ * dvbpsi_esmon_check
+ *****************************************************************************/
+void dvbpsi_esmon_check(dvbpsi_esmon_t *p_mon, int64_t i_time)
+{
+    assert(p_mon);
+    for (unsigned int i = 0; i < p_mon->i_monitored; i++)
+    {
+        uint16_t i_pid = p_mon->pi_monitored[i];
+        if (p_mon->pi_last[i_pid] == DVBPSI_TIME_NONE)
+        {
+            p_mon->pi_last[i_pid] = i_time;
+            continue;
+        }
+        if (p_mon->pi_state[i_pid] & DVBPSI_ESMON_LATE)
+            continue;
+
+        int64_t i_gap = i_time - p_mon->pi_last[i_pid];
+        if (i_gap > p_mon->i_timeout)
+        {
+            p_mon->pi_state[i_pid] |= DVBPSI_ESMON_LATE;
+            dvbpsi_esmon_notify(p_mon, DVBPSI_ESMON_MISSING, i_pid, i_time, i_gap);
+        }
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_esmon_get_es
+ *****************************************************************************/
+bool dvbpsi_esmon_get_es(const dvbpsi_esmon_t *p_mon, uint16_t i_pid,
+                         dvbpsi_esmon_es_t *p_es)
+{
+    assert(p_mon);
+    assert(i_pid < DVBPSI_ESMON_PIDS);
+
+    uint8_t i_state = p_mon->pi_state[i_pid];
+    if (!(i_state & DVBPSI_ESMON_MONITORED))
+        return false;
+
+    p_es->i_ts_id = p_mon->pi_ts_id[i_pid];
+    p_es->i_service_id = p_mon->pi_service_id[i_pid];
+    p_es->i_stream_type = p_mon->pi_stream_type[i_pid];
+    p_es->i_scrambling = p_mon->pi_scrambling[i_pid];
+    p_es->b_missing = (i_state & DVBPSI_ESMON_LATE) != 0;
+    p_es->i_packets = p_mon->pi_packets[i_pid];
+    p_es->i_last = p_es->i_packets ? p_mon->pi_last[i_pid] : DVBPSI_TIME_NONE;
+    p_es->i_max_gap = p_mon->pi_max_gap[i_pid];
+    return true;
+}
@@ -0,0 +1,264 @@
+/*****************************************************************************
+ * esmon.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <esmon.h>
+ * \brief Elementary stream presence and scrambling monitor.
+ *
+ * Follows the elementary streams of the services of a service information
+ * database from the TS packet headers alone: the time since the last packet
+ * of each one, and whether its packets are scrambled. The elementary
+ * streams of a service are those of its PMT in the database. The state of
+ * each PID is kept in one array per field, so that a packet is accounted in
+ * constant time.
+ */
+
+#ifndef _DVBPSI_ESMON_H_
+#define _DVBPSI_ESMON_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_esmon_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_esmon_s dvbpsi_esmon_t
+ * \brief dvbpsi_esmon_t type definition, an opaque monitor.
+ */
+typedef struct dvbpsi_esmon_s dvbpsi_esmon_t;
+
+/*****************************************************************************
+ * dvbpsi_esmon_event_type_t
+ *****************************************************************************/
+/*!
+ * \enum dvbpsi_esmon_event_type
+ * \brief Changes reported by a monitor
+ */
+enum dvbpsi_esmon_event_type
+{
+    DVBPSI_ESMON_MISSING = 0,   /*!< no packet for longer than the timeout,
+                                     see dvbpsi_esmon_check() */
+    DVBPSI_ESMON_BACK,          /*!< first packet after DVBPSI_ESMON_MISSING */
+    DVBPSI_ESMON_SCRAMBLED,     /*!< packet scrambled after clear ones, or
+                                     first packet scrambled */
+    DVBPSI_ESMON_CLEAR,         /*!< packet clear after scrambled ones */
+};
+/*!
+ * \typedef enum dvbpsi_esmon_event_type dvbpsi_esmon_event_type_t
+ * \brief dvbpsi_esmon_event_type_t type definition.
+ */
+typedef enum dvbpsi_esmon_event_type dvbpsi_esmon_event_type_t;
+
+/*****************************************************************************
+ * dvbpsi_esmon_event_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_esmon_event_s
+ * \brief Change of an elementary stream, only valid during the callback.
+ */
+/*!
+ * \typedef struct dvbpsi_esmon_event_s dvbpsi_esmon_event_t
+ * \brief dvbpsi_esmon_event_t type definition.
+ */
+typedef struct dvbpsi_esmon_event_s
+{
+    dvbpsi_esmon_event_type_t i_type;       /*!< change */
+    uint16_t                  i_ts_id;      /*!< transport_stream_id of the
+                                                 service */
+    uint16_t                  i_service_id; /*!< service_id */
+    uint16_t                  i_pid;        /*!< elementary_PID */
+    uint8_t                   i_stream_type;/*!< stream_type in the PMT */
+    uint8_t                   i_scrambling; /*!< transport_scrambling_control
+                                                 of the last packet */
+    bool                      b_free_ca;    /*!< free_CA_mode of the service
+                                                 in the SDT, false without
+                                                 one: a scrambled service */
+    int64_t                   i_time;       /*!< time of the change */
+    int64_t                   i_gap;        /*!< time since the last packet,
+                                                 or since the stream was
+                                                 monitored, for
+                                                 DVBPSI_ESMON_MISSING and
+                                                 DVBPSI_ESMON_BACK */
+} dvbpsi_esmon_event_t;
+
+/*****************************************************************************
+ * dvbpsi_esmon_callback
+ *****************************************************************************/
+/*!
+ * \typedef void (* dvbpsi_esmon_callback)(void *p_cb_data,
+ *                                        const dvbpsi_esmon_event_t *p_event)
+ * \brief Callback type definition, called for each change.
+ */
+typedef void (* dvbpsi_esmon_callback)(void *p_cb_data,
+                                       const dvbpsi_esmon_event_t *p_event);
+
+/*****************************************************************************
+ * dvbpsi_esmon_es_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_esmon_es_s
+ * \brief State of an elementary stream, see dvbpsi_esmon_get_es()
+ */
+/*!
+ * \typedef struct dvbpsi_esmon_es_s dvbpsi_esmon_es_t
+ * \brief dvbpsi_esmon_es_t type definition.
+ */
+typedef struct dvbpsi_esmon_es_s
+{
+    uint16_t i_ts_id;           /*!< transport_stream_id of the service */
+    uint16_t i_service_id;      /*!< service_id */
+    uint8_t  i_stream_type;     /*!< stream_type in the PMT */
+    uint8_t  i_scrambling;      /*!< transport_scrambling_control of the
+                                     last packet */
+    bool     b_missing;         /*!< reported DVBPSI_ESMON_MISSING and no
+                                     packet since */
+    uint64_t i_packets;         /*!< packets since the stream is monitored */
+    int64_t  i_last;            /*!< time of the last packet, or
+                                     DVBPSI_TIME_NONE */
+    int64_t  i_max_gap;         /*!< longest time between two packets */
+} dvbpsi_esmon_es_t;
+
+/*****************************************************************************
+ * dvbpsi_esmon_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_esmon_t *dvbpsi_esmon_new(dvbpsi_sidb_t *p_sidb, int64_t i_timeout,
+ *                                      dvbpsi_esmon_callback pf_callback,
+ *                                      void *p_cb_data)
+ * \brief Creates a monitor of the services of a database
+ * \param p_sidb database giving the PMTs and SDTs of the services, which
+ *        must outlive the monitor
+ * \param i_timeout time without packets after which an elementary stream
+ *        is missing, in the unit of the times given to the monitor
+ * \param pf_callback function called for each change, or NULL
+ * \param p_cb_data private data given in argument to the callback
+ * \return pointer to the monitor, or NULL on error
+ */
+dvbpsi_esmon_t *dvbpsi_esmon_new(dvbpsi_sidb_t *p_sidb, int64_t i_timeout,
+                                 dvbpsi_esmon_callback pf_callback,
+                                 void *p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_esmon_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_esmon_delete(dvbpsi_esmon_t *p_mon)
+ * \brief Deletes a monitor
+ * \param p_mon pointer to the monitor
+ * \return nothing
+ */
+void dvbpsi_esmon_delete(dvbpsi_esmon_t *p_mon);
+
+/*****************************************************************************
+ * dvbpsi_esmon_service
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_esmon_service(dvbpsi_esmon_t *p_mon, uint16_t i_ts_id,
+ *                               uint16_t i_service_id)
+ * \brief Monitors the elementary streams of a service as the database has it
+ * \param p_mon pointer to the monitor
+ * \param i_ts_id transport_stream_id
+ * \param i_service_id service_id
+ * \return false if the database has no PMT for the service, whose streams
+ *         are then no longer monitored, true otherwise.
+ *
+ * Call it after each update of the PMT or SDT of the service in the
+ * database. Streams the service keeps keep their state, the others are no
+ * longer monitored. A PID listed by several services is monitored for the
+ * first one.
+ */
+bool dvbpsi_esmon_service(dvbpsi_esmon_t *p_mon, uint16_t i_ts_id,
+                          uint16_t i_service_id);
+
+/*****************************************************************************
+ * dvbpsi_esmon_packet
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_esmon_packet(dvbpsi_esmon_t *p_mon, const uint8_t *p_packet,
+ *                              int64_t i_time)
+ * \brief Accounts a TS packet
+ * \param p_mon pointer to the monitor
+ * \param p_packet TS packet, starting with its sync byte
+ * \param i_time arrival time of the packet, in any monotonic unit
+ * \return nothing
+ */
+void dvbpsi_esmon_packet(dvbpsi_esmon_t *p_mon, const uint8_t *p_packet,
+                         int64_t i_time);
+
+/*****************************************************************************
+ * dvbpsi_esmon_headers
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_esmon_headers(dvbpsi_esmon_t *p_mon,
+ *                               const dvbpsi_ts_headers_t *p_headers,
+ *                               int64_t i_time)
+ * \brief Accounts a block of TS packets
+ * \param p_mon pointer to the monitor
+ * \param p_headers headers extracted by dvbpsi_packets_scan()
+ * \param i_time arrival time of the block
+ * \return nothing
+ */
+void dvbpsi_esmon_headers(dvbpsi_esmon_t *p_mon, const dvbpsi_ts_headers_t *p_headers,
+                          int64_t i_time);
+
+/*****************************************************************************
+ * dvbpsi_esmon_check
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_esmon_check(dvbpsi_esmon_t *p_mon, int64_t i_time)
+ * \brief Looks for the elementary streams missing at a time
+ * \param p_mon pointer to the monitor
+ * \param i_time current time
+ * \return nothing
+ *
+ * Reports DVBPSI_ESMON_MISSING once for each stream without a packet for
+ * longer than the timeout. A stream without any packet yet is timed from
+ * the first check after it is monitored. The cost is linear in the number
+ * of monitored streams, call it periodically, for instance every fraction
+ * of the timeout.
+ */
+void dvbpsi_esmon_check(dvbpsi_esmon_t *p_mon, int64_t i_time);
+
+/*****************************************************************************
+ * dvbpsi_esmon_get_es
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_esmon_get_es(const dvbpsi_esmon_t *p_mon, uint16_t i_pid,
+ *                              dvbpsi_esmon_es_t *p_es)
+ * \brief Gets the state of an elementary stream
+ * \param p_mon pointer to the monitor
+ * \param i_pid PID, 0 to 0x1fff
+ * \param p_es filled with the state
+ * \return false if the PID is not monitored.
+ */
+bool dvbpsi_esmon_get_es(const dvbpsi_esmon_t *p_mon, uint16_t i_pid,
+                         dvbpsi_esmon_es_t *p_es);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of esmon.h"
+#endif
@@ -0,0 +1,622 @@
+/*****************************************************************************
+ * esprofile.c: profiles of the elementary streams of PMTs
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "descriptor.h"
+#include "tables/pmt.h"
+#include "esprofile.h"
+
+/* A PMT has a single section, a few more are kept by the cache */
+#define ESPROFILE_SECTIONS 4
+
+/*****************************************************************************
+ * dvbpsi_esprofile_entry_t
+ *****************************************************************************
+ * Profiles of a PMT, identified by the CRC_32 and length of its sections.
+ *****************************************************************************/
+typedef struct dvbpsi_esprofile_entry_s
+{
+    struct dvbpsi_esprofile_entry_s *p_next;    /* same bucket */
+    struct dvbpsi_esprofile_entry_s *p_older;   /* less recently used */
+    struct dvbpsi_esprofile_entry_s *p_newer;   /* more recently used */
+
+    uint32_t                i_hash;
+    unsigned int            i_sections;
+    uint32_t                pi_crc[ESPROFILE_SECTIONS];
+    uint16_t                pi_length[ESPROFILE_SECTIONS];
+
+    uint16_t                i_count;
+    dvbpsi_esprofile_t      p_profiles[];
+} dvbpsi_esprofile_entry_t;
+
+struct dvbpsi_esprofile_cache_s
+{
+    size_t                  i_max;
+    unsigned int            i_buckets;          /* power of 2 */
+    dvbpsi_esprofile_entry_t **pp_buckets;
+    dvbpsi_esprofile_entry_t *p_oldest;
+    dvbpsi_esprofile_entry_t *p_newest;
+    dvbpsi_esprofile_stats_t stats;
+
+    dvbpsi_esprofile_t *    p_scratch;          /* profiles not cached */
+    uint16_t                i_scratch;
+};
+
+/*****************************************************************************
+ * dvbpsi_esprofile_cache_new
+ *****************************************************************************/
+dvbpsi_esprofile_cache_t *dvbpsi_esprofile_cache_new(size_t i_max)
+{
+    if (i_max == 0)
+        return NULL;
+
+    dvbpsi_esprofile_cache_t *p_cache = dvbpsi_calloc(1, sizeof(dvbpsi_esprofile_cache_t));
+    if (p_cache == NULL)
+        return NULL;
+
+    p_cache->i_buckets = 64;
+    while (p_cache->i_buckets < i_max && p_cache->i_buckets < (1u << 20))
+        p_cache->i_buckets <<= 1;
+    p_cache->pp_buckets = dvbpsi_calloc(p_cache->i_buckets,
+                                        sizeof(dvbpsi_esprofile_entry_t *));
+    if (p_cache->pp_buckets == NULL)
+    {
+        dvbpsi_free(p_cache);
+        return NULL;
+    }
+    p_cache->i_max = i_max;
+    return p_cache;
+}
+
+/*****************************************************************************
+ * dvbpsi_esprofile_cache_delete
+ *****************************************************************************/
+void dvbpsi_esprofile_cache_delete(dvbpsi_esprofile_cache_t *p_cache)
+{
+    if (p_cache == NULL)
+        return;
+
+    dvbpsi_esprofile_entry_t *p_entry = p_cache->p_oldest;
+    while (p_entry)
+    {
+        dvbpsi_esprofile_entry_t *p_newer = p_entry->p_newer;
+        dvbpsi_free(p_entry);
+        p_entry = p_newer;
+    }
+
+    dvbpsi_free(p_cache->p_scratch);
+    dvbpsi_free(p_cache->pp_buckets);
+    dvbpsi_free(p_cache);
+}
+
+/*****************************************************************************
+ * dvbpsi_esprofile_get_stats
+ *****************************************************************************/
+void dvbpsi_esprofile_get_stats(dvbpsi_esprofile_cache_t *p_cache,
+                                dvbpsi_esprofile_stats_t *p_stats)
+{
+    assert(p_cache);
+    assert(p_stats);
+
+    *p_stats = p_cache->stats;
+}
+
+/*****************************************************************************
+ * dvbpsi_esprofile_type
+ *****************************************************************************
+ * Starts the profile of an elementary stream from its stream_type.
+ *****************************************************************************/
+static void dvbpsi_esprofile_type(dvbpsi_esprofile_t *p_profile, uint8_t i_type,
+                                  uint16_t i_pid)
+{
+    memset(p_profile, 0, sizeof(dvbpsi_esprofile_t));
+    p_profile->i_pid = i_pid;
+    p_profile->i_type = i_type;
+
+    static const struct { uint8_t i_type, i_kind, i_codec; } p_types[] =
+    {
+        { 0x01, DVBPSI_ES_VIDEO, DVBPSI_CODEC_MPEG1_VIDEO },
+        { 0x02, DVBPSI_ES_VIDEO, DVBPSI_CODEC_MPEG2_VIDEO },
+        { 0x03, DVBPSI_ES_AUDIO, DVBPSI_CODEC_MPEG1_AUDIO },
+        { 0x04, DVBPSI_ES_AUDIO, DVBPSI_CODEC_MPEG2_AUDIO },
+        { 0x05, DVBPSI_ES_DATA,  DVBPSI_CODEC_UNKNOWN },
+        { 0x0b, DVBPSI_ES_DATA,  DVBPSI_CODEC_UNKNOWN },
+        { 0x0c, DVBPSI_ES_DATA,  DVBPSI_CODEC_UNKNOWN },
+        { 0x0d, DVBPSI_ES_DATA,  DVBPSI_CODEC_UNKNOWN },
+        { 0x0f, DVBPSI_ES_AUDIO, DVBPSI_CODEC_AAC },
+        { 0x10, DVBPSI_ES_VIDEO, DVBPSI_CODEC_MPEG4_VIDEO },
+        { 0x11, DVBPSI_ES_AUDIO, DVBPSI_CODEC_MPEG4_AUDIO },
+        { 0x1b, DVBPSI_ES_VIDEO, DVBPSI_CODEC_H264 },
+        { 0x24, DVBPSI_ES_VIDEO, DVBPSI_CODEC_HEVC },
+        { 0x81, DVBPSI_ES_AUDIO, DVBPSI_CODEC_AC3 },     /* ATSC A/52 */
+        { 0x87, DVBPSI_ES_AUDIO, DVBPSI_CODEC_EAC3 },    /* ATSC A/52 annex G */
+    };
+    for (size_t i = 0; i < sizeof(p_types) / sizeof(p_types[0]); i++)
+    {
+        if (p_types[i].i_type == i_type)
+        {
+            p_profile->i_kind = p_types[i].i_kind;
+            p_profile->i_codec = p_types[i].i_codec;
+            break;
+        }
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_esprofile_set
+ *****************************************************************************
+ * Sets the kind and codec of a stream whose stream_type said nothing, a
+ * private PES stream_type 0x06 typically.
+ *****************************************************************************/
+static void dvbpsi_esprofile_set(dvbpsi_esprofile_t *p_profile, uint8_t i_kind,
+                                 uint8_t i_codec)
+{
+    if (p_profile->i_kind != DVBPSI_ES_OTHER && p_profile->i_kind != i_kind)
+        return;
+    p_profile->i_kind = i_kind;
+    if (p_profile->i_codec == DVBPSI_CODEC_UNKNOWN)
+        p_profile->i_codec = i_codec;
+}
+
+/*****************************************************************************
+ * dvbpsi_esprofile_language
+ *****************************************************************************/
+static void dvbpsi_esprofile_language(dvbpsi_esprofile_t *p_profile,
+                                      const uint8_t *p_code)
+{
+    if (p_profile->psz_language[0] != '\0')
+        return;
+    memcpy(p_profile->psz_language, p_code, 3);
+    p_profile->psz_language[3] = '\0';
+}
+
+/*****************************************************************************
+ * dvbpsi_esprofile_ac3_channels
+ *****************************************************************************
+ * Channels of the component_type of an AC-3 or enhanced AC-3 descriptor,
+ * ETSI EN 300 468 annex D.
+ *****************************************************************************/
+static uint8_t dvbpsi_esprofile_ac3_channels(uint8_t i_component_type)
+{
+    switch (i_component_type & 0x07)
+    {
+        case 0x00: return DVBPSI_CHANNELS_MONO;
+        case 0x01: return DVBPSI_CHANNELS_DUAL_MONO;
+        case 0x02:
+        case 0x03: return DVBPSI_CHANNELS_STEREO;
+        case 0x04:
+        case 0x05: return DVBPSI_CHANNELS_MULTI;
+        default:   return DVBPSI_CHANNELS_UNKNOWN;
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_esprofile_descriptor
+ *****************************************************************************
+ * Refines the profile with a descriptor of the ES_info loop, read from its
+ * raw bytes so that the descriptor decoders need not be built.
+ *****************************************************************************/
+static void dvbpsi_esprofile_descriptor(dvbpsi_esprofile_t *p_profile, uint8_t i_tag,
+                                        uint8_t i_length, const uint8_t *p_data)
+{
+    switch (i_tag)
+    {
+        case 0x02: /* video stream, MPEG_1_only_flag */
+            if (i_length >= 1 && (p_data[0] & 0x04)
+             && p_profile->i_codec == DVBPSI_CODEC_MPEG2_VIDEO)
+                p_profile->i_codec = DVBPSI_CODEC_MPEG1_VIDEO;
+            break;
+        case 0x03: /* audio stream, ID 0 for the lower sampling frequencies */
+            if (i_length >= 1 && !(p_data[0] & 0x40)
+             && p_profile->i_codec == DVBPSI_CODEC_MPEG1_AUDIO)
+                p_profile->i_codec = DVBPSI_CODEC_MPEG2_AUDIO;
+            break;
+        case 0x0a: /* ISO 639 language */
+            if (i_length >= 4)
+            {
+                if (p_profile->psz_language[0] == '\0')
+                    p_profile->i_audio_type = p_data[3];
+                dvbpsi_esprofile_language(p_profile, p_data);
+            }
+            break;
+        case 0x1b: /* MPEG-4 video */
+            dvbpsi_esprofile_set(p_profile, DVBPSI_ES_VIDEO, DVBPSI_CODEC_MPEG4_VIDEO);
+            break;
+        case 0x1c: /* MPEG-4 audio */
+            dvbpsi_esprofile_set(p_profile, DVBPSI_ES_AUDIO, DVBPSI_CODEC_MPEG4_AUDIO);
+            break;
+        case 0x46: /* VBI teletext */
+        case 0x56: /* teletext */
+            dvbpsi_esprofile_set(p_profile, DVBPSI_ES_TELETEXT, DVBPSI_CODEC_TELETEXT);
+            if (i_length >= 5)
+            {
+                if (p_profile->psz_language[0] == '\0')
+                    p_profile->i_subtitle_type = p_data[3] >> 3;
+                dvbpsi_esprofile_language(p_profile, p_data);
+            }
+            break;
+        case 0x59: /* subtitling */
+            dvbpsi_esprofile_set(p_profile, DVBPSI_ES_SUBTITLES, DVBPSI_CODEC_DVB_SUBTITLES);
+            if (i_length >= 8)
+            {
+                if (p_profile->psz_language[0] == '\0')
+                    p_profile->i_subtitle_type = p_data[3];
+                dvbpsi_esprofile_language(p_profile, p_data);
+            }
+            break;
+        case 0x6a: /* AC-3 */
+        case 0x7a: /* enhanced AC-3 */
+            dvbpsi_esprofile_set(p_profile, DVBPSI_ES_AUDIO,
+                                 i_tag == 0x6a ? DVBPSI_CODEC_AC3 : DVBPSI_CODEC_EAC3);
+            if (i_length >= 2 && (p_data[0] & 0x80)) /* component_type_flag */
+                p_profile->i_channels = dvbpsi_esprofile_ac3_channels(p_data[1]);
+            break;
+        case 0x7b: /* DTS */
+            dvbpsi_esprofile_set(p_profile, DVBPSI_ES_AUDIO, DVBPSI_CODEC_DTS);
+            break;
+        case 0x7c: /* AAC, AAC_type as the component_type of stream_content 0x6 */
+            dvbpsi_esprofile_set(p_profile, DVBPSI_ES_AUDIO, DVBPSI_CODEC_AAC);
+            if (i_length >= 3 && (p_data[1] & 0x80))
+            {
+                switch (p_data[2] & 0x0f)
+                {
+                    case 0x01: p_profile->i_channels = DVBPSI_CHANNELS_MONO; break;
+                    case 0x03: p_profile->i_channels = DVBPSI_CHANNELS_STEREO; break;
+                    case 0x05: p_profile->i_channels = DVBPSI_CHANNELS_MULTI; break;
+                }
+            }
+            break;
+        case 0x81: /* ATSC AC-3 audio, num_channels */
+            dvbpsi_esprofile_set(p_profile, DVBPSI_ES_AUDIO, DVBPSI_CODEC_AC3);
+            if (i_length >= 3)
+            {
+                uint8_t i_num = (p_data[2] >> 1) & 0x0f;
+                if (i_num == 0)
+                    p_profile->i_channels = DVBPSI_CHANNELS_DUAL_MONO;
+                else if (i_num == 1 || i_num == 8)
+                    p_profile->i_channels = DVBPSI_CHANNELS_MONO;
+                else if (i_num == 2 || i_num == 9 || i_num == 10)
+                    p_profile->i_channels = DVBPSI_CHANNELS_STEREO;
+                else
+                    p_profile->i_channels = DVBPSI_CHANNELS_MULTI;
+            }
+            break;
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_esprofile_sections_parse
+ *****************************************************************************
+ * Counts the elementary streams of the raw sections of a PMT, filling their
+ * profiles if p_profiles is not NULL.
+ *****************************************************************************/
+static uint16_t dvbpsi_esprofile_sections_parse(const dvbpsi_psi_section_t *p_sections,
+                                                dvbpsi_esprofile_t *p_profiles)
+{
+    uint16_t i_count = 0;
+    for (const dvbpsi_psi_section_t *p_section = p_sections; p_section;
+         p_section = p_section->p_next)
+    {
+        const uint8_t *p_byte = p_section->p_payload_start;
+        const uint8_t *p_end = p_section->p_payload_end;
+        if (p_byte + 4 > p_end)
+            continue;
+        p_byte += 4 + (((uint16_t)(p_byte[2] & 0x0f) << 8) | p_byte[3]);
+
+        while (p_byte + 5 <= p_end)
+        {
+            uint16_t i_length = ((uint16_t)(p_byte[3] & 0x0f) << 8) | p_byte[4];
+            const uint8_t *p_loop = p_byte + 5;
+            const uint8_t *p_loop_end = p_loop + i_length;
+            if (p_loop_end > p_end)
+                break;
+
+            if (p_profiles)
+            {
+                dvbpsi_esprofile_t *p_profile = &p_profiles[i_count];
+                dvbpsi_esprofile_type(p_profile, p_byte[0],
+                                      ((uint16_t)(p_byte[1] & 0x1f) << 8) | p_byte[2]);
+                while (p_loop + 2 <= p_loop_end && p_loop + 2 + p_loop[1] <= p_loop_end)
+                {
+                    dvbpsi_esprofile_descriptor(p_profile, p_loop[0], p_loop[1], p_loop + 2);
+                    p_loop += 2 + p_loop[1];
+                }
+            }
+            i_count++;
+            p_byte = p_loop_end;
+        }
+    }
+    return i_count;
+}
+
+/*****************************************************************************
+ * dvbpsi_esprofile_sections
+ *****************************************************************************
+ * Raw sections of a PMT, NULL if they are not known.
+ *****************************************************************************/
+static const dvbpsi_psi_section_t *dvbpsi_esprofile_sections(dvbpsi_t *p_dvbpsi,
+                                                             const dvbpsi_pmt_t *p_pmt)
+{
+    if (p_pmt->p_sections)
+        return p_pmt->p_sections;
+    if (p_dvbpsi == NULL || !p_pmt->b_current_next)
+        return NULL;
+
+    const dvbpsi_psi_section_t *p_sections
+                = dvbpsi_get_last_sections(p_dvbpsi, 0x02, p_pmt->i_program_number);
+    if (p_sections == NULL || p_sections->i_extension != p_pmt->i_program_number
+     || p_sections->i_version != p_pmt->i_version)
+        return NULL;
+    return p_sections;
+}
+
+/*****************************************************************************
+ * dvbpsi_esprofile_key
+ *****************************************************************************
+ * Fills the key of the sections of a PMT, with its FNV-1a hash. Returns
+ * false if the PMT has too many sections to be cached.
+ *****************************************************************************/
+static bool dvbpsi_esprofile_key(dvbpsi_esprofile_entry_t *p_key,
+                                 const dvbpsi_psi_section_t *p_sections)
+{
+    p_key->i_sections = 0;
+
+    uint32_t i_hash = 2166136261u;
+#define ESPROFILE_HASH(b) i_hash = (i_hash ^ (uint8_t)(b)) * 16777619u
+    for (const dvbpsi_psi_section_t *p = p_sections; p; p = p->p_next)
+    {
+        if (p_key->i_sections == ESPROFILE_SECTIONS)
+            return false;
+
+        const uint8_t *p_crc = p->p_payload_end;
+        p_key->pi_crc[p_key->i_sections] = ((uint32_t)p_crc[0] << 24)
+                                         | ((uint32_t)p_crc[1] << 16)
+                                         | ((uint32_t)p_crc[2] << 8) | p_crc[3];
+        p_key->pi_length[p_key->i_sections] = p->i_length;
+        p_key->i_sections++;
+        for (int i = 0; i < 4; i++)
+            ESPROFILE_HASH(p_crc[i]);
+    }
+#undef ESPROFILE_HASH
+    p_key->i_hash = i_hash;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_esprofile_unlink
+ *****************************************************************************
+ * Removes an entry from the recently used list.
+ *****************************************************************************/
+static void dvbpsi_esprofile_unlink(dvbpsi_esprofile_cache_t *p_cache,
+                                    dvbpsi_esprofile_entry_t *p_entry)
+{
+    if (p_entry->p_older)
+        p_entry->p_older->p_newer = p_entry->p_newer;
+    else
+        p_cache->p_oldest = p_entry->p_newer;
+    if (p_entry->p_newer)
+        p_entry->p_newer->p_older = p_entry->p_older;
+    else
+        p_cache->p_newest = p_entry->p_older;
+    p_entry->p_older = p_entry->p_newer = NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_esprofile_use
+ *****************************************************************************
+ * Makes an entry the most recently used one.
+ *****************************************************************************/
+static void dvbpsi_esprofile_use(dvbpsi_esprofile_cache_t *p_cache,
+                                 dvbpsi_esprofile_entry_t *p_entry)
+{
+    if (p_cache->p_newest == p_entry)
+        return;
+
+    if (p_entry->p_older || p_entry->p_newer || p_cache->p_oldest == p_entry)
+        dvbpsi_esprofile_unlink(p_cache, p_entry);
+    p_entry->p_older = p_cache->p_newest;
+    if (p_cache->p_newest)
+        p_cache->p_newest->p_newer = p_entry;
+    else
+        p_cache->p_oldest = p_entry;
+    p_cache->p_newest = p_entry;
+}
+
+/*****************************************************************************
+ * dvbpsi_esprofile_find
+ *****************************************************************************/
+static dvbpsi_esprofile_entry_t *dvbpsi_esprofile_find(dvbpsi_esprofile_cache_t *p_cache,
+                                                       const dvbpsi_esprofile_entry_t *p_key)
+{
+    dvbpsi_esprofile_entry_t *p_entry
+                = p_cache->pp_buckets[p_key->i_hash & (p_cache->i_buckets - 1)];
+    for (; p_entry; p_entry = p_entry->p_next)
+    {
+        if (p_entry->i_hash == p_key->i_hash
+         && p_entry->i_sections == p_key->i_sections
+         && !memcmp(p_entry->pi_crc, p_key->pi_crc, p_key->i_sections * sizeof(uint32_t))
+         && !memcmp(p_entry->pi_length, p_key->pi_length,
+                    p_key->i_sections * sizeof(uint16_t)))
+        {
+            dvbpsi_esprofile_use(p_cache, p_entry);
+            return p_entry;
+        }
+    }
+    return NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_esprofile_evict
+ *****************************************************************************
+ * Drops the least recently used entry.
+ *****************************************************************************/
+static void dvbpsi_esprofile_evict(dvbpsi_esprofile_cache_t *p_cache)
+{
+    dvbpsi_esprofile_entry_t *p_entry = p_cache->p_oldest;
+    assert(p_entry);
+
+    dvbpsi_esprofile_entry_t **pp_entry
+                = &p_cache->pp_buckets[p_entry->i_hash & (p_cache->i_buckets - 1)];
+    while (*pp_entry != p_entry)
+        pp_entry = &(*pp_entry)->p_next;
+    *pp_entry = p_entry->p_next;
+
+    dvbpsi_esprofile_unlink(p_cache, p_entry);
+    dvbpsi_free(p_entry);
+    p_cache->stats.i_pmts--;
+    p_cache->stats.i_evictions++;
+}
+
+/*****************************************************************************
+ * dvbpsi_esprofile_insert
+ *****************************************************************************
+ * Adds the profiles of the sections of p_key.
+ *****************************************************************************/
+static dvbpsi_esprofile_entry_t *dvbpsi_esprofile_insert(dvbpsi_esprofile_cache_t *p_cache,
+                                                         const dvbpsi_esprofile_entry_t *p_key,
+                                                         const dvbpsi_psi_section_t *p_sections)
+{
+    uint16_t i_count = dvbpsi_esprofile_sections_parse(p_sections, NULL);
+    dvbpsi_esprofile_entry_t *p_entry
+                = dvbpsi_malloc(sizeof(dvbpsi_esprofile_entry_t)
+                                + i_count * sizeof(dvbpsi_esprofile_t));
+    if (p_entry == NULL)
+        return NULL;
+
+    if (p_cache->stats.i_pmts >= p_cache->i_max)
+        dvbpsi_esprofile_evict(p_cache);
+
+    *p_entry = *p_key;
+    p_entry->i_count = dvbpsi_esprofile_sections_parse(p_sections, p_entry->p_profiles);
+    p_entry->p_older = p_entry->p_newer = NULL;
+    dvbpsi_esprofile_entry_t **pp_bucket
+                = &p_cache->pp_buckets[p_key->i_hash & (p_cache->i_buckets - 1)];
+    p_entry->p_next = *pp_bucket;
+    *pp_bucket = p_entry;
+    dvbpsi_esprofile_use(p_cache, p_entry);
+    p_cache->stats.i_pmts++;
+    return p_entry;
+}
+
+/*****************************************************************************
+ * dvbpsi_esprofile_scratch
+ *****************************************************************************
+ * Room for the profiles of a PMT that is not cached.
+ *****************************************************************************/
+static dvbpsi_esprofile_t *dvbpsi_esprofile_scratch(dvbpsi_esprofile_cache_t *p_cache,
+                                                    uint16_t i_count)
+{
+    if (i_count > p_cache->i_scratch)
+    {
+        dvbpsi_esprofile_t *p_scratch = dvbpsi_malloc(i_count * sizeof(dvbpsi_esprofile_t));
+        if (p_scratch == NULL)
+            return NULL;
+        dvbpsi_free(p_cache->p_scratch);
+        p_cache->p_scratch = p_scratch;
+        p_cache->i_scratch = i_count;
+    }
+    return p_cache->p_scratch;
+}
+
+/*****************************************************************************
+ * dvbpsi_esprofile_pmt
+ *****************************************************************************/
+const dvbpsi_esprofile_t *dvbpsi_esprofile_pmt(dvbpsi_esprofile_cache_t *p_cache,
+                                               dvbpsi_t *p_dvbpsi,
+                                               const dvbpsi_pmt_t *p_pmt,
+                                               uint16_t *pi_count)
+{
+    assert(p_cache);
+    assert(p_pmt);
+    assert(pi_count);
+
+    *pi_count = 0;
+    const dvbpsi_psi_section_t *p_sections = dvbpsi_esprofile_sections(p_dvbpsi, p_pmt);
+    if (p_sections)
+    {
+        dvbpsi_esprofile_entry_t key;
+        if (dvbpsi_esprofile_key(&key, p_sections))
+        {
+            dvbpsi_esprofile_entry_t *p_entry = dvbpsi_esprofile_find(p_cache, &key);
+            if (p_entry)
+                p_cache->stats.i_hits++;
+            else
+            {
+                p_entry = dvbpsi_esprofile_insert(p_cache, &key, p_sections);
+                if (p_entry == NULL)
+                    return NULL;
+                p_cache->stats.i_misses++;
+            }
+            *pi_count = p_entry->i_count;
+            return p_entry->i_count ? p_entry->p_profiles : NULL;
+        }
+
+        /* Too many sections to be cached */
+        uint16_t i_count = dvbpsi_esprofile_sections_parse(p_sections, NULL);
+        dvbpsi_esprofile_t *p_profiles = dvbpsi_esprofile_scratch(p_cache, i_count);
+        if (p_profiles == NULL || i_count == 0)
+            return NULL;
+        *pi_count = dvbpsi_esprofile_sections_parse(p_sections, p_profiles);
+        p_cache->stats.i_uncached++;
+        return p_profiles;
+    }
+
+    /* Decoded descriptors */
+    uint16_t i_count = 0;
+    for (const dvbpsi_pmt_es_t *p_es = p_pmt->p_first_es; p_es; p_es = p_es->p_next)
+        i_count++;
+    dvbpsi_esprofile_t *p_profiles = dvbpsi_esprofile_scratch(p_cache, i_count);
+    if (p_profiles == NULL || i_count == 0)
+        return NULL;
+
+    dvbpsi_esprofile_t *p_profile = p_profiles;
+    for (const dvbpsi_pmt_es_t *p_es = p_pmt->p_first_es; p_es; p_es = p_es->p_next)
+    {
+        dvbpsi_esprofile_type(p_profile, p_es->i_type, p_es->i_pid);
+        for (const dvbpsi_descriptor_t *p_dr = p_es->p_first_descriptor; p_dr;
+             p_dr = p_dr->p_next)
+            dvbpsi_esprofile_descriptor(p_profile, p_dr->i_tag, p_dr->i_length,
+                                        p_dr->p_data);
+        p_profile++;
+    }
+    p_cache->stats.i_uncached++;
+    *pi_count = i_count;
+    return p_profiles;
+}
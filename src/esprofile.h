@@ -0,0 +1,241 @@
+/*****************************************************************************
+ * esprofile.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <esprofile.h>
+ * \brief Profiles of the elementary streams of PMTs, cached by CRC_32.
+ *
+ * The profile of an elementary stream sums up its stream_type and the
+ * descriptors of its ES_info loop: kind of stream, codec, audio channels,
+ * language, subtitling or teletext type. The profiles of a PMT are worked
+ * out from the raw descriptors once for each PMT section seen, and kept in
+ * a cache by the CRC_32 of the section: the same PMT carried by other
+ * streams, or by the same stream again after a reset, only costs a hash
+ * lookup, the decoded descriptors are not needed. A cache is used from one
+ * thread, and may be shared by the handles of any number of streams.
+ */
+
+#ifndef _DVBPSI_ESPROFILE_H_
+#define _DVBPSI_ESPROFILE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_esprofile_cache_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_esprofile_cache_s dvbpsi_esprofile_cache_t
+ * \brief dvbpsi_esprofile_cache_t type definition, an opaque cache of
+ * profiles.
+ */
+typedef struct dvbpsi_esprofile_cache_s dvbpsi_esprofile_cache_t;
+
+/*****************************************************************************
+ * dvbpsi_esprofile_t
+ *****************************************************************************/
+/*!
+ * \enum dvbpsi_es_kind
+ * \brief Kinds of elementary streams
+ */
+enum dvbpsi_es_kind
+{
+    DVBPSI_ES_OTHER = 0,    /*!< unknown or private stream */
+    DVBPSI_ES_VIDEO,        /*!< video */
+    DVBPSI_ES_AUDIO,        /*!< audio */
+    DVBPSI_ES_SUBTITLES,    /*!< DVB subtitles */
+    DVBPSI_ES_TELETEXT,     /*!< teletext or VBI data */
+    DVBPSI_ES_DATA,         /*!< private sections, DSM-CC */
+};
+/*!
+ * \typedef enum dvbpsi_es_kind dvbpsi_es_kind_t
+ * \brief dvbpsi_es_kind_t type definition.
+ */
+typedef enum dvbpsi_es_kind dvbpsi_es_kind_t;
+
+/*!
+ * \enum dvbpsi_es_codec
+ * \brief Codecs of elementary streams
+ */
+enum dvbpsi_es_codec
+{
+    DVBPSI_CODEC_UNKNOWN = 0,   /*!< not known */
+    DVBPSI_CODEC_MPEG1_VIDEO,   /*!< ISO/IEC 11172-2 video */
+    DVBPSI_CODEC_MPEG2_VIDEO,   /*!< ISO/IEC 13818-2 video */
+    DVBPSI_CODEC_MPEG4_VIDEO,   /*!< ISO/IEC 14496-2 visual */
+    DVBPSI_CODEC_H264,          /*!< AVC video */
+    DVBPSI_CODEC_HEVC,          /*!< HEVC video */
+    DVBPSI_CODEC_MPEG1_AUDIO,   /*!< ISO/IEC 11172-3 audio */
+    DVBPSI_CODEC_MPEG2_AUDIO,   /*!< ISO/IEC 13818-3 audio */
+    DVBPSI_CODEC_AAC,           /*!< AAC, ADTS transport */
+    DVBPSI_CODEC_MPEG4_AUDIO,   /*!< ISO/IEC 14496-3 audio, LATM transport */
+    DVBPSI_CODEC_AC3,           /*!< AC-3 */
+    DVBPSI_CODEC_EAC3,          /*!< enhanced AC-3 */
+    DVBPSI_CODEC_DTS,           /*!< DTS */
+    DVBPSI_CODEC_DVB_SUBTITLES, /*!< EN 300 743 subtitles */
+    DVBPSI_CODEC_TELETEXT,      /*!< EN 300 472 teletext */
+};
+/*!
+ * \typedef enum dvbpsi_es_codec dvbpsi_es_codec_t
+ * \brief dvbpsi_es_codec_t type definition.
+ */
+typedef enum dvbpsi_es_codec dvbpsi_es_codec_t;
+
+/*!
+ * \enum dvbpsi_es_channels
+ * \brief Audio channel configurations
+ */
+enum dvbpsi_es_channels
+{
+    DVBPSI_CHANNELS_UNKNOWN = 0,    /*!< not signalled */
+    DVBPSI_CHANNELS_MONO,           /*!< one channel */
+    DVBPSI_CHANNELS_DUAL_MONO,      /*!< two independent channels */
+    DVBPSI_CHANNELS_STEREO,         /*!< two channels, possibly surround
+                                         encoded */
+    DVBPSI_CHANNELS_MULTI,          /*!< more than two channels */
+};
+/*!
+ * \typedef enum dvbpsi_es_channels dvbpsi_es_channels_t
+ * \brief dvbpsi_es_channels_t type definition.
+ */
+typedef enum dvbpsi_es_channels dvbpsi_es_channels_t;
+
+/*!
+ * \struct dvbpsi_esprofile_s
+ * \brief Profile of an elementary stream of a PMT.
+ */
+/*!
+ * \typedef struct dvbpsi_esprofile_s dvbpsi_esprofile_t
+ * \brief dvbpsi_esprofile_t type definition.
+ */
+typedef struct dvbpsi_esprofile_s
+{
+    uint16_t    i_pid;              /*!< elementary_PID */
+    uint8_t     i_type;             /*!< stream_type */
+    uint8_t     i_kind;             /*!< dvbpsi_es_kind_t */
+    uint8_t     i_codec;            /*!< dvbpsi_es_codec_t */
+    uint8_t     i_channels;         /*!< dvbpsi_es_channels_t */
+    uint8_t     i_audio_type;       /*!< audio_type of the ISO 639 language
+                                         descriptor, 0 without */
+    uint8_t     i_subtitle_type;    /*!< subtitling_type of the subtitling
+                                         descriptor, or teletext_type of the
+                                         teletext descriptor, 0 without */
+    char        psz_language[4];    /*!< first ISO 639-2 language code of the
+                                         ISO 639 language, subtitling or
+                                         teletext descriptor, "" without */
+} dvbpsi_esprofile_t;
+
+/*****************************************************************************
+ * dvbpsi_esprofile_stats_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_esprofile_stats_s
+ * \brief Counters of a cache.
+ */
+/*!
+ * \typedef struct dvbpsi_esprofile_stats_s dvbpsi_esprofile_stats_t
+ * \brief dvbpsi_esprofile_stats_t type definition.
+ */
+typedef struct dvbpsi_esprofile_stats_s
+{
+    uint64_t    i_hits;         /*!< PMTs found in the cache */
+    uint64_t    i_misses;       /*!< PMTs worked out and added */
+    uint64_t    i_uncached;     /*!< PMTs worked out from their decoded
+                                     descriptors, their sections being
+                                     unknown */
+    uint64_t    i_evictions;    /*!< PMTs dropped as the cache was full */
+    size_t      i_pmts;         /*!< PMTs in the cache */
+} dvbpsi_esprofile_stats_t;
+
+/*****************************************************************************
+ * dvbpsi_esprofile_cache_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_esprofile_cache_t *dvbpsi_esprofile_cache_new(size_t i_max)
+ * \brief Creates an empty cache
+ * \param i_max maximum number of PMTs kept, the least recently used one
+ *        being dropped for a new one
+ * \return pointer to the cache, or NULL on error
+ */
+dvbpsi_esprofile_cache_t *dvbpsi_esprofile_cache_new(size_t i_max);
+
+/*****************************************************************************
+ * dvbpsi_esprofile_cache_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_esprofile_cache_delete(dvbpsi_esprofile_cache_t *p_cache)
+ * \brief Deletes a cache and its profiles
+ * \param p_cache pointer to the cache, or NULL
+ * \return nothing
+ */
+void dvbpsi_esprofile_cache_delete(dvbpsi_esprofile_cache_t *p_cache);
+
+/*****************************************************************************
+ * dvbpsi_esprofile_get_stats
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_esprofile_get_stats(dvbpsi_esprofile_cache_t *p_cache,
+ *                                     dvbpsi_esprofile_stats_t *p_stats)
+ * \brief Gets the counters of a cache
+ * \param p_cache pointer to the cache
+ * \param p_stats receives the counters
+ * \return nothing
+ */
+void dvbpsi_esprofile_get_stats(dvbpsi_esprofile_cache_t *p_cache,
+                                dvbpsi_esprofile_stats_t *p_stats);
+
+/*****************************************************************************
+ * dvbpsi_esprofile_pmt
+ *****************************************************************************/
+/*!
+ * \fn const dvbpsi_esprofile_t *dvbpsi_esprofile_pmt(
+ *                                  dvbpsi_esprofile_cache_t *p_cache,
+ *                                  dvbpsi_t *p_dvbpsi, const dvbpsi_pmt_t *p_pmt,
+ *                                  uint16_t *pi_count)
+ * \brief Gets the profiles of the elementary streams of a PMT
+ * \param p_cache pointer to the cache
+ * \param p_dvbpsi handle the PMT decoder is attached to, or NULL
+ * \param p_pmt PMT, from the PMT callback
+ * \param pi_count filled with the number of elementary streams
+ * \return the profiles, in the order of the ES loop, valid until the next
+ *         call on the cache, or NULL on a memory error or without
+ *         elementary stream.
+ *
+ * The sections of the PMT are those kept by a PMT delivered with
+ * DVBPSI_FLAG_LAZY_DECODE, which is then not decoded, or those of the last
+ * complete table of the handle with DVBPSI_FLAG_LAST_SECTIONS, called from
+ * the PMT callback. Without them the profiles are worked out from the
+ * decoded descriptors of the PMT, and not cached.
+ */
+const dvbpsi_esprofile_t *dvbpsi_esprofile_pmt(dvbpsi_esprofile_cache_t *p_cache,
+                                               dvbpsi_t *p_dvbpsi,
+                                               const dvbpsi_pmt_t *p_pmt,
+                                               uint16_t *pi_count);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of esprofile.h"
+#endif
@@ -0,0 +1,491 @@
+/*****************************************************************************
+ * fanout.c: several subscribers for the subtables of a demux
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "descriptor.h"
+#include "demux.h"
+#include "tables/pmt.h"
+#include "tables/nit.h"
+#include "tables/sdt.h"
+#include "tables/bat.h"
+#include "tables/eit.h"
+#include "tables/tot.h"
+#include "snapshot.h"
+#include "fanout.h"
+
+/*****************************************************************************
+ * dvbpsi_fanout_subscriber_t
+ *****************************************************************************
+ * Subscriber of a subtable, without callback once unsubscribed from a
+ * callback.
+ *****************************************************************************/
+typedef struct dvbpsi_fanout_subscriber_s
+{
+    dvbpsi_fanout_callback  pf_callback;
+    void *                  p_cb_data;
+    uint32_t                i_flags;
+} dvbpsi_fanout_subscriber_t;
+
+/*****************************************************************************
+ * dvbpsi_fanout_subtable_t
+ *****************************************************************************
+ * Subtable with its decoder, the callback data of the decoder.
+ *****************************************************************************/
+typedef struct dvbpsi_fanout_subtable_s
+{
+    dvbpsi_fanout_t *                   p_fanout;
+    uint8_t                             i_table_id;
+    uint16_t                            i_extension;
+    bool                                b_segments; /* segment callback set */
+
+    dvbpsi_fanout_subscriber_t *        p_subscribers;
+    size_t                              i_subscribers;
+    size_t                              i_max;
+
+    struct dvbpsi_fanout_subtable_s *   p_next;
+} dvbpsi_fanout_subtable_t;
+
+struct dvbpsi_fanout_s
+{
+    dvbpsi_t *                  p_dvbpsi;
+    dvbpsi_fanout_subtable_t *  p_first_subtable;
+    unsigned int                i_depth;    /* callbacks in progress */
+};
+
+/*****************************************************************************
+ * dvbpsi_fanout_signal
+ *****************************************************************************
+ * Gives a new table to the subscribers wanting it, decoding it first.
+ *****************************************************************************/
+static void dvbpsi_fanout_signal(dvbpsi_fanout_subtable_t *p_subtable,
+                                 void *p_table, bool b_current, bool b_segment,
+                                 void (*pf_decode)(void *), void (*pf_delete)(void *))
+{
+    dvbpsi_fanout_t *p_fanout = p_subtable->p_fanout;
+    uint32_t i_wanted = (b_current ? DVBPSI_FANOUT_CURRENT : DVBPSI_FANOUT_NEXT);
+    uint32_t i_segments = (b_segment ? DVBPSI_FANOUT_SEGMENTS : 0);
+
+    /* Subscribed from a callback: only the next tables */
+    size_t i_subscribers = p_subtable->i_subscribers;
+    size_t i_count = 0;
+    for (size_t i = 0; i < i_subscribers; i++)
+    {
+        const dvbpsi_fanout_subscriber_t *p_subscriber = &p_subtable->p_subscribers[i];
+        if (p_subscriber->pf_callback && (p_subscriber->i_flags & i_wanted)
+         && (p_subscriber->i_flags & DVBPSI_FANOUT_SEGMENTS) == i_segments)
+            i_count++;
+    }
+    if (i_count == 0)
+    {
+        pf_delete(p_table);
+        return;
+    }
+
+    if (pf_decode)
+        pf_decode(p_table);
+    dvbpsi_snapshot_t *p_snapshot = dvbpsi_snapshot_new(p_subtable->i_table_id,
+                                                        p_subtable->i_extension,
+                                                        p_table, pf_delete);
+    if (p_snapshot == NULL)
+        return;
+
+    /* The array may grow or lose callbacks while in a callback */
+    p_fanout->i_depth++;
+    for (size_t i = 0; i < i_subscribers; i++)
+    {
+        const dvbpsi_fanout_subscriber_t *p_subscriber = &p_subtable->p_subscribers[i];
+        if (p_subscriber->pf_callback && (p_subscriber->i_flags & i_wanted)
+         && (p_subscriber->i_flags & DVBPSI_FANOUT_SEGMENTS) == i_segments)
+            p_subscriber->pf_callback(p_subscriber->p_cb_data,
+                                      dvbpsi_table_ref(p_snapshot));
+    }
+    p_fanout->i_depth--;
+    dvbpsi_table_unref(p_snapshot);
+}
+
+/*****************************************************************************
+ * Callbacks of the decoders
+ *****************************************************************************/
+static void dvbpsi_fanout_delete_pmt(void *p_table)
+{
+    dvbpsi_pmt_delete(p_table);
+}
+
+static void dvbpsi_fanout_decode_pmt(void *p_table)
+{
+    dvbpsi_pmt_decode(p_table);
+}
+
+static void dvbpsi_fanout_pmt(void *p_data, dvbpsi_pmt_t *p_pmt)
+{
+    dvbpsi_fanout_signal(p_data, p_pmt, p_pmt->b_current_next, false,
+                         dvbpsi_fanout_decode_pmt, dvbpsi_fanout_delete_pmt);
+}
+
+static void dvbpsi_fanout_delete_nit(void *p_table)
+{
+    dvbpsi_nit_delete(p_table);
+}
+
+static void dvbpsi_fanout_decode_nit(void *p_table)
+{
+    dvbpsi_nit_decode(p_table);
+}
+
+static void dvbpsi_fanout_nit(void *p_data, dvbpsi_nit_t *p_nit)
+{
+    dvbpsi_fanout_signal(p_data, p_nit, p_nit->b_current_next, false,
+                         dvbpsi_fanout_decode_nit, dvbpsi_fanout_delete_nit);
+}
+
+static void dvbpsi_fanout_delete_sdt(void *p_table)
+{
+    dvbpsi_sdt_delete(p_table);
+}
+
+static void dvbpsi_fanout_decode_sdt(void *p_table)
+{
+    dvbpsi_sdt_decode(p_table);
+}
+
+static void dvbpsi_fanout_sdt(void *p_data, dvbpsi_sdt_t *p_sdt)
+{
+    dvbpsi_fanout_signal(p_data, p_sdt, p_sdt->b_current_next, false,
+                         dvbpsi_fanout_decode_sdt, dvbpsi_fanout_delete_sdt);
+}
+
+static void dvbpsi_fanout_delete_bat(void *p_table)
+{
+    dvbpsi_bat_delete(p_table);
+}
+
+static void dvbpsi_fanout_decode_bat(void *p_table)
+{
+    dvbpsi_bat_decode(p_table);
+}
+
+static void dvbpsi_fanout_bat(void *p_data, dvbpsi_bat_t *p_bat)
+{
+    dvbpsi_fanout_signal(p_data, p_bat, p_bat->b_current_next, false,
+                         dvbpsi_fanout_decode_bat, dvbpsi_fanout_delete_bat);
+}
+
+static void dvbpsi_fanout_delete_eit(void *p_table)
+{
+    dvbpsi_eit_delete(p_table);
+}
+
+static void dvbpsi_fanout_decode_eit(void *p_table)
+{
+    dvbpsi_eit_decode(p_table);
+}
+
+static void dvbpsi_fanout_eit(void *p_data, dvbpsi_eit_t *p_eit)
+{
+    dvbpsi_fanout_signal(p_data, p_eit, p_eit->b_current_next, false,
+                         dvbpsi_fanout_decode_eit, dvbpsi_fanout_delete_eit);
+}
+
+static void dvbpsi_fanout_eit_segment(void *p_data, dvbpsi_eit_t *p_eit)
+{
+    /* Segments are decoded at once */
+    dvbpsi_fanout_signal(p_data, p_eit, p_eit->b_current_next, true,
+                         NULL, dvbpsi_fanout_delete_eit);
+}
+
+static void dvbpsi_fanout_delete_tot(void *p_table)
+{
+    dvbpsi_tot_delete(p_table);
+}
+
+static void dvbpsi_fanout_tot(void *p_data, dvbpsi_tot_t *p_tot)
+{
+    dvbpsi_fanout_signal(p_data, p_tot, p_tot->b_current_next, false,
+                         NULL, dvbpsi_fanout_delete_tot);
+}
+
+/*****************************************************************************
+ * dvbpsi_fanout_is_eit
+ *****************************************************************************/
+static bool dvbpsi_fanout_is_eit(uint8_t i_table_id)
+{
+    return i_table_id >= 0x4e && i_table_id <= 0x6f;
+}
+
+/*****************************************************************************
+ * dvbpsi_fanout_attach
+ *****************************************************************************
+ * Attaches the decoder of a subtable, false if the table is not supported
+ * or the subtable already has a decoder.
+ *****************************************************************************/
+static bool dvbpsi_fanout_attach(dvbpsi_t *p_dvbpsi, dvbpsi_fanout_subtable_t *p_subtable)
+{
+    uint8_t i_table_id = p_subtable->i_table_id;
+    uint16_t i_extension = p_subtable->i_extension;
+
+    if (i_table_id == 0x02)
+        return dvbpsi_pmt_demux_attach(p_dvbpsi, i_extension, dvbpsi_fanout_pmt, p_subtable);
+    else if (i_table_id == 0x40 || i_table_id == 0x41)
+        return dvbpsi_nit_attach(p_dvbpsi, i_table_id, i_extension, dvbpsi_fanout_nit, p_subtable);
+    else if (i_table_id == 0x42 || i_table_id == 0x46)
+        return dvbpsi_sdt_attach(p_dvbpsi, i_table_id, i_extension, dvbpsi_fanout_sdt, p_subtable);
+    else if (i_table_id == 0x4a)
+        return dvbpsi_bat_attach(p_dvbpsi, i_table_id, i_extension, dvbpsi_fanout_bat, p_subtable);
+    else if (dvbpsi_fanout_is_eit(i_table_id))
+        return dvbpsi_eit_attach(p_dvbpsi, i_table_id, i_extension, dvbpsi_fanout_eit, p_subtable);
+    else if (i_table_id == 0x70 || i_table_id == 0x73)
+        return dvbpsi_tot_attach(p_dvbpsi, i_table_id, i_extension, dvbpsi_fanout_tot, p_subtable);
+    return false;
+}
+
+/*****************************************************************************
+ * dvbpsi_fanout_detach
+ *****************************************************************************/
+static void dvbpsi_fanout_detach(dvbpsi_t *p_dvbpsi, const dvbpsi_fanout_subtable_t *p_subtable)
+{
+    uint8_t i_table_id = p_subtable->i_table_id;
+    uint16_t i_extension = p_subtable->i_extension;
+
+    if (i_table_id == 0x02)
+        dvbpsi_pmt_demux_detach(p_dvbpsi, i_extension);
+    else if (i_table_id == 0x40 || i_table_id == 0x41)
+        dvbpsi_nit_detach(p_dvbpsi, i_table_id, i_extension);
+    else if (i_table_id == 0x42 || i_table_id == 0x46)
+        dvbpsi_sdt_detach(p_dvbpsi, i_table_id, i_extension);
+    else if (i_table_id == 0x4a)
+        dvbpsi_bat_detach(p_dvbpsi, i_table_id, i_extension);
+    else if (dvbpsi_fanout_is_eit(i_table_id))
+        dvbpsi_eit_detach(p_dvbpsi, i_table_id, i_extension);
+    else
+        dvbpsi_tot_detach(p_dvbpsi, i_table_id, i_extension);
+}
+
+/*****************************************************************************
+ * dvbpsi_fanout_sweep
+ *****************************************************************************
+ * Removes the subscribers unsubscribed from a callback, clears the segment
+ * callbacks no longer needed and detaches the subtables left without
+ * subscribers. Only called out of the callbacks.
+ *****************************************************************************/
+static void dvbpsi_fanout_sweep(dvbpsi_fanout_t *p_fanout)
+{
+    assert(p_fanout->i_depth == 0);
+
+    dvbpsi_fanout_subtable_t **pp_subtable = &p_fanout->p_first_subtable;
+    while (*pp_subtable)
+    {
+        dvbpsi_fanout_subtable_t *p_subtable = *pp_subtable;
+        size_t i_kept = 0;
+        bool b_segments = false;
+        for (size_t i = 0; i < p_subtable->i_subscribers; i++)
+        {
+            if (p_subtable->p_subscribers[i].pf_callback == NULL)
+                continue;
+            b_segments |= !!(p_subtable->p_subscribers[i].i_flags & DVBPSI_FANOUT_SEGMENTS);
+            p_subtable->p_subscribers[i_kept++] = p_subtable->p_subscribers[i];
+        }
+        p_subtable->i_subscribers = i_kept;
+
+        if (i_kept == 0)
+        {
+            dvbpsi_fanout_detach(p_fanout->p_dvbpsi, p_subtable);
+            *pp_subtable = p_subtable->p_next;
+            dvbpsi_free(p_subtable->p_subscribers);
+            dvbpsi_free(p_subtable);
+            continue;
+        }
+        if (p_subtable->b_segments && !b_segments)
+        {
+            dvbpsi_eit_set_segment_callback(p_fanout->p_dvbpsi, p_subtable->i_table_id,
+                                            p_subtable->i_extension, NULL, NULL);
+            p_subtable->b_segments = false;
+        }
+        pp_subtable = &p_subtable->p_next;
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_fanout_find
+ *****************************************************************************/
+static dvbpsi_fanout_subtable_t *dvbpsi_fanout_find(dvbpsi_fanout_t *p_fanout,
+                                                    uint8_t i_table_id, uint16_t i_extension)
+{
+    dvbpsi_fanout_subtable_t *p_subtable = p_fanout->p_first_subtable;
+    while (p_subtable && (p_subtable->i_table_id != i_table_id
+                       || p_subtable->i_extension != i_extension))
+        p_subtable = p_subtable->p_next;
+    return p_subtable;
+}
+
+/*****************************************************************************
+ * dvbpsi_fanout_new
+ *****************************************************************************/
+dvbpsi_fanout_t *dvbpsi_fanout_new(dvbpsi_t *p_dvbpsi)
+{
+    assert(p_dvbpsi);
+
+    dvbpsi_fanout_t *p_fanout = dvbpsi_calloc(1, sizeof(dvbpsi_fanout_t));
+    if (p_fanout == NULL)
+        return NULL;
+    p_fanout->p_dvbpsi = p_dvbpsi;
+    return p_fanout;
+}
+
+/*****************************************************************************
+ * dvbpsi_fanout_delete
+ *****************************************************************************/
+void dvbpsi_fanout_delete(dvbpsi_fanout_t *p_fanout)
+{
+    if (p_fanout == NULL)
+        return;
+
+    assert(p_fanout->i_depth == 0);
+    while (p_fanout->p_first_subtable)
+    {
+        dvbpsi_fanout_subtable_t *p_subtable = p_fanout->p_first_subtable;
+        p_fanout->p_first_subtable = p_subtable->p_next;
+        dvbpsi_fanout_detach(p_fanout->p_dvbpsi, p_subtable);
+        dvbpsi_free(p_subtable->p_subscribers);
+        dvbpsi_free(p_subtable);
+    }
+    dvbpsi_free(p_fanout);
+}
+
+/*****************************************************************************
+ * dvbpsi_fanout_subscribe
+ *****************************************************************************/
+bool dvbpsi_fanout_subscribe(dvbpsi_fanout_t *p_fanout, uint8_t i_table_id,
+                             uint16_t i_extension, uint32_t i_flags,
+                             dvbpsi_fanout_callback pf_callback, void *p_cb_data)
+{
+    assert(p_fanout);
+    assert(pf_callback);
+
+    if (!(i_flags & (DVBPSI_FANOUT_CURRENT | DVBPSI_FANOUT_NEXT)))
+        return false;
+    if ((i_flags & DVBPSI_FANOUT_SEGMENTS) && !dvbpsi_fanout_is_eit(i_table_id))
+        return false;
+
+    if (p_fanout->i_depth == 0)
+        dvbpsi_fanout_sweep(p_fanout);
+
+    dvbpsi_fanout_subtable_t *p_subtable = dvbpsi_fanout_find(p_fanout, i_table_id,
+                                                              i_extension);
+    bool b_new = (p_subtable == NULL);
+    if (b_new)
+    {
+        p_subtable = dvbpsi_calloc(1, sizeof(dvbpsi_fanout_subtable_t));
+        if (p_subtable == NULL)
+            return false;
+        p_subtable->p_fanout = p_fanout;
+        p_subtable->i_table_id = i_table_id;
+        p_subtable->i_extension = i_extension;
+        if (!dvbpsi_fanout_attach(p_fanout->p_dvbpsi, p_subtable))
+        {
+            dvbpsi_free(p_subtable);
+            return false;
+        }
+        p_subtable->p_next = p_fanout->p_first_subtable;
+        p_fanout->p_first_subtable = p_subtable;
+    }
+
+    if (p_subtable->i_subscribers == p_subtable->i_max)
+    {
+        size_t i_max = p_subtable->i_max ? 2 * p_subtable->i_max : 4;
+        dvbpsi_fanout_subscriber_t *p_subscribers =
+            dvbpsi_malloc(i_max * sizeof(dvbpsi_fanout_subscriber_t));
+        if (p_subscribers == NULL)
+        {
+            /* A new subtable without subscriber is detached by the next
+               sweep */
+            return false;
+        }
+        if (p_subtable->i_subscribers)
+            memcpy(p_subscribers, p_subtable->p_subscribers,
+                   p_subtable->i_subscribers * sizeof(dvbpsi_fanout_subscriber_t));
+        dvbpsi_free(p_subtable->p_subscribers);
+        p_subtable->p_subscribers = p_subscribers;
+        p_subtable->i_max = i_max;
+    }
+
+    if ((i_flags & DVBPSI_FANOUT_SEGMENTS) && !p_subtable->b_segments)
+    {
+        if (!dvbpsi_eit_set_segment_callback(p_fanout->p_dvbpsi, i_table_id, i_extension,
+                                             dvbpsi_fanout_eit_segment, p_subtable))
+            return false;
+        p_subtable->b_segments = true;
+    }
+
+    dvbpsi_fanout_subscriber_t *p_subscriber =
+        &p_subtable->p_subscribers[p_subtable->i_subscribers++];
+    p_subscriber->pf_callback = pf_callback;
+    p_subscriber->p_cb_data = p_cb_data;
+    p_subscriber->i_flags = i_flags;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_fanout_unsubscribe
+ *****************************************************************************/
+void dvbpsi_fanout_unsubscribe(dvbpsi_fanout_t *p_fanout, uint8_t i_table_id,
+                               uint16_t i_extension,
+                               dvbpsi_fanout_callback pf_callback, void *p_cb_data)
+{
+    assert(p_fanout);
+
+    dvbpsi_fanout_subtable_t *p_subtable = dvbpsi_fanout_find(p_fanout, i_table_id,
+                                                              i_extension);
+    if (p_subtable)
+    {
+        for (size_t i = 0; i < p_subtable->i_subscribers; i++)
+        {
+            dvbpsi_fanout_subscriber_t *p_subscriber = &p_subtable->p_subscribers[i];
+            if (p_subscriber->pf_callback == pf_callback
+             && p_subscriber->p_cb_data == p_cb_data)
+            {
+                p_subscriber->pf_callback = NULL;
+                break;
+            }
+        }
+    }
+
+    if (p_fanout->i_depth == 0)
+        dvbpsi_fanout_sweep(p_fanout);
+}
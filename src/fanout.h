@@ -0,0 +1,165 @@
+/*****************************************************************************
+ * fanout.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <fanout.h>
+ * \brief Several subscribers for the subtables of a demux.
+ *
+ * A subtable of a demux has a single decoder and callback. A fan-out owns
+ * the decoders of the subtables it is subscribed to and gives each new
+ * table to all their subscribers: the table is decoded once, only if a
+ * subscriber wants it, and shared by the subscribers as a snapshot, see
+ * snapshot.h. Each subscriber chooses the current or next tables it gets,
+ * and for an EIT, its whole tables or its segments as soon as they are
+ * complete.
+ */
+
+#ifndef _DVBPSI_FANOUT_H_
+#define _DVBPSI_FANOUT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_fanout_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_fanout_s dvbpsi_fanout_t
+ * \brief dvbpsi_fanout_t type definition, an opaque fan-out.
+ */
+typedef struct dvbpsi_fanout_s dvbpsi_fanout_t;
+
+/*!
+ * \def DVBPSI_FANOUT_CURRENT
+ * \brief The subscriber gets the tables with current_next_indicator set.
+ */
+#define DVBPSI_FANOUT_CURRENT   0x01
+/*!
+ * \def DVBPSI_FANOUT_NEXT
+ * \brief The subscriber gets the tables not yet applicable.
+ */
+#define DVBPSI_FANOUT_NEXT      0x02
+/*!
+ * \def DVBPSI_FANOUT_SEGMENTS
+ * \brief The subscriber of an EIT gets an EIT for each segment as soon as
+ * it is complete, instead of the whole tables, see
+ * dvbpsi_eit_set_segment_callback().
+ */
+#define DVBPSI_FANOUT_SEGMENTS  0x04
+
+/*****************************************************************************
+ * dvbpsi_fanout_callback
+ *****************************************************************************/
+/*!
+ * \typedef void (* dvbpsi_fanout_callback)(void *p_cb_data,
+ *                                          dvbpsi_snapshot_t *p_snapshot)
+ * \brief Callback type definition, called with a reference to the snapshot
+ * of a new table, to be released with dvbpsi_table_unref(). The table, a
+ * dvbpsi_pmt_t, dvbpsi_sdt_t, ... of its table_id, is decoded.
+ */
+typedef void (* dvbpsi_fanout_callback)(void *p_cb_data, dvbpsi_snapshot_t *p_snapshot);
+
+/*****************************************************************************
+ * dvbpsi_fanout_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_fanout_t *dvbpsi_fanout_new(dvbpsi_t *p_dvbpsi)
+ * \brief Creates a fan-out with no subscriber
+ * \param p_dvbpsi handle with a subtable demux, see dvbpsi_AttachDemux()
+ * \return pointer to the fan-out, or NULL on error
+ */
+dvbpsi_fanout_t *dvbpsi_fanout_new(dvbpsi_t *p_dvbpsi);
+
+/*****************************************************************************
+ * dvbpsi_fanout_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_fanout_delete(dvbpsi_fanout_t *p_fanout)
+ * \brief Detaches the decoders of a fan-out and deletes it
+ * \param p_fanout pointer to the fan-out
+ * \return nothing
+ *
+ * It must be called before dvbpsi_DetachDemux(), and not from a callback.
+ */
+void dvbpsi_fanout_delete(dvbpsi_fanout_t *p_fanout);
+
+/*****************************************************************************
+ * dvbpsi_fanout_subscribe
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_fanout_subscribe(dvbpsi_fanout_t *p_fanout,
+ *                                  uint8_t i_table_id, uint16_t i_extension,
+ *                                  uint32_t i_flags,
+ *                                  dvbpsi_fanout_callback pf_callback,
+ *                                  void *p_cb_data)
+ * \brief Subscribes to a subtable, attaching its decoder for the first
+ * subscriber
+ * \param p_fanout pointer to the fan-out
+ * \param i_table_id table_id of a PMT (0x02), NIT, SDT, BAT, EIT, TDT or TOT
+ * \param i_extension table_id_extension, the program_number of a PMT
+ * \param i_flags or'ed DVBPSI_FANOUT_* options, with DVBPSI_FANOUT_CURRENT,
+ *        DVBPSI_FANOUT_NEXT or both
+ * \param pf_callback function to call back with the new tables
+ * \param p_cb_data private data given in argument to the callback
+ * \return false if the options are not valid for the table, the subtable
+ *         has a decoder not attached by the fan-out, or on error, true
+ *         otherwise.
+ *
+ * It may be called from a callback, the subscriber only getting the next
+ * tables.
+ */
+bool dvbpsi_fanout_subscribe(dvbpsi_fanout_t *p_fanout, uint8_t i_table_id,
+                             uint16_t i_extension, uint32_t i_flags,
+                             dvbpsi_fanout_callback pf_callback, void *p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_fanout_unsubscribe
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_fanout_unsubscribe(dvbpsi_fanout_t *p_fanout,
+ *                                    uint8_t i_table_id, uint16_t i_extension,
+ *                                    dvbpsi_fanout_callback pf_callback,
+ *                                    void *p_cb_data)
+ * \brief Removes a subscriber, detaching the decoder of its subtable after
+ * the last one
+ * \param p_fanout pointer to the fan-out
+ * \param i_table_id table_id given to dvbpsi_fanout_subscribe()
+ * \param i_extension table_id_extension given to dvbpsi_fanout_subscribe()
+ * \param pf_callback callback given to dvbpsi_fanout_subscribe()
+ * \param p_cb_data callback data given to dvbpsi_fanout_subscribe()
+ * \return nothing
+ *
+ * It may be called from a callback: the subscriber gets no table anymore,
+ * and the decoder is only detached on the next call out of the callbacks.
+ */
+void dvbpsi_fanout_unsubscribe(dvbpsi_fanout_t *p_fanout, uint8_t i_table_id,
+                               uint16_t i_extension,
+                               dvbpsi_fanout_callback pf_callback, void *p_cb_data);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of fanout.h"
+#endif
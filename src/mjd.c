@@ -0,0 +1,171 @@
+/*****************************************************************************
+ * mjd.c: MJD and BCD time conversions
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+#include "dvbpsi.h"
+#include "mjd.h"
+
+/* MJD 40587 is 1970-01-01 */
+#define DVBPSI_MJD_EPOCH 40587
+
+/* Days from 0000-03-01 to 1970-01-01, and in 400 years */
+#define DVBPSI_MJD_CIVIL_EPOCH 719468
+#define DVBPSI_MJD_ERA_DAYS    146097
+
+/*****************************************************************************
+ * pi_month_start
+ *****************************************************************************
+ * First day of each month in a year starting on March 1st, February being
+ * the last month whatever its length, then the length of the year.
+ *****************************************************************************/
+static const uint16_t pi_month_start[13] = {
+    0, 31, 61, 92, 122, 153, 184, 214, 245, 275, 306, 337, 366
+};
+
+/*****************************************************************************
+ * dvbpsi_bcd_valid
+ *****************************************************************************/
+bool dvbpsi_bcd_valid(uint32_t i_bcd)
+{
+    /* Adding 6 to a digit above 9 carries into the next one */
+    i_bcd &= 0xffffff;
+    uint32_t i_carries = (i_bcd + 0x666666) ^ i_bcd ^ 0x666666;
+    return (i_carries & 0x1111110) == 0;
+}
+
+/*****************************************************************************
+ * dvbpsi_bcd_to_seconds
+ *****************************************************************************/
+uint32_t dvbpsi_bcd_to_seconds(uint32_t i_bcd)
+{
+    /* Each byte to binary at once */
+    uint32_t i_bin = ((i_bcd >> 4) & 0x0f0f0f) * 10 + (i_bcd & 0x0f0f0f);
+    return ((i_bin >> 16) & 0xff) * 3600 + ((i_bin >> 8) & 0xff) * 60 + (i_bin & 0xff);
+}
+
+/*****************************************************************************
+ * dvbpsi_bcd_from_seconds
+ *****************************************************************************/
+uint32_t dvbpsi_bcd_from_seconds(uint32_t i_seconds)
+{
+    if (i_seconds >= 100 * 3600)
+        return 0x995959;
+
+    uint32_t i_bin = ((i_seconds / 3600) << 16) | (((i_seconds / 60) % 60) << 8)
+                   | (i_seconds % 60);
+    /* Each byte to BCD at once, (x * 205) >> 11 being x / 10 below 100 */
+    uint32_t i_tens = (((i_bin & 0xff00ff) * 205) >> 11 & 0x0f000f)
+                    | ((((i_bin >> 8) & 0xff) * 205) >> 11 & 0x0f) << 8;
+    return (i_tens << 4) | (i_bin - i_tens * 10);
+}
+
+/*****************************************************************************
+ * dvbpsi_mjd_to_utc
+ *****************************************************************************/
+int64_t dvbpsi_mjd_to_utc(uint64_t i_time)
+{
+    if ((i_time & DVBPSI_MJD_UNDEFINED) == DVBPSI_MJD_UNDEFINED)
+        return INT64_MIN;
+
+    int64_t i_mjd = (i_time >> 24) & 0xffff;
+    return (i_mjd - DVBPSI_MJD_EPOCH) * 86400 + dvbpsi_bcd_to_seconds(i_time & 0xffffff);
+}
+
+/*****************************************************************************
+ * dvbpsi_mjd_from_utc
+ *****************************************************************************/
+uint64_t dvbpsi_mjd_from_utc(int64_t i_utc)
+{
+    int64_t i_days = i_utc / 86400;
+    int64_t i_seconds = i_utc % 86400;
+    if (i_seconds < 0)
+    {
+        i_days--;
+        i_seconds += 86400;
+    }
+
+    int64_t i_mjd = i_days + DVBPSI_MJD_EPOCH;
+    if (i_mjd < 0 || i_mjd > 0xffff)
+        return DVBPSI_MJD_UNDEFINED;
+    return ((uint64_t)i_mjd << 24) | dvbpsi_bcd_from_seconds((uint32_t)i_seconds);
+}
+
+/*****************************************************************************
+ * dvbpsi_mjd_to_date
+ *****************************************************************************/
+void dvbpsi_mjd_to_date(uint16_t i_mjd, int *pi_year, int *pi_month, int *pi_day,
+                        int *pi_weekday)
+{
+    assert(pi_year && pi_month && pi_day);
+
+    /* Days since 0000-03-01, year of its 400 years era and day of year */
+    uint32_t i_days = (uint32_t)i_mjd - DVBPSI_MJD_EPOCH + DVBPSI_MJD_CIVIL_EPOCH;
+    uint32_t i_era = i_days / DVBPSI_MJD_ERA_DAYS;
+    uint32_t i_doe = i_days - i_era * DVBPSI_MJD_ERA_DAYS;
+    uint32_t i_yoe = (i_doe - i_doe / 1460 + i_doe / 36524 - i_doe / 146096) / 365;
+    uint32_t i_doy = i_doe - (365 * i_yoe + i_yoe / 4 - i_yoe / 100);
+
+    /* No month is shorter than 30 days: i_doy / 31 is the month or the one
+       before */
+    uint32_t i_mp = i_doy / 31;
+    i_mp += i_doy >= pi_month_start[i_mp + 1];
+
+    int i_month = i_mp < 10 ? (int)i_mp + 3 : (int)i_mp - 9;
+    *pi_year = (int)(i_yoe + i_era * 400) + (i_month <= 2);
+    *pi_month = i_month;
+    *pi_day = (int)(i_doy - pi_month_start[i_mp]) + 1;
+    if (pi_weekday)
+        *pi_weekday = (i_mjd + 2) % 7 + 1;
+}
+
+/*****************************************************************************
+ * dvbpsi_mjd_from_date
+ *****************************************************************************/
+int32_t dvbpsi_mjd_from_date(int i_year, int i_month, int i_day)
+{
+    if (i_month < 1 || i_month > 12)
+        return -1;
+
+    int64_t i_y = (int64_t)i_year - (i_month <= 2);
+    int64_t i_era = (i_y >= 0 ? i_y : i_y - 399) / 400;
+    int64_t i_yoe = i_y - i_era * 400;
+    int i_mp = i_month > 2 ? i_month - 3 : i_month + 9;
+    int64_t i_doe = i_yoe * 365 + i_yoe / 4 - i_yoe / 100 + pi_month_start[i_mp] + i_day - 1;
+
+    return (int32_t)(i_era * DVBPSI_MJD_ERA_DAYS + i_doe - DVBPSI_MJD_CIVIL_EPOCH
+                     + DVBPSI_MJD_EPOCH);
+}
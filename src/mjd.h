@@ -0,0 +1,146 @@
+/*****************************************************************************
+ * mjd.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <mjd.h>
+ * \brief MJD and BCD time conversions.
+ *
+ * The DVB SI code dates as 16 bits of Modified Julian Date followed by 24
+ * bits of hours, minutes and seconds in BCD, as the start_time of the EIT
+ * events, the UTC_time of the TDT and TOT and the time_of_change of the
+ * local_time_offset_descriptor, and durations and time offsets in BCD
+ * only. These conversions decode the BCD digits of a field together,
+ * without a branch, and dates from a table of the first day of each month.
+ */
+
+#ifndef _DVBPSI_MJD_H_
+#define _DVBPSI_MJD_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \def DVBPSI_MJD_UNDEFINED
+ * \brief MJD and BCD time with all its bits set, an undefined start_time.
+ */
+#define DVBPSI_MJD_UNDEFINED UINT64_C(0xffffffffff)
+
+/*****************************************************************************
+ * dvbpsi_bcd_valid
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_bcd_valid(uint32_t i_bcd)
+ * \brief Checks that 24 bits of BCD only have decimal digits
+ * \param i_bcd 6 BCD digits
+ * \return true if no digit is above 9, false otherwise.
+ */
+bool dvbpsi_bcd_valid(uint32_t i_bcd);
+
+/*****************************************************************************
+ * dvbpsi_bcd_to_seconds
+ *****************************************************************************/
+/*!
+ * \fn uint32_t dvbpsi_bcd_to_seconds(uint32_t i_bcd)
+ * \brief Converts 24 bits of BCD hours, minutes and seconds to seconds
+ * \param i_bcd hours, minutes and seconds in BCD, for instance the
+ *        duration of an EIT event, or a local_time_offset shifted by 8 bits
+ * \return the number of seconds, meaningless if i_bcd is not valid BCD.
+ */
+uint32_t dvbpsi_bcd_to_seconds(uint32_t i_bcd);
+
+/*****************************************************************************
+ * dvbpsi_bcd_from_seconds
+ *****************************************************************************/
+/*!
+ * \fn uint32_t dvbpsi_bcd_from_seconds(uint32_t i_seconds)
+ * \brief Converts seconds to 24 bits of BCD hours, minutes and seconds
+ * \param i_seconds number of seconds
+ * \return the BCD time, 0x995959 beyond 99:59:59.
+ */
+uint32_t dvbpsi_bcd_from_seconds(uint32_t i_seconds);
+
+/*****************************************************************************
+ * dvbpsi_mjd_to_utc
+ *****************************************************************************/
+/*!
+ * \fn int64_t dvbpsi_mjd_to_utc(uint64_t i_time)
+ * \brief Converts 16 bits of MJD and 24 bits of BCD time to seconds since
+ * 1970-01-01 UTC
+ * \param i_time MJD and BCD time in the 40 low bits, as the start_time of
+ *        dvbpsi_eit_event_t
+ * \return the time, or INT64_MIN for DVBPSI_MJD_UNDEFINED.
+ */
+int64_t dvbpsi_mjd_to_utc(uint64_t i_time);
+
+/*****************************************************************************
+ * dvbpsi_mjd_from_utc
+ *****************************************************************************/
+/*!
+ * \fn uint64_t dvbpsi_mjd_from_utc(int64_t i_utc)
+ * \brief Converts seconds since 1970-01-01 UTC to 16 bits of MJD and 24 bits
+ * of BCD time
+ * \param i_utc seconds since 1970-01-01 UTC
+ * \return the MJD and BCD time, or DVBPSI_MJD_UNDEFINED if the date is
+ *         out of the 16 bits of MJD, 1858-11-17 to 2038-04-22.
+ */
+uint64_t dvbpsi_mjd_from_utc(int64_t i_utc);
+
+/*****************************************************************************
+ * dvbpsi_mjd_to_date
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_mjd_to_date(uint16_t i_mjd, int *pi_year, int *pi_month,
+ *                             int *pi_day, int *pi_weekday)
+ * \brief Converts a Modified Julian Date to a Gregorian date
+ * \param i_mjd MJD, the 16 high bits of an MJD and BCD time
+ * \param pi_year filled with the year
+ * \param pi_month filled with the month, 1 to 12
+ * \param pi_day filled with the day of the month, 1 to 31
+ * \param pi_weekday filled with the day of the week, 1 for Monday to 7 for
+ *        Sunday as in ETSI EN 300 468 annex C, unless NULL
+ * \return nothing
+ */
+void dvbpsi_mjd_to_date(uint16_t i_mjd, int *pi_year, int *pi_month, int *pi_day,
+                        int *pi_weekday);
+
+/*****************************************************************************
+ * dvbpsi_mjd_from_date
+ *****************************************************************************/
+/*!
+ * \fn int32_t dvbpsi_mjd_from_date(int i_year, int i_month, int i_day)
+ * \brief Converts a Gregorian date to a Modified Julian Date
+ * \param i_year year
+ * \param i_month month, 1 to 12
+ * \param i_day day of the month, 1 to 31
+ * \return the MJD, which only fits in 16 bits from 1858-11-17 to
+ *         2038-04-22, or -1 if the month is invalid.
+ */
+int32_t dvbpsi_mjd_from_date(int i_year, int i_month, int i_day);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of mjd.h"
+#endif
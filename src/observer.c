@@ -0,0 +1,460 @@
+/*****************************************************************************
+ * observer.c: change detection of any table without decoding
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+
+#include "dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_DECODER
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "demux.h"
+#include "crc32_private.h"
+#include "observer.h"
+
+/*****************************************************************************
+ * dvbpsi_observer_s
+ *****************************************************************************/
+struct dvbpsi_observer_s
+{
+    dvbpsi_observer_callback    pf_callback;
+    void *                      p_cb_data;
+
+    uint64_t                    i_subtables;
+    uint64_t                    i_changes;
+};
+
+/*****************************************************************************
+ * dvbpsi_observer_pid_t
+ *****************************************************************************
+ * New subtable callback data of the demux of dvbpsi_observer_attach().
+ *****************************************************************************/
+typedef struct dvbpsi_observer_pid_s
+{
+    dvbpsi_observer_t *         p_observer;
+    uint16_t                    i_pid;
+} dvbpsi_observer_pid_t;
+
+/*****************************************************************************
+ * dvbpsi_observer_decoder_t
+ *****************************************************************************
+ * Subtable decoder keeping the CRC_32 of the sections of the table being
+ * received, and of the last complete one.
+ *****************************************************************************/
+typedef struct dvbpsi_observer_decoder_s
+{
+    DVBPSI_DECODER_COMMON
+
+    dvbpsi_observer_t *         p_observer;
+
+    /* Last complete table */
+    bool                        b_complete;
+    dvbpsi_observer_subtable_t  subtable;
+    uint32_t *                  pi_complete_crc;
+
+    /* Table being received */
+    uint8_t                     i_version;
+    uint8_t                     i_last_number;
+    unsigned int                i_received;
+    uint8_t                     pi_received[256 / 8];
+    uint32_t *                  pi_crc;     /* i_last_number + 1 entries */
+} dvbpsi_observer_decoder_t;
+
+/*****************************************************************************
+ * dvbpsi_observer_new
+ *****************************************************************************/
+dvbpsi_observer_t *dvbpsi_observer_new(dvbpsi_observer_callback pf_callback,
+                                       void *p_cb_data)
+{
+    dvbpsi_observer_t *p_observer = dvbpsi_calloc(1, sizeof(dvbpsi_observer_t));
+    if (p_observer == NULL)
+        return NULL;
+
+    p_observer->pf_callback = pf_callback;
+    p_observer->p_cb_data = p_cb_data;
+    return p_observer;
+}
+
+/*****************************************************************************
+ * dvbpsi_observer_delete
+ *****************************************************************************/
+void dvbpsi_observer_delete(dvbpsi_observer_t *p_observer)
+{
+    dvbpsi_free(p_observer);
+}
+
+/*****************************************************************************
+ * dvbpsi_observer_complete
+ *****************************************************************************
+ * All the sections of the table being received are there: reports it if it
+ * differs from the last complete table, and lets the handle drop the
+ * repeated sections early.
+ *****************************************************************************/
+static void dvbpsi_observer_complete(dvbpsi_t *p_dvbpsi,
+                                     dvbpsi_observer_decoder_t *p_decoder,
+                                     int64_t i_time)
+{
+    size_t i_sections = (size_t)p_decoder->i_last_number + 1;
+    uint32_t i_crc = 0xffffffff;
+    for (size_t i = 0; i < i_sections; i++)
+    {
+        uint8_t p_bytes[4] = { p_decoder->pi_crc[i] >> 24, p_decoder->pi_crc[i] >> 16,
+                               p_decoder->pi_crc[i] >> 8, p_decoder->pi_crc[i] };
+        i_crc = dvbpsi_crc32(i_crc, p_bytes, 4);
+    }
+
+    dvbpsi_observer_subtable_t *p_subtable = &p_decoder->subtable;
+    dvbpsi_observer_change_t i_change;
+    if (!p_decoder->b_complete)
+        i_change = DVBPSI_OBSERVER_NEW;
+    else if (p_subtable->i_version != p_decoder->i_version)
+        i_change = DVBPSI_OBSERVER_VERSION;
+    else if (p_subtable->i_crc != i_crc
+             || p_subtable->i_last_section_number != p_decoder->i_last_number)
+        i_change = DVBPSI_OBSERVER_CONTENT;
+    else
+        return;
+
+    /* Keep the sections of the new table */
+    if (!p_decoder->b_complete
+        || p_subtable->i_last_section_number != p_decoder->i_last_number)
+    {
+        uint32_t *pi_complete_crc = dvbpsi_malloc(i_sections * sizeof(uint32_t));
+        if (pi_complete_crc == NULL)
+            return;
+        dvbpsi_free(p_decoder->pi_complete_crc);
+        p_decoder->pi_complete_crc = pi_complete_crc;
+    }
+    memcpy(p_decoder->pi_complete_crc, p_decoder->pi_crc, i_sections * sizeof(uint32_t));
+
+    p_decoder->b_complete = true;
+    p_subtable->i_version = p_decoder->i_version;
+    p_subtable->i_last_section_number = p_decoder->i_last_number;
+    p_subtable->i_crc = i_crc;
+    p_subtable->i_changes++;
+
+    /* Sections of this version are dropped by DVBPSI_FLAG_SKIP_UNCHANGED */
+    p_decoder->b_current_valid = true;
+    p_decoder->b_known = true;
+    p_decoder->i_known_table_id = p_subtable->i_table_id;
+    p_decoder->i_known_extension = p_subtable->i_extension;
+    p_decoder->i_known_version = p_decoder->i_version;
+    p_decoder->b_known_current_next = true;
+    p_decoder->i_known_skipped = 0;
+
+    /* and the identical ones by DVBPSI_FLAG_CRC_CACHE */
+    dvbpsi_crc_cache_t *p_cache = p_decoder->p_crc_cache;
+    if (p_cache)
+    {
+        memset(p_cache->pi_valid, 0, sizeof(p_cache->pi_valid));
+        for (size_t i = 0; i < i_sections; i++)
+        {
+            p_cache->pi_crc[i] = p_decoder->pi_crc[i];
+            p_cache->pi_valid[i >> 3] |= 1 << (i & 7);
+        }
+    }
+
+    p_dvbpsi->stats.i_tables++;
+    dvbpsi_observer_t *p_observer = p_decoder->p_observer;
+    p_observer->i_changes++;
+    if (p_observer->pf_callback)
+    {
+        dvbpsi_observer_event_t event;
+        event.i_change = i_change;
+        event.i_time = i_time;
+        event.subtable = *p_subtable;
+        p_observer->pf_callback(p_observer->p_cb_data, &event);
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_observer_gather
+ *****************************************************************************
+ * Records the CRC_32 of a section, which is not decoded.
+ *****************************************************************************/
+static void dvbpsi_observer_gather(dvbpsi_t *p_dvbpsi,
+                                   dvbpsi_decoder_t *p_private_decoder,
+                                   dvbpsi_psi_section_t *p_section)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    dvbpsi_demux_t *p_demux = (dvbpsi_demux_t *)p_dvbpsi->p_decoder;
+    dvbpsi_observer_decoder_t *p_decoder = (dvbpsi_observer_decoder_t *)p_private_decoder;
+
+    /* Nothing to resynchronize, each section being checked on its own */
+    p_demux->b_discontinuity = false;
+    p_decoder->b_discontinuity = false;
+
+    if (!p_section->b_syntax_indicator || !p_section->b_current_next
+        || p_section->i_number > p_section->i_last_number)
+    {
+        dvbpsi_DeletePSISections(p_section);
+        return;
+    }
+
+    if (p_decoder->pi_crc == NULL
+        || p_decoder->i_version != p_section->i_version
+        || p_decoder->i_last_number != p_section->i_last_number)
+    {
+        /* Another table begins */
+        if (p_decoder->pi_crc == NULL
+            || p_decoder->i_last_number != p_section->i_last_number)
+        {
+            uint32_t *pi_crc = dvbpsi_malloc(((size_t)p_section->i_last_number + 1)
+                                             * sizeof(uint32_t));
+            if (pi_crc == NULL)
+            {
+                dvbpsi_DeletePSISections(p_section);
+                return;
+            }
+            dvbpsi_free(p_decoder->pi_crc);
+            p_decoder->pi_crc = pi_crc;
+        }
+        p_decoder->i_version = p_section->i_version;
+        p_decoder->i_last_number = p_section->i_last_number;
+        p_decoder->i_received = 0;
+        memset(p_decoder->pi_received, 0, sizeof(p_decoder->pi_received));
+    }
+
+    const uint8_t *p_crc = p_section->p_payload_end;
+    uint32_t i_crc = ((uint32_t)p_crc[0] << 24) | ((uint32_t)p_crc[1] << 16)
+                   | ((uint32_t)p_crc[2] << 8) | p_crc[3];
+    uint8_t i_number = p_section->i_number;
+    uint8_t i_bit = 1 << (i_number & 7);
+    int64_t i_time = p_section->i_arrival;
+    dvbpsi_DeletePSISections(p_section);
+
+    if (p_decoder->pi_received[i_number >> 3] & i_bit)
+    {
+        if (p_decoder->pi_crc[i_number] == i_crc)
+        {
+            p_dvbpsi->stats.i_dropped_duplicate++;
+            return;
+        }
+    }
+    else
+    {
+        p_decoder->pi_received[i_number >> 3] |= i_bit;
+        p_decoder->i_received++;
+    }
+    p_decoder->pi_crc[i_number] = i_crc;
+
+    if (p_decoder->i_received == (unsigned int)p_decoder->i_last_number + 1)
+        dvbpsi_observer_complete(p_dvbpsi, p_decoder, i_time);
+}
+
+/*****************************************************************************
+ * dvbpsi_observer_demux_attach
+ *****************************************************************************/
+bool dvbpsi_observer_demux_attach(dvbpsi_observer_t *p_observer,
+                                  dvbpsi_t *p_dvbpsi, uint16_t i_pid,
+                                  uint8_t i_table_id, uint16_t i_extension)
+{
+    assert(p_observer);
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    dvbpsi_demux_t *p_demux = (dvbpsi_demux_t *)p_dvbpsi->p_decoder;
+
+    if (dvbpsi_demuxGetSubDec(p_demux, i_table_id, i_extension))
+    {
+        dvbpsi_error(p_dvbpsi, "Observer",
+                     "Already a decoder for (table_id == 0x%02x,"
+                     "extension == 0x%02x)",
+                     i_table_id, i_extension);
+        return false;
+    }
+
+    dvbpsi_observer_decoder_t *p_decoder;
+    p_decoder = (dvbpsi_observer_decoder_t *) dvbpsi_decoder_new(NULL,
+                                        0, true, sizeof(dvbpsi_observer_decoder_t));
+    if (p_decoder == NULL)
+        return false;
+
+    dvbpsi_demux_subdec_t *p_subdec;
+    p_subdec = dvbpsi_NewDemuxSubDecoder(i_table_id, i_extension,
+                                         dvbpsi_observer_demux_detach,
+                                         dvbpsi_observer_gather,
+                                         DVBPSI_DECODER(p_decoder));
+    if (p_subdec == NULL)
+    {
+        dvbpsi_decoder_delete(DVBPSI_DECODER(p_decoder));
+        return false;
+    }
+
+    dvbpsi_AttachDemuxSubDecoder(p_demux, p_subdec);
+
+    p_decoder->p_observer = p_observer;
+    p_decoder->b_complete = false;
+    memset(&p_decoder->subtable, 0, sizeof(p_decoder->subtable));
+    p_decoder->subtable.i_pid = i_pid;
+    p_decoder->subtable.i_table_id = i_table_id;
+    p_decoder->subtable.i_extension = i_extension;
+    p_decoder->pi_complete_crc = NULL;
+    p_decoder->pi_crc = NULL;
+    p_decoder->i_received = 0;
+
+    p_observer->i_subtables++;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_observer_demux_detach
+ *****************************************************************************/
+void dvbpsi_observer_demux_detach(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                                  uint16_t i_extension)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    dvbpsi_demux_t *p_demux = (dvbpsi_demux_t *)p_dvbpsi->p_decoder;
+
+    dvbpsi_demux_subdec_t *p_subdec;
+    p_subdec = dvbpsi_demuxGetSubDec(p_demux, i_table_id, i_extension);
+    if (p_subdec == NULL || p_subdec->pf_gather != dvbpsi_observer_gather)
+    {
+        dvbpsi_error(p_dvbpsi, "Observer",
+                     "No such observed subtable (table_id == 0x%02x,"
+                     "extension == 0x%02x)",
+                     i_table_id, i_extension);
+        return;
+    }
+
+    dvbpsi_observer_decoder_t *p_decoder = (dvbpsi_observer_decoder_t *)p_subdec->p_decoder;
+    p_decoder->p_observer->i_subtables--;
+    dvbpsi_free(p_decoder->pi_complete_crc);
+    dvbpsi_free(p_decoder->pi_crc);
+
+    dvbpsi_DetachDemuxSubDecoder(p_demux, p_subdec);
+    dvbpsi_DeleteDemuxSubDecoder(p_subdec);
+}
+
+/*****************************************************************************
+ * dvbpsi_observer_new_subtable
+ *****************************************************************************
+ * New subtable callback of the demux of dvbpsi_observer_attach().
+ *****************************************************************************/
+static void dvbpsi_observer_new_subtable(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                                         uint16_t i_extension, void *p_cb_data)
+{
+    dvbpsi_observer_pid_t *p_pid = (dvbpsi_observer_pid_t *)p_cb_data;
+    dvbpsi_observer_demux_attach(p_pid->p_observer, p_dvbpsi, p_pid->i_pid,
+                                 i_table_id, i_extension);
+}
+
+/*****************************************************************************
+ * dvbpsi_observer_attach
+ *****************************************************************************/
+bool dvbpsi_observer_attach(dvbpsi_observer_t *p_observer, dvbpsi_t *p_dvbpsi,
+                            uint16_t i_pid)
+{
+    assert(p_observer);
+    assert(p_dvbpsi);
+
+    dvbpsi_observer_pid_t *p_pid = dvbpsi_malloc(sizeof(dvbpsi_observer_pid_t));
+    if (p_pid == NULL)
+        return false;
+    p_pid->p_observer = p_observer;
+    p_pid->i_pid = i_pid;
+
+    if (!dvbpsi_AttachDemux(p_dvbpsi, dvbpsi_observer_new_subtable, p_pid))
+    {
+        dvbpsi_free(p_pid);
+        return false;
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_observer_detach
+ *****************************************************************************/
+void dvbpsi_observer_detach(dvbpsi_t *p_dvbpsi)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    dvbpsi_demux_t *p_demux = (dvbpsi_demux_t *)p_dvbpsi->p_decoder;
+    assert(p_demux->pf_new_callback == dvbpsi_observer_new_subtable);
+
+    void *p_pid = p_demux->p_new_cb_data;
+    dvbpsi_DetachDemux(p_dvbpsi);
+    dvbpsi_free(p_pid);
+}
+
+/*****************************************************************************
+ * dvbpsi_observer_get
+ *****************************************************************************/
+bool dvbpsi_observer_get(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                         uint16_t i_extension,
+                         dvbpsi_observer_subtable_t *p_subtable, uint32_t *pi_crc)
+{
+    assert(p_dvbpsi);
+    assert(p_subtable);
+
+    if (p_dvbpsi->p_decoder == NULL || p_dvbpsi->p_decoder->pf_gather != dvbpsi_Demux)
+        return false;
+
+    dvbpsi_demux_subdec_t *p_subdec;
+    p_subdec = dvbpsi_demuxGetSubDec((dvbpsi_demux_t *)p_dvbpsi->p_decoder,
+                                     i_table_id, i_extension);
+    if (p_subdec == NULL || p_subdec->pf_gather != dvbpsi_observer_gather)
+        return false;
+
+    dvbpsi_observer_decoder_t *p_decoder = (dvbpsi_observer_decoder_t *)p_subdec->p_decoder;
+    if (!p_decoder->b_complete)
+        return false;
+
+    *p_subtable = p_decoder->subtable;
+    if (pi_crc)
+        memcpy(pi_crc, p_decoder->pi_complete_crc,
+               ((size_t)p_subtable->i_last_section_number + 1) * sizeof(uint32_t));
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_observer_count
+ *****************************************************************************/
+void dvbpsi_observer_count(const dvbpsi_observer_t *p_observer,
+                           uint64_t *pi_subtables, uint64_t *pi_changes)
+{
+    assert(p_observer);
+
+    if (pi_subtables)
+        *pi_subtables = p_observer->i_subtables;
+    if (pi_changes)
+        *pi_changes = p_observer->i_changes;
+}
@@ -0,0 +1,267 @@
+/*****************************************************************************
+ * observer.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <observer.h>
+ * \brief Version observer: change detection of any table without decoding.
+ *
+ * An observer follows the subtables of PIDs from their section headers and
+ * CRC_32 alone: for each table_id and table_id_extension it keeps the
+ * version_number, last_section_number and CRC_32 of every section of the
+ * current table, and reports when a complete table differs from the last
+ * one. No table is decoded. The subtable decoders of an observer are
+ * ordinary demux subtable decoders, so DVBPSI_FLAG_SKIP_UNCHANGED and
+ * DVBPSI_FLAG_CRC_CACHE drop the repeated sections before they are copied
+ * or CRC checked, and dvbpsi_set_section_filter() restricts the subtables
+ * followed.
+ *
+ * Only the sections with the section_syntax_indicator and the
+ * current_next_indicator set are followed. With DVBPSI_FLAG_SKIP_UNCHANGED
+ * a change of content without a new version is only seen when a section is
+ * verified, see dvbpsi_set_verify_interval().
+ */
+
+#ifndef _DVBPSI_OBSERVER_H_
+#define _DVBPSI_OBSERVER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_observer_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_observer_s dvbpsi_observer_t
+ * \brief dvbpsi_observer_t type definition, an opaque observer.
+ */
+typedef struct dvbpsi_observer_s dvbpsi_observer_t;
+
+/*****************************************************************************
+ * dvbpsi_observer_change_t
+ *****************************************************************************/
+/*!
+ * \enum dvbpsi_observer_change
+ * \brief Changes reported by an observer
+ */
+enum dvbpsi_observer_change
+{
+    DVBPSI_OBSERVER_NEW = 0,    /*!< first complete table of a subtable */
+    DVBPSI_OBSERVER_VERSION,    /*!< complete table of another
+                                     version_number */
+    DVBPSI_OBSERVER_CONTENT,    /*!< same version_number, but other
+                                     sections */
+};
+/*!
+ * \typedef enum dvbpsi_observer_change dvbpsi_observer_change_t
+ * \brief dvbpsi_observer_change_t type definition.
+ */
+typedef enum dvbpsi_observer_change dvbpsi_observer_change_t;
+
+/*****************************************************************************
+ * dvbpsi_observer_subtable_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_observer_subtable_s
+ * \brief Last complete table of a subtable, see dvbpsi_observer_get()
+ */
+/*!
+ * \typedef struct dvbpsi_observer_subtable_s dvbpsi_observer_subtable_t
+ * \brief dvbpsi_observer_subtable_t type definition.
+ */
+typedef struct dvbpsi_observer_subtable_s
+{
+    uint16_t i_pid;                 /*!< PID given to the attach function */
+    uint8_t  i_table_id;            /*!< table_id */
+    uint16_t i_extension;           /*!< table_id_extension */
+    uint8_t  i_version;             /*!< version_number */
+    uint8_t  i_last_section_number; /*!< last_section_number */
+    uint32_t i_crc;                 /*!< CRC_32 of the CRC_32 of the
+                                         sections, in section order, each
+                                         as 4 bytes */
+    uint64_t i_changes;             /*!< changes reported */
+} dvbpsi_observer_subtable_t;
+
+/*****************************************************************************
+ * dvbpsi_observer_event_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_observer_event_s
+ * \brief Change of a subtable, only valid during the callback.
+ */
+/*!
+ * \typedef struct dvbpsi_observer_event_s dvbpsi_observer_event_t
+ * \brief dvbpsi_observer_event_t type definition.
+ */
+typedef struct dvbpsi_observer_event_s
+{
+    dvbpsi_observer_change_t    i_change;   /*!< change */
+    int64_t                     i_time;     /*!< arrival time of the section
+                                                 completing the table, or
+                                                 DVBPSI_TIME_NONE */
+    dvbpsi_observer_subtable_t  subtable;   /*!< the new table */
+} dvbpsi_observer_event_t;
+
+/*****************************************************************************
+ * dvbpsi_observer_callback
+ *****************************************************************************/
+/*!
+ * \typedef void (* dvbpsi_observer_callback)(void *p_cb_data,
+ *                                   const dvbpsi_observer_event_t *p_event)
+ * \brief Callback type definition, called for each change.
+ */
+typedef void (* dvbpsi_observer_callback)(void *p_cb_data,
+                                          const dvbpsi_observer_event_t *p_event);
+
+/*****************************************************************************
+ * dvbpsi_observer_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_observer_t *dvbpsi_observer_new(dvbpsi_observer_callback pf_callback,
+ *                                            void *p_cb_data)
+ * \brief Creates an observer
+ * \param pf_callback function called for each change, or NULL
+ * \param p_cb_data private data given in argument to the callback
+ * \return pointer to the observer, or NULL on error
+ *
+ * An observer can be attached to many handles used from the same thread,
+ * one per PID, and must outlive them.
+ */
+dvbpsi_observer_t *dvbpsi_observer_new(dvbpsi_observer_callback pf_callback,
+                                       void *p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_observer_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_observer_delete(dvbpsi_observer_t *p_observer)
+ * \brief Deletes an observer, once detached from all the handles
+ * \param p_observer pointer to the observer
+ * \return nothing
+ */
+void dvbpsi_observer_delete(dvbpsi_observer_t *p_observer);
+
+/*****************************************************************************
+ * dvbpsi_observer_attach
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_observer_attach(dvbpsi_observer_t *p_observer,
+ *                                 dvbpsi_t *p_dvbpsi, uint16_t i_pid)
+ * \brief Attaches a demux observing all the subtables of a PID
+ * \param p_observer pointer to the observer
+ * \param p_dvbpsi handle without decoder, given the TS packets of the PID
+ * \param i_pid PID, reported in the events
+ * \return false on error
+ */
+bool dvbpsi_observer_attach(dvbpsi_observer_t *p_observer, dvbpsi_t *p_dvbpsi,
+                            uint16_t i_pid);
+
+/*****************************************************************************
+ * dvbpsi_observer_detach
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_observer_detach(dvbpsi_t *p_dvbpsi)
+ * \brief Detaches the demux of dvbpsi_observer_attach()
+ * \param p_dvbpsi handle
+ * \return nothing
+ */
+void dvbpsi_observer_detach(dvbpsi_t *p_dvbpsi);
+
+/*****************************************************************************
+ * dvbpsi_observer_demux_attach
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_observer_demux_attach(dvbpsi_observer_t *p_observer,
+ *                                       dvbpsi_t *p_dvbpsi, uint16_t i_pid,
+ *                                       uint8_t i_table_id,
+ *                                       uint16_t i_extension)
+ * \brief Observes one subtable of a demux, typically from its new subtable
+ *        callback for the subtables the application does not decode
+ * \param p_observer pointer to the observer
+ * \param p_dvbpsi handle with a demux
+ * \param i_pid PID, reported in the events
+ * \param i_table_id table_id
+ * \param i_extension table_id_extension
+ * \return false if the subtable already has a decoder, or on error
+ */
+bool dvbpsi_observer_demux_attach(dvbpsi_observer_t *p_observer,
+                                  dvbpsi_t *p_dvbpsi, uint16_t i_pid,
+                                  uint8_t i_table_id, uint16_t i_extension);
+
+/*****************************************************************************
+ * dvbpsi_observer_demux_detach
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_observer_demux_detach(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+ *                                       uint16_t i_extension)
+ * \brief Stops observing a subtable of a demux
+ * \param p_dvbpsi handle with a demux
+ * \param i_table_id table_id
+ * \param i_extension table_id_extension
+ * \return nothing
+ */
+void dvbpsi_observer_demux_detach(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                                  uint16_t i_extension);
+
+/*****************************************************************************
+ * dvbpsi_observer_get
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_observer_get(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+ *                              uint16_t i_extension,
+ *                              dvbpsi_observer_subtable_t *p_subtable,
+ *                              uint32_t *pi_crc)
+ * \brief Gives the last complete table of an observed subtable
+ * \param p_dvbpsi handle with a demux
+ * \param i_table_id table_id
+ * \param i_extension table_id_extension
+ * \param p_subtable filled with the table
+ * \param pi_crc NULL, or array of 256 entries filled with the CRC_32 of the
+ *        sections up to last_section_number
+ * \return false if the subtable is not observed or no table is complete yet
+ */
+bool dvbpsi_observer_get(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                         uint16_t i_extension,
+                         dvbpsi_observer_subtable_t *p_subtable, uint32_t *pi_crc);
+
+/*****************************************************************************
+ * dvbpsi_observer_count
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_observer_count(const dvbpsi_observer_t *p_observer,
+ *                                uint64_t *pi_subtables, uint64_t *pi_changes)
+ * \brief Gives the activity of an observer
+ * \param p_observer pointer to the observer
+ * \param pi_subtables NULL, or filled with the number of subtables observed
+ * \param pi_changes NULL, or filled with the number of changes reported
+ * \return nothing
+ */
+void dvbpsi_observer_count(const dvbpsi_observer_t *p_observer,
+                           uint64_t *pi_subtables, uint64_t *pi_changes);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of observer.h"
+#endif
@@ -0,0 +1,396 @@
+/*****************************************************************************
+ * packetizer.c: section packetizer
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "packetizer.h"
+
+#define DVBPSI_PACKETIZER_PIDS 8192
+
+/* The producer and the consumer of the ring may be distinct threads */
+#ifdef __ATOMIC_ACQUIRE
+#   define PACKETIZER_LOAD(x)       __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#   define PACKETIZER_STORE(x, v)   __atomic_store_n(&(x), v, __ATOMIC_RELEASE)
+#else
+#   define PACKETIZER_LOAD(x)       (x)
+#   define PACKETIZER_STORE(x, v)   ((x) = (v))
+#endif
+
+/*****************************************************************************
+ * dvbpsi_packetizer_pid_t
+ *****************************************************************************
+ * State of a PID, with its open packet if any.
+ *****************************************************************************/
+typedef struct dvbpsi_packetizer_pid_s
+{
+    uint16_t i_pid;
+    uint8_t  i_continuity_counter;          /* of the next packet */
+
+    uint8_t *p_packet;                      /* open packet or NULL */
+    size_t   i_filled;                      /* bytes of the open packet */
+    uint8_t  p_staging[188];                /* open packet kept for later */
+
+    struct dvbpsi_packetizer_pid_s *p_next; /* in first push order */
+} dvbpsi_packetizer_pid_t;
+
+/*****************************************************************************
+ * dvbpsi_packetizer_s
+ *****************************************************************************/
+struct dvbpsi_packetizer_s
+{
+    uint8_t *p_ring;                        /* packets of the caller */
+    size_t   i_packets;                     /* size of the ring */
+    /* Positions modulo twice the size of the ring, so that a full ring is
+     * told from an empty one. Each is only written by one side. */
+    size_t   i_write;                       /* next packet to write */
+    size_t   i_read;                        /* oldest packet not consumed */
+
+    dvbpsi_packetizer_stuffing_t i_stuffing;
+
+    dvbpsi_packetizer_pid_t *pp_pids[DVBPSI_PACKETIZER_PIDS];
+    dvbpsi_packetizer_pid_t *p_first_pid;
+    dvbpsi_packetizer_pid_t *p_last_pid;
+};
+
+/*****************************************************************************
+ * dvbpsi_packetizer_new
+ *****************************************************************************/
+dvbpsi_packetizer_t *dvbpsi_packetizer_new(uint8_t *p_ring, size_t i_packets)
+{
+    assert(p_ring);
+    assert(i_packets > 0);
+
+    dvbpsi_packetizer_t *p_packetizer = dvbpsi_calloc(1, sizeof(dvbpsi_packetizer_t));
+    if (p_packetizer == NULL)
+        return NULL;
+
+    p_packetizer->p_ring = p_ring;
+    p_packetizer->i_packets = i_packets;
+    return p_packetizer;
+}
+
+/*****************************************************************************
+ * dvbpsi_packetizer_delete
+ *****************************************************************************/
+void dvbpsi_packetizer_delete(dvbpsi_packetizer_t *p_packetizer)
+{
+    if (p_packetizer == NULL)
+        return;
+
+    dvbpsi_packetizer_pid_t *p_pid = p_packetizer->p_first_pid;
+    while (p_pid)
+    {
+        dvbpsi_packetizer_pid_t *p_next = p_pid->p_next;
+        dvbpsi_free(p_pid);
+        p_pid = p_next;
+    }
+    dvbpsi_free(p_packetizer);
+}
+
+/*****************************************************************************
+ * dvbpsi_packetizer_set_stuffing
+ *****************************************************************************/
+void dvbpsi_packetizer_set_stuffing(dvbpsi_packetizer_t *p_packetizer,
+                                    dvbpsi_packetizer_stuffing_t i_stuffing)
+{
+    assert(p_packetizer);
+    p_packetizer->i_stuffing = i_stuffing;
+}
+
+/*****************************************************************************
+ * dvbpsi_packetizer_free
+ *****************************************************************************
+ * Number of free packets of the ring, for the producer.
+ *****************************************************************************/
+static size_t dvbpsi_packetizer_free(dvbpsi_packetizer_t *p_packetizer)
+{
+    size_t i_loop = 2 * p_packetizer->i_packets;
+    size_t i_count = (p_packetizer->i_write + i_loop
+                      - PACKETIZER_LOAD(p_packetizer->i_read)) % i_loop;
+    return p_packetizer->i_packets - i_count;
+}
+
+/*****************************************************************************
+ * dvbpsi_packetizer_slot
+ *****************************************************************************
+ * Next free packet of the ring.
+ *****************************************************************************/
+static uint8_t *dvbpsi_packetizer_slot(dvbpsi_packetizer_t *p_packetizer)
+{
+    assert(dvbpsi_packetizer_free(p_packetizer) > 0);
+    return p_packetizer->p_ring
+         + 188 * (p_packetizer->i_write % p_packetizer->i_packets);
+}
+
+/*****************************************************************************
+ * dvbpsi_packetizer_commit
+ *****************************************************************************
+ * Hands the next packet of the ring over to the consumer.
+ *****************************************************************************/
+static void dvbpsi_packetizer_commit(dvbpsi_packetizer_t *p_packetizer)
+{
+    PACKETIZER_STORE(p_packetizer->i_write,
+                     (p_packetizer->i_write + 1) % (2 * p_packetizer->i_packets));
+}
+
+/*****************************************************************************
+ * dvbpsi_packetizer_close
+ *****************************************************************************
+ * Stuffs the open packet of a PID and writes it to the ring.
+ *****************************************************************************/
+static void dvbpsi_packetizer_close(dvbpsi_packetizer_t *p_packetizer,
+                                    dvbpsi_packetizer_pid_t *p_pid)
+{
+    assert(p_pid->p_packet);
+
+    uint8_t *p_packet = p_pid->p_packet;
+    size_t i_payload = p_pid->i_filled - 4;
+    if (i_payload < 184 && p_packetizer->i_stuffing == DVBPSI_PACKETIZER_ADAPTATION)
+    {
+        /* adaptation_field_length, flags and stuffing_bytes before the
+         * payload */
+        size_t i_adaptation = 184 - i_payload;
+        memmove(p_packet + 4 + i_adaptation, p_packet + 4, i_payload);
+        p_packet[3] |= 0x20;
+        p_packet[4] = i_adaptation - 1;
+        if (i_adaptation > 1)
+        {
+            p_packet[5] = 0x00;
+            memset(p_packet + 6, 0xff, i_adaptation - 2);
+        }
+    }
+    else
+        memset(p_packet + p_pid->i_filled, 0xff, 188 - p_pid->i_filled);
+
+    if (p_packet == p_pid->p_staging)
+        memcpy(dvbpsi_packetizer_slot(p_packetizer), p_pid->p_staging, 188);
+    dvbpsi_packetizer_commit(p_packetizer);
+    p_pid->p_packet = NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_packetizer_open
+ *****************************************************************************
+ * Starts a packet of a PID. A packet that 'i_bytes' more bytes fill is
+ * built in place in the ring, others in the staging packet of the PID.
+ *****************************************************************************/
+static void dvbpsi_packetizer_open(dvbpsi_packetizer_t *p_packetizer,
+                                   dvbpsi_packetizer_pid_t *p_pid,
+                                   size_t i_bytes)
+{
+    uint8_t *p_packet = (i_bytes >= 184) ? dvbpsi_packetizer_slot(p_packetizer)
+                                         : p_pid->p_staging;
+    p_packet[0] = 0x47;
+    p_packet[1] = p_pid->i_pid >> 8;
+    p_packet[2] = p_pid->i_pid;
+    p_packet[3] = 0x10 | p_pid->i_continuity_counter; /* payload only */
+    p_pid->i_continuity_counter = (p_pid->i_continuity_counter + 1) & 0x0f;
+
+    p_pid->p_packet = p_packet;
+    p_pid->i_filled = 4;
+}
+
+/*****************************************************************************
+ * dvbpsi_packetizer_push
+ *****************************************************************************/
+bool dvbpsi_packetizer_push(dvbpsi_packetizer_t *p_packetizer, uint16_t i_pid,
+                            const dvbpsi_psi_section_t *p_section)
+{
+    assert(p_packetizer);
+
+    if (i_pid >= DVBPSI_PACKETIZER_PIDS)
+        return false;
+
+    /* Each section needs one more packet than its bytes and pointer_field
+     * fill at most, the open packet being only closed at the end */
+    size_t i_needed = 0;
+    for (const dvbpsi_psi_section_t *p = p_section; p; p = p->p_next)
+    {
+        size_t i_size = p->p_payload_end + (p->b_syntax_indicator ? 4 : 0) - p->p_data;
+        i_needed += (i_size + 1) / 184 + 1;
+    }
+    if (i_needed > dvbpsi_packetizer_free(p_packetizer))
+        return false;
+
+    dvbpsi_packetizer_pid_t *p_pid = p_packetizer->pp_pids[i_pid];
+    if (p_pid == NULL)
+    {
+        p_pid = dvbpsi_calloc(1, sizeof(dvbpsi_packetizer_pid_t));
+        if (p_pid == NULL)
+            return false;
+        p_pid->i_pid = i_pid;
+        dvbpsi_list_append(p_packetizer->p_first_pid, p_packetizer->p_last_pid, p_pid);
+        p_packetizer->pp_pids[i_pid] = p_pid;
+    }
+
+    for (; p_section; p_section = p_section->p_next)
+    {
+        const uint8_t *p_byte = p_section->p_data;
+        const uint8_t *p_end = p_section->p_payload_end
+                             + (p_section->b_syntax_indicator ? 4 : 0);
+        bool b_start = true;
+
+        while (p_byte < p_end)
+        {
+            if (p_pid->p_packet == NULL)
+                dvbpsi_packetizer_open(p_packetizer, p_pid,
+                                       (p_end - p_byte) + (b_start ? 1 : 0));
+
+            uint8_t *p_packet = p_pid->p_packet;
+            if (b_start)
+            {
+                /* pointer_field if missing and the section header */
+                bool b_unit_start = (p_packet[1] & 0x40) != 0;
+                if (188 - p_pid->i_filled < (b_unit_start ? 3 : 4))
+                {
+                    dvbpsi_packetizer_close(p_packetizer, p_pid);
+                    continue;
+                }
+                if (!b_unit_start)
+                {
+                    memmove(p_packet + 5, p_packet + 4, p_pid->i_filled - 4);
+                    p_packet[4] = p_pid->i_filled - 4;
+                    p_packet[1] |= 0x40;
+                    p_pid->i_filled++;
+                }
+                b_start = false;
+            }
+
+            size_t i_copy = 188 - p_pid->i_filled;
+            if (i_copy > (size_t)(p_end - p_byte))
+                i_copy = p_end - p_byte;
+            memcpy(p_packet + p_pid->i_filled, p_byte, i_copy);
+            p_pid->i_filled += i_copy;
+            p_byte += i_copy;
+
+            if (p_pid->i_filled == 188)
+                dvbpsi_packetizer_close(p_packetizer, p_pid);
+        }
+    }
+
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_packetizer_flush
+ *****************************************************************************/
+bool dvbpsi_packetizer_flush(dvbpsi_packetizer_t *p_packetizer)
+{
+    assert(p_packetizer);
+
+    size_t i_open = 0;
+    for (dvbpsi_packetizer_pid_t *p_pid = p_packetizer->p_first_pid; p_pid;
+         p_pid = p_pid->p_next)
+        if (p_pid->p_packet)
+            i_open++;
+
+    if (i_open > dvbpsi_packetizer_free(p_packetizer))
+        return false;
+
+    for (dvbpsi_packetizer_pid_t *p_pid = p_packetizer->p_first_pid; p_pid;
+         p_pid = p_pid->p_next)
+        if (p_pid->p_packet)
+            dvbpsi_packetizer_close(p_packetizer, p_pid);
+
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_packetizer_pad
+ *****************************************************************************/
+bool dvbpsi_packetizer_pad(dvbpsi_packetizer_t *p_packetizer,
+                           unsigned int i_align)
+{
+    assert(p_packetizer);
+    assert(i_align > 0);
+
+    size_t i_position = p_packetizer->i_write % p_packetizer->i_packets;
+    size_t i_nulls = (i_align - i_position % i_align) % i_align;
+    if (i_nulls > dvbpsi_packetizer_free(p_packetizer))
+        return false;
+
+    for (size_t i = 0; i < i_nulls; i++)
+    {
+        uint8_t *p_packet = dvbpsi_packetizer_slot(p_packetizer);
+        p_packet[0] = 0x47;
+        p_packet[1] = 0x1f;
+        p_packet[2] = 0xff;
+        p_packet[3] = 0x10;                 /* payload only */
+        memset(p_packet + 4, 0xff, 184);
+        dvbpsi_packetizer_commit(p_packetizer);
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_packetizer_peek
+ *****************************************************************************/
+size_t dvbpsi_packetizer_peek(dvbpsi_packetizer_t *p_packetizer,
+                              uint8_t **pp_packets)
+{
+    assert(p_packetizer);
+    assert(pp_packets);
+
+    size_t i_loop = 2 * p_packetizer->i_packets;
+    size_t i_read = p_packetizer->i_read % p_packetizer->i_packets;
+    size_t i_count = (PACKETIZER_LOAD(p_packetizer->i_write) + i_loop
+                      - p_packetizer->i_read) % i_loop;
+    if (i_count > p_packetizer->i_packets - i_read)
+        i_count = p_packetizer->i_packets - i_read;
+
+    *pp_packets = p_packetizer->p_ring + 188 * i_read;
+    return i_count;
+}
+
+/*****************************************************************************
+ * dvbpsi_packetizer_consume
+ *****************************************************************************/
+void dvbpsi_packetizer_consume(dvbpsi_packetizer_t *p_packetizer,
+                               size_t i_count)
+{
+    assert(p_packetizer);
+
+    size_t i_loop = 2 * p_packetizer->i_packets;
+    assert(i_count <= (PACKETIZER_LOAD(p_packetizer->i_write) + i_loop
+                       - p_packetizer->i_read) % i_loop);
+
+    PACKETIZER_STORE(p_packetizer->i_read,
+                     (p_packetizer->i_read + i_count) % i_loop);
+}
@@ -0,0 +1,211 @@
+/*****************************************************************************
+ * packetizer.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <packetizer.h>
+ * \brief Section packetizer.
+ *
+ * Turns PSI sections into TS packets written to a ring of packets owned by
+ * the caller. Successive sections of a PID are packed in the same packets
+ * with the pointer_field, and the continuity counter of each PID is kept
+ * from one call to the other, across table versions and tables sharing
+ * the PID.
+ *
+ * dvbpsi_packetizer_push(), dvbpsi_packetizer_flush() and
+ * dvbpsi_packetizer_pad() may be called from one thread while another
+ * one drains the ring with dvbpsi_packetizer_peek() and
+ * dvbpsi_packetizer_consume().
+ */
+
+#ifndef _DVBPSI_PACKETIZER_H_
+#define _DVBPSI_PACKETIZER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_packetizer_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_packetizer_s dvbpsi_packetizer_t
+ * \brief dvbpsi_packetizer_t type definition, an opaque section packetizer.
+ */
+typedef struct dvbpsi_packetizer_s dvbpsi_packetizer_t;
+
+/*****************************************************************************
+ * dvbpsi_packetizer_stuffing_t
+ *****************************************************************************/
+/*!
+ * \enum dvbpsi_packetizer_stuffing
+ * \brief Stuffing of the last packet of a PID, not filled by its sections
+ */
+enum dvbpsi_packetizer_stuffing
+{
+    DVBPSI_PACKETIZER_BYTES = 0,    /*!< 0xff bytes after the sections, the
+                                         default */
+    DVBPSI_PACKETIZER_ADAPTATION,   /*!< adaptation field stuffing before
+                                         the payload */
+};
+
+/*!
+ * \typedef enum dvbpsi_packetizer_stuffing dvbpsi_packetizer_stuffing_t
+ * \brief dvbpsi_packetizer_stuffing_t type definition.
+ */
+typedef enum dvbpsi_packetizer_stuffing dvbpsi_packetizer_stuffing_t;
+
+/*****************************************************************************
+ * dvbpsi_packetizer_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_packetizer_t *dvbpsi_packetizer_new(uint8_t *p_ring,
+ *                                                size_t i_packets)
+ * \brief Creates a section packetizer writing into a ring of TS packets
+ * \param p_ring buffer of 'i_packets' 188 bytes TS packets, which must
+ *        stay valid until the packetizer is deleted
+ * \param i_packets number of packets of the ring
+ * \return pointer to the packetizer, or NULL on error
+ */
+dvbpsi_packetizer_t *dvbpsi_packetizer_new(uint8_t *p_ring, size_t i_packets);
+
+/*****************************************************************************
+ * dvbpsi_packetizer_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_packetizer_delete(dvbpsi_packetizer_t *p_packetizer)
+ * \brief Deletes a section packetizer. Packets not yet flushed are lost.
+ * \param p_packetizer pointer to the packetizer
+ * \return nothing
+ */
+void dvbpsi_packetizer_delete(dvbpsi_packetizer_t *p_packetizer);
+
+/*****************************************************************************
+ * dvbpsi_packetizer_set_stuffing
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_packetizer_set_stuffing(dvbpsi_packetizer_t *p_packetizer,
+ *                                         dvbpsi_packetizer_stuffing_t i_stuffing)
+ * \brief Sets how the packets closed from now on are stuffed
+ * \param p_packetizer pointer to the packetizer
+ * \param i_stuffing stuffing, DVBPSI_PACKETIZER_BYTES by default
+ * \return nothing
+ */
+void dvbpsi_packetizer_set_stuffing(dvbpsi_packetizer_t *p_packetizer,
+                                    dvbpsi_packetizer_stuffing_t i_stuffing);
+
+/*****************************************************************************
+ * dvbpsi_packetizer_push
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_packetizer_push(dvbpsi_packetizer_t *p_packetizer,
+ *                                 uint16_t i_pid,
+ *                                 const dvbpsi_psi_section_t *p_section)
+ * \brief Packetizes a list of sections on a PID
+ * \param p_packetizer pointer to the packetizer
+ * \param i_pid PID, 0 to 0x1fff
+ * \param p_section first of the sections to packetize, as built by the
+ *        dvbpsi_xxx_sections_generate() functions
+ * \return false if the PID is invalid or the ring may not have room for
+ *         the packets, in which case nothing is written, true otherwise.
+ *
+ * Each section starts right after the previous section of the PID, in the
+ * same packet if at least its 3 bytes header fits. The last packet of the
+ * PID is kept open for the next sections: it is only written to the ring
+ * once full or by dvbpsi_packetizer_flush().
+ */
+bool dvbpsi_packetizer_push(dvbpsi_packetizer_t *p_packetizer, uint16_t i_pid,
+                            const dvbpsi_psi_section_t *p_section);
+
+/*****************************************************************************
+ * dvbpsi_packetizer_flush
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_packetizer_flush(dvbpsi_packetizer_t *p_packetizer)
+ * \brief Writes the open packets of all PIDs to the ring
+ * \param p_packetizer pointer to the packetizer
+ * \return false if the ring has no room for all of them, in which case
+ *         nothing is written, true otherwise.
+ *
+ * The remainder of each open packet is filled with 0xff stuffing bytes.
+ * The packets are written in the order the PIDs were first pushed.
+ */
+bool dvbpsi_packetizer_flush(dvbpsi_packetizer_t *p_packetizer);
+
+/*****************************************************************************
+ * dvbpsi_packetizer_pad
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_packetizer_pad(dvbpsi_packetizer_t *p_packetizer,
+ *                                unsigned int i_align)
+ * \brief Writes null packets up to the next multiple of i_align packets of
+ * the ring, typically after dvbpsi_packetizer_flush()
+ * \param p_packetizer pointer to the packetizer
+ * \param i_align number of packets, 7 for UDP or RTP datagrams
+ * \return false if the ring has no room for them, in which case nothing is
+ *         written, true otherwise.
+ *
+ * With a ring of a multiple of i_align packets and whole datagrams
+ * consumed, dvbpsi_packetizer_peek() then always returns whole datagrams
+ * that can be sent straight from the ring.
+ */
+bool dvbpsi_packetizer_pad(dvbpsi_packetizer_t *p_packetizer,
+                           unsigned int i_align);
+
+/*****************************************************************************
+ * dvbpsi_packetizer_peek
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_packetizer_peek(dvbpsi_packetizer_t *p_packetizer,
+ *                                   uint8_t **pp_packets)
+ * \brief Gets the oldest packets of the ring not yet consumed
+ * \param p_packetizer pointer to the packetizer
+ * \param pp_packets filled with a pointer to the first of these packets
+ * \return number of packets following each other in the ring from
+ *         *pp_packets, 0 if the ring is empty. When the packets wrap around
+ *         the end of the ring, the packets at its start are returned once
+ *         these are consumed.
+ */
+size_t dvbpsi_packetizer_peek(dvbpsi_packetizer_t *p_packetizer,
+                              uint8_t **pp_packets);
+
+/*****************************************************************************
+ * dvbpsi_packetizer_consume
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_packetizer_consume(dvbpsi_packetizer_t *p_packetizer,
+ *                                    size_t i_count)
+ * \brief Gives the oldest packets of the ring back to the packetizer
+ * \param p_packetizer pointer to the packetizer
+ * \param i_count number of packets, at most the number of packets in the
+ *        ring
+ * \return nothing
+ */
+void dvbpsi_packetizer_consume(dvbpsi_packetizer_t *p_packetizer,
+                               size_t i_count);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of packetizer.h"
+#endif
@@ -0,0 +1,426 @@
+/*****************************************************************************
+ * pipeline.c: multi-threaded TS processing
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "router.h"
+#include "scan.h"
+#include "pipeline.h"
+
+#define DVBPSI_PIPELINE_NONE    0xff    /* PID not forwarded */
+#define DVBPSI_PIPELINE_BATCHES 32
+
+/*****************************************************************************
+ * Atomics
+ *****************************************************************************
+ * The rings only need acquire and release, the sleep handshake needs
+ * sequential consistency between the flag and the index.
+ *****************************************************************************/
+#ifdef __ATOMIC_SEQ_CST
+#   define PIPELINE_LOAD(p, order)       __atomic_load_n(p, __ATOMIC_##order)
+#   define PIPELINE_STORE(p, v, order)   __atomic_store_n(p, v, __ATOMIC_##order)
+#else
+#   define PIPELINE_LOAD(p, order)       (__sync_synchronize(), *(volatile __typeof__(*(p)) *)(p))
+#   define PIPELINE_STORE(p, v, order)   do { __sync_synchronize(); \
+                                              *(volatile __typeof__(*(p)) *)(p) = (v); \
+                                              __sync_synchronize(); } while (0)
+#endif
+
+/*****************************************************************************
+ * dvbpsi_pipeline_worker_t
+ *****************************************************************************
+ * Worker with its ring of batches: the pushing thread fills the batch at
+ * i_tail and publishes it, the worker processes the batch at i_head.
+ *****************************************************************************/
+typedef struct dvbpsi_pipeline_worker_s
+{
+    dvbpsi_pipeline_t *     p_pipeline;
+    dvbpsi_router_t *       p_router;
+    pthread_t               thread;
+
+    uint8_t *               p_buffers;      /* i_batches batches */
+    unsigned int *          pi_counts;      /* packets of each batch */
+
+    /* Written by the worker */
+    size_t                  i_head;
+    bool                    b_sleeping;     /* waits on wake */
+    uint8_t                 pad[64];        /* keeps the two sides on
+                                               distinct cache lines */
+
+    /* Written by the pushing thread */
+    size_t                  i_tail;
+    unsigned int            i_open;         /* packets of the batch at i_tail */
+    bool                    b_waiting;      /* waits on room */
+    bool                    b_stop;
+
+    pthread_mutex_t         lock;
+    pthread_cond_t          wake;
+    pthread_cond_t          room;
+} dvbpsi_pipeline_worker_t;
+
+struct dvbpsi_pipeline_s
+{
+    dvbpsi_packet_format_t      i_format;
+    size_t                      i_packet_size;
+    size_t                      i_batch_size;   /* in bytes */
+    unsigned int                i_batches;
+    bool                        b_started;
+
+    uint8_t                     pi_workers[DVBPSI_ROUTER_PIDS];
+
+    unsigned int                i_workers;
+    dvbpsi_pipeline_worker_t    p_workers[];
+};
+
+/*****************************************************************************
+ * dvbpsi_pipeline_run
+ *****************************************************************************
+ * Worker thread.
+ *****************************************************************************/
+static void *dvbpsi_pipeline_run(void *p_data)
+{
+    dvbpsi_pipeline_worker_t *p_worker = (dvbpsi_pipeline_worker_t *)p_data;
+    const dvbpsi_pipeline_t *p_pipeline = p_worker->p_pipeline;
+    size_t i_head = p_worker->i_head;
+
+    for (;;)
+    {
+        if (i_head != PIPELINE_LOAD(&p_worker->i_tail, ACQUIRE))
+        {
+            size_t i_slot = i_head % p_pipeline->i_batches;
+            dvbpsi_router_push(p_worker->p_router,
+                               p_worker->p_buffers + i_slot * p_pipeline->i_batch_size,
+                               p_worker->pi_counts[i_slot], 0);
+
+            PIPELINE_STORE(&p_worker->i_head, ++i_head, SEQ_CST);
+            if (PIPELINE_LOAD(&p_worker->b_waiting, SEQ_CST))
+            {
+                pthread_mutex_lock(&p_worker->lock);
+                pthread_cond_signal(&p_worker->room);
+                pthread_mutex_unlock(&p_worker->lock);
+            }
+            continue;
+        }
+
+        /* Empty ring, sleep until a batch is published */
+        pthread_mutex_lock(&p_worker->lock);
+        PIPELINE_STORE(&p_worker->b_sleeping, true, SEQ_CST);
+        while (i_head == PIPELINE_LOAD(&p_worker->i_tail, SEQ_CST)
+               && !PIPELINE_LOAD(&p_worker->b_stop, SEQ_CST))
+            pthread_cond_wait(&p_worker->wake, &p_worker->lock);
+        PIPELINE_STORE(&p_worker->b_sleeping, false, SEQ_CST);
+        bool b_stop = i_head == PIPELINE_LOAD(&p_worker->i_tail, SEQ_CST);
+        pthread_mutex_unlock(&p_worker->lock);
+        if (b_stop)
+            break;
+    }
+    return NULL;
+}
+
+/***** dvbpsi_pipeline_publish ***** Gives the open batch to its worker *****/
+static void dvbpsi_pipeline_publish(dvbpsi_pipeline_t *p_pipeline,
+                                    dvbpsi_pipeline_worker_t *p_worker)
+{
+    p_worker->pi_counts[p_worker->i_tail % p_pipeline->i_batches] = p_worker->i_open;
+    p_worker->i_open = 0;
+    PIPELINE_STORE(&p_worker->i_tail, p_worker->i_tail + 1, SEQ_CST);
+    if (PIPELINE_LOAD(&p_worker->b_sleeping, SEQ_CST))
+    {
+        pthread_mutex_lock(&p_worker->lock);
+        pthread_cond_signal(&p_worker->wake);
+        pthread_mutex_unlock(&p_worker->lock);
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_pipeline_wait
+ *****************************************************************************
+ * Waits until a worker has at most i_pending batches left to process.
+ *****************************************************************************/
+static void dvbpsi_pipeline_wait(dvbpsi_pipeline_worker_t *p_worker, size_t i_pending)
+{
+    if (p_worker->i_tail - PIPELINE_LOAD(&p_worker->i_head, ACQUIRE) <= i_pending)
+        return;
+
+    pthread_mutex_lock(&p_worker->lock);
+    PIPELINE_STORE(&p_worker->b_waiting, true, SEQ_CST);
+    while (p_worker->i_tail - PIPELINE_LOAD(&p_worker->i_head, SEQ_CST) > i_pending)
+        pthread_cond_wait(&p_worker->room, &p_worker->lock);
+    PIPELINE_STORE(&p_worker->b_waiting, false, SEQ_CST);
+    pthread_mutex_unlock(&p_worker->lock);
+}
+
+/*****************************************************************************
+ * dvbpsi_pipeline_new
+ *****************************************************************************/
+dvbpsi_pipeline_t *dvbpsi_pipeline_new(unsigned int i_workers, unsigned int i_batches,
+                                       dvbpsi_packet_format_t i_format)
+{
+    if (i_workers == 0 || i_workers > DVBPSI_PIPELINE_WORKERS)
+        return NULL;
+    if (i_batches == 0)
+        i_batches = DVBPSI_PIPELINE_BATCHES;
+
+    dvbpsi_pipeline_t *p_pipeline = dvbpsi_calloc(1, sizeof(dvbpsi_pipeline_t)
+                                            + i_workers * sizeof(dvbpsi_pipeline_worker_t));
+    if (p_pipeline == NULL)
+        return NULL;
+
+    p_pipeline->i_format = i_format;
+    p_pipeline->i_packet_size = dvbpsi_get_packet_size(i_format);
+    p_pipeline->i_batch_size = DVBPSI_SCAN_BLOCK * p_pipeline->i_packet_size;
+    p_pipeline->i_batches = i_batches;
+    memset(p_pipeline->pi_workers, DVBPSI_PIPELINE_NONE, sizeof(p_pipeline->pi_workers));
+
+    for (unsigned int i = 0; i < i_workers; i++)
+    {
+        dvbpsi_pipeline_worker_t *p_worker = &p_pipeline->p_workers[i];
+        p_worker->p_pipeline = p_pipeline;
+        p_worker->p_router = dvbpsi_router_new();
+        p_worker->p_buffers = dvbpsi_malloc(i_batches * p_pipeline->i_batch_size);
+        p_worker->pi_counts = dvbpsi_malloc(i_batches * sizeof(unsigned int));
+        if (p_worker->p_router == NULL || p_worker->p_buffers == NULL
+         || p_worker->pi_counts == NULL
+         || !dvbpsi_router_set_packet_format(p_worker->p_router, i_format))
+        {
+            dvbpsi_router_delete(p_worker->p_router);
+            dvbpsi_free(p_worker->p_buffers);
+            dvbpsi_free(p_worker->pi_counts);
+            break;
+        }
+        pthread_mutex_init(&p_worker->lock, NULL);
+        pthread_cond_init(&p_worker->wake, NULL);
+        pthread_cond_init(&p_worker->room, NULL);
+        p_pipeline->i_workers++;
+    }
+
+    if (p_pipeline->i_workers != i_workers)
+    {
+        dvbpsi_pipeline_delete(p_pipeline);
+        return NULL;
+    }
+    return p_pipeline;
+}
+
+/*****************************************************************************
+ * dvbpsi_pipeline_delete
+ *****************************************************************************/
+void dvbpsi_pipeline_delete(dvbpsi_pipeline_t *p_pipeline)
+{
+    if (p_pipeline == NULL)
+        return;
+
+    for (unsigned int i = 0; i < p_pipeline->i_workers; i++)
+    {
+        dvbpsi_pipeline_worker_t *p_worker = &p_pipeline->p_workers[i];
+        if (!p_pipeline->b_started)
+            continue;
+
+        if (p_worker->i_open)
+            dvbpsi_pipeline_publish(p_pipeline, p_worker);
+        pthread_mutex_lock(&p_worker->lock);
+        PIPELINE_STORE(&p_worker->b_stop, true, SEQ_CST);
+        pthread_cond_signal(&p_worker->wake);
+        pthread_mutex_unlock(&p_worker->lock);
+        pthread_join(p_worker->thread, NULL);
+    }
+
+    for (unsigned int i = 0; i < p_pipeline->i_workers; i++)
+    {
+        dvbpsi_pipeline_worker_t *p_worker = &p_pipeline->p_workers[i];
+        pthread_mutex_destroy(&p_worker->lock);
+        pthread_cond_destroy(&p_worker->wake);
+        pthread_cond_destroy(&p_worker->room);
+        dvbpsi_router_delete(p_worker->p_router);
+        dvbpsi_free(p_worker->p_buffers);
+        dvbpsi_free(p_worker->pi_counts);
+    }
+    dvbpsi_free(p_pipeline);
+}
+
+/*****************************************************************************
+ * dvbpsi_pipeline_router
+ *****************************************************************************/
+dvbpsi_router_t *dvbpsi_pipeline_router(dvbpsi_pipeline_t *p_pipeline,
+                                        unsigned int i_worker)
+{
+    assert(p_pipeline);
+    assert(i_worker < p_pipeline->i_workers);
+    return p_pipeline->p_workers[i_worker].p_router;
+}
+
+/*****************************************************************************
+ * dvbpsi_pipeline_shard
+ *****************************************************************************/
+unsigned int dvbpsi_pipeline_shard(const dvbpsi_pipeline_t *p_pipeline, uint16_t i_pid)
+{
+    assert(p_pipeline);
+    return (unsigned int)(((uint64_t)((i_pid * 2654435761u) >> 16) * p_pipeline->i_workers)
+                          >> 16);
+}
+
+/*****************************************************************************
+ * dvbpsi_pipeline_add_pid/remove_pid
+ *****************************************************************************/
+bool dvbpsi_pipeline_add_pid(dvbpsi_pipeline_t *p_pipeline, uint16_t i_pid,
+                             unsigned int i_worker)
+{
+    assert(p_pipeline);
+    assert(i_worker < p_pipeline->i_workers);
+
+    if (i_pid >= DVBPSI_ROUTER_PIDS)
+        return false;
+
+    uint8_t i_expected = DVBPSI_PIPELINE_NONE;
+#ifdef __ATOMIC_SEQ_CST
+    if (__atomic_compare_exchange_n(&p_pipeline->pi_workers[i_pid], &i_expected,
+                                    (uint8_t)i_worker, false,
+                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        return true;
+#else
+    i_expected = __sync_val_compare_and_swap(&p_pipeline->pi_workers[i_pid], i_expected,
+                                             (uint8_t)i_worker);
+    if (i_expected == DVBPSI_PIPELINE_NONE)
+        return true;
+#endif
+    return i_expected == i_worker;
+}
+
+void dvbpsi_pipeline_remove_pid(dvbpsi_pipeline_t *p_pipeline, uint16_t i_pid)
+{
+    assert(p_pipeline);
+
+    if (i_pid < DVBPSI_ROUTER_PIDS)
+        PIPELINE_STORE(&p_pipeline->pi_workers[i_pid], DVBPSI_PIPELINE_NONE, RELAXED);
+}
+
+/*****************************************************************************
+ * dvbpsi_pipeline_start
+ *****************************************************************************/
+bool dvbpsi_pipeline_start(dvbpsi_pipeline_t *p_pipeline)
+{
+    assert(p_pipeline);
+    assert(!p_pipeline->b_started);
+
+    for (unsigned int i = 0; i < p_pipeline->i_workers; i++)
+    {
+        dvbpsi_pipeline_worker_t *p_worker = &p_pipeline->p_workers[i];
+        if (pthread_create(&p_worker->thread, NULL, dvbpsi_pipeline_run, p_worker) != 0)
+        {
+            /* Stop the workers already started */
+            for (unsigned int j = 0; j < i; j++)
+            {
+                p_worker = &p_pipeline->p_workers[j];
+                pthread_mutex_lock(&p_worker->lock);
+                PIPELINE_STORE(&p_worker->b_stop, true, SEQ_CST);
+                pthread_cond_signal(&p_worker->wake);
+                pthread_mutex_unlock(&p_worker->lock);
+                pthread_join(p_worker->thread, NULL);
+                p_worker->b_stop = false;
+            }
+            return false;
+        }
+    }
+    p_pipeline->b_started = true;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_pipeline_push
+ *****************************************************************************/
+bool dvbpsi_pipeline_push(dvbpsi_pipeline_t *p_pipeline, const uint8_t *p_data,
+                          size_t i_count)
+{
+    assert(p_pipeline);
+    assert(p_pipeline->b_started);
+
+    const size_t i_packet_size = p_pipeline->i_packet_size;
+    bool b_ok = true;
+    size_t i = 0;
+    while (i < i_count)
+    {
+        dvbpsi_ts_headers_t headers;
+        dvbpsi_packets_scan(p_data + i * i_packet_size, (i_count - i) * i_packet_size,
+                            p_pipeline->i_format, &headers);
+        if (headers.i_count == 0)
+        {
+            /* Not a TS packet */
+            b_ok = false;
+            i++;
+            continue;
+        }
+
+        for (unsigned int k = 0; k < headers.i_count; k++)
+        {
+            uint8_t i_worker = PIPELINE_LOAD(&p_pipeline->pi_workers[headers.pi_pid[k]],
+                                             RELAXED);
+            if (i_worker == DVBPSI_PIPELINE_NONE)
+                continue;
+
+            /* Copy into the open batch of the worker, waiting for room */
+            dvbpsi_pipeline_worker_t *p_worker = &p_pipeline->p_workers[i_worker];
+            if (p_worker->i_open == 0)
+                dvbpsi_pipeline_wait(p_worker, p_pipeline->i_batches - 1);
+            uint8_t *p_batch = p_worker->p_buffers
+                + (p_worker->i_tail % p_pipeline->i_batches) * p_pipeline->i_batch_size;
+            memcpy(p_batch + p_worker->i_open * i_packet_size,
+                   p_data + (i + k) * i_packet_size, i_packet_size);
+            if (++p_worker->i_open == DVBPSI_SCAN_BLOCK)
+                dvbpsi_pipeline_publish(p_pipeline, p_worker);
+        }
+        i += headers.i_count;
+    }
+
+    for (unsigned int w = 0; w < p_pipeline->i_workers; w++)
+        if (p_pipeline->p_workers[w].i_open)
+            dvbpsi_pipeline_publish(p_pipeline, &p_pipeline->p_workers[w]);
+    return b_ok;
+}
+
+/*****************************************************************************
+ * dvbpsi_pipeline_flush
+ *****************************************************************************/
+void dvbpsi_pipeline_flush(dvbpsi_pipeline_t *p_pipeline)
+{
+    assert(p_pipeline);
+    assert(p_pipeline->b_started);
+
+    for (unsigned int i = 0; i < p_pipeline->i_workers; i++)
+        dvbpsi_pipeline_wait(&p_pipeline->p_workers[i], 0);
+}
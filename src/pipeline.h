@@ -0,0 +1,203 @@
+/*****************************************************************************
+ * pipeline.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <pipeline.h>
+ * \brief Multi-threaded TS processing.
+ *
+ * Spreads the PSI PIDs of a transport stream over worker threads. The
+ * thread pushing the stream only reads the TS headers and copies the
+ * packets of the PIDs it was given to their worker, in batches passed
+ * through a lock-free ring per worker. Each worker has a PID router, the
+ * handles attached to it being only used by the worker, so their
+ * callbacks are called on the worker thread, in the order of the packets
+ * of each PID.
+ *
+ * Only built when POSIX threads are available.
+ */
+
+#ifndef _DVBPSI_PIPELINE_H_
+#define _DVBPSI_PIPELINE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_pipeline_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_pipeline_s dvbpsi_pipeline_t
+ * \brief dvbpsi_pipeline_t type definition, an opaque pipeline.
+ */
+typedef struct dvbpsi_pipeline_s dvbpsi_pipeline_t;
+
+/*!
+ * \def DVBPSI_PIPELINE_WORKERS
+ * \brief Maximum number of workers of a pipeline
+ */
+#define DVBPSI_PIPELINE_WORKERS 64
+
+/*****************************************************************************
+ * dvbpsi_pipeline_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_pipeline_t *dvbpsi_pipeline_new(unsigned int i_workers,
+ *                                            unsigned int i_batches,
+ *                                            dvbpsi_packet_format_t i_format)
+ * \brief Creates a pipeline with its workers, not started
+ * \param i_workers number of workers, 1 to DVBPSI_PIPELINE_WORKERS
+ * \param i_batches number of batches of DVBPSI_SCAN_BLOCK packets in the
+ *        ring of each worker, 0 for 32
+ * \param i_format framing of the packets, the one of the routers
+ * \return pointer to the pipeline, or NULL on error
+ */
+dvbpsi_pipeline_t *dvbpsi_pipeline_new(unsigned int i_workers, unsigned int i_batches,
+                                       dvbpsi_packet_format_t i_format);
+
+/*****************************************************************************
+ * dvbpsi_pipeline_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_pipeline_delete(dvbpsi_pipeline_t *p_pipeline)
+ * \brief Processes the packets pushed, stops the workers and deletes a
+ * pipeline with its routers. The handles attached to the routers are not
+ * deleted.
+ * \param p_pipeline pointer to the pipeline
+ * \return nothing
+ */
+void dvbpsi_pipeline_delete(dvbpsi_pipeline_t *p_pipeline);
+
+/*****************************************************************************
+ * dvbpsi_pipeline_router
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_router_t *dvbpsi_pipeline_router(dvbpsi_pipeline_t *p_pipeline,
+ *                                             unsigned int i_worker)
+ * \brief Gets the PID router of a worker
+ * \param p_pipeline pointer to the pipeline
+ * \param i_worker worker, below the number of workers
+ * \return the router.
+ *
+ * The router and its handles may be used before dvbpsi_pipeline_start(),
+ * from the callbacks of its handles, which run on the worker, and between
+ * dvbpsi_pipeline_flush() and the next dvbpsi_pipeline_push().
+ */
+dvbpsi_router_t *dvbpsi_pipeline_router(dvbpsi_pipeline_t *p_pipeline,
+                                        unsigned int i_worker);
+
+/*****************************************************************************
+ * dvbpsi_pipeline_shard
+ *****************************************************************************/
+/*!
+ * \fn unsigned int dvbpsi_pipeline_shard(const dvbpsi_pipeline_t *p_pipeline,
+ *                                        uint16_t i_pid)
+ * \brief Gets the default worker of a PID, spreading the PIDs evenly
+ * \param p_pipeline pointer to the pipeline
+ * \param i_pid PID, 0 to 0x1fff
+ * \return the worker.
+ */
+unsigned int dvbpsi_pipeline_shard(const dvbpsi_pipeline_t *p_pipeline, uint16_t i_pid);
+
+/*****************************************************************************
+ * dvbpsi_pipeline_add_pid/remove_pid
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_pipeline_add_pid(dvbpsi_pipeline_t *p_pipeline,
+ *                                  uint16_t i_pid, unsigned int i_worker)
+ * \brief Forwards the packets of a PID to a worker
+ * \param p_pipeline pointer to the pipeline
+ * \param i_pid PID, 0 to 0x1fff
+ * \param i_worker worker, for instance dvbpsi_pipeline_shard(), whose
+ *        router gets the packets
+ * \return false if the PID is invalid or already forwarded to another
+ *         worker, true otherwise.
+ *
+ * Like dvbpsi_pipeline_remove_pid(), it may be called from any thread, for
+ * instance from the callback of a PAT on a worker to add the PMT PIDs:
+ * the packets pushed afterwards are forwarded. A PID stays on one worker,
+ * which keeps the order of its packets.
+ */
+bool dvbpsi_pipeline_add_pid(dvbpsi_pipeline_t *p_pipeline, uint16_t i_pid,
+                             unsigned int i_worker);
+
+/*!
+ * \fn void dvbpsi_pipeline_remove_pid(dvbpsi_pipeline_t *p_pipeline,
+ *                                     uint16_t i_pid)
+ * \brief Stops forwarding the packets of a PID
+ * \param p_pipeline pointer to the pipeline
+ * \param i_pid PID, 0 to 0x1fff
+ * \return nothing.
+ *
+ * The packets of the PID already forwarded are still given to the router.
+ */
+void dvbpsi_pipeline_remove_pid(dvbpsi_pipeline_t *p_pipeline, uint16_t i_pid);
+
+/*****************************************************************************
+ * dvbpsi_pipeline_start
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_pipeline_start(dvbpsi_pipeline_t *p_pipeline)
+ * \brief Starts the worker threads
+ * \param p_pipeline pointer to the pipeline
+ * \return false if a thread could not be created, true otherwise.
+ */
+bool dvbpsi_pipeline_start(dvbpsi_pipeline_t *p_pipeline);
+
+/*****************************************************************************
+ * dvbpsi_pipeline_push
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_pipeline_push(dvbpsi_pipeline_t *p_pipeline,
+ *                               const uint8_t *p_data, size_t i_count)
+ * \brief Injection of a run of packets of a transport stream
+ * \param p_pipeline pointer to a started pipeline
+ * \param p_data pointer to 'i_count' contiguous packets of the format of
+ *        the pipeline, not needed anymore once the function returns
+ * \param i_count number of packets in the buffer
+ * \return false when at least one packet was not a TS packet, true otherwise.
+ *
+ * The packets are copied, and the batches of each worker given to it at
+ * the latest when the function returns. It blocks while the ring of a
+ * worker is full. Pushes are not thread safe with each other.
+ */
+bool dvbpsi_pipeline_push(dvbpsi_pipeline_t *p_pipeline, const uint8_t *p_data,
+                          size_t i_count);
+
+/*****************************************************************************
+ * dvbpsi_pipeline_flush
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_pipeline_flush(dvbpsi_pipeline_t *p_pipeline)
+ * \brief Waits for the workers to process all the packets pushed
+ * \param p_pipeline pointer to a started pipeline
+ * \return nothing.
+ */
+void dvbpsi_pipeline_flush(dvbpsi_pipeline_t *p_pipeline);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of pipeline.h"
+#endif
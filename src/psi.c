@@ -28,6 +28,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
 
 #include <assert.h>
@@ -39,103 +40,10 @@
 #endif
 
 #include "dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_SECTION
 #include "dvbpsi_private.h"
 #include "psi.h"
-
-/*****************************************************************************
- * dvbpsi_crc32_table
- *****************************************************************************
- * This table is used to compute a PSI CRC byte per byte instead of bit per
- * bit. It's been generated by 'gen_crc' in the 'misc' directory:
- *
- *   uint32_t table[256];
- *   uint32_t i, j, k;
- *
- *   for(i = 0; i < 256; i++)
- *   {
- *     k = 0;
- *     for (j = (i << 24) | 0x800000; j != 0x80000000; j <<= 1)
- *       k = (k << 1) ^ (((k ^ j) & 0x80000000) ? 0x04c11db7 : 0);
- *     table[i] = k;
- *   }
- *
- * A CRC is computed like this:
- *
- *   initialization
- *   --------------
- *   uint32_t i_crc = 0xffffffff;
- *
- *   for each data byte do
- *   ---------------------
- *   i_crc = (i_crc << 8) ^ dvbpsi_crc32_table[(i_crc >> 24) ^ (data_byte)];
- *****************************************************************************/
-static uint32_t dvbpsi_crc32_table[256] =
-{
-  0x00000000, 0x04c11db7, 0x09823b6e, 0x0d4326d9,
-  0x130476dc, 0x17c56b6b, 0x1a864db2, 0x1e475005,
-  0x2608edb8, 0x22c9f00f, 0x2f8ad6d6, 0x2b4bcb61,
-  0x350c9b64, 0x31cd86d3, 0x3c8ea00a, 0x384fbdbd,
-  0x4c11db70, 0x48d0c6c7, 0x4593e01e, 0x4152fda9,
-  0x5f15adac, 0x5bd4b01b, 0x569796c2, 0x52568b75,
-  0x6a1936c8, 0x6ed82b7f, 0x639b0da6, 0x675a1011,
-  0x791d4014, 0x7ddc5da3, 0x709f7b7a, 0x745e66cd,
-  0x9823b6e0, 0x9ce2ab57, 0x91a18d8e, 0x95609039,
-  0x8b27c03c, 0x8fe6dd8b, 0x82a5fb52, 0x8664e6e5,
-  0xbe2b5b58, 0xbaea46ef, 0xb7a96036, 0xb3687d81,
-  0xad2f2d84, 0xa9ee3033, 0xa4ad16ea, 0xa06c0b5d,
-  0xd4326d90, 0xd0f37027, 0xddb056fe, 0xd9714b49,
-  0xc7361b4c, 0xc3f706fb, 0xceb42022, 0xca753d95,
-  0xf23a8028, 0xf6fb9d9f, 0xfbb8bb46, 0xff79a6f1,
-  0xe13ef6f4, 0xe5ffeb43, 0xe8bccd9a, 0xec7dd02d,
-  0x34867077, 0x30476dc0, 0x3d044b19, 0x39c556ae,
-  0x278206ab, 0x23431b1c, 0x2e003dc5, 0x2ac12072,
-  0x128e9dcf, 0x164f8078, 0x1b0ca6a1, 0x1fcdbb16,
-  0x018aeb13, 0x054bf6a4, 0x0808d07d, 0x0cc9cdca,
-  0x7897ab07, 0x7c56b6b0, 0x71159069, 0x75d48dde,
-  0x6b93dddb, 0x6f52c06c, 0x6211e6b5, 0x66d0fb02,
-  0x5e9f46bf, 0x5a5e5b08, 0x571d7dd1, 0x53dc6066,
-  0x4d9b3063, 0x495a2dd4, 0x44190b0d, 0x40d816ba,
-  0xaca5c697, 0xa864db20, 0xa527fdf9, 0xa1e6e04e,
-  0xbfa1b04b, 0xbb60adfc, 0xb6238b25, 0xb2e29692,
-  0x8aad2b2f, 0x8e6c3698, 0x832f1041, 0x87ee0df6,
-  0x99a95df3, 0x9d684044, 0x902b669d, 0x94ea7b2a,
-  0xe0b41de7, 0xe4750050, 0xe9362689, 0xedf73b3e,
-  0xf3b06b3b, 0xf771768c, 0xfa325055, 0xfef34de2,
-  0xc6bcf05f, 0xc27dede8, 0xcf3ecb31, 0xcbffd686,
-  0xd5b88683, 0xd1799b34, 0xdc3abded, 0xd8fba05a,
-  0x690ce0ee, 0x6dcdfd59, 0x608edb80, 0x644fc637,
-  0x7a089632, 0x7ec98b85, 0x738aad5c, 0x774bb0eb,
-  0x4f040d56, 0x4bc510e1, 0x46863638, 0x42472b8f,
-  0x5c007b8a, 0x58c1663d, 0x558240e4, 0x51435d53,
-  0x251d3b9e, 0x21dc2629, 0x2c9f00f0, 0x285e1d47,
-  0x36194d42, 0x32d850f5, 0x3f9b762c, 0x3b5a6b9b,
-  0x0315d626, 0x07d4cb91, 0x0a97ed48, 0x0e56f0ff,
-  0x1011a0fa, 0x14d0bd4d, 0x19939b94, 0x1d528623,
-  0xf12f560e, 0xf5ee4bb9, 0xf8ad6d60, 0xfc6c70d7,
-  0xe22b20d2, 0xe6ea3d65, 0xeba91bbc, 0xef68060b,
-  0xd727bbb6, 0xd3e6a601, 0xdea580d8, 0xda649d6f,
-  0xc423cd6a, 0xc0e2d0dd, 0xcda1f604, 0xc960ebb3,
-  0xbd3e8d7e, 0xb9ff90c9, 0xb4bcb610, 0xb07daba7,
-  0xae3afba2, 0xaafbe615, 0xa7b8c0cc, 0xa379dd7b,
-  0x9b3660c6, 0x9ff77d71, 0x92b45ba8, 0x9675461f,
-  0x8832161a, 0x8cf30bad, 0x81b02d74, 0x857130c3,
-  0x5d8a9099, 0x594b8d2e, 0x5408abf7, 0x50c9b640,
-  0x4e8ee645, 0x4a4ffbf2, 0x470cdd2b, 0x43cdc09c,
-  0x7b827d21, 0x7f436096, 0x7200464f, 0x76c15bf8,
-  0x68860bfd, 0x6c47164a, 0x61043093, 0x65c52d24,
-  0x119b4be9, 0x155a565e, 0x18197087, 0x1cd86d30,
-  0x029f3d35, 0x065e2082, 0x0b1d065b, 0x0fdc1bec,
-  0x3793a651, 0x3352bbe6, 0x3e119d3f, 0x3ad08088,
-  0x2497d08d, 0x2056cd3a, 0x2d15ebe3, 0x29d4f654,
-  0xc5a92679, 0xc1683bce, 0xcc2b1d17, 0xc8ea00a0,
-  0xd6ad50a5, 0xd26c4d12, 0xdf2f6bcb, 0xdbee767c,
-  0xe3a1cbc1, 0xe760d676, 0xea23f0af, 0xeee2ed18,
-  0xf0a5bd1d, 0xf464a0aa, 0xf9278673, 0xfde69bc4,
-  0x89b8fd09, 0x8d79e0be, 0x803ac667, 0x84fbdbd0,
-  0x9abc8bd5, 0x9e7d9662, 0x933eb0bb, 0x97ffad0c,
-  0xafb010b1, 0xab710d06, 0xa6322bdf, 0xa2f33668,
-  0xbcb4666d, 0xb8757bda, 0xb5365d03, 0xb1f740b4
-};
+#include "crc32_private.h"
 
 /*****************************************************************************
  * dvbpsi_NewPSISection
@@ -146,24 +54,368 @@ dvbpsi_psi_section_t *dvbpsi_NewPSISection(int i_max_size)
 {
     /* Allocate the dvbpsi_psi_section_t structure */
     dvbpsi_psi_section_t * p_section
-                  = (dvbpsi_psi_section_t*)calloc(1, sizeof(dvbpsi_psi_section_t));
+                  = (dvbpsi_psi_section_t*)dvbpsi_calloc(1, sizeof(dvbpsi_psi_section_t));
     if (p_section == NULL)
         return NULL;
 
     /* Allocate the p_data memory area */
-    p_section->p_data = (uint8_t*)calloc(1, i_max_size * sizeof(uint8_t));
+    p_section->p_data = (uint8_t*)dvbpsi_calloc(1, i_max_size * sizeof(uint8_t));
     if (p_section->p_data == NULL)
     {
-        free(p_section);
+        dvbpsi_free(p_section);
         return NULL;
     }
 
     p_section->p_payload_end = p_section->p_data;
     p_section->p_next = NULL;
+    p_section->i_max_size = i_max_size;
+    p_section->p_pool = NULL;
+    p_section->i_arrival = DVBPSI_TIME_NONE;
+
+    return p_section;
+}
+
+/*****************************************************************************
+ * dvbpsi_section_pool_t
+ *****************************************************************************/
+struct dvbpsi_section_pool_s
+{
+    dvbpsi_psi_section_t *p_free[DVBPSI_SECTION_POOL_CLASSES];
+    unsigned int          i_free[DVBPSI_SECTION_POOL_CLASSES];
+
+    unsigned int          i_outstanding; /* sections not given back yet */
+    bool                  b_orphan;      /* owner handle has been deleted */
+    bool                  b_compact;     /* DVBPSI_FLAG_COMPACT */
+    bool                  b_keep_last;   /* DVBPSI_FLAG_LAST_SECTIONS */
+
+    dvbpsi_psi_section_t  borrowed;      /* DVBPSI_FLAG_ZERO_COPY section */
+
+    uint64_t              i_allocations; /* sections allocated */
+    uint64_t              i_copied;      /* bytes copied by pool_copy */
+};
+
+/*****************************************************************************
+ * dvbpsi_section_pool_class
+ *****************************************************************************
+ * Smallest size class holding i_max_size bytes, or -1.
+ *****************************************************************************/
+static int dvbpsi_section_pool_class(int i_max_size)
+{
+    for (int i = 0; i < DVBPSI_SECTION_POOL_CLASSES; i++)
+        if (i_max_size <= (64 << i))
+            return i;
+    return -1;
+}
+
+/*****************************************************************************
+ * dvbpsi_section_pool_new
+ *****************************************************************************/
+dvbpsi_section_pool_t *dvbpsi_section_pool_new(void)
+{
+    return (dvbpsi_section_pool_t *)dvbpsi_calloc_as(1, sizeof(dvbpsi_section_pool_t),
+                                                     DVBPSI_MEM_DECODER);
+}
+
+/*****************************************************************************
+ * dvbpsi_section_pool_delete
+ *****************************************************************************
+ * Frees the cached sections. The pool itself lives on until every section
+ * taken from it has been deleted.
+ *****************************************************************************/
+void dvbpsi_section_pool_delete(dvbpsi_section_pool_t *p_pool)
+{
+    if (p_pool == NULL)
+        return;
+
+    for (int i = 0; i < DVBPSI_SECTION_POOL_CLASSES; i++)
+    {
+        dvbpsi_psi_section_t *p_section = p_pool->p_free[i];
+        while (p_section)
+        {
+            dvbpsi_psi_section_t *p_next = p_section->p_next;
+            dvbpsi_free(p_section);
+            p_section = p_next;
+        }
+        p_pool->p_free[i] = NULL;
+        p_pool->i_free[i] = 0;
+    }
+
+    if (p_pool->i_outstanding == 0)
+        dvbpsi_free(p_pool);
+    else
+        p_pool->b_orphan = true;
+}
+
+/*****************************************************************************
+ * dvbpsi_section_pool_set_compact
+ *****************************************************************************/
+void dvbpsi_section_pool_set_compact(dvbpsi_section_pool_t *p_pool, bool b_compact)
+{
+    if (p_pool == NULL || p_pool->b_compact == b_compact)
+        return;
+
+    p_pool->b_compact = b_compact;
+    for (int i = 0; b_compact && i < DVBPSI_SECTION_POOL_CLASSES; i++)
+    {
+        dvbpsi_psi_section_t *p_section = p_pool->p_free[i];
+        while (p_section)
+        {
+            dvbpsi_psi_section_t *p_next = p_section->p_next;
+            dvbpsi_free(p_section);
+            p_section = p_next;
+        }
+        p_pool->p_free[i] = NULL;
+        p_pool->i_free[i] = 0;
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_section_pool_is_compact
+ *****************************************************************************/
+bool dvbpsi_section_pool_is_compact(const dvbpsi_section_pool_t *p_pool)
+{
+    return p_pool && p_pool->b_compact;
+}
+
+/*****************************************************************************
+ * dvbpsi_section_pool_set_keep_last
+ *****************************************************************************/
+void dvbpsi_section_pool_set_keep_last(dvbpsi_section_pool_t *p_pool, bool b_keep_last)
+{
+    if (p_pool)
+        p_pool->b_keep_last = b_keep_last;
+}
+
+/*****************************************************************************
+ * dvbpsi_section_pool_keeps_last
+ *****************************************************************************/
+bool dvbpsi_section_pool_keeps_last(const dvbpsi_section_pool_t *p_pool)
+{
+    return p_pool && p_pool->b_keep_last;
+}
+
+/*****************************************************************************
+ * dvbpsi_section_pool_get
+ *****************************************************************************
+ * Takes a section able to hold i_max_size bytes from the pool. The section
+ * structure and its data area are allocated in one block.
+ *****************************************************************************/
+dvbpsi_psi_section_t *dvbpsi_section_pool_get(dvbpsi_section_pool_t *p_pool,
+                                              int i_max_size)
+{
+    int i_class = dvbpsi_section_pool_class(i_max_size);
+    if (p_pool == NULL || p_pool->b_orphan || i_class < 0)
+    {
+        if (p_pool)
+            p_pool->i_allocations++;
+        return dvbpsi_NewPSISection(i_max_size);
+    }
+
+    dvbpsi_psi_section_t *p_section;
+    if (p_pool->b_compact)
+        p_section = dvbpsi_pool_take(DVBPSI_POOL_BLOCK,
+                                     sizeof(dvbpsi_psi_section_t) + (64 << i_class));
+    else if ((p_section = p_pool->p_free[i_class]) != NULL)
+    {
+        p_pool->p_free[i_class] = p_section->p_next;
+        p_pool->i_free[i_class]--;
+    }
+
+    if (p_section == NULL)
+    {
+        p_section = (dvbpsi_psi_section_t *)dvbpsi_malloc(sizeof(dvbpsi_psi_section_t)
+                                                   + (64 << i_class));
+        if (p_section == NULL)
+            return NULL;
+        p_pool->i_allocations++;
+    }
+    else
+        dvbpsi_mem_tag(p_section, DVBPSI_MEM_SECTION);
+
+    memset(p_section, 0, sizeof(dvbpsi_psi_section_t));
+    p_section->p_data = (uint8_t *)(p_section + 1);
+    p_section->p_payload_end = p_section->p_data;
+    p_section->i_max_size = 64 << i_class;
+    p_section->p_pool = p_pool;
+    p_pool->i_outstanding++;
 
     return p_section;
 }
 
+/*****************************************************************************
+ * dvbpsi_section_pool_borrow
+ *****************************************************************************
+ * The borrowed section is only used while the TS packet is being decoded, so
+ * one per pool is enough.
+ *****************************************************************************/
+dvbpsi_psi_section_t *dvbpsi_section_pool_borrow(dvbpsi_section_pool_t *p_pool,
+                                                 uint8_t *p_pos, int i_size)
+{
+    dvbpsi_psi_section_t *p_section = &p_pool->borrowed;
+
+    memset(p_section, 0, sizeof(dvbpsi_psi_section_t));
+    p_section->p_data = p_section->p_payload_end = p_pos;
+    p_section->i_max_size = i_size;
+    p_section->p_pool = p_pool;
+    p_section->b_borrowed = true;
+
+    return p_section;
+}
+
+/*****************************************************************************
+ * dvbpsi_section_pool_counters
+ *****************************************************************************/
+void dvbpsi_section_pool_counters(const dvbpsi_section_pool_t *p_pool,
+                                  uint64_t *pi_allocations, uint64_t *pi_copied)
+{
+    *pi_allocations = p_pool ? p_pool->i_allocations : 0;
+    *pi_copied = p_pool ? p_pool->i_copied : 0;
+}
+
+/*****************************************************************************
+ * dvbpsi_section_pool_copy
+ *****************************************************************************
+ * Copies a section into one that may outlive the TS packet.
+ *****************************************************************************/
+dvbpsi_psi_section_t *dvbpsi_section_pool_copy(dvbpsi_psi_section_t *p_section)
+{
+    int i_size = p_section->i_length + 3;
+    dvbpsi_psi_section_t *p_copy = dvbpsi_section_pool_get(p_section->p_pool, i_size);
+    if (p_copy == NULL)
+        return NULL;
+
+    uint8_t *p_data = p_copy->p_data;
+    int i_max_size = p_copy->i_max_size;
+    dvbpsi_section_pool_t *p_pool = p_copy->p_pool;
+
+    *p_copy = *p_section;
+    memcpy(p_data, p_section->p_data, i_size);
+    if (p_section->p_pool)
+        p_section->p_pool->i_copied += i_size;
+    p_copy->p_data = p_data;
+    p_copy->p_payload_start = p_data + (p_section->p_payload_start - p_section->p_data);
+    p_copy->p_payload_end = p_data + (p_section->p_payload_end - p_section->p_data);
+    p_copy->p_next = NULL;
+    p_copy->i_max_size = i_max_size;
+    p_copy->p_pool = p_pool;
+    p_copy->b_borrowed = false;
+
+    return p_copy;
+}
+
+/*****************************************************************************
+ * dvbpsi_section_pool_put
+ *****************************************************************************
+ * Gives a section back to its pool.
+ *****************************************************************************/
+static void dvbpsi_section_pool_put(dvbpsi_section_pool_t *p_pool,
+                                    dvbpsi_psi_section_t *p_section)
+{
+    int i_class = dvbpsi_section_pool_class(p_section->i_max_size);
+
+    assert(p_pool->i_outstanding > 0);
+    assert(i_class >= 0);
+    p_pool->i_outstanding--;
+
+    if (p_pool->b_orphan || p_pool->b_compact
+     || p_pool->i_free[i_class] >= DVBPSI_SECTION_POOL_DEPTH)
+    {
+        if (!p_pool->b_compact
+         || !dvbpsi_pool_give(DVBPSI_POOL_BLOCK, p_section,
+                              sizeof(dvbpsi_psi_section_t) + (64 << i_class)))
+            dvbpsi_free(p_section);
+        if (p_pool->b_orphan && p_pool->i_outstanding == 0)
+            dvbpsi_free(p_pool);
+        return;
+    }
+
+    p_section->p_next = p_pool->p_free[i_class];
+    p_pool->p_free[i_class] = p_section;
+    p_pool->i_free[i_class]++;
+    dvbpsi_mem_tag(p_section, DVBPSI_MEM_POOL);
+}
+
+/*****************************************************************************
+ * dvbpsi_section_buffer_get
+ *****************************************************************************
+ * The previous section of the buffer is complete by the time the next one is
+ * taken, so its reservation is cut down to its actual size.
+ *****************************************************************************/
+dvbpsi_psi_section_t *dvbpsi_section_buffer_get(dvbpsi_t *p_dvbpsi, int i_max_size)
+{
+    dvbpsi_section_buffer_t *p_buffer = p_dvbpsi ? p_dvbpsi->p_section_buffer : NULL;
+    if (p_buffer == NULL)
+        return dvbpsi_NewPSISection(i_max_size);
+
+    if (p_buffer->i_used > 0)
+    {
+        dvbpsi_psi_section_t *p_prev = &p_buffer->p_sections[p_buffer->i_used - 1];
+        size_t i_size = p_prev->p_payload_end - p_prev->p_data
+                      + (p_prev->b_syntax_indicator ? 4 : 0);
+        if (i_size < (size_t)p_prev->i_max_size)
+        {
+            p_buffer->i_data_used -= p_prev->i_max_size - i_size;
+            p_prev->i_max_size = i_size;
+        }
+    }
+
+    if (p_buffer->i_used >= p_buffer->i_sections
+     || p_buffer->i_size - p_buffer->i_data_used < (size_t)i_max_size)
+    {
+        p_buffer->b_overflow = true;
+        return dvbpsi_NewPSISection(i_max_size);
+    }
+
+    dvbpsi_psi_section_t *p_section = &p_buffer->p_sections[p_buffer->i_used++];
+    memset(p_section, 0, sizeof(dvbpsi_psi_section_t));
+    p_section->p_data = p_buffer->p_data + p_buffer->i_data_used;
+    memset(p_section->p_data, 0, i_max_size);
+    p_section->p_payload_end = p_section->p_data;
+    p_section->i_max_size = i_max_size;
+    p_section->b_borrowed = true;
+    p_section->i_arrival = DVBPSI_TIME_NONE;
+    p_buffer->i_data_used += i_max_size;
+
+    return p_section;
+}
+
+/*****************************************************************************
+ * dvbpsi_section_buffer_begin
+ *****************************************************************************/
+void dvbpsi_section_buffer_begin(dvbpsi_t *p_dvbpsi, dvbpsi_section_buffer_t *p_buffer)
+{
+    assert(p_dvbpsi);
+    assert(p_buffer);
+
+    p_buffer->i_used = 0;
+    p_buffer->i_data_used = 0;
+    p_buffer->b_overflow = false;
+    p_dvbpsi->p_section_buffer = p_buffer;
+}
+
+/*****************************************************************************
+ * dvbpsi_section_buffer_end
+ *****************************************************************************/
+int dvbpsi_section_buffer_end(dvbpsi_t *p_dvbpsi, dvbpsi_psi_section_t *p_section)
+{
+    dvbpsi_section_buffer_t *p_buffer = p_dvbpsi->p_section_buffer;
+    p_dvbpsi->p_section_buffer = NULL;
+
+    if (p_section == NULL || p_buffer->b_overflow)
+    {
+        /* Frees the sections allocated beyond the buffer */
+        dvbpsi_DeletePSISections(p_section);
+        if (p_buffer->b_overflow)
+            dvbpsi_error(p_dvbpsi, "PSI encoder", "section buffer too small");
+        return -1;
+    }
+
+    int i_count = 0;
+    for (; p_section; p_section = p_section->p_next)
+        i_count++;
+    return i_count;
+}
+
 /*****************************************************************************
  * dvbpsi_DeletePSISections
  *****************************************************************************
@@ -175,10 +427,23 @@ void dvbpsi_DeletePSISections(dvbpsi_psi_section_t *p_section)
     {
         dvbpsi_psi_section_t* p_next = p_section->p_next;
 
+        if (p_section->b_borrowed)
+        {
+            p_section = p_next;
+            continue;
+        }
+
+        if (p_section->p_pool)
+        {
+            dvbpsi_section_pool_put(p_section->p_pool, p_section);
+            p_section = p_next;
+            continue;
+        }
+
         if (p_section->p_data != NULL)
-            free(p_section->p_data);
+            dvbpsi_free(p_section->p_data);
 
-        free(p_section);
+        dvbpsi_free(p_section);
         p_section = p_next;
     }
     p_section = NULL;
@@ -230,15 +495,8 @@ bool dvbpsi_CheckPSISection(dvbpsi_t *p_dvbpsi, dvbpsi_psi_section_t *p_section,
  *****************************************************************************/
 bool dvbpsi_ValidPSISection(dvbpsi_psi_section_t* p_section)
 {
-    uint32_t i_crc = 0xffffffff;
-    uint8_t* p_byte = p_section->p_data;
-
-    while(p_byte < p_section->p_payload_end + 4)
-    {
-        i_crc = (i_crc << 8) ^ dvbpsi_crc32_table[(i_crc >> 24) ^ (*p_byte)];
-        p_byte++;
-    }
-
+    uint32_t i_crc = dvbpsi_crc32(0xffffffff, p_section->p_data,
+                                  p_section->p_payload_end + 4 - p_section->p_data);
     if (i_crc == 0)
         return true;
     else
@@ -252,15 +510,8 @@ bool dvbpsi_ValidPSISection(dvbpsi_psi_section_t* p_section)
  *****************************************************************************/
 void dvbpsi_CalculateCRC32(dvbpsi_psi_section_t *p_section)
 {
-    uint8_t* p_byte = p_section->p_data;
-    p_section->i_crc = 0xffffffff;
-
-    while (p_byte < p_section->p_payload_end)
-    {
-        p_section->i_crc =   (p_section->i_crc << 8)
-                           ^ dvbpsi_crc32_table[(p_section->i_crc >> 24) ^ (*p_byte)];
-        p_byte++;
-    }
+    p_section->i_crc = dvbpsi_crc32(0xffffffff, p_section->p_data,
+                                    p_section->p_payload_end - p_section->p_data);
 
     p_section->p_payload_end[0] = (p_section->i_crc >> 24) & 0xff;
     p_section->p_payload_end[1] = (p_section->i_crc >> 16) & 0xff;
@@ -268,6 +519,198 @@ void dvbpsi_CalculateCRC32(dvbpsi_psi_section_t *p_section)
     p_section->p_payload_end[3] = p_section->i_crc & 0xff;
 }
 
+/*****************************************************************************
+ * dvbpsi_section_patch
+ *****************************************************************************
+ * Overwrite bytes of an encoded section and update its CRC_32 from the
+ * differences only.
+ *****************************************************************************/
+bool dvbpsi_section_patch(dvbpsi_psi_section_t *p_section, size_t i_offset,
+                          const uint8_t *p_bytes, size_t i_count)
+{
+    assert(p_section);
+    assert(p_bytes || i_count == 0);
+
+    size_t i_size = p_section->p_payload_end - p_section->p_data;
+
+    /* table_id and section_length frame the section */
+    if (i_offset < 3 || i_offset > i_size || i_count > i_size - i_offset)
+        return false;
+    if (i_count == 0)
+        return true;
+
+    uint8_t *p_data = p_section->p_data + i_offset;
+    if (dvbpsi_has_CRC32(p_section))
+    {
+        uint8_t p_xor[16];
+        size_t i_done = 0;
+        while (i_done < i_count)
+        {
+            size_t i_chunk = i_count - i_done;
+            if (i_chunk > sizeof(p_xor))
+                i_chunk = sizeof(p_xor);
+            for (size_t i = 0; i < i_chunk; i++)
+                p_xor[i] = p_data[i_done + i] ^ p_bytes[i_done + i];
+            p_section->i_crc = dvbpsi_crc32_patch(p_section->i_crc, i_size,
+                                                  i_offset + i_done,
+                                                  p_xor, i_chunk);
+            i_done += i_chunk;
+        }
+
+        p_section->p_payload_end[0] = (p_section->i_crc >> 24) & 0xff;
+        p_section->p_payload_end[1] = (p_section->i_crc >> 16) & 0xff;
+        p_section->p_payload_end[2] = (p_section->i_crc >> 8) & 0xff;
+        p_section->p_payload_end[3] = p_section->i_crc & 0xff;
+    }
+    memcpy(p_data, p_bytes, i_count);
+
+    /* Keep the syntax fields of the structure in line with the bytes */
+    if (p_section->b_syntax_indicator && i_offset < 8)
+    {
+        p_section->i_extension = (p_section->p_data[3] << 8) | p_section->p_data[4];
+        p_section->i_version = (p_section->p_data[5] & 0x3e) >> 1;
+        p_section->b_current_next = p_section->p_data[5] & 0x01;
+        p_section->i_number = p_section->p_data[6];
+        p_section->i_last_number = p_section->p_data[7];
+    }
+
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_sections_set_version
+ *****************************************************************************
+ * Patch the version_number and current_next_indicator of encoded sections.
+ *****************************************************************************/
+bool dvbpsi_sections_set_version(dvbpsi_psi_section_t *p_section,
+                                 uint8_t i_version, bool b_current_next)
+{
+    for (; p_section; p_section = p_section->p_next)
+    {
+        if (!p_section->b_syntax_indicator)
+            return false;
+
+        uint8_t i_byte = 0xc0 /* reserved bits set to 1 */
+                       | ((i_version & 0x1f) << 1)
+                       | (b_current_next ? 0x01 : 0x00);
+        if (!dvbpsi_section_patch(p_section, 5, &i_byte, 1))
+            return false;
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_encoder_cache_t
+ *****************************************************************************
+ * Sections hashed on table_id, table_id_extension and section_number, each
+ * with its content up to the CRC_32 and the CRC_32.
+ *****************************************************************************/
+#define DVBPSI_ENCODER_CACHE_BUCKETS 256
+
+typedef struct dvbpsi_encoder_entry_s
+{
+    struct dvbpsi_encoder_entry_s *p_next;
+    uint8_t  i_table_id;
+    uint16_t i_extension;
+    uint8_t  i_number;
+    uint32_t i_crc;
+    size_t   i_size;                        /* bytes before the CRC_32 */
+    uint8_t  p_data[];
+} dvbpsi_encoder_entry_t;
+
+struct dvbpsi_encoder_cache_s
+{
+    dvbpsi_encoder_entry_t *p_buckets[DVBPSI_ENCODER_CACHE_BUCKETS];
+};
+
+/*****************************************************************************
+ * dvbpsi_encoder_cache_delete
+ *****************************************************************************/
+void dvbpsi_encoder_cache_delete(dvbpsi_encoder_cache_t *p_cache)
+{
+    if (p_cache == NULL)
+        return;
+
+    for (int i = 0; i < DVBPSI_ENCODER_CACHE_BUCKETS; i++)
+    {
+        dvbpsi_encoder_entry_t *p_entry = p_cache->p_buckets[i];
+        while (p_entry)
+        {
+            dvbpsi_encoder_entry_t *p_next = p_entry->p_next;
+            dvbpsi_free(p_entry);
+            p_entry = p_next;
+        }
+    }
+    dvbpsi_free(p_cache);
+}
+
+/*****************************************************************************
+ * dvbpsi_encoder_cache_crc
+ *****************************************************************************
+ * Fills in the CRC_32 of p_section from its previous encoding and returns
+ * true when only its version_number may have changed. Otherwise computes
+ * the CRC_32 and records the new encoding, returning false.
+ *****************************************************************************/
+static bool dvbpsi_encoder_cache_crc(dvbpsi_encoder_cache_t *p_cache,
+                                     dvbpsi_psi_section_t *p_section)
+{
+    size_t i_size = p_section->p_payload_end - p_section->p_data;
+    uint8_t *p_data = p_section->p_data;
+    unsigned int i_hash = (p_section->i_table_id * 31u + p_section->i_extension) * 31u
+                        + p_section->i_number;
+    dvbpsi_encoder_entry_t **pp_entry = &p_cache->p_buckets[i_hash % DVBPSI_ENCODER_CACHE_BUCKETS];
+
+    while (*pp_entry && ((*pp_entry)->i_table_id != p_section->i_table_id
+                         || (*pp_entry)->i_extension != p_section->i_extension
+                         || (*pp_entry)->i_number != p_section->i_number))
+        pp_entry = &(*pp_entry)->p_next;
+
+    dvbpsi_encoder_entry_t *p_entry = *pp_entry;
+    if (p_entry && p_entry->i_size == i_size)
+    {
+        /* Byte 5 holds the version_number of sections with the syntax */
+        size_t i_version = p_section->b_syntax_indicator ? 5 : i_size;
+        if (memcmp(p_entry->p_data, p_data, i_version) == 0
+         && (i_version == i_size
+             || memcmp(p_entry->p_data + 6, p_data + 6, i_size - 6) == 0))
+        {
+            if (i_version < i_size && p_entry->p_data[5] != p_data[5])
+            {
+                uint8_t i_xor = p_entry->p_data[5] ^ p_data[5];
+                p_entry->i_crc = dvbpsi_crc32_patch(p_entry->i_crc, i_size, 5,
+                                                    &i_xor, 1);
+                p_entry->p_data[5] = p_data[5];
+            }
+            p_section->i_crc = p_entry->i_crc;
+            p_section->p_payload_end[0] = (p_section->i_crc >> 24) & 0xff;
+            p_section->p_payload_end[1] = (p_section->i_crc >> 16) & 0xff;
+            p_section->p_payload_end[2] = (p_section->i_crc >> 8) & 0xff;
+            p_section->p_payload_end[3] = p_section->i_crc & 0xff;
+            return true;
+        }
+    }
+
+    dvbpsi_CalculateCRC32(p_section);
+
+    /* Record the new encoding */
+    if (p_entry == NULL || p_entry->i_size != i_size)
+    {
+        dvbpsi_encoder_entry_t *p_new = dvbpsi_malloc(sizeof(dvbpsi_encoder_entry_t) + i_size);
+        if (p_new == NULL)
+            return false;
+        p_new->p_next = p_entry ? p_entry->p_next : NULL;
+        p_new->i_table_id = p_section->i_table_id;
+        p_new->i_extension = p_section->i_extension;
+        p_new->i_number = p_section->i_number;
+        p_new->i_size = i_size;
+        dvbpsi_free(p_entry);
+        *pp_entry = p_entry = p_new;
+    }
+    memcpy(p_entry->p_data, p_data, i_size);
+    p_entry->i_crc = p_section->i_crc;
+    return false;
+}
+
 /*****************************************************************************
  * dvbpsi_BuildPSISection
  *****************************************************************************
@@ -306,7 +749,22 @@ void dvbpsi_BuildPSISection(dvbpsi_t *p_dvbpsi, dvbpsi_psi_section_t* p_section)
 
     if (dvbpsi_has_CRC32(p_section))
     {
-        dvbpsi_CalculateCRC32(p_section);
+        dvbpsi_encoder_cache_t *p_cache = NULL;
+        if (p_dvbpsi && (p_dvbpsi->i_flags & DVBPSI_FLAG_ENCODER_CACHE))
+        {
+            if (p_dvbpsi->p_encoder_cache == NULL)
+                p_dvbpsi->p_encoder_cache = dvbpsi_calloc(1, sizeof(dvbpsi_encoder_cache_t));
+            p_cache = p_dvbpsi->p_encoder_cache;
+        }
+
+        if (p_cache == NULL)
+            dvbpsi_CalculateCRC32(p_section);
+        else if (dvbpsi_encoder_cache_crc(p_cache, p_section))
+        {
+            /* Same bytes as a section that passed the check below */
+            p_dvbpsi->stats.i_crc_patched++;
+            return;
+        }
 
         if (!dvbpsi_ValidPSISection(p_section))
         {
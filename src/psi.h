@@ -94,6 +94,20 @@ struct dvbpsi_psi_section_s
   /* list handling */
   struct dvbpsi_psi_section_s *         p_next;         /*!< next element of
                                                              the list */
+
+  /* memory handling */
+  int           i_max_size;             /*!< size of the p_data area */
+  struct dvbpsi_section_pool_s *        p_pool;         /*!< private, pool
+                                                             owning the section
+                                                             or NULL */
+  bool          b_borrowed;             /*!< p_data points into a TS packet,
+                                             see DVBPSI_FLAG_ZERO_COPY, or
+                                             the section belongs to a
+                                             dvbpsi_section_buffer_t */
+
+  int64_t       i_arrival;              /*!< arrival time of its first TS
+                                             packet or DVBPSI_TIME_NONE,
+                                             see dvbpsi_packet_push_at() */
 };
 
 /*****************************************************************************
@@ -115,9 +129,40 @@ dvbpsi_psi_section_t * dvbpsi_NewPSISection(int i_max_size);
  * \brief Destruction of a dvbpsi_psi_section_t structure.
  * \param p_section pointer to the first PSI section structure
  * \return nothing.
+ *
+ * Sections assembled by the PSI decoder are given back to the section pool
+ * of their dvbpsi_t handle instead of being freed. Borrowed sections are
+ * left alone.
  */
 void dvbpsi_DeletePSISections(dvbpsi_psi_section_t * p_section);
 
+/*****************************************************************************
+ * dvbpsi_section_buffer_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_section_buffer_s
+ * \brief Caller memory the dvbpsi_xxx_sections_generate_into() functions
+ * write sections into.
+ *
+ * The section structures are taken from p_sections and their content from
+ * p_data, where the sections follow each other without gaps. While it is
+ * being built a section reserves the maximum size of its table in p_data,
+ * 1024 bytes, 4094 for EIT and 4096 for a TOT. The buffer can be reused for
+ * the next generation once the sections have been sent, and nothing has to
+ * be freed.
+ */
+struct dvbpsi_section_buffer_s
+{
+  dvbpsi_psi_section_t *p_sections;     /*!< array of section structures */
+  int                   i_sections;     /*!< size of p_sections */
+  uint8_t *             p_data;         /*!< area for the section contents */
+  size_t                i_size;         /*!< size of p_data */
+
+  int                   i_used;         /*!< private, sections taken */
+  size_t                i_data_used;    /*!< private, bytes taken */
+  bool                  b_overflow;     /*!< private, buffer too small */
+};
+
 /*****************************************************************************
  * dvbpsi_CheckPSISection
  *****************************************************************************/
@@ -174,6 +219,48 @@ void dvbpsi_BuildPSISection(dvbpsi_t *p_dvbpsi, dvbpsi_psi_section_t* p_section)
  */
 void dvbpsi_CalculateCRC32(dvbpsi_psi_section_t *p_section);
 
+/*****************************************************************************
+ * dvbpsi_section_patch
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_section_patch(dvbpsi_psi_section_t *p_section,
+ *                               size_t i_offset, const uint8_t *p_bytes,
+ *                               size_t i_count)
+ * \brief Overwrite bytes of a built section, updating its CRC_32
+ * incrementally instead of running it over the whole section again.
+ * \param p_section pointer to a section built by dvbpsi_BuildPSISection() or
+ * decoded, with p_payload_end before the CRC32 field
+ * \param i_offset offset of the first byte to overwrite from the start of
+ * the section, at least 3 so that table_id and section_length stay
+ * \param p_bytes new bytes
+ * \param i_count number of bytes, which must end before the CRC32 field
+ * \return false if the bytes are out of range, in which case the section is
+ * left as is, true otherwise.
+ *
+ * The cost is O(i_count + log n) for a section of n bytes. The
+ * table_id_extension, version_number, current_next_indicator and section
+ * numbers of the structure are updated when the bytes cover them.
+ */
+bool dvbpsi_section_patch(dvbpsi_psi_section_t *p_section, size_t i_offset,
+                          const uint8_t *p_bytes, size_t i_count);
+
+/*****************************************************************************
+ * dvbpsi_sections_set_version
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_sections_set_version(dvbpsi_psi_section_t *p_section,
+ *                                      uint8_t i_version, bool b_current_next)
+ * \brief Change the version_number and current_next_indicator of a list of
+ * built sections with dvbpsi_section_patch().
+ * \param p_section pointer to the first section of the list
+ * \param i_version new version_number
+ * \param b_current_next new current_next_indicator
+ * \return false if a section has no section_syntax_indicator, the sections
+ * before it being patched, true otherwise.
+ */
+bool dvbpsi_sections_set_version(dvbpsi_psi_section_t *p_section,
+                                 uint8_t i_version, bool b_current_next);
+
 /*****************************************************************************
  * dvbpsi_has_CRC32
  *****************************************************************************/
@@ -0,0 +1,340 @@
+/*****************************************************************************
+ * pull.c: tables and events queued on a handle
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "descriptor.h"
+#include "tables/pat.h"
+#include "tables/cat.h"
+#include "tables/pmt.h"
+#include "tables/sdt.h"
+#include "tables/eit.h"
+#include "tables/nit.h"
+#include "tables/bat.h"
+#include "tables/tot.h"
+#include "pull.h"
+
+/*****************************************************************************
+ * dvbpsi_pull_t
+ *****************************************************************************
+ * Queue of a handle, see dvbpsi_t.p_pull.
+ *****************************************************************************/
+typedef struct dvbpsi_pull_s dvbpsi_pull_t;
+
+struct dvbpsi_pull_s
+{
+    dvbpsi_pull_event_t    *p_entries;  /* ring of i_size entries */
+    size_t                  i_size;
+    size_t                  i_head;     /* oldest entry */
+    size_t                  i_count;
+
+    /* Event callback of the handle before the queue */
+    dvbpsi_event_cb         pf_event;
+    void *                  p_event_data;
+
+    dvbpsi_pull_stats_t     stats;
+};
+
+/*****************************************************************************
+ * dvbpsi_pull_queue
+ *****************************************************************************
+ * Room for a new entry, NULL if the queue is full.
+ *****************************************************************************/
+static dvbpsi_pull_event_t *dvbpsi_pull_queue(dvbpsi_pull_t *p_pull)
+{
+    if (p_pull->i_count == p_pull->i_size)
+    {
+        p_pull->stats.i_dropped++;
+        return NULL;
+    }
+
+    dvbpsi_pull_event_t *p_entry =
+        &p_pull->p_entries[(p_pull->i_head + p_pull->i_count) % p_pull->i_size];
+    p_pull->i_count++;
+    if (p_pull->i_count > p_pull->stats.i_max_depth)
+        p_pull->stats.i_max_depth = p_pull->i_count;
+    return p_entry;
+}
+
+/*****************************************************************************
+ * dvbpsi_pull_on_event
+ *****************************************************************************
+ * Event callback of a handle with a queue.
+ *****************************************************************************/
+static void dvbpsi_pull_on_event(dvbpsi_t *p_dvbpsi, const dvbpsi_event_t *p_event,
+                                 void *p_cb_data)
+{
+    dvbpsi_pull_t *p_pull = (dvbpsi_pull_t *)p_cb_data;
+
+    dvbpsi_pull_event_t *p_entry = dvbpsi_pull_queue(p_pull);
+    if (p_entry)
+    {
+        memset(p_entry, 0, sizeof(dvbpsi_pull_event_t));
+        p_entry->i_type = DVBPSI_PULL_EVENT;
+        p_entry->i_table_id = p_event->i_table_id;
+        p_entry->i_extension = p_event->i_extension;
+        p_entry->event = *p_event;
+        p_pull->stats.i_events++;
+    }
+
+    if (p_pull->pf_event)
+        p_pull->pf_event(p_dvbpsi, p_event, p_pull->p_event_data);
+}
+
+/*****************************************************************************
+ * dvbpsi_pull_attach
+ *****************************************************************************/
+bool dvbpsi_pull_attach(dvbpsi_t *p_dvbpsi, size_t i_size)
+{
+    assert(p_dvbpsi);
+
+    if (p_dvbpsi->p_pull || i_size == 0)
+        return false;
+
+    dvbpsi_pull_t *p_pull = dvbpsi_calloc(1, sizeof(dvbpsi_pull_t));
+    if (p_pull == NULL)
+        return false;
+
+    p_pull->p_entries = dvbpsi_calloc(i_size, sizeof(dvbpsi_pull_event_t));
+    if (p_pull->p_entries == NULL)
+    {
+        dvbpsi_free(p_pull);
+        return false;
+    }
+    p_pull->i_size = i_size;
+    p_pull->pf_event = p_dvbpsi->pf_event;
+    p_pull->p_event_data = p_dvbpsi->p_event_data;
+
+    p_dvbpsi->p_pull = p_pull;
+    dvbpsi_set_event_cb(p_dvbpsi, dvbpsi_pull_on_event, p_pull);
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_pull_detach
+ *****************************************************************************/
+void dvbpsi_pull_detach(dvbpsi_t *p_dvbpsi)
+{
+    assert(p_dvbpsi);
+
+    dvbpsi_pull_t *p_pull = p_dvbpsi->p_pull;
+    if (p_pull == NULL)
+        return;
+
+    for (size_t i = 0; i < p_pull->i_count; i++)
+    {
+        dvbpsi_pull_event_t *p_entry = &p_pull->p_entries[(p_pull->i_head + i) % p_pull->i_size];
+        if (p_entry->i_type == DVBPSI_PULL_TABLE)
+            p_entry->pf_delete(p_entry->p_table);
+    }
+
+    if (p_dvbpsi->pf_event == dvbpsi_pull_on_event)
+        dvbpsi_set_event_cb(p_dvbpsi, p_pull->pf_event, p_pull->p_event_data);
+    p_dvbpsi->p_pull = NULL;
+
+    dvbpsi_free(p_pull->p_entries);
+    dvbpsi_free(p_pull);
+}
+
+/*****************************************************************************
+ * dvbpsi_pull_table
+ *****************************************************************************
+ * Queues a table, deleting it if the queue is full.
+ *****************************************************************************/
+static void dvbpsi_pull_table(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_extension,
+                              void *p_table, void (*pf_delete)(void *))
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_pull);
+
+    dvbpsi_pull_t *p_pull = p_dvbpsi->p_pull;
+    dvbpsi_pull_event_t *p_entry = dvbpsi_pull_queue(p_pull);
+    if (p_entry == NULL)
+    {
+        pf_delete(p_table);
+        return;
+    }
+
+    memset(p_entry, 0, sizeof(dvbpsi_pull_event_t));
+    p_entry->i_type = DVBPSI_PULL_TABLE;
+    p_entry->i_table_id = i_table_id;
+    p_entry->i_extension = i_extension;
+    p_entry->p_table = p_table;
+    p_entry->pf_delete = pf_delete;
+    p_pull->stats.i_tables++;
+}
+
+/*****************************************************************************
+ * dvbpsi_pull_pat/cat/pmt/sdt/eit/nit/bat/tot
+ *****************************************************************************/
+static void dvbpsi_pull_delete_pat(void *p_table)
+{
+    dvbpsi_pat_delete(p_table);
+}
+
+static void dvbpsi_pull_delete_cat(void *p_table)
+{
+    dvbpsi_cat_delete(p_table);
+}
+
+static void dvbpsi_pull_delete_pmt(void *p_table)
+{
+    dvbpsi_pmt_delete(p_table);
+}
+
+static void dvbpsi_pull_delete_sdt(void *p_table)
+{
+    dvbpsi_sdt_delete(p_table);
+}
+
+static void dvbpsi_pull_delete_eit(void *p_table)
+{
+    dvbpsi_eit_delete(p_table);
+}
+
+static void dvbpsi_pull_delete_nit(void *p_table)
+{
+    dvbpsi_nit_delete(p_table);
+}
+
+static void dvbpsi_pull_delete_bat(void *p_table)
+{
+    dvbpsi_bat_delete(p_table);
+}
+
+static void dvbpsi_pull_delete_tot(void *p_table)
+{
+    dvbpsi_tot_delete(p_table);
+}
+
+void dvbpsi_pull_pat(void *p_dvbpsi, dvbpsi_pat_t *p_pat)
+{
+    dvbpsi_pull_table(p_dvbpsi, 0x00, p_pat->i_ts_id, p_pat, dvbpsi_pull_delete_pat);
+}
+
+void dvbpsi_pull_cat(void *p_dvbpsi, dvbpsi_cat_t *p_cat)
+{
+    dvbpsi_pull_table(p_dvbpsi, 0x01, 0, p_cat, dvbpsi_pull_delete_cat);
+}
+
+void dvbpsi_pull_pmt(void *p_dvbpsi, dvbpsi_pmt_t *p_pmt)
+{
+    dvbpsi_pull_table(p_dvbpsi, 0x02, p_pmt->i_program_number, p_pmt,
+                      dvbpsi_pull_delete_pmt);
+}
+
+void dvbpsi_pull_sdt(void *p_dvbpsi, dvbpsi_sdt_t *p_sdt)
+{
+    dvbpsi_pull_table(p_dvbpsi, p_sdt->i_table_id, p_sdt->i_extension, p_sdt,
+                      dvbpsi_pull_delete_sdt);
+}
+
+void dvbpsi_pull_eit(void *p_dvbpsi, dvbpsi_eit_t *p_eit)
+{
+    dvbpsi_pull_table(p_dvbpsi, p_eit->i_table_id, p_eit->i_extension, p_eit,
+                      dvbpsi_pull_delete_eit);
+}
+
+void dvbpsi_pull_nit(void *p_dvbpsi, dvbpsi_nit_t *p_nit)
+{
+    dvbpsi_pull_table(p_dvbpsi, p_nit->i_table_id, p_nit->i_extension, p_nit,
+                      dvbpsi_pull_delete_nit);
+}
+
+void dvbpsi_pull_bat(void *p_dvbpsi, dvbpsi_bat_t *p_bat)
+{
+    dvbpsi_pull_table(p_dvbpsi, p_bat->i_table_id, p_bat->i_extension, p_bat,
+                      dvbpsi_pull_delete_bat);
+}
+
+void dvbpsi_pull_tot(void *p_dvbpsi, dvbpsi_tot_t *p_tot)
+{
+    dvbpsi_pull_table(p_dvbpsi, p_tot->i_table_id, p_tot->i_extension, p_tot,
+                      dvbpsi_pull_delete_tot);
+}
+
+/*****************************************************************************
+ * dvbpsi_next_events
+ *****************************************************************************/
+size_t dvbpsi_next_events(dvbpsi_t *p_dvbpsi, dvbpsi_pull_event_t *p_events,
+                          size_t i_max)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_pull);
+
+    dvbpsi_pull_t *p_pull = p_dvbpsi->p_pull;
+    size_t i_taken = 0;
+    while (i_taken < i_max && p_pull->i_count > 0)
+    {
+        /* Copy the contiguous run up to the end of the ring at once */
+        size_t i_run = p_pull->i_size - p_pull->i_head;
+        if (i_run > p_pull->i_count)
+            i_run = p_pull->i_count;
+        if (i_run > i_max - i_taken)
+            i_run = i_max - i_taken;
+        memcpy(&p_events[i_taken], &p_pull->p_entries[p_pull->i_head],
+               i_run * sizeof(dvbpsi_pull_event_t));
+        p_pull->i_head = (p_pull->i_head + i_run) % p_pull->i_size;
+        p_pull->i_count -= i_run;
+        i_taken += i_run;
+    }
+    if (p_pull->i_count == 0)
+        p_pull->i_head = 0;
+    return i_taken;
+}
+
+/*****************************************************************************
+ * dvbpsi_next_event
+ *****************************************************************************/
+bool dvbpsi_next_event(dvbpsi_t *p_dvbpsi, dvbpsi_pull_event_t *p_event)
+{
+    return dvbpsi_next_events(p_dvbpsi, p_event, 1) == 1;
+}
+
+/*****************************************************************************
+ * dvbpsi_pull_get_stats
+ *****************************************************************************/
+void dvbpsi_pull_get_stats(dvbpsi_t *p_dvbpsi, dvbpsi_pull_stats_t *p_stats)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_pull);
+
+    *p_stats = p_dvbpsi->p_pull->stats;
+    p_stats->i_depth = p_dvbpsi->p_pull->i_count;
+}
@@ -0,0 +1,227 @@
+/*****************************************************************************
+ * pull.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <pull.h>
+ * \brief Pull model: tables and events queued on a handle for the
+ * application to take after each push.
+ *
+ * Instead of handling each table in the callback of its decoder, from
+ * inside dvbpsi_packet_push(), the application gives the decoders one of
+ * the dvbpsi_pull_pat(), dvbpsi_pull_pmt(), ... callbacks, which queue the
+ * tables on a handle, and takes them once the push returned with
+ * dvbpsi_next_event(), or several at a time with dvbpsi_next_events().
+ * The events of the handle, see dvbpsi_event_t, are queued among the
+ * tables in the order they happen: a DVBPSI_EVENT_VERSION_CHANGE comes
+ * right after the table of the new version.
+ *
+ * The queue holds a fixed number of entries and allocates nothing once
+ * attached. When it is full, a new table is deleted and a new event
+ * dropped, both counted. It is not locked: the pushes into a handle and
+ * the polls of its queue are made by one thread at a time.
+ */
+
+#ifndef _DVBPSI_PULL_H_
+#define _DVBPSI_PULL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_pull_event_t
+ *****************************************************************************/
+/*!
+ * \enum dvbpsi_pull_type
+ * \brief Kinds of entries of a pull queue
+ */
+enum dvbpsi_pull_type
+{
+    DVBPSI_PULL_TABLE = 0,      /*!< table completed by a decoder */
+    DVBPSI_PULL_EVENT,          /*!< event of the handle */
+};
+/*!
+ * \typedef enum dvbpsi_pull_type dvbpsi_pull_type_t
+ * \brief dvbpsi_pull_type_t type definition.
+ */
+typedef enum dvbpsi_pull_type dvbpsi_pull_type_t;
+
+/*!
+ * \struct dvbpsi_pull_event_s
+ * \brief Entry taken from a pull queue
+ */
+/*!
+ * \typedef struct dvbpsi_pull_event_s dvbpsi_pull_event_t
+ * \brief dvbpsi_pull_event_t type definition.
+ */
+typedef struct dvbpsi_pull_event_s
+{
+    dvbpsi_pull_type_t  i_type;         /*!< table or event */
+    uint8_t             i_table_id;     /*!< table_id of the table or of
+                                             the event */
+    uint16_t            i_extension;    /*!< table_id_extension of the table
+                                             or of the event */
+    void *              p_table;        /*!< DVBPSI_PULL_TABLE: the
+                                             dvbpsi_pat_t, dvbpsi_pmt_t, ...
+                                             of i_table_id, owned by the
+                                             application */
+    void             (* pf_delete)(void *); /*!< DVBPSI_PULL_TABLE: function
+                                             deleting p_table, such as
+                                             dvbpsi_pmt_delete() */
+    dvbpsi_event_t      event;          /*!< DVBPSI_PULL_EVENT: the event */
+} dvbpsi_pull_event_t;
+
+/*****************************************************************************
+ * dvbpsi_pull_stats_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_pull_stats_s
+ * \brief Counters of a pull queue.
+ */
+/*!
+ * \typedef struct dvbpsi_pull_stats_s dvbpsi_pull_stats_t
+ * \brief dvbpsi_pull_stats_t type definition.
+ */
+typedef struct dvbpsi_pull_stats_s
+{
+    uint64_t    i_tables;       /*!< tables queued */
+    uint64_t    i_events;       /*!< events queued */
+    uint64_t    i_dropped;      /*!< tables deleted and events dropped as
+                                     the queue was full */
+    size_t      i_depth;        /*!< entries queued */
+    size_t      i_max_depth;    /*!< highest number of entries queued */
+} dvbpsi_pull_stats_t;
+
+/*****************************************************************************
+ * dvbpsi_pull_attach
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_pull_attach(dvbpsi_t *p_dvbpsi, size_t i_size)
+ * \brief Creates the pull queue of a handle
+ * \param p_dvbpsi handle
+ * \param i_size maximum number of entries queued
+ * \return false if the handle already has a queue or on error, true
+ *         otherwise.
+ *
+ * The queue takes the events of the handle through its event callback:
+ * the callback set before, see dvbpsi_set_event_cb(), is still called
+ * after each event is queued, and must not be changed until
+ * dvbpsi_pull_detach().
+ */
+bool dvbpsi_pull_attach(dvbpsi_t *p_dvbpsi, size_t i_size);
+
+/*****************************************************************************
+ * dvbpsi_pull_detach
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_pull_detach(dvbpsi_t *p_dvbpsi)
+ * \brief Deletes the pull queue of a handle and the tables still queued
+ * \param p_dvbpsi handle
+ * \return nothing.
+ *
+ * To be called before dvbpsi_delete(), and after the decoders queueing
+ * into it are detached.
+ */
+void dvbpsi_pull_detach(dvbpsi_t *p_dvbpsi);
+
+/*****************************************************************************
+ * dvbpsi_pull_pat/cat/pmt/sdt/eit/nit/bat/tot
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_pull_pat(void *p_dvbpsi, dvbpsi_pat_t *p_pat)
+ * \brief PAT callback queueing the table on a handle
+ * \param p_dvbpsi handle with a pull queue, given as callback data to the
+ *        decoder, which may be attached to another handle
+ * \param p_pat new PAT
+ * \return nothing.
+ *
+ * dvbpsi_pull_cat(), dvbpsi_pull_pmt(), dvbpsi_pull_sdt(),
+ * dvbpsi_pull_eit(), dvbpsi_pull_nit(), dvbpsi_pull_bat() and
+ * dvbpsi_pull_tot() are the same for the other tables, the subtable being
+ * given by table_id and extension: program_number for a PMT, 0 for a CAT
+ * and transport_stream_id for a PAT. The events of a decoder attached to
+ * another handle are only queued by the queue of that handle.
+ */
+void dvbpsi_pull_pat(void *p_dvbpsi, dvbpsi_pat_t *p_pat);
+/*! \brief CAT callback, see dvbpsi_pull_pat() */
+void dvbpsi_pull_cat(void *p_dvbpsi, dvbpsi_cat_t *p_cat);
+/*! \brief PMT callback, see dvbpsi_pull_pat() */
+void dvbpsi_pull_pmt(void *p_dvbpsi, dvbpsi_pmt_t *p_pmt);
+/*! \brief SDT callback, see dvbpsi_pull_pat() */
+void dvbpsi_pull_sdt(void *p_dvbpsi, dvbpsi_sdt_t *p_sdt);
+/*! \brief EIT callback, see dvbpsi_pull_pat() */
+void dvbpsi_pull_eit(void *p_dvbpsi, dvbpsi_eit_t *p_eit);
+/*! \brief NIT callback, see dvbpsi_pull_pat() */
+void dvbpsi_pull_nit(void *p_dvbpsi, dvbpsi_nit_t *p_nit);
+/*! \brief BAT callback, see dvbpsi_pull_pat() */
+void dvbpsi_pull_bat(void *p_dvbpsi, dvbpsi_bat_t *p_bat);
+/*! \brief TDT/TOT callback, see dvbpsi_pull_pat() */
+void dvbpsi_pull_tot(void *p_dvbpsi, dvbpsi_tot_t *p_tot);
+
+/*****************************************************************************
+ * dvbpsi_next_event
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_next_event(dvbpsi_t *p_dvbpsi, dvbpsi_pull_event_t *p_event)
+ * \brief Takes the oldest entry of the pull queue of a handle
+ * \param p_dvbpsi handle with a pull queue
+ * \param p_event filled with the entry, the application then owning its
+ *        table
+ * \return false if the queue is empty, true otherwise.
+ */
+bool dvbpsi_next_event(dvbpsi_t *p_dvbpsi, dvbpsi_pull_event_t *p_event);
+
+/*****************************************************************************
+ * dvbpsi_next_events
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_next_events(dvbpsi_t *p_dvbpsi,
+ *                               dvbpsi_pull_event_t *p_events, size_t i_max)
+ * \brief Takes the oldest entries of the pull queue of a handle at once
+ * \param p_dvbpsi handle with a pull queue
+ * \param p_events array filled with the entries, oldest first
+ * \param i_max number of entries of the array
+ * \return the number of entries taken.
+ */
+size_t dvbpsi_next_events(dvbpsi_t *p_dvbpsi, dvbpsi_pull_event_t *p_events,
+                          size_t i_max);
+
+/*****************************************************************************
+ * dvbpsi_pull_get_stats
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_pull_get_stats(dvbpsi_t *p_dvbpsi,
+ *                                dvbpsi_pull_stats_t *p_stats)
+ * \brief Gets the counters of the pull queue of a handle
+ * \param p_dvbpsi handle with a pull queue
+ * \param p_stats filled with the counters
+ * \return nothing.
+ */
+void dvbpsi_pull_get_stats(dvbpsi_t *p_dvbpsi, dvbpsi_pull_stats_t *p_stats);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of pull.h"
+#endif
@@ -0,0 +1,719 @@
+/*****************************************************************************
+ * replica.c: replication of the sections of a stream
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "replica.h"
+
+#define REPLICA_BUCKETS         256
+#define REPLICA_SECTION_MAX     4096
+#define REPLICA_FRAME_HEADER    20
+#define REPLICA_RECORD_HEADER   5
+#define REPLICA_DELTA_HEADER    11
+#define REPLICA_FRAME_DEFAULT   1400
+
+#define REPLICA_RECORD_SECTION  0
+#define REPLICA_RECORD_DELTA    1
+
+#define REPLICA_FLAG_KEYFRAME   0x01
+#define REPLICA_FLAG_SYNTAX     0x01
+#define REPLICA_FLAG_CURRENT    0x02
+
+/*****************************************************************************
+ * dvbpsi_replica_entry_t
+ *****************************************************************************
+ * Last copy of a section, by its key.
+ *****************************************************************************/
+typedef struct dvbpsi_replica_entry_s
+{
+    struct dvbpsi_replica_entry_s *p_next;
+    uint64_t i_key;
+    size_t   i_size;
+    uint8_t  p_data[];
+} dvbpsi_replica_entry_t;
+
+/*****************************************************************************
+ * dvbpsi_replica_sender_s
+ *****************************************************************************/
+struct dvbpsi_replica_sender_s
+{
+    dvbpsi_replica_options_t options;
+    dvbpsi_replica_output_cb pf_output;
+    void *                   p_cb_data;
+
+    dvbpsi_replica_entry_t * p_buckets[REPLICA_BUCKETS];
+
+    uint8_t *  p_frame;             /* frame being filled */
+    size_t     i_length;            /* its length */
+    unsigned   i_records;           /* its records */
+    uint8_t    i_flags;             /* its flags */
+    int64_t    i_first_time;        /* time of its first section */
+    int64_t    i_last_time;         /* time of the last section */
+    int64_t    i_keyframe_time;     /* time of the last keyframe */
+    uint32_t   i_sequence;          /* sequence number of the next frame */
+
+    uint8_t    p_delta[REPLICA_DELTA_HEADER + REPLICA_SECTION_MAX];
+
+    dvbpsi_replica_stats_t stats;
+};
+
+/*****************************************************************************
+ * dvbpsi_replica_receiver_s
+ *****************************************************************************/
+struct dvbpsi_replica_receiver_s
+{
+    dvbpsi_replica_handle_cb pf_handle;
+    void *                   p_cb_data;
+
+    dvbpsi_replica_entry_t * p_buckets[REPLICA_BUCKETS];
+
+    bool       b_sequence;          /* a frame was received */
+    uint32_t   i_sequence;          /* sequence number expected */
+
+    uint8_t    p_section[REPLICA_SECTION_MAX];
+
+    dvbpsi_replica_stats_t stats;
+};
+
+/*****************************************************************************
+ * replica_key
+ *****************************************************************************
+ * Key of a section: PID and table_id, with the table_id_extension,
+ * section_number and current_next_indicator of the long sections.
+ *****************************************************************************/
+static uint64_t replica_key(uint16_t i_pid, uint8_t i_table_id, uint16_t i_extension,
+                            uint8_t i_number, uint8_t i_flags)
+{
+    uint64_t i_key = (uint64_t)i_pid << 40 | (uint64_t)i_table_id << 32;
+    if (i_flags & REPLICA_FLAG_SYNTAX)
+        i_key |= (uint64_t)i_extension << 16 | (uint64_t)i_number << 8 | i_flags;
+    return i_key;
+}
+
+/*****************************************************************************
+ * replica_section_key
+ *****************************************************************************
+ * Fills the fields of the key of a section, returning its key.
+ *****************************************************************************/
+static uint64_t replica_section_key(uint16_t i_pid, const uint8_t *p_section, size_t i_size,
+                                    uint16_t *pi_extension, uint8_t *pi_number,
+                                    uint8_t *pi_flags)
+{
+    *pi_extension = 0;
+    *pi_number = 0;
+    *pi_flags = 0;
+    if ((p_section[1] & 0x80) && i_size >= 8)
+    {
+        *pi_extension = (uint16_t)(p_section[3] << 8 | p_section[4]);
+        *pi_number = p_section[6];
+        *pi_flags = REPLICA_FLAG_SYNTAX
+                  | ((p_section[5] & 0x01) ? REPLICA_FLAG_CURRENT : 0);
+    }
+    return replica_key(i_pid, p_section[0], *pi_extension, *pi_number, *pi_flags);
+}
+
+/*****************************************************************************
+ * replica_hash
+ *****************************************************************************
+ * FNV-1a hash of a section, naming the base of a delta.
+ *****************************************************************************/
+static uint32_t replica_hash(const uint8_t *p_data, size_t i_size)
+{
+    uint32_t i_hash = 2166136261u;
+    for (size_t i = 0; i < i_size; i++)
+        i_hash = (i_hash ^ p_data[i]) * 16777619u;
+    return i_hash;
+}
+
+/*****************************************************************************
+ * replica_bucket
+ *****************************************************************************/
+static dvbpsi_replica_entry_t **replica_bucket(dvbpsi_replica_entry_t **pp_buckets,
+                                               uint64_t i_key)
+{
+    uint32_t i_fold = (uint32_t)(i_key ^ i_key >> 32);
+    return &pp_buckets[(i_fold * 2654435761u) >> 24];
+}
+
+/*****************************************************************************
+ * replica_find
+ *****************************************************************************/
+static dvbpsi_replica_entry_t *replica_find(dvbpsi_replica_entry_t **pp_buckets,
+                                            uint64_t i_key)
+{
+    dvbpsi_replica_entry_t *p_entry = *replica_bucket(pp_buckets, i_key);
+    while (p_entry && p_entry->i_key != i_key)
+        p_entry = p_entry->p_next;
+    return p_entry;
+}
+
+/*****************************************************************************
+ * replica_store
+ *****************************************************************************
+ * Keeps a copy of a section, replacing the previous one.
+ *****************************************************************************/
+static bool replica_store(dvbpsi_replica_entry_t **pp_buckets, uint64_t i_key,
+                          const uint8_t *p_data, size_t i_size)
+{
+    dvbpsi_replica_entry_t **pp_entry = replica_bucket(pp_buckets, i_key);
+    while (*pp_entry && (*pp_entry)->i_key != i_key)
+        pp_entry = &(*pp_entry)->p_next;
+
+    dvbpsi_replica_entry_t *p_entry = *pp_entry;
+    if (p_entry == NULL || p_entry->i_size != i_size)
+    {
+        dvbpsi_replica_entry_t *p_new = dvbpsi_malloc(sizeof(dvbpsi_replica_entry_t) + i_size);
+        if (p_new == NULL)
+            return false;
+        p_new->i_key = i_key;
+        p_new->i_size = i_size;
+        if (p_entry)
+        {
+            p_new->p_next = p_entry->p_next;
+            dvbpsi_free(p_entry);
+        }
+        else
+            p_new->p_next = NULL;
+        *pp_entry = p_entry = p_new;
+    }
+    memcpy(p_entry->p_data, p_data, i_size);
+    return true;
+}
+
+/*****************************************************************************
+ * replica_clear
+ *****************************************************************************/
+static void replica_clear(dvbpsi_replica_entry_t **pp_buckets)
+{
+    for (int i = 0; i < REPLICA_BUCKETS; i++)
+    {
+        dvbpsi_replica_entry_t *p_entry = pp_buckets[i];
+        while (p_entry)
+        {
+            dvbpsi_replica_entry_t *p_next = p_entry->p_next;
+            dvbpsi_free(p_entry);
+            p_entry = p_next;
+        }
+        pp_buckets[i] = NULL;
+    }
+}
+
+/*****************************************************************************
+ * replica_put16, replica_get16...
+ *****************************************************************************/
+static void replica_put16(uint8_t *p, uint16_t i)
+{
+    p[0] = i;
+    p[1] = i >> 8;
+}
+
+static void replica_put32(uint8_t *p, uint32_t i)
+{
+    replica_put16(p, i);
+    replica_put16(p + 2, i >> 16);
+}
+
+static uint16_t replica_get16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t replica_get32(const uint8_t *p)
+{
+    return replica_get16(p) | (uint32_t)replica_get16(p + 2) << 16;
+}
+
+/*****************************************************************************
+ * dvbpsi_replica_sender_new
+ *****************************************************************************/
+dvbpsi_replica_sender_t *dvbpsi_replica_sender_new(const dvbpsi_replica_options_t *p_options,
+                                                   dvbpsi_replica_output_cb pf_output,
+                                                   void *p_cb_data)
+{
+    assert(pf_output);
+
+    dvbpsi_replica_sender_t *p_sender = dvbpsi_calloc(1, sizeof(dvbpsi_replica_sender_t));
+    if (p_sender == NULL)
+        return NULL;
+
+    if (p_options)
+        p_sender->options = *p_options;
+    if (p_sender->options.i_frame_size == 0)
+        p_sender->options.i_frame_size = REPLICA_FRAME_DEFAULT;
+    if (p_options == NULL)
+        p_sender->options.i_batch_time = INT64_MAX;
+
+    /* A record larger than the frame size still fits, alone */
+    size_t i_frame = REPLICA_FRAME_HEADER + REPLICA_RECORD_HEADER + REPLICA_SECTION_MAX;
+    if (i_frame < p_sender->options.i_frame_size)
+        i_frame = p_sender->options.i_frame_size;
+    p_sender->p_frame = dvbpsi_malloc(i_frame);
+    if (p_sender->p_frame == NULL)
+    {
+        dvbpsi_free(p_sender);
+        return NULL;
+    }
+
+    p_sender->pf_output = pf_output;
+    p_sender->p_cb_data = p_cb_data;
+    p_sender->i_length = REPLICA_FRAME_HEADER;
+    p_sender->i_first_time = DVBPSI_TIME_NONE;
+    p_sender->i_last_time = DVBPSI_TIME_NONE;
+    p_sender->i_keyframe_time = DVBPSI_TIME_NONE;
+    return p_sender;
+}
+
+/*****************************************************************************
+ * dvbpsi_replica_sender_delete
+ *****************************************************************************/
+void dvbpsi_replica_sender_delete(dvbpsi_replica_sender_t *p_sender)
+{
+    if (p_sender == NULL)
+        return;
+
+    replica_clear(p_sender->p_buckets);
+    dvbpsi_free(p_sender->p_frame);
+    dvbpsi_free(p_sender);
+}
+
+/*****************************************************************************
+ * dvbpsi_replica_flush
+ *****************************************************************************/
+void dvbpsi_replica_flush(dvbpsi_replica_sender_t *p_sender)
+{
+    assert(p_sender);
+
+    if (p_sender->i_records == 0)
+        return;
+
+    uint8_t *p = p_sender->p_frame;
+    p[0] = 'D';
+    p[1] = 'R';
+    p[2] = 1;
+    p[3] = p_sender->i_flags;
+    replica_put32(p + 4, p_sender->i_sequence++);
+    replica_put32(p + 8, (uint32_t)p_sender->i_last_time);
+    replica_put32(p + 12, (uint32_t)((uint64_t)p_sender->i_last_time >> 32));
+    replica_put16(p + 16, p_sender->i_records);
+    replica_put16(p + 18, 0);
+
+    p_sender->stats.i_frames++;
+    p_sender->stats.i_bytes += p_sender->i_length;
+    p_sender->pf_output(p_sender->p_cb_data, p, p_sender->i_length);
+
+    p_sender->i_length = REPLICA_FRAME_HEADER;
+    p_sender->i_records = 0;
+    p_sender->i_first_time = DVBPSI_TIME_NONE;
+}
+
+/*****************************************************************************
+ * replica_append
+ *****************************************************************************
+ * Adds a record to the frame, sending it first if the record does not fit.
+ *****************************************************************************/
+static void replica_append(dvbpsi_replica_sender_t *p_sender, uint8_t i_type,
+                           uint16_t i_pid, int64_t i_time,
+                           const uint8_t *p_data, size_t i_size)
+{
+    size_t i_record = REPLICA_RECORD_HEADER + i_size;
+    if (p_sender->i_records > 0
+     && (p_sender->i_length + i_record > p_sender->options.i_frame_size
+      || p_sender->i_records == UINT16_MAX))
+        dvbpsi_replica_flush(p_sender);
+
+    uint8_t *p = p_sender->p_frame + p_sender->i_length;
+    p[0] = i_type;
+    replica_put16(p + 1, i_pid);
+    replica_put16(p + 3, i_size);
+    memcpy(p + REPLICA_RECORD_HEADER, p_data, i_size);
+
+    p_sender->i_length += i_record;
+    p_sender->i_records++;
+    if (p_sender->i_first_time == DVBPSI_TIME_NONE)
+        p_sender->i_first_time = i_time;
+    if (i_time != DVBPSI_TIME_NONE)
+        p_sender->i_last_time = i_time;
+    p_sender->stats.i_records++;
+    if (i_type == REPLICA_RECORD_DELTA)
+        p_sender->stats.i_deltas++;
+}
+
+/*****************************************************************************
+ * replica_delta
+ *****************************************************************************
+ * Encodes the operations turning p_base into p_section after the header of
+ * the delta, returning the size of the delta, or 0 if it would not be
+ * smaller than the section.
+ *****************************************************************************/
+static size_t replica_delta(uint8_t *p_delta, const uint8_t *p_base, size_t i_base,
+                            const uint8_t *p_section, size_t i_size)
+{
+    size_t i_length = REPLICA_DELTA_HEADER;
+    size_t i_common = i_base < i_size ? i_base : i_size;
+    size_t i = 0;
+
+    while (i < i_size)
+    {
+        size_t i_copy = 0;
+        while (i < i_common && p_base[i] == p_section[i] && i_copy < 255)
+        {
+            i++;
+            i_copy++;
+        }
+
+        /* Literal bytes up to the next run of 3 bytes equal in the base */
+        size_t i_start = i;
+        while (i < i_size && i - i_start < 255)
+        {
+            if (i + 2 < i_common && p_base[i] == p_section[i]
+             && p_base[i + 1] == p_section[i + 1] && p_base[i + 2] == p_section[i + 2])
+                break;
+            i++;
+        }
+
+        size_t i_literal = i - i_start;
+        if (i_length + 2 + i_literal >= i_size)
+            return 0;
+        p_delta[i_length++] = i_copy;
+        p_delta[i_length++] = i_literal;
+        memcpy(p_delta + i_length, p_section + i_start, i_literal);
+        i_length += i_literal;
+    }
+    return i_length;
+}
+
+/*****************************************************************************
+ * replica_tick
+ *****************************************************************************
+ * Sends the frame when it waited too long, and the keyframe when it is due.
+ *****************************************************************************/
+static void replica_tick(dvbpsi_replica_sender_t *p_sender, int64_t i_time)
+{
+    if (p_sender->options.i_batch_time == 0)
+        dvbpsi_replica_flush(p_sender);
+
+    if (i_time == DVBPSI_TIME_NONE)
+        return;
+
+    if (p_sender->i_first_time != DVBPSI_TIME_NONE
+     && i_time - p_sender->i_first_time >= p_sender->options.i_batch_time)
+        dvbpsi_replica_flush(p_sender);
+
+    if (p_sender->options.i_keyframe_interval > 0)
+    {
+        if (p_sender->i_keyframe_time == DVBPSI_TIME_NONE)
+            p_sender->i_keyframe_time = i_time;
+        else if (i_time - p_sender->i_keyframe_time >= p_sender->options.i_keyframe_interval)
+        {
+            p_sender->i_last_time = i_time;
+            dvbpsi_replica_keyframe(p_sender);
+        }
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_replica_send
+ *****************************************************************************/
+bool dvbpsi_replica_send(dvbpsi_replica_sender_t *p_sender, uint16_t i_pid, int64_t i_time,
+                         const uint8_t *p_section, size_t i_size)
+{
+    assert(p_sender);
+
+    if (i_size < 3 || i_size > REPLICA_SECTION_MAX)
+        return false;
+    p_sender->stats.i_sections++;
+
+    uint16_t i_extension;
+    uint8_t i_number, i_flags;
+    uint64_t i_key = replica_section_key(i_pid, p_section, i_size,
+                                         &i_extension, &i_number, &i_flags);
+    dvbpsi_replica_entry_t *p_entry = replica_find(p_sender->p_buckets, i_key);
+    if (p_entry && p_entry->i_size == i_size
+     && memcmp(p_entry->p_data, p_section, i_size) == 0)
+    {
+        replica_tick(p_sender, i_time);
+        return true;
+    }
+
+    size_t i_delta = 0;
+    if (p_sender->options.b_delta && p_entry)
+    {
+        uint8_t *p_delta = p_sender->p_delta;
+        i_delta = replica_delta(p_delta, p_entry->p_data, p_entry->i_size,
+                                p_section, i_size);
+        if (i_delta)
+        {
+            p_delta[0] = p_section[0];
+            replica_put16(p_delta + 1, i_extension);
+            p_delta[3] = i_number;
+            p_delta[4] = i_flags;
+            replica_put32(p_delta + 5, replica_hash(p_entry->p_data, p_entry->i_size));
+            replica_put16(p_delta + 9, i_size);
+        }
+    }
+
+    if (!replica_store(p_sender->p_buckets, i_key, p_section, i_size))
+        return false;
+
+    if (i_delta)
+        replica_append(p_sender, REPLICA_RECORD_DELTA, i_pid, i_time,
+                       p_sender->p_delta, i_delta);
+    else
+        replica_append(p_sender, REPLICA_RECORD_SECTION, i_pid, i_time,
+                       p_section, i_size);
+    replica_tick(p_sender, i_time);
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_replica_tap
+ *****************************************************************************/
+void dvbpsi_replica_tap(void *p_sender, uint16_t i_pid, int64_t i_time,
+                        const uint8_t *p_section, size_t i_size)
+{
+    dvbpsi_replica_send((dvbpsi_replica_sender_t *)p_sender, i_pid, i_time,
+                        p_section, i_size);
+}
+
+/*****************************************************************************
+ * dvbpsi_replica_keyframe
+ *****************************************************************************/
+void dvbpsi_replica_keyframe(dvbpsi_replica_sender_t *p_sender)
+{
+    assert(p_sender);
+
+    dvbpsi_replica_flush(p_sender);
+
+    p_sender->i_flags = REPLICA_FLAG_KEYFRAME;
+    for (int i = 0; i < REPLICA_BUCKETS; i++)
+        for (dvbpsi_replica_entry_t *p_entry = p_sender->p_buckets[i]; p_entry;
+             p_entry = p_entry->p_next)
+            replica_append(p_sender, REPLICA_RECORD_SECTION,
+                           (uint16_t)(p_entry->i_key >> 40), DVBPSI_TIME_NONE,
+                           p_entry->p_data, p_entry->i_size);
+    dvbpsi_replica_flush(p_sender);
+    p_sender->i_flags = 0;
+
+    p_sender->stats.i_keyframes++;
+    p_sender->i_keyframe_time = p_sender->i_last_time;
+}
+
+/*****************************************************************************
+ * dvbpsi_replica_sender_stats
+ *****************************************************************************/
+void dvbpsi_replica_sender_stats(const dvbpsi_replica_sender_t *p_sender,
+                                 dvbpsi_replica_stats_t *p_stats)
+{
+    assert(p_sender && p_stats);
+    *p_stats = p_sender->stats;
+}
+
+/*****************************************************************************
+ * dvbpsi_replica_receiver_new
+ *****************************************************************************/
+dvbpsi_replica_receiver_t *dvbpsi_replica_receiver_new(dvbpsi_replica_handle_cb pf_handle,
+                                                       void *p_cb_data)
+{
+    assert(pf_handle);
+
+    dvbpsi_replica_receiver_t *p_receiver = dvbpsi_calloc(1, sizeof(dvbpsi_replica_receiver_t));
+    if (p_receiver == NULL)
+        return NULL;
+
+    p_receiver->pf_handle = pf_handle;
+    p_receiver->p_cb_data = p_cb_data;
+    return p_receiver;
+}
+
+/*****************************************************************************
+ * dvbpsi_replica_receiver_delete
+ *****************************************************************************/
+void dvbpsi_replica_receiver_delete(dvbpsi_replica_receiver_t *p_receiver)
+{
+    if (p_receiver == NULL)
+        return;
+
+    replica_clear(p_receiver->p_buckets);
+    dvbpsi_free(p_receiver);
+}
+
+/*****************************************************************************
+ * replica_undelta
+ *****************************************************************************
+ * Rebuilds a section from a delta into p_section, returning its size, 0 if
+ * its base is unknown or (size_t)-1 if the delta is malformed.
+ *****************************************************************************/
+static size_t replica_undelta(dvbpsi_replica_receiver_t *p_receiver, uint16_t i_pid,
+                              const uint8_t *p_delta, size_t i_length, uint64_t *pi_key)
+{
+    if (i_length < REPLICA_DELTA_HEADER)
+        return (size_t)-1;
+
+    uint8_t i_flags = p_delta[4];
+    size_t i_size = replica_get16(p_delta + 9);
+    if (i_size < 3 || i_size > REPLICA_SECTION_MAX)
+        return (size_t)-1;
+
+    *pi_key = replica_key(i_pid, p_delta[0], replica_get16(p_delta + 1), p_delta[3], i_flags);
+    const dvbpsi_replica_entry_t *p_base = replica_find(p_receiver->p_buckets, *pi_key);
+    if (p_base == NULL
+     || replica_hash(p_base->p_data, p_base->i_size) != replica_get32(p_delta + 5))
+        return 0;
+
+    size_t i_common = p_base->i_size < i_size ? p_base->i_size : i_size;
+    uint8_t *p_section = p_receiver->p_section;
+    const uint8_t *p = p_delta + REPLICA_DELTA_HEADER;
+    const uint8_t *p_end = p_delta + i_length;
+    size_t i = 0;
+    while (p < p_end)
+    {
+        if (p_end - p < 2)
+            return (size_t)-1;
+        size_t i_copy = p[0], i_literal = p[1];
+        p += 2;
+        if (i + i_copy > i_common || i + i_copy + i_literal > i_size
+         || (size_t)(p_end - p) < i_literal)
+            return (size_t)-1;
+        memcpy(p_section + i, p_base->p_data + i, i_copy);
+        i += i_copy;
+        memcpy(p_section + i, p, i_literal);
+        i += i_literal;
+        p += i_literal;
+    }
+    return i == i_size ? i_size : (size_t)-1;
+}
+
+/*****************************************************************************
+ * dvbpsi_replica_receive
+ *****************************************************************************/
+bool dvbpsi_replica_receive(dvbpsi_replica_receiver_t *p_receiver,
+                            const uint8_t *p_frame, size_t i_size)
+{
+    assert(p_receiver);
+
+    if (i_size < REPLICA_FRAME_HEADER || p_frame[0] != 'D' || p_frame[1] != 'R'
+     || p_frame[2] != 1)
+        return false;
+
+    /* A frame older than the one expected came out of order */
+    uint32_t i_sequence = replica_get32(p_frame + 4);
+    uint32_t i_gap = i_sequence - p_receiver->i_sequence;
+    if (!p_receiver->b_sequence || i_gap < 0x80000000u)
+    {
+        if (p_receiver->b_sequence)
+            p_receiver->stats.i_lost += i_gap;
+        p_receiver->b_sequence = true;
+        p_receiver->i_sequence = i_sequence + 1;
+    }
+
+    int64_t i_time = (int64_t)(replica_get32(p_frame + 8)
+                             | (uint64_t)replica_get32(p_frame + 12) << 32);
+    unsigned i_records = replica_get16(p_frame + 16);
+
+    p_receiver->stats.i_frames++;
+    p_receiver->stats.i_bytes += i_size;
+    if (p_frame[3] & REPLICA_FLAG_KEYFRAME)
+        p_receiver->stats.i_keyframes++;
+
+    const uint8_t *p = p_frame + REPLICA_FRAME_HEADER;
+    const uint8_t *p_end = p_frame + i_size;
+    for (unsigned i_record = 0; i_record < i_records; i_record++)
+    {
+        if (p_end - p < REPLICA_RECORD_HEADER)
+            return false;
+        uint8_t i_type = p[0];
+        uint16_t i_pid = replica_get16(p + 1);
+        size_t i_length = replica_get16(p + 3);
+        const uint8_t *p_data = p + REPLICA_RECORD_HEADER;
+        if ((size_t)(p_end - p_data) < i_length)
+            return false;
+        p = p_data + i_length;
+
+        size_t i_section;
+        uint64_t i_key;
+        p_receiver->stats.i_records++;
+        if (i_type == REPLICA_RECORD_SECTION)
+        {
+            if (i_length < 3 || i_length > REPLICA_SECTION_MAX)
+                return false;
+            uint16_t i_extension;
+            uint8_t i_number, i_flags;
+            i_key = replica_section_key(i_pid, p_data, i_length,
+                                        &i_extension, &i_number, &i_flags);
+            memcpy(p_receiver->p_section, p_data, i_length);
+            i_section = i_length;
+        }
+        else if (i_type == REPLICA_RECORD_DELTA)
+        {
+            p_receiver->stats.i_deltas++;
+            i_section = replica_undelta(p_receiver, i_pid, p_data, i_length, &i_key);
+            if (i_section == (size_t)-1)
+                return false;
+            if (i_section == 0)
+            {
+                p_receiver->stats.i_missed++;
+                continue;
+            }
+        }
+        else
+            return false;
+
+        if (!replica_store(p_receiver->p_buckets, i_key, p_receiver->p_section, i_section))
+            return false;
+
+        /* The handle may decode in place, so it gets the copy */
+        dvbpsi_t *p_dvbpsi = p_receiver->pf_handle(p_receiver->p_cb_data, i_pid);
+        if (p_dvbpsi)
+        {
+            dvbpsi_section_push_at(p_dvbpsi, p_receiver->p_section, i_section, i_time);
+            p_receiver->stats.i_sections++;
+        }
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_replica_receiver_stats
+ *****************************************************************************/
+void dvbpsi_replica_receiver_stats(const dvbpsi_replica_receiver_t *p_receiver,
+                                   dvbpsi_replica_stats_t *p_stats)
+{
+    assert(p_receiver && p_stats);
+    *p_stats = p_receiver->stats;
+}
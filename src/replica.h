@@ -0,0 +1,333 @@
+/*****************************************************************************
+ * replica.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <replica.h>
+ * \brief Replication of the sections of a stream to a remote decoder.
+ *
+ * A sender, fed by the section tap of the handles of a probe, see
+ * dvbpsi_set_section_tap(), keeps the last copy of each section, by PID,
+ * table_id, table_id_extension, section_number and current_next_indicator,
+ * and only emits the sections that are new or changed, bit for bit. At
+ * regular intervals a keyframe emits all the sections kept, for receivers
+ * that joined late or lost frames. A receiver rebuilds the sections and
+ * pushes them to its own decoders with dvbpsi_section_push_at().
+ *
+ * The sender batches the sections into frames given to a callback, for
+ * any transport: UDP datagrams, a TCP stream with its own framing, files.
+ * A changed section can be sent as a delta against its previous version,
+ * a new version_number and CRC_32 taking a few bytes. All numbers are
+ * little endian:
+ * - frame: "DR", version (8 bits, 1), flags (8 bits, 1 for a keyframe),
+ *   sequence number (32 bits), time of the last section (64 bits, signed,
+ *   DVBPSI_TIME_NONE if unknown), number of records (16 bits), 0 (16 bits),
+ *   records;
+ * - record: type (8 bits, 0 for a section, 1 for a delta), PID (16 bits),
+ *   length of the data (16 bits), data;
+ * - section data: the section;
+ * - delta data: table_id (8 bits), table_id_extension (16 bits),
+ *   section_number (8 bits), flags (8 bits, 1 with the
+ *   section_syntax_indicator, 2 with the current_next_indicator), FNV-1a
+ *   hash of the previous version (32 bits), size of the section (16 bits),
+ *   then pairs of counts (8 bits each) of bytes copied from the previous
+ *   version at the same position and of bytes that follow, until the size.
+ *
+ * A delta whose previous version the receiver does not have is dropped,
+ * the section coming back with the next keyframe.
+ */
+
+#ifndef _DVBPSI_REPLICA_H_
+#define _DVBPSI_REPLICA_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_replica_options_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_replica_options_s
+ * \brief Options of a sender, see dvbpsi_replica_sender_new()
+ *
+ * Times are in the units of the arrival times of the sections given to the
+ * sender: without them, frames are only sent when full or flushed, and
+ * keyframes when asked for.
+ */
+/*!
+ * \typedef struct dvbpsi_replica_options_s dvbpsi_replica_options_t
+ * \brief dvbpsi_replica_options_t type definition.
+ */
+typedef struct dvbpsi_replica_options_s
+{
+    size_t      i_frame_size;           /*!< bytes of a frame at most, 0 for
+                                             1400, a larger section being
+                                             sent alone */
+    int64_t     i_batch_time;           /*!< longest wait of a section in a
+                                             frame, 0 to send each one at once */
+    int64_t     i_keyframe_interval;    /*!< time between two keyframes, 0
+                                             for dvbpsi_replica_keyframe() only */
+    bool        b_delta;                /*!< changed sections as deltas */
+} dvbpsi_replica_options_t;
+
+/*****************************************************************************
+ * dvbpsi_replica_stats_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_replica_stats_s
+ * \brief Counters of a sender or a receiver
+ */
+/*!
+ * \typedef struct dvbpsi_replica_stats_s dvbpsi_replica_stats_t
+ * \brief dvbpsi_replica_stats_t type definition.
+ */
+typedef struct dvbpsi_replica_stats_s
+{
+    uint64_t    i_sections;     /*!< sections given to the sender, or pushed
+                                     by the receiver */
+    uint64_t    i_records;      /*!< records sent or received */
+    uint64_t    i_deltas;       /*!< records that are deltas */
+    uint64_t    i_frames;       /*!< frames sent or received */
+    uint64_t    i_keyframes;    /*!< keyframes sent, or their frames received */
+    uint64_t    i_bytes;        /*!< bytes of the frames */
+    uint64_t    i_lost;         /*!< frames missing from the sequence, on
+                                     the receiver */
+    uint64_t    i_missed;       /*!< deltas dropped without their previous
+                                     version, on the receiver */
+} dvbpsi_replica_stats_t;
+
+/*****************************************************************************
+ * dvbpsi_replica_output_cb
+ *****************************************************************************/
+/*!
+ * \typedef void (* dvbpsi_replica_output_cb)(void *p_cb_data,
+ *                                           const uint8_t *p_frame,
+ *                                           size_t i_size)
+ * \brief Callback type definition, given each frame of a sender, valid
+ * during the call.
+ */
+typedef void (* dvbpsi_replica_output_cb)(void *p_cb_data, const uint8_t *p_frame,
+                                          size_t i_size);
+
+/*****************************************************************************
+ * dvbpsi_replica_sender_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_replica_sender_s dvbpsi_replica_sender_t
+ * \brief dvbpsi_replica_sender_t type definition, an opaque sender.
+ */
+typedef struct dvbpsi_replica_sender_s dvbpsi_replica_sender_t;
+
+/*****************************************************************************
+ * dvbpsi_replica_sender_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_replica_sender_t *dvbpsi_replica_sender_new(
+ *                                  const dvbpsi_replica_options_t *p_options,
+ *                                  dvbpsi_replica_output_cb pf_output,
+ *                                  void *p_cb_data)
+ * \brief Creates a sender
+ * \param p_options options, NULL for the defaults: full frames, no
+ *        keyframe and no delta
+ * \param pf_output function given the frames
+ * \param p_cb_data private data given in argument to pf_output
+ * \return pointer to the sender, or NULL on error
+ */
+dvbpsi_replica_sender_t *dvbpsi_replica_sender_new(const dvbpsi_replica_options_t *p_options,
+                                                   dvbpsi_replica_output_cb pf_output,
+                                                   void *p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_replica_sender_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_replica_sender_delete(dvbpsi_replica_sender_t *p_sender)
+ * \brief Deletes a sender, without sending the frame being filled
+ * \param p_sender pointer to the sender
+ * \return nothing
+ */
+void dvbpsi_replica_sender_delete(dvbpsi_replica_sender_t *p_sender);
+
+/*****************************************************************************
+ * dvbpsi_replica_send
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_replica_send(dvbpsi_replica_sender_t *p_sender,
+ *                              uint16_t i_pid, int64_t i_time,
+ *                              const uint8_t *p_section, size_t i_size)
+ * \brief Gives a section to a sender, which sends it if it is new or changed
+ * \param p_sender pointer to the sender
+ * \param i_pid PID of the section
+ * \param i_time arrival time of the section, or DVBPSI_TIME_NONE
+ * \param p_section section, starting with its table_id
+ * \param i_size size of the section, from 3 to 4096 bytes
+ * \return false if i_size is out of range or on a memory error
+ */
+bool dvbpsi_replica_send(dvbpsi_replica_sender_t *p_sender, uint16_t i_pid, int64_t i_time,
+                         const uint8_t *p_section, size_t i_size);
+
+/*****************************************************************************
+ * dvbpsi_replica_tap
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_replica_tap(void *p_sender, uint16_t i_pid, int64_t i_time,
+ *                             const uint8_t *p_section, size_t i_size)
+ * \brief Section tap callback giving the sections to the
+ *        dvbpsi_replica_sender_t given as callback data, see
+ *        dvbpsi_set_section_tap()
+ * \param p_sender pointer to the sender
+ * \param i_pid PID of the section
+ * \param i_time arrival time of the section
+ * \param p_section section
+ * \param i_size size of the section
+ * \return nothing
+ *
+ * Several handles may feed the same sender when they are used from the
+ * same thread.
+ */
+void dvbpsi_replica_tap(void *p_sender, uint16_t i_pid, int64_t i_time,
+                        const uint8_t *p_section, size_t i_size);
+
+/*****************************************************************************
+ * dvbpsi_replica_flush
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_replica_flush(dvbpsi_replica_sender_t *p_sender)
+ * \brief Sends the frame being filled, if any
+ * \param p_sender pointer to the sender
+ * \return nothing
+ */
+void dvbpsi_replica_flush(dvbpsi_replica_sender_t *p_sender);
+
+/*****************************************************************************
+ * dvbpsi_replica_keyframe
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_replica_keyframe(dvbpsi_replica_sender_t *p_sender)
+ * \brief Sends the frame being filled, then all the sections kept
+ * \param p_sender pointer to the sender
+ * \return nothing
+ *
+ * A keyframe takes as many frames as needed, all flagged, and restarts the
+ * keyframe interval.
+ */
+void dvbpsi_replica_keyframe(dvbpsi_replica_sender_t *p_sender);
+
+/*****************************************************************************
+ * dvbpsi_replica_sender_stats
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_replica_sender_stats(const dvbpsi_replica_sender_t *p_sender,
+ *                                      dvbpsi_replica_stats_t *p_stats)
+ * \brief Gives the counters of a sender
+ * \param p_sender pointer to the sender
+ * \param p_stats filled with the counters
+ * \return nothing
+ */
+void dvbpsi_replica_sender_stats(const dvbpsi_replica_sender_t *p_sender,
+                                 dvbpsi_replica_stats_t *p_stats);
+
+/*****************************************************************************
+ * dvbpsi_replica_handle_cb
+ *****************************************************************************/
+/*!
+ * \typedef dvbpsi_t *(* dvbpsi_replica_handle_cb)(void *p_cb_data,
+ *                                                 uint16_t i_pid)
+ * \brief Callback type definition, giving the handle decoding the sections
+ * of a PID on a receiver, or NULL to skip them.
+ */
+typedef dvbpsi_t *(* dvbpsi_replica_handle_cb)(void *p_cb_data, uint16_t i_pid);
+
+/*****************************************************************************
+ * dvbpsi_replica_receiver_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_replica_receiver_s dvbpsi_replica_receiver_t
+ * \brief dvbpsi_replica_receiver_t type definition, an opaque receiver.
+ */
+typedef struct dvbpsi_replica_receiver_s dvbpsi_replica_receiver_t;
+
+/*****************************************************************************
+ * dvbpsi_replica_receiver_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_replica_receiver_t *dvbpsi_replica_receiver_new(
+ *                                  dvbpsi_replica_handle_cb pf_handle,
+ *                                  void *p_cb_data)
+ * \brief Creates a receiver
+ * \param pf_handle function giving the handle of a PID
+ * \param p_cb_data private data given in argument to pf_handle
+ * \return pointer to the receiver, or NULL on error
+ */
+dvbpsi_replica_receiver_t *dvbpsi_replica_receiver_new(dvbpsi_replica_handle_cb pf_handle,
+                                                       void *p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_replica_receiver_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_replica_receiver_delete(dvbpsi_replica_receiver_t *p_receiver)
+ * \brief Deletes a receiver
+ * \param p_receiver pointer to the receiver
+ * \return nothing
+ */
+void dvbpsi_replica_receiver_delete(dvbpsi_replica_receiver_t *p_receiver);
+
+/*****************************************************************************
+ * dvbpsi_replica_receive
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_replica_receive(dvbpsi_replica_receiver_t *p_receiver,
+ *                                 const uint8_t *p_frame, size_t i_size)
+ * \brief Pushes the sections of a frame to their handles
+ * \param p_receiver pointer to the receiver
+ * \param p_frame frame of a sender
+ * \param i_size size of the frame
+ * \return false if the frame is malformed, the sections before the error
+ *         being pushed, or on a memory error
+ *
+ * The sections are pushed with the time of the frame.
+ */
+bool dvbpsi_replica_receive(dvbpsi_replica_receiver_t *p_receiver,
+                            const uint8_t *p_frame, size_t i_size);
+
+/*****************************************************************************
+ * dvbpsi_replica_receiver_stats
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_replica_receiver_stats(const dvbpsi_replica_receiver_t *p_receiver,
+ *                                        dvbpsi_replica_stats_t *p_stats)
+ * \brief Gives the counters of a receiver
+ * \param p_receiver pointer to the receiver
+ * \param p_stats filled with the counters
+ * \return nothing
+ */
+void dvbpsi_replica_receiver_stats(const dvbpsi_replica_receiver_t *p_receiver,
+                                   dvbpsi_replica_stats_t *p_stats);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of replica.h"
+#endif
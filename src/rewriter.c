@@ -0,0 +1,351 @@
+/*****************************************************************************
+ * rewriter.c: PAT and PMT rewriter
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "crc32_private.h"
+#include "rewriter.h"
+
+#define DVBPSI_REWRITER_PIDS     8192
+#define DVBPSI_REWRITER_BUCKETS  64
+
+/*****************************************************************************
+ * dvbpsi_rewriter_entry_t
+ *****************************************************************************
+ * Last rewriting of a section: the input bytes followed by the output bytes.
+ *****************************************************************************/
+typedef struct dvbpsi_rewriter_entry_s
+{
+    struct dvbpsi_rewriter_entry_s *p_next;
+    uint8_t  i_table_id;
+    uint16_t i_extension;
+    uint8_t  i_number;
+    size_t   i_in;
+    size_t   i_out;
+    uint8_t  p_data[];
+} dvbpsi_rewriter_entry_t;
+
+/*****************************************************************************
+ * dvbpsi_rewriter_s
+ *****************************************************************************/
+struct dvbpsi_rewriter_s
+{
+    uint16_t p_pids[DVBPSI_REWRITER_PIDS];  /* new PID of each PID */
+    uint8_t  p_dropped[65536 / 8];          /* bitmap of program_number */
+
+    dvbpsi_rewriter_entry_t *p_buckets[DVBPSI_REWRITER_BUCKETS];
+};
+
+/*****************************************************************************
+ * dvbpsi_rewriter_new
+ *****************************************************************************/
+dvbpsi_rewriter_t *dvbpsi_rewriter_new(void)
+{
+    dvbpsi_rewriter_t *p_rewriter = dvbpsi_calloc(1, sizeof(dvbpsi_rewriter_t));
+    if (p_rewriter == NULL)
+        return NULL;
+
+    for (int i = 0; i < DVBPSI_REWRITER_PIDS; i++)
+        p_rewriter->p_pids[i] = i;
+    return p_rewriter;
+}
+
+/*****************************************************************************
+ * dvbpsi_rewriter_flush
+ *****************************************************************************
+ * Forgets the sections rewritten, when the rules change.
+ *****************************************************************************/
+static void dvbpsi_rewriter_flush(dvbpsi_rewriter_t *p_rewriter)
+{
+    for (int i = 0; i < DVBPSI_REWRITER_BUCKETS; i++)
+    {
+        dvbpsi_rewriter_entry_t *p_entry = p_rewriter->p_buckets[i];
+        while (p_entry)
+        {
+            dvbpsi_rewriter_entry_t *p_next = p_entry->p_next;
+            dvbpsi_free(p_entry);
+            p_entry = p_next;
+        }
+        p_rewriter->p_buckets[i] = NULL;
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_rewriter_delete
+ *****************************************************************************/
+void dvbpsi_rewriter_delete(dvbpsi_rewriter_t *p_rewriter)
+{
+    if (p_rewriter == NULL)
+        return;
+
+    dvbpsi_rewriter_flush(p_rewriter);
+    dvbpsi_free(p_rewriter);
+}
+
+/*****************************************************************************
+ * dvbpsi_rewriter_map_pid
+ *****************************************************************************/
+bool dvbpsi_rewriter_map_pid(dvbpsi_rewriter_t *p_rewriter, uint16_t i_pid,
+                             uint16_t i_new_pid)
+{
+    assert(p_rewriter);
+
+    if (i_pid >= DVBPSI_REWRITER_PIDS
+     || (i_new_pid >= DVBPSI_REWRITER_PIDS && i_new_pid != DVBPSI_REWRITER_DROP))
+        return false;
+
+    if (p_rewriter->p_pids[i_pid] != i_new_pid)
+    {
+        p_rewriter->p_pids[i_pid] = i_new_pid;
+        dvbpsi_rewriter_flush(p_rewriter);
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_rewriter_drop_program
+ *****************************************************************************/
+void dvbpsi_rewriter_drop_program(dvbpsi_rewriter_t *p_rewriter,
+                                  uint16_t i_program_number, bool b_drop)
+{
+    assert(p_rewriter);
+
+    uint8_t *p_byte = &p_rewriter->p_dropped[i_program_number >> 3];
+    uint8_t i_bit = 1 << (i_program_number & 7);
+    if (((*p_byte & i_bit) != 0) != b_drop)
+    {
+        *p_byte ^= i_bit;
+        dvbpsi_rewriter_flush(p_rewriter);
+    }
+}
+
+static inline bool dvbpsi_rewriter_dropped(const dvbpsi_rewriter_t *p_rewriter,
+                                           uint16_t i_program_number)
+{
+    return p_rewriter->p_dropped[i_program_number >> 3]
+         & (1 << (i_program_number & 7));
+}
+
+/*****************************************************************************
+ * dvbpsi_rewriter_pat
+ *****************************************************************************
+ * Rewrites the program loop of a PAT section, up to the CRC_32 excluded.
+ * Returns the number of bytes written or 0 if the section is malformed.
+ *****************************************************************************/
+static size_t dvbpsi_rewriter_pat(const dvbpsi_rewriter_t *p_rewriter,
+                                  const uint8_t *p_in, size_t i_size,
+                                  uint8_t *p_out)
+{
+    if ((i_size - 12) % 4 != 0)
+        return 0;
+
+    memcpy(p_out, p_in, 8);
+    size_t i_out = 8;
+    for (size_t i = 8; i < i_size - 4; i += 4)
+    {
+        uint16_t i_number = (p_in[i] << 8) | p_in[i + 1];
+        uint16_t i_pid = p_rewriter->p_pids[((p_in[i + 2] & 0x1f) << 8) | p_in[i + 3]];
+        if (i_pid == DVBPSI_REWRITER_DROP
+         || (i_number != 0 && dvbpsi_rewriter_dropped(p_rewriter, i_number)))
+            continue;
+
+        p_out[i_out]     = p_in[i];
+        p_out[i_out + 1] = p_in[i + 1];
+        p_out[i_out + 2] = (p_in[i + 2] & 0xe0) | (i_pid >> 8);
+        p_out[i_out + 3] = i_pid & 0xff;
+        i_out += 4;
+    }
+    return i_out;
+}
+
+/*****************************************************************************
+ * dvbpsi_rewriter_pmt
+ *****************************************************************************
+ * Rewrites the PCR_PID and elementary stream loop of a PMT section, up to
+ * the CRC_32 excluded. Returns the number of bytes written or 0 if the
+ * section is malformed.
+ *****************************************************************************/
+static size_t dvbpsi_rewriter_pmt(const dvbpsi_rewriter_t *p_rewriter,
+                                  const uint8_t *p_in, size_t i_size,
+                                  uint8_t *p_out)
+{
+    const size_t i_end = i_size - 4;
+    if (i_end < 12)
+        return 0;
+
+    size_t i_info = ((p_in[10] & 0x0f) << 8) | p_in[11];
+    if (12 + i_info > i_end)
+        return 0;
+
+    uint16_t i_pcr_pid = p_rewriter->p_pids[((p_in[8] & 0x1f) << 8) | p_in[9]];
+    if (i_pcr_pid == DVBPSI_REWRITER_DROP)
+        i_pcr_pid = 0x1fff;
+
+    memcpy(p_out, p_in, 12 + i_info);
+    p_out[8] = (p_in[8] & 0xe0) | (i_pcr_pid >> 8);
+    p_out[9] = i_pcr_pid & 0xff;
+
+    size_t i_out = 12 + i_info;
+    size_t i = 12 + i_info;
+    while (i + 5 <= i_end)
+    {
+        size_t i_es_info = ((p_in[i + 3] & 0x0f) << 8) | p_in[i + 4];
+        if (i + 5 + i_es_info > i_end)
+            return 0;
+
+        uint16_t i_pid = p_rewriter->p_pids[((p_in[i + 1] & 0x1f) << 8) | p_in[i + 2]];
+        if (i_pid != DVBPSI_REWRITER_DROP)
+        {
+            memcpy(p_out + i_out, p_in + i, 5 + i_es_info);
+            p_out[i_out + 1] = (p_in[i + 1] & 0xe0) | (i_pid >> 8);
+            p_out[i_out + 2] = i_pid & 0xff;
+            i_out += 5 + i_es_info;
+        }
+        i += 5 + i_es_info;
+    }
+    if (i != i_end)
+        return 0;
+
+    return i_out;
+}
+
+/*****************************************************************************
+ * dvbpsi_rewriter_rewrite
+ *****************************************************************************/
+bool dvbpsi_rewriter_rewrite(dvbpsi_rewriter_t *p_rewriter,
+                             const uint8_t *p_section, size_t i_size,
+                             uint8_t *p_out, size_t *pi_out)
+{
+    assert(p_rewriter);
+    assert(p_section);
+    assert(p_out);
+    assert(pi_out);
+
+    if (i_size < 3 || i_size > 4096
+     || 3 + (size_t)(((p_section[1] & 0x0f) << 8) | p_section[2]) != i_size)
+        return false;
+
+    uint8_t i_table_id = p_section[0];
+    if (i_table_id != 0x00 && i_table_id != 0x02)
+    {
+        memmove(p_out, p_section, i_size);
+        *pi_out = i_size;
+        return true;
+    }
+
+    /* PAT and PMT sections have the syntax and a CRC_32 */
+    if (!(p_section[1] & 0x80) || i_size < 12)
+        return false;
+
+    uint16_t i_extension = (p_section[3] << 8) | p_section[4];
+    uint8_t i_number = p_section[6];
+    if (i_table_id == 0x02 && dvbpsi_rewriter_dropped(p_rewriter, i_extension))
+    {
+        if (dvbpsi_crc32(0xffffffff, p_section, i_size) != 0)
+            return false;
+        *pi_out = 0;
+        return true;
+    }
+
+    unsigned int i_hash = (i_table_id * 31u + i_extension) * 31u + i_number;
+    dvbpsi_rewriter_entry_t **pp_entry = &p_rewriter->p_buckets[i_hash % DVBPSI_REWRITER_BUCKETS];
+    while (*pp_entry && ((*pp_entry)->i_table_id != i_table_id
+                         || (*pp_entry)->i_extension != i_extension
+                         || (*pp_entry)->i_number != i_number))
+        pp_entry = &(*pp_entry)->p_next;
+
+    /* Repetition of the section last rewritten */
+    dvbpsi_rewriter_entry_t *p_entry = *pp_entry;
+    if (p_entry && p_entry->i_in == i_size
+     && memcmp(p_entry->p_data, p_section, i_size) == 0)
+    {
+        memcpy(p_out, p_entry->p_data + i_size, p_entry->i_out);
+        *pi_out = p_entry->i_out;
+        return true;
+    }
+
+    if (dvbpsi_crc32(0xffffffff, p_section, i_size) != 0)
+        return false;
+
+    /* The output is never larger than the input */
+    if (p_entry == NULL || p_entry->i_in != i_size)
+    {
+        dvbpsi_rewriter_entry_t *p_new = dvbpsi_malloc(sizeof(dvbpsi_rewriter_entry_t)
+                                                       + 2 * i_size);
+        if (p_new == NULL)
+            return false;
+        p_new->p_next = p_entry ? p_entry->p_next : NULL;
+        p_new->i_table_id = i_table_id;
+        p_new->i_extension = i_extension;
+        p_new->i_number = i_number;
+        p_new->i_in = i_size;
+        dvbpsi_free(p_entry);
+        *pp_entry = p_entry = p_new;
+    }
+
+    uint8_t *p_in = p_entry->p_data;
+    uint8_t *p_new = p_entry->p_data + i_size;
+    memcpy(p_in, p_section, i_size);
+
+    size_t i_out = (i_table_id == 0x00)
+                 ? dvbpsi_rewriter_pat(p_rewriter, p_in, i_size, p_new)
+                 : dvbpsi_rewriter_pmt(p_rewriter, p_in, i_size, p_new);
+    if (i_out == 0)
+    {
+        /* Never match a malformed section */
+        p_entry->i_in = 0;
+        return false;
+    }
+
+    size_t i_length = i_out + 4 - 3;
+    p_new[1] = (p_new[1] & 0xf0) | ((i_length >> 8) & 0x0f);
+    p_new[2] = i_length & 0xff;
+
+    uint32_t i_crc = dvbpsi_crc32(0xffffffff, p_new, i_out);
+    p_new[i_out]     = (i_crc >> 24) & 0xff;
+    p_new[i_out + 1] = (i_crc >> 16) & 0xff;
+    p_new[i_out + 2] = (i_crc >> 8) & 0xff;
+    p_new[i_out + 3] = i_crc & 0xff;
+    p_entry->i_out = i_out + 4;
+
+    memcpy(p_out, p_new, p_entry->i_out);
+    *pi_out = p_entry->i_out;
+    return true;
+}
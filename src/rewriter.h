@@ -0,0 +1,147 @@
+/*****************************************************************************
+ * rewriter.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <rewriter.h>
+ * \brief PAT and PMT rewriter.
+ *
+ * Remaps PIDs and drops programs or elementary streams directly in the
+ * bytes of PAT and PMT sections, without decoding them into tables and
+ * generating them again, for remultiplexers.
+ */
+
+#ifndef _DVBPSI_REWRITER_H_
+#define _DVBPSI_REWRITER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_rewriter_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_rewriter_s dvbpsi_rewriter_t
+ * \brief dvbpsi_rewriter_t type definition, an opaque set of rewriting
+ * rules with the sections last rewritten with them.
+ */
+typedef struct dvbpsi_rewriter_s dvbpsi_rewriter_t;
+
+/*!
+ * \def DVBPSI_REWRITER_DROP
+ * \brief PID mapping dropping the elementary streams or programs of a PID
+ */
+#define DVBPSI_REWRITER_DROP 0xffff
+
+/*****************************************************************************
+ * dvbpsi_rewriter_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_rewriter_t *dvbpsi_rewriter_new(void)
+ * \brief Creates a rewriter leaving the sections unchanged
+ * \return pointer to the rewriter, or NULL on error
+ */
+dvbpsi_rewriter_t *dvbpsi_rewriter_new(void);
+
+/*****************************************************************************
+ * dvbpsi_rewriter_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_rewriter_delete(dvbpsi_rewriter_t *p_rewriter)
+ * \brief Deletes a rewriter
+ * \param p_rewriter pointer to the rewriter
+ * \return nothing
+ */
+void dvbpsi_rewriter_delete(dvbpsi_rewriter_t *p_rewriter);
+
+/*****************************************************************************
+ * dvbpsi_rewriter_map_pid
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_rewriter_map_pid(dvbpsi_rewriter_t *p_rewriter,
+ *                                  uint16_t i_pid, uint16_t i_new_pid)
+ * \brief Sets the PID written in place of a PID
+ * \param p_rewriter pointer to the rewriter
+ * \param i_pid PID of the input sections, 0 to 0x1fff
+ * \param i_new_pid PID of the output sections, 0 to 0x1fff, i_pid to
+ *        restore it, or DVBPSI_REWRITER_DROP
+ * \return false if a PID is invalid, true otherwise.
+ *
+ * The PIDs are those of the PAT program loop, network_PID included, and
+ * those of the PCR_PID and elementary stream loop of the PMT. The
+ * programs and elementary streams of a dropped PID are removed, and a
+ * dropped PCR_PID becomes 0x1fff.
+ */
+bool dvbpsi_rewriter_map_pid(dvbpsi_rewriter_t *p_rewriter, uint16_t i_pid,
+                             uint16_t i_new_pid);
+
+/*****************************************************************************
+ * dvbpsi_rewriter_drop_program
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_rewriter_drop_program(dvbpsi_rewriter_t *p_rewriter,
+ *                                       uint16_t i_program_number,
+ *                                       bool b_drop)
+ * \brief Removes or keeps a program
+ * \param p_rewriter pointer to the rewriter
+ * \param i_program_number program_number
+ * \param b_drop true to remove the program from the PAT and its PMT
+ *        sections from the output, false to keep it
+ * \return nothing
+ */
+void dvbpsi_rewriter_drop_program(dvbpsi_rewriter_t *p_rewriter,
+                                  uint16_t i_program_number, bool b_drop);
+
+/*****************************************************************************
+ * dvbpsi_rewriter_rewrite
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_rewriter_rewrite(dvbpsi_rewriter_t *p_rewriter,
+ *                                  const uint8_t *p_section, size_t i_size,
+ *                                  uint8_t *p_out, size_t *pi_out)
+ * \brief Rewrites a PAT or PMT section
+ * \param p_rewriter pointer to the rewriter
+ * \param p_section bytes of a complete section, CRC_32 included
+ * \param i_size number of bytes of the section
+ * \param p_out filled with the rewritten section, at most i_size bytes.
+ *        It may be p_section to rewrite the section in place.
+ * \param pi_out filled with the number of bytes of the rewritten section,
+ *        0 when the section is dropped
+ * \return false if the section is malformed or its CRC_32 wrong, in which
+ *         case nothing is written, true otherwise.
+ *
+ * section_length and the CRC_32 are updated. Sections of other tables are
+ * copied unchanged. The rewriter keeps the last rewriting of each
+ * section: a repetition of the same section bytes is only compared and
+ * copied, until the rules change.
+ */
+bool dvbpsi_rewriter_rewrite(dvbpsi_rewriter_t *p_rewriter,
+                             const uint8_t *p_section, size_t i_size,
+                             uint8_t *p_out, size_t *pi_out);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of rewriter.h"
+#endif
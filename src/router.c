@@ -0,0 +1,351 @@
+/*****************************************************************************
+ * router.c: PID router
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "router.h"
+
+/*****************************************************************************
+ * dvbpsi_router_s
+ *****************************************************************************/
+/* No known continuity_counter: the packets go to the decoder */
+#define DVBPSI_ROUTER_NO_CC 0xff
+
+/* Packets of a header pass */
+#define DVBPSI_ROUTER_BATCH 64
+
+struct dvbpsi_router_s
+{
+    dvbpsi_t *pp_handles[DVBPSI_ROUTER_PIDS];
+    unsigned int i_attached;                /* attached PIDs */
+
+    dvbpsi_packet_format_t i_format;        /* framing of the packets */
+
+    /* State of the idle decoders, those without a section in flight, kept
+     * apart from the handles so that their continuation packets are
+     * passed over without touching them */
+    uint8_t p_cc[DVBPSI_ROUTER_PIDS];       /* last continuity_counter */
+    uint8_t p_skipped[DVBPSI_ROUTER_PIDS];  /* packets passed over, not yet
+                                               accounted to the decoder */
+    uint8_t p_shared[DVBPSI_ROUTER_PIDS / 8]; /* handles of several PIDs */
+    dvbpsi_decoder_t *pp_decoders[DVBPSI_ROUTER_PIDS]; /* of the state */
+    unsigned int pi_generations[DVBPSI_ROUTER_PIDS]; /* of these decoders,
+                                               as freed ones are reused */
+};
+
+/*****************************************************************************
+ * dvbpsi_router_new
+ *****************************************************************************/
+dvbpsi_router_t *dvbpsi_router_new(void)
+{
+    dvbpsi_router_t *p_router = dvbpsi_calloc(1, sizeof(dvbpsi_router_t));
+    if (p_router == NULL)
+        return NULL;
+
+    memset(p_router->p_cc, DVBPSI_ROUTER_NO_CC, sizeof(p_router->p_cc));
+    return p_router;
+}
+
+/*****************************************************************************
+ * dvbpsi_router_delete
+ *****************************************************************************/
+void dvbpsi_router_delete(dvbpsi_router_t *p_router)
+{
+    dvbpsi_free(p_router);
+}
+
+/*****************************************************************************
+ * dvbpsi_router_set_packet_format
+ *****************************************************************************/
+bool dvbpsi_router_set_packet_format(dvbpsi_router_t *p_router,
+                                     dvbpsi_packet_format_t i_format)
+{
+    assert(p_router);
+
+    if (p_router->i_attached)
+        return false;
+
+    p_router->i_format = i_format;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_router_get_packet_format
+ *****************************************************************************/
+dvbpsi_packet_format_t dvbpsi_router_get_packet_format(const dvbpsi_router_t *p_router)
+{
+    assert(p_router);
+    return p_router->i_format;
+}
+
+/*****************************************************************************
+ * dvbpsi_router_sync
+ *****************************************************************************
+ * Accounts the packets passed over to the decoder of a PID.
+ *****************************************************************************/
+static void dvbpsi_router_sync(dvbpsi_router_t *p_router, uint16_t i_pid)
+{
+    if (p_router->p_skipped[i_pid] == 0)
+        return;
+
+    dvbpsi_t *p_dvbpsi = p_router->pp_handles[i_pid];
+    p_dvbpsi->stats.i_packets += p_router->p_skipped[i_pid];
+    p_router->p_skipped[i_pid] = 0;
+
+    /* A decoder attached since then starts afresh, even at the address of
+     * the detached one */
+    if (p_dvbpsi->p_decoder == p_router->pp_decoders[i_pid]
+        && p_dvbpsi->p_decoder->i_generation == p_router->pi_generations[i_pid])
+        p_dvbpsi->p_decoder->i_continuity_counter = p_router->p_cc[i_pid];
+}
+
+/*****************************************************************************
+ * dvbpsi_router_refresh
+ *****************************************************************************
+ * Takes the state of the decoder of a PID after it got packets.
+ *****************************************************************************/
+static void dvbpsi_router_refresh(dvbpsi_router_t *p_router, uint16_t i_pid)
+{
+    dvbpsi_t *p_dvbpsi = p_router->pp_handles[i_pid];
+    dvbpsi_decoder_t *p_decoder = p_dvbpsi ? p_dvbpsi->p_decoder : NULL;
+
+    /* The continuity_counter of a handle of several PIDs is theirs */
+    if (p_decoder == NULL || p_decoder->p_current_section
+        || p_decoder->i_continuity_counter > 0x0f
+        || (p_router->p_shared[i_pid / 8] & (1 << (i_pid % 8))))
+    {
+        p_router->p_cc[i_pid] = DVBPSI_ROUTER_NO_CC;
+        return;
+    }
+    p_router->p_cc[i_pid] = p_decoder->i_continuity_counter;
+    p_router->pp_decoders[i_pid] = p_decoder;
+    p_router->pi_generations[i_pid] = p_decoder->i_generation;
+}
+
+/*****************************************************************************
+ * dvbpsi_router_share
+ *****************************************************************************
+ * Flags the PIDs of a handle if it has several.
+ *****************************************************************************/
+static void dvbpsi_router_share(dvbpsi_router_t *p_router, const dvbpsi_t *p_dvbpsi)
+{
+    unsigned int i_pids = 0;
+    for (int i = 0; i < DVBPSI_ROUTER_PIDS; i++)
+        if (p_router->pp_handles[i] == p_dvbpsi)
+            i_pids++;
+
+    for (int i = 0; i < DVBPSI_ROUTER_PIDS; i++)
+    {
+        if (p_router->pp_handles[i] != p_dvbpsi)
+            continue;
+        if (i_pids > 1)
+        {
+            p_router->p_shared[i / 8] |= 1 << (i % 8);
+            dvbpsi_router_sync(p_router, i);
+            p_router->p_cc[i] = DVBPSI_ROUTER_NO_CC;
+        }
+        else
+            p_router->p_shared[i / 8] &= ~(1 << (i % 8));
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_router_attach
+ *****************************************************************************/
+bool dvbpsi_router_attach(dvbpsi_router_t *p_router, uint16_t i_pid,
+                          dvbpsi_t *p_dvbpsi)
+{
+    assert(p_router);
+    assert(p_dvbpsi);
+
+    if (i_pid >= DVBPSI_ROUTER_PIDS)
+    {
+        dvbpsi_error(p_dvbpsi, "PID router", "invalid PID %d", i_pid);
+        return false;
+    }
+
+    if (p_router->pp_handles[i_pid] && p_router->pp_handles[i_pid] != p_dvbpsi)
+    {
+        dvbpsi_error(p_dvbpsi, "PID router", "PID %d already attached", i_pid);
+        return false;
+    }
+
+    if (p_dvbpsi->i_packet_format != p_router->i_format)
+    {
+        dvbpsi_error(p_dvbpsi, "PID router", "packet format differs from the router one");
+        return false;
+    }
+
+    if (p_router->pp_handles[i_pid] == p_dvbpsi)
+        return true;
+
+    p_router->i_attached++;
+    p_router->pp_handles[i_pid] = p_dvbpsi;
+    p_router->p_cc[i_pid] = DVBPSI_ROUTER_NO_CC;
+    dvbpsi_router_share(p_router, p_dvbpsi);
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_router_detach
+ *****************************************************************************/
+dvbpsi_t *dvbpsi_router_detach(dvbpsi_router_t *p_router, uint16_t i_pid)
+{
+    assert(p_router);
+
+    if (i_pid >= DVBPSI_ROUTER_PIDS)
+        return NULL;
+
+    dvbpsi_t *p_dvbpsi = p_router->pp_handles[i_pid];
+    if (p_dvbpsi == NULL)
+        return NULL;
+
+    dvbpsi_router_sync(p_router, i_pid);
+    p_router->i_attached--;
+    p_router->pp_handles[i_pid] = NULL;
+    p_router->p_cc[i_pid] = DVBPSI_ROUTER_NO_CC;
+    dvbpsi_router_share(p_router, p_dvbpsi);
+    return p_dvbpsi;
+}
+
+/*****************************************************************************
+ * dvbpsi_router_get
+ *****************************************************************************/
+dvbpsi_t *dvbpsi_router_get(dvbpsi_router_t *p_router, uint16_t i_pid)
+{
+    assert(p_router);
+    return (i_pid < DVBPSI_ROUTER_PIDS) ? p_router->pp_handles[i_pid] : NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_router_push
+ *****************************************************************************
+ * Injection of TS packets into the handles attached to their PID.
+ *****************************************************************************/
+bool dvbpsi_router_push(dvbpsi_router_t *p_router, uint8_t *p_data,
+                        size_t i_count, size_t i_stride)
+{
+    assert(p_router);
+
+    bool b_ok = true;
+    if (i_stride == 0)
+        i_stride = dvbpsi_get_packet_size(p_router->i_format);
+
+    /* The handles take the framed packets, only look at the TS header */
+    size_t i_offset = (p_router->i_format == DVBPSI_PACKET_M2TS) ? 4 : 0;
+
+    /* The handles time each M2TS packet */
+    bool b_idle = (p_router->i_format != DVBPSI_PACKET_M2TS);
+
+    for (size_t i_batch = 0; i_batch < i_count; i_batch += DVBPSI_ROUTER_BATCH)
+    {
+        size_t i_size = i_count - i_batch;
+        if (i_size > DVBPSI_ROUTER_BATCH)
+            i_size = DVBPSI_ROUTER_BATCH;
+        uint8_t *p_first = p_data + i_batch * i_stride + i_offset;
+
+        /* Header pass: PID, continuity_counter and whether the packet only
+         * continues a section, without TEI, unit start nor scrambling */
+        uint16_t pi_pids[DVBPSI_ROUTER_BATCH];
+        uint8_t pi_ccs[DVBPSI_ROUTER_BATCH];
+        for (size_t j = 0; j < i_size; j++)
+        {
+            const uint8_t *p_packet = p_first + j * i_stride;
+            pi_pids[j] = (p_packet[0] == 0x47)
+                       ? ((uint16_t)(p_packet[1] & 0x1f) << 8) | p_packet[2]
+                       : DVBPSI_ROUTER_PIDS;
+            pi_ccs[j] = ((p_packet[1] & 0xc0) == 0 && (p_packet[3] & 0xd0) == 0x10)
+                      ? (p_packet[3] & 0x0f) : DVBPSI_ROUTER_NO_CC;
+        }
+
+        uint16_t pi_synced[DVBPSI_ROUTER_BATCH];
+        size_t i_synced = 0;
+
+        size_t j = 0;
+        while (j < i_size)
+        {
+            uint16_t i_pid = pi_pids[j];
+            if (i_pid == DVBPSI_ROUTER_PIDS)
+            {
+                b_ok = false;
+                j++;
+                continue;
+            }
+
+            dvbpsi_t *p_dvbpsi = p_router->pp_handles[i_pid];
+            if (p_dvbpsi == NULL)
+            {
+                j++;
+                continue;
+            }
+
+            /* A continuous packet continuing no section only moves the
+             * continuity_counter of an idle decoder */
+            uint8_t i_cc = p_router->p_cc[i_pid];
+            if (b_idle && i_cc != DVBPSI_ROUTER_NO_CC && pi_ccs[j] == ((i_cc + 1) & 0x0f))
+            {
+                p_router->p_cc[i_pid] = pi_ccs[j];
+                if (p_router->p_skipped[i_pid]++ == 0)
+                    pi_synced[i_synced++] = i_pid;
+                j++;
+                continue;
+            }
+
+            /* Run of packets of the same PID */
+            size_t i_run = 1;
+            while (j + i_run < i_size && pi_pids[j + i_run] == i_pid)
+                i_run++;
+
+            /* The callbacks may detach the decoder */
+            dvbpsi_router_sync(p_router, i_pid);
+            if (p_dvbpsi->p_decoder)
+                dvbpsi_packets_push(p_dvbpsi, p_first + j * i_stride - i_offset,
+                                    i_run, i_stride);
+            dvbpsi_router_refresh(p_router, i_pid);
+            j += i_run;
+        }
+
+        /* The PIDs detached meanwhile were synced then */
+        for (size_t k = 0; k < i_synced; k++)
+            if (p_router->pp_handles[pi_synced[k]])
+                dvbpsi_router_sync(p_router, pi_synced[k]);
+    }
+
+    return b_ok;
+}
@@ -0,0 +1,186 @@
+/*****************************************************************************
+ * router.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <router.h>
+ * \brief PID router.
+ *
+ * Dispatches the TS packets of a transport stream to the dvbpsi_t handles
+ * attached to their PID.
+ */
+
+#ifndef _DVBPSI_ROUTER_H_
+#define _DVBPSI_ROUTER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_router_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_router_s dvbpsi_router_t
+ * \brief dvbpsi_router_t type definition, an opaque PID to handle table.
+ */
+typedef struct dvbpsi_router_s dvbpsi_router_t;
+
+/*!
+ * \def DVBPSI_ROUTER_PIDS
+ * \brief Number of PIDs of a transport stream
+ */
+#define DVBPSI_ROUTER_PIDS 8192
+
+/*****************************************************************************
+ * dvbpsi_router_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_router_t *dvbpsi_router_new(void)
+ * \brief Creates a PID router without any attached PID
+ * \return pointer to the router, or NULL on error
+ */
+dvbpsi_router_t *dvbpsi_router_new(void);
+
+/*****************************************************************************
+ * dvbpsi_router_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_router_delete(dvbpsi_router_t *p_router)
+ * \brief Deletes a PID router. The attached handles are not deleted.
+ * \param p_router pointer to the router
+ * \return nothing
+ */
+void dvbpsi_router_delete(dvbpsi_router_t *p_router);
+
+/*****************************************************************************
+ * dvbpsi_router_set_packet_format
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_router_set_packet_format(dvbpsi_router_t *p_router,
+ *                                          dvbpsi_packet_format_t i_format)
+ * \brief Sets the framing of the packets pushed into a router
+ * \param p_router pointer to the router
+ * \param i_format packet framing, DVBPSI_PACKET_TS by default
+ * \return false if PIDs are already attached, true otherwise.
+ *
+ * The framed packets are given as they are to the handles, which must be set
+ * to the same format with dvbpsi_set_packet_format() before being attached.
+ */
+bool dvbpsi_router_set_packet_format(dvbpsi_router_t *p_router,
+                                     dvbpsi_packet_format_t i_format);
+
+/*****************************************************************************
+ * dvbpsi_router_get_packet_format
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_packet_format_t dvbpsi_router_get_packet_format(const dvbpsi_router_t *p_router)
+ * \brief Gets the framing of the packets pushed into a router
+ * \param p_router pointer to the router
+ * \return the packet framing, to be set on the handles to attach.
+ */
+dvbpsi_packet_format_t dvbpsi_router_get_packet_format(const dvbpsi_router_t *p_router);
+
+/*****************************************************************************
+ * dvbpsi_router_attach
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_router_attach(dvbpsi_router_t *p_router, uint16_t i_pid,
+ *                               dvbpsi_t *p_dvbpsi)
+ * \brief Forwards the TS packets of a PID to a handle
+ * \param p_router pointer to the router
+ * \param i_pid PID, 0 to 0x1fff
+ * \param p_dvbpsi handle the packets are given to
+ * \return true on success, false if the PID is invalid, already attached
+ *         to another handle or if the handle packet format is not the router
+ *         one.
+ *
+ * One handle may be attached to several PIDs. Packets are only given to the
+ * handle while a decoder is attached to it. The packets of an attached PID
+ * must only be given to the handle through the router, which keeps the
+ * continuity_counter of its idle decoder, see dvbpsi_router_push().
+ */
+bool dvbpsi_router_attach(dvbpsi_router_t *p_router, uint16_t i_pid,
+                          dvbpsi_t *p_dvbpsi);
+
+/*****************************************************************************
+ * dvbpsi_router_detach
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_t *dvbpsi_router_detach(dvbpsi_router_t *p_router, uint16_t i_pid)
+ * \brief Stops forwarding the TS packets of a PID
+ * \param p_router pointer to the router
+ * \param i_pid PID, 0 to 0x1fff
+ * \return the handle that was attached to the PID, or NULL
+ */
+dvbpsi_t *dvbpsi_router_detach(dvbpsi_router_t *p_router, uint16_t i_pid);
+
+/*****************************************************************************
+ * dvbpsi_router_get
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_t *dvbpsi_router_get(dvbpsi_router_t *p_router, uint16_t i_pid)
+ * \brief Gets the handle attached to a PID
+ * \param p_router pointer to the router
+ * \param i_pid PID, 0 to 0x1fff
+ * \return the handle attached to the PID, or NULL
+ */
+dvbpsi_t *dvbpsi_router_get(dvbpsi_router_t *p_router, uint16_t i_pid);
+
+/*****************************************************************************
+ * dvbpsi_router_push
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_router_push(dvbpsi_router_t *p_router, uint8_t *p_data,
+ *                             size_t i_count, size_t i_stride)
+ * \brief Injection of a run of TS packets of a transport stream.
+ * \param p_router pointer to the router
+ * \param p_data pointer to the first of 'i_count' TS packets
+ * \param i_count number of TS packets in the buffer
+ * \param i_stride distance in bytes between the start of two successive
+ *        packets, 0 means the packet size of the router format
+ * \return false when at least one packet was not a TS packet, true otherwise.
+ *
+ * Each packet is given to the handle attached to its PID, packets of other
+ * PIDs cost a single table lookup. Successive packets of the same PID are
+ * given to their handle with one dvbpsi_packets_push() call. Packets that
+ * do not start with a sync byte are skipped.
+ *
+ * The router keeps the continuity_counter of the decoders without a section
+ * in flight in its own PID arrays. A continuous packet that starts no
+ * section, without transport_error_indicator nor scrambling, would only
+ * move that counter: it is passed over without calling the decoder, and
+ * accounted to the handle before the next call and at the end of each
+ * group of 64 packets. The other packets, continuity errors and duplicates
+ * included, go to the decoder. This is not done for M2TS packets, whose
+ * arrival times are followed by the handles, nor for handles attached to
+ * several PIDs.
+ */
+bool dvbpsi_router_push(dvbpsi_router_t *p_router, uint8_t *p_data,
+                        size_t i_count, size_t i_stride);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of router.h"
+#endif
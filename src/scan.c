@@ -0,0 +1,426 @@
+/*****************************************************************************
+ * scan.c: TS buffer scanning and adaptation field parsing
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "dvbpsi.h"
+#include "scan.h"
+
+/*****************************************************************************
+ * dvbpsi_sync_confirmed
+ *****************************************************************************
+ * Whether the sync byte at i_pos starts a packet of the buffer.
+ *****************************************************************************/
+static inline bool dvbpsi_sync_confirmed(const uint8_t *p_data, size_t i_size,
+                                         size_t i_pos, size_t i_stride,
+                                         size_t i_offset)
+{
+    if (i_pos - i_offset + i_stride > i_size)
+        return false;
+
+    return (i_pos + i_stride >= i_size) || (p_data[i_pos + i_stride] == 0x47);
+}
+
+/*****************************************************************************
+ * dvbpsi_sync_find
+ *****************************************************************************/
+size_t dvbpsi_sync_find(const uint8_t *p_data, size_t i_size,
+                        dvbpsi_packet_format_t i_format)
+{
+    size_t i_stride = dvbpsi_get_packet_size(i_format);
+    size_t i_offset = (i_format == DVBPSI_PACKET_M2TS) ? 4 : 0;
+    size_t i_pos = i_offset;
+
+    if (i_size < i_stride)
+        return i_size;
+
+    /* No sync byte can start a whole packet past i_last */
+    size_t i_last = i_size - i_stride + i_offset;
+
+#if defined(__SSE2__)
+    /* Compare 16 bytes at once, stop at the first confirmed candidate */
+    const __m128i sync = _mm_set1_epi8(0x47);
+    while (i_pos + 16 <= i_last + 1)
+    {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)(p_data + i_pos));
+        unsigned int i_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, sync));
+        while (i_mask)
+        {
+            unsigned int i_bit = __builtin_ctz(i_mask);
+            if (dvbpsi_sync_confirmed(p_data, i_size, i_pos + i_bit, i_stride, i_offset))
+                return i_pos + i_bit - i_offset;
+            i_mask &= i_mask - 1;
+        }
+        i_pos += 16;
+    }
+#endif
+
+    while (i_pos <= i_last)
+    {
+        const uint8_t *p_sync = memchr(p_data + i_pos, 0x47, i_last + 1 - i_pos);
+        if (p_sync == NULL)
+            break;
+
+        i_pos = p_sync - p_data;
+        if (dvbpsi_sync_confirmed(p_data, i_size, i_pos, i_stride, i_offset))
+            return i_pos - i_offset;
+        i_pos++;
+    }
+
+    return i_size;
+}
+
+/*****************************************************************************
+ * dvbpsi_packets_scan
+ *****************************************************************************/
+size_t dvbpsi_packets_scan(const uint8_t *p_data, size_t i_size,
+                           dvbpsi_packet_format_t i_format,
+                           dvbpsi_ts_headers_t *p_headers)
+{
+    assert(p_headers);
+
+    size_t i_stride = dvbpsi_get_packet_size(i_format);
+    size_t i_offset = (i_format == DVBPSI_PACKET_M2TS) ? 4 : 0;
+
+    size_t i_packets = i_size / i_stride;
+    if (i_packets > DVBPSI_SCAN_BLOCK)
+        i_packets = DVBPSI_SCAN_BLOCK;
+
+    const uint8_t *p = p_data + i_offset;
+    unsigned int i = 0;
+    for (; i < i_packets; i++, p += i_stride)
+    {
+        if (p[0] != 0x47)
+            break;
+
+        p_headers->pi_pid[i] = ((uint16_t)(p[1] & 0x1f) << 8) | p[2];
+        p_headers->pi_cc[i] = p[3] & 0x0f;
+        p_headers->pi_flags[i] = (p[1] & 0xe0) | (p[3] >> 4);
+    }
+
+    p_headers->i_count = i;
+    return i * i_stride;
+}
+
+/*****************************************************************************
+ * dvbpsi_pcr_read
+ *****************************************************************************
+ * PCR or OPCR at p in 27 MHz units.
+ *****************************************************************************/
+static inline uint64_t dvbpsi_pcr_read(const uint8_t *p)
+{
+    uint64_t i_base = ((uint64_t)p[0] << 25) | ((uint64_t)p[1] << 17)
+                    | ((uint64_t)p[2] << 9) | ((uint64_t)p[3] << 1)
+                    | (p[4] >> 7);
+    return i_base * 300 + ((((uint64_t)p[4] & 0x01) << 8) | p[5]);
+}
+
+/*****************************************************************************
+ * dvbpsi_timestamp_read
+ *****************************************************************************
+ * 33 bits PTS, DTS or DTS_next_AU at p, split by marker bits.
+ *****************************************************************************/
+static inline uint64_t dvbpsi_timestamp_read(const uint8_t *p)
+{
+    return ((uint64_t)(p[0] & 0x0e) << 29)
+         | ((uint64_t)p[1] << 22) | ((uint64_t)(p[2] & 0xfe) << 14)
+         | ((uint64_t)p[3] << 7) | (p[4] >> 1);
+}
+
+/*****************************************************************************
+ * dvbpsi_adaptation_parse
+ *****************************************************************************/
+bool dvbpsi_adaptation_parse(const uint8_t *p_packet,
+                             dvbpsi_adaptation_t *p_adaptation)
+{
+    assert(p_packet);
+    assert(p_adaptation);
+
+    dvbpsi_adaptation_t *p_af = p_adaptation;
+    p_af->i_length = 0;
+    p_af->i_flags = 0;
+    p_af->i_extension_flags = 0;
+
+    if (!(p_packet[3] & 0x20) || p_packet[4] > 183)
+        return false;
+
+    p_af->i_length = p_packet[4];
+    if (p_af->i_length == 0)
+        return true;
+
+    /* Past the last byte of the adaptation field */
+    const uint8_t *p_end = p_packet + 5 + p_af->i_length;
+    const uint8_t *p = p_packet + 6;
+    uint8_t i_flags = p_packet[5];
+
+    /* Indicators */
+    p_af->i_flags = i_flags & (DVBPSI_AF_DISCONTINUITY | DVBPSI_AF_RANDOM_ACCESS
+                               | DVBPSI_AF_ES_PRIORITY);
+
+    if (i_flags & DVBPSI_AF_PCR)
+    {
+        if (p + 6 > p_end)
+            return true;
+        p_af->i_pcr = dvbpsi_pcr_read(p);
+        p_af->i_flags |= DVBPSI_AF_PCR;
+        p += 6;
+    }
+
+    if (i_flags & DVBPSI_AF_OPCR)
+    {
+        if (p + 6 > p_end)
+            return true;
+        p_af->i_opcr = dvbpsi_pcr_read(p);
+        p_af->i_flags |= DVBPSI_AF_OPCR;
+        p += 6;
+    }
+
+    if (i_flags & DVBPSI_AF_SPLICING_POINT)
+    {
+        if (p + 1 > p_end)
+            return true;
+        p_af->i_splice_countdown = (int8_t)p[0];
+        p_af->i_flags |= DVBPSI_AF_SPLICING_POINT;
+        p++;
+    }
+
+    if (i_flags & DVBPSI_AF_PRIVATE_DATA)
+    {
+        if (p + 1 > p_end || p + 1 + p[0] > p_end)
+            return true;
+        p_af->i_private_length = p[0];
+        p_af->i_private_offset = p + 1 - p_packet;
+        p_af->i_flags |= DVBPSI_AF_PRIVATE_DATA;
+        p += 1 + p[0];
+    }
+
+    if (!(i_flags & DVBPSI_AF_EXTENSION) || p + 1 > p_end || p + 1 + p[0] > p_end)
+        return true;
+
+    /* Adaptation field extension, its flags in its first byte when not empty */
+    const uint8_t *p_ext_end = p + 1 + p[0];
+    p_af->i_extension_length = p[0];
+    p_af->i_flags |= DVBPSI_AF_EXTENSION;
+    if (p[0] == 0)
+        return true;
+
+    uint8_t i_ext_flags = p[1];
+    p += 2;
+
+    if (i_ext_flags & DVBPSI_AF_LTW)
+    {
+        if (p + 2 > p_ext_end)
+            return true;
+        p_af->b_ltw_valid = p[0] & 0x80;
+        p_af->i_ltw_offset = ((uint16_t)(p[0] & 0x7f) << 8) | p[1];
+        p_af->i_extension_flags |= DVBPSI_AF_LTW;
+        p += 2;
+    }
+
+    if (i_ext_flags & DVBPSI_AF_PIECEWISE_RATE)
+    {
+        if (p + 3 > p_ext_end)
+            return true;
+        p_af->i_piecewise_rate = ((uint32_t)(p[0] & 0x3f) << 16)
+                               | ((uint32_t)p[1] << 8) | p[2];
+        p_af->i_extension_flags |= DVBPSI_AF_PIECEWISE_RATE;
+        p += 3;
+    }
+
+    if (i_ext_flags & DVBPSI_AF_SEAMLESS_SPLICE)
+    {
+        if (p + 5 > p_ext_end)
+            return true;
+        p_af->i_splice_type = p[0] >> 4;
+        p_af->i_dts_next_au = dvbpsi_timestamp_read(p);
+        p_af->i_extension_flags |= DVBPSI_AF_SEAMLESS_SPLICE;
+    }
+
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_pcrs_scan
+ *****************************************************************************/
+size_t dvbpsi_pcrs_scan(const uint8_t *p_data, size_t i_size,
+                        dvbpsi_packet_format_t i_format,
+                        const uint8_t *p_pids, dvbpsi_pcrs_t *p_pcrs)
+{
+    assert(p_pcrs);
+
+    size_t i_stride = dvbpsi_get_packet_size(i_format);
+    size_t i_offset = (i_format == DVBPSI_PACKET_M2TS) ? 4 : 0;
+
+    size_t i_packets = i_size / i_stride;
+    if (i_packets > DVBPSI_SCAN_BLOCK)
+        i_packets = DVBPSI_SCAN_BLOCK;
+
+    const uint8_t *p = p_data + i_offset;
+    unsigned int i = 0, i_count = 0;
+    for (; i < i_packets; i++, p += i_stride)
+    {
+        if (p[0] != 0x47)
+            break;
+
+        /* Adaptation field long enough for a PCR, with the PCR flag */
+        if (!(p[3] & 0x20) | (p[4] < 7) | !(p[5] & DVBPSI_AF_PCR))
+            continue;
+
+        uint16_t i_pid = ((uint16_t)(p[1] & 0x1f) << 8) | p[2];
+        if (p_pids && !(p_pids[i_pid >> 3] & (1 << (i_pid & 7))))
+            continue;
+
+        p_pcrs->pi_packet[i_count] = i;
+        p_pcrs->pi_pid[i_count] = i_pid;
+        p_pcrs->pb_discontinuity[i_count] = p[5] & DVBPSI_AF_DISCONTINUITY;
+        p_pcrs->pi_pcr[i_count] = dvbpsi_pcr_read(p + 6);
+        i_count++;
+    }
+
+    p_pcrs->i_count = i_count;
+    return i * i_stride;
+}
+
+/*****************************************************************************
+ * dvbpsi_pes_optional_header
+ *****************************************************************************
+ * Whether the PES packets of a stream_id have the optional PES header with
+ * the PTS and DTS, ISO/IEC 13818-1 2.4.3.7.
+ *****************************************************************************/
+static inline bool dvbpsi_pes_optional_header(uint8_t i_stream_id)
+{
+    switch (i_stream_id)
+    {
+        case 0xbc: /* program_stream_map */
+        case 0xbe: /* padding_stream */
+        case 0xbf: /* private_stream_2 */
+        case 0xf0: /* ECM */
+        case 0xf1: /* EMM */
+        case 0xf2: /* DSMCC_stream */
+        case 0xf8: /* ITU-T H.222.1 type E */
+        case 0xff: /* program_stream_directory */
+            return false;
+        default:
+            return true;
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_pes_scan
+ *****************************************************************************/
+size_t dvbpsi_pes_scan(const uint8_t *p_data, size_t i_size,
+                       dvbpsi_packet_format_t i_format,
+                       const uint8_t *p_pids, dvbpsi_pes_headers_t *p_pes)
+{
+    assert(p_pes);
+
+    size_t i_stride = dvbpsi_get_packet_size(i_format);
+    size_t i_offset = (i_format == DVBPSI_PACKET_M2TS) ? 4 : 0;
+
+    size_t i_packets = i_size / i_stride;
+    if (i_packets > DVBPSI_SCAN_BLOCK)
+        i_packets = DVBPSI_SCAN_BLOCK;
+
+    const uint8_t *p = p_data + i_offset;
+    unsigned int i = 0, i_count = 0;
+    for (; i < i_packets; i++, p += i_stride)
+    {
+        if (p[0] != 0x47)
+            break;
+
+        /* Start of a PES packet in a clear payload */
+        if (!(p[1] & 0x40) | ((p[3] & 0xd0) != 0x10))
+            continue;
+
+        uint16_t i_pid = ((uint16_t)(p[1] & 0x1f) << 8) | p[2];
+        if (p_pids && !(p_pids[i_pid >> 3] & (1 << (i_pid & 7))))
+            continue;
+
+        size_t i_start = (p[3] & 0x20) ? 5 + p[4] : 4;
+        if (i_start + 6 > 188)
+            continue;
+        const uint8_t *p_header = p + i_start;
+        if (p_header[0] | p_header[1] | (p_header[2] ^ 0x01))
+            continue;
+
+        uint8_t i_flags = 0;
+        uint8_t i_stream_id = p_header[3];
+        if (dvbpsi_pes_optional_header(i_stream_id) && i_start + 9 <= 188
+         && (p_header[6] & 0xc0) == 0x80)
+        {
+            uint8_t i_pts_dts = p_header[7] >> 6;
+            uint8_t i_header_length = p_header[8];
+            if ((i_pts_dts & 0x2) && i_header_length >= 5 && i_start + 14 <= 188)
+            {
+                p_pes->pi_pts[i_count] = dvbpsi_timestamp_read(p_header + 9);
+                i_flags |= DVBPSI_PES_PTS;
+                if (i_pts_dts == 0x3 && i_header_length >= 10 && i_start + 19 <= 188)
+                {
+                    p_pes->pi_dts[i_count] = dvbpsi_timestamp_read(p_header + 14);
+                    i_flags |= DVBPSI_PES_DTS;
+                }
+            }
+        }
+
+        if ((p[3] & 0x20) && p[4] >= 1)
+        {
+            if (p[5] & DVBPSI_AF_DISCONTINUITY)
+                i_flags |= DVBPSI_PES_DISCONTINUITY;
+            if (p[5] & DVBPSI_AF_RANDOM_ACCESS)
+                i_flags |= DVBPSI_PES_RANDOM_ACCESS;
+            if (p[4] >= 7 && (p[5] & DVBPSI_AF_PCR))
+            {
+                p_pes->pi_pcr[i_count] = dvbpsi_pcr_read(p + 6);
+                i_flags |= DVBPSI_PES_PCR;
+            }
+        }
+
+        p_pes->pi_packet[i_count] = i;
+        p_pes->pi_pid[i_count] = i_pid;
+        p_pes->pi_stream_id[i_count] = i_stream_id;
+        p_pes->pi_flags[i_count] = i_flags;
+        p_pes->pi_length[i_count] = ((uint16_t)p_header[4] << 8) | p_header[5];
+        i_count++;
+    }
+
+    p_pes->i_count = i_count;
+    return i * i_stride;
+}
@@ -0,0 +1,397 @@
+/*****************************************************************************
+ * scan.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <scan.h>
+ * \brief TS buffer scanning.
+ *
+ * Sync byte search, extraction of the TS packet headers of a buffer,
+ * parsing of the adaptation fields and of the PES headers.
+ */
+
+#ifndef _DVBPSI_SCAN_H_
+#define _DVBPSI_SCAN_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \def DVBPSI_SCAN_BLOCK
+ * \brief Maximum number of packets described by a dvbpsi_ts_headers_t
+ */
+#define DVBPSI_SCAN_BLOCK 64
+
+/*!
+ * \def DVBPSI_TS_TEI
+ * \brief transport_error_indicator bit of dvbpsi_ts_headers_t::pi_flags
+ */
+#define DVBPSI_TS_TEI       0x80
+/*!
+ * \def DVBPSI_TS_PUSI
+ * \brief payload_unit_start_indicator bit of dvbpsi_ts_headers_t::pi_flags
+ */
+#define DVBPSI_TS_PUSI      0x40
+/*!
+ * \def DVBPSI_TS_PRIORITY
+ * \brief transport_priority bit of dvbpsi_ts_headers_t::pi_flags
+ */
+#define DVBPSI_TS_PRIORITY  0x20
+/*!
+ * \def DVBPSI_TS_SCRAMBLING(flags)
+ * \brief transport_scrambling_control of dvbpsi_ts_headers_t::pi_flags
+ */
+#define DVBPSI_TS_SCRAMBLING(flags) (((flags) >> 2) & 0x3)
+/*!
+ * \def DVBPSI_TS_ADAPTATION
+ * \brief adaptation_field present bit of dvbpsi_ts_headers_t::pi_flags
+ */
+#define DVBPSI_TS_ADAPTATION 0x02
+/*!
+ * \def DVBPSI_TS_PAYLOAD
+ * \brief payload present bit of dvbpsi_ts_headers_t::pi_flags
+ */
+#define DVBPSI_TS_PAYLOAD   0x01
+
+/*****************************************************************************
+ * dvbpsi_ts_headers_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_ts_headers_s
+ * \brief Headers of a block of successive TS packets, one array per field.
+ *
+ * Packet i of the block starts i strides after the start of the block.
+ */
+/*!
+ * \typedef struct dvbpsi_ts_headers_s dvbpsi_ts_headers_t
+ * \brief dvbpsi_ts_headers_t type definition.
+ */
+typedef struct dvbpsi_ts_headers_s
+{
+    unsigned int i_count;                     /*!< number of packets */
+    uint16_t     pi_pid[DVBPSI_SCAN_BLOCK];   /*!< PID */
+    uint8_t      pi_cc[DVBPSI_SCAN_BLOCK];    /*!< continuity_counter */
+    uint8_t      pi_flags[DVBPSI_SCAN_BLOCK]; /*!< DVBPSI_TS_* flags */
+} dvbpsi_ts_headers_t;
+
+/*****************************************************************************
+ * dvbpsi_sync_find
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_sync_find(const uint8_t *p_data, size_t i_size,
+ *                             dvbpsi_packet_format_t i_format)
+ * \brief Finds the first packet of a buffer
+ * \param p_data buffer
+ * \param i_size size of the buffer in bytes
+ * \param i_format framing of the packets
+ * \return offset of the first packet, i_size if there is none.
+ *
+ * A packet is found at the first sync byte that starts a whole packet in the
+ * buffer and is followed by another sync byte one packet later, when the
+ * buffer holds it. The offset is the one of the framed packet, 4 bytes
+ * before the sync byte for DVBPSI_PACKET_M2TS.
+ */
+size_t dvbpsi_sync_find(const uint8_t *p_data, size_t i_size,
+                        dvbpsi_packet_format_t i_format);
+
+/*****************************************************************************
+ * dvbpsi_packets_scan
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_packets_scan(const uint8_t *p_data, size_t i_size,
+ *                                dvbpsi_packet_format_t i_format,
+ *                                dvbpsi_ts_headers_t *p_headers)
+ * \brief Extracts the headers of the packets at the start of a buffer
+ * \param p_data buffer, starting with a packet
+ * \param i_size size of the buffer in bytes
+ * \param i_format framing of the packets
+ * \param p_headers receives the headers of up to DVBPSI_SCAN_BLOCK packets
+ * \return number of bytes scanned, p_headers->i_count packets.
+ *
+ * Scanning stops at the end of the buffer, after DVBPSI_SCAN_BLOCK packets or
+ * at the first packet without a sync byte. When fewer bytes than a packet
+ * remain, or sync was lost, call dvbpsi_sync_find() on the rest of the
+ * buffer.
+ */
+size_t dvbpsi_packets_scan(const uint8_t *p_data, size_t i_size,
+                           dvbpsi_packet_format_t i_format,
+                           dvbpsi_ts_headers_t *p_headers);
+
+/*!
+ * \def DVBPSI_AF_DISCONTINUITY
+ * \brief discontinuity_indicator bit of dvbpsi_adaptation_t::i_flags
+ */
+#define DVBPSI_AF_DISCONTINUITY     0x80
+/*!
+ * \def DVBPSI_AF_RANDOM_ACCESS
+ * \brief random_access_indicator bit of dvbpsi_adaptation_t::i_flags
+ */
+#define DVBPSI_AF_RANDOM_ACCESS     0x40
+/*!
+ * \def DVBPSI_AF_ES_PRIORITY
+ * \brief elementary_stream_priority_indicator bit of
+ * dvbpsi_adaptation_t::i_flags
+ */
+#define DVBPSI_AF_ES_PRIORITY       0x20
+/*!
+ * \def DVBPSI_AF_PCR
+ * \brief PCR present bit of dvbpsi_adaptation_t::i_flags
+ */
+#define DVBPSI_AF_PCR               0x10
+/*!
+ * \def DVBPSI_AF_OPCR
+ * \brief OPCR present bit of dvbpsi_adaptation_t::i_flags
+ */
+#define DVBPSI_AF_OPCR              0x08
+/*!
+ * \def DVBPSI_AF_SPLICING_POINT
+ * \brief splice_countdown present bit of dvbpsi_adaptation_t::i_flags
+ */
+#define DVBPSI_AF_SPLICING_POINT    0x04
+/*!
+ * \def DVBPSI_AF_PRIVATE_DATA
+ * \brief transport_private_data present bit of dvbpsi_adaptation_t::i_flags
+ */
+#define DVBPSI_AF_PRIVATE_DATA      0x02
+/*!
+ * \def DVBPSI_AF_EXTENSION
+ * \brief adaptation_field_extension present bit of
+ * dvbpsi_adaptation_t::i_flags
+ */
+#define DVBPSI_AF_EXTENSION         0x01
+
+/*!
+ * \def DVBPSI_AF_LTW
+ * \brief ltw_offset present bit of dvbpsi_adaptation_t::i_extension_flags
+ */
+#define DVBPSI_AF_LTW               0x80
+/*!
+ * \def DVBPSI_AF_PIECEWISE_RATE
+ * \brief piecewise_rate present bit of dvbpsi_adaptation_t::i_extension_flags
+ */
+#define DVBPSI_AF_PIECEWISE_RATE    0x40
+/*!
+ * \def DVBPSI_AF_SEAMLESS_SPLICE
+ * \brief splice_type and DTS_next_AU present bit of
+ * dvbpsi_adaptation_t::i_extension_flags
+ */
+#define DVBPSI_AF_SEAMLESS_SPLICE   0x20
+
+/*****************************************************************************
+ * dvbpsi_adaptation_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_adaptation_s
+ * \brief Fields of an adaptation field, see dvbpsi_adaptation_parse()
+ *
+ * Only the fields whose bit is set in i_flags or i_extension_flags are
+ * meaningful.
+ */
+/*!
+ * \typedef struct dvbpsi_adaptation_s dvbpsi_adaptation_t
+ * \brief dvbpsi_adaptation_t type definition.
+ */
+typedef struct dvbpsi_adaptation_s
+{
+    uint8_t  i_length;            /*!< adaptation_field_length */
+    uint8_t  i_flags;             /*!< DVBPSI_AF_* indicators and fields
+                                       present */
+    uint8_t  i_extension_length;  /*!< adaptation_field_extension_length */
+    uint8_t  i_extension_flags;   /*!< DVBPSI_AF_LTW, DVBPSI_AF_PIECEWISE_RATE
+                                       and DVBPSI_AF_SEAMLESS_SPLICE */
+    int8_t   i_splice_countdown;  /*!< splice_countdown */
+    uint8_t  i_private_offset;    /*!< offset of the transport_private_data
+                                       in the TS packet */
+    uint8_t  i_private_length;    /*!< transport_private_data_length */
+    uint8_t  i_splice_type;       /*!< splice_type */
+    bool     b_ltw_valid;         /*!< ltw_valid_flag */
+    uint16_t i_ltw_offset;        /*!< ltw_offset, 15 bits */
+    uint32_t i_piecewise_rate;    /*!< piecewise_rate, 22 bits */
+    uint64_t i_pcr;               /*!< PCR in 27 MHz units, base * 300 +
+                                       extension */
+    uint64_t i_opcr;              /*!< OPCR in 27 MHz units */
+    uint64_t i_dts_next_au;       /*!< DTS_next_AU, 33 bits */
+} dvbpsi_adaptation_t;
+
+/*****************************************************************************
+ * dvbpsi_adaptation_parse
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_adaptation_parse(const uint8_t *p_packet,
+ *                                  dvbpsi_adaptation_t *p_adaptation)
+ * \brief Parses the adaptation field of a TS packet
+ * \param p_packet TS packet, starting with its sync byte
+ * \param p_adaptation receives the fields
+ * \return false if the packet has no adaptation field or its
+ *         adaptation_field_length goes past the packet.
+ *
+ * A field that does not fit in adaptation_field_length is not parsed and
+ * its bit is cleared, as are the bits of the fields following it. An empty
+ * adaptation field, a single stuffing byte, has an i_length and i_flags
+ * of 0.
+ */
+bool dvbpsi_adaptation_parse(const uint8_t *p_packet,
+                             dvbpsi_adaptation_t *p_adaptation);
+
+/*!
+ * \def DVBPSI_PIDS_SIZE
+ * \brief Size in bytes of a bitmap of the 8192 PIDs, PID i being bit
+ * (i & 7) of byte i / 8
+ */
+#define DVBPSI_PIDS_SIZE (8192 / 8)
+
+/*****************************************************************************
+ * dvbpsi_pcrs_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_pcrs_s
+ * \brief PCRs of a block of successive TS packets, one array per field.
+ */
+/*!
+ * \typedef struct dvbpsi_pcrs_s dvbpsi_pcrs_t
+ * \brief dvbpsi_pcrs_t type definition.
+ */
+typedef struct dvbpsi_pcrs_s
+{
+    unsigned int i_count;                       /*!< number of PCRs */
+    uint8_t      pi_packet[DVBPSI_SCAN_BLOCK];  /*!< index of the packet in
+                                                     the block */
+    uint16_t     pi_pid[DVBPSI_SCAN_BLOCK];     /*!< PID */
+    bool         pb_discontinuity[DVBPSI_SCAN_BLOCK]; /*!< discontinuity_indicator */
+    uint64_t     pi_pcr[DVBPSI_SCAN_BLOCK];     /*!< PCR in 27 MHz units */
+} dvbpsi_pcrs_t;
+
+/*****************************************************************************
+ * dvbpsi_pcrs_scan
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_pcrs_scan(const uint8_t *p_data, size_t i_size,
+ *                             dvbpsi_packet_format_t i_format,
+ *                             const uint8_t *p_pids, dvbpsi_pcrs_t *p_pcrs)
+ * \brief Extracts the PCRs of the packets at the start of a buffer
+ * \param p_data buffer, starting with a packet
+ * \param i_size size of the buffer in bytes
+ * \param i_format framing of the packets
+ * \param p_pids bitmap of DVBPSI_PIDS_SIZE bytes of the PIDs whose PCRs are
+ *        wanted, NULL for all of them
+ * \param p_pcrs receives the PCRs of up to DVBPSI_SCAN_BLOCK packets
+ * \return number of bytes scanned, as dvbpsi_packets_scan() would.
+ *
+ * Scanning stops as for dvbpsi_packets_scan(). Only the adaptation field of
+ * the packets of the wanted PIDs is read.
+ */
+size_t dvbpsi_pcrs_scan(const uint8_t *p_data, size_t i_size,
+                        dvbpsi_packet_format_t i_format,
+                        const uint8_t *p_pids, dvbpsi_pcrs_t *p_pcrs);
+
+/*!
+ * \def DVBPSI_PES_PTS
+ * \brief PTS present bit of dvbpsi_pes_headers_t::pi_flags
+ */
+#define DVBPSI_PES_PTS              0x80
+/*!
+ * \def DVBPSI_PES_DTS
+ * \brief DTS present bit of dvbpsi_pes_headers_t::pi_flags
+ */
+#define DVBPSI_PES_DTS              0x40
+/*!
+ * \def DVBPSI_PES_PCR
+ * \brief PCR present bit of dvbpsi_pes_headers_t::pi_flags, the PCR being
+ * carried by the adaptation field of the packet starting the PES packet
+ */
+#define DVBPSI_PES_PCR              0x20
+/*!
+ * \def DVBPSI_PES_DISCONTINUITY
+ * \brief discontinuity_indicator bit of dvbpsi_pes_headers_t::pi_flags
+ */
+#define DVBPSI_PES_DISCONTINUITY    0x10
+/*!
+ * \def DVBPSI_PES_RANDOM_ACCESS
+ * \brief random_access_indicator bit of dvbpsi_pes_headers_t::pi_flags
+ */
+#define DVBPSI_PES_RANDOM_ACCESS    0x08
+
+/*****************************************************************************
+ * dvbpsi_pes_headers_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_pes_headers_s
+ * \brief PES headers starting in a block of successive TS packets, one array
+ * per field.
+ *
+ * Only the fields whose bit is set in pi_flags are meaningful, besides the
+ * packet index, PID, stream_id and PES_packet_length.
+ */
+/*!
+ * \typedef struct dvbpsi_pes_headers_s dvbpsi_pes_headers_t
+ * \brief dvbpsi_pes_headers_t type definition.
+ */
+typedef struct dvbpsi_pes_headers_s
+{
+    unsigned int i_count;                       /*!< number of PES headers */
+    uint8_t      pi_packet[DVBPSI_SCAN_BLOCK];  /*!< index of the packet in
+                                                     the block */
+    uint16_t     pi_pid[DVBPSI_SCAN_BLOCK];     /*!< PID */
+    uint8_t      pi_stream_id[DVBPSI_SCAN_BLOCK]; /*!< stream_id */
+    uint8_t      pi_flags[DVBPSI_SCAN_BLOCK];   /*!< DVBPSI_PES_* flags */
+    uint16_t     pi_length[DVBPSI_SCAN_BLOCK];  /*!< PES_packet_length, 0 if
+                                                     unbounded */
+    uint64_t     pi_pts[DVBPSI_SCAN_BLOCK];     /*!< PTS, 33 bits */
+    uint64_t     pi_dts[DVBPSI_SCAN_BLOCK];     /*!< DTS, 33 bits */
+    uint64_t     pi_pcr[DVBPSI_SCAN_BLOCK];     /*!< PCR in 27 MHz units */
+} dvbpsi_pes_headers_t;
+
+/*****************************************************************************
+ * dvbpsi_pes_scan
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_pes_scan(const uint8_t *p_data, size_t i_size,
+ *                            dvbpsi_packet_format_t i_format,
+ *                            const uint8_t *p_pids, dvbpsi_pes_headers_t *p_pes)
+ * \brief Extracts the PES headers starting in the packets at the start of a
+ * buffer
+ * \param p_data buffer, starting with a packet
+ * \param i_size size of the buffer in bytes
+ * \param i_format framing of the packets
+ * \param p_pids bitmap of DVBPSI_PIDS_SIZE bytes of the PIDs whose PES
+ *        headers are wanted, NULL for all of them
+ * \param p_pes receives the PES headers of up to DVBPSI_SCAN_BLOCK packets
+ * \return number of bytes scanned, as dvbpsi_packets_scan() would.
+ *
+ * Scanning stops as for dvbpsi_packets_scan(). Only the packets of the
+ * wanted PIDs with the payload_unit_start_indicator set, a payload that is
+ * not scrambled and a packet_start_code_prefix are read, nothing is
+ * reassembled: a PTS or DTS that does not fit in the first packet is left
+ * out. The packet indexes are those of dvbpsi_pcrs_scan() on the same
+ * buffer, so that the PTS can be put against the PCRs of the program.
+ */
+size_t dvbpsi_pes_scan(const uint8_t *p_data, size_t i_size,
+                       dvbpsi_packet_format_t i_format,
+                       const uint8_t *p_pids, dvbpsi_pes_headers_t *p_pes);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of scan.h"
+#endif
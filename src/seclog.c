@@ -0,0 +1,810 @@
+/*****************************************************************************
+ * seclog.c: section logs, recording and replay of the PSI and SI of a stream
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#ifdef HAVE_CLOCK_GETTIME
+#include <time.h>
+#endif
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "seclog.h"
+
+#define SECLOG_MAGIC            "DVBPSISL"
+#define SECLOG_VERSION          1
+#define SECLOG_HEADER_SIZE      32
+#define SECLOG_RECORD_SIZE      16
+#define SECLOG_INDEX_SIZE       16
+#define SECLOG_EVENT_SIZE       24
+#define SECLOG_SECTION          0
+#define SECLOG_INDEX            1
+#define SECLOG_EVENT            2
+/* Smallest ring, holding the largest section */
+#define SECLOG_RING_MIN         8192
+
+/*****************************************************************************
+ * Atomics
+ *****************************************************************************
+ * The tail of a ring is moved past the records about to be overwritten
+ * before they are, and its head past a new record once written: a reader
+ * copying the records in between checks the tail did not move over them.
+ *****************************************************************************/
+#ifdef __ATOMIC_SEQ_CST
+#   define SECLOG_LOAD(p, order)        __atomic_load_n(p, __ATOMIC_##order)
+#   define SECLOG_STORE(p, v, order)    __atomic_store_n(p, v, __ATOMIC_##order)
+#   define SECLOG_FENCE(order)          __atomic_thread_fence(__ATOMIC_##order)
+#else
+#   define SECLOG_LOAD(p, order)        (__sync_synchronize(), *(volatile __typeof__(*(p)) *)(p))
+#   define SECLOG_STORE(p, v, order)    do { __sync_synchronize(); \
+                                             *(volatile __typeof__(*(p)) *)(p) = (v); \
+                                             __sync_synchronize(); } while (0)
+#   define SECLOG_FENCE(order)          __sync_synchronize()
+#endif
+
+struct dvbpsi_seclog_s
+{
+    FILE *                  p_file;
+    bool                    b_error;
+    unsigned int            i_index_interval;
+    uint64_t                i_offset;       /* of the next record */
+    uint64_t                i_sections;
+    uint64_t                i_last_index;   /* offset, 0 for none */
+};
+
+struct dvbpsi_seclog_ring_s
+{
+    uint8_t *               p_records;
+    uint64_t                i_size;         /* multiple of 8 */
+    uint64_t                i_head;         /* position after the last
+                                               record */
+    uint64_t                i_tail;         /* position of the first one */
+    int64_t                 i_last_time;    /* of the last section */
+};
+
+/*****************************************************************************
+ * Little endian numbers
+ *****************************************************************************/
+static void seclog_set16(uint8_t *p, uint16_t i)
+{
+    p[0] = i;
+    p[1] = i >> 8;
+}
+
+static void seclog_set32(uint8_t *p, uint32_t i)
+{
+    seclog_set16(p, i);
+    seclog_set16(p + 2, i >> 16);
+}
+
+static void seclog_set64(uint8_t *p, uint64_t i)
+{
+    seclog_set32(p, i);
+    seclog_set32(p + 4, i >> 32);
+}
+
+static uint16_t seclog_get16(const uint8_t *p)
+{
+    return p[0] | (uint16_t)p[1] << 8;
+}
+
+static uint32_t seclog_get32(const uint8_t *p)
+{
+    return seclog_get16(p) | (uint32_t)seclog_get16(p + 2) << 16;
+}
+
+static uint64_t seclog_get64(const uint8_t *p)
+{
+    return seclog_get32(p) | (uint64_t)seclog_get32(p + 4) << 32;
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_header
+ *****************************************************************************/
+static void dvbpsi_seclog_header(uint8_t p_header[SECLOG_HEADER_SIZE],
+                                 uint32_t i_index_interval, uint64_t i_last_index,
+                                 uint64_t i_sections)
+{
+    memcpy(p_header, SECLOG_MAGIC, 8);
+    seclog_set32(p_header + 8, SECLOG_VERSION);
+    seclog_set32(p_header + 12, i_index_interval);
+    seclog_set64(p_header + 16, i_last_index);
+    seclog_set64(p_header + 24, i_sections);
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_record_header
+ *****************************************************************************/
+static void dvbpsi_seclog_record_header(uint8_t p_record[SECLOG_RECORD_SIZE],
+                                        uint8_t i_type, uint16_t i_pid,
+                                        int64_t i_time, size_t i_size)
+{
+    seclog_set32(p_record, i_size);
+    seclog_set16(p_record + 4, i_pid);
+    p_record[6] = i_type;
+    p_record[7] = 0;
+    seclog_set64(p_record + 8, (uint64_t)i_time);
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_event_encode/dvbpsi_seclog_event_decode
+ *****************************************************************************/
+static void dvbpsi_seclog_event_encode(uint8_t p_data[SECLOG_EVENT_SIZE],
+                                       const dvbpsi_event_t *p_event)
+{
+    p_data[0] = p_event->i_type;
+    p_data[1] = p_event->i_table_id;
+    seclog_set16(p_data + 2, p_event->i_extension);
+    p_data[4] = p_event->i_version;
+    p_data[5] = p_event->i_last_version;
+    seclog_set16(p_data + 6, 0);
+    seclog_set32(p_data + 8, p_event->i_expected);
+    seclog_set32(p_data + 12, p_event->i_received);
+    seclog_set64(p_data + 16, p_event->i_count);
+}
+
+static void dvbpsi_seclog_event_decode(const uint8_t p_data[SECLOG_EVENT_SIZE],
+                                       uint16_t i_pid, dvbpsi_event_t *p_event)
+{
+    p_event->i_type = (dvbpsi_event_type_t)p_data[0];
+    p_event->i_pid = i_pid;
+    p_event->i_table_id = p_data[1];
+    p_event->i_extension = seclog_get16(p_data + 2);
+    p_event->i_version = p_data[4];
+    p_event->i_last_version = p_data[5];
+    p_event->i_expected = seclog_get32(p_data + 8);
+    p_event->i_received = seclog_get32(p_data + 12);
+    p_event->i_count = seclog_get64(p_data + 16);
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_open
+ *****************************************************************************/
+dvbpsi_seclog_t *dvbpsi_seclog_open(const char *psz_path,
+                                    unsigned int i_index_interval)
+{
+    assert(psz_path);
+
+    dvbpsi_seclog_t *p_log = dvbpsi_calloc(1, sizeof(dvbpsi_seclog_t));
+    if (p_log == NULL)
+        return NULL;
+
+    p_log->p_file = fopen(psz_path, "wb");
+    if (p_log->p_file == NULL)
+    {
+        dvbpsi_free(p_log);
+        return NULL;
+    }
+    p_log->i_index_interval = i_index_interval ? i_index_interval : 1024;
+
+    /* Completed by dvbpsi_seclog_close() */
+    uint8_t p_header[SECLOG_HEADER_SIZE];
+    dvbpsi_seclog_header(p_header, p_log->i_index_interval, 0, 0);
+    if (fwrite(p_header, SECLOG_HEADER_SIZE, 1, p_log->p_file) != 1)
+    {
+        fclose(p_log->p_file);
+        dvbpsi_free(p_log);
+        return NULL;
+    }
+    p_log->i_offset = SECLOG_HEADER_SIZE;
+
+    return p_log;
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_record
+ *****************************************************************************
+ * Appends a record, padded to 8 bytes.
+ *****************************************************************************/
+static bool dvbpsi_seclog_record(dvbpsi_seclog_t *p_log, uint8_t i_type,
+                                 uint16_t i_pid, int64_t i_time,
+                                 const uint8_t *p_data, size_t i_size)
+{
+    static const uint8_t p_padding[8];
+    uint8_t p_record[SECLOG_RECORD_SIZE];
+    size_t i_padding = -i_size & 7;
+
+    dvbpsi_seclog_record_header(p_record, i_type, i_pid, i_time, i_size);
+    if (fwrite(p_record, SECLOG_RECORD_SIZE, 1, p_log->p_file) != 1
+     || fwrite(p_data, i_size, 1, p_log->p_file) != 1
+     || (i_padding && fwrite(p_padding, i_padding, 1, p_log->p_file) != 1))
+    {
+        p_log->b_error = true;
+        return false;
+    }
+    p_log->i_offset += SECLOG_RECORD_SIZE + i_size + i_padding;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_write
+ *****************************************************************************/
+bool dvbpsi_seclog_write(dvbpsi_seclog_t *p_log, uint16_t i_pid, int64_t i_time,
+                         const uint8_t *p_section, size_t i_size)
+{
+    assert(p_log);
+    assert(p_section);
+
+    if (i_size < 3 || i_size > 4096 || p_log->b_error)
+        return false;
+
+    /* Index record before every interval */
+    if (p_log->i_sections % p_log->i_index_interval == 0)
+    {
+        uint8_t p_index[SECLOG_INDEX_SIZE];
+        uint64_t i_offset = p_log->i_offset;
+
+        seclog_set64(p_index, p_log->i_last_index);
+        seclog_set64(p_index + 8, p_log->i_sections);
+        if (!dvbpsi_seclog_record(p_log, SECLOG_INDEX, 0, i_time,
+                                  p_index, SECLOG_INDEX_SIZE))
+            return false;
+        p_log->i_last_index = i_offset;
+    }
+
+    if (!dvbpsi_seclog_record(p_log, SECLOG_SECTION, i_pid, i_time, p_section, i_size))
+        return false;
+    p_log->i_sections++;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_write_event
+ *****************************************************************************/
+bool dvbpsi_seclog_write_event(dvbpsi_seclog_t *p_log, int64_t i_time,
+                               const dvbpsi_event_t *p_event)
+{
+    assert(p_log);
+    assert(p_event);
+
+    if (p_log->b_error)
+        return false;
+
+    uint8_t p_data[SECLOG_EVENT_SIZE];
+    dvbpsi_seclog_event_encode(p_data, p_event);
+    return dvbpsi_seclog_record(p_log, SECLOG_EVENT, p_event->i_pid, i_time,
+                                p_data, SECLOG_EVENT_SIZE);
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_tap
+ *****************************************************************************/
+void dvbpsi_seclog_tap(void *p_log, uint16_t i_pid, int64_t i_time,
+                       const uint8_t *p_section, size_t i_size)
+{
+    dvbpsi_seclog_write((dvbpsi_seclog_t *)p_log, i_pid, i_time, p_section, i_size);
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_close
+ *****************************************************************************/
+bool dvbpsi_seclog_close(dvbpsi_seclog_t *p_log)
+{
+    assert(p_log);
+
+    bool b_ok = !p_log->b_error;
+    if (b_ok)
+    {
+        uint8_t p_header[SECLOG_HEADER_SIZE];
+        dvbpsi_seclog_header(p_header, p_log->i_index_interval, p_log->i_last_index,
+                             p_log->i_sections);
+        b_ok = fseek(p_log->p_file, 0, SEEK_SET) == 0
+            && fwrite(p_header, SECLOG_HEADER_SIZE, 1, p_log->p_file) == 1;
+    }
+    if (fclose(p_log->p_file) != 0)
+        b_ok = false;
+    dvbpsi_free(p_log);
+    return b_ok;
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_reader_init
+ *****************************************************************************/
+bool dvbpsi_seclog_reader_init(dvbpsi_seclog_reader_t *p_reader,
+                               uint8_t *p_log, size_t i_size)
+{
+    assert(p_reader);
+
+    if (p_log == NULL || i_size < SECLOG_HEADER_SIZE
+     || memcmp(p_log, SECLOG_MAGIC, 8) || seclog_get32(p_log + 8) != SECLOG_VERSION)
+        return false;
+
+    p_reader->p_log = p_log;
+    p_reader->i_size = i_size;
+    p_reader->i_offset = SECLOG_HEADER_SIZE;
+    p_reader->i_number = 0;
+    p_reader->i_sections = seclog_get64(p_log + 24);
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_next
+ *****************************************************************************
+ * Record at i_offset: its type, and the offset of the next one. false if
+ * it is incomplete.
+ *****************************************************************************/
+static bool dvbpsi_seclog_next(const dvbpsi_seclog_reader_t *p_reader, size_t i_offset,
+                               uint8_t *pi_type, size_t *pi_next)
+{
+    if (i_offset > p_reader->i_size
+     || p_reader->i_size - i_offset < SECLOG_RECORD_SIZE)
+        return false;
+
+    const uint8_t *p_record = p_reader->p_log + i_offset;
+    uint64_t i_size = seclog_get32(p_record);
+    uint64_t i_next = i_offset + SECLOG_RECORD_SIZE + i_size + (-i_size & 7);
+    if (i_next > p_reader->i_size
+     || (p_record[6] == SECLOG_INDEX && i_size < SECLOG_INDEX_SIZE)
+     || (p_record[6] == SECLOG_EVENT && i_size < SECLOG_EVENT_SIZE))
+        return false;
+
+    *pi_type = p_record[6];
+    *pi_next = i_next;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_read
+ *****************************************************************************/
+bool dvbpsi_seclog_read(dvbpsi_seclog_reader_t *p_reader,
+                        dvbpsi_seclog_record_t *p_record)
+{
+    assert(p_reader);
+    assert(p_record);
+
+    while (dvbpsi_seclog_read_record(p_reader, p_record, NULL))
+        if (p_record->p_section)
+            return true;
+    return false;
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_read_record
+ *****************************************************************************/
+bool dvbpsi_seclog_read_record(dvbpsi_seclog_reader_t *p_reader,
+                               dvbpsi_seclog_record_t *p_record,
+                               dvbpsi_event_t *p_event)
+{
+    assert(p_reader);
+    assert(p_record);
+
+    uint8_t i_type;
+    size_t i_next;
+    while (dvbpsi_seclog_next(p_reader, p_reader->i_offset, &i_type, &i_next))
+    {
+        uint8_t *p = p_reader->p_log + p_reader->i_offset;
+        p_reader->i_offset = i_next;
+        if (i_type != SECLOG_SECTION && i_type != SECLOG_EVENT)
+            continue;
+
+        p_record->i_pid = seclog_get16(p + 4);
+        p_record->i_time = (int64_t)seclog_get64(p + 8);
+        if (i_type == SECLOG_EVENT)
+        {
+            p_record->p_section = NULL;
+            p_record->i_size = 0;
+            if (p_event)
+                dvbpsi_seclog_event_decode(p + SECLOG_RECORD_SIZE, p_record->i_pid,
+                                           p_event);
+            return true;
+        }
+
+        p_record->i_size = seclog_get32(p);
+        p_record->p_section = p + SECLOG_RECORD_SIZE;
+        p_reader->i_number++;
+        return true;
+    }
+    return false;
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_seek
+ *****************************************************************************/
+bool dvbpsi_seclog_seek(dvbpsi_seclog_reader_t *p_reader, int64_t i_time)
+{
+    assert(p_reader);
+
+    uint64_t i_index = seclog_get64(p_reader->p_log + 16);
+    p_reader->i_offset = SECLOG_HEADER_SIZE;
+    p_reader->i_number = 0;
+
+    /* Backwards, from the last index record */
+    while (i_index >= SECLOG_HEADER_SIZE)
+    {
+        uint8_t i_type;
+        size_t i_next;
+        if (!dvbpsi_seclog_next(p_reader, i_index, &i_type, &i_next)
+         || i_type != SECLOG_INDEX)
+            return false;
+
+        const uint8_t *p = p_reader->p_log + i_index;
+        int64_t i_index_time = (int64_t)seclog_get64(p + 8);
+        if (i_index_time != DVBPSI_TIME_NONE && i_index_time <= i_time)
+        {
+            p_reader->i_offset = i_index;
+            p_reader->i_number = seclog_get64(p + SECLOG_RECORD_SIZE + 8);
+            return true;
+        }
+
+        uint64_t i_previous = seclog_get64(p + SECLOG_RECORD_SIZE);
+        if (i_previous >= i_index)
+            return false;
+        i_index = i_previous;
+    }
+    return false;
+}
+
+#ifdef HAVE_CLOCK_GETTIME
+/*****************************************************************************
+ * dvbpsi_seclog_wait
+ *****************************************************************************
+ * Sleeps until i_elapsed time units of the log passed since p_start.
+ *****************************************************************************/
+static void dvbpsi_seclog_wait(const struct timespec *p_start, uint64_t i_elapsed,
+                               uint64_t i_units_per_second)
+{
+    uint64_t i_ns = i_elapsed / i_units_per_second * UINT64_C(1000000000)
+                  + i_elapsed % i_units_per_second * UINT64_C(1000000000)
+                                                  / i_units_per_second;
+    struct timespec deadline = {
+        .tv_sec = p_start->tv_sec + i_ns / 1000000000,
+        .tv_nsec = p_start->tv_nsec + i_ns % 1000000000,
+    };
+    if (deadline.tv_nsec >= 1000000000)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    for (;;)
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec > deadline.tv_sec
+         || (now.tv_sec == deadline.tv_sec && now.tv_nsec >= deadline.tv_nsec))
+            return;
+
+        struct timespec delay = {
+            .tv_sec = deadline.tv_sec - now.tv_sec,
+            .tv_nsec = deadline.tv_nsec - now.tv_nsec,
+        };
+        if (delay.tv_nsec < 0)
+        {
+            delay.tv_sec--;
+            delay.tv_nsec += 1000000000;
+        }
+        nanosleep(&delay, NULL);
+    }
+}
+#endif
+
+/*****************************************************************************
+ * dvbpsi_seclog_replay
+ *****************************************************************************/
+uint64_t dvbpsi_seclog_replay(dvbpsi_seclog_reader_t *p_reader,
+                              dvbpsi_seclog_handle_cb pf_handle, void *p_cb_data,
+                              uint64_t i_units_per_second)
+{
+    assert(p_reader);
+    assert(pf_handle);
+
+#ifdef HAVE_CLOCK_GETTIME
+    struct timespec start;
+    int64_t i_first = DVBPSI_TIME_NONE;
+#else
+    (void)i_units_per_second;
+#endif
+    uint64_t i_pushed = 0;
+    dvbpsi_seclog_record_t record;
+
+    while (dvbpsi_seclog_read(p_reader, &record))
+    {
+        dvbpsi_t *p_dvbpsi = pf_handle(p_cb_data, record.i_pid);
+        if (p_dvbpsi == NULL)
+            continue;
+
+#ifdef HAVE_CLOCK_GETTIME
+        if (i_units_per_second && record.i_time != DVBPSI_TIME_NONE)
+        {
+            if (i_first == DVBPSI_TIME_NONE)
+            {
+                i_first = record.i_time;
+                clock_gettime(CLOCK_MONOTONIC, &start);
+            }
+            else if (record.i_time > i_first)
+                dvbpsi_seclog_wait(&start, record.i_time - i_first,
+                                   i_units_per_second);
+        }
+#endif
+        dvbpsi_section_push_at(p_dvbpsi, record.p_section, record.i_size,
+                               record.i_time);
+        i_pushed++;
+    }
+    return i_pushed;
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_ring_new
+ *****************************************************************************/
+dvbpsi_seclog_ring_t *dvbpsi_seclog_ring_new(size_t i_size)
+{
+    if (i_size < SECLOG_RING_MIN)
+        i_size = SECLOG_RING_MIN;
+    i_size = (i_size + 7) & ~(size_t)7;
+
+    dvbpsi_seclog_ring_t *p_ring = dvbpsi_calloc(1, sizeof(dvbpsi_seclog_ring_t));
+    if (p_ring == NULL)
+        return NULL;
+
+    p_ring->p_records = dvbpsi_malloc(i_size);
+    if (p_ring->p_records == NULL)
+    {
+        dvbpsi_free(p_ring);
+        return NULL;
+    }
+    p_ring->i_size = i_size;
+    p_ring->i_last_time = DVBPSI_TIME_NONE;
+    return p_ring;
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_ring_delete
+ *****************************************************************************/
+void dvbpsi_seclog_ring_delete(dvbpsi_seclog_ring_t *p_ring)
+{
+    if (p_ring == NULL)
+        return;
+
+    dvbpsi_free(p_ring->p_records);
+    dvbpsi_free(p_ring);
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_ring_put/dvbpsi_seclog_ring_get
+ *****************************************************************************
+ * Copies bytes to or from a position of a ring, wrapping at its end.
+ *****************************************************************************/
+static void dvbpsi_seclog_ring_put(dvbpsi_seclog_ring_t *p_ring, uint64_t i_position,
+                                   const uint8_t *p_data, size_t i_size)
+{
+    size_t i_offset = i_position % p_ring->i_size;
+    size_t i_first = p_ring->i_size - i_offset;
+    if (i_first > i_size)
+        i_first = i_size;
+    memcpy(p_ring->p_records + i_offset, p_data, i_first);
+    memcpy(p_ring->p_records, p_data + i_first, i_size - i_first);
+}
+
+static void dvbpsi_seclog_ring_get(const dvbpsi_seclog_ring_t *p_ring, uint64_t i_position,
+                                   uint8_t *p_data, size_t i_size)
+{
+    size_t i_offset = i_position % p_ring->i_size;
+    size_t i_first = p_ring->i_size - i_offset;
+    if (i_first > i_size)
+        i_first = i_size;
+    memcpy(p_data, p_ring->p_records + i_offset, i_first);
+    memcpy(p_data + i_first, p_ring->p_records, i_size - i_first);
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_ring_record
+ *****************************************************************************
+ * Appends a record, padded to 8 bytes, over the oldest ones.
+ *****************************************************************************/
+static void dvbpsi_seclog_ring_record(dvbpsi_seclog_ring_t *p_ring, uint8_t i_type,
+                                      uint16_t i_pid, int64_t i_time,
+                                      const uint8_t *p_data, size_t i_size)
+{
+    static const uint8_t p_padding[8];
+    uint8_t p_record[SECLOG_RECORD_SIZE];
+    size_t i_padding = -i_size & 7;
+    uint64_t i_total = SECLOG_RECORD_SIZE + i_size + i_padding;
+    uint64_t i_head = p_ring->i_head;
+    uint64_t i_tail = p_ring->i_tail;
+
+    /* Only this thread moves the tail, past whole records */
+    if (i_head + i_total - i_tail > p_ring->i_size)
+    {
+        while (i_head + i_total - i_tail > p_ring->i_size)
+        {
+            uint8_t p_size[4];
+            dvbpsi_seclog_ring_get(p_ring, i_tail, p_size, 4);
+            uint64_t i_old = seclog_get32(p_size);
+            i_tail += SECLOG_RECORD_SIZE + i_old + (-i_old & 7);
+        }
+        SECLOG_STORE(&p_ring->i_tail, i_tail, RELAXED);
+        SECLOG_FENCE(RELEASE);
+    }
+
+    dvbpsi_seclog_record_header(p_record, i_type, i_pid, i_time, i_size);
+    dvbpsi_seclog_ring_put(p_ring, i_head, p_record, SECLOG_RECORD_SIZE);
+    dvbpsi_seclog_ring_put(p_ring, i_head + SECLOG_RECORD_SIZE, p_data, i_size);
+    dvbpsi_seclog_ring_put(p_ring, i_head + SECLOG_RECORD_SIZE + i_size,
+                           p_padding, i_padding);
+    SECLOG_STORE(&p_ring->i_head, i_head + i_total, RELEASE);
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_ring_write
+ *****************************************************************************/
+bool dvbpsi_seclog_ring_write(dvbpsi_seclog_ring_t *p_ring, uint16_t i_pid,
+                              int64_t i_time, const uint8_t *p_section,
+                              size_t i_size)
+{
+    assert(p_ring);
+    assert(p_section);
+
+    if (i_size < 3 || i_size > 4096)
+        return false;
+
+    dvbpsi_seclog_ring_record(p_ring, SECLOG_SECTION, i_pid, i_time, p_section, i_size);
+    if (i_time != DVBPSI_TIME_NONE)
+        p_ring->i_last_time = i_time;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_ring_event
+ *****************************************************************************/
+void dvbpsi_seclog_ring_event(dvbpsi_seclog_ring_t *p_ring, int64_t i_time,
+                              const dvbpsi_event_t *p_event)
+{
+    assert(p_ring);
+    assert(p_event);
+
+    uint8_t p_data[SECLOG_EVENT_SIZE];
+    dvbpsi_seclog_event_encode(p_data, p_event);
+    dvbpsi_seclog_ring_record(p_ring, SECLOG_EVENT, p_event->i_pid,
+                              i_time != DVBPSI_TIME_NONE ? i_time : p_ring->i_last_time,
+                              p_data, SECLOG_EVENT_SIZE);
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_ring_tap/dvbpsi_seclog_ring_event_cb
+ *****************************************************************************/
+void dvbpsi_seclog_ring_tap(void *p_ring, uint16_t i_pid, int64_t i_time,
+                            const uint8_t *p_section, size_t i_size)
+{
+    dvbpsi_seclog_ring_write((dvbpsi_seclog_ring_t *)p_ring, i_pid, i_time,
+                             p_section, i_size);
+}
+
+void dvbpsi_seclog_ring_event_cb(dvbpsi_t *p_dvbpsi, const dvbpsi_event_t *p_event,
+                                 void *p_ring)
+{
+    (void)p_dvbpsi;
+    dvbpsi_seclog_ring_event((dvbpsi_seclog_ring_t *)p_ring, DVBPSI_TIME_NONE, p_event);
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_ring_snapshot_size
+ *****************************************************************************/
+size_t dvbpsi_seclog_ring_snapshot_size(const dvbpsi_seclog_ring_t *p_ring)
+{
+    assert(p_ring);
+    return SECLOG_HEADER_SIZE + p_ring->i_size;
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_ring_snapshot
+ *****************************************************************************/
+size_t dvbpsi_seclog_ring_snapshot(const dvbpsi_seclog_ring_t *p_ring, int64_t i_duration,
+                                   uint8_t *p_buffer, size_t i_size)
+{
+    assert(p_ring);
+    assert(p_buffer || i_size == 0);
+
+    if (i_size < dvbpsi_seclog_ring_snapshot_size(p_ring))
+        return 0;
+
+    /* The tail loaded first, a head more than the ring away from it meaning
+     * the tail moved in between */
+    uint64_t i_head, i_tail;
+    do
+    {
+        i_tail = SECLOG_LOAD(&p_ring->i_tail, ACQUIRE);
+        i_head = SECLOG_LOAD(&p_ring->i_head, ACQUIRE);
+    } while (i_head - i_tail > p_ring->i_size);
+    uint8_t *p_records = p_buffer + SECLOG_HEADER_SIZE;
+    dvbpsi_seclog_ring_get(p_ring, i_tail, p_records, i_head - i_tail);
+
+    /* Records overwritten while copied */
+    SECLOG_FENCE(ACQUIRE);
+    uint64_t i_valid = SECLOG_LOAD(&p_ring->i_tail, RELAXED);
+    size_t i_start = i_valid < i_head ? i_valid - i_tail : i_head - i_tail;
+    size_t i_end = i_head - i_tail;
+
+    /* From i_duration before the last time */
+    if (i_duration > 0)
+    {
+        int64_t i_last = DVBPSI_TIME_NONE;
+        for (size_t i = i_start; i < i_end;)
+        {
+            uint64_t i_record = seclog_get32(p_records + i);
+            int64_t i_time = (int64_t)seclog_get64(p_records + i + 8);
+            if (i_time != DVBPSI_TIME_NONE)
+                i_last = i_time;
+            i += SECLOG_RECORD_SIZE + i_record + (-i_record & 7);
+        }
+        while (i_last != DVBPSI_TIME_NONE && i_start < i_end)
+        {
+            uint64_t i_record = seclog_get32(p_records + i_start);
+            int64_t i_time = (int64_t)seclog_get64(p_records + i_start + 8);
+            if (i_time != DVBPSI_TIME_NONE && i_time >= i_last - i_duration)
+                break;
+            i_start += SECLOG_RECORD_SIZE + i_record + (-i_record & 7);
+        }
+    }
+
+    uint64_t i_sections = 0;
+    for (size_t i = i_start; i < i_end;)
+    {
+        uint64_t i_record = seclog_get32(p_records + i);
+        if (p_records[i + 6] == SECLOG_SECTION)
+            i_sections++;
+        i += SECLOG_RECORD_SIZE + i_record + (-i_record & 7);
+    }
+
+    memmove(p_records, p_records + i_start, i_end - i_start);
+    dvbpsi_seclog_header(p_buffer, 0, 0, i_sections);
+    return SECLOG_HEADER_SIZE + i_end - i_start;
+}
+
+/*****************************************************************************
+ * dvbpsi_seclog_ring_dump
+ *****************************************************************************/
+bool dvbpsi_seclog_ring_dump(const dvbpsi_seclog_ring_t *p_ring, int64_t i_duration,
+                             const char *psz_path)
+{
+    assert(p_ring);
+    assert(psz_path);
+
+    size_t i_size = dvbpsi_seclog_ring_snapshot_size(p_ring);
+    uint8_t *p_buffer = dvbpsi_malloc(i_size);
+    if (p_buffer == NULL)
+        return false;
+    i_size = dvbpsi_seclog_ring_snapshot(p_ring, i_duration, p_buffer, i_size);
+
+    FILE *p_file = fopen(psz_path, "wb");
+    bool b_ok = p_file != NULL;
+    if (b_ok)
+    {
+        b_ok = fwrite(p_buffer, i_size, 1, p_file) == 1;
+        if (fclose(p_file) != 0)
+            b_ok = false;
+    }
+    dvbpsi_free(p_buffer);
+    return b_ok;
+}
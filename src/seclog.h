@@ -0,0 +1,455 @@
+/*****************************************************************************
+ * seclog.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <seclog.h>
+ * \brief Section logs: recording and replay of the PSI and SI of a stream.
+ *
+ * A section log holds the valid sections of a stream, with their PID and
+ * arrival time, instead of its TS packets. It is written through the
+ * section tap of a handle, see dvbpsi_set_section_tap(), and replayed into
+ * decoders with dvbpsi_section_push_at(), without any TS reassembly.
+ *
+ * The file starts with a 32 bytes header, followed by records aligned on
+ * 8 bytes, all numbers being little endian:
+ * - header: "DVBPSISL", version (32 bits, 1), index interval (32 bits),
+ *   offset of the last index record and number of sections (64 bits each,
+ *   0 until the log is closed);
+ * - record: size of the data (32 bits), PID (16 bits), type (8 bits, 0 for
+ *   a section, 1 for an index, 2 for an event), 0 (8 bits), time (64 bits,
+ *   signed, DVBPSI_TIME_NONE if unknown), data, padding;
+ * - index data, before every index interval sections: offset of the
+ *   previous index record (0 for none), number of the next section (64
+ *   bits each). The time of the index record is that of the next section.
+ * - event data, a dvbpsi_event_t: type, table_id (8 bits each),
+ *   table_id_extension (16 bits), version_number, last version_number (8
+ *   bits each), 0 (16 bits), expected and received values (32 bits each),
+ *   count (64 bits). The PID of the event is that of the record.
+ *
+ * A log can then be mapped in memory and read in place, and the index
+ * records chained from the header give the sections by time.
+ *
+ * A section log ring, dvbpsi_seclog_ring_t, is a flight recorder holding
+ * the last sections and events of a stream in memory allocated once. It is
+ * written from the thread decoding the stream, and its snapshots, taken
+ * from any thread without locking it, are section logs without index
+ * records, of the whole ring or of its last records in time.
+ */
+
+#ifndef _DVBPSI_SECLOG_H_
+#define _DVBPSI_SECLOG_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_seclog_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_seclog_s dvbpsi_seclog_t
+ * \brief dvbpsi_seclog_t type definition, an opaque section log writer.
+ */
+typedef struct dvbpsi_seclog_s dvbpsi_seclog_t;
+
+/*****************************************************************************
+ * dvbpsi_seclog_open
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_seclog_t *dvbpsi_seclog_open(const char *psz_path,
+ *                                         unsigned int i_index_interval)
+ * \brief Creates a section log file
+ * \param psz_path path of the file, replaced if it exists
+ * \param i_index_interval number of sections between two index records, 0
+ *        for the default of 1024
+ * \return pointer to the writer, or NULL on error
+ */
+dvbpsi_seclog_t *dvbpsi_seclog_open(const char *psz_path,
+                                    unsigned int i_index_interval);
+
+/*****************************************************************************
+ * dvbpsi_seclog_write
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_seclog_write(dvbpsi_seclog_t *p_log, uint16_t i_pid,
+ *                              int64_t i_time, const uint8_t *p_section,
+ *                              size_t i_size)
+ * \brief Appends a section to a log
+ * \param p_log pointer to the writer
+ * \param i_pid PID of the section
+ * \param i_time arrival time of the section, or DVBPSI_TIME_NONE
+ * \param p_section section, starting with its table_id
+ * \param i_size size of the section, at most 4096 bytes
+ * \return false on a write error, which dvbpsi_seclog_close() reports as
+ *         well, or if i_size is out of range
+ */
+bool dvbpsi_seclog_write(dvbpsi_seclog_t *p_log, uint16_t i_pid, int64_t i_time,
+                         const uint8_t *p_section, size_t i_size);
+
+/*****************************************************************************
+ * dvbpsi_seclog_write_event
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_seclog_write_event(dvbpsi_seclog_t *p_log, int64_t i_time,
+ *                                    const dvbpsi_event_t *p_event)
+ * \brief Appends an event to a log
+ * \param p_log pointer to the writer
+ * \param i_time time of the event, or DVBPSI_TIME_NONE
+ * \param p_event event, as given to a dvbpsi_event_cb
+ * \return false on a write error, which dvbpsi_seclog_close() reports as
+ *         well
+ *
+ * Events are not counted as sections nor indexed, and are skipped by
+ * dvbpsi_seclog_read() and dvbpsi_seclog_replay().
+ */
+bool dvbpsi_seclog_write_event(dvbpsi_seclog_t *p_log, int64_t i_time,
+                               const dvbpsi_event_t *p_event);
+
+/*****************************************************************************
+ * dvbpsi_seclog_tap
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_seclog_tap(void *p_log, uint16_t i_pid, int64_t i_time,
+ *                            const uint8_t *p_section, size_t i_size)
+ * \brief Section tap callback writing to the dvbpsi_seclog_t given as
+ *        callback data, see dvbpsi_set_section_tap()
+ * \param p_log pointer to the writer
+ * \param i_pid PID of the section
+ * \param i_time arrival time of the section
+ * \param p_section section
+ * \param i_size size of the section
+ * \return nothing
+ *
+ * Several handles may record into the same log when they are used from
+ * the same thread.
+ */
+void dvbpsi_seclog_tap(void *p_log, uint16_t i_pid, int64_t i_time,
+                       const uint8_t *p_section, size_t i_size);
+
+/*****************************************************************************
+ * dvbpsi_seclog_close
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_seclog_close(dvbpsi_seclog_t *p_log)
+ * \brief Completes the header of a log, closes it and deletes the writer
+ * \param p_log pointer to the writer
+ * \return false if the log could not be written entirely
+ */
+bool dvbpsi_seclog_close(dvbpsi_seclog_t *p_log);
+
+/*****************************************************************************
+ * dvbpsi_seclog_reader_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_seclog_reader_s
+ * \brief Reader of a log held in memory, see dvbpsi_seclog_reader_init()
+ */
+/*!
+ * \typedef struct dvbpsi_seclog_reader_s dvbpsi_seclog_reader_t
+ * \brief dvbpsi_seclog_reader_t type definition.
+ */
+typedef struct dvbpsi_seclog_reader_s
+{
+    uint8_t *   p_log;          /*!< private, the log */
+    size_t      i_size;         /*!< private, its size */
+    size_t      i_offset;       /*!< private, offset of the next record */
+    uint64_t    i_number;       /*!< number of the next section */
+    uint64_t    i_sections;     /*!< number of sections of a closed log,
+                                     0 otherwise */
+} dvbpsi_seclog_reader_t;
+
+/*****************************************************************************
+ * dvbpsi_seclog_record_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_seclog_record_s
+ * \brief Section read from a log
+ */
+/*!
+ * \typedef struct dvbpsi_seclog_record_s dvbpsi_seclog_record_t
+ * \brief dvbpsi_seclog_record_t type definition.
+ */
+typedef struct dvbpsi_seclog_record_s
+{
+    uint16_t    i_pid;          /*!< PID of the section */
+    int64_t     i_time;         /*!< arrival time, or DVBPSI_TIME_NONE */
+    uint8_t *   p_section;      /*!< section, in the log */
+    size_t      i_size;         /*!< size of the section */
+} dvbpsi_seclog_record_t;
+
+/*****************************************************************************
+ * dvbpsi_seclog_reader_init
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_seclog_reader_init(dvbpsi_seclog_reader_t *p_reader,
+ *                                    uint8_t *p_log, size_t i_size)
+ * \brief Initializes a reader of a log held in memory, mapped or read
+ * \param p_reader pointer to the reader
+ * \param p_log the log, from its header, which must stay valid while it is
+ *        read
+ * \param i_size size of the log, a log still being written may end with an
+ *        incomplete record, which is ignored
+ * \return false if p_log is no section log
+ */
+bool dvbpsi_seclog_reader_init(dvbpsi_seclog_reader_t *p_reader,
+                               uint8_t *p_log, size_t i_size);
+
+/*****************************************************************************
+ * dvbpsi_seclog_read
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_seclog_read(dvbpsi_seclog_reader_t *p_reader,
+ *                             dvbpsi_seclog_record_t *p_record)
+ * \brief Reads the next section of a log
+ * \param p_reader pointer to the reader
+ * \param p_record filled with the section
+ * \return false at the end of the log
+ */
+bool dvbpsi_seclog_read(dvbpsi_seclog_reader_t *p_reader,
+                        dvbpsi_seclog_record_t *p_record);
+
+/*****************************************************************************
+ * dvbpsi_seclog_read_record
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_seclog_read_record(dvbpsi_seclog_reader_t *p_reader,
+ *                                    dvbpsi_seclog_record_t *p_record,
+ *                                    dvbpsi_event_t *p_event)
+ * \brief Reads the next section or event of a log
+ * \param p_reader pointer to the reader
+ * \param p_record filled with the section, or for an event with its PID and
+ *        time, p_section being NULL and i_size 0
+ * \param p_event filled with the event, when there is one
+ * \return false at the end of the log
+ */
+bool dvbpsi_seclog_read_record(dvbpsi_seclog_reader_t *p_reader,
+                               dvbpsi_seclog_record_t *p_record,
+                               dvbpsi_event_t *p_event);
+
+/*****************************************************************************
+ * dvbpsi_seclog_seek
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_seclog_seek(dvbpsi_seclog_reader_t *p_reader,
+ *                             int64_t i_time)
+ * \brief Moves a reader to the index record before a time
+ * \param p_reader pointer to the reader
+ * \param i_time time to go to
+ * \return false if the log is not closed, or has no index record at or
+ *         before i_time, in which case the reader goes back to the first
+ *         section
+ *
+ * The sections up to i_time then follow within an index interval. The
+ * index records are walked from the last one, the times of the log being
+ * expected to increase.
+ */
+bool dvbpsi_seclog_seek(dvbpsi_seclog_reader_t *p_reader, int64_t i_time);
+
+/*****************************************************************************
+ * dvbpsi_seclog_handle_cb
+ *****************************************************************************/
+/*!
+ * \typedef dvbpsi_t *(* dvbpsi_seclog_handle_cb)(void *p_cb_data,
+ *                                                uint16_t i_pid)
+ * \brief Callback type definition, giving the handle decoding the sections
+ * of a PID during a replay, or NULL to skip them.
+ */
+typedef dvbpsi_t *(* dvbpsi_seclog_handle_cb)(void *p_cb_data, uint16_t i_pid);
+
+/*****************************************************************************
+ * dvbpsi_seclog_replay
+ *****************************************************************************/
+/*!
+ * \fn uint64_t dvbpsi_seclog_replay(dvbpsi_seclog_reader_t *p_reader,
+ *                                   dvbpsi_seclog_handle_cb pf_handle,
+ *                                   void *p_cb_data,
+ *                                   uint64_t i_units_per_second)
+ * \brief Pushes the rest of the sections of a log to their handles
+ * \param p_reader pointer to the reader
+ * \param pf_handle function giving the handle of a PID
+ * \param p_cb_data private data given in argument to pf_handle
+ * \param i_units_per_second 0 to push the sections at full speed, or the
+ *        number of time units of the log per second to push them in real
+ *        time, following their arrival times
+ * \return number of sections pushed
+ *
+ * The sections are given in place to dvbpsi_section_push_at(), with their
+ * arrival time. The first section sets the start of a real time replay,
+ * which needs clock_gettime(): without it the sections are pushed at full
+ * speed.
+ */
+uint64_t dvbpsi_seclog_replay(dvbpsi_seclog_reader_t *p_reader,
+                              dvbpsi_seclog_handle_cb pf_handle, void *p_cb_data,
+                              uint64_t i_units_per_second);
+
+/*****************************************************************************
+ * dvbpsi_seclog_ring_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_seclog_ring_s dvbpsi_seclog_ring_t
+ * \brief dvbpsi_seclog_ring_t type definition, an opaque section log ring.
+ */
+typedef struct dvbpsi_seclog_ring_s dvbpsi_seclog_ring_t;
+
+/*****************************************************************************
+ * dvbpsi_seclog_ring_new/dvbpsi_seclog_ring_delete
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_seclog_ring_t *dvbpsi_seclog_ring_new(size_t i_size)
+ * \brief Creates a section log ring
+ * \param i_size bytes of records kept, at least 8 kB, each section taking
+ *        its size plus 16 to 23 bytes and each event 40 bytes
+ * \return pointer to the ring, or NULL on error
+ *
+ * The ring is allocated at once: writing to it allocates nothing, the
+ * oldest records being overwritten.
+ */
+dvbpsi_seclog_ring_t *dvbpsi_seclog_ring_new(size_t i_size);
+
+/*!
+ * \fn void dvbpsi_seclog_ring_delete(dvbpsi_seclog_ring_t *p_ring)
+ * \brief Deletes a ring, once set on no handle and read by no thread
+ * \param p_ring pointer to the ring, or NULL
+ * \return nothing
+ */
+void dvbpsi_seclog_ring_delete(dvbpsi_seclog_ring_t *p_ring);
+
+/*****************************************************************************
+ * dvbpsi_seclog_ring_write/dvbpsi_seclog_ring_event
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_seclog_ring_write(dvbpsi_seclog_ring_t *p_ring,
+ *                                   uint16_t i_pid, int64_t i_time,
+ *                                   const uint8_t *p_section, size_t i_size)
+ * \brief Appends a section to a ring
+ * \param p_ring pointer to the ring
+ * \param i_pid PID of the section
+ * \param i_time arrival time of the section, or DVBPSI_TIME_NONE
+ * \param p_section section, starting with its table_id
+ * \param i_size size of the section, at most 4096 bytes
+ * \return false if i_size is out of range
+ *
+ * Only one thread may write to a ring.
+ */
+bool dvbpsi_seclog_ring_write(dvbpsi_seclog_ring_t *p_ring, uint16_t i_pid,
+                              int64_t i_time, const uint8_t *p_section,
+                              size_t i_size);
+
+/*!
+ * \fn void dvbpsi_seclog_ring_event(dvbpsi_seclog_ring_t *p_ring,
+ *                                   int64_t i_time,
+ *                                   const dvbpsi_event_t *p_event)
+ * \brief Appends an event to a ring, from the thread writing its sections
+ * \param p_ring pointer to the ring
+ * \param i_time time of the event, or DVBPSI_TIME_NONE for the time of
+ *        the last section written
+ * \param p_event event, from libdvbpsi or made by the application
+ * \return nothing
+ */
+void dvbpsi_seclog_ring_event(dvbpsi_seclog_ring_t *p_ring, int64_t i_time,
+                              const dvbpsi_event_t *p_event);
+
+/*****************************************************************************
+ * dvbpsi_seclog_ring_tap/dvbpsi_seclog_ring_event_cb
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_seclog_ring_tap(void *p_ring, uint16_t i_pid,
+ *                                 int64_t i_time, const uint8_t *p_section,
+ *                                 size_t i_size)
+ * \brief Section tap callback writing to the dvbpsi_seclog_ring_t given as
+ *        callback data, see dvbpsi_set_section_tap()
+ * \param p_ring pointer to the ring
+ * \param i_pid PID of the section
+ * \param i_time arrival time of the section
+ * \param p_section section
+ * \param i_size size of the section
+ * \return nothing
+ */
+void dvbpsi_seclog_ring_tap(void *p_ring, uint16_t i_pid, int64_t i_time,
+                            const uint8_t *p_section, size_t i_size);
+
+/*!
+ * \fn void dvbpsi_seclog_ring_event_cb(dvbpsi_t *p_dvbpsi,
+ *                                      const dvbpsi_event_t *p_event,
+ *                                      void *p_ring)
+ * \brief Event callback writing to the dvbpsi_seclog_ring_t given as
+ *        callback data, see dvbpsi_set_event_cb()
+ * \param p_dvbpsi handle of the event
+ * \param p_event event
+ * \param p_ring pointer to the ring
+ * \return nothing
+ *
+ * The events are given the time of the last section of the ring.
+ */
+void dvbpsi_seclog_ring_event_cb(dvbpsi_t *p_dvbpsi, const dvbpsi_event_t *p_event,
+                                 void *p_ring);
+
+/*****************************************************************************
+ * dvbpsi_seclog_ring_snapshot/dvbpsi_seclog_ring_dump
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_seclog_ring_snapshot_size(const dvbpsi_seclog_ring_t *p_ring)
+ * \brief Gives the size of the buffer of dvbpsi_seclog_ring_snapshot()
+ * \param p_ring pointer to the ring
+ * \return size of the largest snapshot
+ */
+size_t dvbpsi_seclog_ring_snapshot_size(const dvbpsi_seclog_ring_t *p_ring);
+
+/*!
+ * \fn size_t dvbpsi_seclog_ring_snapshot(const dvbpsi_seclog_ring_t *p_ring,
+ *                                        int64_t i_duration,
+ *                                        uint8_t *p_buffer, size_t i_size)
+ * \brief Copies the last records of a ring into a closed section log
+ * \param p_ring pointer to the ring
+ * \param i_duration 0 for all the records of the ring, or the records
+ *        from i_duration time units before the last record with a time
+ * \param p_buffer filled with the log
+ * \param i_size size of p_buffer, at least
+ *        dvbpsi_seclog_ring_snapshot_size()
+ * \return size of the log, for dvbpsi_seclog_reader_init(), 0 if the
+ *         buffer is too small
+ *
+ * A snapshot can be taken from any thread while the ring is written: the
+ * records overwritten during the copy are left out.
+ */
+size_t dvbpsi_seclog_ring_snapshot(const dvbpsi_seclog_ring_t *p_ring, int64_t i_duration,
+                                   uint8_t *p_buffer, size_t i_size);
+
+/*!
+ * \fn bool dvbpsi_seclog_ring_dump(const dvbpsi_seclog_ring_t *p_ring,
+ *                                  int64_t i_duration, const char *psz_path)
+ * \brief Writes a snapshot of a ring to a section log file
+ * \param p_ring pointer to the ring
+ * \param i_duration as for dvbpsi_seclog_ring_snapshot()
+ * \param psz_path path of the file, replaced if it exists
+ * \return false on error
+ */
+bool dvbpsi_seclog_ring_dump(const dvbpsi_seclog_ring_t *p_ring, int64_t i_duration,
+                             const char *psz_path);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of seclog.h"
+#endif
@@ -0,0 +1,1556 @@
+/*****************************************************************************
+ * serialize.c: JSON and CBOR serialization of the decoded tables
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stddef.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "descriptor.h"
+#include "mjd.h"
+#include "text.h"
+#include "descriptors/dr.h"
+#include "tables/pat.h"
+#include "tables/cat.h"
+#include "tables/pmt.h"
+#include "tables/nit.h"
+#include "tables/sdt.h"
+#include "tables/bat.h"
+#include "tables/eit.h"
+#include "tables/tot.h"
+#include "tables/rst.h"
+#include "tables/sis.h"
+#include "tables/atsc_vct.h"
+#include "tables/atsc_mgt.h"
+#include "tables/atsc_stt.h"
+#include "tables/atsc_eit.h"
+#include "tables/atsc_ett.h"
+#include "serialize.h"
+
+/* Smallest buffer asked to the grow callback */
+#define SERIALIZE_MIN_SIZE 1024
+
+/*****************************************************************************
+ * dvbpsi_serializer_init
+ *****************************************************************************/
+void dvbpsi_serializer_init(dvbpsi_serializer_t *p_serializer,
+                            dvbpsi_serializer_format_t i_format,
+                            uint8_t *p_buffer, size_t i_size,
+                            dvbpsi_serializer_grow_cb pf_grow, void *p_cb_data)
+{
+    assert(p_serializer);
+    assert(p_buffer || i_size == 0);
+
+    memset(p_serializer, 0, sizeof(dvbpsi_serializer_t));
+    p_serializer->i_format = i_format;
+    p_serializer->p_buffer = p_buffer;
+    p_serializer->i_size = i_size;
+    p_serializer->pf_grow = pf_grow;
+    p_serializer->p_cb_data = p_cb_data;
+}
+
+/*****************************************************************************
+ * dvbpsi_serializer_reset
+ *****************************************************************************/
+void dvbpsi_serializer_reset(dvbpsi_serializer_t *p_serializer)
+{
+    assert(p_serializer);
+
+    p_serializer->i_length = 0;
+    p_serializer->b_full = false;
+    p_serializer->b_key = false;
+    p_serializer->i_depth = 0;
+    p_serializer->i_members = 0;
+}
+
+/*****************************************************************************
+ * serialize_reserve
+ *****************************************************************************
+ * Makes room for i_bytes more bytes, false once out of space, the following
+ * writes of the table being then dropped.
+ *****************************************************************************/
+static bool serialize_reserve(dvbpsi_serializer_t *p_serializer, size_t i_bytes)
+{
+    if (p_serializer->b_full)
+        return false;
+    if (p_serializer->i_size - p_serializer->i_length >= i_bytes)
+        return true;
+
+    if (p_serializer->pf_grow)
+    {
+        size_t i_size = p_serializer->i_size < SERIALIZE_MIN_SIZE
+                      ? SERIALIZE_MIN_SIZE : p_serializer->i_size;
+        while (i_size - p_serializer->i_length < i_bytes)
+            i_size *= 2;
+        uint8_t *p_buffer = p_serializer->pf_grow(p_serializer->p_cb_data,
+                                                  p_serializer->p_buffer, i_size);
+        if (p_buffer)
+        {
+            p_serializer->p_buffer = p_buffer;
+            p_serializer->i_size = i_size;
+            return true;
+        }
+    }
+    p_serializer->b_full = true;
+    return false;
+}
+
+static void serialize_write(dvbpsi_serializer_t *p_serializer,
+                            const void *p_data, size_t i_length)
+{
+    if (!serialize_reserve(p_serializer, i_length))
+        return;
+    memcpy(p_serializer->p_buffer + p_serializer->i_length, p_data, i_length);
+    p_serializer->i_length += i_length;
+}
+
+static void serialize_byte(dvbpsi_serializer_t *p_serializer, uint8_t i_byte)
+{
+    if (!serialize_reserve(p_serializer, 1))
+        return;
+    p_serializer->p_buffer[p_serializer->i_length++] = i_byte;
+}
+
+/*****************************************************************************
+ * serialize_cbor_head
+ *****************************************************************************
+ * Initial byte of a CBOR data item, with its argument.
+ *****************************************************************************/
+static void serialize_cbor_head(dvbpsi_serializer_t *p_serializer,
+                                uint8_t i_major, uint64_t i_value)
+{
+    uint8_t p_head[9];
+    int i_bytes;
+
+    if (i_value < 24)
+    {
+        serialize_byte(p_serializer, (i_major << 5) | i_value);
+        return;
+    }
+    else if (i_value <= 0xff)
+    {
+        p_head[0] = (i_major << 5) | 24;
+        i_bytes = 1;
+    }
+    else if (i_value <= 0xffff)
+    {
+        p_head[0] = (i_major << 5) | 25;
+        i_bytes = 2;
+    }
+    else if (i_value <= 0xffffffff)
+    {
+        p_head[0] = (i_major << 5) | 26;
+        i_bytes = 4;
+    }
+    else
+    {
+        p_head[0] = (i_major << 5) | 27;
+        i_bytes = 8;
+    }
+    for (int i = 0; i < i_bytes; i++)
+        p_head[1 + i] = i_value >> (8 * (i_bytes - 1 - i));
+    serialize_write(p_serializer, p_head, 1 + i_bytes);
+}
+
+/*****************************************************************************
+ * serialize_value
+ *****************************************************************************
+ * Separates a value from the previous member of its object or array, the
+ * values of an object member following their key directly.
+ *****************************************************************************/
+static void serialize_value(dvbpsi_serializer_t *p_serializer)
+{
+    if (p_serializer->b_key)
+    {
+        p_serializer->b_key = false;
+        return;
+    }
+    if (p_serializer->i_depth == 0)
+        return;
+
+    uint64_t i_bit = UINT64_C(1) << p_serializer->i_depth;
+    if (p_serializer->i_format == DVBPSI_SERIALIZER_JSON &&
+        (p_serializer->i_members & i_bit))
+        serialize_byte(p_serializer, ',');
+    p_serializer->i_members |= i_bit;
+}
+
+static void serialize_key(dvbpsi_serializer_t *p_serializer, const char *psz_key)
+{
+    if (psz_key == NULL)
+        return;
+
+    size_t i_length = strlen(psz_key);
+    serialize_value(p_serializer);
+    if (p_serializer->i_format == DVBPSI_SERIALIZER_JSON)
+    {
+        serialize_byte(p_serializer, '"');
+        serialize_write(p_serializer, psz_key, i_length);
+        serialize_write(p_serializer, "\":", 2);
+    }
+    else
+    {
+        serialize_cbor_head(p_serializer, 3, i_length);
+        serialize_write(p_serializer, psz_key, i_length);
+    }
+    p_serializer->b_key = true;
+}
+
+/*****************************************************************************
+ * serialize_begin, serialize_end
+ *****************************************************************************
+ * Object or array, a member of the current object when psz_key is not NULL.
+ *****************************************************************************/
+static void serialize_begin(dvbpsi_serializer_t *p_serializer, const char *psz_key,
+                            bool b_array)
+{
+    assert(p_serializer->i_depth < 63);
+
+    serialize_key(p_serializer, psz_key);
+    serialize_value(p_serializer);
+    if (p_serializer->i_format == DVBPSI_SERIALIZER_JSON)
+        serialize_byte(p_serializer, b_array ? '[' : '{');
+    else
+        serialize_byte(p_serializer, b_array ? 0x9f : 0xbf);
+    p_serializer->i_depth++;
+    p_serializer->i_members &= ~(UINT64_C(1) << p_serializer->i_depth);
+}
+
+static void serialize_end(dvbpsi_serializer_t *p_serializer, bool b_array)
+{
+    assert(p_serializer->i_depth > 0);
+
+    p_serializer->i_depth--;
+    if (p_serializer->i_format == DVBPSI_SERIALIZER_JSON)
+    {
+        serialize_byte(p_serializer, b_array ? ']' : '}');
+        if (p_serializer->i_depth == 0)
+            serialize_byte(p_serializer, '\n');
+    }
+    else
+        serialize_byte(p_serializer, 0xff);
+}
+
+/*****************************************************************************
+ * Scalars
+ *****************************************************************************/
+static void serialize_decimal(dvbpsi_serializer_t *p_serializer, uint64_t i_value)
+{
+    char psz_digits[20];
+    int i = sizeof(psz_digits);
+
+    do
+    {
+        psz_digits[--i] = '0' + i_value % 10;
+        i_value /= 10;
+    } while (i_value);
+    serialize_write(p_serializer, psz_digits + i, sizeof(psz_digits) - i);
+}
+
+static void serialize_uint(dvbpsi_serializer_t *p_serializer, const char *psz_key,
+                           uint64_t i_value)
+{
+    serialize_key(p_serializer, psz_key);
+    serialize_value(p_serializer);
+    if (p_serializer->i_format == DVBPSI_SERIALIZER_JSON)
+        serialize_decimal(p_serializer, i_value);
+    else
+        serialize_cbor_head(p_serializer, 0, i_value);
+}
+
+static void serialize_int(dvbpsi_serializer_t *p_serializer, const char *psz_key,
+                          int64_t i_value)
+{
+    if (i_value >= 0)
+    {
+        serialize_uint(p_serializer, psz_key, i_value);
+        return;
+    }
+
+    /* -1 - i_value without overflow for INT64_MIN */
+    uint64_t i_magnitude = (uint64_t)(-(i_value + 1));
+    serialize_key(p_serializer, psz_key);
+    serialize_value(p_serializer);
+    if (p_serializer->i_format == DVBPSI_SERIALIZER_JSON)
+    {
+        serialize_byte(p_serializer, '-');
+        if (i_magnitude == UINT64_MAX)
+            serialize_write(p_serializer, "18446744073709551616", 20);
+        else
+            serialize_decimal(p_serializer, i_magnitude + 1);
+    }
+    else
+        serialize_cbor_head(p_serializer, 1, i_magnitude);
+}
+
+static void serialize_bool(dvbpsi_serializer_t *p_serializer, const char *psz_key,
+                           bool b_value)
+{
+    serialize_key(p_serializer, psz_key);
+    serialize_value(p_serializer);
+    if (p_serializer->i_format == DVBPSI_SERIALIZER_JSON)
+    {
+        if (b_value)
+            serialize_write(p_serializer, "true", 4);
+        else
+            serialize_write(p_serializer, "false", 5);
+    }
+    else
+        serialize_byte(p_serializer, b_value ? 0xf5 : 0xf4);
+}
+
+static void serialize_null(dvbpsi_serializer_t *p_serializer, const char *psz_key)
+{
+    serialize_key(p_serializer, psz_key);
+    serialize_value(p_serializer);
+    if (p_serializer->i_format == DVBPSI_SERIALIZER_JSON)
+        serialize_write(p_serializer, "null", 4);
+    else
+        serialize_byte(p_serializer, 0xf6);
+}
+
+/*****************************************************************************
+ * serialize_string
+ *****************************************************************************
+ * UTF-8 string, escaped in JSON.
+ *****************************************************************************/
+static void serialize_string(dvbpsi_serializer_t *p_serializer, const char *psz_key,
+                             const char *p_string, size_t i_length)
+{
+    static const char p_hex[] = "0123456789abcdef";
+
+    serialize_key(p_serializer, psz_key);
+    serialize_value(p_serializer);
+    if (p_serializer->i_format == DVBPSI_SERIALIZER_CBOR)
+    {
+        serialize_cbor_head(p_serializer, 3, i_length);
+        serialize_write(p_serializer, p_string, i_length);
+        return;
+    }
+
+    serialize_byte(p_serializer, '"');
+    size_t i_run = 0;
+    for (size_t i = 0; i < i_length; i++)
+    {
+        uint8_t i_char = p_string[i];
+        if (i_char >= 0x20 && i_char != '"' && i_char != '\\')
+            continue;
+
+        serialize_write(p_serializer, p_string + i_run, i - i_run);
+        i_run = i + 1;
+        switch (i_char)
+        {
+            case '"':  serialize_write(p_serializer, "\\\"", 2); break;
+            case '\\': serialize_write(p_serializer, "\\\\", 2); break;
+            case '\n': serialize_write(p_serializer, "\\n", 2); break;
+            case '\t': serialize_write(p_serializer, "\\t", 2); break;
+            default:
+            {
+                char psz_escape[6] = { '\\', 'u', '0', '0',
+                                       p_hex[i_char >> 4], p_hex[i_char & 0xf] };
+                serialize_write(p_serializer, psz_escape, 6);
+                break;
+            }
+        }
+    }
+    serialize_write(p_serializer, p_string + i_run, i_length - i_run);
+    serialize_byte(p_serializer, '"');
+}
+
+static void serialize_cstring(dvbpsi_serializer_t *p_serializer, const char *psz_key,
+                              const char *psz_string)
+{
+    serialize_string(p_serializer, psz_key, psz_string, strlen(psz_string));
+}
+
+/*****************************************************************************
+ * serialize_bytes
+ *****************************************************************************
+ * Bytes, a hexadecimal string in JSON.
+ *****************************************************************************/
+static void serialize_bytes(dvbpsi_serializer_t *p_serializer, const char *psz_key,
+                            const uint8_t *p_data, size_t i_length)
+{
+    static const char p_hex[] = "0123456789abcdef";
+
+    serialize_key(p_serializer, psz_key);
+    serialize_value(p_serializer);
+    if (p_serializer->i_format == DVBPSI_SERIALIZER_CBOR)
+    {
+        serialize_cbor_head(p_serializer, 2, i_length);
+        serialize_write(p_serializer, p_data, i_length);
+        return;
+    }
+
+    if (!serialize_reserve(p_serializer, 2 * i_length + 2))
+        return;
+    uint8_t *p_out = p_serializer->p_buffer + p_serializer->i_length;
+    *p_out++ = '"';
+    for (size_t i = 0; i < i_length; i++)
+    {
+        *p_out++ = p_hex[p_data[i] >> 4];
+        *p_out++ = p_hex[p_data[i] & 0xf];
+    }
+    *p_out = '"';
+    p_serializer->i_length += 2 * i_length + 2;
+}
+
+/*****************************************************************************
+ * serialize_text
+ *****************************************************************************
+ * DVB text converted to UTF-8, null for an unsupported character table.
+ *****************************************************************************/
+static void serialize_text(dvbpsi_serializer_t *p_serializer, const char *psz_key,
+                           const uint8_t *p_text, size_t i_length)
+{
+    char psz_utf8[1024];
+
+    if (dvbpsi_text_to_utf8(p_text, i_length, 0, psz_utf8, sizeof(psz_utf8)) < 0)
+        serialize_null(p_serializer, psz_key);
+    else
+        serialize_cstring(p_serializer, psz_key, psz_utf8);
+}
+
+/*****************************************************************************
+ * serialize_code
+ *****************************************************************************
+ * ISO 639 language code or ISO 3166 country code, keeping the printable
+ * ASCII characters.
+ *****************************************************************************/
+static void serialize_code(dvbpsi_serializer_t *p_serializer, const char *psz_key,
+                           const uint8_t *p_code)
+{
+    char psz_code[3];
+    size_t i_length = 0;
+
+    for (int i = 0; i < 3; i++)
+        if (p_code[i] >= 0x20 && p_code[i] < 0x7f)
+            psz_code[i_length++] = p_code[i];
+    serialize_string(p_serializer, psz_key, psz_code, i_length);
+}
+
+/*****************************************************************************
+ * serialize_utf16
+ *****************************************************************************
+ * UTF-16 string of the ATSC VCT short_name, up to its first NUL character.
+ *****************************************************************************/
+static void serialize_utf16(dvbpsi_serializer_t *p_serializer, const char *psz_key,
+                            const uint8_t *p_text, size_t i_units)
+{
+    char psz_utf8[64];
+    size_t i_length = 0;
+
+    assert(i_units <= 16);
+    for (size_t i = 0; i < i_units; i++)
+    {
+        uint16_t i_unit = (p_text[2 * i] << 8) | p_text[2 * i + 1];
+        if (i_unit == 0)
+            break;
+        if (i_unit >= 0xd800 && i_unit < 0xe000)
+            i_unit = 0xfffd;    /* not for a channel name */
+        if (i_unit < 0x80)
+            psz_utf8[i_length++] = i_unit;
+        else if (i_unit < 0x800)
+        {
+            psz_utf8[i_length++] = 0xc0 | (i_unit >> 6);
+            psz_utf8[i_length++] = 0x80 | (i_unit & 0x3f);
+        }
+        else
+        {
+            psz_utf8[i_length++] = 0xe0 | (i_unit >> 12);
+            psz_utf8[i_length++] = 0x80 | ((i_unit >> 6) & 0x3f);
+            psz_utf8[i_length++] = 0x80 | (i_unit & 0x3f);
+        }
+    }
+    serialize_string(p_serializer, psz_key, psz_utf8, i_length);
+}
+
+/*****************************************************************************
+ * serialize_mjd
+ *****************************************************************************
+ * MJD and BCD time, null when undefined.
+ *****************************************************************************/
+static void serialize_mjd(dvbpsi_serializer_t *p_serializer, const char *psz_key,
+                          uint64_t i_time)
+{
+    if (i_time == DVBPSI_MJD_UNDEFINED)
+        serialize_null(p_serializer, psz_key);
+    else
+        serialize_int(p_serializer, psz_key, dvbpsi_mjd_to_utc(i_time));
+}
+
+/*****************************************************************************
+ * serialize_table_begin
+ *****************************************************************************
+ * Starts the object of a table, returning the length of the output to
+ * restore on failure.
+ *****************************************************************************/
+static size_t serialize_table_begin(dvbpsi_serializer_t *p_serializer,
+                                    const char *psz_table, uint8_t i_table_id)
+{
+    assert(p_serializer);
+    assert(p_serializer->i_depth == 0);
+
+    size_t i_length = p_serializer->i_length;
+    p_serializer->b_full = false;
+    serialize_begin(p_serializer, NULL, false);
+    serialize_cstring(p_serializer, "table", psz_table);
+    serialize_uint(p_serializer, "table_id", i_table_id);
+    return i_length;
+}
+
+static bool serialize_table_end(dvbpsi_serializer_t *p_serializer, size_t i_length)
+{
+    serialize_end(p_serializer, false);
+    assert(p_serializer->i_depth == 0);
+    if (!p_serializer->b_full)
+        return true;
+
+    p_serializer->i_length = i_length;
+    p_serializer->b_key = false;
+    return false;
+}
+
+/*****************************************************************************
+ * Decoded descriptors
+ *****************************************************************************
+ * The decoded form of a tag is described by a list of its members, and
+ * optionally of the members of the elements of its array. The offsets of
+ * these are the ones of the first element, the elements being
+ * i_element_size bytes from each other.
+ *****************************************************************************/
+enum serialize_kind
+{
+    SERIALIZE_U8 = 0,
+    SERIALIZE_U16,
+    SERIALIZE_U32,
+    SERIALIZE_BOOL,
+    SERIALIZE_INT_BOOL,     /* int used as a boolean */
+    SERIALIZE_CODE,         /* 3 characters */
+    SERIALIZE_CODE24,       /* 3 characters in the low 24 bits of a uint32_t */
+    SERIALIZE_MJD,          /* uint64_t MJD and BCD time */
+    SERIALIZE_TEXT,         /* DVB text, uint8_t length */
+    SERIALIZE_TEXT_INT,     /* DVB text, int length */
+    SERIALIZE_TEXT_POINTER, /* pointer to a DVB text, int length */
+    SERIALIZE_BYTES,        /* bytes, uint8_t length */
+    SERIALIZE_BYTES_POINTER /* pointer to bytes, uint8_t length */
+};
+
+typedef struct serialize_field_s
+{
+    const char *    psz_name;       /* NULL for an array of values */
+    size_t          i_offset;
+    uint8_t         i_kind;
+    size_t          i_length;       /* offset of the length */
+} serialize_field_t;
+
+typedef struct serialize_dr_s
+{
+    const serialize_field_t *   p_fields;
+    unsigned int                i_fields;
+    const char *                psz_array;      /* NULL without array */
+    size_t                      i_count;        /* offset of the uint8_t
+                                                   number of elements */
+    size_t                      i_element_size;
+    const serialize_field_t *   p_elements;
+    unsigned int                i_elements;
+} serialize_dr_t;
+
+#define SERIALIZE_FIELD(type, member, name, kind) \
+    { name, offsetof(type, member), SERIALIZE_##kind, 0 }
+#define SERIALIZE_SIZED(type, member, length, name, kind) \
+    { name, offsetof(type, member), SERIALIZE_##kind, offsetof(type, length) }
+#define SERIALIZE_ELEMENT(type, array, member, name, kind) \
+    { name, offsetof(type, array[0].member), SERIALIZE_##kind, 0 }
+#define SERIALIZE_FIELDS(fields) \
+    fields, sizeof(fields) / sizeof(fields[0])
+#define SERIALIZE_ARRAY(type, name, count, array, elements) \
+    name, offsetof(type, count), sizeof(((type *)0)->array[0]), SERIALIZE_FIELDS(elements)
+
+static void serialize_field(dvbpsi_serializer_t *p_serializer,
+                            const serialize_field_t *p_field, const uint8_t *p_base)
+{
+    const uint8_t *p = p_base + p_field->i_offset;
+    const char *psz_name = p_field->psz_name;
+
+    switch (p_field->i_kind)
+    {
+        case SERIALIZE_U8:
+            serialize_uint(p_serializer, psz_name, *p);
+            break;
+        case SERIALIZE_U16:
+            serialize_uint(p_serializer, psz_name, *(const uint16_t *)p);
+            break;
+        case SERIALIZE_U32:
+            serialize_uint(p_serializer, psz_name, *(const uint32_t *)p);
+            break;
+        case SERIALIZE_BOOL:
+            serialize_bool(p_serializer, psz_name, *(const bool *)p);
+            break;
+        case SERIALIZE_INT_BOOL:
+            serialize_bool(p_serializer, psz_name, *(const int *)p != 0);
+            break;
+        case SERIALIZE_CODE:
+            serialize_code(p_serializer, psz_name, p);
+            break;
+        case SERIALIZE_CODE24:
+        {
+            uint32_t i_code = *(const uint32_t *)p;
+            uint8_t p_code[3] = { i_code >> 16, i_code >> 8, i_code };
+            serialize_code(p_serializer, psz_name, p_code);
+            break;
+        }
+        case SERIALIZE_MJD:
+            serialize_mjd(p_serializer, psz_name, *(const uint64_t *)p);
+            break;
+        case SERIALIZE_TEXT:
+            serialize_text(p_serializer, psz_name, p, p_base[p_field->i_length]);
+            break;
+        case SERIALIZE_TEXT_INT:
+        {
+            int i_length = *(const int *)(p_base + p_field->i_length);
+            serialize_text(p_serializer, psz_name, p, i_length > 0 ? i_length : 0);
+            break;
+        }
+        case SERIALIZE_TEXT_POINTER:
+        {
+            int i_length = *(const int *)(p_base + p_field->i_length);
+            const uint8_t *p_text = *(uint8_t * const *)p;
+            serialize_text(p_serializer, psz_name, p_text,
+                           p_text && i_length > 0 ? i_length : 0);
+            break;
+        }
+        case SERIALIZE_BYTES:
+            serialize_bytes(p_serializer, psz_name, p, p_base[p_field->i_length]);
+            break;
+        case SERIALIZE_BYTES_POINTER:
+        {
+            const uint8_t *p_data = *(uint8_t * const *)p;
+            serialize_bytes(p_serializer, psz_name, p_data,
+                            p_data ? p_base[p_field->i_length] : 0);
+            break;
+        }
+    }
+}
+
+static void serialize_decoded(dvbpsi_serializer_t *p_serializer,
+                              const serialize_dr_t *p_dr, const void *p_decoded)
+{
+    const uint8_t *p_base = p_decoded;
+
+    serialize_begin(p_serializer, "decoded", false);
+    for (unsigned int i = 0; i < p_dr->i_fields; i++)
+        serialize_field(p_serializer, &p_dr->p_fields[i], p_base);
+    if (p_dr->psz_array)
+    {
+        serialize_begin(p_serializer, p_dr->psz_array, true);
+        for (unsigned int i = 0; i < p_base[p_dr->i_count]; i++)
+        {
+            const uint8_t *p_element = p_base + i * p_dr->i_element_size;
+            if (p_dr->p_elements[0].psz_name == NULL)
+            {
+                serialize_field(p_serializer, &p_dr->p_elements[0], p_element);
+                continue;
+            }
+            serialize_begin(p_serializer, NULL, false);
+            for (unsigned int j = 0; j < p_dr->i_elements; j++)
+                serialize_field(p_serializer, &p_dr->p_elements[j], p_element);
+            serialize_end(p_serializer, false);
+        }
+        serialize_end(p_serializer, true);
+    }
+    serialize_end(p_serializer, false);
+}
+
+/* ISO/IEC 13818-1 */
+static const serialize_field_t serialize_dr_02[] =
+{
+    SERIALIZE_FIELD(dvbpsi_vstream_dr_t, b_multiple_frame_rate, "multiple_frame_rate_flag", BOOL),
+    SERIALIZE_FIELD(dvbpsi_vstream_dr_t, i_frame_rate_code, "frame_rate_code", U8),
+    SERIALIZE_FIELD(dvbpsi_vstream_dr_t, b_mpeg2, "mpeg2", BOOL),
+    SERIALIZE_FIELD(dvbpsi_vstream_dr_t, b_constrained_parameter, "constrained_parameter_flag", BOOL),
+    SERIALIZE_FIELD(dvbpsi_vstream_dr_t, b_still_picture, "still_picture_flag", BOOL),
+    SERIALIZE_FIELD(dvbpsi_vstream_dr_t, i_profile_level_indication, "profile_and_level_indication", U8),
+    SERIALIZE_FIELD(dvbpsi_vstream_dr_t, i_chroma_format, "chroma_format", U8),
+    SERIALIZE_FIELD(dvbpsi_vstream_dr_t, b_frame_rate_extension, "frame_rate_extension_flag", BOOL),
+};
+static const serialize_field_t serialize_dr_03[] =
+{
+    SERIALIZE_FIELD(dvbpsi_astream_dr_t, b_free_format, "free_format_flag", BOOL),
+    SERIALIZE_FIELD(dvbpsi_astream_dr_t, i_id, "id", U8),
+    SERIALIZE_FIELD(dvbpsi_astream_dr_t, i_layer, "layer", U8),
+    SERIALIZE_FIELD(dvbpsi_astream_dr_t, b_variable_rate_audio_indicator, "variable_rate_audio_indicator", BOOL),
+};
+static const serialize_field_t serialize_dr_04[] =
+{
+    SERIALIZE_FIELD(dvbpsi_hierarchy_dr_t, i_h_type, "hierarchy_type", U8),
+    SERIALIZE_FIELD(dvbpsi_hierarchy_dr_t, i_h_layer_index, "hierarchy_layer_index", U8),
+    SERIALIZE_FIELD(dvbpsi_hierarchy_dr_t, i_h_embedded_layer, "hierarchy_embedded_layer_index", U8),
+    SERIALIZE_FIELD(dvbpsi_hierarchy_dr_t, i_h_priority, "hierarchy_channel", U8),
+};
+static const serialize_field_t serialize_dr_05[] =
+{
+    SERIALIZE_FIELD(dvbpsi_registration_dr_t, i_format_identifier, "format_identifier", U32),
+    SERIALIZE_SIZED(dvbpsi_registration_dr_t, i_additional_info, i_additional_length,
+                    "additional_identification_info", BYTES),
+};
+static const serialize_field_t serialize_dr_06[] =
+{
+    SERIALIZE_FIELD(dvbpsi_ds_alignment_dr_t, i_alignment_type, "alignment_type", U8),
+};
+static const serialize_field_t serialize_dr_07[] =
+{
+    SERIALIZE_FIELD(dvbpsi_target_bg_grid_dr_t, i_horizontal_size, "horizontal_size", U16),
+    SERIALIZE_FIELD(dvbpsi_target_bg_grid_dr_t, i_vertical_size, "vertical_size", U16),
+    SERIALIZE_FIELD(dvbpsi_target_bg_grid_dr_t, i_pel_aspect_ratio, "aspect_ratio_information", U8),
+};
+static const serialize_field_t serialize_dr_08[] =
+{
+    SERIALIZE_FIELD(dvbpsi_vwindow_dr_t, i_horizontal_offset, "horizontal_offset", U16),
+    SERIALIZE_FIELD(dvbpsi_vwindow_dr_t, i_vertical_offset, "vertical_offset", U16),
+    SERIALIZE_FIELD(dvbpsi_vwindow_dr_t, i_window_priority, "window_priority", U8),
+};
+static const serialize_field_t serialize_dr_09[] =
+{
+    SERIALIZE_FIELD(dvbpsi_ca_dr_t, i_ca_system_id, "ca_system_id", U16),
+    SERIALIZE_FIELD(dvbpsi_ca_dr_t, i_ca_pid, "ca_pid", U16),
+    SERIALIZE_SIZED(dvbpsi_ca_dr_t, i_private_data, i_private_length, "private_data", BYTES),
+};
+static const serialize_field_t serialize_dr_0a[] =
+{
+    SERIALIZE_ELEMENT(dvbpsi_iso639_dr_t, code, iso_639_code, "iso_639_language_code", CODE),
+    SERIALIZE_ELEMENT(dvbpsi_iso639_dr_t, code, i_audio_type, "audio_type", U8),
+};
+static const serialize_field_t serialize_dr_0b[] =
+{
+    SERIALIZE_FIELD(dvbpsi_system_clock_dr_t, i_clock_accuracy_integer, "clock_accuracy_integer", U8),
+    SERIALIZE_FIELD(dvbpsi_system_clock_dr_t, i_clock_accuracy_exponent, "clock_accuracy_exponent", U8),
+};
+static const serialize_field_t serialize_dr_0c[] =
+{
+    SERIALIZE_FIELD(dvbpsi_mx_buff_utilization_dr_t, b_mdv_valid, "bound_valid_flag", BOOL),
+    SERIALIZE_FIELD(dvbpsi_mx_buff_utilization_dr_t, i_mx_delay_variation, "ltw_offset_lower_bound", U16),
+    SERIALIZE_FIELD(dvbpsi_mx_buff_utilization_dr_t, i_mx_strategy, "ltw_offset_upper_bound", U8),
+};
+static const serialize_field_t serialize_dr_0d[] =
+{
+    SERIALIZE_FIELD(dvbpsi_copyright_dr_t, i_copyright_identifier, "copyright_identifier", U32),
+    SERIALIZE_SIZED(dvbpsi_copyright_dr_t, i_additional_info, i_additional_length,
+                    "additional_copyright_info", BYTES),
+};
+static const serialize_field_t serialize_dr_0e[] =
+{
+    SERIALIZE_FIELD(dvbpsi_max_bitrate_dr_t, i_max_bitrate, "maximum_bitrate", U32),
+};
+static const serialize_field_t serialize_dr_0f[] =
+{
+    SERIALIZE_FIELD(dvbpsi_private_data_dr_t, i_private_data, "private_data_indicator", U32),
+};
+static const serialize_field_t serialize_dr_10[] =
+{
+    SERIALIZE_FIELD(dvbpsi_smoothing_buffer_dr_t, i_sb_leak_rate, "sb_leak_rate", U32),
+    SERIALIZE_FIELD(dvbpsi_smoothing_buffer_dr_t, i_sb_size, "sb_size", U32),
+};
+static const serialize_field_t serialize_dr_11[] =
+{
+    SERIALIZE_FIELD(dvbpsi_std_dr_t, b_leak_valid_flag, "leak_valid_flag", BOOL),
+};
+static const serialize_field_t serialize_dr_12[] =
+{
+    SERIALIZE_FIELD(dvbpsi_ibp_dr_t, b_closed_gop_flag, "closed_gop_flag", BOOL),
+    SERIALIZE_FIELD(dvbpsi_ibp_dr_t, b_identical_gop_flag, "identical_gop_flag", BOOL),
+    SERIALIZE_FIELD(dvbpsi_ibp_dr_t, i_max_gop_length, "max_gop_length", U16),
+};
+static const serialize_field_t serialize_dr_13[] =
+{
+    SERIALIZE_FIELD(dvbpsi_carousel_id_dr_t, i_carousel_id, "carousel_id", U32),
+    SERIALIZE_SIZED(dvbpsi_carousel_id_dr_t, p_private_data, i_private_data_len,
+                    "private_data", BYTES_POINTER),
+};
+static const serialize_field_t serialize_dr_14[] =
+{
+    SERIALIZE_FIELD(dvbpsi_association_tag_dr_t, i_tag, "association_tag", U16),
+    SERIALIZE_FIELD(dvbpsi_association_tag_dr_t, i_use, "use", U16),
+    SERIALIZE_SIZED(dvbpsi_association_tag_dr_t, p_selector, i_selector_len,
+                    "selector", BYTES_POINTER),
+    SERIALIZE_SIZED(dvbpsi_association_tag_dr_t, p_private_data, i_private_data_len,
+                    "private_data", BYTES_POINTER),
+};
+static const serialize_field_t serialize_dr_8a[] =
+{
+    SERIALIZE_FIELD(dvbpsi_cuei_dr_t, i_cue_stream_type, "cue_stream_type", U8),
+};
+
+/* ETSI EN 300 468 */
+static const serialize_field_t serialize_dr_40[] =
+{
+    SERIALIZE_SIZED(dvbpsi_network_name_dr_t, i_name_byte, i_name_length, "network_name", TEXT),
+};
+static const serialize_field_t serialize_dr_41[] =
+{
+    SERIALIZE_ELEMENT(dvbpsi_service_list_dr_t, i_service, i_service_id, "service_id", U16),
+    SERIALIZE_ELEMENT(dvbpsi_service_list_dr_t, i_service, i_service_type, "service_type", U8),
+};
+static const serialize_field_t serialize_dr_43[] =
+{
+    SERIALIZE_FIELD(dvbpsi_sat_deliv_sys_dr_t, i_frequency, "frequency", U32),
+    SERIALIZE_FIELD(dvbpsi_sat_deliv_sys_dr_t, i_orbital_position, "orbital_position", U16),
+    SERIALIZE_FIELD(dvbpsi_sat_deliv_sys_dr_t, i_west_east_flag, "west_east_flag", U8),
+    SERIALIZE_FIELD(dvbpsi_sat_deliv_sys_dr_t, i_polarization, "polarization", U8),
+    SERIALIZE_FIELD(dvbpsi_sat_deliv_sys_dr_t, i_roll_off, "roll_off", U8),
+    SERIALIZE_FIELD(dvbpsi_sat_deliv_sys_dr_t, i_modulation_system, "modulation_system", U8),
+    SERIALIZE_FIELD(dvbpsi_sat_deliv_sys_dr_t, i_modulation_type, "modulation_type", U8),
+    SERIALIZE_FIELD(dvbpsi_sat_deliv_sys_dr_t, i_symbol_rate, "symbol_rate", U32),
+    SERIALIZE_FIELD(dvbpsi_sat_deliv_sys_dr_t, i_fec_inner, "fec_inner", U8),
+};
+static const serialize_field_t serialize_dr_44[] =
+{
+    SERIALIZE_FIELD(dvbpsi_cable_deliv_sys_dr_t, i_frequency, "frequency", U32),
+    SERIALIZE_FIELD(dvbpsi_cable_deliv_sys_dr_t, i_fec_outer, "fec_outer", U8),
+    SERIALIZE_FIELD(dvbpsi_cable_deliv_sys_dr_t, i_modulation, "modulation", U8),
+    SERIALIZE_FIELD(dvbpsi_cable_deliv_sys_dr_t, i_symbol_rate, "symbol_rate", U32),
+    SERIALIZE_FIELD(dvbpsi_cable_deliv_sys_dr_t, i_fec_inner, "fec_inner", U8),
+};
+static const serialize_field_t serialize_dr_47[] =
+{
+    SERIALIZE_SIZED(dvbpsi_bouquet_name_dr_t, i_char, i_name_length, "bouquet_name", TEXT),
+};
+static const serialize_field_t serialize_dr_48[] =
+{
+    SERIALIZE_FIELD(dvbpsi_service_dr_t, i_service_type, "service_type", U8),
+    SERIALIZE_SIZED(dvbpsi_service_dr_t, i_service_provider_name, i_service_provider_name_length,
+                    "service_provider_name", TEXT),
+    SERIALIZE_SIZED(dvbpsi_service_dr_t, i_service_name, i_service_name_length,
+                    "service_name", TEXT),
+};
+static const serialize_field_t serialize_dr_49[] =
+{
+    SERIALIZE_FIELD(dvbpsi_country_availability_dr_t, b_country_availability_flag,
+                    "country_availability_flag", BOOL),
+};
+static const serialize_field_t serialize_dr_49_codes[] =
+{
+    SERIALIZE_ELEMENT(dvbpsi_country_availability_dr_t, code, iso_639_code, "country_code", CODE),
+};
+static const serialize_field_t serialize_dr_4b[] =
+{
+    SERIALIZE_ELEMENT(dvbpsi_nvod_ref_dr_t, p_nvod_refs, i_transport_stream_id,
+                      "transport_stream_id", U16),
+    SERIALIZE_ELEMENT(dvbpsi_nvod_ref_dr_t, p_nvod_refs, i_original_network_id,
+                      "original_network_id", U16),
+    SERIALIZE_ELEMENT(dvbpsi_nvod_ref_dr_t, p_nvod_refs, i_service_id, "service_id", U16),
+};
+static const serialize_field_t serialize_dr_4c[] =
+{
+    SERIALIZE_FIELD(dvbpsi_tshifted_service_dr_t, i_ref_service_id, "reference_service_id", U16),
+};
+static const serialize_field_t serialize_dr_4d[] =
+{
+    SERIALIZE_FIELD(dvbpsi_short_event_dr_t, i_iso_639_code, "iso_639_language_code", CODE),
+    SERIALIZE_SIZED(dvbpsi_short_event_dr_t, i_event_name, i_event_name_length,
+                    "event_name", TEXT_INT),
+    SERIALIZE_SIZED(dvbpsi_short_event_dr_t, i_text, i_text_length, "text", TEXT_INT),
+};
+static const serialize_field_t serialize_dr_4f[] =
+{
+    SERIALIZE_FIELD(dvbpsi_tshifted_ev_dr_t, i_ref_service_id, "reference_service_id", U16),
+    SERIALIZE_FIELD(dvbpsi_tshifted_ev_dr_t, i_ref_event_id, "reference_event_id", U16),
+};
+static const serialize_field_t serialize_dr_50[] =
+{
+    SERIALIZE_FIELD(dvbpsi_component_dr_t, i_stream_content, "stream_content", U8),
+    SERIALIZE_FIELD(dvbpsi_component_dr_t, i_component_type, "component_type", U8),
+    SERIALIZE_FIELD(dvbpsi_component_dr_t, i_component_tag, "component_tag", U8),
+    SERIALIZE_FIELD(dvbpsi_component_dr_t, i_iso_639_code, "iso_639_language_code", CODE),
+    SERIALIZE_SIZED(dvbpsi_component_dr_t, i_text, i_text_length, "text", TEXT_POINTER),
+};
+static const serialize_field_t serialize_dr_52[] =
+{
+    SERIALIZE_FIELD(dvbpsi_stream_identifier_dr_t, i_component_tag, "component_tag", U8),
+};
+static const serialize_field_t serialize_dr_53[] =
+{
+    { NULL, offsetof(dvbpsi_ca_identifier_dr_t, p_system[0].i_ca_system_id), SERIALIZE_U16, 0 },
+};
+static const serialize_field_t serialize_dr_54[] =
+{
+    SERIALIZE_ELEMENT(dvbpsi_content_dr_t, p_content, i_type, "content_nibbles", U8),
+    SERIALIZE_ELEMENT(dvbpsi_content_dr_t, p_content, i_user_byte, "user_byte", U8),
+};
+static const serialize_field_t serialize_dr_55[] =
+{
+    SERIALIZE_ELEMENT(dvbpsi_parental_rating_dr_t, p_parental_rating, i_country_code,
+                      "country_code", CODE24),
+    SERIALIZE_ELEMENT(dvbpsi_parental_rating_dr_t, p_parental_rating, i_rating, "rating", U8),
+};
+static const serialize_field_t serialize_dr_56[] =
+{
+    SERIALIZE_ELEMENT(dvbpsi_teletext_dr_t, p_pages, i_iso6392_language_code,
+                      "iso_639_language_code", CODE),
+    SERIALIZE_ELEMENT(dvbpsi_teletext_dr_t, p_pages, i_teletext_type, "teletext_type", U8),
+    SERIALIZE_ELEMENT(dvbpsi_teletext_dr_t, p_pages, i_teletext_magazine_number,
+                      "teletext_magazine_number", U8),
+    SERIALIZE_ELEMENT(dvbpsi_teletext_dr_t, p_pages, i_teletext_page_number,
+                      "teletext_page_number", U8),
+};
+static const serialize_field_t serialize_dr_58[] =
+{
+    SERIALIZE_ELEMENT(dvbpsi_local_time_offset_dr_t, p_local_time_offset, i_country_code,
+                      "country_code", CODE),
+    SERIALIZE_ELEMENT(dvbpsi_local_time_offset_dr_t, p_local_time_offset, i_country_region_id,
+                      "country_region_id", U8),
+    SERIALIZE_ELEMENT(dvbpsi_local_time_offset_dr_t, p_local_time_offset,
+                      i_local_time_offset_polarity, "local_time_offset_polarity", U8),
+    SERIALIZE_ELEMENT(dvbpsi_local_time_offset_dr_t, p_local_time_offset, i_local_time_offset,
+                      "local_time_offset", U16),
+    SERIALIZE_ELEMENT(dvbpsi_local_time_offset_dr_t, p_local_time_offset, i_time_of_change,
+                      "time_of_change", MJD),
+    SERIALIZE_ELEMENT(dvbpsi_local_time_offset_dr_t, p_local_time_offset, i_next_time_offset,
+                      "next_time_offset", U16),
+};
+static const serialize_field_t serialize_dr_59[] =
+{
+    SERIALIZE_ELEMENT(dvbpsi_subtitling_dr_t, p_subtitle, i_iso6392_language_code,
+                      "iso_639_language_code", CODE),
+    SERIALIZE_ELEMENT(dvbpsi_subtitling_dr_t, p_subtitle, i_subtitling_type, "subtitling_type", U8),
+    SERIALIZE_ELEMENT(dvbpsi_subtitling_dr_t, p_subtitle, i_composition_page_id,
+                      "composition_page_id", U16),
+    SERIALIZE_ELEMENT(dvbpsi_subtitling_dr_t, p_subtitle, i_ancillary_page_id,
+                      "ancillary_page_id", U16),
+};
+static const serialize_field_t serialize_dr_5a[] =
+{
+    SERIALIZE_FIELD(dvbpsi_terr_deliv_sys_dr_t, i_centre_frequency, "centre_frequency", U32),
+    SERIALIZE_FIELD(dvbpsi_terr_deliv_sys_dr_t, i_bandwidth, "bandwidth", U8),
+    SERIALIZE_FIELD(dvbpsi_terr_deliv_sys_dr_t, i_priority, "priority", U8),
+    SERIALIZE_FIELD(dvbpsi_terr_deliv_sys_dr_t, i_time_slice_indicator, "time_slicing_indicator", U8),
+    SERIALIZE_FIELD(dvbpsi_terr_deliv_sys_dr_t, i_mpe_fec_indicator, "mpe_fec_indicator", U8),
+    SERIALIZE_FIELD(dvbpsi_terr_deliv_sys_dr_t, i_constellation, "constellation", U8),
+    SERIALIZE_FIELD(dvbpsi_terr_deliv_sys_dr_t, i_hierarchy_information, "hierarchy_information", U8),
+    SERIALIZE_FIELD(dvbpsi_terr_deliv_sys_dr_t, i_code_rate_hp_stream, "code_rate_hp_stream", U8),
+    SERIALIZE_FIELD(dvbpsi_terr_deliv_sys_dr_t, i_code_rate_lp_stream, "code_rate_lp_stream", U8),
+    SERIALIZE_FIELD(dvbpsi_terr_deliv_sys_dr_t, i_guard_interval, "guard_interval", U8),
+    SERIALIZE_FIELD(dvbpsi_terr_deliv_sys_dr_t, i_transmission_mode, "transmission_mode", U8),
+    SERIALIZE_FIELD(dvbpsi_terr_deliv_sys_dr_t, i_other_frequency_flag, "other_frequency_flag", U8),
+};
+static const serialize_field_t serialize_dr_62[] =
+{
+    SERIALIZE_FIELD(dvbpsi_frequency_list_dr_t, i_coding_type, "coding_type", U8),
+};
+static const serialize_field_t serialize_dr_62_frequencies[] =
+{
+    { NULL, offsetof(dvbpsi_frequency_list_dr_t, p_center_frequencies[0]), SERIALIZE_U32, 0 },
+};
+static const serialize_field_t serialize_dr_66[] =
+{
+    SERIALIZE_FIELD(dvbpsi_data_broadcast_id_dr_t, i_data_broadcast_id, "data_broadcast_id", U16),
+    SERIALIZE_SIZED(dvbpsi_data_broadcast_id_dr_t, p_id_selector, i_id_selector_len,
+                    "id_selector", BYTES_POINTER),
+};
+static const serialize_field_t serialize_dr_83[] =
+{
+    SERIALIZE_ELEMENT(dvbpsi_lcn_dr_t, p_entries, i_service_id, "service_id", U16),
+    SERIALIZE_ELEMENT(dvbpsi_lcn_dr_t, p_entries, b_visible_service_flag,
+                      "visible_service_flag", INT_BOOL),
+    SERIALIZE_ELEMENT(dvbpsi_lcn_dr_t, p_entries, i_logical_channel_number,
+                      "logical_channel_number", U16),
+};
+
+/* ATSC A/52 and A/65 */
+static const serialize_field_t serialize_dr_81[] =
+{
+    SERIALIZE_FIELD(dvbpsi_ac3_audio_dr_t, i_sample_rate_code, "sample_rate_code", U8),
+    SERIALIZE_FIELD(dvbpsi_ac3_audio_dr_t, i_bsid, "bsid", U8),
+    SERIALIZE_FIELD(dvbpsi_ac3_audio_dr_t, i_bit_rate_code, "bit_rate_code", U8),
+    SERIALIZE_FIELD(dvbpsi_ac3_audio_dr_t, i_surround_mode, "surround_mode", U8),
+    SERIALIZE_FIELD(dvbpsi_ac3_audio_dr_t, i_bsmod, "bsmod", U8),
+    SERIALIZE_FIELD(dvbpsi_ac3_audio_dr_t, i_num_channels, "num_channels", U8),
+    SERIALIZE_FIELD(dvbpsi_ac3_audio_dr_t, b_full_svc, "full_svc", INT_BOOL),
+};
+static const serialize_field_t serialize_dr_86[] =
+{
+    SERIALIZE_ELEMENT(dvbpsi_caption_service_dr_t, services, i_iso_639_code,
+                      "language", CODE),
+    SERIALIZE_ELEMENT(dvbpsi_caption_service_dr_t, services, b_digital_cc, "digital_cc", INT_BOOL),
+    SERIALIZE_ELEMENT(dvbpsi_caption_service_dr_t, services, b_line21_field,
+                      "line21_field", INT_BOOL),
+    SERIALIZE_ELEMENT(dvbpsi_caption_service_dr_t, services, i_caption_service_number,
+                      "caption_service_number", U16),
+    SERIALIZE_ELEMENT(dvbpsi_caption_service_dr_t, services, b_easy_reader, "easy_reader", INT_BOOL),
+    SERIALIZE_ELEMENT(dvbpsi_caption_service_dr_t, services, b_wide_aspect_ratio,
+                      "wide_aspect_ratio", INT_BOOL),
+};
+static const serialize_field_t serialize_dr_a0[] =
+{
+    SERIALIZE_SIZED(dvbpsi_extended_channel_name_dr_t, i_long_channel_name,
+                    i_long_channel_name_length, "long_channel_name_text", BYTES),
+};
+static const serialize_field_t serialize_dr_a1[] =
+{
+    SERIALIZE_FIELD(dvbpsi_service_location_dr_t, i_pcr_pid, "pcr_pid", U16),
+};
+static const serialize_field_t serialize_dr_a1_elements[] =
+{
+    SERIALIZE_ELEMENT(dvbpsi_service_location_dr_t, elements, i_stream_type, "stream_type", U8),
+    SERIALIZE_ELEMENT(dvbpsi_service_location_dr_t, elements, i_elementary_pid,
+                      "elementary_pid", U16),
+    SERIALIZE_ELEMENT(dvbpsi_service_location_dr_t, elements, i_iso_639_code,
+                      "iso_639_language_code", CODE),
+};
+
+#define SERIALIZE_DR(fields) { SERIALIZE_FIELDS(fields), NULL, 0, 0, NULL, 0 }
+#define SERIALIZE_DR_ARRAY(type, name, count, array, elements) \
+    { NULL, 0, SERIALIZE_ARRAY(type, name, count, array, elements) }
+
+static const serialize_dr_t serialize_dr_mpeg[] =
+{
+    SERIALIZE_DR(serialize_dr_02), SERIALIZE_DR(serialize_dr_03),
+    SERIALIZE_DR(serialize_dr_04), SERIALIZE_DR(serialize_dr_05),
+    SERIALIZE_DR(serialize_dr_06), SERIALIZE_DR(serialize_dr_07),
+    SERIALIZE_DR(serialize_dr_08), SERIALIZE_DR(serialize_dr_09),
+    SERIALIZE_DR_ARRAY(dvbpsi_iso639_dr_t, "languages", i_code_count, code, serialize_dr_0a),
+    SERIALIZE_DR(serialize_dr_0b), SERIALIZE_DR(serialize_dr_0c),
+    SERIALIZE_DR(serialize_dr_0d), SERIALIZE_DR(serialize_dr_0e),
+    SERIALIZE_DR(serialize_dr_0f), SERIALIZE_DR(serialize_dr_10),
+    SERIALIZE_DR(serialize_dr_11), SERIALIZE_DR(serialize_dr_12),
+    SERIALIZE_DR(serialize_dr_13), SERIALIZE_DR(serialize_dr_14),
+};
+
+static const serialize_dr_t serialize_dr_dvb[] =
+{
+    SERIALIZE_DR(serialize_dr_40),
+    SERIALIZE_DR_ARRAY(dvbpsi_service_list_dr_t, "services", i_service_count, i_service,
+                       serialize_dr_41),
+    SERIALIZE_DR(serialize_dr_43), SERIALIZE_DR(serialize_dr_44),
+    SERIALIZE_DR(serialize_dr_47), SERIALIZE_DR(serialize_dr_48),
+    { SERIALIZE_FIELDS(serialize_dr_49),
+      SERIALIZE_ARRAY(dvbpsi_country_availability_dr_t, "countries", i_code_count, code,
+                      serialize_dr_49_codes) },
+    SERIALIZE_DR_ARRAY(dvbpsi_nvod_ref_dr_t, "references", i_references, p_nvod_refs,
+                       serialize_dr_4b),
+    SERIALIZE_DR(serialize_dr_4c), SERIALIZE_DR(serialize_dr_4d),
+    SERIALIZE_DR(serialize_dr_4f), SERIALIZE_DR(serialize_dr_50),
+    SERIALIZE_DR(serialize_dr_52),
+    SERIALIZE_DR_ARRAY(dvbpsi_ca_identifier_dr_t, "ca_system_ids", i_number, p_system,
+                       serialize_dr_53),
+    SERIALIZE_DR_ARRAY(dvbpsi_content_dr_t, "contents", i_contents_number, p_content,
+                       serialize_dr_54),
+    SERIALIZE_DR_ARRAY(dvbpsi_parental_rating_dr_t, "ratings", i_ratings_number,
+                       p_parental_rating, serialize_dr_55),
+    SERIALIZE_DR_ARRAY(dvbpsi_teletext_dr_t, "pages", i_pages_number, p_pages,
+                       serialize_dr_56),
+    SERIALIZE_DR_ARRAY(dvbpsi_local_time_offset_dr_t, "offsets", i_local_time_offsets_number,
+                       p_local_time_offset, serialize_dr_58),
+    SERIALIZE_DR_ARRAY(dvbpsi_subtitling_dr_t, "subtitles", i_subtitles_number, p_subtitle,
+                       serialize_dr_59),
+    SERIALIZE_DR(serialize_dr_5a),
+    { SERIALIZE_FIELDS(serialize_dr_62),
+      SERIALIZE_ARRAY(dvbpsi_frequency_list_dr_t, "centre_frequencies", i_number_of_frequencies,
+                      p_center_frequencies, serialize_dr_62_frequencies) },
+    SERIALIZE_DR(serialize_dr_66),
+    SERIALIZE_DR_ARRAY(dvbpsi_lcn_dr_t, "channels", i_number_of_entries, p_entries,
+                       serialize_dr_83),
+};
+
+static const serialize_dr_t serialize_dr_atsc[] =
+{
+    SERIALIZE_DR(serialize_dr_81),
+    SERIALIZE_DR_ARRAY(dvbpsi_caption_service_dr_t, "services", i_number_of_services, services,
+                       serialize_dr_86),
+    SERIALIZE_DR(serialize_dr_a0),
+    { SERIALIZE_FIELDS(serialize_dr_a1),
+      SERIALIZE_ARRAY(dvbpsi_service_location_dr_t, "elements", i_number_elements, elements,
+                      serialize_dr_a1_elements) },
+};
+
+/*****************************************************************************
+ * serialize_dr
+ *****************************************************************************
+ * Description of the decoded form of a tag, the user private ones depending
+ * on the context.
+ *****************************************************************************/
+static const serialize_dr_t *serialize_dr(enum dvbpsi_descriptor_context i_context,
+                                          uint8_t i_tag)
+{
+    static const serialize_dr_t cuei = SERIALIZE_DR(serialize_dr_8a);
+
+    if (i_context >= DVBPSI_DESCRIPTOR_CONTEXT_MAX)
+        return NULL;
+    if (i_tag >= 0x02 && i_tag <= 0x14)
+        return &serialize_dr_mpeg[i_tag - 0x02];
+    if (i_tag == 0x8a)
+        return &cuei;
+
+    if (i_context == DVBPSI_DESCRIPTOR_CONTEXT_DVB)
+    {
+        static const uint8_t pi_dvb[256] =
+        {
+            [0x40] = 1, [0x41] = 2, [0x43] = 3, [0x44] = 4, [0x47] = 5, [0x48] = 6,
+            [0x49] = 7, [0x4b] = 8, [0x4c] = 9, [0x4d] = 10, [0x4f] = 11, [0x50] = 12,
+            [0x52] = 13, [0x53] = 14, [0x54] = 15, [0x55] = 16, [0x46] = 17, [0x56] = 17,
+            [0x58] = 18, [0x59] = 19, [0x5a] = 20, [0x62] = 21, [0x66] = 22, [0x83] = 23,
+        };
+        return pi_dvb[i_tag] ? &serialize_dr_dvb[pi_dvb[i_tag] - 1] : NULL;
+    }
+    else if (i_context == DVBPSI_DESCRIPTOR_CONTEXT_ATSC)
+    {
+        switch (i_tag)
+        {
+            case 0x81: return &serialize_dr_atsc[0];
+            case 0x86: return &serialize_dr_atsc[1];
+            case 0xa0: return &serialize_dr_atsc[2];
+            case 0xa1: return &serialize_dr_atsc[3];
+        }
+    }
+    return NULL;
+}
+
+/*****************************************************************************
+ * serialize_descriptors
+ *****************************************************************************
+ * Descriptor list, decoded in place, and not at all in the
+ * DVBPSI_DESCRIPTOR_CONTEXT_MAX context.
+ *****************************************************************************/
+static void serialize_descriptors(dvbpsi_serializer_t *p_serializer,
+                                  dvbpsi_descriptor_t *p_descriptor,
+                                  enum dvbpsi_descriptor_context i_context)
+{
+    serialize_begin(p_serializer, "descriptors", true);
+    for (; p_descriptor; p_descriptor = p_descriptor->p_next)
+    {
+        serialize_begin(p_serializer, NULL, false);
+        serialize_uint(p_serializer, "tag", p_descriptor->i_tag);
+        serialize_uint(p_serializer, "length", p_descriptor->i_length);
+        serialize_bytes(p_serializer, "data", p_descriptor->p_data, p_descriptor->i_length);
+
+        const serialize_dr_t *p_dr = serialize_dr(i_context, p_descriptor->i_tag);
+        if (p_dr)
+        {
+            void *p_decoded = p_descriptor->p_decoded;
+            if (p_decoded == NULL)
+            {
+                dvbpsi_descriptor_decoder_cb pf_decode =
+                        dvbpsi_descriptor_decoder(i_context, p_descriptor->i_tag);
+                if (pf_decode)
+                    p_decoded = pf_decode(p_descriptor);
+            }
+            if (p_decoded)
+                serialize_decoded(p_serializer, p_dr, p_decoded);
+        }
+        serialize_end(p_serializer, false);
+    }
+    serialize_end(p_serializer, true);
+}
+
+/*****************************************************************************
+ * dvbpsi_serialize_pat
+ *****************************************************************************/
+bool dvbpsi_serialize_pat(dvbpsi_serializer_t *p_serializer, const dvbpsi_pat_t *p_pat)
+{
+    size_t i_length = serialize_table_begin(p_serializer, "PAT", 0x00);
+    serialize_uint(p_serializer, "transport_stream_id", p_pat->i_ts_id);
+    serialize_uint(p_serializer, "version_number", p_pat->i_version);
+    serialize_bool(p_serializer, "current_next_indicator", p_pat->b_current_next);
+
+    serialize_begin(p_serializer, "programs", true);
+    for (const dvbpsi_pat_program_t *p_program = p_pat->p_first_program; p_program;
+         p_program = p_program->p_next)
+    {
+        serialize_begin(p_serializer, NULL, false);
+        serialize_uint(p_serializer, "program_number", p_program->i_number);
+        serialize_uint(p_serializer, "pid", p_program->i_pid);
+        serialize_end(p_serializer, false);
+    }
+    serialize_end(p_serializer, true);
+    return serialize_table_end(p_serializer, i_length);
+}
+
+/*****************************************************************************
+ * dvbpsi_serialize_pmt
+ *****************************************************************************/
+bool dvbpsi_serialize_pmt(dvbpsi_serializer_t *p_serializer, dvbpsi_pmt_t *p_pmt)
+{
+    size_t i_length = serialize_table_begin(p_serializer, "PMT", 0x02);
+    serialize_uint(p_serializer, "program_number", p_pmt->i_program_number);
+    serialize_uint(p_serializer, "version_number", p_pmt->i_version);
+    serialize_bool(p_serializer, "current_next_indicator", p_pmt->b_current_next);
+    serialize_uint(p_serializer, "pcr_pid", p_pmt->i_pcr_pid);
+    serialize_descriptors(p_serializer, p_pmt->p_first_descriptor,
+                          DVBPSI_DESCRIPTOR_CONTEXT_DVB);
+
+    serialize_begin(p_serializer, "streams", true);
+    for (dvbpsi_pmt_es_t *p_es = p_pmt->p_first_es; p_es; p_es = p_es->p_next)
+    {
+        serialize_begin(p_serializer, NULL, false);
+        serialize_uint(p_serializer, "stream_type", p_es->i_type);
+        serialize_uint(p_serializer, "elementary_pid", p_es->i_pid);
+        serialize_descriptors(p_serializer, p_es->p_first_descriptor,
+                              DVBPSI_DESCRIPTOR_CONTEXT_DVB);
+        serialize_end(p_serializer, false);
+    }
+    serialize_end(p_serializer, true);
+    return serialize_table_end(p_serializer, i_length);
+}
+
+/*****************************************************************************
+ * dvbpsi_serialize_cat
+ *****************************************************************************/
+bool dvbpsi_serialize_cat(dvbpsi_serializer_t *p_serializer, dvbpsi_cat_t *p_cat)
+{
+    size_t i_length = serialize_table_begin(p_serializer, "CAT", 0x01);
+    serialize_uint(p_serializer, "version_number", p_cat->i_version);
+    serialize_bool(p_serializer, "current_next_indicator", p_cat->b_current_next);
+    serialize_descriptors(p_serializer, p_cat->p_first_descriptor,
+                          DVBPSI_DESCRIPTOR_CONTEXT_DVB);
+    return serialize_table_end(p_serializer, i_length);
+}
+
+/*****************************************************************************
+ * serialize_transport_stream
+ *****************************************************************************
+ * Transport stream loop entry of a NIT or a BAT.
+ *****************************************************************************/
+static void serialize_transport_stream(dvbpsi_serializer_t *p_serializer, uint16_t i_ts_id,
+                                       uint16_t i_orig_network_id,
+                                       dvbpsi_descriptor_t *p_descriptors)
+{
+    serialize_begin(p_serializer, NULL, false);
+    serialize_uint(p_serializer, "transport_stream_id", i_ts_id);
+    serialize_uint(p_serializer, "original_network_id", i_orig_network_id);
+    serialize_descriptors(p_serializer, p_descriptors, DVBPSI_DESCRIPTOR_CONTEXT_DVB);
+    serialize_end(p_serializer, false);
+}
+
+/*****************************************************************************
+ * dvbpsi_serialize_nit
+ *****************************************************************************/
+bool dvbpsi_serialize_nit(dvbpsi_serializer_t *p_serializer, dvbpsi_nit_t *p_nit)
+{
+    size_t i_length = serialize_table_begin(p_serializer, "NIT", p_nit->i_table_id);
+    serialize_uint(p_serializer, "network_id", p_nit->i_network_id);
+    serialize_uint(p_serializer, "version_number", p_nit->i_version);
+    serialize_bool(p_serializer, "current_next_indicator", p_nit->b_current_next);
+    serialize_descriptors(p_serializer, p_nit->p_first_descriptor,
+                          DVBPSI_DESCRIPTOR_CONTEXT_DVB);
+
+    serialize_begin(p_serializer, "transport_streams", true);
+    for (dvbpsi_nit_ts_t *p_ts = p_nit->p_first_ts; p_ts; p_ts = p_ts->p_next)
+        serialize_transport_stream(p_serializer, p_ts->i_ts_id, p_ts->i_orig_network_id,
+                                   p_ts->p_first_descriptor);
+    serialize_end(p_serializer, true);
+    return serialize_table_end(p_serializer, i_length);
+}
+
+/*****************************************************************************
+ * dvbpsi_serialize_sdt
+ *****************************************************************************/
+bool dvbpsi_serialize_sdt(dvbpsi_serializer_t *p_serializer, dvbpsi_sdt_t *p_sdt)
+{
+    size_t i_length = serialize_table_begin(p_serializer, "SDT", p_sdt->i_table_id);
+    serialize_uint(p_serializer, "transport_stream_id", p_sdt->i_extension);
+    serialize_uint(p_serializer, "version_number", p_sdt->i_version);
+    serialize_bool(p_serializer, "current_next_indicator", p_sdt->b_current_next);
+    serialize_uint(p_serializer, "original_network_id", p_sdt->i_network_id);
+
+    serialize_begin(p_serializer, "services", true);
+    for (dvbpsi_sdt_service_t *p_service = p_sdt->p_first_service; p_service;
+         p_service = p_service->p_next)
+    {
+        serialize_begin(p_serializer, NULL, false);
+        serialize_uint(p_serializer, "service_id", p_service->i_service_id);
+        serialize_bool(p_serializer, "eit_schedule_flag", p_service->b_eit_schedule);
+        serialize_bool(p_serializer, "eit_present_following_flag", p_service->b_eit_present);
+        serialize_uint(p_serializer, "running_status", p_service->i_running_status);
+        serialize_bool(p_serializer, "free_ca_mode", p_service->b_free_ca);
+        serialize_descriptors(p_serializer, p_service->p_first_descriptor,
+                              DVBPSI_DESCRIPTOR_CONTEXT_DVB);
+        serialize_end(p_serializer, false);
+    }
+    serialize_end(p_serializer, true);
+    return serialize_table_end(p_serializer, i_length);
+}
+
+/*****************************************************************************
+ * dvbpsi_serialize_bat
+ *****************************************************************************/
+bool dvbpsi_serialize_bat(dvbpsi_serializer_t *p_serializer, dvbpsi_bat_t *p_bat)
+{
+    size_t i_length = serialize_table_begin(p_serializer, "BAT", p_bat->i_table_id);
+    serialize_uint(p_serializer, "bouquet_id", p_bat->i_extension);
+    serialize_uint(p_serializer, "version_number", p_bat->i_version);
+    serialize_bool(p_serializer, "current_next_indicator", p_bat->b_current_next);
+    serialize_descriptors(p_serializer, p_bat->p_first_descriptor,
+                          DVBPSI_DESCRIPTOR_CONTEXT_DVB);
+
+    serialize_begin(p_serializer, "transport_streams", true);
+    for (dvbpsi_bat_ts_t *p_ts = p_bat->p_first_ts; p_ts; p_ts = p_ts->p_next)
+        serialize_transport_stream(p_serializer, p_ts->i_ts_id, p_ts->i_orig_network_id,
+                                   p_ts->p_first_descriptor);
+    serialize_end(p_serializer, true);
+    return serialize_table_end(p_serializer, i_length);
+}
+
+/*****************************************************************************
+ * dvbpsi_serialize_eit
+ *****************************************************************************/
+bool dvbpsi_serialize_eit(dvbpsi_serializer_t *p_serializer, dvbpsi_eit_t *p_eit)
+{
+    size_t i_length = serialize_table_begin(p_serializer, "EIT", p_eit->i_table_id);
+    serialize_uint(p_serializer, "service_id", p_eit->i_extension);
+    serialize_uint(p_serializer, "version_number", p_eit->i_version);
+    serialize_bool(p_serializer, "current_next_indicator", p_eit->b_current_next);
+    serialize_uint(p_serializer, "transport_stream_id", p_eit->i_ts_id);
+    serialize_uint(p_serializer, "original_network_id", p_eit->i_network_id);
+    serialize_uint(p_serializer, "segment_last_section_number",
+                   p_eit->i_segment_last_section_number);
+    serialize_uint(p_serializer, "last_table_id", p_eit->i_last_table_id);
+
+    serialize_begin(p_serializer, "events", true);
+    for (dvbpsi_eit_event_t *p_event = p_eit->p_first_event; p_event;
+         p_event = p_event->p_next)
+    {
+        serialize_begin(p_serializer, NULL, false);
+        serialize_uint(p_serializer, "event_id", p_event->i_event_id);
+        /* NVOD reference events have no start time */
+        serialize_mjd(p_serializer, "start_time",
+                      p_event->b_nvod ? DVBPSI_MJD_UNDEFINED : p_event->i_start_time);
+        serialize_uint(p_serializer, "duration", dvbpsi_bcd_to_seconds(p_event->i_duration));
+        serialize_uint(p_serializer, "running_status", p_event->i_running_status);
+        serialize_bool(p_serializer, "free_ca_mode", p_event->b_free_ca);
+        serialize_descriptors(p_serializer, p_event->p_first_descriptor,
+                              DVBPSI_DESCRIPTOR_CONTEXT_DVB);
+        serialize_end(p_serializer, false);
+    }
+    serialize_end(p_serializer, true);
+    return serialize_table_end(p_serializer, i_length);
+}
+
+/*****************************************************************************
+ * dvbpsi_serialize_tot
+ *****************************************************************************/
+bool dvbpsi_serialize_tot(dvbpsi_serializer_t *p_serializer, dvbpsi_tot_t *p_tot)
+{
+    bool b_tot = p_tot->i_table_id == 0x73;
+    size_t i_length = serialize_table_begin(p_serializer, b_tot ? "TOT" : "TDT",
+                                            p_tot->i_table_id);
+    serialize_mjd(p_serializer, "utc_time", p_tot->i_utc_time);
+    if (b_tot)
+        serialize_descriptors(p_serializer, p_tot->p_first_descriptor,
+                              DVBPSI_DESCRIPTOR_CONTEXT_DVB);
+    return serialize_table_end(p_serializer, i_length);
+}
+
+/*****************************************************************************
+ * dvbpsi_serialize_rst
+ *****************************************************************************/
+bool dvbpsi_serialize_rst(dvbpsi_serializer_t *p_serializer, const dvbpsi_rst_t *p_rst)
+{
+    size_t i_length = serialize_table_begin(p_serializer, "RST", 0x71);
+
+    serialize_begin(p_serializer, "events", true);
+    for (const dvbpsi_rst_event_t *p_event = p_rst->p_first_event; p_event;
+         p_event = p_event->p_next)
+    {
+        serialize_begin(p_serializer, NULL, false);
+        serialize_uint(p_serializer, "transport_stream_id", p_event->i_ts_id);
+        serialize_uint(p_serializer, "original_network_id", p_event->i_orig_network_id);
+        serialize_uint(p_serializer, "service_id", p_event->i_service_id);
+        serialize_uint(p_serializer, "event_id", p_event->i_event_id);
+        serialize_uint(p_serializer, "running_status", p_event->i_running_status);
+        serialize_end(p_serializer, false);
+    }
+    serialize_end(p_serializer, true);
+    return serialize_table_end(p_serializer, i_length);
+}
+
+/*****************************************************************************
+ * dvbpsi_serialize_sis
+ *****************************************************************************/
+bool dvbpsi_serialize_sis(dvbpsi_serializer_t *p_serializer, const dvbpsi_sis_t *p_sis)
+{
+    size_t i_length = serialize_table_begin(p_serializer, "SIS", p_sis->i_table_id);
+    serialize_uint(p_serializer, "protocol_version", p_sis->i_protocol_version);
+    serialize_bool(p_serializer, "encrypted_packet", p_sis->b_encrypted_packet);
+    serialize_uint(p_serializer, "encryption_algorithm", p_sis->i_encryption_algorithm);
+    serialize_uint(p_serializer, "pts_adjustment", p_sis->i_pts_adjustment);
+    serialize_uint(p_serializer, "cw_index", p_sis->cw_index);
+    serialize_uint(p_serializer, "splice_command_length", p_sis->i_splice_command_length);
+    serialize_uint(p_serializer, "splice_command_type", p_sis->i_splice_command_type);
+    serialize_descriptors(p_serializer, p_sis->p_first_descriptor,
+                          DVBPSI_DESCRIPTOR_CONTEXT_MAX);
+    return serialize_table_end(p_serializer, i_length);
+}
+
+/*****************************************************************************
+ * dvbpsi_serialize_atsc_vct
+ *****************************************************************************/
+bool dvbpsi_serialize_atsc_vct(dvbpsi_serializer_t *p_serializer, dvbpsi_atsc_vct_t *p_vct)
+{
+    size_t i_length = serialize_table_begin(p_serializer, p_vct->b_cable_vct ? "CVCT" : "TVCT",
+                                            p_vct->i_table_id);
+    serialize_uint(p_serializer, "transport_stream_id", p_vct->i_extension);
+    serialize_uint(p_serializer, "version_number", p_vct->i_version);
+    serialize_bool(p_serializer, "current_next_indicator", p_vct->b_current_next);
+    serialize_uint(p_serializer, "protocol_version", p_vct->i_protocol);
+
+    serialize_begin(p_serializer, "channels", true);
+    for (dvbpsi_atsc_vct_channel_t *p_channel = p_vct->p_first_channel; p_channel;
+         p_channel = p_channel->p_next)
+    {
+        serialize_begin(p_serializer, NULL, false);
+        serialize_utf16(p_serializer, "short_name", p_channel->i_short_name,
+                        sizeof(p_channel->i_short_name) / 2);
+        serialize_uint(p_serializer, "major_channel_number", p_channel->i_major_number);
+        serialize_uint(p_serializer, "minor_channel_number", p_channel->i_minor_number);
+        serialize_uint(p_serializer, "modulation_mode", p_channel->i_modulation);
+        serialize_uint(p_serializer, "carrier_frequency", p_channel->i_carrier_freq);
+        serialize_uint(p_serializer, "channel_tsid", p_channel->i_channel_tsid);
+        serialize_uint(p_serializer, "program_number", p_channel->i_program_number);
+        serialize_uint(p_serializer, "etm_location", p_channel->i_etm_location);
+        serialize_bool(p_serializer, "access_controlled", p_channel->b_access_controlled);
+        serialize_bool(p_serializer, "hidden", p_channel->b_hidden);
+        if (p_vct->b_cable_vct)
+        {
+            serialize_bool(p_serializer, "path_select", p_channel->b_path_select);
+            serialize_bool(p_serializer, "out_of_band", p_channel->b_out_of_band);
+        }
+        serialize_bool(p_serializer, "hide_guide", p_channel->b_hide_guide);
+        serialize_uint(p_serializer, "service_type", p_channel->i_service_type);
+        serialize_uint(p_serializer, "source_id", p_channel->i_source_id);
+        serialize_descriptors(p_serializer, p_channel->p_first_descriptor,
+                              DVBPSI_DESCRIPTOR_CONTEXT_ATSC);
+        serialize_end(p_serializer, false);
+    }
+    serialize_end(p_serializer, true);
+    serialize_descriptors(p_serializer, p_vct->p_first_descriptor,
+                          DVBPSI_DESCRIPTOR_CONTEXT_ATSC);
+    return serialize_table_end(p_serializer, i_length);
+}
+
+/*****************************************************************************
+ * dvbpsi_serialize_atsc_mgt
+ *****************************************************************************/
+bool dvbpsi_serialize_atsc_mgt(dvbpsi_serializer_t *p_serializer, dvbpsi_atsc_mgt_t *p_mgt)
+{
+    size_t i_length = serialize_table_begin(p_serializer, "MGT", p_mgt->i_table_id);
+    serialize_uint(p_serializer, "version_number", p_mgt->i_version);
+    serialize_bool(p_serializer, "current_next_indicator", p_mgt->b_current_next);
+    serialize_uint(p_serializer, "table_id_extension", p_mgt->i_table_id_ext);
+    serialize_uint(p_serializer, "protocol_version", p_mgt->i_protocol);
+
+    serialize_begin(p_serializer, "tables", true);
+    for (dvbpsi_atsc_mgt_table_t *p_table = p_mgt->p_first_table; p_table;
+         p_table = p_table->p_next)
+    {
+        serialize_begin(p_serializer, NULL, false);
+        serialize_uint(p_serializer, "table_type", p_table->i_table_type);
+        serialize_uint(p_serializer, "table_type_pid", p_table->i_table_type_pid);
+        serialize_uint(p_serializer, "table_type_version_number", p_table->i_table_type_version);
+        serialize_uint(p_serializer, "number_bytes", p_table->i_number_bytes);
+        serialize_descriptors(p_serializer, p_table->p_first_descriptor,
+                              DVBPSI_DESCRIPTOR_CONTEXT_ATSC);
+        serialize_end(p_serializer, false);
+    }
+    serialize_end(p_serializer, true);
+    serialize_descriptors(p_serializer, p_mgt->p_first_descriptor,
+                          DVBPSI_DESCRIPTOR_CONTEXT_ATSC);
+    return serialize_table_end(p_serializer, i_length);
+}
+
+/*****************************************************************************
+ * dvbpsi_serialize_atsc_stt
+ *****************************************************************************/
+bool dvbpsi_serialize_atsc_stt(dvbpsi_serializer_t *p_serializer, dvbpsi_atsc_stt_t *p_stt)
+{
+    size_t i_length = serialize_table_begin(p_serializer, "STT", p_stt->i_table_id);
+    serialize_uint(p_serializer, "system_time", p_stt->i_system_time);
+    serialize_uint(p_serializer, "gps_utc_offset", p_stt->i_gps_utc_offset);
+    serialize_uint(p_serializer, "daylight_saving", p_stt->i_daylight_savings);
+    serialize_descriptors(p_serializer, p_stt->p_first_descriptor,
+                          DVBPSI_DESCRIPTOR_CONTEXT_ATSC);
+    return serialize_table_end(p_serializer, i_length);
+}
+
+/*****************************************************************************
+ * dvbpsi_serialize_atsc_eit
+ *****************************************************************************/
+bool dvbpsi_serialize_atsc_eit(dvbpsi_serializer_t *p_serializer, dvbpsi_atsc_eit_t *p_eit)
+{
+    size_t i_length = serialize_table_begin(p_serializer, "ATSC EIT", p_eit->i_table_id);
+    serialize_uint(p_serializer, "source_id", p_eit->i_source_id);
+    serialize_uint(p_serializer, "version_number", p_eit->i_version);
+    serialize_bool(p_serializer, "current_next_indicator", p_eit->b_current_next);
+    serialize_uint(p_serializer, "protocol_version", p_eit->i_protocol);
+
+    serialize_begin(p_serializer, "events", true);
+    for (dvbpsi_atsc_eit_event_t *p_event = p_eit->p_first_event; p_event;
+         p_event = p_event->p_next)
+    {
+        serialize_begin(p_serializer, NULL, false);
+        serialize_uint(p_serializer, "event_id", p_event->i_event_id);
+        serialize_uint(p_serializer, "start_time", p_event->i_start_time);
+        serialize_uint(p_serializer, "etm_location", p_event->i_etm_location);
+        serialize_uint(p_serializer, "length_in_seconds", p_event->i_length_seconds);
+        serialize_bytes(p_serializer, "title_text", p_event->i_title, p_event->i_title_length);
+        serialize_descriptors(p_serializer, p_event->p_first_descriptor,
+                              DVBPSI_DESCRIPTOR_CONTEXT_ATSC);
+        serialize_end(p_serializer, false);
+    }
+    serialize_end(p_serializer, true);
+    serialize_descriptors(p_serializer, p_eit->p_first_descriptor,
+                          DVBPSI_DESCRIPTOR_CONTEXT_ATSC);
+    return serialize_table_end(p_serializer, i_length);
+}
+
+/*****************************************************************************
+ * dvbpsi_serialize_atsc_ett
+ *****************************************************************************/
+bool dvbpsi_serialize_atsc_ett(dvbpsi_serializer_t *p_serializer, dvbpsi_atsc_ett_t *p_ett)
+{
+    size_t i_length = serialize_table_begin(p_serializer, "ETT", p_ett->i_table_id);
+    serialize_uint(p_serializer, "table_id_extension", p_ett->i_extension);
+    serialize_uint(p_serializer, "version_number", p_ett->i_version);
+    serialize_bool(p_serializer, "current_next_indicator", p_ett->b_current_next);
+    serialize_uint(p_serializer, "protocol_version", p_ett->i_protocol);
+    serialize_uint(p_serializer, "etm_id", p_ett->i_etm_id);
+    serialize_bytes(p_serializer, "extended_text_message",
+                    p_ett->p_etm_data, p_ett->p_etm_data ? p_ett->i_etm_length : 0);
+    serialize_descriptors(p_serializer, p_ett->p_first_descriptor,
+                          DVBPSI_DESCRIPTOR_CONTEXT_ATSC);
+    return serialize_table_end(p_serializer, i_length);
+}
@@ -0,0 +1,200 @@
+/*****************************************************************************
+ * serialize.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <serialize.h>
+ * \brief JSON and CBOR serialization of the decoded tables.
+ *
+ * A serializer writes decoded tables, one object per table, straight into
+ * a buffer of the application, grown through a callback when it is full.
+ * Nothing is allocated, so a serializer reset after each table writes any
+ * number of them without a memory allocation once its buffer is large
+ * enough.
+ *
+ * Every object has a "table" member naming the table and the members of the
+ * table, named after the fields of the standards. Times are in seconds since
+ * 1970-01-01 UTC for DVB and since 1980-01-06 for ATSC, durations in
+ * seconds. Each descriptor has its "tag", "length" and "data", as a
+ * hexadecimal string in JSON and a byte string in CBOR, with a "decoded"
+ * object for the most common tags. The descriptors are decoded in place
+ * for this, as their dvbpsi_Decode*Dr() function would, so they must be
+ * lists of libdvbpsi. DVB texts are converted to UTF-8, the ATSC multiple
+ * string structures are left as bytes.
+ *
+ * In JSON each table is a line, ended by a line feed. CBOR objects and
+ * arrays are of indefinite length, so the whole encoding is written in a
+ * single pass.
+ */
+
+#ifndef _DVBPSI_SERIALIZE_H_
+#define _DVBPSI_SERIALIZE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_serializer_format_t
+ *****************************************************************************/
+/*!
+ * \enum dvbpsi_serializer_format
+ * \brief Encodings of a serializer
+ */
+enum dvbpsi_serializer_format
+{
+    DVBPSI_SERIALIZER_JSON = 0,     /*!< JSON, RFC 8259, without white space */
+    DVBPSI_SERIALIZER_CBOR,         /*!< CBOR, RFC 8949 */
+};
+/*!
+ * \typedef enum dvbpsi_serializer_format dvbpsi_serializer_format_t
+ * \brief dvbpsi_serializer_format_t type definition.
+ */
+typedef enum dvbpsi_serializer_format dvbpsi_serializer_format_t;
+
+/*****************************************************************************
+ * dvbpsi_serializer_grow_cb
+ *****************************************************************************/
+/*!
+ * \typedef uint8_t *(* dvbpsi_serializer_grow_cb)(void *p_cb_data,
+ *                                                 uint8_t *p_buffer,
+ *                                                 size_t i_size)
+ * \brief Callback type definition, gives a buffer of at least i_size bytes
+ * starting with the content of p_buffer, as realloc() does, or NULL to stop
+ * the serialization.
+ */
+typedef uint8_t *(* dvbpsi_serializer_grow_cb)(void *p_cb_data, uint8_t *p_buffer,
+                                               size_t i_size);
+
+/*****************************************************************************
+ * dvbpsi_serializer_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_serializer_s
+ * \brief Serializer, see dvbpsi_serializer_init()
+ */
+/*!
+ * \typedef struct dvbpsi_serializer_s dvbpsi_serializer_t
+ * \brief dvbpsi_serializer_t type definition.
+ */
+typedef struct dvbpsi_serializer_s
+{
+    uint8_t *                   p_buffer;   /*!< the output */
+    size_t                      i_length;   /*!< length of the output */
+    size_t                      i_size;     /*!< size of the buffer */
+
+    dvbpsi_serializer_format_t  i_format;   /*!< private, encoding */
+    dvbpsi_serializer_grow_cb   pf_grow;    /*!< private, grows the buffer */
+    void *                      p_cb_data;  /*!< private, given to pf_grow */
+    bool                        b_full;     /*!< private, out of space */
+    bool                        b_key;      /*!< private, after a key */
+    unsigned int                i_depth;    /*!< private, nesting level */
+    uint64_t                    i_members;  /*!< private, bit set for each
+                                                 level with a member */
+} dvbpsi_serializer_t;
+
+/*****************************************************************************
+ * dvbpsi_serializer_init
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_serializer_init(dvbpsi_serializer_t *p_serializer,
+ *                                 dvbpsi_serializer_format_t i_format,
+ *                                 uint8_t *p_buffer, size_t i_size,
+ *                                 dvbpsi_serializer_grow_cb pf_grow,
+ *                                 void *p_cb_data)
+ * \brief Initializes a serializer
+ * \param p_serializer pointer to the serializer
+ * \param i_format encoding
+ * \param p_buffer buffer receiving the output, may be NULL with pf_grow
+ * \param i_size size of the buffer
+ * \param pf_grow callback growing the buffer, NULL for a fixed buffer
+ * \param p_cb_data private data given in argument to the callback
+ * \return nothing
+ */
+void dvbpsi_serializer_init(dvbpsi_serializer_t *p_serializer,
+                            dvbpsi_serializer_format_t i_format,
+                            uint8_t *p_buffer, size_t i_size,
+                            dvbpsi_serializer_grow_cb pf_grow, void *p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_serializer_reset
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_serializer_reset(dvbpsi_serializer_t *p_serializer)
+ * \brief Empties the output of a serializer, keeping its buffer
+ * \param p_serializer pointer to the serializer
+ * \return nothing
+ */
+void dvbpsi_serializer_reset(dvbpsi_serializer_t *p_serializer);
+
+/*****************************************************************************
+ * dvbpsi_serialize_*
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_serialize_pat(dvbpsi_serializer_t *p_serializer,
+ *                               const dvbpsi_pat_t *p_pat)
+ * \brief Appends a table to the output of a serializer
+ * \param p_serializer pointer to the serializer
+ * \param p_pat decoded table
+ * \return false when the buffer could not be grown, the output being then
+ * left as it was before the call.
+ *
+ * The other dvbpsi_serialize_*() functions do the same for their table,
+ * decoding its descriptors.
+ */
+bool dvbpsi_serialize_pat(dvbpsi_serializer_t *p_serializer, const dvbpsi_pat_t *p_pat);
+/*! \brief PMT, see dvbpsi_serialize_pat() */
+bool dvbpsi_serialize_pmt(dvbpsi_serializer_t *p_serializer, dvbpsi_pmt_t *p_pmt);
+/*! \brief CAT, see dvbpsi_serialize_pat() */
+bool dvbpsi_serialize_cat(dvbpsi_serializer_t *p_serializer, dvbpsi_cat_t *p_cat);
+/*! \brief NIT, see dvbpsi_serialize_pat() */
+bool dvbpsi_serialize_nit(dvbpsi_serializer_t *p_serializer, dvbpsi_nit_t *p_nit);
+/*! \brief SDT, see dvbpsi_serialize_pat() */
+bool dvbpsi_serialize_sdt(dvbpsi_serializer_t *p_serializer, dvbpsi_sdt_t *p_sdt);
+/*! \brief BAT, see dvbpsi_serialize_pat() */
+bool dvbpsi_serialize_bat(dvbpsi_serializer_t *p_serializer, dvbpsi_bat_t *p_bat);
+/*! \brief EIT, see dvbpsi_serialize_pat() */
+bool dvbpsi_serialize_eit(dvbpsi_serializer_t *p_serializer, dvbpsi_eit_t *p_eit);
+/*! \brief TDT or TOT, see dvbpsi_serialize_pat() */
+bool dvbpsi_serialize_tot(dvbpsi_serializer_t *p_serializer, dvbpsi_tot_t *p_tot);
+/*! \brief RST, see dvbpsi_serialize_pat() */
+bool dvbpsi_serialize_rst(dvbpsi_serializer_t *p_serializer, const dvbpsi_rst_t *p_rst);
+/*! \brief SCTE 35 splice information section, with its descriptors left
+ *  undecoded, see dvbpsi_serialize_pat() */
+bool dvbpsi_serialize_sis(dvbpsi_serializer_t *p_serializer, const dvbpsi_sis_t *p_sis);
+/*! \brief ATSC VCT, see dvbpsi_serialize_pat() */
+bool dvbpsi_serialize_atsc_vct(dvbpsi_serializer_t *p_serializer, dvbpsi_atsc_vct_t *p_vct);
+/*! \brief ATSC MGT, see dvbpsi_serialize_pat() */
+bool dvbpsi_serialize_atsc_mgt(dvbpsi_serializer_t *p_serializer, dvbpsi_atsc_mgt_t *p_mgt);
+/*! \brief ATSC STT, see dvbpsi_serialize_pat() */
+bool dvbpsi_serialize_atsc_stt(dvbpsi_serializer_t *p_serializer, dvbpsi_atsc_stt_t *p_stt);
+/*! \brief ATSC EIT, see dvbpsi_serialize_pat() */
+bool dvbpsi_serialize_atsc_eit(dvbpsi_serializer_t *p_serializer, dvbpsi_atsc_eit_t *p_eit);
+/*! \brief ATSC ETT, see dvbpsi_serialize_pat() */
+bool dvbpsi_serialize_atsc_ett(dvbpsi_serializer_t *p_serializer, dvbpsi_atsc_ett_t *p_ett);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of serialize.h"
+#endif
@@ -0,0 +1,677 @@
+/*****************************************************************************
+ * shm.c: decoded tables published in shared memory
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "descriptor.h"
+#include "tables/pat.h"
+#include "tables/cat.h"
+#include "tables/pmt.h"
+#include "tables/nit.h"
+#include "tables/bat.h"
+#include "tables/sdt.h"
+#include "tables/eit.h"
+#include "tables/tot.h"
+#include "shm.h"
+
+/*****************************************************************************
+ * Atomics
+ *****************************************************************************
+ * A slot is a sequence lock per buffer: the version being written is
+ * stored before the table, the version published after it, a reader
+ * checking the first one after reading.
+ *****************************************************************************/
+#ifdef __ATOMIC_SEQ_CST
+#   define SHM_LOAD(p, order)       __atomic_load_n(p, __ATOMIC_##order)
+#   define SHM_STORE(p, v, order)   __atomic_store_n(p, v, __ATOMIC_##order)
+#   define SHM_FENCE(order)         __atomic_thread_fence(__ATOMIC_##order)
+#else
+#   define SHM_LOAD(p, order)       (__sync_synchronize(), *(volatile __typeof__(*(p)) *)(p))
+#   define SHM_STORE(p, v, order)   do { __sync_synchronize(); \
+                                         *(volatile __typeof__(*(p)) *)(p) = (v); \
+                                         __sync_synchronize(); } while (0)
+#   define SHM_FENCE(order)         __sync_synchronize()
+#endif
+
+/* A field of a table the publisher may be overwriting, read once */
+#define SHM_READ(x) (*(volatile const __typeof__(x) *)&(x))
+
+#define SHM_MAGIC 0x4d535644    /* "DVSM" in little endian */
+
+/*****************************************************************************
+ * dvbpsi_shm_s
+ *****************************************************************************
+ * Followed by the i_slots slots, then by two buffers of i_table_size bytes
+ * per slot, version v of a slot being in its buffer v & 1.
+ *****************************************************************************/
+struct dvbpsi_shm_s
+{
+    uint32_t    i_magic;        /* SHM_MAGIC once formatted */
+    uint32_t    i_slots;
+    uint64_t    i_table_size;
+    uint64_t    i_size;         /* of the region */
+    uint64_t    i_generation;   /* tables published */
+    uint32_t    i_count;        /* slots in use */
+    uint32_t    i_pending;      /* slot + 1 of dvbpsi_shm_reserve(), 0 for none */
+};
+
+typedef struct shm_slot_s
+{
+    uint64_t    i_key;          /* 1 << 40 | PID << 24 | table_id << 16 |
+                                   table_id_extension, 0 when free */
+    uint64_t    i_started;      /* version being or last written */
+    uint64_t    i_published;    /* version readable, 0 for none */
+} shm_slot_t;
+
+#define SHM_KEY(pid, table_id, extension) ((UINT64_C(1) << 40) | ((uint64_t)(pid) << 24) \
+                                           | ((uint64_t)(table_id) << 16) | (extension))
+
+/*****************************************************************************
+ * shm_slots, shm_buffer
+ *****************************************************************************/
+static shm_slot_t *shm_slots(const dvbpsi_shm_t *p_shm)
+{
+    return (shm_slot_t *)((uintptr_t)p_shm + sizeof(dvbpsi_shm_t));
+}
+
+static uint8_t *shm_buffer(const dvbpsi_shm_t *p_shm, unsigned int i_slot, uint64_t i_version)
+{
+    return (uint8_t *)(uintptr_t)p_shm + sizeof(dvbpsi_shm_t)
+         + (size_t)p_shm->i_slots * sizeof(shm_slot_t)
+         + ((size_t)i_slot * 2 + (i_version & 1)) * p_shm->i_table_size;
+}
+
+/*****************************************************************************
+ * dvbpsi_shm_size
+ *****************************************************************************/
+size_t dvbpsi_shm_size(unsigned int i_slots, size_t i_table_size)
+{
+    i_table_size = (i_table_size + 7) & ~(size_t)7;
+    if (i_slots == 0 || i_table_size == 0 || i_table_size > UINT32_MAX)
+        return 0;
+    size_t i_slot = sizeof(shm_slot_t) + 2 * i_table_size;
+    if (i_slots > (SIZE_MAX - sizeof(dvbpsi_shm_t)) / i_slot)
+        return 0;
+    return sizeof(dvbpsi_shm_t) + i_slots * i_slot;
+}
+
+/*****************************************************************************
+ * dvbpsi_shm_init
+ *****************************************************************************/
+dvbpsi_shm_t *dvbpsi_shm_init(void *p_region, unsigned int i_slots, size_t i_table_size)
+{
+    assert(p_region);
+    assert(((uintptr_t)p_region & 7) == 0);
+
+    size_t i_size = dvbpsi_shm_size(i_slots, i_table_size);
+    if (i_size == 0)
+        return NULL;
+
+    /* Readers of a previous format see it go before anything changes */
+    dvbpsi_shm_t *p_shm = p_region;
+    SHM_STORE(&p_shm->i_magic, 0, RELAXED);
+    SHM_FENCE(RELEASE);
+
+    p_shm->i_slots = i_slots;
+    p_shm->i_table_size = (i_table_size + 7) & ~(size_t)7;
+    p_shm->i_size = i_size;
+    p_shm->i_generation = 0;
+    p_shm->i_count = 0;
+    p_shm->i_pending = 0;
+    memset(shm_slots(p_shm), 0, i_slots * sizeof(shm_slot_t));
+
+    SHM_STORE(&p_shm->i_magic, SHM_MAGIC, RELEASE);
+    return p_shm;
+}
+
+/*****************************************************************************
+ * dvbpsi_shm_open
+ *****************************************************************************/
+const dvbpsi_shm_t *dvbpsi_shm_open(const void *p_region, size_t i_size)
+{
+    assert(p_region);
+
+    const dvbpsi_shm_t *p_shm = p_region;
+    if (i_size < sizeof(dvbpsi_shm_t)
+     || SHM_LOAD(&p_shm->i_magic, ACQUIRE) != SHM_MAGIC
+     || p_shm->i_size > i_size
+     || p_shm->i_size != dvbpsi_shm_size(p_shm->i_slots, p_shm->i_table_size))
+        return NULL;
+    return p_shm;
+}
+
+/*****************************************************************************
+ * dvbpsi_shm_reserve
+ *****************************************************************************/
+uint8_t *dvbpsi_shm_reserve(dvbpsi_shm_t *p_shm, uint16_t i_pid,
+                            uint8_t i_table_id, uint16_t i_extension,
+                            size_t *pi_size)
+{
+    assert(p_shm);
+    assert(pi_size);
+
+    shm_slot_t *p_slots = shm_slots(p_shm);
+    uint64_t i_key = SHM_KEY(i_pid, i_table_id, i_extension);
+    unsigned int i_slot;
+    for (i_slot = 0; i_slot < p_shm->i_count; i_slot++)
+        if (p_slots[i_slot].i_key == i_key)
+            break;
+
+    if (i_slot == p_shm->i_count)
+    {
+        if (i_slot == p_shm->i_slots)
+            return NULL;
+        SHM_STORE(&p_slots[i_slot].i_key, i_key, RELAXED);
+        SHM_STORE(&p_shm->i_count, i_slot + 1, RELEASE);
+    }
+
+    /* The buffer of the version before the last one, which readers of
+     * that version see being overwritten from here on. A version given up
+     * is written again, its buffer being lost anyway. */
+    shm_slot_t *p_slot = &p_slots[i_slot];
+    uint64_t i_version = p_slot->i_published + 1;
+    SHM_STORE(&p_slot->i_started, i_version, RELAXED);
+    SHM_FENCE(RELEASE);
+
+    p_shm->i_pending = i_slot + 1;
+    *pi_size = p_shm->i_table_size;
+    return shm_buffer(p_shm, i_slot, i_version);
+}
+
+/*****************************************************************************
+ * dvbpsi_shm_publish
+ *****************************************************************************/
+bool dvbpsi_shm_publish(dvbpsi_shm_t *p_shm, size_t i_length)
+{
+    assert(p_shm);
+    assert(p_shm->i_pending);
+
+    shm_slot_t *p_slot = &shm_slots(p_shm)[p_shm->i_pending - 1];
+    p_shm->i_pending = 0;
+    if (i_length == 0 || i_length > p_shm->i_table_size)
+        return false;
+
+    SHM_STORE(&p_slot->i_published, p_slot->i_started, RELEASE);
+    SHM_STORE(&p_shm->i_generation, p_shm->i_generation + 1, RELEASE);
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_shm_generation
+ *****************************************************************************/
+uint64_t dvbpsi_shm_generation(const dvbpsi_shm_t *p_shm)
+{
+    assert(p_shm);
+    return SHM_LOAD(&p_shm->i_generation, ACQUIRE);
+}
+
+/*****************************************************************************
+ * dvbpsi_shm_count
+ *****************************************************************************/
+unsigned int dvbpsi_shm_count(const dvbpsi_shm_t *p_shm)
+{
+    assert(p_shm);
+    return SHM_LOAD(&p_shm->i_count, ACQUIRE);
+}
+
+/*****************************************************************************
+ * dvbpsi_shm_slot
+ *****************************************************************************/
+const dvbpsi_flat_table_t *dvbpsi_shm_slot(const dvbpsi_shm_t *p_shm, unsigned int i_slot,
+                                           uint16_t *pi_pid, uint64_t *pi_version)
+{
+    assert(p_shm);
+    assert(pi_version);
+
+    if (i_slot >= dvbpsi_shm_count(p_shm))
+        return NULL;
+
+    const shm_slot_t *p_slot = &shm_slots(p_shm)[i_slot];
+    uint64_t i_version = SHM_LOAD(&p_slot->i_published, ACQUIRE);
+    if (i_version == 0)
+        return NULL;
+
+    if (pi_pid)
+        *pi_pid = (SHM_LOAD(&p_slot->i_key, RELAXED) >> 24) & 0xffff;
+    *pi_version = i_version;
+    return (const dvbpsi_flat_table_t *)shm_buffer(p_shm, i_slot, i_version);
+}
+
+/*****************************************************************************
+ * dvbpsi_shm_get
+ *****************************************************************************/
+const dvbpsi_flat_table_t *dvbpsi_shm_get(const dvbpsi_shm_t *p_shm, uint16_t i_pid,
+                                          uint8_t i_table_id, uint16_t i_extension,
+                                          uint64_t *pi_version)
+{
+    assert(p_shm);
+
+    const shm_slot_t *p_slots = shm_slots(p_shm);
+    uint64_t i_key = SHM_KEY(i_pid, i_table_id, i_extension);
+    unsigned int i_count = dvbpsi_shm_count(p_shm);
+    for (unsigned int i_slot = 0; i_slot < i_count; i_slot++)
+        if (SHM_LOAD(&p_slots[i_slot].i_key, RELAXED) == i_key)
+            return dvbpsi_shm_slot(p_shm, i_slot, NULL, pi_version);
+    return NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_shm_valid
+ *****************************************************************************/
+bool dvbpsi_shm_valid(const dvbpsi_shm_t *p_shm, const dvbpsi_flat_table_t *p_table,
+                      uint64_t i_version)
+{
+    assert(p_shm);
+    assert(p_table);
+
+    size_t i_offset = (const uint8_t *)p_table - shm_buffer(p_shm, 0, 0);
+    unsigned int i_slot = i_offset / (2 * p_shm->i_table_size);
+    assert(i_slot < p_shm->i_slots);
+
+    SHM_FENCE(ACQUIRE);
+    return SHM_LOAD(&shm_slots(p_shm)[i_slot].i_started, RELAXED) < i_version + 2;
+}
+
+/*****************************************************************************
+ * dvbpsi_flat_entries
+ *****************************************************************************/
+const void *dvbpsi_flat_entries(const dvbpsi_flat_table_t *p_table, unsigned int *pi_count)
+{
+    assert(p_table);
+    assert(pi_count);
+
+    uint32_t i_size = SHM_READ(p_table->i_size);
+    uint32_t i_entries = SHM_READ(p_table->i_entries);
+    uint32_t i_count = SHM_READ(p_table->i_entry_count);
+    uint8_t i_entry_size = SHM_READ(p_table->i_entry_size);
+
+    *pi_count = 0;
+    if (i_entries == 0 || i_entry_size == 0 || i_entries > i_size)
+        return NULL;
+    if (i_count > (i_size - i_entries) / i_entry_size)
+        i_count = (i_size - i_entries) / i_entry_size;
+    *pi_count = i_count;
+    return (const uint8_t *)p_table + i_entries;
+}
+
+/*****************************************************************************
+ * dvbpsi_flat_descriptors
+ *****************************************************************************/
+void dvbpsi_flat_descriptors(const dvbpsi_flat_table_t *p_table,
+                             const dvbpsi_flat_loop_t *p_loop,
+                             dvbpsi_descriptor_iter_t *p_iter)
+{
+    assert(p_table);
+    assert(p_loop);
+
+    uint32_t i_size = SHM_READ(p_table->i_size);
+    uint32_t i_offset = SHM_READ(p_loop->i_offset);
+    uint32_t i_length = SHM_READ(p_loop->i_length);
+    if (i_offset > i_size)
+        i_offset = i_length = 0;
+    else if (i_length > i_size - i_offset)
+        i_length = i_size - i_offset;
+
+    /* The iterator does not write through its pointers */
+    dvbpsi_descriptor_iter_init(p_iter, (uint8_t *)(uintptr_t)p_table + i_offset, i_length);
+}
+
+/*****************************************************************************
+ * shm_flat_t
+ *****************************************************************************
+ * Writes a flat table into a buffer, the header first, then the entries,
+ * then the descriptor loops.
+ *****************************************************************************/
+typedef struct shm_flat_s
+{
+    uint8_t    *p_buffer;
+    size_t      i_size;
+    size_t      i_length;
+} shm_flat_t;
+
+/*****************************************************************************
+ * shm_flat_begin
+ *****************************************************************************/
+static dvbpsi_flat_table_t *shm_flat_begin(shm_flat_t *p_flat, uint8_t *p_buffer, size_t i_size,
+                                           uint8_t i_table_id, size_t i_entry_size,
+                                           unsigned int i_count)
+{
+    assert(p_buffer);
+    assert(((uintptr_t)p_buffer & 7) == 0);
+
+    size_t i_entries = (sizeof(dvbpsi_flat_table_t) + 7) & ~(size_t)7;
+    if (i_size > UINT32_MAX)
+        i_size = UINT32_MAX;
+    if (i_entries > i_size
+     || (i_entry_size && i_count > (i_size - i_entries) / i_entry_size))
+        return NULL;
+
+    p_flat->p_buffer = p_buffer;
+    p_flat->i_size = i_size;
+    p_flat->i_length = i_entries + i_count * i_entry_size;
+    memset(p_buffer, 0, p_flat->i_length);
+
+    dvbpsi_flat_table_t *p_table = (dvbpsi_flat_table_t *)p_buffer;
+    p_table->i_magic = DVBPSI_FLAT_MAGIC;
+    p_table->i_table_id = i_table_id;
+    if (i_count)
+    {
+        p_table->i_entry_size = i_entry_size;
+        p_table->i_entries = i_entries;
+        p_table->i_entry_count = i_count;
+    }
+    return p_table;
+}
+
+/*****************************************************************************
+ * shm_flat_loop
+ *****************************************************************************/
+static bool shm_flat_loop(shm_flat_t *p_flat, dvbpsi_flat_loop_t *p_loop,
+                          const dvbpsi_descriptor_t *p_descriptor)
+{
+    size_t i_offset = p_flat->i_length;
+    for (; p_descriptor != NULL; p_descriptor = p_descriptor->p_next)
+    {
+        if (p_flat->i_size - p_flat->i_length < 2 + (size_t)p_descriptor->i_length)
+            return false;
+        uint8_t *p = p_flat->p_buffer + p_flat->i_length;
+        p[0] = p_descriptor->i_tag;
+        p[1] = p_descriptor->i_length;
+        memcpy(p + 2, p_descriptor->p_data, p_descriptor->i_length);
+        p_flat->i_length += 2 + p_descriptor->i_length;
+    }
+    if (p_flat->i_length > i_offset)
+    {
+        p_loop->i_offset = i_offset;
+        p_loop->i_length = p_flat->i_length - i_offset;
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * shm_flat_end
+ *****************************************************************************/
+static size_t shm_flat_end(shm_flat_t *p_flat)
+{
+    ((dvbpsi_flat_table_t *)p_flat->p_buffer)->i_size = p_flat->i_length;
+    return p_flat->i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_flatten_pat
+ *****************************************************************************/
+size_t dvbpsi_flatten_pat(uint8_t *p_buffer, size_t i_size, const dvbpsi_pat_t *p_pat)
+{
+    assert(p_pat);
+
+    unsigned int i_count = 0;
+    for (const dvbpsi_pat_program_t *p = p_pat->p_first_program; p; p = p->p_next)
+        i_count++;
+
+    shm_flat_t flat;
+    dvbpsi_flat_table_t *p_table = shm_flat_begin(&flat, p_buffer, i_size, 0x00,
+                                                  sizeof(dvbpsi_flat_pat_program_t), i_count);
+    if (!p_table)
+        return 0;
+    p_table->i_version = p_pat->i_version;
+    p_table->b_current_next = p_pat->b_current_next;
+    p_table->i_extension = p_pat->i_ts_id;
+
+    dvbpsi_flat_pat_program_t *p_entry = (dvbpsi_flat_pat_program_t *)(p_buffer + p_table->i_entries);
+    for (const dvbpsi_pat_program_t *p = p_pat->p_first_program; p; p = p->p_next, p_entry++)
+    {
+        p_entry->i_number = p->i_number;
+        p_entry->i_pid = p->i_pid;
+    }
+    return shm_flat_end(&flat);
+}
+
+/*****************************************************************************
+ * dvbpsi_flatten_cat
+ *****************************************************************************/
+size_t dvbpsi_flatten_cat(uint8_t *p_buffer, size_t i_size, const dvbpsi_cat_t *p_cat)
+{
+    assert(p_cat);
+
+    shm_flat_t flat;
+    dvbpsi_flat_table_t *p_table = shm_flat_begin(&flat, p_buffer, i_size, 0x01, 0, 0);
+    if (!p_table)
+        return 0;
+    p_table->i_version = p_cat->i_version;
+    p_table->b_current_next = p_cat->b_current_next;
+
+    if (!shm_flat_loop(&flat, &p_table->descriptors, p_cat->p_first_descriptor))
+        return 0;
+    return shm_flat_end(&flat);
+}
+
+/*****************************************************************************
+ * dvbpsi_flatten_pmt
+ *****************************************************************************/
+size_t dvbpsi_flatten_pmt(uint8_t *p_buffer, size_t i_size, const dvbpsi_pmt_t *p_pmt)
+{
+    assert(p_pmt);
+
+    unsigned int i_count = 0;
+    for (const dvbpsi_pmt_es_t *p = p_pmt->p_first_es; p; p = p->p_next)
+        i_count++;
+
+    shm_flat_t flat;
+    dvbpsi_flat_table_t *p_table = shm_flat_begin(&flat, p_buffer, i_size, 0x02,
+                                                  sizeof(dvbpsi_flat_pmt_es_t), i_count);
+    if (!p_table)
+        return 0;
+    p_table->i_version = p_pmt->i_version;
+    p_table->b_current_next = p_pmt->b_current_next;
+    p_table->i_extension = p_pmt->i_program_number;
+    p_table->i_pcr_pid = p_pmt->i_pcr_pid;
+    if (!shm_flat_loop(&flat, &p_table->descriptors, p_pmt->p_first_descriptor))
+        return 0;
+
+    dvbpsi_flat_pmt_es_t *p_entry = (dvbpsi_flat_pmt_es_t *)(p_buffer + p_table->i_entries);
+    for (const dvbpsi_pmt_es_t *p = p_pmt->p_first_es; p; p = p->p_next, p_entry++)
+    {
+        p_entry->i_type = p->i_type;
+        p_entry->i_pid = p->i_pid;
+        if (!shm_flat_loop(&flat, &p_entry->descriptors, p->p_first_descriptor))
+            return 0;
+    }
+    return shm_flat_end(&flat);
+}
+
+/*****************************************************************************
+ * dvbpsi_flatten_nit
+ *****************************************************************************/
+size_t dvbpsi_flatten_nit(uint8_t *p_buffer, size_t i_size, const dvbpsi_nit_t *p_nit)
+{
+    assert(p_nit);
+
+    unsigned int i_count = 0;
+    for (const dvbpsi_nit_ts_t *p = p_nit->p_first_ts; p; p = p->p_next)
+        i_count++;
+
+    shm_flat_t flat;
+    dvbpsi_flat_table_t *p_table = shm_flat_begin(&flat, p_buffer, i_size, p_nit->i_table_id,
+                                                  sizeof(dvbpsi_flat_ts_t), i_count);
+    if (!p_table)
+        return 0;
+    p_table->i_version = p_nit->i_version;
+    p_table->b_current_next = p_nit->b_current_next;
+    p_table->i_extension = p_nit->i_network_id;
+    if (!shm_flat_loop(&flat, &p_table->descriptors, p_nit->p_first_descriptor))
+        return 0;
+
+    dvbpsi_flat_ts_t *p_entry = (dvbpsi_flat_ts_t *)(p_buffer + p_table->i_entries);
+    for (const dvbpsi_nit_ts_t *p = p_nit->p_first_ts; p; p = p->p_next, p_entry++)
+    {
+        p_entry->i_ts_id = p->i_ts_id;
+        p_entry->i_orig_network_id = p->i_orig_network_id;
+        if (!shm_flat_loop(&flat, &p_entry->descriptors, p->p_first_descriptor))
+            return 0;
+    }
+    return shm_flat_end(&flat);
+}
+
+/*****************************************************************************
+ * dvbpsi_flatten_bat
+ *****************************************************************************/
+size_t dvbpsi_flatten_bat(uint8_t *p_buffer, size_t i_size, const dvbpsi_bat_t *p_bat)
+{
+    assert(p_bat);
+
+    unsigned int i_count = 0;
+    for (const dvbpsi_bat_ts_t *p = p_bat->p_first_ts; p; p = p->p_next)
+        i_count++;
+
+    shm_flat_t flat;
+    dvbpsi_flat_table_t *p_table = shm_flat_begin(&flat, p_buffer, i_size, p_bat->i_table_id,
+                                                  sizeof(dvbpsi_flat_ts_t), i_count);
+    if (!p_table)
+        return 0;
+    p_table->i_version = p_bat->i_version;
+    p_table->b_current_next = p_bat->b_current_next;
+    p_table->i_extension = p_bat->i_extension;
+    if (!shm_flat_loop(&flat, &p_table->descriptors, p_bat->p_first_descriptor))
+        return 0;
+
+    dvbpsi_flat_ts_t *p_entry = (dvbpsi_flat_ts_t *)(p_buffer + p_table->i_entries);
+    for (const dvbpsi_bat_ts_t *p = p_bat->p_first_ts; p; p = p->p_next, p_entry++)
+    {
+        p_entry->i_ts_id = p->i_ts_id;
+        p_entry->i_orig_network_id = p->i_orig_network_id;
+        if (!shm_flat_loop(&flat, &p_entry->descriptors, p->p_first_descriptor))
+            return 0;
+    }
+    return shm_flat_end(&flat);
+}
+
+/*****************************************************************************
+ * dvbpsi_flatten_sdt
+ *****************************************************************************/
+size_t dvbpsi_flatten_sdt(uint8_t *p_buffer, size_t i_size, const dvbpsi_sdt_t *p_sdt)
+{
+    assert(p_sdt);
+
+    unsigned int i_count = 0;
+    for (const dvbpsi_sdt_service_t *p = p_sdt->p_first_service; p; p = p->p_next)
+        i_count++;
+
+    shm_flat_t flat;
+    dvbpsi_flat_table_t *p_table = shm_flat_begin(&flat, p_buffer, i_size, p_sdt->i_table_id,
+                                                  sizeof(dvbpsi_flat_sdt_service_t), i_count);
+    if (!p_table)
+        return 0;
+    p_table->i_version = p_sdt->i_version;
+    p_table->b_current_next = p_sdt->b_current_next;
+    p_table->i_extension = p_sdt->i_extension;
+    p_table->i_network_id = p_sdt->i_network_id;
+
+    dvbpsi_flat_sdt_service_t *p_entry = (dvbpsi_flat_sdt_service_t *)(p_buffer + p_table->i_entries);
+    for (const dvbpsi_sdt_service_t *p = p_sdt->p_first_service; p; p = p->p_next, p_entry++)
+    {
+        p_entry->i_service_id = p->i_service_id;
+        p_entry->b_eit_schedule = p->b_eit_schedule;
+        p_entry->b_eit_present = p->b_eit_present;
+        p_entry->i_running_status = p->i_running_status;
+        p_entry->b_free_ca = p->b_free_ca;
+        if (!shm_flat_loop(&flat, &p_entry->descriptors, p->p_first_descriptor))
+            return 0;
+    }
+    return shm_flat_end(&flat);
+}
+
+/*****************************************************************************
+ * dvbpsi_flatten_eit
+ *****************************************************************************/
+size_t dvbpsi_flatten_eit(uint8_t *p_buffer, size_t i_size, const dvbpsi_eit_t *p_eit)
+{
+    assert(p_eit);
+
+    unsigned int i_count = 0;
+    for (const dvbpsi_eit_event_t *p = p_eit->p_first_event; p; p = p->p_next)
+        i_count++;
+
+    shm_flat_t flat;
+    dvbpsi_flat_table_t *p_table = shm_flat_begin(&flat, p_buffer, i_size, p_eit->i_table_id,
+                                                  sizeof(dvbpsi_flat_eit_event_t), i_count);
+    if (!p_table)
+        return 0;
+    p_table->i_version = p_eit->i_version;
+    p_table->b_current_next = p_eit->b_current_next;
+    p_table->i_extension = p_eit->i_extension;
+    p_table->i_ts_id = p_eit->i_ts_id;
+    p_table->i_network_id = p_eit->i_network_id;
+    p_table->i_segment_last_section_number = p_eit->i_segment_last_section_number;
+    p_table->i_last_table_id = p_eit->i_last_table_id;
+
+    dvbpsi_flat_eit_event_t *p_entry = (dvbpsi_flat_eit_event_t *)(p_buffer + p_table->i_entries);
+    for (const dvbpsi_eit_event_t *p = p_eit->p_first_event; p; p = p->p_next, p_entry++)
+    {
+        p_entry->i_start_time = p->i_start_time;
+        p_entry->i_duration = p->i_duration;
+        p_entry->i_event_id = p->i_event_id;
+        p_entry->i_running_status = p->i_running_status;
+        p_entry->b_free_ca = p->b_free_ca;
+        p_entry->b_nvod = p->b_nvod;
+        if (!shm_flat_loop(&flat, &p_entry->descriptors, p->p_first_descriptor))
+            return 0;
+    }
+    return shm_flat_end(&flat);
+}
+
+/*****************************************************************************
+ * dvbpsi_flatten_tot
+ *****************************************************************************/
+size_t dvbpsi_flatten_tot(uint8_t *p_buffer, size_t i_size, const dvbpsi_tot_t *p_tot)
+{
+    assert(p_tot);
+
+    shm_flat_t flat;
+    dvbpsi_flat_table_t *p_table = shm_flat_begin(&flat, p_buffer, i_size, p_tot->i_table_id, 0, 0);
+    if (!p_table)
+        return 0;
+    p_table->i_version = p_tot->i_version;
+    p_table->b_current_next = p_tot->b_current_next;
+    p_table->i_utc_time = p_tot->i_utc_time;
+
+    if (!shm_flat_loop(&flat, &p_table->descriptors, p_tot->p_first_descriptor))
+        return 0;
+    return shm_flat_end(&flat);
+}
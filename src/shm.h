@@ -0,0 +1,445 @@
+/*****************************************************************************
+ * shm.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <shm.h>
+ * \brief Decoded tables published in shared memory.
+ *
+ * A flat table is a decoded table laid out in one block of memory, the
+ * pointers of the C structures being replaced by offsets from the start of
+ * the block, so that it reads the same at any address. Its descriptor
+ * loops are kept as in the sections, to be walked with a
+ * dvbpsi_descriptor_iter_t. Values are in host byte order: a flat table is
+ * meant for the processes of one machine.
+ *
+ * A region is a block of memory shared by these processes, mapped by the
+ * application from a POSIX shared memory object or any other means, at any
+ * address in each process. One process, the publisher, formats it with
+ * dvbpsi_shm_init() and publishes flat tables into its slots, one slot per
+ * PID, table_id and table_id_extension, each holding two versions of the
+ * table. The other processes find the tables with dvbpsi_shm_get() and read
+ * them in place, without copying nor decoding, the publisher never
+ * waiting for them. A version stays valid until the publisher starts
+ * writing the version after the next one, which dvbpsi_shm_valid() tells:
+ * a reader checks it after reading, and reads again when it was
+ * overwritten.
+ */
+
+#ifndef _DVBPSI_SHM_H_
+#define _DVBPSI_SHM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \def DVBPSI_FLAT_MAGIC
+ * \brief i_magic of a flat table
+ */
+#define DVBPSI_FLAT_MAGIC 0x54465644    /* "DVFT" in little endian */
+
+/*****************************************************************************
+ * dvbpsi_flat_loop_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_flat_loop_s
+ * \brief Descriptor loop of a flat table, as found in the sections
+ */
+/*!
+ * \typedef struct dvbpsi_flat_loop_s dvbpsi_flat_loop_t
+ * \brief dvbpsi_flat_loop_t type definition.
+ */
+typedef struct dvbpsi_flat_loop_s
+{
+    uint32_t    i_offset;               /*!< first byte, 0 for an empty loop */
+    uint32_t    i_length;               /*!< length in bytes */
+} dvbpsi_flat_loop_t;
+
+/*****************************************************************************
+ * dvbpsi_flat_table_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_flat_table_s
+ * \brief Header of a flat table
+ *
+ * The fields a table does not have are 0. The entries follow the header in
+ * an array of i_entry_count entries of i_entry_size bytes, the
+ * dvbpsi_flat_*_t type of the table.
+ */
+/*!
+ * \typedef struct dvbpsi_flat_table_s dvbpsi_flat_table_t
+ * \brief dvbpsi_flat_table_t type definition.
+ */
+typedef struct dvbpsi_flat_table_s
+{
+    uint32_t            i_magic;        /*!< DVBPSI_FLAT_MAGIC */
+    uint32_t            i_size;         /*!< bytes of the flat table */
+    uint8_t             i_table_id;     /*!< table_id */
+    uint8_t             i_version;      /*!< version_number */
+    uint8_t             b_current_next; /*!< current_next_indicator */
+    uint8_t             i_last_table_id; /*!< last_table_id of the EIT */
+    uint16_t            i_extension;    /*!< table_id_extension: transport_stream_id
+                                             of the PAT and SDT, program_number,
+                                             network_id, bouquet_id, service_id */
+    uint16_t            i_pcr_pid;      /*!< PCR_PID of the PMT */
+    uint16_t            i_ts_id;        /*!< transport_stream_id of the EIT */
+    uint16_t            i_network_id;   /*!< original_network_id of the SDT
+                                             and EIT */
+    uint8_t             i_segment_last_section_number; /*!< of the EIT */
+    uint8_t             i_entry_size;   /*!< bytes of an entry */
+    uint16_t            i_reserved;     /*!< 0 */
+    uint64_t            i_utc_time;     /*!< UTC_time of the TDT and TOT, as in
+                                             dvbpsi_tot_t */
+    dvbpsi_flat_loop_t  descriptors;    /*!< descriptors of the CAT, PMT, NIT,
+                                             BAT and TOT */
+    uint32_t            i_entries;      /*!< offset of the entries */
+    uint32_t            i_entry_count;  /*!< number of entries */
+} dvbpsi_flat_table_t;
+
+/*!
+ * \struct dvbpsi_flat_pat_program_s
+ * \brief Entry of a flat PAT
+ */
+/*!
+ * \typedef struct dvbpsi_flat_pat_program_s dvbpsi_flat_pat_program_t
+ * \brief dvbpsi_flat_pat_program_t type definition.
+ */
+typedef struct dvbpsi_flat_pat_program_s
+{
+    uint16_t            i_number;       /*!< program_number */
+    uint16_t            i_pid;          /*!< PID of NIT/PMT */
+} dvbpsi_flat_pat_program_t;
+
+/*!
+ * \struct dvbpsi_flat_pmt_es_s
+ * \brief Entry of a flat PMT
+ */
+/*!
+ * \typedef struct dvbpsi_flat_pmt_es_s dvbpsi_flat_pmt_es_t
+ * \brief dvbpsi_flat_pmt_es_t type definition.
+ */
+typedef struct dvbpsi_flat_pmt_es_s
+{
+    uint8_t             i_type;         /*!< stream_type */
+    uint8_t             i_reserved;     /*!< 0 */
+    uint16_t            i_pid;          /*!< elementary_PID */
+    dvbpsi_flat_loop_t  descriptors;    /*!< descriptor loop */
+} dvbpsi_flat_pmt_es_t;
+
+/*!
+ * \struct dvbpsi_flat_ts_s
+ * \brief Entry of a flat NIT or BAT
+ */
+/*!
+ * \typedef struct dvbpsi_flat_ts_s dvbpsi_flat_ts_t
+ * \brief dvbpsi_flat_ts_t type definition.
+ */
+typedef struct dvbpsi_flat_ts_s
+{
+    uint16_t            i_ts_id;        /*!< transport_stream_id */
+    uint16_t            i_orig_network_id; /*!< original_network_id */
+    dvbpsi_flat_loop_t  descriptors;    /*!< descriptor loop */
+} dvbpsi_flat_ts_t;
+
+/*!
+ * \struct dvbpsi_flat_sdt_service_s
+ * \brief Entry of a flat SDT
+ */
+/*!
+ * \typedef struct dvbpsi_flat_sdt_service_s dvbpsi_flat_sdt_service_t
+ * \brief dvbpsi_flat_sdt_service_t type definition.
+ */
+typedef struct dvbpsi_flat_sdt_service_s
+{
+    uint16_t            i_service_id;   /*!< service_id */
+    uint8_t             b_eit_schedule; /*!< EIT schedule flag */
+    uint8_t             b_eit_present;  /*!< EIT present/following flag */
+    uint8_t             i_running_status; /*!< running_status */
+    uint8_t             b_free_ca;      /*!< free_CA_mode */
+    uint16_t            i_reserved;     /*!< 0 */
+    dvbpsi_flat_loop_t  descriptors;    /*!< descriptor loop */
+} dvbpsi_flat_sdt_service_t;
+
+/*!
+ * \struct dvbpsi_flat_eit_event_s
+ * \brief Entry of a flat EIT
+ */
+/*!
+ * \typedef struct dvbpsi_flat_eit_event_s dvbpsi_flat_eit_event_t
+ * \brief dvbpsi_flat_eit_event_t type definition.
+ */
+typedef struct dvbpsi_flat_eit_event_s
+{
+    uint64_t            i_start_time;   /*!< start_time, as in dvbpsi_eit_event_t */
+    dvbpsi_flat_loop_t  descriptors;    /*!< descriptor loop */
+    uint32_t            i_duration;     /*!< duration, as in dvbpsi_eit_event_t */
+    uint16_t            i_event_id;     /*!< event_id */
+    uint8_t             i_running_status; /*!< running_status */
+    uint8_t             b_free_ca;      /*!< free_CA_mode */
+    uint8_t             b_nvod;         /*!< unscheduled NVOD event */
+    uint8_t             i_reserved[7];  /*!< 0 */
+} dvbpsi_flat_eit_event_t;
+
+/*****************************************************************************
+ * dvbpsi_flatten_*
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_flatten_pat(uint8_t *p_buffer, size_t i_size,
+ *                               const dvbpsi_pat_t *p_pat)
+ * \brief Lays out a decoded table as a flat table
+ * \param p_buffer buffer receiving the flat table, aligned on 8 bytes
+ * \param i_size size of the buffer
+ * \param p_pat decoded table
+ * \return size of the flat table, 0 when the buffer is too small.
+ *
+ * The other dvbpsi_flatten_*() functions do the same for their table. The
+ * lists of a lazily decoded table are taken as they are.
+ */
+size_t dvbpsi_flatten_pat(uint8_t *p_buffer, size_t i_size, const dvbpsi_pat_t *p_pat);
+/*! \brief CAT, see dvbpsi_flatten_pat() */
+size_t dvbpsi_flatten_cat(uint8_t *p_buffer, size_t i_size, const dvbpsi_cat_t *p_cat);
+/*! \brief PMT, with dvbpsi_flat_pmt_es_t entries, see dvbpsi_flatten_pat() */
+size_t dvbpsi_flatten_pmt(uint8_t *p_buffer, size_t i_size, const dvbpsi_pmt_t *p_pmt);
+/*! \brief NIT, with dvbpsi_flat_ts_t entries, see dvbpsi_flatten_pat() */
+size_t dvbpsi_flatten_nit(uint8_t *p_buffer, size_t i_size, const dvbpsi_nit_t *p_nit);
+/*! \brief BAT, with dvbpsi_flat_ts_t entries, see dvbpsi_flatten_pat() */
+size_t dvbpsi_flatten_bat(uint8_t *p_buffer, size_t i_size, const dvbpsi_bat_t *p_bat);
+/*! \brief SDT, with dvbpsi_flat_sdt_service_t entries, see dvbpsi_flatten_pat() */
+size_t dvbpsi_flatten_sdt(uint8_t *p_buffer, size_t i_size, const dvbpsi_sdt_t *p_sdt);
+/*! \brief EIT, with dvbpsi_flat_eit_event_t entries, see dvbpsi_flatten_pat() */
+size_t dvbpsi_flatten_eit(uint8_t *p_buffer, size_t i_size, const dvbpsi_eit_t *p_eit);
+/*! \brief TDT or TOT, see dvbpsi_flatten_pat() */
+size_t dvbpsi_flatten_tot(uint8_t *p_buffer, size_t i_size, const dvbpsi_tot_t *p_tot);
+
+/*****************************************************************************
+ * dvbpsi_flat_entries
+ *****************************************************************************/
+/*!
+ * \fn const void *dvbpsi_flat_entries(const dvbpsi_flat_table_t *p_table,
+ *                                      unsigned int *pi_count)
+ * \brief Gives the entries of a flat table
+ * \param p_table flat table
+ * \param pi_count filled with the number of entries
+ * \return the first entry, NULL for none.
+ *
+ * Like dvbpsi_flat_descriptors(), the entries given are within the i_size
+ * bytes of the table, even when it is being overwritten.
+ */
+const void *dvbpsi_flat_entries(const dvbpsi_flat_table_t *p_table, unsigned int *pi_count);
+
+/*****************************************************************************
+ * dvbpsi_flat_descriptors
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_flat_descriptors(const dvbpsi_flat_table_t *p_table,
+ *                                  const dvbpsi_flat_loop_t *p_loop,
+ *                                  dvbpsi_descriptor_iter_t *p_iter)
+ * \brief Starts iterating over a descriptor loop of a flat table
+ * \param p_table flat table
+ * \param p_loop loop of the table or of one of its entries
+ * \param p_iter iterator, see dvbpsi_descriptor_iter_next()
+ * \return nothing.
+ *
+ * The iterator only reads the table, which may be mapped read-only, and
+ * stays within its i_size bytes: i_size never exceeds the table size of a
+ * region, a table being overwritten is still read within its slot.
+ */
+void dvbpsi_flat_descriptors(const dvbpsi_flat_table_t *p_table,
+                             const dvbpsi_flat_loop_t *p_loop,
+                             dvbpsi_descriptor_iter_t *p_iter);
+
+/*****************************************************************************
+ * dvbpsi_shm_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_shm_s dvbpsi_shm_t
+ * \brief dvbpsi_shm_t type definition, the header of a region.
+ */
+typedef struct dvbpsi_shm_s dvbpsi_shm_t;
+
+/*****************************************************************************
+ * dvbpsi_shm_size
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_shm_size(unsigned int i_slots, size_t i_table_size)
+ * \brief Gives the size of a region
+ * \param i_slots number of slots, the number of tables published at most
+ * \param i_table_size largest flat table, rounded up to 8 bytes
+ * \return the size in bytes of the memory to give to dvbpsi_shm_init().
+ */
+size_t dvbpsi_shm_size(unsigned int i_slots, size_t i_table_size);
+
+/*****************************************************************************
+ * dvbpsi_shm_init
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_shm_t *dvbpsi_shm_init(void *p_region, unsigned int i_slots,
+ *                                   size_t i_table_size)
+ * \brief Formats a region, on the side of the publisher
+ * \param p_region shared memory, aligned on 8 bytes, of
+ *        dvbpsi_shm_size(i_slots, i_table_size) bytes
+ * \param i_slots number of slots
+ * \param i_table_size largest flat table
+ * \return the region, NULL when i_slots or i_table_size is 0 or too large.
+ *
+ * Readers can open the region once dvbpsi_shm_init() returned. A region
+ * kept from a previous publisher is formatted again, its readers having to
+ * open it again.
+ */
+dvbpsi_shm_t *dvbpsi_shm_init(void *p_region, unsigned int i_slots, size_t i_table_size);
+
+/*****************************************************************************
+ * dvbpsi_shm_open
+ *****************************************************************************/
+/*!
+ * \fn const dvbpsi_shm_t *dvbpsi_shm_open(const void *p_region, size_t i_size)
+ * \brief Opens a region, on the side of a reader
+ * \param p_region shared memory, mapped at any address
+ * \param i_size size of the mapping
+ * \return the region, NULL when it is not formatted or larger than i_size.
+ */
+const dvbpsi_shm_t *dvbpsi_shm_open(const void *p_region, size_t i_size);
+
+/*****************************************************************************
+ * dvbpsi_shm_reserve
+ *****************************************************************************/
+/*!
+ * \fn uint8_t *dvbpsi_shm_reserve(dvbpsi_shm_t *p_shm, uint16_t i_pid,
+ *                                 uint8_t i_table_id, uint16_t i_extension,
+ *                                 size_t *pi_size)
+ * \brief Gives the buffer of the next version of a table
+ * \param p_shm region
+ * \param i_pid PID of the table
+ * \param i_table_id table_id
+ * \param i_extension table_id_extension, 0 for the tables without one
+ * \param pi_size filled with the size of the buffer
+ * \return the buffer, to lay the table out with a dvbpsi_flatten_*()
+ *         function before dvbpsi_shm_publish(), or NULL when all the slots
+ *         are taken by other tables.
+ *
+ * Only one process, and one thread, may publish into a region.
+ */
+uint8_t *dvbpsi_shm_reserve(dvbpsi_shm_t *p_shm, uint16_t i_pid,
+                            uint8_t i_table_id, uint16_t i_extension,
+                            size_t *pi_size);
+
+/*****************************************************************************
+ * dvbpsi_shm_publish
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_shm_publish(dvbpsi_shm_t *p_shm, size_t i_length)
+ * \brief Publishes the table written into the buffer of dvbpsi_shm_reserve()
+ * \param p_shm region
+ * \param i_length size of the flat table, 0 to give up, as when the table
+ *        did not fit
+ * \return true if the table was published.
+ */
+bool dvbpsi_shm_publish(dvbpsi_shm_t *p_shm, size_t i_length);
+
+/*****************************************************************************
+ * dvbpsi_shm_generation
+ *****************************************************************************/
+/*!
+ * \fn uint64_t dvbpsi_shm_generation(const dvbpsi_shm_t *p_shm)
+ * \brief Gives the number of tables published into a region
+ * \param p_shm region
+ * \return the number of publications, to poll for new tables cheaply.
+ */
+uint64_t dvbpsi_shm_generation(const dvbpsi_shm_t *p_shm);
+
+/*****************************************************************************
+ * dvbpsi_shm_count
+ *****************************************************************************/
+/*!
+ * \fn unsigned int dvbpsi_shm_count(const dvbpsi_shm_t *p_shm)
+ * \brief Gives the number of slots of a region in use
+ * \param p_shm region
+ * \return the number of slots, numbered from 0 in order of first
+ *         publication.
+ */
+unsigned int dvbpsi_shm_count(const dvbpsi_shm_t *p_shm);
+
+/*****************************************************************************
+ * dvbpsi_shm_slot
+ *****************************************************************************/
+/*!
+ * \fn const dvbpsi_flat_table_t *dvbpsi_shm_slot(const dvbpsi_shm_t *p_shm,
+ *                                                unsigned int i_slot,
+ *                                                uint16_t *pi_pid,
+ *                                                uint64_t *pi_version)
+ * \brief Gives the last table published into a slot
+ * \param p_shm region
+ * \param i_slot slot, below dvbpsi_shm_count()
+ * \param pi_pid filled with the PID of the table, may be NULL
+ * \param pi_version filled with the number of versions published into the
+ *        slot, to give to dvbpsi_shm_valid()
+ * \return the table, NULL when i_slot is not in use.
+ */
+const dvbpsi_flat_table_t *dvbpsi_shm_slot(const dvbpsi_shm_t *p_shm, unsigned int i_slot,
+                                           uint16_t *pi_pid, uint64_t *pi_version);
+
+/*****************************************************************************
+ * dvbpsi_shm_get
+ *****************************************************************************/
+/*!
+ * \fn const dvbpsi_flat_table_t *dvbpsi_shm_get(const dvbpsi_shm_t *p_shm,
+ *                                               uint16_t i_pid,
+ *                                               uint8_t i_table_id,
+ *                                               uint16_t i_extension,
+ *                                               uint64_t *pi_version)
+ * \brief Gives the last table published for a PID, table_id and
+ * table_id_extension
+ * \param p_shm region
+ * \param i_pid PID
+ * \param i_table_id table_id
+ * \param i_extension table_id_extension
+ * \param pi_version see dvbpsi_shm_slot()
+ * \return the table, NULL when none was published.
+ */
+const dvbpsi_flat_table_t *dvbpsi_shm_get(const dvbpsi_shm_t *p_shm, uint16_t i_pid,
+                                          uint8_t i_table_id, uint16_t i_extension,
+                                          uint64_t *pi_version);
+
+/*****************************************************************************
+ * dvbpsi_shm_valid
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_shm_valid(const dvbpsi_shm_t *p_shm,
+ *                           const dvbpsi_flat_table_t *p_table,
+ *                           uint64_t i_version)
+ * \brief Tells whether a table was left untouched by the publisher
+ * \param p_shm region
+ * \param p_table table given by dvbpsi_shm_slot() or dvbpsi_shm_get()
+ * \param i_version its version
+ * \return false when the publisher started overwriting the table: what was
+ *         read of it since it was given may be inconsistent.
+ */
+bool dvbpsi_shm_valid(const dvbpsi_shm_t *p_shm, const dvbpsi_flat_table_t *p_table,
+                      uint64_t i_version);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of shm.h"
+#endif
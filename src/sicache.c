@@ -0,0 +1,689 @@
+/*****************************************************************************
+ * sicache.c: decoded SI subtables shared between handles
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "descriptor.h"
+#include "demux.h"
+#include "snapshot.h"
+#include "tables/sdt.h"
+#include "tables/nit.h"
+#include "tables/bat.h"
+#include "tables/eit.h"
+#include "sicache.h"
+
+/*****************************************************************************
+ * dvbpsi_si_cache_entry_t
+ *****************************************************************************
+ * Decoded subtable, identified by its header and the section_number and
+ * CRC_32 of its sections.
+ *****************************************************************************/
+typedef struct dvbpsi_si_cache_entry_s
+{
+    struct dvbpsi_si_cache_entry_s *p_next;     /* same bucket */
+    struct dvbpsi_si_cache_entry_s *p_older;    /* less recently used */
+    struct dvbpsi_si_cache_entry_s *p_newer;    /* more recently used */
+    dvbpsi_snapshot_t *     p_snapshot;         /* reference of the cache */
+
+    uint32_t                i_hash;
+    uint8_t                 i_table_id;
+    uint16_t                i_extension;
+    uint8_t                 i_version;
+    bool                    b_current_next;
+    unsigned int            i_sections;
+    uint8_t                 pi_number[256];
+    uint32_t                pi_crc[256];
+} dvbpsi_si_cache_entry_t;
+
+struct dvbpsi_si_cache_s
+{
+    pthread_mutex_t         lock;
+    size_t                  i_max;
+    unsigned int            i_buckets;          /* power of 2 */
+    dvbpsi_si_cache_entry_t **pp_buckets;
+    dvbpsi_si_cache_entry_t *p_oldest;
+    dvbpsi_si_cache_entry_t *p_newest;
+    dvbpsi_si_cache_stats_t stats;
+};
+
+/*****************************************************************************
+ * dvbpsi_si_cache_decoder_t
+ *****************************************************************************
+ * Subtable decoder. An EIT subtable is complete when all the sections of
+ * each of its segments are received, up to the segment_last_section_number
+ * of the segment, the other ones when all the sections are.
+ *****************************************************************************/
+typedef struct dvbpsi_si_cache_decoder_s
+{
+    DVBPSI_DECODER_COMMON
+
+    dvbpsi_si_cache_t *     p_cache;
+    dvbpsi_si_cache_callback pf_callback;
+    void *                  p_cb_data;
+
+    uint8_t                 i_version;          /* of the current subtable */
+    bool                    b_current_next;
+
+    uint32_t                pi_segments[8];     /* segments with a section */
+    uint8_t                 pi_expected[32];    /* sections by segment */
+    uint8_t                 pi_received[32];
+} dvbpsi_si_cache_decoder_t;
+
+/*****************************************************************************
+ * dvbpsi_si_cache_new
+ *****************************************************************************/
+dvbpsi_si_cache_t *dvbpsi_si_cache_new(size_t i_max)
+{
+    if (i_max == 0)
+        return NULL;
+
+    dvbpsi_si_cache_t *p_cache = dvbpsi_calloc(1, sizeof(dvbpsi_si_cache_t));
+    if (p_cache == NULL)
+        return NULL;
+
+    p_cache->i_buckets = 64;
+    while (p_cache->i_buckets < i_max && p_cache->i_buckets < (1u << 20))
+        p_cache->i_buckets <<= 1;
+    p_cache->pp_buckets = dvbpsi_calloc(p_cache->i_buckets,
+                                        sizeof(dvbpsi_si_cache_entry_t *));
+    if (p_cache->pp_buckets == NULL)
+    {
+        dvbpsi_free(p_cache);
+        return NULL;
+    }
+    p_cache->i_max = i_max;
+
+    pthread_mutex_init(&p_cache->lock, NULL);
+    return p_cache;
+}
+
+/*****************************************************************************
+ * dvbpsi_si_cache_delete
+ *****************************************************************************/
+void dvbpsi_si_cache_delete(dvbpsi_si_cache_t *p_cache)
+{
+    if (p_cache == NULL)
+        return;
+
+    dvbpsi_si_cache_entry_t *p_entry = p_cache->p_oldest;
+    while (p_entry)
+    {
+        dvbpsi_si_cache_entry_t *p_newer = p_entry->p_newer;
+        dvbpsi_table_unref(p_entry->p_snapshot);
+        dvbpsi_free(p_entry);
+        p_entry = p_newer;
+    }
+
+    pthread_mutex_destroy(&p_cache->lock);
+    dvbpsi_free(p_cache->pp_buckets);
+    dvbpsi_free(p_cache);
+}
+
+/*****************************************************************************
+ * dvbpsi_si_cache_get_stats
+ *****************************************************************************/
+void dvbpsi_si_cache_get_stats(dvbpsi_si_cache_t *p_cache,
+                               dvbpsi_si_cache_stats_t *p_stats)
+{
+    assert(p_cache);
+    assert(p_stats);
+
+    pthread_mutex_lock(&p_cache->lock);
+    *p_stats = p_cache->stats;
+    pthread_mutex_unlock(&p_cache->lock);
+}
+
+/*****************************************************************************
+ * dvbpsi_si_cache_key
+ *****************************************************************************
+ * Fills the key of the complete subtable p_sections, with its FNV-1a hash.
+ *****************************************************************************/
+static void dvbpsi_si_cache_key(dvbpsi_si_cache_entry_t *p_key,
+                                const dvbpsi_psi_section_t *p_sections)
+{
+    p_key->i_table_id = p_sections->i_table_id;
+    p_key->i_extension = p_sections->i_extension;
+    p_key->i_version = p_sections->i_version;
+    p_key->b_current_next = p_sections->b_current_next;
+    p_key->i_sections = 0;
+
+    uint32_t i_hash = 2166136261u;
+#define SI_CACHE_HASH(b) i_hash = (i_hash ^ (uint8_t)(b)) * 16777619u
+    SI_CACHE_HASH(p_key->i_table_id);
+    SI_CACHE_HASH(p_key->i_extension >> 8);
+    SI_CACHE_HASH(p_key->i_extension);
+    SI_CACHE_HASH(p_key->i_version << 1 | p_key->b_current_next);
+    for (const dvbpsi_psi_section_t *p = p_sections; p; p = p->p_next)
+    {
+        const uint8_t *p_crc = p->p_payload_end;
+        p_key->pi_number[p_key->i_sections] = p->i_number;
+        p_key->pi_crc[p_key->i_sections] = ((uint32_t)p_crc[0] << 24)
+                                         | ((uint32_t)p_crc[1] << 16)
+                                         | ((uint32_t)p_crc[2] << 8) | p_crc[3];
+        p_key->i_sections++;
+        SI_CACHE_HASH(p->i_number);
+        for (int i = 0; i < 4; i++)
+            SI_CACHE_HASH(p_crc[i]);
+    }
+#undef SI_CACHE_HASH
+    p_key->i_hash = i_hash;
+}
+
+/*****************************************************************************
+ * dvbpsi_si_cache_match
+ *****************************************************************************/
+static bool dvbpsi_si_cache_match(const dvbpsi_si_cache_entry_t *p_entry,
+                                  const dvbpsi_si_cache_entry_t *p_key)
+{
+    return p_entry->i_hash == p_key->i_hash
+        && p_entry->i_table_id == p_key->i_table_id
+        && p_entry->i_extension == p_key->i_extension
+        && p_entry->i_version == p_key->i_version
+        && p_entry->b_current_next == p_key->b_current_next
+        && p_entry->i_sections == p_key->i_sections
+        && !memcmp(p_entry->pi_number, p_key->pi_number, p_key->i_sections)
+        && !memcmp(p_entry->pi_crc, p_key->pi_crc,
+                   p_key->i_sections * sizeof(uint32_t));
+}
+
+/*****************************************************************************
+ * dvbpsi_si_cache_unlink
+ *****************************************************************************
+ * Removes an entry from the recently used list.
+ *****************************************************************************/
+static void dvbpsi_si_cache_unlink(dvbpsi_si_cache_t *p_cache,
+                                   dvbpsi_si_cache_entry_t *p_entry)
+{
+    if (p_entry->p_older)
+        p_entry->p_older->p_newer = p_entry->p_newer;
+    else
+        p_cache->p_oldest = p_entry->p_newer;
+    if (p_entry->p_newer)
+        p_entry->p_newer->p_older = p_entry->p_older;
+    else
+        p_cache->p_newest = p_entry->p_older;
+    p_entry->p_older = p_entry->p_newer = NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_si_cache_use
+ *****************************************************************************
+ * Makes an entry the most recently used one.
+ *****************************************************************************/
+static void dvbpsi_si_cache_use(dvbpsi_si_cache_t *p_cache,
+                                dvbpsi_si_cache_entry_t *p_entry)
+{
+    if (p_cache->p_newest == p_entry)
+        return;
+
+    if (p_entry->p_older || p_entry->p_newer || p_cache->p_oldest == p_entry)
+        dvbpsi_si_cache_unlink(p_cache, p_entry);
+    p_entry->p_older = p_cache->p_newest;
+    if (p_cache->p_newest)
+        p_cache->p_newest->p_newer = p_entry;
+    else
+        p_cache->p_oldest = p_entry;
+    p_cache->p_newest = p_entry;
+}
+
+/*****************************************************************************
+ * dvbpsi_si_cache_find
+ *****************************************************************************
+ * Reference to the snapshot of the key, NULL if it is not in the cache.
+ * Called with the lock held.
+ *****************************************************************************/
+static dvbpsi_snapshot_t *dvbpsi_si_cache_find(dvbpsi_si_cache_t *p_cache,
+                                               const dvbpsi_si_cache_entry_t *p_key)
+{
+    dvbpsi_si_cache_entry_t *p_entry
+                = p_cache->pp_buckets[p_key->i_hash & (p_cache->i_buckets - 1)];
+    for (; p_entry; p_entry = p_entry->p_next)
+    {
+        if (dvbpsi_si_cache_match(p_entry, p_key))
+        {
+            dvbpsi_si_cache_use(p_cache, p_entry);
+            return dvbpsi_table_ref(p_entry->p_snapshot);
+        }
+    }
+    return NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_si_cache_evict
+ *****************************************************************************
+ * Drops the least recently used entry. Called with the lock held.
+ *****************************************************************************/
+static void dvbpsi_si_cache_evict(dvbpsi_si_cache_t *p_cache)
+{
+    dvbpsi_si_cache_entry_t *p_entry = p_cache->p_oldest;
+    assert(p_entry);
+
+    dvbpsi_si_cache_entry_t **pp_entry
+                = &p_cache->pp_buckets[p_entry->i_hash & (p_cache->i_buckets - 1)];
+    while (*pp_entry != p_entry)
+        pp_entry = &(*pp_entry)->p_next;
+    *pp_entry = p_entry->p_next;
+
+    dvbpsi_si_cache_unlink(p_cache, p_entry);
+    dvbpsi_table_unref(p_entry->p_snapshot);
+    dvbpsi_free(p_entry);
+    p_cache->stats.i_tables--;
+    p_cache->stats.i_evictions++;
+}
+
+/*****************************************************************************
+ * dvbpsi_si_cache_insert
+ *****************************************************************************
+ * Adds the snapshot of p_key, whose reference goes to the cache, and
+ * returns a reference to the snapshot of the key: another handle may have
+ * added its own meanwhile.
+ *****************************************************************************/
+static dvbpsi_snapshot_t *dvbpsi_si_cache_insert(dvbpsi_si_cache_t *p_cache,
+                                                 dvbpsi_si_cache_entry_t *p_key,
+                                                 dvbpsi_snapshot_t *p_snapshot)
+{
+    pthread_mutex_lock(&p_cache->lock);
+
+    dvbpsi_snapshot_t *p_found = dvbpsi_si_cache_find(p_cache, p_key);
+    if (p_found)
+    {
+        pthread_mutex_unlock(&p_cache->lock);
+        dvbpsi_table_unref(p_snapshot);
+        return p_found;
+    }
+
+    dvbpsi_si_cache_entry_t *p_entry = dvbpsi_malloc(sizeof(dvbpsi_si_cache_entry_t));
+    if (p_entry == NULL)
+    {
+        /* the subtable is only given to this decoder */
+        pthread_mutex_unlock(&p_cache->lock);
+        return p_snapshot;
+    }
+
+    if (p_cache->stats.i_tables >= p_cache->i_max)
+        dvbpsi_si_cache_evict(p_cache);
+
+    *p_entry = *p_key;
+    p_entry->p_snapshot = p_snapshot;
+    p_entry->p_older = p_entry->p_newer = NULL;
+    dvbpsi_si_cache_entry_t **pp_bucket
+                = &p_cache->pp_buckets[p_key->i_hash & (p_cache->i_buckets - 1)];
+    p_entry->p_next = *pp_bucket;
+    *pp_bucket = p_entry;
+    dvbpsi_si_cache_use(p_cache, p_entry);
+    p_cache->stats.i_tables++;
+
+    pthread_mutex_unlock(&p_cache->lock);
+    return dvbpsi_table_ref(p_snapshot);
+}
+
+/*****************************************************************************
+ * Deleters of the snapshots
+ *****************************************************************************/
+static void dvbpsi_si_cache_sdt_delete(void *p_table) { dvbpsi_sdt_delete(p_table); }
+static void dvbpsi_si_cache_nit_delete(void *p_table) { dvbpsi_nit_delete(p_table); }
+static void dvbpsi_si_cache_bat_delete(void *p_table) { dvbpsi_bat_delete(p_table); }
+static void dvbpsi_si_cache_eit_delete(void *p_table) { dvbpsi_eit_delete(p_table); }
+
+/*****************************************************************************
+ * dvbpsi_si_cache_decode
+ *****************************************************************************
+ * Snapshot of the complete subtable p_sections, whose sections it
+ * releases. NULL on error.
+ *****************************************************************************/
+static dvbpsi_snapshot_t *dvbpsi_si_cache_decode(dvbpsi_psi_section_t *p_sections)
+{
+    const uint8_t i_table_id = p_sections->i_table_id;
+    const uint16_t i_extension = p_sections->i_extension;
+    const uint8_t *p_payload = p_sections->p_payload_start;
+    void *p_table = NULL;
+    void (*pf_delete)(void *) = NULL;
+
+    if (i_table_id == 0x42 || i_table_id == 0x46)
+    {
+        dvbpsi_sdt_t *p_sdt = dvbpsi_sdt_new(i_table_id, i_extension,
+                                             p_sections->i_version,
+                                             p_sections->b_current_next,
+                                             ((uint16_t)p_payload[0] << 8) | p_payload[1]);
+        if (p_sdt)
+        {
+            p_sdt->p_sections = p_sections;
+            dvbpsi_sdt_decode(p_sdt);
+        }
+        p_table = p_sdt;
+        pf_delete = dvbpsi_si_cache_sdt_delete;
+    }
+    else if (i_table_id == 0x40 || i_table_id == 0x41)
+    {
+        dvbpsi_nit_t *p_nit = dvbpsi_nit_new(i_table_id, i_extension, i_extension,
+                                             p_sections->i_version,
+                                             p_sections->b_current_next);
+        if (p_nit)
+        {
+            p_nit->p_sections = p_sections;
+            dvbpsi_nit_decode(p_nit);
+        }
+        p_table = p_nit;
+        pf_delete = dvbpsi_si_cache_nit_delete;
+    }
+    else if (i_table_id == 0x4a)
+    {
+        dvbpsi_bat_t *p_bat = dvbpsi_bat_new(i_table_id, i_extension,
+                                             p_sections->i_version,
+                                             p_sections->b_current_next);
+        if (p_bat)
+        {
+            p_bat->p_sections = p_sections;
+            dvbpsi_bat_decode(p_bat);
+        }
+        p_table = p_bat;
+        pf_delete = dvbpsi_si_cache_bat_delete;
+    }
+    else
+    {
+        dvbpsi_eit_t *p_eit = dvbpsi_eit_new(i_table_id, i_extension,
+                                             p_sections->i_version,
+                                             p_sections->b_current_next,
+                                             ((uint16_t)p_payload[0] << 8) | p_payload[1],
+                                             ((uint16_t)p_payload[2] << 8) | p_payload[3],
+                                             p_payload[4], p_payload[5]);
+        if (p_eit)
+        {
+            p_eit->p_sections = p_sections;
+            dvbpsi_eit_decode(p_eit);
+        }
+        p_table = p_eit;
+        pf_delete = dvbpsi_si_cache_eit_delete;
+    }
+
+    if (p_table == NULL)
+    {
+        dvbpsi_DeletePSISections(p_sections);
+        return NULL;
+    }
+    return dvbpsi_snapshot_new(i_table_id, i_extension, p_table, pf_delete);
+}
+
+/*****************************************************************************
+ * dvbpsi_si_cache_reset
+ *****************************************************************************/
+static void dvbpsi_si_cache_reset(dvbpsi_si_cache_decoder_t *p_decoder, bool b_force)
+{
+    dvbpsi_decoder_reset(DVBPSI_DECODER(p_decoder), b_force);
+    memset(p_decoder->pi_segments, 0, sizeof(p_decoder->pi_segments));
+    memset(p_decoder->pi_expected, 0, sizeof(p_decoder->pi_expected));
+    memset(p_decoder->pi_received, 0, sizeof(p_decoder->pi_received));
+}
+
+/*****************************************************************************
+ * dvbpsi_si_cache_expect
+ *****************************************************************************
+ * Records the sections of the segment of p_section that are expected.
+ *****************************************************************************/
+static void dvbpsi_si_cache_expect(dvbpsi_si_cache_decoder_t *p_decoder,
+                                   const dvbpsi_psi_section_t *p_section)
+{
+    const uint8_t i_number = p_section->i_number;
+    const unsigned int i_segment = i_number / 8;
+    unsigned int i_segment_last;
+
+    if (p_section->i_table_id < 0x4e)
+    {
+        /* a single segment of all the sections */
+        for (unsigned int i = 0; i <= p_section->i_last_number / 8u; i++)
+        {
+            p_decoder->pi_segments[i / 32] |= UINT32_C(1) << (i % 32);
+            p_decoder->pi_expected[i] = 0xff;
+        }
+        i_segment_last = p_section->i_last_number;
+        p_decoder->pi_expected[i_segment_last / 8] = (2 << (i_segment_last % 8)) - 1;
+        return;
+    }
+
+    /* segment_last_section_number of another segment is wrong, then the
+     * segment ends with this section */
+    i_segment_last = p_section->p_payload_start[4];
+    if (i_segment_last / 8u != i_segment || i_segment_last < i_number)
+        i_segment_last = i_number;
+    p_decoder->pi_segments[i_segment / 32] |= UINT32_C(1) << (i_segment % 32);
+    p_decoder->pi_expected[i_segment] |= (2 << (i_segment_last % 8)) - 1;
+}
+
+/*****************************************************************************
+ * dvbpsi_si_cache_complete
+ *****************************************************************************/
+static bool dvbpsi_si_cache_complete(const dvbpsi_si_cache_decoder_t *p_decoder)
+{
+    for (unsigned int i = 0; i <= p_decoder->i_last_section_number / 8u; i++)
+    {
+        if (!(p_decoder->pi_segments[i / 32] & (UINT32_C(1) << (i % 32)))
+         || (p_decoder->pi_received[i] & p_decoder->pi_expected[i])
+                                                != p_decoder->pi_expected[i])
+            return false;
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_si_cache_gather
+ *****************************************************************************
+ * Callback for the demux.
+ *****************************************************************************/
+static void dvbpsi_si_cache_gather(dvbpsi_t *p_dvbpsi,
+                                   dvbpsi_decoder_t *p_private_decoder,
+                                   dvbpsi_psi_section_t *p_section)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    dvbpsi_demux_t *p_demux = (dvbpsi_demux_t *)p_dvbpsi->p_decoder;
+    dvbpsi_si_cache_decoder_t *p_decoder
+                        = (dvbpsi_si_cache_decoder_t *)p_private_decoder;
+
+    if (!dvbpsi_CheckPSISection(p_dvbpsi, p_section, p_section->i_table_id,
+                                "SI cache decoder")
+     || p_section->p_payload_end - p_section->p_payload_start
+                                < (p_section->i_table_id >= 0x4e ? 6 : 2))
+    {
+        dvbpsi_DeletePSISections(p_section);
+        return;
+    }
+
+    /* TS discontinuity check */
+    if (p_demux->b_discontinuity)
+    {
+        dvbpsi_si_cache_reset(p_decoder, true);
+        p_decoder->b_discontinuity = false;
+        p_demux->b_discontinuity = false;
+    }
+    else if (p_decoder->p_sections)
+    {
+        /* Another version, or a wrong section, starts over */
+        if (p_decoder->p_sections->i_version != p_section->i_version
+         || p_decoder->p_sections->b_current_next != p_section->b_current_next
+         || p_decoder->i_last_section_number != p_section->i_last_number)
+            dvbpsi_si_cache_reset(p_decoder, true);
+    }
+    else if (p_decoder->b_current_valid
+          && p_decoder->i_version == p_section->i_version
+          && p_decoder->b_current_next == p_section->b_current_next)
+    {
+        /* Don't decode since this version is already decoded */
+        p_dvbpsi->stats.i_dropped_duplicate++;
+        dvbpsi_DeletePSISections(p_section);
+        return;
+    }
+
+    p_decoder->i_last_section_number = p_section->i_last_number;
+    dvbpsi_si_cache_expect(p_decoder, p_section);
+    p_decoder->pi_received[p_section->i_number / 8] |= 1 << (p_section->i_number % 8);
+    dvbpsi_decoder_psi_section_add(DVBPSI_DECODER(p_decoder), p_section);
+
+    if (!dvbpsi_si_cache_complete(p_decoder))
+        return;
+
+    const uint8_t i_table_id = p_section->i_table_id;
+    const uint16_t i_extension = p_section->i_extension;
+    p_dvbpsi->stats.i_tables++;
+    p_decoder->b_current_valid = true;
+    p_decoder->i_version = p_decoder->p_sections->i_version;
+    p_decoder->b_current_next = p_decoder->p_sections->b_current_next;
+
+    /* The decoded subtable of another handle, or this one */
+    dvbpsi_si_cache_t *p_cache = p_decoder->p_cache;
+    dvbpsi_si_cache_entry_t *p_key = dvbpsi_malloc(sizeof(dvbpsi_si_cache_entry_t));
+    dvbpsi_snapshot_t *p_snapshot = NULL;
+    if (p_key)
+    {
+        dvbpsi_si_cache_key(p_key, p_decoder->p_sections);
+        pthread_mutex_lock(&p_cache->lock);
+        p_snapshot = dvbpsi_si_cache_find(p_cache, p_key);
+        if (p_snapshot)
+            p_cache->stats.i_hits++;
+        else
+            p_cache->stats.i_misses++;
+        pthread_mutex_unlock(&p_cache->lock);
+    }
+
+    if (p_snapshot == NULL)
+    {
+        dvbpsi_psi_section_t *p_sections = p_decoder->p_sections;
+        p_decoder->p_sections = NULL;
+        p_snapshot = dvbpsi_si_cache_decode(p_sections);
+        if (p_snapshot && p_key)
+            p_snapshot = dvbpsi_si_cache_insert(p_cache, p_key, p_snapshot);
+    }
+    dvbpsi_free(p_key);
+    dvbpsi_si_cache_reset(p_decoder, false);
+
+    if (p_snapshot == NULL)
+    {
+        dvbpsi_error(p_dvbpsi, "SI cache decoder", "failed decoding subtable "
+                     "(table_id == 0x%02x, extension == 0x%02x)",
+                     i_table_id, i_extension);
+        return;
+    }
+    p_decoder->pf_callback(p_decoder->p_cb_data, p_snapshot);
+}
+
+/*****************************************************************************
+ * dvbpsi_si_cache_attach
+ *****************************************************************************/
+bool dvbpsi_si_cache_attach(dvbpsi_t *p_dvbpsi, dvbpsi_si_cache_t *p_cache,
+                            uint8_t i_table_id, uint16_t i_extension,
+                            dvbpsi_si_cache_callback pf_callback, void *p_cb_data)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+    assert(p_cache);
+    assert(pf_callback);
+
+    dvbpsi_demux_t *p_demux = (dvbpsi_demux_t *)p_dvbpsi->p_decoder;
+
+    if (!(i_table_id == 0x40 || i_table_id == 0x41 || i_table_id == 0x42
+       || i_table_id == 0x46 || i_table_id == 0x4a
+       || (i_table_id >= 0x4e && i_table_id <= 0x6f)))
+    {
+        dvbpsi_error(p_dvbpsi, "SI cache decoder",
+                     "No SDT, NIT, BAT or EIT table_id (0x%02x)", i_table_id);
+        return false;
+    }
+
+    if (dvbpsi_demuxGetSubDec(p_demux, i_table_id, i_extension))
+    {
+        dvbpsi_error(p_dvbpsi, "SI cache decoder",
+                     "Already a decoder for (table_id == 0x%02x,"
+                     "extension == 0x%02x)",
+                     i_table_id, i_extension);
+        return false;
+    }
+
+    dvbpsi_si_cache_decoder_t *p_decoder;
+    p_decoder = (dvbpsi_si_cache_decoder_t *) dvbpsi_decoder_new(NULL,
+                                    0, true, sizeof(dvbpsi_si_cache_decoder_t));
+    if (p_decoder == NULL)
+        return false;
+
+    /* subtable decoder configuration */
+    dvbpsi_demux_subdec_t *p_subdec;
+    p_subdec = dvbpsi_NewDemuxSubDecoder(i_table_id, i_extension, dvbpsi_si_cache_detach,
+                                         dvbpsi_si_cache_gather, DVBPSI_DECODER(p_decoder));
+    if (p_subdec == NULL)
+    {
+        dvbpsi_decoder_delete(DVBPSI_DECODER(p_decoder));
+        return false;
+    }
+
+    /* Attach the subtable decoder to the demux */
+    dvbpsi_AttachDemuxSubDecoder(p_demux, p_subdec);
+
+    p_decoder->p_cache = p_cache;
+    p_decoder->pf_callback = pf_callback;
+    p_decoder->p_cb_data = p_cb_data;
+
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_si_cache_detach
+ *****************************************************************************/
+void dvbpsi_si_cache_detach(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                            uint16_t i_extension)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    dvbpsi_demux_t *p_demux = (dvbpsi_demux_t *)p_dvbpsi->p_decoder;
+
+    dvbpsi_demux_subdec_t *p_subdec;
+    p_subdec = dvbpsi_demuxGetSubDec(p_demux, i_table_id, i_extension);
+    if (p_subdec == NULL)
+    {
+        dvbpsi_error(p_dvbpsi, "SI cache decoder",
+                     "No such decoder (table_id == 0x%02x,"
+                     "extension == 0x%02x)",
+                     i_table_id, i_extension);
+        return;
+    }
+
+    /* Free sub table decoder */
+    dvbpsi_DetachDemuxSubDecoder(p_demux, p_subdec);
+    dvbpsi_DeleteDemuxSubDecoder(p_subdec);
+}
@@ -0,0 +1,178 @@
+/*****************************************************************************
+ * sicache.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <sicache.h>
+ * \brief Decoded SI subtables shared between handles.
+ *
+ * The SDT, NIT, BAT and EIT of the other transport streams of a network are
+ * often carried identically by all its transport streams. A cache shared by
+ * the handles of these streams decodes each subtable once: the subtable
+ * decoders attached with dvbpsi_si_cache_attach() identify a complete
+ * subtable by its table_id, table_id_extension, version_number and the
+ * section_number and CRC_32 of each of its sections, and get the decoded
+ * subtable from the cache when another handle already decoded it. The
+ * subtables are given as reference counted snapshots, see snapshot.h.
+ *
+ * Only built when POSIX threads are available.
+ */
+
+#ifndef _DVBPSI_SICACHE_H_
+#define _DVBPSI_SICACHE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_si_cache_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_si_cache_s dvbpsi_si_cache_t
+ * \brief dvbpsi_si_cache_t type definition, an opaque cache of subtables.
+ */
+typedef struct dvbpsi_si_cache_s dvbpsi_si_cache_t;
+
+/*****************************************************************************
+ * dvbpsi_si_cache_callback
+ *****************************************************************************/
+/*!
+ * \typedef void (* dvbpsi_si_cache_callback)(void *p_cb_data,
+ *                                            dvbpsi_snapshot_t *p_snapshot)
+ * \brief Callback type definition, called with a reference to the snapshot
+ * of a complete subtable, which it releases with dvbpsi_table_unref().
+ * The table of the snapshot, see dvbpsi_snapshot_table(), is the
+ * dvbpsi_sdt_t, dvbpsi_nit_t, dvbpsi_bat_t or dvbpsi_eit_t of its table_id
+ * and is not to be modified.
+ */
+typedef void (* dvbpsi_si_cache_callback)(void *p_cb_data,
+                                          dvbpsi_snapshot_t *p_snapshot);
+
+/*****************************************************************************
+ * dvbpsi_si_cache_stats_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_si_cache_stats_s
+ * \brief Counters of a cache.
+ */
+/*!
+ * \typedef struct dvbpsi_si_cache_stats_s dvbpsi_si_cache_stats_t
+ * \brief dvbpsi_si_cache_stats_t type definition.
+ */
+typedef struct dvbpsi_si_cache_stats_s
+{
+    uint64_t    i_hits;         /*!< subtables found decoded */
+    uint64_t    i_misses;       /*!< subtables decoded */
+    uint64_t    i_evictions;    /*!< subtables dropped as the cache was full */
+    size_t      i_tables;       /*!< subtables in the cache */
+} dvbpsi_si_cache_stats_t;
+
+/*****************************************************************************
+ * dvbpsi_si_cache_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_si_cache_t *dvbpsi_si_cache_new(size_t i_max)
+ * \brief Creates an empty cache
+ * \param i_max maximum number of subtables kept, the least recently used
+ *        one being dropped for a new one
+ * \return pointer to the cache, or NULL on error
+ */
+dvbpsi_si_cache_t *dvbpsi_si_cache_new(size_t i_max);
+
+/*****************************************************************************
+ * dvbpsi_si_cache_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_si_cache_delete(dvbpsi_si_cache_t *p_cache)
+ * \brief Deletes a cache and releases its snapshots
+ * \param p_cache pointer to the cache, whose decoders are all detached
+ * \return nothing
+ *
+ * The snapshots still referenced by the application stay valid.
+ */
+void dvbpsi_si_cache_delete(dvbpsi_si_cache_t *p_cache);
+
+/*****************************************************************************
+ * dvbpsi_si_cache_get_stats
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_si_cache_get_stats(dvbpsi_si_cache_t *p_cache,
+ *                                    dvbpsi_si_cache_stats_t *p_stats)
+ * \brief Gets the counters of a cache
+ * \param p_cache pointer to the cache
+ * \param p_stats receives the counters
+ * \return nothing
+ */
+void dvbpsi_si_cache_get_stats(dvbpsi_si_cache_t *p_cache,
+                               dvbpsi_si_cache_stats_t *p_stats);
+
+/*****************************************************************************
+ * dvbpsi_si_cache_attach
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_si_cache_attach(dvbpsi_t *p_dvbpsi, dvbpsi_si_cache_t *p_cache,
+ *                                 uint8_t i_table_id, uint16_t i_extension,
+ *                                 dvbpsi_si_cache_callback pf_callback,
+ *                                 void *p_cb_data)
+ * \brief Creates and initializes a subtable decoder sharing its subtables
+ *        through a cache, and attaches it to the demux of the handle
+ * \param p_dvbpsi pointer to the handle, with a demux attached
+ * \param p_cache pointer to the cache, which may be shared by several
+ *        handles used from different threads
+ * \param i_table_id table_id of a SDT (0x42, 0x46), NIT (0x40, 0x41),
+ *        BAT (0x4a) or EIT (0x4e to 0x6f)
+ * \param i_extension table_id_extension of the subtable
+ * \param pf_callback function called with each new version of the subtable
+ * \param p_cb_data private data given in argument to the callback
+ * \return true on success, false on failure
+ *
+ * It takes the place of dvbpsi_sdt_attach(), dvbpsi_nit_attach(),
+ * dvbpsi_bat_attach() or dvbpsi_eit_attach() in the demux callback. The
+ * subtables are decoded as by these decoders without flags: the handle
+ * flags do not apply to subtables that other handles may have decoded.
+ */
+bool dvbpsi_si_cache_attach(dvbpsi_t *p_dvbpsi, dvbpsi_si_cache_t *p_cache,
+                            uint8_t i_table_id, uint16_t i_extension,
+                            dvbpsi_si_cache_callback pf_callback, void *p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_si_cache_detach
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_si_cache_detach(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+ *                                 uint16_t i_extension)
+ * \brief Destroys a subtable decoder attached with dvbpsi_si_cache_attach()
+ * \param p_dvbpsi pointer to the handle
+ * \param i_table_id table_id of the subtable
+ * \param i_extension table_id_extension of the subtable
+ * \return nothing
+ */
+void dvbpsi_si_cache_detach(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                            uint16_t i_extension);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of sicache.h"
+#endif
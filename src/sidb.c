@@ -0,0 +1,1226 @@
+/*****************************************************************************
+ * sidb.c: service information database
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+
+
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "descriptor.h"
+#include "tables/pat.h"
+#include "tables/pmt.h"
+#include "tables/sdt.h"
+#include "tables/nit.h"
+#include "tables/bat.h"
+#include "sidb.h"
+
+/* Initial number of index buckets, doubled as services are added */
+#define DVBPSI_SIDB_INDEX_BITS 6
+
+/*****************************************************************************
+ * dvbpsi_sidb_entry_t
+ *****************************************************************************
+ * Service of the database, with what it owns of the tables.
+ *****************************************************************************/
+typedef struct dvbpsi_sidb_entry_s
+{
+    dvbpsi_sidb_service_t           service;
+
+    struct dvbpsi_sidb_entry_s *    p_next;         /* in the service index */
+    struct dvbpsi_sidb_entry_s *    p_lcn_next;     /* in the LCN index */
+
+    dvbpsi_pmt_t *                  p_pmt;
+    uint16_t *                      pi_bouquets;
+    unsigned int                    i_bouquets_size;
+    uint64_t *                      pi_bouquet_mask;
+    uint16_t                        i_lcn_network;  /* network_id of the NIT
+                                                       giving i_lcn */
+} dvbpsi_sidb_entry_t;
+
+/*****************************************************************************
+ * dvbpsi_sidb_edge_t
+ *****************************************************************************
+ * Linkage of a source, from a table kept by the database.
+ *****************************************************************************/
+typedef struct dvbpsi_sidb_edge_s
+{
+    dvbpsi_sidb_linkage_t           linkage;
+
+    uint64_t                        i_source;       /* dvbpsi_sidb_source() */
+    struct dvbpsi_sidb_edge_s *     p_next;         /* in the linkage index */
+} dvbpsi_sidb_edge_t;
+
+/*****************************************************************************
+ * dvbpsi_sidb_tables_t
+ *****************************************************************************
+ * Tables kept for a transport stream, a network or a bouquet.
+ *****************************************************************************/
+typedef struct dvbpsi_sidb_tables_s
+{
+    uint16_t                i_id;
+    dvbpsi_pat_t *          p_pat;
+    dvbpsi_sdt_t *          p_sdt;
+    dvbpsi_nit_t *          p_nit;
+    dvbpsi_bat_t *          p_bat;
+
+    dvbpsi_sidb_edge_t *    p_edges;        /* linkages of the SDT, NIT or
+                                               BAT */
+    size_t                  i_edges;
+
+    const dvbpsi_sidb_service_t ** pp_services; /* services of the BAT */
+    size_t                  i_services;
+} dvbpsi_sidb_tables_t;
+
+typedef struct dvbpsi_sidb_slots_s
+{
+    dvbpsi_sidb_tables_t *  p_tables;
+    size_t                  i_count;
+    size_t                  i_size;
+} dvbpsi_sidb_slots_t;
+
+struct dvbpsi_sidb_s
+{
+    dvbpsi_sidb_entry_t **  pp_index;       /* by transport_stream_id and
+                                               service_id */
+    dvbpsi_sidb_entry_t **  pp_lcn_index;   /* by logical_channel_number */
+    unsigned int            i_index_bits;
+    size_t                  i_entries;
+
+    dvbpsi_sidb_edge_t **   pp_linkage_index; /* by source */
+    unsigned int            i_linkage_bits;
+    size_t                  i_linkages;
+
+    dvbpsi_sidb_slots_t     streams;        /* PAT and SDT per ts_id */
+    dvbpsi_sidb_slots_t     networks;       /* NIT per network_id */
+    dvbpsi_sidb_slots_t     bouquets;       /* BAT per bouquet_id */
+};
+
+/* Steps of an update walking the services of a NIT or a BAT */
+typedef enum dvbpsi_sidb_step_e
+{
+    DVBPSI_SIDB_ALLOC,      /* create the services of the new table */
+    DVBPSI_SIDB_CLEAR,      /* unlink the services of the previous table */
+    DVBPSI_SIDB_SET,        /* link the services of the new table */
+    DVBPSI_SIDB_RELEASE,    /* delete the services left unused */
+} dvbpsi_sidb_step_t;
+
+/*****************************************************************************
+ * dvbpsi_sidb_bucket
+ *****************************************************************************
+ * Index bucket of a key.
+ *****************************************************************************/
+static inline unsigned int dvbpsi_sidb_bucket(const dvbpsi_sidb_t *p_sidb, uint32_t i_key)
+{
+    return (uint32_t)(i_key * UINT32_C(2654435761)) >> (32 - p_sidb->i_index_bits);
+}
+
+static inline uint32_t dvbpsi_sidb_key(uint16_t i_ts_id, uint16_t i_service_id)
+{
+    return ((uint32_t)i_ts_id << 16) | i_service_id;
+}
+
+static inline uint64_t dvbpsi_sidb_source(uint16_t i_network_id, uint16_t i_ts_id,
+                                          uint16_t i_service_id)
+{
+    return ((uint64_t)i_network_id << 32) | dvbpsi_sidb_key(i_ts_id, i_service_id);
+}
+
+static inline unsigned int dvbpsi_sidb_linkage_bucket(const dvbpsi_sidb_t *p_sidb,
+                                                      uint64_t i_source)
+{
+    return (uint32_t)((i_source * UINT64_C(0x9e3779b97f4a7c15)) >> 32)
+               >> (32 - p_sidb->i_linkage_bits);
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_new
+ *****************************************************************************/
+dvbpsi_sidb_t *dvbpsi_sidb_new(void)
+{
+    dvbpsi_sidb_t *p_sidb = dvbpsi_calloc(1, sizeof(dvbpsi_sidb_t));
+    if (p_sidb == NULL)
+        return NULL;
+
+    p_sidb->i_index_bits = DVBPSI_SIDB_INDEX_BITS;
+    p_sidb->pp_index = dvbpsi_calloc(1u << DVBPSI_SIDB_INDEX_BITS,
+                                     sizeof(dvbpsi_sidb_entry_t *));
+    p_sidb->pp_lcn_index = dvbpsi_calloc(1u << DVBPSI_SIDB_INDEX_BITS,
+                                         sizeof(dvbpsi_sidb_entry_t *));
+    p_sidb->i_linkage_bits = DVBPSI_SIDB_INDEX_BITS;
+    p_sidb->pp_linkage_index = dvbpsi_calloc(1u << DVBPSI_SIDB_INDEX_BITS,
+                                             sizeof(dvbpsi_sidb_edge_t *));
+    if (   p_sidb->pp_index == NULL || p_sidb->pp_lcn_index == NULL
+        || p_sidb->pp_linkage_index == NULL)
+    {
+        dvbpsi_sidb_delete(p_sidb);
+        return NULL;
+    }
+    return p_sidb;
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_slots_delete
+ *****************************************************************************/
+static void dvbpsi_sidb_slots_delete(dvbpsi_sidb_slots_t *p_slots)
+{
+    for (size_t i = 0; i < p_slots->i_count; i++)
+    {
+        dvbpsi_sidb_tables_t *p_tables = &p_slots->p_tables[i];
+        if (p_tables->p_pat)
+            dvbpsi_pat_delete(p_tables->p_pat);
+        if (p_tables->p_sdt)
+            dvbpsi_sdt_delete(p_tables->p_sdt);
+        if (p_tables->p_nit)
+            dvbpsi_nit_delete(p_tables->p_nit);
+        if (p_tables->p_bat)
+            dvbpsi_bat_delete(p_tables->p_bat);
+        dvbpsi_free(p_tables->p_edges);
+        dvbpsi_free(p_tables->pp_services);
+    }
+    dvbpsi_free(p_slots->p_tables);
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_delete
+ *****************************************************************************/
+void dvbpsi_sidb_delete(dvbpsi_sidb_t *p_sidb)
+{
+    if (p_sidb == NULL)
+        return;
+
+    if (p_sidb->pp_index)
+    {
+        for (unsigned int i = 0; i < (1u << p_sidb->i_index_bits); i++)
+        {
+            dvbpsi_sidb_entry_t *p_entry = p_sidb->pp_index[i];
+            while (p_entry)
+            {
+                dvbpsi_sidb_entry_t *p_next = p_entry->p_next;
+                if (p_entry->p_pmt)
+                    dvbpsi_pmt_delete(p_entry->p_pmt);
+                dvbpsi_free(p_entry->pi_bouquets);
+                dvbpsi_free(p_entry->pi_bouquet_mask);
+                dvbpsi_free(p_entry);
+                p_entry = p_next;
+            }
+        }
+    }
+    dvbpsi_free(p_sidb->pp_index);
+    dvbpsi_free(p_sidb->pp_lcn_index);
+    dvbpsi_free(p_sidb->pp_linkage_index);
+
+    dvbpsi_sidb_slots_delete(&p_sidb->streams);
+    dvbpsi_sidb_slots_delete(&p_sidb->networks);
+    dvbpsi_sidb_slots_delete(&p_sidb->bouquets);
+    dvbpsi_free(p_sidb);
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_slot
+ *****************************************************************************
+ * Tables of an id, added if b_create.
+ *****************************************************************************/
+static dvbpsi_sidb_tables_t *dvbpsi_sidb_slot(dvbpsi_sidb_slots_t *p_slots, uint16_t i_id,
+                                              bool b_create)
+{
+    for (size_t i = 0; i < p_slots->i_count; i++)
+        if (p_slots->p_tables[i].i_id == i_id)
+            return &p_slots->p_tables[i];
+
+    if (!b_create)
+        return NULL;
+
+    if (p_slots->i_count == p_slots->i_size)
+    {
+        size_t i_size = p_slots->i_size ? 2 * p_slots->i_size : 4;
+        dvbpsi_sidb_tables_t *p_tables = dvbpsi_calloc(i_size, sizeof(dvbpsi_sidb_tables_t));
+        if (p_tables == NULL)
+            return NULL;
+        if (p_slots->i_count)
+            memcpy(p_tables, p_slots->p_tables, p_slots->i_count * sizeof(dvbpsi_sidb_tables_t));
+        dvbpsi_free(p_slots->p_tables);
+        p_slots->p_tables = p_tables;
+        p_slots->i_size = i_size;
+    }
+
+    dvbpsi_sidb_tables_t *p_tables = &p_slots->p_tables[p_slots->i_count++];
+    memset(p_tables, 0, sizeof(*p_tables));
+    p_tables->i_id = i_id;
+    return p_tables;
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_index_grow
+ *****************************************************************************
+ * Doubles the indexes once there are more services than buckets. The
+ * indexes keep working with longer chains if this fails.
+ *****************************************************************************/
+static void dvbpsi_sidb_index_grow(dvbpsi_sidb_t *p_sidb)
+{
+    unsigned int i_old_size = 1u << p_sidb->i_index_bits;
+    if (p_sidb->i_entries <= i_old_size || p_sidb->i_index_bits >= 24)
+        return;
+
+    dvbpsi_sidb_entry_t **pp_index = dvbpsi_calloc(2 * i_old_size,
+                                                   sizeof(dvbpsi_sidb_entry_t *));
+    dvbpsi_sidb_entry_t **pp_lcn_index = dvbpsi_calloc(2 * i_old_size,
+                                                       sizeof(dvbpsi_sidb_entry_t *));
+    if (pp_index == NULL || pp_lcn_index == NULL)
+    {
+        dvbpsi_free(pp_index);
+        dvbpsi_free(pp_lcn_index);
+        return;
+    }
+
+    dvbpsi_sidb_entry_t **pp_old = p_sidb->pp_index;
+    dvbpsi_sidb_entry_t **pp_old_lcn = p_sidb->pp_lcn_index;
+    p_sidb->pp_index = pp_index;
+    p_sidb->pp_lcn_index = pp_lcn_index;
+    p_sidb->i_index_bits++;
+
+    for (unsigned int i = 0; i < i_old_size; i++)
+    {
+        dvbpsi_sidb_entry_t *p_entry = pp_old[i];
+        while (p_entry)
+        {
+            dvbpsi_sidb_entry_t *p_next = p_entry->p_next;
+            unsigned int i_bucket = dvbpsi_sidb_bucket(p_sidb,
+                    dvbpsi_sidb_key(p_entry->service.i_ts_id, p_entry->service.i_service_id));
+            p_entry->p_next = pp_index[i_bucket];
+            pp_index[i_bucket] = p_entry;
+            p_entry = p_next;
+        }
+
+        p_entry = pp_old_lcn[i];
+        while (p_entry)
+        {
+            dvbpsi_sidb_entry_t *p_next = p_entry->p_lcn_next;
+            unsigned int i_bucket = dvbpsi_sidb_bucket(p_sidb, p_entry->service.i_lcn);
+            p_entry->p_lcn_next = pp_lcn_index[i_bucket];
+            pp_lcn_index[i_bucket] = p_entry;
+            p_entry = p_next;
+        }
+    }
+    dvbpsi_free(pp_old);
+    dvbpsi_free(pp_old_lcn);
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_entry_find
+ *****************************************************************************/
+static dvbpsi_sidb_entry_t *dvbpsi_sidb_entry_find(const dvbpsi_sidb_t *p_sidb,
+                                                   uint16_t i_ts_id, uint16_t i_service_id)
+{
+    uint32_t i_key = dvbpsi_sidb_key(i_ts_id, i_service_id);
+    dvbpsi_sidb_entry_t *p_entry = p_sidb->pp_index[dvbpsi_sidb_bucket(p_sidb, i_key)];
+    while (p_entry && dvbpsi_sidb_key(p_entry->service.i_ts_id,
+                                      p_entry->service.i_service_id) != i_key)
+        p_entry = p_entry->p_next;
+    return p_entry;
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_entry_get
+ *****************************************************************************
+ * Service of the database, added if needed.
+ *****************************************************************************/
+static dvbpsi_sidb_entry_t *dvbpsi_sidb_entry_get(dvbpsi_sidb_t *p_sidb,
+                                                  uint16_t i_ts_id, uint16_t i_service_id)
+{
+    dvbpsi_sidb_entry_t *p_entry = dvbpsi_sidb_entry_find(p_sidb, i_ts_id, i_service_id);
+    if (p_entry)
+        return p_entry;
+
+    p_entry = dvbpsi_calloc(1, sizeof(dvbpsi_sidb_entry_t));
+    if (p_entry == NULL)
+        return NULL;
+    p_entry->service.i_ts_id = i_ts_id;
+    p_entry->service.i_service_id = i_service_id;
+
+    unsigned int i_bucket = dvbpsi_sidb_bucket(p_sidb, dvbpsi_sidb_key(i_ts_id, i_service_id));
+    p_entry->p_next = p_sidb->pp_index[i_bucket];
+    p_sidb->pp_index[i_bucket] = p_entry;
+    p_sidb->i_entries++;
+    dvbpsi_sidb_index_grow(p_sidb);
+    return p_entry;
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_entry_release
+ *****************************************************************************
+ * Deletes a service no table lists anymore.
+ *****************************************************************************/
+static void dvbpsi_sidb_entry_release(dvbpsi_sidb_t *p_sidb, dvbpsi_sidb_entry_t *p_entry)
+{
+    const dvbpsi_sidb_service_t *p_service = &p_entry->service;
+    if (   p_service->i_pmt_pid || p_service->p_pmt || p_service->p_sdt
+        || p_service->i_lcn || p_service->i_bouquets)
+        return;
+
+    dvbpsi_sidb_entry_t **pp_entry = &p_sidb->pp_index[dvbpsi_sidb_bucket(p_sidb,
+                    dvbpsi_sidb_key(p_service->i_ts_id, p_service->i_service_id))];
+    while (*pp_entry != p_entry)
+        pp_entry = &(*pp_entry)->p_next;
+    *pp_entry = p_entry->p_next;
+    p_sidb->i_entries--;
+
+    dvbpsi_free(p_entry->pi_bouquets);
+    dvbpsi_free(p_entry->pi_bouquet_mask);
+    dvbpsi_free(p_entry);
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_lcn_set
+ *****************************************************************************
+ * Moves a service to another logical_channel_number, 0 for none.
+ *****************************************************************************/
+static void dvbpsi_sidb_lcn_set(dvbpsi_sidb_t *p_sidb, dvbpsi_sidb_entry_t *p_entry,
+                                uint16_t i_lcn)
+{
+    if (p_entry->service.i_lcn)
+    {
+        dvbpsi_sidb_entry_t **pp_entry =
+                &p_sidb->pp_lcn_index[dvbpsi_sidb_bucket(p_sidb, p_entry->service.i_lcn)];
+        while (*pp_entry != p_entry)
+            pp_entry = &(*pp_entry)->p_lcn_next;
+        *pp_entry = p_entry->p_lcn_next;
+        p_entry->p_lcn_next = NULL;
+    }
+
+    p_entry->service.i_lcn = i_lcn;
+    if (i_lcn)
+    {
+        unsigned int i_bucket = dvbpsi_sidb_bucket(p_sidb, i_lcn);
+        p_entry->p_lcn_next = p_sidb->pp_lcn_index[i_bucket];
+        p_sidb->pp_lcn_index[i_bucket] = p_entry;
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_edges_add
+ *****************************************************************************
+ * Adds the linkage_descriptors, tag 0x4a, of a descriptor loop to p_edges,
+ * or only counts them if p_edges is NULL.
+ *****************************************************************************/
+static void dvbpsi_sidb_edges_add(dvbpsi_sidb_edge_t *p_edges, size_t *pi_edges,
+                                  uint8_t i_table_id, uint64_t i_source,
+                                  const dvbpsi_descriptor_t *p_dr)
+{
+    for (; p_dr; p_dr = p_dr->p_next)
+    {
+        if (p_dr->i_tag != 0x4a || p_dr->i_length < 7)
+            continue;
+
+        if (p_edges)
+        {
+            dvbpsi_sidb_edge_t *p_edge = &p_edges[*pi_edges];
+            const uint8_t *p_data = p_dr->p_data;
+            p_edge->linkage.i_ts_id = ((uint16_t)p_data[0] << 8) | p_data[1];
+            p_edge->linkage.i_network_id = ((uint16_t)p_data[2] << 8) | p_data[3];
+            p_edge->linkage.i_service_id = ((uint16_t)p_data[4] << 8) | p_data[5];
+            p_edge->linkage.i_linkage_type = p_data[6];
+            p_edge->linkage.i_table_id = i_table_id;
+            p_edge->linkage.p_descriptor = p_dr;
+            p_edge->i_source = i_source;
+            p_edge->p_next = NULL;
+        }
+        (*pi_edges)++;
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_sdt/nit/bat_edges
+ *****************************************************************************
+ * Linkages of a table, the services of an SDT being their sources, and the
+ * transport streams of a NIT or a BAT, with a service_id 0, as well as the
+ * network of a NIT, with a transport_stream_id and a service_id 0.
+ *****************************************************************************/
+static void dvbpsi_sidb_sdt_edges(const dvbpsi_sdt_t *p_sdt, dvbpsi_sidb_edge_t *p_edges,
+                                  size_t *pi_edges)
+{
+    *pi_edges = 0;
+    for (const dvbpsi_sdt_service_t *p = p_sdt->p_first_service; p; p = p->p_next)
+        dvbpsi_sidb_edges_add(p_edges, pi_edges, p_sdt->i_table_id,
+                              dvbpsi_sidb_source(p_sdt->i_network_id, p_sdt->i_extension,
+                                                 p->i_service_id),
+                              p->p_first_descriptor);
+}
+
+static void dvbpsi_sidb_nit_edges(const dvbpsi_nit_t *p_nit, dvbpsi_sidb_edge_t *p_edges,
+                                  size_t *pi_edges)
+{
+    *pi_edges = 0;
+    dvbpsi_sidb_edges_add(p_edges, pi_edges, p_nit->i_table_id,
+                          dvbpsi_sidb_source(p_nit->i_network_id, 0, 0),
+                          p_nit->p_first_descriptor);
+    for (const dvbpsi_nit_ts_t *p_ts = p_nit->p_first_ts; p_ts; p_ts = p_ts->p_next)
+        dvbpsi_sidb_edges_add(p_edges, pi_edges, p_nit->i_table_id,
+                              dvbpsi_sidb_source(p_ts->i_orig_network_id, p_ts->i_ts_id, 0),
+                              p_ts->p_first_descriptor);
+}
+
+static void dvbpsi_sidb_bat_edges(const dvbpsi_bat_t *p_bat, dvbpsi_sidb_edge_t *p_edges,
+                                  size_t *pi_edges)
+{
+    *pi_edges = 0;
+    for (const dvbpsi_bat_ts_t *p_ts = p_bat->p_first_ts; p_ts; p_ts = p_ts->p_next)
+        dvbpsi_sidb_edges_add(p_edges, pi_edges, p_bat->i_table_id,
+                              dvbpsi_sidb_source(p_ts->i_orig_network_id, p_ts->i_ts_id, 0),
+                              p_ts->p_first_descriptor);
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_linkage_link
+ *****************************************************************************
+ * Adds the linkages of a table to the index.
+ *****************************************************************************/
+static void dvbpsi_sidb_linkage_link(dvbpsi_sidb_t *p_sidb, dvbpsi_sidb_tables_t *p_tables)
+{
+    for (size_t i = 0; i < p_tables->i_edges; i++)
+    {
+        dvbpsi_sidb_edge_t *p_edge = &p_tables->p_edges[i];
+        unsigned int i_bucket = dvbpsi_sidb_linkage_bucket(p_sidb, p_edge->i_source);
+        p_edge->p_next = p_sidb->pp_linkage_index[i_bucket];
+        p_sidb->pp_linkage_index[i_bucket] = p_edge;
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_linkage_grow
+ *****************************************************************************
+ * Doubles the linkage index once there are more linkages than buckets,
+ * relinking the linkages of all the tables. The index keeps working with
+ * longer chains if this fails.
+ *****************************************************************************/
+static void dvbpsi_sidb_linkage_grow(dvbpsi_sidb_t *p_sidb)
+{
+    unsigned int i_old_size = 1u << p_sidb->i_linkage_bits;
+    if (p_sidb->i_linkages <= i_old_size || p_sidb->i_linkage_bits >= 24)
+        return;
+
+    dvbpsi_sidb_edge_t **pp_index = dvbpsi_calloc(2 * i_old_size, sizeof(dvbpsi_sidb_edge_t *));
+    if (pp_index == NULL)
+        return;
+
+    dvbpsi_free(p_sidb->pp_linkage_index);
+    p_sidb->pp_linkage_index = pp_index;
+    p_sidb->i_linkage_bits++;
+
+    dvbpsi_sidb_slots_t *pp_slots[] = { &p_sidb->streams, &p_sidb->networks, &p_sidb->bouquets };
+    for (unsigned int i = 0; i < 3; i++)
+        for (size_t j = 0; j < pp_slots[i]->i_count; j++)
+            dvbpsi_sidb_linkage_link(p_sidb, &pp_slots[i]->p_tables[j]);
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_linkage_set
+ *****************************************************************************
+ * Replaces the linkages of a table by the ones of its new version.
+ *****************************************************************************/
+static void dvbpsi_sidb_linkage_set(dvbpsi_sidb_t *p_sidb, dvbpsi_sidb_tables_t *p_tables,
+                                    dvbpsi_sidb_edge_t *p_edges, size_t i_edges)
+{
+    for (size_t i = 0; i < p_tables->i_edges; i++)
+    {
+        dvbpsi_sidb_edge_t *p_edge = &p_tables->p_edges[i];
+        dvbpsi_sidb_edge_t **pp_edge =
+                &p_sidb->pp_linkage_index[dvbpsi_sidb_linkage_bucket(p_sidb, p_edge->i_source)];
+        while (*pp_edge != p_edge)
+            pp_edge = &(*pp_edge)->p_next;
+        *pp_edge = p_edge->p_next;
+    }
+    p_sidb->i_linkages -= p_tables->i_edges;
+    dvbpsi_free(p_tables->p_edges);
+
+    p_tables->p_edges = p_edges;
+    p_tables->i_edges = i_edges;
+    p_sidb->i_linkages += i_edges;
+    dvbpsi_sidb_linkage_link(p_sidb, p_tables);
+    dvbpsi_sidb_linkage_grow(p_sidb);
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_pat
+ *****************************************************************************/
+bool dvbpsi_sidb_pat(dvbpsi_sidb_t *p_sidb, dvbpsi_pat_t *p_pat)
+{
+    assert(p_sidb);
+    assert(p_pat);
+
+    dvbpsi_sidb_tables_t *p_tables = dvbpsi_sidb_slot(&p_sidb->streams, p_pat->i_ts_id, true);
+    if (p_tables == NULL)
+    {
+        dvbpsi_pat_delete(p_pat);
+        return false;
+    }
+
+    dvbpsi_pat_t *p_old = p_tables->p_pat;
+    if (   !p_pat->b_current_next
+        || (p_old && p_old->i_version == p_pat->i_version))
+    {
+        dvbpsi_pat_delete(p_pat);
+        return true;
+    }
+
+    /* Services of the new PAT */
+    for (dvbpsi_pat_program_t *p = p_pat->p_first_program; p; p = p->p_next)
+    {
+        if (p->i_number != 0 && !dvbpsi_sidb_entry_get(p_sidb, p_pat->i_ts_id, p->i_number))
+        {
+            for (p = p_pat->p_first_program; p; p = p->p_next)
+            {
+                dvbpsi_sidb_entry_t *p_entry = dvbpsi_sidb_entry_find(p_sidb, p_pat->i_ts_id,
+                                                                      p->i_number);
+                if (p_entry)
+                    dvbpsi_sidb_entry_release(p_sidb, p_entry);
+            }
+            dvbpsi_pat_delete(p_pat);
+            return false;
+        }
+    }
+
+    for (dvbpsi_pat_program_t *p = p_old ? p_old->p_first_program : NULL; p; p = p->p_next)
+    {
+        dvbpsi_sidb_entry_t *p_entry = dvbpsi_sidb_entry_find(p_sidb, p_old->i_ts_id, p->i_number);
+        if (p_entry)
+            p_entry->service.i_pmt_pid = 0;
+    }
+    for (dvbpsi_pat_program_t *p = p_pat->p_first_program; p; p = p->p_next)
+    {
+        if (p->i_number != 0)
+            dvbpsi_sidb_entry_find(p_sidb, p_pat->i_ts_id, p->i_number)->service.i_pmt_pid = p->i_pid;
+    }
+
+    /* Programs left out, with their PMT */
+    for (dvbpsi_pat_program_t *p = p_old ? p_old->p_first_program : NULL; p; p = p->p_next)
+    {
+        dvbpsi_sidb_entry_t *p_entry = dvbpsi_sidb_entry_find(p_sidb, p_old->i_ts_id, p->i_number);
+        if (p_entry && p_entry->service.i_pmt_pid == 0)
+        {
+            if (p_entry->p_pmt)
+                dvbpsi_pmt_delete(p_entry->p_pmt);
+            p_entry->p_pmt = NULL;
+            p_entry->service.p_pmt = NULL;
+            dvbpsi_sidb_entry_release(p_sidb, p_entry);
+        }
+    }
+
+    if (p_old)
+        dvbpsi_pat_delete(p_old);
+    p_tables->p_pat = p_pat;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_pmt
+ *****************************************************************************/
+bool dvbpsi_sidb_pmt(dvbpsi_sidb_t *p_sidb, uint16_t i_ts_id, dvbpsi_pmt_t *p_pmt)
+{
+    assert(p_sidb);
+    assert(p_pmt);
+
+    if (!p_pmt->b_current_next)
+    {
+        dvbpsi_pmt_delete(p_pmt);
+        return true;
+    }
+
+    dvbpsi_sidb_entry_t *p_entry = dvbpsi_sidb_entry_get(p_sidb, i_ts_id,
+                                                         p_pmt->i_program_number);
+    if (p_entry == NULL)
+    {
+        dvbpsi_pmt_delete(p_pmt);
+        return false;
+    }
+
+    if (p_entry->p_pmt && p_entry->p_pmt->i_version == p_pmt->i_version)
+    {
+        dvbpsi_pmt_delete(p_pmt);
+        return true;
+    }
+
+    /* DVBPSI_FLAG_LAZY_DECODE */
+    if (p_pmt->p_sections)
+        dvbpsi_pmt_decode(p_pmt);
+
+    if (p_entry->p_pmt)
+        dvbpsi_pmt_delete(p_entry->p_pmt);
+    p_entry->p_pmt = p_pmt;
+    p_entry->service.p_pmt = p_pmt;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_sdt
+ *****************************************************************************/
+bool dvbpsi_sidb_sdt(dvbpsi_sidb_t *p_sidb, dvbpsi_sdt_t *p_sdt)
+{
+    assert(p_sidb);
+    assert(p_sdt);
+
+    dvbpsi_sidb_tables_t *p_tables = dvbpsi_sidb_slot(&p_sidb->streams, p_sdt->i_extension, true);
+    if (p_tables == NULL)
+    {
+        dvbpsi_sdt_delete(p_sdt);
+        return false;
+    }
+
+    dvbpsi_sdt_t *p_old = p_tables->p_sdt;
+    if (   !p_sdt->b_current_next
+        || (   p_old && p_old->i_table_id == p_sdt->i_table_id
+            && p_old->i_version == p_sdt->i_version))
+    {
+        dvbpsi_sdt_delete(p_sdt);
+        return true;
+    }
+
+    /* DVBPSI_FLAG_LAZY_DECODE */
+    if (p_sdt->p_sections)
+        dvbpsi_sdt_decode(p_sdt);
+
+    size_t i_edges;
+    dvbpsi_sidb_sdt_edges(p_sdt, NULL, &i_edges);
+    dvbpsi_sidb_edge_t *p_edges = NULL;
+    if (i_edges)
+    {
+        p_edges = dvbpsi_malloc(i_edges * sizeof(dvbpsi_sidb_edge_t));
+        if (p_edges == NULL)
+        {
+            dvbpsi_sdt_delete(p_sdt);
+            return false;
+        }
+        dvbpsi_sidb_sdt_edges(p_sdt, p_edges, &i_edges);
+    }
+
+    /* Services of the new SDT */
+    for (dvbpsi_sdt_service_t *p = p_sdt->p_first_service; p; p = p->p_next)
+    {
+        if (!dvbpsi_sidb_entry_get(p_sidb, p_sdt->i_extension, p->i_service_id))
+        {
+            dvbpsi_free(p_edges);
+            for (p = p_sdt->p_first_service; p; p = p->p_next)
+            {
+                dvbpsi_sidb_entry_t *p_entry = dvbpsi_sidb_entry_find(p_sidb, p_sdt->i_extension,
+                                                                      p->i_service_id);
+                if (p_entry)
+                    dvbpsi_sidb_entry_release(p_sidb, p_entry);
+            }
+            dvbpsi_sdt_delete(p_sdt);
+            return false;
+        }
+    }
+
+    for (dvbpsi_sdt_service_t *p = p_old ? p_old->p_first_service : NULL; p; p = p->p_next)
+    {
+        dvbpsi_sidb_entry_t *p_entry = dvbpsi_sidb_entry_find(p_sidb, p_old->i_extension,
+                                                              p->i_service_id);
+        if (p_entry)
+            p_entry->service.p_sdt = NULL;
+    }
+    for (dvbpsi_sdt_service_t *p = p_sdt->p_first_service; p; p = p->p_next)
+    {
+        dvbpsi_sidb_entry_t *p_entry = dvbpsi_sidb_entry_find(p_sidb, p_sdt->i_extension,
+                                                              p->i_service_id);
+        p_entry->service.p_sdt = p;
+        p_entry->service.i_network_id = p_sdt->i_network_id;
+    }
+
+    /* Services left out */
+    for (dvbpsi_sdt_service_t *p = p_old ? p_old->p_first_service : NULL; p; p = p->p_next)
+    {
+        dvbpsi_sidb_entry_t *p_entry = dvbpsi_sidb_entry_find(p_sidb, p_old->i_extension,
+                                                              p->i_service_id);
+        if (p_entry)
+            dvbpsi_sidb_entry_release(p_sidb, p_entry);
+    }
+
+    dvbpsi_sidb_linkage_set(p_sidb, p_tables, p_edges, i_edges);
+    if (p_old)
+        dvbpsi_sdt_delete(p_old);
+    p_tables->p_sdt = p_sdt;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_nit_walk
+ *****************************************************************************
+ * Does a step of an update for the logical_channel_descriptors of a NIT.
+ *****************************************************************************/
+static bool dvbpsi_sidb_nit_walk(dvbpsi_sidb_t *p_sidb, const dvbpsi_nit_t *p_nit,
+                                 dvbpsi_sidb_step_t i_step)
+{
+    for (dvbpsi_nit_ts_t *p_ts = p_nit->p_first_ts; p_ts; p_ts = p_ts->p_next)
+    {
+        for (dvbpsi_descriptor_t *p_dr = p_ts->p_first_descriptor; p_dr; p_dr = p_dr->p_next)
+        {
+            if (p_dr->i_tag != 0x83)
+                continue;
+
+            for (unsigned int i = 0; i + 4 <= p_dr->i_length; i += 4)
+            {
+                const uint8_t *p_data = p_dr->p_data + i;
+                uint16_t i_service_id = ((uint16_t)p_data[0] << 8) | p_data[1];
+                uint16_t i_lcn = ((uint16_t)(p_data[2] & 0x03) << 8) | p_data[3];
+                if (i_lcn == 0)
+                    continue;
+
+                dvbpsi_sidb_entry_t *p_entry = i_step == DVBPSI_SIDB_ALLOC
+                    ? dvbpsi_sidb_entry_get(p_sidb, p_ts->i_ts_id, i_service_id)
+                    : dvbpsi_sidb_entry_find(p_sidb, p_ts->i_ts_id, i_service_id);
+                if (p_entry == NULL)
+                {
+                    if (i_step == DVBPSI_SIDB_ALLOC)
+                        return false;
+                    continue;
+                }
+
+                switch (i_step)
+                {
+                case DVBPSI_SIDB_ALLOC:
+                    break;
+                case DVBPSI_SIDB_CLEAR:
+                    if (p_entry->i_lcn_network == p_nit->i_extension)
+                        dvbpsi_sidb_lcn_set(p_sidb, p_entry, 0);
+                    break;
+                case DVBPSI_SIDB_SET:
+                    dvbpsi_sidb_lcn_set(p_sidb, p_entry, i_lcn);
+                    p_entry->service.b_visible = (p_data[2] & 0x80) != 0;
+                    p_entry->i_lcn_network = p_nit->i_extension;
+                    if (p_entry->service.i_network_id == 0)
+                        p_entry->service.i_network_id = p_ts->i_orig_network_id;
+                    break;
+                case DVBPSI_SIDB_RELEASE:
+                    dvbpsi_sidb_entry_release(p_sidb, p_entry);
+                    break;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_nit
+ *****************************************************************************/
+bool dvbpsi_sidb_nit(dvbpsi_sidb_t *p_sidb, dvbpsi_nit_t *p_nit)
+{
+    assert(p_sidb);
+    assert(p_nit);
+
+    dvbpsi_sidb_tables_t *p_tables = dvbpsi_sidb_slot(&p_sidb->networks, p_nit->i_extension, true);
+    if (p_tables == NULL)
+    {
+        dvbpsi_nit_delete(p_nit);
+        return false;
+    }
+
+    dvbpsi_nit_t *p_old = p_tables->p_nit;
+    if (   !p_nit->b_current_next
+        || (   p_old && p_old->i_table_id == p_nit->i_table_id
+            && p_old->i_version == p_nit->i_version))
+    {
+        dvbpsi_nit_delete(p_nit);
+        return true;
+    }
+
+    /* DVBPSI_FLAG_LAZY_DECODE */
+    if (p_nit->p_sections)
+        dvbpsi_nit_decode(p_nit);
+
+    size_t i_edges;
+    dvbpsi_sidb_nit_edges(p_nit, NULL, &i_edges);
+    dvbpsi_sidb_edge_t *p_edges = NULL;
+    if (i_edges)
+    {
+        p_edges = dvbpsi_malloc(i_edges * sizeof(dvbpsi_sidb_edge_t));
+        if (p_edges == NULL)
+        {
+            dvbpsi_nit_delete(p_nit);
+            return false;
+        }
+        dvbpsi_sidb_nit_edges(p_nit, p_edges, &i_edges);
+    }
+
+    if (!dvbpsi_sidb_nit_walk(p_sidb, p_nit, DVBPSI_SIDB_ALLOC))
+    {
+        dvbpsi_free(p_edges);
+        dvbpsi_sidb_nit_walk(p_sidb, p_nit, DVBPSI_SIDB_RELEASE);
+        dvbpsi_nit_delete(p_nit);
+        return false;
+    }
+
+    if (p_old)
+        dvbpsi_sidb_nit_walk(p_sidb, p_old, DVBPSI_SIDB_CLEAR);
+    dvbpsi_sidb_nit_walk(p_sidb, p_nit, DVBPSI_SIDB_SET);
+    if (p_old)
+    {
+        dvbpsi_sidb_nit_walk(p_sidb, p_old, DVBPSI_SIDB_RELEASE);
+        dvbpsi_nit_delete(p_old);
+    }
+    dvbpsi_sidb_linkage_set(p_sidb, p_tables, p_edges, i_edges);
+    p_tables->p_nit = p_nit;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_bat_walk
+ *****************************************************************************
+ * Does a step of an update for the service_list_descriptors of a BAT.
+ *****************************************************************************/
+static bool dvbpsi_sidb_bat_walk(dvbpsi_sidb_t *p_sidb, const dvbpsi_bat_t *p_bat,
+                                 dvbpsi_sidb_step_t i_step)
+{
+    uint16_t i_bouquet_id = p_bat->i_extension;
+    /* Bit of the bouquet in the masks, from the rank of its tables */
+    unsigned int i_bit = dvbpsi_sidb_slot(&p_sidb->bouquets, i_bouquet_id, false)
+                             - p_sidb->bouquets.p_tables;
+    uint64_t i_word_bit = UINT64_C(1) << (i_bit % 64);
+
+    for (dvbpsi_bat_ts_t *p_ts = p_bat->p_first_ts; p_ts; p_ts = p_ts->p_next)
+    {
+        for (dvbpsi_descriptor_t *p_dr = p_ts->p_first_descriptor; p_dr; p_dr = p_dr->p_next)
+        {
+            if (p_dr->i_tag != 0x41)
+                continue;
+
+            for (unsigned int i = 0; i + 3 <= p_dr->i_length; i += 3)
+            {
+                uint16_t i_service_id = ((uint16_t)p_dr->p_data[i] << 8) | p_dr->p_data[i + 1];
+                dvbpsi_sidb_entry_t *p_entry = i_step == DVBPSI_SIDB_ALLOC
+                    ? dvbpsi_sidb_entry_get(p_sidb, p_ts->i_ts_id, i_service_id)
+                    : dvbpsi_sidb_entry_find(p_sidb, p_ts->i_ts_id, i_service_id);
+                if (p_entry == NULL)
+                {
+                    if (i_step == DVBPSI_SIDB_ALLOC)
+                        return false;
+                    continue;
+                }
+
+                unsigned int j = 0;
+                while (j < p_entry->service.i_bouquets && p_entry->pi_bouquets[j] != i_bouquet_id)
+                    j++;
+
+                switch (i_step)
+                {
+                case DVBPSI_SIDB_ALLOC:
+                    /* Room for one more bouquet */
+                    if (p_entry->service.i_bouquets == p_entry->i_bouquets_size)
+                    {
+                        unsigned int i_size = p_entry->i_bouquets_size ? 2 * p_entry->i_bouquets_size : 2;
+                        uint16_t *pi_bouquets = dvbpsi_malloc(i_size * sizeof(uint16_t));
+                        if (pi_bouquets == NULL)
+                            return false;
+                        if (p_entry->service.i_bouquets)
+                            memcpy(pi_bouquets, p_entry->pi_bouquets,
+                                   p_entry->service.i_bouquets * sizeof(uint16_t));
+                        dvbpsi_free(p_entry->pi_bouquets);
+                        p_entry->pi_bouquets = pi_bouquets;
+                        p_entry->i_bouquets_size = i_size;
+                        p_entry->service.pi_bouquets = pi_bouquets;
+                    }
+                    /* Room for the bit of the bouquet */
+                    if (i_bit / 64 >= p_entry->service.i_bouquet_words)
+                    {
+                        unsigned int i_words = i_bit / 64 + 1;
+                        uint64_t *pi_mask = dvbpsi_calloc(i_words, sizeof(uint64_t));
+                        if (pi_mask == NULL)
+                            return false;
+                        if (p_entry->service.i_bouquet_words)
+                            memcpy(pi_mask, p_entry->pi_bouquet_mask,
+                                   p_entry->service.i_bouquet_words * sizeof(uint64_t));
+                        dvbpsi_free(p_entry->pi_bouquet_mask);
+                        p_entry->pi_bouquet_mask = pi_mask;
+                        p_entry->service.i_bouquet_words = i_words;
+                        p_entry->service.pi_bouquet_mask = pi_mask;
+                    }
+                    break;
+                case DVBPSI_SIDB_CLEAR:
+                    if (j < p_entry->service.i_bouquets)
+                        p_entry->pi_bouquets[j] = p_entry->pi_bouquets[--p_entry->service.i_bouquets];
+                    p_entry->pi_bouquet_mask[i_bit / 64] &= ~i_word_bit;
+                    break;
+                case DVBPSI_SIDB_SET:
+                    if (j == p_entry->service.i_bouquets)
+                        p_entry->pi_bouquets[p_entry->service.i_bouquets++] = i_bouquet_id;
+                    p_entry->pi_bouquet_mask[i_bit / 64] |= i_word_bit;
+                    if (p_entry->service.i_network_id == 0)
+                        p_entry->service.i_network_id = p_ts->i_orig_network_id;
+                    break;
+                case DVBPSI_SIDB_RELEASE:
+                    dvbpsi_sidb_entry_release(p_sidb, p_entry);
+                    break;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_bat_services
+ *****************************************************************************
+ * Gets the services of a BAT, in its order, or only counts them if
+ * pp_services is NULL.
+ *****************************************************************************/
+static size_t dvbpsi_sidb_bat_services(const dvbpsi_sidb_t *p_sidb, const dvbpsi_bat_t *p_bat,
+                                       const dvbpsi_sidb_service_t **pp_services)
+{
+    size_t i_count = 0;
+    for (dvbpsi_bat_ts_t *p_ts = p_bat->p_first_ts; p_ts; p_ts = p_ts->p_next)
+    {
+        for (dvbpsi_descriptor_t *p_dr = p_ts->p_first_descriptor; p_dr; p_dr = p_dr->p_next)
+        {
+            if (p_dr->i_tag != 0x41)
+                continue;
+
+            for (unsigned int i = 0; i + 3 <= p_dr->i_length; i += 3)
+            {
+                if (pp_services)
+                {
+                    uint16_t i_service_id = ((uint16_t)p_dr->p_data[i] << 8) | p_dr->p_data[i + 1];
+                    pp_services[i_count] = &dvbpsi_sidb_entry_find(p_sidb, p_ts->i_ts_id,
+                                                                   i_service_id)->service;
+                }
+                i_count++;
+            }
+        }
+    }
+    return i_count;
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_bat
+ *****************************************************************************/
+bool dvbpsi_sidb_bat(dvbpsi_sidb_t *p_sidb, dvbpsi_bat_t *p_bat)
+{
+    assert(p_sidb);
+    assert(p_bat);
+
+    dvbpsi_sidb_tables_t *p_tables = dvbpsi_sidb_slot(&p_sidb->bouquets, p_bat->i_extension, true);
+    if (p_tables == NULL)
+    {
+        dvbpsi_bat_delete(p_bat);
+        return false;
+    }
+
+    dvbpsi_bat_t *p_old = p_tables->p_bat;
+    if (   !p_bat->b_current_next
+        || (p_old && p_old->i_version == p_bat->i_version))
+    {
+        dvbpsi_bat_delete(p_bat);
+        return true;
+    }
+
+    /* DVBPSI_FLAG_LAZY_DECODE */
+    if (p_bat->p_sections)
+        dvbpsi_bat_decode(p_bat);
+
+    size_t i_edges;
+    dvbpsi_sidb_bat_edges(p_bat, NULL, &i_edges);
+    dvbpsi_sidb_edge_t *p_edges = NULL;
+    if (i_edges)
+    {
+        p_edges = dvbpsi_malloc(i_edges * sizeof(dvbpsi_sidb_edge_t));
+        if (p_edges == NULL)
+        {
+            dvbpsi_bat_delete(p_bat);
+            return false;
+        }
+        dvbpsi_sidb_bat_edges(p_bat, p_edges, &i_edges);
+    }
+
+    size_t i_services = dvbpsi_sidb_bat_services(p_sidb, p_bat, NULL);
+    const dvbpsi_sidb_service_t **pp_services = NULL;
+    if (i_services)
+    {
+        pp_services = dvbpsi_malloc(i_services * sizeof(dvbpsi_sidb_service_t *));
+        if (pp_services == NULL)
+        {
+            dvbpsi_free(p_edges);
+            dvbpsi_bat_delete(p_bat);
+            return false;
+        }
+    }
+
+    if (!dvbpsi_sidb_bat_walk(p_sidb, p_bat, DVBPSI_SIDB_ALLOC))
+    {
+        dvbpsi_free(pp_services);
+        dvbpsi_free(p_edges);
+        dvbpsi_sidb_bat_walk(p_sidb, p_bat, DVBPSI_SIDB_RELEASE);
+        dvbpsi_bat_delete(p_bat);
+        return false;
+    }
+
+    if (p_old)
+        dvbpsi_sidb_bat_walk(p_sidb, p_old, DVBPSI_SIDB_CLEAR);
+    dvbpsi_sidb_bat_walk(p_sidb, p_bat, DVBPSI_SIDB_SET);
+    if (p_old)
+    {
+        dvbpsi_sidb_bat_walk(p_sidb, p_old, DVBPSI_SIDB_RELEASE);
+        dvbpsi_bat_delete(p_old);
+    }
+    if (pp_services)
+        dvbpsi_sidb_bat_services(p_sidb, p_bat, pp_services);
+    dvbpsi_free(p_tables->pp_services);
+    p_tables->pp_services = pp_services;
+    p_tables->i_services = i_services;
+    dvbpsi_sidb_linkage_set(p_sidb, p_tables, p_edges, i_edges);
+    p_tables->p_bat = p_bat;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_find
+ *****************************************************************************/
+const dvbpsi_sidb_service_t *dvbpsi_sidb_find(dvbpsi_sidb_t *p_sidb, uint16_t i_ts_id,
+                                              uint16_t i_service_id)
+{
+    assert(p_sidb);
+
+    dvbpsi_sidb_entry_t *p_entry = dvbpsi_sidb_entry_find(p_sidb, i_ts_id, i_service_id);
+    return p_entry ? &p_entry->service : NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_get_sdt
+ *****************************************************************************/
+const dvbpsi_sdt_t *dvbpsi_sidb_get_sdt(dvbpsi_sidb_t *p_sidb, uint16_t i_ts_id)
+{
+    assert(p_sidb);
+
+    dvbpsi_sidb_tables_t *p_tables = dvbpsi_sidb_slot(&p_sidb->streams, i_ts_id, false);
+    return p_tables ? p_tables->p_sdt : NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_get_nit
+ *****************************************************************************/
+const dvbpsi_nit_t *dvbpsi_sidb_get_nit(dvbpsi_sidb_t *p_sidb, uint16_t i_network_id)
+{
+    assert(p_sidb);
+
+    dvbpsi_sidb_tables_t *p_tables = dvbpsi_sidb_slot(&p_sidb->networks, i_network_id, false);
+    return p_tables ? p_tables->p_nit : NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_lcn
+ *****************************************************************************/
+size_t dvbpsi_sidb_lcn(dvbpsi_sidb_t *p_sidb, uint16_t i_lcn,
+                       const dvbpsi_sidb_service_t **pp_services, size_t i_max)
+{
+    assert(p_sidb);
+
+    size_t i_count = 0;
+    if (i_lcn == 0)
+        return 0;
+
+    for (dvbpsi_sidb_entry_t *p_entry = p_sidb->pp_lcn_index[dvbpsi_sidb_bucket(p_sidb, i_lcn)];
+         p_entry && i_count < i_max; p_entry = p_entry->p_lcn_next)
+    {
+        if (p_entry->service.i_lcn == i_lcn)
+            pp_services[i_count++] = &p_entry->service;
+    }
+    return i_count;
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_bouquet
+ *****************************************************************************/
+size_t dvbpsi_sidb_bouquet(dvbpsi_sidb_t *p_sidb, uint16_t i_bouquet_id,
+                           const dvbpsi_sidb_service_t **pp_services, size_t i_max)
+{
+    assert(p_sidb);
+
+    dvbpsi_sidb_tables_t *p_tables = dvbpsi_sidb_slot(&p_sidb->bouquets, i_bouquet_id, false);
+    if (p_tables == NULL)
+        return 0;
+
+    size_t i_count = p_tables->i_services < i_max ? p_tables->i_services : i_max;
+    if (i_count)
+        memcpy(pp_services, p_tables->pp_services, i_count * sizeof(dvbpsi_sidb_service_t *));
+    return i_count;
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_bouquet_mask
+ *****************************************************************************/
+bool dvbpsi_sidb_bouquet_mask(dvbpsi_sidb_t *p_sidb, const uint16_t *pi_bouquet_ids,
+                              size_t i_bouquet_ids, uint64_t *pi_mask, size_t i_words)
+{
+    assert(p_sidb);
+
+    bool b_fits = true;
+    memset(pi_mask, 0, i_words * sizeof(uint64_t));
+    for (size_t i = 0; i < i_bouquet_ids; i++)
+    {
+        dvbpsi_sidb_tables_t *p_tables = dvbpsi_sidb_slot(&p_sidb->bouquets,
+                                                          pi_bouquet_ids[i], false);
+        if (p_tables == NULL)
+            continue;
+
+        size_t i_bit = p_tables - p_sidb->bouquets.p_tables;
+        if (i_bit / 64 < i_words)
+            pi_mask[i_bit / 64] |= UINT64_C(1) << (i_bit % 64);
+        else
+            b_fits = false;
+    }
+    return b_fits;
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_linkages
+ *****************************************************************************/
+size_t dvbpsi_sidb_linkages(dvbpsi_sidb_t *p_sidb, uint16_t i_network_id, uint16_t i_ts_id,
+                            uint16_t i_service_id, int i_linkage_type,
+                            const dvbpsi_sidb_linkage_t **pp_linkages, size_t i_max)
+{
+    assert(p_sidb);
+
+    size_t i_count = 0;
+    uint64_t i_source = dvbpsi_sidb_source(i_network_id, i_ts_id, i_service_id);
+    for (dvbpsi_sidb_edge_t *p_edge =
+             p_sidb->pp_linkage_index[dvbpsi_sidb_linkage_bucket(p_sidb, i_source)];
+         p_edge && i_count < i_max; p_edge = p_edge->p_next)
+    {
+        if (   p_edge->i_source == i_source
+            && (i_linkage_type < 0 || p_edge->linkage.i_linkage_type == i_linkage_type))
+            pp_linkages[i_count++] = &p_edge->linkage;
+    }
+    return i_count;
+}
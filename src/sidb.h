@@ -0,0 +1,365 @@
+/*****************************************************************************
+ * sidb.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <sidb.h>
+ * \brief Service information database.
+ *
+ * Joins the PATs, PMTs, SDTs, NITs and BATs of a network into one record per
+ * service, indexed by transport_stream_id and service_id and by logical
+ * channel number, and their linkages by source. The database keeps the
+ * tables it is given, and a new version of a table only updates the
+ * services it lists, before or after the change, and its own linkages.
+ */
+
+#ifndef _DVBPSI_SIDB_H_
+#define _DVBPSI_SIDB_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_sidb_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_sidb_s dvbpsi_sidb_t
+ * \brief dvbpsi_sidb_t type definition, an opaque service information
+ * database.
+ */
+typedef struct dvbpsi_sidb_s dvbpsi_sidb_t;
+
+/*****************************************************************************
+ * dvbpsi_sidb_service_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_sidb_service_s
+ * \brief Service of a database, joining what the tables say about it.
+ */
+/*!
+ * \typedef struct dvbpsi_sidb_service_s dvbpsi_sidb_service_t
+ * \brief dvbpsi_sidb_service_t type definition.
+ */
+typedef struct dvbpsi_sidb_service_s
+{
+    uint16_t                     i_ts_id;        /*!< transport_stream_id */
+    uint16_t                     i_service_id;   /*!< service_id, or
+                                                      program_number */
+    uint16_t                     i_network_id;   /*!< original_network_id
+                                                      given by the SDT, NIT
+                                                      or BAT, 0 if none */
+
+    uint16_t                     i_pmt_pid;      /*!< PID of the PMT in the
+                                                      PAT, 0 if not in it */
+    const dvbpsi_pmt_t *         p_pmt;          /*!< PMT, NULL if none */
+    const dvbpsi_sdt_service_t * p_sdt;          /*!< entry of the SDT, NULL
+                                                      if none */
+
+    uint16_t                     i_lcn;          /*!< logical_channel_number
+                                                      of a NIT, 0 if none */
+    bool                         b_visible;      /*!< visible_service_flag
+                                                      of the LCN */
+
+    const uint16_t *             pi_bouquets;    /*!< bouquet_ids of the BATs
+                                                      listing the service */
+    unsigned int                 i_bouquets;     /*!< number of bouquets */
+    const uint64_t *             pi_bouquet_mask; /*!< bouquets listing the
+                                                      service, see
+                                                      dvbpsi_sidb_bouquet_mask() */
+    unsigned int                 i_bouquet_words; /*!< number of words of
+                                                      pi_bouquet_mask */
+} dvbpsi_sidb_service_t;
+
+/*****************************************************************************
+ * dvbpsi_sidb_linkage_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_sidb_linkage_s
+ * \brief Linkage of a database, from a linkage_descriptor of a table.
+ */
+/*!
+ * \typedef struct dvbpsi_sidb_linkage_s dvbpsi_sidb_linkage_t
+ * \brief dvbpsi_sidb_linkage_t type definition.
+ */
+typedef struct dvbpsi_sidb_linkage_s
+{
+    uint8_t                      i_linkage_type; /*!< linkage_type, 0x05 for
+                                                      a service replacement */
+    uint8_t                      i_table_id;     /*!< table_id of the table
+                                                      giving it */
+    uint16_t                     i_network_id;   /*!< original_network_id of
+                                                      the target */
+    uint16_t                     i_ts_id;        /*!< transport_stream_id of
+                                                      the target */
+    uint16_t                     i_service_id;   /*!< service_id of the
+                                                      target */
+    const dvbpsi_descriptor_t *  p_descriptor;   /*!< linkage_descriptor, for
+                                                      the fields of its type
+                                                      and its private data */
+} dvbpsi_sidb_linkage_t;
+
+/*****************************************************************************
+ * dvbpsi_sidb_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_sidb_t *dvbpsi_sidb_new(void)
+ * \brief Creates an empty service information database
+ * \return pointer to the database, or NULL on error
+ */
+dvbpsi_sidb_t *dvbpsi_sidb_new(void);
+
+/*****************************************************************************
+ * dvbpsi_sidb_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_sidb_delete(dvbpsi_sidb_t *p_sidb)
+ * \brief Deletes a database, its services and the tables it keeps
+ * \param p_sidb pointer to the database
+ * \return nothing
+ */
+void dvbpsi_sidb_delete(dvbpsi_sidb_t *p_sidb);
+
+/*****************************************************************************
+ * dvbpsi_sidb_pat/pmt/sdt/nit/bat
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_sidb_pat(dvbpsi_sidb_t *p_sidb, dvbpsi_pat_t *p_pat)
+ * \brief Updates the services of a transport stream with its PAT
+ * \param p_sidb pointer to the database
+ * \param p_pat PAT, as given to the callback of dvbpsi_pat_attach()
+ * \return false on error, in which case the services keep the previous
+ *         PAT, true otherwise.
+ *
+ * Like the other update functions, it takes the table over: the table is
+ * kept by the database until its next version, or deleted at once on
+ * error, if it is not current or if it is the version already kept. A
+ * program left out of the new PAT loses its PMT.
+ */
+bool dvbpsi_sidb_pat(dvbpsi_sidb_t *p_sidb, dvbpsi_pat_t *p_pat);
+
+/*!
+ * \fn bool dvbpsi_sidb_pmt(dvbpsi_sidb_t *p_sidb, uint16_t i_ts_id,
+ *                          dvbpsi_pmt_t *p_pmt)
+ * \brief Updates the service of a PMT
+ * \param p_sidb pointer to the database
+ * \param i_ts_id transport_stream_id of the PAT listing the program
+ * \param p_pmt PMT, as given to the callback of dvbpsi_pmt_attach()
+ * \return false on error, true otherwise.
+ */
+bool dvbpsi_sidb_pmt(dvbpsi_sidb_t *p_sidb, uint16_t i_ts_id, dvbpsi_pmt_t *p_pmt);
+
+/*!
+ * \fn bool dvbpsi_sidb_sdt(dvbpsi_sidb_t *p_sidb, dvbpsi_sdt_t *p_sdt)
+ * \brief Updates the services of a transport stream with its SDT, actual
+ * or other
+ * \param p_sidb pointer to the database
+ * \param p_sdt SDT, as given to the callback of dvbpsi_sdt_attach()
+ * \return false on error, in which case the services keep the previous
+ *         SDT, true otherwise.
+ */
+bool dvbpsi_sidb_sdt(dvbpsi_sidb_t *p_sidb, dvbpsi_sdt_t *p_sdt);
+
+/*!
+ * \fn bool dvbpsi_sidb_nit(dvbpsi_sidb_t *p_sidb, dvbpsi_nit_t *p_nit)
+ * \brief Updates the logical channel numbers of the services with a NIT,
+ * actual or other
+ * \param p_sidb pointer to the database
+ * \param p_nit NIT, as given to the callback of dvbpsi_nit_attach()
+ * \return false on error, in which case the services keep the previous
+ *         NIT of the network, true otherwise.
+ *
+ * The numbers are the ones of the logical_channel_descriptors, tag 0x83, of
+ * the transport stream loops. A service numbered by several NITs keeps the
+ * last one.
+ */
+bool dvbpsi_sidb_nit(dvbpsi_sidb_t *p_sidb, dvbpsi_nit_t *p_nit);
+
+/*!
+ * \fn bool dvbpsi_sidb_bat(dvbpsi_sidb_t *p_sidb, dvbpsi_bat_t *p_bat)
+ * \brief Updates the bouquets of the services with a BAT
+ * \param p_sidb pointer to the database
+ * \param p_bat BAT, as given to the callback of dvbpsi_bat_attach()
+ * \return false on error, in which case the services keep the previous
+ *         BAT of the bouquet, true otherwise.
+ *
+ * The services of a bouquet are the ones of the service_list_descriptors
+ * of the transport stream loops.
+ */
+bool dvbpsi_sidb_bat(dvbpsi_sidb_t *p_sidb, dvbpsi_bat_t *p_bat);
+
+/*****************************************************************************
+ * dvbpsi_sidb_find
+ *****************************************************************************/
+/*!
+ * \fn const dvbpsi_sidb_service_t *dvbpsi_sidb_find(dvbpsi_sidb_t *p_sidb,
+ *                                                  uint16_t i_ts_id,
+ *                                                  uint16_t i_service_id)
+ * \brief Finds a service of a database
+ * \param p_sidb pointer to the database
+ * \param i_ts_id transport_stream_id
+ * \param i_service_id service_id
+ * \return the service, valid until the next update of the database, or NULL
+ *         if no table lists it. The cost is O(1).
+ */
+const dvbpsi_sidb_service_t *dvbpsi_sidb_find(dvbpsi_sidb_t *p_sidb, uint16_t i_ts_id,
+                                              uint16_t i_service_id);
+
+/*****************************************************************************
+ * dvbpsi_sidb_get_sdt/dvbpsi_sidb_get_nit
+ *****************************************************************************/
+/*!
+ * \fn const dvbpsi_sdt_t *dvbpsi_sidb_get_sdt(dvbpsi_sidb_t *p_sidb,
+ *                                            uint16_t i_ts_id)
+ * \brief Gets the SDT kept for a transport stream
+ * \param p_sidb pointer to the database
+ * \param i_ts_id transport_stream_id
+ * \return the SDT, valid until the next update of the database, or NULL.
+ */
+const dvbpsi_sdt_t *dvbpsi_sidb_get_sdt(dvbpsi_sidb_t *p_sidb, uint16_t i_ts_id);
+
+/*!
+ * \fn const dvbpsi_nit_t *dvbpsi_sidb_get_nit(dvbpsi_sidb_t *p_sidb,
+ *                                            uint16_t i_network_id)
+ * \brief Gets the NIT kept for a network
+ * \param p_sidb pointer to the database
+ * \param i_network_id network_id
+ * \return the NIT, valid until the next update of the database, or NULL.
+ */
+const dvbpsi_nit_t *dvbpsi_sidb_get_nit(dvbpsi_sidb_t *p_sidb, uint16_t i_network_id);
+
+/*****************************************************************************
+ * dvbpsi_sidb_lcn
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_sidb_lcn(dvbpsi_sidb_t *p_sidb, uint16_t i_lcn,
+ *                            const dvbpsi_sidb_service_t **pp_services,
+ *                            size_t i_max)
+ * \brief Gets the services of a logical channel number
+ * \param p_sidb pointer to the database
+ * \param i_lcn logical_channel_number, not 0
+ * \param pp_services filled with up to i_max services, valid until the next
+ *        update of the database
+ * \param i_max maximum number of services
+ * \return the number of services, usually 1. The cost is O(1 + i_max).
+ */
+size_t dvbpsi_sidb_lcn(dvbpsi_sidb_t *p_sidb, uint16_t i_lcn,
+                       const dvbpsi_sidb_service_t **pp_services, size_t i_max);
+
+/*****************************************************************************
+ * dvbpsi_sidb_bouquet
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_sidb_bouquet(dvbpsi_sidb_t *p_sidb, uint16_t i_bouquet_id,
+ *                                const dvbpsi_sidb_service_t **pp_services,
+ *                                size_t i_max)
+ * \brief Gets the services of a bouquet, in the order of its BAT
+ * \param p_sidb pointer to the database
+ * \param i_bouquet_id bouquet_id
+ * \param pp_services filled with up to i_max services, valid until the next
+ *        update of the database
+ * \param i_max maximum number of services
+ * \return the number of services. The cost is a copy of the services,
+ *         kept in an array from one BAT version to the next.
+ */
+size_t dvbpsi_sidb_bouquet(dvbpsi_sidb_t *p_sidb, uint16_t i_bouquet_id,
+                           const dvbpsi_sidb_service_t **pp_services, size_t i_max);
+
+/*****************************************************************************
+ * dvbpsi_sidb_bouquet_mask/dvbpsi_sidb_in_bouquets
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_sidb_bouquet_mask(dvbpsi_sidb_t *p_sidb,
+ *                                   const uint16_t *pi_bouquet_ids,
+ *                                   size_t i_bouquet_ids, uint64_t *pi_mask,
+ *                                   size_t i_words)
+ * \brief Gets the mask of bouquets for dvbpsi_sidb_in_bouquets()
+ * \param p_sidb pointer to the database
+ * \param pi_bouquet_ids bouquet_ids
+ * \param i_bouquet_ids number of bouquet_ids
+ * \param pi_mask filled with the mask
+ * \param i_words number of words of pi_mask
+ * \return false if pi_mask is too small for a bouquet, true otherwise.
+ *
+ * Each bouquet for which the database got a BAT has a bit, in the order the
+ * first BATs came, and a bouquet without any BAT is left out of the mask.
+ * The bits do not change for the life of the database, and a mask stays
+ * valid across updates.
+ */
+bool dvbpsi_sidb_bouquet_mask(dvbpsi_sidb_t *p_sidb, const uint16_t *pi_bouquet_ids,
+                              size_t i_bouquet_ids, uint64_t *pi_mask, size_t i_words);
+
+/*!
+ * \fn static inline bool dvbpsi_sidb_in_bouquets(const dvbpsi_sidb_service_t *p_service,
+ *                                                const uint64_t *pi_mask,
+ *                                                size_t i_words)
+ * \brief Checks whether a service is in any bouquet of a mask
+ * \param p_service service of the database
+ * \param pi_mask mask of dvbpsi_sidb_bouquet_mask()
+ * \param i_words number of words of pi_mask
+ * \return true if a BAT of a bouquet of the mask lists the service.
+ */
+static inline bool dvbpsi_sidb_in_bouquets(const dvbpsi_sidb_service_t *p_service,
+                                           const uint64_t *pi_mask, size_t i_words)
+{
+    size_t i_count = p_service->i_bouquet_words < i_words ? p_service->i_bouquet_words : i_words;
+    for (size_t i = 0; i < i_count; i++)
+        if (p_service->pi_bouquet_mask[i] & pi_mask[i])
+            return true;
+    return false;
+}
+
+/*****************************************************************************
+ * dvbpsi_sidb_linkages
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_sidb_linkages(dvbpsi_sidb_t *p_sidb, uint16_t i_network_id,
+ *                                 uint16_t i_ts_id, uint16_t i_service_id,
+ *                                 int i_linkage_type,
+ *                                 const dvbpsi_sidb_linkage_t **pp_linkages,
+ *                                 size_t i_max)
+ * \brief Gets the linkages of a service, a transport stream or a network
+ * \param p_sidb pointer to the database
+ * \param i_network_id original_network_id, or network_id of a network
+ * \param i_ts_id transport_stream_id, 0 for a network
+ * \param i_service_id service_id, 0 for a transport stream or a network
+ * \param i_linkage_type linkage_type, -1 for all
+ * \param pp_linkages filled with up to i_max linkages, valid until the next
+ *        update of the database
+ * \param i_max maximum number of linkages
+ * \return the number of linkages. The cost is O(1 + degree).
+ *
+ * The linkages are the ones of the service loops of the SDTs, of the
+ * transport stream loops of the NITs and BATs and of the first loop of
+ * the NITs. They are indexed as their table is updated, a new version
+ * replacing the linkages of the previous one.
+ */
+size_t dvbpsi_sidb_linkages(dvbpsi_sidb_t *p_sidb, uint16_t i_network_id, uint16_t i_ts_id,
+                            uint16_t i_service_id, int i_linkage_type,
+                            const dvbpsi_sidb_linkage_t **pp_linkages, size_t i_max);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of sidb.h"
+#endif
@@ -0,0 +1,857 @@
+/*****************************************************************************
+ * sigen.c: SDTs and NITs generated from a service information database
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "descriptor.h"
+#include "tables/pat.h"
+#include "tables/pmt.h"
+#include "tables/sdt.h"
+#include "tables/nit.h"
+#include "tables/bat.h"
+#include "sidb.h"
+#include "sigen.h"
+
+/* Largest section, CRC_32 included */
+#define DVBPSI_SIGEN_SECTION    1024
+/* Largest service of an SDT section: 11 bytes of header and the CRC_32 */
+#define DVBPSI_SIGEN_SERVICE    (DVBPSI_SIGEN_SECTION - 15)
+/* Largest transport stream of a NIT section: 12 bytes of header and the
+ * CRC_32 */
+#define DVBPSI_SIGEN_TS         (DVBPSI_SIGEN_SECTION - 16)
+
+/*****************************************************************************
+ * dvbpsi_sigen_service_t
+ *****************************************************************************
+ * Output service of a transport stream, with its encoded SDT entry.
+ *****************************************************************************/
+typedef struct dvbpsi_sigen_service_s
+{
+    uint16_t                i_service_id;
+    bool                    b_dirty;
+    dvbpsi_sigen_edit_t     edit;
+    uint8_t                 i_service_type; /* of the service_descriptor */
+
+    uint16_t                i_size;
+    uint8_t *               p_data;
+} dvbpsi_sigen_service_t;
+
+/*****************************************************************************
+ * dvbpsi_sigen_stream_t
+ *****************************************************************************
+ * Output services of a transport stream, from the SDT of the database.
+ *****************************************************************************/
+typedef struct dvbpsi_sigen_stream_s
+{
+    uint16_t                i_ts_id;
+    uint16_t                i_network_id;   /* original_network_id */
+    bool                    b_dirty;        /* all the services */
+
+    dvbpsi_sigen_service_t *p_services;
+    size_t                  i_services;
+    uint64_t                i_change;       /* counts the changes of the
+                                               services */
+
+    /* Output SDT */
+    bool                    b_sdt;
+    uint8_t                 i_sdt_version;
+    uint64_t                i_sdt_change;   /* i_change it was made of */
+} dvbpsi_sigen_stream_t;
+
+/*****************************************************************************
+ * dvbpsi_sigen_loop_t
+ *****************************************************************************
+ * Transport stream of an output NIT, with its encoded entry.
+ *****************************************************************************/
+typedef struct dvbpsi_sigen_loop_s
+{
+    uint16_t                i_ts_id;
+    bool                    b_dirty;
+    uint64_t                i_change;       /* i_change of the stream it was
+                                               made of */
+
+    uint16_t                i_size;
+    uint8_t *               p_data;
+} dvbpsi_sigen_loop_t;
+
+/*****************************************************************************
+ * dvbpsi_sigen_network_t
+ *****************************************************************************
+ * Output NIT.
+ *****************************************************************************/
+typedef struct dvbpsi_sigen_network_s
+{
+    uint16_t                i_network_id;
+    bool                    b_dirty;        /* the network descriptors */
+    uint16_t                i_descriptors;
+    uint8_t *               p_descriptors;
+
+    dvbpsi_sigen_loop_t *   p_loops;
+    size_t                  i_loops;
+
+    bool                    b_nit;
+    uint8_t                 i_version;
+} dvbpsi_sigen_network_t;
+
+/*****************************************************************************
+ * dvbpsi_sigen_s
+ *****************************************************************************/
+struct dvbpsi_sigen_s
+{
+    dvbpsi_sidb_t *             p_sidb;
+    dvbpsi_sigen_callback       pf_edit;
+    void *                      p_cb_data;
+
+    dvbpsi_sigen_stream_t **    pp_streams;
+    size_t                      i_streams;
+    size_t                      i_streams_size;
+
+    dvbpsi_sigen_network_t **   pp_networks;
+    size_t                      i_networks;
+    size_t                      i_networks_size;
+};
+
+/*****************************************************************************
+ * dvbpsi_sigen_new
+ *****************************************************************************/
+dvbpsi_sigen_t *dvbpsi_sigen_new(dvbpsi_sidb_t *p_sidb, dvbpsi_sigen_callback pf_edit,
+                                 void *p_cb_data)
+{
+    assert(p_sidb);
+
+    dvbpsi_sigen_t *p_sigen = dvbpsi_calloc(1, sizeof(dvbpsi_sigen_t));
+    if (p_sigen == NULL)
+        return NULL;
+
+    p_sigen->p_sidb = p_sidb;
+    p_sigen->pf_edit = pf_edit;
+    p_sigen->p_cb_data = p_cb_data;
+    return p_sigen;
+}
+
+/*****************************************************************************
+ * dvbpsi_sigen_delete
+ *****************************************************************************/
+void dvbpsi_sigen_delete(dvbpsi_sigen_t *p_sigen)
+{
+    if (p_sigen == NULL)
+        return;
+
+    for (size_t i = 0; i < p_sigen->i_streams; i++)
+    {
+        dvbpsi_sigen_stream_t *p_stream = p_sigen->pp_streams[i];
+        for (size_t j = 0; j < p_stream->i_services; j++)
+            dvbpsi_free(p_stream->p_services[j].p_data);
+        dvbpsi_free(p_stream->p_services);
+        dvbpsi_free(p_stream);
+    }
+    dvbpsi_free(p_sigen->pp_streams);
+
+    for (size_t i = 0; i < p_sigen->i_networks; i++)
+    {
+        dvbpsi_sigen_network_t *p_network = p_sigen->pp_networks[i];
+        for (size_t j = 0; j < p_network->i_loops; j++)
+            dvbpsi_free(p_network->p_loops[j].p_data);
+        dvbpsi_free(p_network->p_loops);
+        dvbpsi_free(p_network->p_descriptors);
+        dvbpsi_free(p_network);
+    }
+    dvbpsi_free(p_sigen->pp_networks);
+    dvbpsi_free(p_sigen);
+}
+
+/*****************************************************************************
+ * dvbpsi_sigen_grow
+ *****************************************************************************
+ * Room for one more pointer in an array.
+ *****************************************************************************/
+static bool dvbpsi_sigen_grow(void ***ppp_array, size_t i_count, size_t *pi_size)
+{
+    if (i_count < *pi_size)
+        return true;
+
+    size_t i_size = *pi_size ? 2 * *pi_size : 8;
+    void **pp_array = dvbpsi_malloc(i_size * sizeof(void *));
+    if (pp_array == NULL)
+        return false;
+    if (i_count)
+        memcpy(pp_array, *ppp_array, i_count * sizeof(void *));
+    dvbpsi_free(*ppp_array);
+    *ppp_array = pp_array;
+    *pi_size = i_size;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_sigen_stream/dvbpsi_sigen_network
+ *****************************************************************************
+ * Output of an id, added if b_create.
+ *****************************************************************************/
+static dvbpsi_sigen_stream_t *dvbpsi_sigen_stream(dvbpsi_sigen_t *p_sigen, uint16_t i_ts_id,
+                                                  bool b_create)
+{
+    for (size_t i = 0; i < p_sigen->i_streams; i++)
+        if (p_sigen->pp_streams[i]->i_ts_id == i_ts_id)
+            return p_sigen->pp_streams[i];
+
+    if (!b_create || !dvbpsi_sigen_grow((void ***)&p_sigen->pp_streams, p_sigen->i_streams,
+                                        &p_sigen->i_streams_size))
+        return NULL;
+
+    dvbpsi_sigen_stream_t *p_stream = dvbpsi_calloc(1, sizeof(dvbpsi_sigen_stream_t));
+    if (p_stream == NULL)
+        return NULL;
+    p_stream->i_ts_id = i_ts_id;
+    p_sigen->pp_streams[p_sigen->i_streams++] = p_stream;
+    return p_stream;
+}
+
+static dvbpsi_sigen_network_t *dvbpsi_sigen_network(dvbpsi_sigen_t *p_sigen,
+                                                    uint16_t i_network_id, bool b_create)
+{
+    for (size_t i = 0; i < p_sigen->i_networks; i++)
+        if (p_sigen->pp_networks[i]->i_network_id == i_network_id)
+            return p_sigen->pp_networks[i];
+
+    if (!b_create || !dvbpsi_sigen_grow((void ***)&p_sigen->pp_networks, p_sigen->i_networks,
+                                        &p_sigen->i_networks_size))
+        return NULL;
+
+    dvbpsi_sigen_network_t *p_network = dvbpsi_calloc(1, sizeof(dvbpsi_sigen_network_t));
+    if (p_network == NULL)
+        return NULL;
+    p_network->i_network_id = i_network_id;
+    p_network->b_dirty = true;
+    p_sigen->pp_networks[p_sigen->i_networks++] = p_network;
+    return p_network;
+}
+
+/*****************************************************************************
+ * dvbpsi_sigen_sdt_delta
+ *****************************************************************************/
+void dvbpsi_sigen_sdt_delta(dvbpsi_sigen_t *p_sigen, uint16_t i_ts_id,
+                            const dvbpsi_sdt_delta_t *p_delta)
+{
+    assert(p_sigen);
+    assert(p_delta);
+
+    if (p_delta->b_first)
+        dvbpsi_sigen_invalidate(p_sigen, i_ts_id, 0);
+    for (unsigned int i = 0; i < p_delta->i_services; i++)
+        dvbpsi_sigen_invalidate(p_sigen, i_ts_id, p_delta->p_services[i].i_service_id);
+}
+
+/*****************************************************************************
+ * dvbpsi_sigen_nit_delta
+ *****************************************************************************/
+void dvbpsi_sigen_nit_delta(dvbpsi_sigen_t *p_sigen, uint16_t i_network_id,
+                            const dvbpsi_nit_delta_t *p_delta)
+{
+    assert(p_sigen);
+    assert(p_delta);
+
+    dvbpsi_sigen_network_t *p_network = dvbpsi_sigen_network(p_sigen, i_network_id, false);
+    if (p_network && (p_delta->b_first || p_delta->b_descriptors))
+        p_network->b_dirty = true;
+
+    /* The logical channel numbers come with the transport streams */
+    if (p_delta->b_first)
+    {
+        for (size_t i = 0; i < p_sigen->i_streams; i++)
+            p_sigen->pp_streams[i]->b_dirty = true;
+        for (size_t i = 0; p_network && i < p_network->i_loops; i++)
+            p_network->p_loops[i].b_dirty = true;
+        return;
+    }
+
+    for (unsigned int i = 0; i < p_delta->i_ts; i++)
+    {
+        uint16_t i_ts_id = p_delta->p_ts[i].i_ts_id;
+        dvbpsi_sigen_stream_t *p_stream = dvbpsi_sigen_stream(p_sigen, i_ts_id, false);
+        if (p_stream)
+            p_stream->b_dirty = true;
+        for (size_t j = 0; p_network && j < p_network->i_loops; j++)
+            if (p_network->p_loops[j].i_ts_id == i_ts_id)
+                p_network->p_loops[j].b_dirty = true;
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_sigen_invalidate
+ *****************************************************************************/
+void dvbpsi_sigen_invalidate(dvbpsi_sigen_t *p_sigen, uint16_t i_ts_id,
+                             uint16_t i_service_id)
+{
+    assert(p_sigen);
+
+    dvbpsi_sigen_stream_t *p_stream = dvbpsi_sigen_stream(p_sigen, i_ts_id, false);
+    if (p_stream == NULL)
+        return;
+
+    if (i_service_id == 0)
+        p_stream->b_dirty = true;
+    for (size_t i = 0; i < p_stream->i_services && i_service_id; i++)
+        if (p_stream->p_services[i].i_service_id == i_service_id)
+            p_stream->p_services[i].b_dirty = true;
+}
+
+/*****************************************************************************
+ * dvbpsi_sigen_service_encode
+ *****************************************************************************
+ * Edits a service of the SDT of the database and encodes its SDT entry.
+ *****************************************************************************/
+static bool dvbpsi_sigen_service_encode(dvbpsi_sigen_t *p_sigen, uint16_t i_ts_id,
+                                        const dvbpsi_sdt_service_t *p_service,
+                                        dvbpsi_sigen_service_t *p_out)
+{
+    const dvbpsi_sidb_service_t *p_db = dvbpsi_sidb_find(p_sigen->p_sidb, i_ts_id,
+                                                         p_service->i_service_id);
+    memset(p_out, 0, sizeof(*p_out));
+    p_out->i_service_id = p_service->i_service_id;
+    p_out->i_service_type = 0x01;
+    if (p_db)
+    {
+        p_out->edit.i_lcn = p_db->i_lcn;
+        p_out->edit.b_visible = p_db->b_visible;
+        if (p_sigen->pf_edit)
+            p_sigen->pf_edit(p_sigen->p_cb_data, p_db, &p_out->edit);
+    }
+
+    uint16_t i_size = 5;
+    const dvbpsi_descriptor_t *p_dr;
+    for (p_dr = p_service->p_first_descriptor; p_dr; p_dr = p_dr->p_next)
+    {
+        if (i_size + 2 + p_dr->i_length > DVBPSI_SIGEN_SERVICE)
+            break;
+        i_size += 2 + p_dr->i_length;
+        if (p_dr->i_tag == 0x48 && p_dr->i_length >= 1)
+            p_out->i_service_type = p_dr->p_data[0];
+    }
+
+    p_out->p_data = dvbpsi_malloc(i_size);
+    if (p_out->p_data == NULL)
+        return false;
+    p_out->i_size = i_size;
+
+    uint8_t *p_data = p_out->p_data;
+    uint16_t i_length = i_size - 5;
+    p_data[0] = p_service->i_service_id >> 8;
+    p_data[1] = p_service->i_service_id;
+    p_data[2] = 0xfc | (p_service->b_eit_schedule ? 0x02 : 0x00)
+                     | (p_service->b_eit_present ? 0x01 : 0x00);
+    p_data[3] = ((p_service->i_running_status & 0x07) << 5)
+              | (p_service->b_free_ca ? 0x10 : 0x00) | ((i_length >> 8) & 0x0f);
+    p_data[4] = i_length;
+    p_data += 5;
+    for (p_dr = p_service->p_first_descriptor; p_data < p_out->p_data + i_size; p_dr = p_dr->p_next)
+    {
+        p_data[0] = p_dr->i_tag;
+        p_data[1] = p_dr->i_length;
+        memcpy(p_data + 2, p_dr->p_data, p_dr->i_length);
+        p_data += 2 + p_dr->i_length;
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_sigen_stream_refresh
+ *****************************************************************************
+ * Encodes again the services of a stream marked as changed, and those new
+ * in the SDT of the database, counting a change of the stream if any of
+ * them differs.
+ *****************************************************************************/
+static bool dvbpsi_sigen_stream_refresh(dvbpsi_sigen_t *p_sigen,
+                                        dvbpsi_sigen_stream_t *p_stream)
+{
+    const dvbpsi_sdt_t *p_sdt = dvbpsi_sidb_get_sdt(p_sigen->p_sidb, p_stream->i_ts_id);
+    size_t i_services = 0;
+    for (const dvbpsi_sdt_service_t *p = p_sdt ? p_sdt->p_first_service : NULL; p; p = p->p_next)
+        i_services++;
+
+    dvbpsi_sigen_service_t *p_services = NULL;
+    if (i_services)
+    {
+        p_services = dvbpsi_malloc(i_services * sizeof(dvbpsi_sigen_service_t));
+        if (p_services == NULL)
+            return false;
+    }
+
+    dvbpsi_sigen_service_t *p_old = p_stream->p_services;
+    size_t i_old = p_stream->i_services;
+    uint16_t i_network_id = p_sdt ? p_sdt->i_network_id : 0;
+    bool b_changed = i_services != i_old || i_network_id != p_stream->i_network_id;
+
+    size_t i = 0, j = 0;
+    for (const dvbpsi_sdt_service_t *p = p_sdt ? p_sdt->p_first_service : NULL; p;
+         p = p->p_next, i++)
+    {
+        /* Same order as the previous version, usually */
+        size_t k = j;
+        if (k >= i_old || p_old[k].i_service_id != p->i_service_id)
+            for (k = 0; k < i_old && p_old[k].i_service_id != p->i_service_id; k++)
+                ;
+        if (k != i)
+            b_changed = true;
+
+        if (k < i_old && p_old[k].p_data && !p_old[k].b_dirty && !p_stream->b_dirty)
+        {
+            p_services[i] = p_old[k];
+            p_old[k].p_data = NULL;
+        }
+        else if (dvbpsi_sigen_service_encode(p_sigen, p_stream->i_ts_id, p, &p_services[i]))
+        {
+            dvbpsi_sigen_service_t *p_new = &p_services[i];
+            if (   k == i_old || p_old[k].p_data == NULL
+                || p_old[k].i_size != p_new->i_size
+                || memcmp(p_old[k].p_data, p_new->p_data, p_new->i_size)
+                || p_old[k].edit.b_drop != p_new->edit.b_drop
+                || p_old[k].edit.i_lcn != p_new->edit.i_lcn
+                || p_old[k].edit.b_visible != p_new->edit.b_visible
+                || p_old[k].i_service_type != p_new->i_service_type)
+                b_changed = true;
+        }
+        else
+        {
+            while (i-- > 0)
+                dvbpsi_free(p_services[i].p_data);
+            dvbpsi_free(p_services);
+            return false;
+        }
+        j = k + 1;
+    }
+
+    for (size_t k = 0; k < i_old; k++)
+        dvbpsi_free(p_old[k].p_data);
+    dvbpsi_free(p_old);
+
+    p_stream->p_services = p_services;
+    p_stream->i_services = i_services;
+    p_stream->i_network_id = i_network_id;
+    p_stream->b_dirty = false;
+    if (b_changed)
+        p_stream->i_change++;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_sigen_section
+ *****************************************************************************
+ * New section of an output, its payload_end after the header.
+ *****************************************************************************/
+static dvbpsi_psi_section_t *dvbpsi_sigen_section(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                                                  uint16_t i_extension, uint8_t i_version,
+                                                  uint8_t i_number, bool b_private)
+{
+    dvbpsi_psi_section_t *p_section = dvbpsi_section_buffer_get(p_dvbpsi, DVBPSI_SIGEN_SECTION);
+    if (p_section == NULL)
+        return NULL;
+
+    p_section->i_table_id = i_table_id;
+    p_section->b_syntax_indicator = true;
+    p_section->b_private_indicator = b_private;
+    p_section->i_extension = i_extension;
+    p_section->i_version = i_version;
+    p_section->b_current_next = true;
+    p_section->i_number = i_number;
+    p_section->p_payload_start = p_section->p_data + 8;
+    p_section->p_payload_end = p_section->p_data + 8;
+    return p_section;
+}
+
+/*****************************************************************************
+ * dvbpsi_sigen_build
+ *****************************************************************************
+ * Sets the lengths and numbers of the sections of an output and builds
+ * them.
+ *****************************************************************************/
+static void dvbpsi_sigen_build(dvbpsi_t *p_dvbpsi, dvbpsi_psi_section_t *p_first)
+{
+    uint8_t i_last = 0;
+    for (dvbpsi_psi_section_t *p = p_first; p; p = p->p_next)
+        i_last = p->i_number;
+
+    for (dvbpsi_psi_section_t *p = p_first; p; p = p->p_next)
+    {
+        /* From the byte after section_length to the CRC_32 included */
+        p->i_length = p->p_payload_end - p->p_data - 3 + 4;
+        p->i_last_number = i_last;
+        dvbpsi_BuildPSISection(p_dvbpsi, p);
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_sigen_version
+ *****************************************************************************
+ * Version of an output made of i_change, incremented on a change.
+ *****************************************************************************/
+static bool dvbpsi_sigen_version(bool *pb_made, uint8_t *pi_version, bool b_changed)
+{
+    if (*pb_made && !b_changed)
+        return false;
+    if (*pb_made)
+        *pi_version = (*pi_version + 1) & 0x1f;
+    *pb_made = true;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_sigen_sdt
+ *****************************************************************************/
+dvbpsi_psi_section_t *dvbpsi_sigen_sdt(dvbpsi_sigen_t *p_sigen, dvbpsi_t *p_dvbpsi,
+                                       uint16_t i_ts_id, uint8_t i_table_id,
+                                       bool *pb_changed)
+{
+    assert(p_sigen);
+    assert(pb_changed);
+
+    *pb_changed = false;
+    dvbpsi_sigen_stream_t *p_stream = dvbpsi_sigen_stream(p_sigen, i_ts_id, true);
+    if (p_stream == NULL || !dvbpsi_sigen_stream_refresh(p_sigen, p_stream)
+     || dvbpsi_sidb_get_sdt(p_sigen->p_sidb, i_ts_id) == NULL)
+        return NULL;
+
+    *pb_changed = dvbpsi_sigen_version(&p_stream->b_sdt, &p_stream->i_sdt_version,
+                                       p_stream->i_sdt_change != p_stream->i_change);
+    p_stream->i_sdt_change = p_stream->i_change;
+
+    dvbpsi_psi_section_t *p_first = NULL, *p_current = NULL;
+    size_t i = 0;
+    do
+    {
+        dvbpsi_psi_section_t *p_section = dvbpsi_sigen_section(p_dvbpsi, i_table_id, i_ts_id,
+                                               p_stream->i_sdt_version,
+                                               p_current ? p_current->i_number + 1 : 0, true);
+        if (p_section == NULL)
+        {
+            dvbpsi_DeletePSISections(p_first);
+            return NULL;
+        }
+        if (p_current)
+            p_current->p_next = p_section;
+        else
+            p_first = p_section;
+        p_current = p_section;
+
+        p_current->p_payload_end[0] = p_stream->i_network_id >> 8;
+        p_current->p_payload_end[1] = p_stream->i_network_id;
+        p_current->p_payload_end[2] = 0xff;
+        p_current->p_payload_end += 3;
+
+        for (; i < p_stream->i_services; i++)
+        {
+            const dvbpsi_sigen_service_t *p_service = &p_stream->p_services[i];
+            if (p_service->edit.b_drop)
+                continue;
+            if (p_current->p_payload_end + p_service->i_size + 4
+                    > p_current->p_data + DVBPSI_SIGEN_SECTION)
+                break;
+            memcpy(p_current->p_payload_end, p_service->p_data, p_service->i_size);
+            p_current->p_payload_end += p_service->i_size;
+        }
+    } while (i < p_stream->i_services && p_current->i_number < 255);
+
+    dvbpsi_sigen_build(p_dvbpsi, p_first);
+    return p_first;
+}
+
+/*****************************************************************************
+ * dvbpsi_sigen_descriptors
+ *****************************************************************************
+ * Copies a descriptor loop to p_data up to i_max bytes, less the tags
+ * 0x41 and 0x83 if b_services, and returns its length.
+ *****************************************************************************/
+static size_t dvbpsi_sigen_descriptors(uint8_t *p_data, size_t i_max,
+                                       const dvbpsi_descriptor_t *p_dr, bool b_services)
+{
+    size_t i_size = 0;
+    for (; p_dr; p_dr = p_dr->p_next)
+    {
+        if (b_services && (p_dr->i_tag == 0x41 || p_dr->i_tag == 0x83))
+            continue;
+        if (i_size + 2 + p_dr->i_length > i_max)
+            break;
+        p_data[i_size] = p_dr->i_tag;
+        p_data[i_size + 1] = p_dr->i_length;
+        memcpy(p_data + i_size + 2, p_dr->p_data, p_dr->i_length);
+        i_size += 2 + p_dr->i_length;
+    }
+    return i_size;
+}
+
+/*****************************************************************************
+ * dvbpsi_sigen_loop_encode
+ *****************************************************************************
+ * Encodes the NIT entry of a stream, from the one of the NIT of the
+ * database and its output services.
+ *****************************************************************************/
+static bool dvbpsi_sigen_loop_encode(const dvbpsi_nit_t *p_nit,
+                                     const dvbpsi_sigen_stream_t *p_stream,
+                                     dvbpsi_sigen_loop_t *p_loop)
+{
+    const dvbpsi_nit_ts_t *p_ts = p_nit ? p_nit->p_first_ts : NULL;
+    while (p_ts && p_ts->i_ts_id != p_stream->i_ts_id)
+        p_ts = p_ts->p_next;
+
+    uint8_t p_data[DVBPSI_SIGEN_TS];
+    uint16_t i_network_id = p_ts ? p_ts->i_orig_network_id : p_stream->i_network_id;
+    p_data[0] = p_stream->i_ts_id >> 8;
+    p_data[1] = p_stream->i_ts_id;
+    p_data[2] = i_network_id >> 8;
+    p_data[3] = i_network_id;
+    size_t i_size = 6 + dvbpsi_sigen_descriptors(p_data + 6, DVBPSI_SIGEN_TS - 6,
+                                                 p_ts ? p_ts->p_first_descriptor : NULL,
+                                                 true);
+
+    /* service_list_descriptors, then logical_channel_descriptors, of up
+     * to 85 and 63 services */
+    for (int i_tag = 0x41; i_tag; i_tag = i_tag == 0x41 ? 0x83 : 0)
+    {
+        unsigned int i_entry = i_tag == 0x41 ? 3 : 4;
+        uint8_t *p_dr = NULL;
+        for (size_t i = 0; i < p_stream->i_services; i++)
+        {
+            const dvbpsi_sigen_service_t *p_service = &p_stream->p_services[i];
+            if (p_service->edit.b_drop || (i_tag == 0x83 && p_service->edit.i_lcn == 0))
+                continue;
+            if (p_dr == NULL || p_dr[1] + i_entry > 255)
+            {
+                if (i_size + 2 + i_entry > DVBPSI_SIGEN_TS)
+                    break;
+                p_dr = p_data + i_size;
+                p_dr[0] = i_tag;
+                p_dr[1] = 0;
+                i_size += 2;
+            }
+            else if (i_size + i_entry > DVBPSI_SIGEN_TS)
+                break;
+
+            uint8_t *p_entry = p_data + i_size;
+            p_entry[0] = p_service->i_service_id >> 8;
+            p_entry[1] = p_service->i_service_id;
+            if (i_tag == 0x41)
+                p_entry[2] = p_service->i_service_type;
+            else
+            {
+                p_entry[2] = (p_service->edit.b_visible ? 0x80 : 0x00) | 0x7c
+                           | ((p_service->edit.i_lcn >> 8) & 0x03);
+                p_entry[3] = p_service->edit.i_lcn;
+            }
+            p_dr[1] += i_entry;
+            i_size += i_entry;
+        }
+    }
+
+    uint16_t i_length = i_size - 6;
+    p_data[4] = 0xf0 | ((i_length >> 8) & 0x0f);
+    p_data[5] = i_length;
+
+    p_loop->p_data = dvbpsi_malloc(i_size);
+    if (p_loop->p_data == NULL)
+        return false;
+    memcpy(p_loop->p_data, p_data, i_size);
+    p_loop->i_size = i_size;
+    p_loop->i_ts_id = p_stream->i_ts_id;
+    p_loop->i_change = p_stream->i_change;
+    p_loop->b_dirty = false;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_sigen_network_refresh
+ *****************************************************************************
+ * Encodes again the network descriptors and the transport streams of a NIT
+ * marked as changed, or whose services changed, returning in pb_changed
+ * whether any of them differs.
+ *****************************************************************************/
+static bool dvbpsi_sigen_network_refresh(dvbpsi_sigen_t *p_sigen,
+                                         dvbpsi_sigen_network_t *p_network,
+                                         const uint16_t *pi_ts_ids, size_t i_ts_ids,
+                                         bool *pb_changed)
+{
+    const dvbpsi_nit_t *p_nit = dvbpsi_sidb_get_nit(p_sigen->p_sidb, p_network->i_network_id);
+
+    if (p_network->b_dirty)
+    {
+        uint8_t p_data[DVBPSI_SIGEN_TS];
+        size_t i_size = dvbpsi_sigen_descriptors(p_data, DVBPSI_SIGEN_TS,
+                                                 p_nit ? p_nit->p_first_descriptor : NULL,
+                                                 false);
+        if (i_size != p_network->i_descriptors
+         || (i_size && memcmp(p_data, p_network->p_descriptors, i_size)))
+        {
+            uint8_t *p_descriptors = NULL;
+            if (i_size && (p_descriptors = dvbpsi_malloc(i_size)) == NULL)
+                return false;
+            if (i_size)
+                memcpy(p_descriptors, p_data, i_size);
+            dvbpsi_free(p_network->p_descriptors);
+            p_network->p_descriptors = p_descriptors;
+            p_network->i_descriptors = i_size;
+            *pb_changed = true;
+        }
+        p_network->b_dirty = false;
+    }
+
+    dvbpsi_sigen_loop_t *p_loops = NULL;
+    if (i_ts_ids)
+    {
+        p_loops = dvbpsi_malloc(i_ts_ids * sizeof(dvbpsi_sigen_loop_t));
+        if (p_loops == NULL)
+            return false;
+    }
+
+    dvbpsi_sigen_loop_t *p_old = p_network->p_loops;
+    size_t i_old = p_network->i_loops;
+    if (i_ts_ids != i_old)
+        *pb_changed = true;
+
+    size_t i;
+    for (i = 0; i < i_ts_ids; i++)
+    {
+        dvbpsi_sigen_stream_t *p_stream = dvbpsi_sigen_stream(p_sigen, pi_ts_ids[i], true);
+        if (p_stream == NULL || !dvbpsi_sigen_stream_refresh(p_sigen, p_stream))
+            break;
+
+        size_t k = i;
+        if (k >= i_old || p_old[k].i_ts_id != pi_ts_ids[i])
+            for (k = 0; k < i_old && p_old[k].i_ts_id != pi_ts_ids[i]; k++)
+                ;
+        if (k != i)
+            *pb_changed = true;
+
+        if (   k < i_old && p_old[k].p_data && !p_old[k].b_dirty
+            && p_old[k].i_change == p_stream->i_change)
+        {
+            p_loops[i] = p_old[k];
+            p_old[k].p_data = NULL;
+        }
+        else if (dvbpsi_sigen_loop_encode(p_nit, p_stream, &p_loops[i]))
+        {
+            if (   k == i_old || p_old[k].p_data == NULL
+                || p_old[k].i_size != p_loops[i].i_size
+                || memcmp(p_old[k].p_data, p_loops[i].p_data, p_loops[i].i_size))
+                *pb_changed = true;
+        }
+        else
+            break;
+    }
+    if (i < i_ts_ids)
+    {
+        while (i-- > 0)
+            dvbpsi_free(p_loops[i].p_data);
+        dvbpsi_free(p_loops);
+        return false;
+    }
+
+    for (size_t k = 0; k < i_old; k++)
+        dvbpsi_free(p_old[k].p_data);
+    dvbpsi_free(p_old);
+    p_network->p_loops = p_loops;
+    p_network->i_loops = i_ts_ids;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_sigen_nit
+ *****************************************************************************/
+dvbpsi_psi_section_t *dvbpsi_sigen_nit(dvbpsi_sigen_t *p_sigen, dvbpsi_t *p_dvbpsi,
+                                       uint16_t i_network_id, uint8_t i_table_id,
+                                       const uint16_t *pi_ts_ids, size_t i_ts_ids,
+                                       bool *pb_changed)
+{
+    assert(p_sigen);
+    assert(pb_changed);
+
+    *pb_changed = false;
+    bool b_changed = false;
+    dvbpsi_sigen_network_t *p_network = dvbpsi_sigen_network(p_sigen, i_network_id, true);
+    if (p_network == NULL
+     || !dvbpsi_sigen_network_refresh(p_sigen, p_network, pi_ts_ids, i_ts_ids, &b_changed))
+        return NULL;
+
+    *pb_changed = dvbpsi_sigen_version(&p_network->b_nit, &p_network->i_version, b_changed);
+
+    dvbpsi_psi_section_t *p_first = NULL, *p_current = NULL;
+    size_t i = 0;
+    do
+    {
+        dvbpsi_psi_section_t *p_section = dvbpsi_sigen_section(p_dvbpsi, i_table_id,
+                                               i_network_id, p_network->i_version,
+                                               p_current ? p_current->i_number + 1 : 0, false);
+        if (p_section == NULL)
+        {
+            dvbpsi_DeletePSISections(p_first);
+            return NULL;
+        }
+        if (p_current)
+            p_current->p_next = p_section;
+        else
+            p_first = p_section;
+        p_current = p_section;
+
+        /* The network descriptors in the first section */
+        uint16_t i_descriptors = p_current == p_first ? p_network->i_descriptors : 0;
+        uint8_t *p_data = p_current->p_payload_end;
+        p_data[0] = 0xf0 | ((i_descriptors >> 8) & 0x0f);
+        p_data[1] = i_descriptors;
+        if (i_descriptors)
+            memcpy(p_data + 2, p_network->p_descriptors, i_descriptors);
+        uint8_t *p_loop = p_data + 2 + i_descriptors;
+        p_current->p_payload_end = p_loop + 2;
+
+        for (; i < p_network->i_loops; i++)
+        {
+            const dvbpsi_sigen_loop_t *p_ts = &p_network->p_loops[i];
+            if (p_current->p_payload_end + p_ts->i_size + 4
+                    > p_current->p_data + DVBPSI_SIGEN_SECTION)
+                break;
+            memcpy(p_current->p_payload_end, p_ts->p_data, p_ts->i_size);
+            p_current->p_payload_end += p_ts->i_size;
+        }
+
+        /* transport_stream_loop_length */
+        uint16_t i_length = p_current->p_payload_end - p_loop - 2;
+        p_loop[0] = 0xf0 | ((i_length >> 8) & 0x0f);
+        p_loop[1] = i_length;
+    } while (i < p_network->i_loops && p_current->i_number < 255);
+
+    dvbpsi_sigen_build(p_dvbpsi, p_first);
+    return p_first;
+}
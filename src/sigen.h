@@ -0,0 +1,221 @@
+/*****************************************************************************
+ * sigen.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <sigen.h>
+ * \brief SDTs and NITs generated from a service information database.
+ *
+ * A generator derives output SDTs and NITs, for a regional remultiplexing
+ * for instance, from the tables kept by a dvbpsi_sidb_t, with edits made
+ * by a callback for each service: leaving it out, or changing its logical
+ * channel number. It keeps the encoded loop entry of each service and
+ * transport stream of its outputs, and only encodes again the ones the
+ * deltas of the input tables, from dvbpsi_sdt_set_delta_callback() and
+ * dvbpsi_nit_set_delta_callback(), or dvbpsi_sigen_invalidate() mark as
+ * changed. Generating an output then lays out the kept entries into
+ * sections; with DVBPSI_FLAG_ENCODER_CACHE set on the handle given to the
+ * generation, the sections left unchanged also keep their CRC_32.
+ *
+ * The deltas of a table are given to the generator from the delta callback
+ * of its decoder, and the table to the database from its table callback,
+ * before the outputs are generated again.
+ */
+
+#ifndef _DVBPSI_SIGEN_H_
+#define _DVBPSI_SIGEN_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_sigen_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_sigen_s dvbpsi_sigen_t
+ * \brief dvbpsi_sigen_t type definition, an opaque generator.
+ */
+typedef struct dvbpsi_sigen_s dvbpsi_sigen_t;
+
+/*****************************************************************************
+ * dvbpsi_sigen_edit_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_sigen_edit_s
+ * \brief Edit of a service in the outputs of a generator.
+ */
+/*!
+ * \typedef struct dvbpsi_sigen_edit_s dvbpsi_sigen_edit_t
+ * \brief dvbpsi_sigen_edit_t type definition.
+ */
+typedef struct dvbpsi_sigen_edit_s
+{
+    bool        b_drop;         /*!< leave the service out of the outputs */
+    uint16_t    i_lcn;          /*!< logical_channel_number of the output
+                                     NITs, 0 for none */
+    bool        b_visible;      /*!< visible_service_flag of the LCN */
+} dvbpsi_sigen_edit_t;
+
+/*!
+ * \typedef void (* dvbpsi_sigen_callback)(void *p_cb_data,
+ *                                         const dvbpsi_sidb_service_t *p_service,
+ *                                         dvbpsi_sigen_edit_t *p_edit)
+ * \brief Edit callback type definition, p_edit being filled with the
+ * service as the database has it, kept, with its logical channel number.
+ */
+typedef void (* dvbpsi_sigen_callback)(void *p_cb_data,
+                                       const dvbpsi_sidb_service_t *p_service,
+                                       dvbpsi_sigen_edit_t *p_edit);
+
+/*****************************************************************************
+ * dvbpsi_sigen_new/dvbpsi_sigen_delete
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_sigen_t *dvbpsi_sigen_new(dvbpsi_sidb_t *p_sidb,
+ *                                     dvbpsi_sigen_callback pf_edit,
+ *                                     void *p_cb_data)
+ * \brief Creates a generator without any output yet
+ * \param p_sidb database of the input tables, which must outlive the
+ *        generator
+ * \param pf_edit function called when a service is encoded, NULL to keep
+ *        the services as they are
+ * \param p_cb_data data given to pf_edit
+ * \return the new generator, NULL on error.
+ */
+dvbpsi_sigen_t *dvbpsi_sigen_new(dvbpsi_sidb_t *p_sidb, dvbpsi_sigen_callback pf_edit,
+                                 void *p_cb_data);
+
+/*!
+ * \fn void dvbpsi_sigen_delete(dvbpsi_sigen_t *p_sigen)
+ * \brief Deletes a generator
+ * \param p_sigen generator, or NULL
+ * \return nothing.
+ */
+void dvbpsi_sigen_delete(dvbpsi_sigen_t *p_sigen);
+
+/*****************************************************************************
+ * dvbpsi_sigen_sdt_delta/dvbpsi_sigen_nit_delta/dvbpsi_sigen_invalidate
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_sigen_sdt_delta(dvbpsi_sigen_t *p_sigen, uint16_t i_ts_id,
+ *                                 const dvbpsi_sdt_delta_t *p_delta)
+ * \brief Marks the services changed by a new SDT
+ * \param p_sigen generator
+ * \param i_ts_id transport_stream_id of the SDT
+ * \param p_delta changes, as given to the SDT delta callback
+ * \return nothing.
+ */
+void dvbpsi_sigen_sdt_delta(dvbpsi_sigen_t *p_sigen, uint16_t i_ts_id,
+                            const dvbpsi_sdt_delta_t *p_delta);
+
+/*!
+ * \fn void dvbpsi_sigen_nit_delta(dvbpsi_sigen_t *p_sigen, uint16_t i_network_id,
+ *                                 const dvbpsi_nit_delta_t *p_delta)
+ * \brief Marks the transport streams changed by a new NIT
+ * \param p_sigen generator
+ * \param i_network_id network_id of the NIT
+ * \param p_delta changes, as given to the NIT delta callback
+ * \return nothing.
+ *
+ * The logical channel numbers of the transport streams are those of their
+ * services, which are encoded again.
+ */
+void dvbpsi_sigen_nit_delta(dvbpsi_sigen_t *p_sigen, uint16_t i_network_id,
+                            const dvbpsi_nit_delta_t *p_delta);
+
+/*!
+ * \fn void dvbpsi_sigen_invalidate(dvbpsi_sigen_t *p_sigen, uint16_t i_ts_id,
+ *                                  uint16_t i_service_id)
+ * \brief Marks a service as changed, after a change of its edit
+ * \param p_sigen generator
+ * \param i_ts_id transport_stream_id
+ * \param i_service_id service_id, 0 for all the services of the stream
+ * \return nothing.
+ */
+void dvbpsi_sigen_invalidate(dvbpsi_sigen_t *p_sigen, uint16_t i_ts_id,
+                             uint16_t i_service_id);
+
+/*****************************************************************************
+ * dvbpsi_sigen_sdt
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_psi_section_t *dvbpsi_sigen_sdt(dvbpsi_sigen_t *p_sigen,
+ *                                           dvbpsi_t *p_dvbpsi, uint16_t i_ts_id,
+ *                                           uint8_t i_table_id, bool *pb_changed)
+ * \brief Generates the output SDT of a transport stream
+ * \param p_sigen generator
+ * \param p_dvbpsi handle building the sections
+ * \param i_ts_id transport_stream_id
+ * \param i_table_id 0x42 for an actual SDT, 0x46 for an other SDT
+ * \param pb_changed filled with true if the output changed since it was
+ *        last generated, its version_number being then incremented
+ * \return the sections, to be deleted with dvbpsi_DeletePSISections(), or
+ *         NULL if the database has no SDT for the stream or on error.
+ *
+ * The services are those of the SDT of the database, in its order, less
+ * the ones left out by the edits.
+ */
+dvbpsi_psi_section_t *dvbpsi_sigen_sdt(dvbpsi_sigen_t *p_sigen, dvbpsi_t *p_dvbpsi,
+                                       uint16_t i_ts_id, uint8_t i_table_id,
+                                       bool *pb_changed);
+
+/*****************************************************************************
+ * dvbpsi_sigen_nit
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_psi_section_t *dvbpsi_sigen_nit(dvbpsi_sigen_t *p_sigen,
+ *                                           dvbpsi_t *p_dvbpsi,
+ *                                           uint16_t i_network_id,
+ *                                           uint8_t i_table_id,
+ *                                           const uint16_t *pi_ts_ids,
+ *                                           size_t i_ts_ids, bool *pb_changed)
+ * \brief Generates an output NIT
+ * \param p_sigen generator
+ * \param p_dvbpsi handle building the sections
+ * \param i_network_id network_id of the NIT of the database the output
+ *        derives from
+ * \param i_table_id 0x40 for an actual NIT, 0x41 for an other NIT
+ * \param pi_ts_ids transport_stream_ids of the output transport streams
+ * \param i_ts_ids number of transport streams
+ * \param pb_changed filled with true if the output changed since it was
+ *        last generated, its version_number being then incremented
+ * \return the sections, to be deleted with dvbpsi_DeletePSISections(), or
+ *         NULL on error.
+ *
+ * The network descriptors, and the descriptors of each transport stream
+ * other than the service_list_descriptors and logical_channel_descriptors,
+ * are those of the NIT of the database. The service_list_descriptor and
+ * the logical_channel_descriptor, tag 0x83, of each transport stream are
+ * made from the output services of its SDT.
+ */
+dvbpsi_psi_section_t *dvbpsi_sigen_nit(dvbpsi_sigen_t *p_sigen, dvbpsi_t *p_dvbpsi,
+                                       uint16_t i_network_id, uint8_t i_table_id,
+                                       const uint16_t *pi_ts_ids, size_t i_ts_ids,
+                                       bool *pb_changed);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of sigen.h"
+#endif
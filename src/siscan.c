@@ -0,0 +1,318 @@
+/*****************************************************************************
+ * siscan.c: SI acquisition for network scans
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "descriptor.h"
+#include "router.h"
+#include "tables/pat.h"
+#include "tables/pmt.h"
+#include "tables/nit.h"
+#include "tables/sdt.h"
+#include "tables/atsc_mgt.h"
+#include "tables/atsc_vct.h"
+#include "discovery.h"
+#include "siscan.h"
+
+/*****************************************************************************
+ * dvbpsi_siscan_program_t
+ *****************************************************************************
+ * Program of the last PAT, and whether its PMT was acquired.
+ *****************************************************************************/
+typedef struct dvbpsi_siscan_program_s
+{
+    uint16_t                i_number;
+    bool                    b_pmt;
+} dvbpsi_siscan_program_t;
+
+struct dvbpsi_siscan_s
+{
+    dvbpsi_discovery_t *        p_discovery;
+
+    uint32_t                    i_required;
+    uint32_t                    i_acquired;
+    enum dvbpsi_siscan_state    i_state;
+    bool                        b_stopped;      /* PIDs detached */
+
+    uint64_t                    i_timeout;
+    uint64_t                    i_start;
+    bool                        b_started;
+
+    dvbpsi_discovery_callback   pf_table;
+    dvbpsi_siscan_callback      pf_done;
+    void *                      p_cb_data;
+
+    /* Programs of the last PAT */
+    dvbpsi_siscan_program_t *   p_programs;
+    size_t                      i_programs;
+};
+
+/*****************************************************************************
+ * dvbpsi_siscan_end
+ *****************************************************************************
+ * Ends a pending session.
+ *****************************************************************************/
+static void dvbpsi_siscan_end(dvbpsi_siscan_t *p_siscan, enum dvbpsi_siscan_state i_state)
+{
+    if (p_siscan->i_state != DVBPSI_SISCAN_PENDING)
+        return;
+
+    p_siscan->i_state = i_state;
+    if (p_siscan->pf_done)
+        p_siscan->pf_done(p_siscan->p_cb_data, i_state, p_siscan->i_acquired);
+}
+
+/***** dvbpsi_siscan_pat ***** Follows the programs of a new PAT *****/
+static void dvbpsi_siscan_pat(dvbpsi_siscan_t *p_siscan, const dvbpsi_pat_t *p_pat)
+{
+    size_t i_programs = 0;
+    for (const dvbpsi_pat_program_t *p = p_pat->p_first_program; p; p = p->p_next)
+        i_programs++;
+
+    dvbpsi_siscan_program_t *p_programs = NULL;
+    if (i_programs)
+    {
+        p_programs = dvbpsi_malloc(i_programs * sizeof(dvbpsi_siscan_program_t));
+        if (p_programs == NULL)
+            return;     /* the PMTs stay missing */
+    }
+
+    /* The PMTs of the programs of the previous PAT stay acquired */
+    size_t i = 0;
+    for (const dvbpsi_pat_program_t *p = p_pat->p_first_program; p; p = p->p_next)
+    {
+        if (p->i_number == 0)
+            continue;
+        p_programs[i].i_number = p->i_number;
+        p_programs[i].b_pmt = false;
+        for (size_t j = 0; j < p_siscan->i_programs; j++)
+            if (p_siscan->p_programs[j].i_number == p->i_number)
+                p_programs[i].b_pmt = p_siscan->p_programs[j].b_pmt;
+        i++;
+    }
+    dvbpsi_free(p_siscan->p_programs);
+    p_siscan->p_programs = p_programs;
+    p_siscan->i_programs = i;
+    p_siscan->i_acquired |= DVBPSI_SISCAN_PAT;
+}
+
+/***** dvbpsi_siscan_pmts ***** Whether the PMTs of the PAT are acquired *****/
+static bool dvbpsi_siscan_pmts(const dvbpsi_siscan_t *p_siscan)
+{
+    if (!(p_siscan->i_acquired & DVBPSI_SISCAN_PAT))
+        return false;
+    for (size_t i = 0; i < p_siscan->i_programs; i++)
+        if (!p_siscan->p_programs[i].b_pmt)
+            return false;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_siscan_table
+ *****************************************************************************
+ * Records a new table of the discovery engine.
+ *****************************************************************************/
+static void dvbpsi_siscan_table(void *p_data, uint16_t i_pid, uint8_t i_table_id,
+                                void *p_table)
+{
+    dvbpsi_siscan_t *p_siscan = (dvbpsi_siscan_t *)p_data;
+
+    switch (i_table_id)
+    {
+    case 0x00:
+        if (((dvbpsi_pat_t *)p_table)->b_current_next)
+            dvbpsi_siscan_pat(p_siscan, (dvbpsi_pat_t *)p_table);
+        break;
+    case 0x02:
+    {
+        const dvbpsi_pmt_t *p_pmt = (dvbpsi_pmt_t *)p_table;
+        if (p_pmt->b_current_next)
+            for (size_t i = 0; i < p_siscan->i_programs; i++)
+                if (p_siscan->p_programs[i].i_number == p_pmt->i_program_number)
+                    p_siscan->p_programs[i].b_pmt = true;
+        break;
+    }
+    case 0x40:
+        if (((dvbpsi_nit_t *)p_table)->b_current_next)
+            p_siscan->i_acquired |= DVBPSI_SISCAN_NIT;
+        break;
+    case 0x42:
+        if (((dvbpsi_sdt_t *)p_table)->b_current_next)
+            p_siscan->i_acquired |= DVBPSI_SISCAN_SDT;
+        break;
+    case 0xc7:
+        if (((dvbpsi_atsc_mgt_t *)p_table)->b_current_next)
+            p_siscan->i_acquired |= DVBPSI_SISCAN_MGT;
+        break;
+    case 0xc8:
+    case 0xc9:
+        if (((dvbpsi_atsc_vct_t *)p_table)->b_current_next)
+            p_siscan->i_acquired |= DVBPSI_SISCAN_VCT;
+        break;
+    }
+    if (dvbpsi_siscan_pmts(p_siscan))
+        p_siscan->i_acquired |= DVBPSI_SISCAN_PMT;
+    else
+        p_siscan->i_acquired &= ~DVBPSI_SISCAN_PMT;
+
+    if (p_siscan->pf_table)
+        p_siscan->pf_table(p_siscan->p_cb_data, i_pid, i_table_id, p_table);
+    else
+    {
+        switch (i_table_id)
+        {
+        case 0x00: dvbpsi_pat_delete((dvbpsi_pat_t *)p_table); break;
+        case 0x02: dvbpsi_pmt_delete((dvbpsi_pmt_t *)p_table); break;
+        case 0x40: dvbpsi_nit_delete((dvbpsi_nit_t *)p_table); break;
+        case 0x42: dvbpsi_sdt_delete((dvbpsi_sdt_t *)p_table); break;
+        case 0xc7: dvbpsi_atsc_DeleteMGT((dvbpsi_atsc_mgt_t *)p_table); break;
+        case 0xc8:
+        case 0xc9: dvbpsi_atsc_DeleteVCT((dvbpsi_atsc_vct_t *)p_table); break;
+        }
+    }
+
+    if ((p_siscan->i_acquired & p_siscan->i_required) == p_siscan->i_required)
+        dvbpsi_siscan_end(p_siscan, DVBPSI_SISCAN_COMPLETE);
+}
+
+/*****************************************************************************
+ * dvbpsi_siscan_new
+ *****************************************************************************/
+dvbpsi_siscan_t *dvbpsi_siscan_new(dvbpsi_router_t *p_router, uint32_t i_flags,
+                                   uint32_t i_required, uint64_t i_timeout,
+                                   dvbpsi_discovery_callback pf_table,
+                                   dvbpsi_siscan_callback pf_done, void *p_cb_data)
+{
+    assert(p_router);
+
+    dvbpsi_siscan_t *p_siscan = dvbpsi_calloc(1, sizeof(dvbpsi_siscan_t));
+    if (p_siscan == NULL)
+        return NULL;
+
+    p_siscan->i_required = i_required;
+    p_siscan->i_timeout = i_timeout;
+    p_siscan->pf_table = pf_table;
+    p_siscan->pf_done = pf_done;
+    p_siscan->p_cb_data = p_cb_data;
+    p_siscan->i_state = DVBPSI_SISCAN_PENDING;
+
+    /* The table_ids of the set, nothing else */
+    uint8_t pi_tables[32];
+    memset(pi_tables, 0, sizeof(pi_tables));
+#define DVBPSI_SISCAN_TABLE(i_table_id) \
+    pi_tables[(i_table_id) >> 3] |= 1 << ((i_table_id) & 7)
+    if (i_required & (DVBPSI_SISCAN_PAT | DVBPSI_SISCAN_PMT))
+        DVBPSI_SISCAN_TABLE(0x00);
+    if (i_required & DVBPSI_SISCAN_PMT)
+        DVBPSI_SISCAN_TABLE(0x02);
+    if (i_required & DVBPSI_SISCAN_NIT)
+        DVBPSI_SISCAN_TABLE(0x40);
+    if (i_required & DVBPSI_SISCAN_SDT)
+        DVBPSI_SISCAN_TABLE(0x42);
+    if (i_required & DVBPSI_SISCAN_MGT)
+        DVBPSI_SISCAN_TABLE(0xc7);
+    if (i_required & DVBPSI_SISCAN_VCT)
+    {
+        DVBPSI_SISCAN_TABLE(0xc8);
+        DVBPSI_SISCAN_TABLE(0xc9);
+    }
+#undef DVBPSI_SISCAN_TABLE
+
+    p_siscan->p_discovery = dvbpsi_discovery_new(p_router, i_flags, NULL, DVBPSI_MSG_NONE,
+                                                 dvbpsi_siscan_table, p_siscan);
+    if (p_siscan->p_discovery == NULL)
+    {
+        dvbpsi_free(p_siscan);
+        return NULL;
+    }
+    dvbpsi_discovery_set_tables(p_siscan->p_discovery, pi_tables);
+
+    /* An empty set is complete at once */
+    if (i_required == 0)
+        dvbpsi_siscan_end(p_siscan, DVBPSI_SISCAN_COMPLETE);
+    return p_siscan;
+}
+
+/*****************************************************************************
+ * dvbpsi_siscan_delete
+ *****************************************************************************/
+void dvbpsi_siscan_delete(dvbpsi_siscan_t *p_siscan)
+{
+    if (p_siscan == NULL)
+        return;
+
+    dvbpsi_discovery_delete(p_siscan->p_discovery);
+    dvbpsi_free(p_siscan->p_programs);
+    dvbpsi_free(p_siscan);
+}
+
+/*****************************************************************************
+ * dvbpsi_siscan_poll
+ *****************************************************************************/
+enum dvbpsi_siscan_state dvbpsi_siscan_poll(dvbpsi_siscan_t *p_siscan, uint64_t i_now)
+{
+    assert(p_siscan);
+
+    if (!p_siscan->b_started)
+    {
+        p_siscan->i_start = i_now;
+        p_siscan->b_started = true;
+    }
+    if (p_siscan->i_timeout && i_now >= p_siscan->i_start
+     && i_now - p_siscan->i_start >= p_siscan->i_timeout)
+        dvbpsi_siscan_end(p_siscan, DVBPSI_SISCAN_TIMEOUT);
+
+    /* Nothing more to acquire */
+    if (p_siscan->i_state != DVBPSI_SISCAN_PENDING && !p_siscan->b_stopped)
+    {
+        static const uint8_t pi_none[32];
+        dvbpsi_discovery_set_tables(p_siscan->p_discovery, pi_none);
+        p_siscan->b_stopped = true;
+    }
+    return p_siscan->i_state;
+}
+
+/*****************************************************************************
+ * dvbpsi_siscan_acquired
+ *****************************************************************************/
+uint32_t dvbpsi_siscan_acquired(const dvbpsi_siscan_t *p_siscan)
+{
+    assert(p_siscan);
+    return p_siscan->i_acquired;
+}
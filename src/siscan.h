@@ -0,0 +1,189 @@
+/*****************************************************************************
+ * siscan.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <siscan.h>
+ * \brief SI acquisition for network scans.
+ *
+ * Drives an SI discovery engine to acquire a minimal set of tables from a
+ * transponder, such as the PAT, the SDT actual and the NIT actual, and
+ * tells the moment the set is complete, or its timeout expired, so that a
+ * blind scan leaves each transponder after about one repetition of its
+ * tables. The sections of the tables outside the set, the EITs included,
+ * are filtered out before assembly.
+ */
+
+#ifndef _DVBPSI_SISCAN_H_
+#define _DVBPSI_SISCAN_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_siscan_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_siscan_s dvbpsi_siscan_t
+ * \brief dvbpsi_siscan_t type definition, an opaque scan session.
+ */
+typedef struct dvbpsi_siscan_s dvbpsi_siscan_t;
+
+/*!
+ * \def DVBPSI_SISCAN_PAT
+ * \brief The PAT.
+ */
+#define DVBPSI_SISCAN_PAT 0x01
+/*!
+ * \def DVBPSI_SISCAN_PMT
+ * \brief The PMTs of all the programs of the last PAT.
+ */
+#define DVBPSI_SISCAN_PMT 0x02
+/*!
+ * \def DVBPSI_SISCAN_NIT
+ * \brief The NIT actual, table_id 0x40.
+ */
+#define DVBPSI_SISCAN_NIT 0x04
+/*!
+ * \def DVBPSI_SISCAN_SDT
+ * \brief The SDT actual, table_id 0x42.
+ */
+#define DVBPSI_SISCAN_SDT 0x08
+/*!
+ * \def DVBPSI_SISCAN_MGT
+ * \brief The ATSC MGT.
+ */
+#define DVBPSI_SISCAN_MGT 0x10
+/*!
+ * \def DVBPSI_SISCAN_VCT
+ * \brief The ATSC terrestrial or cable VCT.
+ */
+#define DVBPSI_SISCAN_VCT 0x20
+
+/*!
+ * \enum dvbpsi_siscan_state
+ * \brief State of a scan session
+ */
+enum dvbpsi_siscan_state
+{
+    DVBPSI_SISCAN_PENDING = 0,  /*!< tables of the set are missing */
+    DVBPSI_SISCAN_COMPLETE,     /*!< all the tables of the set were acquired */
+    DVBPSI_SISCAN_TIMEOUT,      /*!< the timeout expired first */
+};
+
+/*****************************************************************************
+ * dvbpsi_siscan_callback
+ *****************************************************************************/
+/*!
+ * \typedef void (* dvbpsi_siscan_callback)(void *p_cb_data,
+ *                                          enum dvbpsi_siscan_state i_state,
+ *                                          uint32_t i_acquired)
+ * \brief Callback type definition, called once when a session completes
+ * or times out.
+ * i_acquired holds the DVBPSI_SISCAN_* of the tables acquired.
+ */
+typedef void (* dvbpsi_siscan_callback)(void *p_cb_data,
+                                        enum dvbpsi_siscan_state i_state,
+                                        uint32_t i_acquired);
+
+/*****************************************************************************
+ * dvbpsi_siscan_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_siscan_t *dvbpsi_siscan_new(dvbpsi_router_t *p_router,
+ *                                        uint32_t i_flags,
+ *                                        uint32_t i_required,
+ *                                        uint64_t i_timeout,
+ *                                        dvbpsi_discovery_callback pf_table,
+ *                                        dvbpsi_siscan_callback pf_done,
+ *                                        void *p_cb_data)
+ * \brief Creates a scan session on a router
+ * \param p_router PID router the transport stream is pushed into, which
+ *        must stay valid until the session is deleted
+ * \param i_flags DVBPSI_FLAG_* options of the handles of the session
+ * \param i_required DVBPSI_SISCAN_* of the set of tables to acquire
+ * \param i_timeout time in microseconds after the first call of
+ *        dvbpsi_siscan_poll() the session gives up, 0 for none
+ * \param pf_table function called with each table of the set, as with
+ *        dvbpsi_discovery_new(), or NULL for the session to delete them
+ * \param pf_done function called when the set is complete or the timeout
+ *        expired, or NULL
+ * \param p_cb_data private data given in argument to the callbacks
+ * \return pointer to the session, or NULL on error
+ *
+ * Only the current tables count. The PAT is also given to pf_table when
+ * the PMTs are required. pf_done is called from the callback of the last
+ * table of the set, before the next TS packet is pushed.
+ */
+dvbpsi_siscan_t *dvbpsi_siscan_new(dvbpsi_router_t *p_router, uint32_t i_flags,
+                                   uint32_t i_required, uint64_t i_timeout,
+                                   dvbpsi_discovery_callback pf_table,
+                                   dvbpsi_siscan_callback pf_done, void *p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_siscan_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_siscan_delete(dvbpsi_siscan_t *p_siscan)
+ * \brief Detaches the PIDs of a session from its router and deletes it
+ * \param p_siscan pointer to the session
+ * \return nothing
+ */
+void dvbpsi_siscan_delete(dvbpsi_siscan_t *p_siscan);
+
+/*****************************************************************************
+ * dvbpsi_siscan_poll
+ *****************************************************************************/
+/*!
+ * \fn enum dvbpsi_siscan_state dvbpsi_siscan_poll(dvbpsi_siscan_t *p_siscan,
+ *                                                 uint64_t i_now)
+ * \brief Checks the timeout of a session
+ * \param p_siscan pointer to the session
+ * \param i_now current time in microseconds, the first call starting the
+ *        timeout
+ * \return the state of the session.
+ *
+ * Once the session is complete or timed out, its PIDs are detached from
+ * the router, and the packets pushed afterwards are ignored. It must not
+ * be called from the callbacks of the session.
+ */
+enum dvbpsi_siscan_state dvbpsi_siscan_poll(dvbpsi_siscan_t *p_siscan, uint64_t i_now);
+
+/*****************************************************************************
+ * dvbpsi_siscan_acquired
+ *****************************************************************************/
+/*!
+ * \fn uint32_t dvbpsi_siscan_acquired(const dvbpsi_siscan_t *p_siscan)
+ * \brief Gets the tables a session acquired so far
+ * \param p_siscan pointer to the session
+ * \return the DVBPSI_SISCAN_* of the tables acquired, which may include
+ *         tables outside the set.
+ */
+uint32_t dvbpsi_siscan_acquired(const dvbpsi_siscan_t *p_siscan);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of siscan.h"
+#endif
@@ -0,0 +1,227 @@
+/*****************************************************************************
+ * snapshot.c: reference counted table snapshots
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#ifdef HAVE_PTHREAD_H
+#include <sched.h>
+#endif
+
+#include <assert.h>
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "snapshot.h"
+
+/*****************************************************************************
+ * Atomics
+ *****************************************************************************
+ * Sequentially consistent: the slot relies on the order between the reader
+ * counters, the epoch and the current snapshot.
+ *****************************************************************************/
+#ifdef __ATOMIC_SEQ_CST
+#   define SNAPSHOT_ADD(p, v)      __atomic_add_fetch(p, v, __ATOMIC_SEQ_CST)
+#   define SNAPSHOT_SUB(p, v)      __atomic_sub_fetch(p, v, __ATOMIC_SEQ_CST)
+#   define SNAPSHOT_LOAD(p)        __atomic_load_n(p, __ATOMIC_SEQ_CST)
+#   define SNAPSHOT_STORE(p, v)    __atomic_store_n(p, v, __ATOMIC_SEQ_CST)
+#   define SNAPSHOT_XCHG(p, v)     __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST)
+#else
+#   define SNAPSHOT_ADD(p, v)      __sync_add_and_fetch(p, v)
+#   define SNAPSHOT_SUB(p, v)      __sync_sub_and_fetch(p, v)
+#   define SNAPSHOT_LOAD(p)        (__sync_synchronize(), *(volatile __typeof__(*(p)) *)(p))
+#   define SNAPSHOT_STORE(p, v)    do { __sync_synchronize(); \
+                                        *(volatile __typeof__(*(p)) *)(p) = (v); \
+                                        __sync_synchronize(); } while (0)
+#   define SNAPSHOT_XCHG(p, v)     (__sync_synchronize(), __sync_lock_test_and_set(p, v))
+#endif
+
+#ifdef HAVE_PTHREAD_H
+#   define SNAPSHOT_YIELD()        sched_yield()
+#else
+#   define SNAPSHOT_YIELD()        ((void)0)
+#endif
+
+struct dvbpsi_snapshot_s
+{
+    unsigned int            i_refs;
+    uint8_t                 i_table_id;
+    uint16_t                i_extension;
+    void *                  p_table;
+    void                 (* pf_delete)(void *);
+};
+
+/*****************************************************************************
+ * dvbpsi_snapshot_slot_s
+ *****************************************************************************
+ * A reader counts itself in the counter of the current epoch while it
+ * takes its reference, retrying if a writer flipped the epoch meanwhile.
+ * A writer swaps the snapshot, flips the epoch and waits for the counter
+ * of the previous epoch to drain: a reader counted there may have loaded
+ * the previous snapshot, a later one only sees the new snapshot. New readers use the other counter, so that the writer
+ * is not starved by a steady flow of readers.
+ *****************************************************************************/
+struct dvbpsi_snapshot_slot_s
+{
+    dvbpsi_snapshot_t *     p_current;
+    unsigned int            i_epoch;
+    unsigned int            pi_readers[2];
+    unsigned int            b_writing;
+};
+
+/*****************************************************************************
+ * dvbpsi_snapshot_new
+ *****************************************************************************/
+dvbpsi_snapshot_t *dvbpsi_snapshot_new(uint8_t i_table_id, uint16_t i_extension,
+                                       void *p_table, void (*pf_delete)(void *))
+{
+    assert(p_table && pf_delete);
+
+    dvbpsi_snapshot_t *p_snapshot = dvbpsi_malloc(sizeof(dvbpsi_snapshot_t));
+    if (p_snapshot == NULL)
+    {
+        pf_delete(p_table);
+        return NULL;
+    }
+    p_snapshot->i_refs = 1;
+    p_snapshot->i_table_id = i_table_id;
+    p_snapshot->i_extension = i_extension;
+    p_snapshot->p_table = p_table;
+    p_snapshot->pf_delete = pf_delete;
+    return p_snapshot;
+}
+
+/*****************************************************************************
+ * dvbpsi_table_ref
+ *****************************************************************************/
+dvbpsi_snapshot_t *dvbpsi_table_ref(dvbpsi_snapshot_t *p_snapshot)
+{
+    assert(p_snapshot);
+
+    SNAPSHOT_ADD(&p_snapshot->i_refs, 1);
+    return p_snapshot;
+}
+
+/*****************************************************************************
+ * dvbpsi_table_unref
+ *****************************************************************************/
+void dvbpsi_table_unref(dvbpsi_snapshot_t *p_snapshot)
+{
+    if (p_snapshot == NULL)
+        return;
+
+    if (SNAPSHOT_SUB(&p_snapshot->i_refs, 1) == 0)
+    {
+        p_snapshot->pf_delete(p_snapshot->p_table);
+        dvbpsi_free(p_snapshot);
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_snapshot_table
+ *****************************************************************************/
+const void *dvbpsi_snapshot_table(const dvbpsi_snapshot_t *p_snapshot,
+                                  uint8_t *pi_table_id, uint16_t *pi_extension)
+{
+    assert(p_snapshot);
+
+    if (pi_table_id)
+        *pi_table_id = p_snapshot->i_table_id;
+    if (pi_extension)
+        *pi_extension = p_snapshot->i_extension;
+    return p_snapshot->p_table;
+}
+
+/*****************************************************************************
+ * dvbpsi_snapshot_slot_new
+ *****************************************************************************/
+dvbpsi_snapshot_slot_t *dvbpsi_snapshot_slot_new(void)
+{
+    return dvbpsi_calloc(1, sizeof(dvbpsi_snapshot_slot_t));
+}
+
+/*****************************************************************************
+ * dvbpsi_snapshot_slot_delete
+ *****************************************************************************/
+void dvbpsi_snapshot_slot_delete(dvbpsi_snapshot_slot_t *p_slot)
+{
+    if (p_slot == NULL)
+        return;
+
+    dvbpsi_table_unref(p_slot->p_current);
+    dvbpsi_free(p_slot);
+}
+
+/*****************************************************************************
+ * dvbpsi_snapshot_publish
+ *****************************************************************************/
+void dvbpsi_snapshot_publish(dvbpsi_snapshot_slot_t *p_slot,
+                             dvbpsi_snapshot_t *p_snapshot)
+{
+    assert(p_slot);
+
+    while (SNAPSHOT_XCHG(&p_slot->b_writing, 1) != 0)
+        SNAPSHOT_YIELD();
+
+    dvbpsi_snapshot_t *p_previous = SNAPSHOT_XCHG(&p_slot->p_current, p_snapshot);
+    unsigned int i_epoch = SNAPSHOT_LOAD(&p_slot->i_epoch);
+    SNAPSHOT_STORE(&p_slot->i_epoch, i_epoch ^ 1);
+    while (SNAPSHOT_LOAD(&p_slot->pi_readers[i_epoch]) != 0)
+        SNAPSHOT_YIELD();
+
+    SNAPSHOT_STORE(&p_slot->b_writing, 0);
+    dvbpsi_table_unref(p_previous);
+}
+
+/*****************************************************************************
+ * dvbpsi_snapshot_acquire
+ *****************************************************************************/
+dvbpsi_snapshot_t *dvbpsi_snapshot_acquire(dvbpsi_snapshot_slot_t *p_slot)
+{
+    assert(p_slot);
+
+    unsigned int i_epoch;
+    for (;;)
+    {
+        /* Counted in the epoch still current once counted */
+        i_epoch = SNAPSHOT_LOAD(&p_slot->i_epoch);
+        SNAPSHOT_ADD(&p_slot->pi_readers[i_epoch], 1);
+        if (SNAPSHOT_LOAD(&p_slot->i_epoch) == i_epoch)
+            break;
+        SNAPSHOT_SUB(&p_slot->pi_readers[i_epoch], 1);
+    }
+    dvbpsi_snapshot_t *p_snapshot = SNAPSHOT_LOAD(&p_slot->p_current);
+    if (p_snapshot)
+        SNAPSHOT_ADD(&p_snapshot->i_refs, 1);
+    SNAPSHOT_SUB(&p_slot->pi_readers[i_epoch], 1);
+    return p_snapshot;
+}
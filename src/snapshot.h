@@ -0,0 +1,188 @@
+/*****************************************************************************
+ * snapshot.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <snapshot.h>
+ * \brief Reference counted table snapshots.
+ *
+ * A snapshot owns a decoded table, an EPG store or any other object, that
+ * is not modified anymore and can then be read from many threads at once
+ * instead of being copied. Each thread holds a reference and the last
+ * reference released deletes the object.
+ *
+ * A slot publishes the current snapshot of a table: the writer replaces it
+ * atomically while readers take references to it without locks, the
+ * previous snapshot being released once no reader can still be taking a
+ * reference to it.
+ */
+
+#ifndef _DVBPSI_SNAPSHOT_H_
+#define _DVBPSI_SNAPSHOT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_snapshot_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_snapshot_s dvbpsi_snapshot_t
+ * \brief dvbpsi_snapshot_t type definition, an opaque snapshot.
+ */
+typedef struct dvbpsi_snapshot_s dvbpsi_snapshot_t;
+
+/*****************************************************************************
+ * dvbpsi_snapshot_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_snapshot_t *dvbpsi_snapshot_new(uint8_t i_table_id,
+ *                                            uint16_t i_extension,
+ *                                            void *p_table,
+ *                                            void (*pf_delete)(void *))
+ * \brief Creates a snapshot of a table, with one reference
+ * \param i_table_id table_id of the table, for the readers
+ * \param i_extension table_id_extension of the table, for the readers
+ * \param p_table table, owned by the snapshot from now on
+ * \param pf_delete function deleting the table, such as dvbpsi_pmt_delete()
+ * \return pointer to the snapshot, or NULL on error, in which case the
+ *         table is deleted.
+ *
+ * The table must not be modified anymore: a table decoded lazily must be
+ * decoded first, with dvbpsi_pmt_decode() for instance. The table may be
+ * deleted on any thread, so tables of a handle with
+ * DVBPSI_FLAG_INTERN_DESCRIPTORS cannot be shared.
+ */
+dvbpsi_snapshot_t *dvbpsi_snapshot_new(uint8_t i_table_id, uint16_t i_extension,
+                                       void *p_table, void (*pf_delete)(void *));
+
+/*****************************************************************************
+ * dvbpsi_table_ref
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_snapshot_t *dvbpsi_table_ref(dvbpsi_snapshot_t *p_snapshot)
+ * \brief Takes a reference to a snapshot held by the caller
+ * \param p_snapshot pointer to the snapshot
+ * \return p_snapshot.
+ */
+dvbpsi_snapshot_t *dvbpsi_table_ref(dvbpsi_snapshot_t *p_snapshot);
+
+/*****************************************************************************
+ * dvbpsi_table_unref
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_table_unref(dvbpsi_snapshot_t *p_snapshot)
+ * \brief Releases a reference to a snapshot, deleting it with its table
+ * when it was the last one
+ * \param p_snapshot pointer to the snapshot, or NULL
+ * \return nothing
+ */
+void dvbpsi_table_unref(dvbpsi_snapshot_t *p_snapshot);
+
+/*****************************************************************************
+ * dvbpsi_snapshot_table
+ *****************************************************************************/
+/*!
+ * \fn const void *dvbpsi_snapshot_table(const dvbpsi_snapshot_t *p_snapshot,
+ *                                       uint8_t *pi_table_id,
+ *                                       uint16_t *pi_extension)
+ * \brief Gets the table of a snapshot
+ * \param p_snapshot pointer to the snapshot
+ * \param pi_table_id filled with the table_id, or NULL
+ * \param pi_extension filled with the table_id_extension, or NULL
+ * \return the table, valid as long as a reference is held.
+ */
+const void *dvbpsi_snapshot_table(const dvbpsi_snapshot_t *p_snapshot,
+                                  uint8_t *pi_table_id, uint16_t *pi_extension);
+
+/*****************************************************************************
+ * dvbpsi_snapshot_slot_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_snapshot_slot_s dvbpsi_snapshot_slot_t
+ * \brief dvbpsi_snapshot_slot_t type definition, an opaque slot holding
+ * the current snapshot of a table.
+ */
+typedef struct dvbpsi_snapshot_slot_s dvbpsi_snapshot_slot_t;
+
+/*****************************************************************************
+ * dvbpsi_snapshot_slot_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_snapshot_slot_t *dvbpsi_snapshot_slot_new(void)
+ * \brief Creates an empty slot
+ * \return pointer to the slot, or NULL on error
+ */
+dvbpsi_snapshot_slot_t *dvbpsi_snapshot_slot_new(void);
+
+/*****************************************************************************
+ * dvbpsi_snapshot_slot_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_snapshot_slot_delete(dvbpsi_snapshot_slot_t *p_slot)
+ * \brief Deletes a slot and releases its snapshot
+ * \param p_slot pointer to the slot, no longer used by any thread
+ * \return nothing
+ */
+void dvbpsi_snapshot_slot_delete(dvbpsi_snapshot_slot_t *p_slot);
+
+/*****************************************************************************
+ * dvbpsi_snapshot_publish
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_snapshot_publish(dvbpsi_snapshot_slot_t *p_slot,
+ *                                  dvbpsi_snapshot_t *p_snapshot)
+ * \brief Replaces the snapshot of a slot
+ * \param p_slot pointer to the slot
+ * \param p_snapshot new snapshot, or NULL to empty the slot, whose
+ *        reference is given to the slot
+ * \return nothing
+ *
+ * The readers see either the previous snapshot or the new one. The
+ * function waits for the readers taking a reference at the same time, a
+ * few instructions each, before releasing the previous snapshot. Writers
+ * of a slot are serialized.
+ */
+void dvbpsi_snapshot_publish(dvbpsi_snapshot_slot_t *p_slot,
+                             dvbpsi_snapshot_t *p_snapshot);
+
+/*****************************************************************************
+ * dvbpsi_snapshot_acquire
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_snapshot_t *dvbpsi_snapshot_acquire(dvbpsi_snapshot_slot_t *p_slot)
+ * \brief Takes a reference to the current snapshot of a slot
+ * \param p_slot pointer to the slot
+ * \return the snapshot, to be released with dvbpsi_table_unref(), or NULL
+ *         if the slot is empty.
+ *
+ * It never waits for a lock or for a writer.
+ */
+dvbpsi_snapshot_t *dvbpsi_snapshot_acquire(dvbpsi_snapshot_slot_t *p_slot);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of snapshot.h"
+#endif
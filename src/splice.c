@@ -0,0 +1,495 @@
+/*****************************************************************************
+ * splice.c: timeline of the SCTE 35 splices of a program
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "descriptor.h"
+#include "tables/sis.h"
+#include "splice.h"
+
+/* System time clock in 27 MHz units, wrapping with the 33 bits PCR base */
+#define DVBPSI_SPLICE_WRAP  ((INT64_C(1) << 33) * 300)
+/* PCR away from the extrapolated clock taken as a discontinuity, 1 s */
+#define DVBPSI_SPLICE_JUMP  INT64_C(27000000)
+/* Splices remembered once they happened, to ignore their repetitions */
+#define DVBPSI_SPLICE_FIRED 16
+
+/*****************************************************************************
+ * dvbpsi_splice_entry_t
+ *****************************************************************************
+ * Pending splice, in the min-heap on its time.
+ *****************************************************************************/
+typedef struct dvbpsi_splice_entry_s
+{
+    int64_t                 i_target;       /* extended clock, 27 MHz */
+    unsigned int            i_heap;         /* position in the heap */
+    int64_t                 i_arrival;
+    bool                    b_late;
+    dvbpsi_sis_splice_t     splice;         /* p_upid pointing to p_upids */
+    uint8_t                 p_upids[DVBPSI_SIS_SPLICE_SEGMENTATIONS][255];
+} dvbpsi_splice_entry_t;
+
+/*****************************************************************************
+ * dvbpsi_splice_fired_t
+ *****************************************************************************
+ * Identity of a splice that happened.
+ *****************************************************************************/
+typedef struct dvbpsi_splice_fired_s
+{
+    uint8_t                 i_command;      /* 0 for an unused slot */
+    uint32_t                i_event_id;
+    uint64_t                i_pts;
+} dvbpsi_splice_fired_t;
+
+/*****************************************************************************
+ * dvbpsi_splice_timeline_s
+ *****************************************************************************/
+struct dvbpsi_splice_timeline_s
+{
+    dvbpsi_splice_callback  pf_callback;
+    void *                  p_cb_data;
+
+    unsigned int            i_max_cues;
+    unsigned int            i_cues;
+    dvbpsi_splice_entry_t **pp_heap;        /* min-heap on i_target */
+
+    /* System time clock, from the last PCR */
+    bool                    b_clock;
+    int64_t                 i_pcr;          /* last PCR */
+    int64_t                 i_stc;          /* last PCR on the extended clock */
+    int64_t                 i_pcr_time;     /* arrival time of the last PCR */
+
+    dvbpsi_splice_fired_t   p_fired[DVBPSI_SPLICE_FIRED];
+    unsigned int            i_fired;        /* next slot */
+};
+
+/*****************************************************************************
+ * dvbpsi_splice_new
+ *****************************************************************************/
+dvbpsi_splice_timeline_t *dvbpsi_splice_new(unsigned int i_max_cues,
+                                            dvbpsi_splice_callback pf_callback,
+                                            void *p_cb_data)
+{
+    assert(pf_callback);
+
+    dvbpsi_splice_timeline_t *p_timeline = dvbpsi_calloc(1, sizeof(dvbpsi_splice_timeline_t));
+    if (p_timeline == NULL)
+        return NULL;
+
+    p_timeline->pp_heap = dvbpsi_calloc(i_max_cues ? i_max_cues : 1,
+                                        sizeof(dvbpsi_splice_entry_t *));
+    if (p_timeline->pp_heap == NULL)
+    {
+        dvbpsi_free(p_timeline);
+        return NULL;
+    }
+    p_timeline->i_max_cues = i_max_cues;
+    p_timeline->pf_callback = pf_callback;
+    p_timeline->p_cb_data = p_cb_data;
+    return p_timeline;
+}
+
+/*****************************************************************************
+ * dvbpsi_splice_delete
+ *****************************************************************************/
+void dvbpsi_splice_delete(dvbpsi_splice_timeline_t *p_timeline)
+{
+    if (p_timeline == NULL)
+        return;
+
+    for (unsigned int i = 0; i < p_timeline->i_cues; i++)
+        dvbpsi_free(p_timeline->pp_heap[i]);
+    dvbpsi_free(p_timeline->pp_heap);
+    dvbpsi_free(p_timeline);
+}
+
+/*****************************************************************************
+ * Min-heap of the splices on their time
+ *****************************************************************************
+ * dvbpsi_splice_sift_up() and dvbpsi_splice_sift_down() move the splice at
+ * position i of the heap to its place.
+ *****************************************************************************/
+static void dvbpsi_splice_place(dvbpsi_splice_timeline_t *p_timeline, unsigned int i,
+                                dvbpsi_splice_entry_t *p_entry)
+{
+    p_timeline->pp_heap[i] = p_entry;
+    p_entry->i_heap = i;
+}
+
+static void dvbpsi_splice_sift_up(dvbpsi_splice_timeline_t *p_timeline, unsigned int i)
+{
+    dvbpsi_splice_entry_t *p_entry = p_timeline->pp_heap[i];
+    while (i > 0)
+    {
+        unsigned int i_parent = (i - 1) / 2;
+        if (p_timeline->pp_heap[i_parent]->i_target <= p_entry->i_target)
+            break;
+        dvbpsi_splice_place(p_timeline, i, p_timeline->pp_heap[i_parent]);
+        i = i_parent;
+    }
+    dvbpsi_splice_place(p_timeline, i, p_entry);
+}
+
+static void dvbpsi_splice_sift_down(dvbpsi_splice_timeline_t *p_timeline, unsigned int i)
+{
+    dvbpsi_splice_entry_t *p_entry = p_timeline->pp_heap[i];
+    for (;;)
+    {
+        unsigned int i_child = 2 * i + 1;
+        if (i_child >= p_timeline->i_cues)
+            break;
+        if (i_child + 1 < p_timeline->i_cues
+         && p_timeline->pp_heap[i_child + 1]->i_target < p_timeline->pp_heap[i_child]->i_target)
+            i_child++;
+        if (p_entry->i_target <= p_timeline->pp_heap[i_child]->i_target)
+            break;
+        dvbpsi_splice_place(p_timeline, i, p_timeline->pp_heap[i_child]);
+        i = i_child;
+    }
+    dvbpsi_splice_place(p_timeline, i, p_entry);
+}
+
+/*****************************************************************************
+ * dvbpsi_splice_remove
+ *****************************************************************************
+ * Takes a splice out of the heap, without deleting it.
+ *****************************************************************************/
+static void dvbpsi_splice_remove(dvbpsi_splice_timeline_t *p_timeline,
+                                 dvbpsi_splice_entry_t *p_entry)
+{
+    unsigned int i = p_entry->i_heap;
+    p_timeline->i_cues--;
+    if (i == p_timeline->i_cues)
+        return;
+
+    dvbpsi_splice_entry_t *p_last = p_timeline->pp_heap[p_timeline->i_cues];
+    dvbpsi_splice_place(p_timeline, i, p_last);
+    dvbpsi_splice_sift_down(p_timeline, i);
+    dvbpsi_splice_sift_up(p_timeline, p_last->i_heap);
+}
+
+/*****************************************************************************
+ * Clock
+ *****************************************************************************
+ * dvbpsi_splice_wrap() is the difference of two PCRs or pts_time * 300
+ * closest to 0, dvbpsi_splice_stc() the extended clock at an arrival time
+ * and dvbpsi_splice_time() the arrival time of an extended clock.
+ *****************************************************************************/
+static inline int64_t dvbpsi_splice_wrap(int64_t i_delta)
+{
+    i_delta %= DVBPSI_SPLICE_WRAP;
+    if (i_delta < 0)
+        i_delta += DVBPSI_SPLICE_WRAP;
+    if (i_delta >= DVBPSI_SPLICE_WRAP / 2)
+        i_delta -= DVBPSI_SPLICE_WRAP;
+    return i_delta;
+}
+
+static inline int64_t dvbpsi_splice_stc(const dvbpsi_splice_timeline_t *p_timeline,
+                                        int64_t i_time)
+{
+    return p_timeline->i_stc + (i_time - p_timeline->i_pcr_time) * 27;
+}
+
+static inline int64_t dvbpsi_splice_time(const dvbpsi_splice_timeline_t *p_timeline,
+                                         int64_t i_target)
+{
+    int64_t i_delta = i_target - p_timeline->i_stc;
+    /* rounded up, the clock having reached the splice at that time */
+    return p_timeline->i_pcr_time + (i_delta >= 0 ? (i_delta + 26) / 27 : -(-i_delta / 27));
+}
+
+/*****************************************************************************
+ * dvbpsi_splice_target
+ *****************************************************************************
+ * Puts a splice on the extended clock, late if it is before i_now.
+ *****************************************************************************/
+static void dvbpsi_splice_target(dvbpsi_splice_timeline_t *p_timeline,
+                                 dvbpsi_splice_entry_t *p_entry, int64_t i_now)
+{
+    p_entry->i_target = p_timeline->i_stc
+                      + dvbpsi_splice_wrap((int64_t)p_entry->splice.i_pts_time * 300
+                                           - p_timeline->i_pcr);
+    p_entry->b_late = p_entry->i_target < i_now;
+}
+
+/*****************************************************************************
+ * dvbpsi_splice_retarget
+ *****************************************************************************
+ * Puts all the pending splices on a new time base.
+ *****************************************************************************/
+static void dvbpsi_splice_retarget(dvbpsi_splice_timeline_t *p_timeline)
+{
+    for (unsigned int i = 0; i < p_timeline->i_cues; i++)
+        dvbpsi_splice_target(p_timeline, p_timeline->pp_heap[i], p_timeline->i_stc);
+    for (unsigned int i = p_timeline->i_cues / 2; i-- > 0; )
+        dvbpsi_splice_sift_down(p_timeline, i);
+}
+
+/*****************************************************************************
+ * dvbpsi_splice_fired
+ *****************************************************************************
+ * Remembers a splice that happened, or tells whether it did.
+ *****************************************************************************/
+static void dvbpsi_splice_fired(dvbpsi_splice_timeline_t *p_timeline,
+                                const dvbpsi_sis_splice_t *p_splice)
+{
+    dvbpsi_splice_fired_t *p_fired = &p_timeline->p_fired[p_timeline->i_fired];
+    p_fired->i_command = p_splice->i_splice_command_type;
+    p_fired->i_event_id = p_splice->i_splice_event_id;
+    p_fired->i_pts = p_splice->i_pts_time;
+    p_timeline->i_fired = (p_timeline->i_fired + 1) % DVBPSI_SPLICE_FIRED;
+}
+
+static bool dvbpsi_splice_same(const dvbpsi_sis_splice_t *p_splice, uint8_t i_command,
+                               uint32_t i_event_id, uint64_t i_pts)
+{
+    if (p_splice->i_splice_command_type != i_command)
+        return false;
+    if (i_command == 0x05)
+        return p_splice->i_splice_event_id == i_event_id;
+    return p_splice->i_pts_time == i_pts;
+}
+
+static bool dvbpsi_splice_has_fired(const dvbpsi_splice_timeline_t *p_timeline,
+                                    const dvbpsi_sis_splice_t *p_splice)
+{
+    for (unsigned int i = 0; i < DVBPSI_SPLICE_FIRED; i++)
+    {
+        const dvbpsi_splice_fired_t *p_fired = &p_timeline->p_fired[i];
+        if (p_fired->i_command
+         && dvbpsi_splice_same(p_splice, p_fired->i_command, p_fired->i_event_id,
+                               p_fired->i_pts))
+            return true;
+    }
+    return false;
+}
+
+/*****************************************************************************
+ * dvbpsi_splice_fire
+ *****************************************************************************
+ * Calls back the splices due on the extended clock i_now.
+ *****************************************************************************/
+static void dvbpsi_splice_fire(dvbpsi_splice_timeline_t *p_timeline, int64_t i_now)
+{
+    while (p_timeline->i_cues > 0 && p_timeline->pp_heap[0]->i_target <= i_now)
+    {
+        dvbpsi_splice_entry_t *p_entry = p_timeline->pp_heap[0];
+        dvbpsi_splice_remove(p_timeline, p_entry);
+        dvbpsi_splice_fired(p_timeline, &p_entry->splice);
+
+        dvbpsi_splice_cue_t cue;
+        cue.p_splice = &p_entry->splice;
+        cue.i_arrival = p_entry->i_arrival;
+        cue.i_time = dvbpsi_splice_time(p_timeline, p_entry->i_target);
+        cue.b_immediate = false;
+        cue.b_late = p_entry->b_late;
+        p_timeline->pf_callback(p_timeline->p_cb_data, &cue);
+        dvbpsi_free(p_entry);
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_splice_cue
+ *****************************************************************************/
+bool dvbpsi_splice_cue(dvbpsi_splice_timeline_t *p_timeline,
+                       const dvbpsi_sis_splice_t *p_splice, int64_t i_time)
+{
+    assert(p_timeline);
+    assert(p_splice);
+
+    uint8_t i_command = p_splice->i_splice_command_type;
+    if (p_splice->b_encrypted || (i_command != 0x05 && i_command != 0x06))
+        return true;
+
+    /* Pending splice of the same command */
+    dvbpsi_splice_entry_t *p_entry = NULL;
+    for (unsigned int i = 0; i < p_timeline->i_cues; i++)
+    {
+        const dvbpsi_sis_splice_t *p = &p_timeline->pp_heap[i]->splice;
+        if (dvbpsi_splice_same(p_splice, p->i_splice_command_type, p->i_splice_event_id,
+                               p->i_pts_time))
+        {
+            p_entry = p_timeline->pp_heap[i];
+            break;
+        }
+    }
+
+    if (i_command == 0x05 && p_splice->b_splice_event_cancel)
+    {
+        if (p_entry)
+        {
+            dvbpsi_splice_remove(p_timeline, p_entry);
+            dvbpsi_free(p_entry);
+        }
+        return true;
+    }
+
+    if (p_entry == NULL && dvbpsi_splice_has_fired(p_timeline, p_splice))
+        return true;
+
+    bool b_immediate = !p_splice->b_time_specified
+                    || (i_command == 0x05 && p_splice->b_splice_immediate);
+    if (b_immediate)
+    {
+        if (p_entry)
+        {
+            dvbpsi_splice_remove(p_timeline, p_entry);
+            dvbpsi_free(p_entry);
+        }
+        dvbpsi_splice_fired(p_timeline, p_splice);
+
+        dvbpsi_splice_cue_t cue;
+        cue.p_splice = p_splice;
+        cue.i_arrival = cue.i_time = i_time;
+        cue.b_immediate = true;
+        cue.b_late = false;
+        p_timeline->pf_callback(p_timeline->p_cb_data, &cue);
+        return true;
+    }
+
+    bool b_new = (p_entry == NULL);
+    if (b_new)
+    {
+        if (p_timeline->i_cues >= p_timeline->i_max_cues)
+            return false;
+        p_entry = dvbpsi_malloc(sizeof(dvbpsi_splice_entry_t));
+        if (p_entry == NULL)
+            return false;
+    }
+
+    p_entry->splice = *p_splice;
+    for (unsigned int i = 0; i < p_splice->i_segmentations; i++)
+    {
+        dvbpsi_sis_segmentation_t *p_segmentation = &p_entry->splice.segmentations[i];
+        if (p_segmentation->p_upid == NULL)
+            continue;
+        memcpy(p_entry->p_upids[i], p_segmentation->p_upid, p_segmentation->i_upid_length);
+        p_segmentation->p_upid = p_entry->p_upids[i];
+    }
+    p_entry->i_arrival = i_time;
+    p_entry->i_target = 0;
+    p_entry->b_late = false;
+
+    int64_t i_now = 0;
+    if (p_timeline->b_clock)
+    {
+        i_now = dvbpsi_splice_stc(p_timeline, i_time);
+        dvbpsi_splice_target(p_timeline, p_entry, i_now);
+    }
+
+    if (b_new)
+    {
+        dvbpsi_splice_place(p_timeline, p_timeline->i_cues++, p_entry);
+        dvbpsi_splice_sift_up(p_timeline, p_entry->i_heap);
+    }
+    else
+    {
+        dvbpsi_splice_sift_down(p_timeline, p_entry->i_heap);
+        dvbpsi_splice_sift_up(p_timeline, p_entry->i_heap);
+    }
+
+    if (p_timeline->b_clock)
+        dvbpsi_splice_fire(p_timeline, i_now);
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_splice_pcr
+ *****************************************************************************/
+void dvbpsi_splice_pcr(dvbpsi_splice_timeline_t *p_timeline, uint64_t i_pcr,
+                       bool b_discontinuity, int64_t i_time)
+{
+    assert(p_timeline);
+
+    int64_t i_new = (int64_t)(i_pcr % DVBPSI_SPLICE_WRAP);
+    if (!p_timeline->b_clock)
+    {
+        p_timeline->b_clock = true;
+        p_timeline->i_pcr = i_new;
+        p_timeline->i_stc = 0;
+        p_timeline->i_pcr_time = i_time;
+        dvbpsi_splice_retarget(p_timeline);
+    }
+    else
+    {
+        int64_t i_expected = dvbpsi_splice_stc(p_timeline, i_time);
+        int64_t i_stc = p_timeline->i_stc + dvbpsi_splice_wrap(i_new - p_timeline->i_pcr);
+        int64_t i_error = i_stc - i_expected;
+        if (b_discontinuity || i_error > DVBPSI_SPLICE_JUMP || i_error < -DVBPSI_SPLICE_JUMP)
+        {
+            /* New time base, the extended clock going on from the last PCR */
+            p_timeline->i_pcr = i_new;
+            p_timeline->i_stc = i_expected;
+            p_timeline->i_pcr_time = i_time;
+            dvbpsi_splice_retarget(p_timeline);
+        }
+        else
+        {
+            p_timeline->i_pcr = i_new;
+            p_timeline->i_stc = i_stc;
+            p_timeline->i_pcr_time = i_time;
+        }
+    }
+
+    dvbpsi_splice_fire(p_timeline, p_timeline->i_stc);
+}
+
+/*****************************************************************************
+ * dvbpsi_splice_advance
+ *****************************************************************************/
+void dvbpsi_splice_advance(dvbpsi_splice_timeline_t *p_timeline, int64_t i_time)
+{
+    assert(p_timeline);
+
+    if (p_timeline->b_clock)
+        dvbpsi_splice_fire(p_timeline, dvbpsi_splice_stc(p_timeline, i_time));
+}
+
+/*****************************************************************************
+ * dvbpsi_splice_next
+ *****************************************************************************/
+int64_t dvbpsi_splice_next(const dvbpsi_splice_timeline_t *p_timeline)
+{
+    assert(p_timeline);
+
+    if (!p_timeline->b_clock || p_timeline->i_cues == 0)
+        return DVBPSI_TIME_NONE;
+    return dvbpsi_splice_time(p_timeline, p_timeline->pp_heap[0]->i_target);
+}
@@ -0,0 +1,201 @@
+/*****************************************************************************
+ * splice.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <splice.h>
+ * \brief Timeline of the SCTE 35 splices of a program.
+ *
+ * A timeline takes the splice_insert() and time_signal() commands of a
+ * program, as given to the callback of dvbpsi_sis_set_splice_callback(),
+ * and the PCRs of the program with their arrival times, from
+ * dvbpsi_pcrs_scan() or dvbpsi_adaptation_parse(). The pts_time of a
+ * command, pts_adjustment included, is put on the system time clock
+ * followed through the PCRs, which gives the arrival time at which the
+ * splice happens. The pending splices are kept in a min-heap on that time
+ * and called back when it is reached, on a PCR or on
+ * dvbpsi_splice_advance().
+ *
+ * Times are in microseconds of the clock of the arrival times, which are
+ * those of the packets carrying the PCRs and the splice_info_sections.
+ * A splice_insert() is identified by its splice_event_id, a time_signal()
+ * by its pts_time: the repetitions of a command update the pending splice,
+ * and are ignored once it happened. A PCR discontinuity puts the pending
+ * splices on the new time base. The callbacks are made from inside the
+ * calls of the timeline, which must not be called back from them.
+ */
+
+#ifndef _DVBPSI_SPLICE_H_
+#define _DVBPSI_SPLICE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_splice_timeline_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_splice_timeline_s dvbpsi_splice_timeline_t
+ * \brief dvbpsi_splice_timeline_t type definition, an opaque timeline.
+ */
+typedef struct dvbpsi_splice_timeline_s dvbpsi_splice_timeline_t;
+
+/*****************************************************************************
+ * dvbpsi_splice_cue_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_splice_cue_s
+ * \brief Splice given to the callback of a timeline, only valid during the
+ * callback.
+ */
+/*!
+ * \typedef struct dvbpsi_splice_cue_s dvbpsi_splice_cue_t
+ * \brief dvbpsi_splice_cue_t type definition.
+ */
+typedef struct dvbpsi_splice_cue_s
+{
+    const dvbpsi_sis_splice_t *p_splice;    /*!< last command of the splice,
+                                                 the p_upid of its
+                                                 segmentations pointing to
+                                                 copies */
+    int64_t     i_arrival;                  /*!< arrival time of the last
+                                                 command */
+    int64_t     i_time;                     /*!< time of the splice, the
+                                                 arrival time of the command
+                                                 for an immediate one */
+    bool        b_immediate;                /*!< splice_immediate_flag, or
+                                                 no splice_time */
+    bool        b_late;                     /*!< called back after its time,
+                                                 which was already past when
+                                                 it was known */
+} dvbpsi_splice_cue_t;
+
+/*!
+ * \typedef void (* dvbpsi_splice_callback)(void *p_cb_data,
+                  const dvbpsi_splice_cue_t *p_cue)
+ * \brief Callback type definition.
+ */
+typedef void (* dvbpsi_splice_callback)(void *p_cb_data,
+                                        const dvbpsi_splice_cue_t *p_cue);
+
+/*****************************************************************************
+ * dvbpsi_splice_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_splice_timeline_t *dvbpsi_splice_new(unsigned int i_max_cues,
+ *                            dvbpsi_splice_callback pf_callback, void *p_cb_data)
+ * \brief Creates a timeline without any PCR nor splice yet
+ * \param i_max_cues maximum number of pending splices
+ * \param pf_callback function called when a splice happens
+ * \param p_cb_data data given to pf_callback
+ * \return the new timeline, NULL on error.
+ */
+dvbpsi_splice_timeline_t *dvbpsi_splice_new(unsigned int i_max_cues,
+                                            dvbpsi_splice_callback pf_callback,
+                                            void *p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_splice_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_splice_delete(dvbpsi_splice_timeline_t *p_timeline)
+ * \brief Deletes a timeline and its pending splices, calling back nothing
+ * \param p_timeline timeline, or NULL
+ * \return nothing.
+ */
+void dvbpsi_splice_delete(dvbpsi_splice_timeline_t *p_timeline);
+
+/*****************************************************************************
+ * dvbpsi_splice_cue
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_splice_cue(dvbpsi_splice_timeline_t *p_timeline,
+ *                            const dvbpsi_sis_splice_t *p_splice, int64_t i_time)
+ * \brief Adds the command of a splice_info_section to a timeline
+ * \param p_timeline timeline
+ * \param p_splice command, from the splice callback of a SIS decoder
+ * \param i_time arrival time of the section
+ * \return false if the splice could not be kept, the timeline being full
+ *         or on a memory error, true otherwise.
+ *
+ * An immediate splice, and a splice whose time is already past, are called
+ * back at once. A cancelled splice_insert() removes the pending splice of
+ * its splice_event_id. Other commands, and encrypted sections, are
+ * ignored. The splices with a time are pending until the first PCR.
+ */
+bool dvbpsi_splice_cue(dvbpsi_splice_timeline_t *p_timeline,
+                       const dvbpsi_sis_splice_t *p_splice, int64_t i_time);
+
+/*****************************************************************************
+ * dvbpsi_splice_pcr
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_splice_pcr(dvbpsi_splice_timeline_t *p_timeline, uint64_t i_pcr,
+ *                            bool b_discontinuity, int64_t i_time)
+ * \brief Follows the system time clock of the program with a PCR
+ * \param p_timeline timeline
+ * \param i_pcr PCR in 27 MHz units, as given by dvbpsi_pcrs_scan()
+ * \param b_discontinuity discontinuity_indicator of the packet
+ * \param i_time arrival time of the packet
+ * \return nothing.
+ *
+ * The splices whose time is reached are called back. A PCR more than a
+ * second away from the clock extrapolated from the previous one is taken
+ * as a discontinuity.
+ */
+void dvbpsi_splice_pcr(dvbpsi_splice_timeline_t *p_timeline, uint64_t i_pcr,
+                       bool b_discontinuity, int64_t i_time);
+
+/*****************************************************************************
+ * dvbpsi_splice_advance
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_splice_advance(dvbpsi_splice_timeline_t *p_timeline,
+ *                                int64_t i_time)
+ * \brief Calls back the splices whose time is reached at a time
+ * \param p_timeline timeline
+ * \param i_time current time, on the clock of the arrival times
+ * \return nothing.
+ *
+ * To be called when the time given by dvbpsi_splice_next() is reached,
+ * so that the splices happen on time between two PCRs.
+ */
+void dvbpsi_splice_advance(dvbpsi_splice_timeline_t *p_timeline, int64_t i_time);
+
+/*****************************************************************************
+ * dvbpsi_splice_next
+ *****************************************************************************/
+/*!
+ * \fn int64_t dvbpsi_splice_next(const dvbpsi_splice_timeline_t *p_timeline)
+ * \brief Gets the time of the next pending splice
+ * \param p_timeline timeline
+ * \return the time, DVBPSI_TIME_NONE without pending splice or PCR.
+ */
+int64_t dvbpsi_splice_next(const dvbpsi_splice_timeline_t *p_timeline);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of splice.h"
+#endif
@@ -0,0 +1,684 @@
+/*****************************************************************************
+ * spts.c: extraction of single program transport streams
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "descriptor.h"
+#include "rewriter.h"
+#include "tables/pat.h"
+#include "tables/pmt.h"
+#include "tables/cat.h"
+#include "spts.h"
+
+/* No PID */
+#define DVBPSI_SPTS_NO_PID 0xffff
+
+/* No continuity_counter yet */
+#define DVBPSI_SPTS_NO_CC 0xff
+
+#define DVBPSI_SPTS_SET(p, i)   ((p)[(i) / 8] |= 1 << ((i) % 8))
+#define DVBPSI_SPTS_TEST(p, i)  ((p)[(i) / 8] & (1 << ((i) % 8)))
+
+/*****************************************************************************
+ * dvbpsi_spts_program_t
+ *****************************************************************************
+ * Program of the last PAT.
+ *****************************************************************************/
+typedef struct dvbpsi_spts_program_s
+{
+    uint16_t                i_number;
+    uint16_t                i_pid;
+} dvbpsi_spts_program_t;
+
+/*****************************************************************************
+ * dvbpsi_spts_output_t
+ *****************************************************************************
+ * Single program transport stream being extracted.
+ *****************************************************************************/
+typedef struct dvbpsi_spts_output_s
+{
+    struct dvbpsi_spts_s *  p_spts;
+    unsigned int            i_output;
+    uint16_t                i_program_number;
+    uint16_t                i_pmt_pid;      /* DVBPSI_SPTS_NO_PID if unknown */
+
+    dvbpsi_t *              p_pmt_handle;   /* NULL while the PMT PID is unknown */
+    dvbpsi_rewriter_t *     p_rewriter;     /* of the PAT */
+
+    uint8_t                 p_program[8192 / 8]; /* PIDs of the last PMT */
+    uint8_t                 p_pids[8192 / 8];    /* PIDs copied */
+    uint8_t                 p_cc[8192];          /* last continuity_counter */
+
+    uint8_t *               p_batch;        /* i_batch * 188 bytes */
+    size_t                  i_count;
+} dvbpsi_spts_output_t;
+
+struct dvbpsi_spts_s
+{
+    dvbpsi_spts_callback    pf_callback;
+    void *                  p_cb_data;
+    size_t                  i_batch;
+
+    dvbpsi_t *              p_pat_handle;
+    dvbpsi_t *              p_cat_handle;
+
+    /* Last PAT and CAT */
+    dvbpsi_spts_program_t * p_programs;
+    size_t                  i_programs;
+    uint8_t                 p_emms[8192 / 8];
+
+    /* Outputs of each PID, bit i for output i */
+    uint64_t                p_masks[8192];
+    uint8_t                 p_pmts[8192 / 8];   /* PMT PIDs of the outputs */
+    uint8_t                 p_in_cc[8192];      /* last input continuity_counter */
+
+    dvbpsi_spts_output_t *  pp_outputs[DVBPSI_SPTS_OUTPUTS];
+
+    dvbpsi_spts_stats_t     stats;
+};
+
+/*****************************************************************************
+ * dvbpsi_spts_deliver
+ *****************************************************************************
+ * Gives the batch of an output to the application.
+ *****************************************************************************/
+static void dvbpsi_spts_deliver(dvbpsi_spts_output_t *p_output)
+{
+    if (p_output->i_count == 0)
+        return;
+
+    dvbpsi_spts_t *p_spts = p_output->p_spts;
+    p_spts->pf_callback(p_spts->p_cb_data, p_output->i_output,
+                        p_output->p_batch, p_output->i_count);
+    p_output->i_count = 0;
+}
+
+/*****************************************************************************
+ * dvbpsi_spts_slot
+ *****************************************************************************
+ * Next packet of the batch of an output, making room if it is full.
+ *****************************************************************************/
+static inline uint8_t *dvbpsi_spts_slot(dvbpsi_spts_output_t *p_output)
+{
+    if (p_output->i_count == p_output->p_spts->i_batch)
+        dvbpsi_spts_deliver(p_output);
+    return p_output->p_batch + 188 * p_output->i_count++;
+}
+
+/*****************************************************************************
+ * dvbpsi_spts_update
+ *****************************************************************************
+ * Sets the PIDs copied to an output from its program, the CAT and the EMM
+ * PIDs, changing the outputs of the PIDs which differ.
+ *****************************************************************************/
+static void dvbpsi_spts_update(dvbpsi_spts_output_t *p_output)
+{
+    dvbpsi_spts_t *p_spts = p_output->p_spts;
+    uint64_t i_bit = (uint64_t)1 << p_output->i_output;
+
+    uint8_t p_pids[8192 / 8];
+    for (int i = 0; i < 8192 / 8; i++)
+        p_pids[i] = p_output->p_program[i] | p_spts->p_emms[i];
+    DVBPSI_SPTS_SET(p_pids, 0x01);
+    if (p_output->i_pmt_pid != DVBPSI_SPTS_NO_PID)
+        DVBPSI_SPTS_SET(p_pids, p_output->i_pmt_pid);
+    p_pids[0] &= ~1;
+    p_pids[0x1fff / 8] &= ~(1 << (0x1fff % 8));
+
+    bool b_changed = false;
+    for (int i = 0; i < 8192 / 8; i++)
+    {
+        uint8_t i_diff = p_pids[i] ^ p_output->p_pids[i];
+        if (i_diff == 0)
+            continue;
+        b_changed = true;
+        for (int j = 0; j < 8; j++)
+            if (i_diff & (1 << j))
+                p_spts->p_masks[i * 8 + j] ^= i_bit;
+        p_output->p_pids[i] = p_pids[i];
+    }
+    if (b_changed)
+        p_spts->stats.i_updates++;
+}
+
+/*****************************************************************************
+ * dvbpsi_spts_set_pmts
+ *****************************************************************************
+ * Gathers the PMT PIDs of the outputs.
+ *****************************************************************************/
+static void dvbpsi_spts_set_pmts(dvbpsi_spts_t *p_spts)
+{
+    memset(p_spts->p_pmts, 0, sizeof(p_spts->p_pmts));
+    for (int i = 0; i < DVBPSI_SPTS_OUTPUTS; i++)
+    {
+        dvbpsi_spts_output_t *p_output = p_spts->pp_outputs[i];
+        if (p_output && p_output->p_pmt_handle)
+            DVBPSI_SPTS_SET(p_spts->p_pmts, p_output->i_pmt_pid);
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_spts_ca_pids
+ *****************************************************************************
+ * Sets the CA_PID of the CA descriptors of a list.
+ *****************************************************************************/
+static void dvbpsi_spts_ca_pids(uint8_t *p_pids, const dvbpsi_descriptor_t *p_descriptor)
+{
+    for (; p_descriptor; p_descriptor = p_descriptor->p_next)
+    {
+        if (p_descriptor->i_tag != 0x09 || p_descriptor->i_length < 4)
+            continue;
+        DVBPSI_SPTS_SET(p_pids, ((uint16_t)(p_descriptor->p_data[2] & 0x1f) << 8)
+                                | p_descriptor->p_data[3]);
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_spts_pmt
+ *****************************************************************************
+ * Takes the PCR, elementary stream and ECM PIDs of a current PMT.
+ *****************************************************************************/
+static void dvbpsi_spts_pmt(void *p_data, dvbpsi_pmt_t *p_pmt)
+{
+    dvbpsi_spts_output_t *p_output = (dvbpsi_spts_output_t *)p_data;
+
+    if (p_pmt->b_current_next)
+    {
+        memset(p_output->p_program, 0, sizeof(p_output->p_program));
+        DVBPSI_SPTS_SET(p_output->p_program, p_pmt->i_pcr_pid);
+        if (dvbpsi_has_descriptor(p_pmt->p_tags, 0x09))
+            dvbpsi_spts_ca_pids(p_output->p_program, p_pmt->p_first_descriptor);
+        for (dvbpsi_pmt_es_t *p_es = p_pmt->p_first_es; p_es; p_es = p_es->p_next)
+        {
+            DVBPSI_SPTS_SET(p_output->p_program, p_es->i_pid);
+            if (dvbpsi_has_descriptor(p_es->p_tags, 0x09))
+                dvbpsi_spts_ca_pids(p_output->p_program, p_es->p_first_descriptor);
+        }
+        dvbpsi_spts_update(p_output);
+    }
+
+    dvbpsi_pmt_delete(p_pmt);
+}
+
+/*****************************************************************************
+ * dvbpsi_spts_clear
+ *****************************************************************************
+ * Drops the PMT decoder and the PIDs of the program of an output.
+ *****************************************************************************/
+static void dvbpsi_spts_clear(dvbpsi_spts_output_t *p_output)
+{
+    if (p_output->p_pmt_handle)
+    {
+        dvbpsi_pmt_detach(p_output->p_pmt_handle);
+        dvbpsi_delete(p_output->p_pmt_handle);
+        p_output->p_pmt_handle = NULL;
+    }
+    p_output->i_pmt_pid = DVBPSI_SPTS_NO_PID;
+    memset(p_output->p_program, 0, sizeof(p_output->p_program));
+}
+
+/*****************************************************************************
+ * dvbpsi_spts_set_pmt_pid
+ *****************************************************************************
+ * Attaches the PMT decoder of an output to the PID of its program, or drops
+ * it if the program is not in the PAT.
+ *****************************************************************************/
+static void dvbpsi_spts_set_pmt_pid(dvbpsi_spts_output_t *p_output, uint16_t i_pid)
+{
+    if (p_output->p_pmt_handle && p_output->i_pmt_pid == i_pid)
+        return;
+
+    /* The program moved */
+    dvbpsi_spts_clear(p_output);
+
+    if (i_pid != DVBPSI_SPTS_NO_PID)
+    {
+        dvbpsi_t *p_handle = dvbpsi_new(NULL, DVBPSI_MSG_NONE);
+        if (p_handle && dvbpsi_pmt_attach(p_handle, p_output->i_program_number,
+                                          dvbpsi_spts_pmt, p_output))
+        {
+            p_output->p_pmt_handle = p_handle;
+            p_output->i_pmt_pid = i_pid;
+        }
+        else
+            dvbpsi_delete(p_handle);
+    }
+
+    dvbpsi_spts_update(p_output);
+    dvbpsi_spts_set_pmts(p_output->p_spts);
+}
+
+/*****************************************************************************
+ * dvbpsi_spts_find
+ *****************************************************************************
+ * PID of a program of the last PAT, DVBPSI_SPTS_NO_PID if none.
+ *****************************************************************************/
+static uint16_t dvbpsi_spts_find(const dvbpsi_spts_t *p_spts, uint16_t i_number)
+{
+    for (size_t i = 0; i < p_spts->i_programs; i++)
+        if (p_spts->p_programs[i].i_number == i_number)
+            return p_spts->p_programs[i].i_pid;
+    return DVBPSI_SPTS_NO_PID;
+}
+
+/*****************************************************************************
+ * dvbpsi_spts_pat
+ *****************************************************************************
+ * Follows the PMT PIDs of the programs of a current PAT.
+ *****************************************************************************/
+static void dvbpsi_spts_pat(void *p_data, dvbpsi_pat_t *p_pat)
+{
+    dvbpsi_spts_t *p_spts = (dvbpsi_spts_t *)p_data;
+
+    if (p_pat->b_current_next)
+    {
+        size_t i_programs = 0;
+        for (dvbpsi_pat_program_t *p = p_pat->p_first_program; p; p = p->p_next)
+            i_programs++;
+
+        dvbpsi_spts_program_t *p_programs = NULL;
+        if (i_programs)
+            p_programs = dvbpsi_malloc(i_programs * sizeof(dvbpsi_spts_program_t));
+
+        /* Without memory, the previous PAT is kept */
+        if (p_programs || i_programs == 0)
+        {
+            size_t i = 0;
+            for (dvbpsi_pat_program_t *p = p_pat->p_first_program; p; p = p->p_next, i++)
+            {
+                p_programs[i].i_number = p->i_number;
+                p_programs[i].i_pid = p->i_pid;
+            }
+            dvbpsi_free(p_spts->p_programs);
+            p_spts->p_programs = p_programs;
+            p_spts->i_programs = i_programs;
+
+            for (int j = 0; j < DVBPSI_SPTS_OUTPUTS; j++)
+            {
+                dvbpsi_spts_output_t *p_output = p_spts->pp_outputs[j];
+                if (p_output)
+                    dvbpsi_spts_set_pmt_pid(p_output,
+                            dvbpsi_spts_find(p_spts, p_output->i_program_number));
+            }
+        }
+    }
+
+    dvbpsi_pat_delete(p_pat);
+}
+
+/*****************************************************************************
+ * dvbpsi_spts_packetize
+ *****************************************************************************
+ * Carries a PAT section in the packets of PID 0 of an output.
+ *****************************************************************************/
+static void dvbpsi_spts_packetize(dvbpsi_spts_output_t *p_output,
+                                  const uint8_t *p_section, size_t i_size)
+{
+    uint8_t i_cc = p_output->p_cc[0];
+    bool b_start = true;
+    while (i_size)
+    {
+        uint8_t *p_packet = dvbpsi_spts_slot(p_output);
+        i_cc = (i_cc + 1) & 0x0f;
+        p_packet[0] = 0x47;
+        p_packet[1] = b_start ? 0x40 : 0x00;
+        p_packet[2] = 0x00;
+        p_packet[3] = 0x10 | i_cc;
+
+        size_t i_offset = 4;
+        if (b_start)
+            p_packet[i_offset++] = 0x00;    /* pointer_field */
+        size_t i_chunk = 188 - i_offset;
+        if (i_chunk > i_size)
+            i_chunk = i_size;
+        memcpy(p_packet + i_offset, p_section, i_chunk);
+        memset(p_packet + i_offset + i_chunk, 0xff, 188 - i_offset - i_chunk);
+
+        p_section += i_chunk;
+        i_size -= i_chunk;
+        b_start = false;
+    }
+    p_output->p_cc[0] = i_cc;
+}
+
+/*****************************************************************************
+ * dvbpsi_spts_pat_tap
+ *****************************************************************************
+ * Rewrites each current PAT section to the program of each output.
+ *****************************************************************************/
+static void dvbpsi_spts_pat_tap(void *p_data, uint16_t i_pid, int64_t i_time,
+                                const uint8_t *p_section, size_t i_size)
+{
+    dvbpsi_spts_t *p_spts = (dvbpsi_spts_t *)p_data;
+    (void)i_pid;
+    (void)i_time;
+
+    if (i_size < 12 || i_size > 1024 || p_section[0] != 0x00
+     || !(p_section[5] & 0x01))
+        return;
+
+    for (int j = 0; j < DVBPSI_SPTS_OUTPUTS; j++)
+    {
+        dvbpsi_spts_output_t *p_output = p_spts->pp_outputs[j];
+        if (p_output == NULL)
+            continue;
+
+        /* The other programs and the NIT are dropped, rules which only
+         * change with the programs of the section */
+        for (size_t i = 8; i + 4 <= i_size - 4; i += 4)
+        {
+            uint16_t i_number = ((uint16_t)p_section[i] << 8) | p_section[i + 1];
+            if (i_number == 0)
+                dvbpsi_rewriter_map_pid(p_output->p_rewriter,
+                                        ((uint16_t)(p_section[i + 2] & 0x1f) << 8)
+                                        | p_section[i + 3], DVBPSI_REWRITER_DROP);
+            else if (i_number != p_output->i_program_number)
+                dvbpsi_rewriter_drop_program(p_output->p_rewriter, i_number, true);
+        }
+
+        uint8_t p_out[1024];
+        size_t i_out;
+        if (!dvbpsi_rewriter_rewrite(p_output->p_rewriter, p_section, i_size,
+                                     p_out, &i_out) || i_out == 0)
+            continue;
+
+        dvbpsi_spts_packetize(p_output, p_out, i_out);
+        p_spts->stats.i_pats++;
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_spts_cat
+ *****************************************************************************
+ * Takes the EMM PIDs of a current CAT.
+ *****************************************************************************/
+static void dvbpsi_spts_cat(void *p_data, dvbpsi_cat_t *p_cat)
+{
+    dvbpsi_spts_t *p_spts = (dvbpsi_spts_t *)p_data;
+
+    if (p_cat->b_current_next)
+    {
+        memset(p_spts->p_emms, 0, sizeof(p_spts->p_emms));
+        dvbpsi_spts_ca_pids(p_spts->p_emms, p_cat->p_first_descriptor);
+        for (int j = 0; j < DVBPSI_SPTS_OUTPUTS; j++)
+            if (p_spts->pp_outputs[j])
+                dvbpsi_spts_update(p_spts->pp_outputs[j]);
+    }
+
+    dvbpsi_cat_delete(p_cat);
+}
+
+/*****************************************************************************
+ * dvbpsi_spts_new
+ *****************************************************************************/
+dvbpsi_spts_t *dvbpsi_spts_new(size_t i_batch, dvbpsi_spts_callback pf_callback,
+                               void *p_cb_data)
+{
+    assert(pf_callback);
+
+    if (i_batch == 0)
+        return NULL;
+
+    dvbpsi_spts_t *p_spts = dvbpsi_calloc(1, sizeof(dvbpsi_spts_t));
+    if (p_spts == NULL)
+        return NULL;
+
+    p_spts->pf_callback = pf_callback;
+    p_spts->p_cb_data = p_cb_data;
+    p_spts->i_batch = i_batch;
+    memset(p_spts->p_in_cc, DVBPSI_SPTS_NO_CC, sizeof(p_spts->p_in_cc));
+
+    p_spts->p_pat_handle = dvbpsi_new(NULL, DVBPSI_MSG_NONE);
+    p_spts->p_cat_handle = dvbpsi_new(NULL, DVBPSI_MSG_NONE);
+    if (p_spts->p_pat_handle == NULL || p_spts->p_cat_handle == NULL
+     || !dvbpsi_pat_attach(p_spts->p_pat_handle, dvbpsi_spts_pat, p_spts)
+     || !dvbpsi_cat_attach(p_spts->p_cat_handle, dvbpsi_spts_cat, p_spts))
+    {
+        dvbpsi_spts_delete(p_spts);
+        return NULL;
+    }
+    dvbpsi_set_section_tap(p_spts->p_pat_handle, dvbpsi_spts_pat_tap, p_spts);
+    return p_spts;
+}
+
+/*****************************************************************************
+ * dvbpsi_spts_delete
+ *****************************************************************************/
+void dvbpsi_spts_delete(dvbpsi_spts_t *p_spts)
+{
+    if (p_spts == NULL)
+        return;
+
+    for (unsigned int i = 0; i < DVBPSI_SPTS_OUTPUTS; i++)
+        dvbpsi_spts_remove_output(p_spts, i);
+    if (p_spts->p_pat_handle)
+    {
+        if (p_spts->p_pat_handle->p_decoder)
+            dvbpsi_pat_detach(p_spts->p_pat_handle);
+        dvbpsi_delete(p_spts->p_pat_handle);
+    }
+    if (p_spts->p_cat_handle)
+    {
+        if (p_spts->p_cat_handle->p_decoder)
+            dvbpsi_cat_detach(p_spts->p_cat_handle);
+        dvbpsi_delete(p_spts->p_cat_handle);
+    }
+    dvbpsi_free(p_spts->p_programs);
+    dvbpsi_free(p_spts);
+}
+
+/*****************************************************************************
+ * dvbpsi_spts_add_output
+ *****************************************************************************/
+int dvbpsi_spts_add_output(dvbpsi_spts_t *p_spts, uint16_t i_program_number)
+{
+    assert(p_spts);
+
+    unsigned int i_output = 0;
+    while (i_output < DVBPSI_SPTS_OUTPUTS && p_spts->pp_outputs[i_output])
+        i_output++;
+    if (i_output == DVBPSI_SPTS_OUTPUTS)
+        return -1;
+
+    dvbpsi_spts_output_t *p_output = dvbpsi_calloc(1, sizeof(dvbpsi_spts_output_t));
+    if (p_output == NULL)
+        return -1;
+    p_output->p_batch = dvbpsi_malloc(p_spts->i_batch * 188);
+    p_output->p_rewriter = dvbpsi_rewriter_new();
+    if (p_output->p_batch == NULL || p_output->p_rewriter == NULL)
+    {
+        dvbpsi_rewriter_delete(p_output->p_rewriter);
+        dvbpsi_free(p_output->p_batch);
+        dvbpsi_free(p_output);
+        return -1;
+    }
+
+    p_output->p_spts = p_spts;
+    p_output->i_output = i_output;
+    p_output->i_program_number = i_program_number;
+    p_output->i_pmt_pid = DVBPSI_SPTS_NO_PID;
+    memset(p_output->p_cc, DVBPSI_SPTS_NO_CC, sizeof(p_output->p_cc));
+    p_output->p_cc[0] = 0x0f;
+    p_spts->pp_outputs[i_output] = p_output;
+
+    dvbpsi_spts_set_pmt_pid(p_output, dvbpsi_spts_find(p_spts, i_program_number));
+    return i_output;
+}
+
+/*****************************************************************************
+ * dvbpsi_spts_remove_output
+ *****************************************************************************/
+void dvbpsi_spts_remove_output(dvbpsi_spts_t *p_spts, unsigned int i_output)
+{
+    assert(p_spts);
+
+    if (i_output >= DVBPSI_SPTS_OUTPUTS || p_spts->pp_outputs[i_output] == NULL)
+        return;
+
+    dvbpsi_spts_output_t *p_output = p_spts->pp_outputs[i_output];
+    uint64_t i_bit = (uint64_t)1 << i_output;
+    for (int i = 0; i < 8192; i++)
+        p_spts->p_masks[i] &= ~i_bit;
+
+    dvbpsi_spts_clear(p_output);
+    p_spts->pp_outputs[i_output] = NULL;
+    dvbpsi_spts_set_pmts(p_spts);
+
+    dvbpsi_rewriter_delete(p_output->p_rewriter);
+    dvbpsi_free(p_output->p_batch);
+    dvbpsi_free(p_output);
+}
+
+/*****************************************************************************
+ * dvbpsi_spts_push
+ *****************************************************************************/
+bool dvbpsi_spts_push(dvbpsi_spts_t *p_spts, uint8_t *p_data, size_t i_count,
+                      size_t i_stride, int64_t i_time)
+{
+    assert(p_spts);
+
+    if (i_stride == 0)
+        i_stride = 188;
+    assert(i_stride >= 188);
+
+    bool b_valid = true;
+    uint8_t *p_end = p_data + i_count * i_stride;
+    for (; p_data < p_end; p_data += i_stride)
+    {
+        if (p_data[0] != 0x47)
+        {
+            b_valid = false;
+            continue;
+        }
+        p_spts->stats.i_packets++;
+
+        uint16_t i_pid = ((uint16_t)(p_data[1] & 0x1f) << 8) | p_data[2];
+        if (i_pid == 0x00)
+        {
+            /* Regenerated for each output by the tap */
+            dvbpsi_packet_push_at(p_spts->p_pat_handle, p_data, i_time);
+            continue;
+        }
+        if (i_pid == 0x01)
+            dvbpsi_packet_push_at(p_spts->p_cat_handle, p_data, i_time);
+        else if (DVBPSI_SPTS_TEST(p_spts->p_pmts, i_pid))
+        {
+            for (int j = 0; j < DVBPSI_SPTS_OUTPUTS; j++)
+            {
+                dvbpsi_spts_output_t *p_output = p_spts->pp_outputs[j];
+                if (p_output && p_output->p_pmt_handle && p_output->i_pmt_pid == i_pid)
+                    dvbpsi_packet_push_at(p_output->p_pmt_handle, p_data, i_time);
+            }
+        }
+
+        uint64_t i_mask = p_spts->p_masks[i_pid];
+        if (i_mask == 0)
+        {
+            p_spts->stats.i_dropped++;
+            continue;
+        }
+
+        /* A repeated packet keeps the continuity_counter it is given */
+        bool b_payload = p_data[3] & 0x10;
+        uint8_t i_in_cc = p_data[3] & 0x0f;
+        bool b_duplicate = b_payload && p_spts->p_in_cc[i_pid] == i_in_cc;
+        if (b_payload)
+            p_spts->p_in_cc[i_pid] = i_in_cc;
+
+        while (i_mask)
+        {
+            unsigned int j = __builtin_ctzll(i_mask);
+            i_mask &= i_mask - 1;
+
+            dvbpsi_spts_output_t *p_output = p_spts->pp_outputs[j];
+            uint8_t i_cc = p_output->p_cc[i_pid];
+            if (i_cc == DVBPSI_SPTS_NO_CC)
+                i_cc = i_in_cc;
+            else if (b_payload && !b_duplicate)
+                i_cc = (i_cc + 1) & 0x0f;
+            p_output->p_cc[i_pid] = i_cc;
+
+            uint8_t *p_packet = dvbpsi_spts_slot(p_output);
+            memcpy(p_packet, p_data, 188);
+            p_packet[3] = (p_data[3] & 0xf0) | i_cc;
+            p_spts->stats.i_copied++;
+        }
+    }
+
+    return b_valid;
+}
+
+/*****************************************************************************
+ * dvbpsi_spts_flush
+ *****************************************************************************/
+void dvbpsi_spts_flush(dvbpsi_spts_t *p_spts)
+{
+    assert(p_spts);
+
+    for (int j = 0; j < DVBPSI_SPTS_OUTPUTS; j++)
+        if (p_spts->pp_outputs[j])
+            dvbpsi_spts_deliver(p_spts->pp_outputs[j]);
+}
+
+/*****************************************************************************
+ * dvbpsi_spts_get_pids
+ *****************************************************************************/
+bool dvbpsi_spts_get_pids(const dvbpsi_spts_t *p_spts, unsigned int i_output,
+                          uint8_t p_pids[8192 / 8])
+{
+    assert(p_spts);
+    assert(p_pids);
+
+    if (i_output >= DVBPSI_SPTS_OUTPUTS || p_spts->pp_outputs[i_output] == NULL)
+        return false;
+    memcpy(p_pids, p_spts->pp_outputs[i_output]->p_pids, 8192 / 8);
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_spts_get_stats
+ *****************************************************************************/
+void dvbpsi_spts_get_stats(const dvbpsi_spts_t *p_spts, dvbpsi_spts_stats_t *p_stats)
+{
+    assert(p_spts);
+    assert(p_stats);
+
+    *p_stats = p_spts->stats;
+}
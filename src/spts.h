@@ -0,0 +1,217 @@
+/*****************************************************************************
+ * spts.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <spts.h>
+ * \brief Extraction of single program transport streams.
+ *
+ * Splits a multiple program transport stream into one output per selected
+ * program, in one pass over the packets. The PIDs of each output, its PMT,
+ * PCR, elementary stream and ECM PIDs, the CAT and the EMM PIDs, follow the
+ * PAT, the PMT of the program and the CAT as their versions change. Each
+ * PID has the set of the outputs it goes to, so that a packet costs one
+ * lookup however many outputs there are.
+ *
+ * The PAT of an output is rewritten with dvbpsi_rewriter_rewrite() to its
+ * program only, and carried in its own packets. The other packets are
+ * copied, their continuity_counter renumbered per output so that each
+ * output is continuous, and handed out in batches, e.g. of 7 packets for
+ * UDP or RTP datagrams.
+ */
+
+#ifndef _DVBPSI_SPTS_H_
+#define _DVBPSI_SPTS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \def DVBPSI_SPTS_OUTPUTS
+ * \brief Maximum number of outputs of an extractor.
+ */
+#define DVBPSI_SPTS_OUTPUTS 64
+
+/*****************************************************************************
+ * dvbpsi_spts_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_spts_s dvbpsi_spts_t
+ * \brief dvbpsi_spts_t type definition, an opaque SPTS extractor.
+ */
+typedef struct dvbpsi_spts_s dvbpsi_spts_t;
+
+/*****************************************************************************
+ * dvbpsi_spts_stats_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_spts_stats_s
+ * \brief Counters of an extractor.
+ */
+/*!
+ * \typedef struct dvbpsi_spts_stats_s dvbpsi_spts_stats_t
+ * \brief dvbpsi_spts_stats_t type definition.
+ */
+typedef struct dvbpsi_spts_stats_s
+{
+    uint64_t    i_packets;      /*!< TS packets pushed */
+    uint64_t    i_dropped;      /*!< TS packets of no output */
+    uint64_t    i_copied;       /*!< TS packets copied to the outputs */
+    uint64_t    i_pats;         /*!< PAT sections rewritten for the outputs */
+    uint64_t    i_updates;      /*!< changes of the PIDs of an output */
+} dvbpsi_spts_stats_t;
+
+/*!
+ * \typedef void (* dvbpsi_spts_callback)(void *p_cb_data, unsigned int i_output,
+ *                                        const uint8_t *p_packets, size_t i_count)
+ * \brief Callback type definition, the packets being only valid during the
+ * call.
+ */
+typedef void (* dvbpsi_spts_callback)(void *p_cb_data, unsigned int i_output,
+                                      const uint8_t *p_packets, size_t i_count);
+
+/*****************************************************************************
+ * dvbpsi_spts_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_spts_t *dvbpsi_spts_new(size_t i_batch,
+ *                                    dvbpsi_spts_callback pf_callback,
+ *                                    void *p_cb_data)
+ * \brief Creates an extractor without any output
+ * \param i_batch number of 188 bytes TS packets given to each callback
+ * \param pf_callback function called with the packets of an output
+ * \param p_cb_data private data given in argument to the callback
+ * \return pointer to the extractor, or NULL on error
+ */
+dvbpsi_spts_t *dvbpsi_spts_new(size_t i_batch, dvbpsi_spts_callback pf_callback,
+                               void *p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_spts_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_spts_delete(dvbpsi_spts_t *p_spts)
+ * \brief Deletes an extractor, the packets of the partial batches being lost
+ * \param p_spts pointer to the extractor, or NULL
+ * \return nothing
+ */
+void dvbpsi_spts_delete(dvbpsi_spts_t *p_spts);
+
+/*****************************************************************************
+ * dvbpsi_spts_add_output
+ *****************************************************************************/
+/*!
+ * \fn int dvbpsi_spts_add_output(dvbpsi_spts_t *p_spts,
+ *                                uint16_t i_program_number)
+ * \brief Adds an output carrying a program
+ * \param p_spts pointer to the extractor
+ * \param i_program_number program_number of the program
+ * \return the number of the output given to the callback, or -1 if
+ *         DVBPSI_SPTS_OUTPUTS are used or on a memory error.
+ *
+ * The output starts with the next PAT naming the program. Several outputs
+ * may carry the same program.
+ */
+int dvbpsi_spts_add_output(dvbpsi_spts_t *p_spts, uint16_t i_program_number);
+
+/*****************************************************************************
+ * dvbpsi_spts_remove_output
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_spts_remove_output(dvbpsi_spts_t *p_spts, unsigned int i_output)
+ * \brief Removes an output, the packets of its partial batch being lost
+ * \param p_spts pointer to the extractor
+ * \param i_output number of the output, which may be given again by
+ *        dvbpsi_spts_add_output()
+ * \return nothing
+ */
+void dvbpsi_spts_remove_output(dvbpsi_spts_t *p_spts, unsigned int i_output);
+
+/*****************************************************************************
+ * dvbpsi_spts_push
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_spts_push(dvbpsi_spts_t *p_spts, uint8_t *p_data,
+ *                           size_t i_count, size_t i_stride, int64_t i_time)
+ * \brief Injection of a run of TS packets of the transport stream
+ * \param p_spts pointer to the extractor
+ * \param p_data pointer to the first of 'i_count' 188 bytes TS packets
+ * \param i_count number of TS packets in the buffer
+ * \param i_stride distance in bytes between the start of two successive
+ *        packets, 0 for 188
+ * \param i_time arrival time of the packets, in any monotonic unit of the
+ *        caller, or DVBPSI_TIME_NONE
+ * \return false when at least one packet was not a TS packet, true otherwise.
+ *
+ * The callback is made whenever the batch of an output is full. The
+ * function must not be called from the callback.
+ */
+bool dvbpsi_spts_push(dvbpsi_spts_t *p_spts, uint8_t *p_data, size_t i_count,
+                      size_t i_stride, int64_t i_time);
+
+/*****************************************************************************
+ * dvbpsi_spts_flush
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_spts_flush(dvbpsi_spts_t *p_spts)
+ * \brief Gives the partial batches of all the outputs to the callback
+ * \param p_spts pointer to the extractor
+ * \return nothing
+ */
+void dvbpsi_spts_flush(dvbpsi_spts_t *p_spts);
+
+/*****************************************************************************
+ * dvbpsi_spts_get_pids
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_spts_get_pids(const dvbpsi_spts_t *p_spts, unsigned int i_output,
+ *                               uint8_t p_pids[8192 / 8])
+ * \brief Gets the PIDs copied to an output
+ * \param p_spts pointer to the extractor
+ * \param i_output number of the output
+ * \param p_pids filled with the bitmap of the PIDs, bit i % 8 of byte i / 8
+ *        for PID i; PID 0 is not set, the PAT of the output being rewritten
+ * \return false if the output is not used, true otherwise.
+ */
+bool dvbpsi_spts_get_pids(const dvbpsi_spts_t *p_spts, unsigned int i_output,
+                          uint8_t p_pids[8192 / 8]);
+
+/*****************************************************************************
+ * dvbpsi_spts_get_stats
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_spts_get_stats(const dvbpsi_spts_t *p_spts,
+ *                                dvbpsi_spts_stats_t *p_stats)
+ * \brief Gets the counters of an extractor
+ * \param p_spts pointer to the extractor
+ * \param p_stats receives the counters
+ * \return nothing
+ */
+void dvbpsi_spts_get_stats(const dvbpsi_spts_t *p_spts, dvbpsi_spts_stats_t *p_stats);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of spts.h"
+#endif
@@ -0,0 +1,476 @@
+/*****************************************************************************
+ * t2mi.c: T2-MI decapsulation into PID routers
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "crc32_private.h"
+#include "router.h"
+#include "t2mi.h"
+
+/* T2-MI packet: header, payload of up to 65535 bits, CRC_32 */
+#define T2MI_HEADER_SIZE        6
+#define T2MI_MAX_SIZE           (T2MI_HEADER_SIZE + 8192 + 4)
+#define T2MI_BBFRAME            0x00
+/* Baseband frame payload: frame_idx, plp_id, intl_frame_start */
+#define T2MI_BBFRAME_HEADER     3
+#define T2MI_BBHEADER_SIZE      10
+#define T2MI_NO_SYNCD           0xffff
+/* No continuity_counter seen */
+#define T2MI_NO_CC              0xff
+
+/*****************************************************************************
+ * dvbpsi_t2mi_plp_t
+ *****************************************************************************
+ * A PLP and the TS packet split between its last frame and the next.
+ *****************************************************************************/
+typedef struct dvbpsi_t2mi_plp_s
+{
+    dvbpsi_router_t *   p_router;
+    bool                b_sync;         /* i_packet follows the last frame */
+    size_t              i_packet;       /* bytes of p_packet, sync byte
+                                           included, 0 for none */
+    uint8_t             p_packet[188];
+} dvbpsi_t2mi_plp_t;
+
+/*****************************************************************************
+ * dvbpsi_t2mi_s
+ *****************************************************************************/
+struct dvbpsi_t2mi_s
+{
+    uint16_t            i_pid;
+    uint8_t             i_cc;           /* last continuity_counter */
+    bool                b_sync;         /* i_size follows the last packet */
+    bool                b_count;        /* i_count is known */
+    uint8_t             i_count;        /* last packet_count */
+
+    dvbpsi_t2mi_plp_t * pp_plps[256];
+    dvbpsi_t2mi_stats_t stats;
+
+    /* T2-MI packet being reassembled */
+    size_t              i_size;
+    size_t              i_total;        /* its size, once the header is in */
+    uint8_t             p_packet[T2MI_MAX_SIZE];
+};
+
+/*****************************************************************************
+ * dvbpsi_t2mi_new
+ *****************************************************************************/
+dvbpsi_t2mi_t *dvbpsi_t2mi_new(uint16_t i_pid)
+{
+    dvbpsi_t2mi_t *p_t2mi = dvbpsi_calloc(1, sizeof(dvbpsi_t2mi_t));
+    if (p_t2mi == NULL)
+        return NULL;
+
+    p_t2mi->i_pid = i_pid & 0x1fff;
+    p_t2mi->i_cc = T2MI_NO_CC;
+    return p_t2mi;
+}
+
+/*****************************************************************************
+ * dvbpsi_t2mi_delete
+ *****************************************************************************/
+void dvbpsi_t2mi_delete(dvbpsi_t2mi_t *p_t2mi)
+{
+    if (p_t2mi == NULL)
+        return;
+
+    for (int i = 0; i < 256; i++)
+        dvbpsi_free(p_t2mi->pp_plps[i]);
+    dvbpsi_free(p_t2mi);
+}
+
+/*****************************************************************************
+ * dvbpsi_t2mi_attach
+ *****************************************************************************/
+bool dvbpsi_t2mi_attach(dvbpsi_t2mi_t *p_t2mi, uint8_t i_plp_id,
+                        dvbpsi_router_t *p_router)
+{
+    assert(p_t2mi);
+    assert(p_router);
+
+    if (dvbpsi_router_get_packet_format(p_router) != DVBPSI_PACKET_TS)
+        return false;
+
+    dvbpsi_t2mi_plp_t *p_plp = p_t2mi->pp_plps[i_plp_id];
+    if (p_plp)
+        return p_plp->p_router == p_router;
+
+    p_plp = dvbpsi_calloc(1, sizeof(dvbpsi_t2mi_plp_t));
+    if (p_plp == NULL)
+        return false;
+    p_plp->p_router = p_router;
+    p_t2mi->pp_plps[i_plp_id] = p_plp;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_t2mi_detach
+ *****************************************************************************/
+dvbpsi_router_t *dvbpsi_t2mi_detach(dvbpsi_t2mi_t *p_t2mi, uint8_t i_plp_id)
+{
+    assert(p_t2mi);
+
+    dvbpsi_t2mi_plp_t *p_plp = p_t2mi->pp_plps[i_plp_id];
+    if (p_plp == NULL)
+        return NULL;
+
+    dvbpsi_router_t *p_router = p_plp->p_router;
+    p_t2mi->pp_plps[i_plp_id] = NULL;
+    dvbpsi_free(p_plp);
+    return p_router;
+}
+
+/*****************************************************************************
+ * dvbpsi_t2mi_lost
+ *****************************************************************************
+ * Drops the TS packets split between frames after a loss: the PLPs start
+ * again from the SYNCD of their next frames.
+ *****************************************************************************/
+static void dvbpsi_t2mi_lost(dvbpsi_t2mi_t *p_t2mi)
+{
+    p_t2mi->stats.i_discontinuities++;
+    p_t2mi->b_count = false;
+    for (int i = 0; i < 256; i++)
+        if (p_t2mi->pp_plps[i])
+        {
+            p_t2mi->pp_plps[i]->b_sync = false;
+            p_t2mi->pp_plps[i]->i_packet = 0;
+        }
+}
+
+/*****************************************************************************
+ * dvbpsi_t2mi_crc8
+ *****************************************************************************
+ * CRC-8 of a BBHEADER, polynomial 0xd5, MSB first.
+ *****************************************************************************/
+static uint8_t dvbpsi_t2mi_crc8(const uint8_t *p_data, size_t i_size)
+{
+    uint8_t i_crc = 0;
+    for (size_t i = 0; i < i_size; i++)
+    {
+        i_crc ^= p_data[i];
+        for (int j = 0; j < 8; j++)
+            i_crc = (i_crc & 0x80) ? (uint8_t)(i_crc << 1) ^ 0xd5 : (uint8_t)(i_crc << 1);
+    }
+    return i_crc;
+}
+
+/*****************************************************************************
+ * dvbpsi_t2mi_emit
+ *****************************************************************************
+ * Gives TS packets to the router of a PLP.
+ *****************************************************************************/
+static inline void dvbpsi_t2mi_emit(dvbpsi_t2mi_t *p_t2mi, dvbpsi_t2mi_plp_t *p_plp,
+                                    uint8_t *p_packets, size_t i_count, size_t i_stride)
+{
+    dvbpsi_router_push(p_plp->p_router, p_packets, i_count, i_stride);
+    p_t2mi->stats.i_ts_packets += i_count;
+}
+
+/*****************************************************************************
+ * dvbpsi_t2mi_bbframe
+ *****************************************************************************
+ * Extracts the TS packets of the data field of a baseband frame. Each user
+ * packet is 188 bytes in NM, its sync byte replaced by a CRC-8, 187 bytes
+ * without it in HEM, followed in NM by an ISSY field of 2 or 3 bytes when
+ * ISSYI is set, and by the DNP byte when NPD is set. SYNCD is the distance
+ * in bits from the start of the data field to the first user packet.
+ *****************************************************************************/
+static void dvbpsi_t2mi_bbframe(dvbpsi_t2mi_t *p_t2mi, uint8_t *p_payload, size_t i_size)
+{
+    if (i_size < T2MI_BBFRAME_HEADER + T2MI_BBHEADER_SIZE)
+        return;
+
+    uint8_t i_plp_id = p_payload[1];
+    p_t2mi->stats.p_plps[i_plp_id / 8] |= 1 << (i_plp_id % 8);
+    dvbpsi_t2mi_plp_t *p_plp = p_t2mi->pp_plps[i_plp_id];
+    if (p_plp == NULL)
+        return;
+    p_t2mi->stats.i_bbframes++;
+
+    /* BBHEADER: MATYPE, UPL, DFL, SYNC, SYNCD, CRC-8 xor MODE */
+    uint8_t *p_header = p_payload + T2MI_BBFRAME_HEADER;
+    uint8_t i_mode = dvbpsi_t2mi_crc8(p_header, 9) ^ p_header[9];
+    if ((p_header[0] & 0xc0) != 0xc0 || i_mode > 1)
+    {
+        p_t2mi->stats.i_header_errors++;
+        p_plp->b_sync = false;
+        p_plp->i_packet = 0;
+        return;
+    }
+    bool b_hem = (i_mode == 1);
+    bool b_issy = !b_hem && (p_header[0] & 0x08);
+    size_t i_npd = (p_header[0] & 0x04) ? 1 : 0;
+    size_t i_dfl = (((uint16_t)p_header[4] << 8) | p_header[5]) / 8;
+    uint16_t i_syncd = ((uint16_t)p_header[7] << 8) | p_header[8];
+
+    uint8_t *p_data = p_header + T2MI_BBHEADER_SIZE;
+    uint8_t *p_end = p_payload + i_size;
+    if (i_dfl < (size_t)(p_end - p_data))
+        p_end = p_data + i_dfl;
+    uint8_t *p_first = (i_syncd == T2MI_NO_SYNCD) ? p_end : p_data + i_syncd / 8;
+    if (p_first > p_end)
+    {
+        p_t2mi->stats.i_header_errors++;
+        p_plp->b_sync = false;
+        p_plp->i_packet = 0;
+        return;
+    }
+
+    /* End of the packet split with the last frame, up to the first one
+     * starting in this frame */
+    if (p_plp->b_sync && p_plp->i_packet)
+    {
+        size_t i_copy = 188 - p_plp->i_packet;
+        if (i_copy > (size_t)(p_first - p_data))
+            i_copy = p_first - p_data;
+        memcpy(p_plp->p_packet + p_plp->i_packet, p_data, i_copy);
+        p_plp->i_packet += i_copy;
+        if (p_plp->i_packet == 188)
+        {
+            dvbpsi_t2mi_emit(p_t2mi, p_plp, p_plp->p_packet, 1, 188);
+            p_plp->i_packet = 0;
+        }
+        else if (p_first < p_end)
+            p_plp->i_packet = 0;
+    }
+    if (i_syncd == T2MI_NO_SYNCD)
+        return;
+    p_plp->b_sync = true;
+    p_plp->i_packet = 0;
+
+    /* The packets of the frame, their sync byte restored in place over the
+     * CRC-8 in NM and over the previous byte in HEM, with runs of the same
+     * stride given at once */
+    size_t i_up = b_hem ? 187 : 188;
+    uint8_t *p_up = p_first;
+    uint8_t *p_run = NULL;
+    size_t i_run = 0;
+    while (p_up + i_up <= p_end)
+    {
+        uint8_t *p_packet = b_hem ? p_up - 1 : p_up;
+        size_t i_extra = i_npd;
+        if (b_issy)
+        {
+            if (p_up + i_up >= p_end)
+                i_extra += 2;
+            else
+                i_extra += ((p_up[i_up] & 0xc0) == 0x80) ? 3 : 2;
+        }
+
+        /* In HEM the next sync byte overwrites the end of this packet */
+        *p_packet = 0x47;
+        if (b_hem || b_issy)
+            dvbpsi_t2mi_emit(p_t2mi, p_plp, p_packet, 1, 188);
+        else if (i_run++ == 0)
+            p_run = p_packet;
+        if ((size_t)(p_end - p_up) < i_up + i_extra)
+        {
+            p_up = p_end;
+            break;
+        }
+        p_up += i_up + i_extra;
+    }
+    if (i_run)
+        dvbpsi_t2mi_emit(p_t2mi, p_plp, p_run, i_run, i_up + i_npd);
+
+    /* Beginning of the packet continued in the next frame */
+    if (p_up < p_end)
+    {
+        p_plp->i_packet = b_hem ? 1 : 0;
+        memcpy(p_plp->p_packet + p_plp->i_packet, p_up, p_end - p_up);
+        p_plp->i_packet += p_end - p_up;
+        p_plp->p_packet[0] = 0x47;
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_t2mi_packet
+ *****************************************************************************
+ * Handles a reassembled T2-MI packet.
+ *****************************************************************************/
+static void dvbpsi_t2mi_packet(dvbpsi_t2mi_t *p_t2mi)
+{
+    uint8_t *p = p_t2mi->p_packet;
+
+    p_t2mi->stats.i_packets++;
+    if (dvbpsi_crc32(0xffffffff, p, p_t2mi->i_total) != 0)
+    {
+        p_t2mi->stats.i_crc_errors++;
+        dvbpsi_t2mi_lost(p_t2mi);
+        return;
+    }
+
+    /* packet_count follows all the T2-MI packets */
+    if (p_t2mi->b_count && p[1] != (uint8_t)(p_t2mi->i_count + 1))
+        dvbpsi_t2mi_lost(p_t2mi);
+    p_t2mi->b_count = true;
+    p_t2mi->i_count = p[1];
+
+    if (p[0] == T2MI_BBFRAME)
+    {
+        size_t i_payload = ((((uint16_t)p[4] << 8) | p[5]) + 7) / 8;
+        dvbpsi_t2mi_bbframe(p_t2mi, p + T2MI_HEADER_SIZE, i_payload);
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_t2mi_gather
+ *****************************************************************************
+ * Appends the payload bytes of a TS packet to the T2-MI packets.
+ *****************************************************************************/
+static void dvbpsi_t2mi_gather(dvbpsi_t2mi_t *p_t2mi, const uint8_t *p_data, size_t i_size)
+{
+    while (i_size && p_t2mi->b_sync)
+    {
+        size_t i_want = p_t2mi->i_size < T2MI_HEADER_SIZE
+                      ? T2MI_HEADER_SIZE - p_t2mi->i_size
+                      : p_t2mi->i_total - p_t2mi->i_size;
+        size_t i_copy = i_want < i_size ? i_want : i_size;
+        memcpy(p_t2mi->p_packet + p_t2mi->i_size, p_data, i_copy);
+        p_t2mi->i_size += i_copy;
+        p_data += i_copy;
+        i_size -= i_copy;
+
+        if (p_t2mi->i_size == T2MI_HEADER_SIZE && p_t2mi->i_total == 0)
+        {
+            /* Stuffing up to the next packet starting one */
+            if (p_t2mi->p_packet[0] == 0xff)
+            {
+                p_t2mi->b_sync = false;
+                p_t2mi->i_size = 0;
+                return;
+            }
+            uint16_t i_bits = ((uint16_t)p_t2mi->p_packet[4] << 8) | p_t2mi->p_packet[5];
+            p_t2mi->i_total = T2MI_HEADER_SIZE + (i_bits + 7) / 8 + 4;
+        }
+        else if (p_t2mi->i_total && p_t2mi->i_size == p_t2mi->i_total)
+        {
+            dvbpsi_t2mi_packet(p_t2mi);
+            p_t2mi->i_size = 0;
+            p_t2mi->i_total = 0;
+        }
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_t2mi_push
+ *****************************************************************************/
+bool dvbpsi_t2mi_push(dvbpsi_t2mi_t *p_t2mi, const uint8_t *p_data, size_t i_count,
+                      size_t i_stride)
+{
+    assert(p_t2mi);
+
+    bool b_ok = true;
+    if (i_stride == 0)
+        i_stride = 188;
+
+    for (size_t i = 0; i < i_count; i++)
+    {
+        const uint8_t *p_packet = p_data + i * i_stride;
+        if (p_packet[0] != 0x47)
+        {
+            b_ok = false;
+            continue;
+        }
+        if ((((uint16_t)(p_packet[1] & 0x1f) << 8) | p_packet[2]) != p_t2mi->i_pid)
+            continue;
+
+        /* Errored or scrambled packets break the T2-MI packet in progress */
+        if ((p_packet[1] & 0x80) || (p_packet[3] & 0xc0))
+        {
+            if (p_t2mi->b_sync)
+                dvbpsi_t2mi_lost(p_t2mi);
+            p_t2mi->b_sync = false;
+            p_t2mi->i_cc = T2MI_NO_CC;
+            continue;
+        }
+        if (!(p_packet[3] & 0x10))
+            continue;
+
+        uint8_t i_cc = p_packet[3] & 0x0f;
+        if (i_cc == p_t2mi->i_cc)
+            continue;
+        if (p_t2mi->i_cc != T2MI_NO_CC && i_cc != ((p_t2mi->i_cc + 1) & 0x0f))
+        {
+            if (p_t2mi->b_sync)
+                dvbpsi_t2mi_lost(p_t2mi);
+            p_t2mi->b_sync = false;
+        }
+        p_t2mi->i_cc = i_cc;
+
+        const uint8_t *p_payload = p_packet + 4;
+        if (p_packet[3] & 0x20)
+            p_payload += 1 + p_packet[4];
+        const uint8_t *p_end = p_packet + 188;
+        if (p_payload >= p_end)
+            continue;
+
+        if (p_packet[1] & 0x40)
+        {
+            /* pointer_field: end of the packet in progress, then the next */
+            const uint8_t *p_start = p_payload + 1 + p_payload[0];
+            if (p_start > p_end)
+            {
+                p_t2mi->b_sync = false;
+                continue;
+            }
+            dvbpsi_t2mi_gather(p_t2mi, p_payload + 1, p_start - p_payload - 1);
+            if (p_t2mi->b_sync && p_t2mi->i_size)
+                dvbpsi_t2mi_lost(p_t2mi);
+            p_t2mi->b_sync = true;
+            p_t2mi->i_size = 0;
+            p_t2mi->i_total = 0;
+            dvbpsi_t2mi_gather(p_t2mi, p_start, p_end - p_start);
+        }
+        else
+            dvbpsi_t2mi_gather(p_t2mi, p_payload, p_end - p_payload);
+    }
+    return b_ok;
+}
+
+/*****************************************************************************
+ * dvbpsi_t2mi_get_stats
+ *****************************************************************************/
+void dvbpsi_t2mi_get_stats(const dvbpsi_t2mi_t *p_t2mi, dvbpsi_t2mi_stats_t *p_stats)
+{
+    assert(p_t2mi);
+    assert(p_stats);
+    *p_stats = p_t2mi->stats;
+}
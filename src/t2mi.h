@@ -0,0 +1,176 @@
+/*****************************************************************************
+ * t2mi.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <t2mi.h>
+ * \brief T2-MI decapsulation into PID routers.
+ *
+ * A T2-MI decapsulator takes the TS packets of an outer transport stream
+ * carrying a DVB-T2 modulator interface stream (ETSI TS 102 773) on one
+ * PID. It reassembles the T2-MI packets from the payload of that PID,
+ * following the pointer_field of the packets starting one, checks their
+ * CRC_32 and packet_count, and extracts the TS packets of the baseband
+ * frames of each PLP into the PID router attached to the PLP, see
+ * router.h.
+ *
+ * The baseband frames in normal mode (NM) and high efficiency mode (HEM)
+ * are both followed, told apart by their BBHEADER, with null packet
+ * deletion and, in NM, ISSY fields. The deleted null packets are not
+ * inserted again. The TS packets within a frame are given to the router
+ * from the T2-MI packet, where their sync byte is restored in place, and
+ * runs of them with a single call in NM: only the packets split between
+ * two frames are copied.
+ */
+
+#ifndef _DVBPSI_T2MI_H_
+#define _DVBPSI_T2MI_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_t2mi_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_t2mi_s dvbpsi_t2mi_t
+ * \brief dvbpsi_t2mi_t type definition, an opaque T2-MI decapsulator.
+ */
+typedef struct dvbpsi_t2mi_s dvbpsi_t2mi_t;
+
+/*****************************************************************************
+ * dvbpsi_t2mi_stats_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_t2mi_stats_s
+ * \brief Counters of a decapsulator, see dvbpsi_t2mi_get_stats()
+ */
+/*!
+ * \typedef struct dvbpsi_t2mi_stats_s dvbpsi_t2mi_stats_t
+ * \brief dvbpsi_t2mi_stats_t type definition.
+ */
+typedef struct dvbpsi_t2mi_stats_s
+{
+    uint64_t i_packets;         /*!< T2-MI packets reassembled */
+    uint64_t i_crc_errors;      /*!< T2-MI packets with a bad CRC_32 */
+    uint64_t i_discontinuities; /*!< losses of the outer TS packets or of
+                                     T2-MI packets, after which the PLPs
+                                     resynchronize */
+    uint64_t i_bbframes;        /*!< baseband frames of the attached PLPs */
+    uint64_t i_header_errors;   /*!< baseband frames of a bad BBHEADER, or
+                                     not of a transport stream */
+    uint64_t i_ts_packets;      /*!< TS packets given to the routers */
+    uint8_t  p_plps[32];        /*!< bit i % 8 of byte i / 8 set if PLP i
+                                     was seen, attached or not */
+} dvbpsi_t2mi_stats_t;
+
+/*****************************************************************************
+ * dvbpsi_t2mi_new/dvbpsi_t2mi_delete
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_t2mi_t *dvbpsi_t2mi_new(uint16_t i_pid)
+ * \brief Creates a decapsulator without any attached PLP
+ * \param i_pid PID of the outer transport stream carrying the T2-MI
+ *        packets
+ * \return pointer to the decapsulator, or NULL on error
+ */
+dvbpsi_t2mi_t *dvbpsi_t2mi_new(uint16_t i_pid);
+
+/*!
+ * \fn void dvbpsi_t2mi_delete(dvbpsi_t2mi_t *p_t2mi)
+ * \brief Deletes a decapsulator. The attached routers are not deleted.
+ * \param p_t2mi pointer to the decapsulator, or NULL
+ * \return nothing
+ */
+void dvbpsi_t2mi_delete(dvbpsi_t2mi_t *p_t2mi);
+
+/*****************************************************************************
+ * dvbpsi_t2mi_attach/dvbpsi_t2mi_detach
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_t2mi_attach(dvbpsi_t2mi_t *p_t2mi, uint8_t i_plp_id,
+ *                             dvbpsi_router_t *p_router)
+ * \brief Gives the TS packets of a PLP to a router
+ * \param p_t2mi pointer to the decapsulator
+ * \param i_plp_id plp_id
+ * \param p_router router of the inner transport stream, of the
+ *        DVBPSI_PACKET_TS format
+ * \return false if the PLP is already attached to another router, if the
+ *         router takes another packet format, or on error
+ *
+ * The PLP starts at the first TS packet signalled by the SYNCD of its next
+ * baseband frame.
+ */
+bool dvbpsi_t2mi_attach(dvbpsi_t2mi_t *p_t2mi, uint8_t i_plp_id,
+                        dvbpsi_router_t *p_router);
+
+/*!
+ * \fn dvbpsi_router_t *dvbpsi_t2mi_detach(dvbpsi_t2mi_t *p_t2mi, uint8_t i_plp_id)
+ * \brief Stops giving the TS packets of a PLP to its router
+ * \param p_t2mi pointer to the decapsulator
+ * \param i_plp_id plp_id
+ * \return the router that was attached to the PLP, or NULL
+ */
+dvbpsi_router_t *dvbpsi_t2mi_detach(dvbpsi_t2mi_t *p_t2mi, uint8_t i_plp_id);
+
+/*****************************************************************************
+ * dvbpsi_t2mi_push
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_t2mi_push(dvbpsi_t2mi_t *p_t2mi, const uint8_t *p_data,
+ *                           size_t i_count, size_t i_stride)
+ * \brief Injection of a run of TS packets of the outer transport stream
+ * \param p_t2mi pointer to the decapsulator
+ * \param p_data pointer to the first of 'i_count' 188 bytes TS packets
+ * \param i_count number of TS packets in the buffer
+ * \param i_stride distance in bytes between the start of two successive
+ *        packets, 0 for 188
+ * \return false when at least one packet was not a TS packet, true otherwise.
+ *
+ * Packets of all the PIDs can be pushed, those of other PIDs than the
+ * T2-MI one costing a header check, so that the outer stream can be given
+ * both to a decapsulator and to its own router. The inner TS packets are
+ * given to the routers during the call.
+ */
+bool dvbpsi_t2mi_push(dvbpsi_t2mi_t *p_t2mi, const uint8_t *p_data, size_t i_count,
+                      size_t i_stride);
+
+/*****************************************************************************
+ * dvbpsi_t2mi_get_stats
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_t2mi_get_stats(const dvbpsi_t2mi_t *p_t2mi,
+ *                                dvbpsi_t2mi_stats_t *p_stats)
+ * \brief Gets the counters of a decapsulator
+ * \param p_t2mi pointer to the decapsulator
+ * \param p_stats filled with the counters, since dvbpsi_t2mi_new()
+ * \return nothing
+ */
+void dvbpsi_t2mi_get_stats(const dvbpsi_t2mi_t *p_t2mi, dvbpsi_t2mi_stats_t *p_stats);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of t2mi.h"
+#endif
@@ -36,6 +36,7 @@ Decode PSIP Virtual Channel Table.
 #include <assert.h>
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_TABLE
 #include "../dvbpsi_private.h"
 #include "../psi.h"
 #include "../descriptor.h"
@@ -176,7 +177,9 @@ void dvbpsi_atsc_InitEIT(dvbpsi_atsc_eit_t* p_eit, uint8_t i_table_id, uint16_t
     p_eit->i_protocol = i_protocol;
     p_eit->i_source_id = i_source_id;
     p_eit->p_first_event = NULL;
+    p_eit->p_last_event = NULL;
     p_eit->p_first_descriptor = NULL;
+    p_eit->p_last_descriptor = NULL;
 }
 
 dvbpsi_atsc_eit_t *dvbpsi_atsc_NewEIT(uint8_t i_table_id, uint16_t i_extension,
@@ -184,7 +187,7 @@ dvbpsi_atsc_eit_t *dvbpsi_atsc_NewEIT(uint8_t i_table_id, uint16_t i_extension,
                                       uint16_t i_source_id, bool b_current_next)
 {
     dvbpsi_atsc_eit_t *p_eit;
-    p_eit = (dvbpsi_atsc_eit_t*) malloc(sizeof(dvbpsi_atsc_eit_t));
+    p_eit = (dvbpsi_atsc_eit_t*) dvbpsi_malloc(sizeof(dvbpsi_atsc_eit_t));
     if (p_eit != NULL)
         dvbpsi_atsc_InitEIT(p_eit, i_table_id, i_extension, i_version,
                             i_protocol, i_source_id, b_current_next);
@@ -204,20 +207,22 @@ void dvbpsi_atsc_EmptyEIT(dvbpsi_atsc_eit_t* p_eit)
   {
     dvbpsi_atsc_eit_event_t* p_tmp = p_event->p_next;
     dvbpsi_DeleteDescriptors(p_event->p_first_descriptor);
-    free(p_event);
+    dvbpsi_free(p_event);
     p_event = p_tmp;
   }
   p_eit->p_first_event = NULL;
+  p_eit->p_last_event = NULL;
 
   dvbpsi_DeleteDescriptors(p_eit->p_first_descriptor);
   p_eit->p_first_descriptor = NULL;
+  p_eit->p_last_descriptor = NULL;
 }
 
 void dvbpsi_atsc_DeleteEIT(dvbpsi_atsc_eit_t *p_eit)
 {
     if (p_eit)
         dvbpsi_atsc_EmptyEIT(p_eit);
-    free(p_eit);
+    dvbpsi_free(p_eit);
     p_eit = NULL;
 }
 
@@ -235,7 +240,7 @@ static dvbpsi_atsc_eit_event_t *dvbpsi_atsc_EITAddEvent(dvbpsi_atsc_eit_t* p_eit
                                             uint8_t *p_title)
 {
   dvbpsi_atsc_eit_event_t * p_event
-                = (dvbpsi_atsc_eit_event_t*)malloc(sizeof(dvbpsi_atsc_eit_event_t));
+                = (dvbpsi_atsc_eit_event_t*)dvbpsi_malloc(sizeof(dvbpsi_atsc_eit_event_t));
   if(p_event)
   {
     p_event->i_event_id = i_event_id;
@@ -247,19 +252,10 @@ static dvbpsi_atsc_eit_event_t *dvbpsi_atsc_EITAddEvent(dvbpsi_atsc_eit_t* p_eit
     memcpy(p_event->i_title, p_title, i_title_length);
 
     p_event->p_first_descriptor = NULL;
+    p_event->p_last_descriptor = NULL;
     p_event->p_next = NULL;
 
-    if(p_eit->p_first_event== NULL)
-    {
-      p_eit->p_first_event = p_event;
-    }
-    else
-    {
-      dvbpsi_atsc_eit_event_t * p_last_event = p_eit->p_first_event;
-      while(p_last_event->p_next != NULL)
-        p_last_event = p_last_event->p_next;
-      p_last_event->p_next = p_event;
-    }
+    dvbpsi_list_append(p_eit->p_first_event, p_eit->p_last_event, p_event);
   }
 
   return p_event;
@@ -280,19 +276,15 @@ static dvbpsi_descriptor_t *dvbpsi_atsc_EITChannelAddDescriptor(
     if (p_descriptor == NULL)
         return NULL;
 
-    p_event->p_first_descriptor = dvbpsi_AddDescriptor(p_event->p_first_descriptor,
-                                                       p_descriptor);
-    assert(p_event->p_first_descriptor);
-    if (p_event->p_first_descriptor == NULL)
-        return NULL;
+    dvbpsi_list_append(p_event->p_first_descriptor, p_event->p_last_descriptor, p_descriptor);
 
     return p_descriptor;
 }
 
 /*****************************************************************************
- * dvbpsi_ReInitEIT                                                          *
+ * dvbpsi_atsc_ReInitEIT                                                     *
  *****************************************************************************/
-static void dvbpsi_ReInitEIT(dvbpsi_atsc_eit_decoder_t *p_decoder, const bool b_force)
+static void dvbpsi_atsc_ReInitEIT(dvbpsi_atsc_eit_decoder_t *p_decoder, const bool b_force)
 {
     assert(p_decoder);
 
@@ -308,7 +300,7 @@ static void dvbpsi_ReInitEIT(dvbpsi_atsc_eit_decoder_t *p_decoder, const bool b_
     p_decoder->p_building_eit = NULL;
 }
 
-static bool dvbpsi_CheckEIT(dvbpsi_t *p_dvbpsi, dvbpsi_atsc_eit_decoder_t *p_decoder,
+static bool dvbpsi_atsc_CheckEIT(dvbpsi_t *p_dvbpsi, dvbpsi_atsc_eit_decoder_t *p_decoder,
                             dvbpsi_psi_section_t *p_section)
 {
     bool b_reinit = false;
@@ -344,7 +336,7 @@ static bool dvbpsi_CheckEIT(dvbpsi_t *p_dvbpsi, dvbpsi_atsc_eit_decoder_t *p_dec
     return b_reinit;
 }
 
-static bool dvbpsi_AddSectionEIT(dvbpsi_t *p_dvbpsi, dvbpsi_atsc_eit_decoder_t *p_decoder,
+static bool dvbpsi_atsc_AddSectionEIT(dvbpsi_t *p_dvbpsi, dvbpsi_atsc_eit_decoder_t *p_decoder,
                                  dvbpsi_psi_section_t* p_section)
 {
     assert(p_dvbpsi);
@@ -405,7 +397,7 @@ static void dvbpsi_atsc_GatherEITSections(dvbpsi_t * p_dvbpsi,
     /* TS discontinuity check */
     if (p_demux->b_discontinuity)
     {
-        dvbpsi_ReInitEIT(p_eit_decoder, true);
+        dvbpsi_atsc_ReInitEIT(p_eit_decoder, true);
         p_eit_decoder->b_discontinuity = false;
         p_demux->b_discontinuity = false;
     }
@@ -414,8 +406,8 @@ static void dvbpsi_atsc_GatherEITSections(dvbpsi_t * p_dvbpsi,
         /* Perform a few sanity checks */
         if (p_eit_decoder->p_building_eit)
         {
-            if (dvbpsi_CheckEIT(p_dvbpsi, p_eit_decoder, p_section))
-                dvbpsi_ReInitEIT(p_eit_decoder, true);
+            if (dvbpsi_atsc_CheckEIT(p_dvbpsi, p_eit_decoder, p_section))
+                dvbpsi_atsc_ReInitEIT(p_eit_decoder, true);
         }
         else
         {
@@ -425,6 +417,8 @@ static void dvbpsi_atsc_GatherEITSections(dvbpsi_t * p_dvbpsi,
                                                p_section->b_current_next))
             {
                 /* Don't decode since this version is already decoded */
+                p_dvbpsi->stats.i_dropped_duplicate++;
+                dvbpsi_probe_dropped(p_section, "duplicate");
                 dvbpsi_debug(p_dvbpsi, "ATSC EIT decoder",
                              "ignoring already decoded section %d",
                              p_section->i_number);
@@ -439,7 +433,7 @@ static void dvbpsi_atsc_GatherEITSections(dvbpsi_t * p_dvbpsi,
                 if ((!p_eit_decoder->current_eit.b_current_next) &&
                      (p_section->b_current_next))
                 {
-                    dvbpsi_atsc_eit_t * p_eit = (dvbpsi_atsc_eit_t*)malloc(sizeof(dvbpsi_atsc_eit_t));
+                    dvbpsi_atsc_eit_t * p_eit = (dvbpsi_atsc_eit_t*)dvbpsi_malloc(sizeof(dvbpsi_atsc_eit_t));
                     if (p_eit)
                     {
                         p_eit_decoder->current_eit.b_current_next = true;
@@ -457,7 +451,7 @@ static void dvbpsi_atsc_GatherEITSections(dvbpsi_t * p_dvbpsi,
     }
 
     /* Add section to EIT */
-    if (!dvbpsi_AddSectionEIT(p_dvbpsi, p_eit_decoder, p_section))
+    if (!dvbpsi_atsc_AddSectionEIT(p_dvbpsi, p_eit_decoder, p_section))
     {
         dvbpsi_error(p_dvbpsi, "ATSC EIT decoder", "failed decoding section %d",
                      p_section->i_number);
@@ -468,6 +462,7 @@ static void dvbpsi_atsc_GatherEITSections(dvbpsi_t * p_dvbpsi,
     /* Check if we have all the sections */
     if (dvbpsi_decoder_psi_sections_completed(DVBPSI_DECODER(p_eit_decoder)))
     {
+        p_dvbpsi->stats.i_tables++;
         assert(p_eit_decoder->pf_eit_callback);
 
         /* Save the current information */
@@ -477,10 +472,12 @@ static void dvbpsi_atsc_GatherEITSections(dvbpsi_t * p_dvbpsi,
         dvbpsi_atsc_DecodeEITSections(p_eit_decoder->p_building_eit,
                                       p_eit_decoder->p_sections);
         /* signal the new EIT */
+        dvbpsi_probe_callback_entry("atsc_eit", p_section->i_table_id, p_section->i_extension);
         p_eit_decoder->pf_eit_callback(p_eit_decoder->p_cb_data,
                                        p_eit_decoder->p_building_eit);
+        dvbpsi_probe_callback_exit("atsc_eit", p_section->i_table_id, p_section->i_extension);
         /* Delete sections and Reinitialize the structures */
-        dvbpsi_ReInitEIT(p_eit_decoder, false);
+        dvbpsi_atsc_ReInitEIT(p_eit_decoder, false);
         assert(p_eit_decoder->p_sections == NULL);
     }
 }
@@ -55,6 +55,7 @@ typedef struct dvbpsi_atsc_eit_event_s
     uint8_t    i_title[256];    /*!< Title in multiple string structure format. */
 
     dvbpsi_descriptor_t *p_first_descriptor; /*!< First descriptor structure. */
+    dvbpsi_descriptor_t *p_last_descriptor;  /*!< private, list tail */
 
     struct dvbpsi_atsc_eit_event_s   *p_next;/*!< Next event information structure. */
 
@@ -84,8 +85,10 @@ typedef struct dvbpsi_atsc_eit_s
     uint8_t                 i_protocol;         /*!< PSIP Protocol version */
 
     dvbpsi_atsc_eit_event_t *p_first_event;     /*!< First event information structure. */
+    dvbpsi_atsc_eit_event_t *p_last_event;      /*!< private, list tail */
 
     dvbpsi_descriptor_t     *p_first_descriptor;/*!< First descriptor structure. */
+    dvbpsi_descriptor_t     *p_last_descriptor; /*!< private, list tail */
 } dvbpsi_atsc_eit_t;
 
 /*****************************************************************************
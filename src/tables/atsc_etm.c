@@ -0,0 +1,315 @@
+/*****************************************************************************
+ * atsc_etm.c: index of the ATSC Extended Text Messages
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+#include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_TABLE
+#include "../dvbpsi_private.h"
+#include "../psi.h"
+#include "../descriptor.h"
+
+#include "atsc_ett.h"
+#include "atsc_eit.h"
+#include "atsc_vct.h"
+#include "atsc_mgt.h"
+#include "atsc_etm.h"
+
+/* Version of a PID that is not an ETT PID of the MGT */
+#define DVBPSI_ATSC_ETM_NONE 0xff
+
+/*****************************************************************************
+ * dvbpsi_atsc_etm_text_t
+ *****************************************************************************
+ * Text of an ETM_id.
+ *****************************************************************************/
+typedef struct dvbpsi_atsc_etm_text_s
+{
+    uint32_t                i_etm_id;
+    uint16_t                i_pid;          /* of the ETT */
+    uint8_t                 i_version;      /* of the ETT */
+    uint32_t                i_length;
+
+    struct dvbpsi_atsc_etm_text_s *p_hash_next;
+
+    uint8_t                 p_data[];
+} dvbpsi_atsc_etm_text_t;
+
+/*****************************************************************************
+ * dvbpsi_atsc_etm_s
+ *****************************************************************************
+ * Texts hashed on their ETM_id, and versions of the ETT PIDs of the MGT.
+ *****************************************************************************/
+struct dvbpsi_atsc_etm_s
+{
+    dvbpsi_atsc_etm_text_t **pp_index;
+    unsigned int            i_index_bits;
+    unsigned int            i_texts;
+
+    bool                    b_mgt;          /* an MGT was given */
+    uint8_t                 i_mgt_version;
+    uint8_t                 i_versions[0x2000];
+};
+
+/***** dvbpsi_atsc_etm_bucket ***** Index bucket of an ETM_id *****/
+static inline unsigned int dvbpsi_atsc_etm_bucket(const dvbpsi_atsc_etm_t *p_etm,
+                                                  uint32_t i_etm_id)
+{
+    return (uint32_t)(i_etm_id * UINT32_C(2654435761)) >> (32 - p_etm->i_index_bits);
+}
+
+/***** dvbpsi_atsc_etm_grow ***** Doubles the index once it is full *****/
+static void dvbpsi_atsc_etm_grow(dvbpsi_atsc_etm_t *p_etm)
+{
+    unsigned int i_old_size = 1u << p_etm->i_index_bits;
+    if (p_etm->i_texts <= i_old_size || p_etm->i_index_bits >= 24)
+        return;
+
+    /* The index keeps working with longer chains if this fails */
+    dvbpsi_atsc_etm_text_t **pp_index = dvbpsi_calloc(2 * i_old_size,
+                                              sizeof(dvbpsi_atsc_etm_text_t *));
+    if (pp_index == NULL)
+        return;
+
+    dvbpsi_atsc_etm_text_t **pp_old = p_etm->pp_index;
+    p_etm->pp_index = pp_index;
+    p_etm->i_index_bits++;
+
+    for (unsigned int i = 0; i < i_old_size; i++)
+    {
+        dvbpsi_atsc_etm_text_t *p_text = pp_old[i];
+        while (p_text)
+        {
+            dvbpsi_atsc_etm_text_t *p_next = p_text->p_hash_next;
+            unsigned int i_bucket = dvbpsi_atsc_etm_bucket(p_etm, p_text->i_etm_id);
+            p_text->p_hash_next = pp_index[i_bucket];
+            pp_index[i_bucket] = p_text;
+            p_text = p_next;
+        }
+    }
+    dvbpsi_free(pp_old);
+}
+
+/*****************************************************************************
+ * dvbpsi_atsc_etm_new
+ *****************************************************************************/
+dvbpsi_atsc_etm_t *dvbpsi_atsc_etm_new(void)
+{
+    dvbpsi_atsc_etm_t *p_etm = (dvbpsi_atsc_etm_t *)dvbpsi_calloc(1, sizeof(dvbpsi_atsc_etm_t));
+    if (p_etm == NULL)
+        return NULL;
+
+    p_etm->i_index_bits = 6;
+    p_etm->pp_index = dvbpsi_calloc(1u << p_etm->i_index_bits,
+                                    sizeof(dvbpsi_atsc_etm_text_t *));
+    if (p_etm->pp_index == NULL)
+    {
+        dvbpsi_free(p_etm);
+        return NULL;
+    }
+    memset(p_etm->i_versions, DVBPSI_ATSC_ETM_NONE, sizeof(p_etm->i_versions));
+    return p_etm;
+}
+
+/*****************************************************************************
+ * dvbpsi_atsc_etm_delete
+ *****************************************************************************/
+void dvbpsi_atsc_etm_delete(dvbpsi_atsc_etm_t *p_etm)
+{
+    if (p_etm == NULL)
+        return;
+
+    for (unsigned int i = 0; i < 1u << p_etm->i_index_bits; i++)
+    {
+        dvbpsi_atsc_etm_text_t *p_text = p_etm->pp_index[i];
+        while (p_text)
+        {
+            dvbpsi_atsc_etm_text_t *p_next = p_text->p_hash_next;
+            dvbpsi_free(p_text);
+            p_text = p_next;
+        }
+    }
+    dvbpsi_free(p_etm->pp_index);
+    dvbpsi_free(p_etm);
+}
+
+/*****************************************************************************
+ * dvbpsi_atsc_etm_add
+ *****************************************************************************/
+bool dvbpsi_atsc_etm_add(dvbpsi_atsc_etm_t *p_etm, uint16_t i_pid,
+                         const dvbpsi_atsc_ett_t *p_ett)
+{
+    assert(p_etm);
+    assert(p_ett);
+
+    if (!p_ett->b_current_next)
+        return true;
+
+    dvbpsi_atsc_etm_text_t **pp_text =
+            &p_etm->pp_index[dvbpsi_atsc_etm_bucket(p_etm, p_ett->i_etm_id)];
+    while (*pp_text && (*pp_text)->i_etm_id != p_ett->i_etm_id)
+        pp_text = &(*pp_text)->p_hash_next;
+
+    dvbpsi_atsc_etm_text_t *p_old = *pp_text;
+    if (p_old && p_old->i_pid == (i_pid & 0x1fff) && p_old->i_version == p_ett->i_version
+     && p_old->i_length == p_ett->i_etm_length
+     && memcmp(p_old->p_data, p_ett->p_etm_data, p_ett->i_etm_length) == 0)
+        return true;
+
+    dvbpsi_atsc_etm_text_t *p_text =
+            (dvbpsi_atsc_etm_text_t *)dvbpsi_malloc(sizeof(dvbpsi_atsc_etm_text_t)
+                                                    + p_ett->i_etm_length);
+    if (p_text == NULL)
+        return false;
+
+    p_text->i_etm_id = p_ett->i_etm_id;
+    p_text->i_pid = i_pid & 0x1fff;
+    p_text->i_version = p_ett->i_version;
+    p_text->i_length = p_ett->i_etm_length;
+    if (p_ett->i_etm_length > 0)
+        memcpy(p_text->p_data, p_ett->p_etm_data, p_ett->i_etm_length);
+
+    if (p_old)
+    {
+        p_text->p_hash_next = p_old->p_hash_next;
+        *pp_text = p_text;
+        dvbpsi_free(p_old);
+        return true;
+    }
+
+    p_text->p_hash_next = NULL;
+    *pp_text = p_text;
+    p_etm->i_texts++;
+    dvbpsi_atsc_etm_grow(p_etm);
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_atsc_etm_update
+ *****************************************************************************/
+void dvbpsi_atsc_etm_update(dvbpsi_atsc_etm_t *p_etm, const dvbpsi_atsc_mgt_t *p_mgt)
+{
+    assert(p_etm);
+    assert(p_mgt);
+
+    if (!p_mgt->b_current_next
+     || (p_etm->b_mgt && p_etm->i_mgt_version == p_mgt->i_version))
+        return;
+    p_etm->b_mgt = true;
+    p_etm->i_mgt_version = p_mgt->i_version;
+
+    /* Channel ETT and event ETTs, A/65 table 6.3 */
+    memset(p_etm->i_versions, DVBPSI_ATSC_ETM_NONE, sizeof(p_etm->i_versions));
+    for (const dvbpsi_atsc_mgt_table_t *p_table = p_mgt->p_first_table;
+         p_table != NULL; p_table = p_table->p_next)
+    {
+        if (p_table->i_table_type == 0x0004
+         || (p_table->i_table_type >= 0x0200 && p_table->i_table_type <= 0x027f))
+            p_etm->i_versions[p_table->i_table_type_pid & 0x1fff] =
+                    p_table->i_table_type_version & 0x1f;
+    }
+
+    for (unsigned int i = 0; i < 1u << p_etm->i_index_bits; i++)
+    {
+        dvbpsi_atsc_etm_text_t **pp_text = &p_etm->pp_index[i];
+        while (*pp_text)
+        {
+            dvbpsi_atsc_etm_text_t *p_text = *pp_text;
+            if (p_etm->i_versions[p_text->i_pid] == p_text->i_version)
+            {
+                pp_text = &p_text->p_hash_next;
+                continue;
+            }
+            *pp_text = p_text->p_hash_next;
+            dvbpsi_free(p_text);
+            p_etm->i_texts--;
+        }
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_atsc_etm_find
+ *****************************************************************************/
+const uint8_t *dvbpsi_atsc_etm_find(dvbpsi_atsc_etm_t *p_etm, uint32_t i_etm_id,
+                                    uint32_t *pi_length)
+{
+    assert(p_etm);
+
+    const dvbpsi_atsc_etm_text_t *p_text =
+            p_etm->pp_index[dvbpsi_atsc_etm_bucket(p_etm, i_etm_id)];
+    while (p_text && p_text->i_etm_id != i_etm_id)
+        p_text = p_text->p_hash_next;
+    if (p_text == NULL)
+        return NULL;
+
+    if (pi_length)
+        *pi_length = p_text->i_length;
+    return p_text->p_data;
+}
+
+/*****************************************************************************
+ * dvbpsi_atsc_etm_find_event
+ *****************************************************************************/
+const uint8_t *dvbpsi_atsc_etm_find_event(dvbpsi_atsc_etm_t *p_etm,
+                                          const dvbpsi_atsc_eit_t *p_eit,
+                                          const dvbpsi_atsc_eit_event_t *p_event,
+                                          uint32_t *pi_length)
+{
+    assert(p_eit);
+    assert(p_event);
+
+    /* ETM_location 0: no ETM */
+    if (p_event->i_etm_location == 0)
+        return NULL;
+    return dvbpsi_atsc_etm_find(p_etm, DVBPSI_ATSC_ETM_ID_EVENT(p_eit->i_source_id,
+                                                                p_event->i_event_id),
+                                pi_length);
+}
+
+/*****************************************************************************
+ * dvbpsi_atsc_etm_find_channel
+ *****************************************************************************/
+const uint8_t *dvbpsi_atsc_etm_find_channel(dvbpsi_atsc_etm_t *p_etm,
+                                            const dvbpsi_atsc_vct_channel_t *p_channel,
+                                            uint32_t *pi_length)
+{
+    assert(p_channel);
+
+    if (p_channel->i_etm_location == 0)
+        return NULL;
+    return dvbpsi_atsc_etm_find(p_etm, DVBPSI_ATSC_ETM_ID_CHANNEL(p_channel->i_source_id),
+                                pi_length);
+}
@@ -0,0 +1,184 @@
+/*****************************************************************************
+ * atsc_etm.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file atsc_etm.h
+ * \brief Index of the ATSC Extended Text Messages by ETM_id.
+ *
+ * The ETTs carry the extended texts of the channels of the VCT and of the
+ * events of the EITs, each text being found by its ETM_id. The index keeps
+ * the texts of the ETTs given by the ETT decoders in a hash table on the
+ * ETM_id, and follows the versions the MGT gives to their PIDs to drop the
+ * texts of a previous version.
+ */
+
+#ifndef _ATSC_ETM_H
+#define _ATSC_ETM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \def DVBPSI_ATSC_ETM_ID_CHANNEL(source_id)
+ * \brief ETM_id of the text of a channel, A/65 table 6.14.
+ */
+#define DVBPSI_ATSC_ETM_ID_CHANNEL(source_id) \
+    ((uint32_t)(source_id) << 16)
+
+/*!
+ * \def DVBPSI_ATSC_ETM_ID_EVENT(source_id, event_id)
+ * \brief ETM_id of the text of an event, A/65 table 6.14.
+ */
+#define DVBPSI_ATSC_ETM_ID_EVENT(source_id, event_id) \
+    (((uint32_t)(source_id) << 16) | (((uint32_t)(event_id) & 0x3fff) << 2) | 0x2)
+
+/*****************************************************************************
+ * dvbpsi_atsc_etm_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_atsc_etm_s dvbpsi_atsc_etm_t
+ * \brief dvbpsi_atsc_etm_t type definition, an opaque ETM index.
+ */
+typedef struct dvbpsi_atsc_etm_s dvbpsi_atsc_etm_t;
+
+/*****************************************************************************
+ * dvbpsi_atsc_etm_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_atsc_etm_t *dvbpsi_atsc_etm_new(void)
+ * \brief Creates an empty ETM index
+ * \return pointer to the index, or NULL on error
+ */
+dvbpsi_atsc_etm_t *dvbpsi_atsc_etm_new(void);
+
+/*****************************************************************************
+ * dvbpsi_atsc_etm_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_atsc_etm_delete(dvbpsi_atsc_etm_t *p_etm)
+ * \brief Deletes an ETM index and all its texts
+ * \param p_etm pointer to the index
+ * \return nothing
+ */
+void dvbpsi_atsc_etm_delete(dvbpsi_atsc_etm_t *p_etm);
+
+/*****************************************************************************
+ * dvbpsi_atsc_etm_add
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_atsc_etm_add(dvbpsi_atsc_etm_t *p_etm, uint16_t i_pid,
+ *                              const dvbpsi_atsc_ett_t *p_ett)
+ * \brief Adds or replaces the text of an ETT
+ * \param p_etm pointer to the index
+ * \param i_pid PID the ETT was decoded on
+ * \param p_ett ETT given to the callback of dvbpsi_atsc_AttachETT(), whose
+ *        text is copied
+ * \return false on error, in which case the index keeps the previous text
+ *         of the ETM_id, true otherwise.
+ *
+ * An ETT that is not current is ignored. The cost is O(1), the same
+ * version of a text being only compared.
+ */
+bool dvbpsi_atsc_etm_add(dvbpsi_atsc_etm_t *p_etm, uint16_t i_pid,
+                         const dvbpsi_atsc_ett_t *p_ett);
+
+/*****************************************************************************
+ * dvbpsi_atsc_etm_update
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_atsc_etm_update(dvbpsi_atsc_etm_t *p_etm,
+ *                                 const dvbpsi_atsc_mgt_t *p_mgt)
+ * \brief Drops the texts the versions of an MGT make out of date
+ * \param p_etm pointer to the index
+ * \param p_mgt MGT given to the callback of dvbpsi_atsc_AttachMGT()
+ * \return nothing
+ *
+ * The texts of a PID that is no longer listed as a channel or event ETT,
+ * or whose ETT has another version than the one listed for its PID, are
+ * removed. The texts are kept until the first MGT is given.
+ */
+void dvbpsi_atsc_etm_update(dvbpsi_atsc_etm_t *p_etm, const dvbpsi_atsc_mgt_t *p_mgt);
+
+/*****************************************************************************
+ * dvbpsi_atsc_etm_find
+ *****************************************************************************/
+/*!
+ * \fn const uint8_t *dvbpsi_atsc_etm_find(dvbpsi_atsc_etm_t *p_etm,
+ *                                         uint32_t i_etm_id,
+ *                                         uint32_t *pi_length)
+ * \brief Finds the text of an ETM_id
+ * \param p_etm pointer to the index
+ * \param i_etm_id ETM_id
+ * \param pi_length filled with the length of the text
+ * \return the text, a multiple_string_structure valid until the next add or
+ *         update of the index, or NULL if there is none.
+ */
+const uint8_t *dvbpsi_atsc_etm_find(dvbpsi_atsc_etm_t *p_etm, uint32_t i_etm_id,
+                                    uint32_t *pi_length);
+
+/*****************************************************************************
+ * dvbpsi_atsc_etm_find_event
+ *****************************************************************************/
+/*!
+ * \fn const uint8_t *dvbpsi_atsc_etm_find_event(dvbpsi_atsc_etm_t *p_etm,
+ *                                         const dvbpsi_atsc_eit_t *p_eit,
+ *                                         const dvbpsi_atsc_eit_event_t *p_event,
+ *                                         uint32_t *pi_length)
+ * \brief Finds the text of an event
+ * \param p_etm pointer to the index
+ * \param p_eit EIT of the event
+ * \param p_event event
+ * \param pi_length filled with the length of the text
+ * \return the text as dvbpsi_atsc_etm_find(), or NULL if there is none or
+ *         the event has no ETM.
+ */
+const uint8_t *dvbpsi_atsc_etm_find_event(dvbpsi_atsc_etm_t *p_etm,
+                                          const dvbpsi_atsc_eit_t *p_eit,
+                                          const dvbpsi_atsc_eit_event_t *p_event,
+                                          uint32_t *pi_length);
+
+/*****************************************************************************
+ * dvbpsi_atsc_etm_find_channel
+ *****************************************************************************/
+/*!
+ * \fn const uint8_t *dvbpsi_atsc_etm_find_channel(dvbpsi_atsc_etm_t *p_etm,
+ *                                         const dvbpsi_atsc_vct_channel_t *p_channel,
+ *                                         uint32_t *pi_length)
+ * \brief Finds the text of a channel
+ * \param p_etm pointer to the index
+ * \param p_channel channel of a VCT
+ * \param pi_length filled with the length of the text
+ * \return the text as dvbpsi_atsc_etm_find(), or NULL if there is none or
+ *         the channel has no ETM.
+ */
+const uint8_t *dvbpsi_atsc_etm_find_channel(dvbpsi_atsc_etm_t *p_etm,
+                                            const dvbpsi_atsc_vct_channel_t *p_channel,
+                                            uint32_t *pi_length);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of atsc_etm.h"
+#endif
@@ -37,6 +37,7 @@ Decode PSIP Extended Text Table.
 #include <assert.h>
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_TABLE
 #include "../dvbpsi_private.h"
 #include "../psi.h"
 #include "../descriptor.h"
@@ -183,6 +184,7 @@ void dvbpsi_atsc_InitETT(dvbpsi_atsc_ett_t *p_ett, uint8_t i_table_id,
     p_ett->i_etm_length = 0;
     p_ett->p_etm_data = NULL;
     p_ett->p_first_descriptor = NULL;
+    p_ett->p_last_descriptor = NULL;
 }
 
 dvbpsi_atsc_ett_t *dvbpsi_atsc_NewETT(uint8_t i_table_id, uint16_t i_extension,
@@ -190,7 +192,7 @@ dvbpsi_atsc_ett_t *dvbpsi_atsc_NewETT(uint8_t i_table_id, uint16_t i_extension,
                                       uint32_t i_etm_id, bool b_current_next)
 {
     dvbpsi_atsc_ett_t *p_ett;
-    p_ett = (dvbpsi_atsc_ett_t*)malloc(sizeof(dvbpsi_atsc_ett_t));
+    p_ett = (dvbpsi_atsc_ett_t*)dvbpsi_malloc(sizeof(dvbpsi_atsc_ett_t));
     if (p_ett != NULL)
         dvbpsi_atsc_InitETT(p_ett, i_table_id, i_extension, i_version,
                             i_protocol, i_etm_id, b_current_next);
@@ -208,17 +210,18 @@ void dvbpsi_atsc_EmptyETT(dvbpsi_atsc_ett_t *p_ett)
 
     dvbpsi_DeleteDescriptors(p_ett->p_first_descriptor);
 
-    free(p_ett->p_etm_data);
+    dvbpsi_free(p_ett->p_etm_data);
     p_ett->i_etm_length = 0;
     p_ett->p_etm_data = NULL;
     p_ett->p_first_descriptor = NULL;
+    p_ett->p_last_descriptor = NULL;
 }
 
 void dvbpsi_atsc_DeleteETT(dvbpsi_atsc_ett_t *p_ett)
 {
     if (p_ett)
         dvbpsi_atsc_EmptyETT(p_ett);
-    free(p_ett);
+    dvbpsi_free(p_ett);
     p_ett = NULL;
 }
 
@@ -363,6 +366,8 @@ static void dvbpsi_atsc_GatherETTSections(dvbpsi_t* p_dvbpsi,
                                                p_section->b_current_next))
             {
                 /* Don't decode since this version is already decoded */
+                p_dvbpsi->stats.i_dropped_duplicate++;
+                dvbpsi_probe_dropped(p_section, "duplicate");
                 dvbpsi_debug(p_dvbpsi, "ATSC ETT decoder",
                              "ignoring already decoded section %d",
                              p_section->i_number);
@@ -384,6 +389,7 @@ static void dvbpsi_atsc_GatherETTSections(dvbpsi_t* p_dvbpsi,
     /* Check if we have all the sections */
     if (dvbpsi_decoder_psi_sections_completed(DVBPSI_DECODER(p_ett_decoder)))
     {
+        p_dvbpsi->stats.i_tables++;
         assert(p_ett_decoder->pf_ett_callback);
 
         /* Save the current information */
@@ -393,8 +399,10 @@ static void dvbpsi_atsc_GatherETTSections(dvbpsi_t* p_dvbpsi,
         dvbpsi_atsc_DecodeETTSections(p_ett_decoder->p_building_ett,
                                       p_ett_decoder->p_sections);
         /* signal the new ETT */
+        dvbpsi_probe_callback_entry("atsc_ett", p_section->i_table_id, p_section->i_extension);
         p_ett_decoder->pf_ett_callback(p_ett_decoder->p_cb_data,
                                        p_ett_decoder->p_building_ett);
+        dvbpsi_probe_callback_exit("atsc_ett", p_section->i_table_id, p_section->i_extension);
         /* Delete sections and Reinitialize the structures */
         dvbpsi_ReInitETT(p_ett_decoder, false);
         assert(p_ett_decoder->p_sections == NULL);
@@ -417,7 +425,7 @@ static void dvbpsi_atsc_DecodeETTSections(dvbpsi_atsc_ett_t* p_ett,
          * the PSI table is spread over multiple PSI sections */
         if (p_ett->p_etm_data)
             abort();
-        p_ett->p_etm_data = calloc(i_etm_length, sizeof(uint8_t));
+        p_ett->p_etm_data = dvbpsi_calloc(i_etm_length, sizeof(uint8_t));
         if (!p_ett->p_etm_data)
             continue;
         /* FIXME: Decode the separate strings. For now copy the data in the
@@ -73,6 +73,7 @@ typedef struct dvbpsi_atsc_ett_s
                                                  multiple string structure */
 
     dvbpsi_descriptor_t    *p_first_descriptor; /*!< First descriptor. */
+    dvbpsi_descriptor_t    *p_last_descriptor;  /*!< private, list tail */
 } dvbpsi_atsc_ett_t;
 
 /*****************************************************************************
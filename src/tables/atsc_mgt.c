@@ -37,6 +37,7 @@ Decode PSIP Master Guide Table.
 #include <assert.h>
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_TABLE
 #include "../dvbpsi_private.h"
 #include "../psi.h"
 #include "../descriptor.h"
@@ -179,14 +180,16 @@ void dvbpsi_atsc_InitMGT(dvbpsi_atsc_mgt_t* p_mgt, uint8_t i_table_id, uint16_t
     p_mgt->b_current_next = b_current_next;
     p_mgt->i_protocol = i_protocol;
     p_mgt->p_first_table = NULL;
+    p_mgt->p_last_table = NULL;
     p_mgt->p_first_descriptor = NULL;
+    p_mgt->p_last_descriptor = NULL;
 }
 
 dvbpsi_atsc_mgt_t *dvbpsi_atsc_NewMGT(uint8_t i_table_id, uint16_t i_extension,
                                       uint8_t i_version, uint8_t i_protocol, bool b_current_next)
 {
     dvbpsi_atsc_mgt_t* p_mgt;
-    p_mgt = (dvbpsi_atsc_mgt_t*)calloc(1, sizeof(dvbpsi_atsc_mgt_t));
+    p_mgt = (dvbpsi_atsc_mgt_t*)dvbpsi_calloc(1, sizeof(dvbpsi_atsc_mgt_t));
     if (p_mgt != NULL)
         dvbpsi_atsc_InitMGT(p_mgt, i_table_id, i_extension, i_version, i_protocol, b_current_next);
     return p_mgt;
@@ -205,19 +208,21 @@ void dvbpsi_atsc_EmptyMGT(dvbpsi_atsc_mgt_t* p_mgt)
   {
     dvbpsi_atsc_mgt_table_t* p_tmp = p_table->p_next;
     dvbpsi_DeleteDescriptors(p_table->p_first_descriptor);
-    free(p_table);
+    dvbpsi_free(p_table);
     p_table = p_tmp;
   }
   dvbpsi_DeleteDescriptors(p_mgt->p_first_descriptor);
   p_mgt->p_first_table = NULL;
+  p_mgt->p_last_table = NULL;
   p_mgt->p_first_descriptor = NULL;
+  p_mgt->p_last_descriptor = NULL;
 }
 
 void dvbpsi_atsc_DeleteMGT(dvbpsi_atsc_mgt_t *p_mgt)
 {
     if (p_mgt)
         dvbpsi_atsc_EmptyMGT(p_mgt);
-    free(p_mgt);
+    dvbpsi_free(p_mgt);
     p_mgt = NULL;
 }
 
@@ -236,11 +241,7 @@ static dvbpsi_descriptor_t *dvbpsi_atsc_MGTAddDescriptor(
     if (p_descriptor == NULL)
         return NULL;
 
-    p_mgt->p_first_descriptor = dvbpsi_AddDescriptor(p_mgt->p_first_descriptor,
-                                                     p_descriptor);
-    assert(p_mgt->p_first_descriptor);
-    if (p_mgt->p_first_descriptor == NULL)
-        return NULL;
+    dvbpsi_list_append(p_mgt->p_first_descriptor, p_mgt->p_last_descriptor, p_descriptor);
 
     return p_descriptor;
 }
@@ -257,7 +258,7 @@ static dvbpsi_atsc_mgt_table_t *dvbpsi_atsc_MGTAddTable(dvbpsi_atsc_mgt_t* p_mgt
 						 uint32_t i_number_bytes)
 {
   dvbpsi_atsc_mgt_table_t * p_table
-                = (dvbpsi_atsc_mgt_table_t*)malloc(sizeof(dvbpsi_atsc_mgt_table_t));
+                = (dvbpsi_atsc_mgt_table_t*)dvbpsi_malloc(sizeof(dvbpsi_atsc_mgt_table_t));
   if(p_table)
   {
     p_table->i_table_type = i_table_type;
@@ -266,19 +267,10 @@ static dvbpsi_atsc_mgt_table_t *dvbpsi_atsc_MGTAddTable(dvbpsi_atsc_mgt_t* p_mgt
     p_table->i_number_bytes = i_number_bytes;
 
     p_table->p_first_descriptor = NULL;
+    p_table->p_last_descriptor = NULL;
     p_table->p_next = NULL;
 
-    if(p_mgt->p_first_table== NULL)
-    {
-      p_mgt->p_first_table = p_table;
-    }
-    else
-    {
-      dvbpsi_atsc_mgt_table_t * p_last_table = p_mgt->p_first_table;
-      while(p_last_table->p_next != NULL)
-        p_last_table = p_last_table->p_next;
-      p_last_table->p_next = p_table;
-    }
+    dvbpsi_list_append(p_mgt->p_first_table, p_mgt->p_last_table, p_table);
   }
 
   return p_table;
@@ -298,17 +290,7 @@ static dvbpsi_descriptor_t *dvbpsi_atsc_MGTTableAddDescriptor(
                         = dvbpsi_NewDescriptor(i_tag, i_length, p_data);
   if(p_descriptor)
   {
-    if(p_table->p_first_descriptor == NULL)
-    {
-      p_table->p_first_descriptor = p_descriptor;
-    }
-    else
-    {
-      dvbpsi_descriptor_t * p_last_descriptor = p_table->p_first_descriptor;
-      while(p_last_descriptor->p_next != NULL)
-        p_last_descriptor = p_last_descriptor->p_next;
-      p_last_descriptor->p_next = p_descriptor;
-    }
+    dvbpsi_list_append(p_table->p_first_descriptor, p_table->p_last_descriptor, p_descriptor);
   }
 
   return p_descriptor;
@@ -448,6 +430,8 @@ static void dvbpsi_atsc_GatherMGTSections(dvbpsi_t * p_dvbpsi,
                                                p_section->b_current_next))
             {
                 /* Don't decode since this version is already decoded */
+                p_dvbpsi->stats.i_dropped_duplicate++;
+                dvbpsi_probe_dropped(p_section, "duplicate");
                 dvbpsi_debug(p_dvbpsi, "ATSC MGT decoder",
                              "ignoring already decoded section %d",
                              p_section->i_number);
@@ -462,7 +446,7 @@ static void dvbpsi_atsc_GatherMGTSections(dvbpsi_t * p_dvbpsi,
                 if ((!p_mgt_decoder->current_mgt.b_current_next) &&
                      (p_section->b_current_next))
                 {
-                    dvbpsi_atsc_mgt_t * p_mgt = (dvbpsi_atsc_mgt_t*)malloc(sizeof(dvbpsi_atsc_mgt_t));
+                    dvbpsi_atsc_mgt_t * p_mgt = (dvbpsi_atsc_mgt_t*)dvbpsi_malloc(sizeof(dvbpsi_atsc_mgt_t));
                     if (p_mgt)
                     {
                         p_mgt_decoder->current_mgt.b_current_next = true;
@@ -491,6 +475,7 @@ static void dvbpsi_atsc_GatherMGTSections(dvbpsi_t * p_dvbpsi,
     /* Check if we have all the sections */
     if (dvbpsi_decoder_psi_sections_completed(DVBPSI_DECODER(p_mgt_decoder)))
     {
+        p_dvbpsi->stats.i_tables++;
         assert(p_mgt_decoder->pf_mgt_callback);
 
         /* Save the current information */
@@ -500,8 +485,10 @@ static void dvbpsi_atsc_GatherMGTSections(dvbpsi_t * p_dvbpsi,
         dvbpsi_atsc_DecodeMGTSections(p_mgt_decoder->p_building_mgt,
                                       p_mgt_decoder->p_sections);
         /* signal the new MGT */
+        dvbpsi_probe_callback_entry("atsc_mgt", p_section->i_table_id, p_section->i_extension);
         p_mgt_decoder->pf_mgt_callback(p_mgt_decoder->p_cb_data,
                                        p_mgt_decoder->p_building_mgt);
+        dvbpsi_probe_callback_exit("atsc_mgt", p_section->i_table_id, p_section->i_extension);
         /* Delete sections and Reinitialize the structures */
         dvbpsi_ReInitMGT(p_mgt_decoder, false);
         assert(p_mgt_decoder->p_sections == NULL);
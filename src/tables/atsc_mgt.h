@@ -56,6 +56,7 @@ typedef struct dvbpsi_atsc_mgt_table_s
     uint32_t                    i_number_bytes;     /*!< bytes used for table */
 
     dvbpsi_descriptor_t        *p_first_descriptor; /*!< First descriptor. */
+    dvbpsi_descriptor_t        *p_last_descriptor;  /*!< private, list tail */
 
     struct dvbpsi_atsc_mgt_table_s *p_next;         /*!< next element of the list */
 } dvbpsi_atsc_mgt_table_t;
@@ -84,8 +85,10 @@ typedef struct dvbpsi_atsc_mgt_s
     uint8_t                 i_protocol;         /*!< PSIP Protocol version */
 
     dvbpsi_atsc_mgt_table_t   *p_first_table;   /*!< First table information structure. */
+    dvbpsi_atsc_mgt_table_t   *p_last_table;    /*!< private, list tail */
 
     dvbpsi_descriptor_t    *p_first_descriptor; /*!< First descriptor. */
+    dvbpsi_descriptor_t    *p_last_descriptor;  /*!< private, list tail */
 } dvbpsi_atsc_mgt_t;
 
 /*****************************************************************************
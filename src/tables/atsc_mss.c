@@ -0,0 +1,378 @@
+/*****************************************************************************
+ * atsc_mss.c: ATSC multiple_string_structure decoder
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+#include <limits.h>
+#include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_TABLE
+#include "../dvbpsi_private.h"
+
+#include "atsc_mss.h"
+
+/* Prior characters of an order-1 Huffman table, A/65 Annex C */
+#define DVBPSI_MSS_CONTEXTS 128
+
+/* Entries of the 8 bits lookup tables */
+#define DVBPSI_MSS_LEAF     0x8000  /* 0x0f00 bits, 0x007f character */
+#define DVBPSI_MSS_INVALID  0x4000  /* the code leaves the table */
+                                    /* otherwise node after 8 bits */
+
+/* Escape to an uncompressed character and end of string */
+#define DVBPSI_MSS_ESC      27
+#define DVBPSI_MSS_END      0
+
+/*****************************************************************************
+ * dvbpsi_atsc_huffman_s
+ *****************************************************************************
+ * Compiled Huffman decode table.
+ *****************************************************************************/
+struct dvbpsi_atsc_huffman_s
+{
+    uint16_t                i_roots[DVBPSI_MSS_CONTEXTS];
+                                            /* tree offsets, 0 if invalid */
+    uint16_t                i_lookup[DVBPSI_MSS_CONTEXTS][256];
+                                            /* 8 bits of code per step */
+    size_t                  i_size;
+    uint8_t                 p_table[];      /* for the longer codes */
+};
+
+/*****************************************************************************
+ * dvbpsi_mss_text_t
+ *****************************************************************************
+ * UTF-8 text being written into the buffer of the caller.
+ *****************************************************************************/
+typedef struct dvbpsi_mss_text_s
+{
+    char *                  psz_text;
+    size_t                  i_size;
+    size_t                  i_written;      /* in the buffer */
+    size_t                  i_length;       /* of the whole text */
+    bool                    b_full;         /* truncated */
+} dvbpsi_mss_text_t;
+
+/*****************************************************************************
+ * dvbpsi_atsc_huffman_new
+ *****************************************************************************/
+dvbpsi_atsc_huffman_t *dvbpsi_atsc_huffman_new(const uint8_t *p_table, size_t i_size)
+{
+    if (p_table == NULL || i_size < 2 * DVBPSI_MSS_CONTEXTS || i_size > UINT16_MAX)
+        return NULL;
+
+    dvbpsi_atsc_huffman_t *p_huffman =
+            (dvbpsi_atsc_huffman_t *)dvbpsi_malloc(sizeof(dvbpsi_atsc_huffman_t) + i_size);
+    if (p_huffman == NULL)
+        return NULL;
+
+    memcpy(p_huffman->p_table, p_table, i_size);
+    p_huffman->i_size = i_size;
+
+    bool b_valid = false;
+    for (int i_context = 0; i_context < DVBPSI_MSS_CONTEXTS; i_context++)
+    {
+        uint16_t i_root = ((uint16_t)p_table[2 * i_context] << 8)
+                        | p_table[2 * i_context + 1];
+        if (i_root < 2 * DVBPSI_MSS_CONTEXTS || (size_t)i_root + 2 > i_size)
+        {
+            /* No tree for this prior character */
+            p_huffman->i_roots[i_context] = 0;
+            continue;
+        }
+        p_huffman->i_roots[i_context] = i_root;
+        b_valid = true;
+
+        /* Walk the tree along every 8 bits of code */
+        for (int i_code = 0; i_code < 256; i_code++)
+        {
+            uint16_t i_entry = 0;   /* node 0 after 8 bits */
+            for (int i_bit = 0; i_bit < 8; i_bit++)
+            {
+                size_t i_offset = i_root + 2 * i_entry + ((i_code >> (7 - i_bit)) & 1);
+                if (i_offset >= i_size)
+                {
+                    i_entry = DVBPSI_MSS_INVALID;
+                    break;
+                }
+                if (p_table[i_offset] & 0x80)
+                {
+                    i_entry = DVBPSI_MSS_LEAF | ((i_bit + 1) << 8)
+                            | (p_table[i_offset] & 0x7f);
+                    break;
+                }
+                i_entry = p_table[i_offset];
+            }
+            p_huffman->i_lookup[i_context][i_code] = i_entry;
+        }
+    }
+
+    if (!b_valid)
+    {
+        dvbpsi_free(p_huffman);
+        return NULL;
+    }
+    return p_huffman;
+}
+
+/*****************************************************************************
+ * dvbpsi_atsc_huffman_delete
+ *****************************************************************************/
+void dvbpsi_atsc_huffman_delete(dvbpsi_atsc_huffman_t *p_huffman)
+{
+    dvbpsi_free(p_huffman);
+}
+
+/***** dvbpsi_mss_put ***** Appends a character in UTF-8 *****/
+static void dvbpsi_mss_put(dvbpsi_mss_text_t *p_text, uint32_t i_char)
+{
+    uint8_t p_utf8[4];
+    size_t i_bytes;
+
+    if (i_char == 0)
+        return;
+    if (i_char < 0x80)
+    {
+        p_utf8[0] = i_char;
+        i_bytes = 1;
+    }
+    else if (i_char < 0x800)
+    {
+        p_utf8[0] = 0xc0 | (i_char >> 6);
+        p_utf8[1] = 0x80 | (i_char & 0x3f);
+        i_bytes = 2;
+    }
+    else if (i_char < 0x10000)
+    {
+        p_utf8[0] = 0xe0 | (i_char >> 12);
+        p_utf8[1] = 0x80 | ((i_char >> 6) & 0x3f);
+        p_utf8[2] = 0x80 | (i_char & 0x3f);
+        i_bytes = 3;
+    }
+    else
+    {
+        p_utf8[0] = 0xf0 | (i_char >> 18);
+        p_utf8[1] = 0x80 | ((i_char >> 12) & 0x3f);
+        p_utf8[2] = 0x80 | ((i_char >> 6) & 0x3f);
+        p_utf8[3] = 0x80 | (i_char & 0x3f);
+        i_bytes = 4;
+    }
+
+    /* Never split a character, nor write past a truncation */
+    if (!p_text->b_full && p_text->i_written + i_bytes < p_text->i_size)
+    {
+        memcpy(p_text->psz_text + p_text->i_written, p_utf8, i_bytes);
+        p_text->i_written += i_bytes;
+    }
+    else
+        p_text->b_full = true;
+    p_text->i_length += i_bytes;
+}
+
+/***** dvbpsi_mss_bits ***** Reads 8 bits at a bit position *****/
+static inline unsigned int dvbpsi_mss_bits(const uint8_t *p_data, size_t i_pos)
+{
+    unsigned int i_word = (unsigned int)p_data[i_pos >> 3] << 8;
+    if ((i_pos & 7) != 0)
+        i_word |= p_data[(i_pos >> 3) + 1];
+    return (i_word >> (8 - (i_pos & 7))) & 0xff;
+}
+
+/***** dvbpsi_mss_huffman ***** Decodes a Huffman compressed segment *****/
+static void dvbpsi_mss_huffman(dvbpsi_mss_text_t *p_text,
+                               const dvbpsi_atsc_huffman_t *p_huffman,
+                               const uint8_t *p_data, size_t i_bytes)
+{
+    size_t i_bits = i_bytes * 8;
+    size_t i_pos = 0;
+    unsigned int i_context = 0;
+
+    while (i_pos < i_bits)
+    {
+        uint16_t i_root = p_huffman->i_roots[i_context];
+        if (i_root == 0)
+            return;
+
+        unsigned int i_node = 0;
+        int i_char = -1;
+        if (i_bits - i_pos >= 8)
+        {
+            uint16_t i_entry = p_huffman->i_lookup[i_context][dvbpsi_mss_bits(p_data, i_pos)];
+            if (i_entry & DVBPSI_MSS_INVALID)
+                return;
+            if (i_entry & DVBPSI_MSS_LEAF)
+            {
+                i_char = i_entry & 0x7f;
+                i_pos += (i_entry >> 8) & 0x0f;
+            }
+            else
+            {
+                i_node = i_entry;
+                i_pos += 8;
+            }
+        }
+
+        /* Codes longer than 8 bits and the last bits, bit by bit */
+        while (i_char < 0)
+        {
+            if (i_pos >= i_bits)
+                return;
+            size_t i_offset = i_root + 2 * i_node
+                            + ((p_data[i_pos >> 3] >> (7 - (i_pos & 7))) & 1);
+            i_pos++;
+            if (i_offset >= p_huffman->i_size)
+                return;
+            if (p_huffman->p_table[i_offset] & 0x80)
+                i_char = p_huffman->p_table[i_offset] & 0x7f;
+            else
+                i_node = p_huffman->p_table[i_offset];
+        }
+
+        if (i_char == DVBPSI_MSS_END)
+            return;
+        if (i_char == DVBPSI_MSS_ESC)
+        {
+            /* Uncompressed ISO 8859-1 character */
+            if (i_bits - i_pos < 8)
+                return;
+            i_char = dvbpsi_mss_bits(p_data, i_pos);
+            i_pos += 8;
+        }
+        dvbpsi_mss_put(p_text, i_char);
+        i_context = i_char & 0x7f;
+    }
+}
+
+/***** dvbpsi_mss_utf16 ***** Decodes a UTF-16 segment *****/
+static void dvbpsi_mss_utf16(dvbpsi_mss_text_t *p_text,
+                             const uint8_t *p_data, size_t i_bytes)
+{
+    for (size_t i = 0; i + 1 < i_bytes; i += 2)
+    {
+        uint32_t i_char = ((uint32_t)p_data[i] << 8) | p_data[i + 1];
+        if (i_char >= 0xd800 && i_char < 0xdc00 && i + 3 < i_bytes)
+        {
+            uint32_t i_low = ((uint32_t)p_data[i + 2] << 8) | p_data[i + 3];
+            if (i_low >= 0xdc00 && i_low < 0xe000)
+            {
+                i_char = 0x10000 + ((i_char - 0xd800) << 10) + (i_low - 0xdc00);
+                i += 2;
+            }
+        }
+        if (i_char >= 0xd800 && i_char < 0xe000)
+            i_char = 0xfffd;    /* unpaired surrogate */
+        dvbpsi_mss_put(p_text, i_char);
+    }
+}
+
+/***** dvbpsi_mss_mode ***** Checks a mode of uncompressed segment *****/
+static bool dvbpsi_mss_mode(uint8_t i_mode)
+{
+    /* Unicode pages of A/65 table 6.41, the others being reserved */
+    return i_mode <= 0x06
+        || (i_mode >= 0x09 && i_mode <= 0x10)
+        || (i_mode >= 0x20 && i_mode <= 0x27)
+        || (i_mode >= 0x30 && i_mode <= 0x33);
+}
+
+/*****************************************************************************
+ * dvbpsi_atsc_mss_decode
+ *****************************************************************************/
+int dvbpsi_atsc_mss_decode(const uint8_t *p_data, size_t i_size,
+                           const char *psz_language,
+                           const dvbpsi_atsc_huffman_t *p_title,
+                           const dvbpsi_atsc_huffman_t *p_description,
+                           char *psz_text, size_t i_text)
+{
+    dvbpsi_mss_text_t text = { psz_text, i_text, 0, 0, false };
+    const uint8_t *p_string = NULL;
+
+    if (i_text > 0)
+        psz_text[0] = '\0';
+    if (p_data == NULL || i_size < 1)
+        return -1;
+
+    /* Check the whole structure and find the string */
+    const uint8_t *p_end = p_data + i_size;
+    const uint8_t *p = p_data + 1;
+    for (int i_string = 0; i_string < p_data[0]; i_string++)
+    {
+        if (p_end - p < 4)
+            return -1;
+        if (p_string == NULL
+         || (psz_language != NULL && memcmp(p_string, psz_language, 3) != 0
+          && memcmp(p, psz_language, 3) == 0))
+            p_string = p;
+        int i_segments = p[3];
+        p += 4;
+        for (int i_segment = 0; i_segment < i_segments; i_segment++)
+        {
+            if (p_end - p < 3 || p_end - p - 3 < p[2])
+                return -1;
+            p += 3 + p[2];
+        }
+    }
+    if (p_string == NULL)
+        return 0;
+
+    /* Decode its segments */
+    int i_segments = p_string[3];
+    p = p_string + 4;
+    for (int i_segment = 0; i_segment < i_segments; i_segment++)
+    {
+        uint8_t i_compression = p[0];
+        uint8_t i_mode = p[1];
+        size_t i_bytes = p[2];
+        p += 3;
+
+        if (i_compression == 0x00 && i_mode == 0x3f)
+            dvbpsi_mss_utf16(&text, p, i_bytes);
+        else if (i_compression == 0x00 && dvbpsi_mss_mode(i_mode))
+        {
+            for (size_t i = 0; i < i_bytes; i++)
+                dvbpsi_mss_put(&text, ((uint32_t)i_mode << 8) | p[i]);
+        }
+        else if (i_compression == 0x01 && p_title != NULL)
+            dvbpsi_mss_huffman(&text, p_title, p, i_bytes);
+        else if (i_compression == 0x02 && p_description != NULL)
+            dvbpsi_mss_huffman(&text, p_description, p, i_bytes);
+        /* SCSU, reserved modes and compressions are skipped */
+
+        p += i_bytes;
+    }
+
+    if (i_text > 0)
+        psz_text[text.i_written] = '\0';
+    return text.i_length > INT_MAX ? INT_MAX : (int)text.i_length;
+}
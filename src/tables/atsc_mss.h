@@ -0,0 +1,127 @@
+/*****************************************************************************
+ * atsc_mss.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file atsc_mss.h
+ * \brief Decode ATSC multiple_string_structure (A/65 section 6.10) to UTF-8.
+ *
+ * The text of the VCT extended channel names, EIT titles and ETT messages
+ * is a multiple_string_structure, each string in one language being made
+ * of segments, uncompressed or compressed with the Huffman codes of A/65
+ * Annex C. The Huffman decode tables are compiled once into lookup tables
+ * decoding up to 8 bits at a time.
+ */
+
+#ifndef _ATSC_MSS_H
+#define _ATSC_MSS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_atsc_huffman_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_atsc_huffman_s dvbpsi_atsc_huffman_t
+ * \brief dvbpsi_atsc_huffman_t type definition, an opaque compiled Huffman
+ * decode table.
+ */
+typedef struct dvbpsi_atsc_huffman_s dvbpsi_atsc_huffman_t;
+
+/*****************************************************************************
+ * dvbpsi_atsc_huffman_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_atsc_huffman_t *dvbpsi_atsc_huffman_new(const uint8_t *p_table,
+ *                                                    size_t i_size)
+ * \brief Compiles a Huffman decode table of A/65 Annex C
+ * \param p_table the decode table as laid out in A/65 Annex C, table C5
+ *        for the titles (compression_type 0x01) or C7 for the program
+ *        descriptions (compression_type 0x02): the 128 16 bits byte offsets
+ *        of the trees of each prior character, then the trees, made of
+ *        pairs of bytes for the 0 and 1 branches of each node, a byte with
+ *        the high bit set being the leaf of the character in its 7 low
+ *        bits and a byte without it the index of the next node
+ * \param i_size size of the table
+ * \return pointer to the compiled table, or NULL if the table is
+ *         malformed or on error.
+ */
+dvbpsi_atsc_huffman_t *dvbpsi_atsc_huffman_new(const uint8_t *p_table, size_t i_size);
+
+/*****************************************************************************
+ * dvbpsi_atsc_huffman_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_atsc_huffman_delete(dvbpsi_atsc_huffman_t *p_huffman)
+ * \brief Deletes a compiled Huffman decode table
+ * \param p_huffman pointer to the table
+ * \return nothing
+ */
+void dvbpsi_atsc_huffman_delete(dvbpsi_atsc_huffman_t *p_huffman);
+
+/*****************************************************************************
+ * dvbpsi_atsc_mss_decode
+ *****************************************************************************/
+/*!
+ * \fn int dvbpsi_atsc_mss_decode(const uint8_t *p_data, size_t i_size,
+ *                                const char *psz_language,
+ *                                const dvbpsi_atsc_huffman_t *p_title,
+ *                                const dvbpsi_atsc_huffman_t *p_description,
+ *                                char *psz_text, size_t i_text)
+ * \brief Decodes a string of a multiple_string_structure to UTF-8
+ * \param p_data the multiple_string_structure, for instance
+ *        dvbpsi_atsc_ett_t::p_etm_data or the title of an EIT event
+ * \param i_size size of the structure
+ * \param psz_language ISO 639-2 code of the language of the string, the
+ *        first string being decoded if NULL or if there is no such string
+ * \param p_title compiled table C5 for compression_type 0x01, NULL if
+ *        these segments are to be skipped
+ * \param p_description compiled table C7 for compression_type 0x02, NULL if
+ *        these segments are to be skipped
+ * \param psz_text buffer receiving the text, always terminated by a NUL
+ *        byte when i_text is not 0
+ * \param i_text size of the buffer
+ * \return the length of the whole text in bytes, without the NUL byte, as
+ *         snprintf() does, the text being truncated at a character boundary
+ *         when it is larger than i_text - 1, or -1 if the structure is
+ *         truncated or malformed.
+ *
+ * The segments of the string are decoded one after the other in the
+ * buffer, with no allocation. Uncompressed segments are decoded in the
+ * Unicode page given by their mode, or as UTF-16 with mode 0x3F. Segments
+ * in SCSU (mode 0x3E), of an unknown mode or compression_type, or without
+ * their Huffman table are skipped.
+ */
+int dvbpsi_atsc_mss_decode(const uint8_t *p_data, size_t i_size,
+                           const char *psz_language,
+                           const dvbpsi_atsc_huffman_t *p_title,
+                           const dvbpsi_atsc_huffman_t *p_description,
+                           char *psz_text, size_t i_text);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of atsc_mss.h"
+#endif
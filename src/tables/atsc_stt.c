@@ -36,6 +36,7 @@ Decode PSIP System Time Table.
 #include <assert.h>
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_TABLE
 #include "../dvbpsi_private.h"
 #include "../psi.h"
 #include "../descriptor.h"
@@ -166,6 +167,7 @@ void dvbpsi_atsc_InitSTT(dvbpsi_atsc_stt_t *p_stt, uint8_t i_table_id,
     p_stt->b_current_next = b_current_next;
 
     p_stt->p_first_descriptor = NULL;
+    p_stt->p_last_descriptor = NULL;
 }
 
 /*****************************************************************************
@@ -177,7 +179,7 @@ dvbpsi_atsc_stt_t *dvbpsi_atsc_NewSTT(uint8_t i_table_id, uint16_t i_extension,
                                       uint8_t i_version, bool b_current_next)
 {
     dvbpsi_atsc_stt_t *p_stt;
-    p_stt = (dvbpsi_atsc_stt_t*)malloc(sizeof(dvbpsi_atsc_stt_t));
+    p_stt = (dvbpsi_atsc_stt_t*)dvbpsi_malloc(sizeof(dvbpsi_atsc_stt_t));
     if (p_stt != NULL)
         dvbpsi_atsc_InitSTT(p_stt, i_table_id, i_extension, i_version, b_current_next);
     return p_stt;
@@ -192,6 +194,7 @@ void dvbpsi_atsc_EmptySTT(dvbpsi_atsc_stt_t* p_stt)
 {
   dvbpsi_DeleteDescriptors(p_stt->p_first_descriptor);
   p_stt->p_first_descriptor = NULL;
+  p_stt->p_last_descriptor = NULL;
 }
 
 /*****************************************************************************
@@ -203,7 +206,7 @@ void dvbpsi_atsc_DeleteSTT(dvbpsi_atsc_stt_t *p_stt)
 {
     if (p_stt)
         dvbpsi_atsc_EmptySTT(p_stt);
-    free(p_stt);
+    dvbpsi_free(p_stt);
     p_stt = NULL;
 }
 
@@ -220,11 +223,7 @@ dvbpsi_descriptor_t *dvbpsi_atsc_STTAddDescriptor( dvbpsi_atsc_stt_t *p_stt,
     if (p_descriptor == NULL)
         return NULL;
 
-    p_stt->p_first_descriptor = dvbpsi_AddDescriptor(p_stt->p_first_descriptor,
-                                                     p_descriptor);
-    assert(p_stt->p_first_descriptor);
-    if (p_stt->p_first_descriptor == NULL)
-        return NULL;
+    dvbpsi_list_append(p_stt->p_first_descriptor, p_stt->p_last_descriptor, p_descriptor);
 
     return p_descriptor;
 }
@@ -353,6 +352,8 @@ static void dvbpsi_atsc_GatherSTTSections(dvbpsi_t *p_dvbpsi,
                                                p_section->b_current_next))
             {
                 /* Don't decode since this version is already decoded */
+                p_dvbpsi->stats.i_dropped_duplicate++;
+                dvbpsi_probe_dropped(p_section, "duplicate");
                 dvbpsi_debug(p_dvbpsi, "ATSC STT decoder",
                              "ignoring already decoded section %d",
                              p_section->i_number);
@@ -367,7 +368,7 @@ static void dvbpsi_atsc_GatherSTTSections(dvbpsi_t *p_dvbpsi,
                 if ((!p_stt_decoder->current_stt.b_current_next)
                     && (p_section->b_current_next))
                 {
-                    dvbpsi_atsc_stt_t * p_stt = (dvbpsi_atsc_stt_t*)malloc(sizeof(dvbpsi_atsc_stt_t));
+                    dvbpsi_atsc_stt_t * p_stt = (dvbpsi_atsc_stt_t*)dvbpsi_malloc(sizeof(dvbpsi_atsc_stt_t));
                     if (p_stt)
                     {
                         p_stt_decoder->current_stt.b_current_next = 1;
@@ -396,6 +397,7 @@ static void dvbpsi_atsc_GatherSTTSections(dvbpsi_t *p_dvbpsi,
     /* Check if we have all the sections */
     if (dvbpsi_decoder_psi_sections_completed(DVBPSI_DECODER(p_stt_decoder)))
     {
+        p_dvbpsi->stats.i_tables++;
         assert(p_stt_decoder->pf_stt_callback);
 
         /* Save the current information */
@@ -405,8 +407,10 @@ static void dvbpsi_atsc_GatherSTTSections(dvbpsi_t *p_dvbpsi,
         dvbpsi_atsc_DecodeSTTSections(p_stt_decoder->p_building_stt,
                                       p_stt_decoder->p_sections);
         /* signal the new STT */
+        dvbpsi_probe_callback_entry("atsc_stt", p_section->i_table_id, p_section->i_extension);
         p_stt_decoder->pf_stt_callback(p_stt_decoder->p_cb_data,
                                        p_stt_decoder->p_building_stt);
+        dvbpsi_probe_callback_exit("atsc_stt", p_section->i_table_id, p_section->i_extension);
         /* Delete sections and Reinitialize the structures */
         dvbpsi_ReInitSTT(p_stt_decoder, false);
         assert(p_stt_decoder->p_sections == NULL);
@@ -58,6 +58,7 @@ typedef struct dvbpsi_atsc_stt_s
     uint16_t                i_daylight_savings; /*!< Daylight savings control bytes. */
 
     dvbpsi_descriptor_t    *p_first_descriptor; /*!< First descriptor. */
+    dvbpsi_descriptor_t    *p_last_descriptor;  /*!< private, list tail */
 } dvbpsi_atsc_stt_t;
 
 /*****************************************************************************
@@ -36,12 +36,15 @@ Decode PSIP Virtual Channel Table.
 #include <assert.h>
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_TABLE
 #include "../dvbpsi_private.h"
 #include "../psi.h"
 #include "../descriptor.h"
 #include "../demux.h"
 #include "atsc_vct.h"
 
+typedef struct dvbpsi_atsc_vct_index_s dvbpsi_atsc_vct_index_t;
+
 typedef struct dvbpsi_atsc_vct_decoder_s
 {
     DVBPSI_DECODER_COMMON
@@ -179,7 +182,7 @@ void dvbpsi_atsc_DetachVCT(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_ex
 dvbpsi_atsc_vct_t *dvbpsi_atsc_NewVCT(uint8_t i_table_id, uint16_t i_extension,
         uint8_t i_protocol, bool b_cable_vct, uint8_t i_version, bool b_current_next)
 {
-    dvbpsi_atsc_vct_t *p_vct = (dvbpsi_atsc_vct_t*)malloc(sizeof(dvbpsi_atsc_vct_t));
+    dvbpsi_atsc_vct_t *p_vct = (dvbpsi_atsc_vct_t*)dvbpsi_malloc(sizeof(dvbpsi_atsc_vct_t));
     if (p_vct != NULL)
         dvbpsi_atsc_InitVCT(p_vct, i_table_id, i_extension,  i_protocol,
                             b_cable_vct, i_version, b_current_next);
@@ -204,7 +207,10 @@ void dvbpsi_atsc_InitVCT(dvbpsi_atsc_vct_t* p_vct, uint8_t i_table_id,
     p_vct->i_protocol = i_protocol;
     p_vct->b_cable_vct = b_cable_vct;
     p_vct->p_first_channel = NULL;
+    p_vct->p_last_channel = NULL;
     p_vct->p_first_descriptor = NULL;
+    p_vct->p_last_descriptor = NULL;
+    p_vct->p_index = NULL;
 }
 
 /*****************************************************************************
@@ -217,15 +223,20 @@ void dvbpsi_atsc_EmptyVCT(dvbpsi_atsc_vct_t* p_vct)
     dvbpsi_atsc_vct_channel_t* p_channel = p_vct->p_first_channel;
     dvbpsi_DeleteDescriptors(p_vct->p_first_descriptor);
     p_vct->p_first_descriptor = NULL;
+    p_vct->p_last_descriptor = NULL;
 
     while(p_channel != NULL)
     {
         dvbpsi_atsc_vct_channel_t* p_tmp = p_channel->p_next;
         dvbpsi_DeleteDescriptors(p_channel->p_first_descriptor);
-        free(p_channel);
+        dvbpsi_free(p_channel);
         p_channel = p_tmp;
     }
     p_vct->p_first_channel = NULL;
+    p_vct->p_last_channel = NULL;
+
+    dvbpsi_free(p_vct->p_index);
+    p_vct->p_index = NULL;
 }
 
 /*****************************************************************************
@@ -237,7 +248,143 @@ void dvbpsi_atsc_DeleteVCT(dvbpsi_atsc_vct_t *p_vct)
 {
     if (p_vct)
         dvbpsi_atsc_EmptyVCT(p_vct);
-    free(p_vct);
+    dvbpsi_free(p_vct);
+}
+
+/*****************************************************************************
+ * dvbpsi_atsc_vct_index_s
+ *****************************************************************************
+ * Hash tables of the channels of a VCT, open addressing over a power of two
+ * slots, a channel being before the channels of the same key added after.
+ *****************************************************************************/
+enum
+{
+    DVBPSI_VCT_KEY_NUMBER = 0,
+    DVBPSI_VCT_KEY_SOURCE,
+    DVBPSI_VCT_KEY_PROGRAM,
+    DVBPSI_VCT_KEYS
+};
+
+struct dvbpsi_atsc_vct_index_s
+{
+    size_t                      i_size;
+    dvbpsi_atsc_vct_channel_t **pp_slots[DVBPSI_VCT_KEYS];
+};
+
+static inline uint32_t dvbpsi_atsc_vct_key(const dvbpsi_atsc_vct_channel_t *p_channel,
+                                           unsigned int i_key)
+{
+    switch (i_key)
+    {
+        case DVBPSI_VCT_KEY_NUMBER:
+            return ((uint32_t)p_channel->i_major_number << 10) | p_channel->i_minor_number;
+        case DVBPSI_VCT_KEY_SOURCE:
+            return p_channel->i_source_id;
+        default:
+            return ((uint32_t)p_channel->i_channel_tsid << 16) | p_channel->i_program_number;
+    }
+}
+
+static inline size_t dvbpsi_atsc_vct_hash(uint32_t i_key, size_t i_size)
+{
+    return (i_key * UINT32_C(2654435761)) & (i_size - 1);
+}
+
+/*****************************************************************************
+ * dvbpsi_atsc_vct_index
+ *****************************************************************************
+ * Index the channels of a VCT.
+ *****************************************************************************/
+bool dvbpsi_atsc_vct_index(dvbpsi_atsc_vct_t *p_vct)
+{
+    assert(p_vct);
+
+    dvbpsi_free(p_vct->p_index);
+    p_vct->p_index = NULL;
+
+    size_t i_channels = 0;
+    for (dvbpsi_atsc_vct_channel_t *p = p_vct->p_first_channel; p; p = p->p_next)
+        i_channels++;
+
+    /* Half full at most */
+    size_t i_size = 16;
+    while (i_size < 2 * i_channels)
+        i_size *= 2;
+
+    size_t i_slots = DVBPSI_VCT_KEYS * i_size * sizeof(dvbpsi_atsc_vct_channel_t *);
+    dvbpsi_atsc_vct_index_t *p_index = dvbpsi_calloc(1, sizeof(dvbpsi_atsc_vct_index_t) + i_slots);
+    if (p_index == NULL)
+        return false;
+
+    p_index->i_size = i_size;
+    dvbpsi_atsc_vct_channel_t **pp_slots = (dvbpsi_atsc_vct_channel_t **)(p_index + 1);
+    for (unsigned int i_key = 0; i_key < DVBPSI_VCT_KEYS; i_key++)
+        p_index->pp_slots[i_key] = pp_slots + i_key * i_size;
+
+    for (dvbpsi_atsc_vct_channel_t *p = p_vct->p_first_channel; p; p = p->p_next)
+        for (unsigned int i_key = 0; i_key < DVBPSI_VCT_KEYS; i_key++)
+        {
+            dvbpsi_atsc_vct_channel_t **pp_table = p_index->pp_slots[i_key];
+            size_t j = dvbpsi_atsc_vct_hash(dvbpsi_atsc_vct_key(p, i_key), i_size);
+            while (pp_table[j])
+                j = (j + 1) & (i_size - 1);
+            pp_table[j] = p;
+        }
+
+    p_vct->p_index = p_index;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_atsc_vct_find
+ *****************************************************************************
+ * Find the first channel of a key, through the index if any.
+ *****************************************************************************/
+static dvbpsi_atsc_vct_channel_t *dvbpsi_atsc_vct_find(dvbpsi_atsc_vct_t *p_vct,
+                                                       unsigned int i_key, uint32_t i_value)
+{
+    assert(p_vct);
+
+    if (p_vct->p_index == NULL)
+    {
+        for (dvbpsi_atsc_vct_channel_t *p = p_vct->p_first_channel; p; p = p->p_next)
+            if (dvbpsi_atsc_vct_key(p, i_key) == i_value)
+                return p;
+        return NULL;
+    }
+
+    size_t i_size = p_vct->p_index->i_size;
+    dvbpsi_atsc_vct_channel_t **pp_table = p_vct->p_index->pp_slots[i_key];
+    for (size_t j = dvbpsi_atsc_vct_hash(i_value, i_size); pp_table[j];
+         j = (j + 1) & (i_size - 1))
+        if (dvbpsi_atsc_vct_key(pp_table[j], i_key) == i_value)
+            return pp_table[j];
+    return NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_atsc_vct_find_number/source/program
+ *****************************************************************************/
+dvbpsi_atsc_vct_channel_t *dvbpsi_atsc_vct_find_number(dvbpsi_atsc_vct_t *p_vct,
+                                                       uint16_t i_major_number,
+                                                       uint16_t i_minor_number)
+{
+    return dvbpsi_atsc_vct_find(p_vct, DVBPSI_VCT_KEY_NUMBER,
+                                ((uint32_t)i_major_number << 10) | i_minor_number);
+}
+
+dvbpsi_atsc_vct_channel_t *dvbpsi_atsc_vct_find_source(dvbpsi_atsc_vct_t *p_vct,
+                                                       uint16_t i_source_id)
+{
+    return dvbpsi_atsc_vct_find(p_vct, DVBPSI_VCT_KEY_SOURCE, i_source_id);
+}
+
+dvbpsi_atsc_vct_channel_t *dvbpsi_atsc_vct_find_program(dvbpsi_atsc_vct_t *p_vct,
+                                                        uint16_t i_channel_tsid,
+                                                        uint16_t i_program_number)
+{
+    return dvbpsi_atsc_vct_find(p_vct, DVBPSI_VCT_KEY_PROGRAM,
+                                ((uint32_t)i_channel_tsid << 16) | i_program_number);
 }
 
 /*****************************************************************************
@@ -254,11 +401,7 @@ static dvbpsi_descriptor_t *dvbpsi_atsc_VCTAddDescriptor(dvbpsi_atsc_vct_t *p_vc
     if (p_descriptor == NULL)
         return NULL;
 
-    p_vct->p_first_descriptor = dvbpsi_AddDescriptor(p_vct->p_first_descriptor,
-                                                     p_descriptor);
-    assert(p_vct->p_first_descriptor);
-    if (p_vct->p_first_descriptor == NULL)
-        return NULL;
+    dvbpsi_list_append(p_vct->p_first_descriptor, p_vct->p_last_descriptor, p_descriptor);
 
     return p_descriptor;
 }
@@ -286,7 +429,7 @@ static dvbpsi_atsc_vct_channel_t *dvbpsi_atsc_VCTAddChannel(dvbpsi_atsc_vct_t* p
                                             uint16_t i_source_id)
 {
     dvbpsi_atsc_vct_channel_t * p_channel
-            = (dvbpsi_atsc_vct_channel_t*)malloc(sizeof(dvbpsi_atsc_vct_channel_t));
+            = (dvbpsi_atsc_vct_channel_t*)dvbpsi_malloc(sizeof(dvbpsi_atsc_vct_channel_t));
     if(p_channel)
     {
         memcpy(p_channel->i_short_name, p_short_name, sizeof(uint16_t) * 7);
@@ -306,19 +449,10 @@ static dvbpsi_atsc_vct_channel_t *dvbpsi_atsc_VCTAddChannel(dvbpsi_atsc_vct_t* p
         p_channel->i_source_id = i_source_id;
 
         p_channel->p_first_descriptor = NULL;
+        p_channel->p_last_descriptor = NULL;
         p_channel->p_next = NULL;
 
-        if(p_vct->p_first_channel== NULL)
-        {
-            p_vct->p_first_channel = p_channel;
-        }
-        else
-        {
-            dvbpsi_atsc_vct_channel_t * p_last_channel = p_vct->p_first_channel;
-            while(p_last_channel->p_next != NULL)
-                p_last_channel = p_last_channel->p_next;
-            p_last_channel->p_next = p_channel;
-        }
+        dvbpsi_list_append(p_vct->p_first_channel, p_vct->p_last_channel, p_channel);
     }
 
     return p_channel;
@@ -338,17 +472,7 @@ static dvbpsi_descriptor_t *dvbpsi_atsc_VCTChannelAddDescriptor(
             = dvbpsi_NewDescriptor(i_tag, i_length, p_data);
     if(p_descriptor)
     {
-        if(p_channel->p_first_descriptor == NULL)
-        {
-            p_channel->p_first_descriptor = p_descriptor;
-        }
-        else
-        {
-            dvbpsi_descriptor_t * p_last_descriptor = p_channel->p_first_descriptor;
-            while(p_last_descriptor->p_next != NULL)
-                p_last_descriptor = p_last_descriptor->p_next;
-            p_last_descriptor->p_next = p_descriptor;
-        }
+        dvbpsi_list_append(p_channel->p_first_descriptor, p_channel->p_last_descriptor, p_descriptor);
     }
 
     return p_descriptor;
@@ -486,6 +610,8 @@ static void dvbpsi_atsc_GatherVCTSections(dvbpsi_t *p_dvbpsi,
                                                p_section->b_current_next))
             {
                 /* Don't decode since this version is already decoded */
+                p_dvbpsi->stats.i_dropped_duplicate++;
+                dvbpsi_probe_dropped(p_section, "duplicate");
                 dvbpsi_debug(p_dvbpsi, "ATSC VCT decoder",
                              "ignoring already decoded section %d",
                              p_section->i_number);
@@ -500,7 +626,7 @@ static void dvbpsi_atsc_GatherVCTSections(dvbpsi_t *p_dvbpsi,
                 if ((!p_vct_decoder->current_vct.b_current_next)
                     && (p_section->b_current_next))
                 {
-                    dvbpsi_atsc_vct_t * p_vct = (dvbpsi_atsc_vct_t*)malloc(sizeof(dvbpsi_atsc_vct_t));
+                    dvbpsi_atsc_vct_t * p_vct = (dvbpsi_atsc_vct_t*)dvbpsi_malloc(sizeof(dvbpsi_atsc_vct_t));
                     if (p_vct)
                     {
                         p_vct_decoder->current_vct.b_current_next = 1;
@@ -529,6 +655,7 @@ static void dvbpsi_atsc_GatherVCTSections(dvbpsi_t *p_dvbpsi,
     /* Check if we have all the sections */
     if (dvbpsi_decoder_psi_sections_completed(DVBPSI_DECODER(p_vct_decoder)))
     {
+        p_dvbpsi->stats.i_tables++;
         assert(p_vct_decoder->pf_vct_callback);
 
         /* Save the current information */
@@ -537,9 +664,13 @@ static void dvbpsi_atsc_GatherVCTSections(dvbpsi_t *p_dvbpsi,
         /* Decode the sections */
         dvbpsi_atsc_DecodeVCTSections(p_vct_decoder->p_building_vct,
                                       p_vct_decoder->p_sections);
+        if (p_dvbpsi->i_flags & DVBPSI_FLAG_TABLE_INDEX)
+            dvbpsi_atsc_vct_index(p_vct_decoder->p_building_vct);
         /* signal the new VCT */
+        dvbpsi_probe_callback_entry("atsc_vct", p_section->i_table_id, p_section->i_extension);
         p_vct_decoder->pf_vct_callback(p_vct_decoder->p_cb_data,
                                        p_vct_decoder->p_building_vct);
+        dvbpsi_probe_callback_exit("atsc_vct", p_section->i_table_id, p_section->i_extension);
         /* Delete sections and Reinitialize the structures */
         dvbpsi_ReInitVCT(p_vct_decoder, false);
         assert(p_vct_decoder->p_sections == NULL);
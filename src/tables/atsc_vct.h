@@ -69,6 +69,7 @@ typedef struct dvbpsi_atsc_vct_channel_s
     uint16_t  i_source_id;     /*!< Programming source associated with the channel.*/
 
     dvbpsi_descriptor_t *p_first_descriptor;  /*!< First descriptor. */
+    dvbpsi_descriptor_t *p_last_descriptor;   /*!< private, list tail */
 
     struct dvbpsi_atsc_vct_channel_s *p_next; /*!< next element of the list */
 } dvbpsi_atsc_vct_channel_t;
@@ -97,7 +98,10 @@ typedef struct dvbpsi_atsc_vct_s
     bool     b_cable_vct;        /*!< 1 if this is a cable VCT, 0 if it is a Terrestrial VCT. */
 
     dvbpsi_descriptor_t         *p_first_descriptor; /*!< First descriptor. */
+    dvbpsi_descriptor_t         *p_last_descriptor;  /*!< private, list tail */
     dvbpsi_atsc_vct_channel_t   *p_first_channel;    /*!< First channel information structure. */
+    dvbpsi_atsc_vct_channel_t   *p_last_channel;     /*!< private, list tail */
+    struct dvbpsi_atsc_vct_index_s *p_index;         /*!< private, see DVBPSI_FLAG_TABLE_INDEX */
 
 } dvbpsi_atsc_vct_t;
 
@@ -208,6 +212,85 @@ void dvbpsi_atsc_EmptyVCT(dvbpsi_atsc_vct_t *p_vct);
  */
 void dvbpsi_atsc_DeleteVCT(dvbpsi_atsc_vct_t *p_vct);
 
+/*****************************************************************************
+ * dvbpsi_atsc_vct_index
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_atsc_vct_index(dvbpsi_atsc_vct_t *p_vct)
+ * \brief Builds the index of the channels of a VCT
+ * \param p_vct pointer to the VCT structure
+ * \return false on error, in which case the lookups walk the channels, true
+ *         otherwise.
+ *
+ * The channels are hashed by major and minor channel number, by source_id
+ * and by channel_TSID and program_number. The decoder builds the index
+ * itself with DVBPSI_FLAG_TABLE_INDEX. It is dropped by
+ * dvbpsi_atsc_EmptyVCT().
+ */
+bool dvbpsi_atsc_vct_index(dvbpsi_atsc_vct_t *p_vct);
+
+/*****************************************************************************
+ * dvbpsi_atsc_vct_find_number
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_atsc_vct_channel_t *dvbpsi_atsc_vct_find_number(
+ *                   dvbpsi_atsc_vct_t *p_vct, uint16_t i_major_number,
+ *                   uint16_t i_minor_number)
+ * \brief Finds a channel of a VCT by its channel number
+ * \param p_vct pointer to the VCT structure
+ * \param i_major_number major_channel_number
+ * \param i_minor_number minor_channel_number
+ * \return the first channel of the VCT with this number, or NULL if there
+ *         is none.
+ *
+ * O(1) with an index, see dvbpsi_atsc_vct_index(), linear in the channels
+ * otherwise.
+ */
+dvbpsi_atsc_vct_channel_t *dvbpsi_atsc_vct_find_number(dvbpsi_atsc_vct_t *p_vct,
+                                                       uint16_t i_major_number,
+                                                       uint16_t i_minor_number);
+
+/*****************************************************************************
+ * dvbpsi_atsc_vct_find_source
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_atsc_vct_channel_t *dvbpsi_atsc_vct_find_source(
+ *                   dvbpsi_atsc_vct_t *p_vct, uint16_t i_source_id)
+ * \brief Finds a channel of a VCT by its source_id, as given by the EIT and
+ * ETT of the channel
+ * \param p_vct pointer to the VCT structure
+ * \param i_source_id source_id
+ * \return the first channel of the VCT with this source_id, or NULL if there
+ *         is none.
+ *
+ * O(1) with an index, see dvbpsi_atsc_vct_index(), linear in the channels
+ * otherwise.
+ */
+dvbpsi_atsc_vct_channel_t *dvbpsi_atsc_vct_find_source(dvbpsi_atsc_vct_t *p_vct,
+                                                       uint16_t i_source_id);
+
+/*****************************************************************************
+ * dvbpsi_atsc_vct_find_program
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_atsc_vct_channel_t *dvbpsi_atsc_vct_find_program(
+ *                   dvbpsi_atsc_vct_t *p_vct, uint16_t i_channel_tsid,
+ *                   uint16_t i_program_number)
+ * \brief Finds a channel of a VCT by the MPEG program carrying it
+ * \param p_vct pointer to the VCT structure
+ * \param i_channel_tsid channel_TSID of the transport stream of the program
+ * \param i_program_number program_number of the program, as in its PAT
+ *        and PMT
+ * \return the first channel of the VCT carried by this program, or NULL if
+ *         there is none.
+ *
+ * O(1) with an index, see dvbpsi_atsc_vct_index(), linear in the channels
+ * otherwise.
+ */
+dvbpsi_atsc_vct_channel_t *dvbpsi_atsc_vct_find_program(dvbpsi_atsc_vct_t *p_vct,
+                                                        uint16_t i_channel_tsid,
+                                                        uint16_t i_program_number);
+
 #ifdef __cplusplus
 };
 #endif
@@ -44,6 +44,11 @@ typedef struct dvbpsi_bat_decoder_s
     dvbpsi_bat_t                  current_bat;
     dvbpsi_bat_t *                p_building_bat;
 
+    /* Summary of the last BAT signalled, for the delta callback */
+    dvbpsi_bat_delta_callback     pf_delta_callback;
+    void *                        p_delta_cb_data;
+    dvbpsi_delta_summary_t        summary;
+
 } dvbpsi_bat_decoder_t;
 
 /*****************************************************************************
@@ -43,6 +43,7 @@
 #include <assert.h>
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_TABLE
 #include "../dvbpsi_private.h"
 #include "../psi.h"
 #include "../descriptor.h"
@@ -107,6 +108,7 @@ void dvbpsi_cat_init(dvbpsi_cat_t* p_cat, uint8_t i_version, bool b_current_next
     p_cat->i_version = i_version;
     p_cat->b_current_next = b_current_next;
     p_cat->p_first_descriptor = NULL;
+    p_cat->p_last_descriptor = NULL;
 }
 
 /*****************************************************************************
@@ -116,7 +118,7 @@ void dvbpsi_cat_init(dvbpsi_cat_t* p_cat, uint8_t i_version, bool b_current_next
  *****************************************************************************/
 dvbpsi_cat_t *dvbpsi_cat_new(uint8_t i_version, bool b_current_next)
 {
-    dvbpsi_cat_t *p_cat = (dvbpsi_cat_t*)malloc(sizeof(dvbpsi_cat_t));
+    dvbpsi_cat_t *p_cat = (dvbpsi_cat_t*)dvbpsi_malloc(sizeof(dvbpsi_cat_t));
     if (p_cat != NULL)
         dvbpsi_cat_init(p_cat, i_version, b_current_next);
     return p_cat;
@@ -131,6 +133,7 @@ void dvbpsi_cat_empty(dvbpsi_cat_t* p_cat)
 {
     dvbpsi_DeleteDescriptors(p_cat->p_first_descriptor);
     p_cat->p_first_descriptor = NULL;
+    p_cat->p_last_descriptor = NULL;
 }
 
 /*****************************************************************************
@@ -142,7 +145,7 @@ void dvbpsi_cat_delete(dvbpsi_cat_t *p_cat)
 {
     if (p_cat)
         dvbpsi_cat_empty(p_cat);
-    free(p_cat);
+    dvbpsi_free(p_cat);
 }
 
 /*****************************************************************************
@@ -159,11 +162,7 @@ dvbpsi_descriptor_t* dvbpsi_cat_descriptor_add(dvbpsi_cat_t* p_cat,
     if (p_descriptor == NULL)
         return NULL;
 
-    p_cat->p_first_descriptor = dvbpsi_AddDescriptor(p_cat->p_first_descriptor,
-                                                     p_descriptor);
-    assert(p_cat->p_first_descriptor);
-    if (p_cat->p_first_descriptor == NULL)
-        return NULL;
+    dvbpsi_list_append(p_cat->p_first_descriptor, p_cat->p_last_descriptor, p_descriptor);
 
     return p_descriptor;
 }
@@ -226,7 +225,7 @@ static bool dvbpsi_CheckCAT(dvbpsi_t *p_dvbpsi, dvbpsi_psi_section_t *p_section)
 }
 
 static bool dvbpsi_AddSectionCAT(dvbpsi_t *p_dvbpsi, dvbpsi_cat_decoder_t *p_decoder,
-                                 dvbpsi_psi_section_t* p_section)
+                                 dvbpsi_psi_section_t* p_section, bool *pb_complete)
 {
     assert(p_dvbpsi);
     assert(p_decoder);
@@ -243,11 +242,19 @@ static bool dvbpsi_AddSectionCAT(dvbpsi_t *p_dvbpsi, dvbpsi_cat_decoder_t *p_dec
         p_decoder->i_last_section_number = p_section->i_last_number;
     }
 
+    /* A table carried by this section alone is complete as it is */
+    if (dvbpsi_decoder_psi_section_single(DVBPSI_DECODER(p_decoder), p_section))
+    {
+        *pb_complete = true;
+        return true;
+    }
+
     /* Add to linked list of sections */
     if (dvbpsi_decoder_psi_section_add(DVBPSI_DECODER(p_decoder), p_section))
         dvbpsi_debug(p_dvbpsi, "CAT decoder", "overwrite section number %d",
                      p_section->i_number);
 
+    *pb_complete = dvbpsi_decoder_psi_sections_completed(DVBPSI_DECODER(p_decoder));
     return true;
 }
 
@@ -294,6 +301,8 @@ void dvbpsi_cat_sections_gather(dvbpsi_t *p_dvbpsi,
                                                    p_section->b_current_next))
              {
                  /* Don't decode since this version is already decoded */
+                 p_dvbpsi->stats.i_dropped_duplicate++;
+                 dvbpsi_probe_dropped(p_section, "duplicate");
                  dvbpsi_debug(p_dvbpsi, "CAT decoder",
                               "ignoring already decoded section %d",
                               p_section->i_number);
@@ -304,7 +313,8 @@ void dvbpsi_cat_sections_gather(dvbpsi_t *p_dvbpsi,
     }
 
     /* Add section to CAT */
-    if (!dvbpsi_AddSectionCAT(p_dvbpsi, p_cat_decoder, p_section))
+    bool b_complete = false;
+    if (!dvbpsi_AddSectionCAT(p_dvbpsi, p_cat_decoder, p_section, &b_complete))
     {
         dvbpsi_error(p_dvbpsi, "CAT decoder", "failed decoding section %d",
                      p_section->i_number);
@@ -313,8 +323,9 @@ void dvbpsi_cat_sections_gather(dvbpsi_t *p_dvbpsi,
     }
 
     /* Check if we have all the sections */
-    if (dvbpsi_decoder_psi_sections_completed(DVBPSI_DECODER(p_cat_decoder)))
+    if (b_complete)
     {
+        p_dvbpsi->stats.i_tables++;
         assert(p_cat_decoder->pf_cat_callback);
 
         /* Save the current information */
@@ -324,8 +335,10 @@ void dvbpsi_cat_sections_gather(dvbpsi_t *p_dvbpsi,
         dvbpsi_cat_sections_decode(p_cat_decoder->p_building_cat,
                                    p_cat_decoder->p_sections);
         /* signal the new CAT */
+        dvbpsi_probe_callback_entry("cat", p_section->i_table_id, p_section->i_extension);
         p_cat_decoder->pf_cat_callback(p_cat_decoder->p_cb_data,
                                        p_cat_decoder->p_building_cat);
+        dvbpsi_probe_callback_exit("cat", p_section->i_table_id, p_section->i_extension);
         /* Delete sections and Reinitialize the structures */
         dvbpsi_ReInitCAT(p_cat_decoder, false);
         assert(p_cat_decoder->p_sections == NULL);
@@ -364,7 +377,7 @@ void dvbpsi_cat_sections_decode(dvbpsi_cat_t* p_cat, dvbpsi_psi_section_t* p_sec
  *****************************************************************************/
 dvbpsi_psi_section_t* dvbpsi_cat_sections_generate(dvbpsi_t* p_dvbpsi, dvbpsi_cat_t* p_cat)
 {
-    dvbpsi_psi_section_t* p_result = dvbpsi_NewPSISection(1024);
+    dvbpsi_psi_section_t* p_result = dvbpsi_section_buffer_get(p_dvbpsi, 1024);
     dvbpsi_psi_section_t* p_current = p_result;
     dvbpsi_psi_section_t* p_prev;
     dvbpsi_descriptor_t* p_descriptor = p_cat->p_first_descriptor;
@@ -389,7 +402,7 @@ dvbpsi_psi_section_t* dvbpsi_cat_sections_generate(dvbpsi_t* p_dvbpsi, dvbpsi_ca
                                 + p_descriptor->i_length > 1018)
         {
             p_prev = p_current;
-            p_current = dvbpsi_NewPSISection(1024);
+            p_current = dvbpsi_section_buffer_get(p_dvbpsi, 1024);
             p_prev->p_next = p_current;
 
             p_current->i_table_id = 0x01;
@@ -427,3 +440,32 @@ dvbpsi_psi_section_t* dvbpsi_cat_sections_generate(dvbpsi_t* p_dvbpsi, dvbpsi_ca
     }
     return p_result;
 }
+
+/*****************************************************************************
+ * dvbpsi_cat_sections_generate_into
+ *****************************************************************************
+ * Generate CAT sections into a caller buffer.
+ *****************************************************************************/
+int dvbpsi_cat_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_cat_t *p_cat,
+                                      dvbpsi_section_buffer_t *p_buffer)
+{
+    dvbpsi_section_buffer_begin(p_dvbpsi, p_buffer);
+    return dvbpsi_section_buffer_end(p_dvbpsi,
+                dvbpsi_cat_sections_generate(p_dvbpsi, p_cat));
+}
+
+/*****************************************************************************
+ * dvbpsi_cat_section_iter
+ *****************************************************************************
+ * Sets up iterators over the raw loops of a CAT section.
+ *****************************************************************************/
+bool dvbpsi_cat_section_iter(dvbpsi_psi_section_t *p_section,
+                             dvbpsi_descriptor_iter_t *p_descriptors)
+{
+    assert(p_section);
+
+    uint8_t *p_byte = p_section->p_payload_start;
+    uint8_t *p_end = p_section->p_payload_end;
+    dvbpsi_descriptor_iter_init(p_descriptors, p_byte, p_end - p_byte);
+    return true;
+}
@@ -60,6 +60,7 @@ typedef struct dvbpsi_cat_s
   bool                      b_current_next;     /*!< current_next_indicator */
 
   dvbpsi_descriptor_t *     p_first_descriptor; /*!< descriptor list */
+  dvbpsi_descriptor_t *     p_last_descriptor;  /*!< private, list tail */
 
 } dvbpsi_cat_t;
 
@@ -179,6 +180,39 @@ dvbpsi_descriptor_t* dvbpsi_cat_descriptor_add(dvbpsi_cat_t* p_cat,
  */
 dvbpsi_psi_section_t* dvbpsi_cat_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_cat_t* p_cat);
 
+/*****************************************************************************
+ * dvbpsi_cat_sections_generate_into
+ *****************************************************************************/
+/*!
+ * \fn int dvbpsi_cat_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_cat_t *p_cat,
+ *                                          dvbpsi_section_buffer_t *p_buffer)
+ * \brief CAT generator writing into caller memory
+ * \param p_dvbpsi handle to dvbpsi with attached decoder
+ * \param p_cat pointer to the CAT structure
+ * \param p_buffer buffer the sections are written into, its previous
+ *        sections are overwritten
+ * \return the number of sections written, linked from p_buffer->p_sections,
+ *         or -1 on error or if the buffer is too small.
+ *
+ * Same encoding as dvbpsi_cat_sections_generate(), without any allocation.
+ */
+int dvbpsi_cat_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_cat_t *p_cat,
+                                      dvbpsi_section_buffer_t *p_buffer);
+
+/*****************************************************************************
+ * dvbpsi_cat_section_iter
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_cat_section_iter(dvbpsi_psi_section_t *p_section,
+ *                                  dvbpsi_descriptor_iter_t *p_descriptors)
+ * \brief Iterates over a CAT section without decoding it
+ * \param p_section CAT section
+ * \param p_descriptors set up for the descriptors
+ * \return true.
+ */
+bool dvbpsi_cat_section_iter(dvbpsi_psi_section_t *p_section,
+                             dvbpsi_descriptor_iter_t *p_descriptors);
+
 #ifdef __cplusplus
 };
 #endif
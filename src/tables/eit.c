@@ -42,10 +42,13 @@
 #include <assert.h>
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_TABLE
 #include "../dvbpsi_private.h"
 #include "../psi.h"
 #include "../descriptor.h"
 #include "../demux.h"
+#include "../mjd.h"
+#include "../descriptors/dr_4e.h"
 #include "eit.h"
 #include "eit_private.h"
 
@@ -132,6 +135,55 @@ void dvbpsi_eit_detach(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
     dvbpsi_DeleteDemuxSubDecoder(p_subdec);
 }
 
+/*****************************************************************************
+ * dvbpsi_eit_set_segment_callback
+ *****************************************************************************
+ * Set the function signalling each complete segment of an EIT decoder.
+ *****************************************************************************/
+bool dvbpsi_eit_set_segment_callback(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                                     uint16_t i_extension,
+                                     dvbpsi_eit_callback pf_callback, void* p_cb_data)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    dvbpsi_demux_t *p_demux = (dvbpsi_demux_t *) p_dvbpsi->p_decoder;
+    dvbpsi_demux_subdec_t* p_subdec = dvbpsi_demuxGetSubDec(p_demux, i_table_id, i_extension);
+    if (p_subdec == NULL)
+        return false;
+
+    dvbpsi_eit_decoder_t* p_eit_decoder = (dvbpsi_eit_decoder_t*)p_subdec->p_decoder;
+    p_eit_decoder->pf_segment_callback = pf_callback;
+    p_eit_decoder->p_segment_cb_data = p_cb_data;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_eit_restore
+ *****************************************************************************
+ * Resume an EIT decoder from a version decoded before.
+ *****************************************************************************/
+bool dvbpsi_eit_restore(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_extension,
+                        uint8_t i_version, uint32_t i_segments)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    dvbpsi_demux_t *p_demux = (dvbpsi_demux_t *) p_dvbpsi->p_decoder;
+    dvbpsi_demux_subdec_t* p_subdec = dvbpsi_demuxGetSubDec(p_demux, i_table_id, i_extension);
+    if (p_subdec == NULL || i_version > 31)
+        return false;
+
+    dvbpsi_eit_decoder_t* p_eit_decoder = (dvbpsi_eit_decoder_t*)p_subdec->p_decoder;
+    if (p_eit_decoder->b_current_valid || p_eit_decoder->p_building_eit)
+        return false;
+
+    p_eit_decoder->b_restored = true;
+    p_eit_decoder->i_restored_version = i_version;
+    p_eit_decoder->i_restored_segments = i_segments;
+    return true;
+}
+
 /*****************************************************************************
  * dvbpsi_eit_init
  *****************************************************************************
@@ -152,6 +204,10 @@ void dvbpsi_eit_init(dvbpsi_eit_t* p_eit, uint8_t i_table_id, uint16_t i_extensi
     p_eit->i_segment_last_section_number = i_segment_last_section_number;
     p_eit->i_last_table_id = i_last_table_id;
     p_eit->p_first_event = NULL;
+    p_eit->p_last_event = NULL;
+    memset(p_eit->p_tags, 0, sizeof(p_eit->p_tags));
+    p_eit->p_arena = NULL;
+    p_eit->p_sections = NULL;
 }
 
 /*****************************************************************************
@@ -164,7 +220,7 @@ dvbpsi_eit_t* dvbpsi_eit_new(uint8_t i_table_id, uint16_t i_extension,
                              uint16_t i_network_id, uint8_t i_segment_last_section_number,
                              uint8_t i_last_table_id)
 {
-    dvbpsi_eit_t *p_eit = (dvbpsi_eit_t*)malloc(sizeof(dvbpsi_eit_t));
+    dvbpsi_eit_t *p_eit = (dvbpsi_eit_t*)dvbpsi_malloc(sizeof(dvbpsi_eit_t));
     if (p_eit != NULL)
         dvbpsi_eit_init(p_eit, i_table_id, i_extension, i_version,
                         b_current_next, i_ts_id, i_network_id, i_segment_last_section_number,
@@ -179,16 +235,24 @@ dvbpsi_eit_t* dvbpsi_eit_new(uint8_t i_table_id, uint16_t i_extension,
  *****************************************************************************/
 void dvbpsi_eit_empty(dvbpsi_eit_t* p_eit)
 {
+    dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(p_eit->p_arena);
     dvbpsi_eit_event_t* p_event = p_eit->p_first_event;
 
     while(p_event != NULL)
     {
         dvbpsi_eit_event_t* p_tmp = p_event->p_next;
         dvbpsi_DeleteDescriptors(p_event->p_first_descriptor);
-        free(p_event);
+        dvbpsi_free(p_event);
         p_event = p_tmp;
     }
     p_eit->p_first_event = NULL;
+    p_eit->p_last_event = NULL;
+    memset(p_eit->p_tags, 0, sizeof(p_eit->p_tags));
+
+    dvbpsi_arena_leave(p_previous);
+
+    dvbpsi_DeletePSISections(p_eit->p_sections);
+    p_eit->p_sections = NULL;
 }
 
 /*****************************************************************************
@@ -198,9 +262,217 @@ void dvbpsi_eit_empty(dvbpsi_eit_t* p_eit)
  *****************************************************************************/
 void dvbpsi_eit_delete(dvbpsi_eit_t* p_eit)
 {
-    if (p_eit)
-        dvbpsi_eit_empty(p_eit);
-    free(p_eit);
+    if (p_eit == NULL)
+        return;
+
+    dvbpsi_arena_t *p_arena = p_eit->p_arena;
+    dvbpsi_eit_empty(p_eit);
+    if (p_arena)
+        dvbpsi_arena_delete(p_arena);
+    else
+        dvbpsi_free(p_eit);
+}
+
+/*****************************************************************************
+ * dvbpsi_eit_decode
+ *****************************************************************************
+ * Decode the raw sections of a EIT delivered with DVBPSI_FLAG_LAZY_DECODE.
+ *****************************************************************************/
+void dvbpsi_eit_decode(dvbpsi_eit_t* p_eit)
+{
+    assert(p_eit);
+
+    if (p_eit->p_sections == NULL)
+        return;
+
+    dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(p_eit->p_arena);
+    dvbpsi_eit_sections_decode(p_eit, p_eit->p_sections);
+    dvbpsi_arena_leave(p_previous);
+
+    dvbpsi_DeletePSISections(p_eit->p_sections);
+    p_eit->p_sections = NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_eit_event_times
+ *****************************************************************************
+ * Convert the start times and durations of the events of an EIT.
+ *****************************************************************************/
+size_t dvbpsi_eit_event_times(dvbpsi_eit_t* p_eit, int64_t *pi_starts,
+                              uint32_t *pi_durations, size_t i_max)
+{
+    assert(p_eit);
+
+    dvbpsi_eit_decode(p_eit);
+
+    size_t i_events = 0;
+    for (const dvbpsi_eit_event_t *p_event = p_eit->p_first_event; p_event;
+         p_event = p_event->p_next, i_events++)
+    {
+        if (i_events >= i_max)
+            continue;
+        if (pi_starts)
+            pi_starts[i_events] = dvbpsi_mjd_to_utc(p_event->i_start_time);
+        if (pi_durations)
+            pi_durations[i_events] = dvbpsi_bcd_to_seconds(p_event->i_duration);
+    }
+    return i_events;
+}
+
+/***** dvbpsi_eit_text_table ***** Length of the table selection of a text *****/
+static size_t dvbpsi_eit_text_table(const uint8_t *p_text, size_t i_length)
+{
+    if (i_length == 0 || p_text[0] >= 0x20)
+        return 0;
+    size_t i_table = p_text[0] == 0x10 ? 3 : (p_text[0] == 0x1f ? 2 : 1);
+    return i_table <= i_length ? i_table : i_length;
+}
+
+/***** dvbpsi_eit_extended_join ***** Appends bytes to the buffer *****/
+static void dvbpsi_eit_extended_join(dvbpsi_eit_extended_t *p_extended,
+                                     uint8_t *p_buffer, size_t i_size,
+                                     const uint8_t *p_data, size_t i_length)
+{
+    if (p_extended->i_buffer + i_length <= i_size)
+        memcpy(p_buffer + p_extended->i_buffer, p_data, i_length);
+    p_extended->i_buffer += i_length;
+}
+
+/*****************************************************************************
+ * dvbpsi_eit_event_extended
+ *****************************************************************************
+ * Reassemble the extended event descriptors of an event in one language.
+ *****************************************************************************/
+bool dvbpsi_eit_event_extended(const dvbpsi_eit_event_t *p_event,
+                               const uint8_t *p_language,
+                               dvbpsi_eit_extended_t *p_extended,
+                               dvbpsi_eit_extended_item_t *p_items, size_t i_max_items,
+                               uint8_t *p_buffer, size_t i_size)
+{
+    assert(p_event);
+    assert(p_extended);
+
+    memset(p_extended, 0, sizeof(dvbpsi_eit_extended_t));
+
+    /* The descriptors of the language by descriptor_number */
+    dvbpsi_extended_event_compact_t parts[16];
+    uint16_t i_present = 0;
+    uint8_t i_last = 0;
+    for (dvbpsi_descriptor_t *p_descriptor = p_event->p_first_descriptor;
+         p_descriptor; p_descriptor = p_descriptor->p_next)
+    {
+        dvbpsi_extended_event_compact_t compact;
+        if (p_descriptor->i_tag != 0x4e
+         || !dvbpsi_DecodeExtendedEventDrCompact(p_descriptor, &compact))
+            continue;
+        if (p_language == NULL && i_present == 0)
+        {
+            memcpy(p_extended->i_iso_639_code, compact.i_iso_639_code, 3);
+            p_language = p_extended->i_iso_639_code;
+        }
+        if (memcmp(compact.i_iso_639_code, p_language, 3) != 0
+         || (i_present & (1 << compact.i_descriptor_number)))
+            continue;
+        if (i_present == 0)
+            i_last = compact.i_last_descriptor_number;
+        parts[compact.i_descriptor_number] = compact;
+        i_present |= 1 << compact.i_descriptor_number;
+    }
+    if (i_present == 0)
+        return false;
+
+    memcpy(p_extended->i_iso_639_code, p_language, 3);
+    p_extended->b_complete = (i_present & ((2u << i_last) - 1)) == (2u << i_last) - 1;
+
+    /* Items, an empty description at the start of a descriptor continuing
+       the previous item */
+    dvbpsi_eit_extended_item_t last = { NULL, 0, NULL, 0 };
+    size_t i_joined = SIZE_MAX;     /* offset of the last item in the buffer */
+    for (int i = 0; i < 16; i++)
+    {
+        if (!(i_present & (1 << i)))
+            continue;
+        p_extended->i_descriptors++;
+
+        int i_offset = 0;
+        const uint8_t *p_description, *p_item;
+        uint8_t i_description_length, i_item_length;
+        while (dvbpsi_NextExtendedEventItem(&parts[i], &i_offset,
+                                            &p_description, &i_description_length,
+                                            &p_item, &i_item_length))
+        {
+            if (i_offset == 2 + i_description_length + i_item_length
+             && i_description_length == 0 && p_extended->i_items > 0)
+            {
+                if (i_joined == SIZE_MAX)
+                {
+                    i_joined = p_extended->i_buffer;
+                    dvbpsi_eit_extended_join(p_extended, p_buffer, i_size,
+                                             last.p_item, last.i_item_length);
+                }
+                dvbpsi_eit_extended_join(p_extended, p_buffer, i_size,
+                                         p_item, i_item_length);
+                last.p_item = p_buffer ? p_buffer + i_joined : NULL;
+                last.i_item_length += i_item_length;
+            }
+            else
+            {
+                last.p_description = p_description;
+                last.i_description_length = i_description_length;
+                last.p_item = p_item;
+                last.i_item_length = i_item_length;
+                i_joined = SIZE_MAX;
+                p_extended->i_items++;
+            }
+            if (p_items && p_extended->i_items <= i_max_items)
+                p_items[p_extended->i_items - 1] = last;
+        }
+    }
+
+    /* Text, in the character table of the first part */
+    const uint8_t *p_table = NULL;
+    size_t i_table = 0;
+    unsigned int i_texts = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        if (!(i_present & (1 << i)) || parts[i].i_text_length == 0)
+            continue;
+
+        const uint8_t *p_text = parts[i].p_text;
+        size_t i_length = parts[i].i_text_length;
+        size_t i_skip = dvbpsi_eit_text_table(p_text, i_length);
+        if (p_table == NULL)
+        {
+            p_table = p_text;
+            i_table = i_skip;
+        }
+        else if (i_skip == i_table && memcmp(p_text, p_table, i_skip) == 0)
+        {
+            p_text += i_skip;
+            i_length -= i_skip;
+        }
+
+        if (i_texts == 0)
+        {
+            p_extended->p_text = p_text;
+            p_extended->i_text_length = i_length;
+        }
+        else
+        {
+            if (i_texts == 1)
+            {
+                const uint8_t *p_first = p_extended->p_text;
+                p_extended->p_text = p_buffer ? p_buffer + p_extended->i_buffer : NULL;
+                dvbpsi_eit_extended_join(p_extended, p_buffer, i_size,
+                                         p_first, p_extended->i_text_length);
+            }
+            dvbpsi_eit_extended_join(p_extended, p_buffer, i_size, p_text, i_length);
+            p_extended->i_text_length += i_length;
+        }
+        i_texts++;
+    }
+
+    return p_extended->i_buffer <= i_size;
 }
 
 /*****************************************************************************
@@ -213,7 +485,7 @@ dvbpsi_eit_event_t* dvbpsi_eit_event_add(dvbpsi_eit_t* p_eit,
     uint8_t i_running_status, bool b_free_ca, uint16_t i_event_descriptor_length)
 {
     dvbpsi_eit_event_t* p_event;
-    p_event = (dvbpsi_eit_event_t*)calloc(1,sizeof(dvbpsi_eit_event_t));
+    p_event = (dvbpsi_eit_event_t*)dvbpsi_calloc(1,sizeof(dvbpsi_eit_event_t));
     if (p_event == NULL)
         return NULL;
 
@@ -227,16 +499,9 @@ dvbpsi_eit_event_t* dvbpsi_eit_event_add(dvbpsi_eit_t* p_eit,
     p_event->p_next = NULL;
     p_event->i_descriptors_length = i_event_descriptor_length;
     p_event->p_first_descriptor = NULL;
+    p_event->p_last_descriptor = NULL;
 
-    if (p_eit->p_first_event == NULL)
-        p_eit->p_first_event = p_event;
-    else
-    {
-        dvbpsi_eit_event_t* p_last_event = p_eit->p_first_event;
-        while(p_last_event->p_next != NULL)
-            p_last_event = p_last_event->p_next;
-        p_last_event->p_next = p_event;
-    }
+    dvbpsi_list_append(p_eit->p_first_event, p_eit->p_last_event, p_event);
     return p_event;
 }
 
@@ -266,11 +531,8 @@ dvbpsi_descriptor_t* dvbpsi_eit_event_descriptor_add(dvbpsi_eit_event_t* p_event
     if (p_descriptor == NULL)
         return NULL;
 
-    p_event->p_first_descriptor = dvbpsi_AddDescriptor(p_event->p_first_descriptor,
-                                                       p_descriptor);
-    assert(p_event->p_first_descriptor);
-    if (p_event->p_first_descriptor == NULL)
-        return NULL;
+    dvbpsi_list_append(p_event->p_first_descriptor, p_event->p_last_descriptor, p_descriptor);
+    dvbpsi_tags_add(p_event->p_tags, i_tag);
 
     return p_descriptor;
 }
@@ -289,6 +551,11 @@ static void dvbpsi_ReInitEIT(dvbpsi_eit_decoder_t* p_decoder, const bool b_force
             dvbpsi_eit_delete(p_decoder->p_building_eit);
     }
     p_decoder->p_building_eit = NULL;
+
+    /* Segments of the next table */
+    memset(p_decoder->pi_segment_received, 0, sizeof(p_decoder->pi_segment_received));
+    memset(p_decoder->pi_segment_expected, 0, sizeof(p_decoder->pi_segment_expected));
+    p_decoder->i_segments_signalled = 0;
 }
 
 static bool dvbpsi_CheckEIT(dvbpsi_t *p_dvbpsi, dvbpsi_eit_decoder_t *p_eit_decoder,
@@ -332,6 +599,18 @@ static bool dvbpsi_IsCompleteEIT(dvbpsi_eit_decoder_t* p_eit_decoder, dvbpsi_psi
 
     bool b_complete = false;
 
+    /* All the segments up to last_section_number have been received */
+    unsigned int i_segment = 0;
+    for (; i_segment <= p_eit_decoder->i_last_section_number / 8u; i_segment++)
+    {
+        uint8_t i_expected = p_eit_decoder->pi_segment_expected[i_segment];
+        if (   i_expected == 0
+            || (p_eit_decoder->pi_segment_received[i_segment] & i_expected) != i_expected)
+            break;
+    }
+    if (i_segment > p_eit_decoder->i_last_section_number / 8u)
+        return true;
+
     /* As there may be gaps in the section_number fields (see below), we
      * have to wait until we have received a section_number twice or
      * until we have a received a section_number which is
@@ -378,6 +657,87 @@ static bool dvbpsi_IsCompleteEIT(dvbpsi_eit_decoder_t* p_eit_decoder, dvbpsi_psi
     return b_complete;
 }
 
+/*****************************************************************************
+ * dvbpsi_eit_segment_signal
+ *****************************************************************************
+ * Decodes the complete segment of the sections of the building table
+ * starting at p_first and gives it to the segment callback.
+ *****************************************************************************/
+static void dvbpsi_eit_segment_signal(dvbpsi_t *p_dvbpsi, dvbpsi_eit_decoder_t *p_eit_decoder,
+                                      dvbpsi_psi_section_t *p_first)
+{
+    dvbpsi_psi_section_t *p_last = p_first;
+    while (p_last->p_next && p_last->p_next->i_number / 8 == p_first->i_number / 8)
+        p_last = p_last->p_next;
+
+    dvbpsi_arena_t *p_arena = dvbpsi_arena_table_new(p_dvbpsi);
+    dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(p_arena);
+    dvbpsi_eit_t *p_segment = dvbpsi_eit_new(p_first->i_table_id, p_first->i_extension,
+                                p_first->i_version, p_first->b_current_next,
+                                ((uint16_t)(p_first->p_payload_start[0]) << 8)
+                                    | p_first->p_payload_start[1],
+                                ((uint16_t)(p_first->p_payload_start[2]) << 8)
+                                    | p_first->p_payload_start[3],
+                                p_first->p_payload_start[4],
+                                p_first->p_payload_start[5]);
+    if (p_segment)
+    {
+        /* Decode the sections of the segment only */
+        dvbpsi_psi_section_t *p_next = p_last->p_next;
+        p_last->p_next = NULL;
+        dvbpsi_eit_sections_decode(p_segment, p_first);
+        p_last->p_next = p_next;
+    }
+    dvbpsi_arena_leave(p_previous);
+
+    if (p_segment == NULL)
+    {
+        dvbpsi_arena_delete(p_arena);
+        dvbpsi_error(p_dvbpsi, "EIT decoder", "failed decoding segment %d",
+                     p_first->i_number / 8);
+        return;
+    }
+    p_segment->p_arena = p_arena;
+
+    dvbpsi_probe_callback_entry("eit_segment", p_first->i_table_id, p_first->i_extension);
+    p_eit_decoder->pf_segment_callback(p_eit_decoder->p_segment_cb_data, p_segment);
+    dvbpsi_probe_callback_exit("eit_segment", p_first->i_table_id, p_first->i_extension);
+}
+
+/*****************************************************************************
+ * dvbpsi_eit_segment_add
+ *****************************************************************************
+ * Records a section added to the building table and signals its segment
+ * once complete.
+ *****************************************************************************/
+static void dvbpsi_eit_segment_add(dvbpsi_t *p_dvbpsi, dvbpsi_eit_decoder_t *p_eit_decoder,
+                                   uint8_t i_number, uint8_t i_segment_last)
+{
+    unsigned int i_segment = i_number / 8;
+
+    /* segment_last_section_number of another segment is wrong, then the
+       segment is not expected to go beyond this section */
+    if (i_segment_last / 8u != i_segment || i_segment_last < i_number)
+        i_segment_last = i_number;
+
+    p_eit_decoder->pi_segment_received[i_segment] |= 1 << (i_number % 8);
+    p_eit_decoder->pi_segment_expected[i_segment] |= (2 << (i_segment_last % 8)) - 1;
+
+    uint8_t i_expected = p_eit_decoder->pi_segment_expected[i_segment];
+    if (   p_eit_decoder->pf_segment_callback == NULL
+        || (p_eit_decoder->i_segments_signalled & (UINT32_C(1) << i_segment))
+        || (p_eit_decoder->pi_segment_received[i_segment] & i_expected) != i_expected)
+        return;
+
+    p_eit_decoder->i_segments_signalled |= UINT32_C(1) << i_segment;
+
+    dvbpsi_psi_section_t *p_first = p_eit_decoder->p_sections;
+    while (p_first && p_first->i_number < i_segment * 8)
+        p_first = p_first->p_next;
+    assert(p_first);
+    dvbpsi_eit_segment_signal(p_dvbpsi, p_eit_decoder, p_first);
+}
+
 static bool dvbpsi_AddSectionEIT(dvbpsi_t *p_dvbpsi, dvbpsi_eit_decoder_t *p_eit_decoder,
                                  dvbpsi_psi_section_t* p_section)
 {
@@ -388,6 +748,8 @@ static bool dvbpsi_AddSectionEIT(dvbpsi_t *p_dvbpsi, dvbpsi_eit_decoder_t *p_eit
     /* Initialize the structures if it's the first section received */
     if (!p_eit_decoder->p_building_eit)
     {
+        dvbpsi_arena_t *p_arena = dvbpsi_arena_table_new(p_dvbpsi);
+        dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(p_arena);
         p_eit_decoder->p_building_eit = dvbpsi_eit_new(
                                 p_section->i_table_id,
                                 p_section->i_extension,
@@ -399,6 +761,11 @@ static bool dvbpsi_AddSectionEIT(dvbpsi_t *p_dvbpsi, dvbpsi_eit_decoder_t *p_eit
                                     | p_section->p_payload_start[3],
                                 p_section->p_payload_start[4],
                                 p_section->p_payload_start[5]);
+        dvbpsi_arena_leave(p_previous);
+        if (p_eit_decoder->p_building_eit)
+            p_eit_decoder->p_building_eit->p_arena = p_arena;
+        else
+            dvbpsi_arena_delete(p_arena);
 
         p_eit_decoder->i_last_section_number = p_section->i_last_number;
         p_eit_decoder->i_first_received_section_number = p_section->i_number;
@@ -406,13 +773,25 @@ static bool dvbpsi_AddSectionEIT(dvbpsi_t *p_dvbpsi, dvbpsi_eit_decoder_t *p_eit
         if (p_eit_decoder->p_building_eit == NULL)
             return false;
         p_eit_decoder->i_last_section_number = p_section->i_last_number;
+
+        /* Segments of the restored version already signalled */
+        if (p_eit_decoder->b_restored)
+        {
+            if (   p_section->b_current_next
+                && p_section->i_version == p_eit_decoder->i_restored_version)
+                p_eit_decoder->i_segments_signalled = p_eit_decoder->i_restored_segments;
+            p_eit_decoder->b_restored = false;
+        }
     }
 
     /* Add to linked list of sections */
+    uint8_t i_number = p_section->i_number;
+    uint8_t i_segment_last = p_section->p_payload_start[4];
     if (dvbpsi_decoder_psi_section_add(DVBPSI_DECODER(p_eit_decoder), p_section))
         dvbpsi_debug(p_dvbpsi, "EIT decoder",
-                     "overwrite section number %d", p_section->i_number);
+                     "overwrite section number %d", i_number);
 
+    dvbpsi_eit_segment_add(p_dvbpsi, p_eit_decoder, i_number, i_segment_last);
     return true;
 }
 
@@ -449,28 +828,42 @@ void dvbpsi_eit_sections_gather(dvbpsi_t *p_dvbpsi, dvbpsi_decoder_t *p_private_
         p_eit_decoder->b_discontinuity = false;
         p_demux->b_discontinuity = false;
     }
-    else
+    else if (p_eit_decoder->p_building_eit)
     {
         /* Perform a few sanity checks */
-        if (p_eit_decoder->p_building_eit)
-        {
-            if (dvbpsi_CheckEIT(p_dvbpsi, p_eit_decoder, p_section))
-                dvbpsi_ReInitEIT(p_eit_decoder, true);
-        }
-        else
-        {
-            if (   (p_eit_decoder->b_current_valid)
-                && (p_eit_decoder->current_eit.i_version == p_section->i_version)
-                && (p_eit_decoder->current_eit.b_current_next == p_section->b_current_next))
-            {
-                /* Don't decode since this version is already decoded */
-                dvbpsi_debug(p_dvbpsi, "EIT decoder",
-                             "ignoring already decoded section %d",
-                             p_section->i_number);
-                dvbpsi_DeletePSISections(p_section);
-                return;
-            }
-        }
+        if (dvbpsi_CheckEIT(p_dvbpsi, p_eit_decoder, p_section))
+            dvbpsi_ReInitEIT(p_eit_decoder, true);
+    }
+
+    /* Whole table restored, as if it had just been decoded */
+    if (p_eit_decoder->b_restored && p_eit_decoder->i_restored_segments == UINT32_MAX)
+    {
+        dvbpsi_eit_init(&p_eit_decoder->current_eit, p_section->i_table_id,
+                        p_section->i_extension, p_eit_decoder->i_restored_version,
+                        true, 0, 0, 0, 0);
+        p_eit_decoder->b_current_valid = true;
+        p_eit_decoder->b_known = true;
+        p_eit_decoder->i_known_table_id = p_section->i_table_id;
+        p_eit_decoder->i_known_extension = p_section->i_extension;
+        p_eit_decoder->i_known_version = p_eit_decoder->i_restored_version;
+        p_eit_decoder->b_known_current_next = true;
+        p_eit_decoder->i_known_skipped = 0;
+        p_eit_decoder->b_restored = false;
+    }
+
+    if (   !p_eit_decoder->p_building_eit
+        && (p_eit_decoder->b_current_valid)
+        && (p_eit_decoder->current_eit.i_version == p_section->i_version)
+        && (p_eit_decoder->current_eit.b_current_next == p_section->b_current_next))
+    {
+        /* Don't decode since this version is already decoded */
+        p_dvbpsi->stats.i_dropped_duplicate++;
+        dvbpsi_probe_dropped(p_section, "duplicate");
+        dvbpsi_debug(p_dvbpsi, "EIT decoder",
+                     "ignoring already decoded section %d",
+                     p_section->i_number);
+        dvbpsi_DeletePSISections(p_section);
+        return;
     }
 
     /* Add section to EIT */
@@ -488,18 +881,34 @@ void dvbpsi_eit_sections_gather(dvbpsi_t *p_dvbpsi, dvbpsi_decoder_t *p_private_
      */
     if (dvbpsi_IsCompleteEIT(p_eit_decoder, p_section))
     {
+        p_dvbpsi->stats.i_tables++;
         assert(p_eit_decoder->pf_eit_callback);
 
+        dvbpsi_decoder_psi_sections_known(DVBPSI_DECODER(p_eit_decoder));
+
         /* Save the current information */
         p_eit_decoder->current_eit = *p_eit_decoder->p_building_eit;
         p_eit_decoder->b_current_valid = true;
 
-        /* Decode the sections */
-        dvbpsi_eit_sections_decode(p_eit_decoder->p_building_eit,
-                                   p_eit_decoder->p_sections);
+        if (p_dvbpsi->i_flags & DVBPSI_FLAG_LAZY_DECODE)
+        {
+            /* Hand the sections over, they are decoded on request */
+            p_eit_decoder->p_building_eit->p_sections = p_eit_decoder->p_sections;
+            p_eit_decoder->p_sections = NULL;
+        }
+        else
+        {
+            /* Decode the sections, in the arena of the table if any */
+            dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(p_eit_decoder->p_building_eit->p_arena);
+            dvbpsi_eit_sections_decode(p_eit_decoder->p_building_eit,
+                                       p_eit_decoder->p_sections);
+            dvbpsi_arena_leave(p_previous);
+        }
 
         /* signal the new EIT */
+        dvbpsi_probe_callback_entry("eit", p_section->i_table_id, p_section->i_extension);
         p_eit_decoder->pf_eit_callback(p_eit_decoder->p_cb_data, p_eit_decoder->p_building_eit);
+        dvbpsi_probe_callback_exit("eit", p_section->i_table_id, p_section->i_extension);
 
         /* Delete sections and Reinitialize the structures */
         dvbpsi_ReInitEIT(p_eit_decoder, false);
@@ -557,6 +966,8 @@ void dvbpsi_eit_sections_decode(dvbpsi_eit_t* p_eit,
                     dvbpsi_eit_event_descriptor_add(p_event, i_tag, i_length, p_byte + 2);
                 p_byte += 2 + i_length;
             }
+            for (int i = 0; i < DVBPSI_TAGS_SIZE; i++)
+                p_eit->p_tags[i] |= p_event->p_tags[i];
         }
         p_section = p_section->p_next;
     }
@@ -568,10 +979,10 @@ void dvbpsi_eit_sections_decode(dvbpsi_eit_t* p_eit,
  * Helper function which allocates a initializes a new PSI section suitable
  * for carrying EIT data.
  *****************************************************************************/
-static dvbpsi_psi_section_t* NewEITSection(dvbpsi_eit_t* p_eit, int i_table_id,
-                                           int i_section_number)
+static dvbpsi_psi_section_t* NewEITSection(dvbpsi_t *p_dvbpsi, dvbpsi_eit_t* p_eit,
+                                           int i_table_id, int i_section_number)
 {
-  dvbpsi_psi_section_t *p_result = dvbpsi_NewPSISection(4094);
+  dvbpsi_psi_section_t *p_result = dvbpsi_section_buffer_get(p_dvbpsi, 4094);
 
   p_result->i_table_id = i_table_id;
   p_result->b_syntax_indicator = 1;
@@ -608,7 +1019,7 @@ static dvbpsi_psi_section_t* NewEITSection(dvbpsi_eit_t* p_eit, int i_table_id,
  *****************************************************************************
  * Helper function which encodes an EIT event header in a byte buffer.
  *****************************************************************************/
-static inline void EncodeEventHeaders(dvbpsi_eit_event_t *p_event, uint8_t *buf)
+static inline void EncodeEventHeaders(const dvbpsi_eit_event_t *p_event, uint8_t *buf)
 {
   /* event_id */
   buf[0] = p_event->i_event_id >> 8;
@@ -641,7 +1052,7 @@ static inline void EncodeEventHeaders(dvbpsi_eit_event_t *p_event, uint8_t *buf)
 dvbpsi_psi_section_t* dvbpsi_eit_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_eit_t *p_eit,
                                             uint8_t i_table_id)
 {
-  dvbpsi_psi_section_t *p_result = NewEITSection (p_eit, i_table_id, 0);
+  dvbpsi_psi_section_t *p_result = NewEITSection (p_dvbpsi, p_eit, i_table_id, 0);
   dvbpsi_psi_section_t *p_current = p_result;
   uint8_t i_last_section_number = 0;
   dvbpsi_eit_event_t *p_event;
@@ -667,7 +1078,7 @@ dvbpsi_psi_section_t* dvbpsi_eit_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_ei
       {
         dvbpsi_psi_section_t *p_prev = p_current;
 
-        p_current = NewEITSection (p_eit, i_table_id, ++i_last_section_number);
+        p_current = NewEITSection (p_dvbpsi, p_eit, i_table_id, ++i_last_section_number);
         p_event_start = p_current->p_payload_end;
         p_prev->p_next = p_current;
 
@@ -722,3 +1133,296 @@ dvbpsi_psi_section_t* dvbpsi_eit_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_ei
 
   return p_result;
 }
+
+/*****************************************************************************
+ * dvbpsi_eit_sections_generate_into
+ *****************************************************************************
+ * Generate EIT sections into a caller buffer.
+ *****************************************************************************/
+int dvbpsi_eit_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_eit_t *p_eit,
+                                      uint8_t i_table_id, dvbpsi_section_buffer_t *p_buffer)
+{
+    dvbpsi_section_buffer_begin(p_dvbpsi, p_buffer);
+    return dvbpsi_section_buffer_end(p_dvbpsi,
+                dvbpsi_eit_sections_generate(p_dvbpsi, p_eit, i_table_id));
+}
+
+/*****************************************************************************
+ * dvbpsi_eit_schedule_s
+ *****************************************************************************
+ * The open segment and its sections.
+ *****************************************************************************/
+#define DVBPSI_EIT_SEGMENTS_PER_TABLE 32
+#define DVBPSI_EIT_SECTIONS_PER_SEGMENT 8
+
+struct dvbpsi_eit_schedule_s
+{
+    dvbpsi_t                    *p_dvbpsi;
+    dvbpsi_eit_t                eit;            /* header of the sections */
+    uint8_t                     i_table_id;     /* first table_id */
+    uint16_t                    i_mjd;          /* first day */
+    unsigned int                i_segments;     /* of the whole schedule */
+
+    unsigned int                i_segment;      /* open segment */
+    dvbpsi_psi_section_t        *p_first;       /* its sections, or NULL */
+    dvbpsi_psi_section_t        *p_current;
+    uint8_t                     *p_event;       /* event reserved, or NULL */
+    size_t                      i_event_size;   /* bytes of its descriptors */
+
+    dvbpsi_eit_schedule_callback pf_callback;
+    void                        *p_cb_data;
+};
+
+/*****************************************************************************
+ * dvbpsi_eit_schedule_new
+ *****************************************************************************/
+dvbpsi_eit_schedule_t *dvbpsi_eit_schedule_new(dvbpsi_t *p_dvbpsi,
+                                               const dvbpsi_eit_t *p_eit,
+                                               uint8_t i_table_id,
+                                               uint16_t i_mjd, unsigned int i_days,
+                                               dvbpsi_eit_schedule_callback pf_callback,
+                                               void *p_cb_data)
+{
+    assert(p_eit);
+    assert(pf_callback);
+
+    if ((i_table_id != 0x50 && i_table_id != 0x60) || i_days < 1 || i_days > 64)
+        return NULL;
+
+    dvbpsi_eit_schedule_t *p_schedule = dvbpsi_calloc(1, sizeof(dvbpsi_eit_schedule_t));
+    if (p_schedule == NULL)
+        return NULL;
+
+    p_schedule->p_dvbpsi = p_dvbpsi;
+    p_schedule->i_table_id = i_table_id;
+    p_schedule->i_mjd = i_mjd;
+    p_schedule->i_segments = i_days * 8;
+    p_schedule->pf_callback = pf_callback;
+    p_schedule->p_cb_data = p_cb_data;
+
+    dvbpsi_eit_init(&p_schedule->eit, i_table_id, p_eit->i_extension,
+                    p_eit->i_version, p_eit->b_current_next, p_eit->i_ts_id,
+                    p_eit->i_network_id, 0,
+                    i_table_id + (p_schedule->i_segments - 1) / DVBPSI_EIT_SEGMENTS_PER_TABLE);
+    return p_schedule;
+}
+
+/*****************************************************************************
+ * dvbpsi_eit_schedule_last_number
+ *****************************************************************************
+ * last_section_number of the table_id of a segment, that of the eighth
+ * section of its last segment.
+ *****************************************************************************/
+static uint8_t dvbpsi_eit_schedule_last_number(const dvbpsi_eit_schedule_t *p_schedule,
+                                               unsigned int i_segment)
+{
+    unsigned int i_last = i_segment | (DVBPSI_EIT_SEGMENTS_PER_TABLE - 1);
+    if (i_last >= p_schedule->i_segments)
+        i_last = p_schedule->i_segments - 1;
+    return (i_last % DVBPSI_EIT_SEGMENTS_PER_TABLE) * DVBPSI_EIT_SECTIONS_PER_SEGMENT
+         + DVBPSI_EIT_SECTIONS_PER_SEGMENT - 1;
+}
+
+/*****************************************************************************
+ * dvbpsi_eit_schedule_section
+ *****************************************************************************
+ * Appends a section to the open segment.
+ *****************************************************************************/
+static bool dvbpsi_eit_schedule_section(dvbpsi_eit_schedule_t *p_schedule)
+{
+    unsigned int i_segment = p_schedule->i_segment;
+    int i_number = (i_segment % DVBPSI_EIT_SEGMENTS_PER_TABLE) * DVBPSI_EIT_SECTIONS_PER_SEGMENT;
+    if (p_schedule->p_current)
+    {
+        i_number = p_schedule->p_current->i_number + 1;
+        if (i_number % DVBPSI_EIT_SECTIONS_PER_SEGMENT == 0)
+            return false;
+    }
+
+    dvbpsi_psi_section_t *p_section =
+        NewEITSection(p_schedule->p_dvbpsi, &p_schedule->eit,
+                      p_schedule->i_table_id + i_segment / DVBPSI_EIT_SEGMENTS_PER_TABLE,
+                      i_number);
+    if (p_section == NULL)
+        return false;
+
+    if (p_schedule->p_current)
+        p_schedule->p_current->p_next = p_section;
+    else
+        p_schedule->p_first = p_section;
+    p_schedule->p_current = p_section;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_eit_schedule_close
+ *****************************************************************************
+ * Completes the open segment, hands it to the callback and opens the next.
+ *****************************************************************************/
+static bool dvbpsi_eit_schedule_close(dvbpsi_eit_schedule_t *p_schedule)
+{
+    unsigned int i_segment = p_schedule->i_segment;
+    uint8_t i_last_number = dvbpsi_eit_schedule_last_number(p_schedule, i_segment);
+    bool b_last = (i_segment + 1) % DVBPSI_EIT_SEGMENTS_PER_TABLE == 0
+               || i_segment + 1 == p_schedule->i_segments;
+
+    if (p_schedule->p_first == NULL && !dvbpsi_eit_schedule_section(p_schedule))
+        return false;
+    while (b_last && p_schedule->p_current->i_number != i_last_number)
+    {
+        if (!dvbpsi_eit_schedule_section(p_schedule))
+            return false;
+    }
+
+    for (dvbpsi_psi_section_t *p = p_schedule->p_first; p; p = p->p_next)
+    {
+        /* Segment last section number */
+        p->p_data[12] = p_schedule->p_current->i_number;
+        p->i_last_number = i_last_number;
+
+        dvbpsi_BuildPSISection(p_schedule->p_dvbpsi, p);
+    }
+
+    dvbpsi_psi_section_t *p_sections = p_schedule->p_first;
+    p_schedule->p_first = p_schedule->p_current = NULL;
+    p_schedule->i_segment++;
+    p_schedule->pf_callback(p_schedule->p_cb_data, p_sections);
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_eit_schedule_reserve
+ *****************************************************************************/
+uint8_t *dvbpsi_eit_schedule_reserve(dvbpsi_eit_schedule_t *p_schedule,
+                                     const dvbpsi_eit_event_t *p_event, size_t i_size)
+{
+    assert(p_schedule);
+    assert(p_event);
+
+    p_schedule->p_event = NULL;
+
+    /* start_time: 16 bits of MJD then the UTC time in 6 BCD digits */
+    unsigned int i_mjd = (p_event->i_start_time >> 24) & 0xffff;
+    unsigned int i_hours = (p_event->i_start_time >> 16) & 0xff;
+    i_hours = (i_hours >> 4) * 10 + (i_hours & 0x0f);
+    if (i_mjd < p_schedule->i_mjd || i_hours > 23)
+        return NULL;
+
+    unsigned int i_segment = (i_mjd - p_schedule->i_mjd) * 8 + i_hours / 3;
+    if (i_segment < p_schedule->i_segment || i_segment >= p_schedule->i_segments)
+        return NULL;
+
+    if (14 + 12 + i_size > 4090)
+        return NULL;
+
+    while (p_schedule->i_segment < i_segment)
+    {
+        if (!dvbpsi_eit_schedule_close(p_schedule))
+            return NULL;
+    }
+
+    dvbpsi_psi_section_t *p_current = p_schedule->p_current;
+    if (p_current == NULL
+     || p_current->p_payload_end - p_current->p_data + 12 + i_size > 4090)
+    {
+        if (!dvbpsi_eit_schedule_section(p_schedule))
+            return NULL;
+        p_current = p_schedule->p_current;
+    }
+
+    p_schedule->p_event = p_current->p_payload_end;
+    p_schedule->i_event_size = i_size;
+    EncodeEventHeaders(p_event, p_schedule->p_event);
+    return p_schedule->p_event + 12;
+}
+
+/*****************************************************************************
+ * dvbpsi_eit_schedule_commit
+ *****************************************************************************/
+bool dvbpsi_eit_schedule_commit(dvbpsi_eit_schedule_t *p_schedule, size_t i_length)
+{
+    assert(p_schedule);
+
+    uint8_t *p_event = p_schedule->p_event;
+    if (p_event == NULL || i_length > p_schedule->i_event_size)
+        return false;
+
+    p_event[10] = (p_event[10] & 0xf0) | ((i_length >> 8) & 0x0f);
+    p_event[11] = i_length;
+    p_schedule->p_current->p_payload_end += 12 + i_length;
+    p_schedule->p_current->i_length += 12 + i_length;
+    p_schedule->p_event = NULL;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_eit_schedule_add
+ *****************************************************************************/
+bool dvbpsi_eit_schedule_add(dvbpsi_eit_schedule_t *p_schedule,
+                             const dvbpsi_eit_event_t *p_event)
+{
+    size_t i_length = 0;
+    for (dvbpsi_descriptor_t *p_descriptor = p_event->p_first_descriptor;
+         p_descriptor; p_descriptor = p_descriptor->p_next)
+        i_length += p_descriptor->i_length + 2;
+
+    uint8_t *p = dvbpsi_eit_schedule_reserve(p_schedule, p_event, i_length);
+    if (p == NULL)
+        return false;
+
+    for (dvbpsi_descriptor_t *p_descriptor = p_event->p_first_descriptor;
+         p_descriptor; p_descriptor = p_descriptor->p_next)
+    {
+        p[0] = p_descriptor->i_tag;
+        p[1] = p_descriptor->i_length;
+        memcpy(p + 2, p_descriptor->p_data, p_descriptor->i_length);
+        p += p_descriptor->i_length + 2;
+    }
+    return dvbpsi_eit_schedule_commit(p_schedule, i_length);
+}
+
+/*****************************************************************************
+ * dvbpsi_eit_schedule_finish
+ *****************************************************************************/
+bool dvbpsi_eit_schedule_finish(dvbpsi_eit_schedule_t *p_schedule)
+{
+    assert(p_schedule);
+
+    while (p_schedule->i_segment < p_schedule->i_segments)
+    {
+        if (!dvbpsi_eit_schedule_close(p_schedule))
+            return false;
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_eit_schedule_delete
+ *****************************************************************************/
+void dvbpsi_eit_schedule_delete(dvbpsi_eit_schedule_t *p_schedule)
+{
+    if (p_schedule == NULL)
+        return;
+
+    dvbpsi_DeletePSISections(p_schedule->p_first);
+    dvbpsi_free(p_schedule);
+}
+
+/*****************************************************************************
+ * dvbpsi_eit_section_iter
+ *****************************************************************************
+ * Sets up iterators over the raw loops of a EIT section.
+ *****************************************************************************/
+bool dvbpsi_eit_section_iter(dvbpsi_psi_section_t *p_section,
+                             dvbpsi_entry_iter_t *p_events)
+{
+    assert(p_section);
+
+    uint8_t *p_byte = p_section->p_payload_start;
+    uint8_t *p_end = p_section->p_payload_end;
+    if (p_end - p_byte < 6)
+        return false;
+
+    dvbpsi_entry_iter_init(p_events, p_byte + 6, p_end - p_byte - 6, 12, 10);
+    return true;
+}
@@ -64,6 +64,9 @@ typedef struct dvbpsi_eit_event_s
                                                          length */
   dvbpsi_descriptor_t *     p_first_descriptor;     /*!< First of the following
                                                          DVB descriptors */
+  dvbpsi_descriptor_t *     p_last_descriptor;      /*!< private, list tail */
+  uint8_t                   p_tags[DVBPSI_TAGS_SIZE]; /*!< tags present in
+                                     the list, see dvbpsi_has_descriptor() */
 
   struct dvbpsi_eit_event_s * p_next;               /*!< next element of
                                                              the list */
@@ -97,6 +100,12 @@ typedef struct dvbpsi_eit_s
     uint8_t             i_last_table_id;    /*!< last table id */
 
     dvbpsi_eit_event_t *p_first_event;      /*!< event information list */
+    dvbpsi_eit_event_t *p_last_event;       /*!< private, list tail */
+    uint8_t             p_tags[DVBPSI_TAGS_SIZE]; /*!< tags present in the
+                                     descriptors of any decoded event,
+                                     see dvbpsi_has_descriptor() */
+    struct dvbpsi_arena_s *p_arena;         /*!< private, see DVBPSI_FLAG_TABLE_ARENA */
+    dvbpsi_psi_section_t *p_sections;       /*!< raw sections, see DVBPSI_FLAG_LAZY_DECODE */
 
 } dvbpsi_eit_t;
 
@@ -142,6 +151,65 @@ bool dvbpsi_eit_attach(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_extens
  */
 void dvbpsi_eit_detach(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_extension);
 
+/*****************************************************************************
+ * dvbpsi_eit_set_segment_callback
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_eit_set_segment_callback(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+ *                                          uint16_t i_extension,
+ *                                          dvbpsi_eit_callback pf_callback,
+ *                                          void* p_cb_data)
+ * \brief Signals each segment of the EITs of a decoder as soon as it is
+ * complete, before the whole table
+ * \param p_dvbpsi dvbpsi handle pointing to Subtable demultiplexor to which the
+ *        eit decoder is attached.
+ * \param i_table_id Table ID, 0x4E, 0x4F, or 0x50-0x6F.
+ * \param i_extension Table ID extension, here service ID.
+ * \param pf_callback function called with an EIT holding the events of one
+ *        segment, to be deleted with dvbpsi_eit_delete(), NULL for none
+ * \param p_cb_data private data given in argument to the callback
+ * \return false if there is no such EIT decoder, true otherwise.
+ *
+ * A segment is the 8 sections from a multiple of 8, up to the
+ * segment_last_section_number of its sections, the one of the EIT given
+ * to the callback. Each segment of a version is signalled once, decoded at
+ * once whatever DVBPSI_FLAG_LAZY_DECODE, and the whole table is still
+ * given to the callback of dvbpsi_eit_attach() when complete.
+ */
+bool dvbpsi_eit_set_segment_callback(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                                     uint16_t i_extension,
+                                     dvbpsi_eit_callback pf_callback, void* p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_eit_restore
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_eit_restore(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+ *                             uint16_t i_extension, uint8_t i_version,
+ *                             uint32_t i_segments)
+ * \brief Resumes an EIT decoder from a version decoded before, typically
+ * found with dvbpsi_epg_version() in an EPG store loaded at start up
+ * \param p_dvbpsi dvbpsi handle pointing to Subtable demultiplexor to which the
+ *        eit decoder is attached.
+ * \param i_table_id Table ID, 0x4E, 0x4F, or 0x50-0x6F.
+ * \param i_extension Table ID extension, here service ID.
+ * \param i_version version_number of the table
+ * \param i_segments UINT32_MAX for a whole table, or the bit mask of the
+ *        segments of the version given to the callback of
+ *        dvbpsi_eit_set_segment_callback(), all 32 of them making a whole
+ *        table
+ * \return false if there is no such EIT decoder, or if it already received
+ *         sections, true otherwise.
+ *
+ * The sections of a whole table of this version are then ignored as if the
+ * table had just been decoded, without calling the callback of
+ * dvbpsi_eit_attach(). With the segments of a version, these segments are
+ * not signalled again, the others being as soon as complete. Any other
+ * version is decoded as usual.
+ */
+bool dvbpsi_eit_restore(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_extension,
+                        uint8_t i_version, uint32_t i_segments);
+
 /*****************************************************************************
  * dvbpsi_eit_init/dvbpsi_eit_new
  *****************************************************************************/
@@ -210,6 +278,129 @@ void dvbpsi_eit_empty(dvbpsi_eit_t* p_eit);
  */
 void dvbpsi_eit_delete(dvbpsi_eit_t* p_eit);
 
+/*****************************************************************************
+ * dvbpsi_eit_decode
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_eit_decode(dvbpsi_eit_t* p_eit)
+ * \brief Decodes the raw sections of a EIT received with DVBPSI_FLAG_LAZY_DECODE
+ * \param p_eit pointer to the EIT structure
+ * \return nothing.
+ *
+ * Decodes the events from dvbpsi_eit_t::p_sections and releases the
+ * sections. Does nothing when the EIT has no raw sections.
+ */
+void dvbpsi_eit_decode(dvbpsi_eit_t* p_eit);
+
+/*****************************************************************************
+ * dvbpsi_eit_event_times
+ *****************************************************************************/
+/*!
+ * \fn size_t dvbpsi_eit_event_times(dvbpsi_eit_t* p_eit, int64_t *pi_starts,
+ *                                  uint32_t *pi_durations, size_t i_max)
+ * \brief Converts the start times and durations of the events of an EIT
+ * \param p_eit pointer to the EIT structure, decoded if it was not yet
+ * \param pi_starts filled with the start_time of up to i_max events in
+ *        seconds since 1970-01-01 UTC, INT64_MIN when undefined, unless NULL
+ * \param pi_durations filled with the duration of up to i_max events in
+ *        seconds, unless NULL
+ * \param i_max size of the arrays
+ * \return the number of events of the EIT, which may exceed i_max.
+ *
+ * The events are converted in the order of dvbpsi_eit_t::p_first_event,
+ * with dvbpsi_mjd_to_utc() and dvbpsi_bcd_to_seconds().
+ */
+size_t dvbpsi_eit_event_times(dvbpsi_eit_t* p_eit, int64_t *pi_starts,
+                              uint32_t *pi_durations, size_t i_max);
+
+/*****************************************************************************
+ * dvbpsi_eit_extended_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_eit_extended_item_s
+ * \brief Item of the extended event descriptors of an event.
+ */
+/*!
+ * \typedef struct dvbpsi_eit_extended_item_s dvbpsi_eit_extended_item_t
+ * \brief dvbpsi_eit_extended_item_t type definition.
+ */
+typedef struct dvbpsi_eit_extended_item_s
+{
+  const uint8_t *           p_description;          /*!< item_description */
+  uint8_t                   i_description_length;   /*!< its length */
+  const uint8_t *           p_item;                 /*!< item, joined when
+                                                         continued in the next
+                                                         descriptor */
+  size_t                    i_item_length;          /*!< its length */
+} dvbpsi_eit_extended_item_t;
+
+/*!
+ * \struct dvbpsi_eit_extended_s
+ * \brief Extended event descriptors of an event reassembled, see
+ * dvbpsi_eit_event_extended().
+ */
+/*!
+ * \typedef struct dvbpsi_eit_extended_s dvbpsi_eit_extended_t
+ * \brief dvbpsi_eit_extended_t type definition.
+ */
+typedef struct dvbpsi_eit_extended_s
+{
+  uint8_t                   i_iso_639_code[3];      /*!< language */
+  unsigned int              i_descriptors;          /*!< number of descriptors
+                                                         reassembled */
+  bool                      b_complete;             /*!< all the descriptors
+                                                         up to
+                                                         last_descriptor_number
+                                                         are present */
+  const uint8_t *           p_text;                 /*!< text, in the table
+                                                         of its first byte */
+  size_t                    i_text_length;          /*!< its length */
+  size_t                    i_items;                /*!< number of items, which
+                                                         may exceed the array
+                                                         given */
+  size_t                    i_buffer;               /*!< bytes of the buffer
+                                                         needed */
+} dvbpsi_eit_extended_t;
+
+/*****************************************************************************
+ * dvbpsi_eit_event_extended
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_eit_event_extended(const dvbpsi_eit_event_t *p_event,
+ *                                    const uint8_t *p_language,
+ *                                    dvbpsi_eit_extended_t *p_extended,
+ *                                    dvbpsi_eit_extended_item_t *p_items,
+ *                                    size_t i_max_items,
+ *                                    uint8_t *p_buffer, size_t i_size)
+ * \brief Reassembles the extended event descriptors of an event in a
+ * language into one text and one list of items
+ * \param p_event event of an EIT
+ * \param p_language 3 letter ISO 639 code, or NULL for the language of the
+ *        first extended event descriptor
+ * \param p_extended filled with the text and the number of items
+ * \param p_items filled with up to i_max_items items, unless NULL
+ * \param i_max_items size of the array
+ * \param p_buffer buffer for the parts to join, may be NULL if i_size is 0
+ * \param i_size size of the buffer
+ * \return false if the event has no extended event descriptor in the
+ *         language, or if the buffer is smaller than
+ *         dvbpsi_eit_extended_t::i_buffer, true otherwise.
+ *
+ * The descriptors are taken by descriptor_number, whatever their order in
+ * the loop. The text and items point into the descriptors of the event
+ * when they fit in one, and into p_buffer when they span several: the
+ * repeated character table selections at the start of the following parts
+ * of the text are dropped, and an item with an empty description at the
+ * start of a descriptor continues the last one. Nothing is allocated and
+ * the descriptors are not decoded, the text being given as is to
+ * dvbpsi_text_to_utf8() for instance.
+ */
+bool dvbpsi_eit_event_extended(const dvbpsi_eit_event_t *p_event,
+                               const uint8_t *p_language,
+                               dvbpsi_eit_extended_t *p_extended,
+                               dvbpsi_eit_extended_item_t *p_items, size_t i_max_items,
+                               uint8_t *p_buffer, size_t i_size);
+
 /*****************************************************************************
  * dvbpsi_eit_event_add
  *****************************************************************************/
@@ -296,6 +487,181 @@ dvbpsi_descriptor_t* dvbpsi_eit_event_descriptor_add(
 dvbpsi_psi_section_t *dvbpsi_eit_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_eit_t *p_eit,
                                             uint8_t i_table_id);
 
+/*****************************************************************************
+ * dvbpsi_eit_sections_generate_into
+ *****************************************************************************/
+/*!
+ * \fn int dvbpsi_eit_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_eit_t *p_eit,
+ *                                          uint8_t i_table_id, dvbpsi_section_buffer_t *p_buffer)
+ * \brief EIT generator writing into caller memory
+ * \param p_dvbpsi handle to dvbpsi with attached decoder
+ * \param p_eit pointer to the EIT structure
+ * \param i_table_id table id, as for dvbpsi_eit_sections_generate()
+ * \param p_buffer buffer the sections are written into, its previous
+ *        sections are overwritten
+ * \return the number of sections written, linked from p_buffer->p_sections,
+ *         or -1 on error or if the buffer is too small.
+ *
+ * Same encoding as dvbpsi_eit_sections_generate(), without any allocation.
+ */
+int dvbpsi_eit_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_eit_t *p_eit,
+                                      uint8_t i_table_id, dvbpsi_section_buffer_t *p_buffer);
+
+/*****************************************************************************
+ * dvbpsi_eit_schedule_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_eit_schedule_s dvbpsi_eit_schedule_t
+ * \brief dvbpsi_eit_schedule_t type definition, an opaque streaming EIT
+ * schedule generator.
+ */
+typedef struct dvbpsi_eit_schedule_s dvbpsi_eit_schedule_t;
+
+/*!
+ * \typedef void (* dvbpsi_eit_schedule_callback)(void *p_cb_data,
+ *                                               dvbpsi_psi_section_t *p_sections)
+ * \brief Callback type definition, called with the sections of each segment
+ * of a schedule, which it is in charge of deleting.
+ */
+typedef void (* dvbpsi_eit_schedule_callback)(void *p_cb_data,
+                                              dvbpsi_psi_section_t *p_sections);
+
+/*****************************************************************************
+ * dvbpsi_eit_schedule_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_eit_schedule_t *dvbpsi_eit_schedule_new(dvbpsi_t *p_dvbpsi,
+ *                                 const dvbpsi_eit_t *p_eit, uint8_t i_table_id,
+ *                                 uint16_t i_mjd, unsigned int i_days,
+ *                                 dvbpsi_eit_schedule_callback pf_callback,
+ *                                 void *p_cb_data)
+ * \brief Starts generating the EIT schedule of a service segment by segment,
+ * ETSI EN 300 468 section 5.2.4 and ETSI TR 101 211 section 4.1.4.
+ * \param p_dvbpsi handle to dvbpsi, as for dvbpsi_eit_sections_generate()
+ * \param p_eit EIT whose service_id, version_number, current_next_indicator,
+ *        transport_stream_id and original_network_id are used, its events
+ *        being ignored
+ * \param i_table_id first table_id, 0x50 for the actual transport stream or
+ *        0x60 for another one
+ * \param i_mjd Modified Julian Date of the first day of the schedule, whose
+ *        first segment starts at 00:00 UTC
+ * \param i_days number of days of the schedule, 1 to 64. It sets the
+ *        last_table_id.
+ * \param pf_callback function called with the sections of each segment
+ * \param p_cb_data private data given to pf_callback
+ * \return pointer to the generator, or NULL on error
+ *
+ * Each segment covers three hours, 8 segments a day and 32 segments a
+ * table_id. The sections of a segment are numbered from 8 times its index
+ * in its table_id, a segment without any event being one empty section.
+ * The last segment of each table_id is padded with empty sections up to
+ * its eighth one, so that its last_section_number is known before its
+ * events are.
+ */
+dvbpsi_eit_schedule_t *dvbpsi_eit_schedule_new(dvbpsi_t *p_dvbpsi,
+                                               const dvbpsi_eit_t *p_eit,
+                                               uint8_t i_table_id,
+                                               uint16_t i_mjd, unsigned int i_days,
+                                               dvbpsi_eit_schedule_callback pf_callback,
+                                               void *p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_eit_schedule_add
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_eit_schedule_add(dvbpsi_eit_schedule_t *p_schedule,
+ *                                  const dvbpsi_eit_event_t *p_event)
+ * \brief Adds the next event of a schedule, by start_time
+ * \param p_schedule pointer to the generator
+ * \param p_event event, copied in the sections of its segment
+ * \return false if the event starts before an event already added or out
+ *         of the schedule, if its segment is full or on error, in which
+ *         case the event is not added, true otherwise.
+ *
+ * The segments before the segment of the event are completed and handed
+ * to the callback. Only the sections of one segment are kept in memory.
+ */
+bool dvbpsi_eit_schedule_add(dvbpsi_eit_schedule_t *p_schedule,
+                             const dvbpsi_eit_event_t *p_event);
+
+/*****************************************************************************
+ * dvbpsi_eit_schedule_reserve
+ *****************************************************************************/
+/*!
+ * \fn uint8_t *dvbpsi_eit_schedule_reserve(dvbpsi_eit_schedule_t *p_schedule,
+ *                                          const dvbpsi_eit_event_t *p_event,
+ *                                          size_t i_size)
+ * \brief Starts the next event of a schedule, whose descriptors are then
+ * written by the caller straight into its section
+ * \param p_schedule pointer to the generator
+ * \param p_event event, its descriptors being ignored
+ * \param i_size largest size of the descriptor loop of the event
+ * \return where to write the descriptor loop, i_size bytes being available,
+ *         or NULL in the cases where dvbpsi_eit_schedule_add() fails.
+ *
+ * The descriptors are written by the dvbpsi_Encode*Dr() functions, one
+ * after the other, without allocating any descriptor, then the event is
+ * added by dvbpsi_eit_schedule_commit(). An event reserved and not
+ * committed is dropped by the next call.
+ */
+uint8_t *dvbpsi_eit_schedule_reserve(dvbpsi_eit_schedule_t *p_schedule,
+                                     const dvbpsi_eit_event_t *p_event, size_t i_size);
+
+/*****************************************************************************
+ * dvbpsi_eit_schedule_commit
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_eit_schedule_commit(dvbpsi_eit_schedule_t *p_schedule,
+ *                                     size_t i_length)
+ * \brief Adds the event started by dvbpsi_eit_schedule_reserve()
+ * \param p_schedule pointer to the generator
+ * \param i_length size of the descriptor loop written, at most the size
+ *        reserved
+ * \return false if no event is reserved or i_length is too large, true
+ *         otherwise.
+ */
+bool dvbpsi_eit_schedule_commit(dvbpsi_eit_schedule_t *p_schedule, size_t i_length);
+
+/*****************************************************************************
+ * dvbpsi_eit_schedule_finish
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_eit_schedule_finish(dvbpsi_eit_schedule_t *p_schedule)
+ * \brief Completes the remaining segments of a schedule and hands them to
+ * the callback. No event can be added afterwards.
+ * \param p_schedule pointer to the generator
+ * \return false on error, true otherwise.
+ */
+bool dvbpsi_eit_schedule_finish(dvbpsi_eit_schedule_t *p_schedule);
+
+/*****************************************************************************
+ * dvbpsi_eit_schedule_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_eit_schedule_delete(dvbpsi_eit_schedule_t *p_schedule)
+ * \brief Deletes a generator. Segments not yet completed are lost.
+ * \param p_schedule pointer to the generator
+ * \return nothing
+ */
+void dvbpsi_eit_schedule_delete(dvbpsi_eit_schedule_t *p_schedule);
+
+/*****************************************************************************
+ * dvbpsi_eit_section_iter
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_eit_section_iter(dvbpsi_psi_section_t *p_section,
+ *                                  dvbpsi_entry_iter_t *p_events)
+ * \brief Iterates over a EIT section without decoding it
+ * \param p_section EIT section
+ * \param p_events set up for the events
+ * \return false if the section is too short for an EIT section.
+ *
+ * An event header is the 12 bytes from event_id to
+ * descriptors_loop_length.
+ */
+bool dvbpsi_eit_section_iter(dvbpsi_psi_section_t *p_section,
+                             dvbpsi_entry_iter_t *p_events);
+
 #ifdef __cplusplus
 };
 #endif
@@ -45,6 +45,19 @@ typedef struct dvbpsi_eit_decoder_s
 
     uint8_t                       i_first_received_section_number;
 
+    /* Sections received and expected per segment of the building table,
+       one bit per section */
+    dvbpsi_eit_callback           pf_segment_callback;
+    void *                        p_segment_cb_data;
+    uint8_t                       pi_segment_received[32];
+    uint8_t                       pi_segment_expected[32];
+    uint32_t                      i_segments_signalled;
+
+    /* Version to resume from, see dvbpsi_eit_restore() */
+    bool                          b_restored;
+    uint8_t                       i_restored_version;
+    uint32_t                      i_restored_segments;
+
 } dvbpsi_eit_decoder_t;
 
 /*****************************************************************************
@@ -0,0 +1,226 @@
+/*****************************************************************************
+ * mpe.c: MPE decoder
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+
+#include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_TABLE
+#include "../dvbpsi_private.h"
+#include "../psi.h"
+#include "mpe.h"
+#include "mpe_private.h"
+
+/*****************************************************************************
+ * dvbpsi_mpe_attach
+ *****************************************************************************
+ * Initialize an MPE decoder and return a handle on it.
+ *****************************************************************************/
+bool dvbpsi_mpe_attach(dvbpsi_t *p_dvbpsi, unsigned int i_batch,
+                       dvbpsi_mpe_callback pf_callback, void* p_cb_data)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder == NULL);
+    assert(pf_callback);
+
+    if (i_batch == 0 || i_batch > DVBPSI_MPE_BATCH_MAX)
+    {
+        dvbpsi_error(p_dvbpsi, "MPE decoder",
+                     "invalid batch of %u datagrams", i_batch);
+        return false;
+    }
+
+    /* PSI decoder configuration and initial state */
+    dvbpsi_mpe_decoder_t *p_mpe_decoder;
+    p_mpe_decoder = (dvbpsi_mpe_decoder_t*) dvbpsi_decoder_new(&dvbpsi_mpe_sections_gather,
+                                                4096, true, sizeof(dvbpsi_mpe_decoder_t));
+    if (p_mpe_decoder == NULL)
+        return false;
+
+    /* MPE decoder information */
+    p_mpe_decoder->pf_callback = pf_callback;
+    p_mpe_decoder->p_cb_data = p_cb_data;
+    p_mpe_decoder->i_batch = i_batch;
+    p_mpe_decoder->i_count = 0;
+    memset(&p_mpe_decoder->stats, 0, sizeof(dvbpsi_mpe_stats_t));
+
+    p_dvbpsi->p_decoder = DVBPSI_DECODER(p_mpe_decoder);
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_mpe_deliver
+ *****************************************************************************
+ * Gives the batch to the callback and the sections back to their pool.
+ *****************************************************************************/
+static void dvbpsi_mpe_deliver(dvbpsi_mpe_decoder_t *p_mpe_decoder)
+{
+    unsigned int i_count = p_mpe_decoder->i_count;
+    if (i_count == 0)
+        return;
+
+    p_mpe_decoder->stats.i_batches++;
+    p_mpe_decoder->stats.i_datagrams += i_count;
+    p_mpe_decoder->pf_callback(p_mpe_decoder->p_cb_data,
+                               p_mpe_decoder->datagrams, i_count);
+
+    for (unsigned int i = 0; i < i_count; i++)
+    {
+        dvbpsi_DeletePSISections(p_mpe_decoder->pp_sections[i]);
+        p_mpe_decoder->pp_sections[i] = NULL;
+    }
+    p_mpe_decoder->i_count = 0;
+}
+
+/*****************************************************************************
+ * dvbpsi_mpe_detach
+ *****************************************************************************
+ * Close an MPE decoder. The handle isn't valid any more.
+ *****************************************************************************/
+void dvbpsi_mpe_detach(dvbpsi_t *p_dvbpsi)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    dvbpsi_mpe_decoder_t* p_mpe_decoder = (dvbpsi_mpe_decoder_t*)p_dvbpsi->p_decoder;
+    dvbpsi_mpe_deliver(p_mpe_decoder);
+
+    dvbpsi_decoder_delete(p_dvbpsi->p_decoder);
+    p_dvbpsi->p_decoder = NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_mpe_flush
+ *****************************************************************************/
+void dvbpsi_mpe_flush(dvbpsi_t *p_dvbpsi)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    dvbpsi_mpe_deliver((dvbpsi_mpe_decoder_t *)p_dvbpsi->p_decoder);
+}
+
+/*****************************************************************************
+ * dvbpsi_mpe_get_stats
+ *****************************************************************************/
+void dvbpsi_mpe_get_stats(dvbpsi_t *p_dvbpsi, dvbpsi_mpe_stats_t *p_stats)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+    assert(p_stats);
+
+    *p_stats = ((dvbpsi_mpe_decoder_t *)p_dvbpsi->p_decoder)->stats;
+}
+
+/*****************************************************************************
+ * dvbpsi_mpe_datagram_size
+ *****************************************************************************
+ * Size of an IP datagram from its header, the stuffing which may follow it
+ * excluded, or i_size if unknown.
+ *****************************************************************************/
+static size_t dvbpsi_mpe_datagram_size(const uint8_t *p_data, size_t i_size)
+{
+    size_t i_datagram = i_size;
+    if (i_size >= 20 && (p_data[0] >> 4) == 4)
+        i_datagram = ((size_t)p_data[2] << 8) | p_data[3];
+    else if (i_size >= 40 && (p_data[0] >> 4) == 6)
+        i_datagram = 40 + (((size_t)p_data[4] << 8) | p_data[5]);
+    return i_datagram <= i_size ? i_datagram : i_size;
+}
+
+/*****************************************************************************
+ * dvbpsi_mpe_sections_gather
+ *****************************************************************************
+ * Callback for the PSI decoder.
+ *****************************************************************************/
+void dvbpsi_mpe_sections_gather(dvbpsi_t* p_dvbpsi, dvbpsi_psi_section_t* p_section)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    dvbpsi_mpe_decoder_t *p_mpe_decoder = (dvbpsi_mpe_decoder_t *)p_dvbpsi->p_decoder;
+
+    /* MAC address, flags, section numbers and CRC_32 or checksum, read from
+     * the bytes as a checksum leaves the header fields of the section unset */
+    const uint8_t *p_byte = p_section->p_data;
+    if (p_byte[0] != 0x3e || p_section->i_length + 3 < 12 + 4)
+    {
+        dvbpsi_debug(p_dvbpsi, "MPE decoder",
+                     "ignoring section (table_id == 0x%02x)", p_byte[0]);
+        p_mpe_decoder->stats.i_invalid++;
+        dvbpsi_DeletePSISections(p_section);
+        return;
+    }
+    if (p_byte[6] != 0 || p_byte[7] != 0)
+    {
+        p_mpe_decoder->stats.i_fragmented++;
+        dvbpsi_DeletePSISections(p_section);
+        return;
+    }
+    p_mpe_decoder->b_discontinuity = false;
+
+    /* The section has to outlive the TS packet for a batch */
+    if (p_section->b_borrowed && p_mpe_decoder->i_batch > 1)
+    {
+        p_section = dvbpsi_section_pool_copy(p_section);
+        if (p_section == NULL)
+            return;
+        p_mpe_decoder->stats.i_copied++;
+        p_byte = p_section->p_data;
+    }
+
+    dvbpsi_mpe_datagram_t *p_datagram = &p_mpe_decoder->datagrams[p_mpe_decoder->i_count];
+    p_datagram->i_mac[0] = p_byte[11];
+    p_datagram->i_mac[1] = p_byte[10];
+    p_datagram->i_mac[2] = p_byte[9];
+    p_datagram->i_mac[3] = p_byte[8];
+    p_datagram->i_mac[4] = p_byte[4];
+    p_datagram->i_mac[5] = p_byte[3];
+    p_datagram->i_payload_scrambling = (p_byte[5] >> 4) & 0x03;
+    p_datagram->i_address_scrambling = (p_byte[5] >> 2) & 0x03;
+    p_datagram->b_llc_snap = p_byte[5] & 0x02;
+    p_datagram->p_data = p_byte + 12;
+    p_datagram->i_size = p_section->i_length + 3 - 12 - 4;
+    if (!p_datagram->b_llc_snap && p_datagram->i_payload_scrambling == 0)
+        p_datagram->i_size = dvbpsi_mpe_datagram_size(p_datagram->p_data,
+                                                      p_datagram->i_size);
+    p_datagram->i_arrival = p_section->i_arrival;
+    p_mpe_decoder->pp_sections[p_mpe_decoder->i_count++] = p_section;
+    p_mpe_decoder->stats.i_bytes += p_datagram->i_size;
+
+    if (p_mpe_decoder->i_count == p_mpe_decoder->i_batch)
+        dvbpsi_mpe_deliver(p_mpe_decoder);
+}
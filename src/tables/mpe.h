@@ -0,0 +1,179 @@
+/*****************************************************************************
+ * mpe.h
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <mpe.h>
+ * \brief Application interface for the MPE decoder.
+ *
+ * Application interface for the multiprotocol encapsulation decoder,
+ * ETSI EN 301 192 section 7. The datagram_sections (table_id 0x3E) of a PID
+ * are given to the application as views on the MAC address and the
+ * datagram they carry, in batches, without copying the datagrams out of
+ * the sections assembled by the handle.
+ */
+
+#ifndef _DVBPSI_MPE_H_
+#define _DVBPSI_MPE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \def DVBPSI_MPE_BATCH_MAX
+ * \brief Maximum number of datagrams of a batch, the number of sections the
+ * section pool of a handle recycles.
+ */
+#define DVBPSI_MPE_BATCH_MAX 32
+
+/*****************************************************************************
+ * dvbpsi_mpe_datagram_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_mpe_datagram_s
+ * \brief Datagram of a datagram_section.
+ */
+/*!
+ * \typedef struct dvbpsi_mpe_datagram_s dvbpsi_mpe_datagram_t
+ * \brief dvbpsi_mpe_datagram_t type definition.
+ */
+typedef struct dvbpsi_mpe_datagram_s
+{
+    uint8_t         i_mac[6];               /*!< MAC_address, most
+                                                 significant byte first */
+    uint8_t         i_payload_scrambling;   /*!< payload_scrambling_control */
+    uint8_t         i_address_scrambling;   /*!< address_scrambling_control */
+    bool            b_llc_snap;             /*!< LLC_SNAP_flag: p_data holds
+                                                 an LLC/SNAP structure rather
+                                                 than an IP datagram */
+    const uint8_t * p_data;                 /*!< datagram, in the section */
+    size_t          i_size;                 /*!< bytes of the datagram, the
+                                                 stuffing excluded */
+    int64_t         i_arrival;              /*!< arrival time of the section */
+} dvbpsi_mpe_datagram_t;
+
+/*****************************************************************************
+ * dvbpsi_mpe_stats_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_mpe_stats_s
+ * \brief Counters of an MPE decoder.
+ */
+/*!
+ * \typedef struct dvbpsi_mpe_stats_s dvbpsi_mpe_stats_t
+ * \brief dvbpsi_mpe_stats_t type definition.
+ */
+typedef struct dvbpsi_mpe_stats_s
+{
+    uint64_t    i_datagrams;    /*!< datagrams given to the callback */
+    uint64_t    i_batches;      /*!< calls of the callback */
+    uint64_t    i_bytes;        /*!< bytes of the datagrams */
+    uint64_t    i_fragmented;   /*!< sections of datagrams split over several
+                                     sections, dropped */
+    uint64_t    i_invalid;      /*!< sections too short or of another
+                                     table_id */
+    uint64_t    i_copied;       /*!< sections copied out of their TS packet to
+                                     wait for the end of their batch */
+} dvbpsi_mpe_stats_t;
+
+/*****************************************************************************
+ * dvbpsi_mpe_callback
+ *****************************************************************************/
+/*!
+ * \typedef void (* dvbpsi_mpe_callback)(void* p_cb_data,
+ *                                       const dvbpsi_mpe_datagram_t *p_datagrams,
+ *                                       unsigned int i_count)
+ * \brief Callback type definition, the datagrams being only valid during
+ * the call.
+ */
+typedef void (* dvbpsi_mpe_callback)(void* p_cb_data,
+                                     const dvbpsi_mpe_datagram_t *p_datagrams,
+                                     unsigned int i_count);
+
+/*****************************************************************************
+ * dvbpsi_mpe_attach
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_mpe_attach(dvbpsi_t *p_dvbpsi, unsigned int i_batch,
+ *                            dvbpsi_mpe_callback pf_callback, void* p_cb_data)
+ * \brief Creation and initialization of an MPE decoder. The decoder will be
+ * attached to 'p_dvbpsi' argument.
+ * \param p_dvbpsi handle to dvbpsi without attached decoder
+ * \param i_batch number of datagrams given to each callback, from 1 to
+ *        DVBPSI_MPE_BATCH_MAX
+ * \param pf_callback function to call back with the datagrams
+ * \param p_cb_data private data given in argument to the callback
+ * \return true on success, false on failure
+ *
+ * The datagrams point into the sections of the handle, kept until the end
+ * of their batch and then recycled by its section pool. With
+ * DVBPSI_FLAG_ZERO_COPY and a batch of 1, a section held by one TS packet
+ * is given straight from the packet; with larger batches it is copied once
+ * into a pooled section. A partial batch is given by dvbpsi_mpe_flush(),
+ * e.g. after each dvbpsi_packets_push(). The datagrams fragmented over
+ * several sections are not reassembled.
+ */
+bool dvbpsi_mpe_attach(dvbpsi_t *p_dvbpsi, unsigned int i_batch,
+                       dvbpsi_mpe_callback pf_callback, void* p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_mpe_detach
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_mpe_detach(dvbpsi_t *p_dvbpsi)
+ * \brief Destroy an MPE decoder, after giving the datagrams of its partial
+ * batch.
+ * \param p_dvbpsi handle to dvbpsi with attached MPE decoder
+ * \return nothing.
+ */
+void dvbpsi_mpe_detach(dvbpsi_t *p_dvbpsi);
+
+/*****************************************************************************
+ * dvbpsi_mpe_flush
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_mpe_flush(dvbpsi_t *p_dvbpsi)
+ * \brief Gives the datagrams of the partial batch of an MPE decoder to its
+ * callback, if any.
+ * \param p_dvbpsi handle to dvbpsi with attached MPE decoder
+ * \return nothing.
+ */
+void dvbpsi_mpe_flush(dvbpsi_t *p_dvbpsi);
+
+/*****************************************************************************
+ * dvbpsi_mpe_get_stats
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_mpe_get_stats(dvbpsi_t *p_dvbpsi, dvbpsi_mpe_stats_t *p_stats)
+ * \brief Gets the counters of an MPE decoder.
+ * \param p_dvbpsi handle to dvbpsi with attached MPE decoder
+ * \param p_stats receives the counters
+ * \return nothing.
+ */
+void dvbpsi_mpe_get_stats(dvbpsi_t *p_dvbpsi, dvbpsi_mpe_stats_t *p_stats);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of mpe.h"
+#endif
@@ -0,0 +1,59 @@
+/*****************************************************************************
+ * mpe_private.h: private MPE structures
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#ifndef _DVBPSI_MPE_PRIVATE_H_
+#define _DVBPSI_MPE_PRIVATE_H_
+
+/*****************************************************************************
+ * dvbpsi_mpe_decoder_t
+ *****************************************************************************
+ * MPE decoder.
+ *****************************************************************************/
+typedef struct dvbpsi_mpe_decoder_s
+{
+    DVBPSI_DECODER_COMMON
+
+    dvbpsi_mpe_callback           pf_callback;
+    void *                        p_cb_data;
+
+    /* Batch being filled, each datagram pointing into its section */
+    unsigned int                  i_batch;
+    unsigned int                  i_count;
+    dvbpsi_psi_section_t *        pp_sections[DVBPSI_MPE_BATCH_MAX];
+    dvbpsi_mpe_datagram_t         datagrams[DVBPSI_MPE_BATCH_MAX];
+
+    dvbpsi_mpe_stats_t            stats;
+
+} dvbpsi_mpe_decoder_t;
+
+/*****************************************************************************
+ * dvbpsi_mpe_sections_gather
+ *****************************************************************************
+ * Callback for the PSI decoder.
+ *****************************************************************************/
+void dvbpsi_mpe_sections_gather(dvbpsi_t* p_dvbpsi, dvbpsi_psi_section_t* p_section);
+
+#else
+#error "Multiple inclusions of mpe_private.h"
+#endif
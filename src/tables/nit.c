@@ -43,12 +43,15 @@
 #include <assert.h>
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_TABLE
 #include "../dvbpsi_private.h"
 #include "../psi.h"
 #include "../descriptor.h"
 #include "../demux.h"
 #include "nit.h"
 #include "nit_private.h"
+#include "ts_index.h"
+#include "ts_index_private.h"
 
 /*****************************************************************************
  * dvbpsi_nit_attach
@@ -126,12 +129,37 @@ void dvbpsi_nit_detach(dvbpsi_t * p_dvbpsi, uint8_t i_table_id, uint16_t i_exten
     if (p_nit_decoder->p_building_nit)
         dvbpsi_nit_delete(p_nit_decoder->p_building_nit);
     p_nit_decoder->p_building_nit = NULL;
+    dvbpsi_delta_reset(&p_nit_decoder->summary);
 
     /* Free demux sub table decoder */
     dvbpsi_DetachDemuxSubDecoder(p_demux, p_subdec);
     dvbpsi_DeleteDemuxSubDecoder(p_subdec);
 }
 
+/*****************************************************************************
+ * dvbpsi_nit_set_delta_callback
+ *****************************************************************************
+ * Set the function reporting the changes of each new NIT.
+ *****************************************************************************/
+bool dvbpsi_nit_set_delta_callback(dvbpsi_t *p_dvbpsi,
+                                   uint8_t i_table_id, uint16_t i_extension,
+                                   dvbpsi_nit_delta_callback pf_callback,
+                                   void* p_cb_data)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    dvbpsi_demux_t *p_demux = (dvbpsi_demux_t *) p_dvbpsi->p_decoder;
+    dvbpsi_demux_subdec_t* p_subdec = dvbpsi_demuxGetSubDec(p_demux, i_table_id, i_extension);
+    if (p_subdec == NULL)
+        return false;
+
+    dvbpsi_nit_decoder_t* p_nit_decoder = (dvbpsi_nit_decoder_t*)p_subdec->p_decoder;
+    p_nit_decoder->pf_delta_callback = pf_callback;
+    p_nit_decoder->p_delta_cb_data = p_cb_data;
+    return true;
+}
+
 /****************************************************************************
  * dvbpsi_nit_init
  *****************************************************************************
@@ -147,7 +175,12 @@ void dvbpsi_nit_init(dvbpsi_nit_t* p_nit, uint8_t i_table_id, uint16_t i_extensi
     p_nit->i_version = i_version;
     p_nit->b_current_next = b_current_next;
     p_nit->p_first_descriptor = NULL;
+    p_nit->p_last_descriptor = NULL;
     p_nit->p_first_ts = NULL;
+    p_nit->p_last_ts = NULL;
+    p_nit->p_arena = NULL;
+    p_nit->p_index = NULL;
+    p_nit->p_sections = NULL;
 }
 
 /****************************************************************************
@@ -159,7 +192,7 @@ dvbpsi_nit_t *dvbpsi_nit_new(uint8_t i_table_id, uint16_t i_extension,
                              uint16_t i_network_id, uint8_t i_version,
                              bool b_current_next)
 {
-    dvbpsi_nit_t*p_nit = (dvbpsi_nit_t*)malloc(sizeof(dvbpsi_nit_t));
+    dvbpsi_nit_t*p_nit = (dvbpsi_nit_t*)dvbpsi_malloc(sizeof(dvbpsi_nit_t));
     if (p_nit != NULL)
        dvbpsi_nit_init(p_nit, i_table_id, i_extension, i_network_id,
                        i_version, b_current_next);
@@ -173,20 +206,31 @@ dvbpsi_nit_t *dvbpsi_nit_new(uint8_t i_table_id, uint16_t i_extension,
  *****************************************************************************/
 void dvbpsi_nit_empty(dvbpsi_nit_t* p_nit)
 {
+    dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(p_nit->p_arena);
     dvbpsi_nit_ts_t* p_ts = p_nit->p_first_ts;
 
+    dvbpsi_ts_index_delete(p_nit->p_index);
+    p_nit->p_index = NULL;
+
     dvbpsi_DeleteDescriptors(p_nit->p_first_descriptor);
 
     while (p_ts != NULL)
     {
         dvbpsi_nit_ts_t* p_tmp = p_ts->p_next;
         dvbpsi_DeleteDescriptors(p_ts->p_first_descriptor);
-        free(p_ts);
+        dvbpsi_free(p_ts);
         p_ts = p_tmp;
     }
 
     p_nit->p_first_descriptor = NULL;
+    p_nit->p_last_descriptor = NULL;
     p_nit->p_first_ts = NULL;
+    p_nit->p_last_ts = NULL;
+
+    dvbpsi_arena_leave(p_previous);
+
+    dvbpsi_DeletePSISections(p_nit->p_sections);
+    p_nit->p_sections = NULL;
 }
 
 /****************************************************************************
@@ -196,9 +240,150 @@ void dvbpsi_nit_empty(dvbpsi_nit_t* p_nit)
  *****************************************************************************/
 void dvbpsi_nit_delete(dvbpsi_nit_t *p_nit)
 {
-    if (p_nit)
-        dvbpsi_nit_empty(p_nit);
-    free(p_nit);
+    if (p_nit == NULL)
+        return;
+
+    dvbpsi_arena_t *p_arena = p_nit->p_arena;
+    dvbpsi_nit_empty(p_nit);
+    if (p_arena)
+        dvbpsi_arena_delete(p_arena);
+    else
+        dvbpsi_free(p_nit);
+}
+
+/*****************************************************************************
+ * dvbpsi_nit_decode
+ *****************************************************************************
+ * Decode the raw sections of a NIT delivered with DVBPSI_FLAG_LAZY_DECODE.
+ *****************************************************************************/
+void dvbpsi_nit_decode(dvbpsi_nit_t *p_nit)
+{
+    dvbpsi_nit_decode_step(p_nit, SIZE_MAX);
+}
+
+/*****************************************************************************
+ * dvbpsi_nit_decode_step
+ *****************************************************************************
+ * Decode the first raw sections of a NIT, at least one and up to i_budget
+ * bytes, and release them.
+ *****************************************************************************/
+bool dvbpsi_nit_decode_step(dvbpsi_nit_t *p_nit, size_t i_budget)
+{
+    assert(p_nit);
+
+    if (p_nit->p_sections == NULL)
+        return true;
+
+    dvbpsi_psi_section_t *p_first = p_nit->p_sections;
+    dvbpsi_psi_section_t *p_last = p_first;
+    size_t i_size = p_first->p_payload_end - p_first->p_data;
+    while (p_last->p_next)
+    {
+        size_t i_next = p_last->p_next->p_payload_end - p_last->p_next->p_data;
+        if (i_next > i_budget || i_size > i_budget - i_next)
+            break;
+        i_size += i_next;
+        p_last = p_last->p_next;
+    }
+    p_nit->p_sections = p_last->p_next;
+    p_last->p_next = NULL;
+
+    dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(p_nit->p_arena);
+    dvbpsi_nit_sections_decode(p_nit, p_first);
+    dvbpsi_arena_leave(p_previous);
+
+    dvbpsi_DeletePSISections(p_first);
+    return p_nit->p_sections == NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_nit_index
+ *****************************************************************************
+ * Index the transport streams and services of a NIT.
+ *****************************************************************************/
+bool dvbpsi_nit_index(dvbpsi_nit_t *p_nit)
+{
+    assert(p_nit);
+
+    dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(p_nit->p_arena);
+    dvbpsi_ts_index_delete(p_nit->p_index);
+
+    size_t i_ts = 0, i_services = 0;
+    for (dvbpsi_nit_ts_t *p_ts = p_nit->p_first_ts; p_ts; p_ts = p_ts->p_next, i_ts++)
+        i_services += dvbpsi_ts_index_count(p_ts->p_first_descriptor);
+
+    p_nit->p_index = dvbpsi_ts_index_new(i_ts, i_services);
+    if (p_nit->p_index)
+    {
+        for (dvbpsi_nit_ts_t *p_ts = p_nit->p_first_ts; p_ts; p_ts = p_ts->p_next)
+            dvbpsi_ts_index_add(p_nit->p_index, p_ts->i_orig_network_id, p_ts->i_ts_id,
+                                p_ts, p_ts->p_first_descriptor);
+    }
+    dvbpsi_arena_leave(p_previous);
+
+    return p_nit->p_index != NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_nit_ts_find
+ *****************************************************************************
+ * Find a transport stream of a NIT, through its index if any.
+ *****************************************************************************/
+dvbpsi_nit_ts_t *dvbpsi_nit_ts_find(dvbpsi_nit_t *p_nit, uint16_t i_orig_network_id,
+                                    uint16_t i_ts_id, dvbpsi_descriptor_t **pp_delivery)
+{
+    assert(p_nit);
+
+    if (p_nit->p_index)
+        return dvbpsi_ts_index_find_ts(p_nit->p_index, i_orig_network_id, i_ts_id,
+                                       pp_delivery);
+
+    /* A transport stream split across sections is in the loop once per
+       section, its first entry standing for all */
+    dvbpsi_nit_ts_t *p_found = NULL;
+    if (pp_delivery)
+        *pp_delivery = NULL;
+    for (dvbpsi_nit_ts_t *p_ts = p_nit->p_first_ts; p_ts; p_ts = p_ts->p_next)
+    {
+        if (p_ts->i_orig_network_id != i_orig_network_id || p_ts->i_ts_id != i_ts_id)
+            continue;
+        if (p_found == NULL)
+            p_found = p_ts;
+        if (pp_delivery == NULL)
+            break;
+        if ((*pp_delivery = dvbpsi_ts_delivery(p_ts->p_first_descriptor)) != NULL)
+            break;
+    }
+    return p_found;
+}
+
+/*****************************************************************************
+ * dvbpsi_nit_service_find
+ *****************************************************************************
+ * Find a service of the transport streams of a NIT, through its index if
+ * any.
+ *****************************************************************************/
+bool dvbpsi_nit_service_find(dvbpsi_nit_t *p_nit, uint16_t i_orig_network_id,
+                             uint16_t i_service_id, dvbpsi_ts_service_t *p_service)
+{
+    assert(p_nit);
+    assert(p_service);
+
+    if (p_nit->p_index)
+        return dvbpsi_ts_index_find_service(p_nit->p_index, i_orig_network_id,
+                                            i_service_id, p_service);
+
+    bool b_found = false;
+    memset(p_service, 0, sizeof(dvbpsi_ts_service_t));
+    for (dvbpsi_nit_ts_t *p_ts = p_nit->p_first_ts; p_ts; p_ts = p_ts->p_next)
+    {
+        if (p_ts->i_orig_network_id == i_orig_network_id
+         && (!b_found || p_ts->i_ts_id == p_service->i_ts_id)
+         && dvbpsi_ts_service(i_orig_network_id, p_ts->i_ts_id, p_ts->p_first_descriptor,
+                              i_service_id, p_service))
+            b_found = true;
+    }
+    return b_found;
 }
 
 /*****************************************************************************
@@ -215,15 +400,7 @@ dvbpsi_descriptor_t* dvbpsi_nit_descriptor_add(dvbpsi_nit_t* p_nit,
     if (p_descriptor == NULL)
         return NULL;
 
-    if (p_nit->p_first_descriptor == NULL)
-        p_nit->p_first_descriptor = p_descriptor;
-    else
-    {
-        dvbpsi_descriptor_t* p_last_descriptor = p_nit->p_first_descriptor;
-        while(p_last_descriptor->p_next != NULL)
-            p_last_descriptor = p_last_descriptor->p_next;
-        p_last_descriptor->p_next = p_descriptor;
-    }
+    dvbpsi_list_append(p_nit->p_first_descriptor, p_nit->p_last_descriptor, p_descriptor);
     return p_descriptor;
 }
 
@@ -235,23 +412,23 @@ dvbpsi_descriptor_t* dvbpsi_nit_descriptor_add(dvbpsi_nit_t* p_nit,
 dvbpsi_nit_ts_t* dvbpsi_nit_ts_add(dvbpsi_nit_t* p_nit,
                                    uint16_t i_ts_id, uint16_t i_orig_network_id)
 {
-    dvbpsi_nit_ts_t* p_ts = (dvbpsi_nit_ts_t*)malloc(sizeof(dvbpsi_nit_ts_t));
+    dvbpsi_nit_ts_t* p_ts = (dvbpsi_nit_ts_t*)dvbpsi_malloc(sizeof(dvbpsi_nit_ts_t));
     if (p_ts == NULL)
         return NULL;
 
     p_ts->i_ts_id = i_ts_id;
     p_ts->i_orig_network_id = i_orig_network_id;
     p_ts->p_first_descriptor = NULL;
+    p_ts->p_last_descriptor = NULL;
     p_ts->p_next = NULL;
 
-    if (p_nit->p_first_ts == NULL)
-        p_nit->p_first_ts = p_ts;
-    else
+    dvbpsi_list_append(p_nit->p_first_ts, p_nit->p_last_ts, p_ts);
+
+    /* The index does not know the new transport stream */
+    if (p_nit->p_index)
     {
-        dvbpsi_nit_ts_t* p_last_ts = p_nit->p_first_ts;
-        while(p_last_ts->p_next != NULL)
-            p_last_ts = p_last_ts->p_next;
-        p_last_ts->p_next = p_ts;
+        dvbpsi_ts_index_delete(p_nit->p_index);
+        p_nit->p_index = NULL;
     }
     return p_ts;
 }
@@ -270,11 +447,7 @@ dvbpsi_descriptor_t* dvbpsi_nit_ts_descriptor_add(dvbpsi_nit_ts_t* p_ts,
     if (p_descriptor == NULL)
         return NULL;
 
-    p_ts->p_first_descriptor = dvbpsi_AddDescriptor(p_ts->p_first_descriptor,
-                                                    p_descriptor);
-    assert(p_ts->p_first_descriptor);
-    if (p_ts->p_first_descriptor == NULL)
-        return NULL;
+    dvbpsi_list_append(p_ts->p_first_descriptor, p_ts->p_last_descriptor, p_descriptor);
 
     return p_descriptor;
 }
@@ -335,9 +508,16 @@ static bool dvbpsi_AddSectionNIT(dvbpsi_t *p_dvbpsi, dvbpsi_nit_decoder_t *p_nit
     /* Initialize the structures if it's the first section received */
     if (p_nit_decoder->p_building_nit == NULL)
     {
+        dvbpsi_arena_t *p_arena = dvbpsi_arena_table_new(p_dvbpsi);
+        dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(p_arena);
         p_nit_decoder->p_building_nit = dvbpsi_nit_new(p_section->i_table_id,
                 p_section->i_extension, p_nit_decoder->i_network_id,
                 p_section->i_version, p_section->b_current_next);
+        dvbpsi_arena_leave(p_previous);
+        if (p_nit_decoder->p_building_nit)
+            p_nit_decoder->p_building_nit->p_arena = p_arena;
+        else
+            dvbpsi_arena_delete(p_arena);
         if (p_nit_decoder->p_building_nit == NULL)
             return false;
         p_nit_decoder->i_last_section_number = p_section->i_last_number;
@@ -351,6 +531,81 @@ static bool dvbpsi_AddSectionNIT(dvbpsi_t *p_dvbpsi, dvbpsi_nit_decoder_t *p_nit
     return true;
 }
 
+/*****************************************************************************
+ * dvbpsi_DecodeNITDescriptors
+ *****************************************************************************
+ * Decode the network and TS descriptors of the new NIT through the
+ * descriptor cache of the decoder, see DVBPSI_FLAG_DESCRIPTOR_CACHE.
+ *****************************************************************************/
+static void dvbpsi_DecodeNITDescriptors(dvbpsi_t *p_dvbpsi, dvbpsi_nit_decoder_t *p_nit_decoder)
+{
+    dvbpsi_nit_t *p_nit = p_nit_decoder->p_building_nit;
+    dvbpsi_dr_cache_decode(p_dvbpsi, DVBPSI_DECODER(p_nit_decoder),
+                           p_nit->p_first_descriptor);
+
+    dvbpsi_nit_ts_t *p_ts = p_nit->p_first_ts;
+    while (p_ts)
+    {
+        dvbpsi_dr_cache_decode(p_dvbpsi, DVBPSI_DECODER(p_nit_decoder),
+                               p_ts->p_first_descriptor);
+        p_ts = p_ts->p_next;
+    }
+    dvbpsi_dr_cache_trim(DVBPSI_DECODER(p_nit_decoder));
+}
+
+/*****************************************************************************
+ * dvbpsi_nit_delta
+ *****************************************************************************
+ * Compares the sections of a complete NIT with the summary of the previous
+ * one and calls the delta callback.
+ *****************************************************************************/
+static uint32_t dvbpsi_nit_delta_key(const uint8_t *p_header)
+{
+    /* original_network_id, then transport_stream_id */
+    return ((uint32_t)p_header[2] << 24) | ((uint32_t)p_header[3] << 16)
+         | ((uint32_t)p_header[0] << 8) | p_header[1];
+}
+
+static void dvbpsi_nit_delta(dvbpsi_t *p_dvbpsi, dvbpsi_nit_decoder_t *p_nit_decoder,
+                             dvbpsi_psi_section_t *p_section)
+{
+    bool b_first, b_descriptors;
+    unsigned int i_changes;
+    dvbpsi_delta_change_t *p_changes = dvbpsi_delta_compute(&p_nit_decoder->summary,
+                                            p_nit_decoder->p_sections,
+                                            dvbpsi_nit_section_iter, dvbpsi_nit_delta_key,
+                                            &b_first, &b_descriptors, &i_changes);
+    dvbpsi_nit_ts_delta_t *p_ts = NULL;
+    if (p_changes)
+        p_ts = dvbpsi_malloc((i_changes ? i_changes : 1) * sizeof(dvbpsi_nit_ts_delta_t));
+    if (p_ts == NULL)
+    {
+        dvbpsi_error(p_dvbpsi, "NIT decoder", "out of memory, no delta reported");
+        dvbpsi_free(p_changes);
+        dvbpsi_delta_reset(&p_nit_decoder->summary);
+        return;
+    }
+
+    for (unsigned int i = 0; i < i_changes; i++)
+    {
+        p_ts[i].i_change = p_changes[i].i_change;
+        p_ts[i].i_ts_id = p_changes[i].i_key & 0xffff;
+        p_ts[i].i_orig_network_id = p_changes[i].i_key >> 16;
+    }
+    dvbpsi_free(p_changes);
+
+    dvbpsi_nit_delta_t delta;
+    delta.b_first = b_first;
+    delta.b_descriptors = b_descriptors;
+    delta.i_ts = i_changes;
+    delta.p_ts = p_ts;
+
+    dvbpsi_probe_callback_entry("nit_delta", p_section->i_table_id, p_section->i_extension);
+    p_nit_decoder->pf_delta_callback(p_nit_decoder->p_delta_cb_data, &delta);
+    dvbpsi_probe_callback_exit("nit_delta", p_section->i_table_id, p_section->i_extension);
+    dvbpsi_free(p_ts);
+}
+
 /*****************************************************************************
  * dvbpsi_nit_sections_gather
  *****************************************************************************
@@ -406,6 +661,8 @@ void dvbpsi_nit_sections_gather(dvbpsi_t *p_dvbpsi,
                 && (p_nit_decoder->current_nit.b_current_next == p_section->b_current_next))
             {
                 /* Don't decode since this version is already decoded */
+                p_dvbpsi->stats.i_dropped_duplicate++;
+                dvbpsi_probe_dropped(p_section, "duplicate");
                 dvbpsi_debug(p_dvbpsi, "NIT decoder",
                              "ignoring already decoded section %d",
                              p_section->i_number);
@@ -427,18 +684,42 @@ void dvbpsi_nit_sections_gather(dvbpsi_t *p_dvbpsi,
     /* Check if we have all the sections */
     if (dvbpsi_decoder_psi_sections_completed(DVBPSI_DECODER(p_nit_decoder)))
     {
+        p_dvbpsi->stats.i_tables++;
         assert(p_nit_decoder->pf_nit_callback);
 
         /* Save the current information */
         p_nit_decoder->current_nit = *p_nit_decoder->p_building_nit;
         p_nit_decoder->b_current_valid = true;
+        if (p_nit_decoder->pf_delta_callback)
+            dvbpsi_nit_delta(p_dvbpsi, p_nit_decoder, p_section);
 
-        /* Decode the sections */
-        dvbpsi_nit_sections_decode(p_nit_decoder->p_building_nit,
-                                   p_nit_decoder->p_sections);
+        if (p_dvbpsi->i_flags & DVBPSI_FLAG_LAZY_DECODE)
+        {
+            /* Hand the sections over, they are decoded on request */
+            p_nit_decoder->p_building_nit->p_sections = p_nit_decoder->p_sections;
+            p_nit_decoder->p_sections = NULL;
+        }
+        else
+        {
+            /* Decode the sections, in the arena of the table if any */
+            dvbpsi_intern_t *p_intern = dvbpsi_intern_new(p_dvbpsi);
+            dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(p_nit_decoder->p_building_nit->p_arena);
+            dvbpsi_intern_t *p_previous_intern = dvbpsi_intern_enter(p_intern);
+            dvbpsi_nit_sections_decode(p_nit_decoder->p_building_nit,
+                                       p_nit_decoder->p_sections);
+            if (p_dvbpsi->i_flags & DVBPSI_FLAG_TABLE_INDEX)
+                dvbpsi_nit_index(p_nit_decoder->p_building_nit);
+            if (p_dvbpsi->i_flags & DVBPSI_FLAG_DESCRIPTOR_CACHE)
+                dvbpsi_DecodeNITDescriptors(p_dvbpsi, p_nit_decoder);
+            dvbpsi_intern_leave(p_previous_intern);
+            dvbpsi_arena_leave(p_previous);
+            dvbpsi_intern_delete(p_intern);
+        }
         /* signal the new NIT */
+        dvbpsi_probe_callback_entry("nit", p_section->i_table_id, p_section->i_extension);
         p_nit_decoder->pf_nit_callback(p_nit_decoder->p_cb_data,
                                        p_nit_decoder->p_building_nit);
+        dvbpsi_probe_callback_exit("nit", p_section->i_table_id, p_section->i_extension);
         /* Delete sections and Reinitialize the structures */
         dvbpsi_ReInitNIT(p_nit_decoder, false);
         assert(p_nit_decoder->p_sections == NULL);
@@ -461,6 +742,8 @@ void dvbpsi_nit_sections_decode(dvbpsi_nit_t* p_nit,
         p_byte = p_section->p_payload_start + 2;
         p_end = p_byte + (((uint16_t)(p_section->p_payload_start[0] & 0x0f) << 8)
                           | p_section->p_payload_start[1]);
+        if (p_end > p_section->p_payload_end)
+            p_end = p_section->p_payload_end;
 
         while (p_byte + 2 <= p_end)
         {
@@ -472,6 +755,11 @@ void dvbpsi_nit_sections_decode(dvbpsi_nit_t* p_nit,
         }
 
         /* Transport stream loop length */
+        if (p_byte + 2 > p_section->p_payload_end)
+        {
+            p_section = p_section->p_next;
+            continue;
+        }
         p_end = 2 + p_byte + (((uint16_t)(p_byte[0] & 0x0f) << 8) | p_byte[1]);
         if (p_end > p_section->p_payload_end)
             p_end = p_section->p_payload_end;
@@ -518,7 +806,7 @@ void dvbpsi_nit_sections_decode(dvbpsi_nit_t* p_nit,
 dvbpsi_psi_section_t* dvbpsi_nit_sections_generate(dvbpsi_t *p_dvbpsi,
                                             dvbpsi_nit_t* p_nit, uint8_t i_table_id)
 {
-    dvbpsi_psi_section_t* p_result = dvbpsi_NewPSISection(1024);
+    dvbpsi_psi_section_t* p_result = dvbpsi_section_buffer_get(p_dvbpsi, 1024);
     dvbpsi_psi_section_t* p_current = p_result;
     dvbpsi_psi_section_t* p_prev;
     dvbpsi_descriptor_t* p_descriptor = p_nit->p_first_descriptor;
@@ -556,7 +844,7 @@ dvbpsi_psi_section_t* dvbpsi_nit_sections_generate(dvbpsi_t *p_dvbpsi,
             p_current->p_payload_end += 2;
 
             p_prev = p_current;
-            p_current = dvbpsi_NewPSISection(1024);
+            p_current = dvbpsi_section_buffer_get(p_dvbpsi, 1024);
             p_prev->p_next = p_current;
 
             p_current->i_table_id = i_table_id;
@@ -604,7 +892,8 @@ dvbpsi_psi_section_t* dvbpsi_nit_sections_generate(dvbpsi_t *p_dvbpsi,
         /* Can the current section carry all the descriptors ? */
         p_descriptor = p_ts->p_first_descriptor;
         while(    (p_descriptor != NULL)
-               && ((p_ts_start - p_current->p_data) + i_ts_length <= 1020))
+               && ((p_ts_start - p_current->p_data) + i_ts_length
+                   + p_descriptor->i_length + 2 <= 1020))
         {
             i_ts_length += p_descriptor->i_length + 2;
             p_descriptor = p_descriptor->p_next;
@@ -627,7 +916,7 @@ dvbpsi_psi_section_t* dvbpsi_nit_sections_generate(dvbpsi_t *p_dvbpsi,
                                    "create a new section to carry more TS descriptors");
 
             p_prev = p_current;
-            p_current = dvbpsi_NewPSISection(1024);
+            p_current = dvbpsi_section_buffer_get(p_dvbpsi, 1024);
             p_prev->p_next = p_current;
 
             p_current->i_table_id = i_table_id;
@@ -710,3 +999,53 @@ dvbpsi_psi_section_t* dvbpsi_nit_sections_generate(dvbpsi_t *p_dvbpsi,
 
     return p_result;
 }
+
+/*****************************************************************************
+ * dvbpsi_nit_sections_generate_into
+ *****************************************************************************
+ * Generate NIT sections into a caller buffer.
+ *****************************************************************************/
+int dvbpsi_nit_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_nit_t *p_nit,
+                                      uint8_t i_table_id, dvbpsi_section_buffer_t *p_buffer)
+{
+    dvbpsi_section_buffer_begin(p_dvbpsi, p_buffer);
+    return dvbpsi_section_buffer_end(p_dvbpsi,
+                dvbpsi_nit_sections_generate(p_dvbpsi, p_nit, i_table_id));
+}
+
+/*****************************************************************************
+ * dvbpsi_nit_section_iter
+ *****************************************************************************
+ * Sets up iterators over the raw loops of a NIT section.
+ *****************************************************************************/
+bool dvbpsi_nit_section_iter(dvbpsi_psi_section_t *p_section,
+                             dvbpsi_descriptor_iter_t *p_descriptors,
+                             dvbpsi_entry_iter_t *p_ts)
+{
+    assert(p_section);
+
+    uint8_t *p_byte = p_section->p_payload_start;
+    uint8_t *p_end = p_section->p_payload_end;
+    if (p_end - p_byte < 2)
+        return false;
+
+    /* network descriptors */
+    size_t i_length = ((size_t)(p_byte[0] & 0x0f) << 8) | p_byte[1];
+    p_byte += 2;
+    if (i_length > (size_t)(p_end - p_byte))
+        i_length = p_end - p_byte;
+    if (p_descriptors)
+        dvbpsi_descriptor_iter_init(p_descriptors, p_byte, i_length);
+    p_byte += i_length;
+
+    /* transport_stream_loop */
+    if (p_end - p_byte < 2)
+        return false;
+    i_length = ((size_t)(p_byte[0] & 0x0f) << 8) | p_byte[1];
+    p_byte += 2;
+    if (i_length > (size_t)(p_end - p_byte))
+        i_length = p_end - p_byte;
+    if (p_ts)
+        dvbpsi_entry_iter_init(p_ts, p_byte, i_length, 6, 4);
+    return true;
+}
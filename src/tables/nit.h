@@ -60,6 +60,7 @@ typedef struct dvbpsi_nit_ts_s
   uint16_t                      i_orig_network_id;      /*!< original network id */
 
   dvbpsi_descriptor_t *         p_first_descriptor;     /*!< descriptor list */
+  dvbpsi_descriptor_t *         p_last_descriptor;      /*!< private, list tail */
 
   struct dvbpsi_nit_ts_s *      p_next;                 /*!< next element of
                                                              the list */
@@ -90,8 +91,13 @@ typedef struct dvbpsi_nit_s
     bool                 b_current_next;     /*!< current_next_indicator */
 
     dvbpsi_descriptor_t *p_first_descriptor; /*!< descriptor list */
+    dvbpsi_descriptor_t *p_last_descriptor;  /*!< private, list tail */
 
     dvbpsi_nit_ts_t *    p_first_ts;         /*!< TS list */
+    dvbpsi_nit_ts_t *    p_last_ts;          /*!< private, list tail */
+    struct dvbpsi_arena_s *p_arena;          /*!< private, see DVBPSI_FLAG_TABLE_ARENA */
+    struct dvbpsi_ts_index_s *p_index;       /*!< private, see DVBPSI_FLAG_TABLE_INDEX */
+    dvbpsi_psi_section_t *p_sections;        /*!< raw sections, see DVBPSI_FLAG_LAZY_DECODE */
 
 } dvbpsi_nit_t;
 
@@ -137,6 +143,89 @@ bool dvbpsi_nit_attach(dvbpsi_t* p_dvbpsi, uint8_t i_table_id, uint16_t i_extens
 void dvbpsi_nit_detach(dvbpsi_t* p_dvbpsi, uint8_t i_table_id,
                       uint16_t i_extension);
 
+/*****************************************************************************
+ * dvbpsi_nit_delta_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_nit_ts_delta_s
+ * \brief Change of a transport stream, identified by its transport_stream_id
+ * and original_network_id.
+ */
+/*!
+ * \typedef struct dvbpsi_nit_ts_delta_s dvbpsi_nit_ts_delta_t
+ * \brief dvbpsi_nit_ts_delta_t type definition.
+ */
+typedef struct dvbpsi_nit_ts_delta_s
+{
+    enum dvbpsi_entry_change  i_change;             /*!< kind of change */
+    uint16_t                  i_ts_id;              /*!< transport stream id */
+    uint16_t                  i_orig_network_id;    /*!< original network id */
+} dvbpsi_nit_ts_delta_t;
+
+/*!
+ * \struct dvbpsi_nit_delta_s
+ * \brief Changes of a NIT since the version previously decoded.
+ */
+/*!
+ * \typedef struct dvbpsi_nit_delta_s dvbpsi_nit_delta_t
+ * \brief dvbpsi_nit_delta_t type definition.
+ */
+typedef struct dvbpsi_nit_delta_s
+{
+    bool                         b_first;       /*!< no previous version, all
+                                                     the transport streams
+                                                     are added */
+    bool                         b_descriptors; /*!< the network descriptors
+                                                     changed */
+    unsigned int                 i_ts;          /*!< number of changed
+                                                     transport streams */
+    const dvbpsi_nit_ts_delta_t *p_ts;          /*!< changed transport
+                                                     streams, removed ones
+                                                     first */
+} dvbpsi_nit_delta_t;
+
+/*****************************************************************************
+ * dvbpsi_nit_delta_callback
+ *****************************************************************************/
+/*!
+ * \typedef void (* dvbpsi_nit_delta_callback)(void* p_cb_data,
+ *                                             const dvbpsi_nit_delta_t *p_delta)
+ * \brief Delta callback type definition, p_delta being only valid during
+ * the call.
+ */
+typedef void (* dvbpsi_nit_delta_callback)(void* p_cb_data,
+                                           const dvbpsi_nit_delta_t *p_delta);
+
+/*****************************************************************************
+ * dvbpsi_nit_set_delta_callback
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_nit_set_delta_callback(dvbpsi_t *p_dvbpsi,
+ *                                        uint8_t i_table_id, uint16_t i_extension,
+ *                                        dvbpsi_nit_delta_callback pf_callback,
+ *                                        void* p_cb_data)
+ * \brief Reports the changes of each new NIT of a decoder
+ * \param p_dvbpsi handle with a subtable demux
+ * \param i_table_id Table ID, 0x40 or 0x41.
+ * \param i_extension Table ID extension, here network ID.
+ * \param pf_callback function called right before the NIT callback, with
+ *        the changes of the new version, NULL for none
+ * \param p_cb_data private data given in argument to the callback
+ * \return false if there is no such NIT decoder, true otherwise.
+ *
+ * The decoder keeps, for the version it last signalled, a 64 bits hash of
+ * the network descriptors and of the bytes of each transport stream, sorted by
+ * original_network_id and transport_stream_id, and compares the raw
+ * sections of the new version against them. A transport stream is
+ * modified when any of its descriptors changed, a delivery system descriptor for instance. A version
+ * whose transport streams and network descriptors are all unchanged has an empty
+ * delta.
+ */
+bool dvbpsi_nit_set_delta_callback(dvbpsi_t *p_dvbpsi,
+                                   uint8_t i_table_id, uint16_t i_extension,
+                                   dvbpsi_nit_delta_callback pf_callback,
+                                   void* p_cb_data);
+
 /*****************************************************************************
  * dvbpsi_nit_init/dvbpsi_nit_new
  *****************************************************************************/
@@ -190,6 +279,106 @@ void dvbpsi_nit_empty(dvbpsi_nit_t* p_nit);
  */
 void dvbpsi_nit_delete(dvbpsi_nit_t *p_nit);
 
+/*****************************************************************************
+ * dvbpsi_nit_decode
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_nit_decode(dvbpsi_nit_t *p_nit)
+ * \brief Decodes the raw sections of a NIT received with DVBPSI_FLAG_LAZY_DECODE
+ * \param p_nit pointer to the NIT structure
+ * \return nothing.
+ *
+ * Decodes the descriptors and transport streams from dvbpsi_nit_t::p_sections
+ * and releases the sections. Does nothing when the NIT has no raw sections.
+ */
+void dvbpsi_nit_decode(dvbpsi_nit_t *p_nit);
+
+/*****************************************************************************
+ * dvbpsi_nit_decode_step
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_nit_decode_step(dvbpsi_nit_t *p_nit, size_t i_budget)
+ * \brief Decodes part of the raw sections of a NIT received with
+ *        DVBPSI_FLAG_LAZY_DECODE
+ * \param p_nit pointer to the NIT structure
+ * \param i_budget number of section bytes to decode at most, the first
+ *        section being decoded whatever its size
+ * \return true when all the sections are decoded, false otherwise.
+ *
+ * Does what dvbpsi_nit_decode() does in steps of whole sections, for an
+ * event loop to spread the decoding of a large NIT over several iterations
+ * between its packets. The lists are complete when it returns true.
+ */
+bool dvbpsi_nit_decode_step(dvbpsi_nit_t *p_nit, size_t i_budget);
+
+/*****************************************************************************
+ * dvbpsi_nit_index
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_nit_index(dvbpsi_nit_t *p_nit)
+ * \brief Builds the index of the transport streams and services of a NIT
+ * \param p_nit pointer to the NIT structure
+ * \return false on error, in which case the lookups walk the loop, true
+ *         otherwise.
+ *
+ * The decoder builds the index itself with DVBPSI_FLAG_TABLE_INDEX, but not
+ * dvbpsi_nit_decode(). The index reflects the transport streams and their
+ * descriptors at the time of the call: it is dropped by
+ * dvbpsi_nit_ts_add() and dvbpsi_nit_empty(), and must be built again
+ * after descriptors are added to a transport stream.
+ */
+bool dvbpsi_nit_index(dvbpsi_nit_t *p_nit);
+
+/*****************************************************************************
+ * dvbpsi_nit_ts_find
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_nit_ts_t *dvbpsi_nit_ts_find(dvbpsi_nit_t *p_nit,
+ *                                  uint16_t i_orig_network_id,
+ *                                  uint16_t i_ts_id,
+ *                                  dvbpsi_descriptor_t **pp_delivery)
+ * \brief Finds a transport stream of a NIT
+ * \param p_nit pointer to the NIT structure
+ * \param i_orig_network_id original_network_id
+ * \param i_ts_id transport_stream_id
+ * \param pp_delivery set to its first satellite, cable or terrestrial
+ *        delivery system descriptor (tag 0x43, 0x44 or 0x5a), NULL if none,
+ *        unless NULL
+ * \return the first transport stream of the loop with these identifiers, or
+ *         NULL if there is none.
+ *
+ * O(1) with an index, see dvbpsi_nit_index(), linear in the loop
+ * otherwise.
+ */
+dvbpsi_nit_ts_t *dvbpsi_nit_ts_find(dvbpsi_nit_t *p_nit, uint16_t i_orig_network_id,
+                                    uint16_t i_ts_id, dvbpsi_descriptor_t **pp_delivery);
+
+/*****************************************************************************
+ * dvbpsi_nit_service_find
+ *****************************************************************************/
+struct dvbpsi_ts_service_s; /* see tables/ts_index.h */
+
+/*!
+ * \fn bool dvbpsi_nit_service_find(dvbpsi_nit_t *p_nit,
+ *                                   uint16_t i_orig_network_id,
+ *                                   uint16_t i_service_id,
+ *                                   struct dvbpsi_ts_service_s *p_service)
+ * \brief Finds a service in the service list (tag 0x41) and logical channel
+ * (tag 0x83) descriptors of the transport streams of a NIT
+ * \param p_nit pointer to the NIT structure
+ * \param i_orig_network_id original_network_id
+ * \param i_service_id service_id
+ * \param p_service filled with the transport stream, service_type and
+ *        logical channel number of the service, see tables/ts_index.h
+ * \return true if the first transport stream of the loop that has the
+ *         service in one of these descriptors was found, false otherwise.
+ *
+ * O(1) with an index, see dvbpsi_nit_index(), linear in the loop
+ * otherwise.
+ */
+bool dvbpsi_nit_service_find(dvbpsi_nit_t *p_nit, uint16_t i_orig_network_id,
+                             uint16_t i_service_id, struct dvbpsi_ts_service_s *p_service);
+
 /*****************************************************************************
  * dvbpsi_nit_descriptor_add
  *****************************************************************************/
@@ -260,6 +449,46 @@ dvbpsi_descriptor_t* dvbpsi_nit_ts_descriptor_add(dvbpsi_nit_ts_t* p_ts,
 dvbpsi_psi_section_t* dvbpsi_nit_sections_generate(dvbpsi_t* p_dvbpsi, dvbpsi_nit_t* p_nit,
                                             uint8_t i_table_id);
 
+/*****************************************************************************
+ * dvbpsi_nit_sections_generate_into
+ *****************************************************************************/
+/*!
+ * \fn int dvbpsi_nit_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_nit_t *p_nit,
+ *                                          uint8_t i_table_id, dvbpsi_section_buffer_t *p_buffer)
+ * \brief NIT generator writing into caller memory
+ * \param p_dvbpsi handle to dvbpsi with attached decoder
+ * \param p_nit pointer to the NIT structure
+ * \param i_table_id table id, as for dvbpsi_nit_sections_generate()
+ * \param p_buffer buffer the sections are written into, its previous
+ *        sections are overwritten
+ * \return the number of sections written, linked from p_buffer->p_sections,
+ *         or -1 on error or if the buffer is too small.
+ *
+ * Same encoding as dvbpsi_nit_sections_generate(), without any allocation.
+ */
+int dvbpsi_nit_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_nit_t *p_nit,
+                                      uint8_t i_table_id, dvbpsi_section_buffer_t *p_buffer);
+
+/*****************************************************************************
+ * dvbpsi_nit_section_iter
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_nit_section_iter(dvbpsi_psi_section_t *p_section,
+ *                                  dvbpsi_descriptor_iter_t *p_descriptors,
+ *                                  dvbpsi_entry_iter_t *p_ts)
+ * \brief Iterates over a NIT section without decoding it
+ * \param p_section NIT section
+ * \param p_descriptors set up for the network descriptors, may be NULL
+ * \param p_ts set up for the transport streams, may be NULL
+ * \return false if the section is too short for a NIT section.
+ *
+ * A transport stream header is the 6 bytes holding transport_stream_id,
+ * original_network_id and transport_descriptors_length.
+ */
+bool dvbpsi_nit_section_iter(dvbpsi_psi_section_t *p_section,
+                             dvbpsi_descriptor_iter_t *p_descriptors,
+                             dvbpsi_entry_iter_t *p_ts);
+
 #ifdef __cplusplus
 };
 #endif
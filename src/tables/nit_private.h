@@ -45,6 +45,11 @@ typedef struct dvbpsi_nit_decoder_s
     dvbpsi_nit_t                  current_nit;
     dvbpsi_nit_t *                p_building_nit;
 
+    /* Summary of the last NIT signalled, for the delta callback */
+    dvbpsi_nit_delta_callback     pf_delta_callback;
+    void *                        p_delta_cb_data;
+    dvbpsi_delta_summary_t        summary;
+
     uint16_t                      i_network_id;
 
 } dvbpsi_nit_decoder_t;
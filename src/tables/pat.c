@@ -40,6 +40,7 @@
 #include <assert.h>
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_TABLE
 #include "../dvbpsi_private.h"
 #include "../psi.h"
 #include "pat.h"
@@ -66,6 +67,8 @@ bool dvbpsi_pat_attach(dvbpsi_t *p_dvbpsi, dvbpsi_pat_callback pf_callback,
     /* PAT decoder information */
     p_pat_decoder->pf_pat_callback = pf_callback;
     p_pat_decoder->p_cb_data = p_cb_data;
+    p_pat_decoder->pf_program_callback = NULL;
+    p_pat_decoder->p_program_cb_data = NULL;
     p_pat_decoder->p_building_pat = NULL;
 
     p_dvbpsi->p_decoder = DVBPSI_DECODER(p_pat_decoder);
@@ -86,11 +89,31 @@ void dvbpsi_pat_detach(dvbpsi_t *p_dvbpsi)
     if (p_pat_decoder->p_building_pat)
         dvbpsi_pat_delete(p_pat_decoder->p_building_pat);
     p_pat_decoder->p_building_pat = NULL;
+    if (p_pat_decoder->p_next_pat)
+        dvbpsi_pat_delete(p_pat_decoder->p_next_pat);
+    p_pat_decoder->p_next_pat = NULL;
 
     dvbpsi_decoder_delete(p_dvbpsi->p_decoder);
     p_dvbpsi->p_decoder = NULL;
 }
 
+/*****************************************************************************
+ * dvbpsi_pat_set_program_callback
+ *****************************************************************************
+ * Set the function signalling the programs of each section of a PAT decoder.
+ *****************************************************************************/
+void dvbpsi_pat_set_program_callback(dvbpsi_t *p_dvbpsi,
+                                     dvbpsi_pat_program_callback pf_callback,
+                                     void* p_cb_data)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    dvbpsi_pat_decoder_t* p_pat_decoder = (dvbpsi_pat_decoder_t*)p_dvbpsi->p_decoder;
+    p_pat_decoder->pf_program_callback = pf_callback;
+    p_pat_decoder->p_program_cb_data = p_cb_data;
+}
+
 /*****************************************************************************
  * dvbpsi_pat_init
  *****************************************************************************
@@ -105,6 +128,10 @@ void dvbpsi_pat_init(dvbpsi_pat_t* p_pat, uint16_t i_ts_id, uint8_t i_version,
     p_pat->i_version = i_version;
     p_pat->b_current_next = b_current_next;
     p_pat->p_first_program = NULL;
+    p_pat->p_last_program = NULL;
+    p_pat->i_program_count = 0;
+    p_pat->b_arrays = false;
+    p_pat->p_arena = NULL;
 }
 
 /*****************************************************************************
@@ -115,7 +142,7 @@ void dvbpsi_pat_init(dvbpsi_pat_t* p_pat, uint16_t i_ts_id, uint8_t i_version,
 dvbpsi_pat_t *dvbpsi_pat_new(uint16_t i_ts_id, uint8_t i_version,
                             bool b_current_next)
 {
-    dvbpsi_pat_t *p_pat = (dvbpsi_pat_t*)malloc(sizeof(dvbpsi_pat_t));
+    dvbpsi_pat_t *p_pat = (dvbpsi_pat_t*)dvbpsi_malloc(sizeof(dvbpsi_pat_t));
     if (p_pat)
         dvbpsi_pat_init(p_pat, i_ts_id, i_version, b_current_next);
     return p_pat;
@@ -128,15 +155,20 @@ dvbpsi_pat_t *dvbpsi_pat_new(uint16_t i_ts_id, uint8_t i_version,
  *****************************************************************************/
 void dvbpsi_pat_empty(dvbpsi_pat_t* p_pat)
 {
+    dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(p_pat->p_arena);
     dvbpsi_pat_program_t* p_program = p_pat->p_first_program;
 
     while(p_program != NULL)
     {
         dvbpsi_pat_program_t* p_tmp = p_program->p_next;
-        free(p_program);
+        dvbpsi_free(p_program);
         p_program = p_tmp;
     }
     p_pat->p_first_program = NULL;
+    p_pat->p_last_program = NULL;
+    p_pat->i_program_count = 0;
+
+    dvbpsi_arena_leave(p_previous);
 }
 
 /*****************************************************************************
@@ -146,9 +178,30 @@ void dvbpsi_pat_empty(dvbpsi_pat_t* p_pat)
  *****************************************************************************/
 void dvbpsi_pat_delete(dvbpsi_pat_t *p_pat)
 {
-    if (p_pat)
-        dvbpsi_pat_empty(p_pat);
-    free(p_pat);
+    if (p_pat == NULL)
+        return;
+
+    dvbpsi_arena_t *p_arena = p_pat->p_arena;
+    dvbpsi_pat_empty(p_pat);
+    if (p_arena)
+        dvbpsi_arena_delete(p_arena);
+    else
+        dvbpsi_free(p_pat);
+}
+
+/*****************************************************************************
+ * dvbpsi_pat_program_append
+ *****************************************************************************
+ * Set up a program and add it at the end of the PAT.
+ *****************************************************************************/
+static void dvbpsi_pat_program_append(dvbpsi_pat_t *p_pat, dvbpsi_pat_program_t *p_program,
+                                      uint16_t i_number, uint16_t i_pid)
+{
+    p_program->i_number = i_number;
+    p_program->i_pid = i_pid;
+    p_program->p_next = NULL;
+
+    dvbpsi_list_append(p_pat->p_first_program, p_pat->p_last_program, p_program);
 }
 
 /*****************************************************************************
@@ -166,25 +219,39 @@ dvbpsi_pat_program_t* dvbpsi_pat_program_add(dvbpsi_pat_t* p_pat,
     if (i_pid == 0)
         return NULL;
 
-    p_program = (dvbpsi_pat_program_t*) malloc(sizeof(dvbpsi_pat_program_t));
+    p_program = (dvbpsi_pat_program_t*) dvbpsi_malloc(sizeof(dvbpsi_pat_program_t));
     if (p_program == NULL)
         return NULL;
 
-    p_program->i_number = i_number;
-    p_program->i_pid = i_pid;
-    p_program->p_next = NULL;
+    dvbpsi_pat_program_append(p_pat, p_program, i_number, i_pid);
+    return p_program;
+}
 
-    if (p_pat->p_first_program == NULL)
-        p_pat->p_first_program = p_program;
-    else
+/*****************************************************************************
+ * dvbpsi_pat_table_new
+ *****************************************************************************
+ * New table of the decoder, in an arena of its own with
+ * DVBPSI_FLAG_TABLE_ARRAYS.
+ *****************************************************************************/
+static dvbpsi_pat_t *dvbpsi_pat_table_new(dvbpsi_t *p_dvbpsi, uint16_t i_ts_id,
+                                          uint8_t i_version, bool b_current_next)
+{
+    dvbpsi_arena_t *p_arena = NULL;
+    if (p_dvbpsi->i_flags & DVBPSI_FLAG_TABLE_ARRAYS)
+        p_arena = dvbpsi_arena_new();
+
+    dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(p_arena);
+    dvbpsi_pat_t *p_pat = dvbpsi_pat_new(i_ts_id, i_version, b_current_next);
+    dvbpsi_arena_leave(p_previous);
+    if (p_pat == NULL)
     {
-        dvbpsi_pat_program_t* p_last_program = p_pat->p_first_program;
-        while (p_last_program->p_next != NULL)
-            p_last_program = p_last_program->p_next;
-        p_last_program->p_next = p_program;
+        dvbpsi_arena_delete(p_arena);
+        return NULL;
     }
 
-    return p_program;
+    p_pat->p_arena = p_arena;
+    p_pat->b_arrays = p_arena != NULL;
+    return p_pat;
 }
 
 /* */
@@ -200,6 +267,9 @@ static void dvbpsi_ReInitPAT(dvbpsi_pat_decoder_t* p_decoder, const bool b_force
         /* Free structures */
         if (p_decoder->p_building_pat)
             dvbpsi_pat_delete(p_decoder->p_building_pat);
+        if (p_decoder->p_next_pat)
+            dvbpsi_pat_delete(p_decoder->p_next_pat);
+        p_decoder->p_next_pat = NULL;
     }
     p_decoder->p_building_pat = NULL;
 }
@@ -242,7 +312,7 @@ static bool dvbpsi_CheckPAT(dvbpsi_t *p_dvbpsi, dvbpsi_psi_section_t *p_section)
 }
 
 static bool dvbpsi_AddSectionPAT(dvbpsi_t *p_dvbpsi, dvbpsi_pat_decoder_t *p_pat_decoder,
-                                 dvbpsi_psi_section_t* p_section)
+                                 dvbpsi_psi_section_t* p_section, bool *pb_complete)
 {
     assert(p_dvbpsi);
     assert(p_pat_decoder);
@@ -251,7 +321,7 @@ static bool dvbpsi_AddSectionPAT(dvbpsi_t *p_dvbpsi, dvbpsi_pat_decoder_t *p_pat
     /* Initialize the structures if it's the first section received */
     if (p_pat_decoder->p_building_pat == NULL)
     {
-        p_pat_decoder->p_building_pat = dvbpsi_pat_new(p_section->i_extension,
+        p_pat_decoder->p_building_pat = dvbpsi_pat_table_new(p_dvbpsi, p_section->i_extension,
                               p_section->i_version, p_section->b_current_next);
         if (p_pat_decoder->p_building_pat == NULL)
             return false;
@@ -259,10 +329,87 @@ static bool dvbpsi_AddSectionPAT(dvbpsi_t *p_dvbpsi, dvbpsi_pat_decoder_t *p_pat
         p_pat_decoder->i_last_section_number = p_section->i_last_number;
     }
 
+    /* A table carried by this section alone is complete as it is */
+    if (dvbpsi_decoder_psi_section_single(DVBPSI_DECODER(p_pat_decoder), p_section))
+    {
+        *pb_complete = true;
+        return true;
+    }
+
     /* Add to linked list of sections */
     if (dvbpsi_decoder_psi_section_add(DVBPSI_DECODER(p_pat_decoder), p_section))
         dvbpsi_debug(p_dvbpsi, "PAT decoder", "overwrite section number %d",
                      p_section->i_number);
+    *pb_complete = dvbpsi_decoder_psi_sections_completed(DVBPSI_DECODER(p_pat_decoder));
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_pat_keep_next
+ *****************************************************************************
+ * Decodes the sections of a complete next PAT once more so that the decoder
+ * keeps it until the version becomes current.
+ *****************************************************************************/
+static void dvbpsi_pat_keep_next(dvbpsi_t *p_dvbpsi, dvbpsi_pat_decoder_t *p_pat_decoder)
+{
+    dvbpsi_pat_t *p_building = p_pat_decoder->p_building_pat;
+
+    if (p_pat_decoder->p_next_pat)
+        dvbpsi_pat_delete(p_pat_decoder->p_next_pat);
+
+    p_pat_decoder->p_next_pat = dvbpsi_pat_table_new(p_dvbpsi, p_building->i_ts_id,
+                                                     p_building->i_version, false);
+    if (p_pat_decoder->p_next_pat == NULL)
+        return;
+
+    if (!dvbpsi_pat_sections_decode(p_pat_decoder->p_next_pat, p_pat_decoder->p_sections))
+    {
+        dvbpsi_pat_delete(p_pat_decoder->p_next_pat);
+        p_pat_decoder->p_next_pat = NULL;
+        return;
+    }
+    p_pat_decoder->i_next_last_section_number = p_pat_decoder->i_last_section_number;
+}
+
+/*****************************************************************************
+ * dvbpsi_pat_promote_next
+ *****************************************************************************
+ * Signals the next PAT kept by the decoder as soon as a section says that
+ * its version is current.
+ *****************************************************************************/
+static bool dvbpsi_pat_promote_next(dvbpsi_t *p_dvbpsi, dvbpsi_pat_decoder_t *p_pat_decoder,
+                                    dvbpsi_psi_section_t* p_section)
+{
+    dvbpsi_pat_t *p_next = p_pat_decoder->p_next_pat;
+
+    if (   p_next == NULL || !p_section->b_current_next
+        || p_next->i_ts_id != p_section->i_extension
+        || p_next->i_version != p_section->i_version
+        || p_pat_decoder->i_next_last_section_number != p_section->i_last_number)
+        return false;
+
+    /* Sections of another table being gathered */
+    if (p_pat_decoder->p_building_pat)
+    {
+        dvbpsi_pat_delete(p_pat_decoder->p_building_pat);
+        p_pat_decoder->p_building_pat = NULL;
+        dvbpsi_decoder_reset(DVBPSI_DECODER(p_pat_decoder), false);
+    }
+    dvbpsi_DeletePSISections(p_section);
+
+    p_dvbpsi->stats.i_tables++;
+    p_pat_decoder->p_next_pat = NULL;
+    p_next->b_current_next = true;
+    p_pat_decoder->current_pat = *p_next;
+    p_pat_decoder->b_current_valid = true;
+    /* The repetitions of the current version are skipped from now on */
+    if (p_pat_decoder->b_known && p_pat_decoder->i_known_version == p_next->i_version)
+        p_pat_decoder->b_known_current_next = true;
+
+    /* signal the new PAT */
+    dvbpsi_probe_callback_entry("pat", 0x00, p_next->i_ts_id);
+    p_pat_decoder->pf_pat_callback(p_pat_decoder->p_cb_data, p_next);
+    dvbpsi_probe_callback_exit("pat", 0x00, p_next->i_ts_id);
     return true;
 }
 
@@ -308,6 +455,8 @@ void dvbpsi_pat_sections_gather(dvbpsi_t* p_dvbpsi, dvbpsi_psi_section_t* p_sect
                                                p_section->b_current_next))
             {
                 /* Don't decode since this version is already decoded */
+                p_dvbpsi->stats.i_dropped_duplicate++;
+                dvbpsi_probe_dropped(p_section, "duplicate");
                 dvbpsi_debug(p_dvbpsi, "PAT decoder",
                              "ignoring already decoded section %d",
                              p_section->i_number);
@@ -317,8 +466,28 @@ void dvbpsi_pat_sections_gather(dvbpsi_t* p_dvbpsi, dvbpsi_psi_section_t* p_sect
         }
     }
 
+    /* The next PAT already decoded becomes current */
+    if (dvbpsi_pat_promote_next(p_dvbpsi, p_pat_decoder, p_section))
+        return;
+
+    /* Signal the programs of the section at once */
+    if (p_pat_decoder->pf_program_callback && p_section->b_current_next)
+    {
+        for (uint8_t *p_byte = p_section->p_payload_start;
+             p_byte + 4 <= p_section->p_payload_end;
+             p_byte += 4)
+        {
+            dvbpsi_probe_callback_entry("pat_program", p_section->i_table_id, p_section->i_extension);
+            p_pat_decoder->pf_program_callback(p_pat_decoder->p_program_cb_data,
+                                               ((uint16_t)(p_byte[0]) << 8) | p_byte[1],
+                                               ((uint16_t)(p_byte[2] & 0x1f) << 8) | p_byte[3]);
+            dvbpsi_probe_callback_exit("pat_program", p_section->i_table_id, p_section->i_extension);
+        }
+    }
+
     /* Add section to PAT */
-    if (!dvbpsi_AddSectionPAT(p_dvbpsi, p_pat_decoder, p_section))
+    bool b_complete = false;
+    if (!dvbpsi_AddSectionPAT(p_dvbpsi, p_pat_decoder, p_section, &b_complete))
     {
         dvbpsi_error(p_dvbpsi, "PAT decoder", "failed decoding section %d",
                      p_section->i_number);
@@ -327,8 +496,9 @@ void dvbpsi_pat_sections_gather(dvbpsi_t* p_dvbpsi, dvbpsi_psi_section_t* p_sect
     }
 
     /* Check if we have all the sections */
-    if (dvbpsi_decoder_psi_sections_completed(DVBPSI_DECODER(p_pat_decoder)))
+    if (b_complete)
     {
+        p_dvbpsi->stats.i_tables++;
         assert(p_pat_decoder->pf_pat_callback);
 
         /* Save the current information */
@@ -338,11 +508,17 @@ void dvbpsi_pat_sections_gather(dvbpsi_t* p_dvbpsi, dvbpsi_psi_section_t* p_sect
         if (dvbpsi_pat_sections_decode(p_pat_decoder->p_building_pat,
                                        p_pat_decoder->p_sections))
             p_pat_decoder->b_current_valid = true;
+        if (p_pat_decoder->b_current_valid && !p_pat_decoder->p_building_pat->b_current_next)
+            dvbpsi_pat_keep_next(p_dvbpsi, p_pat_decoder);
 
         /* signal the new PAT */
         if (p_pat_decoder->b_current_valid)
+        {
+            dvbpsi_probe_callback_entry("pat", p_section->i_table_id, p_section->i_extension);
             p_pat_decoder->pf_pat_callback(p_pat_decoder->p_cb_data,
                                            p_pat_decoder->p_building_pat);
+            dvbpsi_probe_callback_exit("pat", p_section->i_table_id, p_section->i_extension);
+        }
 
         /* Delete sectioins and Reinitialize the structures */
         dvbpsi_ReInitPAT(p_pat_decoder, !p_pat_decoder->b_current_valid);
@@ -359,6 +535,17 @@ void dvbpsi_pat_sections_gather(dvbpsi_t* p_dvbpsi, dvbpsi_psi_section_t* p_sect
 bool dvbpsi_pat_sections_decode(dvbpsi_pat_t* p_pat, dvbpsi_psi_section_t* p_section)
 {
     bool b_valid = false;
+
+    /* DVBPSI_FLAG_TABLE_ARRAYS, the programs dvbpsi_pat_program_add() takes */
+    size_t i_programs = 0;
+    for (dvbpsi_psi_section_t *p = p_pat->b_arrays ? p_section : NULL; p; p = p->p_next)
+        for (uint8_t *p_byte = p->p_payload_start; p_byte < p->p_payload_end; p_byte += 4)
+            if ((p_byte[2] & 0x1f) || p_byte[3])
+                i_programs++;
+    dvbpsi_arrays_t arrays;
+    dvbpsi_arrays_new(&arrays, p_pat->b_arrays ? p_pat->p_arena : NULL,
+                      i_programs, sizeof(dvbpsi_pat_program_t), 0);
+
     while (p_section)
     {
         for (uint8_t *p_byte = p_section->p_payload_start;
@@ -367,7 +554,14 @@ bool dvbpsi_pat_sections_decode(dvbpsi_pat_t* p_pat, dvbpsi_psi_section_t* p_sec
         {
             uint16_t i_program_number = ((uint16_t)(p_byte[0]) << 8) | p_byte[1];
             uint16_t i_pid = ((uint16_t)(p_byte[2] & 0x1f) << 8) | p_byte[3];
-            dvbpsi_pat_program_t* p_program = dvbpsi_pat_program_add(p_pat, i_program_number, i_pid);
+            dvbpsi_pat_program_t* p_program = i_pid ? dvbpsi_arrays_entry(&arrays) : NULL;
+            if (p_program)
+            {
+                dvbpsi_pat_program_append(p_pat, p_program, i_program_number, i_pid);
+                p_pat->i_program_count++;
+            }
+            else
+                p_program = dvbpsi_pat_program_add(p_pat, i_program_number, i_pid);
             if (p_program)
                 b_valid = true;
         }
@@ -386,7 +580,7 @@ bool dvbpsi_pat_sections_decode(dvbpsi_pat_t* p_pat, dvbpsi_psi_section_t* p_sec
 dvbpsi_psi_section_t* dvbpsi_pat_sections_generate(dvbpsi_t *p_dvbpsi,
                                             dvbpsi_pat_t* p_pat, int i_max_pps)
 {
-    dvbpsi_psi_section_t* p_result = dvbpsi_NewPSISection(1024);
+    dvbpsi_psi_section_t* p_result = dvbpsi_section_buffer_get(p_dvbpsi, 1024);
     dvbpsi_psi_section_t* p_current = p_result;
     dvbpsi_psi_section_t* p_prev;
     dvbpsi_pat_program_t* p_program = p_pat->p_first_program;
@@ -420,7 +614,7 @@ dvbpsi_psi_section_t* dvbpsi_pat_sections_generate(dvbpsi_t *p_dvbpsi,
         if (++i_count > i_max_pps)
         {
             p_prev = p_current;
-            p_current = dvbpsi_NewPSISection(1024);
+            p_current = dvbpsi_section_buffer_get(p_dvbpsi, 1024);
             if (p_current ==  NULL)
             {
                 dvbpsi_error(p_dvbpsi, "PAT encoder", "failed to allocate new PSI section");
@@ -471,3 +665,16 @@ error:
     dvbpsi_DeletePSISections(p_prev);
     return NULL;
 }
+
+/*****************************************************************************
+ * dvbpsi_pat_sections_generate_into
+ *****************************************************************************
+ * Generate PAT sections into a caller buffer.
+ *****************************************************************************/
+int dvbpsi_pat_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_pat_t *p_pat,
+                                      int i_max_pps, dvbpsi_section_buffer_t *p_buffer)
+{
+    dvbpsi_section_buffer_begin(p_dvbpsi, p_buffer);
+    return dvbpsi_section_buffer_end(p_dvbpsi,
+                dvbpsi_pat_sections_generate(p_dvbpsi, p_pat, i_max_pps));
+}
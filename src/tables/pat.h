@@ -83,6 +83,12 @@ typedef struct dvbpsi_pat_s
   bool                      b_current_next;     /*!< current_next_indicator */
 
   dvbpsi_pat_program_t *    p_first_program;    /*!< program list */
+  dvbpsi_pat_program_t *    p_last_program;     /*!< private, list tail */
+  uint16_t                  i_program_count;    /*!< programs of the array
+                                                     at p_first_program, see
+                                                     DVBPSI_FLAG_TABLE_ARRAYS */
+  bool                      b_arrays;           /*!< private, see DVBPSI_FLAG_TABLE_ARRAYS */
+  struct dvbpsi_arena_s *   p_arena;            /*!< private, see DVBPSI_FLAG_TABLE_ARRAYS */
 
 } dvbpsi_pat_t;
 
@@ -97,6 +103,16 @@ typedef struct dvbpsi_pat_s
  */
 typedef void (* dvbpsi_pat_callback)(void* p_cb_data, dvbpsi_pat_t* p_new_pat);
 
+/*!
+ * \typedef void (* dvbpsi_pat_program_callback)(void* p_cb_data,
+ *                                               uint16_t i_number,
+ *                                               uint16_t i_pid)
+ * \brief Program callback type definition, see
+ * dvbpsi_pat_set_program_callback().
+ */
+typedef void (* dvbpsi_pat_program_callback)(void* p_cb_data, uint16_t i_number,
+                                             uint16_t i_pid);
+
 /*****************************************************************************
  * dvbpsi_pat_attach
  *****************************************************************************/
@@ -107,6 +123,11 @@ typedef void (* dvbpsi_pat_callback)(void* p_cb_data, dvbpsi_pat_t* p_new_pat);
  * \param pf_callback function to call back on new PAT
  * \param p_cb_data private data given in argument to the callback
  * \return true on success, false on failure
+ *
+ * A PAT whose current_next_indicator is 0 is signalled once complete, and
+ * the decoder keeps a decoded copy of it: the first section of that
+ * version with current_next_indicator 1 signals the copy, now current,
+ * without waiting for the other sections.
  */
 bool dvbpsi_pat_attach(dvbpsi_t *p_dvbpsi, dvbpsi_pat_callback pf_callback,
                        void* p_cb_data);
@@ -124,6 +145,29 @@ bool dvbpsi_pat_attach(dvbpsi_t *p_dvbpsi, dvbpsi_pat_callback pf_callback,
  */
 void dvbpsi_pat_detach(dvbpsi_t *p_dvbpsi);
 
+/*****************************************************************************
+ * dvbpsi_pat_set_program_callback
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_pat_set_program_callback(dvbpsi_t *p_dvbpsi,
+ *                                          dvbpsi_pat_program_callback pf_callback,
+ *                                          void* p_cb_data)
+ * \brief Signals the programs of each section of a PAT as soon as the
+ * section is received, before the whole table
+ * \param p_dvbpsi handle to dvbpsi with attached PAT decoder
+ * \param pf_callback function called with the program_number and PID of each
+ *        program of the section, NULL for none
+ * \param p_cb_data private data given in argument to the callback
+ * \return nothing.
+ *
+ * Only the sections of a current PAT (current_next_indicator 1) are
+ * signalled, and not those of a version already decoded. The whole table
+ * is still given to the callback of dvbpsi_pat_attach() when complete.
+ */
+void dvbpsi_pat_set_program_callback(dvbpsi_t *p_dvbpsi,
+                                     dvbpsi_pat_program_callback pf_callback,
+                                     void* p_cb_data);
+
 /*****************************************************************************
  * dvbpsi_pat_init/dvbpsi_pat_new
  *****************************************************************************/
@@ -204,6 +248,27 @@ dvbpsi_pat_program_t* dvbpsi_pat_program_add(dvbpsi_pat_t* p_pat,
 dvbpsi_psi_section_t* dvbpsi_pat_sections_generate(dvbpsi_t *p_dvbpsi,
                                             dvbpsi_pat_t* p_pat, int i_max_pps);
 
+/*****************************************************************************
+ * dvbpsi_pat_sections_generate_into
+ *****************************************************************************/
+/*!
+ * \fn int dvbpsi_pat_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_pat_t *p_pat,
+ *                                          int i_max_pps, dvbpsi_section_buffer_t *p_buffer)
+ * \brief PAT generator writing into caller memory
+ * \param p_dvbpsi handle to dvbpsi with attached decoder
+ * \param p_pat pointer to the PAT structure
+ * \param i_max_pps limitation of the number of program in each section
+ *        (max: 253), as for dvbpsi_pat_sections_generate()
+ * \param p_buffer buffer the sections are written into, its previous
+ *        sections are overwritten
+ * \return the number of sections written, linked from p_buffer->p_sections,
+ *         or -1 on error or if the buffer is too small.
+ *
+ * Same encoding as dvbpsi_pat_sections_generate(), without any allocation.
+ */
+int dvbpsi_pat_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_pat_t *p_pat,
+                                      int i_max_pps, dvbpsi_section_buffer_t *p_buffer);
+
 #ifdef __cplusplus
 };
 #endif
@@ -40,9 +40,18 @@ typedef struct dvbpsi_pat_decoder_s
     dvbpsi_pat_callback           pf_pat_callback;
     void *                        p_cb_data;
 
+    /* Programs of each section, see dvbpsi_pat_set_program_callback() */
+    dvbpsi_pat_program_callback   pf_program_callback;
+    void *                        p_program_cb_data;
+
     dvbpsi_pat_t                  current_pat;
     dvbpsi_pat_t *                p_building_pat;
 
+    /* Complete table with current_next_indicator == 0, signalled as soon as
+       its version becomes current */
+    dvbpsi_pat_t *                p_next_pat;
+    uint8_t                       i_next_last_section_number;
+
 } dvbpsi_pat_decoder_t;
 
 /*****************************************************************************
@@ -41,9 +41,11 @@
 #include <assert.h>
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_TABLE
 #include "../dvbpsi_private.h"
 #include "../psi.h"
 #include "../descriptor.h"
+#include "../demux.h"
 #include "pmt.h"
 #include "pmt_private.h"
 
@@ -90,11 +92,156 @@ void dvbpsi_pmt_detach(dvbpsi_t *p_dvbpsi)
     if (p_pmt_decoder->p_building_pmt)
         dvbpsi_pmt_delete(p_pmt_decoder->p_building_pmt);
     p_pmt_decoder->p_building_pmt = NULL;
+    if (p_pmt_decoder->p_next_pmt)
+        dvbpsi_pmt_delete(p_pmt_decoder->p_next_pmt);
+    p_pmt_decoder->p_next_pmt = NULL;
+    dvbpsi_free(p_pmt_decoder->p_es);
 
     dvbpsi_decoder_delete(p_dvbpsi->p_decoder);
     p_dvbpsi->p_decoder = NULL;
 }
 
+/*****************************************************************************
+ * dvbpsi_pmt_set_delta_callback
+ *****************************************************************************
+ * Set the function reporting the changes of each new PMT.
+ *****************************************************************************/
+void dvbpsi_pmt_set_delta_callback(dvbpsi_t *p_dvbpsi,
+                                   dvbpsi_pmt_delta_callback pf_callback,
+                                   void* p_cb_data)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    dvbpsi_pmt_decoder_t* p_pmt_decoder = (dvbpsi_pmt_decoder_t*)p_dvbpsi->p_decoder;
+    p_pmt_decoder->pf_delta_callback = pf_callback;
+    p_pmt_decoder->p_delta_cb_data = p_cb_data;
+}
+
+/*****************************************************************************
+ * dvbpsi_pmt_demux_attach
+ *****************************************************************************
+ * Initialize a PMT subtable decoder.
+ *****************************************************************************/
+bool dvbpsi_pmt_demux_attach(dvbpsi_t *p_dvbpsi, uint16_t i_program_number,
+                             dvbpsi_pmt_callback pf_callback, void* p_cb_data)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    dvbpsi_demux_t* p_demux = (dvbpsi_demux_t*)p_dvbpsi->p_decoder;
+
+    if (dvbpsi_demuxGetSubDec(p_demux, 0x02, i_program_number))
+    {
+        dvbpsi_error(p_dvbpsi, "PMT decoder",
+                     "Already a decoder for (table_id == 0x02,"
+                     "program_number == 0x%02x)",
+                     i_program_number);
+        return false;
+    }
+
+    dvbpsi_pmt_decoder_t* p_pmt_decoder;
+    p_pmt_decoder = (dvbpsi_pmt_decoder_t*) dvbpsi_decoder_new(NULL,
+                                             0, true, sizeof(dvbpsi_pmt_decoder_t));
+    if (p_pmt_decoder == NULL)
+        return false;
+
+    /* subtable decoder configuration */
+    dvbpsi_demux_subdec_t* p_subdec;
+    p_subdec = dvbpsi_NewDemuxSubDecoder(0x02, i_program_number, dvbpsi_pmt_subtable_detach,
+                                         dvbpsi_pmt_subtable_gather, DVBPSI_DECODER(p_pmt_decoder));
+    if (p_subdec == NULL)
+    {
+        dvbpsi_decoder_delete(DVBPSI_DECODER(p_pmt_decoder));
+        return false;
+    }
+
+    /* Attach the subtable decoder to the demux */
+    dvbpsi_AttachDemuxSubDecoder(p_demux, p_subdec);
+
+    /* PMT decoder configuration */
+    p_pmt_decoder->i_program_number = i_program_number;
+    p_pmt_decoder->pf_pmt_callback = pf_callback;
+    p_pmt_decoder->p_cb_data = p_cb_data;
+    p_pmt_decoder->p_building_pmt = NULL;
+
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_pmt_subtable_detach
+ *****************************************************************************
+ * Close a PMT subtable decoder, also called by dvbpsi_DetachDemux().
+ *****************************************************************************/
+void dvbpsi_pmt_subtable_detach(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_extension)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    dvbpsi_demux_t *p_demux = (dvbpsi_demux_t *) p_dvbpsi->p_decoder;
+
+    dvbpsi_demux_subdec_t* p_subdec;
+    p_subdec = dvbpsi_demuxGetSubDec(p_demux, i_table_id, i_extension);
+    if (p_subdec == NULL)
+    {
+        dvbpsi_error(p_dvbpsi, "PMT decoder",
+                     "No such PMT decoder (table_id == 0x%02x,"
+                     "program_number == 0x%02x)",
+                     i_table_id, i_extension);
+        return;
+    }
+
+    assert(p_subdec->p_decoder);
+
+    dvbpsi_pmt_decoder_t* p_pmt_decoder;
+    p_pmt_decoder = (dvbpsi_pmt_decoder_t*)p_subdec->p_decoder;
+    if (p_pmt_decoder->p_building_pmt)
+        dvbpsi_pmt_delete(p_pmt_decoder->p_building_pmt);
+    p_pmt_decoder->p_building_pmt = NULL;
+    if (p_pmt_decoder->p_next_pmt)
+        dvbpsi_pmt_delete(p_pmt_decoder->p_next_pmt);
+    p_pmt_decoder->p_next_pmt = NULL;
+    dvbpsi_free(p_pmt_decoder->p_es);
+    p_pmt_decoder->p_es = NULL;
+
+    /* Free sub table decoder */
+    dvbpsi_DetachDemuxSubDecoder(p_demux, p_subdec);
+    dvbpsi_DeleteDemuxSubDecoder(p_subdec);
+}
+
+/*****************************************************************************
+ * dvbpsi_pmt_demux_detach
+ *****************************************************************************
+ * Close a PMT subtable decoder.
+ *****************************************************************************/
+void dvbpsi_pmt_demux_detach(dvbpsi_t *p_dvbpsi, uint16_t i_program_number)
+{
+    dvbpsi_pmt_subtable_detach(p_dvbpsi, 0x02, i_program_number);
+}
+
+/*****************************************************************************
+ * dvbpsi_pmt_demux_set_delta_callback
+ *****************************************************************************
+ * Set the function reporting the changes of each new PMT of a program.
+ *****************************************************************************/
+bool dvbpsi_pmt_demux_set_delta_callback(dvbpsi_t *p_dvbpsi, uint16_t i_program_number,
+                                         dvbpsi_pmt_delta_callback pf_callback,
+                                         void* p_cb_data)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    dvbpsi_demux_t *p_demux = (dvbpsi_demux_t *) p_dvbpsi->p_decoder;
+    dvbpsi_demux_subdec_t* p_subdec = dvbpsi_demuxGetSubDec(p_demux, 0x02, i_program_number);
+    if (p_subdec == NULL)
+        return false;
+
+    dvbpsi_pmt_decoder_t* p_pmt_decoder = (dvbpsi_pmt_decoder_t*)p_subdec->p_decoder;
+    p_pmt_decoder->pf_delta_callback = pf_callback;
+    p_pmt_decoder->p_delta_cb_data = p_cb_data;
+    return true;
+}
+
 /*****************************************************************************
  * dvbpsi_pmt_init
  *****************************************************************************
@@ -110,7 +257,14 @@ void dvbpsi_pmt_init(dvbpsi_pmt_t* p_pmt, uint16_t i_program_number,
     p_pmt->b_current_next = b_current_next;
     p_pmt->i_pcr_pid = i_pcr_pid;
     p_pmt->p_first_descriptor = NULL;
+    p_pmt->p_last_descriptor = NULL;
+    memset(p_pmt->p_tags, 0, sizeof(p_pmt->p_tags));
     p_pmt->p_first_es = NULL;
+    p_pmt->p_last_es = NULL;
+    p_pmt->i_es_count = 0;
+    p_pmt->b_arrays = false;
+    p_pmt->p_arena = NULL;
+    p_pmt->p_sections = NULL;
 }
 
 /*****************************************************************************
@@ -121,7 +275,7 @@ void dvbpsi_pmt_init(dvbpsi_pmt_t* p_pmt, uint16_t i_program_number,
 dvbpsi_pmt_t* dvbpsi_pmt_new(uint16_t i_program_number, uint8_t i_version,
                             bool b_current_next, uint16_t i_pcr_pid)
 {
-    dvbpsi_pmt_t *p_pmt = (dvbpsi_pmt_t*)malloc(sizeof(dvbpsi_pmt_t));
+    dvbpsi_pmt_t *p_pmt = (dvbpsi_pmt_t*)dvbpsi_malloc(sizeof(dvbpsi_pmt_t));
     if(p_pmt != NULL)
         dvbpsi_pmt_init(p_pmt, i_program_number, i_version,
                         b_current_next, i_pcr_pid);
@@ -135,6 +289,7 @@ dvbpsi_pmt_t* dvbpsi_pmt_new(uint16_t i_program_number, uint8_t i_version,
  *****************************************************************************/
 void dvbpsi_pmt_empty(dvbpsi_pmt_t* p_pmt)
 {
+    dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(p_pmt->p_arena);
     dvbpsi_pmt_es_t* p_es = p_pmt->p_first_es;
 
     dvbpsi_DeleteDescriptors(p_pmt->p_first_descriptor);
@@ -143,12 +298,21 @@ void dvbpsi_pmt_empty(dvbpsi_pmt_t* p_pmt)
     {
         dvbpsi_pmt_es_t* p_tmp = p_es->p_next;
         dvbpsi_DeleteDescriptors(p_es->p_first_descriptor);
-        free(p_es);
+        dvbpsi_free(p_es);
         p_es = p_tmp;
     }
 
     p_pmt->p_first_descriptor = NULL;
+    p_pmt->p_last_descriptor = NULL;
+    memset(p_pmt->p_tags, 0, sizeof(p_pmt->p_tags));
     p_pmt->p_first_es = NULL;
+    p_pmt->p_last_es = NULL;
+    p_pmt->i_es_count = 0;
+
+    dvbpsi_arena_leave(p_previous);
+
+    dvbpsi_DeletePSISections(p_pmt->p_sections);
+    p_pmt->p_sections = NULL;
 }
 
 /*****************************************************************************
@@ -158,9 +322,35 @@ void dvbpsi_pmt_empty(dvbpsi_pmt_t* p_pmt)
  *****************************************************************************/
 void dvbpsi_pmt_delete(dvbpsi_pmt_t* p_pmt)
 {
-    if (p_pmt)
-        dvbpsi_pmt_empty(p_pmt);
-    free(p_pmt);
+    if (p_pmt == NULL)
+        return;
+
+    dvbpsi_arena_t *p_arena = p_pmt->p_arena;
+    dvbpsi_pmt_empty(p_pmt);
+    if (p_arena)
+        dvbpsi_arena_delete(p_arena);
+    else
+        dvbpsi_free(p_pmt);
+}
+
+/*****************************************************************************
+ * dvbpsi_pmt_decode
+ *****************************************************************************
+ * Decode the raw sections of a PMT delivered with DVBPSI_FLAG_LAZY_DECODE.
+ *****************************************************************************/
+void dvbpsi_pmt_decode(dvbpsi_pmt_t* p_pmt)
+{
+    assert(p_pmt);
+
+    if (p_pmt->p_sections == NULL)
+        return;
+
+    dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(p_pmt->p_arena);
+    dvbpsi_pmt_sections_decode(p_pmt, p_pmt->p_sections);
+    dvbpsi_arena_leave(p_previous);
+
+    dvbpsi_DeletePSISections(p_pmt->p_sections);
+    p_pmt->p_sections = NULL;
 }
 
 /*****************************************************************************
@@ -177,15 +367,30 @@ dvbpsi_descriptor_t* dvbpsi_pmt_descriptor_add(dvbpsi_pmt_t* p_pmt,
     if (p_descriptor == NULL)
         return NULL;
 
-    p_pmt->p_first_descriptor = dvbpsi_AddDescriptor(p_pmt->p_first_descriptor,
-                                                     p_descriptor);
-    assert(p_pmt->p_first_descriptor);
-    if (p_pmt->p_first_descriptor == NULL)
-        return NULL;
+    dvbpsi_list_append(p_pmt->p_first_descriptor, p_pmt->p_last_descriptor, p_descriptor);
+    dvbpsi_tags_add(p_pmt->p_tags, i_tag);
 
     return p_descriptor;
 }
 
+/*****************************************************************************
+ * dvbpsi_pmt_es_append
+ *****************************************************************************
+ * Set up an ES and add it at the end of the PMT.
+ *****************************************************************************/
+static void dvbpsi_pmt_es_append(dvbpsi_pmt_t *p_pmt, dvbpsi_pmt_es_t *p_es,
+                                 uint8_t i_type, uint16_t i_pid)
+{
+    p_es->i_type = i_type;
+    p_es->i_pid = i_pid;
+    p_es->p_first_descriptor = NULL;
+    p_es->p_last_descriptor = NULL;
+    memset(p_es->p_tags, 0, sizeof(p_es->p_tags));
+    p_es->p_next = NULL;
+
+    dvbpsi_list_append(p_pmt->p_first_es, p_pmt->p_last_es, p_es);
+}
+
 /*****************************************************************************
  * dvbpsi_pmt_es_add
  *****************************************************************************
@@ -194,24 +399,11 @@ dvbpsi_descriptor_t* dvbpsi_pmt_descriptor_add(dvbpsi_pmt_t* p_pmt,
 dvbpsi_pmt_es_t* dvbpsi_pmt_es_add(dvbpsi_pmt_t* p_pmt,
                                    uint8_t i_type, uint16_t i_pid)
 {
-    dvbpsi_pmt_es_t* p_es = (dvbpsi_pmt_es_t*)malloc(sizeof(dvbpsi_pmt_es_t));
+    dvbpsi_pmt_es_t* p_es = (dvbpsi_pmt_es_t*)dvbpsi_malloc(sizeof(dvbpsi_pmt_es_t));
     if (p_es == NULL)
         return NULL;
 
-    p_es->i_type = i_type;
-    p_es->i_pid = i_pid;
-    p_es->p_first_descriptor = NULL;
-    p_es->p_next = NULL;
-
-    if (p_pmt->p_first_es == NULL)
-       p_pmt->p_first_es = p_es;
-    else
-    {
-        dvbpsi_pmt_es_t* p_last_es = p_pmt->p_first_es;
-        while (p_last_es->p_next != NULL)
-            p_last_es = p_last_es->p_next;
-        p_last_es->p_next = p_es;
-    }
+    dvbpsi_pmt_es_append(p_pmt, p_es, i_type, i_pid);
     return p_es;
 }
 
@@ -229,15 +421,8 @@ dvbpsi_descriptor_t* dvbpsi_pmt_es_descriptor_add(dvbpsi_pmt_es_t* p_es,
     if (p_descriptor == NULL)
         return NULL;
 
-    if (p_es->p_first_descriptor == NULL)
-        p_es->p_first_descriptor = p_descriptor;
-    else
-    {
-        dvbpsi_descriptor_t* p_last_descriptor = p_es->p_first_descriptor;
-        while(p_last_descriptor->p_next != NULL)
-            p_last_descriptor = p_last_descriptor->p_next;
-        p_last_descriptor->p_next = p_descriptor;
-    }
+    dvbpsi_list_append(p_es->p_first_descriptor, p_es->p_last_descriptor, p_descriptor);
+    dvbpsi_tags_add(p_es->p_tags, i_tag);
     return p_descriptor;
 }
 
@@ -254,17 +439,18 @@ static void dvbpsi_ReInitPMT(dvbpsi_pmt_decoder_t* p_decoder, const bool b_force
         /* Free structures */
         if (p_decoder->p_building_pmt)
             dvbpsi_pmt_delete(p_decoder->p_building_pmt);
+        if (p_decoder->p_next_pmt)
+            dvbpsi_pmt_delete(p_decoder->p_next_pmt);
+        p_decoder->p_next_pmt = NULL;
     }
     p_decoder->p_building_pmt = NULL;
 }
 
-static bool dvbpsi_CheckPMT(dvbpsi_t *p_dvbpsi, dvbpsi_psi_section_t *p_section)
+static bool dvbpsi_CheckPMT(dvbpsi_t *p_dvbpsi, dvbpsi_pmt_decoder_t *p_pmt_decoder,
+                            dvbpsi_psi_section_t *p_section)
 {
     bool b_reinit = false;
-    assert(p_dvbpsi->p_decoder);
-
-    dvbpsi_pmt_decoder_t* p_pmt_decoder;
-    p_pmt_decoder = (dvbpsi_pmt_decoder_t *)p_dvbpsi->p_decoder;
+    assert(p_pmt_decoder);
 
     if (p_pmt_decoder->p_building_pmt->i_version != p_section->i_version)
     {
@@ -287,7 +473,7 @@ static bool dvbpsi_CheckPMT(dvbpsi_t *p_dvbpsi, dvbpsi_psi_section_t *p_section)
 }
 
 static bool dvbpsi_AddSectionPMT(dvbpsi_t *p_dvbpsi, dvbpsi_pmt_decoder_t *p_pmt_decoder,
-                                 dvbpsi_psi_section_t* p_section)
+                                 dvbpsi_psi_section_t* p_section, bool *pb_complete)
 {
     assert(p_dvbpsi);
     assert(p_pmt_decoder);
@@ -296,56 +482,257 @@ static bool dvbpsi_AddSectionPMT(dvbpsi_t *p_dvbpsi, dvbpsi_pmt_decoder_t *p_pmt
     /* Initialize the structures if it's the first section received */
     if (p_pmt_decoder->p_building_pmt == NULL)
     {
+        dvbpsi_arena_t *p_arena = dvbpsi_arena_table_new(p_dvbpsi);
+        dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(p_arena);
         p_pmt_decoder->p_building_pmt = dvbpsi_pmt_new(p_pmt_decoder->i_program_number,
                               p_section->i_version, p_section->b_current_next,
                               ((uint16_t)(p_section->p_payload_start[0] & 0x1f) << 8)
                                           | p_section->p_payload_start[1]);
+        dvbpsi_arena_leave(p_previous);
+        if (p_pmt_decoder->p_building_pmt)
+        {
+            p_pmt_decoder->p_building_pmt->p_arena = p_arena;
+            p_pmt_decoder->p_building_pmt->b_arrays =
+                        p_arena && (p_dvbpsi->i_flags & DVBPSI_FLAG_TABLE_ARRAYS);
+        }
+        else
+            dvbpsi_arena_delete(p_arena);
         if (p_pmt_decoder->p_building_pmt == NULL)
             return false;
 
         p_pmt_decoder->i_last_section_number = p_section->i_last_number;
     }
 
+    /* A table carried by this section alone is complete as it is */
+    if (dvbpsi_decoder_psi_section_single(DVBPSI_DECODER(p_pmt_decoder), p_section))
+    {
+        *pb_complete = true;
+        return true;
+    }
+
     /* Add to linked list of sections */
     if (dvbpsi_decoder_psi_section_add(DVBPSI_DECODER(p_pmt_decoder), p_section))
         dvbpsi_debug(p_dvbpsi, "PMT decoder", "overwrite section number %d",
                      p_section->i_number);
 
+    *pb_complete = dvbpsi_decoder_psi_sections_completed(DVBPSI_DECODER(p_pmt_decoder));
     return true;
 }
 
 /*****************************************************************************
- * dvbpsi_GatherPMTSections
+ * dvbpsi_pmt_es_summary_t
  *****************************************************************************
- * Callback for the PSI decoder.
+ * What the delta callback compares of an ES.
  *****************************************************************************/
-void dvbpsi_pmt_sections_gather(dvbpsi_t *p_dvbpsi, dvbpsi_psi_section_t* p_section)
+typedef struct dvbpsi_pmt_es_summary_s
 {
-    assert(p_dvbpsi);
-    assert(p_dvbpsi->p_decoder);
+    uint16_t i_pid;
+    uint8_t  i_type;
+    uint64_t i_hash;                        /* of the descriptor loop */
+} dvbpsi_pmt_es_summary_t;
 
-    if (!dvbpsi_CheckPSISection(p_dvbpsi, p_section, 0x02, "PMT decoder"))
+/* FNV-1a */
+static uint64_t dvbpsi_pmt_hash(uint64_t i_hash, const uint8_t *p_data, size_t i_length)
+{
+    for (size_t i = 0; i < i_length; i++)
+        i_hash = (i_hash ^ p_data[i]) * UINT64_C(0x100000001b3);
+    return i_hash;
+}
+
+#define DVBPSI_PMT_HASH_INIT UINT64_C(0xcbf29ce484222325)
+
+/*****************************************************************************
+ * dvbpsi_pmt_delta
+ *****************************************************************************
+ * Compares the sections of a complete PMT with the summary of the previous
+ * one, calls the delta callback and keeps the new summary.
+ *****************************************************************************/
+static void dvbpsi_pmt_delta(dvbpsi_t *p_dvbpsi, dvbpsi_pmt_decoder_t *p_pmt_decoder)
+{
+    dvbpsi_psi_section_t *p_section;
+    dvbpsi_descriptor_iter_t descriptors;
+    dvbpsi_entry_iter_t es;
+    uint8_t *p_header;
+
+    unsigned int i_es = 0;
+    for (p_section = p_pmt_decoder->p_sections; p_section; p_section = p_section->p_next)
     {
-        dvbpsi_DeletePSISections(p_section);
+        if (!dvbpsi_pmt_section_iter(p_section, NULL, &es))
+            continue;
+        while (dvbpsi_entry_iter_next(&es, NULL))
+            i_es++;
+    }
+
+    dvbpsi_pmt_es_summary_t *p_es = dvbpsi_malloc((i_es ? i_es : 1) * sizeof(dvbpsi_pmt_es_summary_t));
+    dvbpsi_pmt_es_delta_t *p_changes = dvbpsi_malloc((i_es + p_pmt_decoder->i_es + 1)
+                                                     * sizeof(dvbpsi_pmt_es_delta_t));
+    if (p_es == NULL || p_changes == NULL)
+    {
+        dvbpsi_error(p_dvbpsi, "PMT decoder", "out of memory, no delta reported");
+        dvbpsi_free(p_es);
+        dvbpsi_free(p_changes);
+        dvbpsi_free(p_pmt_decoder->p_es);
+        p_pmt_decoder->p_es = NULL;
+        p_pmt_decoder->i_es = 0;
+        p_pmt_decoder->b_summary = false;
         return;
     }
 
-    /* */
-    dvbpsi_pmt_decoder_t* p_pmt_decoder = (dvbpsi_pmt_decoder_t*)p_dvbpsi->p_decoder;
-    assert(p_pmt_decoder);
+    /* Summary of the new version */
+    uint8_t *p_pcr = p_pmt_decoder->p_sections->p_payload_start;
+    uint16_t i_pcr_pid = ((uint16_t)(p_pcr[0] & 0x1f) << 8) | p_pcr[1];
+    uint64_t i_descriptors_hash = DVBPSI_PMT_HASH_INIT;
+    i_es = 0;
+    for (p_section = p_pmt_decoder->p_sections; p_section; p_section = p_section->p_next)
+    {
+        if (!dvbpsi_pmt_section_iter(p_section, &descriptors, &es))
+            continue;
+        i_descriptors_hash = dvbpsi_pmt_hash(i_descriptors_hash, descriptors.p_pos,
+                                             descriptors.p_end - descriptors.p_pos);
+        while ((p_header = dvbpsi_entry_iter_next(&es, &descriptors)) != NULL)
+        {
+            p_es[i_es].i_type = p_header[0];
+            p_es[i_es].i_pid = ((uint16_t)(p_header[1] & 0x1f) << 8) | p_header[2];
+            p_es[i_es].i_hash = dvbpsi_pmt_hash(DVBPSI_PMT_HASH_INIT, descriptors.p_pos,
+                                                descriptors.p_end - descriptors.p_pos);
+            i_es++;
+        }
+    }
 
-    /* We have a valid PMT section */
-    if (p_pmt_decoder->i_program_number != p_section->i_extension)
+    /* Removed, then added and modified ESs */
+    unsigned int i_changes = 0;
+    for (unsigned int i = 0; i < p_pmt_decoder->i_es; i++)
     {
-        /* Invalid program_number */
-        dvbpsi_debug(p_dvbpsi, "PMT decoder", "ignoring section %d not belonging to 'program_number' %d",
-                     p_section->i_extension, p_pmt_decoder->i_program_number);
-        dvbpsi_DeletePSISections(p_section);
-        return;
+        const dvbpsi_pmt_es_summary_t *p_old = &p_pmt_decoder->p_es[i];
+        unsigned int j = 0;
+        while (j < i_es && p_es[j].i_pid != p_old->i_pid)
+            j++;
+        if (j == i_es)
+            p_changes[i_changes++] = (dvbpsi_pmt_es_delta_t){ DVBPSI_PMT_ES_REMOVED,
+                                        p_old->i_pid, p_old->i_type, p_old->i_type };
+    }
+    for (unsigned int j = 0; j < i_es; j++)
+    {
+        const dvbpsi_pmt_es_summary_t *p_new = &p_es[j];
+        unsigned int i = 0;
+        while (i < p_pmt_decoder->i_es && p_pmt_decoder->p_es[i].i_pid != p_new->i_pid)
+            i++;
+        if (i == p_pmt_decoder->i_es)
+            p_changes[i_changes++] = (dvbpsi_pmt_es_delta_t){ DVBPSI_PMT_ES_ADDED,
+                                        p_new->i_pid, p_new->i_type, p_new->i_type };
+        else if (p_pmt_decoder->p_es[i].i_type != p_new->i_type
+              || p_pmt_decoder->p_es[i].i_hash != p_new->i_hash)
+            p_changes[i_changes++] = (dvbpsi_pmt_es_delta_t){ DVBPSI_PMT_ES_MODIFIED,
+                                        p_new->i_pid, p_new->i_type,
+                                        p_pmt_decoder->p_es[i].i_type };
+    }
+
+    dvbpsi_pmt_delta_t delta;
+    delta.b_first = !p_pmt_decoder->b_summary;
+    delta.i_old_pcr_pid = p_pmt_decoder->b_summary ? p_pmt_decoder->i_pcr_pid : i_pcr_pid;
+    delta.i_pcr_pid = i_pcr_pid;
+    delta.b_descriptors = p_pmt_decoder->b_summary
+                       && p_pmt_decoder->i_descriptors_hash != i_descriptors_hash;
+    delta.i_es = i_changes;
+    delta.p_es = p_changes;
+
+    dvbpsi_free(p_pmt_decoder->p_es);
+    p_pmt_decoder->p_es = p_es;
+    p_pmt_decoder->i_es = i_es;
+    p_pmt_decoder->i_pcr_pid = i_pcr_pid;
+    p_pmt_decoder->i_descriptors_hash = i_descriptors_hash;
+    p_pmt_decoder->b_summary = true;
+
+    dvbpsi_probe_callback_entry("pmt_delta", 0x02, p_pmt_decoder->i_program_number);
+    p_pmt_decoder->pf_delta_callback(p_pmt_decoder->p_delta_cb_data, &delta);
+    dvbpsi_probe_callback_exit("pmt_delta", 0x02, p_pmt_decoder->i_program_number);
+    dvbpsi_free(p_changes);
+}
+
+/*****************************************************************************
+ * dvbpsi_pmt_keep_next
+ *****************************************************************************
+ * Decodes the sections of a complete next PMT once more so that the decoder
+ * keeps it until the version becomes current.
+ *****************************************************************************/
+static void dvbpsi_pmt_keep_next(dvbpsi_t *p_dvbpsi, dvbpsi_pmt_decoder_t *p_pmt_decoder)
+{
+    dvbpsi_pmt_t *p_building = p_pmt_decoder->p_building_pmt;
+
+    if (p_pmt_decoder->p_next_pmt)
+        dvbpsi_pmt_delete(p_pmt_decoder->p_next_pmt);
+
+    dvbpsi_arena_t *p_arena = dvbpsi_arena_table_new(p_dvbpsi);
+    dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(p_arena);
+    dvbpsi_pmt_t *p_next = dvbpsi_pmt_new(p_building->i_program_number,
+                                          p_building->i_version, false,
+                                          p_building->i_pcr_pid);
+    if (p_next)
+    {
+        p_next->p_arena = p_arena;
+        p_next->b_arrays = p_building->b_arrays;
+        dvbpsi_pmt_sections_decode(p_next, p_pmt_decoder->p_sections);
+    }
+    dvbpsi_arena_leave(p_previous);
+
+    p_pmt_decoder->p_next_pmt = p_next;
+    if (p_next)
+        p_pmt_decoder->i_next_last_section_number = p_pmt_decoder->i_last_section_number;
+    else
+        dvbpsi_arena_delete(p_arena);
+}
+
+/*****************************************************************************
+ * dvbpsi_pmt_promote_next
+ *****************************************************************************
+ * Signals the next PMT kept by the decoder as soon as a section says that
+ * its version is current.
+ *****************************************************************************/
+static bool dvbpsi_pmt_promote_next(dvbpsi_t *p_dvbpsi, dvbpsi_pmt_decoder_t *p_pmt_decoder,
+                                    dvbpsi_psi_section_t* p_section)
+{
+    dvbpsi_pmt_t *p_next = p_pmt_decoder->p_next_pmt;
+
+    if (   p_next == NULL || !p_section->b_current_next
+        || p_next->i_version != p_section->i_version
+        || p_pmt_decoder->i_next_last_section_number != p_section->i_last_number)
+        return false;
+
+    /* Sections of another table being gathered */
+    if (p_pmt_decoder->p_building_pmt)
+    {
+        dvbpsi_pmt_delete(p_pmt_decoder->p_building_pmt);
+        p_pmt_decoder->p_building_pmt = NULL;
+        dvbpsi_decoder_reset(DVBPSI_DECODER(p_pmt_decoder), false);
     }
+    dvbpsi_DeletePSISections(p_section);
+
+    p_dvbpsi->stats.i_tables++;
+    p_pmt_decoder->p_next_pmt = NULL;
+    p_next->b_current_next = true;
+    p_pmt_decoder->current_pmt = *p_next;
+    p_pmt_decoder->b_current_valid = true;
+    /* The repetitions of the current version are skipped from now on */
+    if (p_pmt_decoder->b_known && p_pmt_decoder->i_known_version == p_next->i_version)
+        p_pmt_decoder->b_known_current_next = true;
+
+    /* signal the new PMT, its changes were reported with the next one */
+    dvbpsi_probe_callback_entry("pmt", 0x02, p_next->i_program_number);
+    p_pmt_decoder->pf_pmt_callback(p_pmt_decoder->p_cb_data, p_next);
+    dvbpsi_probe_callback_exit("pmt", 0x02, p_next->i_program_number);
+    return true;
+}
 
+/*****************************************************************************
+ * dvbpsi_pmt_gather
+ *****************************************************************************
+ * Adds a valid section of the program to a PMT decoder.
+ *****************************************************************************/
+static void dvbpsi_pmt_gather(dvbpsi_t *p_dvbpsi, dvbpsi_pmt_decoder_t *p_pmt_decoder,
+                              bool b_discontinuity, dvbpsi_psi_section_t* p_section)
+{
     /* TS discontinuity check */
-    if (p_pmt_decoder->b_discontinuity)
+    if (b_discontinuity)
     {
         dvbpsi_ReInitPMT(p_pmt_decoder, true);
         p_pmt_decoder->b_discontinuity = false;
@@ -355,7 +742,7 @@ void dvbpsi_pmt_sections_gather(dvbpsi_t *p_dvbpsi, dvbpsi_psi_section_t* p_sect
         /* Perform some few sanity checks */
         if (p_pmt_decoder->p_building_pmt)
         {
-            if (dvbpsi_CheckPMT(p_dvbpsi, p_section))
+            if (dvbpsi_CheckPMT(p_dvbpsi, p_pmt_decoder, p_section))
                 dvbpsi_ReInitPMT(p_pmt_decoder, true);
         }
         else
@@ -366,6 +753,8 @@ void dvbpsi_pmt_sections_gather(dvbpsi_t *p_dvbpsi, dvbpsi_psi_section_t* p_sect
                                                p_section->b_current_next))
             {
                 /* Don't decode since this version is already decoded */
+                p_dvbpsi->stats.i_dropped_duplicate++;
+                dvbpsi_probe_dropped(p_section, "duplicate");
                 dvbpsi_debug(p_dvbpsi, "PMT decoder",
                              "ignoring already decoded section %d",
                              p_section->i_number);
@@ -375,8 +764,13 @@ void dvbpsi_pmt_sections_gather(dvbpsi_t *p_dvbpsi, dvbpsi_psi_section_t* p_sect
         }
     }
 
+    /* The next PMT already decoded becomes current */
+    if (dvbpsi_pmt_promote_next(p_dvbpsi, p_pmt_decoder, p_section))
+        return;
+
     /* Add section to PMT */
-    if (!dvbpsi_AddSectionPMT(p_dvbpsi, p_pmt_decoder, p_section))
+    bool b_complete = false;
+    if (!dvbpsi_AddSectionPMT(p_dvbpsi, p_pmt_decoder, p_section, &b_complete))
     {
         dvbpsi_error(p_dvbpsi, "PMT decoder", "failed decoding section %d",
                      p_section->i_number);
@@ -384,25 +778,150 @@ void dvbpsi_pmt_sections_gather(dvbpsi_t *p_dvbpsi, dvbpsi_psi_section_t* p_sect
         return;
     }
 
-    if (dvbpsi_decoder_psi_sections_completed(DVBPSI_DECODER(p_pmt_decoder)))
+    if (b_complete)
     {
+        p_dvbpsi->stats.i_tables++;
         assert(p_pmt_decoder->pf_pmt_callback);
 
         /* Save the current information */
         p_pmt_decoder->current_pmt = *p_pmt_decoder->p_building_pmt;
         p_pmt_decoder->b_current_valid = true;
-        /* Decode the sections */
-        dvbpsi_pmt_sections_decode(p_pmt_decoder->p_building_pmt,
-                                   p_pmt_decoder->p_sections);
+        if (p_pmt_decoder->pf_delta_callback)
+            dvbpsi_pmt_delta(p_dvbpsi, p_pmt_decoder);
+        if (!p_pmt_decoder->p_building_pmt->b_current_next)
+            dvbpsi_pmt_keep_next(p_dvbpsi, p_pmt_decoder);
+        dvbpsi_psi_section_t *p_lazy = NULL;
+        if (p_dvbpsi->i_flags & DVBPSI_FLAG_LAZY_DECODE)
+        {
+            /* A single section may still be borrowed from the TS packet */
+            p_lazy = p_pmt_decoder->p_sections;
+            if (p_lazy->b_borrowed)
+                p_lazy = dvbpsi_section_pool_copy(p_lazy);
+        }
+        if (p_lazy)
+        {
+            /* Hand the sections over, they are decoded on request */
+            p_pmt_decoder->p_building_pmt->p_sections = p_lazy;
+            if (p_lazy == p_pmt_decoder->p_sections)
+                p_pmt_decoder->p_sections = NULL;
+        }
+        else
+        {
+            /* Decode the sections, in the arena of the table if any */
+            dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(p_pmt_decoder->p_building_pmt->p_arena);
+            dvbpsi_pmt_sections_decode(p_pmt_decoder->p_building_pmt,
+                                       p_pmt_decoder->p_sections);
+            dvbpsi_arena_leave(p_previous);
+        }
         /* signal the new PMT */
+        dvbpsi_probe_callback_entry("pmt", p_section->i_table_id, p_section->i_extension);
         p_pmt_decoder->pf_pmt_callback(p_pmt_decoder->p_cb_data,
                                        p_pmt_decoder->p_building_pmt);
+        dvbpsi_probe_callback_exit("pmt", p_section->i_table_id, p_section->i_extension);
         /* Delete sections and Reinitialize the structures */
         dvbpsi_ReInitPMT(p_pmt_decoder, false);
         assert(p_pmt_decoder->p_sections == NULL);
     }
 }
 
+/*****************************************************************************
+ * dvbpsi_pmt_sections_gather
+ *****************************************************************************
+ * Callback for the PSI decoder.
+ *****************************************************************************/
+void dvbpsi_pmt_sections_gather(dvbpsi_t *p_dvbpsi, dvbpsi_psi_section_t* p_section)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    if (!dvbpsi_CheckPSISection(p_dvbpsi, p_section, 0x02, "PMT decoder"))
+    {
+        dvbpsi_DeletePSISections(p_section);
+        return;
+    }
+
+    /* */
+    dvbpsi_pmt_decoder_t* p_pmt_decoder = (dvbpsi_pmt_decoder_t*)p_dvbpsi->p_decoder;
+    assert(p_pmt_decoder);
+
+    /* We have a valid PMT section */
+    if (p_pmt_decoder->i_program_number != p_section->i_extension)
+    {
+        /* Invalid program_number */
+        dvbpsi_debug(p_dvbpsi, "PMT decoder", "ignoring section %d not belonging to 'program_number' %d",
+                     p_section->i_extension, p_pmt_decoder->i_program_number);
+        dvbpsi_DeletePSISections(p_section);
+        return;
+    }
+
+    dvbpsi_pmt_gather(p_dvbpsi, p_pmt_decoder, p_pmt_decoder->b_discontinuity, p_section);
+}
+
+/*****************************************************************************
+ * dvbpsi_pmt_subtable_gather
+ *****************************************************************************
+ * Callback for the subtable demultiplexor.
+ *****************************************************************************/
+void dvbpsi_pmt_subtable_gather(dvbpsi_t *p_dvbpsi, dvbpsi_decoder_t *p_private_decoder,
+                                dvbpsi_psi_section_t* p_section)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    if (!dvbpsi_CheckPSISection(p_dvbpsi, p_section, 0x02, "PMT decoder"))
+    {
+        dvbpsi_DeletePSISections(p_section);
+        return;
+    }
+
+    /* We have a valid PMT section, routed by the demux on its program_number */
+    dvbpsi_demux_t *p_demux = (dvbpsi_demux_t *)p_dvbpsi->p_decoder;
+    dvbpsi_pmt_decoder_t *p_pmt_decoder = (dvbpsi_pmt_decoder_t *)p_private_decoder;
+    assert(p_pmt_decoder);
+
+    bool b_discontinuity = p_demux->b_discontinuity;
+    p_demux->b_discontinuity = false;
+    dvbpsi_pmt_gather(p_dvbpsi, p_pmt_decoder, b_discontinuity, p_section);
+}
+
+/*****************************************************************************
+ * dvbpsi_pmt_arrays_size
+ *****************************************************************************
+ * ESs and room of the descriptors dvbpsi_pmt_sections_decode() adds, for
+ * DVBPSI_FLAG_TABLE_ARRAYS.
+ *****************************************************************************/
+static size_t dvbpsi_pmt_arrays_size(dvbpsi_psi_section_t *p_section, size_t *pi_span)
+{
+    size_t i_es = 0;
+    *pi_span = 0;
+
+    for (; p_section; p_section = p_section->p_next)
+    {
+        uint8_t *p_byte = p_section->p_payload_start + 4;
+        uint8_t *p_end = p_byte + (   ((uint16_t)(p_section->p_payload_start[2] & 0x0f) << 8)
+                                    | p_section->p_payload_start[3]);
+        if (p_end > p_section->p_payload_end)
+            p_end = p_section->p_payload_end;
+        *pi_span += dvbpsi_arrays_span(p_byte, p_end);
+
+        for (p_byte = p_end; p_byte + 5 <= p_section->p_payload_end;)
+        {
+            uint16_t i_es_length = ((uint16_t)(p_byte[3] & 0x0f) << 8) | p_byte[4];
+            p_byte += 5;
+            p_end = p_byte + i_es_length;
+            if (p_end > p_section->p_payload_end)
+                p_end = p_section->p_payload_end;
+            *pi_span += dvbpsi_arrays_span(p_byte, p_end);
+            i_es++;
+
+            /* past the last descriptor, as the decoding loop leaves it */
+            while (p_byte + 2 <= p_end)
+                p_byte += 2 + p_byte[1];
+        }
+    }
+    return i_es;
+}
+
 /*****************************************************************************
  * dvbpsi_pmt_sections_decode
  *****************************************************************************
@@ -413,20 +932,25 @@ void dvbpsi_pmt_sections_decode(dvbpsi_pmt_t* p_pmt,
 {
     uint8_t* p_byte, * p_end;
 
+    dvbpsi_arrays_t arrays;
+    size_t i_es = 0, i_span = 0;
+    if (p_pmt->b_arrays)
+        i_es = dvbpsi_pmt_arrays_size(p_section, &i_span);
+    dvbpsi_arrays_new(&arrays, p_pmt->b_arrays ? p_pmt->p_arena : NULL,
+                      i_es, sizeof(dvbpsi_pmt_es_t), i_span);
+
     while (p_section)
     {
         /* - PMT descriptors */
         p_byte = p_section->p_payload_start + 4;
         p_end = p_byte + (   ((uint16_t)(p_section->p_payload_start[2] & 0x0f) << 8)
                            | p_section->p_payload_start[3]);
-        while (p_byte + 2 <= p_end)
+        if (p_end > p_section->p_payload_end)
         {
-            uint8_t i_tag = p_byte[0];
-            uint8_t i_length = p_byte[1];
-            if (i_length + 2 <= p_end - p_byte)
-                dvbpsi_pmt_descriptor_add(p_pmt, i_tag, i_length, p_byte + 2);
-            p_byte += 2 + i_length;
+            p_end = p_section->p_payload_end;
         }
+        dvbpsi_arrays_descriptors(&arrays, p_byte, p_end, &p_pmt->p_first_descriptor,
+                                  &p_pmt->p_last_descriptor, p_pmt->p_tags);
 
         /* - ESs */
         for (p_byte = p_end; p_byte + 5 <= p_section->p_payload_end;)
@@ -434,7 +958,14 @@ void dvbpsi_pmt_sections_decode(dvbpsi_pmt_t* p_pmt,
             uint8_t i_type = p_byte[0];
             uint16_t i_pid = ((uint16_t)(p_byte[1] & 0x1f) << 8) | p_byte[2];
             uint16_t i_es_length = ((uint16_t)(p_byte[3] & 0x0f) << 8) | p_byte[4];
-            dvbpsi_pmt_es_t* p_es = dvbpsi_pmt_es_add(p_pmt, i_type, i_pid);
+            dvbpsi_pmt_es_t* p_es = dvbpsi_arrays_entry(&arrays);
+            if (p_es)
+            {
+                dvbpsi_pmt_es_append(p_pmt, p_es, i_type, i_pid);
+                p_pmt->i_es_count++;
+            }
+            else
+                p_es = dvbpsi_pmt_es_add(p_pmt, i_type, i_pid);
             /* - ES descriptors */
             p_byte += 5;
             p_end = p_byte + i_es_length;
@@ -442,14 +973,10 @@ void dvbpsi_pmt_sections_decode(dvbpsi_pmt_t* p_pmt,
             {
                 p_end = p_section->p_payload_end;
             }
-            while (p_byte + 2 <= p_end)
-            {
-                uint8_t i_tag = p_byte[0];
-                uint8_t i_length = p_byte[1];
-                if (i_length + 2 <= p_end - p_byte)
-                    dvbpsi_pmt_es_descriptor_add(p_es, i_tag, i_length, p_byte + 2);
-                p_byte += 2 + i_length;
-            }
+            if (p_es)
+                dvbpsi_arrays_descriptors(&arrays, p_byte, p_end, &p_es->p_first_descriptor,
+                                          &p_es->p_last_descriptor, p_es->p_tags);
+            p_byte = p_end;
         }
         p_section = p_section->p_next;
     }
@@ -462,7 +989,7 @@ void dvbpsi_pmt_sections_decode(dvbpsi_pmt_t* p_pmt,
  *****************************************************************************/
 dvbpsi_psi_section_t* dvbpsi_pmt_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_pmt_t* p_pmt)
 {
-    dvbpsi_psi_section_t* p_result = dvbpsi_NewPSISection(1024);
+    dvbpsi_psi_section_t* p_result = dvbpsi_section_buffer_get(p_dvbpsi, 1024);
     dvbpsi_psi_section_t* p_current = p_result;
     dvbpsi_psi_section_t* p_prev;
     dvbpsi_descriptor_t* p_descriptor = p_pmt->p_first_descriptor;
@@ -498,7 +1025,7 @@ dvbpsi_psi_section_t* dvbpsi_pmt_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_pm
             p_current->p_data[11] = i_info_length;
 
             p_prev = p_current;
-            p_current = dvbpsi_NewPSISection(1024);
+            p_current = dvbpsi_section_buffer_get(p_dvbpsi, 1024);
             p_prev->p_next = p_current;
 
             p_current->i_table_id = 0x02;
@@ -545,16 +1072,18 @@ dvbpsi_psi_section_t* dvbpsi_pmt_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_pm
         /* Can the current section carry all the descriptors ? */
         p_descriptor = p_es->p_first_descriptor;
         while(    (p_descriptor != NULL)
-               && ((p_es_start - p_current->p_data) + i_es_length <= 1020))
+               && ((p_es_start - p_current->p_data) + i_es_length
+                   + p_descriptor->i_length + 2 <= 1020))
         {
             i_es_length += p_descriptor->i_length + 2;
             p_descriptor = p_descriptor->p_next;
         }
 
-        /* If _no_ and the current section isn't empty and an empty section
-           may carry one more descriptor
+        /* If _no_, or not even the ES header fits, and the current section
+           isn't empty and an empty section may carry one more descriptor
            then create a new section */
-        if(    (p_descriptor != NULL)
+        if(    (   (p_descriptor != NULL)
+                || ((p_es_start - p_current->p_data) + 5 > 1020))
             && (p_es_start - p_current->p_data != 12)
             && (i_es_length <= 1008))
         {
@@ -563,7 +1092,7 @@ dvbpsi_psi_section_t* dvbpsi_pmt_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_pm
                          "create a new section to carry more ES descriptors");
 
             p_prev = p_current;
-            p_current = dvbpsi_NewPSISection(1024);
+            p_current = dvbpsi_section_buffer_get(p_dvbpsi, 1024);
             p_prev->p_next = p_current;
 
             p_current->i_table_id = 0x02;
@@ -640,3 +1169,47 @@ dvbpsi_psi_section_t* dvbpsi_pmt_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_pm
 
     return p_result;
 }
+
+/*****************************************************************************
+ * dvbpsi_pmt_sections_generate_into
+ *****************************************************************************
+ * Generate PMT sections into a caller buffer.
+ *****************************************************************************/
+int dvbpsi_pmt_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_pmt_t *p_pmt,
+                                      dvbpsi_section_buffer_t *p_buffer)
+{
+    dvbpsi_section_buffer_begin(p_dvbpsi, p_buffer);
+    return dvbpsi_section_buffer_end(p_dvbpsi,
+                dvbpsi_pmt_sections_generate(p_dvbpsi, p_pmt));
+}
+
+/*****************************************************************************
+ * dvbpsi_pmt_section_iter
+ *****************************************************************************
+ * Sets up iterators over the raw loops of a PMT section.
+ *****************************************************************************/
+bool dvbpsi_pmt_section_iter(dvbpsi_psi_section_t *p_section,
+                             dvbpsi_descriptor_iter_t *p_descriptors,
+                             dvbpsi_entry_iter_t *p_es)
+{
+    assert(p_section);
+
+    uint8_t *p_byte = p_section->p_payload_start;
+    uint8_t *p_end = p_section->p_payload_end;
+    if (p_end - p_byte < 4)
+        return false;
+
+    /* program_info */
+    size_t i_length = ((size_t)(p_byte[2] & 0x0f) << 8) | p_byte[3];
+    p_byte += 4;
+    if (i_length > (size_t)(p_end - p_byte))
+        i_length = p_end - p_byte;
+    if (p_descriptors)
+        dvbpsi_descriptor_iter_init(p_descriptors, p_byte, i_length);
+    p_byte += i_length;
+
+    /* ESs */
+    if (p_es)
+        dvbpsi_entry_iter_init(p_es, p_byte, p_end - p_byte, 5, 3);
+    return true;
+}
@@ -58,6 +58,9 @@ typedef struct dvbpsi_pmt_es_s
   uint16_t                      i_pid;                  /*!< elementary_PID */
 
   dvbpsi_descriptor_t *         p_first_descriptor;     /*!< descriptor list */
+  dvbpsi_descriptor_t *         p_last_descriptor;      /*!< private, list tail */
+  uint8_t                       p_tags[DVBPSI_TAGS_SIZE]; /*!< tags present in
+                                     the list, see dvbpsi_has_descriptor() */
 
   struct dvbpsi_pmt_es_s *      p_next;                 /*!< next element of
                                                              the list */
@@ -87,8 +90,18 @@ typedef struct dvbpsi_pmt_s
   uint16_t                  i_pcr_pid;          /*!< PCR_PID */
 
   dvbpsi_descriptor_t *     p_first_descriptor; /*!< descriptor list */
+  dvbpsi_descriptor_t *     p_last_descriptor;  /*!< private, list tail */
+  uint8_t                   p_tags[DVBPSI_TAGS_SIZE]; /*!< tags present in the
+                                     list, see dvbpsi_has_descriptor() */
 
   dvbpsi_pmt_es_t *         p_first_es;         /*!< ES list */
+  dvbpsi_pmt_es_t *         p_last_es;          /*!< private, list tail */
+  uint16_t                  i_es_count;         /*!< ESs of the array at
+                                                     p_first_es, see
+                                                     DVBPSI_FLAG_TABLE_ARRAYS */
+  bool                      b_arrays;           /*!< private, see DVBPSI_FLAG_TABLE_ARRAYS */
+  struct dvbpsi_arena_s *   p_arena;            /*!< private, see DVBPSI_FLAG_TABLE_ARENA */
+  dvbpsi_psi_section_t *    p_sections;         /*!< raw sections, see DVBPSI_FLAG_LAZY_DECODE */
 
 } dvbpsi_pmt_t;
 
@@ -117,6 +130,11 @@ typedef void (* dvbpsi_pmt_callback)(void* p_cb_data, dvbpsi_pmt_t* p_new_pmt);
  * \param pf_callback function to call back on new PMT
  * \param p_cb_data private data given in argument to the callback
  * \return true on success, false on failure
+ *
+ * A PMT whose current_next_indicator is 0 is signalled once complete, and
+ * the decoder keeps a decoded copy of it: the first section of that
+ * version with current_next_indicator 1 signals the copy, now current,
+ * without waiting for the other sections.
  */
 bool dvbpsi_pmt_attach(dvbpsi_t *p_dvbpsi, uint16_t i_program_number,
                       dvbpsi_pmt_callback pf_callback, void* p_cb_data);
@@ -134,6 +152,159 @@ bool dvbpsi_pmt_attach(dvbpsi_t *p_dvbpsi, uint16_t i_program_number,
  */
 void dvbpsi_pmt_detach(dvbpsi_t *p_dvbpsi);
 
+/*****************************************************************************
+ * dvbpsi_pmt_demux_attach
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_pmt_demux_attach(dvbpsi_t *p_dvbpsi,
+                                    uint16_t i_program_number,
+                                    dvbpsi_pmt_callback pf_callback,
+                                    void* p_cb_data)
+ * \brief Creates a PMT subtable decoder for a program and attaches it to the
+ *        subtable demux of a dvbpsi_t handle
+ * \param p_dvbpsi handle with a subtable demux, see dvbpsi_AttachDemux()
+ * \param i_program_number program number
+ * \param pf_callback function to call back on new PMT
+ * \param p_cb_data private data given in argument to the callback
+ * \return true on success, false if there is already a PMT decoder for the
+ *         program or on failure
+ *
+ * Use it for a PID carrying the PMTs of several programs: a single handle
+ * reassembles and checks each section once and the demux hands it to the
+ * decoder of its program_number, typically attached from the new subtable
+ * callback of the demux on table_id 0x02. dvbpsi_DetachDemux() detaches
+ * the PMT subtable decoders left.
+ */
+bool dvbpsi_pmt_demux_attach(dvbpsi_t *p_dvbpsi, uint16_t i_program_number,
+                             dvbpsi_pmt_callback pf_callback, void* p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_pmt_demux_detach
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_pmt_demux_detach(dvbpsi_t *p_dvbpsi, uint16_t i_program_number)
+ * \brief Destroys the PMT subtable decoder of a program.
+ * \param p_dvbpsi handle with a subtable demux
+ * \param i_program_number program number
+ * \return nothing.
+ */
+void dvbpsi_pmt_demux_detach(dvbpsi_t *p_dvbpsi, uint16_t i_program_number);
+
+/*****************************************************************************
+ * dvbpsi_pmt_es_change_t
+ *****************************************************************************/
+/*!
+ * \enum dvbpsi_pmt_es_change
+ * \brief Change of an ES between two versions of a PMT
+ */
+enum dvbpsi_pmt_es_change
+{
+    DVBPSI_PMT_ES_ADDED,        /*!< PID not in the previous version */
+    DVBPSI_PMT_ES_REMOVED,      /*!< PID not in the new version */
+    DVBPSI_PMT_ES_MODIFIED,     /*!< stream_type or descriptors changed */
+};
+
+/*!
+ * \struct dvbpsi_pmt_es_delta_s
+ * \brief Change of an ES, identified by its PID.
+ */
+/*!
+ * \typedef struct dvbpsi_pmt_es_delta_s dvbpsi_pmt_es_delta_t
+ * \brief dvbpsi_pmt_es_delta_t type definition.
+ */
+typedef struct dvbpsi_pmt_es_delta_s
+{
+    enum dvbpsi_pmt_es_change i_change;     /*!< kind of change */
+    uint16_t                  i_pid;        /*!< elementary_PID */
+    uint8_t                   i_type;       /*!< stream_type, the previous
+                                                 one for a removed ES */
+    uint8_t                   i_old_type;   /*!< previous stream_type of a
+                                                 modified ES */
+} dvbpsi_pmt_es_delta_t;
+
+/*****************************************************************************
+ * dvbpsi_pmt_delta_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_pmt_delta_s
+ * \brief Changes of a PMT since the version previously decoded.
+ */
+/*!
+ * \typedef struct dvbpsi_pmt_delta_s dvbpsi_pmt_delta_t
+ * \brief dvbpsi_pmt_delta_t type definition.
+ */
+typedef struct dvbpsi_pmt_delta_s
+{
+    bool                         b_first;       /*!< no previous version, all
+                                                     the ESs are added */
+    uint16_t                     i_old_pcr_pid; /*!< previous PCR_PID */
+    uint16_t                     i_pcr_pid;     /*!< new PCR_PID */
+    bool                         b_descriptors; /*!< the program descriptors
+                                                     changed */
+    unsigned int                 i_es;          /*!< number of changed ESs */
+    const dvbpsi_pmt_es_delta_t *p_es;          /*!< changed ESs, removed
+                                                     ones first */
+} dvbpsi_pmt_delta_t;
+
+/*****************************************************************************
+ * dvbpsi_pmt_delta_callback
+ *****************************************************************************/
+/*!
+ * \typedef void (* dvbpsi_pmt_delta_callback)(void* p_cb_data,
+ *                                             const dvbpsi_pmt_delta_t *p_delta)
+ * \brief Delta callback type definition, p_delta being only valid during
+ * the call.
+ */
+typedef void (* dvbpsi_pmt_delta_callback)(void* p_cb_data,
+                                           const dvbpsi_pmt_delta_t *p_delta);
+
+/*****************************************************************************
+ * dvbpsi_pmt_set_delta_callback
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_pmt_set_delta_callback(dvbpsi_t *p_dvbpsi,
+ *                                        dvbpsi_pmt_delta_callback pf_callback,
+ *                                        void* p_cb_data)
+ * \brief Reports the changes of each new PMT of a decoder
+ * \param p_dvbpsi handle with an attached PMT decoder
+ * \param pf_callback function called right before the PMT callback, with
+ *        the changes of the new version, NULL for none
+ * \param p_cb_data private data given in argument to the callback
+ * \return nothing.
+ *
+ * The decoder keeps, for the version it last signalled, the PCR_PID, the
+ * stream_type of each ES and a 64 bits hash of each descriptor loop, and
+ * compares the raw sections of the new version against them. Descriptor
+ * changes are detected on the bytes: the same descriptors in another
+ * order are a change. A version whose ESs, PCR_PID and descriptors are
+ * all unchanged has an empty delta.
+ */
+void dvbpsi_pmt_set_delta_callback(dvbpsi_t *p_dvbpsi,
+                                   dvbpsi_pmt_delta_callback pf_callback,
+                                   void* p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_pmt_demux_set_delta_callback
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_pmt_demux_set_delta_callback(dvbpsi_t *p_dvbpsi,
+ *                                              uint16_t i_program_number,
+ *                                              dvbpsi_pmt_delta_callback pf_callback,
+ *                                              void* p_cb_data)
+ * \brief Same as dvbpsi_pmt_set_delta_callback() for the PMT subtable
+ * decoder of a program
+ * \param p_dvbpsi handle with a subtable demux
+ * \param i_program_number program number
+ * \param pf_callback function called right before the PMT callback, NULL
+ *        for none
+ * \param p_cb_data private data given in argument to the callback
+ * \return false if there is no PMT decoder for the program, true
+ *         otherwise.
+ */
+bool dvbpsi_pmt_demux_set_delta_callback(dvbpsi_t *p_dvbpsi, uint16_t i_program_number,
+                                         dvbpsi_pmt_delta_callback pf_callback,
+                                         void* p_cb_data);
+
 /*****************************************************************************
  * dvbpsi_pmt_init/dvbpsi_pmt_new
  *****************************************************************************/
@@ -185,6 +356,20 @@ void dvbpsi_pmt_empty(dvbpsi_pmt_t* p_pmt);
  */
 void dvbpsi_pmt_delete(dvbpsi_pmt_t* p_pmt);
 
+/*****************************************************************************
+ * dvbpsi_pmt_decode
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_pmt_decode(dvbpsi_pmt_t* p_pmt)
+ * \brief Decodes the raw sections of a PMT received with DVBPSI_FLAG_LAZY_DECODE
+ * \param p_pmt pointer to the PMT structure
+ * \return nothing.
+ *
+ * Decodes the descriptors and ESs from dvbpsi_pmt_t::p_sections
+ * and releases the sections. Does nothing when the PMT has no raw sections.
+ */
+void dvbpsi_pmt_decode(dvbpsi_pmt_t* p_pmt);
+
 /*****************************************************************************
  * dvbpsi_pmt_descriptor_add
  *****************************************************************************/
@@ -253,6 +438,45 @@ dvbpsi_descriptor_t* dvbpsi_pmt_es_descriptor_add(dvbpsi_pmt_es_t* p_es,
  */
 dvbpsi_psi_section_t* dvbpsi_pmt_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_pmt_t* p_pmt);
 
+/*****************************************************************************
+ * dvbpsi_pmt_sections_generate_into
+ *****************************************************************************/
+/*!
+ * \fn int dvbpsi_pmt_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_pmt_t *p_pmt,
+ *                                          dvbpsi_section_buffer_t *p_buffer)
+ * \brief PMT generator writing into caller memory
+ * \param p_dvbpsi handle to dvbpsi with attached decoder
+ * \param p_pmt pointer to the PMT structure
+ * \param p_buffer buffer the sections are written into, its previous
+ *        sections are overwritten
+ * \return the number of sections written, linked from p_buffer->p_sections,
+ *         or -1 on error or if the buffer is too small.
+ *
+ * Same encoding as dvbpsi_pmt_sections_generate(), without any allocation.
+ */
+int dvbpsi_pmt_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_pmt_t *p_pmt,
+                                      dvbpsi_section_buffer_t *p_buffer);
+
+/*****************************************************************************
+ * dvbpsi_pmt_section_iter
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_pmt_section_iter(dvbpsi_psi_section_t *p_section,
+ *                                  dvbpsi_descriptor_iter_t *p_descriptors,
+ *                                  dvbpsi_entry_iter_t *p_es)
+ * \brief Iterates over a PMT section without decoding it
+ * \param p_section PMT section
+ * \param p_descriptors set up for the program_info descriptors, may be NULL
+ * \param p_es set up for the ESs, may be NULL
+ * \return false if the section is too short for a PMT section.
+ *
+ * An ES header is the 5 bytes holding stream_type, elementary_PID and
+ * ES_info_length.
+ */
+bool dvbpsi_pmt_section_iter(dvbpsi_psi_section_t *p_section,
+                             dvbpsi_descriptor_iter_t *p_descriptors,
+                             dvbpsi_entry_iter_t *p_es);
+
 #ifdef __cplusplus
 };
 #endif
@@ -45,6 +45,20 @@ typedef struct dvbpsi_pmt_decoder_s
 
     uint16_t                      i_program_number;
 
+    /* Complete table with current_next_indicator == 0, signalled as soon as
+       its version becomes current */
+    dvbpsi_pmt_t *                p_next_pmt;
+    uint8_t                       i_next_last_section_number;
+
+    /* Summary of the last PMT signalled, for the delta callback */
+    dvbpsi_pmt_delta_callback     pf_delta_callback;
+    void *                        p_delta_cb_data;
+    bool                          b_summary;
+    uint16_t                      i_pcr_pid;
+    uint64_t                      i_descriptors_hash;
+    struct dvbpsi_pmt_es_summary_s *p_es;
+    unsigned int                  i_es;
+
 } dvbpsi_pmt_decoder_t;
 
 /*****************************************************************************
@@ -55,6 +69,23 @@ typedef struct dvbpsi_pmt_decoder_s
 void dvbpsi_pmt_sections_gather(dvbpsi_t *p_dvbpsi,
                               dvbpsi_psi_section_t* p_section);
 
+/*****************************************************************************
+ * dvbpsi_pmt_subtable_gather
+ *****************************************************************************
+ * Callback for the subtable demultiplexor.
+ *****************************************************************************/
+void dvbpsi_pmt_subtable_gather(dvbpsi_t *p_dvbpsi,
+                                dvbpsi_decoder_t *p_private_decoder,
+                                dvbpsi_psi_section_t* p_section);
+
+/*****************************************************************************
+ * dvbpsi_pmt_subtable_detach
+ *****************************************************************************
+ * Close a PMT subtable decoder.
+ *****************************************************************************/
+void dvbpsi_pmt_subtable_detach(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                                uint16_t i_extension);
+
 /*****************************************************************************
  * dvbpsi_pmt_sections_decode
  *****************************************************************************
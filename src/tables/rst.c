@@ -40,6 +40,7 @@
 #include <assert.h>
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_TABLE
 #include "../dvbpsi_private.h"
 #include "../psi.h"
 #include "../descriptor.h"
@@ -104,6 +105,7 @@ void dvbpsi_rst_init(dvbpsi_rst_t* p_rst)
     assert(p_rst);
 
     p_rst->p_first_event = NULL;
+    p_rst->p_last_event = NULL;
 }
 
 /*****************************************************************************
@@ -113,7 +115,7 @@ void dvbpsi_rst_init(dvbpsi_rst_t* p_rst)
  *****************************************************************************/
 dvbpsi_rst_t *dvbpsi_rst_new(void)
 {
-    dvbpsi_rst_t *p_rst = (dvbpsi_rst_t*)malloc(sizeof(dvbpsi_rst_t));
+    dvbpsi_rst_t *p_rst = (dvbpsi_rst_t*)dvbpsi_malloc(sizeof(dvbpsi_rst_t));
     if (p_rst != NULL)
         dvbpsi_rst_init(p_rst);
     return p_rst;
@@ -132,12 +134,13 @@ void dvbpsi_rst_empty(dvbpsi_rst_t* p_rst)
     {
     	dvbpsi_rst_event_t* p_next = p_rst_event->p_next;
 
-        free(p_rst_event);
+        dvbpsi_free(p_rst_event);
 
         p_rst_event = p_next;
     }
 
     p_rst->p_first_event = NULL;
+    p_rst->p_last_event = NULL;
 }
 
 /*****************************************************************************
@@ -149,7 +152,7 @@ void dvbpsi_rst_delete(dvbpsi_rst_t *p_rst)
 {
     if (p_rst)
         dvbpsi_rst_empty(p_rst);
-    free(p_rst);
+    dvbpsi_free(p_rst);
 }
 
 /*****************************************************************************
@@ -166,7 +169,7 @@ dvbpsi_rst_event_t* dvbpsi_rst_event_add(dvbpsi_rst_t* p_rst,
                                             uint8_t i_running_status)
 {
 	dvbpsi_rst_event_t* p_rst_event
-                        = (dvbpsi_rst_event_t*)malloc(sizeof(dvbpsi_rst_event_t));
+                        = (dvbpsi_rst_event_t*)dvbpsi_malloc(sizeof(dvbpsi_rst_event_t));
 
     if (p_rst_event == NULL)
         return NULL;
@@ -178,15 +181,7 @@ dvbpsi_rst_event_t* dvbpsi_rst_event_add(dvbpsi_rst_t* p_rst,
     p_rst_event->i_running_status = i_running_status;
     p_rst_event->p_next = NULL;
 
-    if (p_rst->p_first_event == NULL)
-    	p_rst->p_first_event = p_rst_event;
-    else
-    {
-    	dvbpsi_rst_event_t *p_last = p_rst->p_first_event;
-    	while (p_last->p_next != NULL)
-    		p_last = p_last->p_next;
-    	p_last->p_next = p_rst_event;
-    }
+    dvbpsi_list_append(p_rst->p_first_event, p_rst->p_last_event, p_rst_event);
 
     return p_rst_event;
 }
@@ -198,7 +193,7 @@ dvbpsi_rst_event_t* dvbpsi_rst_event_add(dvbpsi_rst_t* p_rst,
  *****************************************************************************/
 dvbpsi_psi_section_t* dvbpsi_rst_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_rst_t* p_rst)
 {
-    dvbpsi_psi_section_t* p_result = dvbpsi_NewPSISection(1024);
+    dvbpsi_psi_section_t* p_result = dvbpsi_section_buffer_get(p_dvbpsi, 1024);
     dvbpsi_psi_section_t* p_current = p_result;
     dvbpsi_psi_section_t* p_prev;
     dvbpsi_rst_event_t* p_event = p_rst->p_first_event;
@@ -255,6 +250,19 @@ dvbpsi_psi_section_t* dvbpsi_rst_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_rs
     return p_result;
 }
 
+/*****************************************************************************
+ * dvbpsi_rst_sections_generate_into
+ *****************************************************************************
+ * Generate RST sections into a caller buffer.
+ *****************************************************************************/
+int dvbpsi_rst_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_rst_t *p_rst,
+                                      dvbpsi_section_buffer_t *p_buffer)
+{
+    dvbpsi_section_buffer_begin(p_dvbpsi, p_buffer);
+    return dvbpsi_section_buffer_end(p_dvbpsi,
+                dvbpsi_rst_sections_generate(p_dvbpsi, p_rst));
+}
+
 /* */
 static void dvbpsi_rst_reset(dvbpsi_rst_decoder_t* p_decoder, const bool b_force)
 {
@@ -378,6 +386,7 @@ void dvbpsi_rst_sections_gather(dvbpsi_t *p_dvbpsi,
     /* Check if we have all the sections */
     if (dvbpsi_decoder_psi_sections_completed(DVBPSI_DECODER(p_rst_decoder)))
     {
+        p_dvbpsi->stats.i_tables++;
         assert(p_rst_decoder->pf_rst_callback);
 
         /* Save the current information */
@@ -387,8 +396,10 @@ void dvbpsi_rst_sections_gather(dvbpsi_t *p_dvbpsi,
         dvbpsi_rst_sections_decode(p_rst_decoder->p_building_rst,
                                    p_rst_decoder->p_sections);
         /* signal the new CAT */
+        dvbpsi_probe_callback_entry("rst", p_section->i_table_id, p_section->i_extension);
         p_rst_decoder->pf_rst_callback(p_rst_decoder->p_cb_data,
                                        p_rst_decoder->p_building_rst);
+        dvbpsi_probe_callback_exit("rst", p_section->i_table_id, p_section->i_extension);
         /* Delete sectioins and Reinitialize the structures */
         dvbpsi_rst_reset(p_rst_decoder, false);
         assert(p_rst_decoder->p_sections == NULL);
@@ -81,6 +81,7 @@ typedef struct dvbpsi_rst_event_s
 typedef struct dvbpsi_rst_s
 {
   dvbpsi_rst_event_t *      p_first_event;      /*!< event information list */
+  dvbpsi_rst_event_t *      p_last_event;       /*!< private, list tail */
 } dvbpsi_rst_t;
 
 
@@ -200,6 +201,25 @@ dvbpsi_rst_event_t* dvbpsi_rst_event_add(dvbpsi_rst_t* p_rst,
  */
 dvbpsi_psi_section_t* dvbpsi_rst_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_rst_t* p_rst);
 
+/*****************************************************************************
+ * dvbpsi_rst_sections_generate_into
+ *****************************************************************************/
+/*!
+ * \fn int dvbpsi_rst_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_rst_t *p_rst,
+ *                                          dvbpsi_section_buffer_t *p_buffer)
+ * \brief RST generator writing into caller memory
+ * \param p_dvbpsi handle to dvbpsi with attached decoder
+ * \param p_rst pointer to the RST structure
+ * \param p_buffer buffer the sections are written into, its previous
+ *        sections are overwritten
+ * \return the number of sections written, linked from p_buffer->p_sections,
+ *         or -1 on error or if the buffer is too small.
+ *
+ * Same encoding as dvbpsi_rst_sections_generate(), without any allocation.
+ */
+int dvbpsi_rst_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_rst_t *p_rst,
+                                      dvbpsi_section_buffer_t *p_buffer);
+
 #ifdef __cplusplus
 };
 #endif
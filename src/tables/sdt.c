@@ -41,6 +41,7 @@
 #include <assert.h>
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_TABLE
 #include "../dvbpsi_private.h"
 #include "../psi.h"
 #include "../descriptor.h"
@@ -127,12 +128,37 @@ void dvbpsi_sdt_detach(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_extens
     if (p_sdt_decoder->p_building_sdt)
         dvbpsi_sdt_delete(p_sdt_decoder->p_building_sdt);
     p_sdt_decoder->p_building_sdt = NULL;
+    dvbpsi_delta_reset(&p_sdt_decoder->summary);
 
     /* Free sub table decoder */
     dvbpsi_DetachDemuxSubDecoder(p_demux, p_subdec);
     dvbpsi_DeleteDemuxSubDecoder(p_subdec);
 }
 
+/*****************************************************************************
+ * dvbpsi_sdt_set_delta_callback
+ *****************************************************************************
+ * Set the function reporting the changes of each new SDT.
+ *****************************************************************************/
+bool dvbpsi_sdt_set_delta_callback(dvbpsi_t *p_dvbpsi,
+                                   uint8_t i_table_id, uint16_t i_extension,
+                                   dvbpsi_sdt_delta_callback pf_callback,
+                                   void* p_cb_data)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    dvbpsi_demux_t *p_demux = (dvbpsi_demux_t *) p_dvbpsi->p_decoder;
+    dvbpsi_demux_subdec_t* p_subdec = dvbpsi_demuxGetSubDec(p_demux, i_table_id, i_extension);
+    if (p_subdec == NULL)
+        return false;
+
+    dvbpsi_sdt_decoder_t* p_sdt_decoder = (dvbpsi_sdt_decoder_t*)p_subdec->p_decoder;
+    p_sdt_decoder->pf_delta_callback = pf_callback;
+    p_sdt_decoder->p_delta_cb_data = p_cb_data;
+    return true;
+}
+
 /*****************************************************************************
  * dvbpsi_sdt_init
  *****************************************************************************
@@ -150,6 +176,12 @@ void dvbpsi_sdt_init(dvbpsi_sdt_t* p_sdt, uint8_t i_table_id, uint16_t i_extensi
     p_sdt->b_current_next = b_current_next;
     p_sdt->i_network_id = i_network_id;
     p_sdt->p_first_service = NULL;
+    p_sdt->p_last_service = NULL;
+    p_sdt->i_service_count = 0;
+    p_sdt->b_arrays = false;
+    memset(p_sdt->p_tags, 0, sizeof(p_sdt->p_tags));
+    p_sdt->p_arena = NULL;
+    p_sdt->p_sections = NULL;
 }
 
 /*****************************************************************************
@@ -160,7 +192,7 @@ void dvbpsi_sdt_init(dvbpsi_sdt_t* p_sdt, uint8_t i_table_id, uint16_t i_extensi
 dvbpsi_sdt_t *dvbpsi_sdt_new(uint8_t i_table_id, uint16_t i_extension, uint8_t i_version,
                              bool b_current_next, uint16_t i_network_id)
 {
-    dvbpsi_sdt_t *p_sdt = (dvbpsi_sdt_t*)malloc(sizeof(dvbpsi_sdt_t));
+    dvbpsi_sdt_t *p_sdt = (dvbpsi_sdt_t*)dvbpsi_malloc(sizeof(dvbpsi_sdt_t));
     if (p_sdt != NULL)
         dvbpsi_sdt_init(p_sdt, i_table_id, i_extension, i_version,
                         b_current_next, i_network_id);
@@ -174,16 +206,25 @@ dvbpsi_sdt_t *dvbpsi_sdt_new(uint8_t i_table_id, uint16_t i_extension, uint8_t i
  *****************************************************************************/
 void dvbpsi_sdt_empty(dvbpsi_sdt_t* p_sdt)
 {
+    dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(p_sdt->p_arena);
     dvbpsi_sdt_service_t* p_service = p_sdt->p_first_service;
 
     while (p_service != NULL)
     {
         dvbpsi_sdt_service_t* p_tmp = p_service->p_next;
         dvbpsi_DeleteDescriptors(p_service->p_first_descriptor);
-        free(p_service);
+        dvbpsi_free(p_service);
         p_service = p_tmp;
     }
     p_sdt->p_first_service = NULL;
+    p_sdt->p_last_service = NULL;
+    p_sdt->i_service_count = 0;
+    memset(p_sdt->p_tags, 0, sizeof(p_sdt->p_tags));
+
+    dvbpsi_arena_leave(p_previous);
+
+    dvbpsi_DeletePSISections(p_sdt->p_sections);
+    p_sdt->p_sections = NULL;
 }
 
 /*****************************************************************************
@@ -193,9 +234,57 @@ void dvbpsi_sdt_empty(dvbpsi_sdt_t* p_sdt)
  *****************************************************************************/
 void dvbpsi_sdt_delete(dvbpsi_sdt_t *p_sdt)
 {
-    if (p_sdt)
-        dvbpsi_sdt_empty(p_sdt);
-    free(p_sdt);
+    if (p_sdt == NULL)
+        return;
+
+    dvbpsi_arena_t *p_arena = p_sdt->p_arena;
+    dvbpsi_sdt_empty(p_sdt);
+    if (p_arena)
+        dvbpsi_arena_delete(p_arena);
+    else
+        dvbpsi_free(p_sdt);
+}
+
+/*****************************************************************************
+ * dvbpsi_sdt_decode
+ *****************************************************************************
+ * Decode the raw sections of a SDT delivered with DVBPSI_FLAG_LAZY_DECODE.
+ *****************************************************************************/
+void dvbpsi_sdt_decode(dvbpsi_sdt_t *p_sdt)
+{
+    assert(p_sdt);
+
+    if (p_sdt->p_sections == NULL)
+        return;
+
+    dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(p_sdt->p_arena);
+    dvbpsi_sdt_sections_decode(p_sdt, p_sdt->p_sections);
+    dvbpsi_arena_leave(p_previous);
+
+    dvbpsi_DeletePSISections(p_sdt->p_sections);
+    p_sdt->p_sections = NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_sdt_service_append
+ *****************************************************************************
+ * Set up a zeroed service description and add it at the end of the SDT.
+ *****************************************************************************/
+static void dvbpsi_sdt_service_append(dvbpsi_sdt_t *p_sdt, dvbpsi_sdt_service_t *p_service,
+                                      uint16_t i_service_id, bool b_eit_schedule,
+                                      bool b_eit_present, uint8_t i_running_status,
+                                      bool b_free_ca)
+{
+    p_service->i_service_id = i_service_id;
+    p_service->b_eit_schedule = b_eit_schedule;
+    p_service->b_eit_present = b_eit_present;
+    p_service->i_running_status = i_running_status;
+    p_service->b_free_ca = b_free_ca;
+    p_service->p_next = NULL;
+    p_service->p_first_descriptor = NULL;
+    p_service->p_last_descriptor = NULL;
+
+    dvbpsi_list_append(p_sdt->p_first_service, p_sdt->p_last_service, p_service);
 }
 
 /*****************************************************************************
@@ -211,28 +300,12 @@ dvbpsi_sdt_service_t *dvbpsi_sdt_service_add(dvbpsi_sdt_t* p_sdt,
                                            bool b_free_ca)
 {
     dvbpsi_sdt_service_t * p_service;
-    p_service = (dvbpsi_sdt_service_t*)calloc(1, sizeof(dvbpsi_sdt_service_t));
+    p_service = (dvbpsi_sdt_service_t*)dvbpsi_calloc(1, sizeof(dvbpsi_sdt_service_t));
     if (p_service == NULL)
         return NULL;
 
-    p_service->i_service_id = i_service_id;
-    p_service->b_eit_schedule = b_eit_schedule;
-    p_service->b_eit_present = b_eit_present;
-    p_service->i_running_status = i_running_status;
-    p_service->b_free_ca = b_free_ca;
-    p_service->p_next = NULL;
-    p_service->p_first_descriptor = NULL;
-
-    if (p_sdt->p_first_service == NULL)
-        p_sdt->p_first_service = p_service;
-    else
-    {
-        dvbpsi_sdt_service_t * p_last_service = p_sdt->p_first_service;
-        while(p_last_service->p_next != NULL)
-            p_last_service = p_last_service->p_next;
-        p_last_service->p_next = p_service;
-    }
-
+    dvbpsi_sdt_service_append(p_sdt, p_service, i_service_id, b_eit_schedule,
+                              b_eit_present, i_running_status, b_free_ca);
     return p_service;
 }
 
@@ -251,11 +324,8 @@ dvbpsi_descriptor_t *dvbpsi_sdt_service_descriptor_add(
     if (p_descriptor == NULL)
         return NULL;
 
-    p_service->p_first_descriptor = dvbpsi_AddDescriptor(p_service->p_first_descriptor,
-                                                         p_descriptor);
-    assert(p_service->p_first_descriptor);
-    if (p_service->p_first_descriptor == NULL)
-        return NULL;
+    dvbpsi_list_append(p_service->p_first_descriptor, p_service->p_last_descriptor, p_descriptor);
+    dvbpsi_tags_add(p_service->p_tags, i_tag);
 
     return p_descriptor;
 }
@@ -322,11 +392,22 @@ static bool dvbpsi_AddSectionSDT(dvbpsi_t *p_dvbpsi, dvbpsi_sdt_decoder_t *p_sdt
     /* Initialize the structures if it's the first section received */
     if (!p_sdt_decoder->p_building_sdt)
     {
+        dvbpsi_arena_t *p_arena = dvbpsi_arena_table_new(p_dvbpsi);
+        dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(p_arena);
         p_sdt_decoder->p_building_sdt =
                 dvbpsi_sdt_new(p_section->i_table_id, p_section->i_extension,
                              p_section->i_version, p_section->b_current_next,
                              ((uint16_t)(p_section->p_payload_start[0]) << 8)
                                          | p_section->p_payload_start[1]);
+        dvbpsi_arena_leave(p_previous);
+        if (p_sdt_decoder->p_building_sdt)
+        {
+            p_sdt_decoder->p_building_sdt->p_arena = p_arena;
+            p_sdt_decoder->p_building_sdt->b_arrays =
+                        p_arena && (p_dvbpsi->i_flags & DVBPSI_FLAG_TABLE_ARRAYS);
+        }
+        else
+            dvbpsi_arena_delete(p_arena);
 
         if (p_sdt_decoder->p_building_sdt == NULL)
             return false;
@@ -341,6 +422,84 @@ static bool dvbpsi_AddSectionSDT(dvbpsi_t *p_dvbpsi, dvbpsi_sdt_decoder_t *p_sdt
     return true;
 }
 
+/*****************************************************************************
+ * dvbpsi_DecodeSDTDescriptors
+ *****************************************************************************
+ * Decode the service descriptors of the new SDT through the descriptor
+ * cache of the decoder, see DVBPSI_FLAG_DESCRIPTOR_CACHE.
+ *****************************************************************************/
+static void dvbpsi_DecodeSDTDescriptors(dvbpsi_t *p_dvbpsi, dvbpsi_sdt_decoder_t *p_sdt_decoder)
+{
+    dvbpsi_sdt_service_t *p_service = p_sdt_decoder->p_building_sdt->p_first_service;
+    while (p_service)
+    {
+        dvbpsi_dr_cache_decode(p_dvbpsi, DVBPSI_DECODER(p_sdt_decoder),
+                               p_service->p_first_descriptor);
+        p_service = p_service->p_next;
+    }
+    dvbpsi_dr_cache_trim(DVBPSI_DECODER(p_sdt_decoder));
+}
+
+/*****************************************************************************
+ * dvbpsi_sdt_delta
+ *****************************************************************************
+ * Compares the sections of a complete SDT with the summary of the previous
+ * one and calls the delta callback.
+ *****************************************************************************/
+static bool dvbpsi_sdt_delta_iter(dvbpsi_psi_section_t *p_section,
+                                  dvbpsi_descriptor_iter_t *p_descriptors,
+                                  dvbpsi_entry_iter_t *p_services)
+{
+    /* No descriptor loop of its own */
+    if (p_descriptors)
+        dvbpsi_descriptor_iter_init(p_descriptors, p_section->p_payload_start, 0);
+    return dvbpsi_sdt_section_iter(p_section, p_services);
+}
+
+static uint32_t dvbpsi_sdt_delta_key(const uint8_t *p_header)
+{
+    return ((uint32_t)p_header[0] << 8) | p_header[1];
+}
+
+static void dvbpsi_sdt_delta(dvbpsi_t *p_dvbpsi, dvbpsi_sdt_decoder_t *p_sdt_decoder,
+                             dvbpsi_psi_section_t *p_section)
+{
+    bool b_first, b_descriptors;
+    unsigned int i_changes;
+    dvbpsi_delta_change_t *p_changes = dvbpsi_delta_compute(&p_sdt_decoder->summary,
+                                            p_sdt_decoder->p_sections,
+                                            dvbpsi_sdt_delta_iter, dvbpsi_sdt_delta_key,
+                                            &b_first, &b_descriptors, &i_changes);
+    dvbpsi_sdt_service_delta_t *p_services = NULL;
+    if (p_changes)
+        p_services = dvbpsi_malloc((i_changes ? i_changes : 1)
+                                   * sizeof(dvbpsi_sdt_service_delta_t));
+    if (p_services == NULL)
+    {
+        dvbpsi_error(p_dvbpsi, "SDT decoder", "out of memory, no delta reported");
+        dvbpsi_free(p_changes);
+        dvbpsi_delta_reset(&p_sdt_decoder->summary);
+        return;
+    }
+
+    for (unsigned int i = 0; i < i_changes; i++)
+    {
+        p_services[i].i_change = p_changes[i].i_change;
+        p_services[i].i_service_id = p_changes[i].i_key;
+    }
+    dvbpsi_free(p_changes);
+
+    dvbpsi_sdt_delta_t delta;
+    delta.b_first = b_first;
+    delta.i_services = i_changes;
+    delta.p_services = p_services;
+
+    dvbpsi_probe_callback_entry("sdt_delta", p_section->i_table_id, p_section->i_extension);
+    p_sdt_decoder->pf_delta_callback(p_sdt_decoder->p_delta_cb_data, &delta);
+    dvbpsi_probe_callback_exit("sdt_delta", p_section->i_table_id, p_section->i_extension);
+    dvbpsi_free(p_services);
+}
+
 /*****************************************************************************
  * dvbpsi_sdt_sections_gather
  *****************************************************************************
@@ -390,6 +549,8 @@ void dvbpsi_sdt_sections_gather(dvbpsi_t *p_dvbpsi,
                 && (p_sdt_decoder->current_sdt.b_current_next == p_section->b_current_next))
             {
                 /* Don't decode since this version is already decoded */
+                p_dvbpsi->stats.i_dropped_duplicate++;
+                dvbpsi_probe_dropped(p_section, "duplicate");
                 dvbpsi_debug(p_dvbpsi, "SDT decoder",
                              "ignoring already decoded section %d",
                              p_section->i_number);
@@ -411,23 +572,78 @@ void dvbpsi_sdt_sections_gather(dvbpsi_t *p_dvbpsi,
     /* Check if we have all the sections */
     if (dvbpsi_decoder_psi_sections_completed(DVBPSI_DECODER(p_sdt_decoder)))
     {
+        p_dvbpsi->stats.i_tables++;
         assert(p_sdt_decoder->pf_sdt_callback);
 
         /* Save the current information */
         p_sdt_decoder->current_sdt = *p_sdt_decoder->p_building_sdt;
         p_sdt_decoder->b_current_valid = true;
-        /* Decode the sections */
-        dvbpsi_sdt_sections_decode(p_sdt_decoder->p_building_sdt,
-                                   p_sdt_decoder->p_sections);
+        if (p_sdt_decoder->pf_delta_callback)
+            dvbpsi_sdt_delta(p_dvbpsi, p_sdt_decoder, p_section);
+        if (p_dvbpsi->i_flags & DVBPSI_FLAG_LAZY_DECODE)
+        {
+            /* Hand the sections over, they are decoded on request */
+            p_sdt_decoder->p_building_sdt->p_sections = p_sdt_decoder->p_sections;
+            p_sdt_decoder->p_sections = NULL;
+        }
+        else
+        {
+            /* Decode the sections, in the arena of the table if any */
+            dvbpsi_intern_t *p_intern = dvbpsi_intern_new(p_dvbpsi);
+            dvbpsi_arena_t *p_previous = dvbpsi_arena_enter(p_sdt_decoder->p_building_sdt->p_arena);
+            dvbpsi_intern_t *p_previous_intern = dvbpsi_intern_enter(p_intern);
+            dvbpsi_sdt_sections_decode(p_sdt_decoder->p_building_sdt,
+                                       p_sdt_decoder->p_sections);
+            if (p_dvbpsi->i_flags & DVBPSI_FLAG_DESCRIPTOR_CACHE)
+                dvbpsi_DecodeSDTDescriptors(p_dvbpsi, p_sdt_decoder);
+            dvbpsi_intern_leave(p_previous_intern);
+            dvbpsi_arena_leave(p_previous);
+            dvbpsi_intern_delete(p_intern);
+        }
         /* signal the new SDT */
+        dvbpsi_probe_callback_entry("sdt", p_section->i_table_id, p_section->i_extension);
         p_sdt_decoder->pf_sdt_callback(p_sdt_decoder->p_cb_data,
                                        p_sdt_decoder->p_building_sdt);
+        dvbpsi_probe_callback_exit("sdt", p_section->i_table_id, p_section->i_extension);
         /* Delete sections and Reinitialize the structures */
         dvbpsi_ReInitSDT(p_sdt_decoder, false);
         assert(p_sdt_decoder->p_sections == NULL);
     }
 }
 
+/*****************************************************************************
+ * dvbpsi_sdt_arrays_size
+ *****************************************************************************
+ * Services and room of the descriptors dvbpsi_sdt_sections_decode() adds,
+ * for DVBPSI_FLAG_TABLE_ARRAYS.
+ *****************************************************************************/
+static size_t dvbpsi_sdt_arrays_size(dvbpsi_psi_section_t *p_section, size_t *pi_span)
+{
+    size_t i_services = 0;
+    *pi_span = 0;
+
+    for (; p_section; p_section = p_section->p_next)
+    {
+        for (uint8_t *p_byte = p_section->p_payload_start + 3;
+             p_byte + 4 < p_section->p_payload_end;)
+        {
+            uint16_t i_srv_length = ((uint16_t)(p_byte[3] & 0xf) <<8) | p_byte[4];
+            i_services++;
+
+            p_byte += 5;
+            uint8_t *p_end = p_byte + i_srv_length;
+            if (p_end > p_section->p_payload_end)
+                break;
+            *pi_span += dvbpsi_arrays_span(p_byte, p_end);
+
+            /* past the last descriptor, as the decoding loop leaves it */
+            while (p_byte + 2 <= p_end)
+                p_byte += 2 + p_byte[1];
+        }
+    }
+    return i_services;
+}
+
 /*****************************************************************************
  * dvbpsi_sdt_sections_decode
  *****************************************************************************
@@ -438,6 +654,13 @@ void dvbpsi_sdt_sections_decode(dvbpsi_sdt_t* p_sdt,
 {
     uint8_t *p_byte, *p_end;
 
+    dvbpsi_arrays_t arrays;
+    size_t i_services = 0, i_span = 0;
+    if (p_sdt->b_arrays)
+        i_services = dvbpsi_sdt_arrays_size(p_section, &i_span);
+    dvbpsi_arrays_new(&arrays, p_sdt->b_arrays ? p_sdt->p_arena : NULL,
+                      i_services, sizeof(dvbpsi_sdt_service_t), i_span);
+
     while (p_section)
     {
         for (p_byte = p_section->p_payload_start + 3;
@@ -449,23 +672,29 @@ void dvbpsi_sdt_sections_decode(dvbpsi_sdt_t* p_sdt,
             uint8_t i_running_status = (uint8_t)(p_byte[3]) >> 5;
             bool b_free_ca = ((p_byte[3] & 0x10) >> 4);
             uint16_t i_srv_length = ((uint16_t)(p_byte[3] & 0xf) <<8) | p_byte[4];
-            dvbpsi_sdt_service_t* p_service = dvbpsi_sdt_service_add(p_sdt,
-                    i_service_id, b_eit_schedule, b_eit_present,
-                    i_running_status, b_free_ca);
+            dvbpsi_sdt_service_t* p_service = dvbpsi_arrays_entry(&arrays);
+            if (p_service)
+            {
+                memset(p_service, 0, sizeof(dvbpsi_sdt_service_t));
+                dvbpsi_sdt_service_append(p_sdt, p_service, i_service_id, b_eit_schedule,
+                                          b_eit_present, i_running_status, b_free_ca);
+                p_sdt->i_service_count++;
+            }
+            else
+                p_service = dvbpsi_sdt_service_add(p_sdt,
+                        i_service_id, b_eit_schedule, b_eit_present,
+                        i_running_status, b_free_ca);
 
             /* Service descriptors */
             p_byte += 5;
             p_end = p_byte + i_srv_length;
             if( p_end > p_section->p_payload_end ) break;
 
-            while(p_byte + 2 <= p_end)
-            {
-                uint8_t i_tag = p_byte[0];
-                uint8_t i_length = p_byte[1];
-                if (i_length + 2 <= p_end - p_byte)
-                    dvbpsi_sdt_service_descriptor_add(p_service, i_tag, i_length, p_byte + 2);
-                p_byte += 2 + i_length;
-            }
+            dvbpsi_arrays_descriptors(&arrays, p_byte, p_end, &p_service->p_first_descriptor,
+                                      &p_service->p_last_descriptor, p_service->p_tags);
+            p_byte = p_end;
+            for (int i = 0; i < DVBPSI_TAGS_SIZE; i++)
+                p_sdt->p_tags[i] |= p_service->p_tags[i];
         }
         p_section = p_section->p_next;
     }
@@ -478,7 +707,7 @@ void dvbpsi_sdt_sections_decode(dvbpsi_sdt_t* p_sdt,
  *****************************************************************************/
 dvbpsi_psi_section_t *dvbpsi_sdt_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_sdt_t* p_sdt)
 {
-    dvbpsi_psi_section_t *p_result = dvbpsi_NewPSISection(1024);
+    dvbpsi_psi_section_t *p_result = dvbpsi_section_buffer_get(p_dvbpsi, 1024);
     dvbpsi_psi_section_t *p_current = p_result;
     dvbpsi_psi_section_t *p_prev;
 
@@ -514,13 +743,14 @@ dvbpsi_psi_section_t *dvbpsi_sdt_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_sd
             p_descriptor = p_descriptor->p_next;
         }
 
-        if ((p_descriptor != NULL) && (p_service_start - p_current->p_data != 11) && (i_service_length <= 1009))
+        if (((p_descriptor != NULL) || ((p_service_start - p_current->p_data) + i_service_length > 1020))
+         && (p_service_start - p_current->p_data != 11) && (i_service_length <= 1009))
         {
             /* will put more descriptors in an empty section */
             dvbpsi_debug(p_dvbpsi, "SDT generator","create a new section to carry more Service descriptors");
 
             p_prev = p_current;
-            p_current = dvbpsi_NewPSISection(1024);
+            p_current = dvbpsi_section_buffer_get(p_dvbpsi, 1024);
             p_prev->p_next = p_current;
 
             p_current->i_table_id = 0x42;
@@ -586,3 +816,35 @@ dvbpsi_psi_section_t *dvbpsi_sdt_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_sd
     }
     return p_result;
 }
+
+/*****************************************************************************
+ * dvbpsi_sdt_sections_generate_into
+ *****************************************************************************
+ * Generate SDT sections into a caller buffer.
+ *****************************************************************************/
+int dvbpsi_sdt_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_sdt_t *p_sdt,
+                                      dvbpsi_section_buffer_t *p_buffer)
+{
+    dvbpsi_section_buffer_begin(p_dvbpsi, p_buffer);
+    return dvbpsi_section_buffer_end(p_dvbpsi,
+                dvbpsi_sdt_sections_generate(p_dvbpsi, p_sdt));
+}
+
+/*****************************************************************************
+ * dvbpsi_sdt_section_iter
+ *****************************************************************************
+ * Sets up iterators over the raw loops of a SDT section.
+ *****************************************************************************/
+bool dvbpsi_sdt_section_iter(dvbpsi_psi_section_t *p_section,
+                             dvbpsi_entry_iter_t *p_services)
+{
+    assert(p_section);
+
+    uint8_t *p_byte = p_section->p_payload_start;
+    uint8_t *p_end = p_section->p_payload_end;
+    if (p_end - p_byte < 3)
+        return false;
+
+    dvbpsi_entry_iter_init(p_services, p_byte + 3, p_end - p_byte - 3, 5, 3);
+    return true;
+}
@@ -64,6 +64,9 @@ typedef struct dvbpsi_sdt_service_s
                                                          length */
   dvbpsi_descriptor_t *     p_first_descriptor;     /*!< First of the following
                                                          DVB descriptors */
+  dvbpsi_descriptor_t *     p_last_descriptor;      /*!< private, list tail */
+  uint8_t                   p_tags[DVBPSI_TAGS_SIZE]; /*!< tags present in
+                                     the list, see dvbpsi_has_descriptor() */
 
   struct dvbpsi_sdt_service_s * p_next;             /*!< next element of
                                                              the list */
@@ -97,6 +100,16 @@ typedef struct dvbpsi_sdt_s
 
     dvbpsi_sdt_service_t *    p_first_service;    /*!< service description
                                                      list */
+    dvbpsi_sdt_service_t *    p_last_service;     /*!< private, list tail */
+    uint16_t                  i_service_count;    /*!< services of the array
+                                                     at p_first_service, see
+                                                     DVBPSI_FLAG_TABLE_ARRAYS */
+    bool                      b_arrays;           /*!< private, see DVBPSI_FLAG_TABLE_ARRAYS */
+    uint8_t                   p_tags[DVBPSI_TAGS_SIZE]; /*!< tags present in
+                                     the descriptors of any decoded service,
+                                     see dvbpsi_has_descriptor() */
+    struct dvbpsi_arena_s *   p_arena;            /*!< private, see DVBPSI_FLAG_TABLE_ARENA */
+    dvbpsi_psi_section_t *    p_sections;         /*!< raw sections, see DVBPSI_FLAG_LAZY_DECODE */
 
 } dvbpsi_sdt_t;
 
@@ -142,6 +155,82 @@ bool dvbpsi_sdt_attach(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_extens
  */
 void dvbpsi_sdt_detach(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_extension);
 
+/*****************************************************************************
+ * dvbpsi_sdt_delta_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_sdt_service_delta_s
+ * \brief Change of a service, identified by its service_id.
+ */
+/*!
+ * \typedef struct dvbpsi_sdt_service_delta_s dvbpsi_sdt_service_delta_t
+ * \brief dvbpsi_sdt_service_delta_t type definition.
+ */
+typedef struct dvbpsi_sdt_service_delta_s
+{
+    enum dvbpsi_entry_change  i_change;         /*!< kind of change */
+    uint16_t                  i_service_id;     /*!< service_id */
+} dvbpsi_sdt_service_delta_t;
+
+/*!
+ * \struct dvbpsi_sdt_delta_s
+ * \brief Changes of a SDT since the version previously decoded.
+ */
+/*!
+ * \typedef struct dvbpsi_sdt_delta_s dvbpsi_sdt_delta_t
+ * \brief dvbpsi_sdt_delta_t type definition.
+ */
+typedef struct dvbpsi_sdt_delta_s
+{
+    bool                              b_first;      /*!< no previous version,
+                                                         all the services are
+                                                         added */
+    unsigned int                      i_services;   /*!< number of changed
+                                                         services */
+    const dvbpsi_sdt_service_delta_t *p_services;   /*!< changed services,
+                                                         removed ones first */
+} dvbpsi_sdt_delta_t;
+
+/*****************************************************************************
+ * dvbpsi_sdt_delta_callback
+ *****************************************************************************/
+/*!
+ * \typedef void (* dvbpsi_sdt_delta_callback)(void* p_cb_data,
+ *                                             const dvbpsi_sdt_delta_t *p_delta)
+ * \brief Delta callback type definition, p_delta being only valid during
+ * the call.
+ */
+typedef void (* dvbpsi_sdt_delta_callback)(void* p_cb_data,
+                                           const dvbpsi_sdt_delta_t *p_delta);
+
+/*****************************************************************************
+ * dvbpsi_sdt_set_delta_callback
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_sdt_set_delta_callback(dvbpsi_t *p_dvbpsi,
+ *                                        uint8_t i_table_id, uint16_t i_extension,
+ *                                        dvbpsi_sdt_delta_callback pf_callback,
+ *                                        void* p_cb_data)
+ * \brief Reports the changes of each new SDT of a decoder
+ * \param p_dvbpsi handle with a subtable demux
+ * \param i_table_id Table ID, 0x42 or 0x46.
+ * \param i_extension Table ID extension, here TS ID.
+ * \param pf_callback function called right before the SDT callback, with
+ *        the changes of the new version, NULL for none
+ * \param p_cb_data private data given in argument to the callback
+ * \return false if there is no such SDT decoder, true otherwise.
+ *
+ * The decoder keeps, for the version it last signalled, a 64 bits hash of
+ * the bytes of each service, sorted by service_id, and compares the raw
+ * sections of the new version against them: a service is modified when
+ * anything from its EIT flags to its descriptors changed, such as its
+ * name. A version whose services are all unchanged has an empty delta.
+ */
+bool dvbpsi_sdt_set_delta_callback(dvbpsi_t *p_dvbpsi,
+                                   uint8_t i_table_id, uint16_t i_extension,
+                                   dvbpsi_sdt_delta_callback pf_callback,
+                                   void* p_cb_data);
+
 /*****************************************************************************
  * dvbpsi_sdt_init/dvbpsi_NewSDT
  *****************************************************************************/
@@ -193,6 +282,20 @@ void dvbpsi_sdt_empty(dvbpsi_sdt_t *p_sdt);
  */
 void dvbpsi_sdt_delete(dvbpsi_sdt_t *p_sdt);
 
+/*****************************************************************************
+ * dvbpsi_sdt_decode
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_sdt_decode(dvbpsi_sdt_t *p_sdt)
+ * \brief Decodes the raw sections of a SDT received with DVBPSI_FLAG_LAZY_DECODE
+ * \param p_sdt pointer to the SDT structure
+ * \return nothing.
+ *
+ * Decodes the services from dvbpsi_sdt_t::p_sections and releases the
+ * sections. Does nothing when the SDT has no raw sections.
+ */
+void dvbpsi_sdt_decode(dvbpsi_sdt_t *p_sdt);
+
 /*****************************************************************************
  * dvbpsi_sdt_service_add
  *****************************************************************************/
@@ -253,6 +356,42 @@ dvbpsi_descriptor_t *dvbpsi_sdt_service_descriptor_add(
  */
 dvbpsi_psi_section_t *dvbpsi_sdt_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_sdt_t * p_sdt);
 
+/*****************************************************************************
+ * dvbpsi_sdt_sections_generate_into
+ *****************************************************************************/
+/*!
+ * \fn int dvbpsi_sdt_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_sdt_t *p_sdt,
+ *                                          dvbpsi_section_buffer_t *p_buffer)
+ * \brief SDT generator writing into caller memory
+ * \param p_dvbpsi handle to dvbpsi with attached decoder
+ * \param p_sdt pointer to the SDT structure
+ * \param p_buffer buffer the sections are written into, its previous
+ *        sections are overwritten
+ * \return the number of sections written, linked from p_buffer->p_sections,
+ *         or -1 on error or if the buffer is too small.
+ *
+ * Same encoding as dvbpsi_sdt_sections_generate(), without any allocation.
+ */
+int dvbpsi_sdt_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_sdt_t *p_sdt,
+                                      dvbpsi_section_buffer_t *p_buffer);
+
+/*****************************************************************************
+ * dvbpsi_sdt_section_iter
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_sdt_section_iter(dvbpsi_psi_section_t *p_section,
+ *                                  dvbpsi_entry_iter_t *p_services)
+ * \brief Iterates over a SDT section without decoding it
+ * \param p_section SDT section
+ * \param p_services set up for the services
+ * \return false if the section is too short for a SDT section.
+ *
+ * A service header is the 5 bytes from service_id to
+ * descriptors_loop_length.
+ */
+bool dvbpsi_sdt_section_iter(dvbpsi_psi_section_t *p_section,
+                             dvbpsi_entry_iter_t *p_services);
+
 #ifdef __cplusplus
 };
 #endif
@@ -43,6 +43,11 @@ typedef struct dvbpsi_sdt_decoder_s
     dvbpsi_sdt_t                  current_sdt;
     dvbpsi_sdt_t *                p_building_sdt;
 
+    /* Summary of the last SDT signalled, for the delta callback */
+    dvbpsi_sdt_delta_callback     pf_delta_callback;
+    void *                        p_delta_cb_data;
+    dvbpsi_delta_summary_t        summary;
+
 } dvbpsi_sdt_decoder_t;
 
 /*****************************************************************************
@@ -40,10 +40,12 @@
 #include <assert.h>
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_TABLE
 #include "../dvbpsi_private.h"
 #include "../psi.h"
 #include "../descriptor.h"
 #include "../demux.h"
+#include "../crc32_private.h"
 
 #include "sis.h"
 #include "sis_private.h"
@@ -94,6 +96,8 @@ bool dvbpsi_sis_attach(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_extens
     /* SIS decoder information */
     p_sis_decoder->pf_sis_callback = pf_callback;
     p_sis_decoder->p_cb_data = p_cb_data;
+    p_sis_decoder->pf_splice_callback = NULL;
+    p_sis_decoder->p_splice_cb_data = NULL;
     p_sis_decoder->p_building_sis = NULL;
 
     return true;
@@ -135,6 +139,293 @@ void dvbpsi_sis_detach(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_extens
     dvbpsi_DeleteDemuxSubDecoder(p_subdec);
 }
 
+/*****************************************************************************
+ * dvbpsi_sis_set_splice_callback
+ *****************************************************************************
+ * Set the function signalling each splice_info_section of a SIS decoder.
+ *****************************************************************************/
+bool dvbpsi_sis_set_splice_callback(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                                    uint16_t i_extension,
+                                    dvbpsi_sis_splice_callback pf_callback,
+                                    void* p_cb_data)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    dvbpsi_demux_t *p_demux = (dvbpsi_demux_t *) p_dvbpsi->p_decoder;
+
+    i_extension = 0;
+    dvbpsi_demux_subdec_t* p_subdec = dvbpsi_demuxGetSubDec(p_demux, i_table_id, i_extension);
+    if (p_subdec == NULL)
+        return false;
+
+    dvbpsi_sis_decoder_t* p_sis_decoder = (dvbpsi_sis_decoder_t*)p_subdec->p_decoder;
+    p_sis_decoder->pf_splice_callback = pf_callback;
+    p_sis_decoder->p_splice_cb_data = p_cb_data;
+    return true;
+}
+
+/* 33 bits field starting at the last bit of p_byte[0] */
+static inline uint64_t dvbpsi_sis_33bits(const uint8_t *p_byte)
+{
+    return ((uint64_t)(p_byte[0] & 0x01) << 32) | ((uint64_t)p_byte[1] << 24)
+         | ((uint64_t)p_byte[2] << 16) | ((uint64_t)p_byte[3] << 8) | p_byte[4];
+}
+
+/*****************************************************************************
+ * dvbpsi_sis_splice_time
+ *****************************************************************************
+ * Decodes a splice_time() into p_splice unless NULL. Returns its size, or 0
+ * if truncated.
+ *****************************************************************************/
+static size_t dvbpsi_sis_splice_time(const uint8_t *p_byte, const uint8_t *p_end,
+                                     dvbpsi_sis_splice_t *p_splice)
+{
+    if (p_byte >= p_end)
+        return 0;
+    if (!(p_byte[0] & 0x80))
+        return 1;
+    if (p_end - p_byte < 5)
+        return 0;
+
+    if (p_splice)
+    {
+        p_splice->b_time_specified = true;
+        p_splice->i_pts_time = (dvbpsi_sis_33bits(p_byte) + p_splice->i_pts_adjustment)
+                             & UINT64_C(0x1ffffffff);
+    }
+    return 5;
+}
+
+/*****************************************************************************
+ * dvbpsi_sis_splice_insert
+ *****************************************************************************
+ * Decodes a splice_insert(). Returns the byte after it, or NULL if
+ * truncated.
+ *****************************************************************************/
+static const uint8_t *dvbpsi_sis_splice_insert(const uint8_t *p_byte, const uint8_t *p_end,
+                                               dvbpsi_sis_splice_t *p_splice)
+{
+    if (p_end - p_byte < 5)
+        return NULL;
+    p_splice->i_splice_event_id = ((uint32_t)p_byte[0] << 24) | ((uint32_t)p_byte[1] << 16)
+                                | ((uint32_t)p_byte[2] << 8) | p_byte[3];
+    p_splice->b_splice_event_cancel = (p_byte[4] & 0x80) != 0;
+    p_byte += 5;
+    if (p_splice->b_splice_event_cancel)
+        return p_byte;
+
+    if (p_byte >= p_end)
+        return NULL;
+    p_splice->b_out_of_network = (p_byte[0] & 0x80) != 0;
+    p_splice->b_program_splice = (p_byte[0] & 0x40) != 0;
+    p_splice->b_duration = (p_byte[0] & 0x20) != 0;
+    p_splice->b_splice_immediate = (p_byte[0] & 0x10) != 0;
+    p_byte++;
+
+    if (p_splice->b_program_splice && !p_splice->b_splice_immediate)
+    {
+        size_t i_size = dvbpsi_sis_splice_time(p_byte, p_end, p_splice);
+        if (i_size == 0)
+            return NULL;
+        p_byte += i_size;
+    }
+    else if (!p_splice->b_program_splice)
+    {
+        if (p_byte >= p_end)
+            return NULL;
+        p_splice->i_component_count = *p_byte++;
+
+        /* component_tag and splice_time(), the first one being kept */
+        for (unsigned int i = 0; i < p_splice->i_component_count; i++)
+        {
+            if (p_byte >= p_end)
+                return NULL;
+            p_byte++;
+            if (!p_splice->b_splice_immediate)
+            {
+                size_t i_size = dvbpsi_sis_splice_time(p_byte, p_end, i ? NULL : p_splice);
+                if (i_size == 0)
+                    return NULL;
+                p_byte += i_size;
+            }
+        }
+    }
+
+    if (p_splice->b_duration)
+    {
+        if (p_end - p_byte < 5)
+            return NULL;
+        p_splice->b_auto_return = (p_byte[0] & 0x80) != 0;
+        p_splice->i_break_duration = dvbpsi_sis_33bits(p_byte);
+        p_byte += 5;
+    }
+
+    if (p_end - p_byte < 4)
+        return NULL;
+    p_splice->i_unique_program_id = ((uint16_t)p_byte[0] << 8) | p_byte[1];
+    p_splice->i_avail_num = p_byte[2];
+    p_splice->i_avails_expected = p_byte[3];
+    return p_byte + 4;
+}
+
+/*****************************************************************************
+ * dvbpsi_sis_segmentation
+ *****************************************************************************
+ * Adds the essentials of a segmentation_descriptor, ignoring it if
+ * malformed.
+ *****************************************************************************/
+static void dvbpsi_sis_segmentation(const uint8_t *p_byte, uint8_t i_length,
+                                    dvbpsi_sis_splice_t *p_splice)
+{
+    const uint8_t *p_end = p_byte + i_length;
+
+    /* identifier "CUEI" */
+    if (i_length < 9 || memcmp(p_byte, "CUEI", 4) != 0)
+        return;
+
+    dvbpsi_sis_segmentation_t segmentation;
+    memset(&segmentation, 0, sizeof(segmentation));
+    segmentation.i_event_id = ((uint32_t)p_byte[4] << 24) | ((uint32_t)p_byte[5] << 16)
+                            | ((uint32_t)p_byte[6] << 8) | p_byte[7];
+    segmentation.b_cancel = (p_byte[8] & 0x80) != 0;
+    p_byte += 9;
+
+    if (!segmentation.b_cancel)
+    {
+        if (p_byte >= p_end)
+            return;
+        segmentation.b_program_segmentation = (p_byte[0] & 0x80) != 0;
+        segmentation.b_duration = (p_byte[0] & 0x40) != 0;
+        p_byte++;
+
+        /* component_tag and pts_offset of each component */
+        if (!segmentation.b_program_segmentation)
+        {
+            if (p_byte >= p_end || p_end - p_byte - 1 < 6 * p_byte[0])
+                return;
+            p_byte += 1 + 6 * p_byte[0];
+        }
+
+        if (segmentation.b_duration)
+        {
+            if (p_end - p_byte < 5)
+                return;
+            segmentation.i_duration = ((uint64_t)p_byte[0] << 32) | ((uint64_t)p_byte[1] << 24)
+                                    | ((uint64_t)p_byte[2] << 16) | ((uint64_t)p_byte[3] << 8)
+                                    | p_byte[4];
+            p_byte += 5;
+        }
+
+        if (p_end - p_byte < 2)
+            return;
+        segmentation.i_upid_type = p_byte[0];
+        segmentation.i_upid_length = p_byte[1];
+        p_byte += 2;
+        if (p_end - p_byte < segmentation.i_upid_length + 3)
+            return;
+        segmentation.p_upid = p_byte;
+        p_byte += segmentation.i_upid_length;
+
+        segmentation.i_type_id = p_byte[0];
+        segmentation.i_segment_num = p_byte[1];
+        segmentation.i_segments_expected = p_byte[2];
+    }
+
+    p_splice->segmentations[p_splice->i_segmentations++] = segmentation;
+}
+
+/*****************************************************************************
+ * dvbpsi_sis_splice_parse
+ *****************************************************************************
+ * Decode the essentials of a splice_info_section from its bytes.
+ *****************************************************************************/
+bool dvbpsi_sis_splice_parse(const uint8_t *p_data, size_t i_size,
+                             dvbpsi_sis_splice_t *p_splice)
+{
+    assert(p_data);
+    assert(p_splice);
+
+    memset(p_splice, 0, sizeof(dvbpsi_sis_splice_t));
+    if (i_size < 3 || p_data[0] != 0xFC)
+        return false;
+
+    /* Header up to splice_command_type, descriptor_loop_length and CRC_32 */
+    size_t i_length = 3 + ((((size_t)p_data[1] & 0x0f) << 8) | p_data[2]);
+    if (i_length > i_size || i_length < 20)
+        return false;
+    if (dvbpsi_crc32(0xffffffff, p_data, i_length) != 0)
+        return false;
+
+    p_splice->i_protocol_version = p_data[3];
+    p_splice->b_encrypted = (p_data[4] & 0x80) != 0;
+    p_splice->i_pts_adjustment = dvbpsi_sis_33bits(p_data + 4);
+    p_splice->i_tier = ((uint16_t)p_data[10] << 4) | (p_data[11] >> 4);
+
+    /* The splice command and descriptors are encrypted */
+    if (p_splice->b_encrypted)
+        return true;
+
+    size_t i_command_length = ((size_t)(p_data[11] & 0x0f) << 8) | p_data[12];
+    p_splice->i_splice_command_type = p_data[13];
+
+    const uint8_t *p_byte = p_data + 14;
+    const uint8_t *p_end = p_data + i_length - 4;
+    const uint8_t *p_next = NULL;
+    switch (p_splice->i_splice_command_type)
+    {
+        case 0x00: /* splice_null */
+            p_next = p_byte;
+            break;
+        case 0x05: /* splice_insert */
+            p_next = dvbpsi_sis_splice_insert(p_byte, p_end, p_splice);
+            if (p_next == NULL)
+                return false;
+            break;
+        case 0x06: /* time_signal */
+        {
+            size_t i_time_size = dvbpsi_sis_splice_time(p_byte, p_end, p_splice);
+            if (i_time_size == 0)
+                return false;
+            p_next = p_byte + i_time_size;
+            break;
+        }
+        default:
+            break;
+    }
+
+    /* A splice_command_length of 0xfff leaves the length to the command */
+    if (i_command_length != 0xfff)
+    {
+        if (i_command_length > (size_t)(p_end - p_byte))
+            return false;
+        p_next = p_byte + i_command_length;
+    }
+    if (p_next == NULL)
+        return true;
+
+    /* Segmentation descriptors */
+    if (p_end - p_next < 2)
+        return false;
+    size_t i_loop_length = ((size_t)p_next[0] << 8) | p_next[1];
+    p_byte = p_next + 2;
+    if (i_loop_length > (size_t)(p_end - p_byte))
+        return false;
+
+    const uint8_t *p_loop_end = p_byte + i_loop_length;
+    while (p_loop_end - p_byte >= 2)
+    {
+        uint8_t i_tag = p_byte[0];
+        uint8_t i_desc_length = p_byte[1];
+        if (i_desc_length > p_loop_end - p_byte - 2)
+            break;
+        if (i_tag == 0x02 && p_splice->i_segmentations < DVBPSI_SIS_SPLICE_SEGMENTATIONS)
+            dvbpsi_sis_segmentation(p_byte + 2, i_desc_length, p_splice);
+        p_byte += 2 + i_desc_length;
+    }
+    return true;
+}
+
 /*****************************************************************************
  * dvbpsi_sis_init
  *****************************************************************************
@@ -168,6 +459,7 @@ void dvbpsi_sis_init(dvbpsi_sis_t *p_sis, uint8_t i_table_id, uint16_t i_extensi
     /* descriptors */
     p_sis->i_descriptors_length = 0;
     p_sis->p_first_descriptor = NULL;
+    p_sis->p_last_descriptor = NULL;
 
     /* FIXME: alignment stuffing */
 
@@ -182,7 +474,7 @@ void dvbpsi_sis_init(dvbpsi_sis_t *p_sis, uint8_t i_table_id, uint16_t i_extensi
 dvbpsi_sis_t* dvbpsi_sis_new(uint8_t i_table_id, uint16_t i_extension, uint8_t i_version,
                              bool b_current_next, uint8_t i_protocol_version)
 {
-    dvbpsi_sis_t* p_sis = (dvbpsi_sis_t*)malloc(sizeof(dvbpsi_sis_t));
+    dvbpsi_sis_t* p_sis = (dvbpsi_sis_t*)dvbpsi_malloc(sizeof(dvbpsi_sis_t));
     if (p_sis != NULL)
         dvbpsi_sis_init(p_sis, i_table_id, i_extension, i_version,
                         b_current_next, i_protocol_version);
@@ -200,6 +492,7 @@ void dvbpsi_sis_empty(dvbpsi_sis_t* p_sis)
 
     dvbpsi_DeleteDescriptors(p_sis->p_first_descriptor);
     p_sis->p_first_descriptor = NULL;
+    p_sis->p_last_descriptor = NULL;
 
     /* FIXME: free alignment stuffing */
 }
@@ -213,7 +506,7 @@ void dvbpsi_sis_delete(dvbpsi_sis_t *p_sis)
 {
     if (p_sis)
         dvbpsi_sis_empty(p_sis);
-    free(p_sis);
+    dvbpsi_free(p_sis);
 }
 
 /*****************************************************************************
@@ -230,11 +523,7 @@ dvbpsi_descriptor_t *dvbpsi_sis_descriptor_add(dvbpsi_sis_t *p_sis,
     if (p_descriptor == NULL)
         return NULL;
 
-    p_sis->p_first_descriptor = dvbpsi_AddDescriptor(p_sis->p_first_descriptor,
-                                                     p_descriptor);
-    assert(p_sis->p_first_descriptor);
-    if (p_sis->p_first_descriptor == NULL)
-        return NULL;
+    dvbpsi_list_append(p_sis->p_first_descriptor, p_sis->p_last_descriptor, p_descriptor);
 
     return p_descriptor;
 }
@@ -335,6 +624,25 @@ void dvbpsi_sis_sections_gather(dvbpsi_t *p_dvbpsi,
     assert(p_dvbpsi);
     assert(p_dvbpsi->p_decoder);
 
+    dvbpsi_sis_decoder_t * p_sis_decoder = (dvbpsi_sis_decoder_t*)p_decoder;
+
+    /* Low latency path, straight from the section bytes */
+    if (p_sis_decoder->pf_splice_callback)
+    {
+        dvbpsi_sis_splice_t splice;
+        if (dvbpsi_sis_splice_parse(p_section->p_data, 3 + p_section->i_length, &splice))
+        {
+            dvbpsi_probe_callback_entry("sis_splice", p_section->i_table_id, p_section->i_extension);
+            p_sis_decoder->pf_splice_callback(p_sis_decoder->p_splice_cb_data, &splice);
+            dvbpsi_probe_callback_exit("sis_splice", p_section->i_table_id, p_section->i_extension);
+        }
+    }
+    if (p_sis_decoder->pf_sis_callback == NULL)
+    {
+        dvbpsi_DeletePSISections(p_section);
+        return;
+    }
+
     if (!dvbpsi_CheckPSISection(p_dvbpsi, p_section, 0xFC, "SIS decoder"))
     {
         dvbpsi_DeletePSISections(p_section);
@@ -343,7 +651,6 @@ void dvbpsi_sis_sections_gather(dvbpsi_t *p_dvbpsi,
 
     /* */
     dvbpsi_demux_t *p_demux = (dvbpsi_demux_t *) p_dvbpsi->p_decoder;
-    dvbpsi_sis_decoder_t * p_sis_decoder = (dvbpsi_sis_decoder_t*)p_decoder;
 
     if (p_section->b_private_indicator)
     {
@@ -376,6 +683,8 @@ void dvbpsi_sis_sections_gather(dvbpsi_t *p_dvbpsi,
                  && (p_sis_decoder->current_sis.b_current_next == p_section->b_current_next))
              {
                  /* Don't decode since this version is already decoded */
+                 p_dvbpsi->stats.i_dropped_duplicate++;
+                 dvbpsi_probe_dropped(p_section, "duplicate");
                  dvbpsi_debug(p_dvbpsi, "SIT decoder",
                              "ignoring already decoded section %d",
                              p_section->i_number);
@@ -397,6 +706,7 @@ void dvbpsi_sis_sections_gather(dvbpsi_t *p_dvbpsi,
     /* Check if we have all the sections */
     if (dvbpsi_decoder_psi_sections_completed(DVBPSI_DECODER(p_sis_decoder)))
     {
+        p_dvbpsi->stats.i_tables++;
         assert(p_sis_decoder->pf_sis_callback);
 
         /* Save the current information */
@@ -406,8 +716,10 @@ void dvbpsi_sis_sections_gather(dvbpsi_t *p_dvbpsi,
         dvbpsi_sis_sections_decode(p_dvbpsi, p_sis_decoder->p_building_sis,
                                    p_sis_decoder->p_sections);
         /* signal the new SDT */
+        dvbpsi_probe_callback_entry("sis", p_section->i_table_id, p_section->i_extension);
         p_sis_decoder->pf_sis_callback(p_sis_decoder->p_cb_data,
                                        p_sis_decoder->p_building_sis);
+        dvbpsi_probe_callback_exit("sis", p_section->i_table_id, p_section->i_extension);
         /* Delete sections and Reinitialize the structures */
         dvbpsi_ReInitSIS(p_sis_decoder, false);
         assert(p_sis_decoder->p_sections == NULL);
@@ -508,7 +820,7 @@ void dvbpsi_sis_sections_decode(dvbpsi_t* p_dvbpsi, dvbpsi_sis_t* p_sis,
  *****************************************************************************/
 dvbpsi_psi_section_t *dvbpsi_sis_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_sis_t* p_sis)
 {
-    dvbpsi_psi_section_t * p_current = dvbpsi_NewPSISection(1024);
+    dvbpsi_psi_section_t * p_current = dvbpsi_section_buffer_get(p_dvbpsi, 1024);
 
     p_current->i_table_id = 0xFC;
     p_current->b_syntax_indicator = false;
@@ -576,3 +888,16 @@ dvbpsi_psi_section_t *dvbpsi_sis_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_si
     dvbpsi_BuildPSISection(p_dvbpsi, p_current);
     return p_current;
 }
+
+/*****************************************************************************
+ * dvbpsi_sis_sections_generate_into
+ *****************************************************************************
+ * Generate SIS sections into a caller buffer.
+ *****************************************************************************/
+int dvbpsi_sis_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_sis_t *p_sis,
+                                      dvbpsi_section_buffer_t *p_buffer)
+{
+    dvbpsi_section_buffer_begin(p_dvbpsi, p_buffer);
+    return dvbpsi_section_buffer_end(p_dvbpsi,
+                dvbpsi_sis_sections_generate(p_dvbpsi, p_sis));
+}
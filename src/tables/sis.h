@@ -96,6 +96,7 @@ typedef struct dvbpsi_sis_s
                                                          length */
   dvbpsi_descriptor_t       *p_first_descriptor;     /*!< First of the following
                                                           SIS descriptors */
+  dvbpsi_descriptor_t       *p_last_descriptor;      /*!< private, list tail */
 
   /* FIXME: alignment stuffing */
   uint32_t i_ecrc; /*!< CRC 32 of decrypted splice_info_section */
@@ -357,7 +358,8 @@ typedef void (* dvbpsi_sis_callback)(void* p_cb_data, dvbpsi_sis_t* p_new_sis);
  * \param p_dvbpsi pointer to dvbpsi to hold decoder/demuxer structure
  * \param i_table_id Table ID, 0xFC.
  * \param i_extension Table ID extension.
- * \param pf_callback function to call back on new SIS.
+ * \param pf_callback function to call back on new SIS, NULL when only
+ *        dvbpsi_sis_set_splice_callback() is used.
  * \param p_cb_data private data given in argument to the callback.
  * \return true on success, false on failure
  */
@@ -378,6 +380,152 @@ bool dvbpsi_sis_attach(dvbpsi_t* p_dvbpsi, uint8_t i_table_id, uint16_t i_extens
  */
 void dvbpsi_sis_detach(dvbpsi_t *p_dvbpsi, uint8_t i_table_id, uint16_t i_extension);
 
+/*****************************************************************************
+ * dvbpsi_sis_splice_t
+ *****************************************************************************/
+/*!
+ * \def DVBPSI_SIS_SPLICE_SEGMENTATIONS
+ * \brief Maximum number of segmentation descriptors of a
+ * dvbpsi_sis_splice_t
+ */
+#define DVBPSI_SIS_SPLICE_SEGMENTATIONS 4
+
+/*!
+ * \struct dvbpsi_sis_segmentation_s
+ * \brief Essentials of a segmentation_descriptor (SCTE 35 section 10.3.3).
+ */
+/*!
+ * \typedef struct dvbpsi_sis_segmentation_s dvbpsi_sis_segmentation_t
+ * \brief dvbpsi_sis_segmentation_t type definition.
+ */
+typedef struct dvbpsi_sis_segmentation_s
+{
+    uint32_t        i_event_id;             /*!< segmentation_event_id */
+    bool            b_cancel;               /*!< segmentation_event_cancel_indicator,
+                                                 the next members being 0
+                                                 when set */
+    bool            b_program_segmentation; /*!< program_segmentation_flag */
+    bool            b_duration;             /*!< segmentation_duration_flag */
+    uint64_t        i_duration;             /*!< segmentation_duration, in
+                                                 90 kHz ticks */
+    uint8_t         i_upid_type;            /*!< segmentation_upid_type */
+    uint8_t         i_upid_length;          /*!< segmentation_upid_length */
+    const uint8_t  *p_upid;                 /*!< segmentation_upid, in the
+                                                 section */
+    uint8_t         i_type_id;              /*!< segmentation_type_id */
+    uint8_t         i_segment_num;          /*!< segment_num */
+    uint8_t         i_segments_expected;    /*!< segments_expected */
+} dvbpsi_sis_segmentation_t;
+
+/*!
+ * \struct dvbpsi_sis_splice_s
+ * \brief Essentials of a splice_info_section, decoded without allocation.
+ */
+/*!
+ * \typedef struct dvbpsi_sis_splice_s dvbpsi_sis_splice_t
+ * \brief dvbpsi_sis_splice_t type definition.
+ */
+typedef struct dvbpsi_sis_splice_s
+{
+    uint8_t         i_protocol_version;     /*!< protocol_version */
+    bool            b_encrypted;            /*!< encrypted_packet, the splice
+                                                 command and descriptors being
+                                                 then left out */
+    uint64_t        i_pts_adjustment;       /*!< pts_adjustment */
+    uint16_t        i_tier;                 /*!< tier */
+    uint8_t         i_splice_command_type;  /*!< splice_command_type, 0x05
+                                                 for splice_insert() and 0x06
+                                                 for time_signal() */
+
+    /* splice_insert() */
+    uint32_t        i_splice_event_id;      /*!< splice_event_id */
+    bool            b_splice_event_cancel;  /*!< splice_event_cancel_indicator */
+    bool            b_out_of_network;       /*!< out_of_network_indicator */
+    bool            b_program_splice;       /*!< program_splice_flag */
+    bool            b_splice_immediate;     /*!< splice_immediate_flag */
+    uint8_t         i_component_count;      /*!< component_count without
+                                                 program_splice_flag */
+    bool            b_duration;             /*!< duration_flag */
+    bool            b_auto_return;          /*!< auto_return of the
+                                                 break_duration() */
+    uint64_t        i_break_duration;       /*!< duration of the
+                                                 break_duration(), in 90 kHz
+                                                 ticks */
+    uint16_t        i_unique_program_id;    /*!< unique_program_id */
+    uint8_t         i_avail_num;            /*!< avail_num */
+    uint8_t         i_avails_expected;      /*!< avails_expected */
+
+    /* splice_time() of a splice_insert() or time_signal() */
+    bool            b_time_specified;       /*!< time_specified_flag */
+    uint64_t        i_pts_time;             /*!< pts_time plus pts_adjustment,
+                                                 modulo 2^33 */
+
+    /* Segmentation descriptors */
+    unsigned int    i_segmentations;        /*!< number of segmentations */
+    dvbpsi_sis_segmentation_t segmentations[DVBPSI_SIS_SPLICE_SEGMENTATIONS];
+                                            /*!< first segmentation
+                                                 descriptors of the section */
+} dvbpsi_sis_splice_t;
+
+/*****************************************************************************
+ * dvbpsi_sis_splice_callback
+ *****************************************************************************/
+/*!
+ * \typedef void (* dvbpsi_sis_splice_callback)(void* p_cb_data,
+ *                                              const dvbpsi_sis_splice_t* p_splice)
+ * \brief Splice callback type definition, see
+ * dvbpsi_sis_set_splice_callback().
+ */
+typedef void (* dvbpsi_sis_splice_callback)(void* p_cb_data,
+                                            const dvbpsi_sis_splice_t* p_splice);
+
+/*****************************************************************************
+ * dvbpsi_sis_set_splice_callback
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_sis_set_splice_callback(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+ *                                         uint16_t i_extension,
+ *                                         dvbpsi_sis_splice_callback pf_callback,
+ *                                         void* p_cb_data)
+ * \brief Signals each splice_info_section of a SIS decoder as soon as it is
+ * received, decoded straight from its bytes
+ * \param p_dvbpsi pointer to dvbpsi to hold decoder/demuxer structure
+ * \param i_table_id Table ID, 0xFC.
+ * \param i_extension Table ID extension.
+ * \param pf_callback function called with the essentials of the section,
+ *        valid until it returns, NULL for none
+ * \param p_cb_data private data given in argument to the callback
+ * \return false if there is no such SIS decoder, true otherwise.
+ *
+ * Every valid section is signalled, the repetitions of a splice event
+ * included, without any allocation. The callback of dvbpsi_sis_attach(),
+ * which may then be NULL, is still called with the decoded dvbpsi_sis_t.
+ */
+bool dvbpsi_sis_set_splice_callback(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                                    uint16_t i_extension,
+                                    dvbpsi_sis_splice_callback pf_callback,
+                                    void* p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_sis_splice_parse
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_sis_splice_parse(const uint8_t *p_data, size_t i_size,
+ *                                  dvbpsi_sis_splice_t *p_splice)
+ * \brief Decodes the essentials of a splice_info_section from its bytes
+ * \param p_data the section, from its table_id
+ * \param i_size number of bytes at p_data, at least the section
+ * \param p_splice filled with the essentials, its p_upid pointing into
+ *        p_data
+ * \return false if the section is truncated, malformed or fails its CRC_32,
+ *         true otherwise.
+ *
+ * The segmentation descriptors after the first
+ * DVBPSI_SIS_SPLICE_SEGMENTATIONS are ignored.
+ */
+bool dvbpsi_sis_splice_parse(const uint8_t *p_data, size_t i_size,
+                             dvbpsi_sis_splice_t *p_splice);
+
 /*****************************************************************************
  * dvbpsi_sis_init/dvbpsi_sis_new
  *****************************************************************************/
@@ -463,6 +611,25 @@ dvbpsi_descriptor_t *dvbpsi_sis_descriptor_add(dvbpsi_sis_t *p_sis,
  */
 dvbpsi_psi_section_t *dvbpsi_sis_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_sis_t * p_sis);
 
+/*****************************************************************************
+ * dvbpsi_sis_sections_generate_into
+ *****************************************************************************/
+/*!
+ * \fn int dvbpsi_sis_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_sis_t *p_sis,
+ *                                          dvbpsi_section_buffer_t *p_buffer)
+ * \brief SIS generator writing into caller memory
+ * \param p_dvbpsi handle to dvbpsi with attached decoder
+ * \param p_sis pointer to the SIS structure
+ * \param p_buffer buffer the sections are written into, its previous
+ *        sections are overwritten
+ * \return the number of sections written, linked from p_buffer->p_sections,
+ *         or -1 on error or if the buffer is too small.
+ *
+ * Same encoding as dvbpsi_sis_sections_generate(), without any allocation.
+ */
+int dvbpsi_sis_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_sis_t *p_sis,
+                                      dvbpsi_section_buffer_t *p_buffer);
+
 #ifdef __cplusplus
 };
 #endif
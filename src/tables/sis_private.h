@@ -39,6 +39,10 @@ typedef struct dvbpsi_sis_decoder_s
     dvbpsi_sis_callback           pf_sis_callback;
     void *                        p_cb_data;
 
+    /* Each section, see dvbpsi_sis_set_splice_callback() */
+    dvbpsi_sis_splice_callback    pf_splice_callback;
+    void *                        p_splice_cb_data;
+
     /* */
     dvbpsi_sis_t                  current_sis;
     dvbpsi_sis_t                  *p_building_sis;
@@ -43,10 +43,13 @@
 #include <assert.h>
 
 #include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_TABLE
 #include "../dvbpsi_private.h"
 #include "../psi.h"
 #include "../descriptor.h"
 #include "../demux.h"
+#include "../crc32_private.h"
+#include "../mjd.h"
 #include "tot.h"
 #include "tot_private.h"
 
@@ -95,6 +98,8 @@ bool dvbpsi_tot_attach(dvbpsi_t* p_dvbpsi, uint8_t i_table_id, uint16_t i_extens
     /* TDT/TOT decoder information */
     p_tot_decoder->pf_tot_callback = pf_callback;
     p_tot_decoder->p_cb_data = p_cb_data;
+    p_tot_decoder->pf_time_callback = NULL;
+    p_tot_decoder->p_time_cb_data = NULL;
     p_tot_decoder->p_building_tot = NULL;
 
     return true;
@@ -137,6 +142,137 @@ void dvbpsi_tot_detach(dvbpsi_t* p_dvbpsi, uint8_t i_table_id,
     dvbpsi_DeleteDemuxSubDecoder(p_subdec);
 }
 
+/*****************************************************************************
+ * dvbpsi_tot_set_time_callback
+ *****************************************************************************
+ * Set the function signalling the time of each section of a TDT/TOT decoder.
+ *****************************************************************************/
+bool dvbpsi_tot_set_time_callback(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                                  uint16_t i_extension,
+                                  dvbpsi_tot_time_callback pf_callback,
+                                  void* p_cb_data)
+{
+    assert(p_dvbpsi);
+    assert(p_dvbpsi->p_decoder);
+
+    dvbpsi_demux_t *p_demux = (dvbpsi_demux_t *) p_dvbpsi->p_decoder;
+
+    i_extension = 0; /* NOTE: force to 0 when handling TDT/TOT */
+    dvbpsi_demux_subdec_t* p_subdec = dvbpsi_demuxGetSubDec(p_demux, i_table_id, i_extension);
+    if (p_subdec == NULL)
+        return false;
+
+    dvbpsi_tot_decoder_t* p_tot_decoder = (dvbpsi_tot_decoder_t*)p_subdec->p_decoder;
+    p_tot_decoder->pf_time_callback = pf_callback;
+    p_tot_decoder->p_time_cb_data = p_cb_data;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_tot_time_utc
+ *****************************************************************************
+ * Converts 16 bits of MJD and 24 bits of BCD time to seconds since
+ * 1970-01-01. Returns false for an invalid BCD time.
+ *****************************************************************************/
+static bool dvbpsi_tot_time_utc(const uint8_t *p_byte, int64_t *pi_utc)
+{
+    uint64_t i_time = ((uint64_t)p_byte[0] << 32) | ((uint64_t)p_byte[1] << 24)
+                    | ((uint32_t)p_byte[2] << 16) | ((uint32_t)p_byte[3] << 8) | p_byte[4];
+    if (!dvbpsi_bcd_valid(i_time & 0xffffff))
+        return false;
+    *pi_utc = dvbpsi_mjd_to_utc(i_time);
+    return true;
+}
+
+/* 4 BCD digits of hours and minutes in seconds, or -1 if invalid */
+static int32_t dvbpsi_tot_time_offset(const uint8_t *p_byte)
+{
+    uint32_t i_bcd = ((uint32_t)p_byte[0] << 16) | ((uint32_t)p_byte[1] << 8);
+    if (!dvbpsi_bcd_valid(i_bcd))
+        return -1;
+    return dvbpsi_bcd_to_seconds(i_bcd);
+}
+
+/*****************************************************************************
+ * dvbpsi_tot_time_parse
+ *****************************************************************************
+ * Decode the time of a TDT or TOT section from its bytes.
+ *****************************************************************************/
+bool dvbpsi_tot_time_parse(const uint8_t *p_data, size_t i_size,
+                           dvbpsi_tot_time_t *p_time)
+{
+    assert(p_time);
+
+    if (p_data == NULL || i_size < 3 + 5)
+        return false;
+    size_t i_section = 3 + ((((size_t)p_data[1] & 0x0f) << 8) | p_data[2]);
+    if (i_section > i_size)
+        return false;
+
+    p_time->i_table_id = p_data[0];
+    p_time->i_offsets = 0;
+    if (p_data[0] == 0x70)
+    {
+        if (i_section != 3 + 5)
+            return false;
+    }
+    else if (p_data[0] == 0x73)
+    {
+        /* UTC_time, descriptors_loop_length and CRC_32 */
+        if (i_section < 3 + 5 + 2 + 4
+         || dvbpsi_crc32(0xffffffff, p_data, i_section) != 0)
+            return false;
+    }
+    else
+        return false;
+
+    if (!dvbpsi_tot_time_utc(p_data + 3, &p_time->i_utc))
+        return false;
+    p_time->i_utc_ns = p_time->i_utc * INT64_C(1000000000);
+    if (p_data[0] == 0x70)
+        return true;
+
+    const uint8_t *p_byte = p_data + 3 + 5;
+    const uint8_t *p_end = p_byte + 2 + ((((uint16_t)p_byte[0] & 0x0f) << 8) | p_byte[1]);
+    if (p_end > p_data + i_section - 4)
+        return false;
+
+    p_byte += 2;
+    while (p_end - p_byte >= 2)
+    {
+        uint8_t i_tag = p_byte[0];
+        uint8_t i_length = p_byte[1];
+        p_byte += 2;
+        if (i_length > p_end - p_byte)
+            return false;
+
+        /* local_time_offset_descriptor, 13 bytes per region */
+        if (i_tag == 0x58)
+        {
+            for (const uint8_t *p = p_byte; p + 13 <= p_byte + i_length; p += 13)
+            {
+                if (p_time->i_offsets == DVBPSI_TOT_TIME_OFFSETS)
+                    break;
+
+                dvbpsi_tot_offset_t *p_offset = &p_time->offsets[p_time->i_offsets];
+                int32_t i_offset = dvbpsi_tot_time_offset(p + 4);
+                int32_t i_next_offset = dvbpsi_tot_time_offset(p + 11);
+                if (i_offset < 0 || i_next_offset < 0
+                 || !dvbpsi_tot_time_utc(p + 6, &p_offset->i_time_of_change))
+                    continue;
+
+                memcpy(p_offset->i_country_code, p, 3);
+                p_offset->i_country_region_id = p[3] >> 2;
+                p_offset->i_offset = (p[3] & 0x01) ? -i_offset : i_offset;
+                p_offset->i_next_offset = (p[3] & 0x01) ? -i_next_offset : i_next_offset;
+                p_time->i_offsets++;
+            }
+        }
+        p_byte += i_length;
+    }
+    return true;
+}
+
 /*****************************************************************************
  * dvbpsi_tot_init
  *****************************************************************************
@@ -155,6 +291,7 @@ void dvbpsi_tot_init(dvbpsi_tot_t* p_tot, uint8_t i_table_id, uint16_t i_extensi
 
     p_tot->i_utc_time = i_utc_time;
     p_tot->p_first_descriptor = NULL;
+    p_tot->p_last_descriptor = NULL;
 }
 
 /*****************************************************************************
@@ -165,7 +302,7 @@ void dvbpsi_tot_init(dvbpsi_tot_t* p_tot, uint8_t i_table_id, uint16_t i_extensi
 dvbpsi_tot_t *dvbpsi_tot_new(uint8_t i_table_id, uint16_t i_extension, uint8_t i_version,
                              bool b_current_next, uint64_t i_utc_time)
 {
-  dvbpsi_tot_t *p_tot = (dvbpsi_tot_t*)malloc(sizeof(dvbpsi_tot_t));
+  dvbpsi_tot_t *p_tot = (dvbpsi_tot_t*)dvbpsi_malloc(sizeof(dvbpsi_tot_t));
   if (p_tot != NULL)
         dvbpsi_tot_init(p_tot, i_table_id, i_extension, i_version,
                         b_current_next, i_utc_time);
@@ -181,6 +318,7 @@ void dvbpsi_tot_empty(dvbpsi_tot_t* p_tot)
 {
     dvbpsi_DeleteDescriptors(p_tot->p_first_descriptor);
     p_tot->p_first_descriptor = NULL;
+    p_tot->p_last_descriptor = NULL;
 }
 
 /*****************************************************************************
@@ -192,7 +330,7 @@ void dvbpsi_tot_delete(dvbpsi_tot_t* p_tot)
 {
     if (p_tot)
         dvbpsi_tot_empty(p_tot);
-    free(p_tot);
+    dvbpsi_free(p_tot);
 }
 
 /*****************************************************************************
@@ -209,11 +347,7 @@ dvbpsi_descriptor_t* dvbpsi_tot_descriptor_add(dvbpsi_tot_t* p_tot,
     if (p_descriptor == NULL)
         return NULL;
 
-    p_tot->p_first_descriptor = dvbpsi_AddDescriptor(p_tot->p_first_descriptor,
-                                                     p_descriptor);
-    assert(p_tot->p_first_descriptor);
-    if (p_tot->p_first_descriptor == NULL)
-        return NULL;
+    dvbpsi_list_append(p_tot->p_first_descriptor, p_tot->p_last_descriptor, p_descriptor);
 
     return p_descriptor;
 }
@@ -271,7 +405,7 @@ static bool dvbpsi_CheckTOT(dvbpsi_t *p_dvbpsi, dvbpsi_tot_decoder_t *p_tot_deco
 }
 
 static bool dvbpsi_AddSectionTOT(dvbpsi_t *p_dvbpsi, dvbpsi_tot_decoder_t *p_tot_decoder,
-                                 dvbpsi_psi_section_t* p_section)
+                                 dvbpsi_psi_section_t* p_section, bool *pb_complete)
 {
     assert(p_dvbpsi);
     assert(p_tot_decoder);
@@ -293,11 +427,19 @@ static bool dvbpsi_AddSectionTOT(dvbpsi_t *p_dvbpsi, dvbpsi_tot_decoder_t *p_tot
         p_tot_decoder->i_last_section_number = p_section->i_last_number;
     }
 
+    /* A table carried by this section alone is complete as it is */
+    if (dvbpsi_decoder_psi_section_single(DVBPSI_DECODER(p_tot_decoder), p_section))
+    {
+        *pb_complete = true;
+        return true;
+    }
+
     /* Add to linked list of sections */
     if (dvbpsi_decoder_psi_section_add(DVBPSI_DECODER(p_tot_decoder), p_section))
         dvbpsi_debug(p_dvbpsi, "TOT decoder", "overwrite section number %d",
                      p_section->i_number);
 
+    *pb_complete = dvbpsi_decoder_psi_sections_completed(DVBPSI_DECODER(p_tot_decoder));
     return true;
 }
 
@@ -313,6 +455,25 @@ void dvbpsi_tot_sections_gather(dvbpsi_t* p_dvbpsi,
     assert(p_dvbpsi);
     assert(p_dvbpsi->p_decoder);
 
+    dvbpsi_tot_decoder_t* p_tot_decoder = (dvbpsi_tot_decoder_t*)p_decoder;
+
+    /* Low latency path, straight from the section bytes */
+    if (p_tot_decoder->pf_time_callback)
+    {
+        dvbpsi_tot_time_t time;
+        if (dvbpsi_tot_time_parse(p_section->p_data, 3 + p_section->i_length, &time))
+        {
+            dvbpsi_probe_callback_entry("tot_time", p_section->i_table_id, p_section->i_extension);
+            p_tot_decoder->pf_time_callback(p_tot_decoder->p_time_cb_data, &time);
+            dvbpsi_probe_callback_exit("tot_time", p_section->i_table_id, p_section->i_extension);
+        }
+    }
+    if (p_tot_decoder->pf_tot_callback == NULL)
+    {
+        dvbpsi_DeletePSISections(p_section);
+        return;
+    }
+
     const uint8_t i_table_id = ((p_section->i_table_id == 0x70 ||  /* TDT */
                                  p_section->i_table_id == 0x73)) ? /* TOT */
                                     p_section->i_table_id : 0x70;
@@ -324,8 +485,6 @@ void dvbpsi_tot_sections_gather(dvbpsi_t* p_dvbpsi,
     }
 
     /* Valid TDT/TOT section */
-    dvbpsi_tot_decoder_t* p_tot_decoder = (dvbpsi_tot_decoder_t*)p_decoder;
-
     /* TS discontinuity check */
     if (p_tot_decoder->b_discontinuity)
     {
@@ -351,6 +510,8 @@ void dvbpsi_tot_sections_gather(dvbpsi_t* p_dvbpsi,
                 && (p_tot_decoder->current_tot.b_current_next == p_section->b_current_next))
             {
                 /* Don't decode since this version is already decoded */
+                p_dvbpsi->stats.i_dropped_duplicate++;
+                dvbpsi_probe_dropped(p_section, "duplicate");
                 dvbpsi_debug(p_dvbpsi, "TOT decoder",
                              "ignoring already decoded section %d",
                              p_section->i_number);
@@ -362,7 +523,8 @@ void dvbpsi_tot_sections_gather(dvbpsi_t* p_dvbpsi,
     }
 
     /* Add section to TOT */
-    if (!dvbpsi_AddSectionTOT(p_dvbpsi, p_tot_decoder, p_section))
+    bool b_complete = false;
+    if (!dvbpsi_AddSectionTOT(p_dvbpsi, p_tot_decoder, p_section, &b_complete))
     {
         dvbpsi_error(p_dvbpsi, "TOT decoder", "failed decoding section %d",
                      p_section->i_number);
@@ -371,8 +533,9 @@ void dvbpsi_tot_sections_gather(dvbpsi_t* p_dvbpsi,
     }
 
     /* Check if we have all the sections */
-    if (dvbpsi_decoder_psi_sections_completed(DVBPSI_DECODER(p_tot_decoder)))
+    if (b_complete)
     {
+        p_dvbpsi->stats.i_tables++;
         assert(p_tot_decoder->pf_tot_callback);
 
         /* Save the current information */
@@ -383,8 +546,10 @@ void dvbpsi_tot_sections_gather(dvbpsi_t* p_dvbpsi,
         dvbpsi_tot_sections_decode(p_dvbpsi, p_tot_decoder->p_building_tot,
                                    p_tot_decoder->p_sections);
         /* signal the new TOT */
+        dvbpsi_probe_callback_entry("tot", p_section->i_table_id, p_section->i_extension);
         p_tot_decoder->pf_tot_callback(p_tot_decoder->p_cb_data,
                                        p_tot_decoder->p_building_tot);
+        dvbpsi_probe_callback_exit("tot", p_section->i_table_id, p_section->i_extension);
         /* Delete sections and Reinitialize the structures */
         dvbpsi_ReInitTOT(p_tot_decoder, false);
         assert(p_tot_decoder->p_sections == NULL);
@@ -477,7 +642,7 @@ dvbpsi_psi_section_t* dvbpsi_tot_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_to
     dvbpsi_descriptor_t* p_descriptor = p_tot->p_first_descriptor;
 
     /* If it has descriptors, it must be a TOT, otherwise a TDT */
-    p_result = dvbpsi_NewPSISection((p_descriptor != NULL) ? 4096 : 8);
+    p_result = dvbpsi_section_buffer_get(p_dvbpsi, (p_descriptor != NULL) ? 4096 : 8);
 
     p_result->i_table_id = (p_descriptor != NULL) ? 0x73 : 0x70;
     p_result->b_syntax_indicator = false;
@@ -555,3 +720,39 @@ dvbpsi_psi_section_t* dvbpsi_tot_sections_generate(dvbpsi_t *p_dvbpsi, dvbpsi_to
 
     return p_result;
 }
+
+/*****************************************************************************
+ * dvbpsi_tot_sections_generate_into
+ *****************************************************************************
+ * Generate TOT sections into a caller buffer.
+ *****************************************************************************/
+int dvbpsi_tot_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_tot_t *p_tot,
+                                      dvbpsi_section_buffer_t *p_buffer)
+{
+    dvbpsi_section_buffer_begin(p_dvbpsi, p_buffer);
+    return dvbpsi_section_buffer_end(p_dvbpsi,
+                dvbpsi_tot_sections_generate(p_dvbpsi, p_tot));
+}
+
+/*****************************************************************************
+ * dvbpsi_tot_section_iter
+ *****************************************************************************
+ * Sets up iterators over the raw loops of a TOT section.
+ *****************************************************************************/
+bool dvbpsi_tot_section_iter(dvbpsi_psi_section_t *p_section,
+                             dvbpsi_descriptor_iter_t *p_descriptors)
+{
+    assert(p_section);
+
+    uint8_t *p_byte = p_section->p_payload_start;
+    uint8_t *p_end = p_section->p_payload_end;
+    if (p_section->i_table_id != 0x73 || p_end - p_byte < 7)
+        return false;
+
+    size_t i_length = ((size_t)(p_byte[5] & 0x0f) << 8) | p_byte[6];
+    p_byte += 7;
+    if (i_length > (size_t)(p_end - p_byte))
+        i_length = p_end - p_byte;
+    dvbpsi_descriptor_iter_init(p_descriptors, p_byte, i_length);
+    return true;
+}
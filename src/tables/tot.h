@@ -67,6 +67,7 @@ typedef struct dvbpsi_tot_s
     uint64_t                  i_utc_time;         /*!< UTC_time */
 
     dvbpsi_descriptor_t *     p_first_descriptor; /*!< descriptor list */
+    dvbpsi_descriptor_t *     p_last_descriptor;  /*!< private, list tail */
 
 } __attribute__((packed)) dvbpsi_tot_t;
 
@@ -90,7 +91,8 @@ typedef void (* dvbpsi_tot_callback)(void* p_cb_data, dvbpsi_tot_t* p_new_tot);
  * \param p_dvbpsi dvbpsi handle pointing to Subtable demultiplexor to which the decoder is attached.
  * \param i_table_id Table ID, usually 0x70
  * \param i_extension Table ID extension, unused in the TDT/TOT
- * \param pf_callback function to call back on new TDT/TOT.
+ * \param pf_callback function to call back on new TDT/TOT, NULL when only
+ *        dvbpsi_tot_set_time_callback() is used.
  * \param p_cb_data private data given in argument to the callback.
  * \return true on success, false on failure
  */
@@ -195,6 +197,152 @@ dvbpsi_descriptor_t* dvbpsi_tot_descriptor_add(dvbpsi_tot_t* p_tot,
  */
 dvbpsi_psi_section_t* dvbpsi_tot_sections_generate(dvbpsi_t* p_dvbpsi, dvbpsi_tot_t* p_tot);
 
+/*****************************************************************************
+ * dvbpsi_tot_sections_generate_into
+ *****************************************************************************/
+/*!
+ * \fn int dvbpsi_tot_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_tot_t *p_tot,
+ *                                          dvbpsi_section_buffer_t *p_buffer)
+ * \brief TOT generator writing into caller memory
+ * \param p_dvbpsi handle to dvbpsi with attached decoder
+ * \param p_tot pointer to the TOT structure
+ * \param p_buffer buffer the sections are written into, its previous
+ *        sections are overwritten
+ * \return the number of sections written, linked from p_buffer->p_sections,
+ *         or -1 on error or if the buffer is too small.
+ *
+ * Same encoding as dvbpsi_tot_sections_generate(), without any allocation.
+ */
+int dvbpsi_tot_sections_generate_into(dvbpsi_t *p_dvbpsi, dvbpsi_tot_t *p_tot,
+                                      dvbpsi_section_buffer_t *p_buffer);
+
+/*****************************************************************************
+ * dvbpsi_tot_section_iter
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_tot_section_iter(dvbpsi_psi_section_t *p_section,
+ *                                  dvbpsi_descriptor_iter_t *p_descriptors)
+ * \brief Iterates over a TOT section without decoding it
+ * \param p_section TOT section
+ * \param p_descriptors set up for the descriptors
+ * \return false if the section is not a TOT section or is too short.
+ */
+bool dvbpsi_tot_section_iter(dvbpsi_psi_section_t *p_section,
+                             dvbpsi_descriptor_iter_t *p_descriptors);
+
+/*****************************************************************************
+ * dvbpsi_tot_time_t
+ *****************************************************************************/
+/*!
+ * \def DVBPSI_TOT_TIME_OFFSETS
+ * \brief Maximum number of local time offsets of a dvbpsi_tot_time_t, those
+ * of one local_time_offset_descriptor
+ */
+#define DVBPSI_TOT_TIME_OFFSETS 19
+
+/*!
+ * \struct dvbpsi_tot_offset_s
+ * \brief Local time offset of a region (ETSI EN 300 468 section 6.2.20).
+ */
+/*!
+ * \typedef struct dvbpsi_tot_offset_s dvbpsi_tot_offset_t
+ * \brief dvbpsi_tot_offset_t type definition.
+ */
+typedef struct dvbpsi_tot_offset_s
+{
+    uint8_t         i_country_code[3];      /*!< country_code */
+    uint8_t         i_country_region_id;    /*!< country_region_id */
+    int32_t         i_offset;               /*!< local_time_offset in seconds,
+                                                 negative with
+                                                 local_time_offset_polarity */
+    int64_t         i_time_of_change;       /*!< time_of_change in seconds
+                                                 since 1970-01-01 UTC */
+    int32_t         i_next_offset;          /*!< next_time_offset in seconds,
+                                                 with the same polarity */
+} dvbpsi_tot_offset_t;
+
+/*!
+ * \struct dvbpsi_tot_time_s
+ * \brief UTC and local time offsets of a TDT or TOT, decoded without
+ * allocation.
+ */
+/*!
+ * \typedef struct dvbpsi_tot_time_s dvbpsi_tot_time_t
+ * \brief dvbpsi_tot_time_t type definition.
+ */
+typedef struct dvbpsi_tot_time_s
+{
+    uint8_t         i_table_id;             /*!< 0x70 for a TDT, 0x73 for a
+                                                 TOT */
+    int64_t         i_utc;                  /*!< UTC_time in seconds since
+                                                 1970-01-01, as a time_t */
+    int64_t         i_utc_ns;               /*!< UTC_time in nanoseconds since
+                                                 1970-01-01 */
+
+    unsigned int    i_offsets;              /*!< number of offsets */
+    dvbpsi_tot_offset_t offsets[DVBPSI_TOT_TIME_OFFSETS];
+                                            /*!< local time offsets of the
+                                                 first descriptors of a TOT */
+} dvbpsi_tot_time_t;
+
+/*****************************************************************************
+ * dvbpsi_tot_time_callback
+ *****************************************************************************/
+/*!
+ * \typedef void (* dvbpsi_tot_time_callback)(void* p_cb_data,
+ *                                            const dvbpsi_tot_time_t* p_time)
+ * \brief Time callback type definition, see dvbpsi_tot_set_time_callback().
+ */
+typedef void (* dvbpsi_tot_time_callback)(void* p_cb_data,
+                                          const dvbpsi_tot_time_t* p_time);
+
+/*****************************************************************************
+ * dvbpsi_tot_set_time_callback
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_tot_set_time_callback(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+ *                                       uint16_t i_extension,
+ *                                       dvbpsi_tot_time_callback pf_callback,
+ *                                       void* p_cb_data)
+ * \brief Signals the time of each TDT or TOT section of a decoder as soon as
+ * it is received, decoded straight from its bytes
+ * \param p_dvbpsi dvbpsi handle pointing to Subtable demultiplexor to which
+ *        the decoder is attached.
+ * \param i_table_id Table ID, 0x70 or 0x73
+ * \param i_extension Table ID extension, unused in the TDT/TOT
+ * \param pf_callback function called with the time, valid until it returns,
+ *        NULL for none
+ * \param p_cb_data private data given in argument to the callback
+ * \return false if there is no such TDT/TOT decoder, true otherwise.
+ *
+ * Every valid section is signalled without any allocation. The callback
+ * of dvbpsi_tot_attach(), which may then be NULL, is still called with the
+ * decoded dvbpsi_tot_t.
+ */
+bool dvbpsi_tot_set_time_callback(dvbpsi_t *p_dvbpsi, uint8_t i_table_id,
+                                  uint16_t i_extension,
+                                  dvbpsi_tot_time_callback pf_callback,
+                                  void* p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_tot_time_parse
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_tot_time_parse(const uint8_t *p_data, size_t i_size,
+ *                                dvbpsi_tot_time_t *p_time)
+ * \brief Decodes the time of a TDT or TOT section from its bytes
+ * \param p_data the section, from its table_id
+ * \param i_size number of bytes at p_data, at least the section
+ * \param p_time filled with the time and the local time offsets
+ * \return false if the section is truncated, malformed, has an invalid BCD
+ *         time or fails the CRC_32 of a TOT, true otherwise.
+ *
+ * The local time offsets after the first DVBPSI_TOT_TIME_OFFSETS are
+ * ignored.
+ */
+bool dvbpsi_tot_time_parse(const uint8_t *p_data, size_t i_size,
+                           dvbpsi_tot_time_t *p_time);
+
 #ifdef __cplusplus
 };
 #endif
@@ -42,6 +42,9 @@ typedef struct dvbpsi_tot_decoder_s
     dvbpsi_tot_callback           pf_tot_callback;
     void *                        p_cb_data;
 
+    dvbpsi_tot_time_callback      pf_time_callback;
+    void *                        p_time_cb_data;
+
     /* */
     dvbpsi_tot_t                  current_tot;
     dvbpsi_tot_t                  *p_building_tot;
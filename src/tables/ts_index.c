@@ -0,0 +1,353 @@
+/*****************************************************************************
+ * ts_index.c: index of the transport stream loops of the NIT and BAT
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+#include "../dvbpsi.h"
+#define DVBPSI_MEM_CATEGORY DVBPSI_MEM_TABLE
+#include "../dvbpsi_private.h"
+#include "../descriptor.h"
+
+#include "ts_index.h"
+#include "ts_index_private.h"
+
+/*****************************************************************************
+ * dvbpsi_ts_index_s
+ *****************************************************************************
+ * The entries are in arrays allocated with the index, and each bucket holds
+ * 1 + the position of its first entry, 0 for none.
+ *****************************************************************************/
+typedef struct dvbpsi_ts_index_ts_s
+{
+    void *                  p_ts;
+    dvbpsi_descriptor_t *   p_delivery;
+    uint32_t                i_key;          /* original_network_id, ts_id */
+    uint32_t                i_next;
+} dvbpsi_ts_index_ts_t;
+
+typedef struct dvbpsi_ts_index_service_s
+{
+    dvbpsi_ts_service_t     service;
+    uint32_t                i_key;          /* original_network_id, service_id */
+    uint32_t                i_next;
+} dvbpsi_ts_index_service_t;
+
+struct dvbpsi_ts_index_s
+{
+    dvbpsi_ts_index_ts_t *      p_ts;
+    dvbpsi_ts_index_service_t * p_services;
+    uint32_t *                  pi_ts_buckets;
+    uint32_t *                  pi_service_buckets;
+    size_t                      i_ts, i_ts_max;
+    size_t                      i_services, i_services_max;
+    unsigned int                i_ts_bits, i_service_bits;
+};
+
+/***** dvbpsi_ts_index_bits ***** Bits of the buckets of n entries *****/
+static unsigned int dvbpsi_ts_index_bits(size_t i_entries)
+{
+    unsigned int i_bits = 1;
+    while (i_bits < 24 && ((size_t)1 << i_bits) < i_entries)
+        i_bits++;
+    return i_bits;
+}
+
+/***** dvbpsi_ts_index_bucket ***** Bucket of a key *****/
+static inline uint32_t dvbpsi_ts_index_bucket(uint32_t i_key, unsigned int i_bits)
+{
+    return (uint32_t)(i_key * 2654435761u) >> (32 - i_bits);
+}
+
+/*****************************************************************************
+ * dvbpsi_ts_index_count
+ *****************************************************************************/
+size_t dvbpsi_ts_index_count(const dvbpsi_descriptor_t *p_first_descriptor)
+{
+    size_t i_services = 0;
+    for (const dvbpsi_descriptor_t *p_dr = p_first_descriptor; p_dr; p_dr = p_dr->p_next)
+    {
+        if (p_dr->i_tag == 0x41)
+            i_services += p_dr->i_length / 3;
+        else if (p_dr->i_tag == 0x83)
+            i_services += p_dr->i_length / 4;
+    }
+    return i_services;
+}
+
+/*****************************************************************************
+ * dvbpsi_ts_index_new
+ *****************************************************************************/
+dvbpsi_ts_index_t *dvbpsi_ts_index_new(size_t i_ts, size_t i_services)
+{
+    if (i_ts > UINT32_MAX / 2 || i_services > UINT32_MAX / 2)
+        return NULL;
+
+    /* One block, the arrays being in decreasing order of alignment */
+    unsigned int i_ts_bits = dvbpsi_ts_index_bits(i_ts);
+    unsigned int i_service_bits = dvbpsi_ts_index_bits(i_services);
+    size_t i_size = sizeof(dvbpsi_ts_index_t)
+                  + i_ts * sizeof(dvbpsi_ts_index_ts_t)
+                  + i_services * sizeof(dvbpsi_ts_index_service_t)
+                  + (((size_t)1 << i_ts_bits) + ((size_t)1 << i_service_bits))
+                    * sizeof(uint32_t);
+    uint8_t *p_block = dvbpsi_calloc(1, i_size);
+    if (p_block == NULL)
+        return NULL;
+
+    dvbpsi_ts_index_t *p_index = (dvbpsi_ts_index_t *)p_block;
+    p_block += sizeof(dvbpsi_ts_index_t);
+    p_index->p_ts = (dvbpsi_ts_index_ts_t *)p_block;
+    p_block += i_ts * sizeof(dvbpsi_ts_index_ts_t);
+    p_index->p_services = (dvbpsi_ts_index_service_t *)p_block;
+    p_block += i_services * sizeof(dvbpsi_ts_index_service_t);
+    p_index->pi_ts_buckets = (uint32_t *)p_block;
+    p_index->pi_service_buckets = p_index->pi_ts_buckets + ((size_t)1 << i_ts_bits);
+    p_index->i_ts_max = i_ts;
+    p_index->i_services_max = i_services;
+    p_index->i_ts_bits = i_ts_bits;
+    p_index->i_service_bits = i_service_bits;
+    return p_index;
+}
+
+/*****************************************************************************
+ * dvbpsi_ts_index_delete
+ *****************************************************************************/
+void dvbpsi_ts_index_delete(dvbpsi_ts_index_t *p_index)
+{
+    dvbpsi_free(p_index);
+}
+
+/*****************************************************************************
+ * dvbpsi_ts_index_service_get
+ *****************************************************************************
+ * Find or add the service of a transport stream, NULL if it was already
+ * given by another transport stream or if the index is full.
+ *****************************************************************************/
+static dvbpsi_ts_service_t *dvbpsi_ts_index_service_get(dvbpsi_ts_index_t *p_index,
+                                                        uint16_t i_orig_network_id,
+                                                        uint16_t i_ts_id,
+                                                        uint16_t i_service_id)
+{
+    uint32_t i_key = ((uint32_t)i_orig_network_id << 16) | i_service_id;
+    uint32_t *pi_bucket = &p_index->pi_service_buckets[
+                            dvbpsi_ts_index_bucket(i_key, p_index->i_service_bits)];
+
+    for (uint32_t i = *pi_bucket; i; i = p_index->p_services[i - 1].i_next)
+    {
+        dvbpsi_ts_index_service_t *p_entry = &p_index->p_services[i - 1];
+        if (p_entry->i_key == i_key)
+            return p_entry->service.i_ts_id == i_ts_id ? &p_entry->service : NULL;
+    }
+
+    if (p_index->i_services == p_index->i_services_max)
+        return NULL;
+
+    dvbpsi_ts_index_service_t *p_entry = &p_index->p_services[p_index->i_services++];
+    p_entry->service.i_orig_network_id = i_orig_network_id;
+    p_entry->service.i_ts_id = i_ts_id;
+    p_entry->service.i_service_id = i_service_id;
+    p_entry->i_key = i_key;
+    p_entry->i_next = *pi_bucket;
+    *pi_bucket = p_index->i_services;
+    return &p_entry->service;
+}
+
+/*****************************************************************************
+ * dvbpsi_ts_index_add
+ *****************************************************************************/
+void dvbpsi_ts_index_add(dvbpsi_ts_index_t *p_index, uint16_t i_orig_network_id,
+                         uint16_t i_ts_id, void *p_ts,
+                         dvbpsi_descriptor_t *p_first_descriptor)
+{
+    assert(p_index);
+    assert(p_index->i_ts < p_index->i_ts_max);
+
+    /* A transport stream split across sections is in the loop once per
+       section, its first entry standing for all */
+    uint32_t i_key = ((uint32_t)i_orig_network_id << 16) | i_ts_id;
+    uint32_t *pi_bucket = &p_index->pi_ts_buckets[
+                            dvbpsi_ts_index_bucket(i_key, p_index->i_ts_bits)];
+    dvbpsi_ts_index_ts_t *p_entry = NULL;
+    for (uint32_t i = *pi_bucket; i && p_entry == NULL; i = p_index->p_ts[i - 1].i_next)
+    {
+        if (p_index->p_ts[i - 1].i_key == i_key)
+            p_entry = &p_index->p_ts[i - 1];
+    }
+
+    if (p_entry == NULL)
+    {
+        p_entry = &p_index->p_ts[p_index->i_ts++];
+        p_entry->p_ts = p_ts;
+        p_entry->i_key = i_key;
+        p_entry->i_next = *pi_bucket;
+        *pi_bucket = p_index->i_ts;
+    }
+    if (p_entry->p_delivery == NULL)
+        p_entry->p_delivery = dvbpsi_ts_delivery(p_first_descriptor);
+
+    for (const dvbpsi_descriptor_t *p_dr = p_first_descriptor; p_dr; p_dr = p_dr->p_next)
+    {
+        if (p_dr->i_tag == 0x41)
+        {
+            for (unsigned int i = 0; i + 3 <= p_dr->i_length; i += 3)
+            {
+                const uint8_t *p_data = p_dr->p_data + i;
+                dvbpsi_ts_service_t *p_service =
+                    dvbpsi_ts_index_service_get(p_index, i_orig_network_id, i_ts_id,
+                                                ((uint16_t)p_data[0] << 8) | p_data[1]);
+                if (p_service && p_service->i_service_type == 0)
+                    p_service->i_service_type = p_data[2];
+            }
+        }
+        else if (p_dr->i_tag == 0x83)
+        {
+            for (unsigned int i = 0; i + 4 <= p_dr->i_length; i += 4)
+            {
+                const uint8_t *p_data = p_dr->p_data + i;
+                dvbpsi_ts_service_t *p_service =
+                    dvbpsi_ts_index_service_get(p_index, i_orig_network_id, i_ts_id,
+                                                ((uint16_t)p_data[0] << 8) | p_data[1]);
+                if (p_service && p_service->i_lcn == 0)
+                {
+                    p_service->i_lcn = ((uint16_t)(p_data[2] & 0x03) << 8) | p_data[3];
+                    p_service->b_visible = (p_data[2] & 0x80) != 0;
+                }
+            }
+        }
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_ts_index_find_ts
+ *****************************************************************************/
+void *dvbpsi_ts_index_find_ts(const dvbpsi_ts_index_t *p_index,
+                              uint16_t i_orig_network_id, uint16_t i_ts_id,
+                              dvbpsi_descriptor_t **pp_delivery)
+{
+    uint32_t i_key = ((uint32_t)i_orig_network_id << 16) | i_ts_id;
+    uint32_t i = p_index->pi_ts_buckets[dvbpsi_ts_index_bucket(i_key, p_index->i_ts_bits)];
+    for (; i; i = p_index->p_ts[i - 1].i_next)
+    {
+        const dvbpsi_ts_index_ts_t *p_entry = &p_index->p_ts[i - 1];
+        if (p_entry->i_key == i_key)
+        {
+            if (pp_delivery)
+                *pp_delivery = p_entry->p_delivery;
+            return p_entry->p_ts;
+        }
+    }
+    return NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_ts_index_find_service
+ *****************************************************************************/
+bool dvbpsi_ts_index_find_service(const dvbpsi_ts_index_t *p_index,
+                                  uint16_t i_orig_network_id, uint16_t i_service_id,
+                                  dvbpsi_ts_service_t *p_service)
+{
+    uint32_t i_key = ((uint32_t)i_orig_network_id << 16) | i_service_id;
+    uint32_t i = p_index->pi_service_buckets[
+                    dvbpsi_ts_index_bucket(i_key, p_index->i_service_bits)];
+    for (; i; i = p_index->p_services[i - 1].i_next)
+    {
+        if (p_index->p_services[i - 1].i_key == i_key)
+        {
+            *p_service = p_index->p_services[i - 1].service;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*****************************************************************************
+ * dvbpsi_ts_delivery
+ *****************************************************************************
+ * First satellite, cable or terrestrial delivery system descriptor.
+ *****************************************************************************/
+dvbpsi_descriptor_t *dvbpsi_ts_delivery(dvbpsi_descriptor_t *p_first_descriptor)
+{
+    for (dvbpsi_descriptor_t *p_dr = p_first_descriptor; p_dr; p_dr = p_dr->p_next)
+    {
+        if (p_dr->i_tag == 0x43 || p_dr->i_tag == 0x44 || p_dr->i_tag == 0x5a)
+            return p_dr;
+    }
+    return NULL;
+}
+
+/*****************************************************************************
+ * dvbpsi_ts_service
+ *****************************************************************************
+ * Add what the descriptor loop of a transport stream says about a service
+ * to p_service, as the index would.
+ *****************************************************************************/
+bool dvbpsi_ts_service(uint16_t i_orig_network_id, uint16_t i_ts_id,
+                       const dvbpsi_descriptor_t *p_first_descriptor,
+                       uint16_t i_service_id, dvbpsi_ts_service_t *p_service)
+{
+    bool b_found = false;
+
+    for (const dvbpsi_descriptor_t *p_dr = p_first_descriptor; p_dr; p_dr = p_dr->p_next)
+    {
+        unsigned int i_step = p_dr->i_tag == 0x41 ? 3 : (p_dr->i_tag == 0x83 ? 4 : 0);
+        if (i_step == 0)
+            continue;
+
+        for (unsigned int i = 0; i + i_step <= p_dr->i_length; i += i_step)
+        {
+            const uint8_t *p_data = p_dr->p_data + i;
+            if ((((uint16_t)p_data[0] << 8) | p_data[1]) != i_service_id)
+                continue;
+
+            b_found = true;
+            if (i_step == 3 && p_service->i_service_type == 0)
+                p_service->i_service_type = p_data[2];
+            else if (i_step == 4 && p_service->i_lcn == 0)
+            {
+                p_service->i_lcn = ((uint16_t)(p_data[2] & 0x03) << 8) | p_data[3];
+                p_service->b_visible = (p_data[2] & 0x80) != 0;
+            }
+        }
+    }
+
+    if (b_found)
+    {
+        p_service->i_orig_network_id = i_orig_network_id;
+        p_service->i_ts_id = i_ts_id;
+        p_service->i_service_id = i_service_id;
+    }
+    return b_found;
+}
@@ -0,0 +1,73 @@
+/*****************************************************************************
+ * ts_index.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <ts_index.h>
+ * \brief Index of the transport streams and services of a NIT or a BAT.
+ *
+ * With DVBPSI_FLAG_TABLE_INDEX the NIT and BAT decoders hash the transport
+ * stream loop of each table they decode by original_network_id and
+ * transport_stream_id, and the services of its service list and logical
+ * channel descriptors by original_network_id and service_id, so that
+ * dvbpsi_nit_ts_find(), dvbpsi_nit_service_find() and their BAT
+ * counterparts do not walk the loop.
+ */
+
+#ifndef _DVBPSI_TS_INDEX_H_
+#define _DVBPSI_TS_INDEX_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_ts_service_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_ts_service_s
+ * \brief Service of the transport stream loop of a NIT or a BAT.
+ */
+/*!
+ * \typedef struct dvbpsi_ts_service_s dvbpsi_ts_service_t
+ * \brief dvbpsi_ts_service_t type definition.
+ */
+typedef struct dvbpsi_ts_service_s
+{
+    uint16_t    i_orig_network_id;  /*!< original_network_id */
+    uint16_t    i_ts_id;            /*!< transport_stream_id */
+    uint16_t    i_service_id;       /*!< service_id */
+    uint8_t     i_service_type;     /*!< service_type of the service list
+                                         descriptor, 0 if not listed */
+    uint16_t    i_lcn;              /*!< logical_channel_number of the
+                                         logical channel descriptor, 0 if
+                                         none */
+    bool        b_visible;          /*!< visible_service_flag of the logical
+                                         channel descriptor */
+} dvbpsi_ts_service_t;
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of ts_index.h"
+#endif
@@ -0,0 +1,64 @@
+/*****************************************************************************
+ * ts_index_private.h: index of the transport stream loops
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#ifndef _DVBPSI_TS_INDEX_PRIVATE_H_
+#define _DVBPSI_TS_INDEX_PRIVATE_H_
+
+/*****************************************************************************
+ * dvbpsi_ts_index_t
+ *****************************************************************************
+ * Hash tables of the transport streams and services of a NIT or a BAT,
+ * filled once from its transport stream loop.
+ *****************************************************************************/
+typedef struct dvbpsi_ts_index_s dvbpsi_ts_index_t;
+
+/* Number of services listed by a descriptor loop, to size an index */
+size_t dvbpsi_ts_index_count(const dvbpsi_descriptor_t *p_first_descriptor);
+
+dvbpsi_ts_index_t *dvbpsi_ts_index_new(size_t i_ts, size_t i_services);
+void dvbpsi_ts_index_delete(dvbpsi_ts_index_t *p_index);
+
+/* Adds a transport stream of the loop and its services, at most the number
+   given to dvbpsi_ts_index_new() */
+void dvbpsi_ts_index_add(dvbpsi_ts_index_t *p_index, uint16_t i_orig_network_id,
+                         uint16_t i_ts_id, void *p_ts,
+                         dvbpsi_descriptor_t *p_first_descriptor);
+
+void *dvbpsi_ts_index_find_ts(const dvbpsi_ts_index_t *p_index,
+                              uint16_t i_orig_network_id, uint16_t i_ts_id,
+                              dvbpsi_descriptor_t **pp_delivery);
+bool dvbpsi_ts_index_find_service(const dvbpsi_ts_index_t *p_index,
+                                  uint16_t i_orig_network_id, uint16_t i_service_id,
+                                  dvbpsi_ts_service_t *p_service);
+
+/* Delivery system descriptor of a loop, and what the loop of a transport
+   stream adds to a service initially zeroed, without an index */
+dvbpsi_descriptor_t *dvbpsi_ts_delivery(dvbpsi_descriptor_t *p_first_descriptor);
+bool dvbpsi_ts_service(uint16_t i_orig_network_id, uint16_t i_ts_id,
+                       const dvbpsi_descriptor_t *p_first_descriptor,
+                       uint16_t i_service_id, dvbpsi_ts_service_t *p_service);
+
+#else
+#error "Multiple inclusions of ts_index_private.h"
+#endif
@@ -0,0 +1,801 @@
+/*****************************************************************************
+ * text.c: DVB text to UTF-8
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "dvbpsi.h"
+#include "text.h"
+
+/* Character tables of the text, ETSI EN 300 468 annex A.2 */
+#define DVBPSI_TEXT_6937    0       /* figure A.1, ISO/IEC 6937 and euro */
+#define DVBPSI_TEXT_8859    1
+#define DVBPSI_TEXT_UCS2    2
+#define DVBPSI_TEXT_UTF8    3
+
+/*****************************************************************************
+ * Tables of the upper half of the single byte character sets, from 0xa0,
+ * 0 being a position without any character.
+ *****************************************************************************/
+static const uint16_t dvbpsi_text_8859[][96] =
+{
+  /* ISO/IEC 8859-2 */
+  {
+    0x00a0, 0x0104, 0x02d8, 0x0141, 0x00a4, 0x013d, 0x015a, 0x00a7,
+    0x00a8, 0x0160, 0x015e, 0x0164, 0x0179, 0x00ad, 0x017d, 0x017b,
+    0x00b0, 0x0105, 0x02db, 0x0142, 0x00b4, 0x013e, 0x015b, 0x02c7,
+    0x00b8, 0x0161, 0x015f, 0x0165, 0x017a, 0x02dd, 0x017e, 0x017c,
+    0x0154, 0x00c1, 0x00c2, 0x0102, 0x00c4, 0x0139, 0x0106, 0x00c7,
+    0x010c, 0x00c9, 0x0118, 0x00cb, 0x011a, 0x00cd, 0x00ce, 0x010e,
+    0x0110, 0x0143, 0x0147, 0x00d3, 0x00d4, 0x0150, 0x00d6, 0x00d7,
+    0x0158, 0x016e, 0x00da, 0x0170, 0x00dc, 0x00dd, 0x0162, 0x00df,
+    0x0155, 0x00e1, 0x00e2, 0x0103, 0x00e4, 0x013a, 0x0107, 0x00e7,
+    0x010d, 0x00e9, 0x0119, 0x00eb, 0x011b, 0x00ed, 0x00ee, 0x010f,
+    0x0111, 0x0144, 0x0148, 0x00f3, 0x00f4, 0x0151, 0x00f6, 0x00f7,
+    0x0159, 0x016f, 0x00fa, 0x0171, 0x00fc, 0x00fd, 0x0163, 0x02d9
+  },
+  /* ISO/IEC 8859-3 */
+  {
+    0x00a0, 0x0126, 0x02d8, 0x00a3, 0x00a4, 0x0000, 0x0124, 0x00a7,
+    0x00a8, 0x0130, 0x015e, 0x011e, 0x0134, 0x00ad, 0x0000, 0x017b,
+    0x00b0, 0x0127, 0x00b2, 0x00b3, 0x00b4, 0x00b5, 0x0125, 0x00b7,
+    0x00b8, 0x0131, 0x015f, 0x011f, 0x0135, 0x00bd, 0x0000, 0x017c,
+    0x00c0, 0x00c1, 0x00c2, 0x0000, 0x00c4, 0x010a, 0x0108, 0x00c7,
+    0x00c8, 0x00c9, 0x00ca, 0x00cb, 0x00cc, 0x00cd, 0x00ce, 0x00cf,
+    0x0000, 0x00d1, 0x00d2, 0x00d3, 0x00d4, 0x0120, 0x00d6, 0x00d7,
+    0x011c, 0x00d9, 0x00da, 0x00db, 0x00dc, 0x016c, 0x015c, 0x00df,
+    0x00e0, 0x00e1, 0x00e2, 0x0000, 0x00e4, 0x010b, 0x0109, 0x00e7,
+    0x00e8, 0x00e9, 0x00ea, 0x00eb, 0x00ec, 0x00ed, 0x00ee, 0x00ef,
+    0x0000, 0x00f1, 0x00f2, 0x00f3, 0x00f4, 0x0121, 0x00f6, 0x00f7,
+    0x011d, 0x00f9, 0x00fa, 0x00fb, 0x00fc, 0x016d, 0x015d, 0x02d9
+  },
+  /* ISO/IEC 8859-4 */
+  {
+    0x00a0, 0x0104, 0x0138, 0x0156, 0x00a4, 0x0128, 0x013b, 0x00a7,
+    0x00a8, 0x0160, 0x0112, 0x0122, 0x0166, 0x00ad, 0x017d, 0x00af,
+    0x00b0, 0x0105, 0x02db, 0x0157, 0x00b4, 0x0129, 0x013c, 0x02c7,
+    0x00b8, 0x0161, 0x0113, 0x0123, 0x0167, 0x014a, 0x017e, 0x014b,
+    0x0100, 0x00c1, 0x00c2, 0x00c3, 0x00c4, 0x00c5, 0x00c6, 0x012e,
+    0x010c, 0x00c9, 0x0118, 0x00cb, 0x0116, 0x00cd, 0x00ce, 0x012a,
+    0x0110, 0x0145, 0x014c, 0x0136, 0x00d4, 0x00d5, 0x00d6, 0x00d7,
+    0x00d8, 0x0172, 0x00da, 0x00db, 0x00dc, 0x0168, 0x016a, 0x00df,
+    0x0101, 0x00e1, 0x00e2, 0x00e3, 0x00e4, 0x00e5, 0x00e6, 0x012f,
+    0x010d, 0x00e9, 0x0119, 0x00eb, 0x0117, 0x00ed, 0x00ee, 0x012b,
+    0x0111, 0x0146, 0x014d, 0x0137, 0x00f4, 0x00f5, 0x00f6, 0x00f7,
+    0x00f8, 0x0173, 0x00fa, 0x00fb, 0x00fc, 0x0169, 0x016b, 0x02d9
+  },
+  /* ISO/IEC 8859-5 */
+  {
+    0x00a0, 0x0401, 0x0402, 0x0403, 0x0404, 0x0405, 0x0406, 0x0407,
+    0x0408, 0x0409, 0x040a, 0x040b, 0x040c, 0x00ad, 0x040e, 0x040f,
+    0x0410, 0x0411, 0x0412, 0x0413, 0x0414, 0x0415, 0x0416, 0x0417,
+    0x0418, 0x0419, 0x041a, 0x041b, 0x041c, 0x041d, 0x041e, 0x041f,
+    0x0420, 0x0421, 0x0422, 0x0423, 0x0424, 0x0425, 0x0426, 0x0427,
+    0x0428, 0x0429, 0x042a, 0x042b, 0x042c, 0x042d, 0x042e, 0x042f,
+    0x0430, 0x0431, 0x0432, 0x0433, 0x0434, 0x0435, 0x0436, 0x0437,
+    0x0438, 0x0439, 0x043a, 0x043b, 0x043c, 0x043d, 0x043e, 0x043f,
+    0x0440, 0x0441, 0x0442, 0x0443, 0x0444, 0x0445, 0x0446, 0x0447,
+    0x0448, 0x0449, 0x044a, 0x044b, 0x044c, 0x044d, 0x044e, 0x044f,
+    0x2116, 0x0451, 0x0452, 0x0453, 0x0454, 0x0455, 0x0456, 0x0457,
+    0x0458, 0x0459, 0x045a, 0x045b, 0x045c, 0x00a7, 0x045e, 0x045f
+  },
+  /* ISO/IEC 8859-6 */
+  {
+    0x00a0, 0x0000, 0x0000, 0x0000, 0x00a4, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x060c, 0x00ad, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x061b, 0x0000, 0x0000, 0x0000, 0x061f,
+    0x0000, 0x0621, 0x0622, 0x0623, 0x0624, 0x0625, 0x0626, 0x0627,
+    0x0628, 0x0629, 0x062a, 0x062b, 0x062c, 0x062d, 0x062e, 0x062f,
+    0x0630, 0x0631, 0x0632, 0x0633, 0x0634, 0x0635, 0x0636, 0x0637,
+    0x0638, 0x0639, 0x063a, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0640, 0x0641, 0x0642, 0x0643, 0x0644, 0x0645, 0x0646, 0x0647,
+    0x0648, 0x0649, 0x064a, 0x064b, 0x064c, 0x064d, 0x064e, 0x064f,
+    0x0650, 0x0651, 0x0652, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000
+  },
+  /* ISO/IEC 8859-7 */
+  {
+    0x00a0, 0x2018, 0x2019, 0x00a3, 0x20ac, 0x20af, 0x00a6, 0x00a7,
+    0x00a8, 0x00a9, 0x037a, 0x00ab, 0x00ac, 0x00ad, 0x0000, 0x2015,
+    0x00b0, 0x00b1, 0x00b2, 0x00b3, 0x0384, 0x0385, 0x0386, 0x00b7,
+    0x0388, 0x0389, 0x038a, 0x00bb, 0x038c, 0x00bd, 0x038e, 0x038f,
+    0x0390, 0x0391, 0x0392, 0x0393, 0x0394, 0x0395, 0x0396, 0x0397,
+    0x0398, 0x0399, 0x039a, 0x039b, 0x039c, 0x039d, 0x039e, 0x039f,
+    0x03a0, 0x03a1, 0x0000, 0x03a3, 0x03a4, 0x03a5, 0x03a6, 0x03a7,
+    0x03a8, 0x03a9, 0x03aa, 0x03ab, 0x03ac, 0x03ad, 0x03ae, 0x03af,
+    0x03b0, 0x03b1, 0x03b2, 0x03b3, 0x03b4, 0x03b5, 0x03b6, 0x03b7,
+    0x03b8, 0x03b9, 0x03ba, 0x03bb, 0x03bc, 0x03bd, 0x03be, 0x03bf,
+    0x03c0, 0x03c1, 0x03c2, 0x03c3, 0x03c4, 0x03c5, 0x03c6, 0x03c7,
+    0x03c8, 0x03c9, 0x03ca, 0x03cb, 0x03cc, 0x03cd, 0x03ce, 0x0000
+  },
+  /* ISO/IEC 8859-8 */
+  {
+    0x00a0, 0x0000, 0x00a2, 0x00a3, 0x00a4, 0x00a5, 0x00a6, 0x00a7,
+    0x00a8, 0x00a9, 0x00d7, 0x00ab, 0x00ac, 0x00ad, 0x00ae, 0x00af,
+    0x00b0, 0x00b1, 0x00b2, 0x00b3, 0x00b4, 0x00b5, 0x00b6, 0x00b7,
+    0x00b8, 0x00b9, 0x00f7, 0x00bb, 0x00bc, 0x00bd, 0x00be, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x2017,
+    0x05d0, 0x05d1, 0x05d2, 0x05d3, 0x05d4, 0x05d5, 0x05d6, 0x05d7,
+    0x05d8, 0x05d9, 0x05da, 0x05db, 0x05dc, 0x05dd, 0x05de, 0x05df,
+    0x05e0, 0x05e1, 0x05e2, 0x05e3, 0x05e4, 0x05e5, 0x05e6, 0x05e7,
+    0x05e8, 0x05e9, 0x05ea, 0x0000, 0x0000, 0x200e, 0x200f, 0x0000
+  },
+  /* ISO/IEC 8859-9 */
+  {
+    0x00a0, 0x00a1, 0x00a2, 0x00a3, 0x00a4, 0x00a5, 0x00a6, 0x00a7,
+    0x00a8, 0x00a9, 0x00aa, 0x00ab, 0x00ac, 0x00ad, 0x00ae, 0x00af,
+    0x00b0, 0x00b1, 0x00b2, 0x00b3, 0x00b4, 0x00b5, 0x00b6, 0x00b7,
+    0x00b8, 0x00b9, 0x00ba, 0x00bb, 0x00bc, 0x00bd, 0x00be, 0x00bf,
+    0x00c0, 0x00c1, 0x00c2, 0x00c3, 0x00c4, 0x00c5, 0x00c6, 0x00c7,
+    0x00c8, 0x00c9, 0x00ca, 0x00cb, 0x00cc, 0x00cd, 0x00ce, 0x00cf,
+    0x011e, 0x00d1, 0x00d2, 0x00d3, 0x00d4, 0x00d5, 0x00d6, 0x00d7,
+    0x00d8, 0x00d9, 0x00da, 0x00db, 0x00dc, 0x0130, 0x015e, 0x00df,
+    0x00e0, 0x00e1, 0x00e2, 0x00e3, 0x00e4, 0x00e5, 0x00e6, 0x00e7,
+    0x00e8, 0x00e9, 0x00ea, 0x00eb, 0x00ec, 0x00ed, 0x00ee, 0x00ef,
+    0x011f, 0x00f1, 0x00f2, 0x00f3, 0x00f4, 0x00f5, 0x00f6, 0x00f7,
+    0x00f8, 0x00f9, 0x00fa, 0x00fb, 0x00fc, 0x0131, 0x015f, 0x00ff
+  },
+  /* ISO/IEC 8859-10 */
+  {
+    0x00a0, 0x0104, 0x0112, 0x0122, 0x012a, 0x0128, 0x0136, 0x00a7,
+    0x013b, 0x0110, 0x0160, 0x0166, 0x017d, 0x00ad, 0x016a, 0x014a,
+    0x00b0, 0x0105, 0x0113, 0x0123, 0x012b, 0x0129, 0x0137, 0x00b7,
+    0x013c, 0x0111, 0x0161, 0x0167, 0x017e, 0x2015, 0x016b, 0x014b,
+    0x0100, 0x00c1, 0x00c2, 0x00c3, 0x00c4, 0x00c5, 0x00c6, 0x012e,
+    0x010c, 0x00c9, 0x0118, 0x00cb, 0x0116, 0x00cd, 0x00ce, 0x00cf,
+    0x00d0, 0x0145, 0x014c, 0x00d3, 0x00d4, 0x00d5, 0x00d6, 0x0168,
+    0x00d8, 0x0172, 0x00da, 0x00db, 0x00dc, 0x00dd, 0x00de, 0x00df,
+    0x0101, 0x00e1, 0x00e2, 0x00e3, 0x00e4, 0x00e5, 0x00e6, 0x012f,
+    0x010d, 0x00e9, 0x0119, 0x00eb, 0x0117, 0x00ed, 0x00ee, 0x00ef,
+    0x00f0, 0x0146, 0x014d, 0x00f3, 0x00f4, 0x00f5, 0x00f6, 0x0169,
+    0x00f8, 0x0173, 0x00fa, 0x00fb, 0x00fc, 0x00fd, 0x00fe, 0x0138
+  },
+  /* ISO/IEC 8859-11 */
+  {
+    0x00a0, 0x0e01, 0x0e02, 0x0e03, 0x0e04, 0x0e05, 0x0e06, 0x0e07,
+    0x0e08, 0x0e09, 0x0e0a, 0x0e0b, 0x0e0c, 0x0e0d, 0x0e0e, 0x0e0f,
+    0x0e10, 0x0e11, 0x0e12, 0x0e13, 0x0e14, 0x0e15, 0x0e16, 0x0e17,
+    0x0e18, 0x0e19, 0x0e1a, 0x0e1b, 0x0e1c, 0x0e1d, 0x0e1e, 0x0e1f,
+    0x0e20, 0x0e21, 0x0e22, 0x0e23, 0x0e24, 0x0e25, 0x0e26, 0x0e27,
+    0x0e28, 0x0e29, 0x0e2a, 0x0e2b, 0x0e2c, 0x0e2d, 0x0e2e, 0x0e2f,
+    0x0e30, 0x0e31, 0x0e32, 0x0e33, 0x0e34, 0x0e35, 0x0e36, 0x0e37,
+    0x0e38, 0x0e39, 0x0e3a, 0x0000, 0x0000, 0x0000, 0x0000, 0x0e3f,
+    0x0e40, 0x0e41, 0x0e42, 0x0e43, 0x0e44, 0x0e45, 0x0e46, 0x0e47,
+    0x0e48, 0x0e49, 0x0e4a, 0x0e4b, 0x0e4c, 0x0e4d, 0x0e4e, 0x0e4f,
+    0x0e50, 0x0e51, 0x0e52, 0x0e53, 0x0e54, 0x0e55, 0x0e56, 0x0e57,
+    0x0e58, 0x0e59, 0x0e5a, 0x0e5b, 0x0000, 0x0000, 0x0000, 0x0000
+  },
+  /* ISO/IEC 8859-13 */
+  {
+    0x00a0, 0x201d, 0x00a2, 0x00a3, 0x00a4, 0x201e, 0x00a6, 0x00a7,
+    0x00d8, 0x00a9, 0x0156, 0x00ab, 0x00ac, 0x00ad, 0x00ae, 0x00c6,
+    0x00b0, 0x00b1, 0x00b2, 0x00b3, 0x201c, 0x00b5, 0x00b6, 0x00b7,
+    0x00f8, 0x00b9, 0x0157, 0x00bb, 0x00bc, 0x00bd, 0x00be, 0x00e6,
+    0x0104, 0x012e, 0x0100, 0x0106, 0x00c4, 0x00c5, 0x0118, 0x0112,
+    0x010c, 0x00c9, 0x0179, 0x0116, 0x0122, 0x0136, 0x012a, 0x013b,
+    0x0160, 0x0143, 0x0145, 0x00d3, 0x014c, 0x00d5, 0x00d6, 0x00d7,
+    0x0172, 0x0141, 0x015a, 0x016a, 0x00dc, 0x017b, 0x017d, 0x00df,
+    0x0105, 0x012f, 0x0101, 0x0107, 0x00e4, 0x00e5, 0x0119, 0x0113,
+    0x010d, 0x00e9, 0x017a, 0x0117, 0x0123, 0x0137, 0x012b, 0x013c,
+    0x0161, 0x0144, 0x0146, 0x00f3, 0x014d, 0x00f5, 0x00f6, 0x00f7,
+    0x0173, 0x0142, 0x015b, 0x016b, 0x00fc, 0x017c, 0x017e, 0x2019
+  },
+  /* ISO/IEC 8859-14 */
+  {
+    0x00a0, 0x1e02, 0x1e03, 0x00a3, 0x010a, 0x010b, 0x1e0a, 0x00a7,
+    0x1e80, 0x00a9, 0x1e82, 0x1e0b, 0x1ef2, 0x00ad, 0x00ae, 0x0178,
+    0x1e1e, 0x1e1f, 0x0120, 0x0121, 0x1e40, 0x1e41, 0x00b6, 0x1e56,
+    0x1e81, 0x1e57, 0x1e83, 0x1e60, 0x1ef3, 0x1e84, 0x1e85, 0x1e61,
+    0x00c0, 0x00c1, 0x00c2, 0x00c3, 0x00c4, 0x00c5, 0x00c6, 0x00c7,
+    0x00c8, 0x00c9, 0x00ca, 0x00cb, 0x00cc, 0x00cd, 0x00ce, 0x00cf,
+    0x0174, 0x00d1, 0x00d2, 0x00d3, 0x00d4, 0x00d5, 0x00d6, 0x1e6a,
+    0x00d8, 0x00d9, 0x00da, 0x00db, 0x00dc, 0x00dd, 0x0176, 0x00df,
+    0x00e0, 0x00e1, 0x00e2, 0x00e3, 0x00e4, 0x00e5, 0x00e6, 0x00e7,
+    0x00e8, 0x00e9, 0x00ea, 0x00eb, 0x00ec, 0x00ed, 0x00ee, 0x00ef,
+    0x0175, 0x00f1, 0x00f2, 0x00f3, 0x00f4, 0x00f5, 0x00f6, 0x1e6b,
+    0x00f8, 0x00f9, 0x00fa, 0x00fb, 0x00fc, 0x00fd, 0x0177, 0x00ff
+  },
+  /* ISO/IEC 8859-15 */
+  {
+    0x00a0, 0x00a1, 0x00a2, 0x00a3, 0x20ac, 0x00a5, 0x0160, 0x00a7,
+    0x0161, 0x00a9, 0x00aa, 0x00ab, 0x00ac, 0x00ad, 0x00ae, 0x00af,
+    0x00b0, 0x00b1, 0x00b2, 0x00b3, 0x017d, 0x00b5, 0x00b6, 0x00b7,
+    0x017e, 0x00b9, 0x00ba, 0x00bb, 0x0152, 0x0153, 0x0178, 0x00bf,
+    0x00c0, 0x00c1, 0x00c2, 0x00c3, 0x00c4, 0x00c5, 0x00c6, 0x00c7,
+    0x00c8, 0x00c9, 0x00ca, 0x00cb, 0x00cc, 0x00cd, 0x00ce, 0x00cf,
+    0x00d0, 0x00d1, 0x00d2, 0x00d3, 0x00d4, 0x00d5, 0x00d6, 0x00d7,
+    0x00d8, 0x00d9, 0x00da, 0x00db, 0x00dc, 0x00dd, 0x00de, 0x00df,
+    0x00e0, 0x00e1, 0x00e2, 0x00e3, 0x00e4, 0x00e5, 0x00e6, 0x00e7,
+    0x00e8, 0x00e9, 0x00ea, 0x00eb, 0x00ec, 0x00ed, 0x00ee, 0x00ef,
+    0x00f0, 0x00f1, 0x00f2, 0x00f3, 0x00f4, 0x00f5, 0x00f6, 0x00f7,
+    0x00f8, 0x00f9, 0x00fa, 0x00fb, 0x00fc, 0x00fd, 0x00fe, 0x00ff
+  }
+};
+
+/* Row of dvbpsi_text_8859 of each part of ISO/IEC 8859, -1 if none */
+static const int8_t pi_8859_rows[16] = {
+    -1, -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, -1, 10, 11, 12
+};
+
+/* Figure A.1, 0xc1 to 0xcf being the non-spacing diacritical marks */
+static const uint16_t dvbpsi_text_6937[96] =
+{
+    0x00a0, 0x00a1, 0x00a2, 0x00a3, 0x20ac, 0x00a5, 0x0023, 0x00a7,
+    0x00a4, 0x2018, 0x201c, 0x00ab, 0x2190, 0x2191, 0x2192, 0x2193,
+    0x00b0, 0x00b1, 0x00b2, 0x00b3, 0x00d7, 0x00b5, 0x00b6, 0x00b7,
+    0x00f7, 0x2019, 0x201d, 0x00bb, 0x00bc, 0x00bd, 0x00be, 0x00bf,
+    0x0000, 0x0300, 0x0301, 0x0302, 0x0303, 0x0304, 0x0306, 0x0307,
+    0x0308, 0x0000, 0x030a, 0x0327, 0x0000, 0x030b, 0x0328, 0x030c,
+    0x2015, 0x00b9, 0x00ae, 0x00a9, 0x2122, 0x266a, 0x00ac, 0x00a6,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x215b, 0x215c, 0x215d, 0x215e,
+    0x2126, 0x00c6, 0x0110, 0x00aa, 0x0126, 0x0000, 0x0132, 0x013f,
+    0x0141, 0x00d8, 0x0152, 0x00ba, 0x00de, 0x0166, 0x014a, 0x0149,
+    0x0138, 0x00e6, 0x0111, 0x00f0, 0x0127, 0x0131, 0x0133, 0x0140,
+    0x0142, 0x00f8, 0x0153, 0x00df, 0x00fe, 0x0167, 0x014b, 0x00ad
+};
+
+/* Spacing form of the diacritical marks 0xc0 to 0xcf, alone or before a
+   space */
+static const uint16_t dvbpsi_text_6937_spacing[16] =
+{
+    0x0000, 0x0060, 0x00b4, 0x005e, 0x007e, 0x00af, 0x02d8, 0x02d9,
+    0x00a8, 0x0000, 0x02da, 0x00b8, 0x0000, 0x02dd, 0x02db, 0x02c7
+};
+
+/* Letter composed with the diacritical marks 0xc0 to 0xcf for the letters
+   0x40 to 0x7f, 0 if there is none */
+static const uint16_t dvbpsi_text_6937_compose[16][64] =
+{
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000
+  },
+  {
+    0x0000, 0x00c0, 0x0000, 0x0000, 0x0000, 0x00c8, 0x0000, 0x0000,
+    0x0000, 0x00cc, 0x0000, 0x0000, 0x0000, 0x0000, 0x01f8, 0x00d2,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x00d9, 0x0000, 0x1e80,
+    0x0000, 0x1ef2, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x00e0, 0x0000, 0x0000, 0x0000, 0x00e8, 0x0000, 0x0000,
+    0x0000, 0x00ec, 0x0000, 0x0000, 0x0000, 0x0000, 0x01f9, 0x00f2,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x00f9, 0x0000, 0x1e81,
+    0x0000, 0x1ef3, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000
+  },
+  {
+    0x0000, 0x00c1, 0x0000, 0x0106, 0x0000, 0x00c9, 0x0000, 0x01f4,
+    0x0000, 0x00cd, 0x0000, 0x1e30, 0x0139, 0x1e3e, 0x0143, 0x00d3,
+    0x1e54, 0x0000, 0x0154, 0x015a, 0x0000, 0x00da, 0x0000, 0x1e82,
+    0x0000, 0x00dd, 0x0179, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x00e1, 0x0000, 0x0107, 0x0000, 0x00e9, 0x0000, 0x01f5,
+    0x0000, 0x00ed, 0x0000, 0x1e31, 0x013a, 0x1e3f, 0x0144, 0x00f3,
+    0x1e55, 0x0000, 0x0155, 0x015b, 0x0000, 0x00fa, 0x0000, 0x1e83,
+    0x0000, 0x00fd, 0x017a, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000
+  },
+  {
+    0x0000, 0x00c2, 0x0000, 0x0108, 0x0000, 0x00ca, 0x0000, 0x011c,
+    0x0124, 0x00ce, 0x0134, 0x0000, 0x0000, 0x0000, 0x0000, 0x00d4,
+    0x0000, 0x0000, 0x0000, 0x015c, 0x0000, 0x00db, 0x0000, 0x0174,
+    0x0000, 0x0176, 0x1e90, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x00e2, 0x0000, 0x0109, 0x0000, 0x00ea, 0x0000, 0x011d,
+    0x0125, 0x00ee, 0x0135, 0x0000, 0x0000, 0x0000, 0x0000, 0x00f4,
+    0x0000, 0x0000, 0x0000, 0x015d, 0x0000, 0x00fb, 0x0000, 0x0175,
+    0x0000, 0x0177, 0x1e91, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000
+  },
+  {
+    0x0000, 0x00c3, 0x0000, 0x0000, 0x0000, 0x1ebc, 0x0000, 0x0000,
+    0x0000, 0x0128, 0x0000, 0x0000, 0x0000, 0x0000, 0x00d1, 0x00d5,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0168, 0x1e7c, 0x0000,
+    0x0000, 0x1ef8, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x00e3, 0x0000, 0x0000, 0x0000, 0x1ebd, 0x0000, 0x0000,
+    0x0000, 0x0129, 0x0000, 0x0000, 0x0000, 0x0000, 0x00f1, 0x00f5,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0169, 0x1e7d, 0x0000,
+    0x0000, 0x1ef9, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000
+  },
+  {
+    0x0000, 0x0100, 0x0000, 0x0000, 0x0000, 0x0112, 0x0000, 0x1e20,
+    0x0000, 0x012a, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x014c,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x016a, 0x0000, 0x0000,
+    0x0000, 0x0232, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0101, 0x0000, 0x0000, 0x0000, 0x0113, 0x0000, 0x1e21,
+    0x0000, 0x012b, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x014d,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x016b, 0x0000, 0x0000,
+    0x0000, 0x0233, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000
+  },
+  {
+    0x0000, 0x0102, 0x0000, 0x0000, 0x0000, 0x0114, 0x0000, 0x011e,
+    0x0000, 0x012c, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x014e,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x016c, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0103, 0x0000, 0x0000, 0x0000, 0x0115, 0x0000, 0x011f,
+    0x0000, 0x012d, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x014f,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x016d, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000
+  },
+  {
+    0x0000, 0x0226, 0x1e02, 0x010a, 0x1e0a, 0x0116, 0x1e1e, 0x0120,
+    0x1e22, 0x0130, 0x0000, 0x0000, 0x0000, 0x1e40, 0x1e44, 0x022e,
+    0x1e56, 0x0000, 0x1e58, 0x1e60, 0x1e6a, 0x0000, 0x0000, 0x1e86,
+    0x1e8a, 0x1e8e, 0x017b, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0227, 0x1e03, 0x010b, 0x1e0b, 0x0117, 0x1e1f, 0x0121,
+    0x1e23, 0x0000, 0x0000, 0x0000, 0x0000, 0x1e41, 0x1e45, 0x022f,
+    0x1e57, 0x0000, 0x1e59, 0x1e61, 0x1e6b, 0x0000, 0x0000, 0x1e87,
+    0x1e8b, 0x1e8f, 0x017c, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000
+  },
+  {
+    0x0000, 0x00c4, 0x0000, 0x0000, 0x0000, 0x00cb, 0x0000, 0x0000,
+    0x1e26, 0x00cf, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x00d6,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x00dc, 0x0000, 0x1e84,
+    0x1e8c, 0x0178, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x00e4, 0x0000, 0x0000, 0x0000, 0x00eb, 0x0000, 0x0000,
+    0x1e27, 0x00ef, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x00f6,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x1e97, 0x00fc, 0x0000, 0x1e85,
+    0x1e8d, 0x00ff, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000
+  },
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000
+  },
+  {
+    0x0000, 0x00c5, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x016e, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x00e5, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x016f, 0x0000, 0x1e98,
+    0x0000, 0x1e99, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000
+  },
+  {
+    0x0000, 0x0000, 0x0000, 0x00c7, 0x1e10, 0x0228, 0x0000, 0x0122,
+    0x1e28, 0x0000, 0x0000, 0x0136, 0x013b, 0x0000, 0x0145, 0x0000,
+    0x0000, 0x0000, 0x0156, 0x015e, 0x0162, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x00e7, 0x1e11, 0x0229, 0x0000, 0x0123,
+    0x1e29, 0x0000, 0x0000, 0x0137, 0x013c, 0x0000, 0x0146, 0x0000,
+    0x0000, 0x0000, 0x0157, 0x015f, 0x0163, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000
+  },
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000
+  },
+  {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0150,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0170, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0151,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0171, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000
+  },
+  {
+    0x0000, 0x0104, 0x0000, 0x0000, 0x0000, 0x0118, 0x0000, 0x0000,
+    0x0000, 0x012e, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x01ea,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0172, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0105, 0x0000, 0x0000, 0x0000, 0x0119, 0x0000, 0x0000,
+    0x0000, 0x012f, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x01eb,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0173, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000
+  },
+  {
+    0x0000, 0x01cd, 0x0000, 0x010c, 0x010e, 0x011a, 0x0000, 0x01e6,
+    0x021e, 0x01cf, 0x0000, 0x01e8, 0x013d, 0x0000, 0x0147, 0x01d1,
+    0x0000, 0x0000, 0x0158, 0x0160, 0x0164, 0x01d3, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x017d, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x01ce, 0x0000, 0x010d, 0x010f, 0x011b, 0x0000, 0x01e7,
+    0x021f, 0x01d0, 0x01f0, 0x01e9, 0x013e, 0x0000, 0x0148, 0x01d2,
+    0x0000, 0x0000, 0x0159, 0x0161, 0x0165, 0x01d4, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x017e, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000
+  }
+};
+
+/*****************************************************************************
+ * dvbpsi_text_t
+ *****************************************************************************
+ * UTF-8 text being written into the buffer of the caller.
+ *****************************************************************************/
+typedef struct dvbpsi_text_s
+{
+    char *                  psz_utf8;
+    size_t                  i_size;
+    size_t                  i_written;      /* in the buffer */
+    size_t                  i_length;       /* of the whole text */
+    bool                    b_full;         /* truncated */
+
+    bool                    b_emphasis_only;
+    bool                    b_emphasis;
+} dvbpsi_text_t;
+
+/***** dvbpsi_text_visible ***** Whether characters are kept *****/
+static inline bool dvbpsi_text_visible(const dvbpsi_text_t *p_text)
+{
+    return !p_text->b_emphasis_only || p_text->b_emphasis;
+}
+
+/***** dvbpsi_text_append ***** Appends bytes of whole characters *****/
+static void dvbpsi_text_append(dvbpsi_text_t *p_text, const uint8_t *p_bytes,
+                               size_t i_bytes, bool b_ascii)
+{
+    if (!p_text->b_full)
+    {
+        /* Never split a character, nor write past a truncation */
+        size_t i_room = p_text->i_size > p_text->i_written
+                      ? p_text->i_size - p_text->i_written - 1 : 0;
+        size_t i_copy = i_bytes <= i_room ? i_bytes : (b_ascii ? i_room : 0);
+        memcpy(p_text->psz_utf8 + p_text->i_written, p_bytes, i_copy);
+        p_text->i_written += i_copy;
+        p_text->b_full = i_copy < i_bytes;
+    }
+    p_text->i_length += i_bytes;
+}
+
+/***** dvbpsi_text_put ***** Appends a character in UTF-8 *****/
+static void dvbpsi_text_put(dvbpsi_text_t *p_text, uint32_t i_char)
+{
+    uint8_t p_utf8[4];
+    size_t i_bytes;
+
+    if (!dvbpsi_text_visible(p_text))
+        return;
+
+    if (i_char < 0x80)
+    {
+        p_utf8[0] = i_char;
+        i_bytes = 1;
+    }
+    else if (i_char < 0x800)
+    {
+        p_utf8[0] = 0xc0 | (i_char >> 6);
+        p_utf8[1] = 0x80 | (i_char & 0x3f);
+        i_bytes = 2;
+    }
+    else if (i_char < 0x10000)
+    {
+        p_utf8[0] = 0xe0 | (i_char >> 12);
+        p_utf8[1] = 0x80 | ((i_char >> 6) & 0x3f);
+        p_utf8[2] = 0x80 | (i_char & 0x3f);
+        i_bytes = 3;
+    }
+    else
+    {
+        p_utf8[0] = 0xf0 | (i_char >> 18);
+        p_utf8[1] = 0x80 | ((i_char >> 12) & 0x3f);
+        p_utf8[2] = 0x80 | ((i_char >> 6) & 0x3f);
+        p_utf8[3] = 0x80 | (i_char & 0x3f);
+        i_bytes = 4;
+    }
+    dvbpsi_text_append(p_text, p_utf8, i_bytes, false);
+}
+
+/***** dvbpsi_text_control ***** Handles a control code 0x80 to 0x9f *****/
+static void dvbpsi_text_control(dvbpsi_text_t *p_text, uint32_t i_code)
+{
+    if (i_code == 0x86)
+        p_text->b_emphasis = true;
+    else if (i_code == 0x87)
+        p_text->b_emphasis = false;
+    else if (i_code == 0x8a)
+        dvbpsi_text_put(p_text, '\n');
+}
+
+/*****************************************************************************
+ * dvbpsi_text_ascii
+ *****************************************************************************
+ * Length of the run of printable ASCII characters, 0x20 to 0x7e, at the
+ * start of a text.
+ *****************************************************************************/
+static size_t dvbpsi_text_ascii(const uint8_t *p_data, size_t i_size)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    /* The bytes from 0x80 are negative, and below 0x20 as well */
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i del = _mm_set1_epi8(0x7f);
+    while (i + 16 <= i_size)
+    {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)(p_data + i));
+        unsigned int i_mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmplt_epi8(bytes, space),
+                                                             _mm_cmpeq_epi8(bytes, del)));
+        if (i_mask)
+            return i + __builtin_ctz(i_mask);
+        i += 16;
+    }
+#endif
+
+    /* 8 bytes at once, stopping at any byte below 0x20 or above 0x7e */
+    while (i + 8 <= i_size)
+    {
+        uint64_t i_word;
+        memcpy(&i_word, p_data + i, 8);
+        uint64_t i_below = (i_word - UINT64_C(0x2020202020202020)) & ~i_word;
+        uint64_t i_above = (i_word + UINT64_C(0x0101010101010101)) | i_word;
+        if ((i_below | i_above) & UINT64_C(0x8080808080808080))
+            break;
+        i += 8;
+    }
+
+    while (i < i_size && p_data[i] >= 0x20 && p_data[i] < 0x7f)
+        i++;
+    return i;
+}
+
+/***** dvbpsi_text_single ***** Converts a single byte character set *****/
+static void dvbpsi_text_single(dvbpsi_text_t *p_text, const uint8_t *p_data,
+                               size_t i_size, const uint16_t *p_upper)
+{
+    size_t i = 0;
+    while (i < i_size)
+    {
+        size_t i_ascii = dvbpsi_text_ascii(p_data + i, i_size - i);
+        if (i_ascii > 0)
+        {
+            if (dvbpsi_text_visible(p_text))
+                dvbpsi_text_append(p_text, p_data + i, i_ascii, true);
+            i += i_ascii;
+            continue;
+        }
+
+        uint8_t i_byte = p_data[i++];
+        if (i_byte < 0xa0)
+        {
+            /* Control codes, and DEL */
+            if (i_byte >= 0x80)
+                dvbpsi_text_control(p_text, i_byte);
+            continue;
+        }
+
+        /* ISO/IEC 8859-1 */
+        if (p_upper == NULL)
+        {
+            dvbpsi_text_put(p_text, i_byte);
+            continue;
+        }
+
+        uint32_t i_char = p_upper[i_byte - 0xa0];
+        if (p_upper == dvbpsi_text_6937 && i_byte >= 0xc1 && i_byte <= 0xcf && i_char)
+        {
+            /* Non-spacing diacritical mark, before its letter */
+            uint8_t i_letter = i < i_size ? p_data[i] : 0;
+            if (i_letter >= 0x40 && i_letter < 0x7f
+             && dvbpsi_text_6937_compose[i_byte - 0xc0][i_letter - 0x40])
+            {
+                i_char = dvbpsi_text_6937_compose[i_byte - 0xc0][i_letter - 0x40];
+                i++;
+            }
+            else if (i_letter > 0x20 && i_letter < 0x7f)
+            {
+                /* Combining mark after its letter */
+                dvbpsi_text_put(p_text, i_letter);
+                i++;
+            }
+            else
+            {
+                i_char = dvbpsi_text_6937_spacing[i_byte - 0xc0];
+                i += i_letter == 0x20;
+            }
+        }
+        dvbpsi_text_put(p_text, i_char ? i_char : 0xfffd);
+    }
+}
+
+/***** dvbpsi_text_ucs2 ***** Converts ISO/IEC 10646 in 16 bits *****/
+static void dvbpsi_text_ucs2(dvbpsi_text_t *p_text, const uint8_t *p_data, size_t i_size)
+{
+    for (size_t i = 0; i + 1 < i_size; i += 2)
+    {
+        uint32_t i_char = ((uint32_t)p_data[i] << 8) | p_data[i + 1];
+        if (i_char >= 0xe080 && i_char <= 0xe09f)
+        {
+            /* Control codes of the two bytes character tables */
+            dvbpsi_text_control(p_text, i_char - 0xe000);
+            continue;
+        }
+        if (i_char < 0x20 || (i_char >= 0x7f && i_char < 0xa0))
+            continue;
+
+        if (i_char >= 0xd800 && i_char < 0xdc00 && i + 3 < i_size)
+        {
+            uint32_t i_low = ((uint32_t)p_data[i + 2] << 8) | p_data[i + 3];
+            if (i_low >= 0xdc00 && i_low < 0xe000)
+            {
+                i_char = 0x10000 + ((i_char - 0xd800) << 10) + (i_low - 0xdc00);
+                i += 2;
+            }
+        }
+        if (i_char >= 0xd800 && i_char < 0xe000)
+            i_char = 0xfffd;    /* unpaired surrogate */
+        dvbpsi_text_put(p_text, i_char);
+    }
+}
+
+/***** dvbpsi_text_utf8 ***** Checks and copies UTF-8 *****/
+static void dvbpsi_text_utf8(dvbpsi_text_t *p_text, const uint8_t *p_data, size_t i_size)
+{
+    size_t i = 0;
+    while (i < i_size)
+    {
+        size_t i_ascii = dvbpsi_text_ascii(p_data + i, i_size - i);
+        if (i_ascii > 0)
+        {
+            if (dvbpsi_text_visible(p_text))
+                dvbpsi_text_append(p_text, p_data + i, i_ascii, true);
+            i += i_ascii;
+            continue;
+        }
+
+        uint8_t i_byte = p_data[i];
+        if (i_byte < 0x80)
+        {
+            i++;    /* C0 control codes and DEL */
+            continue;
+        }
+
+        /* Length and smallest character of the sequence */
+        size_t i_bytes;
+        uint32_t i_char, i_min;
+        if (i_byte >= 0xc2 && i_byte <= 0xdf)
+            i_bytes = 2, i_char = i_byte & 0x1f, i_min = 0x80;
+        else if (i_byte >= 0xe0 && i_byte <= 0xef)
+            i_bytes = 3, i_char = i_byte & 0x0f, i_min = 0x800;
+        else if (i_byte >= 0xf0 && i_byte <= 0xf4)
+            i_bytes = 4, i_char = i_byte & 0x07, i_min = 0x10000;
+        else
+            i_bytes = 0, i_char = 0, i_min = 0;
+
+        size_t k = 1;
+        while (k < i_bytes && i + k < i_size && (p_data[i + k] & 0xc0) == 0x80)
+        {
+            i_char = (i_char << 6) | (p_data[i + k] & 0x3f);
+            k++;
+        }
+        if (i_bytes == 0 || k < i_bytes || i_char < i_min || i_char > 0x10ffff
+         || (i_char >= 0xd800 && i_char < 0xe000))
+        {
+            /* Invalid sequence, up to the next lead byte */
+            dvbpsi_text_put(p_text, 0xfffd);
+            i += k;
+            continue;
+        }
+
+        if (i_char < 0xa0)
+            dvbpsi_text_control(p_text, i_char);
+        else if (dvbpsi_text_visible(p_text))
+            dvbpsi_text_append(p_text, p_data + i, i_bytes, false);
+        i += i_bytes;
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_text_to_utf8
+ *****************************************************************************/
+int dvbpsi_text_to_utf8(const uint8_t *p_text, size_t i_length, uint32_t i_flags,
+                        char *psz_utf8, size_t i_size)
+{
+    dvbpsi_text_t text = { psz_utf8, i_size, 0, 0, false,
+                           (i_flags & DVBPSI_TEXT_EMPHASIS) != 0, false };
+
+    if (i_size > 0)
+        psz_utf8[0] = '\0';
+    if (p_text == NULL || i_length == 0)
+        return 0;
+
+    /* Selection of the character table */
+    int i_table = DVBPSI_TEXT_6937;
+    unsigned int i_part = 0;
+    size_t i_start = 0;
+    if (p_text[0] >= 0x01 && p_text[0] <= 0x0b)
+    {
+        /* ISO/IEC 8859-5 to 8859-15 */
+        i_table = DVBPSI_TEXT_8859;
+        i_part = p_text[0] + 4;
+        i_start = 1;
+    }
+    else if (p_text[0] == 0x10)
+    {
+        if (i_length < 3 || p_text[1] != 0x00)
+            return -1;
+        i_table = DVBPSI_TEXT_8859;
+        i_part = p_text[2];
+        i_start = 3;
+    }
+    else if (p_text[0] == 0x11 || p_text[0] == 0x14)
+    {
+        /* Basic Multilingual Plane, and its Big5 subset */
+        i_table = DVBPSI_TEXT_UCS2;
+        i_start = 1;
+    }
+    else if (p_text[0] == 0x15)
+    {
+        i_table = DVBPSI_TEXT_UTF8;
+        i_start = 1;
+    }
+    else if (p_text[0] < 0x20)
+        return -1;
+
+    if (i_table == DVBPSI_TEXT_8859
+     && (i_part < 1 || i_part > 15 || (i_part > 1 && pi_8859_rows[i_part] < 0)))
+        return -1;
+
+    const uint8_t *p_data = p_text + i_start;
+    size_t i_data = i_length - i_start;
+    switch (i_table)
+    {
+    case DVBPSI_TEXT_6937:
+        dvbpsi_text_single(&text, p_data, i_data, dvbpsi_text_6937);
+        break;
+    case DVBPSI_TEXT_8859:
+        dvbpsi_text_single(&text, p_data, i_data,
+                           i_part == 1 ? NULL : dvbpsi_text_8859[pi_8859_rows[i_part]]);
+        break;
+    case DVBPSI_TEXT_UCS2:
+        dvbpsi_text_ucs2(&text, p_data, i_data);
+        break;
+    default:
+        dvbpsi_text_utf8(&text, p_data, i_data);
+        break;
+    }
+
+    if (i_size > 0)
+        psz_utf8[text.i_written] = '\0';
+    return text.i_length > INT_MAX ? INT_MAX : (int)text.i_length;
+}
@@ -0,0 +1,84 @@
+/*****************************************************************************
+ * text.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <text.h>
+ * \brief DVB text to UTF-8.
+ *
+ * The names and texts of the DVB SI descriptors, such as the service,
+ * short event, extended event, network name and bouquet name descriptors,
+ * start with the selection of their character table as in ETSI EN 300 468
+ * annex A: the Latin alphabet of figure A.1 by default, a part of ISO/IEC
+ * 8859, UTF-16 or UTF-8. They also carry control codes, the emphasis of
+ * the short name of a service and line breaks.
+ */
+
+#ifndef _DVBPSI_TEXT_H_
+#define _DVBPSI_TEXT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \def DVBPSI_TEXT_EMPHASIS
+ * \brief Only keeps the characters between the character emphasis on and
+ * off control codes, for instance the short name of a service.
+ */
+#define DVBPSI_TEXT_EMPHASIS 0x01
+
+/*****************************************************************************
+ * dvbpsi_text_to_utf8
+ *****************************************************************************/
+/*!
+ * \fn int dvbpsi_text_to_utf8(const uint8_t *p_text, size_t i_length,
+ *                             uint32_t i_flags, char *psz_utf8, size_t i_size)
+ * \brief Converts a DVB text to UTF-8
+ * \param p_text the text, from its character table selection if any, for
+ *        instance dvbpsi_service_dr_t::i_service_name
+ * \param i_length length of the text in bytes
+ * \param i_flags DVBPSI_TEXT_* options, 0 for the whole text
+ * \param psz_utf8 buffer receiving the text, always terminated by a NUL
+ *        byte when i_size is not 0
+ * \param i_size size of the buffer
+ * \return the length of the whole text in bytes, without the NUL byte, as
+ *         snprintf() does, the text being truncated at a character boundary
+ *         when it is larger than i_size - 1, or -1 if its character table
+ *         is reserved or not supported: KS X 1001, GB-2312 and the tables
+ *         of an encoding_type_id.
+ *
+ * Runs of ASCII characters are copied 16 bytes at a time with SSE2, or 8
+ * otherwise. The diacritical marks of figure A.1 are composed with the
+ * letter they precede, the control codes are dropped but for CR/LF, which
+ * gives a line feed, and characters missing from their table give U+FFFD.
+ * Nothing is allocated.
+ */
+int dvbpsi_text_to_utf8(const uint8_t *p_text, size_t i_length, uint32_t i_flags,
+                        char *psz_utf8, size_t i_size);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of text.h"
+#endif
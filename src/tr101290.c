@@ -0,0 +1,1089 @@
+/*****************************************************************************
+ * tr101290.c: ETSI TR 101 290 measurements
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "scan.h"
+#include "tr101290.h"
+
+#define DVBPSI_TR101290_PIDS    8192
+#define DVBPSI_TR101290_NULL    0x1fff
+#define DVBPSI_TR101290_NO_CC   0xff
+
+/* Times are kept in 27 MHz ticks, the PCR unit */
+#define DVBPSI_TR101290_MS(ms)  ((int64_t)(ms) * 27000)
+#define DVBPSI_TR101290_WRAP    (INT64_C(300) << 33)
+
+#define DVBPSI_TR101290_PSI_MAX         DVBPSI_TR101290_MS(500)
+#define DVBPSI_TR101290_PCR_MAX         DVBPSI_TR101290_MS(40)
+#define DVBPSI_TR101290_PCR_JUMP        DVBPSI_TR101290_MS(100)
+#define DVBPSI_TR101290_SI_MIN          DVBPSI_TR101290_MS(25)
+/* 500 ns, in half ticks */
+#define DVBPSI_TR101290_PCR_TOLERANCE   27
+/* Shortest and longest spans of PCRs the transport rate is measured over */
+#define DVBPSI_TR101290_RATE_MIN        DVBPSI_TR101290_MS(100)
+#define DVBPSI_TR101290_RATE_MAX        DVBPSI_TR101290_MS(10000)
+
+/* Packets in a row with a sync byte to lock, and without one to lose it */
+#define DVBPSI_TR101290_LOCK    5
+#define DVBPSI_TR101290_UNLOCK  2
+
+/* pi_kind bits */
+#define DVBPSI_TR101290_KIND_HANDLE   0x01    /* sections are assembled */
+#define DVBPSI_TR101290_KIND_FIXED    0x02    /* PSI or SI PID, always assembled */
+#define DVBPSI_TR101290_KIND_PMT      0x04    /* program_map_PID of the PAT */
+#define DVBPSI_TR101290_KIND_ES       0x08    /* referred to by a PMT */
+#define DVBPSI_TR101290_KIND_PCR      0x10    /* PCR_PID of a PMT */
+#define DVBPSI_TR101290_KIND_ES_LATE  0x20    /* PID_error of the current gap */
+#define DVBPSI_TR101290_KIND_PCR_LATE 0x40    /* PCR_repetition_error of the
+                                                 current gap */
+
+/*****************************************************************************
+ * dvbpsi_tr101290_timer_t
+ *****************************************************************************
+ * Last occurrence of a table, each gap longer than the limit being reported
+ * once, while it lasts or when it ends.
+ *****************************************************************************/
+typedef struct dvbpsi_tr101290_timer_s
+{
+    int64_t                 i_last;     /* DVBPSI_TIME_NONE until armed */
+    bool                    b_late;
+} dvbpsi_tr101290_timer_t;
+
+/*****************************************************************************
+ * dvbpsi_tr101290_program_t
+ *****************************************************************************
+ * Program of the PAT, with the PIDs of its last PMT.
+ *****************************************************************************/
+typedef struct dvbpsi_tr101290_program_s
+{
+    uint16_t                i_number;
+    uint16_t                i_pmt_pid;
+    uint16_t                i_pcr_pid;
+    bool                    b_pmt;      /* a PMT was received */
+    bool                    b_stale;    /* left out of the PAT being read */
+    uint32_t                i_crc;      /* CRC_32 of the last PMT section */
+    dvbpsi_tr101290_timer_t pmt;
+
+    uint16_t *              pi_es;
+    size_t                  i_es;
+} dvbpsi_tr101290_program_t;
+
+/*****************************************************************************
+ * dvbpsi_tr101290_si_t
+ *****************************************************************************
+ * SI table with a repetition interval, and the last section seen of it.
+ *****************************************************************************/
+typedef struct dvbpsi_tr101290_si_s
+{
+    uint16_t                i_pid;
+    uint8_t                 i_table_id;
+    int64_t                 i_max;
+    dvbpsi_tr101290_timer_t timer;
+
+    uint32_t                i_section;  /* table_id_extension and
+                                           section_number */
+} dvbpsi_tr101290_si_t;
+
+static const dvbpsi_tr101290_si_t si_tables[] =
+{
+    { 0x10, 0x40, DVBPSI_TR101290_MS(10000), { 0, false }, 0 }, /* NIT actual */
+    { 0x11, 0x42, DVBPSI_TR101290_MS(2000),  { 0, false }, 0 }, /* SDT actual */
+    { 0x12, 0x4e, DVBPSI_TR101290_MS(2000),  { 0, false }, 0 }, /* EIT p/f actual */
+    { 0x14, 0x70, DVBPSI_TR101290_MS(30000), { 0, false }, 0 }, /* TDT */
+};
+#define DVBPSI_TR101290_SI (sizeof(si_tables) / sizeof(si_tables[0]))
+
+/* PIDs whose sections are always assembled */
+static const uint16_t fixed_pids[] = { 0x00, 0x01, 0x10, 0x11, 0x12, 0x14 };
+
+struct dvbpsi_tr101290_s
+{
+    dvbpsi_tr101290_callback pf_callback;
+    void *                  p_cb_data;
+
+    dvbpsi_packet_format_t  i_format;
+    size_t                  i_stride;
+    size_t                  i_offset;   /* of the sync byte */
+    int64_t                 i_pid_timeout;
+    bool                    b_error;
+
+    /* Synchronization */
+    bool                    b_locked;
+    unsigned int            i_good;
+    unsigned int            i_bad;
+    uint8_t                 p_carry[204];
+    size_t                  i_carry;
+
+    /* Clock */
+    uint64_t                i_packet;   /* index of the current packet */
+    int64_t                 i_now;      /* time of the current packet */
+    int64_t                 i_arrival;  /* of the buffer, DVBPSI_TIME_NONE
+                                           to time with the PCRs */
+    uint16_t                i_ref_pid;  /* PID timing the packets */
+    int64_t                 i_ref_time;
+    uint64_t                i_ref_packet;
+    int64_t                 i_window_ticks;
+    uint64_t                i_window_packets;
+    double                  f_rate;     /* ticks per packet, 0 if unknown */
+
+    /* Tables */
+    dvbpsi_tr101290_timer_t pat;
+    bool                    b_cat;
+    bool                    b_scrambled;
+    bool                    b_cat_error;    /* scrambled without a CAT */
+    dvbpsi_tr101290_si_t    si[DVBPSI_TR101290_SI];
+
+    dvbpsi_tr101290_program_t *p_programs;
+    size_t                  i_programs;
+    size_t                  i_programs_size;
+    bool                    b_changed;
+
+    uint64_t                pi_counts[DVBPSI_TR101290_MAX];
+    dvbpsi_t *              pp_handles[DVBPSI_TR101290_PIDS];
+
+    /* Per PID state and counters, one array per field */
+    uint8_t                 pi_kind[DVBPSI_TR101290_PIDS];
+    uint8_t                 pi_cc[DVBPSI_TR101290_PIDS];
+    uint8_t                 pi_duplicates[DVBPSI_TR101290_PIDS];
+    int64_t                 pi_seen[DVBPSI_TR101290_PIDS];
+    int64_t                 pi_pcr[DVBPSI_TR101290_PIDS];       /* -1 if none */
+    uint64_t                pi_pcr_packet[DVBPSI_TR101290_PIDS];
+    int64_t                 pi_pcr_time[DVBPSI_TR101290_PIDS];
+
+    uint64_t                pi_packets[DVBPSI_TR101290_PIDS];
+    uint32_t                pi_cc_errors[DVBPSI_TR101290_PIDS];
+    uint32_t                pi_transport_errors[DVBPSI_TR101290_PIDS];
+    uint32_t                pi_pid_errors[DVBPSI_TR101290_PIDS];
+    uint32_t                pi_pcr_errors[DVBPSI_TR101290_PIDS];
+    uint32_t                pi_table_errors[DVBPSI_TR101290_PIDS];
+};
+
+/*****************************************************************************
+ * dvbpsi_tr101290_decoder_t
+ *****************************************************************************
+ * Decoder of the handles, giving the sections of a PID to the engine.
+ *****************************************************************************/
+typedef struct dvbpsi_tr101290_decoder_s
+{
+    DVBPSI_DECODER_COMMON
+
+    dvbpsi_tr101290_t *     p_tr;
+    uint16_t                i_pid;
+} dvbpsi_tr101290_decoder_t;
+
+/*****************************************************************************
+ * dvbpsi_tr101290_error
+ *****************************************************************************
+ * Counts an error and reports it.
+ *****************************************************************************/
+static void dvbpsi_tr101290_error(dvbpsi_tr101290_t *p_tr, dvbpsi_tr101290_error_t i_type,
+                                  uint16_t i_pid, uint8_t i_table_id)
+{
+    p_tr->pi_counts[i_type]++;
+    if (i_pid < DVBPSI_TR101290_PIDS)
+    {
+        switch (i_type)
+        {
+        case DVBPSI_TR101290_CC:
+            p_tr->pi_cc_errors[i_pid]++;
+            break;
+        case DVBPSI_TR101290_TRANSPORT:
+            p_tr->pi_transport_errors[i_pid]++;
+            break;
+        case DVBPSI_TR101290_PID:
+            p_tr->pi_pid_errors[i_pid]++;
+            break;
+        case DVBPSI_TR101290_PCR_REPETITION:
+        case DVBPSI_TR101290_PCR_DISCONTINUITY:
+        case DVBPSI_TR101290_PCR_ACCURACY:
+            p_tr->pi_pcr_errors[i_pid]++;
+            break;
+        default:
+            p_tr->pi_table_errors[i_pid]++;
+            break;
+        }
+    }
+
+    if (p_tr->pf_callback == NULL)
+        return;
+
+    dvbpsi_tr101290_event_t event = {
+        .i_type = i_type,
+        .i_pid = i_pid,
+        .i_table_id = i_table_id,
+        .i_time = p_tr->i_now == DVBPSI_TIME_NONE ? DVBPSI_TIME_NONE : p_tr->i_now / 27,
+        .i_packet = p_tr->i_packet,
+        .i_count = p_tr->pi_counts[i_type],
+    };
+    p_tr->pf_callback(p_tr->p_cb_data, &event);
+}
+
+/*****************************************************************************
+ * dvbpsi_tr101290_hit / dvbpsi_tr101290_check
+ *****************************************************************************
+ * Occurrence of a table, reporting the gap it ends, and check of the gap
+ * since the last occurrence, arming the timer at the first known time.
+ *****************************************************************************/
+static void dvbpsi_tr101290_hit(dvbpsi_tr101290_t *p_tr, dvbpsi_tr101290_timer_t *p_timer,
+                                int64_t i_max, dvbpsi_tr101290_error_t i_type,
+                                uint16_t i_pid, uint8_t i_table_id)
+{
+    if (p_tr->i_now == DVBPSI_TIME_NONE)
+        return;
+
+    if (p_timer->i_last != DVBPSI_TIME_NONE && !p_timer->b_late
+        && p_tr->i_now - p_timer->i_last > i_max)
+        dvbpsi_tr101290_error(p_tr, i_type, i_pid, i_table_id);
+    p_timer->i_last = p_tr->i_now;
+    p_timer->b_late = false;
+}
+
+static void dvbpsi_tr101290_check(dvbpsi_tr101290_t *p_tr, dvbpsi_tr101290_timer_t *p_timer,
+                                  int64_t i_max, dvbpsi_tr101290_error_t i_type,
+                                  uint16_t i_pid, uint8_t i_table_id)
+{
+    if (p_timer->i_last == DVBPSI_TIME_NONE)
+        p_timer->i_last = p_tr->i_now;
+    else if (!p_timer->b_late && p_tr->i_now - p_timer->i_last > i_max)
+    {
+        p_timer->b_late = true;
+        dvbpsi_tr101290_error(p_tr, i_type, i_pid, i_table_id);
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_tr101290_check_all
+ *****************************************************************************
+ * Looks for the tables, PCRs and PIDs missing for too long.
+ *****************************************************************************/
+static void dvbpsi_tr101290_check_all(dvbpsi_tr101290_t *p_tr)
+{
+    if (p_tr->i_now == DVBPSI_TIME_NONE)
+        return;
+
+    dvbpsi_tr101290_check(p_tr, &p_tr->pat, DVBPSI_TR101290_PSI_MAX,
+                          DVBPSI_TR101290_PAT, 0x00, 0x00);
+    for (size_t i = 0; i < DVBPSI_TR101290_SI; i++)
+        if (p_tr->si[i].timer.i_last != DVBPSI_TIME_NONE)
+            dvbpsi_tr101290_check(p_tr, &p_tr->si[i].timer, p_tr->si[i].i_max,
+                                  DVBPSI_TR101290_SI_REPETITION, p_tr->si[i].i_pid,
+                                  p_tr->si[i].i_table_id);
+
+    for (size_t i = 0; i < p_tr->i_programs; i++)
+    {
+        dvbpsi_tr101290_program_t *p_program = &p_tr->p_programs[i];
+        dvbpsi_tr101290_check(p_tr, &p_program->pmt, DVBPSI_TR101290_PSI_MAX,
+                              DVBPSI_TR101290_PMT, p_program->i_pmt_pid, 0x02);
+
+        for (size_t j = 0; j < p_program->i_es; j++)
+        {
+            uint16_t i_pid = p_program->pi_es[j];
+            if (p_tr->pi_kind[i_pid] & DVBPSI_TR101290_KIND_ES_LATE)
+                continue;
+            if (p_tr->pi_seen[i_pid] == DVBPSI_TIME_NONE)
+                p_tr->pi_seen[i_pid] = p_tr->i_now;
+            else if (p_tr->i_now - p_tr->pi_seen[i_pid] > p_tr->i_pid_timeout)
+            {
+                p_tr->pi_kind[i_pid] |= DVBPSI_TR101290_KIND_ES_LATE;
+                dvbpsi_tr101290_error(p_tr, DVBPSI_TR101290_PID, i_pid, 0);
+            }
+        }
+
+        uint16_t i_pid = p_program->i_pcr_pid;
+        if (!p_program->b_pmt || i_pid == DVBPSI_TR101290_NULL
+            || (p_tr->pi_kind[i_pid] & DVBPSI_TR101290_KIND_PCR_LATE))
+            continue;
+        if (p_tr->pi_pcr_time[i_pid] == DVBPSI_TIME_NONE)
+            p_tr->pi_pcr_time[i_pid] = p_tr->i_now;
+        else if (p_tr->i_now - p_tr->pi_pcr_time[i_pid] > DVBPSI_TR101290_PCR_MAX)
+        {
+            p_tr->pi_kind[i_pid] |= DVBPSI_TR101290_KIND_PCR_LATE;
+            dvbpsi_tr101290_error(p_tr, DVBPSI_TR101290_PCR_REPETITION, i_pid, 0);
+        }
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_tr101290_event
+ *****************************************************************************
+ * Event callback of the handles, for the sections with a bad CRC_32.
+ *****************************************************************************/
+static void dvbpsi_tr101290_event(dvbpsi_t *p_dvbpsi, const dvbpsi_event_t *p_event,
+                                  void *p_cb_data)
+{
+    (void)p_dvbpsi;
+    dvbpsi_tr101290_t *p_tr = (dvbpsi_tr101290_t *)p_cb_data;
+
+    if (p_event->i_type == DVBPSI_EVENT_CRC_ERROR)
+        dvbpsi_tr101290_error(p_tr, DVBPSI_TR101290_CRC, p_event->i_pid,
+                              p_event->i_table_id);
+}
+
+static void dvbpsi_tr101290_gather(dvbpsi_t *p_dvbpsi, dvbpsi_psi_section_t *p_section);
+
+/*****************************************************************************
+ * dvbpsi_tr101290_attach / dvbpsi_tr101290_detach
+ *****************************************************************************
+ * Creates and deletes the handle assembling the sections of a PID.
+ *****************************************************************************/
+static bool dvbpsi_tr101290_attach(dvbpsi_tr101290_t *p_tr, uint16_t i_pid)
+{
+    dvbpsi_t *p_dvbpsi = dvbpsi_new(NULL, DVBPSI_MSG_NONE);
+    if (p_dvbpsi == NULL)
+        return false;
+
+    dvbpsi_tr101290_decoder_t *p_decoder;
+    p_decoder = (dvbpsi_tr101290_decoder_t *)dvbpsi_decoder_new(&dvbpsi_tr101290_gather,
+                                            4096, true, sizeof(dvbpsi_tr101290_decoder_t));
+    if (p_decoder == NULL)
+    {
+        dvbpsi_delete(p_dvbpsi);
+        return false;
+    }
+    p_decoder->p_tr = p_tr;
+    p_decoder->i_pid = i_pid;
+
+    p_dvbpsi->p_decoder = DVBPSI_DECODER(p_decoder);
+    dvbpsi_set_packet_format(p_dvbpsi, p_tr->i_format);
+    dvbpsi_set_event_cb(p_dvbpsi, dvbpsi_tr101290_event, p_tr);
+
+    p_tr->pp_handles[i_pid] = p_dvbpsi;
+    p_tr->pi_kind[i_pid] |= DVBPSI_TR101290_KIND_HANDLE;
+    return true;
+}
+
+static void dvbpsi_tr101290_detach(dvbpsi_tr101290_t *p_tr, uint16_t i_pid)
+{
+    dvbpsi_t *p_dvbpsi = p_tr->pp_handles[i_pid];
+
+    dvbpsi_decoder_delete(p_dvbpsi->p_decoder);
+    p_dvbpsi->p_decoder = NULL;
+    dvbpsi_delete(p_dvbpsi);
+
+    p_tr->pp_handles[i_pid] = NULL;
+    p_tr->pi_kind[i_pid] &= ~DVBPSI_TR101290_KIND_HANDLE;
+}
+
+/*****************************************************************************
+ * dvbpsi_tr101290_update
+ *****************************************************************************
+ * Sets again the kind of the PIDs from the programs, creating or deleting
+ * the handles of the PMT PIDs. A PID newly referred to is timed from now.
+ *****************************************************************************/
+static void dvbpsi_tr101290_update(dvbpsi_tr101290_t *p_tr)
+{
+    uint8_t i_mask = DVBPSI_TR101290_KIND_PMT | DVBPSI_TR101290_KIND_ES
+                   | DVBPSI_TR101290_KIND_PCR;
+    uint8_t pi_old[DVBPSI_TR101290_PIDS];
+
+    for (unsigned int i = 0; i < DVBPSI_TR101290_PIDS; i++)
+    {
+        pi_old[i] = p_tr->pi_kind[i];
+        p_tr->pi_kind[i] &= ~i_mask;
+    }
+
+    for (size_t i = 0; i < p_tr->i_programs; i++)
+    {
+        const dvbpsi_tr101290_program_t *p_program = &p_tr->p_programs[i];
+        p_tr->pi_kind[p_program->i_pmt_pid] |= DVBPSI_TR101290_KIND_PMT;
+        if (p_program->b_pmt && p_program->i_pcr_pid != DVBPSI_TR101290_NULL)
+            p_tr->pi_kind[p_program->i_pcr_pid] |= DVBPSI_TR101290_KIND_PCR;
+        for (size_t j = 0; j < p_program->i_es; j++)
+            p_tr->pi_kind[p_program->pi_es[j]] |= DVBPSI_TR101290_KIND_ES;
+    }
+
+    for (unsigned int i = 0; i < DVBPSI_TR101290_PIDS; i++)
+    {
+        uint8_t i_kind = p_tr->pi_kind[i];
+        uint8_t i_new = i_kind & ~pi_old[i];
+
+        if (i_new & DVBPSI_TR101290_KIND_ES)
+        {
+            p_tr->pi_seen[i] = p_tr->i_now;
+            i_kind &= ~DVBPSI_TR101290_KIND_ES_LATE;
+        }
+        if (i_new & DVBPSI_TR101290_KIND_PCR)
+        {
+            p_tr->pi_pcr_time[i] = p_tr->i_now;
+            i_kind &= ~DVBPSI_TR101290_KIND_PCR_LATE;
+        }
+        p_tr->pi_kind[i] = i_kind;
+
+        if ((i_kind & DVBPSI_TR101290_KIND_PMT) && !(i_kind & DVBPSI_TR101290_KIND_HANDLE))
+        {
+            if (!dvbpsi_tr101290_attach(p_tr, (uint16_t)i))
+                p_tr->b_error = true;
+        }
+        else if ((i_kind & DVBPSI_TR101290_KIND_HANDLE)
+                 && !(i_kind & (DVBPSI_TR101290_KIND_PMT | DVBPSI_TR101290_KIND_FIXED)))
+            dvbpsi_tr101290_detach(p_tr, (uint16_t)i);
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_tr101290_pat
+ *****************************************************************************
+ * Reads the programs of a PAT section. The first section marks all the
+ * programs stale and the last one removes those it left so.
+ *****************************************************************************/
+static void dvbpsi_tr101290_pat(dvbpsi_tr101290_t *p_tr, const dvbpsi_psi_section_t *p_section)
+{
+    if (!p_section->b_current_next)
+        return;
+
+    if (p_section->i_number == 0)
+        for (size_t i = 0; i < p_tr->i_programs; i++)
+            p_tr->p_programs[i].b_stale = true;
+
+    for (const uint8_t *p = p_section->p_payload_start; p + 4 <= p_section->p_payload_end; p += 4)
+    {
+        uint16_t i_number = ((uint16_t)p[0] << 8) | p[1];
+        uint16_t i_pid = ((uint16_t)(p[2] & 0x1f) << 8) | p[3];
+        if (i_number == 0)
+            continue;
+
+        size_t i = 0;
+        while (i < p_tr->i_programs && p_tr->p_programs[i].i_number != i_number)
+            i++;
+        if (i == p_tr->i_programs)
+        {
+            if (p_tr->i_programs == p_tr->i_programs_size)
+            {
+                size_t i_size = p_tr->i_programs_size ? 2 * p_tr->i_programs_size : 8;
+                dvbpsi_tr101290_program_t *p_programs;
+                p_programs = dvbpsi_malloc(i_size * sizeof(dvbpsi_tr101290_program_t));
+                if (p_programs == NULL)
+                {
+                    p_tr->b_error = true;
+                    continue;
+                }
+                if (p_tr->i_programs)
+                    memcpy(p_programs, p_tr->p_programs,
+                           p_tr->i_programs * sizeof(dvbpsi_tr101290_program_t));
+                dvbpsi_free(p_tr->p_programs);
+                p_tr->p_programs = p_programs;
+                p_tr->i_programs_size = i_size;
+            }
+            memset(&p_tr->p_programs[i], 0, sizeof(dvbpsi_tr101290_program_t));
+            p_tr->p_programs[i].i_number = i_number;
+            p_tr->p_programs[i].i_pmt_pid = i_pid;
+            p_tr->p_programs[i].i_pcr_pid = DVBPSI_TR101290_NULL;
+            p_tr->p_programs[i].pmt.i_last = p_tr->i_now;
+            p_tr->i_programs++;
+            p_tr->b_changed = true;
+        }
+        else if (p_tr->p_programs[i].i_pmt_pid != i_pid)
+        {
+            /* Moved, its previous PMT does not apply */
+            dvbpsi_tr101290_program_t *p_program = &p_tr->p_programs[i];
+            p_program->i_pmt_pid = i_pid;
+            p_program->i_pcr_pid = DVBPSI_TR101290_NULL;
+            p_program->b_pmt = false;
+            p_program->i_crc = 0;
+            p_program->i_es = 0;
+            p_program->pmt.i_last = p_tr->i_now;
+            p_program->pmt.b_late = false;
+            p_tr->b_changed = true;
+        }
+        p_tr->p_programs[i].b_stale = false;
+    }
+
+    if (p_section->i_number != p_section->i_last_number)
+        return;
+
+    size_t j = 0;
+    for (size_t i = 0; i < p_tr->i_programs; i++)
+    {
+        if (p_tr->p_programs[i].b_stale)
+        {
+            dvbpsi_free(p_tr->p_programs[i].pi_es);
+            p_tr->b_changed = true;
+        }
+        else
+            p_tr->p_programs[j++] = p_tr->p_programs[i];
+    }
+    p_tr->i_programs = j;
+
+    if (p_tr->b_changed)
+    {
+        p_tr->b_changed = false;
+        dvbpsi_tr101290_update(p_tr);
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_tr101290_pmt
+ *****************************************************************************
+ * Times a PMT section and reads its PIDs when it changed.
+ *****************************************************************************/
+static void dvbpsi_tr101290_pmt(dvbpsi_tr101290_t *p_tr, uint16_t i_pid,
+                                const dvbpsi_psi_section_t *p_section)
+{
+    dvbpsi_tr101290_program_t *p_program = NULL;
+    for (size_t i = 0; i < p_tr->i_programs; i++)
+        if (p_tr->p_programs[i].i_number == p_section->i_extension
+            && p_tr->p_programs[i].i_pmt_pid == i_pid)
+            p_program = &p_tr->p_programs[i];
+    if (p_program == NULL)
+        return;
+
+    dvbpsi_tr101290_hit(p_tr, &p_program->pmt, DVBPSI_TR101290_PSI_MAX,
+                        DVBPSI_TR101290_PMT, i_pid, 0x02);
+
+    const uint8_t *p = p_section->p_payload_start;
+    const uint8_t *p_end = p_section->p_payload_end;
+    if (!p_section->b_current_next || p_end - p < 4)
+        return;
+
+    const uint8_t *p_crc = p_section->p_payload_end;
+    uint32_t i_crc = ((uint32_t)p_crc[0] << 24) | ((uint32_t)p_crc[1] << 16)
+                   | ((uint32_t)p_crc[2] << 8) | p_crc[3];
+    if (p_program->b_pmt && p_program->i_crc == i_crc)
+        return;
+
+    /* At most one ES per 5 bytes */
+    size_t i_max = (size_t)(p_end - p) / 5;
+    uint16_t *pi_es = i_max ? dvbpsi_malloc(i_max * sizeof(uint16_t)) : NULL;
+    if (i_max && pi_es == NULL)
+    {
+        p_tr->b_error = true;
+        return;
+    }
+
+    uint16_t i_pcr_pid = ((uint16_t)(p[0] & 0x1f) << 8) | p[1];
+    p += 4 + ((((uint16_t)p[2] & 0x0f) << 8) | p[3]);
+    size_t i_es = 0;
+    while (p + 5 <= p_end)
+    {
+        pi_es[i_es++] = ((uint16_t)(p[1] & 0x1f) << 8) | p[2];
+        p += 5 + ((((uint16_t)p[3] & 0x0f) << 8) | p[4]);
+    }
+
+    dvbpsi_free(p_program->pi_es);
+    p_program->pi_es = pi_es;
+    p_program->i_es = i_es;
+    p_program->i_pcr_pid = i_pcr_pid;
+    p_program->i_crc = i_crc;
+    p_program->b_pmt = true;
+    dvbpsi_tr101290_update(p_tr);
+}
+
+/*****************************************************************************
+ * dvbpsi_tr101290_section
+ *****************************************************************************
+ * Checks a section with a valid CRC_32, or without any.
+ *****************************************************************************/
+static void dvbpsi_tr101290_section(dvbpsi_tr101290_t *p_tr, uint16_t i_pid,
+                                    const dvbpsi_psi_section_t *p_section)
+{
+    uint8_t i_table_id = p_section->i_table_id;
+    uint8_t i_kind = p_tr->pi_kind[i_pid];
+
+    if (i_pid == 0x00)
+    {
+        if (i_table_id != 0x00)
+            dvbpsi_tr101290_error(p_tr, DVBPSI_TR101290_PAT, i_pid, i_table_id);
+        else
+        {
+            dvbpsi_tr101290_hit(p_tr, &p_tr->pat, DVBPSI_TR101290_PSI_MAX,
+                                DVBPSI_TR101290_PAT, i_pid, i_table_id);
+            dvbpsi_tr101290_pat(p_tr, p_section);
+        }
+        return;
+    }
+
+    if (i_pid == 0x01)
+    {
+        if (i_table_id != 0x01)
+            dvbpsi_tr101290_error(p_tr, DVBPSI_TR101290_CAT, i_pid, i_table_id);
+        else
+            p_tr->b_cat = true;
+        return;
+    }
+
+    if ((i_kind & DVBPSI_TR101290_KIND_PMT) && i_table_id == 0x02)
+    {
+        dvbpsi_tr101290_pmt(p_tr, i_pid, p_section);
+        return;
+    }
+
+    for (size_t i = 0; i < DVBPSI_TR101290_SI; i++)
+    {
+        dvbpsi_tr101290_si_t *p_si = &p_tr->si[i];
+        if (p_si->i_pid != i_pid || p_si->i_table_id != i_table_id)
+            continue;
+
+        /* The same section again too soon */
+        uint32_t i_section = ((uint32_t)p_section->i_extension << 8) | p_section->i_number;
+        if (p_tr->i_now != DVBPSI_TIME_NONE && p_si->timer.i_last != DVBPSI_TIME_NONE
+            && p_si->i_section == i_section
+            && p_tr->i_now - p_si->timer.i_last < DVBPSI_TR101290_SI_MIN)
+            dvbpsi_tr101290_error(p_tr, DVBPSI_TR101290_SI_REPETITION, i_pid, i_table_id);
+        p_si->i_section = i_section;
+
+        dvbpsi_tr101290_hit(p_tr, &p_si->timer, p_si->i_max,
+                            DVBPSI_TR101290_SI_REPETITION, i_pid, i_table_id);
+    }
+}
+
+/*****************************************************************************
+ * dvbpsi_tr101290_gather
+ *****************************************************************************
+ * Gather callback of the handles.
+ *****************************************************************************/
+static void dvbpsi_tr101290_gather(dvbpsi_t *p_dvbpsi, dvbpsi_psi_section_t *p_section)
+{
+    dvbpsi_tr101290_decoder_t *p_decoder = (dvbpsi_tr101290_decoder_t *)p_dvbpsi->p_decoder;
+
+    for (const dvbpsi_psi_section_t *p = p_section; p; p = p->p_next)
+        dvbpsi_tr101290_section(p_decoder->p_tr, p_decoder->i_pid, p);
+    dvbpsi_DeletePSISections(p_section);
+}
+
+/*****************************************************************************
+ * dvbpsi_tr101290_pcr
+ *****************************************************************************
+ * Checks the PCR of a packet and times the packets with the reference PID.
+ *****************************************************************************/
+static void dvbpsi_tr101290_pcr(dvbpsi_tr101290_t *p_tr, uint16_t i_pid,
+                                const uint8_t *p_packet, bool b_discontinuity)
+{
+    int64_t i_pcr = (((int64_t)p_packet[6] << 25) | ((int64_t)p_packet[7] << 17)
+                   | ((int64_t)p_packet[8] << 9) | ((int64_t)p_packet[9] << 1)
+                   | (p_packet[10] >> 7)) * 300
+                  + ((((int64_t)p_packet[10] & 0x01) << 8) | p_packet[11]);
+
+    /* Progress since the previous PCR of the PID, if it is plausible */
+    int64_t i_delta = 0;
+    uint64_t i_packets = p_tr->i_packet - p_tr->pi_pcr_packet[i_pid];
+    bool b_valid = false;
+    if (p_tr->pi_pcr[i_pid] >= 0 && !b_discontinuity)
+    {
+        i_delta = (i_pcr - p_tr->pi_pcr[i_pid] + DVBPSI_TR101290_WRAP) % DVBPSI_TR101290_WRAP;
+        if (i_delta > DVBPSI_TR101290_WRAP / 2)
+            i_delta -= DVBPSI_TR101290_WRAP;
+        b_valid = i_delta > 0 && i_delta <= DVBPSI_TR101290_PCR_JUMP;
+        if (!b_valid)
+            dvbpsi_tr101290_error(p_tr, DVBPSI_TR101290_PCR_DISCONTINUITY, i_pid, 0);
+    }
+
+    bool b_accurate = true;
+    if (b_valid && p_tr->f_rate > 0)
+    {
+        double f_error = (double)i_delta - (double)i_packets * p_tr->f_rate;
+        b_accurate = f_error * 2 <= DVBPSI_TR101290_PCR_TOLERANCE
+                  && f_error * 2 >= -DVBPSI_TR101290_PCR_TOLERANCE;
+        if (!b_accurate)
+            dvbpsi_tr101290_error(p_tr, DVBPSI_TR101290_PCR_ACCURACY, i_pid, 0);
+    }
+
+    /* The reference PID moves to another one once it stopped carrying PCRs */
+    if (p_tr->i_ref_pid != i_pid
+        && (p_tr->i_ref_pid == DVBPSI_EVENT_NO_PID
+            || !(p_tr->pi_pcr_time[p_tr->i_ref_pid] != DVBPSI_TIME_NONE
+                 && p_tr->i_now != DVBPSI_TIME_NONE
+                 && p_tr->i_now - p_tr->pi_pcr_time[p_tr->i_ref_pid] <= DVBPSI_TR101290_PCR_JUMP)))
+    {
+        if (p_tr->i_ref_pid == DVBPSI_EVENT_NO_PID)
+            p_tr->i_ref_time = i_pcr;
+        else if (p_tr->i_arrival == DVBPSI_TIME_NONE)
+            p_tr->i_ref_time = p_tr->i_now;
+        p_tr->i_ref_pid = i_pid;
+        p_tr->i_ref_packet = p_tr->i_packet;
+        p_tr->i_window_ticks = 0;
+        p_tr->i_window_packets = 0;
+        if (p_tr->i_arrival == DVBPSI_TIME_NONE)
+            p_tr->i_now = p_tr->i_ref_time;
+    }
+    else if (p_tr->i_ref_pid == i_pid)
+    {
+        if (b_valid)
+            p_tr->i_ref_time += i_delta;
+
+        /* An inaccurate PCR would bias the rate */
+        if (b_valid && b_accurate)
+        {
+            p_tr->i_window_ticks += i_delta;
+            p_tr->i_window_packets += i_packets;
+            if (p_tr->i_window_ticks >= DVBPSI_TR101290_RATE_MIN)
+                p_tr->f_rate = (double)p_tr->i_window_ticks / (double)p_tr->i_window_packets;
+            if (p_tr->i_window_ticks >= DVBPSI_TR101290_RATE_MAX)
+            {
+                p_tr->i_window_ticks = 0;
+                p_tr->i_window_packets = 0;
+            }
+        }
+        else if (!b_valid)
+        {
+            /* Carries on from the packets timed with the rate */
+            if (p_tr->i_now != DVBPSI_TIME_NONE)
+                p_tr->i_ref_time = p_tr->i_now;
+            p_tr->i_window_ticks = 0;
+            p_tr->i_window_packets = 0;
+        }
+        p_tr->i_ref_packet = p_tr->i_packet;
+        if (p_tr->i_arrival == DVBPSI_TIME_NONE)
+            p_tr->i_now = p_tr->i_ref_time;
+    }
+
+    /* Repetition */
+    uint8_t i_kind = p_tr->pi_kind[i_pid];
+    if (p_tr->i_now != DVBPSI_TIME_NONE)
+    {
+        if (p_tr->pi_pcr_time[i_pid] != DVBPSI_TIME_NONE && !b_discontinuity
+            && !(i_kind & DVBPSI_TR101290_KIND_PCR_LATE)
+            && p_tr->i_now - p_tr->pi_pcr_time[i_pid] > DVBPSI_TR101290_PCR_MAX)
+            dvbpsi_tr101290_error(p_tr, DVBPSI_TR101290_PCR_REPETITION, i_pid, 0);
+        p_tr->pi_pcr_time[i_pid] = p_tr->i_now;
+    }
+    p_tr->pi_kind[i_pid] = i_kind & ~DVBPSI_TR101290_KIND_PCR_LATE;
+
+    p_tr->pi_pcr[i_pid] = i_pcr;
+    p_tr->pi_pcr_packet[i_pid] = p_tr->i_packet;
+}
+
+/*****************************************************************************
+ * dvbpsi_tr101290_time
+ *****************************************************************************
+ * Time of the current packet.
+ *****************************************************************************/
+static inline int64_t dvbpsi_tr101290_time(const dvbpsi_tr101290_t *p_tr)
+{
+    if (p_tr->i_arrival != DVBPSI_TIME_NONE)
+        return p_tr->i_arrival;
+    if (p_tr->i_ref_pid == DVBPSI_EVENT_NO_PID)
+        return DVBPSI_TIME_NONE;
+    return p_tr->i_ref_time
+         + (int64_t)((double)(p_tr->i_packet - p_tr->i_ref_packet) * p_tr->f_rate);
+}
+
+/*****************************************************************************
+ * dvbpsi_tr101290_block
+ *****************************************************************************
+ * Measures a block of packets scanned by dvbpsi_packets_scan().
+ *****************************************************************************/
+static void dvbpsi_tr101290_block(dvbpsi_tr101290_t *p_tr, uint8_t *p_data,
+                                  const dvbpsi_ts_headers_t *p_headers)
+{
+    for (unsigned int i = 0; i < p_headers->i_count; i++, p_tr->i_packet++)
+    {
+        uint16_t i_pid = p_headers->pi_pid[i];
+        uint8_t i_flags = p_headers->pi_flags[i];
+        uint8_t *p_packet = p_data + i * p_tr->i_stride + p_tr->i_offset;
+
+        p_tr->pi_packets[i_pid]++;
+        if (i_flags & DVBPSI_TS_TEI)
+        {
+            dvbpsi_tr101290_error(p_tr, DVBPSI_TR101290_TRANSPORT, i_pid, 0);
+            continue;
+        }
+        if (i_pid == DVBPSI_TR101290_NULL)
+            continue;
+
+        uint8_t i_kind = p_tr->pi_kind[i_pid];
+        if (i_kind || (i_flags & DVBPSI_TS_ADAPTATION))
+            p_tr->i_now = dvbpsi_tr101290_time(p_tr);
+
+        /* Adaptation field */
+        bool b_discontinuity = false;
+        if ((i_flags & DVBPSI_TS_ADAPTATION) && p_packet[4] > 0)
+        {
+            b_discontinuity = p_packet[5] & 0x80;
+            if ((p_packet[5] & 0x10) && p_packet[4] >= 7)
+            {
+                dvbpsi_tr101290_pcr(p_tr, i_pid, p_packet, b_discontinuity);
+                i_kind = p_tr->pi_kind[i_pid];
+            }
+        }
+
+        /* Continuity, a packet may be sent twice */
+        uint8_t i_cc = p_headers->pi_cc[i];
+        uint8_t i_last = p_tr->pi_cc[i_pid];
+        if (b_discontinuity || i_last == DVBPSI_TR101290_NO_CC)
+        {
+            p_tr->pi_cc[i_pid] = i_cc;
+            p_tr->pi_duplicates[i_pid] = 0;
+        }
+        else if (i_flags & DVBPSI_TS_PAYLOAD)
+        {
+            if (i_cc == i_last)
+            {
+                if (++p_tr->pi_duplicates[i_pid] > 1)
+                    dvbpsi_tr101290_error(p_tr, DVBPSI_TR101290_CC, i_pid, 0);
+            }
+            else
+            {
+                if (i_cc != ((i_last + 1) & 0x0f))
+                    dvbpsi_tr101290_error(p_tr, DVBPSI_TR101290_CC, i_pid, 0);
+                p_tr->pi_cc[i_pid] = i_cc;
+                p_tr->pi_duplicates[i_pid] = 0;
+            }
+        }
+
+        if (DVBPSI_TS_SCRAMBLING(i_flags))
+        {
+            p_tr->b_scrambled = true;
+            if (i_pid == 0x00)
+            {
+                dvbpsi_tr101290_error(p_tr, DVBPSI_TR101290_PAT, i_pid, 0);
+                continue;
+            }
+            if (i_kind & DVBPSI_TR101290_KIND_PMT)
+            {
+                dvbpsi_tr101290_error(p_tr, DVBPSI_TR101290_PMT, i_pid, 0);
+                continue;
+            }
+        }
+
+        if (i_kind & DVBPSI_TR101290_KIND_ES)
+        {
+            p_tr->pi_seen[i_pid] = p_tr->i_now;
+            p_tr->pi_kind[i_pid] = i_kind & ~DVBPSI_TR101290_KIND_ES_LATE;
+        }
+        if (i_kind & DVBPSI_TR101290_KIND_HANDLE)
+            dvbpsi_packet_push(p_tr->pp_handles[i_pid], p_packet - p_tr->i_offset);
+    }
+
+    /* Scrambled packets need a CAT, reported once */
+    if (p_tr->b_scrambled && !p_tr->b_cat && !p_tr->b_cat_error)
+    {
+        p_tr->b_cat_error = true;
+        dvbpsi_tr101290_error(p_tr, DVBPSI_TR101290_CAT, 0x01, 0);
+    }
+
+    p_tr->i_now = dvbpsi_tr101290_time(p_tr);
+    dvbpsi_tr101290_check_all(p_tr);
+}
+
+/*****************************************************************************
+ * dvbpsi_tr101290_scan
+ *****************************************************************************
+ * Measures the whole packets of a buffer, returning the bytes used.
+ *****************************************************************************/
+static size_t dvbpsi_tr101290_scan(dvbpsi_tr101290_t *p_tr, uint8_t *p_data, size_t i_size)
+{
+    dvbpsi_ts_headers_t headers;
+    size_t i_pos = 0;
+
+    while (i_size - i_pos >= p_tr->i_stride)
+    {
+        if (p_data[i_pos + p_tr->i_offset] != 0x47)
+        {
+            if (p_tr->b_locked)
+            {
+                /* Corrupted sync byte, the next packet is expected after it */
+                dvbpsi_tr101290_error(p_tr, DVBPSI_TR101290_SYNC_BYTE,
+                                      DVBPSI_EVENT_NO_PID, 0);
+                if (++p_tr->i_bad < DVBPSI_TR101290_UNLOCK)
+                {
+                    i_pos += p_tr->i_stride;
+                    p_tr->i_packet++;
+                    continue;
+                }
+                p_tr->b_locked = false;
+                p_tr->i_good = 0;
+                dvbpsi_tr101290_error(p_tr, DVBPSI_TR101290_SYNC_LOSS,
+                                      DVBPSI_EVENT_NO_PID, 0);
+
+                /* The packets lost meanwhile are unknown */
+                for (unsigned int i = 0; i < DVBPSI_TR101290_PIDS; i++)
+                    p_tr->pi_pcr[i] = -1;
+            }
+            i_pos += dvbpsi_sync_find(p_data + i_pos, i_size - i_pos, p_tr->i_format);
+            continue;
+        }
+
+        i_pos += dvbpsi_packets_scan(p_data + i_pos, i_size - i_pos, p_tr->i_format,
+                                     &headers);
+        p_tr->i_bad = 0;
+        if (!p_tr->b_locked)
+        {
+            /* Nothing is measured until locked */
+            p_tr->i_good += headers.i_count;
+            p_tr->b_locked = p_tr->i_good >= DVBPSI_TR101290_LOCK;
+            if (!p_tr->b_locked)
+            {
+                p_tr->i_packet += headers.i_count;
+                continue;
+            }
+        }
+        dvbpsi_tr101290_block(p_tr, p_data + i_pos - headers.i_count * p_tr->i_stride,
+                              &headers);
+    }
+    return i_pos;
+}
+
+/*****************************************************************************
+ * dvbpsi_tr101290_new
+ *****************************************************************************/
+dvbpsi_tr101290_t *dvbpsi_tr101290_new(dvbpsi_packet_format_t i_format,
+                                       dvbpsi_tr101290_callback pf_callback,
+                                       void *p_cb_data)
+{
+    dvbpsi_tr101290_t *p_tr = dvbpsi_calloc(1, sizeof(dvbpsi_tr101290_t));
+    if (p_tr == NULL)
+        return NULL;
+
+    p_tr->pf_callback = pf_callback;
+    p_tr->p_cb_data = p_cb_data;
+    p_tr->i_format = i_format;
+    p_tr->i_stride = dvbpsi_get_packet_size(i_format);
+    p_tr->i_offset = (i_format == DVBPSI_PACKET_M2TS) ? 4 : 0;
+    p_tr->i_pid_timeout = DVBPSI_TR101290_MS(5000);
+
+    p_tr->i_now = DVBPSI_TIME_NONE;
+    p_tr->i_arrival = DVBPSI_TIME_NONE;
+    p_tr->i_ref_pid = DVBPSI_EVENT_NO_PID;
+    p_tr->pat.i_last = DVBPSI_TIME_NONE;
+    memcpy(p_tr->si, si_tables, sizeof(si_tables));
+    for (size_t i = 0; i < DVBPSI_TR101290_SI; i++)
+        p_tr->si[i].timer.i_last = DVBPSI_TIME_NONE;
+
+    memset(p_tr->pi_cc, DVBPSI_TR101290_NO_CC, sizeof(p_tr->pi_cc));
+    for (unsigned int i = 0; i < DVBPSI_TR101290_PIDS; i++)
+    {
+        p_tr->pi_seen[i] = DVBPSI_TIME_NONE;
+        p_tr->pi_pcr[i] = -1;
+        p_tr->pi_pcr_time[i] = DVBPSI_TIME_NONE;
+    }
+
+    for (size_t i = 0; i < sizeof(fixed_pids) / sizeof(fixed_pids[0]); i++)
+    {
+        p_tr->pi_kind[fixed_pids[i]] |= DVBPSI_TR101290_KIND_FIXED;
+        if (!dvbpsi_tr101290_attach(p_tr, fixed_pids[i]))
+        {
+            dvbpsi_tr101290_delete(p_tr);
+            return NULL;
+        }
+    }
+    return p_tr;
+}
+
+/*****************************************************************************
+ * dvbpsi_tr101290_delete
+ *****************************************************************************/
+void dvbpsi_tr101290_delete(dvbpsi_tr101290_t *p_tr)
+{
+    if (p_tr == NULL)
+        return;
+
+    for (unsigned int i = 0; i < DVBPSI_TR101290_PIDS; i++)
+        if (p_tr->pp_handles[i])
+            dvbpsi_tr101290_detach(p_tr, (uint16_t)i);
+    for (size_t i = 0; i < p_tr->i_programs; i++)
+        dvbpsi_free(p_tr->p_programs[i].pi_es);
+    dvbpsi_free(p_tr->p_programs);
+    dvbpsi_free(p_tr);
+}
+
+/*****************************************************************************
+ * dvbpsi_tr101290_set_pid_timeout
+ *****************************************************************************/
+void dvbpsi_tr101290_set_pid_timeout(dvbpsi_tr101290_t *p_tr, unsigned int i_ms)
+{
+    assert(p_tr);
+    p_tr->i_pid_timeout = DVBPSI_TR101290_MS(i_ms);
+}
+
+/*****************************************************************************
+ * dvbpsi_tr101290_push
+ *****************************************************************************/
+bool dvbpsi_tr101290_push(dvbpsi_tr101290_t *p_tr, uint8_t *p_data,
+                          size_t i_size, int64_t i_time)
+{
+    assert(p_tr);
+    assert(p_data || i_size == 0);
+
+    p_tr->b_error = false;
+    p_tr->i_arrival = (i_time == DVBPSI_TIME_NONE) ? DVBPSI_TIME_NONE : i_time * 27;
+    if (p_tr->i_arrival != DVBPSI_TIME_NONE)
+        p_tr->i_now = p_tr->i_arrival;
+
+    /* Packet started by the previous buffer */
+    if (p_tr->i_carry)
+    {
+        size_t i_missing = p_tr->i_stride - p_tr->i_carry;
+        if (i_size < i_missing)
+        {
+            memcpy(p_tr->p_carry + p_tr->i_carry, p_data, i_size);
+            p_tr->i_carry += i_size;
+            return !p_tr->b_error;
+        }
+        memcpy(p_tr->p_carry + p_tr->i_carry, p_data, i_missing);
+        p_tr->i_carry = 0;
+        dvbpsi_tr101290_scan(p_tr, p_tr->p_carry, p_tr->i_stride);
+        p_data += i_missing;
+        i_size -= i_missing;
+    }
+
+    size_t i_used = dvbpsi_tr101290_scan(p_tr, p_data, i_size);
+    p_tr->i_carry = i_size - i_used;
+    memcpy(p_tr->p_carry, p_data + i_used, p_tr->i_carry);
+    return !p_tr->b_error;
+}
+
+/*****************************************************************************
+ * dvbpsi_tr101290_get_count
+ *****************************************************************************/
+uint64_t dvbpsi_tr101290_get_count(const dvbpsi_tr101290_t *p_tr,
+                                   dvbpsi_tr101290_error_t i_type)
+{
+    assert(p_tr);
+    assert(i_type < DVBPSI_TR101290_MAX);
+    return p_tr->pi_counts[i_type];
+}
+
+/*****************************************************************************
+ * dvbpsi_tr101290_get_pid
+ *****************************************************************************/
+void dvbpsi_tr101290_get_pid(const dvbpsi_tr101290_t *p_tr, uint16_t i_pid,
+                             dvbpsi_tr101290_pid_t *p_counters)
+{
+    assert(p_tr);
+    assert(i_pid < DVBPSI_TR101290_PIDS);
+    assert(p_counters);
+
+    p_counters->i_packets = p_tr->pi_packets[i_pid];
+    p_counters->i_cc_errors = p_tr->pi_cc_errors[i_pid];
+    p_counters->i_transport_errors = p_tr->pi_transport_errors[i_pid];
+    p_counters->i_pid_errors = p_tr->pi_pid_errors[i_pid];
+    p_counters->i_pcr_errors = p_tr->pi_pcr_errors[i_pid];
+    p_counters->i_table_errors = p_tr->pi_table_errors[i_pid];
+}
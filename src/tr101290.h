@@ -0,0 +1,269 @@
+/*****************************************************************************
+ * tr101290.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <tr101290.h>
+ * \brief ETSI TR 101 290 measurements.
+ *
+ * Measures the first, second and third priority indicators of ETSI
+ * TR 101 290 section 5.2 over a whole transport stream: synchronization,
+ * continuity counters, transport errors, scrambling and repetition of the
+ * PAT and PMTs, PIDs referred to by the PMTs that disappear, repetition,
+ * discontinuity and accuracy of the PCRs, CRC_32 of the PSI and SI
+ * sections and repetition of the actual NIT, SDT, EIT present/following
+ * and of the TDT.
+ *
+ * The engine works on the headers extracted by dvbpsi_packets_scan(), and
+ * only reads the adaptation field of the packets that have one and the
+ * sections of the PSI and SI PIDs, which it assembles with its own
+ * handles. The counters of each PID are kept in one array per counter.
+ */
+
+#ifndef _DVBPSI_TR101290_H_
+#define _DVBPSI_TR101290_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_tr101290_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_tr101290_s dvbpsi_tr101290_t
+ * \brief dvbpsi_tr101290_t type definition, an opaque measurement engine.
+ */
+typedef struct dvbpsi_tr101290_s dvbpsi_tr101290_t;
+
+/*****************************************************************************
+ * dvbpsi_tr101290_error_t
+ *****************************************************************************/
+/*!
+ * \enum dvbpsi_tr101290_error
+ * \brief Indicators of ETSI TR 101 290, with their section number
+ */
+enum dvbpsi_tr101290_error
+{
+    DVBPSI_TR101290_SYNC_LOSS = 0,      /*!< 1.1 TS_sync_loss, two packets
+                                             in a row without a sync byte,
+                                             five being needed to lock again */
+    DVBPSI_TR101290_SYNC_BYTE,          /*!< 1.2 Sync_byte_error */
+    DVBPSI_TR101290_PAT,                /*!< 1.3 PAT_error, PAT missing for
+                                             0.5 s, another table_id on PID 0
+                                             or PID 0 scrambled */
+    DVBPSI_TR101290_CC,                 /*!< 1.4 Continuity_count_error */
+    DVBPSI_TR101290_PMT,                /*!< 1.5 PMT_error, PMT of a program
+                                             missing for 0.5 s or PMT PID
+                                             scrambled */
+    DVBPSI_TR101290_PID,                /*!< 1.6 PID_error, PID referred to
+                                             by a PMT missing, see
+                                             dvbpsi_tr101290_set_pid_timeout() */
+    DVBPSI_TR101290_TRANSPORT,          /*!< 2.1 Transport_error */
+    DVBPSI_TR101290_CRC,                /*!< 2.2 CRC_error */
+    DVBPSI_TR101290_PCR_REPETITION,     /*!< 2.3a PCR_repetition_error, more
+                                             than 40 ms between two PCRs */
+    DVBPSI_TR101290_PCR_DISCONTINUITY,  /*!< 2.3b PCR_discontinuity_indicator_error,
+                                             PCR moving back or by more than
+                                             100 ms without discontinuity_indicator */
+    DVBPSI_TR101290_PCR_ACCURACY,       /*!< 2.4 PCR_accuracy_error, more
+                                             than 500 ns of the transport rate */
+    DVBPSI_TR101290_CAT,                /*!< 2.6 CAT_error, scrambled packets
+                                             without a CAT or another table_id
+                                             on PID 1 */
+    DVBPSI_TR101290_SI_REPETITION,      /*!< 3.2 SI_repetition_error */
+
+    DVBPSI_TR101290_MAX                 /*!< Number of indicators */
+};
+/*!
+ * \typedef enum dvbpsi_tr101290_error dvbpsi_tr101290_error_t
+ * \brief dvbpsi_tr101290_error_t type definition.
+ */
+typedef enum dvbpsi_tr101290_error dvbpsi_tr101290_error_t;
+
+/*****************************************************************************
+ * dvbpsi_tr101290_event_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_tr101290_event_s
+ * \brief Error reported by a measurement engine, only valid during the
+ * callback.
+ */
+/*!
+ * \typedef struct dvbpsi_tr101290_event_s dvbpsi_tr101290_event_t
+ * \brief dvbpsi_tr101290_event_t type definition.
+ */
+typedef struct dvbpsi_tr101290_event_s
+{
+    dvbpsi_tr101290_error_t i_type;     /*!< indicator */
+    uint16_t                i_pid;      /*!< PID or DVBPSI_EVENT_NO_PID */
+    uint8_t                 i_table_id; /*!< table_id of a section error,
+                                             0 otherwise */
+    int64_t                 i_time;     /*!< time in microseconds, see
+                                             dvbpsi_tr101290_push(), or
+                                             DVBPSI_TIME_NONE */
+    uint64_t                i_packet;   /*!< index of the packet in the
+                                             stream */
+    uint64_t                i_count;    /*!< errors of this indicator so far,
+                                             this one included */
+} dvbpsi_tr101290_event_t;
+
+/*****************************************************************************
+ * dvbpsi_tr101290_callback
+ *****************************************************************************/
+/*!
+ * \typedef void (* dvbpsi_tr101290_callback)(void *p_cb_data,
+ *                                  const dvbpsi_tr101290_event_t *p_event)
+ * \brief Callback type definition, called for each error.
+ */
+typedef void (* dvbpsi_tr101290_callback)(void *p_cb_data,
+                                          const dvbpsi_tr101290_event_t *p_event);
+
+/*****************************************************************************
+ * dvbpsi_tr101290_pid_t
+ *****************************************************************************/
+/*!
+ * \struct dvbpsi_tr101290_pid_s
+ * \brief Counters of a PID, see dvbpsi_tr101290_get_pid()
+ */
+/*!
+ * \typedef struct dvbpsi_tr101290_pid_s dvbpsi_tr101290_pid_t
+ * \brief dvbpsi_tr101290_pid_t type definition.
+ */
+typedef struct dvbpsi_tr101290_pid_s
+{
+    uint64_t i_packets;             /*!< packets */
+    uint32_t i_cc_errors;           /*!< DVBPSI_TR101290_CC */
+    uint32_t i_transport_errors;    /*!< DVBPSI_TR101290_TRANSPORT */
+    uint32_t i_pid_errors;          /*!< DVBPSI_TR101290_PID */
+    uint32_t i_pcr_errors;          /*!< DVBPSI_TR101290_PCR_* */
+    uint32_t i_table_errors;        /*!< DVBPSI_TR101290_PAT, PMT, CRC, CAT
+                                         and SI_REPETITION */
+} dvbpsi_tr101290_pid_t;
+
+/*****************************************************************************
+ * dvbpsi_tr101290_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_tr101290_t *dvbpsi_tr101290_new(dvbpsi_packet_format_t i_format,
+ *                                            dvbpsi_tr101290_callback pf_callback,
+ *                                            void *p_cb_data)
+ * \brief Creates a measurement engine
+ * \param i_format framing of the packets
+ * \param pf_callback function called for each error, or NULL
+ * \param p_cb_data private data given in argument to the callback
+ * \return pointer to the engine, or NULL on error
+ */
+dvbpsi_tr101290_t *dvbpsi_tr101290_new(dvbpsi_packet_format_t i_format,
+                                       dvbpsi_tr101290_callback pf_callback,
+                                       void *p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_tr101290_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_tr101290_delete(dvbpsi_tr101290_t *p_tr)
+ * \brief Deletes a measurement engine
+ * \param p_tr pointer to the engine
+ * \return nothing
+ */
+void dvbpsi_tr101290_delete(dvbpsi_tr101290_t *p_tr);
+
+/*****************************************************************************
+ * dvbpsi_tr101290_set_pid_timeout
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_tr101290_set_pid_timeout(dvbpsi_tr101290_t *p_tr,
+ *                                          unsigned int i_ms)
+ * \brief Sets after how long a PID referred to by a PMT is missing
+ * \param p_tr pointer to the engine
+ * \param i_ms timeout in milliseconds, 5000 by default
+ * \return nothing
+ */
+void dvbpsi_tr101290_set_pid_timeout(dvbpsi_tr101290_t *p_tr, unsigned int i_ms);
+
+/*****************************************************************************
+ * dvbpsi_tr101290_push
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_tr101290_push(dvbpsi_tr101290_t *p_tr, uint8_t *p_data,
+ *                               size_t i_size, int64_t i_time)
+ * \brief Measures the next bytes of the stream
+ * \param p_tr pointer to the engine
+ * \param p_data buffer, which does not need to start or end on a packet
+ * \param i_size size of the buffer in bytes
+ * \param i_time arrival time of the buffer in microseconds, or
+ *        DVBPSI_TIME_NONE to time the packets with the PCRs of the stream
+ * \return false if the engine could not follow a PSI change for lack of
+ *         memory, true otherwise.
+ *
+ * The end of a buffer that is not a whole packet is kept for the next
+ * call. Without arrival times, the time of a packet is the PCR of the
+ * first PID carrying PCRs, extrapolated at the transport rate between two
+ * PCRs, and nothing that needs a time is measured before the first PCR.
+ * The PCR accuracy is always measured against the transport rate given by
+ * the PCRs, over windows of at least 100 ms. Missing tables and PIDs are
+ * detected every DVBPSI_SCAN_BLOCK packets.
+ *
+ * The SI tables are only checked once they have been seen, the absence of
+ * a NIT or SDT not being an error for every network. The minimum interval
+ * of 25 ms is checked between two copies of the same section in a row.
+ */
+bool dvbpsi_tr101290_push(dvbpsi_tr101290_t *p_tr, uint8_t *p_data,
+                          size_t i_size, int64_t i_time);
+
+/*****************************************************************************
+ * dvbpsi_tr101290_get_count
+ *****************************************************************************/
+/*!
+ * \fn uint64_t dvbpsi_tr101290_get_count(const dvbpsi_tr101290_t *p_tr,
+ *                                        dvbpsi_tr101290_error_t i_type)
+ * \brief Gets the number of errors of an indicator
+ * \param p_tr pointer to the engine
+ * \param i_type indicator
+ * \return the number of errors since the engine was created.
+ */
+uint64_t dvbpsi_tr101290_get_count(const dvbpsi_tr101290_t *p_tr,
+                                   dvbpsi_tr101290_error_t i_type);
+
+/*****************************************************************************
+ * dvbpsi_tr101290_get_pid
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_tr101290_get_pid(const dvbpsi_tr101290_t *p_tr,
+ *                                  uint16_t i_pid,
+ *                                  dvbpsi_tr101290_pid_t *p_counters)
+ * \brief Gets the counters of a PID
+ * \param p_tr pointer to the engine
+ * \param i_pid PID, 0 to 0x1fff
+ * \param p_counters filled with the counters
+ * \return nothing
+ */
+void dvbpsi_tr101290_get_pid(const dvbpsi_tr101290_t *p_tr, uint16_t i_pid,
+                             dvbpsi_tr101290_pid_t *p_counters);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of tr101290.h"
+#endif
@@ -0,0 +1,483 @@
+/*****************************************************************************
+ * zap.c: fast zapping
+ *----------------------------------------------------------------------------
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *----------------------------------------------------------------------------
+ *
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(HAVE_INTTYPES_H)
+#include <inttypes.h>
+#elif defined(HAVE_STDINT_H)
+#include <stdint.h>
+#endif
+
+#include <assert.h>
+
+
+#include "dvbpsi.h"
+#include "dvbpsi_private.h"
+#include "psi.h"
+#include "descriptor.h"
+#include "tables/pat.h"
+#include "tables/pmt.h"
+#include "zap.h"
+
+/* No PID */
+#define DVBPSI_ZAP_NO_PID 0xffff
+
+/*****************************************************************************
+ * dvbpsi_zap_program_t
+ *****************************************************************************
+ * Program of the last PAT.
+ *****************************************************************************/
+typedef struct dvbpsi_zap_program_s
+{
+    uint16_t                i_number;
+    uint16_t                i_pid;
+} dvbpsi_zap_program_t;
+
+struct dvbpsi_zap_s
+{
+    dvbpsi_message_cb       pf_message;
+    enum dvbpsi_msg_level   i_msg_level;
+    dvbpsi_pat_callback     pf_pat;
+    dvbpsi_pmt_callback     pf_pmt;
+    void *                  p_cb_data;
+
+    dvbpsi_t *              p_pat_handle;
+    dvbpsi_t *              p_pmt_handle;   /* NULL while the PMT PID is unknown */
+
+    /* Selected program */
+    bool                    b_started;
+    uint16_t                i_program_number;
+    uint16_t                i_pmt_pid;
+
+    /* Last PAT */
+    dvbpsi_zap_program_t *  p_programs;
+    size_t                  i_programs;
+
+    /* Packets buffered while the PMT PID is unknown */
+    uint8_t *               p_ring;         /* i_packets * 188 bytes */
+    int64_t *               pi_times;
+    size_t                  i_packets;
+    size_t                  i_first;
+    size_t                  i_count;
+    uint8_t                 pi_candidates[8192 / 8];
+
+    /* Time to PMT */
+    int64_t                 i_time;         /* of the packets being pushed */
+    bool                    b_first;        /* no packet pushed since the start */
+    int64_t                 i_start;
+    bool                    b_pmt;          /* PMT signalled since the start */
+    int64_t                 i_time_to_pmt;  /* DVBPSI_TIME_NONE if unknown */
+    bool                    b_latency;
+    uint64_t                pi_buckets[DVBPSI_LATENCY_BUCKETS];
+};
+
+/*****************************************************************************
+ * dvbpsi_zap_pmt
+ *****************************************************************************
+ * Records the time to PMT of the first PMT and gives it to the application.
+ *****************************************************************************/
+static void dvbpsi_zap_pmt(void *p_data, dvbpsi_pmt_t *p_pmt)
+{
+    dvbpsi_zap_t *p_zap = (dvbpsi_zap_t *)p_data;
+
+    if (!p_zap->b_pmt)
+    {
+        p_zap->b_pmt = true;
+        if (p_zap->i_start != DVBPSI_TIME_NONE && p_zap->i_time != DVBPSI_TIME_NONE)
+        {
+            p_zap->i_time_to_pmt = (p_zap->i_time > p_zap->i_start)
+                                 ? p_zap->i_time - p_zap->i_start : 0;
+            p_zap->pi_buckets[dvbpsi_latency_bucket((uint64_t)p_zap->i_time_to_pmt)]++;
+            p_zap->b_latency = true;
+        }
+    }
+
+    p_zap->pf_pmt(p_zap->p_cb_data, p_pmt);
+}
+
+/*****************************************************************************
+ * dvbpsi_zap_clear
+ *****************************************************************************
+ * Drops the buffered packets and the PMT decoder.
+ *****************************************************************************/
+static void dvbpsi_zap_clear(dvbpsi_zap_t *p_zap)
+{
+    if (p_zap->p_pmt_handle)
+    {
+        dvbpsi_pmt_detach(p_zap->p_pmt_handle);
+        dvbpsi_delete(p_zap->p_pmt_handle);
+        p_zap->p_pmt_handle = NULL;
+    }
+    p_zap->i_pmt_pid = DVBPSI_ZAP_NO_PID;
+    p_zap->i_first = 0;
+    p_zap->i_count = 0;
+    memset(p_zap->pi_candidates, 0, sizeof(p_zap->pi_candidates));
+}
+
+/*****************************************************************************
+ * dvbpsi_zap_set_pmt_pid
+ *****************************************************************************
+ * Attaches the PMT decoder to the PID of the program and replays the
+ * packets buffered on it.
+ *****************************************************************************/
+static void dvbpsi_zap_set_pmt_pid(dvbpsi_zap_t *p_zap, uint16_t i_pid)
+{
+    if (p_zap->p_pmt_handle && p_zap->i_pmt_pid == i_pid)
+        return;
+
+    /* The program moved */
+    if (p_zap->p_pmt_handle)
+        dvbpsi_zap_clear(p_zap);
+
+    dvbpsi_t *p_handle = dvbpsi_new(p_zap->pf_message, p_zap->i_msg_level);
+    if (p_handle == NULL)
+        return;
+    if (!dvbpsi_pmt_attach(p_handle, p_zap->i_program_number, dvbpsi_zap_pmt, p_zap))
+    {
+        dvbpsi_delete(p_handle);
+        return;
+    }
+    p_zap->p_pmt_handle = p_handle;
+    p_zap->i_pmt_pid = i_pid;
+
+    for (size_t i = 0; i < p_zap->i_count; i++)
+    {
+        size_t i_slot = (p_zap->i_first + i) % p_zap->i_packets;
+        uint8_t *p_packet = p_zap->p_ring + i_slot * 188;
+        if ((((uint16_t)(p_packet[1] & 0x1f) << 8) | p_packet[2]) == i_pid)
+            dvbpsi_packet_push_at(p_handle, p_packet, p_zap->pi_times[i_slot]);
+    }
+    p_zap->i_first = 0;
+    p_zap->i_count = 0;
+    memset(p_zap->pi_candidates, 0, sizeof(p_zap->pi_candidates));
+}
+
+/*****************************************************************************
+ * dvbpsi_zap_find
+ *****************************************************************************
+ * PID of a program of the last PAT, DVBPSI_ZAP_NO_PID if none.
+ *****************************************************************************/
+static uint16_t dvbpsi_zap_find(const dvbpsi_zap_t *p_zap, uint16_t i_number)
+{
+    for (size_t i = 0; i < p_zap->i_programs; i++)
+        if (p_zap->p_programs[i].i_number == i_number)
+            return p_zap->p_programs[i].i_pid;
+    return DVBPSI_ZAP_NO_PID;
+}
+
+/*****************************************************************************
+ * dvbpsi_zap_program
+ *****************************************************************************
+ * Program of a PAT section, before the whole table.
+ *****************************************************************************/
+static void dvbpsi_zap_program(void *p_data, uint16_t i_number, uint16_t i_pid)
+{
+    dvbpsi_zap_t *p_zap = (dvbpsi_zap_t *)p_data;
+
+    if (p_zap->b_started && i_number == p_zap->i_program_number)
+        dvbpsi_zap_set_pmt_pid(p_zap, i_pid);
+}
+
+/*****************************************************************************
+ * dvbpsi_zap_pat
+ *****************************************************************************
+ * Keeps the programs of a current PAT.
+ *****************************************************************************/
+static void dvbpsi_zap_pat(void *p_data, dvbpsi_pat_t *p_pat)
+{
+    dvbpsi_zap_t *p_zap = (dvbpsi_zap_t *)p_data;
+
+    if (p_pat->b_current_next)
+    {
+        size_t i_programs = 0;
+        for (dvbpsi_pat_program_t *p = p_pat->p_first_program; p; p = p->p_next)
+            i_programs++;
+
+        dvbpsi_zap_program_t *p_programs = NULL;
+        if (i_programs)
+            p_programs = dvbpsi_malloc(i_programs * sizeof(dvbpsi_zap_program_t));
+
+        /* Without memory, the previous PAT is kept */
+        if (p_programs || i_programs == 0)
+        {
+            size_t i = 0;
+            for (dvbpsi_pat_program_t *p = p_pat->p_first_program; p; p = p->p_next, i++)
+            {
+                p_programs[i].i_number = p->i_number;
+                p_programs[i].i_pid = p->i_pid;
+            }
+            dvbpsi_free(p_zap->p_programs);
+            p_zap->p_programs = p_programs;
+            p_zap->i_programs = i_programs;
+
+            if (p_zap->b_started)
+            {
+                uint16_t i_pid = dvbpsi_zap_find(p_zap, p_zap->i_program_number);
+                if (i_pid != DVBPSI_ZAP_NO_PID)
+                    dvbpsi_zap_set_pmt_pid(p_zap, i_pid);
+                else if (p_zap->p_pmt_handle)
+                    dvbpsi_zap_clear(p_zap);
+            }
+        }
+    }
+
+    if (p_zap->pf_pat)
+        p_zap->pf_pat(p_zap->p_cb_data, p_pat);
+    else
+        dvbpsi_pat_delete(p_pat);
+}
+
+/*****************************************************************************
+ * dvbpsi_zap_attach_pat
+ *****************************************************************************
+ * Attaches the PAT decoder.
+ *****************************************************************************/
+static bool dvbpsi_zap_attach_pat(dvbpsi_zap_t *p_zap)
+{
+    if (!dvbpsi_pat_attach(p_zap->p_pat_handle, dvbpsi_zap_pat, p_zap))
+        return false;
+    dvbpsi_pat_set_program_callback(p_zap->p_pat_handle, dvbpsi_zap_program, p_zap);
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_zap_is_candidate
+ *****************************************************************************
+ * Whether a packet starts a PMT section of the selected program.
+ *****************************************************************************/
+static bool dvbpsi_zap_is_candidate(const dvbpsi_zap_t *p_zap, const uint8_t *p_packet)
+{
+    /* payload_unit_start_indicator and payload */
+    if (!(p_packet[1] & 0x40) || !(p_packet[3] & 0x10))
+        return false;
+
+    size_t i_offset = 4;
+    if (p_packet[3] & 0x20)
+        i_offset += 1 + p_packet[4];
+    if (i_offset >= 188)
+        return false;
+
+    /* pointer_field, then table_id and program_number */
+    i_offset += 1 + p_packet[i_offset];
+    if (i_offset + 5 > 188)
+        return false;
+    return p_packet[i_offset] == 0x02
+        && (((uint16_t)p_packet[i_offset + 3] << 8) | p_packet[i_offset + 4])
+           == p_zap->i_program_number;
+}
+
+/*****************************************************************************
+ * dvbpsi_zap_new
+ *****************************************************************************/
+dvbpsi_zap_t *dvbpsi_zap_new(size_t i_packets, dvbpsi_message_cb pf_message,
+                             enum dvbpsi_msg_level i_msg_level,
+                             dvbpsi_pat_callback pf_pat, dvbpsi_pmt_callback pf_pmt,
+                             void *p_cb_data)
+{
+    assert(pf_pmt);
+
+    dvbpsi_zap_t *p_zap = dvbpsi_calloc(1, sizeof(dvbpsi_zap_t));
+    if (p_zap == NULL)
+        return NULL;
+
+    p_zap->pf_message = pf_message;
+    p_zap->i_msg_level = i_msg_level;
+    p_zap->pf_pat = pf_pat;
+    p_zap->pf_pmt = pf_pmt;
+    p_zap->p_cb_data = p_cb_data;
+    p_zap->i_pmt_pid = DVBPSI_ZAP_NO_PID;
+    p_zap->i_time = DVBPSI_TIME_NONE;
+    p_zap->i_start = DVBPSI_TIME_NONE;
+    p_zap->i_time_to_pmt = DVBPSI_TIME_NONE;
+
+    if (i_packets)
+    {
+        p_zap->p_ring = dvbpsi_malloc(i_packets * 188);
+        p_zap->pi_times = dvbpsi_malloc(i_packets * sizeof(int64_t));
+        if (p_zap->p_ring == NULL || p_zap->pi_times == NULL)
+        {
+            dvbpsi_zap_delete(p_zap);
+            return NULL;
+        }
+        p_zap->i_packets = i_packets;
+    }
+
+    p_zap->p_pat_handle = dvbpsi_new(pf_message, i_msg_level);
+    if (p_zap->p_pat_handle == NULL || !dvbpsi_zap_attach_pat(p_zap))
+    {
+        dvbpsi_zap_delete(p_zap);
+        return NULL;
+    }
+    return p_zap;
+}
+
+/*****************************************************************************
+ * dvbpsi_zap_delete
+ *****************************************************************************/
+void dvbpsi_zap_delete(dvbpsi_zap_t *p_zap)
+{
+    if (p_zap == NULL)
+        return;
+
+    dvbpsi_zap_clear(p_zap);
+    if (p_zap->p_pat_handle)
+    {
+        if (p_zap->p_pat_handle->p_decoder)
+            dvbpsi_pat_detach(p_zap->p_pat_handle);
+        dvbpsi_delete(p_zap->p_pat_handle);
+    }
+    dvbpsi_free(p_zap->p_programs);
+    dvbpsi_free(p_zap->p_ring);
+    dvbpsi_free(p_zap->pi_times);
+    dvbpsi_free(p_zap);
+}
+
+/*****************************************************************************
+ * dvbpsi_zap_start
+ *****************************************************************************/
+bool dvbpsi_zap_start(dvbpsi_zap_t *p_zap, uint16_t i_program_number, bool b_new_ts)
+{
+    assert(p_zap);
+
+    dvbpsi_zap_clear(p_zap);
+    p_zap->b_started = true;
+    p_zap->i_program_number = i_program_number;
+    p_zap->b_first = true;
+    p_zap->i_start = DVBPSI_TIME_NONE;
+    p_zap->b_pmt = false;
+    p_zap->i_time_to_pmt = DVBPSI_TIME_NONE;
+
+    if (b_new_ts)
+    {
+        dvbpsi_free(p_zap->p_programs);
+        p_zap->p_programs = NULL;
+        p_zap->i_programs = 0;
+
+        dvbpsi_pat_detach(p_zap->p_pat_handle);
+        return dvbpsi_zap_attach_pat(p_zap);
+    }
+
+    uint16_t i_pid = dvbpsi_zap_find(p_zap, i_program_number);
+    if (i_pid != DVBPSI_ZAP_NO_PID)
+        dvbpsi_zap_set_pmt_pid(p_zap, i_pid);
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_zap_push
+ *****************************************************************************/
+bool dvbpsi_zap_push(dvbpsi_zap_t *p_zap, uint8_t *p_data, size_t i_count,
+                     size_t i_stride, int64_t i_time)
+{
+    assert(p_zap);
+
+    if (i_stride == 0)
+        i_stride = 188;
+    assert(i_stride >= 188);
+
+    /* A failed dvbpsi_zap_start() left no PAT decoder */
+    if (p_zap->p_pat_handle->p_decoder == NULL && !dvbpsi_zap_attach_pat(p_zap))
+        return false;
+
+    if (p_zap->b_first && i_count)
+    {
+        p_zap->b_first = false;
+        p_zap->i_start = i_time;
+    }
+    p_zap->i_time = i_time;
+
+    bool b_valid = true;
+    uint8_t *p_end = p_data + i_count * i_stride;
+    for (; p_data < p_end; p_data += i_stride)
+    {
+        if (p_data[0] != 0x47)
+        {
+            b_valid = false;
+            continue;
+        }
+
+        uint16_t i_pid = ((uint16_t)(p_data[1] & 0x1f) << 8) | p_data[2];
+        if (i_pid == 0x00)
+            dvbpsi_packet_push_at(p_zap->p_pat_handle, p_data, i_time);
+        else if (p_zap->p_pmt_handle)
+        {
+            if (i_pid == p_zap->i_pmt_pid)
+                dvbpsi_packet_push_at(p_zap->p_pmt_handle, p_data, i_time);
+        }
+        else if (p_zap->b_started && p_zap->i_packets && i_pid != 0x1fff)
+        {
+            /* Speculative buffering of the PIDs that may carry the PMT */
+            if (!(p_zap->pi_candidates[i_pid / 8] & (1 << (i_pid % 8))))
+            {
+                if (!dvbpsi_zap_is_candidate(p_zap, p_data))
+                    continue;
+                p_zap->pi_candidates[i_pid / 8] |= 1 << (i_pid % 8);
+            }
+
+            size_t i_slot = (p_zap->i_first + p_zap->i_count) % p_zap->i_packets;
+            if (p_zap->i_count == p_zap->i_packets)
+                p_zap->i_first = (p_zap->i_first + 1) % p_zap->i_packets;
+            else
+                p_zap->i_count++;
+            memcpy(p_zap->p_ring + i_slot * 188, p_data, 188);
+            p_zap->pi_times[i_slot] = i_time;
+        }
+    }
+
+    p_zap->i_time = DVBPSI_TIME_NONE;
+    return b_valid;
+}
+
+/*****************************************************************************
+ * dvbpsi_zap_get_time_to_pmt
+ *****************************************************************************/
+bool dvbpsi_zap_get_time_to_pmt(dvbpsi_zap_t *p_zap, int64_t *pi_time)
+{
+    assert(p_zap);
+
+    if (p_zap->i_time_to_pmt == DVBPSI_TIME_NONE)
+        return false;
+    *pi_time = p_zap->i_time_to_pmt;
+    return true;
+}
+
+/*****************************************************************************
+ * dvbpsi_zap_get_latency_histogram
+ *****************************************************************************/
+bool dvbpsi_zap_get_latency_histogram(dvbpsi_zap_t *p_zap,
+                                      uint64_t pi_buckets[DVBPSI_LATENCY_BUCKETS])
+{
+    assert(p_zap);
+
+    if (!p_zap->b_latency)
+        return false;
+    memcpy(pi_buckets, p_zap->pi_buckets, sizeof(p_zap->pi_buckets));
+    return true;
+}
@@ -0,0 +1,168 @@
+/*****************************************************************************
+ * zap.h
+ *
+ * Copyright (C) 2001-2011 VideoLAN
+ * $Id$
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+/*!
+ * \file <zap.h>
+ * \brief Fast zapping.
+ *
+ * Acquires the PMT of a program with the least latency on a channel
+ * change. The PMT decoder is attached as soon as a PAT section names the
+ * program, before the whole PAT, and the packets that looked like the
+ * start of its PMT are buffered meanwhile and replayed into it, so that a
+ * PMT having gone by before the PAT is not lost.
+ */
+
+#ifndef _DVBPSI_ZAP_H_
+#define _DVBPSI_ZAP_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * dvbpsi_zap_t
+ *****************************************************************************/
+/*!
+ * \typedef struct dvbpsi_zap_s dvbpsi_zap_t
+ * \brief dvbpsi_zap_t type definition, an opaque fast zapping decoder.
+ */
+typedef struct dvbpsi_zap_s dvbpsi_zap_t;
+
+/*****************************************************************************
+ * dvbpsi_zap_new
+ *****************************************************************************/
+/*!
+ * \fn dvbpsi_zap_t *dvbpsi_zap_new(size_t i_packets,
+ *                                  dvbpsi_message_cb pf_message,
+ *                                  enum dvbpsi_msg_level i_msg_level,
+ *                                  dvbpsi_pat_callback pf_pat,
+ *                                  dvbpsi_pmt_callback pf_pmt,
+ *                                  void *p_cb_data)
+ * \brief Creates a fast zapping decoder, with no program selected
+ * \param i_packets number of TS packets buffered while the PMT PID is not
+ *        known yet, 0 for none
+ * \param pf_message message callback of the handles of the decoder
+ * \param i_msg_level message level of the handles of the decoder
+ * \param pf_pat function called with each current PAT, NULL to have the
+ *        decoder delete them
+ * \param pf_pmt function called with each PMT of the selected program
+ * \param p_cb_data private data given in argument to the callbacks
+ * \return pointer to the decoder, or NULL on error
+ *
+ * The tables given to the callbacks are to be deleted by the application.
+ */
+dvbpsi_zap_t *dvbpsi_zap_new(size_t i_packets, dvbpsi_message_cb pf_message,
+                             enum dvbpsi_msg_level i_msg_level,
+                             dvbpsi_pat_callback pf_pat, dvbpsi_pmt_callback pf_pmt,
+                             void *p_cb_data);
+
+/*****************************************************************************
+ * dvbpsi_zap_delete
+ *****************************************************************************/
+/*!
+ * \fn void dvbpsi_zap_delete(dvbpsi_zap_t *p_zap)
+ * \brief Deletes a fast zapping decoder and its handles
+ * \param p_zap pointer to the decoder
+ * \return nothing
+ */
+void dvbpsi_zap_delete(dvbpsi_zap_t *p_zap);
+
+/*****************************************************************************
+ * dvbpsi_zap_start
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_zap_start(dvbpsi_zap_t *p_zap, uint16_t i_program_number,
+ *                           bool b_new_ts)
+ * \brief Selects the program whose PMT to acquire, on a channel change
+ * \param p_zap pointer to the decoder
+ * \param i_program_number program_number of the program
+ * \param b_new_ts true when the transport stream changed, the last PAT
+ *        being then forgotten, false when the program is in the same one
+ * \return false on error, true otherwise.
+ *
+ * Without b_new_ts the PMT decoder is attached at once from the last PAT.
+ * The time to PMT is measured from the first packet pushed afterwards.
+ * The function must not be called from the callbacks of the decoder.
+ */
+bool dvbpsi_zap_start(dvbpsi_zap_t *p_zap, uint16_t i_program_number, bool b_new_ts);
+
+/*****************************************************************************
+ * dvbpsi_zap_push
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_zap_push(dvbpsi_zap_t *p_zap, uint8_t *p_data,
+ *                          size_t i_count, size_t i_stride, int64_t i_time)
+ * \brief Injection of a run of TS packets of a transport stream
+ * \param p_zap pointer to the decoder
+ * \param p_data pointer to the first of 'i_count' 188 bytes TS packets
+ * \param i_count number of TS packets in the buffer
+ * \param i_stride distance in bytes between the start of two successive
+ *        packets, 0 for 188
+ * \param i_time arrival time of the packets, in any monotonic unit of the
+ *        caller, or DVBPSI_TIME_NONE
+ * \return false when at least one packet was not a TS packet, true otherwise.
+ *
+ * Packets of all the PIDs can be pushed, the decoder keeping the PAT and
+ * the PMT of the selected program. While the PMT PID is not known, the
+ * packets of the PIDs on which a PMT section of the program started are
+ * buffered, the oldest ones being dropped once i_packets are.
+ */
+bool dvbpsi_zap_push(dvbpsi_zap_t *p_zap, uint8_t *p_data, size_t i_count,
+                     size_t i_stride, int64_t i_time);
+
+/*****************************************************************************
+ * dvbpsi_zap_get_time_to_pmt
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_zap_get_time_to_pmt(dvbpsi_zap_t *p_zap, int64_t *pi_time)
+ * \brief Gets the time to PMT of the last dvbpsi_zap_start()
+ * \param p_zap pointer to the decoder
+ * \param pi_time receives the time from the first packet pushed after
+ *        dvbpsi_zap_start() to the first PMT callback, in the unit of the
+ *        timestamps given to dvbpsi_zap_push()
+ * \return false if the PMT was not signalled yet or the packets were pushed
+ *         without a timestamp, true otherwise.
+ */
+bool dvbpsi_zap_get_time_to_pmt(dvbpsi_zap_t *p_zap, int64_t *pi_time);
+
+/*****************************************************************************
+ * dvbpsi_zap_get_latency_histogram
+ *****************************************************************************/
+/*!
+ * \fn bool dvbpsi_zap_get_latency_histogram(dvbpsi_zap_t *p_zap,
+ *                                           uint64_t pi_buckets[DVBPSI_LATENCY_BUCKETS])
+ * \brief Gets the histogram of the times to PMT of all the zaps
+ * \param p_zap pointer to the decoder
+ * \param pi_buckets receives the number of zaps per time to PMT bucket,
+ *        bucketed as by dvbpsi_get_latency_histogram()
+ * \return false if no time to PMT was recorded yet, true otherwise.
+ */
+bool dvbpsi_zap_get_latency_histogram(dvbpsi_zap_t *p_zap,
+                                      uint64_t pi_buckets[DVBPSI_LATENCY_BUCKETS]);
+
+#ifdef __cplusplus
+};
+#endif
+
+#else
+#error "Multiple inclusions of zap.h"
+#endif